@@ -49,6 +49,12 @@ find_package(OpenSSL MODULE REQUIRED)
 find_package(SELinux)
 set(EDEN_HAVE_SELINUX ${SELINUX_FOUND})
 
+# liburing is optional: without it, overlay file I/O is always synchronous.
+if ("${CMAKE_SYSTEM_NAME}" STREQUAL "Linux")
+  find_package(LibUring MODULE)
+  set(EDEN_HAVE_LIBURING ${LIBURING_FOUND})
+endif()
+
 if("${ENABLE_GIT}" STREQUAL "AUTO")
   find_package(LibGit2 MODULE)
   set(EDEN_HAVE_GIT "${LibGit2_FOUND}")
@@ -0,0 +1,19 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+#
+# This software may be used and distributed according to the terms of the
+# GNU General Public License version 2.
+
+include(FindPackageHandleStandardArgs)
+
+find_path(LIBURING_INCLUDE_DIR NAMES liburing.h)
+find_library(LIBURING_LIBRARY NAMES uring)
+find_package_handle_standard_args(
+  LIBURING
+  DEFAULT_MSG
+  LIBURING_INCLUDE_DIR
+  LIBURING_LIBRARY
+)
+mark_as_advanced(
+  LIBURING_INCLUDE_DIR
+  LIBURING_LIBRARY
+)
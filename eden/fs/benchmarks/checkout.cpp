@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kTopDirCount = 16;
+constexpr size_t kSubdirCount = 16;
+constexpr size_t kFilesPerDir = 8;
+
+FakeTreeBuilder makeCommit(folly::StringPiece contents) {
+  FakeTreeBuilder builder;
+  for (size_t top = 0; top < kTopDirCount; ++top) {
+    for (size_t sub = 0; sub < kSubdirCount; ++sub) {
+      for (size_t file = 0; file < kFilesPerDir; ++file) {
+        builder.setFile(
+            folly::to<std::string>("dir", top, "/sub", sub, "/file", file),
+            folly::to<std::string>(contents, top, sub, file));
+      }
+    }
+  }
+  return builder;
+}
+
+/**
+ * Check out back and forth between two commits where every file differs,
+ * with every directory loaded so that checkout has to walk all of them.
+ * The argument is the number of trees prefetched in parallel, 0 disabling the
+ * prefetch.
+ */
+void checkout_changed_tree(benchmark::State& state) {
+  auto builder1 = makeCommit("one");
+  TestMount mount{RootId{"1"}, builder1};
+  auto builder2 = makeCommit("two");
+  builder2.finalize(mount.getBackingStore(), true);
+  mount.getBackingStore()->putCommit(RootId{"2"}, builder2)->setReady();
+
+  mount.getEdenConfig()->checkoutTreePrefetchConcurrency.setValue(
+      state.range(0), ConfigSource::CommandLine);
+
+  // Keep every directory loaded, so checkout can't skip them.
+  std::vector<TreeInodePtr> dirs;
+  for (size_t top = 0; top < kTopDirCount; ++top) {
+    for (size_t sub = 0; sub < kSubdirCount; ++sub) {
+      dirs.push_back(
+          mount.getTreeInode(folly::to<std::string>("dir", top, "/sub", sub)));
+    }
+  }
+
+  auto executor = mount.getServerExecutor().get();
+  bool toSecond = true;
+  for (auto _ : state) {
+    auto result = mount.getEdenMount()
+                      ->checkout(
+                          toSecond ? RootId{"2"} : RootId{"1"},
+                          std::nullopt,
+                          __func__)
+                      .getVia(executor);
+    benchmark::DoNotOptimize(result);
+    toSecond = !toSecond;
+  }
+}
+
+BENCHMARK(checkout_changed_tree)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(0)
+    ->Arg(4)
+    ->Arg(32);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <folly/CancellationToken.h>
+#include <gflags/gflags.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+/*
+ * Measures checkout and status on synthetic repositories held in a
+ * FakeBackingStore.
+ *
+ * The repository is a tree of --depth levels of --fanout directories, with
+ * --files_per_dir files in each leaf directory. --materialized_percent of the
+ * files are materialized with their original contents, so they don't show up
+ * as modified but have to be compared.
+ *
+ * Each benchmark runs with a warm TreeCache, and with a cold one that is
+ * cleared before every iteration. Use --benchmark_format=json or
+ * --benchmark_out=<file> for machine-readable results.
+ */
+
+DEFINE_uint64(depth, 3, "Number of directory levels in the repository");
+DEFINE_uint64(fanout, 8, "Number of subdirectories of each directory");
+DEFINE_uint64(files_per_dir, 16, "Number of files in each leaf directory");
+DEFINE_uint64(
+    materialized_percent,
+    0,
+    "Percentage of the files that are materialized but unmodified");
+
+namespace {
+
+using namespace facebook::eden;
+
+/**
+ * Calls `func(path, index)` for every file of the synthetic repository, with
+ * the index of the file in a depth-first walk.
+ */
+template <typename Func>
+void forEachFile(Func&& func) {
+  size_t index = 0;
+  auto walk = [&](auto& self, const std::string& dir, uint64_t level) -> void {
+    if (level == FLAGS_depth) {
+      for (size_t file = 0; file < FLAGS_files_per_dir; ++file) {
+        func(folly::to<std::string>(dir, "file", file), index++);
+      }
+      return;
+    }
+    for (size_t sub = 0; sub < FLAGS_fanout; ++sub) {
+      self(self, folly::to<std::string>(dir, "dir", sub, "/"), level + 1);
+    }
+  };
+  walk(walk, "", 0);
+}
+
+/**
+ * Files are picked by percentage from the start of every run of 100 files,
+ * and materialized files from the end, so the two only overlap when their
+ * percentages add up to more than 100.
+ */
+bool isChanged(size_t index, int64_t changedPercent) {
+  return static_cast<int64_t>(index % 100) < changedPercent;
+}
+
+bool isMaterialized(size_t index) {
+  return index % 100 >= 100 - FLAGS_materialized_percent;
+}
+
+FakeTreeBuilder makeCommit(int64_t changedPercent) {
+  FakeTreeBuilder builder;
+  forEachFile([&](const std::string& path, size_t index) {
+    builder.setFile(
+        path, isChanged(index, changedPercent) ? path + " changed" : path);
+  });
+  return builder;
+}
+
+void materializeFiles(TestMount& mount) {
+  forEachFile([&](const std::string& path, size_t index) {
+    if (isMaterialized(index)) {
+      mount.overwriteFile(path, path);
+    }
+  });
+}
+
+void clearTreeCacheIfCold(benchmark::State& state, TestMount& mount) {
+  if (state.range(1) == 0) {
+    state.PauseTiming();
+    mount.getTreeCache()->clear();
+    state.ResumeTiming();
+  }
+}
+
+/**
+ * Check out back and forth between two commits that differ in the given
+ * percentage of files.
+ */
+void checkout(benchmark::State& state) {
+  auto builder1 = makeCommit(0);
+  TestMount mount{RootId{"1"}, builder1};
+  auto builder2 = makeCommit(state.range(0));
+  builder2.finalize(mount.getBackingStore(), true);
+  mount.getBackingStore()->putCommit(RootId{"2"}, builder2)->setReady();
+  materializeFiles(mount);
+
+  auto executor = mount.getServerExecutor().get();
+  bool toSecond = true;
+  for (auto _ : state) {
+    clearTreeCacheIfCold(state, mount);
+    auto result = mount.getEdenMount()
+                      ->checkout(
+                          toSecond ? RootId{"2"} : RootId{"1"},
+                          std::nullopt,
+                          __func__)
+                      .getVia(executor);
+    benchmark::DoNotOptimize(result);
+    toSecond = !toSecond;
+  }
+}
+
+/**
+ * Compute the status of a working copy with the given number of modified
+ * files.
+ */
+void status(benchmark::State& state) {
+  auto builder = makeCommit(0);
+  TestMount mount{RootId{"1"}, builder};
+  materializeFiles(mount);
+  auto modified = static_cast<size_t>(state.range(0));
+  forEachFile([&](const std::string& path, size_t index) {
+    if (index < modified) {
+      mount.overwriteFile(path, path + " modified");
+    }
+  });
+
+  auto executor = mount.getServerExecutor().get();
+  for (auto _ : state) {
+    clearTreeCacheIfCold(state, mount);
+    auto status = mount.getEdenMount()
+                      ->diff(RootId{"1"}, folly::CancellationToken{})
+                      .getVia(executor);
+    benchmark::DoNotOptimize(status);
+  }
+}
+
+BENCHMARK(checkout)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgNames({"changed_percent", "warm"})
+    ->ArgsProduct({{1, 10, 100}, {0, 1}});
+
+BENCHMARK(status)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgNames({"modified", "warm"})
+    ->ArgsProduct({{0, 10, 1000}, {0, 1}});
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
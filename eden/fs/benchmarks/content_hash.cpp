@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/Blake3.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+/**
+ * Hashing file contents of the size given by the argument, as done for
+ * getAttributesFromFiles().
+ */
+void content_sha1(benchmark::State& state) {
+  std::string contents(static_cast<size_t>(state.range(0)), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Hash20::sha1(folly::ByteRange{folly::StringPiece{contents}}));
+  }
+  state.SetBytesProcessed(state.iterations() * contents.size());
+}
+
+void content_blake3(benchmark::State& state) {
+  std::string contents(static_cast<size_t>(state.range(0)), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Blake3::hash(folly::ByteRange{folly::StringPiece{contents}}));
+  }
+  state.SetBytesProcessed(state.iterations() * contents.size());
+}
+
+BENCHMARK(content_sha1)->Arg(64)->Arg(4096)->Arg(1024 * 1024);
+BENCHMARK(content_blake3)->Arg(64)->Arg(4096)->Arg(1024 * 1024);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/json.h>
+#include <folly/testing/TestUtil.h>
+#include <gflags/gflags.h>
+#include <sys/stat.h>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/SpawnedProcess.h"
+
+/*
+ * Measures how long an edenfs daemon takes from being started to serving its
+ * checkouts, and how long a graceful takeover blocks the requests of a
+ * client.
+ *
+ * The daemon runs against a synthetic state directory: --mounts checkouts of
+ * a one-commit Git repository, each with --overlay_entries materialized
+ * files, and a RocksDB local store filled with --local_store_size bytes of
+ * blobs. edenfs has to mount the checkouts, so run this as edenfs is run in
+ * development builds, with sudo.
+ *
+ * The time of each phase of startup is parsed from the "Startup phase" lines
+ * edenfs writes to its --startupLogPath, and reported as a counter.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+DEFINE_string(edenfs, "", "Path to the edenfs binary to start");
+DEFINE_uint32(mounts, 4, "Number of checkouts to remount at startup");
+DEFINE_uint32(
+    overlay_entries,
+    10000,
+    "Number of materialized files in each checkout");
+DEFINE_uint64(
+    local_store_size,
+    256ull * 1024 * 1024,
+    "Bytes of blobs to fill the local store with");
+DEFINE_uint32(
+    startup_timeout,
+    600,
+    "Seconds to wait for edenfs to report that it started");
+
+constexpr size_t kBlobSize = 16 * 1024;
+constexpr size_t kFilesPerDirectory = 100;
+constexpr folly::StringPiece kPhasePrefix{"Startup phase "};
+constexpr folly::StringPiece kStartedPrefix{"Started EdenFS"};
+
+void runChecked(const std::vector<std::string>& args) {
+  SpawnedProcess::Options options;
+  options.nullStdin();
+  SpawnedProcess{args, std::move(options)}.waitChecked();
+}
+
+std::string runCheckedWithOutput(const std::vector<std::string>& args) {
+  SpawnedProcess::Options options;
+  options.nullStdin();
+  options.pipeStdout();
+  SpawnedProcess process{args, std::move(options)};
+  auto output = process.communicate().first;
+  process.waitChecked();
+  return folly::trimWhitespace(output).str();
+}
+
+ObjectId makeHash(size_t i) {
+  std::array<uint8_t, 20> bytes{};
+  std::memcpy(bytes.data(), &i, sizeof(i));
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+/**
+ * The state directory of an edenfs daemon, with its Git repository and the
+ * paths its checkouts are mounted at.
+ */
+struct StateDir {
+  StateDir() {
+    ensureDirectoryExists(edenDir);
+    ensureDirectoryExists(etcEdenDir);
+    createRepository();
+    fillLocalStore();
+
+    folly::dynamic clients = folly::dynamic::object();
+    for (uint32_t i = 0; i < FLAGS_mounts; ++i) {
+      auto name = folly::to<std::string>("mount", i);
+      auto mountPath = root + PathComponentPiece{name};
+      auto clientDir = edenDir + "clients"_pc + PathComponentPiece{name};
+      ensureDirectoryExists(mountPath);
+      ensureDirectoryExists(clientDir);
+      folly::writeFileAtomic(
+          (clientDir + "config.toml"_pc).stringPiece(),
+          folly::to<std::string>(
+              "[repository]\npath = \"",
+              repository,
+              "\"\ntype = \"git\"\n"));
+      CheckoutConfig{mountPath, clientDir}.setCheckedOutCommit(RootId{commit});
+      clients[mountPath.stringPiece()] = name;
+      mountPaths.push_back(std::move(mountPath));
+    }
+    folly::writeFileAtomic(
+        (edenDir + "config.json"_pc).stringPiece(), folly::toJson(clients));
+  }
+
+  void createRepository() {
+    ensureDirectoryExists(repository);
+    runChecked({"git", "init", "-q", repository.value()});
+    folly::writeFileAtomic(
+        (repository + "README"_pc).stringPiece(), folly::StringPiece{"eden"});
+    runChecked({"git", "-C", repository.value(), "add", "README"});
+    runChecked(
+        {"git",
+         "-C",
+         repository.value(),
+         "-c",
+         "user.name=eden",
+         "-c",
+         "user.email=eden@localhost",
+         "commit",
+         "-q",
+         "-m",
+         "initial"});
+    commit = runCheckedWithOutput(
+        {"git", "-C", repository.value(), "rev-parse", "HEAD"});
+  }
+
+  /**
+   * Fill the local store edenfs opens at startup before it ever runs, as
+   * a long-lived daemon's would have been by the objects it fetched.
+   */
+  void fillLocalStore() {
+    auto rocksPath = edenDir + "storage"_pc + "rocks-db"_pc;
+    ensureDirectoryExists(rocksPath);
+    FaultInjector faultInjector{/*enabled=*/false};
+    RocksDbLocalStore store{
+        rocksPath,
+        std::make_shared<NullStructuredLogger>(),
+        &faultInjector};
+    auto batch = store.beginWrite();
+    std::string blob(kBlobSize, 'x');
+    for (size_t i = 0; i < FLAGS_local_store_size / kBlobSize; ++i) {
+      batch->put(KeySpace::BlobFamily, makeHash(i), folly::StringPiece{blob});
+    }
+    batch->flush();
+  }
+
+  /**
+   * Remove the marker the overlays leave when they are shut down cleanly, so
+   * that the next startup checks them all as after a crash.
+   */
+  void markOverlaysUnclean() {
+    for (uint32_t i = 0; i < FLAGS_mounts; ++i) {
+      auto path = edenDir + "clients"_pc +
+          PathComponent{folly::to<std::string>("mount", i)} + "local"_pc +
+          "next-inode-number"_pc;
+      ::unlink(path.c_str());
+    }
+  }
+
+  folly::test::TemporaryDirectory tempDir = makeTempDir("eden_startup");
+  AbsolutePath root{tempDir.path().string()};
+  AbsolutePath edenDir = root + "eden"_pc;
+  AbsolutePath etcEdenDir = root + "etc-eden"_pc;
+  AbsolutePath repository = root + "repo"_pc;
+  std::string commit;
+  std::vector<AbsolutePath> mountPaths;
+  size_t startCount = 0;
+};
+
+/**
+ * An edenfs process started against a StateDir.
+ */
+class Daemon {
+ public:
+  Daemon(StateDir& state, bool takeover)
+      : logPath_{state.root +
+                 PathComponent{folly::to<std::string>(
+                     "startup-", state.startCount++, ".log")}} {
+    std::vector<std::string> args{
+        FLAGS_edenfs,
+        "--edenfs",
+        "--foreground",
+        "--edenDir",
+        state.edenDir.value(),
+        "--etcEdenDir",
+        state.etcEdenDir.value(),
+        "--configPath",
+        (state.root + ".edenrc"_pc).value(),
+        "--startupLogPath",
+        logPath_.value()};
+    if (takeover) {
+      args.emplace_back("--takeover");
+    }
+
+    SpawnedProcess::Options options;
+    options.nullStdin();
+    OpenFileHandleOptions devNull;
+    devNull.writeContents = 1;
+    options.open(STDOUT_FILENO, "/dev/null"_abspath, devNull);
+    options.open(STDERR_FILENO, "/dev/null"_abspath, devNull);
+    process_ = SpawnedProcess{args, std::move(options)};
+  }
+
+  ~Daemon() {
+    if (running_) {
+      process_.terminateOrKill(30s);
+    }
+  }
+
+  /**
+   * Wait for the daemon to report that it started, and return how long each
+   * phase of its startup took, in seconds.
+   */
+  PhaseTimes waitUntilStarted() {
+    auto deadline =
+        std::chrono::steady_clock::now() + 1s * FLAGS_startup_timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+      std::string log;
+      folly::readFile(logPath_.c_str(), log);
+      if (log.find(kStartedPrefix.str()) != std::string::npos) {
+        return parsePhases(log);
+      }
+      if (process_.terminated()) {
+        running_ = false;
+        throw std::runtime_error(folly::to<std::string>(
+            "edenfs exited before it started:\n", log));
+      }
+      /* sleep override */ std::this_thread::sleep_for(10ms);
+    }
+    throw std::runtime_error("timed out waiting for edenfs to start");
+  }
+
+  /**
+   * Wait for the daemon to exit, as it does once another one took over its
+   * mounts.
+   */
+  void waitForExit() {
+    process_.wait();
+    running_ = false;
+  }
+
+  void stop() {
+    process_.terminateOrKill(60s);
+    running_ = false;
+  }
+
+ private:
+  static PhaseTimes parsePhases(folly::StringPiece log) {
+    // "Startup phase <phase> took <seconds> seconds"
+    PhaseTimes phases;
+    std::vector<folly::StringPiece> lines;
+    folly::split('\n', log, lines);
+    for (auto line : lines) {
+      if (!line.removePrefix(kPhasePrefix)) {
+        continue;
+      }
+      std::vector<folly::StringPiece> words;
+      folly::split(' ', line, words);
+      if (words.size() == 4) {
+        phases[words[0].str()] += folly::to<double>(words[2]);
+      }
+    }
+    return phases;
+  }
+
+  AbsolutePath logPath_;
+  SpawnedProcess process_;
+  bool running_{true};
+};
+
+std::unique_ptr<StateDir> stateDir;
+
+/**
+ * Creates the state directory, and has a first daemon materialize the
+ * overlay entries of every checkout.
+ */
+StateDir& getStateDir() {
+  if (stateDir) {
+    return *stateDir;
+  }
+  if (FLAGS_edenfs.empty()) {
+    throw std::invalid_argument("--edenfs must be given");
+  }
+  stateDir = std::make_unique<StateDir>();
+
+  Daemon daemon{*stateDir, /*takeover=*/false};
+  daemon.waitUntilStarted();
+  for (const auto& mountPath : stateDir->mountPaths) {
+    for (uint32_t i = 0; i < FLAGS_overlay_entries; ++i) {
+      auto dir = mountPath +
+          PathComponent{folly::to<std::string>("dir", i / kFilesPerDirectory)};
+      if (i % kFilesPerDirectory == 0) {
+        folly::checkUnixError(::mkdir(dir.c_str(), 0755), "mkdir ", dir);
+      }
+      auto file = dir + PathComponent{folly::to<std::string>("file", i)};
+      if (!folly::writeFile(folly::to<std::string>(i), file.c_str())) {
+        folly::throwSystemError("unable to write ", file);
+      }
+    }
+  }
+  daemon.stop();
+  return *stateDir;
+}
+
+using PhaseTimes = std::map<std::string, double>;
+
+void addPhases(PhaseTimes& totals, const PhaseTimes& phases) {
+  for (const auto& [phase, seconds] : phases) {
+    totals[phase] += seconds;
+  }
+}
+
+/**
+ * Report the mean time of each phase over the iterations, in seconds.
+ */
+void reportPhases(benchmark::State& state, const PhaseTimes& totals) {
+  for (const auto& [phase, seconds] : totals) {
+    state.counters[phase + "_s"] =
+        benchmark::Counter{seconds, benchmark::Counter::kAvgIterations};
+  }
+}
+
+/**
+ * Start a daemon and wait for it to remount every checkout. With an argument
+ * of 1, the overlays look like edenfs crashed, so they are all checked.
+ */
+void daemon_start(benchmark::State& state) {
+  auto& stateDir = getStateDir();
+  bool unclean = state.range(0) != 0;
+  PhaseTimes totals;
+  for (auto _ : state) {
+    if (unclean) {
+      stateDir.markOverlaysUnclean();
+    }
+    auto start = std::chrono::steady_clock::now();
+    Daemon daemon{stateDir, /*takeover=*/false};
+    auto phases = daemon.waitUntilStarted();
+    state.SetIterationTime(std::chrono::duration<double>{
+        std::chrono::steady_clock::now() - start}
+                               .count());
+    addPhases(totals, phases);
+    daemon.stop();
+  }
+  reportPhases(state, totals);
+}
+
+/**
+ * Gracefully restart a daemon while a client stats a file of the first
+ * checkout in a loop, and report the longest a stat call took.
+ */
+void daemon_takeover(benchmark::State& state) {
+  auto& stateDir = getStateDir();
+  auto statPath = stateDir.mountPaths.at(0) + "README"_pc;
+  auto daemon = std::make_unique<Daemon>(stateDir, /*takeover=*/false);
+  daemon->waitUntilStarted();
+
+  PhaseTimes totals;
+  double maxPause = 0;
+  for (auto _ : state) {
+    std::atomic<bool> done{false};
+    std::chrono::steady_clock::duration longestStat{0};
+    std::thread client{[&] {
+      struct stat buf;
+      while (!done.load(std::memory_order_relaxed)) {
+        auto before = std::chrono::steady_clock::now();
+        folly::checkUnixError(::stat(statPath.c_str(), &buf), "stat failed");
+        longestStat =
+            std::max(longestStat, std::chrono::steady_clock::now() - before);
+      }
+    }};
+
+    auto start = std::chrono::steady_clock::now();
+    auto next = std::make_unique<Daemon>(stateDir, /*takeover=*/true);
+    auto phases = next->waitUntilStarted();
+    daemon->waitForExit();
+    state.SetIterationTime(std::chrono::duration<double>{
+        std::chrono::steady_clock::now() - start}
+                               .count());
+    done = true;
+    client.join();
+
+    addPhases(totals, phases);
+    maxPause = std::max(
+        maxPause, std::chrono::duration<double>{longestStat}.count() * 1000);
+    daemon = std::move(next);
+  }
+  reportPhases(state, totals);
+  state.counters["max_stat_pause_ms"] = maxPause;
+  daemon->stop();
+}
+
+BENCHMARK(daemon_start)
+    ->Arg(0)
+    ->Arg(1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(5);
+BENCHMARK(daemon_takeover)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(5);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/Conv.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/io/IOBuf.h>
+#include <gflags/gflags.h>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <new>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/fuse/DirList.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/FuseDispatcherImpl.h"
+#include "eden/fs/inodes/NfsDispatcherImpl.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/nfs/DirList.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+/*
+ * Drives the FUSE and NFS dispatchers of a TestMount directly, without a
+ * kernel or a running daemon, so that the cost of the inode layer can be
+ * measured reproducibly and without privileges.
+ *
+ * Every benchmark reports its operations per second and the number of heap
+ * allocations per operation.
+ */
+
+DEFINE_uint64(dirs, 64, "Number of directories in the synthetic tree");
+DEFINE_uint64(files_per_dir, 64, "Number of files in each directory");
+DEFINE_uint64(file_size, 4096, "Size of each file, and of reads and writes");
+
+namespace {
+
+thread_local uint64_t allocationCount = 0;
+
+} // namespace
+
+// Count every allocation of the benchmark threads. The process is dedicated
+// to benchmarking, so replacing the global allocation functions is fine.
+void* operator new(size_t size) {
+  ++allocationCount;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+using namespace facebook::eden;
+
+/**
+ * A mount holding a tree of FLAGS_dirs directories of FLAGS_files_per_dir
+ * files, with every inode loaded, and a dispatcher of each kind.
+ */
+struct DispatcherMount {
+  DispatcherMount() {
+    FakeTreeBuilder builder;
+    std::string contents(FLAGS_file_size, 'x');
+    for (size_t dir = 0; dir < FLAGS_dirs; ++dir) {
+      for (size_t file = 0; file < FLAGS_files_per_dir; ++file) {
+        builder.setFile(
+            folly::to<std::string>("dir", dir, "/file", file), contents);
+      }
+    }
+    builder.setFile("scratch/placeholder", "");
+    mount = std::make_unique<TestMount>(builder);
+    auto* edenMount = mount->getEdenMount().get();
+    fuse = std::make_unique<FuseDispatcherImpl>(edenMount);
+    nfs = std::make_unique<NfsDispatcherImpl>(edenMount);
+
+    for (size_t dir = 0; dir < FLAGS_dirs; ++dir) {
+      auto dirPath = folly::to<std::string>("dir", dir);
+      auto dirInode = mount->getTreeInode(dirPath);
+      for (size_t file = 0; file < FLAGS_files_per_dir; ++file) {
+        auto name = folly::to<std::string>("file", file);
+        auto inode = mount->getFileInode(dirPath + "/" + name);
+        files.push_back({dirInode->getNodeId(), PathComponent{name}});
+        fileInodes.push_back(inode->getNodeId());
+        // Keep the inodes referenced so they stay loaded.
+        references.push_back(std::move(inode));
+      }
+      dirInodes.push_back(dirInode->getNodeId());
+      references.push_back(std::move(dirInode));
+    }
+    auto scratch = mount->getTreeInode("scratch");
+    scratchDir = scratch->getNodeId();
+    references.push_back(std::move(scratch));
+  }
+
+  template <typename T>
+  T wait(ImmediateFuture<T> future) {
+    if (future.isReady()) {
+      return std::move(future).get();
+    }
+    auto* executor = mount->getServerExecutor().get();
+    return std::move(future).semi().via(executor).getVia(executor);
+  }
+
+  std::unique_ptr<TestMount> mount;
+  std::unique_ptr<FuseDispatcherImpl> fuse;
+  std::unique_ptr<NfsDispatcherImpl> nfs;
+  /// The parent and name of every file, in the same order as fileInodes.
+  std::vector<std::pair<InodeNumber, PathComponent>> files;
+  std::vector<InodeNumber> fileInodes;
+  std::vector<InodeNumber> dirInodes;
+  InodeNumber scratchDir;
+  std::vector<InodePtr> references;
+};
+
+/**
+ * The mount is shared by all benchmarks, and built on first use.
+ */
+DispatcherMount& getMount() {
+  static auto* mount = new DispatcherMount();
+  return *mount;
+}
+
+/**
+ * Runs `op` once per iteration, and reports the operation rate and the
+ * allocations per operation.
+ */
+template <typename Op>
+void runOps(benchmark::State& state, Op op) {
+  size_t index = 0;
+  auto allocationsBefore = allocationCount;
+  for (auto _ : state) {
+    op(index++);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs/op"] = benchmark::Counter(
+      static_cast<double>(allocationCount - allocationsBefore),
+      benchmark::Counter::kAvgIterations);
+}
+
+auto& context() {
+  return ObjectFetchContext::getNullContext();
+}
+
+void fuse_lookup(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    const auto& [parent, name] = m.files[i % m.files.size()];
+    auto entry = m.wait(m.fuse->lookup(0, parent, name, context()));
+    benchmark::DoNotOptimize(entry);
+    // Balance the reference that the lookup gave to the kernel.
+    m.fuse->forget(InodeNumber{entry.nodeid}, 1);
+  });
+}
+
+void fuse_getattr(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    auto ino = m.fileInodes[i % m.fileInodes.size()];
+    auto attr = m.wait(m.fuse->getattr(ino, context()));
+    benchmark::DoNotOptimize(attr);
+  });
+}
+
+void fuse_read(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    auto data = m.wait(m.fuse->read(
+        m.fileInodes[i % m.fileInodes.size()],
+        FLAGS_file_size,
+        0,
+        context()));
+    benchmark::DoNotOptimize(data);
+  });
+}
+
+void fuse_readdir(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    auto ino = m.dirInodes[i % m.dirInodes.size()];
+    auto fh = m.wait(m.fuse->opendir(ino, 0));
+    auto list = m.wait(m.fuse->readdir(
+        ino, FuseDirList{64 * 1024}, 0, fh, context()));
+    benchmark::DoNotOptimize(list);
+    m.wait(m.fuse->releasedir(ino, fh));
+  });
+}
+
+void fuse_create(benchmark::State& state) {
+  auto& m = getMount();
+  auto prefix = folly::to<std::string>("fuse_create", state.iterations());
+  runOps(state, [&](size_t i) {
+    auto entry = m.wait(m.fuse->create(
+        m.scratchDir,
+        PathComponent{folly::to<std::string>(prefix, "_", i)},
+        S_IFREG | 0644,
+        0,
+        context()));
+    benchmark::DoNotOptimize(entry);
+  });
+}
+
+void fuse_write(benchmark::State& state) {
+  auto& m = getMount();
+  auto ino = InodeNumber{m.wait(m.fuse->create(
+                                    m.scratchDir,
+                                    PathComponent{folly::to<std::string>(
+                                        "fuse_write", state.iterations())},
+                                    S_IFREG | 0644,
+                                    0,
+                                    context()))
+                             .nodeid};
+  std::string data(FLAGS_file_size, 'y');
+  runOps(state, [&](size_t) {
+    auto written = m.wait(m.fuse->write(ino, data, 0, context()));
+    benchmark::DoNotOptimize(written);
+  });
+}
+
+void nfs_lookup(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    const auto& [parent, name] = m.files[i % m.files.size()];
+    auto result = m.wait(m.nfs->lookup(parent, name.copy(), context()));
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+void nfs_getattr(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    auto ino = m.fileInodes[i % m.fileInodes.size()];
+    auto stat = m.wait(m.nfs->getattr(ino, context()));
+    benchmark::DoNotOptimize(stat);
+  });
+}
+
+void nfs_read(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    auto result = m.wait(m.nfs->read(
+        m.fileInodes[i % m.fileInodes.size()],
+        FLAGS_file_size,
+        0,
+        context()));
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+void nfs_readdir(benchmark::State& state) {
+  auto& m = getMount();
+  runOps(state, [&](size_t i) {
+    auto result = m.wait(m.nfs->readdir(
+        m.dirInodes[i % m.dirInodes.size()], 0, 0, 64 * 1024, context()));
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+void nfs_create(benchmark::State& state) {
+  auto& m = getMount();
+  auto prefix = folly::to<std::string>("nfs_create", state.iterations());
+  runOps(state, [&](size_t i) {
+    auto result = m.wait(m.nfs->create(
+        m.scratchDir,
+        PathComponent{folly::to<std::string>(prefix, "_", i)},
+        S_IFREG | 0644,
+        context()));
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+void nfs_write(benchmark::State& state) {
+  auto& m = getMount();
+  auto ino = m.wait(m.nfs->create(
+                        m.scratchDir,
+                        PathComponent{folly::to<std::string>(
+                            "nfs_write", state.iterations())},
+                        S_IFREG | 0644,
+                        context()))
+                 .ino;
+  std::string data(FLAGS_file_size, 'y');
+  runOps(state, [&](size_t) {
+    auto result = m.wait(m.nfs->write(
+        ino, folly::IOBuf::copyBuffer(data), 0, context()));
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+BENCHMARK(fuse_lookup)->Unit(benchmark::kNanosecond);
+BENCHMARK(fuse_getattr)->Unit(benchmark::kNanosecond);
+BENCHMARK(fuse_read)->Unit(benchmark::kNanosecond);
+BENCHMARK(fuse_readdir)->Unit(benchmark::kMicrosecond);
+BENCHMARK(fuse_create)->Unit(benchmark::kMicrosecond);
+BENCHMARK(fuse_write)->Unit(benchmark::kMicrosecond);
+BENCHMARK(nfs_lookup)->Unit(benchmark::kNanosecond);
+BENCHMARK(nfs_getattr)->Unit(benchmark::kNanosecond);
+BENCHMARK(nfs_read)->Unit(benchmark::kNanosecond);
+BENCHMARK(nfs_readdir)->Unit(benchmark::kMicrosecond);
+BENCHMARK(nfs_create)->Unit(benchmark::kMicrosecond);
+BENCHMARK(nfs_write)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
+
+#else
+
+int main() {
+  return 0;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+
+/*
+ * Measures sequential write throughput for a range of write sizes. Run it
+ * against files in mounts configured with different fuse:max-write values
+ * (or fuse_tester --maxWrite) to see how many FUSE requests large writes
+ * cost.
+ */
+
+namespace {
+
+DEFINE_string(
+    filename,
+    "fuse_write_sizes.tmp",
+    "Path to which writes should be issued");
+DEFINE_uint64(filesize, 64 * 1024 * 1024, "File size in bytes");
+DEFINE_uint64(
+    max_write,
+    128 * 1024,
+    "The max_write of the mount holding --filename, used to report the rate "
+    "of FUSE write requests");
+
+struct TemporaryFile {
+  TemporaryFile()
+      : file{FLAGS_filename, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC} {}
+
+  ~TemporaryFile() {
+    folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+  }
+
+  folly::File file;
+};
+
+int getTemporaryFD() {
+  static TemporaryFile tf;
+  return tf.file.fd();
+}
+
+void sequential_writes(benchmark::State& state) {
+  int fd = getTemporaryFD();
+  const size_t writeSize = state.range(0);
+  if (writeSize == 0 || writeSize > FLAGS_filesize) {
+    throw std::invalid_argument{"write size must be in (0, filesize]"};
+  }
+  std::vector<char> buffer(writeSize, 'a');
+
+  off_t offset = 0;
+  for (auto _ : state) {
+    if (offset + writeSize > FLAGS_filesize) {
+      offset = 0;
+    }
+    folly::checkUnixError(
+        folly::pwriteFull(fd, buffer.data(), writeSize, offset));
+    offset += writeSize;
+  }
+
+  auto maxWrite = std::max<uint64_t>(FLAGS_max_write, 1);
+  auto requestsPerWrite = (writeSize + maxWrite - 1) / maxWrite;
+  state.SetBytesProcessed(state.iterations() * writeSize);
+  state.counters["fuse_requests"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * requestsPerWrite),
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(sequential_writes)
+    ->Arg(4 * 1024)
+    ->Arg(32 * 1024)
+    ->Arg(128 * 1024)
+    ->Arg(256 * 1024)
+    ->Arg(512 * 1024)
+    ->Arg(1024 * 1024);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/model/CompactTree.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/git/GitTree.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kEntryCount = 100000;
+
+/// A serialized git tree of kEntryCount regular files, in sorted order.
+const std::string& getGitTree() {
+  static auto tree = [] {
+    std::string body;
+    for (size_t i = 0; i < kEntryCount; ++i) {
+      body += fmt::format("100644 file{:08}", i);
+      body.push_back('\0');
+      auto hash = Hash20::sha1(folly::to<std::string>(i));
+      auto bytes = hash.getBytes();
+      body.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    std::string tree = fmt::format("tree {}", body.size());
+    tree.push_back('\0');
+    return tree + body;
+  }();
+  return tree;
+}
+
+void deserialize_git_tree(benchmark::State& state) {
+  auto& data = getGitTree();
+  auto hash = ObjectId::sha1(data);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        deserializeGitTree(hash, folly::StringPiece{data}));
+  }
+  state.SetItemsProcessed(state.iterations() * kEntryCount);
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+void deserialize_git_compact_tree(benchmark::State& state) {
+  auto& data = getGitTree();
+  auto hash = ObjectId::sha1(data);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        deserializeGitCompactTree(hash, folly::StringPiece{data}));
+  }
+  state.SetItemsProcessed(state.iterations() * kEntryCount);
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK(deserialize_git_tree)->Unit(benchmark::kMillisecond);
+BENCHMARK(deserialize_git_compact_tree)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/Hex.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kHashCount = 4096;
+
+const std::vector<Hash20>& getHashes() {
+  static auto hashes = [] {
+    std::vector<Hash20> hashes;
+    hashes.reserve(kHashCount);
+    for (size_t i = 0; i < kHashCount; ++i) {
+      hashes.push_back(Hash20::sha1(folly::to<std::string>(i)));
+    }
+    return hashes;
+  }();
+  return hashes;
+}
+
+const std::vector<std::string>& getHexHashes() {
+  static auto hexHashes = [] {
+    std::vector<std::string> hexHashes;
+    hexHashes.reserve(kHashCount);
+    for (auto& hash : getHashes()) {
+      hexHashes.push_back(hash.toString());
+    }
+    return hexHashes;
+  }();
+  return hexHashes;
+}
+
+void hexlify_hash20(benchmark::State& state) {
+  auto& hashes = getHashes();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        folly::hexlify(hashes[index++ % kHashCount].getBytes()));
+  }
+}
+
+void hash20_to_string(benchmark::State& state) {
+  auto& hashes = getHashes();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hashes[index++ % kHashCount].toString());
+  }
+}
+
+void unhexlify_hash20(benchmark::State& state) {
+  auto& hexHashes = getHexHashes();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        folly::unhexlify(hexHashes[index++ % kHashCount]));
+  }
+}
+
+void hash20_constexpr_from_hex(benchmark::State& state) {
+  auto& hexHashes = getHexHashes();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Hash20{hexHashes[index++ % kHashCount]});
+  }
+}
+
+void hash20_from_hex(benchmark::State& state) {
+  auto& hexHashes = getHexHashes();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Hash20::fromHex(hexHashes[index++ % kHashCount]));
+  }
+}
+
+void object_id_from_hex(benchmark::State& state) {
+  auto& hexHashes = getHexHashes();
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ObjectId::fromHex(hexHashes[index++ % kHashCount]));
+  }
+}
+
+/**
+ * Bulk encoding, as done when rendering many object IDs into one buffer. The
+ * argument is the input size in bytes.
+ */
+void hex_encode_bulk(benchmark::State& state) {
+  std::string bytes(static_cast<size_t>(state.range(0)), 'x');
+  std::string out(bytes.size() * 2, '\0');
+  for (auto _ : state) {
+    hexEncode(folly::ByteRange{folly::StringPiece{bytes}}, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void hex_decode_bulk(benchmark::State& state) {
+  std::string bytes(static_cast<size_t>(state.range(0)), 'x');
+  auto hex = folly::hexlify(bytes);
+  std::vector<uint8_t> out(bytes.size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hexDecode(hex, out.data()));
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK(hexlify_hash20);
+BENCHMARK(hash20_to_string);
+BENCHMARK(unhexlify_hash20);
+BENCHMARK(hash20_constexpr_from_hex);
+BENCHMARK(hash20_from_hex);
+BENCHMARK(object_id_from_hex);
+BENCHMARK(hex_encode_bulk)->Range(20, 64 * 1024);
+BENCHMARK(hex_decode_bulk)->Range(20, 64 * 1024);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -7,6 +7,7 @@
 
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
@@ -24,12 +25,17 @@ Hash20 uniqueHash() {
 }
 
 std::shared_ptr<HgImportRequest> makeBlobImportRequest(
-    ImportPriority priority) {
-  auto hgRevHash = uniqueHash();
+    ImportPriority priority,
+    Hash20 hgRevHash = uniqueHash(),
+    std::optional<pid_t> pid = std::nullopt) {
   auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, hgRevHash};
   auto hash = proxyHash.sha1();
   return HgImportRequest::makeBlobImportRequest(
-      hash, std::move(proxyHash), priority, ObjectFetchContext::Cause::Unknown);
+      hash,
+      std::move(proxyHash),
+      priority,
+      ObjectFetchContext::Cause::Unknown,
+      pid);
 }
 
 void enqueue(benchmark::State& state) {
@@ -68,6 +74,60 @@ void dequeue(benchmark::State& state) {
   }
 }
 
+/**
+ * All threads share one queue and each iteration enqueues a request, every
+ * fourth one followed by a higher priority duplicate, then dequeues one and
+ * marks it finished. Each thread acts as a separate client, so this covers
+ * de-duplication, priority raises and the fair queue under contention.
+ *
+ * The batch size is 1 and every thread enqueues before it dequeues, so a
+ * dequeue never waits for a request that no thread will enqueue.
+ */
+void enqueueDequeueFinish(benchmark::State& state) {
+  static std::unique_ptr<HgImportRequestQueue> queue;
+  if (state.thread_index() == 0) {
+    auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+    rawEdenConfig->importBatchSize.setValue(1, ConfigSource::Default, true);
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        rawEdenConfig, ConfigReloadBehavior::NoReload);
+    queue = std::make_unique<HgImportRequestQueue>(edenConfig);
+  }
+
+  auto pid = static_cast<pid_t>(state.thread_index() + 1);
+  std::vector<std::shared_ptr<HgImportRequest>> requests;
+  requests.reserve(state.max_iterations);
+  for (size_t i = 0; i < state.max_iterations; i++) {
+    requests.emplace_back(
+        makeBlobImportRequest(ImportPriority::kNormal(), uniqueHash(), pid));
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    auto& request = requests[i];
+    std::shared_ptr<HgImportRequest> duplicate;
+    if (i++ % 4 == 0) {
+      auto* blobImport = request->getRequest<HgImportRequest::BlobImport>();
+      duplicate = makeBlobImportRequest(
+          ImportPriority::kHigh(), blobImport->proxyHash.revHash(), pid);
+    }
+    queue->enqueueBlob(std::move(request));
+    if (duplicate) {
+      queue->enqueueBlob(std::move(duplicate));
+    }
+
+    for (auto& dequeued : queue->dequeue()) {
+      auto* blobImport = dequeued->getRequest<HgImportRequest::BlobImport>();
+      auto result = folly::Try<std::unique_ptr<Blob>>{
+          std::make_unique<Blob>(blobImport->hash, folly::IOBuf{})};
+      queue->markImportAsFinished<Blob>(blobImport->hash, result);
+    }
+  }
+
+  if (state.thread_index() == 0) {
+    queue.reset();
+  }
+}
+
 BENCHMARK(enqueue)
     ->Unit(benchmark::kNanosecond)
     ->Threads(1)
@@ -85,6 +145,16 @@ BENCHMARK(dequeue)
     ->Threads(8)
     ->Threads(16)
     ->Threads(32);
+
+BENCHMARK(enqueueDequeueFinish)
+    ->Unit(benchmark::kNanosecond)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32)
+    ->UseRealTime();
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
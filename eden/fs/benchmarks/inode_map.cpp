@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kDirCount = 64;
+constexpr size_t kFilesPerDir = 64;
+
+/**
+ * A mount with every inode loaded, and the numbers of those inodes.
+ */
+struct LoadedMount {
+  LoadedMount() {
+    FakeTreeBuilder builder;
+    for (size_t dir = 0; dir < kDirCount; ++dir) {
+      for (size_t file = 0; file < kFilesPerDir; ++file) {
+        builder.setFile(
+            folly::to<std::string>("dir", dir, "/file", file), "contents");
+      }
+    }
+    mount = std::make_unique<TestMount>(builder);
+    for (size_t dir = 0; dir < kDirCount; ++dir) {
+      auto dirPath = folly::to<std::string>("dir", dir);
+      for (size_t file = 0; file < kFilesPerDir; ++file) {
+        auto inode =
+            mount->getInode(folly::to<std::string>(dirPath, "/file", file));
+        inodes.push_back(inode->getNodeId());
+        // Keep the inodes referenced so they stay loaded.
+        references.push_back(std::move(inode));
+      }
+    }
+  }
+
+  std::unique_ptr<TestMount> mount;
+  std::vector<InodeNumber> inodes;
+  std::vector<InodePtr> references;
+};
+
+/**
+ * The mount is shared by all benchmarks and threads, and built on first use.
+ */
+LoadedMount& getLoadedMount() {
+  static auto* loaded = new LoadedMount();
+  return *loaded;
+}
+
+/**
+ * Every thread looks up already-loaded inodes, spread over the whole mount,
+ * as FUSE/NFS worker threads do for requests on files that are in use.
+ */
+void lookup_loaded_inode(benchmark::State& state) {
+  auto& loaded = getLoadedMount();
+  auto* inodeMap = loaded.mount->getEdenMount()->getInodeMap();
+  const auto& inodes = loaded.inodes;
+
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    auto inode =
+        inodeMap->lookupInode(inodes[index++ % inodes.size()]).get();
+    benchmark::DoNotOptimize(inode);
+  }
+}
+
+/**
+ * Like lookup_loaded_inode, but every thread looks up the same inode, so
+ * sharding can not help and only the cost of the shared lock remains.
+ */
+void lookup_same_loaded_inode(benchmark::State& state) {
+  auto& loaded = getLoadedMount();
+  auto* inodeMap = loaded.mount->getEdenMount()->getInodeMap();
+  auto number = loaded.inodes.front();
+
+  for (auto _ : state) {
+    auto inode = inodeMap->lookupInode(number).get();
+    benchmark::DoNotOptimize(inode);
+  }
+}
+
+BENCHMARK(lookup_loaded_inode)
+    ->Unit(benchmark::kNanosecond)
+    ->ThreadRange(1, 128)
+    ->UseRealTime();
+
+BENCHMARK(lookup_same_loaded_inode)
+    ->Unit(benchmark::kNanosecond)
+    ->ThreadRange(1, 128)
+    ->UseRealTime();
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/experimental/TestUtil.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/InodeMetadata.h"
+#include "eden/fs/inodes/InodeTable.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr uint64_t kInodeCount = 100000;
+
+/**
+ * An InodeMetadataTable shared by every benchmark thread, with metadata for
+ * inodes [1, kInodeCount].
+ */
+struct PopulatedTable {
+  PopulatedTable()
+      : tmpDir{"eden_inode_table_bench_"},
+        table{InodeMetadataTable::open(
+            (tmpDir.path() / "metadata.table").string())} {
+    for (uint64_t i = 1; i <= kInodeCount; ++i) {
+      table->set(InodeNumber{i}, InodeMetadata{});
+    }
+  }
+
+  folly::test::TemporaryDirectory tmpDir;
+  std::unique_ptr<InodeMetadataTable> table;
+};
+
+InodeMetadataTable& getTable() {
+  static PopulatedTable populated;
+  return *populated.table;
+}
+
+/**
+ * Mimics setattr: every iteration modifies the metadata of a different
+ * inode. Tail latencies show how much a concurrent flush or a remap stalls
+ * writers.
+ */
+void modifyOrThrow(benchmark::State& state) {
+  auto& table = getTable();
+  std::vector<uint64_t> latencies;
+  latencies.reserve(1 << 20);
+  uint64_t ino = 1 + state.thread_index() * (kInodeCount / 64);
+  uint64_t iteration = 0;
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    table.modifyOrThrow(InodeNumber{ino}, [&](InodeMetadata& metadata) {
+      metadata.mode = static_cast<mode_t>(iteration);
+    });
+    auto end = std::chrono::steady_clock::now();
+    if (latencies.size() < latencies.capacity()) {
+      latencies.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count());
+    }
+    ino = ino % kInodeCount + 1;
+    ++iteration;
+    if (state.thread_index() == 0 && iteration % 4096 == 0) {
+      table.flushAsync();
+    }
+  }
+
+  if (latencies.empty()) {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    auto index = static_cast<size_t>(p * (latencies.size() - 1));
+    return benchmark::Counter(
+        static_cast<double>(latencies[index]), benchmark::Counter::kAvgThreads);
+  };
+  state.counters["p50_ns"] = percentile(0.5);
+  state.counters["p99_ns"] = percentile(0.99);
+  state.counters["p999_ns"] = percentile(0.999);
+}
+
+BENCHMARK(modifyOrThrow)->ThreadRange(1, 64);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
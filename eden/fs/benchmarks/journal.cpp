@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <atomic>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/journal/Journal.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kPathCount = 4096;
+
+const std::vector<RelativePath>& getPaths() {
+  static auto paths = [] {
+    std::vector<RelativePath> paths;
+    paths.reserve(kPathCount);
+    for (size_t i = 0; i < kPathCount; ++i) {
+      paths.emplace_back(folly::to<std::string>("dir", i % 64, "/file", i));
+    }
+    return paths;
+  }();
+  return paths;
+}
+
+/**
+ * Every thread records changes to a shared Journal that has as many
+ * subscribers as the benchmark argument. Consecutive changes are to different
+ * paths, so none of them are compacted away.
+ */
+void journal_record_changed(benchmark::State& state) {
+  static std::unique_ptr<Journal> journal;
+  static std::atomic<uint64_t> notifications;
+  auto& paths = getPaths();
+  if (state.thread_index() == 0) {
+    journal = std::make_unique<Journal>(std::make_shared<EdenStats>());
+    notifications = 0;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      journal->registerSubscriber(
+          [] { notifications.fetch_add(1, std::memory_order_relaxed); });
+    }
+  }
+
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    journal->recordChanged(paths[index++ % kPathCount]);
+  }
+
+  if (state.thread_index() == 0) {
+    journal->flush();
+    state.counters["notifications"] = benchmark::Counter(
+        static_cast<double>(notifications.load()),
+        benchmark::Counter::kAvgIterations);
+    journal->cancelAllSubscribers();
+    journal.reset();
+  }
+}
+
+/**
+ * Accumulate a range over a history of as many deltas as the benchmark
+ * argument.
+ */
+void journal_accumulate_range(benchmark::State& state) {
+  auto& paths = getPaths();
+  Journal journal{std::make_shared<EdenStats>()};
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    journal.recordChanged(paths[i % kPathCount]);
+  }
+  journal.flush();
+
+  for (auto _ : state) {
+    auto range = journal.accumulateRange();
+    benchmark::DoNotOptimize(range);
+  }
+}
+
+/**
+ * Record as many deltas as the benchmark argument, and report the memory the
+ * Journal uses for each of them.
+ */
+void journal_memory_per_delta(benchmark::State& state) {
+  auto& paths = getPaths();
+  auto deltas = state.range(0);
+  double bytesPerDelta = 0;
+  for (auto _ : state) {
+    Journal journal{std::make_shared<EdenStats>()};
+    for (int64_t i = 0; i < deltas; ++i) {
+      journal.recordChanged(paths[i % kPathCount]);
+    }
+    journal.flush();
+    bytesPerDelta = static_cast<double>(journal.estimateMemoryUsage()) / deltas;
+  }
+  state.SetItemsProcessed(state.iterations() * deltas);
+  state.counters["bytes_per_delta"] = bytesPerDelta;
+}
+
+BENCHMARK(journal_record_changed)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgName("subscribers")
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(16)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+BENCHMARK(journal_accumulate_range)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgName("depth")
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 20);
+
+BENCHMARK(journal_memory_per_delta)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgName("deltas")
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 20);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <folly/testing/TestUtil.h>
+#include <random>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FaultInjector.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kKeyCount = 16 * 1024;
+constexpr size_t kBatchSize = 64;
+
+enum StoreKind : int64_t { Memory, Sqlite, RocksDb };
+
+/**
+ * Blob sizes of a typical source repository: mostly files of a few KiB, with
+ * a long tail of large ones. The last column is the weight, out of 100.
+ */
+constexpr std::pair<size_t, size_t> kBlobSizes[] = {
+    {128, 10},
+    {1024, 20},
+    {4 * 1024, 35},
+    {16 * 1024, 25},
+    {64 * 1024, 8},
+    {1024 * 1024, 2},
+};
+
+size_t pickBlobSize(std::mt19937& rng) {
+  auto weight = std::uniform_int_distribution<size_t>{0, 99}(rng);
+  for (auto [size, sizeWeight] : kBlobSizes) {
+    if (weight < sizeWeight) {
+      return size;
+    }
+    weight -= sizeWeight;
+  }
+  return kBlobSizes[0].first;
+}
+
+ObjectId makeHash(size_t i) {
+  std::array<uint8_t, 20> bytes{};
+  std::memcpy(bytes.data(), &i, sizeof(i));
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+/**
+ * A LocalStore of the kind of the first benchmark argument, filled with
+ * kKeyCount blobs whose sizes follow kBlobSizes.
+ */
+struct FilledStore {
+  explicit FilledStore(int64_t kind) {
+    switch (kind) {
+      case Memory:
+        store = std::make_shared<MemoryLocalStore>();
+        break;
+      case Sqlite:
+        store = std::make_shared<SqliteLocalStore>(
+            AbsolutePath{tempDir.path().string()} + "sqlite"_pc);
+        break;
+      case RocksDb:
+        store = std::make_shared<RocksDbLocalStore>(
+            AbsolutePathPiece{tempDir.path().string()},
+            std::make_shared<NullStructuredLogger>(),
+            &faultInjector);
+        break;
+    }
+
+    std::mt19937 rng{0};
+    auto batch = store->beginWrite();
+    for (size_t i = 0; i < kKeyCount; ++i) {
+      keys.push_back(makeHash(i));
+      batch->put(
+          KeySpace::BlobFamily,
+          keys.back(),
+          folly::StringPiece{std::string(pickBlobSize(rng), 'x')});
+    }
+    batch->flush();
+  }
+
+  folly::test::TemporaryDirectory tempDir = makeTempDir();
+  FaultInjector faultInjector{/*enabled=*/false};
+  std::shared_ptr<LocalStore> store;
+  std::vector<ObjectId> keys;
+};
+
+/**
+ * Stores are shared by the threads of a benchmark, and created by the first
+ * one.
+ */
+std::unique_ptr<FilledStore> filledStore;
+
+void setUpStore(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    filledStore = std::make_unique<FilledStore>(state.range(0));
+  }
+}
+
+void tearDownStore(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    filledStore.reset();
+  }
+}
+
+void local_store_get(benchmark::State& state) {
+  setUpStore(state);
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    auto result = filledStore->store->get(
+        KeySpace::BlobFamily,
+        filledStore->keys[index++ % kKeyCount].getBytes());
+    benchmark::DoNotOptimize(result);
+  }
+  tearDownStore(state);
+}
+
+void local_store_get_batch(benchmark::State& state) {
+  setUpStore(state);
+  size_t index = state.thread_index() * 7919;
+  std::vector<folly::ByteRange> keys(kBatchSize);
+  for (auto _ : state) {
+    for (auto& key : keys) {
+      key = filledStore->keys[index++ % kKeyCount].getBytes();
+    }
+    auto results =
+        filledStore->store->getBatch(KeySpace::BlobFamily, keys).get();
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  tearDownStore(state);
+}
+
+void local_store_put(benchmark::State& state) {
+  setUpStore(state);
+  std::mt19937 rng(state.thread_index());
+  std::vector<std::string> values;
+  for (size_t i = 0; i < 1024; ++i) {
+    values.emplace_back(pickBlobSize(rng), 'y');
+  }
+  size_t index = kKeyCount + state.thread_index() * (1ull << 40);
+  for (auto _ : state) {
+    filledStore->store->put(
+        KeySpace::BlobFamily,
+        makeHash(index),
+        folly::StringPiece{values[index % values.size()]});
+    ++index;
+  }
+  tearDownStore(state);
+}
+
+Tree makeTree(size_t entryCount) {
+  std::vector<TreeEntry> entries;
+  entries.reserve(entryCount);
+  for (size_t i = 0; i < entryCount; ++i) {
+    entries.emplace_back(
+        makeHash(i),
+        PathComponent{folly::to<std::string>("some_file_name_", i, ".cpp")},
+        TreeEntryType::REGULAR_FILE,
+        4096,
+        Hash20{});
+  }
+  return Tree{std::move(entries), makeHash(entryCount)};
+}
+
+void tree_serialize(benchmark::State& state) {
+  auto tree = makeTree(state.range(0));
+  for (auto _ : state) {
+    auto serialized = tree.serialize();
+    benchmark::DoNotOptimize(serialized);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void tree_deserialize(benchmark::State& state) {
+  auto tree = makeTree(state.range(0));
+  auto serialized = tree.serialize();
+  auto data = folly::StringPiece{serialized.coalesce()};
+  for (auto _ : state) {
+    auto result = Tree::tryDeserialize(tree.getHash(), data);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Load proxy hashes that aren't embedded in their ID, so each load reads the
+ * LocalStore.
+ */
+void hg_proxy_hash_load(benchmark::State& state) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  std::vector<ObjectId> ids;
+  auto batch = store->beginWrite();
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    ids.push_back(HgProxyHash::store(
+        RelativePathPiece{folly::to<std::string>("some/dir/file", i)},
+        Hash20{},
+        HgObjectIdFormat::ProxyHash,
+        batch.get()));
+  }
+  batch->flush();
+
+  size_t index = 0;
+  for (auto _ : state) {
+    auto proxyHash = HgProxyHash::load(
+        store.get(), ids[index++ % kKeyCount], __func__);
+    benchmark::DoNotOptimize(proxyHash);
+  }
+}
+
+void hg_proxy_hash_store(benchmark::State& state) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  auto batch = store->beginWrite();
+  size_t index = 0;
+  for (auto _ : state) {
+    auto id = HgProxyHash::store(
+        RelativePathPiece{folly::to<std::string>("some/dir/file", index++)},
+        Hash20{},
+        static_cast<HgObjectIdFormat>(state.range(0)),
+        batch.get());
+    benchmark::DoNotOptimize(id);
+  }
+  batch->flush();
+}
+
+BENCHMARK(local_store_get)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgName("store")
+    ->DenseRange(Memory, RocksDb)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+BENCHMARK(local_store_get_batch)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgName("store")
+    ->DenseRange(Memory, RocksDb)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+BENCHMARK(local_store_put)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgName("store")
+    ->DenseRange(Memory, RocksDb)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+BENCHMARK(tree_serialize)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgName("entries")
+    ->RangeMultiplier(16)
+    ->Range(1, 4096);
+
+BENCHMARK(tree_deserialize)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgName("entries")
+    ->RangeMultiplier(16)
+    ->Range(1, 4096);
+
+BENCHMARK(hg_proxy_hash_load)->Unit(benchmark::kNanosecond);
+
+BENCHMARK(hg_proxy_hash_store)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgName("format")
+    ->Arg(static_cast<int64_t>(HgObjectIdFormat::ProxyHash))
+    ->Arg(static_cast<int64_t>(HgObjectIdFormat::WithPath))
+    ->Arg(static_cast<int64_t>(HgObjectIdFormat::HashOnly));
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/lang/Bits.h>
+#include <gflags/gflags.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cstring>
+#include <thread>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/nfs/rpc/Rpc.h"
+#include "eden/fs/nfs/rpc/Server.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+
+/*
+ * Sends batches of pipelined RPC calls over a single TCP connection, like the
+ * macOS NFS client does, to an RpcServer whose procedures block for
+ * --work_us. Throughput should scale with the number of worker threads until
+ * --max_inflight is reached.
+ */
+
+using namespace facebook::eden;
+
+namespace {
+
+DEFINE_uint64(batch, 256, "Number of calls in flight from the client");
+DEFINE_uint64(work_us, 100, "Time each call blocks a worker thread");
+DEFINE_uint64(
+    max_inflight,
+    512,
+    "Maximum number of requests processed concurrently per connection");
+
+constexpr uint32_t kProgram = 100003;
+constexpr uint32_t kVersion = 3;
+
+class SleepingProcessor : public RpcServerProcessor {
+ public:
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor /*deser*/,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t /*progNumber*/,
+      uint32_t /*progVersion*/,
+      uint32_t /*procNumber*/) override {
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::microseconds{FLAGS_work_us});
+    serializeReply(ser, accept_stat::SUCCESS, xid);
+    return folly::unit;
+  }
+};
+
+std::string serializeCall(uint32_t xid) {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender ser(&queue, 1024);
+  XdrTrait<uint32_t>::serialize(ser, 0); // reserve space for fragment header
+  rpc_msg_call call{
+      xid,
+      msg_type::CALL,
+      call_body{
+          kRPCVersion,
+          kProgram,
+          kVersion,
+          0,
+          opaque_auth{auth_flavor::AUTH_NONE, OpaqueBytes{}},
+          opaque_auth{auth_flavor::AUTH_NONE, OpaqueBytes{}}}};
+  XdrTrait<rpc_msg_call>::serialize(ser, call);
+
+  std::string bytes;
+  queue.move()->appendTo(bytes);
+  auto length = uint32_t(bytes.size() - sizeof(uint32_t)) | 0x80000000;
+  auto header = folly::Endian::big(length);
+  memcpy(bytes.data(), &header, sizeof(header));
+  return bytes;
+}
+
+void readReply(int fd, std::string& buffer) {
+  uint32_t header;
+  folly::checkUnixError(
+      folly::readFull(fd, &header, sizeof(header)), "read header");
+  buffer.resize(folly::Endian::big(header) & 0x7fffffff);
+  folly::checkUnixError(
+      folly::readFull(fd, buffer.data(), buffer.size()), "read reply");
+}
+
+void pipelined_calls(benchmark::State& state) {
+  folly::ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  auto threadPool =
+      std::make_shared<folly::CPUThreadPoolExecutor>(state.range(0));
+  std::shared_ptr<RpcServer> server;
+  evb->runInEventBaseThreadAndWait([&] {
+    server = RpcServer::create(
+        std::make_shared<SleepingProcessor>(),
+        evb,
+        threadPool,
+        std::make_shared<NullStructuredLogger>(),
+        FLAGS_max_inflight);
+    server->initialize(folly::SocketAddress{"127.0.0.1", 0});
+  });
+
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  folly::checkUnixError(fd, "socket");
+  sockaddr_storage addr;
+  auto addrLen = server->getAddr().getAddress(&addr);
+  folly::checkUnixError(
+      ::connect(fd, reinterpret_cast<sockaddr*>(&addr), addrLen), "connect");
+
+  std::string calls;
+  for (uint32_t xid = 1; xid <= FLAGS_batch; ++xid) {
+    calls += serializeCall(xid);
+  }
+
+  std::string reply;
+  for (auto _ : state) {
+    folly::checkUnixError(
+        folly::writeFull(fd, calls.data(), calls.size()), "write calls");
+    for (uint64_t i = 0; i < FLAGS_batch; ++i) {
+      readReply(fd, reply);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * FLAGS_batch);
+
+  ::close(fd);
+  evb->runInEventBaseThreadAndWait([&] { server.reset(); });
+  threadPool->join();
+}
+
+BENCHMARK(pipelined_calls)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/TreeCache.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kBlobCount = 4096;
+constexpr size_t kBlobSize = 1024;
+constexpr size_t kTreeCount = 4096;
+constexpr size_t kTreeEntries = 64;
+
+ObjectId makeHash(size_t i) {
+  std::array<uint8_t, 20> bytes{};
+  std::memcpy(bytes.data(), &i, sizeof(i));
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+std::vector<std::shared_ptr<const Blob>> makeBlobs() {
+  std::vector<std::shared_ptr<const Blob>> blobs;
+  blobs.reserve(kBlobCount);
+  for (size_t i = 0; i < kBlobCount; ++i) {
+    auto hash = makeHash(i);
+    folly::IOBuf contents{folly::IOBuf::CREATE, kBlobSize};
+    contents.append(kBlobSize);
+    blobs.push_back(std::make_shared<Blob>(hash, std::move(contents)));
+  }
+  return blobs;
+}
+
+const std::vector<std::shared_ptr<const Blob>>& getBlobs() {
+  static auto blobs = makeBlobs();
+  return blobs;
+}
+
+std::vector<std::shared_ptr<const Tree>> makeTrees() {
+  std::vector<std::shared_ptr<const Tree>> trees;
+  trees.reserve(kTreeCount);
+  for (size_t i = 0; i < kTreeCount; ++i) {
+    std::vector<TreeEntry> entries;
+    entries.reserve(kTreeEntries);
+    for (size_t entry = 0; entry < kTreeEntries; ++entry) {
+      entries.emplace_back(
+          makeHash(kTreeCount + i * kTreeEntries + entry),
+          PathComponent{folly::to<std::string>("file", entry)},
+          TreeEntryType::REGULAR_FILE,
+          kBlobSize,
+          Hash20{});
+    }
+    trees.push_back(std::make_shared<Tree>(std::move(entries), makeHash(i)));
+  }
+  return trees;
+}
+
+const std::vector<std::shared_ptr<const Tree>>& getTrees() {
+  static auto trees = makeTrees();
+  return trees;
+}
+
+/**
+ * Make a TreeCache with the shard count and compact representation flag of
+ * the benchmark arguments, holding `fraction` of the trees.
+ */
+std::shared_ptr<TreeCache> makeTreeCache(
+    benchmark::State& state,
+    double fraction) {
+  std::shared_ptr<EdenConfig> config = EdenConfig::createTestEdenConfig();
+  config->inMemoryTreeCacheSize.setValue(
+      static_cast<size_t>(
+          fraction * getTrees().size() * getTrees()[0]->getSizeBytes()),
+      ConfigSource::Default);
+  config->inMemoryTreeCacheShards.setValue(
+      static_cast<size_t>(state.range(0)), ConfigSource::Default);
+  config->inMemoryTreeCacheCompact.setValue(
+      state.range(1) != 0, ConfigSource::Default);
+  return TreeCache::create(std::make_shared<ReloadableConfig>(
+      config, ConfigReloadBehavior::NoReload));
+}
+
+/**
+ * All threads share one BlobCache large enough to hold every blob, and
+ * repeatedly look up blobs in it. The shard count is the benchmark argument,
+ * so comparing Arg(1) against larger values shows how much of the cost is
+ * lock contention.
+ */
+void blob_cache_get(benchmark::State& state) {
+  static std::shared_ptr<BlobCache> cache;
+  auto& blobs = getBlobs();
+  if (state.thread_index() == 0) {
+    cache = BlobCache::create(
+        kBlobCount * kBlobSize * 2, 0, static_cast<size_t>(state.range(0)));
+    for (auto& blob : blobs) {
+      cache->insert(blob);
+    }
+  }
+
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    auto result = cache->get(blobs[index++ % kBlobCount]->getHash());
+    benchmark::DoNotOptimize(result);
+  }
+
+  if (state.thread_index() == 0) {
+    cache.reset();
+  }
+}
+
+/**
+ * Every thread inserts blobs into a cache that is too small to hold them all,
+ * so each insert also evicts.
+ */
+void blob_cache_insert_evict(benchmark::State& state) {
+  static std::shared_ptr<BlobCache> cache;
+  auto& blobs = getBlobs();
+  if (state.thread_index() == 0) {
+    cache = BlobCache::create(
+        kBlobCount * kBlobSize / 4, 0, static_cast<size_t>(state.range(0)));
+  }
+
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    cache->insert(blobs[index++ % kBlobCount]);
+  }
+
+  if (state.thread_index() == 0) {
+    cache.reset();
+  }
+}
+
+/**
+ * Like blob_cache_get, for a TreeCache holding every tree.
+ */
+void tree_cache_get(benchmark::State& state) {
+  static std::shared_ptr<TreeCache> cache;
+  auto& trees = getTrees();
+  if (state.thread_index() == 0) {
+    cache = makeTreeCache(state, 2);
+    for (auto& tree : trees) {
+      cache->insert(tree);
+    }
+  }
+
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    auto result = cache->get(trees[index++ % kTreeCount]->getHash());
+    benchmark::DoNotOptimize(result);
+  }
+
+  if (state.thread_index() == 0) {
+    cache.reset();
+  }
+}
+
+/**
+ * Like blob_cache_insert_evict, for a TreeCache holding a quarter of the
+ * trees.
+ */
+void tree_cache_insert_evict(benchmark::State& state) {
+  static std::shared_ptr<TreeCache> cache;
+  auto& trees = getTrees();
+  if (state.thread_index() == 0) {
+    cache = makeTreeCache(state, 0.25);
+  }
+
+  size_t index = state.thread_index() * 7919;
+  for (auto _ : state) {
+    cache->insert(trees[index++ % kTreeCount]);
+  }
+
+  if (state.thread_index() == 0) {
+    cache.reset();
+  }
+}
+
+BENCHMARK(blob_cache_get)
+    ->Unit(benchmark::kNanosecond)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->ThreadRange(1, 128)
+    ->UseRealTime();
+
+BENCHMARK(blob_cache_insert_evict)
+    ->Unit(benchmark::kNanosecond)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->ThreadRange(1, 128)
+    ->UseRealTime();
+
+BENCHMARK(tree_cache_get)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgNames({"shards", "compact"})
+    ->ArgsProduct({{1, 16}, {0, 1}})
+    ->ThreadRange(1, 128)
+    ->UseRealTime();
+
+BENCHMARK(tree_cache_insert_evict)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgNames({"shards", "compact"})
+    ->ArgsProduct({{1, 16}, {0, 1}})
+    ->ThreadRange(1, 128)
+    ->UseRealTime();
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
+#include <random>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/utils/IoUring.h"
+
+using namespace facebook::eden;
+
+namespace {
+constexpr size_t kPageSize = 4096;
+
+DEFINE_string(
+    filename,
+    "overlay_io.tmp",
+    "Path to which reads and writes should be issued");
+DEFINE_uint64(filesize, kPageSize * 4096, "File size in bytes");
+DEFINE_uint32(queue_depth, 256, "Number of io_uring submission entries");
+
+struct TemporaryFile {
+  TemporaryFile()
+      : file{FLAGS_filename, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC} {
+    if (FLAGS_filesize == 0 || (FLAGS_filesize % kPageSize)) {
+      throw std::invalid_argument{"file size must be multiple of page size"};
+    }
+    folly::checkUnixError(ftruncate(file.fd(), FLAGS_filesize), "ftruncate");
+  }
+
+  ~TemporaryFile() {
+    folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+  }
+
+  folly::File file;
+};
+
+int getTemporaryFD() {
+  static TemporaryFile tf;
+  return tf.file.fd();
+}
+
+/**
+ * Returns null if io_uring is not available.
+ */
+IoUring* getIoUring() {
+  static auto ring = IoUring::isSupported()
+      ? std::make_unique<IoUring>(FLAGS_queue_depth)
+      : nullptr;
+  return ring.get();
+}
+
+/**
+ * Random page-aligned offsets to issue I/O at, along with a page of data.
+ *
+ * std::uniform_int_distribution has as much userspace CPU cost as
+ * __libc_pwrite64 so offsets are pregenerated.
+ */
+struct RandomPages {
+  RandomPages() {
+    folly::File urandom{"/dev/urandom", O_RDONLY | O_CLOEXEC};
+    folly::checkUnixError(
+        folly::readFull(urandom.fd(), page, sizeof(page)), "read /dev/urandom");
+
+    off_t pageCount = FLAGS_filesize / kPageSize;
+    std::default_random_engine gen{std::random_device{}()};
+    std::uniform_int_distribution<off_t> rng{0, pageCount - 1};
+    std::generate(std::begin(offsets), std::end(offsets), [&] {
+      return rng(gen) * kPageSize;
+    });
+  }
+
+  off_t next() {
+    return offsets[index++ % std::size(offsets)];
+  }
+
+  char page[kPageSize];
+  off_t offsets[16 * 1024];
+  size_t index = 0;
+};
+
+enum class Mode { Sync, IoUring };
+
+/**
+ * Returns false, after reporting why, if `mode` can't be benchmarked.
+ */
+bool checkMode(benchmark::State& state, Mode mode) {
+  if (mode == Mode::IoUring && !getIoUring()) {
+    state.SkipWithError("io_uring is not supported");
+    return false;
+  }
+  return true;
+}
+
+void checkResult(int ret, const char* op) {
+  if (ret < 0) {
+    folly::throwSystemErrorExplicit(-ret, op);
+  }
+}
+
+void writePage(Mode mode, int fd, char* page, off_t offset) {
+  if (mode == Mode::Sync) {
+    folly::checkUnixError(pwrite(fd, page, kPageSize, offset));
+    return;
+  }
+  iovec iov{page, kPageSize};
+  auto ret = getIoUring()->pwritev(fd, &iov, 1, offset).get();
+  checkResult(ret, "pwritev");
+}
+
+void random_writes(benchmark::State& state, Mode mode) {
+  if (!checkMode(state, mode)) {
+    return;
+  }
+  int fd = getTemporaryFD();
+  RandomPages pages;
+
+  for (auto _ : state) {
+    writePage(mode, fd, pages.page, pages.next());
+  }
+}
+
+void random_reads(benchmark::State& state, Mode mode) {
+  if (!checkMode(state, mode)) {
+    return;
+  }
+  int fd = getTemporaryFD();
+  RandomPages pages;
+
+  for (auto _ : state) {
+    auto offset = pages.next();
+    if (mode == Mode::Sync) {
+      folly::checkUnixError(pread(fd, pages.page, kPageSize, offset));
+    } else {
+      auto ret = getIoUring()->pread(fd, pages.page, kPageSize, offset).get();
+      checkResult(ret, "pread");
+    }
+  }
+}
+
+/**
+ * The pattern of an editor saving a file: write, then fdatasync.
+ */
+void random_writes_fdatasync(benchmark::State& state, Mode mode) {
+  if (!checkMode(state, mode)) {
+    return;
+  }
+  int fd = getTemporaryFD();
+  RandomPages pages;
+
+  for (auto _ : state) {
+    writePage(mode, fd, pages.page, pages.next());
+    if (mode == Mode::Sync) {
+      folly::checkUnixError(fdatasync(fd));
+    } else {
+      auto ret = getIoUring()->fsync(fd, /*datasync=*/true).get();
+      checkResult(ret, "fdatasync");
+    }
+  }
+}
+
+/**
+ * Keeps `state.range(0)` writes in flight from a single thread, which is what
+ * io_uring allows the FUSE worker threads to do.
+ */
+void random_writes_pipelined(benchmark::State& state) {
+  if (!checkMode(state, Mode::IoUring)) {
+    return;
+  }
+  int fd = getTemporaryFD();
+  RandomPages pages;
+  iovec iov{pages.page, kPageSize};
+  std::vector<folly::SemiFuture<int>> inFlight;
+  inFlight.reserve(state.range(0));
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      inFlight.push_back(getIoUring()->pwritev(fd, &iov, 1, pages.next()));
+    }
+    for (auto& future : inFlight) {
+      auto ret = std::move(future).get();
+      checkResult(ret, "pwritev");
+    }
+    inFlight.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_CAPTURE(random_writes, sync, Mode::Sync)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16);
+
+BENCHMARK_CAPTURE(random_writes, io_uring, Mode::IoUring)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16);
+
+BENCHMARK_CAPTURE(random_reads, sync, Mode::Sync)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16);
+
+BENCHMARK_CAPTURE(random_reads, io_uring, Mode::IoUring)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16);
+
+BENCHMARK_CAPTURE(random_writes_fdatasync, sync, Mode::Sync)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16);
+
+BENCHMARK_CAPTURE(random_writes_fdatasync, io_uring, Mode::IoUring)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16);
+
+BENCHMARK(random_writes_pipelined)->Arg(1)->Arg(8)->Arg(64);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kNameCount = 4096;
+
+/**
+ * Names as long as the benchmark argument, mostly ASCII like the names in a
+ * source tree, with one in 16 ending in a multi-byte character.
+ */
+std::vector<std::string> makeNames(size_t length) {
+  std::vector<std::string> names;
+  names.reserve(kNameCount);
+  for (size_t i = 0; i < kNameCount; ++i) {
+    auto name = folly::to<std::string>(i, "_SourceFile");
+    name.resize(length, 'x');
+    if (i % 16 == 0) {
+      name.replace(length - 2, 2, "\xc3\xa9");
+    }
+    names.push_back(std::move(name));
+  }
+  return names;
+}
+
+void path_component_construct(benchmark::State& state) {
+  auto names = makeNames(static_cast<size_t>(state.range(0)));
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(PathComponentPiece{names[index++ % kNameCount]});
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void equals_ignoring_ascii_case(benchmark::State& state) {
+  auto names = makeNames(static_cast<size_t>(state.range(0)));
+  auto upperNames = names;
+  for (auto& name : upperNames) {
+    for (auto& c : name) {
+      if ('a' <= c && c <= 'z') {
+        c -= 'a' - 'A';
+      }
+    }
+  }
+  size_t index = 0;
+  for (auto _ : state) {
+    auto i = index++ % kNameCount;
+    benchmark::DoNotOptimize(equalsIgnoringAsciiCase(names[i], upperNames[i]));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(path_component_construct)->ArgName("length")->Range(16, 256);
+BENCHMARK(equals_ignoring_ascii_case)->ArgName("length")->Range(16, 256);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
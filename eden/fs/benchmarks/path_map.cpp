@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+#include <algorithm>
+#include <random>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/utils/PathMap.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kEntryCount = 10000;
+
+PathMap<size_t> makeMap(CaseSensitivity caseSensitive) {
+  PathMap<size_t> map{caseSensitive};
+  for (size_t i = 0; i < kEntryCount; ++i) {
+    map.emplace(PathComponent{folly::to<std::string>("File_", i, ".cpp")}, i);
+  }
+  return map;
+}
+
+void lookup(
+    benchmark::State& state,
+    CaseSensitivity caseSensitive,
+    folly::StringPiece prefix) {
+  auto map = makeMap(caseSensitive);
+  std::vector<PathComponent> names;
+  names.reserve(kEntryCount);
+  for (size_t i = 0; i < kEntryCount; ++i) {
+    names.emplace_back(folly::to<std::string>(prefix, i, ".cpp"));
+  }
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(names[index++ % kEntryCount]));
+  }
+}
+
+void case_sensitive_hit(benchmark::State& state) {
+  lookup(state, CaseSensitivity::Sensitive, "File_");
+}
+
+void case_sensitive_miss(benchmark::State& state) {
+  lookup(state, CaseSensitivity::Sensitive, "file_");
+}
+
+void case_insensitive_exact_hit(benchmark::State& state) {
+  lookup(state, CaseSensitivity::Insensitive, "File_");
+}
+
+void case_insensitive_folded_hit(benchmark::State& state) {
+  lookup(state, CaseSensitivity::Insensitive, "FILE_");
+}
+
+void case_insensitive_miss(benchmark::State& state) {
+  lookup(state, CaseSensitivity::Insensitive, "missing_");
+}
+
+/**
+ * Insert state.range(0) entries, in random order, into a single map, like a
+ * build populating an output directory.
+ */
+void insert_random_order(benchmark::State& state) {
+  auto count = static_cast<size_t>(state.range(0));
+  std::vector<PathComponent> names;
+  names.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    names.emplace_back(folly::to<std::string>("output_", i, ".o"));
+  }
+  std::shuffle(names.begin(), names.end(), std::mt19937{0});
+
+  for (auto _ : state) {
+    PathMap<size_t> map{CaseSensitivity::Sensitive};
+    for (size_t i = 0; i < count; ++i) {
+      map.emplace(names[i], i);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(case_sensitive_hit);
+BENCHMARK(case_sensitive_miss);
+BENCHMARK(case_insensitive_exact_hit);
+BENCHMARK(case_insensitive_folded_hit);
+BENCHMARK(case_insensitive_miss);
+BENCHMARK(insert_random_order)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Conv.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+/*
+ * Every thread renames files in directories of its own, the way parallel
+ * build steps move their outputs into place. With the benchmark argument set
+ * the files move between two directories, and otherwise within one.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kMaxThreads = 32;
+constexpr size_t kFilesPerDir = 64;
+
+/**
+ * A mount with a pair of materialized directories for each thread, the first
+ * one holding kFilesPerDir loaded files.
+ */
+struct RenameMount {
+  RenameMount() {
+    FakeTreeBuilder builder;
+    builder.setFile("README", "");
+    mount = std::make_unique<TestMount>(builder);
+    for (size_t thread = 0; thread < kMaxThreads; ++thread) {
+      auto dir = folly::to<std::string>("thread", thread);
+      mount->mkdir(dir);
+      mount->mkdir(dir + "/src");
+      mount->mkdir(dir + "/dest");
+      for (size_t file = 0; file < kFilesPerDir; ++file) {
+        auto path = folly::to<std::string>(dir, "/src/file", file);
+        mount->addFile(path, "contents");
+        // Keep the inodes referenced so they stay loaded.
+        references.push_back(mount->getFileInode(path));
+      }
+      dirs.push_back(
+          {mount->getTreeInode(dir + "/src"),
+           mount->getTreeInode(dir + "/dest")});
+    }
+    for (size_t file = 0; file < kFilesPerDir; ++file) {
+      names.emplace_back(folly::to<std::string>("file", file));
+      tmpNames.emplace_back(folly::to<std::string>("file", file, ".tmp"));
+    }
+  }
+
+  std::unique_ptr<TestMount> mount;
+  std::vector<std::pair<TreeInodePtr, TreeInodePtr>> dirs;
+  std::vector<PathComponent> names;
+  std::vector<PathComponent> tmpNames;
+  std::vector<InodePtr> references;
+};
+
+void renameFile(
+    const TreeInodePtr& srcDir,
+    const PathComponent& srcName,
+    const TreeInodePtr& destDir,
+    const PathComponent& destName) {
+  std::move(srcDir->rename(
+                srcName,
+                destDir,
+                destName,
+                InvalidationRequired::No,
+                ObjectFetchContext::getNullContext()))
+      .get();
+}
+
+void rename_parallel(benchmark::State& state) {
+  static std::unique_ptr<RenameMount> renameMount;
+  if (state.thread_index() == 0) {
+    renameMount = std::make_unique<RenameMount>();
+  }
+  bool crossDir = state.range(0) != 0;
+
+  for (auto _ : state) {
+    // The benchmark threads start together, after the mount was built.
+    auto& m = *renameMount;
+    const auto& [src, dest] = m.dirs[state.thread_index()];
+    const auto& to = crossDir ? dest : src;
+    const auto& toNames = crossDir ? m.names : m.tmpNames;
+    // Move every file away, and then back.
+    for (size_t file = 0; file < kFilesPerDir; ++file) {
+      renameFile(src, m.names[file], to, toNames[file]);
+    }
+    for (size_t file = 0; file < kFilesPerDir; ++file) {
+      renameFile(to, toNames[file], src, m.names[file]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * kFilesPerDir);
+
+  if (state.thread_index() == 0) {
+    renameMount.reset();
+  }
+}
+
+BENCHMARK(rename_parallel)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgName("cross_dir")
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,575 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <fmt/core.h>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <sys/stat.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#include "eden/fs/fuse/DirList.h"
+#include "eden/fs/inodes/FuseDispatcherImpl.h"
+#include "eden/fs/service/gen-cpp2/streamingeden_types.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+/*
+ * Replays a recorded stream of FUSE requests and reports the latency of each
+ * kind of request.
+ *
+ * Record a trace with:
+ *
+ *   eden_trace_stream --mountRoot=<mount> --trace=fs --json > trace.json
+ *
+ * Requests are replayed by path, so they can be replayed against a live
+ * mount with --mount, where they become system calls, or against a TestMount
+ * whose tree is synthesized from the paths and read sizes seen in the trace.
+ * Requests on inodes that were looked up before the recording started can't
+ * be resolved to a path, and are skipped.
+ */
+
+DEFINE_string(
+    trace,
+    "",
+    "File of FsEvents printed by eden_trace_stream --trace=fs --json");
+DEFINE_string(
+    mount,
+    "",
+    "Replay against this live mount instead of a TestMount");
+DEFINE_double(
+    speed,
+    1.0,
+    "Replay speed relative to the recording, or 0 to replay as fast as "
+    "possible");
+DEFINE_uint32(
+    threads,
+    16,
+    "Number of requests that can be replayed concurrently");
+
+namespace {
+
+using namespace facebook::eden;
+using namespace std::chrono;
+
+enum class OpKind {
+  Lookup,
+  Getattr,
+  Read,
+  Readdir,
+  Write,
+  Create,
+  Mkdir,
+  Unlink,
+  Rmdir,
+};
+
+constexpr folly::StringPiece kOpNames[] = {
+    "lookup",
+    "getattr",
+    "read",
+    "readdir",
+    "write",
+    "create",
+    "mkdir",
+    "unlink",
+    "rmdir",
+};
+constexpr size_t kOpKindCount = std::size(kOpNames);
+
+struct ReplayOp {
+  OpKind kind;
+  /// The path the request applies to. For lookup, create, mkdir, unlink and
+  /// rmdir, this is the path of the entry, not of its parent.
+  RelativePath path;
+  uint64_t offset = 0;
+  uint64_t length = 0;
+  /// When the request started, relative to the first request of the trace.
+  nanoseconds start{0};
+};
+
+struct Trace {
+  std::vector<ReplayOp> ops;
+  /// The files that existed when recording started, and the largest offset
+  /// read from each.
+  std::map<RelativePath, uint64_t> files;
+  /// The directories that existed when recording started.
+  std::set<RelativePath> dirs;
+  size_t skipped = 0;
+};
+
+/**
+ * Parses the "off=N, len=M" arguments of read and write.
+ */
+std::pair<uint64_t, uint64_t> parseOffsetAndLength(folly::StringPiece args) {
+  folly::StringPiece off;
+  folly::StringPiece len;
+  folly::split(", ", args, off, len);
+  off.removePrefix("off=");
+  len.removePrefix("len=");
+  return {folly::to<uint64_t>(off), folly::to<uint64_t>(len)};
+}
+
+/**
+ * Returns the name of the entry that a create ("name=X, mode=M"), mkdir or
+ * mknod ("X, mode=M") request applies to.
+ */
+folly::StringPiece parseCreatedName(folly::StringPiece args) {
+  args.removePrefix("name=");
+  auto end = args.rfind(", mode=");
+  return end == folly::StringPiece::npos ? args : args.subpiece(0, end);
+}
+
+/**
+ * Builds the ReplayOp for the START event of a FUSE request, or returns
+ * std::nullopt for requests that aren't replayed.
+ */
+std::optional<ReplayOp> makeOp(
+    const FuseCall& call,
+    folly::StringPiece args,
+    RelativePathPiece inodePath) {
+  auto opcode = folly::StringPiece{call.get_opcodeName()};
+  opcode.removePrefix("FUSE_");
+  ReplayOp op{OpKind::Getattr, inodePath.copy()};
+  if (opcode == "LOOKUP") {
+    op.kind = OpKind::Lookup;
+    op.path = inodePath + PathComponentPiece{args};
+  } else if (opcode == "GETATTR") {
+    op.kind = OpKind::Getattr;
+  } else if (opcode == "READ") {
+    op.kind = OpKind::Read;
+    std::tie(op.offset, op.length) = parseOffsetAndLength(args);
+  } else if (opcode == "READDIR" || opcode == "READDIRPLUS") {
+    op.kind = OpKind::Readdir;
+    args.removePrefix("offset=");
+    op.offset = folly::to<uint64_t>(args);
+  } else if (opcode == "WRITE") {
+    op.kind = OpKind::Write;
+    std::tie(op.offset, op.length) = parseOffsetAndLength(args);
+  } else if (opcode == "CREATE") {
+    op.kind = OpKind::Create;
+    op.path = inodePath + PathComponentPiece{parseCreatedName(args)};
+  } else if (opcode == "MKDIR") {
+    op.kind = OpKind::Mkdir;
+    op.path = inodePath + PathComponentPiece{parseCreatedName(args)};
+  } else if (opcode == "UNLINK") {
+    op.kind = OpKind::Unlink;
+    op.path = inodePath + PathComponentPiece{args};
+  } else if (opcode == "RMDIR") {
+    op.kind = OpKind::Rmdir;
+    op.path = inodePath + PathComponentPiece{args};
+  } else {
+    return std::nullopt;
+  }
+  return op;
+}
+
+/**
+ * Reads a trace, resolving the inode of every request to a path with the
+ * results of the lookups, creates and mkdirs that precede it.
+ */
+Trace loadTrace(const std::string& tracePath) {
+  std::string contents;
+  if (!folly::readFile(tracePath.c_str(), contents)) {
+    folly::throwSystemError("failed to read ", tracePath);
+  }
+
+  Trace trace;
+  std::unordered_map<uint64_t, RelativePath> inodePaths{
+      {kRootNodeId.get(), RelativePath{}}};
+  // The ops of requests that have started but not finished, by unique.
+  std::unordered_map<uint64_t, size_t> active;
+  std::set<RelativePath> created;
+  std::optional<int64_t> firstStart;
+
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines, /*ignoreEmpty=*/true);
+  for (auto line : lines) {
+    auto event =
+        apache::thrift::SimpleJSONSerializer::deserialize<FsEvent>(line);
+    const auto* call = event.get_fuseRequest();
+    if (!call) {
+      continue;
+    }
+
+    if (event.get_type() == FsEventType::START) {
+      auto inodePath = inodePaths.find(call->get_nodeid());
+      if (inodePath == inodePaths.end()) {
+        ++trace.skipped;
+        continue;
+      }
+      std::optional<ReplayOp> op;
+      try {
+        op = makeOp(*call, event.get_arguments(), inodePath->second);
+      } catch (const std::exception&) {
+        ++trace.skipped;
+        continue;
+      }
+      if (!op) {
+        continue;
+      }
+      if (!firstStart) {
+        firstStart = event.get_monotonic_time_ns();
+      }
+      op->start = nanoseconds{event.get_monotonic_time_ns() - *firstStart};
+      active[call->get_unique()] = trace.ops.size();
+      trace.ops.push_back(std::move(*op));
+    } else if (event.get_type() == FsEventType::FINISH) {
+      auto it = active.find(call->get_unique());
+      if (it == active.end()) {
+        continue;
+      }
+      const auto& op = trace.ops[it->second];
+      active.erase(it);
+      auto result = event.get_result();
+      if (!result || *result < 0) {
+        continue;
+      }
+
+      switch (op.kind) {
+        case OpKind::Create:
+        case OpKind::Mkdir:
+          created.insert(op.path);
+          inodePaths[*result] = op.path;
+          break;
+        case OpKind::Lookup:
+          inodePaths[*result] = op.path;
+          if (created.count(op.path) == 0) {
+            trace.files.emplace(op.path, 0);
+          }
+          break;
+        case OpKind::Read:
+          if (created.count(op.path) == 0) {
+            auto& size = trace.files[op.path];
+            size = std::max(size, op.offset + op.length);
+          }
+          break;
+        case OpKind::Readdir:
+          if (created.count(op.path) == 0) {
+            trace.dirs.insert(op.path);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // Whatever contains another entry is a directory.
+  for (const auto& [path, size] : trace.files) {
+    for (auto parent : path.paths()) {
+      if (parent != path) {
+        trace.dirs.insert(parent.copy());
+      }
+    }
+  }
+  for (const auto& dir : trace.dirs) {
+    trace.files.erase(dir);
+  }
+  trace.dirs.erase(RelativePath{});
+  return trace;
+}
+
+class ReplayTarget {
+ public:
+  virtual ~ReplayTarget() = default;
+
+  /**
+   * Replays one request, and throws if it fails.
+   */
+  virtual void replay(const ReplayOp& op) = 0;
+};
+
+/**
+ * Replays requests as system calls on a live mount.
+ */
+class LiveMountTarget : public ReplayTarget {
+ public:
+  explicit LiveMountTarget(AbsolutePath root) : root_{std::move(root)} {}
+
+  void replay(const ReplayOp& op) override {
+    auto path = (root_ + op.path).asString();
+    switch (op.kind) {
+      case OpKind::Lookup:
+      case OpKind::Getattr: {
+        struct stat st;
+        folly::checkUnixError(lstat(path.c_str(), &st), "lstat ", path);
+        break;
+      }
+      case OpKind::Read: {
+        folly::File file{path, O_RDONLY};
+        std::string buffer(op.length, '\0');
+        folly::checkUnixError(
+            folly::preadFull(file.fd(), buffer.data(), op.length, op.offset),
+            "read ",
+            path);
+        break;
+      }
+      case OpKind::Readdir: {
+        auto* dir = opendir(path.c_str());
+        folly::checkUnixError(dir ? 0 : -1, "opendir ", path);
+        while (readdir(dir)) {
+        }
+        closedir(dir);
+        break;
+      }
+      case OpKind::Write: {
+        folly::File file{path, O_WRONLY};
+        std::string buffer(op.length, 'w');
+        folly::checkUnixError(
+            folly::pwriteFull(file.fd(), buffer.data(), op.length, op.offset),
+            "write ",
+            path);
+        break;
+      }
+      case OpKind::Create:
+        folly::File{path, O_WRONLY | O_CREAT, 0644};
+        break;
+      case OpKind::Mkdir:
+        folly::checkUnixError(::mkdir(path.c_str(), 0755), "mkdir ", path);
+        break;
+      case OpKind::Unlink:
+        folly::checkUnixError(::unlink(path.c_str()), "unlink ", path);
+        break;
+      case OpKind::Rmdir:
+        folly::checkUnixError(::rmdir(path.c_str()), "rmdir ", path);
+        break;
+    }
+  }
+
+ private:
+  AbsolutePath root_;
+};
+
+/**
+ * Replays requests through the FUSE dispatcher of a TestMount, the way
+ * FuseChannel would.
+ */
+class TestMountTarget : public ReplayTarget {
+ public:
+  explicit TestMountTarget(TestMount& mount)
+      : mount_{mount}, dispatcher_{mount.getEdenMount().get()} {
+    inodes_.wlock()->emplace(RelativePath{}, kRootNodeId);
+  }
+
+  void replay(const ReplayOp& op) override {
+    auto& context = ObjectFetchContext::getNullContext();
+    switch (op.kind) {
+      case OpKind::Lookup:
+        resolve(op.path);
+        break;
+      case OpKind::Getattr:
+        wait(dispatcher_.getattr(resolve(op.path), context));
+        break;
+      case OpKind::Read:
+        wait(dispatcher_.read(resolve(op.path), op.length, op.offset, context));
+        break;
+      case OpKind::Readdir: {
+        auto ino = resolve(op.path);
+        auto fh = wait(dispatcher_.opendir(ino, 0));
+        wait(dispatcher_.readdir(
+            ino, FuseDirList{64 * 1024}, op.offset, fh, context));
+        wait(dispatcher_.releasedir(ino, fh));
+        break;
+      }
+      case OpKind::Write: {
+        std::string buffer(op.length, 'w');
+        wait(dispatcher_.write(resolve(op.path), buffer, op.offset, context));
+        break;
+      }
+      case OpKind::Create: {
+        auto entry = wait(dispatcher_.create(
+            resolve(op.path.dirname()),
+            op.path.basename(),
+            S_IFREG | 0644,
+            0,
+            context));
+        inodes_.wlock()->insert_or_assign(op.path, InodeNumber{entry.nodeid});
+        break;
+      }
+      case OpKind::Mkdir: {
+        auto entry = wait(dispatcher_.mkdir(
+            resolve(op.path.dirname()),
+            op.path.basename(),
+            S_IFDIR | 0755,
+            context));
+        inodes_.wlock()->insert_or_assign(op.path, InodeNumber{entry.nodeid});
+        break;
+      }
+      case OpKind::Unlink:
+      case OpKind::Rmdir: {
+        auto parent = resolve(op.path.dirname());
+        if (op.kind == OpKind::Unlink) {
+          wait(dispatcher_.unlink(parent, op.path.basename(), context));
+        } else {
+          wait(dispatcher_.rmdir(parent, op.path.basename(), context));
+        }
+        inodes_.wlock()->erase(op.path);
+        break;
+      }
+    }
+  }
+
+ private:
+  template <typename T>
+  T wait(ImmediateFuture<T> future) {
+    if (future.isReady()) {
+      return std::move(future).get();
+    }
+    auto* executor = mount_.getServerExecutor().get();
+    return std::move(future).semi().via(executor).getVia(executor);
+  }
+
+  /**
+   * Returns the inode number of `path`, looking up the path the first time.
+   */
+  InodeNumber resolve(RelativePathPiece path) {
+    {
+      auto inodes = inodes_.rlock();
+      auto it = inodes->find(path.copy());
+      if (it != inodes->end()) {
+        return it->second;
+      }
+    }
+    auto parent = resolve(path.dirname());
+    auto entry = wait(dispatcher_.lookup(
+        0, parent, path.basename(), ObjectFetchContext::getNullContext()));
+    auto ino = InodeNumber{entry.nodeid};
+    inodes_.wlock()->insert_or_assign(path.copy(), ino);
+    return ino;
+  }
+
+  TestMount& mount_;
+  FuseDispatcherImpl dispatcher_;
+  folly::Synchronized<std::unordered_map<RelativePath, InodeNumber>> inodes_;
+};
+
+std::unique_ptr<TestMount> makeTestMount(const Trace& trace) {
+  FakeTreeBuilder builder;
+  for (const auto& [path, size] : trace.files) {
+    builder.setFile(path, std::string(size, 'x'));
+  }
+  for (const auto& dir : trace.dirs) {
+    builder.mkdir(dir);
+  }
+  return std::make_unique<TestMount>(builder);
+}
+
+struct OpStats {
+  std::vector<nanoseconds> latencies;
+  size_t errors = 0;
+};
+
+void printStats(const std::array<OpStats, kOpKindCount>& stats) {
+  fmt::print(
+      "{:<10}{:>10}{:>10}{:>12}{:>12}{:>12}{:>12}\n",
+      "op",
+      "count",
+      "errors",
+      "p50 (us)",
+      "p90 (us)",
+      "p99 (us)",
+      "max (us)");
+  for (size_t kind = 0; kind < kOpKindCount; ++kind) {
+    auto latencies = stats[kind].latencies;
+    if (latencies.empty()) {
+      continue;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+      auto index = static_cast<size_t>(p * (latencies.size() - 1));
+      return duration<double, std::micro>{latencies[index]}.count();
+    };
+    fmt::print(
+        "{:<10}{:>10}{:>10}{:>12.1f}{:>12.1f}{:>12.1f}{:>12.1f}\n",
+        kOpNames[kind],
+        latencies.size(),
+        stats[kind].errors,
+        percentile(0.5),
+        percentile(0.9),
+        percentile(0.99),
+        percentile(1));
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (FLAGS_trace.empty()) {
+    fmt::print(stderr, "--trace is required\n");
+    return 1;
+  }
+
+  auto trace = loadTrace(FLAGS_trace);
+  fmt::print(
+      "{} requests to replay, {} skipped\n", trace.ops.size(), trace.skipped);
+
+  std::unique_ptr<TestMount> testMount;
+  std::unique_ptr<ReplayTarget> target;
+  if (FLAGS_mount.empty()) {
+    testMount = makeTestMount(trace);
+    target = std::make_unique<TestMountTarget>(*testMount);
+  } else {
+    target = std::make_unique<LiveMountTarget>(AbsolutePath{FLAGS_mount});
+  }
+
+  folly::Synchronized<std::array<OpStats, kOpKindCount>> stats;
+  {
+    folly::CPUThreadPoolExecutor pool{FLAGS_threads};
+    auto begin = steady_clock::now();
+    for (const auto& op : trace.ops) {
+      if (FLAGS_speed > 0) {
+        std::this_thread::sleep_until(
+            begin + duration_cast<nanoseconds>(op.start / FLAGS_speed));
+      }
+      pool.add([&target, &stats, &op] {
+        auto start = steady_clock::now();
+        bool failed = false;
+        try {
+          target->replay(op);
+        } catch (const std::exception&) {
+          failed = true;
+        }
+        auto latency = steady_clock::now() - start;
+        auto locked = stats.wlock();
+        auto& opStats = (*locked)[static_cast<size_t>(op.kind)];
+        opStats.latencies.push_back(duration_cast<nanoseconds>(latency));
+        opStats.errors += failed;
+      });
+    }
+    pool.join();
+  }
+
+  printStats(*stats.rlock());
+  return 0;
+}
+
+#else
+
+int main() {
+  return 0;
+}
+
+#endif
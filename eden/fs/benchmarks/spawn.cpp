@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <gflags/gflags.h>
+#include <cstring>
+#include <memory>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/utils/SpawnedProcess.h"
+
+/*
+ * Measures how long it takes to spawn and reap a trivial child process while
+ * this process has an RSS comparable to a busy edenfs daemon. Spawning with
+ * fork would have to copy page tables proportional to the RSS; posix_spawn
+ * with vfork semantics should not.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+
+DEFINE_uint64(
+    rss,
+    2ull * 1024 * 1024 * 1024,
+    "Bytes of memory to allocate and touch before spawning");
+
+std::unique_ptr<char[]> residentMemory;
+
+void touchResidentMemory() {
+  if (!residentMemory && FLAGS_rss > 0) {
+    residentMemory = std::make_unique<char[]>(FLAGS_rss);
+    memset(residentMemory.get(), 1, FLAGS_rss);
+  }
+}
+
+void spawn_true(benchmark::State& state) {
+  touchResidentMemory();
+  for (auto _ : state) {
+    SpawnedProcess proc{{"/bin/true"}};
+    benchmark::DoNotOptimize(proc.wait());
+  }
+}
+
+void spawn_true_with_cwd(benchmark::State& state) {
+  touchResidentMemory();
+  for (auto _ : state) {
+    SpawnedProcess::Options opts;
+    opts.chdir(canonicalPath("/"));
+    SpawnedProcess proc{{"/bin/true"}, std::move(opts)};
+    benchmark::DoNotOptimize(proc.wait());
+  }
+}
+
+BENCHMARK(spawn_true)->Unit(benchmark::kMicrosecond);
+BENCHMARK(spawn_true_with_cwd)->Unit(benchmark::kMicrosecond);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/telemetry/TraceBus.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kCapacity = 25000;
+
+struct Event : TraceEventBase {
+  uint64_t unique;
+  uint32_t opcode;
+};
+
+/**
+ * Every thread publishes into one TraceBus observed by a number of trivial
+ * subscribers given by the benchmark argument. With zero subscribers, this
+ * measures the queueing cost alone.
+ */
+void trace_bus_publish(benchmark::State& state) {
+  static std::shared_ptr<TraceBus<Event>> bus;
+  static std::vector<TraceBus<Event>::SubscriptionHandle> handles;
+  static std::atomic<uint64_t> observed;
+  if (state.thread_index() == 0) {
+    bus = TraceBus<Event>::create("bench", kCapacity);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      handles.push_back(bus->subscribeFunction("sub", [](const Event& event) {
+        observed.fetch_add(event.opcode, std::memory_order_relaxed);
+      }));
+    }
+  }
+
+  Event event;
+  event.unique = state.thread_index();
+  event.opcode = 1;
+  for (auto _ : state) {
+    bus->publish(event);
+  }
+
+  if (state.thread_index() == 0) {
+    handles.clear();
+    bus.reset();
+  }
+}
+
+BENCHMARK(trace_bus_publish)
+    ->Unit(benchmark::kNanosecond)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(8)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -1435,6 +1435,47 @@ class DropRequestsCmd(Subcmd):
             return 0
 
 
+@debug_cmd(
+    "stalls",
+    "Show the filesystem requests and source control imports that were in "
+    "flight over the last few seconds",
+)
+class StallsCmd(Subcmd):
+    def setup_parser(self, parser: argparse.ArgumentParser) -> None:
+        parser.add_argument(
+            "--seconds",
+            type=float,
+            default=5,
+            help="How far back to show samples (default: %(default)s)",
+        )
+
+    def run(self, args: argparse.Namespace) -> int:
+        instance = cmd_util.get_eden_instance(args)
+        with instance.get_thrift_client_legacy() as client:
+            response = client.debugGetInFlightSamples()
+
+        cutoff_ms = (time.time() - args.seconds) * 1000
+        samples = [s for s in response.samples if s.takenAtMillis >= cutoff_ms]
+        if not samples:
+            print("No samples. Is core:in-flight-sample-interval set to 0?")
+            return 0
+
+        for sample in samples:
+            taken_at = time.strftime(
+                "%H:%M:%S", time.localtime(sample.takenAtMillis / 1000)
+            )
+            millis = sample.takenAtMillis % 1000
+            print(f"{taken_at}.{millis:03d}: {len(sample.calls)} in flight")
+            for call in sorted(sample.calls, key=lambda c: -c.ageMicros):
+                request_id = "" if call.requestId is None else call.requestId
+                print(
+                    f"  {call.ageMicros / 1000:10.1f}ms  {call.source:4} "
+                    f"{call.operation:20} {call.stage:24} {request_id:>8} "
+                    f"{call.location}"
+                )
+        return 0
+
+
 @subcmd_mod.subcmd("debug", "Internal commands for examining EdenFS state")
 # pyre-fixme[13]: Attribute `parser` is never initialized.
 class DebugCmd(Subcmd):
@@ -27,6 +27,10 @@ DEFINE_string(trace, "", "Trace mode");
 DEFINE_bool(writes, false, "Limit trace to write operations");
 DEFINE_bool(reads, false, "Limit trace to write operations");
 DEFINE_bool(verbose, false, "Show import priority and cause");
+DEFINE_bool(
+    json,
+    false,
+    "Print each fs event as a line of JSON, which replay_fs_trace can replay");
 
 namespace {
 constexpr auto kTimeout = std::chrono::seconds{1};
@@ -264,6 +268,21 @@ int trace_fs(
           .via(evbThread.getEventBase())
           .get();
 
+  if (FLAGS_json) {
+    std::move(traceFsStream).subscribeInline([](folly::Try<FsEvent>&& event) {
+      if (event.hasException()) {
+        fmt::print(
+            stderr, "Error: {}\n", folly::exceptionStr(event.exception()));
+        return;
+      }
+      fmt::print(
+          "{}\n",
+          apache::thrift::SimpleJSONSerializer::serialize<std::string>(
+              event.value()));
+    });
+    return 0;
+  }
+
   // TODO (liuz): Rather than issuing one call per filesystem interface, it
   // would be better to introduce a new thrift method that returns a list of
   // live filesystem calls, with an optional FuseCall, optional NfsCall,
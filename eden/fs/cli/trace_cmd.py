@@ -12,6 +12,8 @@ import subprocess
 import sys
 from typing import List, Union
 
+from facebook.eden.ttypes import CaptureChromeTraceParams
+
 from . import subcmd as subcmd_mod
 from .cmd_util import require_checkout
 from .subcmd import Subcmd
@@ -132,3 +134,41 @@ class TraceFsCommand(Subcmd):
                 f"--writes={'true' if args.writes else 'false'}",
             ]
         )
+
+
+@trace_cmd("chrome", "Record a trace that Perfetto or chrome://tracing can load")
+class TraceChromeCommand(Subcmd):
+    DESCRIPTION = """Record the filesystem requests, hg imports and checkouts of a
+checkout for a while, and write them as Chrome trace-event JSON. Each hg
+import caused by a filesystem request is linked to that request.
+"""
+
+    def setup_parser(self, parser: argparse.ArgumentParser) -> None:
+        parser.add_argument(
+            "checkout", default=None, nargs="?", help="Path to the checkout"
+        )
+        parser.add_argument(
+            "--duration",
+            type=float,
+            default=10.0,
+            help="How many seconds to record for (default: 10)",
+        )
+        parser.add_argument(
+            "--output",
+            "-o",
+            default="eden-trace.json",
+            help="Where to write the trace (default: eden-trace.json)",
+        )
+
+    async def run(self, args: argparse.Namespace) -> int:
+        instance, checkout, _rel_path = require_checkout(args, args.checkout)
+        params = CaptureChromeTraceParams(
+            mountPoint=bytes(checkout.path),
+            durationMs=int(args.duration * 1000),
+        )
+        with instance.get_thrift_client_legacy(timeout=args.duration + 60) as client:
+            result = client.captureChromeTrace(params)
+        with open(args.output, "wb") as f:
+            f.write(result.json)
+        print(f"Wrote {args.output}")
+        return 0
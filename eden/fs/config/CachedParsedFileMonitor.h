@@ -21,7 +21,8 @@ namespace facebook::eden {
  * created by parsing a data file. The object can be accessed through
  * "getFileContents()". "getFileContents()" will reload and parse the file as
  * necessary. A throttle is applied to limit change checks to at
- * most to 1 per throttleDuration.
+ * most to 1 per throttleDuration. With useWatcher, the file is only checked
+ * after the kernel reported a change to it (see FileChangeMonitor).
  *
  * The parsed value T is deduced through the Parser. The Parser and T must
  * be default constructable and provide following:
@@ -35,8 +36,9 @@ class CachedParsedFileMonitor {
  public:
   CachedParsedFileMonitor(
       AbsolutePathPiece filePath,
-      std::chrono::milliseconds throttleDuration)
-      : fileChangeMonitor_{filePath, throttleDuration} {}
+      std::chrono::milliseconds throttleDuration,
+      bool useWatcher = false)
+      : fileChangeMonitor_{filePath, throttleDuration, useWatcher} {}
 
   /**
    * Get the parsed file contents.  If the file (or its path) has changed we
@@ -8,6 +8,7 @@
 #include "eden/fs/config/CheckoutConfig.h"
 
 #include <cpptoml.h>
+#include <algorithm>
 
 #include <folly/Range.h>
 #include <folly/String.h>
@@ -34,6 +35,11 @@ constexpr folly::StringPiece kRepoCaseSensitiveKey{"case-sensitive"};
 constexpr folly::StringPiece kMountProtocol{"protocol"};
 constexpr folly::StringPiece kRequireUtf8Path{"require-utf8-path"};
 constexpr folly::StringPiece kEnableTreeOverlay{"enable-tree-overlay"};
+constexpr folly::StringPiece kSpeculativeTreePrefetchDepth{
+    "speculative-tree-prefetch-depth"};
+constexpr folly::StringPiece kSpeculativePrefetchBlobMetadata{
+    "speculative-prefetch-blob-metadata"};
+constexpr folly::StringPiece kFuseWritebackCache{"fuse-writeback-cache"};
 #ifdef _WIN32
 constexpr folly::StringPiece kRepoGuid{"guid"};
 #endif
@@ -53,6 +59,7 @@ constexpr folly::StringPiece kMountProtocolDefault{kMountProtocolFuse};
 
 // Files of interest in the client directory.
 const facebook::eden::RelativePathPiece kSnapshotFile{"SNAPSHOT"};
+const facebook::eden::RelativePathPiece kFilterFile{"FILTER"};
 const facebook::eden::RelativePathPiece kOverlayDir{"local"};
 
 // File holding mapping of client directories.
@@ -283,6 +290,34 @@ void CheckoutConfig::setCheckoutInProgress(const RootId& from, const RootId& to)
       .value();
 }
 
+std::vector<RelativePath> CheckoutConfig::getFilteredPaths() const {
+  auto contents = readFile(clientDirectory_ + kFilterFile);
+  if (auto* ex = contents.tryGetExceptionObject<std::system_error>();
+      ex && isEnoent(*ex)) {
+    return {};
+  }
+  std::vector<StringPiece> lines;
+  folly::split('\n', contents.value(), lines, /*ignoreEmpty=*/true);
+  std::vector<RelativePath> paths;
+  paths.reserve(lines.size());
+  for (auto line : lines) {
+    paths.emplace_back(line);
+  }
+  return paths;
+}
+
+void CheckoutConfig::setFilteredPaths(
+    const std::vector<RelativePath>& paths) const {
+  std::string contents;
+  for (const auto& path : paths) {
+    contents.append(path.value());
+    contents.push_back('\n');
+  }
+  writeFileAtomic(
+      clientDirectory_ + kFilterFile, ByteRange{StringPiece{contents}})
+      .value();
+}
+
 const AbsolutePath& CheckoutConfig::getClientDirectory() const {
   return clientDirectory_;
 }
@@ -329,6 +364,18 @@ std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
   // Treeoverlay is default on Windows
   config->enableTreeOverlay_ = enableTreeOverlay.value_or(folly::kIsWindows);
 
+  auto prefetchDepth =
+      repository->get_as<int64_t>(kSpeculativeTreePrefetchDepth.str());
+  config->speculativeTreePrefetchDepth_ =
+      static_cast<uint32_t>(std::max<int64_t>(prefetchDepth.value_or(0), 0));
+  auto prefetchBlobMetadata =
+      repository->get_as<bool>(kSpeculativePrefetchBlobMetadata.str());
+  config->speculativePrefetchBlobMetadata_ =
+      prefetchBlobMetadata.value_or(false);
+
+  auto fuseWritebackCache = repository->get_as<bool>(kFuseWritebackCache.str());
+  config->fuseWritebackCache_ = fuseWritebackCache.value_or(false);
+
 #ifdef _WIN32
   auto guid = repository->get_as<std::string>(kRepoGuid.str());
   config->repoGuid_ = guid ? Guid{*guid} : Guid::generate();
@@ -10,6 +10,7 @@
 #include <folly/Portability.h>
 #include <folly/dynamic.h>
 #include <optional>
+#include <vector>
 #include "eden/fs/config/MountProtocol.h"
 #include "eden/fs/config/ParentCommit.h"
 #include "eden/fs/model/RootId.h"
@@ -112,6 +113,17 @@ class CheckoutConfig {
     return repoSource_;
   }
 
+  /**
+   * The paths excluded from the checkout, along with everything under them.
+   * They are stored one per line in the FILTER file of the client directory.
+   */
+  std::vector<RelativePath> getFilteredPaths() const;
+
+  /**
+   * Replace the paths excluded from the checkout.
+   */
+  void setFilteredPaths(const std::vector<RelativePath>& paths) const;
+
   /** Path to the file where the current commit ID is stored */
   AbsolutePath getSnapshotPath() const;
 
@@ -133,6 +145,31 @@ class CheckoutConfig {
     return enableTreeOverlay_;
   }
 
+  /**
+   * How many levels of subdirectories below a listed directory to prefetch
+   * speculatively after a readdir. 0 disables speculative prefetching.
+   */
+  uint32_t getSpeculativeTreePrefetchDepth() const {
+    return speculativeTreePrefetchDepth_;
+  }
+
+  /**
+   * Whether speculative prefetching also fetches the metadata of the files
+   * in the prefetched trees.
+   */
+  bool getSpeculativePrefetchBlobMetadata() const {
+    return speculativePrefetchBlobMetadata_;
+  }
+
+  /**
+   * Whether a FUSE mount lets the kernel cache writes and send them to
+   * EdenFS in large batches (FUSE_WRITEBACK_CACHE). The kernel then owns the
+   * size, mtime and ctime of files while they are in its cache.
+   */
+  bool getFuseWritebackCache() const {
+    return fuseWritebackCache_;
+  }
+
 #ifdef _WIN32
   /** Guid for that repository */
   Guid getRepoGuid() const {
@@ -152,6 +189,10 @@ class CheckoutConfig {
   // Tree Overlay is default on Windows
   bool enableTreeOverlay_{folly::kIsWindows};
 
+  uint32_t speculativeTreePrefetchDepth_{0};
+  bool speculativePrefetchBlobMetadata_{false};
+  bool fuseWritebackCache_{false};
+
 #ifdef _WIN32
   Guid repoGuid_;
 #endif
@@ -223,6 +223,100 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(5),
       this};
 
+  /**
+   * How often to compare EdenFS's resident memory to its memory limit, and
+   * unload the least recently accessed inodes if it uses too much. 0
+   * disables memory pressure driven unloading.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryPressureCheckInterval{
+      "core:memory-pressure-check-interval",
+      std::chrono::seconds(30),
+      this};
+
+  /**
+   * How often to return the unused pages of the memory arenas of inodes, the
+   * object caches and the journal to the system. 0 leaves it to jemalloc's
+   * decay.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryArenaPurgeInterval{
+      "core:memory-arena-purge-interval",
+      std::chrono::minutes(5),
+      this};
+
+  /**
+   * The memory limit, in bytes, against which resident memory is compared.
+   * 0 means the limit of the memory cgroup EdenFS runs in; without either,
+   * memory pressure driven unloading does nothing.
+   */
+  ConfigSetting<uint64_t> memoryPressureLimit{
+      "core:memory-pressure-limit",
+      0,
+      this};
+
+  /**
+   * Percentage of the memory limit above which resident memory triggers
+   * memory pressure driven unloading.
+   */
+  ConfigSetting<uint32_t> memoryPressureHighWatermarkPercent{
+      "core:memory-pressure-high-watermark-percent",
+      80,
+      this};
+
+  /**
+   * Once triggered, memory pressure driven unloading unloads one batch of
+   * inodes per check until resident memory is below this percentage of the
+   * memory limit.
+   */
+  ConfigSetting<uint32_t> memoryPressureTargetPercent{
+      "core:memory-pressure-target-percent",
+      70,
+      this};
+
+  /**
+   * Memory pressure driven unloading never unloads inodes accessed more
+   * recently than this.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryPressureMinUnloadAge{
+      "core:memory-pressure-min-unload-age",
+      std::chrono::minutes(1),
+      this};
+
+  /**
+   * How often to record which filesystem requests and source control imports
+   * are in flight, for `eden debug stalls`. 0 disables sampling.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inFlightSampleInterval{
+      "core:in-flight-sample-interval",
+      std::chrono::milliseconds(500),
+      this};
+
+  /**
+   * How far back the in-flight request samples are kept.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inFlightSampleHistory{
+      "core:in-flight-sample-history",
+      std::chrono::seconds(30),
+      this};
+
+  /**
+   * How many checkouts are remounted at the same time when EdenFS starts.
+   * 0 remounts all of them at once.
+   */
+  ConfigSetting<uint32_t> startupMountConcurrency{
+      "core:startup-mount-concurrency",
+      8,
+      this};
+
+  /**
+   * The maximum number of paths each mount remembers the inode numbers of,
+   * for the Thrift and ProjectedFS APIs that look up inodes by path. 0
+   * disables the cache.
+   */
+  ConfigSetting<size_t> pathInodeCacheSize{
+      "core:path-inode-cache-size",
+      10000,
+      this};
+
   // [config]
 
   /**
@@ -249,6 +343,76 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * The minimum time between two notifications sent to a
+   * subscribeStreamTemporary client. Changes made in between are reported by
+   * one trailing notification at the end of the interval. Zero sends a
+   * notification for every change the client has not yet observed.
+   */
+  ConfigSetting<std::chrono::nanoseconds> streamNotificationInterval{
+      "thrift:stream-notification-interval",
+      std::chrono::milliseconds(0),
+      this};
+
+  /**
+   * When streamNotificationInterval is set, a subscribeStreamTemporary
+   * client is notified before the end of the interval once this many journal
+   * deltas are waiting. Zero waits for the end of the interval.
+   */
+  ConfigSetting<uint64_t> streamNotificationMaxDeltas{
+      "thrift:stream-notification-max-deltas",
+      0,
+      this};
+
+  /**
+   * The maximum number of bulk Thrift requests (status, glob, checkout, ...)
+   * being processed at once. Requests over the limit fail immediately rather
+   * than queueing behind the others. Zero means no limit.
+   */
+  ConfigSetting<uint64_t> thriftMaxBulkRequests{
+      "thrift:max-bulk-requests",
+      0,
+      this};
+
+  /**
+   * Whether to also limit the bulk Thrift requests in flight to the
+   * background request limit, which adapts to the latency of filesystem
+   * requests so that bulk requests are refused before filesystem requests
+   * slow down. thrift:max-bulk-requests still applies.
+   */
+  ConfigSetting<bool> thriftAdaptiveBulkRequests{
+      "thrift:adaptive-bulk-requests",
+      false,
+      this};
+
+  /**
+   * The maximum number of debug* Thrift requests being processed at once.
+   * Zero means no limit.
+   */
+  ConfigSetting<uint64_t> thriftMaxDebugRequests{
+      "thrift:max-debug-requests",
+      8,
+      this};
+
+  /**
+   * The sustained rate of non-interactive Thrift requests a single client
+   * process may issue. Requests over the rate fail immediately. Zero means no
+   * limit.
+   */
+  ConfigSetting<uint64_t> thriftClientRequestsPerSecond{
+      "thrift:client-requests-per-second",
+      0,
+      this};
+
+  /**
+   * The number of requests a client may issue at once above
+   * thrift:client-requests-per-second. Never less than the rate.
+   */
+  ConfigSetting<uint64_t> thriftClientRequestBurst{
+      "thrift:client-request-burst",
+      0,
+      this};
+
   // [ssl]
 
   ConfigSetting<AbsolutePath> clientCertificate{
@@ -265,8 +429,9 @@ class EdenConfig : private ConfigSettingManager {
   // [store]
 
   /**
-   * How often to compute stats and perform garbage collection management
-   * for the LocalStore.
+   * How often to compute stats for the LocalStore, and to check whether its
+   * ephemeral data needs garbage collection. Garbage collection itself
+   * waits for the host to be idle, see maintenance:idle-only.
    */
   ConfigSetting<std::chrono::nanoseconds> localStoreManagementInterval{
       "store:stats-interval",
@@ -301,6 +466,93 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  ConfigSetting<uint64_t> localStoreScmStatusSizeLimit{
+      "store:scmstatus-size-limit",
+      100'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreNameIndexSizeLimit{
+      "store:nameindex-size-limit",
+      1'000'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreLocalitySizeLimit{
+      "store:locality-size-limit",
+      15'000'000'000,
+      this};
+
+  /**
+   * With the memory local store engine, the size in bytes above which the
+   * least recently used ephemeral data is evicted. 0 means unbounded. Only
+   * read at startup.
+   */
+  ConfigSetting<uint64_t> memoryLocalStoreSizeLimit{
+      "store:memory-size-limit",
+      0,
+      this};
+
+  /**
+   * When an ephemeral column exceeds its size limit, delete its least
+   * recently accessed keys instead of clearing the whole column.
+   */
+  ConfigSetting<bool> localStoreLruGc{"store:lru-gc", false, this};
+
+  /**
+   * Number of keys the least recently used garbage collection scans, and at
+   * most deletes, per step.
+   */
+  ConfigSetting<uint32_t> localStoreLruGcBatchSize{
+      "store:lru-gc-delete-batch-size",
+      1000,
+      this};
+
+  /**
+   * Pause between steps of the least recently used garbage collection. It is
+   * doubled, up to one second, while foreground reads are happening.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreLruGcBatchInterval{
+      "store:lru-gc-batch-interval",
+      std::chrono::milliseconds{10},
+      this};
+
+  /**
+   * Buffer writes to the RocksDB local store in memory and commit them in
+   * large batches from a background thread, instead of committing every
+   * imported object by itself. Reads see buffered writes.
+   */
+  ConfigSetting<bool> localStoreWriteCombining{
+      "store:write-combining",
+      false,
+      this};
+
+  /**
+   * With `store:write-combining`, the number of buffered bytes at which a
+   * batch is committed. Writers block once four times as much is buffered.
+   */
+  ConfigSetting<uint64_t> localStoreWriteCombiningBatchSize{
+      "store:write-combining-batch-size",
+      16 * 1024 * 1024,
+      this};
+
+  /**
+   * With `store:write-combining`, the longest writes stay buffered.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreWriteCombiningInterval{
+      "store:write-combining-interval",
+      std::chrono::seconds{1},
+      this};
+
+  /**
+   * If set, a directory of read-only pack segments shared by every user of
+   * the host. Objects are read from it before the local store, which still
+   * receives every write. The segments are written by a separate process;
+   * new ones are picked up every store:stats-interval. Only read at startup.
+   */
+  ConfigSetting<std::string> localStoreSharedPackDirectory{
+      "store:shared-pack-directory",
+      "",
+      this};
+
   /**
    * The minimum duration between logging occurrences of failed HgProxyHash
    * loads.
@@ -328,6 +580,193 @@ class EdenConfig : private ConfigSettingManager {
       5,
       this};
 
+  /**
+   * Before a checkout walks the inodes, fetch the trees that differ between
+   * the old and new commit with this many fetches in flight, so that the walk
+   * finds them in the caches. Setting this to 0 disables the prefetch.
+   */
+  ConfigSetting<uint64_t> checkoutTreePrefetchConcurrency{
+      "store:checkout-tree-prefetch-concurrency",
+      0,
+      this};
+
+  /**
+   * Evaluate globs concurrently on the server thread pool, with at most this
+   * many tree fetches in flight per glob. Setting this to 0 evaluates globs
+   * serially.
+   */
+  ConfigSetting<uint64_t> globTreeFetchConcurrency{
+      "store:glob-tree-fetch-concurrency",
+      0,
+      this};
+
+  /**
+   * Answer globs over a commit whose patterns all look like `**/name` out of
+   * a per-commit index of entry names, instead of loading every tree. The
+   * index is built once all of the commit's trees are in the LocalStore.
+   */
+  ConfigSetting<bool> globUseNameIndex{
+      "store:glob-use-name-index",
+      false,
+      this};
+
+  /**
+   * Speculative tree prefetching, enabled per mount, backs off while fewer
+   * than this percentage of the trees it prefetches are later loaded.
+   */
+  ConfigSetting<uint32_t> speculativePrefetchMinHitRatePercent{
+      "store:speculative-prefetch-min-hit-rate-percent",
+      20,
+      this};
+
+  /**
+   * Maximum number of objects the ObjectStore remembers as missing or failed
+   * to fetch, so that repeated lookups fail fast instead of going back to the
+   * LocalStore and BackingStore. 0 disables the negative cache. Only read at
+   * startup.
+   */
+  ConfigSetting<size_t> negativeCacheSize{
+      "store:negative-cache-size",
+      10000,
+      this};
+
+  /**
+   * How long an object the BackingStore reported as not found is remembered
+   * by the negative cache.
+   */
+  ConfigSetting<std::chrono::nanoseconds> negativeCacheMissingTTL{
+      "store:negative-cache-missing-ttl",
+      std::chrono::seconds{30},
+      this};
+
+  /**
+   * How long an object whose fetch failed with any other error (for example a
+   * network error) is remembered by the negative cache. This is kept short so
+   * that transient failures are retried soon.
+   */
+  ConfigSetting<std::chrono::nanoseconds> negativeCacheErrorTTL{
+      "store:negative-cache-error-ttl",
+      std::chrono::seconds{2},
+      this};
+
+  /**
+   * Maximum number of tree fetches a single diff operation keeps outstanding
+   * at once. Further fetches wait for an earlier one to finish. 0 means no
+   * limit.
+   */
+  ConfigSetting<size_t> diffMaxConcurrentTreeFetches{
+      "store:diff-max-concurrent-tree-fetches",
+      512,
+      this};
+
+  /**
+   * Reads from files at least this large are served by fetching only the
+   * chunks they cover rather than the whole blob, when the backing store can
+   * fetch byte ranges. 0 disables chunked reads.
+   */
+  ConfigSetting<uint64_t> chunkedBlobReadThreshold{
+      "store:chunked-read-threshold",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Size of the chunks fetched and cached for chunked reads.
+   */
+  ConfigSetting<uint64_t> blobChunkSize{
+      "store:blob-chunk-size",
+      8 * 1024 * 1024,
+      this};
+
+  /**
+   * Once a chunked file has been read sequentially a few times in a row, the
+   * reads keep this many chunks past the one being read fetched ahead of
+   * them. 0 disables readahead.
+   */
+  ConfigSetting<uint32_t> readaheadChunks{"store:readahead-chunks", 2, this};
+
+  /**
+   * On graceful takeover, the ids of up to this many of the most recently used
+   * blobs and as many trees are handed to the new process, which reloads them
+   * from the local store into its in-memory caches in the background. 0
+   * disables it.
+   */
+  ConfigSetting<uint64_t> takeoverWarmCacheEntries{
+      "store:takeover-warm-cache-entries",
+      100'000,
+      this};
+
+  // [maintenance]
+
+  /**
+   * How often the maintenance scheduler samples the load on the host and
+   * starts the maintenance jobs that are due.
+   */
+  ConfigSetting<std::chrono::nanoseconds> maintenanceCheckInterval{
+      "maintenance:check-interval",
+      std::chrono::seconds(10),
+      this};
+
+  /**
+   * Whether heavy maintenance jobs, such as local store garbage collection,
+   * wait for the host to be idle and stop when it no longer is. Otherwise
+   * they run as soon as they are due.
+   */
+  ConfigSetting<bool> maintenanceIdleOnly{"maintenance:idle-only", true, this};
+
+  /**
+   * How long the load must stay below all of the limits below before the
+   * host is considered idle.
+   */
+  ConfigSetting<std::chrono::nanoseconds> maintenanceIdleDelay{
+      "maintenance:idle-delay",
+      std::chrono::minutes(1),
+      this};
+
+  /**
+   * The filesystem requests per second, across all mounts, above which the
+   * host is busy.
+   */
+  ConfigSetting<uint64_t> maintenanceMaxRequestRate{
+      "maintenance:max-request-rate",
+      20,
+      this};
+
+  /**
+   * The percentage of the host's CPU time above which the host is busy.
+   */
+  ConfigSetting<uint64_t> maintenanceMaxCpuPercent{
+      "maintenance:max-cpu-percent",
+      50,
+      this};
+
+  /**
+   * The bytes per second the host pages in from and out to disk above which
+   * the host is busy.
+   */
+  ConfigSetting<uint64_t> maintenanceMaxIoRate{
+      "maintenance:max-io-rate",
+      16 * 1024 * 1024,
+      this};
+
+  /**
+   * How long a heavy maintenance job may run before it is stopped. It runs
+   * again once its next interval has passed.
+   */
+  ConfigSetting<std::chrono::nanoseconds> maintenanceHeavyJobBudget{
+      "maintenance:heavy-job-budget",
+      std::chrono::minutes(10),
+      this};
+
+  /**
+   * How long a heavy maintenance job may wait for the host to be idle. Past
+   * that it runs, and is not stopped when load comes back, so that a host
+   * that is never idle does not grow its local store without bound.
+   */
+  ConfigSetting<std::chrono::nanoseconds> maintenanceMaxDeferral{
+      "maintenance:max-deferral",
+      std::chrono::hours(6),
+      this};
+
   // [fuse]
 
   /**
@@ -352,6 +791,87 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(1),
       this};
 
+  /**
+   * Whether checkouts mounted with FUSE at startup are only initialized,
+   * which loads their root tree and overlay and may run fsck, when the first
+   * request reaches them. Until then requests wait, up to
+   * fuse:request-timeout, for the initialization to finish. Checkouts taken
+   * over during a graceful restart are always initialized right away.
+   */
+  ConfigSetting<bool> fuseLazyMountInitialization{
+      "fuse:lazy-mount-initialization",
+      false,
+      this};
+
+  /**
+   * Whether each FUSE worker thread reads requests from its own clone of the
+   * FUSE device (FUSE_DEV_IOC_CLONE), rather than all of them contending for
+   * the same one. Only supported on Linux.
+   */
+  ConfigSetting<bool> fuseCloneDevicePerThread{
+      "fuse:clone-device-per-thread",
+      false,
+      this};
+
+  /**
+   * Whether FUSE worker threads are pinned to distinct CPUs, for better cache
+   * locality on hosts with many cores. Only supported on Linux.
+   */
+  ConfigSetting<bool> fusePinWorkerThreads{
+      "fuse:pin-worker-threads",
+      false,
+      this};
+
+  /**
+   * FUSE read replies of at least this many bytes are spliced to the kernel
+   * through a pipe instead of being written to it. Reads from materialized
+   * files are then served straight from the overlay file's page cache. 0
+   * disables splicing. Only supported on Linux.
+   */
+  ConfigSetting<uint64_t> fuseSpliceReadThreshold{
+      "fuse:splice-read-threshold",
+      0,
+      this};
+
+  /**
+   * Whether the kernel may use READDIRPLUS, which returns the attributes of
+   * directory entries along with them and saves a lookup for each entry when
+   * listing a directory is followed by stat()ing its entries. The kernel then
+   * takes a reference to every listed entry, so EdenFS loads their inodes.
+   * Only supported on Linux.
+   */
+  ConfigSetting<bool> fuseUseReaddirplus{
+      "fuse:use-readdirplus",
+      false,
+      this};
+
+  /**
+   * Controls the number of threads per mount sending invalidations to the
+   * kernel. Invalidations of recently accessed directories are sent first.
+   */
+  ConfigSetting<uint8_t> fuseNumInvalidationThreads{
+      "fuse:num-invalidation-threads",
+      4,
+      this};
+
+  /**
+   * Whether checkout waits for every kernel invalidation it scheduled before
+   * completing. If false, checkout only waits for the invalidations of
+   * recently accessed directories and the rest are sent in the background.
+   */
+  ConfigSetting<bool> fuseCheckoutWaitsForAllInvalidations{
+      "fuse:checkout-waits-for-all-invalidations",
+      true,
+      this};
+
+  /**
+   * The largest write, in bytes, the kernel may send in a single FUSE
+   * request. Larger values mean fewer requests for large writes, at the cost
+   * of a request buffer of this size per FUSE worker thread. Clamped to
+   * [4 KiB, 1 MiB].
+   */
+  ConfigSetting<uint64_t> fuseMaxWrite{"fuse:max-write", 128 * 1024, this};
+
   /**
    * The maximum time duration that the kernel should allow for a fuse request.
    * If a request exceeds this amount of time, it may take aggressive
@@ -400,6 +920,15 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint64_t> numNfsThreads{"nfs:num-servicing-threads", 8, this};
 
+  /**
+   * Number of threads that read, parse and reply to the requests of NFS
+   * connections. Connections are assigned to them round-robin as they are
+   * accepted, so that clients mounting with several connections (nconnect)
+   * are served by several threads. 0 serves all connections on the main
+   * event base.
+   */
+  ConfigSetting<uint64_t> numNfsIoThreads{"nfs:num-io-threads", 4, this};
+
   /**
    * Maximum number of pending NFS requests. If more requests are inflight, the
    * NFS code will block.
@@ -409,6 +938,17 @@ class EdenConfig : private ConfigSettingManager {
       1000,
       this};
 
+  /**
+   * Maximum number of requests from a single NFS connection that are
+   * processed concurrently. The macOS NFS client sends all requests of a
+   * mount over one connection. Past this limit, EdenFS stops reading from the
+   * connection until some requests complete. 0 means no limit.
+   */
+  ConfigSetting<uint64_t> maxNfsInflightRequestsPerConnection{
+      "nfs:max-inflight-requests-per-connection",
+      512,
+      this};
+
   /**
    * Buffer size for read and writes requests. Default to 1 MiB.
    */
@@ -441,6 +981,38 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::seconds{10},
       this};
 
+  /**
+   * How often to unload the inodes of NFS mounts that were not accessed in
+   * the last nfs:inode-unload-age. NFSv3 has no FORGET, so otherwise every
+   * inode the kernel ever looked up stays loaded. Unloaded inodes are
+   * remembered by number, so their file handles stay valid and they are
+   * loaded again when used. 0 disables this.
+   */
+  ConfigSetting<std::chrono::nanoseconds> nfsInodeUnloadInterval{
+      "nfs:inode-unload-interval",
+      std::chrono::minutes{10},
+      this};
+
+  ConfigSetting<std::chrono::nanoseconds> nfsInodeUnloadAge{
+      "nfs:inode-unload-age",
+      std::chrono::hours{1},
+      this};
+
+  /**
+   * How many directory snapshots NFS listings in progress can page through,
+   * and how long they are kept for. A listing whose snapshot is gone carries
+   * on from a new one, which costs a pass over the whole directory.
+   */
+  ConfigSetting<size_t> nfsReaddirSnapshotCacheSize{
+      "nfs:readdir-snapshot-cache-size",
+      256,
+      this};
+
+  ConfigSetting<std::chrono::nanoseconds> nfsReaddirSnapshotTtl{
+      "nfs:readdir-snapshot-ttl",
+      std::chrono::minutes{1},
+      this};
+
   /**
    * When set to true, we will use readdirplus instead of readdir. Readdirplus
    * will be enabled for all nfs mounts. If set to false, regular readdir is
@@ -448,6 +1020,25 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> useReaddirplus{"nfs:use-readdirplus", false, this};
 
+  /**
+   * How long the kernel caches the attributes of files before asking EdenFS
+   * for them again. EdenFS invalidates the files changed by a checkout, thus
+   * this only bounds how long other changes that EdenFS makes behind the
+   * kernel's back can go unnoticed.
+   */
+  ConfigSetting<std::chrono::nanoseconds> nfsFileAttributeCacheTimeout{
+      "nfs:file-attribute-cache-timeout",
+      std::chrono::minutes(5),
+      this};
+
+  /**
+   * Same as nfs:file-attribute-cache-timeout, but for directories.
+   */
+  ConfigSetting<std::chrono::nanoseconds> nfsDirectoryAttributeCacheTimeout{
+      "nfs:directory-attribute-cache-timeout",
+      std::chrono::minutes(1),
+      this};
+
   // [prjfs]
 
   /**
@@ -480,6 +1071,17 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * When recorded prefetch profiles are replayed after a checkout, also write
+   * the ProjectedFS placeholders of their files and parent directories in
+   * the background. The first traversal of these paths then doesn't need a
+   * lookup callback per path.
+   */
+  ConfigSetting<bool> prjfsWriteProfilePlaceholders{
+      "prjfs:write-profile-placeholders",
+      false,
+      this};
+
   // [hg]
 
   /**
@@ -488,6 +1090,23 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> enforceParents{"hg:enforce-parents", true, this};
 
+  /**
+   * Whether getScmStatus brings the last status it computed for a mount up to
+   * date by looking at the paths changed in the journal since then, rather
+   * than diffing the whole working copy. Changes to the user and system
+   * ignore files are only noticed when a full diff is needed.
+   */
+  ConfigSetting<bool> incrementalStatus{"hg:incremental-status", false, this};
+
+  /**
+   * The maximum number of parsed .gitignore files each mount keeps in memory,
+   * keyed by blob ID, for reuse by later status calls.
+   */
+  ConfigSetting<size_t> gitIgnoreCacheSize{
+      "hg:gitignore-cache-size",
+      10000,
+      this};
+
   /**
    * Controls whether EdenFS reads blob metadata directly from hg
    */
@@ -528,6 +1147,85 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * Import requests are queued separately per client process (or per cause,
+   * for requests with no known process), and the clients take turns filling
+   * each batch. This is how many requests a client may contribute per turn.
+   */
+  ConfigSetting<uint32_t> importFairQueueQuantum{
+      "hg:import-fair-queue-quantum",
+      1,
+      this};
+
+  /**
+   * Every time a queued import request has waited this long, it is treated as
+   * one priority class higher (Low to Normal to High), so that deprioritized
+   * requests are not starved forever. 0 disables aging.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importPriorityAgingInterval{
+      "hg:import-priority-aging-interval",
+      std::chrono::seconds{2},
+      this};
+
+  /**
+   * When enabled, batched imports first look every object up locally, then
+   * fetch the misses remotely in sub-batches of
+   * `hg:import-remote-sub-batch-size`, and complete each request on the
+   * server thread pool as soon as its object arrives. One slow remote object
+   * then no longer holds up the rest of its batch.
+   */
+  ConfigSetting<bool> streamImportBatches{
+      "hg:stream-import-batches",
+      false,
+      this};
+
+  /**
+   * The number of objects fetched remotely per call when
+   * `hg:stream-import-batches` is enabled. 0 fetches them all at once.
+   */
+  ConfigSetting<uint32_t> importRemoteSubBatchSize{
+      "hg:import-remote-sub-batch-size",
+      16,
+      this};
+
+  /**
+   * When enabled, the backingstore threads tune the import batch sizes and
+   * the number of batches imported at once from the latency and throughput
+   * of recent batches. `hg:import-batch-size`, `hg:import-batch-size-tree`
+   * and `backingstore:num-servicing-threads` become the upper bounds.
+   */
+  ConfigSetting<bool> adaptiveImportBatching{
+      "hg:adaptive-import-batching",
+      false,
+      this};
+
+  /**
+   * With `hg:adaptive-import-batching`, batches that take longer than this
+   * to import shrink the batch size or the concurrency.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importBatchTargetLatency{
+      "hg:import-batch-target-latency",
+      std::chrono::milliseconds{500},
+      this};
+
+  /**
+   * The number of legacy proxy hashes to keep in memory in front of the
+   * hgproxyhash key space of the LocalStore. 0 disables the cache. Only read
+   * at startup.
+   */
+  ConfigSetting<size_t> hgProxyHashCacheSize{
+      "hg:proxy-hash-cache-size",
+      100'000,
+      this};
+
+  /**
+   * Whether blobs and trees that the native backing store could not fetch
+   * from EdenAPI should be retried through the HgImporter subprocess. This
+   * is only meant for diagnosing EdenAPI misses; without EdenAPI, the
+   * importer is always used to fetch objects missing from the local caches.
+   */
+  ConfigSetting<bool> hgImporterFallback{"hg:importer-fallback", false, this};
+
   // [backingstore]
 
   /**
@@ -563,6 +1261,19 @@ class EdenConfig : private ConfigSettingManager {
       std::nullopt,
       this};
 
+  /**
+   * Sample denominators for the fetches logged because of
+   * `telemetry:log-object-fetch-path-regex`, indexed by the cause of the
+   * fetch: unknown, filesystem, thrift and prefetch. As with
+   * `telemetry:request-sampling-group-denominators`, 0 drops every fetch of
+   * that cause and x logs 1/x of them. Causes past the end of the vector are
+   * dropped.
+   */
+  ConfigSetting<std::vector<uint32_t>> logObjectFetchSampleDenominators{
+      "telemetry:log-object-fetch-sample-denominators",
+      std::vector<uint32_t>{1, 1, 1, 1},
+      this};
+
   /**
    * Controls sample denominator for each request sampling group.
    * We assign request types into sampling groups based on their usage and
@@ -651,6 +1362,26 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * Whether a mount saves its journal to its state directory when it is
+   * cleanly unmounted or handed over to a new EdenFS process, and restores it
+   * when it is mounted again. Journal positions from before a restart then
+   * remain valid, rather than forcing every subscriber to recrawl.
+   */
+  ConfigSetting<bool> persistJournal{
+      "experimental:persist-journal",
+      false,
+      this};
+
+  /**
+   * The maximum size of the most recent journal deltas that a mount saves
+   * across restarts. Positions older than that are reported as truncated.
+   */
+  ConfigSetting<size_t> persistedJournalSizeLimit{
+      "experimental:persisted-journal-size-limit",
+      100 * 1024 * 1024,
+      this};
+
   // [treecache]
 
   /**
@@ -678,6 +1409,38 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the tree cache is split into. The
+   * cache size and minimum element count are divided evenly between shards.
+   * Only read at startup.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheShards{
+      "treecache:shard-count",
+      1,
+      this};
+
+  /**
+   * Store cached trees as CompactTree, which packs each tree into a single
+   * allocation and roughly doubles how many trees fit in inMemoryTreeCacheSize.
+   * Every cache hit then has to rebuild a Tree. Only read at startup.
+   */
+  ConfigSetting<bool> inMemoryTreeCacheCompact{
+      "treecache:compact-representation",
+      false,
+      this};
+
+  // [blobcache]
+
+  /**
+   * Number of bytes of zstd-compressed blobs to keep in memory after they are
+   * evicted from the in-memory blob cache. 0 disables the compressed tier.
+   * Only read at startup.
+   */
+  ConfigSetting<size_t> compressedBlobCacheSize{
+      "blobcache:compressed-cache-size",
+      0,
+      this};
+
   // [notifications]
 
   /**
@@ -738,6 +1501,14 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * Replay the prefetch profiles recorded for a mount after every checkout.
+   */
+  ConfigSetting<bool> replayRecordedPrefetchProfiles{
+      "prefetch-profiles:replay-recorded-profiles",
+      true,
+      this};
+
   /**
    * Kill switch for predictive prefetch profiles feature.
    */
@@ -796,6 +1567,151 @@ class EdenConfig : private ConfigSettingManager {
       "normal",
       this};
 
+  /**
+   * Whether the tree overlay keeps directory writes in memory and writes
+   * them to disk in the background. The overlay stays consistent after a
+   * crash, but loses up to overlay:buffer-max-age of changes. Takes
+   * precedence over overlay:synchronous-mode.
+   */
+  ConfigSetting<bool> overlayBuffered{"overlay:buffered", false, this};
+
+  /**
+   * Approximate number of bytes of directory writes the buffered overlay
+   * keeps in memory. Writers wait for a flush when it is reached.
+   */
+  ConfigSetting<uint64_t> overlayBufferMaxBytes{
+      "overlay:buffer-max-bytes",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * How long the buffered overlay keeps a directory write in memory before
+   * writing it to disk.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayBufferMaxAge{
+      "overlay:buffer-max-age",
+      std::chrono::seconds(1),
+      this};
+
+  /**
+   * Maximum number of bytes of blob contents the legacy overlay keeps on
+   * disk to clone materialized files from, on Linux. Only useful when the
+   * overlay is on a filesystem that can clone files, such as btrfs or XFS:
+   * the cache stops growing if it can't. 0 disables the cache.
+   */
+  ConfigSetting<uint64_t> overlayBlobFileCacheSize{
+      "overlay:blob-file-cache-size",
+      0,
+      this};
+
+  /**
+   * Maximum number of bytes of file contents, keyed by their SHA-1, that
+   * the legacy overlay keeps on disk for materialized files with identical
+   * contents to share their data with, on Linux. A file is deduplicated
+   * once its SHA-1 is computed and saved, and its first write after that
+   * only copies the blocks it modifies. Requires a filesystem that can
+   * share data between files, such as btrfs or XFS. 0 disables it.
+   */
+  ConfigSetting<uint64_t> overlayDedupStoreSize{
+      "overlay:dedup-store-size",
+      0,
+      this};
+
+  /**
+   * Whether the legacy overlay stores directories in a few append-only
+   * segment files instead of one file per directory. Directories already
+   * stored as files are moved to the segments as they are loaded. Once
+   * enabled, the segments keep being used even if this is turned off again.
+   */
+  ConfigSetting<bool> overlayPackedDirectories{
+      "overlay:packed-directories",
+      false,
+      this};
+
+  /**
+   * Whether reads, writes and fsyncs of materialized files are submitted to
+   * an io_uring instead of blocking the threads serving filesystem requests.
+   * Only supported on Linux; ignored if the kernel lacks io_uring.
+   */
+  ConfigSetting<bool> overlayUseIoUring{"overlay:use-io-uring", false, this};
+
+  /**
+   * How long small writes that extend the previous write to a materialized
+   * file may be buffered in memory, so that they reach the overlay file and
+   * the journal together. Reads, stats and fsyncs of the file write them out
+   * first. Buffered writes are lost if EdenFS crashes. 0 disables buffering,
+   * which is never done with `overlay:use-io-uring`.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayWriteCoalescingDelay{
+      "overlay:write-coalescing-delay",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * With `overlay:write-coalescing-delay`, the most bytes buffered for a
+   * file. Writes of more than a sixteenth of it are never buffered.
+   */
+  ConfigSetting<uint64_t> overlayWriteCoalescingMaxBytes{
+      "overlay:write-coalescing-max-bytes",
+      1024 * 1024,
+      this};
+
+  /**
+   * Number of tree overlay mutations a checkout groups into each SQLite
+   * transaction, instead of committing them one by one. Mutations of a batch
+   * that wasn't committed are lost if EdenFS crashes during the checkout.
+   * 0 disables batching.
+   */
+  ConfigSetting<uint64_t> overlayCheckoutBatchSize{
+      "overlay:checkout-batch-size",
+      0,
+      this};
+
+  /**
+   * Number of threads of each mount that remove the contents of removed
+   * directories from the overlay.
+   */
+  ConfigSetting<uint64_t> overlayGCThreads{"overlay:gc-threads", 4, this};
+
+  /**
+   * Maximum number of inodes a second that the overlay garbage collection
+   * of each mount removes, so that it leaves I/O for filesystem requests.
+   * 0 means no limit.
+   */
+  ConfigSetting<uint64_t> overlayGCMaxOpsPerSecond{
+      "overlay:gc-max-ops-per-second",
+      0,
+      this};
+
+  /**
+   * How often the inode metadata tables of the mounts start writing their
+   * modified records back to disk, so the kernel doesn't write back many of
+   * them at once at an unpredictable time. 0 leaves writeback to the kernel.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inodeMetadataFlushInterval{
+      "overlay:inode-metadata-flush-interval",
+      std::chrono::seconds(1),
+      this};
+
+  /**
+   * How often the materialized directories whose entries are identical to
+   * the working copy parent's trees again are dematerialized, when the host
+   * is idle. 0 disables it.
+   */
+  ConfigSetting<std::chrono::nanoseconds> dematerializeInterval{
+      "overlay:dematerialize-interval",
+      std::chrono::hours(1),
+      this};
+
+  /**
+   * Whether to dematerialize the directories identical to the new working
+   * copy parent's trees when it is reset, such as after a commit.
+   */
+  ConfigSetting<bool> dematerializeOnResetParent{
+      "overlay:dematerialize-on-reset-parent",
+      true,
+      this};
+
   // [clone]
 
   /**
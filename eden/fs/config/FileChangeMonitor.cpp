@@ -9,6 +9,7 @@
 #include <folly/logging/xlog.h>
 
 #include "eden/fs/config/FileChangeMonitor.h"
+#include "eden/fs/config/FileChangeWatcher.h"
 #include "eden/fs/utils/StatTimes.h"
 #include "eden/fs/utils/TimeUtil.h"
 
@@ -77,13 +78,44 @@ bool FileChangeMonitor::throttle() {
   return (std::chrono::steady_clock::now() - lastCheck_) < throttleDuration_;
 }
 
+std::optional<uint64_t> FileChangeMonitor::getWatchGeneration() {
+  if (!useWatcher_) {
+    return std::nullopt;
+  }
+  if (!watch_ || !watch_->valid.load(std::memory_order_acquire)) {
+    // Only retry watching as often as we would otherwise poll.
+    if (throttle()) {
+      return std::nullopt;
+    }
+    auto* watcher = FileChangeWatcher::get();
+    watch_ = watcher ? watcher->watch(filePath_) : nullptr;
+    // The new watch has its own generations, so the file must be checked
+    // once regardless of what the previous watch reported.
+    watchGeneration_.reset();
+    if (!watch_) {
+      return std::nullopt;
+    }
+  }
+  return watch_->generation.load(std::memory_order_acquire);
+}
+
 std::optional<folly::Expected<folly::File, int>>
 FileChangeMonitor::checkIfUpdated(bool noThrottle) {
   std::optional<folly::Expected<folly::File, int>> rslt;
 
-  if (!noThrottle && throttle()) {
-    return rslt;
+  // Read the generation before stat so that events racing with the stat
+  // below cause another check next time.
+  auto generation = getWatchGeneration();
+  if (!noThrottle) {
+    if (generation.has_value()) {
+      if (generation == watchGeneration_) {
+        return rslt;
+      }
+    } else if (throttle()) {
+      return rslt;
+    }
   }
+  watchGeneration_ = generation;
 
   // Update lastCheck - we use it for throttling
   lastCheck_ = std::chrono::steady_clock::now();
@@ -11,12 +11,15 @@
 #include <sys/stat.h>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <optional>
 
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
 
+struct FileWatch;
+
 /**
  * Why a file is considered to have changed. Evaluates as true in
  * conditionals if a file is considered changed.
@@ -66,6 +69,9 @@ FileChangeReason hasFileChanged(
  *
  * FileChangeMonitor performs checks on demand. The throttleDuration setting
  * can further limit resource usage (to a maximum of 1 check/throttleDuration).
+ * When constructed with useWatcher, the file is instead only checked after
+ * FileChangeWatcher reported an event for it, and throttled polling is the
+ * fallback used when the file cannot be watched.
  *
  * FileChangeMonitor is not thread safe - users are responsible for locking as
  * necessary.
@@ -75,11 +81,15 @@ class FileChangeMonitor {
   /**
    * Construct a FileChangeMonitor for the provided filePath.
    * @param throttleDuration specifies minimum time between file stats.
+   * @param useWatcher skip stat calls while the kernel reports no changes.
    */
   FileChangeMonitor(
       AbsolutePathPiece filePath,
-      std::chrono::milliseconds throttleDuration)
-      : filePath_{filePath}, throttleDuration_{throttleDuration} {
+      std::chrono::milliseconds throttleDuration,
+      bool useWatcher = false)
+      : filePath_{filePath},
+        throttleDuration_{throttleDuration},
+        useWatcher_{useWatcher} {
     resetToForceChange();
   }
 
@@ -146,6 +156,13 @@ class FileChangeMonitor {
    */
   bool throttle();
 
+  /**
+   * Returns the change generation of the monitored file, or std::nullopt if
+   * the file is not being watched and must be polled. (Re-)establishes the
+   * watch when the throttle allows it.
+   */
+  std::optional<uint64_t> getWatchGeneration();
+
   /** Stat the monitored file and compare results against last call to
    * isChanged(). It updates statErrno_ which can be used to by invokeIfUpdated
    * to make optimizations.
@@ -165,6 +182,8 @@ class FileChangeMonitor {
 
     statErrno_ = 0;
     openErrno_ = 0;
+    watch_.reset();
+    watchGeneration_.reset();
     // Set lastCheck in past so throttle does not apply.
     lastCheck_ = std::chrono::steady_clock::now() - throttleDuration_ -
         std::chrono::seconds{1};
@@ -176,6 +195,12 @@ class FileChangeMonitor {
   int openErrno_{0};
   std::chrono::milliseconds throttleDuration_;
   std::chrono::steady_clock::time_point lastCheck_;
+  bool useWatcher_{false};
+  std::shared_ptr<FileWatch> watch_;
+  /**
+   * The watch generation observed before the last stat, if any.
+   */
+  std::optional<uint64_t> watchGeneration_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/FileChangeWatcher.h"
+
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace facebook::eden {
+
+#ifdef __linux__
+
+namespace {
+constexpr uint32_t kDirectoryEvents = IN_CREATE | IN_DELETE | IN_MODIFY |
+    IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+void bump(std::vector<std::weak_ptr<FileWatch>>& watches) {
+  for (auto& weak : watches) {
+    if (auto watch = weak.lock()) {
+      watch->generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+  }
+}
+
+void invalidate(std::vector<std::weak_ptr<FileWatch>>& watches) {
+  for (auto& weak : watches) {
+    if (auto watch = weak.lock()) {
+      // Bump the generation as well so that a caller comparing generations
+      // checks the file once more before noticing the watch is gone.
+      watch->valid.store(false, std::memory_order_release);
+      watch->generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+  }
+}
+} // namespace
+
+FileChangeWatcher* FileChangeWatcher::get() {
+  static auto watcher = []() -> std::unique_ptr<FileChangeWatcher> {
+    int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+      XLOG(WARN) << "inotify unavailable, config files will be polled: "
+                 << folly::errnoStr(errno);
+      return nullptr;
+    }
+    folly::File inotify{inotifyFd, /*ownsFd=*/true};
+
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) != 0) {
+      XLOG(WARN) << "failed to create pipe for file watcher: "
+                 << folly::errnoStr(errno);
+      return nullptr;
+    }
+    return std::unique_ptr<FileChangeWatcher>{new FileChangeWatcher{
+        std::move(inotify),
+        folly::File{pipeFds[0], /*ownsFd=*/true},
+        folly::File{pipeFds[1], /*ownsFd=*/true}}};
+  }();
+  return watcher.get();
+}
+
+FileChangeWatcher::FileChangeWatcher(
+    folly::File inotify,
+    folly::File stopRead,
+    folly::File stopWrite)
+    : inotify_{std::move(inotify)},
+      stopRead_{std::move(stopRead)},
+      stopWrite_{std::move(stopWrite)},
+      thread_{[this] { run(); }} {}
+
+FileChangeWatcher::~FileChangeWatcher() {
+  char byte = 0;
+  XCHECK_EQ(1, folly::writeNoInt(stopWrite_.fd(), &byte, sizeof(byte)))
+      << "failed to stop file watcher: " << folly::errnoStr(errno);
+  thread_.join();
+}
+
+std::shared_ptr<FileWatch> FileChangeWatcher::watch(AbsolutePathPiece path) {
+  AbsolutePath filePath{path};
+  struct stat st;
+  if (lstat(filePath.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+    return nullptr;
+  }
+
+  AbsolutePath directory{path.dirname()};
+  auto name = path.basename().stringPiece().str();
+  auto watch = std::make_shared<FileWatch>();
+
+  // Hold the lock while adding the watch so that the watcher thread cannot
+  // look up the new watch descriptor before it is recorded.
+  auto state = state_.wlock();
+  int wd =
+      inotify_add_watch(inotify_.fd(), directory.c_str(), kDirectoryEvents);
+  if (wd < 0) {
+    XLOG(DBG3) << "cannot watch " << directory << ", polling " << path << ": "
+               << folly::errnoStr(errno);
+    return nullptr;
+  }
+
+  // inotify returns the existing descriptor if the directory is already
+  // watched.
+  auto& entry = state->directoriesByWd[wd];
+  entry.path = std::move(directory);
+  auto& watches = entry.files[name];
+  watches.erase(
+      std::remove_if(
+          watches.begin(),
+          watches.end(),
+          [](const auto& weak) { return weak.expired(); }),
+      watches.end());
+  watches.push_back(watch);
+  return watch;
+}
+
+void FileChangeWatcher::run() {
+  folly::setThreadName("FileWatcher");
+
+  struct pollfd fds[2] = {
+      {inotify_.fd(), POLLIN, 0},
+      {stopRead_.fd(), POLLIN, 0},
+  };
+  alignas(struct inotify_event) uint8_t buffer[4096];
+  while (true) {
+    int rc = poll(fds, 2, -1);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      XLOG(ERR) << "file watcher poll failed: " << folly::errnoStr(errno);
+      break;
+    }
+    if (fds[1].revents) {
+      break;
+    }
+    if (!(fds[0].revents & POLLIN)) {
+      continue;
+    }
+
+    ssize_t bytesRead = ::read(inotify_.fd(), buffer, sizeof(buffer));
+    if (bytesRead < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      XLOG(ERR) << "file watcher read failed: " << folly::errnoStr(errno);
+      break;
+    }
+    processEvents(folly::ByteRange{buffer, static_cast<size_t>(bytesRead)});
+  }
+
+  // Nobody will be notified of changes anymore, so everyone must poll.
+  invalidateAll();
+}
+
+void FileChangeWatcher::processEvents(folly::ByteRange events) {
+  auto state = state_.wlock();
+  while (events.size() >= sizeof(struct inotify_event)) {
+    struct inotify_event event;
+    memcpy(&event, events.data(), sizeof(event));
+    auto eventSize = sizeof(event) + event.len;
+    folly::StringPiece name;
+    if (event.len) {
+      // The name is NUL-padded to an alignment boundary.
+      name = folly::StringPiece{
+          reinterpret_cast<const char*>(events.data() + sizeof(event))};
+    }
+    events.advance(std::min(eventSize, events.size()));
+
+    if (event.mask & IN_Q_OVERFLOW) {
+      // Events were dropped; any file may have changed.
+      for (auto& [wd, directory] : state->directoriesByWd) {
+        for (auto& [fileName, watches] : directory.files) {
+          bump(watches);
+        }
+      }
+      continue;
+    }
+
+    auto it = state->directoriesByWd.find(event.wd);
+    if (it == state->directoriesByWd.end()) {
+      continue;
+    }
+    auto& directory = it->second;
+
+    if (event.mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+      XLOG(DBG3) << "lost watch on " << directory.path;
+      for (auto& [fileName, watches] : directory.files) {
+        invalidate(watches);
+      }
+      if (!(event.mask & IN_IGNORED)) {
+        inotify_rm_watch(inotify_.fd(), event.wd);
+      }
+      state->directoriesByWd.erase(it);
+      continue;
+    }
+
+    if (name.empty()) {
+      continue;
+    }
+    auto fileIt = directory.files.find(name.str());
+    if (fileIt != directory.files.end()) {
+      bump(fileIt->second);
+    }
+  }
+}
+
+void FileChangeWatcher::invalidateAll() {
+  auto state = state_.wlock();
+  for (auto& [wd, directory] : state->directoriesByWd) {
+    for (auto& [fileName, watches] : directory.files) {
+      invalidate(watches);
+    }
+  }
+  state->directoriesByWd.clear();
+}
+
+#else
+
+FileChangeWatcher* FileChangeWatcher::get() {
+  return nullptr;
+}
+
+FileChangeWatcher::~FileChangeWatcher() = default;
+
+std::shared_ptr<FileWatch> FileChangeWatcher::watch(AbsolutePathPiece) {
+  return nullptr;
+}
+
+#endif
+
+} // namespace facebook::eden
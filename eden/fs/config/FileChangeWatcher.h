@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * The state shared between FileChangeWatcher and the user of one watched
+ * file.
+ */
+struct FileWatch {
+  /**
+   * Incremented every time the kernel reports an event that may have changed
+   * the file, and when events may have been dropped. Callers compare it
+   * against the value they observed before their last stat() to decide
+   * whether the file needs to be checked again.
+   */
+  std::atomic<uint64_t> generation{0};
+
+  /**
+   * Cleared when the watch is lost, for example because the parent directory
+   * was removed or renamed. Once invalid, the watch never reports changes
+   * again and callers must fall back to polling.
+   */
+  std::atomic<bool> valid{true};
+};
+
+/**
+ * Delivers kernel change notifications for individual files so that
+ * FileChangeMonitor and ReloadableConfig can skip stat() calls while nothing
+ * happened to the files they monitor.
+ *
+ * Only inotify is supported. On other platforms get() returns nullptr and
+ * callers keep polling.
+ *
+ * The parent directory of each file is watched rather than the file itself,
+ * so that editors replacing the file with rename() are noticed. Symlinks are
+ * not watched because changes to their target would go unnoticed.
+ */
+class FileChangeWatcher {
+ public:
+  ~FileChangeWatcher();
+
+  FileChangeWatcher(const FileChangeWatcher&) = delete;
+  FileChangeWatcher& operator=(const FileChangeWatcher&) = delete;
+
+  /**
+   * Returns the process-wide watcher, or nullptr if kernel notifications are
+   * not available.
+   */
+  static FileChangeWatcher* get();
+
+  /**
+   * Start watching the given file. Returns nullptr if the file cannot be
+   * watched, in which case the caller must poll it.
+   *
+   * The watch stays active for as long as the returned pointer is alive.
+   */
+  std::shared_ptr<FileWatch> watch(AbsolutePathPiece path);
+
+ private:
+  struct Directory {
+    AbsolutePath path;
+    folly::F14NodeMap<std::string, std::vector<std::weak_ptr<FileWatch>>>
+        files;
+  };
+
+  struct State {
+    folly::F14NodeMap<int, Directory> directoriesByWd;
+  };
+
+  FileChangeWatcher(
+      folly::File inotify,
+      folly::File stopRead,
+      folly::File stopWrite);
+
+  void run();
+  void processEvents(folly::ByteRange events);
+  void invalidateAll();
+
+  folly::File inotify_;
+  folly::File stopRead_;
+  folly::File stopWrite_;
+  folly::Synchronized<State> state_;
+  std::thread thread_;
+};
+
+} // namespace facebook::eden
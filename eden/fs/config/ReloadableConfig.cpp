@@ -8,6 +8,7 @@
 #include "eden/fs/config/ReloadableConfig.h"
 
 #include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/FileChangeWatcher.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/EnumValue.h"
 
@@ -22,51 +23,79 @@ constexpr std::chrono::seconds kEdenConfigMinimumPollDuration{5};
 namespace facebook::eden {
 
 ReloadableConfig::ReloadableConfig(std::shared_ptr<const EdenConfig> config)
-    : state_{ConfigState{config}} {}
+    : config_{config} {
+  if (auto* watcher = FileChangeWatcher::get()) {
+    userConfigWatch_ = watcher->watch(config->getUserConfigPath());
+    systemConfigWatch_ = watcher->watch(config->getSystemConfigPath());
+  }
+}
 ReloadableConfig::ReloadableConfig(
     std::shared_ptr<const EdenConfig> config,
     ConfigReloadBehavior reloadBehavior)
-    : state_{ConfigState{config}}, reloadBehavior_{reloadBehavior} {}
+    : config_{std::move(config)}, reloadBehavior_{reloadBehavior} {}
 
 ReloadableConfig::~ReloadableConfig() {}
 
 std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
     ConfigReloadBehavior reload) {
-  auto now = std::chrono::steady_clock::now();
-
-  // TODO: Update this monitoring code to use FileChangeMonitor.
-  bool shouldReload;
   if (reloadBehavior_.has_value()) {
     reload = reloadBehavior_.value();
   }
   switch (reload) {
     case ConfigReloadBehavior::NoReload:
-      shouldReload = false;
-      break;
+      return config_.load(std::memory_order_acquire);
     case ConfigReloadBehavior::ForceReload:
-      shouldReload = true;
-      break;
+      return this->reload(std::chrono::steady_clock::now());
     case ConfigReloadBehavior::AutoReload: {
+      if (auto generation = getWatchGeneration()) {
+        auto seen = watchGeneration_.load(std::memory_order_acquire);
+        if (*generation == seen ||
+            !watchGeneration_.compare_exchange_strong(
+                seen, *generation, std::memory_order_acq_rel)) {
+          return config_.load(std::memory_order_acquire);
+        }
+        return this->reload(std::chrono::steady_clock::now());
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      auto lastCheckRep = lastCheck_.load(std::memory_order_acquire);
       auto lastCheck = std::chrono::steady_clock::time_point{
-          std::chrono::steady_clock::duration{
-              lastCheck_.load(std::memory_order_acquire)}};
-      shouldReload = now - lastCheck >= kEdenConfigMinimumPollDuration;
-      break;
+          std::chrono::steady_clock::duration{lastCheckRep}};
+      if (now - lastCheck < kEdenConfigMinimumPollDuration) {
+        return config_.load(std::memory_order_acquire);
+      }
+      // Only the caller that claims this poll interval checks the files.
+      // Everyone else keeps using the current snapshot rather than waiting.
+      if (!lastCheck_.compare_exchange_strong(
+              lastCheckRep,
+              now.time_since_epoch().count(),
+              std::memory_order_acq_rel)) {
+        return config_.load(std::memory_order_acquire);
+      }
+      return this->reload(now);
     }
-    default:
-      EDEN_BUG() << "Unexpected reload flag: " << enumValue(reload);
   }
+  EDEN_BUG() << "Unexpected reload flag: " << enumValue(reload);
+}
 
-  if (!shouldReload) {
-    return state_.rlock()->config;
+std::optional<uint64_t> ReloadableConfig::getWatchGeneration() const {
+  if (!userConfigWatch_ || !systemConfigWatch_ ||
+      !userConfigWatch_->valid.load(std::memory_order_acquire) ||
+      !systemConfigWatch_->valid.load(std::memory_order_acquire)) {
+    return std::nullopt;
   }
+  return userConfigWatch_->generation.load(std::memory_order_acquire) +
+      systemConfigWatch_->generation.load(std::memory_order_acquire);
+}
 
-  auto state = state_.wlock();
+std::shared_ptr<const EdenConfig> ReloadableConfig::reload(
+    std::chrono::steady_clock::time_point now) {
+  std::lock_guard<std::mutex> guard{reloadMutex_};
 
   // Throttle the updates when using ConfigReloadBehavior::AutoReload
   lastCheck_.store(now.time_since_epoch().count(), std::memory_order_release);
 
-  auto& config = state->config;
+  auto config = config_.load(std::memory_order_acquire);
 
   auto userConfigChanged = config->hasUserConfigFileChanged();
   auto systemConfigChanged = config->hasSystemConfigFileChanged();
@@ -82,9 +111,10 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
                  << systemConfigChanged.str();
       newConfig->loadSystemConfig();
     }
-    state->config = std::move(newConfig);
+    config = std::move(newConfig);
+    config_.store(config, std::memory_order_release);
   }
-  return state->config;
+  return config;
 }
 
 } // namespace facebook::eden
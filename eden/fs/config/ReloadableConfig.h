@@ -7,16 +7,20 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 
-#include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 
 #include "eden/fs/config/gen-cpp2/eden_config_types.h"
 
 namespace facebook::eden {
 
 class EdenConfig;
+struct FileWatch;
 
 /**
  * An interface that defines how to obtain a possibly reloaded EdenConfig
@@ -34,21 +38,52 @@ class ReloadableConfig {
    * Get the EdenConfig data.
    *
    * The config data may be reloaded from disk depending on the value of the
-   * reload parameter.
+   * reload parameter. With AutoReload, the config files are only checked after
+   * FileChangeWatcher reported a change to them, or at most once per poll
+   * interval when they cannot be watched. One caller performs each check;
+   * every other call only loads the current snapshot and never blocks.
    */
   std::shared_ptr<const EdenConfig> getEdenConfig(
       ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload);
 
  private:
-  struct ConfigState {
-    explicit ConfigState(const std::shared_ptr<const EdenConfig>& config)
-        : config{config} {}
-    std::shared_ptr<const EdenConfig> config;
-  };
+  /**
+   * Checks the config files for changes and publishes a new snapshot if they
+   * were modified. Returns the current snapshot.
+   */
+  std::shared_ptr<const EdenConfig> reload(
+      std::chrono::steady_clock::time_point now);
 
-  folly::Synchronized<ConfigState> state_;
+  /**
+   * Returns a value that changes whenever either config file may have
+   * changed, or std::nullopt if the files are not watched and must be polled.
+   */
+  std::optional<uint64_t> getWatchGeneration() const;
+
+  /**
+   * The current snapshot. Readers only perform an atomic load; a reload
+   * publishes a new EdenConfig rather than modifying the existing one.
+   */
+  folly::atomic_shared_ptr<const EdenConfig> config_;
+  /**
+   * Serializes reloads so that a change is only loaded from disk once.
+   */
+  std::mutex reloadMutex_;
   std::atomic<std::chrono::steady_clock::time_point::rep> lastCheck_{};
 
+  /**
+   * Watches on the user and system config files. Null if they could not be
+   * watched.
+   */
+  std::shared_ptr<FileWatch> userConfigWatch_;
+  std::shared_ptr<FileWatch> systemConfigWatch_;
+  /**
+   * The watch generation observed before the last check of the config files.
+   * Starts out as a value getWatchGeneration() never returns so that the
+   * first AutoReload checks the files.
+   */
+  std::atomic<uint64_t> watchGeneration_{~uint64_t{0}};
+
   // Reload behavior, when set this overrides reload behavior passed to methods
   // This is used in tests where we want to set the manually set the EdenConfig
   // and avoid reloading it from disk.
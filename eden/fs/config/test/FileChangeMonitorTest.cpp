@@ -10,6 +10,7 @@
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/config/FileChangeMonitor.h"
 #include "eden/fs/utils/FileUtils.h"
@@ -435,4 +436,33 @@ TEST_F(FileChangeMonitorTest, openFailFixTest) {
   EXPECT_EQ(fcp.getCallbackCount(), 2);
   EXPECT_EQ(fcp.getFileContents(), dataOne_);
 }
+
+#ifdef __linux__
+TEST_F(FileChangeMonitorTest, watcherNoticesChangeWhileThrottled) {
+  MockFileChangeProcessor fcp;
+  auto path = AbsolutePath{(rootTestDir_->path() / "WatchedFile.txt").string()};
+  writeFileAtomic(path, dataOne_).throwUnlessValue();
+
+  // A throttle this long means only an inotify event can trigger a check.
+  auto fcm = std::make_shared<FileChangeMonitor>(path, 1h, /*useWatcher=*/true);
+  EXPECT_TRUE(fcm->invokeIfUpdated(std::ref(fcp)));
+  EXPECT_EQ(fcp.getFileContents(), dataOne_);
+  EXPECT_FALSE(fcm->invokeIfUpdated(std::ref(fcp)));
+
+  // Replace the file like editors do. Events are delivered asynchronously,
+  // so wait for the watcher thread to process them.
+  writeFileAtomic(path, dataTwo_).throwUnlessValue();
+  auto deadline = std::chrono::steady_clock::now() + 10s;
+  bool updated = false;
+  while (!updated && std::chrono::steady_clock::now() < deadline) {
+    updated = fcm->invokeIfUpdated(std::ref(fcp));
+    if (!updated) {
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+  EXPECT_TRUE(updated);
+  EXPECT_EQ(fcp.getCallbackCount(), 2);
+  EXPECT_EQ(fcp.getFileContents(), dataTwo_);
+}
+#endif
 #endif
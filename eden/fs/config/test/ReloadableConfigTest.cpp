@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/ReloadableConfig.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+
+class ReloadableConfigTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tempDir_ = std::make_unique<folly::test::TemporaryDirectory>(
+        "eden_reloadable_config_test_");
+    auto root = AbsolutePath{tempDir_->path().native()};
+    userConfigPath_ = root + ".edenrc"_pc;
+    writeUserConfig("[mononoke]\nuse-mononoke=false\n");
+
+    auto config = std::make_shared<EdenConfig>(
+        "bob",
+        uid_t{},
+        root,
+        userConfigPath_,
+        root,
+        root + "edenfs.rc"_pc);
+    config->loadUserConfig();
+    config_ = std::move(config);
+  }
+
+  void writeUserConfig(folly::StringPiece contents) {
+    writeFile(userConfigPath_, contents).value();
+  }
+
+  std::unique_ptr<folly::test::TemporaryDirectory> tempDir_;
+  AbsolutePath userConfigPath_;
+  std::shared_ptr<const EdenConfig> config_;
+};
+
+} // namespace
+
+TEST_F(ReloadableConfigTest, no_reload_returns_current_snapshot) {
+  ReloadableConfig reloadable{config_};
+  writeUserConfig("[mononoke]\nuse-mononoke=true\n");
+  auto snapshot = reloadable.getEdenConfig(ConfigReloadBehavior::NoReload);
+  EXPECT_EQ(config_, snapshot);
+  EXPECT_FALSE(snapshot->useMononoke.getValue());
+}
+
+TEST_F(ReloadableConfigTest, force_reload_publishes_new_snapshot) {
+  ReloadableConfig reloadable{config_};
+  writeUserConfig("[mononoke]\nuse-mononoke=true # changed\n");
+
+  auto reloaded = reloadable.getEdenConfig(ConfigReloadBehavior::ForceReload);
+  EXPECT_NE(config_, reloaded);
+  EXPECT_TRUE(reloaded->useMononoke.getValue());
+  // The old snapshot is never modified in place.
+  EXPECT_FALSE(config_->useMononoke.getValue());
+
+  // Later reads see the new snapshot without touching the disk.
+  EXPECT_EQ(
+      reloaded, reloadable.getEdenConfig(ConfigReloadBehavior::NoReload));
+}
+
+TEST_F(ReloadableConfigTest, concurrent_auto_reload_loads_changes_once) {
+  ReloadableConfig reloadable{config_};
+  writeUserConfig("[mononoke]\nuse-mononoke=true # changed\n");
+
+  constexpr size_t kThreadCount = 8;
+  std::vector<std::shared_ptr<const EdenConfig>> snapshots(kThreadCount);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < 1000; ++j) {
+        snapshots[i] = reloadable.getEdenConfig();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Only one caller checked the files, so every thread observed either the
+  // original snapshot or the single reloaded one.
+  auto current = reloadable.getEdenConfig(ConfigReloadBehavior::NoReload);
+  EXPECT_NE(config_, current);
+  EXPECT_TRUE(current->useMononoke.getValue());
+  for (auto& snapshot : snapshots) {
+    EXPECT_TRUE(snapshot == config_ || snapshot == current);
+  }
+}
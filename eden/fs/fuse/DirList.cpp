@@ -16,18 +16,74 @@ using folly::StringPiece;
 
 namespace facebook::eden {
 
-FuseDirList::FuseDirList(size_t maxSize)
-    : buf_(new char[maxSize]), end_(buf_.get() + maxSize), cur_(buf_.get()) {}
+namespace {
+size_t nameOffset(bool plus) {
+#ifdef __linux__
+  return plus ? FUSE_NAME_OFFSET_DIRENTPLUS : FUSE_NAME_OFFSET;
+#else
+  XCHECK(!plus) << "READDIRPLUS is only supported on Linux";
+  return FUSE_NAME_OFFSET;
+#endif
+}
+
+// Larger buffers are freed rather than kept around by every thread.
+constexpr size_t kMaxSpareBufferSize = 1024 * 1024;
+
+struct SpareBuffer {
+  std::unique_ptr<char[]> buf;
+  size_t size = 0;
+};
+thread_local SpareBuffer spareBuffer;
+
+fuse_dirent* direntAt(char* p, bool plus) {
+#ifdef __linux__
+  if (plus) {
+    return &reinterpret_cast<fuse_direntplus*>(p)->dirent;
+  }
+#else
+  (void)plus;
+#endif
+  return reinterpret_cast<fuse_dirent*>(p);
+}
+} // namespace
+
+FuseDirList::FuseDirList(size_t maxSize, bool plus) : plus_(plus) {
+  if (spareBuffer.buf && spareBuffer.size >= maxSize) {
+    buf_ = std::move(spareBuffer.buf);
+    bufSize_ = spareBuffer.size;
+    spareBuffer.size = 0;
+  } else {
+    buf_.reset(new char[maxSize]);
+    bufSize_ = maxSize;
+  }
+  end_ = buf_.get() + maxSize;
+  cur_ = buf_.get();
+}
+
+FuseDirList::~FuseDirList() {
+  // Lists that were moved from have no buffer.
+  if (buf_ && bufSize_ <= kMaxSpareBufferSize &&
+      bufSize_ > spareBuffer.size) {
+    spareBuffer.buf = std::move(buf_);
+    spareBuffer.size = bufSize_;
+  }
+}
 
 bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
   const size_t avail = end_ - cur_;
-  const auto entLength = FUSE_NAME_OFFSET + name.size();
+  const auto entLength = nameOffset(plus_) + name.size();
   const auto fullSize = FUSE_DIRENT_ALIGN(entLength);
   if (fullSize > avail) {
     return false;
   }
 
-  fuse_dirent* const dirent = reinterpret_cast<fuse_dirent*>(cur_);
+  fuse_dirent* const dirent = direntAt(cur_, plus_);
+#ifdef __linux__
+  if (plus_) {
+    auto& entryOut = reinterpret_cast<fuse_direntplus*>(cur_)->entry_out;
+    memset(&entryOut, 0, sizeof(entryOut));
+  }
+#endif
   dirent->ino = inode;
   dirent->off = off;
   dirent->namelen = name.size();
@@ -47,19 +103,39 @@ StringPiece FuseDirList::getBuf() const {
   return StringPiece(buf_.get(), cur_ - buf_.get());
 }
 
+std::vector<FuseDirList::EntryOut> FuseDirList::getEntryOuts() {
+  XCHECK(plus_) << "only READDIRPLUS lists have entry attributes";
+  std::vector<EntryOut> result;
+
+#ifdef __linux__
+  char* p = buf_.get();
+  while (p != cur_) {
+    auto direntplus = reinterpret_cast<fuse_direntplus*>(p);
+    auto& dirent = direntplus->dirent;
+    result.push_back(EntryOut{
+        StringPiece{dirent.name, dirent.namelen},
+        dirent.ino,
+        &direntplus->entry_out});
+
+    p += FUSE_DIRENT_ALIGN(FUSE_NAME_OFFSET_DIRENTPLUS + dirent.namelen);
+  }
+#endif
+  return result;
+}
+
 std::vector<FuseDirList::ExtractedEntry> FuseDirList::extract() const {
   std::vector<FuseDirList::ExtractedEntry> result;
 
   char* p = buf_.get();
   while (p != cur_) {
-    auto entry = reinterpret_cast<fuse_dirent*>(p);
+    auto entry = direntAt(p, plus_);
     result.emplace_back(ExtractedEntry{
         std::string{entry->name, entry->name + entry->namelen},
         entry->ino,
         static_cast<dtype_t>(entry->type),
         static_cast<off_t>(entry->off)});
 
-    p += FUSE_DIRENT_ALIGN(FUSE_NAME_OFFSET + entry->namelen);
+    p += FUSE_DIRENT_ALIGN(nameOffset(plus_) + entry->namelen);
   }
   return result;
 }
@@ -9,17 +9,25 @@
 #include <folly/Range.h>
 #include <sys/stat.h>
 #include <memory>
+#include <vector>
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/FsChannelTypes.h"
 
 namespace facebook::eden {
 
 /**
  * Helper for populating directory listings.
+ *
+ * A list for FUSE_READDIRPLUS holds a fuse_entry_out with each entry. add()
+ * zeroes it, which tells the kernel nothing is known about the entry, and
+ * getEntryOuts() gives access to it to fill it in.
  */
 class FuseDirList {
   std::unique_ptr<char[]> buf_;
+  size_t bufSize_;
   char* end_;
   char* cur_;
+  bool plus_;
 
  public:
   struct ExtractedEntry {
@@ -29,7 +37,23 @@ class FuseDirList {
     off_t offset;
   };
 
-  explicit FuseDirList(size_t maxSize);
+  /**
+   * The fuse_entry_out of an entry in a READDIRPLUS list. Remains valid for
+   * as long as the list, even if it is moved.
+   */
+  struct EntryOut {
+    folly::StringPiece name;
+    ino_t inode;
+    fuse_entry_out* entry;
+  };
+
+  /**
+   * The buffer is taken from the one the last list destroyed on this thread
+   * left behind when it is large enough, so that listings don't each allocate
+   * one.
+   */
+  explicit FuseDirList(size_t maxSize, bool plus = false);
+  ~FuseDirList();
 
   FuseDirList(const FuseDirList&) = delete;
   FuseDirList& operator=(const FuseDirList&) = delete;
@@ -44,6 +68,15 @@ class FuseDirList {
 
   folly::StringPiece getBuf() const;
 
+  bool isPlus() const {
+    return plus_;
+  }
+
+  /**
+   * Returns the fuse_entry_out of each entry of a READDIRPLUS list.
+   */
+  std::vector<EntryOut> getEntryOuts();
+
   /**
    * Helper function that parses an accumulated buffer back into its constituent
    * parts.
@@ -11,12 +11,20 @@
 
 #include <boost/cast.hpp>
 #include <fmt/core.h>
+#include <folly/FileUtil.h>
+#include <folly/MapUtil.h>
+#include <folly/ScopeGuard.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <sys/ioctl.h>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <mutex>
 #include <type_traits>
 #include "eden/common/utils/Synchronized.h"
 #include "eden/fs/fuse/DirList.h"
@@ -36,6 +44,60 @@ namespace facebook::eden {
 
 namespace {
 
+/**
+ * The FUSE device replies sent by the current thread are written to, set by
+ * FuseChannel::ReplyDeviceScope.
+ */
+struct ReplyDevice {
+  const FuseChannel* channel{nullptr};
+  int fd{-1};
+};
+thread_local ReplyDevice currentReplyDevice;
+
+#ifdef __linux__
+/**
+ * The pipe spliced replies go through. Replies are sent from many threads, so
+ * each thread has its own.
+ */
+struct SplicePipe {
+  folly::File readEnd;
+  folly::File writeEnd;
+  size_t capacity{0};
+};
+
+// Empty until the thread first splices a reply, and after an error may have
+// left data in the pipe.
+thread_local std::optional<SplicePipe> currentSplicePipe;
+
+// Large enough for the largest read the kernel sends, FUSE_MAX_MAX_PAGES
+// pages, plus the reply header.
+constexpr size_t kSplicePipeSize = 2 * 1024 * 1024;
+
+SplicePipe* getSplicePipe() {
+  if (!currentSplicePipe) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+      XLOG_EVERY_MS(WARN, 1000)
+          << "unable to create splice pipe: " << folly::errnoStr(errno);
+      return nullptr;
+    }
+    SplicePipe pipe{folly::File{fds[0], true}, folly::File{fds[1], true}};
+    // Pipe buffers are allocated as they fill, so this costs no memory until
+    // a large reply is sent. The size may be capped by
+    // /proc/sys/fs/pipe-max-size, in which case larger replies are not
+    // spliced.
+    fcntl(pipe.writeEnd.fd(), F_SETPIPE_SZ, kSplicePipeSize);
+    auto capacity = fcntl(pipe.writeEnd.fd(), F_GETPIPE_SZ);
+    if (capacity <= 0) {
+      return nullptr;
+    }
+    pipe.capacity = static_cast<size_t>(capacity);
+    currentSplicePipe = std::move(pipe);
+  }
+  return &*currentSplicePipe;
+}
+#endif
+
 /**
  * For most FUSE requests, the protocol is simple: an optional request
  * parameters struct followed by zero or more null-terminated strings. Provide
@@ -176,6 +238,7 @@ std::string readdir(FuseArg arg) {
   return fmt::format("offset={}", in.offset);
 }
 
+constexpr RenderFn readdirplus = readdir;
 constexpr RenderFn releasedir = default_render;
 constexpr RenderFn fsyncdir = default_render;
 
@@ -217,6 +280,82 @@ static_assert(
 // This is the minimum size used by libfuse so we use it too!
 constexpr size_t MIN_BUFSIZE = 0x21000;
 
+// Like libfuse, reserve a page in request buffers for the request header and
+// fuse_write_in on top of max_write.
+constexpr size_t kRequestHeaderSize = 0x1000;
+
+// The kernel never uses a max_write below 4 KiB, and Linux limits requests to
+// 256 pages.
+constexpr size_t kMinMaxWrite = 4 * 1024;
+constexpr size_t kMaxMaxWrite = 1024 * 1024;
+
+// Number of request buffers kept around for future worker threads.
+constexpr size_t kMaxPooledRequestBuffers = 64;
+
+struct PooledRequestBuffer {
+  std::unique_ptr<char[]> data;
+  size_t size{0};
+};
+
+/**
+ * Request buffers of FUSE worker threads that have exited, shared by all
+ * mounts. Buffers can be as large as 1 MiB, so rather than allocating and
+ * zeroing one for every worker thread each time a mount is started, buffers
+ * are reused.
+ */
+folly::Synchronized<std::vector<PooledRequestBuffer>, std::mutex>&
+requestBufferPool() {
+  static auto* pool =
+      new folly::Synchronized<std::vector<PooledRequestBuffer>, std::mutex>();
+  return *pool;
+}
+
+/**
+ * A request buffer taken from requestBufferPool() for the lifetime of a FUSE
+ * worker thread, and returned to it on destruction.
+ */
+class RequestBuffer {
+ public:
+  explicit RequestBuffer(size_t size) {
+    {
+      auto pool = requestBufferPool().lock();
+      auto it = std::find_if(pool->begin(), pool->end(), [&](const auto& buf) {
+        return buf.size >= size;
+      });
+      if (it != pool->end()) {
+        buffer_ = std::move(*it);
+        pool->erase(it);
+        return;
+      }
+    }
+    // Every request is read into the buffer before it is parsed, so there is
+    // no need to zero it.
+    buffer_.data.reset(new char[size]);
+    buffer_.size = size;
+  }
+
+  ~RequestBuffer() {
+    auto pool = requestBufferPool().lock();
+    if (pool->size() < kMaxPooledRequestBuffers) {
+      pool->push_back(std::move(buffer_));
+    }
+  }
+
+  RequestBuffer(const RequestBuffer&) = delete;
+  RequestBuffer& operator=(const RequestBuffer&) = delete;
+
+  char* data() {
+    return buffer_.data.get();
+  }
+
+  size_t size() const {
+    return buffer_.size;
+  }
+
+ private:
+  PooledRequestBuffer buffer_;
+};
+
 using Handler = ImmediateFuture<folly::Unit> (FuseChannel::*)(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -485,7 +624,13 @@ constexpr auto kFuseHandlers = [] {
       &ChannelThreadStats::fallocate,
       Write};
 #ifdef __linux__
-  handlers[FUSE_READDIRPLUS] = {"FUSE_READDIRPLUS", Read};
+  handlers[FUSE_READDIRPLUS] = {
+      "FUSE_READDIRPLUS",
+      &FuseChannel::fuseReadDirPlus,
+      &argrender::readdirplus,
+      &ChannelThreadStats::readdirplus,
+      Read,
+      SamplingGroup::Three};
   handlers[FUSE_RENAME2] = {"FUSE_RENAME2", Write};
   handlers[FUSE_LSEEK] = {"FUSE_LSEEK"};
   handlers[FUSE_COPY_FILE_RANGE] = {"FUSE_COPY_FILE_RANGE", Write};
@@ -643,11 +788,6 @@ FuseChannel::InvalidationEntry::InvalidationEntry(
     int64_t length)
     : type(InvalidationType::INODE), inode(num), range(offset, length) {}
 
-FuseChannel::InvalidationEntry::InvalidationEntry(Promise<Unit> p)
-    : type(InvalidationType::FLUSH),
-      inode(kRootNodeId),
-      promise(std::move(p)) {}
-
 FuseChannel::InvalidationEntry::~InvalidationEntry() {
   switch (type) {
     case InvalidationType::INODE:
@@ -656,9 +796,6 @@ FuseChannel::InvalidationEntry::~InvalidationEntry() {
     case InvalidationType::DIR_ENTRY:
       name.~PathComponent();
       return;
-    case InvalidationType::FLUSH:
-      promise.~Promise();
-      return;
   }
   XLOG(FATAL) << "unknown InvalidationEntry type: "
               << static_cast<uint64_t>(type);
@@ -666,16 +803,13 @@ FuseChannel::InvalidationEntry::~InvalidationEntry() {
 
 FuseChannel::InvalidationEntry::InvalidationEntry(
     InvalidationEntry&& other) noexcept
-    : type(other.type), inode(other.inode) {
+    : type(other.type), inode(other.inode), sequence(other.sequence) {
   // For simplicity we just declare the InvalidationEntry move constructor as
   // unconditionally noexcept in FuseChannel.h
   // Assert that this is actually true.
   static_assert(
       std::is_nothrow_move_constructible<PathComponent>::value,
       "All members should be nothrow move constructible");
-  static_assert(
-      std::is_nothrow_move_constructible<Promise<Unit>>::value,
-      "All members should be nothrow move constructible");
   static_assert(
       std::is_nothrow_move_constructible<DataRange>::value,
       "All members should be nothrow move constructible");
@@ -687,9 +821,6 @@ FuseChannel::InvalidationEntry::InvalidationEntry(
     case InvalidationType::DIR_ENTRY:
       new (&name) PathComponent(std::move(other.name));
       return;
-    case InvalidationType::FLUSH:
-      new (&promise) Promise<Unit>(std::move(other.promise));
-      return;
   }
 }
 
@@ -703,14 +834,31 @@ std::ostream& operator<<(
     case FuseChannel::InvalidationType::DIR_ENTRY:
       return os << "(inode " << entry.inode << ", child \"" << entry.name
                 << "\")";
-    case FuseChannel::InvalidationType::FLUSH:
-      return os << "(invalidation flush)";
   }
   return os << "(unknown invalidation type "
             << static_cast<uint64_t>(entry.type) << " inode " << entry.inode
             << ")";
 }
 
+FuseChannel::ReplyDeviceScope::ReplyDeviceScope(
+    const FuseChannel* channel,
+    int fd)
+    : previousChannel_{currentReplyDevice.channel},
+      previousFd_{currentReplyDevice.fd} {
+  currentReplyDevice = ReplyDevice{channel, fd};
+}
+
+FuseChannel::ReplyDeviceScope::~ReplyDeviceScope() {
+  currentReplyDevice = ReplyDevice{previousChannel_, previousFd_};
+}
+
+int FuseChannel::getReplyDevice() const {
+  if (currentReplyDevice.channel == this) {
+    return currentReplyDevice.fd;
+  }
+  return fuseDevice_.fd();
+}
+
 void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
   fuse_out_header err;
   err.len = sizeof(err);
@@ -718,7 +866,7 @@ void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
   err.unique = request.unique;
   XLOG(DBG7) << "replyError unique=" << err.unique << " error=" << errorCode
              << " " << folly::errnoStr(errorCode);
-  auto res = write(fuseDevice_.fd(), &err, sizeof(err));
+  auto res = write(getReplyDevice(), &err, sizeof(err));
   if (res != sizeof(err)) {
     if (res < 0) {
       throwSystemError("replyError: error writing to fuse device");
@@ -747,6 +895,12 @@ void FuseChannel::sendReply(
   out.unique = request.unique;
   out.error = 0;
 
+  if (spliceReadThreshold_ != 0 &&
+      buf.computeChainDataLength() >= spliceReadThreshold_ &&
+      trySendSplicedReply(out, &buf, nullptr)) {
+    return;
+  }
+
   folly::fbvector<iovec> vec;
   vec.reserve(1 + buf.countChainElements());
   vec.push_back(make_iovec(out));
@@ -755,6 +909,165 @@ void FuseChannel::sendReply(
   sendRawReply(vec.data(), vec.size());
 }
 
+void FuseChannel::sendReply(
+    const fuse_in_header& request,
+    const FileRange& range) const {
+  fuse_out_header out;
+  out.unique = request.unique;
+  out.error = 0;
+
+  if (trySendSplicedReply(out, nullptr, &range)) {
+    return;
+  }
+
+  auto buf = folly::IOBuf::create(range.size);
+  auto res =
+      folly::preadNoInt(range.fd, buf->writableData(), range.size, range.offset);
+  if (res < 0) {
+    throwSystemError("error reading file range for FUSE reply");
+  }
+  buf->append(res);
+  sendReply(request, *buf);
+}
+
+bool FuseChannel::trySendSplicedReply(
+    fuse_out_header& out,
+    const folly::IOBuf* buf,
+    const FileRange* range) const {
+#ifdef __linux__
+  auto* pipe = getSplicePipe();
+  if (!pipe) {
+    return false;
+  }
+
+  // The header goes in the pipe first, so the length of the payload must be
+  // known up front. Cut file ranges short at the end of the file.
+  size_t payloadLength;
+  if (buf) {
+    payloadLength = buf->computeChainDataLength();
+  } else {
+    struct stat st;
+    if (fstat(range->fd, &st) != 0) {
+      return false;
+    }
+    auto available = st.st_size > range->offset
+        ? static_cast<size_t>(st.st_size - range->offset)
+        : size_t{0};
+    payloadLength = std::min(range->size, available);
+  }
+  if (sizeof(out) + payloadLength > pipe->capacity) {
+    return false;
+  }
+  out.len = sizeof(out) + payloadLength;
+
+  // If anything goes wrong, the pipe may hold part of this reply, so it is
+  // replaced before the next one.
+  auto discardPipe = folly::makeGuard([] { currentSplicePipe.reset(); });
+
+  if (folly::writeFull(pipe->writeEnd.fd(), &out, sizeof(out)) !=
+      sizeof(out)) {
+    return false;
+  }
+
+  size_t queued = 0;
+  if (buf) {
+    // The IOBuf outlives the splice to the FUSE device below, which is when
+    // the kernel is done with its pages.
+    folly::fbvector<iovec> vec;
+    vec.reserve(buf->countChainElements());
+    buf->appendToIov(&vec);
+    size_t index = 0;
+    while (index < vec.size()) {
+      auto count = std::min<size_t>(vec.size() - index, IOV_MAX);
+      auto res = vmsplice(pipe->writeEnd.fd(), &vec[index], count, 0);
+      if (res < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      queued += res;
+      // Skip the iovecs that were spliced completely and trim the next one.
+      while (res > 0 && index < vec.size()) {
+        auto used = std::min<size_t>(res, vec[index].iov_len);
+        vec[index].iov_base = static_cast<char*>(vec[index].iov_base) + used;
+        vec[index].iov_len -= used;
+        res -= used;
+        if (vec[index].iov_len == 0) {
+          ++index;
+        }
+      }
+    }
+  } else {
+    loff_t offset = range->offset;
+    while (queued < payloadLength) {
+      auto res = splice(
+          range->fd,
+          &offset,
+          pipe->writeEnd.fd(),
+          nullptr,
+          payloadLength - queued,
+          SPLICE_F_MOVE);
+      if (res < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      if (res == 0) {
+        // The file was truncated since fstat(). Readers racing with a
+        // truncate may see zeros.
+        static const std::array<char, 4096> zeros{};
+        auto padding = std::min(payloadLength - queued, zeros.size());
+        if (folly::writeFull(pipe->writeEnd.fd(), zeros.data(), padding) < 0) {
+          return false;
+        }
+        res = padding;
+      }
+      queued += res;
+    }
+  }
+  XDCHECK_EQ(queued, payloadLength);
+
+  // From here on, the reply can not be sent some other way.
+  ssize_t res;
+  do {
+    res = splice(
+        pipe->readEnd.fd(),
+        nullptr,
+        getReplyDevice(),
+        nullptr,
+        out.len,
+        SPLICE_F_MOVE);
+  } while (res < 0 && errno == EINTR);
+  const int err = errno;
+  XLOG(DBG7) << "trySendSplicedReply: unique=" << out.unique
+             << " out.len=" << out.len << " wrote=" << res;
+  if (res < 0) {
+    if (err == ENOENT) {
+      // Interrupted by a signal.  We don't need to log this,
+      // but will propagate it back to our caller.
+    } else if (!isFuseDeviceValid(state_.rlock()->stopReason)) {
+      XLOG(INFO) << "error splicing to fuse device: session closed";
+    } else {
+      XLOG(WARNING) << "error splicing to fuse device: "
+                    << folly::errnoStr(err);
+    }
+    throwSystemErrorExplicit(err, "error splicing to fuse device");
+  }
+  if (static_cast<size_t>(res) != out.len) {
+    throw std::runtime_error("unexpected short splice to FUSE device");
+  }
+  discardPipe.dismiss();
+  return true;
+#else
+  (void)out;
+  (void)buf;
+  (void)range;
+  return false;
+#endif
+}
+
 void FuseChannel::sendReply(
     const fuse_in_header& request,
     folly::ByteRange bytes) const {
@@ -780,7 +1093,7 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
     header->len += iov[i].iov_len;
   }
 
-  const auto res = writev(fuseDevice_.fd(), iov, count);
+  const auto res = writev(getReplyDevice(), iov, count);
   const int err = errno;
   XLOG(DBG7) << "sendRawReply: unique=" << header->unique
              << " header->len=" << header->len << " wrote=" << res;
@@ -810,8 +1123,15 @@ FuseChannel::FuseChannel(
     std::shared_ptr<Notifier> notifier,
     CaseSensitivity caseSensitive,
     bool requireUtf8Path,
-    int32_t maximumBackgroundRequests)
-    : bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
+    int32_t maximumBackgroundRequests,
+    bool cloneDevicePerThread,
+    bool pinWorkerThreads,
+    size_t spliceReadThreshold,
+    bool useReaddirplus,
+    size_t numInvalidationThreads,
+    bool useWritebackCache,
+    size_t maxWrite)
+    : maxWrite_{std::clamp(maxWrite, kMinMaxWrite, kMaxMaxWrite)},
       numThreads_(numThreads),
       dispatcher_(std::move(dispatcher)),
       straceLogger_(straceLogger),
@@ -821,6 +1141,12 @@ FuseChannel::FuseChannel(
       caseSensitive_{caseSensitive},
       requireUtf8Path_{requireUtf8Path},
       maximumBackgroundRequests_{maximumBackgroundRequests},
+      cloneDevicePerThread_{cloneDevicePerThread},
+      pinWorkerThreads_{pinWorkerThreads},
+      spliceReadThreshold_{spliceReadThreshold},
+      useReaddirplus_{useReaddirplus},
+      numInvalidationThreads_{std::max<size_t>(numInvalidationThreads, 1)},
+      useWritebackCache_{useWritebackCache},
       fuseDevice_(std::move(fuseDevice)),
       processAccessLog_(std::move(processNameCache)),
       traceDetailedArguments_(std::make_shared<std::atomic<size_t>>(0)),
@@ -915,12 +1241,32 @@ void FuseChannel::startWorkerThreads() {
   }
 
   try {
+    if (cloneDevicePerThread_ && workerDevices_.empty()) {
+      try {
+        workerDevices_.reserve(numThreads_ - 1);
+        while (workerDevices_.size() < numThreads_ - 1) {
+          workerDevices_.push_back(cloneFuseDevice());
+        }
+      } catch (const std::exception& ex) {
+        // Fall back to sharing fuseDevice_ between all worker threads.
+        XLOG(WARN) << "Unable to clone the FUSE device for " << mountPath_
+                   << ", sharing it between worker threads: "
+                   << exceptionStr(ex);
+        workerDevices_.clear();
+      }
+    }
+
     state->workerThreads.reserve(numThreads_);
     while (state->workerThreads.size() < numThreads_) {
-      state->workerThreads.emplace_back([this] { fuseWorkerThread(); });
+      auto workerIndex = state->workerThreads.size();
+      state->workerThreads.emplace_back(
+          [this, workerIndex] { fuseWorkerThread(workerIndex); });
     }
 
-    invalidationThread_ = std::thread([this] { invalidationThread(); });
+    invalidationThreads_.reserve(numInvalidationThreads_);
+    while (invalidationThreads_.size() < numInvalidationThreads_) {
+      invalidationThreads_.emplace_back([this] { invalidationThread(); });
+    }
   } catch (const std::exception& ex) {
     XLOG(ERR) << "Error starting FUSE worker threads: " << exceptionStr(ex);
     // Request any threads we did start to stop now.
@@ -930,6 +1276,57 @@ void FuseChannel::startWorkerThreads() {
   }
 }
 
+folly::File FuseChannel::cloneFuseDevice() const {
+#ifdef __linux__
+  folly::File clone{"/dev/fuse", O_RDWR | O_CLOEXEC};
+  uint32_t sessionFd = fuseDevice_.fd();
+  folly::checkUnixError(
+      ioctl(clone.fd(), FUSE_DEV_IOC_CLONE, &sessionFd),
+      "FUSE_DEV_IOC_CLONE failed");
+  return clone;
+#else
+  throw std::runtime_error(
+      "cloning the FUSE device is only supported on Linux");
+#endif
+}
+
+void FuseChannel::pinWorkerThread(size_t workerIndex) const {
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    XLOG(WARN) << "sched_getaffinity failed: " << folly::errnoStr(errno);
+    return;
+  }
+  auto cpuCount = static_cast<size_t>(CPU_COUNT(&allowed));
+  if (cpuCount == 0) {
+    return;
+  }
+
+  // Pick the (workerIndex % cpuCount)th CPU this process may run on.
+  auto remaining = workerIndex % cpuCount;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &allowed)) {
+      continue;
+    }
+    if (remaining-- == 0) {
+      cpu_set_t pinned;
+      CPU_ZERO(&pinned);
+      CPU_SET(cpu, &pinned);
+      auto err =
+          pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+      if (err != 0) {
+        XLOG(WARN) << "Unable to pin FUSE worker thread " << workerIndex
+                   << " to CPU " << cpu << ": " << folly::errnoStr(err);
+      }
+      return;
+    }
+  }
+#else
+  (void)workerIndex;
+#endif
+}
+
 void FuseChannel::destroy() {
   std::vector<std::thread> threads;
   {
@@ -964,56 +1361,128 @@ void FuseChannel::destroy() {
 }
 
 void FuseChannel::invalidateInode(InodeNumber ino, off_t off, off_t len) {
-  // Add the entry to invalidationQueue_ and wake up the invalidation thread to
+  // Add the entry to invalidationQueue_ and wake up an invalidation thread to
   // send it.
-  invalidationQueue_.lock()->queue.emplace_back(ino, off, len);
+  {
+    auto queue = invalidationQueue_.lock();
+    queueInvalidation(queue, InvalidationEntry{ino, off, len});
+  }
   invalidationCV_.notify_one();
 }
 
 void FuseChannel::invalidateEntry(InodeNumber parent, PathComponentPiece name) {
-  // Add the entry to invalidationQueue_ and wake up the invalidation thread to
+  // Add the entry to invalidationQueue_ and wake up an invalidation thread to
   // send it.
-  invalidationQueue_.lock()->queue.emplace_back(parent, name);
+  {
+    auto queue = invalidationQueue_.lock();
+    queueInvalidation(queue, InvalidationEntry{parent, name});
+  }
   invalidationCV_.notify_one();
 }
 
 void FuseChannel::invalidateInodes(folly::Range<InodeNumber*> range) {
   {
     auto queue = invalidationQueue_.lock();
-    std::transform(
-        range.begin(),
-        range.end(),
-        std::back_insert_iterator(queue->queue),
-        [](const auto& inodeNum) { return InvalidationEntry(inodeNum, 0, 0); });
+    for (auto inodeNum : range) {
+      queueInvalidation(queue, InvalidationEntry{inodeNum, 0, 0});
+    }
   }
   if (range.begin() != range.end()) {
-    invalidationCV_.notify_one();
+    invalidationCV_.notify_all();
   }
 }
+
+void FuseChannel::queueInvalidation(
+    folly::Synchronized<InvalidationQueue, std::mutex>::LockedPtr& queue,
+    InvalidationEntry&& entry) {
+  // Drop entries that are already queued. Invalidating all of an inode's
+  // data (offset 0, length 0) also invalidates its attributes and any
+  // range of it, so it covers every other INODE entry for that inode.
+  if (entry.type == InvalidationType::INODE) {
+    if (queue->queuedInodes.count(
+            std::make_tuple(entry.inode.get(), int64_t{0}, int64_t{0})) ||
+        !queue->queuedInodes
+             .emplace(
+                 entry.inode.get(), entry.range.offset, entry.range.length)
+             .second) {
+      XLOG(DBG7) << "dropping duplicate invalidation request: " << entry;
+      return;
+    }
+  } else if (!queue->queuedEntries
+                  .emplace(entry.inode.get(), entry.name.stringPiece().str())
+                  .second) {
+    XLOG(DBG7) << "dropping duplicate invalidation request: " << entry;
+    return;
+  }
+
+  entry.sequence = queue->nextSequence++;
+  if (isRecentlyAccessedDirectory(entry.inode)) {
+    queue->urgent.push_back(std::move(entry));
+  } else {
+    queue->background.push_back(std::move(entry));
+  }
+}
+
+uint64_t FuseChannel::InvalidationQueue::urgentSentWatermark() const {
+  auto watermark = nextSequence;
+  if (!urgent.empty()) {
+    watermark = std::min(watermark, urgent.front().sequence);
+  }
+  if (!urgentInFlight.empty()) {
+    watermark = std::min(watermark, *urgentInFlight.begin());
+  }
+  return watermark;
+}
+
+uint64_t FuseChannel::InvalidationQueue::sentWatermark() const {
+  auto watermark = urgentSentWatermark();
+  if (!background.empty()) {
+    watermark = std::min(watermark, background.front().sequence);
+  }
+  if (!backgroundInFlight.empty()) {
+    watermark = std::min(watermark, *backgroundInFlight.begin());
+  }
+  return watermark;
+}
+
 folly::Future<folly::Unit> FuseChannel::flushInvalidations() {
-  // Add a promise to the invalidation queue, which the invalidation thread
-  // will fulfill once it reaches that element in the queue.
+  return queueFlush(/*urgentOnly=*/false);
+}
+
+folly::Future<folly::Unit> FuseChannel::flushUrgentInvalidations() {
+  return queueFlush(/*urgentOnly=*/true);
+}
+
+folly::Future<folly::Unit> FuseChannel::queueFlush(bool urgentOnly) {
+  // Queue a promise that an invalidation thread will fulfill once every entry
+  // queued before it has been sent.
   Promise<Unit> promise;
   auto result = promise.getFuture();
   {
     auto state = invalidationQueue_.lock();
     if (state->stop) {
       // In the case of a concurrent unmount with a checkout, the unmount could
-      // win the race and thus have shutdown the invalidation thread. This is
+      // win the race and thus have shutdown the invalidation threads. This is
       // not an issue as the mount is gone at this point, let's thus return
       // immediately.
       return folly::unit;
     }
-    state->queue.emplace_back(std::move(promise));
+    auto watermark =
+        urgentOnly ? state->urgentSentWatermark() : state->sentWatermark();
+    if (watermark == state->nextSequence) {
+      // Nothing to wait for.
+      return folly::unit;
+    }
+    auto& flushes = urgentOnly ? state->urgentFlushes : state->flushes;
+    flushes.push_back(PendingFlush{state->nextSequence, std::move(promise)});
   }
-  invalidationCV_.notify_one();
   return result;
 }
 
 /**
  * Send an element from the invalidation queue.
  *
- * This method always runs in the invalidation thread.
+ * This method always runs in an invalidation thread.
  */
 void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
   // We catch any exceptions that occur and simply log an error message.
@@ -1028,11 +1497,6 @@ void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
       case InvalidationType::DIR_ENTRY:
         sendInvalidateEntry(entry.inode, entry.name);
         return;
-      case InvalidationType::FLUSH:
-        // Fulfill the promise to indicate that all previous entries in the
-        // invalidation queue have been completed.
-        entry.promise.setValue();
-        return;
     }
     EDEN_BUG() << "unknown invalidation entry type "
                << static_cast<uint64_t>(entry.type);
@@ -1056,7 +1520,7 @@ void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
 /**
  * Send a FUSE_NOTIFY_INVAL_INODE message to the kernel.
  *
- * This method always runs in the invalidation thread.
+ * This method always runs in an invalidation thread.
  */
 void FuseChannel::sendInvalidateInode(
     InodeNumber ino,
@@ -1103,7 +1567,7 @@ void FuseChannel::sendInvalidateInode(
 /**
  * Send a FUSE_NOTIFY_INVAL_ENTRY message to the kernel.
  *
- * This method always runs in the invalidation thread.
+ * This method always runs in an invalidation thread.
  */
 void FuseChannel::sendInvalidateEntry(
     InodeNumber parent,
@@ -1255,15 +1719,25 @@ void FuseChannel::initWorkerThread() noexcept {
   initPromise_.setValue(sessionCompletePromise_.getSemiFuture());
 
   // Continue to run like a normal FUSE worker thread.
-  fuseWorkerThread();
+  fuseWorkerThread(0);
 }
 
-void FuseChannel::fuseWorkerThread() noexcept {
+void FuseChannel::fuseWorkerThread(size_t workerIndex) noexcept {
   disablePthreadCancellation();
   setThreadName(to<std::string>("fuse", mountPath_.basename()));
   setThreadSigmask();
   *(liveRequestWatches_.get()) =
       std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
+  if (pinWorkerThreads_) {
+    pinWorkerThread(workerIndex);
+  }
+
+  // Worker 0 reads the INIT request, so it always uses fuseDevice_.
+  int device = fuseDevice_.fd();
+  if (workerIndex != 0 && workerIndex <= workerDevices_.size()) {
+    device = workerDevices_[workerIndex - 1].fd();
+  }
+  ReplyDeviceScope replyDevice{this, device};
 
   try {
     processSession();
@@ -1313,38 +1787,90 @@ void FuseChannel::invalidationThread() noexcept {
   // currently owns the rename lock, and will generate invalidation requests.
   // We need to make sure the checkout operation does not block waiting on the
   // invalidation requests to complete, since otherwise this would deadlock.
+  //
+  // Several threads share the queue, each taking a batch of entries at a
+  // time. Entries for recently accessed directories are always taken first.
+  constexpr size_t kMaxBatchSize = 64;
+  std::vector<InvalidationEntry> entries;
+  entries.reserve(kMaxBatchSize);
   while (true) {
     // Wait for entries to process
-    std::vector<InvalidationEntry> entries;
+    bool urgent;
     {
       auto lockedQueue = invalidationQueue_.lock();
-      while (lockedQueue->queue.empty()) {
+      while (lockedQueue->urgent.empty() && lockedQueue->background.empty()) {
         if (lockedQueue->stop) {
           return;
         }
         invalidationCV_.wait(lockedQueue.as_lock());
       }
-      lockedQueue->queue.swap(entries);
+      urgent = !lockedQueue->urgent.empty();
+      auto& queue = urgent ? lockedQueue->urgent : lockedQueue->background;
+      auto& inFlight = urgent ? lockedQueue->urgentInFlight
+                              : lockedQueue->backgroundInFlight;
+      inFlight.insert(queue.front().sequence);
+      while (!queue.empty() && entries.size() < kMaxBatchSize) {
+        auto& entry = queue.front();
+        if (entry.type == InvalidationType::INODE) {
+          lockedQueue->queuedInodes.erase(std::make_tuple(
+              entry.inode.get(), entry.range.offset, entry.range.length));
+        } else {
+          lockedQueue->queuedEntries.erase(std::make_pair(
+              entry.inode.get(), entry.name.stringPiece().str()));
+        }
+        entries.push_back(std::move(entry));
+        queue.pop_front();
+      }
+      if (!lockedQueue->urgent.empty() || !lockedQueue->background.empty()) {
+        // Let another thread work on the rest in parallel.
+        invalidationCV_.notify_one();
+      }
     }
 
     // Process all of the entries we found
     for (auto& entry : entries) {
       sendInvalidation(entry);
     }
+
+    // Complete the flushes that no longer wait on any entry.
+    std::vector<Promise<Unit>> completed;
+    {
+      auto lockedQueue = invalidationQueue_.lock();
+      auto& inFlight = urgent ? lockedQueue->urgentInFlight
+                              : lockedQueue->backgroundInFlight;
+      inFlight.erase(inFlight.find(entries.front().sequence));
+
+      auto completeFlushes = [&](std::deque<PendingFlush>& flushes,
+                                 uint64_t watermark) {
+        while (!flushes.empty() && flushes.front().sequence <= watermark) {
+          completed.push_back(std::move(flushes.front().promise));
+          flushes.pop_front();
+        }
+      };
+      completeFlushes(
+          lockedQueue->urgentFlushes, lockedQueue->urgentSentWatermark());
+      completeFlushes(lockedQueue->flushes, lockedQueue->sentWatermark());
+    }
+    for (auto& promise : completed) {
+      promise.setValue();
+    }
     entries.clear();
   }
 }
 
 void FuseChannel::stopInvalidationThread() {
-  // Check that the thread is joinable just in case we were destroyed
-  // before the invalidation thread was started.
-  if (!invalidationThread_.joinable()) {
+  // invalidationThreads_ is empty if we were destroyed before the
+  // invalidation threads were started.
+  if (invalidationThreads_.empty()) {
     return;
   }
 
   invalidationQueue_.lock()->stop = true;
-  invalidationCV_.notify_one();
-  invalidationThread_.join();
+  invalidationCV_.notify_all();
+  for (auto& thread : invalidationThreads_) {
+    thread.join();
+  }
+  invalidationThreads_.clear();
 }
 
 void FuseChannel::readInitPacket() {
@@ -1427,7 +1953,7 @@ void FuseChannel::readInitPacket() {
   fuse_init_out connInfo = {};
   connInfo.major = init.init.major;
   connInfo.minor = init.init.minor;
-  connInfo.max_write = bufferSize_ - 4096;
+  connInfo.max_write = maxWrite_;
   connInfo.max_readahead = init.init.max_readahead;
 
   int32_t max_background = maximumBackgroundRequests_;
@@ -1447,9 +1973,10 @@ void FuseChannel::readInitPacket() {
   const auto capable = init.init.flags;
   auto& want = connInfo.flags;
 
-  // TODO: follow up and look at the new flags; particularly
-  // FUSE_DO_READDIRPLUS, FUSE_READDIRPLUS_AUTO. FUSE_SPLICE_XXX are interesting
-  // too, but may not directly benefit eden today.
+  // TODO: follow up and look at the new flags. FUSE_SPLICE_READ would let us
+  // splice incoming writes into the overlay, but requests would then have to
+  // be read through a pipe, which costs an extra syscall for every other
+  // request.
   //
   // FUSE_ATOMIC_O_TRUNC is a nice optimization when the kernel supports it
   // and the FUSE daemon requires handling open/release for stateful file
@@ -1473,6 +2000,27 @@ void FuseChannel::readInitPacket() {
   want |= FUSE_CACHE_SYMLINKS;
   // We can handle almost any request in parallel.
   want |= FUSE_PARALLEL_DIROPS;
+  if (spliceReadThreshold_ != 0) {
+    // Large read replies are spliced, and the kernel may steal their pages.
+    want |= FUSE_SPLICE_WRITE | FUSE_SPLICE_MOVE;
+  }
+  if (useReaddirplus_) {
+    // Let the kernel choose between READDIR and READDIRPLUS, depending on
+    // whether the entries of a directory are looked up after listing it.
+    want |= FUSE_DO_READDIRPLUS | FUSE_READDIRPLUS_AUTO;
+  }
+  if (useWritebackCache_) {
+    // Let the kernel buffer writes in its page cache and send them to us in
+    // page-sized batches. The kernel then maintains the size, mtime and ctime
+    // of cached files, and sends mtime and ctime back with SETATTR.
+    want |= FUSE_WRITEBACK_CACHE;
+  }
+  // Without FUSE_MAX_PAGES, the kernel splits requests into chunks of at
+  // most 32 pages regardless of max_write.
+  want |= FUSE_MAX_PAGES;
+  const size_t pageSize = getpagesize();
+  connInfo.max_pages =
+      static_cast<uint16_t>((maxWrite_ + pageSize - 1) / pageSize);
 #endif
 #ifdef FUSE_NO_OPEN_SUPPORT
   // File handles are stateless so the kernel does not need to send open() and
@@ -1552,7 +2100,11 @@ void FuseChannel::readInitPacket() {
 }
 
 void FuseChannel::processSession() {
-  std::vector<char> buf(bufferSize_);
+  // The kernel refuses to read requests into buffers that could not hold a
+  // write of max_write bytes. max_write may differ from maxWrite_ after a
+  // graceful restart, so size the buffer from the negotiated value.
+  RequestBuffer buf{std::max(
+      size_t{connInfo_->max_write} + kRequestHeaderSize, MIN_BUFSIZE)};
   // Save this for the sanity check later in the loop to avoid
   // additional syscalls on each loop iteration.
   auto myPid = getpid();
@@ -1560,7 +2112,7 @@ void FuseChannel::processSession() {
   while (!stop_.load(std::memory_order_relaxed)) {
     // TODO: FUSE_SPLICE_READ allows using splice(2) here if we enable it.
     // We can look at turning this on once the main plumbing is complete.
-    auto res = read(fuseDevice_.fd(), buf.data(), buf.size());
+    auto res = read(getReplyDevice(), buf.data(), buf.size());
     if (UNLIKELY(res < 0)) {
       int error = errno;
       if (stop_.load(std::memory_order_relaxed)) {
@@ -1709,11 +2261,20 @@ void FuseChannel::processSession() {
 
       case FUSE_INTERRUPT: {
         // no reply is required
-        XLOG(DBG7) << "FUSE_INTERRUPT";
-        // Ignore it: we don't have a reliable way to guarantee
-        // that interrupting functions correctly.
-        // In addition, the kernel (certainly on macOS) may recycle
-        // ids too quickly for us to safely track by `unique` id.
+        const auto* interrupt =
+            reinterpret_cast<const fuse_interrupt_in*>(arg.data());
+        XLOG(DBG7) << "FUSE_INTERRUPT(" << interrupt->unique << ")";
+        // The request keeps running, but the fetches it started stop
+        // holding up the import queue once no one else is waiting on them.
+        // An interrupt for a request that finished or wasn't read yet is
+        // ignored: the process only waits longer in that case. The kernel
+        // may recycle unique ids once a request was answered, so entries
+        // are removed by the request that added them.
+        auto inFlight = inFlightRequests_.rlock();
+        if (auto* request = folly::get_default(
+                *inFlight, interrupt->unique, nullptr)) {
+          request->interrupt();
+        }
         break;
       }
 
@@ -1757,9 +2318,10 @@ void FuseChannel::processSession() {
           // in both. I'm sure this could be improved with some cleverness.
           auto request =
               RequestContext::makeSharedRequestContext<FuseRequestContext>(
-                  this, *header);
+                  this, *header, requestId);
 
           ++state_.wlock()->pendingRequests;
+          (*inFlightRequests_.wlock())[header->unique] = request.get();
 
           auto headerCopy = *header;
 
@@ -1782,9 +2344,33 @@ void FuseChannel::processSession() {
                     request->startRequest(
                         dispatcher_->getStats(),
                         handlerEntry->stat,
+                        handlerEntry->name,
                         *(liveRequestWatches_.get()));
-                    return (this->*handlerEntry->handler)(
-                               *request, request->getReq(), arg)
+                    auto handler = handlerEntry->handler;
+                    auto initialized = dispatcher_->ensureInitialized();
+                    if (initialized.isReady()) {
+                      return std::move(initialized)
+                          .thenValue([&](auto&&) {
+                            return (this->*handler)(
+                                *request, request->getReq(), arg);
+                          })
+                          .semi()
+                          .via(&folly::QueuedImmediateExecutor::instance());
+                    }
+                    // The argument points into the buffer the next request
+                    // is read into, so copy it while the dispatcher
+                    // finishes initializing.
+                    auto argCopy = folly::StringPiece{arg}.str();
+                    return std::move(initialized)
+                        .thenValue([this,
+                                    request,
+                                    handler,
+                                    argCopy = std::move(argCopy)](auto&&) {
+                          return (this->*handler)(
+                              *request,
+                              request->getReq(),
+                              folly::ByteRange{folly::StringPiece{argCopy}});
+                        })
                         .semi()
                         .via(&folly::QueuedImmediateExecutor::instance());
                   }).ensure([request] {
@@ -1794,6 +2380,14 @@ void FuseChannel::processSession() {
                 traceBus_->publish(FuseTraceEvent::finish(
                     requestId, headerCopy, request->getResult()));
 
+                {
+                  auto inFlight = inFlightRequests_.wlock();
+                  auto it = inFlight->find(headerCopy.unique);
+                  if (it != inFlight->end() && it->second == request.get()) {
+                    inFlight->erase(it);
+                  }
+                }
+
                 // We may be complete; check to see if all requests are
                 // done and whether there are any threads remaining.
                 auto state = state_.wlock();
@@ -1875,6 +2469,16 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseRead(
   XLOG(DBG7) << "FUSE_READ";
 
   auto ino = InodeNumber{header.nodeid};
+  if (spliceReadThreshold_ != 0 && read->size >= spliceReadThreshold_) {
+    return dispatcher_->readSpliceable(ino, read->size, read->offset, request)
+        .thenValue([&request](std::variant<BufVec, FileRange>&& data) {
+          if (auto* range = std::get_if<FileRange>(&data)) {
+            request.sendReply(*range);
+          } else {
+            request.sendReply(*std::get<BufVec>(data));
+          }
+        });
+  }
   return dispatcher_->read(ino, read->size, read->offset, request)
       .thenValue([&request](BufVec&& buf) { request.sendReply(*buf); });
 }
@@ -1925,6 +2529,7 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseLookup(
   const auto parent = InodeNumber{header.nodeid};
 
   XLOG(DBG7) << "FUSE_LOOKUP parent=" << parent << " name=" << name;
+  noteDirectoryAccess(header.nodeid);
 
   return dispatcher_->lookup(header.unique, parent, name, request)
       .thenValue([&request](fuse_entry_out entry) {
@@ -2306,6 +2911,7 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseOpenDir(
     ByteRange arg) {
   const auto open = reinterpret_cast<const fuse_open_in*>(arg.data());
   XLOG(DBG7) << "FUSE_OPENDIR";
+  noteDirectoryAccess(header.nodeid);
   auto ino = InodeNumber{header.nodeid};
   auto minorVersion = connInfo_->minor;
   return dispatcher_->opendir(ino, open->flags)
@@ -2330,6 +2936,7 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseReadDir(
     ByteRange arg) {
   auto read = reinterpret_cast<const fuse_read_in*>(arg.data());
   XLOG(DBG7) << "FUSE_READDIR";
+  noteDirectoryAccess(header.nodeid);
   auto ino = InodeNumber{header.nodeid};
   return dispatcher_
       ->readdir(ino, FuseDirList{read->size}, read->offset, read->fh, request)
@@ -2339,6 +2946,27 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseReadDir(
       });
 }
 
+ImmediateFuture<folly::Unit> FuseChannel::fuseReadDirPlus(
+    FuseRequestContext& request,
+    const fuse_in_header& header,
+    ByteRange arg) {
+  auto read = reinterpret_cast<const fuse_read_in*>(arg.data());
+  XLOG(DBG7) << "FUSE_READDIRPLUS";
+  noteDirectoryAccess(header.nodeid);
+  auto ino = InodeNumber{header.nodeid};
+  return dispatcher_
+      ->readdirplus(
+          ino,
+          FuseDirList{read->size, /*plus=*/true},
+          read->offset,
+          read->fh,
+          request)
+      .thenValue([&request](FuseDirList&& list) {
+        const auto buf = list.getBuf();
+        request.sendReply(StringPiece{buf});
+      });
+}
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseReleaseDir(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -2427,13 +3055,9 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseBatchForget(
   const auto forgets =
       reinterpret_cast<const fuse_batch_forget_in*>(arg.data());
   auto item = reinterpret_cast<const fuse_forget_one*>(forgets + 1);
-  const auto end = item + forgets->count;
   XLOG(DBG7) << "FUSE_BATCH_FORGET";
 
-  while (item != end) {
-    dispatcher_->forget(InodeNumber{item->nodeid}, item->nlookup);
-    ++item;
-  }
+  dispatcher_->batchForget(folly::range(item, item + forgets->count));
   request.replyNone();
   return folly::unit;
 }
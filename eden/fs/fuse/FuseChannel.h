@@ -10,15 +10,20 @@
 #include <folly/File.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Set.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdlib.h>
 #include <sys/uio.h>
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <iosfwd>
 #include <memory>
 #include <optional>
+#include <set>
 #include <stdexcept>
 #include <thread>
 #include <unordered_map>
@@ -219,6 +224,29 @@ class FuseChannel {
    * The caller is expected to follow up with a call to the
    * initialize() method to perform the handshake with the
    * kernel and set up the thread pool.
+   *
+   * If cloneDevicePerThread is true, each worker thread but the first reads
+   * requests from its own clone of fuseDevice, so that the workers do not all
+   * contend for the same kernel queue. If pinWorkerThreads is true, the
+   * worker threads are pinned to distinct CPUs where possible. Both are only
+   * supported on Linux and ignored elsewhere.
+   *
+   * Read replies of at least spliceReadThreshold bytes are spliced to the
+   * FUSE device through a pipe rather than written to it, on Linux. Data of
+   * materialized files is then never copied through user space. 0 disables
+   * splicing.
+   *
+   * If useReaddirplus is true, the kernel is allowed to send READDIRPLUS
+   * requests, on Linux.
+   *
+   * numInvalidationThreads threads send cache invalidations to the kernel.
+   *
+   * If useWritebackCache is true, the kernel is asked to cache writes and
+   * send them in large batches (FUSE_WRITEBACK_CACHE), on Linux.
+   *
+   * maxWrite is the largest write, in bytes, the kernel may send in a single
+   * request. It is clamped to [4 KiB, 1 MiB]. On Linux, values above 128 KiB
+   * also require the kernel to support FUSE_MAX_PAGES.
    */
   FuseChannel(
       folly::File&& fuseDevice,
@@ -232,7 +260,14 @@ class FuseChannel {
       std::shared_ptr<Notifier> notifier,
       CaseSensitivity caseSensitive,
       bool requireUtf8Path,
-      int32_t maximumBackgroundRequests);
+      int32_t maximumBackgroundRequests,
+      bool cloneDevicePerThread,
+      bool pinWorkerThreads,
+      size_t spliceReadThreshold,
+      bool useReaddirplus,
+      size_t numInvalidationThreads,
+      bool useWritebackCache,
+      size_t maxWrite);
 
   /**
    * Destroy the FuseChannel.
@@ -348,11 +383,43 @@ class FuseChannel {
    *
    * The returned Future will complete once all invalidation operations
    * scheduled before this flushInvalidations() call have finished.  This
-   * future will normally be completed in the FuseChannel's invalidation
-   * thread.
+   * future will normally be completed in one of the FuseChannel's
+   * invalidation threads.
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> flushInvalidations();
 
+  /**
+   * Like flushInvalidations(), but only waits for the invalidations of
+   * directories that were recently accessed through this channel. The
+   * remaining invalidations keep being sent in the background.
+   */
+  FOLLY_NODISCARD folly::Future<folly::Unit> flushUrgentInvalidations();
+
+  /**
+   * The kernel only accepts the reply to a request on the FUSE device the
+   * request was read from, which may be the clone of a worker thread. While a
+   * ReplyDeviceScope exists, replies sent by this thread through `channel`
+   * are written to `fd`.
+   */
+  class ReplyDeviceScope {
+   public:
+    ReplyDeviceScope(const FuseChannel* channel, int fd);
+    ~ReplyDeviceScope();
+
+    ReplyDeviceScope(const ReplyDeviceScope&) = delete;
+    ReplyDeviceScope& operator=(const ReplyDeviceScope&) = delete;
+
+   private:
+    const FuseChannel* previousChannel_;
+    int previousFd_;
+  };
+
+  /**
+   * Returns the FUSE device that replies sent by this thread are written to.
+   * On a worker thread, this is the device it reads requests from.
+   */
+  int getReplyDevice() const;
+
   /**
    * Sends a reply to a kernel request that consists only of the error
    * status (no additional payload).
@@ -413,6 +480,15 @@ class FuseChannel {
    */
   void sendReply(const fuse_in_header& request, const folly::IOBuf& buf) const;
 
+  /**
+   * Sends the contents of a range of a file as a reply to a kernel request.
+   * If the file ends within the range, the reply is cut short there.
+   *
+   * throws system_error if the write fails.  Writes can fail if the
+   * data we send to the kernel is invalid.
+   */
+  void sendReply(const fuse_in_header& request, const FileRange& range) const;
+
   /**
    * Sends a reply to the kernel.
    * The payload parameter is typically a fuse_out_XXX struct as defined
@@ -518,26 +594,53 @@ class FuseChannel {
   enum class InvalidationType : uint32_t {
     INODE,
     DIR_ENTRY,
-    FLUSH,
   };
   struct InvalidationEntry {
     InvalidationEntry(InodeNumber inode, int64_t offset, int64_t length);
     InvalidationEntry(InodeNumber inode, PathComponentPiece name);
-    explicit InvalidationEntry(folly::Promise<folly::Unit> promise);
     InvalidationEntry(InvalidationEntry&& other) noexcept;
     ~InvalidationEntry();
 
     InvalidationType type;
     InodeNumber inode;
+    // Order in which the entry was queued, used to complete flushes.
+    uint64_t sequence{0};
     union {
       PathComponent name;
       DataRange range;
-      folly::Promise<folly::Unit> promise;
     };
   };
+  struct PendingFlush {
+    // The flush completes once every entry queued before it was sent.
+    uint64_t sequence;
+    folly::Promise<folly::Unit> promise;
+  };
   struct InvalidationQueue {
-    std::vector<InvalidationEntry> queue;
+    // Entries for recently accessed directories, sent before background.
+    std::deque<InvalidationEntry> urgent;
+    std::deque<InvalidationEntry> background;
+
+    // Every INODE and DIR_ENTRY entry in urgent and background, used to drop
+    // duplicates before they are queued.
+    folly::F14FastSet<std::tuple<uint64_t, int64_t, int64_t>> queuedInodes;
+    folly::F14FastSet<std::pair<uint64_t, std::string>> queuedEntries;
+
+    // Lowest sequence number of each batch currently being sent.
+    std::multiset<uint64_t> urgentInFlight;
+    std::multiset<uint64_t> backgroundInFlight;
+
+    std::deque<PendingFlush> flushes;
+    std::deque<PendingFlush> urgentFlushes;
+
+    uint64_t nextSequence{0};
     bool stop{false};
+
+    /**
+     * Sequence numbers below this have been sent, for the urgent entries
+     * only or for all of them.
+     */
+    uint64_t urgentSentWatermark() const;
+    uint64_t sentWatermark() const;
   };
   friend std::ostream& operator<<(
       std::ostream& os,
@@ -656,6 +759,10 @@ class FuseChannel {
       FuseRequestContext& request,
       const fuse_in_header& header,
       folly::ByteRange arg);
+  ImmediateFuture<folly::Unit> fuseReadDirPlus(
+      FuseRequestContext& request,
+      const fuse_in_header& header,
+      folly::ByteRange arg);
   ImmediateFuture<folly::Unit> fuseReleaseDir(
       FuseRequestContext& request,
       const fuse_in_header& header,
@@ -688,15 +795,54 @@ class FuseChannel {
  private:
   void setThreadSigmask();
   void initWorkerThread() noexcept;
-  void fuseWorkerThread() noexcept;
+  void fuseWorkerThread(size_t workerIndex) noexcept;
   void invalidationThread() noexcept;
   void stopInvalidationThread();
+  void queueInvalidation(
+      folly::Synchronized<InvalidationQueue, std::mutex>::LockedPtr& queue,
+      InvalidationEntry&& entry);
+  folly::Future<folly::Unit> queueFlush(bool urgentOnly);
   void sendInvalidation(InvalidationEntry& entry);
+
+  /**
+   * Remember that the kernel looked up or listed entries of the directory
+   * ino, so that invalidations for it are sent ahead of the others.
+   */
+  void noteDirectoryAccess(uint64_t ino) {
+    recentDirectories_[ino % recentDirectories_.size()].store(
+        ino, std::memory_order_relaxed);
+  }
+  bool isRecentlyAccessedDirectory(InodeNumber ino) const {
+    return recentDirectories_[ino.get() % recentDirectories_.size()].load(
+               std::memory_order_relaxed) == ino.get();
+  }
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
   void sendInvalidateEntry(InodeNumber parent, PathComponentPiece name);
   void readInitPacket();
   void startWorkerThreads();
 
+  /**
+   * Opens a new FUSE device attached to the same connection as fuseDevice_
+   * with FUSE_DEV_IOC_CLONE. Throws if the kernel does not support it.
+   */
+  folly::File cloneFuseDevice() const;
+
+  /** Pins the calling worker thread to a CPU picked by its index. */
+  void pinWorkerThread(size_t workerIndex) const;
+
+  /**
+   * Sends a reply whose payload is either `buf` or `range` through a pipe,
+   * using vmsplice(2) and splice(2). Returns false without sending anything
+   * if the reply could not be put in the pipe; the caller should then send it
+   * some other way.
+   *
+   * throws system_error if splicing the reply to the FUSE device fails.
+   */
+  bool trySendSplicedReply(
+      fuse_out_header& out,
+      const folly::IOBuf* buf,
+      const FileRange* range) const;
+
   /**
    * sessionComplete() will fulfill the sessionCompletePromise_.
    *
@@ -723,6 +869,9 @@ class FuseChannel {
    * This function blocks until the fuse session is stopped.
    * The intent is that this is called from each of the
    * fuse worker threads provided by the MountPoint.
+   *
+   * Requests are read from the FUSE device of the calling thread's
+   * ReplyDeviceScope.
    */
   void processSession();
 
@@ -737,7 +886,7 @@ class FuseChannel {
   /*
    * Constant state that does not change for the lifetime of the FuseChannel
    */
-  const size_t bufferSize_{0};
+  const size_t maxWrite_;
   const size_t numThreads_;
   std::unique_ptr<FuseDispatcher> dispatcher_;
   const folly::Logger* const straceLogger_;
@@ -747,6 +896,12 @@ class FuseChannel {
   CaseSensitivity caseSensitive_;
   bool requireUtf8Path_;
   int32_t maximumBackgroundRequests_;
+  const bool cloneDevicePerThread_;
+  const bool pinWorkerThreads_;
+  const size_t spliceReadThreshold_;
+  const bool useReaddirplus_;
+  const size_t numInvalidationThreads_;
+  const bool useWritebackCache_;
 
   /*
    * connInfo_ is modified during the initialization process,
@@ -772,6 +927,16 @@ class FuseChannel {
    */
   folly::File fuseDevice_;
 
+  /*
+   * The cloned FUSE devices of the worker threads, indexed by worker index
+   * minus one. Worker 0 also reads INIT and uses fuseDevice_.
+   *
+   * This is filled in before the worker threads are started and is constant
+   * while they run. The clones are only closed when the FuseChannel is
+   * destroyed, once all requests read from them have been answered.
+   */
+  std::vector<folly::File> workerDevices_;
+
   /*
    * Mutable state that is accessed from the worker threads.
    * All of this state uses locking or other synchronization.
@@ -787,11 +952,21 @@ class FuseChannel {
   // To prevent logging unsupported opcodes twice.
   folly::Synchronized<std::unordered_set<FuseOpcode>> unhandledOpcodes_;
 
+  // The requests being processed, by the kernel's unique id, so that
+  // FUSE_INTERRUPT can cancel the fetches they started. An entry is removed
+  // once its request finished, which keeps the pointer valid.
+  folly::Synchronized<std::unordered_map<uint64_t, FuseRequestContext*>>
+      inFlightRequests_;
+
   // State for sending inode invalidation requests to the kernel
-  // These are processed in their own dedicated thread.
+  // These are processed in their own dedicated threads.
   folly::Synchronized<InvalidationQueue, std::mutex> invalidationQueue_;
   std::condition_variable invalidationCV_;
-  std::thread invalidationThread_;
+  std::vector<std::thread> invalidationThreads_;
+
+  // A lossy set of the directories most recently accessed by the kernel,
+  // indexed by inode number.
+  std::array<std::atomic<uint64_t>, 1024> recentDirectories_{};
 
   ProcessAccessLog processAccessLog_;
 
@@ -63,6 +63,10 @@ void FuseDispatcher::initConnection(const fuse_init_out& out) {
 
 void FuseDispatcher::destroy() {}
 
+ImmediateFuture<folly::Unit> FuseDispatcher::ensureInitialized() {
+  return folly::unit;
+}
+
 ImmediateFuture<fuse_entry_out> FuseDispatcher::lookup(
     uint64_t /*requestID*/,
     InodeNumber /*parent*/,
@@ -73,6 +77,12 @@ ImmediateFuture<fuse_entry_out> FuseDispatcher::lookup(
 
 void FuseDispatcher::forget(InodeNumber /*ino*/, unsigned long /*nlookup*/) {}
 
+void FuseDispatcher::batchForget(folly::Range<const fuse_forget_one*> forgets) {
+  for (const auto& item : forgets) {
+    forget(InodeNumber{item.nodeid}, item.nlookup);
+  }
+}
+
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcher::getattr(
     InodeNumber /*ino*/,
     ObjectFetchContext& /*context*/) {
@@ -175,6 +185,16 @@ ImmediateFuture<BufVec> FuseDispatcher::read(
   FUSELL_NOT_IMPL();
 }
 
+ImmediateFuture<std::variant<BufVec, FileRange>> FuseDispatcher::readSpliceable(
+    InodeNumber ino,
+    size_t size,
+    off_t off,
+    ObjectFetchContext& context) {
+  return read(ino, size, off, context).thenValue([](BufVec&& buf) {
+    return std::variant<BufVec, FileRange>{std::move(buf)};
+  });
+}
+
 ImmediateFuture<size_t> FuseDispatcher::write(
     InodeNumber /*ino*/,
     StringPiece /*data*/,
@@ -212,6 +232,15 @@ ImmediateFuture<FuseDirList> FuseDispatcher::readdir(
   FUSELL_NOT_IMPL();
 }
 
+ImmediateFuture<FuseDirList> FuseDispatcher::readdirplus(
+    InodeNumber,
+    FuseDirList&&,
+    off_t,
+    uint64_t,
+    ObjectFetchContext&) {
+  FUSELL_NOT_IMPL();
+}
+
 ImmediateFuture<struct fuse_kstatfs> FuseDispatcher::statfs(
     InodeNumber /*ino*/) {
   struct fuse_kstatfs info = {};
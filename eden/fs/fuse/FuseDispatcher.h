@@ -10,6 +10,7 @@
 #include <folly/Portability.h>
 #include <folly/Range.h>
 #include <sys/statvfs.h>
+#include <variant>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/utils/BufVec.h"
@@ -53,6 +54,13 @@ class FuseDispatcher {
    */
   virtual void destroy();
 
+  /**
+   * Called before each request is dispatched. The request is only handled
+   * once the returned future completes, and fails if it fails. This lets
+   * the filesystem finish initializing after it was mounted.
+   */
+  virtual ImmediateFuture<folly::Unit> ensureInitialized();
+
   /**
    * Lookup a directory entry by name and get its attributes.
    *
@@ -85,6 +93,13 @@ class FuseDispatcher {
    */
   virtual void forget(InodeNumber ino, unsigned long nlookup);
 
+  /**
+   * Forget about many inodes at once, for FUSE_BATCH_FORGET.
+   *
+   * The default implementation calls forget() for each of them.
+   */
+  virtual void batchForget(folly::Range<const fuse_forget_one*> forgets);
+
   /**
    * The stat information and the cache TTL for the kernel
    *
@@ -302,6 +317,18 @@ class FuseDispatcher {
   virtual ImmediateFuture<BufVec>
   read(InodeNumber ino, size_t size, off_t off, ObjectFetchContext& context);
 
+  /**
+   * Like read, but may instead return the range of a local file holding the
+   * data, which the FuseChannel can splice to the kernel without copying it.
+   *
+   * The default implementation calls read().
+   */
+  virtual ImmediateFuture<std::variant<BufVec, FileRange>> readSpliceable(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      ObjectFetchContext& context);
+
   /**
    * Write data
    *
@@ -386,6 +413,21 @@ class FuseDispatcher {
       uint64_t fh,
       ObjectFetchContext& context);
 
+  /**
+   * Read directory, along with the attributes of its entries.
+   *
+   * Like readdir, but dirList is a READDIRPLUS list, whose fuse_entry_out
+   * should be filled in for the entries the kernel should take a reference
+   * to, as if they had been looked up. The fuse_entry_out of "." and ".."
+   * is ignored, and they take no reference.
+   */
+  virtual ImmediateFuture<FuseDirList> readdirplus(
+      InodeNumber ino,
+      FuseDirList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      ObjectFetchContext& context);
+
   /**
    * Get file system statistics
    *
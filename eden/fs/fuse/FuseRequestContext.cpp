@@ -21,10 +21,13 @@ namespace facebook::eden {
 
 FuseRequestContext::FuseRequestContext(
     FuseChannel* channel,
-    const fuse_in_header& fuseHeader)
+    const fuse_in_header& fuseHeader,
+    uint64_t requestId)
     : RequestContext(channel->getProcessAccessLog()),
       channel_(channel),
-      fuseHeader_(fuseHeader) {}
+      fuseHeader_(fuseHeader),
+      fuseDevice_(channel->getReplyDevice()),
+      requestId_(requestId) {}
 
 fuse_in_header FuseRequestContext::stealReqWithResult(int64_t result) {
   if (result_.has_value()) {
@@ -78,6 +81,7 @@ void FuseRequestContext::timeoutErrorHandler(
 
 void FuseRequestContext::replyError(int err) {
   XCHECK(err >= 0) << "errno values are positive";
+  FuseChannel::ReplyDeviceScope replyDevice{channel_, fuseDevice_};
   channel_->replyError(stealReqWithResult(-err), err);
 }
 
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/futures/Future.h>
 #include <atomic>
 #include <utility>
@@ -34,9 +35,14 @@ class FuseRequestContext : public RequestContext {
   FuseRequestContext& operator=(const FuseRequestContext&) = delete;
   FuseRequestContext(FuseRequestContext&&) = delete;
   FuseRequestContext& operator=(FuseRequestContext&&) = delete;
+  /**
+   * Must be constructed on the FUSE worker thread that read the request, so
+   * that replies go to the FUSE device it was read from.
+   */
   explicit FuseRequestContext(
       FuseChannel* channel,
-      const fuse_in_header& fuseHeader);
+      const fuse_in_header& fuseHeader,
+      uint64_t requestId);
 
   // Override of `ObjectFetchContext`
   std::optional<pid_t> getClientPid() const override {
@@ -48,6 +54,29 @@ class FuseRequestContext : public RequestContext {
     return fuseOpcodeName(fuseHeader_.opcode);
   }
 
+  // Override of `ObjectFetchContext`
+  std::optional<uint64_t> getRequestId() const override {
+    return requestId_;
+  }
+
+  // Override of `ObjectFetchContext`
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellation_.getToken();
+  }
+
+  // Override of `RequestContext`
+  std::optional<uint64_t> getRequestInode() const override {
+    return fuseHeader_.nodeid;
+  }
+
+  /**
+   * Called when the kernel sends FUSE_INTERRUPT for this request. Unlike the
+   * other member functions, this may be called from any thread at any time.
+   */
+  void interrupt() {
+    cancellation_.requestCancellation();
+  }
+
   /**
    * After sendReply or replyError, this returns the error code we returned to
    * the kernel, negated.
@@ -80,6 +109,9 @@ class FuseRequestContext : public RequestContext {
         } else if (
             auto* err = try_.tryGetExceptionObject<std::system_error>()) {
           systemErrorHandler(*err, notifier);
+        } else if (try_.tryGetExceptionObject<folly::OperationCancelled>()) {
+          // A fetch was dropped after the request was interrupted.
+          replyError(EINTR);
         } else if (auto* err = try_.tryGetExceptionObject<std::exception>()) {
           genericErrorHandler(*err, notifier);
         } else {
@@ -102,6 +134,7 @@ class FuseRequestContext : public RequestContext {
 
   template <typename... T>
   void sendReply(T&&... payload) {
+    FuseChannel::ReplyDeviceScope replyDevice{channel_, fuseDevice_};
     channel_->sendReply(stealReqWithResult(0), std::forward<T>(payload)...);
   }
 
@@ -112,6 +145,7 @@ class FuseRequestContext : public RequestContext {
    */
   template <typename T>
   void sendReplyWithInode(uint64_t nodeid, T&& reply) {
+    FuseChannel::ReplyDeviceScope replyDevice{channel_, fuseDevice_};
     channel_->sendReply(stealReqWithResult(nodeid), std::forward<T>(reply));
   }
 
@@ -128,6 +162,12 @@ class FuseRequestContext : public RequestContext {
 
   FuseChannel* channel_;
   const fuse_in_header fuseHeader_;
+  // The FUSE device the request was read from, which the reply must be
+  // written to.
+  const int fuseDevice_;
+  // Also the unique id of the FuseTraceEvents of this request.
+  const uint64_t requestId_;
+  folly::CancellationSource cancellation_;
 
   std::optional<int64_t> result_;
 };
@@ -33,6 +33,10 @@ using folly::exceptionStr;
 using std::string;
 
 DEFINE_int32(numFuseThreads, 4, "The number of FUSE worker threads");
+DEFINE_uint64(
+    maxWrite,
+    128 * 1024,
+    "The largest write the kernel may send in a single FUSE request");
 
 FOLLY_INIT_LOGGING_CONFIG("eden=DBG2,eden.fs.fuse=DBG7");
 
@@ -138,7 +142,14 @@ int main(int argc, char** argv) {
       /*notifications=*/nullptr,
       CaseSensitivity::Sensitive,
       /*requireUtf8Path=*/true,
-      /*maximumBackgroundRequests=*/12 /* the default on Linux */));
+      /*maximumBackgroundRequests=*/12 /* the default on Linux */,
+      /*cloneDevicePerThread=*/false,
+      /*pinWorkerThreads=*/false,
+      /*spliceReadThreshold=*/0,
+      /*useReaddirplus=*/false,
+      /*numInvalidationThreads=*/1,
+      /*useWritebackCache=*/false,
+      FLAGS_maxWrite));
 
   XLOG(INFO) << "Starting FUSE...";
   auto completionFuture = channel->initialize().get();
@@ -68,13 +68,22 @@ class PrivHelper {
       folly::StringPiece mountPath,
       bool readOnly) = 0;
 
+  /**
+   * Ask the privileged helper process to perform a NFS mount.
+   *
+   * The kernel caches the attributes of files and directories for
+   * fileAttrCacheTimeout and dirAttrCacheTimeout respectively before asking
+   * EdenFS for them again.
+   */
   FOLLY_NODISCARD virtual folly::Future<folly::Unit> nfsMount(
       folly::StringPiece mountPath,
       folly::SocketAddress mountdAddr,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus) = 0;
+      bool useReaddirplus,
+      std::chrono::seconds fileAttrCacheTimeout,
+      std::chrono::seconds dirAttrCacheTimeout) = 0;
 
   /**
    * Ask the privileged helper process to perform a fuse unmount.
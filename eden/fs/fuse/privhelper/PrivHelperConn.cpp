@@ -16,6 +16,7 @@
 #include <folly/FileUtil.h>
 #include <folly/ScopeGuard.h>
 #include <folly/SocketAddress.h>
+#include <folly/Utility.h>
 #include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
@@ -172,7 +173,9 @@ UnixSocket::Message PrivHelperConn::serializeMountNfsRequest(
     folly::SocketAddress nfsdAddr,
     bool readOnly,
     uint32_t iosize,
-    bool useReaddirplus) {
+    bool useReaddirplus,
+    std::chrono::seconds fileAttrCacheTimeout,
+    std::chrono::seconds dirAttrCacheTimeout) {
   auto msg = serializeHeader(xid, REQ_MOUNT_NFS);
   Appender appender(&msg.data, kDefaultBufferSize);
 
@@ -182,6 +185,8 @@ UnixSocket::Message PrivHelperConn::serializeMountNfsRequest(
   serializeBool(appender, readOnly);
   serializeUint32(appender, iosize);
   serializeBool(appender, useReaddirplus);
+  serializeUint32(appender, folly::to_narrow(fileAttrCacheTimeout.count()));
+  serializeUint32(appender, folly::to_narrow(dirAttrCacheTimeout.count()));
   return msg;
 }
 
@@ -192,13 +197,17 @@ void PrivHelperConn::parseMountNfsRequest(
     folly::SocketAddress& nfsdAddr,
     bool& readOnly,
     uint32_t& iosize,
-    bool& useReaddirplus) {
+    bool& useReaddirplus,
+    std::chrono::seconds& fileAttrCacheTimeout,
+    std::chrono::seconds& dirAttrCacheTimeout) {
   mountPoint = deserializeString(cursor);
   mountdAddr = deserializeSocketAddress(cursor);
   nfsdAddr = deserializeSocketAddress(cursor);
   readOnly = deserializeBool(cursor);
   iosize = deserializeUint32(cursor);
   useReaddirplus = deserializeBool(cursor);
+  fileAttrCacheTimeout = std::chrono::seconds{deserializeUint32(cursor)};
+  dirAttrCacheTimeout = std::chrono::seconds{deserializeUint32(cursor)};
   checkAtEnd(cursor, "mount nfs request");
 }
 
@@ -278,6 +287,46 @@ void PrivHelperConn::parseTakeoverStartupRequest(
   checkAtEnd(cursor, "takeover startup request");
 }
 
+UnixSocket::Message PrivHelperConn::serializeBatchRequest(
+    uint32_t xid,
+    const std::vector<UnixSocket::Message>& requests) {
+  auto msg = serializeHeader(xid, REQ_BATCH);
+  Appender appender(&msg.data, kDefaultBufferSize);
+
+  appender.writeBE<uint32_t>(requests.size());
+  for (const auto& request : requests) {
+    if (!request.files.empty()) {
+      throw std::invalid_argument(
+          "privhelper requests with file descriptors cannot be batched");
+    }
+    appender.writeBE<uint32_t>(request.data.computeChainDataLength());
+    for (auto range : request.data) {
+      appender.push(range);
+    }
+  }
+  return msg;
+}
+
+void PrivHelperConn::parseBatchRequest(
+    Cursor& cursor,
+    std::vector<IOBuf>& requests) {
+  auto n = cursor.readBE<uint32_t>();
+  while (n-- != 0) {
+    auto length = cursor.readBE<uint32_t>();
+    if (length < kHeaderSize) {
+      throw std::runtime_error(folly::to<string>(
+          "privhelper batch contains a truncated request of ",
+          length,
+          " bytes"));
+    }
+    IOBuf request{IOBuf::CREATE, length};
+    cursor.pull(request.writableData(), length);
+    request.append(length);
+    requests.push_back(std::move(request));
+  }
+  checkAtEnd(cursor, "batch request");
+}
+
 void PrivHelperConn::parseEmptyResponse(
     MsgType reqType,
     const UnixSocket::Message& msg) {
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <chrono>
 #include <cinttypes>
 #include <stdexcept>
 #include "eden/fs/utils/UnixSocket.h"
@@ -47,6 +48,7 @@ class PrivHelperConn {
     REQ_SET_USE_EDENFS = 10,
     REQ_MOUNT_NFS = 11,
     REQ_UNMOUNT_NFS = 12,
+    REQ_BATCH = 13,
   };
 
   /**
@@ -86,7 +88,9 @@ class PrivHelperConn {
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus);
+      bool useReaddirplus,
+      std::chrono::seconds fileAttrCacheTimeout,
+      std::chrono::seconds dirAttrCacheTimeout);
   static void parseMountNfsRequest(
       folly::io::Cursor& cursor,
       std::string& mountPoint,
@@ -94,7 +98,9 @@ class PrivHelperConn {
       folly::SocketAddress& nfsdAddr,
       bool& readOnly,
       uint32_t& iosize,
-      bool& useReaddirplus);
+      bool& useReaddirplus,
+      std::chrono::seconds& fileAttrCacheTimeout,
+      std::chrono::seconds& dirAttrCacheTimeout);
 
   static UnixSocket::Message serializeUnmountRequest(
       uint32_t xid,
@@ -161,6 +167,20 @@ class PrivHelperConn {
       folly::io::Cursor& cursor,
       bool& useEdenFs);
 
+  /**
+   * A batch carries several complete requests, header included, in a single
+   * message. The server sends the response to each request, with the
+   * request's own transaction ID, and then an empty response to the batch.
+   *
+   * Requests in a batch cannot carry file descriptors.
+   */
+  static UnixSocket::Message serializeBatchRequest(
+      uint32_t xid,
+      const std::vector<UnixSocket::Message>& requests);
+  static void parseBatchRequest(
+      folly::io::Cursor& cursor,
+      std::vector<folly::IOBuf>& requests);
+
   /**
    * Parse a response that is expected to be empty.
    *
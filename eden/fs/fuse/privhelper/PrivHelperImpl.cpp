@@ -69,7 +69,8 @@ namespace {
 class PrivHelperClientImpl : public PrivHelper,
                              private UnixSocket::ReceiveCallback,
                              private UnixSocket::SendCallback,
-                             private EventBase::OnDestructionCallback {
+                             private EventBase::OnDestructionCallback,
+                             private EventBase::LoopCallback {
  public:
   PrivHelperClientImpl(File&& conn, std::optional<SpawnedProcess> proc)
       : helperProc_(std::move(proc)),
@@ -110,7 +111,9 @@ class PrivHelperClientImpl : public PrivHelper,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus) override;
+      bool useReaddirplus,
+      std::chrono::seconds fileAttrCacheTimeout,
+      std::chrono::seconds dirAttrCacheTimeout) override;
   Future<Unit> fuseUnmount(StringPiece mountPath) override;
   Future<Unit> nfsUnmount(StringPiece mountPath) override;
   Future<Unit> bindMount(StringPiece clientPath, StringPiece mountPath)
@@ -173,6 +176,7 @@ class PrivHelperClientImpl : public PrivHelper,
     // If the state was still RUNNING detach from the EventBase.
     if (eventBase) {
       eventBase->runImmediatelyOrRunInEventBaseThreadAndWait([this] {
+        cancelLoopCallback();
         {
           auto state = state_.wlock();
           state->conn_->clearReceiveCallback();
@@ -222,6 +226,7 @@ class PrivHelperClientImpl : public PrivHelper,
     folly::Promise<UnixSocket::Message> promise;
     auto future = promise.getFuture();
     eventBase->runInEventBaseThread([this,
+                                     eventBase,
                                      xid,
                                      msg = std::move(msg),
                                      promise = std::move(promise)]() mutable {
@@ -235,15 +240,58 @@ class PrivHelperClientImpl : public PrivHelper,
         }
       }
       pendingRequests_.emplace(xid, std::move(promise));
-      ++sendPending_;
-      {
-        auto state = state_.wlock();
-        state->conn_->send(std::move(msg), this);
+      if (!msg.files.empty() || !batchRequests_) {
+        sendMessage(std::move(msg));
+        return;
+      }
+
+      // Requests made during the same loop iteration, typically by several
+      // mounts starting at once, are sent to the server in a single batch.
+      queuedRequests_.push_back(std::move(msg));
+      if (!isLoopCallbackScheduled()) {
+        eventBase->runInLoop(this);
       }
     });
     return future;
   }
 
+  void sendMessage(UnixSocket::Message&& msg) {
+    ++sendPending_;
+    auto state = state_.wlock();
+    state->conn_->send(std::move(msg), this);
+  }
+
+  void runLoopCallback() noexcept override {
+    try {
+      sendQueuedRequests();
+    } catch (const std::exception& ex) {
+      handleSocketError(std::runtime_error(folly::to<string>(
+          "error sending privhelper requests: ", folly::exceptionStr(ex))));
+    }
+  }
+
+  void sendQueuedRequests() {
+    auto requests = std::move(queuedRequests_);
+    queuedRequests_.clear();
+    if (requests.empty() || !state_.rlock()->conn_) {
+      // The socket was closed and the requests have already been failed.
+      return;
+    }
+
+    if (requests.size() == 1 || !batchRequests_) {
+      for (auto& request : requests) {
+        sendMessage(std::move(request));
+      }
+      return;
+    }
+
+    auto xid = getNextXid();
+    auto batch = PrivHelperConn::serializeBatchRequest(xid, requests);
+    // Keep the requests in case the server can't process batches.
+    pendingBatches_.emplace(xid, std::move(requests));
+    sendMessage(std::move(batch));
+  }
+
   void messageReceived(UnixSocket::Message&& message) noexcept override {
     try {
       processResponse(std::move(message));
@@ -257,6 +305,23 @@ class PrivHelperClientImpl : public PrivHelper,
     Cursor cursor(&message.data);
     auto xid = cursor.readBE<uint32_t>();
 
+    auto batchIter = pendingBatches_.find(xid);
+    if (batchIter != pendingBatches_.end()) {
+      // The responses to the batched requests were received already.
+      auto requests = std::move(batchIter->second);
+      pendingBatches_.erase(batchIter);
+      if (cursor.readBE<uint32_t>() == PrivHelperConn::RESP_ERROR) {
+        // A privhelper started by an older edenfs, and kept across a graceful
+        // restart, does not know about batches.
+        XLOG(DBG2) << "privhelper does not support batched requests";
+        batchRequests_ = false;
+        for (auto& request : requests) {
+          sendMessage(std::move(request));
+        }
+      }
+      return;
+    }
+
     auto iter = pendingRequests_.find(xid);
     if (iter == pendingRequests_.end()) {
       // This normally shouldn't happen unless there is a bug.
@@ -331,6 +396,8 @@ class PrivHelperClientImpl : public PrivHelper,
   void closeSocket(const std::exception& ex) {
     PendingRequestMap pending;
     pending.swap(pendingRequests_);
+    queuedRequests_.clear();
+    pendingBatches_.clear();
     {
       auto state = state_.wlock();
       state->conn_.reset();
@@ -345,6 +412,10 @@ class PrivHelperClientImpl : public PrivHelper,
   // Separated out from detachEventBase() since it is not safe to cancel() an
   // EventBase::OnDestructionCallback within the callback itself.
   void detachWithinEventBaseDestructor() noexcept {
+    if (isLoopCallbackScheduled()) {
+      cancelLoopCallback();
+      runLoopCallback();
+    }
     {
       auto state = state_.wlock();
       if (state->status != Status::RUNNING) {
@@ -361,10 +432,16 @@ class PrivHelperClientImpl : public PrivHelper,
   std::atomic<uint32_t> nextXid_{1};
   folly::Synchronized<ThreadSafeData> state_;
 
-  // sendPending_, and pendingRequests_ are only accessed from the
-  // EventBase thread.
+  // sendPending_, pendingRequests_, queuedRequests_, pendingBatches_ and
+  // batchRequests_ are only accessed from the EventBase thread.
   size_t sendPending_{0};
   PendingRequestMap pendingRequests_;
+  /// Requests waiting for the end of the loop iteration to be sent.
+  std::vector<UnixSocket::Message> queuedRequests_;
+  /// The requests in each batch sent, by transaction ID of the batch.
+  std::unordered_map<uint32_t, std::vector<UnixSocket::Message>>
+      pendingBatches_;
+  bool batchRequests_{true};
 };
 
 Future<File> PrivHelperClientImpl::fuseMount(
@@ -393,10 +470,20 @@ Future<Unit> PrivHelperClientImpl::nfsMount(
     folly::SocketAddress nfsdAddr,
     bool readOnly,
     uint32_t iosize,
-    bool useReaddirplus) {
+    bool useReaddirplus,
+    std::chrono::seconds fileAttrCacheTimeout,
+    std::chrono::seconds dirAttrCacheTimeout) {
   auto xid = getNextXid();
   auto request = PrivHelperConn::serializeMountNfsRequest(
-      xid, mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
+      xid,
+      mountPath,
+      mountdAddr,
+      nfsdAddr,
+      readOnly,
+      iosize,
+      useReaddirplus,
+      fileAttrCacheTimeout,
+      dirAttrCacheTimeout);
   return sendAndRecv(xid, std::move(request))
       .thenValue([](UnixSocket::Message&& response) {
         PrivHelperConn::parseEmptyResponse(
@@ -565,7 +565,9 @@ void PrivHelperServer::nfsMount(
     folly::SocketAddress nfsdAddr,
     bool readOnly,
     uint32_t iosize,
-    bool useReaddirplus) {
+    bool useReaddirplus,
+    std::chrono::seconds fileAttrCacheTimeout,
+    std::chrono::seconds dirAttrCacheTimeout) {
 #ifdef __APPLE__
   // Hold the attribute list set below.
   auto attrsBuf = folly::IOBufQueue{folly::IOBufQueue::cacheChainLength()};
@@ -603,6 +605,23 @@ void PrivHelperServer::nfsMount(
   mattrFlags |= NFS_MATTR_WRITE_SIZE;
   XdrTrait<nfs_mattr_wsize>::serialize(attrSer, iosize);
 
+  // Pin the attribute cache timeouts instead of letting the kernel pick one
+  // between 5 and 60 seconds based on the age of the file. EdenFS
+  // invalidates the entries that a checkout changes, thus the kernel's cache
+  // can be trusted for much longer than for a regular NFS server.
+  auto fileTimeout =
+      nfstime32{folly::to_narrow(fileAttrCacheTimeout.count()), 0};
+  auto dirTimeout =
+      nfstime32{folly::to_narrow(dirAttrCacheTimeout.count()), 0};
+  mattrFlags |= NFS_MATTR_ATTRCACHE_REG_MIN;
+  XdrTrait<nfs_mattr_acregmin>::serialize(attrSer, fileTimeout);
+  mattrFlags |= NFS_MATTR_ATTRCACHE_REG_MAX;
+  XdrTrait<nfs_mattr_acregmax>::serialize(attrSer, fileTimeout);
+  mattrFlags |= NFS_MATTR_ATTRCACHE_DIR_MIN;
+  XdrTrait<nfs_mattr_acdirmin>::serialize(attrSer, dirTimeout);
+  mattrFlags |= NFS_MATTR_ATTRCACHE_DIR_MAX;
+  XdrTrait<nfs_mattr_acdirmax>::serialize(attrSer, dirTimeout);
+
   mattrFlags |= NFS_MATTR_LOCK_MODE;
   XdrTrait<nfs_mattr_lock_mode>::serialize(
       attrSer, nfs_lock_mode::NFS_LOCK_MODE_LOCAL);
@@ -746,13 +765,18 @@ void PrivHelperServer::nfsMount(
   }
   auto mountOpts = fmt::format(
       "addr={},vers=3,proto=tcp,port={},mountvers=3,mountproto=tcp,mountport={},"
-      "noresvport,nolock{}soft,retrans=0,rsize={},wsize={}",
+      "noresvport,nolock{}soft,retrans=0,rsize={},wsize={},"
+      "acregmin={},acregmax={},acdirmin={},acdirmax={}",
       nfsdAddr.getAddressStr(),
       nfsdAddr.getPort(),
       mountdAddr.getPort(),
       noReaddirplusStr,
       iosize,
-      iosize);
+      iosize,
+      fileAttrCacheTimeout.count(),
+      fileAttrCacheTimeout.count(),
+      dirAttrCacheTimeout.count(),
+      dirAttrCacheTimeout.count());
 
   // The mount flags.
   // We do not use MS_NODEV.  MS_NODEV prevents mount points from being created
@@ -860,6 +884,7 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
   folly::SocketAddress mountdAddr, nfsdAddr;
   bool readOnly, useReaddirplus;
   uint32_t iosize;
+  std::chrono::seconds fileAttrCacheTimeout, dirAttrCacheTimeout;
   PrivHelperConn::parseMountNfsRequest(
       cursor,
       mountPath,
@@ -867,12 +892,22 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
       nfsdAddr,
       readOnly,
       iosize,
-      useReaddirplus);
+      useReaddirplus,
+      fileAttrCacheTimeout,
+      dirAttrCacheTimeout);
   XLOG(DBG3) << "mount.nfs \"" << mountPath << "\"";
 
   sanityCheckMountPoint(mountPath);
 
-  nfsMount(mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
+  nfsMount(
+      mountPath,
+      mountdAddr,
+      nfsdAddr,
+      readOnly,
+      iosize,
+      useReaddirplus,
+      fileAttrCacheTimeout,
+      dirAttrCacheTimeout);
   mountPoints_.insert(mountPath);
 
   return makeResponse();
@@ -1140,6 +1175,22 @@ void PrivHelperServer::processAndSendResponse(UnixSocket::Message&& message) {
   conn_->send(std::move(response));
 }
 
+UnixSocket::Message PrivHelperServer::processBatchMsg(Cursor& cursor) {
+  std::vector<IOBuf> requests;
+  PrivHelperConn::parseBatchRequest(cursor, requests);
+  XLOG(DBG3) << "processing batch of " << requests.size()
+             << " privhelper requests";
+
+  // Each request gets its own response, so that an error only fails the
+  // request that caused it.
+  for (auto& request : requests) {
+    UnixSocket::Message message;
+    message.data = std::move(request);
+    processAndSendResponse(std::move(message));
+  }
+  return makeResponse();
+}
+
 UnixSocket::Message PrivHelperServer::makeResponse() {
   // 1024 bytes is enough for most responses.  If the response is longer
   // we will allocate more room later.
@@ -1187,6 +1238,8 @@ UnixSocket::Message PrivHelperServer::processMessage(
       return processSetDaemonTimeout(cursor, request);
     case PrivHelperConn::REQ_SET_USE_EDENFS:
       return processSetUseEdenFs(cursor, request);
+    case PrivHelperConn::REQ_BATCH:
+      return processBatchMsg(cursor);
     case PrivHelperConn::MSG_TYPE_NONE:
     case PrivHelperConn::RESP_ERROR:
       break;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <sys/types.h>
+#include <chrono>
 #include <limits>
 #include <set>
 #include <string>
@@ -86,6 +87,7 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   UnixSocket::Message processBindUnMountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverShutdownMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverStartupMsg(folly::io::Cursor& cursor);
+  UnixSocket::Message processBatchMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processSetLogFileMsg(
       folly::io::Cursor& cursor,
       UnixSocket::Message& request);
@@ -115,7 +117,9 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
       folly::SocketAddress nfsdPort,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus);
+      bool useReaddirplus,
+      std::chrono::seconds fileAttrCacheTimeout,
+      std::chrono::seconds dirAttrCacheTimeout);
   virtual void unmount(const char* mountPath);
   // Both clientPath and mountPath must be existing directories.
   virtual void bindMount(const char* clientPath, const char* mountPath);
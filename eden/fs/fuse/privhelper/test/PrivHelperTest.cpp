@@ -313,6 +313,42 @@ TEST_F(PrivHelperTest, multiplePendingFuseMounts) {
   EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
 }
 
+TEST_F(PrivHelperTest, batchedFuseMounts) {
+  auto abcMountPoint = makeTempDir("abc");
+  auto abcPath = abcMountPoint.path().string();
+  auto defMountPoint = makeTempDir("def");
+  auto defPath = defMountPoint.path().string();
+  auto errorMountPoint = makeTempDir("error");
+  auto errorPath = errorMountPoint.path().string();
+
+  TemporaryFile tempFile;
+  server_.setFuseMountResult(abcPath).setValue(File(tempFile.fd(), false));
+  server_.setFuseMountResult(defPath).setValue(File(tempFile.fd(), false));
+  server_.setFuseUnmountResult(abcPath).setValue();
+  server_.setFuseUnmountResult(defPath).setValue();
+
+  // Requests made during the same loop iteration are sent as one batch. An
+  // error only fails the request that caused it.
+  Future<File> abcResult = Future<File>::makeEmpty();
+  Future<File> errorResult = Future<File>::makeEmpty();
+  Future<File> defResult = Future<File>::makeEmpty();
+  clientIoThread_.getEventBase()->runInEventBaseThreadAndWait([&] {
+    abcResult = client_->fuseMount(abcPath, false);
+    errorResult = client_->fuseMount(errorPath, false);
+    defResult = client_->fuseMount(defPath, false);
+  });
+
+  std::move(abcResult).get(1s);
+  EXPECT_THROW_RE(
+      std::move(errorResult).get(1s),
+      std::exception,
+      fmt::format("no result available for {}", errorPath));
+  std::move(defResult).get(1s);
+
+  cleanup();
+  EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
+}
+
 TEST_F(PrivHelperTest, bindMounts) {
   auto abcMountPoint = makeTempDir("abc");
   auto abcPath = abcMountPoint.path().string();
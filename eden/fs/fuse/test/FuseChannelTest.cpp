@@ -11,6 +11,7 @@
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 #include <unordered_map>
 #include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
@@ -66,7 +67,8 @@ fuse_entry_out genRandomLookupResponse(uint64_t nodeid) {
 class FuseChannelTest : public ::testing::Test {
  protected:
   unique_ptr<FuseChannel, FuseChannelDeleter> createChannel(
-      size_t numThreads = 2) {
+      size_t numThreads = 2,
+      size_t maxWrite = 128 * 1024) {
     auto testDispatcher = std::make_unique<TestDispatcher>(&stats_);
     dispatcher_ = testDispatcher.get();
     return unique_ptr<FuseChannel, FuseChannelDeleter>(new FuseChannel(
@@ -81,7 +83,14 @@ class FuseChannelTest : public ::testing::Test {
         /*notifications=*/nullptr,
         CaseSensitivity::Sensitive,
         /*requireUtf8Path=*/true,
-        /*maximumBackgroundRequests=*/12));
+        /*maximumBackgroundRequests=*/12,
+        /*cloneDevicePerThread=*/false,
+        /*pinWorkerThreads=*/false,
+        /*spliceReadThreshold=*/0,
+        /*useReaddirplus=*/false,
+        /*numInvalidationThreads=*/1,
+        /*useWritebackCache=*/false,
+        maxWrite));
   }
 
   FuseChannel::StopFuture performInit(
@@ -189,6 +198,36 @@ TEST_F(FuseChannelTest, testTakeoverStop) {
   EXPECT_EQ(flags, stopData.fuseSettings.flags);
 }
 
+TEST_F(FuseChannelTest, testInitNegotiatesMaxWrite) {
+  constexpr size_t kMaxWrite = 1024 * 1024;
+  auto channel = createChannel(2, kMaxWrite);
+  uint32_t flags = 0;
+#ifdef __linux__
+  flags |= FUSE_MAX_PAGES;
+#endif
+  auto completeFuture = performInit(
+      channel.get(), FUSE_KERNEL_VERSION, FUSE_KERNEL_MINOR_VERSION, 0, flags);
+
+  channel->takeoverStop();
+
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(kMaxWrite, stopData.fuseSettings.max_write);
+#ifdef __linux__
+  EXPECT_EQ(FUSE_MAX_PAGES, stopData.fuseSettings.flags & FUSE_MAX_PAGES);
+  EXPECT_EQ(kMaxWrite / getpagesize(), stopData.fuseSettings.max_pages);
+#endif
+}
+
+TEST_F(FuseChannelTest, testInitClampsMaxWrite) {
+  auto channel = createChannel(2, 64 * 1024 * 1024);
+  auto completeFuture = performInit(channel.get());
+
+  channel->takeoverStop();
+
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(1024 * 1024, stopData.fuseSettings.max_write);
+}
+
 TEST_F(FuseChannelTest, testInitUnmountRace) {
   auto channel = createChannel();
   auto completeFuture = performInit(channel.get());
@@ -359,10 +398,8 @@ TEST_F(FuseChannelTest, interruptLookups) {
 
     (void)fuse_.sendRequest(FUSE_INTERRUPT, FUSE_ROOT_ID, interruptData);
 
-    // For now FuseChannel never actually interrupts requests, so the
-    // dispatcher will definitely receive the request.
-    // We may need to change this code in the future if we do add true
-    // interrupt support to FuseChannel.
+    // An interrupt only cancels the fetches of a request, so the dispatcher
+    // will definitely receive the request.
     auto req = dispatcher_->waitForLookup(requestId);
 
     auto nodeId = 5 + i * 7;
@@ -373,3 +410,28 @@ TEST_F(FuseChannelTest, interruptLookups) {
     EXPECT_EQ(requestId, received.header.unique);
   }
 }
+
+TEST_F(FuseChannelTest, interruptCancelsRequestFetches) {
+  auto channel = createChannel();
+  auto completeFuture = performInit(channel.get());
+
+  auto requestId = fuse_.sendLookup(FUSE_ROOT_ID, "foo");
+  auto req = dispatcher_->waitForLookup(requestId);
+  EXPECT_FALSE(req.cancellation.isCancellationRequested());
+
+  fuse_interrupt_in interruptData;
+  interruptData.unique = requestId;
+  (void)fuse_.sendRequest(FUSE_INTERRUPT, FUSE_ROOT_ID, interruptData);
+
+  // The interrupt is handled by whichever worker thread reads it.
+  auto deadline = std::chrono::steady_clock::now() + kTimeout;
+  while (!req.cancellation.isCancellationRequested() &&
+         std::chrono::steady_clock::now() < deadline) {
+    /* sleep override */ std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(req.cancellation.isCancellationRequested());
+
+  req.promise.setValue(genRandomLookupResponse(5));
+  auto received = fuse_.recvResponse();
+  EXPECT_EQ(requestId, received.header.unique);
+}
@@ -11,6 +11,7 @@
 #include <optional>
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/TreeInode.h"
@@ -26,9 +27,13 @@ CheckoutContext::CheckoutContext(
     CheckoutMode checkoutMode,
     std::optional<pid_t> clientPid,
     folly::StringPiece thriftMethodName,
-    const std::unordered_map<std::string, std::string>* requestInfo)
+    const std::unordered_map<std::string, std::string>* requestInfo,
+    folly::CancellationToken cancellation,
+    bool resuming)
     : checkoutMode_{checkoutMode},
       mount_{mount},
+      cancellation_{std::move(cancellation)},
+      resuming_{resuming},
       fetchContext_{
           clientPid,
           ObjectFetchContext::Cause::Thrift,
@@ -49,7 +54,10 @@ void CheckoutContext::start(
     std::optional<RootId> oldParent;
     if (parentLock) {
       XCHECK(parentLock->checkoutInProgress);
-      oldParent = parentLock->workingCopyParentRootId;
+      // Keep recording where an interrupted checkout started from, as the
+      // working copy may still be partly there.
+      oldParent = parentLock->interruptedCheckoutFrom.value_or(
+          parentLock->workingCopyParentRootId);
       // Update the in-memory snapshot ID
       parentLock->checkedOutRootId = newSnapshot;
       parentLock->workingCopyParentRootId = newSnapshot;
@@ -63,14 +71,24 @@ void CheckoutContext::start(
       config->setCheckedOutCommit(std::move(newSnapshot));
     } else {
       config->setCheckoutInProgress(oldParent.value(), newSnapshot);
+      started_ = true;
     }
     XLOG(DBG1) << "updated snapshot for " << config->getMountPath() << " from "
                << (oldParent.has_value() ? oldParent->value() : "<none>")
                << " to " << newSnapshot;
+
+    auto batchSize =
+        mount_->getEdenConfig()->overlayCheckoutBatchSize.getValue();
+    if (batchSize > 0) {
+      overlayBatch_.emplace(mount_->getOverlay(), batchSize);
+    }
   }
 }
 
 Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
+  // Commit the overlay changes before recording the checkout as complete.
+  overlayBatch_.reset();
+
   auto config = mount_->getCheckoutConfig();
 
   auto parentCommit = config->getParentCommit();
@@ -81,6 +99,7 @@ Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
         newSnapshot);
     config->setCheckedOutCommit(newSnapshot);
   }
+  finished_ = true;
 
   // Release the rename lock.
   // This allows any filesystem unlink() or rename() operations to proceed.
@@ -89,6 +108,30 @@ Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
   return flush();
 }
 
+Future<vector<CheckoutConflict>> CheckoutContext::interrupt() {
+  // Commit the directories that were updated, so that resuming the checkout
+  // skips them even after a restart.
+  overlayBatch_.reset();
+  renameLock_.unlock();
+  return flush();
+}
+
+void CheckoutContext::holdRenameLock(RenameLock&& renameLock) {
+  renameLock_ = std::move(renameLock);
+  if (!isDryRun()) {
+    auto batchSize =
+        mount_->getEdenConfig()->overlayCheckoutBatchSize.getValue();
+    if (batchSize > 0) {
+      overlayBatch_.emplace(mount_->getOverlay(), batchSize);
+    }
+  }
+}
+
+void CheckoutContext::releaseRenameLock() {
+  overlayBatch_.reset();
+  renameLock_.unlock();
+}
+
 Future<vector<CheckoutConflict>> CheckoutContext::flush() {
   if (!isDryRun()) {
     // If we have a FUSE channel, flush all invalidations we sent to the kernel
@@ -98,7 +141,7 @@ Future<vector<CheckoutConflict>> CheckoutContext::flush() {
     // We do this after releasing the rename lock since some of the invalidation
     // operations may be blocked waiting on FUSE unlink() and rename()
     // operations complete.
-    return mount_->flushInvalidations()
+    return mount_->flushCheckoutInvalidations()
         .thenValue([this](auto&&) { return std::move(*conflicts_.wlock()); })
         .semi()
         .via(&folly::QueuedImmediateExecutor::instance());
@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include <folly/CancellationToken.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/stop_watch.h>
@@ -46,7 +47,9 @@ class CheckoutContext {
       std::optional<pid_t> clientPid,
       folly::StringPiece thriftMethodName,
       const std::unordered_map<std::string, std::string>* requestInfo =
-          nullptr);
+          nullptr,
+      folly::CancellationToken cancellation = {},
+      bool resuming = false);
 
   ~CheckoutContext();
 
@@ -75,6 +78,31 @@ class CheckoutContext {
     return checkoutMode_ == CheckoutMode::FORCE;
   }
 
+  /**
+   * Returns true if this checkout resumes an interrupted checkout to the same
+   * commit. Entries that are already in their new state are then skipped
+   * rather than reported as conflicts.
+   */
+  bool isResuming() const {
+    return resuming_;
+  }
+
+  /**
+   * Returns true if the checkout was cancelled. It then stops recursing into
+   * directories, leaving them to be updated when the checkout is resumed.
+   */
+  bool isCancelled() const {
+    return cancellation_.isCancellationRequested();
+  }
+
+  /**
+   * Returns true if start() moved the parent commit to the new snapshot, but
+   * finish() didn't record the checkout as complete.
+   */
+  bool isInterrupted() const {
+    return started_ && !finished_;
+  }
+
   /**
    * Start the checkout operation.
    *
@@ -96,6 +124,27 @@ class CheckoutContext {
    */
   folly::Future<std::vector<CheckoutConflict>> finish(RootId newSnapshot);
 
+  /**
+   * Stop a cancelled checkout operation without completing it.
+   *
+   * The overlay changes made so far are committed and the rename lock is
+   * released, but the SNAPSHOT file keeps recording the checkout as in
+   * progress so that it can be resumed.
+   */
+  folly::Future<std::vector<CheckoutConflict>> interrupt();
+
+  /**
+   * Hold the rename lock for an operation that updates parts of the working
+   * copy without moving it to a new snapshot, such as
+   * EdenMount::setPathObjectIds().
+   */
+  void holdRenameLock(RenameLock&& renameLock);
+
+  /**
+   * Release the lock taken by holdRenameLock(), before flush().
+   */
+  void releaseRenameLock();
+
   /**
    * Flush the invalidation if needed.
    *
@@ -133,9 +182,17 @@ class CheckoutContext {
  private:
   CheckoutMode checkoutMode_;
   EdenMount* const mount_;
+  folly::CancellationToken cancellation_;
+  const bool resuming_;
+  bool started_{false};
+  bool finished_{false};
   RenameLock renameLock_;
   StatsFetchContext fetchContext_;
 
+  // Groups the overlay mutations of the checkout, when enabled, from start()
+  // or holdRenameLock() to finish() or releaseRenameLock().
+  std::optional<OverlayBatch> overlayBatch_;
+
   // The checkout processing may occur across many threads,
   // if some data load operations complete asynchronously on other threads.
   // Therefore access to the conflicts list must be synchronized.
@@ -102,10 +102,12 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
       const TreeEntry& scmEntry,
       InodePtr inode,
       const GitIgnoreStack* ignore,
-      bool isIgnored)
+      bool isIgnored,
+      bool isMaterialized)
       : DeferredDiffEntry{context, std::move(path)},
         ignore_{ignore},
         isIgnored_{isIgnored},
+        isMaterialized_{isMaterialized},
         scmEntry_{scmEntry},
         inode_{std::move(inode)} {}
 
@@ -119,6 +121,7 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
       : DeferredDiffEntry{context, std::move(path)},
         ignore_{ignore},
         isIgnored_{isIgnored},
+        isMaterialized_{true},
         scmEntry_{scmEntry},
         inodeFuture_{std::move(inodeFuture)} {}
 
@@ -219,11 +222,28 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
       return treeInode->diff(context_, getPath(), nullptr, ignore_, isIgnored_);
     }
 
-    return fileInode
-        ->isSameAs(
-            scmEntry_.getHash(),
-            scmEntry_.getType(),
-            context_->getFetchContext())
+    auto isSameAs = [this, fileInode = std::move(fileInode)] {
+      return fileInode->isSameAs(
+          scmEntry_.getHash(),
+          scmEntry_.getType(),
+          context_->getFetchContext());
+    };
+    // Comparing a materialized file hashes its contents unless its SHA-1 is
+    // already known, so leave that to the hash executor rather than hashing
+    // the files of a directory one after the other.
+    ImmediateFuture<bool> isSameFuture{false};
+    auto* hashExecutor = context_->getHashExecutor();
+    if (isMaterialized_ && hashExecutor) {
+      isSameFuture = folly::via(
+                         hashExecutor,
+                         [isSameAs = std::move(isSameAs)] {
+                           return isSameAs().semi();
+                         })
+                         .semi();
+    } else {
+      isSameFuture = isSameAs();
+    }
+    return std::move(isSameFuture)
         .thenValue([this](bool isSame) {
           if (!isSame) {
             XLOG(DBG5) << "modified file: " << getPath();
@@ -236,6 +256,7 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
 
   const GitIgnoreStack* ignore_{nullptr};
   bool isIgnored_{false};
+  bool isMaterialized_{false};
   TreeEntry scmEntry_;
   folly::Future<InodePtr> inodeFuture_ = folly::Future<InodePtr>::makeEmpty();
   InodePtr inode_;
@@ -370,9 +391,16 @@ unique_ptr<DeferredDiffEntry> DeferredDiffEntry::createModifiedEntry(
     const TreeEntry& scmEntry,
     InodePtr inode,
     const GitIgnoreStack* ignore,
-    bool isIgnored) {
+    bool isIgnored,
+    bool isMaterialized) {
   return make_unique<ModifiedDiffEntry>(
-      context, std::move(path), scmEntry, std::move(inode), ignore, isIgnored);
+      context,
+      std::move(path),
+      scmEntry,
+      std::move(inode),
+      ignore,
+      isIgnored,
+      isMaterialized);
 }
 
 unique_ptr<DeferredDiffEntry>
@@ -78,13 +78,18 @@ class DeferredDiffEntry {
       RelativePath path,
       const TreeEntry& scmEntry);
 
+  /**
+   * isMaterialized tells whether `inode` is materialized, in which case
+   * comparing it to `scmEntry` may require hashing its contents.
+   */
   static std::unique_ptr<DeferredDiffEntry> createModifiedEntry(
       DiffContext* context,
       RelativePath path,
       const TreeEntry& scmEntry,
       InodePtr inode,
       const GitIgnoreStack* ignore,
-      bool isIgnored);
+      bool isIgnored,
+      bool isMaterialized);
 
   static std::unique_ptr<DeferredDiffEntry> createModifiedEntryFromInodeFuture(
       DiffContext* context,
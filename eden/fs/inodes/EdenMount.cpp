@@ -8,8 +8,10 @@
 #include "eden/fs/inodes/EdenMount.h"
 
 #include <boost/filesystem.hpp>
+#include <folly/Exception.h>
 #include <folly/ExceptionWrapper.h>
 #include <folly/FBString.h>
+#include <folly/File.h>
 #include <folly/stop_watch.h>
 
 #include <folly/chrono/Conv.h>
@@ -19,6 +21,7 @@
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 #include <gflags/gflags.h>
+#include <map>
 
 #include <eden/fs/config/MountProtocol.h>
 #include "eden/fs/config/EdenConfig.h"
@@ -32,6 +35,7 @@
 #include "eden/fs/inodes/TreePrefetchLease.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeFilter.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/nfs/NfsServer.h"
@@ -42,13 +46,17 @@
 #include "eden/fs/store/DiffCallback.h"
 #include "eden/fs/store/DiffContext.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/ScmStatusCache.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/SortedDiffCallback.h"
 #include "eden/fs/store/StatsFetchContext.h"
+#include "eden/fs/store/TreePrefetcher.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/FsChannelTypes.h"
 #include "eden/fs/utils/Future.h"
 #include "eden/fs/utils/ImmediateFuture.h"
@@ -94,6 +102,26 @@ constexpr PathComponentPiece kNfsdSocketName{"nfsd.socket"_pc};
 } // namespace
 #endif
 
+namespace {
+// How many of the roots this mount was most recently checked out at are
+// considered as intermediate points when composing a cached status.
+constexpr size_t kMaxScmStatusViaRoots = 16;
+// The name index of a large repository takes a lot of memory, and globs are
+// usually evaluated against only a few commits.
+constexpr size_t kNameIndexCacheSize = 4;
+// Checkouts are rare: a small buffer absorbs a burst of them.
+constexpr size_t kCheckoutTraceBusCapacity = 64;
+
+EdenError newCheckoutCancelledError(const RootId& snapshotHash) {
+  return newEdenError(
+      ECANCELED,
+      EdenErrorType::POSIX_ERROR,
+      "checkout to ",
+      snapshotHash,
+      " was cancelled");
+}
+} // namespace
+
 /**
  * Helper for computing unclean paths when changing parents
  *
@@ -228,15 +256,38 @@ EdenMount::EdenMount(
           checkoutConfig_->getOverlayPath(),
           checkoutConfig_->getCaseSensitive(),
           getOverlayType(),
-          serverState_->getStructuredLogger())},
+          serverState_->getStructuredLogger(),
+          serverState_->getEdenConfig()->overlayBlobFileCacheSize.getValue(),
+          serverState_->getEdenConfig()->overlayBufferMaxBytes.getValue(),
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              serverState_->getEdenConfig()->overlayBufferMaxAge.getValue()),
+          serverState_->getEdenConfig()->overlayGCThreads.getValue(),
+          serverState_->getEdenConfig()->overlayGCMaxOpsPerSecond.getValue(),
+          serverState_->getEdenConfig()->overlayDedupStoreSize.getValue())},
 #ifndef _WIN32
-      overlayFileAccess_{overlay_.get()},
+      overlayFileAccess_{
+          overlay_.get(),
+          serverState_->getEdenConfig()->overlayUseIoUring.getValue()},
 #endif
+      checkoutFilter_{std::make_shared<const TreeFilter>(
+          checkoutConfig_->getFilteredPaths())},
       journal_{std::move(journal)},
-      mountGeneration_{globalProcessGeneration | ++mountGeneration},
+      recordedPrefetchProfiles_{
+          checkoutConfig_->getClientDirectory() + "prefetch-profiles"_pc},
+      speculativeTreePrefetcher_{objectStore_},
+      statusCache_{this},
+      gitIgnoreCache_{
+          serverState_->getEdenConfig()->gitIgnoreCacheSize.getValue()},
+      nameIndexCache_{objectStore_->getLocalStore(), kNameIndexCacheSize},
+      pathInodeCache_{
+          serverState_->getEdenConfig()->pathInodeCacheSize.getValue()},
+      mountGeneration_{restoreJournal()},
       straceLogger_{
           kEdenStracePrefix.str() + checkoutConfig_->getMountPath().value()},
       lastCheckoutTime_{EdenTimestamp{serverState_->getClock()->getRealtime()}},
+      checkoutTraceBus_{TraceBus<CheckoutTraceEvent>::create(
+          "checkout",
+          kCheckoutTraceBusCapacity)},
       owner_{Owner{getuid(), getgid()}},
       clock_{serverState_->getClock()} {
 }
@@ -246,11 +297,17 @@ Overlay::OverlayType EdenMount::getOverlayType() {
     if (getEdenConfig()->unsafeInMemoryOverlay.getValue()) {
       return Overlay::OverlayType::TreeInMemory;
     }
+    if (getEdenConfig()->overlayBuffered.getValue()) {
+      return Overlay::OverlayType::TreeBuffered;
+    }
     if (getEdenConfig()->overlaySynchronousMode.getValue() == "off") {
       return Overlay::OverlayType::TreeSynchronousOff;
     }
     return Overlay::OverlayType::Tree;
   } else {
+    if (getEdenConfig()->overlayPackedDirectories.getValue()) {
+      return Overlay::OverlayType::LegacyPacked;
+    }
     return Overlay::OverlayType::Legacy;
   }
 }
@@ -271,21 +328,34 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
       .thenValue([this, parent](auto&&) {
         static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
             "EdenMount::initialize");
-        return objectStore_->getRootTree(parent, *context);
+        return getFilteredRootTree(parent, *context);
       })
       .thenValue([this,
                   progressCallback = std::move(progressCallback),
                   parent,
                   workingCopyParentRootId = parentCommit.getWorkingCopyParent(),
-                  inProgressCheckout = parentCommit.isCheckoutInProgress()](
+                  interruptedCheckoutFrom = parentCommit.isCheckoutInProgress()
+                      ? parentCommit.getLastCheckoutId(
+                            ParentCommit::RootIdPreference::From)
+                      : std::nullopt](
                      std::shared_ptr<const Tree> parentTree) mutable {
+        // A checkout that was in progress when EdenFS stopped is resumed by
+        // the next checkout to the same commit.
         *parentState_.wlock() = ParentCommitState{
-            parent, parentTree, workingCopyParentRootId, inProgressCheckout};
+            parent,
+            parentTree,
+            workingCopyParentRootId,
+            false,
+            std::move(interruptedCheckoutFrom)};
 
         // Record the transition from no snapshot to the current snapshot in
         // the journal.  This also sets things up so that we can carry the
         // snapshot id forward through subsequent journal entries.
-        journal_->recordHashUpdate(parent);
+        // A restored journal is usually on the parent already.
+        auto latest = journal_->getLatest();
+        if (!latest || latest->toHash != parent) {
+          journal_->recordHashUpdate(parent);
+        }
 
         // Initialize the overlay.
         // This must be performed before we do any operations that may
@@ -322,6 +392,68 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
       });
 }
 
+bool EdenMount::deferInitialization(
+    OverlayChecker::ProgressCallback&& progressCallback) {
+  if (folly::kIsWindows || shouldUseNFSMount_) {
+    return false;
+  }
+  if (getState() != State::UNINITIALIZED) {
+    throw std::runtime_error(folly::to<std::string>(
+        "cannot defer the initialization of mount ",
+        getPath(),
+        " in state ",
+        getState()));
+  }
+  auto deferred = deferredInitialization_.wlock();
+  deferred->deferred = true;
+  deferred->progressCallback = std::move(progressCallback);
+  return true;
+}
+
+ImmediateFuture<folly::Unit> EdenMount::ensureInitialized() {
+  if (getState() == State::RUNNING) {
+    return folly::unit;
+  }
+
+  auto deferred = deferredInitialization_.wlock();
+  if (!deferred->deferred) {
+    return folly::unit;
+  }
+  auto future = deferred->initialized.getSemiFuture();
+  if (!deferred->progressCallback) {
+    // Already started by an earlier request.
+    return std::move(future);
+  }
+  auto progressCallback = std::move(*deferred->progressCallback);
+  deferred->progressCallback.reset();
+  deferred.unlock();
+
+  XLOG(DBG1) << "initializing " << getPath() << " on first access";
+  folly::makeFutureWith([&] { return initialize(std::move(progressCallback)); })
+      .thenTry([self = shared_from_this()](Try<Unit>&& result) {
+        if (result.hasException()) {
+          XLOG(ERR) << "error initializing " << self->getPath() << ": "
+                    << result.exception().what();
+        }
+        auto deferred = self->deferredInitialization_.wlock();
+        if (result.hasValue() && deferred->channelStarted) {
+          // startChannel() finished first, so the mount is now running. If
+          // it is shutting down instead, leave it alone.
+          (void)self->tryToTransitionState(State::INITIALIZED, State::RUNNING);
+        }
+        // The promise outlives the lock, and waiting requests resume when it
+        // is fulfilled, so do not hold the lock while fulfilling it.
+        auto& initialized = deferred->initialized;
+        deferred.unlock();
+        initialized.setTry(std::move(result));
+      });
+  return std::move(future);
+}
+
+folly::SemiFuture<folly::Unit> EdenMount::getDeferredInitializationFuture() {
+  return deferredInitialization_.wlock()->initialized.getSemiFuture();
+}
+
 TreeInodePtr EdenMount::createRootInode(std::shared_ptr<const Tree> tree) {
   // Load the overlay, if present.
   auto rootOverlayDir = overlay_->loadOverlayDir(kRootNodeId);
@@ -537,6 +669,60 @@ folly::SemiFuture<Unit> EdenMount::performBindMounts() {
 
 EdenMount::~EdenMount() {}
 
+AbsolutePath EdenMount::getSavedJournalPath() const {
+  return checkoutConfig_->getClientDirectory() + "journal"_pc;
+}
+
+uint64_t EdenMount::restoreJournal() {
+  auto newGeneration = globalProcessGeneration | ++mountGeneration;
+  auto path = getSavedJournalPath();
+  auto contents = readFile(path);
+  if (contents.hasException()) {
+    // Usually because the last shutdown did not save one.
+    return newGeneration;
+  }
+  boost::system::error_code ec;
+  boost::filesystem::remove(
+      boost::filesystem::path{path.stringPiece().str()}, ec);
+  if (ec) {
+    XLOG(ERR) << "not restoring the journal of " << getPath()
+              << ", since it can not be removed: " << ec.message();
+    return newGeneration;
+  }
+
+  folly::StringPiece data{*contents};
+  uint64_t generation;
+  if (!getEdenConfig()->persistJournal.getValue() ||
+      data.size() < sizeof(generation)) {
+    return newGeneration;
+  }
+  memcpy(&generation, data.data(), sizeof(generation));
+  data.advance(sizeof(generation));
+  if (!journal_->restore(data)) {
+    XLOG(WARN) << "ignoring the unreadable saved journal of " << getPath();
+    return newGeneration;
+  }
+  XLOG(DBG1) << "restored the journal of " << getPath();
+  return generation;
+}
+
+void EdenMount::saveJournal() {
+  auto config = getEdenConfig();
+  if (!config->persistJournal.getValue()) {
+    return;
+  }
+  auto generation = mountGeneration_;
+  std::string contents(
+      reinterpret_cast<const char*>(&generation), sizeof(generation));
+  contents += journal_->serialize(config->persistedJournalSizeLimit.getValue());
+  auto result = writeFileAtomic(
+      getSavedJournalPath(), folly::ByteRange{folly::StringPiece{contents}});
+  if (result.hasException()) {
+    XLOG(ERR) << "unable to save the journal of " << getPath() << ": "
+              << result.exception();
+  }
+}
+
 bool EdenMount::tryToTransitionState(State expected, State newState) {
   return state_.compare_exchange_strong(
       expected, newState, std::memory_order_acq_rel);
@@ -733,6 +919,156 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
         return std::move(resultAndTimes);
       });
 }
+
+folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectIds(
+    std::vector<SetPathObjectIdObject> objects,
+    CheckoutMode checkoutMode,
+    ObjectFetchContext& context) {
+  const folly::stop_watch<> stopWatch;
+  auto setPathObjectIdTime = std::make_shared<SetPathObjectIdTimes>();
+  auto oldParent = getWorkingCopyParent();
+  XLOG(DBG3) << "adding " << objects.size() << " objects to Eden mount "
+             << this->getPath() << " on top of " << oldParent;
+
+  auto ctx = std::make_shared<CheckoutContext>(
+      this,
+      checkoutMode,
+      std::nullopt,
+      "setPathObjectIds",
+      context.getRequestInfo());
+  setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
+
+  // Trees are grafted one by one, while the files of a directory are grafted
+  // together through a tree synthesized from all of them. The groups are
+  // keyed by the directory they check out, and a tree sorts before the files
+  // grafted in it, so that parents are always checked out first.
+  std::stable_sort(
+      objects.begin(), objects.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.path < rhs.path;
+      });
+  std::map<std::pair<RelativePath, bool>, std::vector<SetPathObjectIdObject>>
+      groups;
+  for (size_t i = 0; i < objects.size(); ++i) {
+    if (i + 1 < objects.size() && objects[i + 1].path == objects[i].path) {
+      // Only the last object given for a path is grafted.
+      continue;
+    }
+    auto& object = objects[i];
+    if (object.type == facebook::eden::ObjectType::SYMLINK) {
+      XLOG(DBG3) << "setPathObjectIds called with symlink for object with id "
+                 << object.id << " at path" << object.path;
+    }
+    bool isTree = object.type == facebook::eden::ObjectType::TREE;
+    auto target = isTree ? object.path : object.path.dirname().copy();
+    groups[std::make_pair(std::move(target), !isTree)].push_back(
+        std::move(object));
+  }
+
+  std::vector<folly::Future<std::tuple<TreeInodePtr, shared_ptr<const Tree>>>>
+      lookups;
+  lookups.reserve(groups.size());
+  for (auto& [key, group] : groups) {
+    auto& [target, isFiles] = key;
+    auto getTargetTreeInodeFuture =
+        ensureDirectoryExists(target, ctx->getFetchContext())
+            .semi()
+            .via(&folly::QueuedImmediateExecutor::instance());
+
+    folly::Future<shared_ptr<const Tree>> getRootTreeFuture;
+    if (!isFiles) {
+      getRootTreeFuture =
+          objectStore_->getRootTree(group.front().id, ctx->getFetchContext());
+    } else {
+      std::vector<folly::Future<std::shared_ptr<TreeEntry>>> entryFutures;
+      entryFutures.reserve(group.size());
+      for (auto& object : group) {
+        entryFutures.push_back(objectStore_->getTreeEntryForRootId(
+            object.id,
+            toEdenTreeEntryType(object.type),
+            object.path.basename(),
+            ctx->getFetchContext()));
+      }
+      getRootTreeFuture =
+          folly::collect(std::move(entryFutures))
+              .via(&folly::QueuedImmediateExecutor::instance())
+              .thenValue([](std::vector<std::shared_ptr<TreeEntry>> entries) {
+                // The group is sorted by path, hence the entries by name.
+                std::vector<TreeEntry> treeEntries;
+                treeEntries.reserve(entries.size());
+                for (auto& entry : entries) {
+                  treeEntries.push_back(std::move(*entry));
+                }
+                // Make up a fake ObjectId for this tree, as in
+                // setPathObjectId.
+                ObjectId fakeObjectId{};
+                return std::make_shared<const Tree>(
+                    std::move(treeEntries), fakeObjectId);
+              });
+    }
+    lookups.push_back(
+        collectSafe(getTargetTreeInodeFuture, getRootTreeFuture));
+  }
+
+  return folly::collectAll(std::move(lookups))
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenValue([this, ctx, setPathObjectIdTime, stopWatch](
+                     std::vector<folly::Try<
+                         std::tuple<TreeInodePtr, shared_ptr<const Tree>>>>
+                         results) {
+        setPathObjectIdTime->didLookupTreesOrGetInodeByPath =
+            stopWatch.elapsed();
+        for (auto& result : results) {
+          result.throwUnlessValue();
+        }
+
+        // Hold the rename lock until every directory was checked out, so that
+        // none of them can be moved in the middle of the batch.
+        ctx->holdRenameLock(acquireRenameLock());
+        auto checkoutFuture = folly::makeFuture();
+        for (auto& result : results) {
+          auto lookup = std::move(result).value();
+          checkoutFuture =
+              std::move(checkoutFuture)
+                  .thenValue([ctx,
+                              targetTreeInode = std::get<0>(std::move(lookup)),
+                              incomingTree = std::get<1>(std::move(lookup))](
+                                 auto&&) {
+                    targetTreeInode->unloadChildrenUnreferencedByFs();
+                    return targetTreeInode->checkout(
+                        ctx.get(), nullptr, incomingTree);
+                  });
+        }
+        return std::move(checkoutFuture).ensure([ctx] {
+          ctx->releaseRenameLock();
+        });
+      })
+      .thenValue([ctx, setPathObjectIdTime, stopWatch](auto&&) {
+        setPathObjectIdTime->didCheckout = stopWatch.elapsed();
+        return ctx->flush();
+      })
+      .thenValue([ctx, setPathObjectIdTime, stopWatch](
+                     std::vector<CheckoutConflict>&& conflicts) {
+        setPathObjectIdTime->didFinish = stopWatch.elapsed();
+        SetPathObjectIdResultAndTimes resultAndTimes;
+        resultAndTimes.times = *setPathObjectIdTime;
+        SetPathObjectIdResult result;
+        result.conflicts_ref() = std::move(conflicts);
+        resultAndTimes.result = std::move(result);
+        return resultAndTimes;
+      })
+      .thenTry([this, ctx, oldParent](
+                   Try<SetPathObjectIdResultAndTimes>&& resultAndTimes) {
+        auto fetchStats = ctx->getFetchContext().computeStatistics();
+        logStats(
+            resultAndTimes.hasValue(),
+            this->getPath(),
+            oldParent,
+            oldParent,
+            fetchStats,
+            "setPathObjectIds");
+        return std::move(resultAndTimes);
+      });
+}
 #endif // !_WIN32
 
 void EdenMount::destroy() {
@@ -781,10 +1117,35 @@ void EdenMount::destroy() {
 folly::SemiFuture<SerializedInodeMap> EdenMount::shutdown(
     bool doTakeover,
     bool allowFuseNotStarted) {
+  auto deferredInitialization = deferredInitialization_.wlock();
+  bool deferred = deferredInitialization->deferred;
+  if (deferredInitialization->progressCallback && !doTakeover) {
+    // Nothing was loaded, so there is no need to initialize the mount just
+    // to unload it.
+    deferredInitialization->progressCallback.reset();
+    auto& initialized = deferredInitialization->initialized;
+    deferredInitialization.unlock();
+    initialized.setException(std::runtime_error(folly::to<std::string>(
+        "mount ", getPath(), " was shut down before it was initialized")));
+  } else if (deferred && !deferredInitialization->initialized.isFulfilled()) {
+    // Let a deferred initialization in progress finish before unloading the
+    // inodes it loads. A graceful restart hands the inode map of an
+    // initialized mount to the new process, so it starts the initialization
+    // if nothing has yet.
+    deferredInitialization.unlock();
+    return ensureInitialized().semi().deferTry(
+        [this, doTakeover, allowFuseNotStarted](Try<Unit>&&) {
+          return shutdown(doTakeover, allowFuseNotStarted);
+        });
+  } else {
+    deferredInitialization.unlock();
+  }
+
   // shutdown() should only be called on mounts that have not yet reached
   // SHUTTING_DOWN or later states.  Confirm this is the case, and move to
-  // SHUTTING_DOWN.
-  if (!(allowFuseNotStarted &&
+  // SHUTTING_DOWN. Mounts with deferred initialization may be running
+  // without ever having been initialized.
+  if (!((allowFuseNotStarted || deferred) &&
         (tryToTransitionState(State::UNINITIALIZED, State::SHUTTING_DOWN) ||
          tryToTransitionState(State::INITIALIZING, State::SHUTTING_DOWN) ||
          tryToTransitionState(State::INITIALIZED, State::SHUTTING_DOWN))) &&
@@ -805,6 +1166,7 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
   return inodeMap_->shutdown(doTakeover)
       .thenValue([this](SerializedInodeMap inodeMap) {
         XLOG(DBG1) << "shutdown complete for EdenMount " << getPath();
+        saveJournal();
         // Close the Overlay object to make sure we have released its lock.
         // This is important during graceful restart to ensure that we have
         // released the lock before the new edenfs process begins to take over
@@ -985,6 +1347,20 @@ std::shared_ptr<const Tree> EdenMount::getCheckedOutRootTree() const {
   return parentState_.rlock()->checkedOutRootTree;
 }
 
+std::shared_ptr<const TreeFilter> EdenMount::getCheckoutFilter() const {
+  return checkoutFilter_.copy();
+}
+
+folly::Future<std::shared_ptr<const Tree>> EdenMount::getFilteredRootTree(
+    const RootId& rootId,
+    ObjectFetchContext& context) const {
+  return objectStore_->getRootTree(rootId, context)
+      .thenValue([filter = getCheckoutFilter()](
+                     std::shared_ptr<const Tree> tree) {
+        return filter->apply(std::move(tree));
+      });
+}
+
 namespace {
 
 class TreeLookupProcessor {
@@ -1141,7 +1517,23 @@ InodeNumber EdenMount::getDotEdenInodeNumber() const {
 ImmediateFuture<InodePtr> EdenMount::getInodeSlow(
     RelativePathPiece path,
     ObjectFetchContext& context) const {
-  return inodeMap_->getRootInode()->getChildRecursive(path, context);
+  if (auto ino = pathInodeCache_.get(path)) {
+    // Only loaded inodes are used, since loading one by number needs the
+    // path anyway.
+    if (auto inode = inodeMap_->lookupLoadedInode(*ino)) {
+      return inode;
+    }
+  }
+
+  // Read the generation first, so that a change racing with the walk keeps
+  // its result out of the cache.
+  auto generation = pathInodeCache_.getGeneration();
+  return inodeMap_->getRootInode()
+      ->getChildRecursive(path, context)
+      .thenValue([this, path = path.copy(), generation](InodePtr inode) {
+        pathInodeCache_.insert(path, inode->getNodeId(), generation);
+        return inode;
+      });
 }
 
 namespace {
@@ -1321,6 +1713,18 @@ ImmediateFuture<folly::Unit> EdenMount::waitForPendingNotifications() const {
   if (auto* channel = getPrjfsChannel()) {
     return channel->waitForPendingNotifications();
   }
+#elif defined(__linux__)
+  if (getFuseChannel() && checkoutConfig_->getFuseWritebackCache()) {
+    // With FUSE_WRITEBACK_CACHE, writes may still sit in the kernel's page
+    // cache. syncfs() makes the kernel send them to us, which requires that
+    // the caller holds no inode locks and is not a FUSE worker thread.
+    return ImmediateFuture<folly::Unit>{
+        folly::via(getServerThreadPool().get(), [path = getPath()] {
+          folly::File root{path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC};
+          folly::checkUnixError(
+              syncfs(root.fd()), "unable to flush cached writes to ", path);
+        }).semi()};
+  }
 #endif
   return folly::unit;
 }
@@ -1329,11 +1733,14 @@ folly::Future<CheckoutResult> EdenMount::checkout(
     const RootId& snapshotHash,
     std::optional<pid_t> clientPid,
     folly::StringPiece thriftMethodCaller,
-    CheckoutMode checkoutMode) {
+    CheckoutMode checkoutMode,
+    std::shared_ptr<const TreeFilter> newFilter) {
   const folly::stop_watch<> stopWatch;
   auto checkoutTimes = std::make_shared<CheckoutTimes>();
 
   RootId oldParent;
+  bool resuming = false;
+  folly::CancellationToken cancellation;
   {
     auto parentLock = parentState_.wlock();
     if (parentLock->checkoutInProgress) {
@@ -1344,16 +1751,54 @@ folly::Future<CheckoutResult> EdenMount::checkout(
           EdenErrorType::CHECKOUT_IN_PROGRESS,
           "another checkout operation is still in progress"));
     }
+    if (parentLock->interruptedCheckoutFrom.has_value()) {
+      // The working copy is partly at the interrupted checkout's source and
+      // partly at its destination. Only a checkout to the destination, or a
+      // forced one, knows how to bring all of it to a single commit.
+      resuming = snapshotHash == parentLock->checkedOutRootId;
+      if (!resuming && checkoutMode != CheckoutMode::FORCE) {
+        return makeFuture<CheckoutResult>(newEdenError(
+            EdenErrorType::CHECKOUT_IN_PROGRESS,
+            "a previous checkout to ",
+            parentLock->checkedOutRootId,
+            " was interrupted, check it out again to resume it"));
+      }
+      oldParent = parentLock->interruptedCheckoutFrom.value();
+    } else {
+      oldParent = parentLock->workingCopyParentRootId;
+    }
     // Set checkoutInProgress and release the lock. An alternative way of
     // achieving the same would be to hold the lock during the checkout
     // operation, but this might lead to deadlocks on Windows due to callbacks
     // needing to access the parent commit to service callbacks.
     parentLock->checkoutInProgress = true;
-    oldParent = parentLock->workingCopyParentRootId;
+    parentLock->checkoutCancellation = folly::CancellationSource{};
+    if (!newFilter) {
+      // An interrupted filter change could not be told apart from a commit
+      // change when resuming it, so it cannot be cancelled.
+      cancellation = parentLock->checkoutCancellation.getToken();
+    }
+  }
+  auto oldFilter = getCheckoutFilter();
+  if (!newFilter) {
+    newFilter = oldFilter;
   }
 
+  // Checking out a new commit usually follows pulling new data, so objects
+  // that were missing before may be available now.
+  objectStore_->invalidateNegativeCache();
+
   auto ctx = std::make_shared<CheckoutContext>(
-      this, checkoutMode, clientPid, thriftMethodCaller);
+      this,
+      checkoutMode,
+      clientPid,
+      thriftMethodCaller,
+      nullptr,
+      std::move(cancellation),
+      resuming);
+  if (resuming) {
+    XLOG(DBG1) << "resuming interrupted checkout for " << this->getPath();
+  }
   XLOG(DBG1) << "starting checkout for " << this->getPath() << ": " << oldParent
              << " to " << snapshotHash;
 
@@ -1367,12 +1812,23 @@ folly::Future<CheckoutResult> EdenMount::checkout(
   return serverState_->getFaultInjector()
       .checkAsync("checkout", getPath().stringPiece())
       .via(getServerThreadPool().get())
-      .thenValue([this, ctx, parent1Hash = oldParent, snapshotHash](auto&&) {
+      .thenValue([this,
+                  ctx,
+                  parent1Hash = oldParent,
+                  snapshotHash,
+                  oldFilter,
+                  newFilter](auto&&) {
         XLOG(DBG7) << "Checkout: getRoots";
         auto fromTreeFuture =
-            objectStore_->getRootTree(parent1Hash, ctx->getFetchContext());
+            objectStore_->getRootTree(parent1Hash, ctx->getFetchContext())
+                .thenValue([oldFilter](std::shared_ptr<const Tree> tree) {
+                  return oldFilter->apply(std::move(tree));
+                });
         auto toTreeFuture =
-            objectStore_->getRootTree(snapshotHash, ctx->getFetchContext());
+            objectStore_->getRootTree(snapshotHash, ctx->getFetchContext())
+                .thenValue([newFilter](std::shared_ptr<const Tree> tree) {
+                  return newFilter->apply(std::move(tree));
+                });
         return collectSafe(fromTreeFuture, toTreeFuture);
       })
       .thenValue(
@@ -1390,22 +1846,51 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                          treeResults) {
         XLOG(DBG7) << "Checkout: performDiff";
         checkoutTimes->didLookupTrees = stopWatch.elapsed();
+        auto& fromTree = std::get<0>(treeResults);
+
+        // Fetch the trees the checkout may need while the journal diff runs.
+        auto prefetchConcurrency =
+            getEdenConfig()->checkoutTreePrefetchConcurrency.getValue();
+        auto prefetchFuture = prefetchConcurrency > 0
+            ? prefetchChangedTrees(
+                  objectStore_,
+                  fromTree,
+                  std::get<1>(treeResults),
+                  ctx->getFetchContext(),
+                  prefetchConcurrency)
+            : folly::makeSemiFuture(size_t{0});
+
         // Call JournalDiffCallback::performDiff() to compute the changes
         // between the original working directory state and the source
         // tree state.
         //
         // If we are doing a dry-run update we aren't going to create a
         // journal entry, so we can skip this step entirely.
-        if (ctx->isDryRun()) {
-          return folly::makeFuture(treeResults);
-        }
+        auto diffFuture = ctx->isDryRun()
+            ? folly::makeFuture(treeResults)
+            : journalDiffCallback->performDiff(this, getRootInode(), fromTree)
+                  .thenValue([ctx, journalDiffCallback, treeResults](
+                                 const StatsFetchContext& diffFetchContext) {
+                    ctx->getFetchContext().merge(diffFetchContext);
+                    return treeResults;
+                  });
 
-        auto& fromTree = std::get<0>(treeResults);
-        return journalDiffCallback->performDiff(this, getRootInode(), fromTree)
-            .thenValue([ctx, journalDiffCallback, treeResults](
-                           const StatsFetchContext& diffFetchContext) {
-              ctx->getFetchContext().merge(diffFetchContext);
-              return treeResults;
+        // The prefetch uses the checkout's fetch context, so wait for it
+        // even if the diff failed.
+        return std::move(diffFuture)
+            .thenTry([ctx, prefetchFuture = std::move(prefetchFuture)](
+                         folly::Try<std::tuple<
+                             shared_ptr<const Tree>,
+                             shared_ptr<const Tree>>>&& diffResult) mutable {
+              return std::move(prefetchFuture)
+                  .deferTry([ctx, diffResult = std::move(diffResult)](
+                                folly::Try<size_t>&& fetched) mutable {
+                    if (fetched.hasValue() && *fetched > 0) {
+                      XLOG(DBG3) << "Checkout: prefetched " << *fetched
+                                 << " trees";
+                    }
+                    return std::move(diffResult).value();
+                  });
             });
       })
       .thenValue([this, ctx, checkoutTimes, stopWatch, snapshotHash](
@@ -1413,6 +1898,11 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                          treeResults) {
         checkoutTimes->didDiff = stopWatch.elapsed();
 
+        // Nothing was changed yet, so the checkout can simply stop.
+        if (ctx->isCancelled()) {
+          throw newCheckoutCancelledError(snapshotHash);
+        }
+
         // Perform the requested checkout operation after the journal diff
         // completes. This also updates the SNAPSHOT file to make sure that an
         // interrupted checkout can be properly detected.
@@ -1462,15 +1952,38 @@ folly::Future<CheckoutResult> EdenMount::checkout(
       .thenValue([ctx, checkoutTimes, stopWatch, snapshotHash](auto&&) {
         checkoutTimes->didCheckout = stopWatch.elapsed();
 
+        if (ctx->isCancelled()) {
+          // The directories the checkout didn't get to are left as they were,
+          // and the SNAPSHOT file still records the checkout as in progress.
+          return ctx->interrupt().thenValue(
+              [snapshotHash](auto&&) -> std::vector<CheckoutConflict> {
+                throw newCheckoutCancelledError(snapshotHash);
+              });
+        }
+
         // Complete the checkout
         return ctx->finish(snapshotHash);
       })
-      .ensure([this]() {
+      .thenTry([this, ctx, oldParent, oldFilter, newFilter](
+                   folly::Try<std::vector<CheckoutConflict>>&& result) {
         // Checkout completed, make sure to always reset the checkoutInProgress
         // flag!
         auto parentLock = parentState_.wlock();
         XCHECK(parentLock->checkoutInProgress);
         parentLock->checkoutInProgress = false;
+        if (ctx->isInterrupted()) {
+          // The parent was moved, but not all of the working copy was.
+          parentLock->interruptedCheckoutFrom = oldParent;
+        } else if (result.hasValue() && !ctx->isDryRun()) {
+          parentLock->interruptedCheckoutFrom.reset();
+          if (*newFilter != *oldFilter) {
+            // The working copy already matches the new filter, so use it even
+            // if it cannot be saved.
+            *checkoutFilter_.wlock() = newFilter;
+            checkoutConfig_->setFilteredPaths(newFilter->getExcludedPaths());
+          }
+        }
+        return folly::makeFuture(std::move(result));
       })
       .thenValue(
           [this,
@@ -1507,11 +2020,30 @@ folly::Future<CheckoutResult> EdenMount::checkout(
             journal_->recordUncleanPaths(
                 oldParent, snapshotHash, std::move(uncleanPaths));
 
+            replayRecordedPrefetchProfiles();
+
             return result;
           })
-      .thenTry([this, ctx, stopWatch, oldParent, snapshotHash, checkoutMode](
-                   Try<CheckoutResult>&& result) {
+      .thenTry([this,
+                ctx,
+                checkoutTimes,
+                stopWatch,
+                oldParent,
+                snapshotHash,
+                checkoutMode](Try<CheckoutResult>&& result) {
         auto fetchStats = ctx->getFetchContext().computeStatistics();
+
+        CheckoutTraceEvent traceEvent;
+        traceEvent.fromRoot = oldParent;
+        traceEvent.toRoot = snapshotHash;
+        traceEvent.mode = checkoutMode;
+        traceEvent.success = result.hasValue();
+        traceEvent.times = *checkoutTimes;
+        traceEvent.duration = stopWatch.elapsed();
+        traceEvent.fetchedTrees = fetchStats.tree.fetchCount;
+        traceEvent.fetchedBlobs = fetchStats.blob.fetchCount;
+        checkoutTraceBus_->publish(std::move(traceEvent));
+
         logStats(
             result.hasValue(),
             this->getPath(),
@@ -1536,6 +2068,62 @@ folly::Future<CheckoutResult> EdenMount::checkout(
       });
 }
 
+void EdenMount::replayRecordedPrefetchProfiles() {
+  auto config = getEdenConfig();
+  if (!config->enablePrefetchProfiles.getValue() ||
+      !config->replayRecordedPrefetchProfiles.getValue()) {
+    return;
+  }
+
+  auto rootTree = parentState_.rlock()->checkedOutRootTree;
+  if (!rootTree) {
+    return;
+  }
+  // Checkout does not wait for the prefetch: it only warms the caches for
+  // the reads that are expected to follow.
+  folly::futures::detachOn(
+      getServerThreadPool()->getLowPriorityExecutor(),
+      recordedPrefetchProfiles_.replay(std::move(rootTree), objectStore_)
+          .thenTry([path = getPath()](folly::Try<size_t>&& count) {
+            if (count.hasException()) {
+              XLOG(WARN) << "error replaying prefetch profiles for " << path
+                         << ": " << count.exception().what();
+            } else if (count.value() > 0) {
+              XLOG(DBG2) << "prefetched " << count.value()
+                         << " blobs from recorded profiles for " << path;
+            }
+          })
+          .semi());
+
+#ifdef _WIN32
+  auto* channel = getPrjfsChannel();
+  if (channel && config->prjfsWriteProfilePlaceholders.getValue()) {
+    std::vector<RelativePath> paths;
+    for (const auto& name : recordedPrefetchProfiles_.listProfiles()) {
+      auto profilePaths = recordedPrefetchProfiles_.loadProfile(name);
+      paths.insert(
+          paths.end(),
+          std::make_move_iterator(profilePaths.begin()),
+          std::make_move_iterator(profilePaths.end()));
+    }
+    folly::futures::detachOn(
+        getServerThreadPool().get(),
+        channel->writePlaceholders(std::move(paths))
+            .thenTry([path = getPath()](folly::Try<size_t>&& count) {
+              if (count.hasException()) {
+                XLOG(WARN) << "error writing placeholders for " << path
+                           << ": " << count.exception().what();
+              } else if (count.value() > 0) {
+                XLOG(DBG2) << "wrote " << count.value()
+                           << " placeholders from recorded profiles for "
+                           << path;
+              }
+            })
+            .semi());
+  }
+#endif
+}
+
 void EdenMount::forgetStaleInodes() {
   inodeMap_->forgetStaleInodes();
 }
@@ -1561,6 +2149,19 @@ ImmediateFuture<folly::Unit> EdenMount::flushInvalidations() {
 #endif
 }
 
+ImmediateFuture<folly::Unit> EdenMount::flushCheckoutInvalidations() {
+#ifndef _WIN32
+  auto* fuseChannel = getFuseChannel();
+  if (fuseChannel &&
+      !getEdenConfig()->fuseCheckoutWaitsForAllInvalidations.getValue()) {
+    XLOG(DBG4) << "waiting for urgent inode invalidations to complete";
+    return ImmediateFuture<folly::Unit>{
+        fuseChannel->flushUrgentInvalidations().semi()};
+  }
+#endif
+  return flushInvalidations();
+}
+
 #ifndef _WIN32
 folly::Future<folly::Unit> EdenMount::chown(uid_t uid, gid_t gid) {
   // 1) Ensure that all future opens will by default provide this owner
@@ -1601,7 +2202,8 @@ file.
 std::unique_ptr<DiffContext> EdenMount::createDiffContext(
     DiffCallback* callback,
     folly::CancellationToken cancellation,
-    bool listIgnored) const {
+    bool listIgnored,
+    std::vector<RelativePath> pathPrefixes) const {
   // We hold a reference to the root inode to ensure that
   // the EdenMount cannot be destroyed while the DiffContext
   // is still using it.
@@ -1618,13 +2220,16 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       getCheckoutConfig()->getCaseSensitive(),
       getObjectStore(),
       serverState_->getTopLevelIgnores(),
-      std::move(loadContents));
+      std::move(loadContents),
+      getEdenConfig()->diffMaxConcurrentTreeFetches.getValue(),
+      getServerThreadPool().get(),
+      std::move(pathPrefixes));
 }
 
 Future<Unit> EdenMount::diff(DiffContext* ctxPtr, const RootId& commitHash)
     const {
   auto rootInode = getRootInode();
-  return objectStore_->getRootTree(commitHash, ctxPtr->getFetchContext())
+  return getFilteredRootTree(commitHash, ctxPtr->getFetchContext())
       .thenValue([this](std::shared_ptr<const Tree> rootTree) {
         return waitForPendingNotifications()
             .thenValue(
@@ -1642,42 +2247,58 @@ Future<Unit> EdenMount::diff(DiffContext* ctxPtr, const RootId& commitHash)
       });
 }
 
+folly::exception_wrapper EdenMount::checkCurrentParent(
+    const RootId& commitHash) const {
+  auto parentInfo = parentState_.rlock();
+
+  if (parentInfo->checkoutInProgress) {
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::CHECKOUT_IN_PROGRESS,
+        "cannot compute status while a checkout is currently in progress")};
+  }
+  if (parentInfo->interruptedCheckoutFrom.has_value()) {
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::CHECKOUT_IN_PROGRESS,
+        "cannot compute status while a checkout to ",
+        parentInfo->checkedOutRootId,
+        " is interrupted, check it out again to resume it")};
+  }
+
+  if (parentInfo->workingCopyParentRootId != commitHash) {
+    // Log this occurrence to Scuba
+    getServerState()->getStructuredLogger()->logEvent(ParentMismatch{
+        commitHash.value(), parentInfo->workingCopyParentRootId.value()});
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::OUT_OF_DATE_PARENT,
+        "error computing status: requested parent commit is out-of-date: requested ",
+        commitHash,
+        ", but current parent commit is ",
+        parentInfo->workingCopyParentRootId,
+        ".\nTry running `eden doctor` to remediate")};
+  }
+
+  return folly::exception_wrapper{};
+}
+
 Future<Unit> EdenMount::diff(
     DiffCallback* callback,
     const RootId& commitHash,
     bool listIgnored,
     bool enforceCurrentParent,
-    folly::CancellationToken cancellation) const {
+    folly::CancellationToken cancellation,
+    std::vector<RelativePath> pathPrefixes) const {
   if (enforceCurrentParent) {
-    auto parentInfo = parentState_.rlock();
-
-    if (parentInfo->checkoutInProgress) {
-      return makeFuture<Unit>(newEdenError(
-          EdenErrorType::CHECKOUT_IN_PROGRESS,
-          "cannot compute status while a checkout is currently in progress"));
-    }
-
-    if (parentInfo->workingCopyParentRootId != commitHash) {
-      // Log this occurrence to Scuba
-      getServerState()->getStructuredLogger()->logEvent(ParentMismatch{
-          commitHash.value(), parentInfo->workingCopyParentRootId.value()});
-      return makeFuture<Unit>(newEdenError(
-          EdenErrorType::OUT_OF_DATE_PARENT,
-          "error computing status: requested parent commit is out-of-date: requested ",
-          commitHash,
-          ", but current parent commit is ",
-          parentInfo->workingCopyParentRootId,
-          ".\nTry running `eden doctor` to remediate"));
+    if (auto error = checkCurrentParent(commitHash)) {
+      return makeFuture<Unit>(std::move(error));
     }
-
-    // TODO: Should we perhaps hold the parentInfo read-lock for the duration
+    // TODO: Should we perhaps hold the parent read-lock for the duration
     // of the status operation?  This would block new checkout operations from
     // starting until we have finished computing this status call.
   }
 
   // Create a DiffContext object for this diff operation.
-  auto context =
-      createDiffContext(callback, std::move(cancellation), listIgnored);
+  auto context = createDiffContext(
+      callback, std::move(cancellation), listIgnored, std::move(pathPrefixes));
   DiffContext* ctxPtr = context.get();
 
   // stateHolder() exists to ensure that the DiffContext and GitIgnoreStack
@@ -1691,30 +2312,144 @@ folly::Future<std::unique_ptr<ScmStatus>> EdenMount::diff(
     const RootId& commitHash,
     folly::CancellationToken cancellation,
     bool listIgnored,
-    bool enforceCurrentParent) {
-  auto callback = std::make_unique<ScmStatusDiffCallback>();
-  auto callbackPtr = callback.get();
-  return this
-      ->diff(
-          callbackPtr,
-          commitHash,
-          listIgnored,
-          enforceCurrentParent,
-          std::move(cancellation))
-      .thenValue([callback = std::move(callback)](auto&&) {
-        return std::make_unique<ScmStatus>(callback->extractStatus());
-      });
+    bool enforceCurrentParent,
+    std::vector<RelativePath> pathPrefixes) {
+  auto fullDiff = [this, commitHash, cancellation, listIgnored, pathPrefixes](
+                      bool enforceCurrentParent) {
+    auto callback = std::make_unique<ScmStatusDiffCallback>();
+    auto callbackPtr = callback.get();
+    return this
+        ->diff(
+            callbackPtr,
+            commitHash,
+            listIgnored,
+            enforceCurrentParent,
+            std::move(cancellation),
+            std::move(pathPrefixes))
+        .thenValue([callback = std::move(callback)](auto&&) {
+          return std::make_unique<ScmStatus>(callback->extractStatus());
+        });
+  };
+
+  // The status cache only holds the status of the whole working copy.
+  if (!pathPrefixes.empty() || !getEdenConfig()->incrementalStatus.getValue() ||
+      getCheckoutConfig()->getCaseSensitive() != CaseSensitivity::Sensitive) {
+    return fullDiff(enforceCurrentParent);
+  }
+  if (enforceCurrentParent) {
+    if (auto error = checkCurrentParent(commitHash)) {
+      return makeFuture<std::unique_ptr<ScmStatus>>(std::move(error));
+    }
+  }
+  // The journal doesn't record the changes a checkout makes until it is done.
+  if (parentState_.rlock()->checkoutInProgress) {
+    return fullDiff(false);
+  }
+
+  return statusCache_
+      .get(commitHash, listIgnored, ObjectFetchContext::getNullContext())
+      .thenValue([this,
+                  commitHash,
+                  listIgnored,
+                  fullDiff = std::move(fullDiff)](
+                     std::optional<ScmStatus> cached) mutable
+                 -> ImmediateFuture<std::unique_ptr<ScmStatus>> {
+        if (cached) {
+          return std::make_unique<ScmStatus>(std::move(*cached));
+        }
+
+        auto before = journal_->getLatest();
+        return ImmediateFuture<std::unique_ptr<ScmStatus>>{
+            fullDiff(false).thenValue(
+                [this, commitHash, listIgnored, before](
+                    std::unique_ptr<ScmStatus> status) {
+                  // Only cache the status if the working copy didn't change
+                  // while it was computed.
+                  auto after = journal_->getLatest();
+                  if (before && after &&
+                      before->sequenceID == after->sequenceID &&
+                      !parentState_.rlock()->checkoutInProgress) {
+                    statusCache_.insert(
+                        commitHash, listIgnored, before->sequenceID, *status);
+                  }
+                  return status;
+                })};
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
 }
 
 ImmediateFuture<folly::Unit> EdenMount::diffBetweenRoots(
     const RootId& fromRoot,
     const RootId& toRoot,
     folly::CancellationToken cancellation,
-    DiffCallback* callback) {
-  auto diffContext = createDiffContext(callback, cancellation, true);
+    DiffCallback* callback,
+    std::vector<RelativePath> pathPrefixes) {
+  // Subtrees are diffed concurrently; sort the results so that callers see
+  // them in the same order from one run to the next.
+  auto sortedCallback = std::make_unique<SortedDiffCallback>(callback);
+  auto diffContext = createDiffContext(
+      sortedCallback.get(), cancellation, true, std::move(pathPrefixes));
   auto fut =
       ImmediateFuture{diffRoots(diffContext.get(), fromRoot, toRoot).semi()};
-  return std::move(fut).ensure([diffContext = std::move(diffContext)] {});
+  return std::move(fut)
+      .thenValue([sortedCallback = sortedCallback.get()](folly::Unit) {
+        sortedCallback->flush();
+      })
+      .ensure([diffContext = std::move(diffContext),
+               sortedCallback = std::move(sortedCallback)] {});
+}
+
+ImmediateFuture<std::unique_ptr<ScmStatus>>
+EdenMount::getScmStatusBetweenRoots(
+    const RootId& fromRoot,
+    const RootId& toRoot,
+    folly::CancellationToken cancellation,
+    std::vector<RelativePath> pathPrefixes) {
+  if (!pathPrefixes.empty()) {
+    auto callback = std::make_unique<ScmStatusDiffCallback>();
+    auto* callbackPtr = callback.get();
+    return diffBetweenRoots(
+               fromRoot,
+               toRoot,
+               std::move(cancellation),
+               callbackPtr,
+               std::move(pathPrefixes))
+        .thenValue([callback = std::move(callback)](folly::Unit) {
+          return std::make_unique<ScmStatus>(callback->extractStatus());
+        });
+  }
+
+  auto cache = ScmStatusCache{
+      objectStore_, getCheckoutConfig()->getCaseSensitive()};
+  if (auto status = cache.get(fromRoot, toRoot)) {
+    return std::make_unique<ScmStatus>(std::move(*status));
+  }
+
+  auto storeResult = [cache, fromRoot, toRoot](ScmStatus&& status) {
+    cache.insert(fromRoot, toRoot, status);
+    return std::make_unique<ScmStatus>(std::move(status));
+  };
+
+  for (const auto& via : journal_->getRecentRoots(kMaxScmStatusViaRoots)) {
+    if (via == fromRoot || via == toRoot) {
+      continue;
+    }
+    auto composed = cache.compose(
+        fromRoot, via, toRoot, ObjectFetchContext::getNullContext());
+    if (composed) {
+      return std::move(*composed).thenValue(std::move(storeResult));
+    }
+  }
+
+  auto callback = std::make_unique<ScmStatusDiffCallback>();
+  auto* callbackPtr = callback.get();
+  return diffBetweenRoots(
+             fromRoot, toRoot, std::move(cancellation), callbackPtr)
+      .thenValue([callback = std::move(callback),
+                  storeResult = std::move(storeResult)](folly::Unit) {
+        return storeResult(callback->extractStatus());
+      });
 }
 
 void EdenMount::resetParent(const RootId& parent) {
@@ -1726,18 +2461,59 @@ void EdenMount::resetParent(const RootId& parent) {
         EdenErrorType::CHECKOUT_IN_PROGRESS,
         "cannot reset parent while a checkout is currently in progress");
   }
+  if (parentLock->interruptedCheckoutFrom.has_value()) {
+    throw newEdenError(
+        EdenErrorType::CHECKOUT_IN_PROGRESS,
+        "cannot reset parent while a checkout to ",
+        parentLock->checkedOutRootId,
+        " is interrupted, check it out again to resume it");
+  }
 
   auto oldParent = parentLock->workingCopyParentRootId;
   XLOG(DBG1) << "resetting snapshot for " << this->getPath() << " from "
              << oldParent << " to " << parent;
 
-  // TODO: Maybe we should walk the inodes and see if we can dematerialize
-  // some files using the new source control state.
-
   checkoutConfig_->setWorkingCopyParentCommit(parent);
   parentLock->workingCopyParentRootId = parent;
 
   journal_->recordHashUpdate(oldParent, parent);
+  parentLock.unlock();
+
+  // The new parent is typically a commit of the working copy's changes, so
+  // the directories that were materialized for them may now be identical to
+  // its trees.
+  if (serverState_->getEdenConfig()->dematerializeOnResetParent.getValue()) {
+    folly::futures::detachOn(
+        getServerThreadPool()->getLowPriorityExecutor(),
+        dematerializeUnchangedDirectories(folly::CancellationToken{})
+            .thenTry([path = getPath()](folly::Try<size_t>&& count) {
+              if (count.hasException()) {
+                XLOG(WARN) << "error dematerializing directories of " << path
+                           << ": " << count.exception().what();
+              }
+            })
+            .semi());
+  }
+}
+
+ImmediateFuture<size_t> EdenMount::dematerializeUnchangedDirectories(
+    folly::CancellationToken cancel) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "EdenMount::dematerializeUnchangedDirectories");
+  return ImmediateFuture{
+      getFilteredRootTree(getWorkingCopyParent(), *context).semi()}
+      .thenValue([rootInode = getRootInode(), cancel = std::move(cancel)](
+                     std::shared_ptr<const Tree> rootTree) {
+        return rootInode->dematerializeUnchanged(
+            rootTree->getHash(), *context, cancel);
+      })
+      .thenValue([path = getPath()](size_t count) {
+        if (count > 0) {
+          XLOG(DBG2) << "dematerialized " << count
+                     << " unchanged directories of " << path;
+        }
+        return count;
+      });
 }
 
 EdenTimestamp EdenMount::getLastCheckoutTime() const {
@@ -1749,6 +2525,16 @@ void EdenMount::setLastCheckoutTime(EdenTimestamp time) {
   lastCheckoutTime_.store(time, std::memory_order_release);
 }
 
+bool EdenMount::cancelCheckout() {
+  auto parentLock = parentState_.rlock();
+  if (!parentLock->checkoutInProgress) {
+    return false;
+  }
+  XLOG(DBG1) << "cancelling checkout for " << getPath();
+  parentLock->checkoutCancellation.requestCancellation();
+  return true;
+}
+
 bool EdenMount::isCheckoutInProgress() {
   auto parentLock = parentState_.rlock();
   return parentLock->checkoutInProgress;
@@ -1770,8 +2556,28 @@ std::string EdenMount::getCounterName(CounterName name) {
       return folly::to<std::string>("inodemap.", base, ".loaded");
     case CounterName::INODEMAP_UNLOADED:
       return folly::to<std::string>("inodemap.", base, ".unloaded");
+    case CounterName::INODEMAP_UNLOADED_BYTES_PER_INODE:
+      return folly::to<std::string>(
+          "inodemap.", base, ".unloaded_bytes_per_inode");
     case CounterName::JOURNAL_MEMORY:
       return folly::to<std::string>("journal.", base, ".memory");
+    case CounterName::SPECULATIVE_PREFETCH_TREES:
+      return folly::to<std::string>("prefetch.", base, ".speculative_trees");
+    case CounterName::SPECULATIVE_PREFETCH_HITS:
+      return folly::to<std::string>("prefetch.", base, ".speculative_hits");
+    case CounterName::SPECULATIVE_PREFETCH_HIT_RATE:
+      return folly::to<std::string>(
+          "prefetch.", base, ".speculative_hit_rate_pct");
+    case CounterName::OVERLAY_BYTES_CLONED:
+      return folly::to<std::string>("overlay.", base, ".bytes_cloned");
+    case CounterName::OVERLAY_BYTES_COPIED:
+      return folly::to<std::string>("overlay.", base, ".bytes_copied");
+    case CounterName::OVERLAY_BYTES_DEDUPLICATED:
+      return folly::to<std::string>("overlay.", base, ".bytes_deduplicated");
+    case CounterName::OVERLAY_GC_BACKLOG:
+      return folly::to<std::string>("overlay.", base, ".gc_backlog");
+    case CounterName::OVERLAY_GC_BACKLOG_AGE:
+      return folly::to<std::string>("overlay.", base, ".gc_backlog_age_ms");
     case CounterName::JOURNAL_ENTRIES:
       return folly::to<std::string>("journal.", base, ".count");
     case CounterName::JOURNAL_DURATION:
@@ -1784,11 +2590,28 @@ std::string EdenMount::getCounterName(CounterName name) {
     case CounterName::PERIODIC_UNLINKED_INODE_UNLOAD:
       return folly::to<std::string>(
           "inodemap.", base, ".unloaded_unlinked_inodes");
+    case CounterName::MEMORY_INODES:
+      return folly::to<std::string>("memory.", base, ".inodes");
+    case CounterName::MEMORY_OVERLAY_FILE_CACHE:
+      return folly::to<std::string>("memory.", base, ".overlay_file_cache");
+    case CounterName::MEMORY_TOTAL:
+      return folly::to<std::string>("memory.", base, ".total");
   }
   EDEN_BUG() << "unknown counter name "
              << static_cast<std::underlying_type_t<CounterName>>(name);
 }
 
+EdenMount::MemoryUsage EdenMount::estimateMemoryUsage() {
+  MemoryUsage usage;
+  auto counts = inodeMap_->getInodeCounts();
+  usage.inodes = counts.loadedInodeMemory + counts.unloadedInodeMemory;
+  usage.journal = journal_->estimateMemoryUsage();
+#ifndef _WIN32
+  usage.overlayFileCache = overlayFileAccess_.estimateMemoryUsage();
+#endif // !_WIN32
+  return usage;
+}
+
 folly::Future<TakeoverData::MountInfo> EdenMount::getChannelCompletionFuture() {
   return channelCompletionPromise_.getFuture();
 }
@@ -1812,7 +2635,14 @@ std::unique_ptr<FuseChannel, FuseChannelDeleter> makeFuseChannel(
       mount->getServerState()->getNotifier(),
       mount->getCheckoutConfig()->getCaseSensitive(),
       mount->getCheckoutConfig()->getRequireUtf8Path(),
-      edenConfig->fuseMaximumRequests.getValue())};
+      edenConfig->fuseMaximumRequests.getValue(),
+      edenConfig->fuseCloneDevicePerThread.getValue(),
+      edenConfig->fusePinWorkerThreads.getValue(),
+      edenConfig->fuseSpliceReadThreshold.getValue(),
+      edenConfig->fuseUseReaddirplus.getValue(),
+      edenConfig->fuseNumInvalidationThreads.getValue(),
+      mount->getCheckoutConfig()->getFuseWritebackCache(),
+      edenConfig->fuseMaxWrite.getValue())};
 }
 
 folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
@@ -1838,7 +2668,8 @@ folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
                        edenConfig->nfsRequestTimeout.getValue()),
                    mount->getServerState()->getNotifier(),
                    mount->getCheckoutConfig()->getCaseSensitive(),
-                   iosize);
+                   iosize,
+                   edenConfig->maxNfsInflightRequestsPerConnection.getValue());
              })
       .thenValue([mount, connectedSocket = std::move(connectedSocket)](
                      NfsServer::NfsMountInfo mountInfo) mutable {
@@ -1906,6 +2737,12 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
         if (shouldUseNFSMount_) {
           auto iosize = edenConfig->nfsIoSize.getValue();
           auto useReaddirplus = edenConfig->useReaddirplus.getValue();
+          auto fileAttrCacheTimeout =
+              std::chrono::duration_cast<std::chrono::seconds>(
+                  edenConfig->nfsFileAttributeCacheTimeout.getValue());
+          auto dirAttrCacheTimeout =
+              std::chrono::duration_cast<std::chrono::seconds>(
+                  edenConfig->nfsDirectoryAttributeCacheTimeout.getValue());
 
           // Make sure that we are running on the EventBase while registering
           // the mount point.
@@ -1915,6 +2752,8 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                readOnly,
                iosize,
                useReaddirplus,
+               fileAttrCacheTimeout,
+               dirAttrCacheTimeout,
                mountPromise = std::move(mountPromise),
                mountPath = std::move(mountPath)](
                   NfsServer::NfsMountInfo mountInfo) mutable {
@@ -1927,7 +2766,9 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                         channel->getAddr(),
                         readOnly,
                         iosize,
-                        useReaddirplus)
+                        useReaddirplus,
+                        fileAttrCacheTimeout,
+                        dirAttrCacheTimeout)
                     .thenTry([this,
                               mountPromise = std::move(mountPromise),
                               channel = std::move(channel)](
@@ -1990,8 +2831,14 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
 
 folly::Future<folly::Unit> EdenMount::startChannel(bool readOnly) {
   return folly::makeFutureWith([&]() {
-    transitionState(
-        /*expected=*/State::INITIALIZED, /*newState=*/State::STARTING);
+    // With deferred initialization the channel starts before the mount is
+    // initialized, and channelInitSuccessful() or ensureInitialized(),
+    // whichever finishes last, moves the mount to RUNNING.
+    bool deferred = deferredInitialization_.rlock()->deferred;
+    if (!deferred) {
+      transitionState(
+          /*expected=*/State::INITIALIZED, /*newState=*/State::STARTING);
+    }
 
     // Just in case the mount point directory doesn't exist,
     // automatically create it.
@@ -2039,8 +2886,10 @@ folly::Future<folly::Unit> EdenMount::startChannel(bool readOnly) {
               channel_);
 #endif
         })
-        .thenError([this](folly::exception_wrapper&& ew) {
-          transitionToFuseInitializationErrorState();
+        .thenError([this, deferred](folly::exception_wrapper&& ew) {
+          if (!deferred) {
+            transitionToFuseInitializationErrorState();
+          }
           return makeFuture<folly::Unit>(std::move(ew));
         });
   });
@@ -2133,10 +2982,20 @@ void EdenMount::preparePostChannelCompletion(
 
 void EdenMount::channelInitSuccessful(
     EdenMount::StopFuture&& channelCompleteFuture) {
-  // Try to transition to the RUNNING state.
-  // This state transition could fail if shutdown() was called before we saw
-  // the FUSE_INIT message from the kernel.
-  transitionState(State::STARTING, State::RUNNING);
+  {
+    auto deferred = deferredInitialization_.wlock();
+    if (deferred->deferred) {
+      deferred->channelStarted = true;
+      // If the deferred initialization has not finished yet,
+      // ensureInitialized() moves the mount to RUNNING when it does.
+      (void)tryToTransitionState(State::INITIALIZED, State::RUNNING);
+    } else {
+      // Try to transition to the RUNNING state.
+      // This state transition could fail if shutdown() was called before we
+      // saw the FUSE_INIT message from the kernel.
+      transitionState(State::STARTING, State::RUNNING);
+    }
+  }
 #ifndef _WIN32
   if (auto channel = std::get_if<NfsdChannelVariant>(&channel_)) {
     // Make sure that the Nfsd3 is destroyed in the EventBase that it was
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/Portability.h>
 #include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
@@ -29,12 +30,19 @@
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/inodes/InodeTimestamps.h"
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/PathInodeCache.h"
+#include "eden/fs/inodes/RecordedPrefetchProfiles.h"
+#include "eden/fs/inodes/SpeculativeTreePrefetcher.h"
+#include "eden/fs/inodes/WorkingCopyStatusCache.h"
 #include "eden/fs/journal/Journal.h"
 #include "eden/fs/model/RootId.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/BlobAccess.h"
+#include "eden/fs/store/NameIndex.h"
 #include "eden/fs/takeover/TakeoverData.h"
 #include "eden/fs/telemetry/IActivityRecorder.h"
+#include "eden/fs/telemetry/TraceBus.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 #ifndef _WIN32
@@ -78,6 +86,7 @@ class Overlay;
 class OverlayFileAccess;
 class ServerState;
 class Tree;
+class TreeFilter;
 class TreePrefetchLease;
 class UnboundedQueueExecutor;
 template <typename T>
@@ -99,10 +108,53 @@ enum class CounterName {
    * Represents count of unloaded inodes in the current mount.
    */
   INODEMAP_UNLOADED,
+  /**
+   * Represents the average memory used to remember each unloaded inode, in
+   * bytes.
+   */
+  INODEMAP_UNLOADED_BYTES_PER_INODE,
   /**
    * Represents the amount of memory used by deltas in the change log
    */
   JOURNAL_MEMORY,
+  /**
+   * Represents the number of trees speculatively prefetched after readdir
+   * that count towards the prefetch hit rate.
+   */
+  SPECULATIVE_PREFETCH_TREES,
+  /**
+   * Represents how many of those trees were later loaded.
+   */
+  SPECULATIVE_PREFETCH_HITS,
+  /**
+   * Represents the recent speculative prefetch hit rate, in percent.
+   */
+  SPECULATIVE_PREFETCH_HIT_RATE,
+  /**
+   * Represents the bytes of materialized files cloned from the overlay's
+   * blob file cache.
+   */
+  OVERLAY_BYTES_CLONED,
+  /**
+   * Represents the bytes of materialized files written by copying their
+   * blob's contents.
+   */
+  OVERLAY_BYTES_COPIED,
+  /**
+   * Represents the bytes of overlay files made to share their data with
+   * identical files.
+   */
+  OVERLAY_BYTES_DEDUPLICATED,
+  /**
+   * Represents the number of removed directories whose contents the overlay
+   * is yet to collect.
+   */
+  OVERLAY_GC_BACKLOG,
+  /**
+   * Represents how long the overlay garbage collection has been busy, in
+   * milliseconds.
+   */
+  OVERLAY_GC_BACKLOG_AGE,
   /**
    * Represents the number of entries in the change log
    */
@@ -128,8 +180,20 @@ enum class CounterName {
    * unlinked inode unloading. This is used on NFS mounts to clean up old
    * inodes.
    */
-  PERIODIC_UNLINKED_INODE_UNLOAD
+  PERIODIC_UNLINKED_INODE_UNLOAD,
 
+  /**
+   * Represents the estimated bytes used by the loaded and unloaded inodes.
+   */
+  MEMORY_INODES,
+  /**
+   * Represents the estimated bytes used by the cache of open overlay files.
+   */
+  MEMORY_OVERLAY_FILE_CACHE,
+  /**
+   * Represents the sum of the estimated memory usage of the mount.
+   */
+  MEMORY_TOTAL,
 };
 
 /**
@@ -167,11 +231,35 @@ struct CheckoutResult {
   CheckoutTimes times;
 };
 
+/**
+ * Published on the checkout TraceBus of a mount when a checkout finishes,
+ * successfully or not. The stages that were not reached have a zero duration.
+ */
+struct CheckoutTraceEvent : TraceEventBase {
+  RootId fromRoot;
+  RootId toRoot;
+  CheckoutMode mode;
+  bool success;
+  CheckoutTimes times;
+  std::chrono::steady_clock::duration duration;
+  uint64_t fetchedTrees;
+  uint64_t fetchedBlobs;
+};
+
 struct SetPathObjectIdResultAndTimes {
   SetPathObjectIdResult result;
   SetPathObjectIdTimes times;
 };
 
+/**
+ * One of the objects grafted by EdenMount::setPathObjectIds.
+ */
+struct SetPathObjectIdObject {
+  RelativePath path;
+  RootId id;
+  ObjectType type;
+};
+
 /**
  * EdenMount contains all of the data about a specific eden mount point.
  *
@@ -208,6 +296,36 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       OverlayChecker::ProgressCallback&& progressCallback = [](auto) {},
       const std::optional<SerializedInodeMap>& takeover = std::nullopt);
 
+  /**
+   * Defer initialize() until the channel receives its first request, so that
+   * checkouts nobody uses are never loaded.
+   *
+   * This must be called instead of initialize(), before startChannel().
+   * startChannel() then mounts the checkout right away and the first request
+   * calls initialize() with `progressCallback` through ensureInitialized().
+   *
+   * Only FUSE mounts support this. Returns false, leaving `progressCallback`
+   * untouched, for other mounts, which must call initialize() as usual.
+   */
+  bool deferInitialization(
+      OverlayChecker::ProgressCallback&& progressCallback);
+
+  /**
+   * Returns a future that completes once the mount is initialized, starting
+   * the initialization deferred by deferInitialization() if it has not
+   * started yet.
+   *
+   * The returned future is ready immediately for mounts whose initialization
+   * was not deferred.
+   */
+  ImmediateFuture<folly::Unit> ensureInitialized();
+
+  /**
+   * Returns a future that completes once the initialization deferred by
+   * deferInitialization() finishes, without starting it.
+   */
+  folly::SemiFuture<folly::Unit> getDeferredInitializationFuture();
+
   /**
    * Destroy the EdenMount.
    *
@@ -333,7 +451,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * the on-disk state of the the repository may differ from the inode state.
    * This ensures that all pending notifications have completed.
    *
-   * On macOS and Linux, this immediately return.
+   * On Linux, FUSE mounts using the writeback cache have the kernel send the
+   * writes it has cached. Otherwise, and on macOS, this returns immediately.
    *
    * This can be called from any thread/executor.
    */
@@ -437,6 +556,48 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
     return *journal_;
   }
 
+  TraceBus<CheckoutTraceEvent>& getCheckoutTraceBus() {
+    return *checkoutTraceBus_;
+  }
+
+  /**
+   * Return the prefetch profiles recorded for this mount, which are replayed
+   * after every checkout.
+   */
+  RecordedPrefetchProfiles& getRecordedPrefetchProfiles() {
+    return recordedPrefetchProfiles_;
+  }
+
+  /**
+   * Return the prefetcher used for speculative subtree prefetches after
+   * readdir, and its hit rate statistics.
+   */
+  SpeculativeTreePrefetcher& getSpeculativeTreePrefetcher() {
+    return speculativeTreePrefetcher_;
+  }
+
+  /**
+   * Return the cache of parsed .gitignore files, keyed by blob ID.
+   */
+  GitIgnoreCache& getGitIgnoreCache() {
+    return gitIgnoreCache_;
+  }
+
+  /**
+   * Return the index of entry names of recently globbed commits.
+   */
+  NameIndexCache& getNameIndexCache() {
+    return nameIndexCache_;
+  }
+
+  /**
+   * Return the cache of the inode numbers that getInodeSlow() resolved paths
+   * to. Anything that removes or replaces an entry must invalidate it.
+   */
+  PathInodeCache& getPathInodeCache() {
+    return pathInodeCache_;
+  }
+
   folly::Synchronized<std::unique_ptr<IActivityRecorder>>&
   getActivityRecorder() {
     return activityRecorder_;
@@ -498,6 +659,20 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::shared_ptr<const Tree> getCheckedOutRootTree() const;
 
+  /**
+   * The paths excluded from the working copy. The filter is empty unless
+   * setCheckoutFilter() was used on the mount.
+   */
+  std::shared_ptr<const TreeFilter> getCheckoutFilter() const;
+
+  /**
+   * Get the root tree of a commit with the checkout filter applied, which is
+   * what the working copy is compared against.
+   */
+  folly::Future<std::shared_ptr<const Tree>> getFilteredRootTree(
+      const RootId& rootId,
+      ObjectFetchContext& context) const;
+
   /**
    * Look up the Tree or TreeEntry for the specified path.
    *
@@ -619,12 +794,31 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    *
    * This updates the checkedOutRootId as well as the workingCopyParentRootId to
    * the passed in snapshotHash.
+   *
+   * If a previous checkout was interrupted, by cancelCheckout() or by EdenFS
+   * stopping, only a checkout to the same commit, which resumes it, or a
+   * forced checkout is allowed. Resuming skips the directories and files that
+   * the interrupted checkout already updated.
+   *
+   * If newFilter is set, the checkout also replaces the checkout filter: the
+   * paths it newly excludes are removed from the working copy and the ones it
+   * no longer excludes are added back. Such a checkout cannot be cancelled.
    */
   folly::Future<CheckoutResult> checkout(
       const RootId& snapshotHash,
       std::optional<pid_t> clientPid,
       folly::StringPiece thriftMethodCaller,
-      CheckoutMode checkoutMode = CheckoutMode::NORMAL);
+      CheckoutMode checkoutMode = CheckoutMode::NORMAL,
+      std::shared_ptr<const TreeFilter> newFilter = nullptr);
+
+  /**
+   * Make the checkout in progress stop once the directories it is updating
+   * are done, and fail with ECANCELED. The working copy is left partially
+   * checked out, until a checkout to the same commit resumes it.
+   *
+   * Returns false if no checkout is in progress.
+   */
+  bool cancelCheckout();
 
   /**
    * Chown the repository to the given uid and gid
@@ -646,6 +840,9 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * @param request This ResposeChannelRequest is passed from the ServiceHandler
    *     and is used to check if the request is still active, because if the
    *     request is no longer active we will cancel this diff operation.
+   * @param pathPrefixes When not empty, only paths under these are reported,
+   *     and the directories outside of them are not looked at. The status
+   *     cache is bypassed in that case.
    *
    * @return Returns a folly::Future that will be fulfilled when the diff
    *     operation is complete.  This is marked FOLLY_NODISCARD to
@@ -655,7 +852,23 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       const RootId& commitHash,
       folly::CancellationToken cancellation,
       bool listIgnored = false,
-      bool enforceCurrentParent = true);
+      bool enforceCurrentParent = true,
+      std::vector<RelativePath> pathPrefixes = {});
+
+  /**
+   * This accepts a callback which will be invoked as differences are found.
+   * Note that the callback methods may be invoked simultaneously from multiple
+   * different threads, and the callback is responsible for performing
+   * synchronization (if it is needed). It will be packaged into a DiffContext
+   * and passed through the TreeInode diff() codepath
+   */
+  FOLLY_NODISCARD folly::Future<folly::Unit> diff(
+      DiffCallback* callback,
+      const RootId& commitHash,
+      bool listIgnored,
+      bool enforceCurrentParent,
+      folly::CancellationToken cancellation,
+      std::vector<RelativePath> pathPrefixes = {}) const;
 
   /**
    * Compute the difference between the passed in roots.
@@ -663,12 +876,32 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * The order of the roots matters: a file added in toRoot will be returned as
    * ScmFileStatus::ADDED, while if the order of arguments were reversed, it
    * would be returned as ScmFileStatus::REMOVED.
+   *
+   * When pathPrefixes is not empty, only the paths under them are compared.
    */
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> diffBetweenRoots(
       const RootId& fromRoot,
       const RootId& toRoot,
       folly::CancellationToken cancellation,
-      DiffCallback* callback);
+      DiffCallback* callback,
+      std::vector<RelativePath> pathPrefixes = {});
+
+  /**
+   * Compute the status between the passed in roots, like diffBetweenRoots().
+   *
+   * Results are memoized in the LocalStore. If the status between the two
+   * roots is not cached but the journal shows this mount was checked out at
+   * some root in between, and the statuses from fromRoot to it and from it to
+   * toRoot are both cached, only the paths those name are compared.
+   *
+   * A status limited to pathPrefixes is neither looked up nor memoized.
+   */
+  FOLLY_NODISCARD ImmediateFuture<std::unique_ptr<ScmStatus>>
+  getScmStatusBetweenRoots(
+      const RootId& fromRoot,
+      const RootId& toRoot,
+      folly::CancellationToken cancellation,
+      std::vector<RelativePath> pathPrefixes = {});
 
   /**
    * This version of diff is primarily intended for testing.
@@ -688,6 +921,17 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   void resetParent(const RootId& parent);
 
+  /**
+   * Dematerialize the directories whose entries are identical to the
+   * corresponding trees of the working copy parent again, so that they no
+   * longer need to be compared by status.
+   *
+   * Only materialized directories are visited. The returned future holds the
+   * number of directories that were dematerialized.
+   */
+  ImmediateFuture<size_t> dematerializeUnchangedDirectories(
+      folly::CancellationToken cancel);
+
   /**
    * Acquire the rename lock in exclusive mode.
    */
@@ -733,6 +977,23 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::string getCounterName(CounterName name);
 
+  /**
+   * Estimated bytes of memory used by the structures of this mount, by
+   * subsystem. Memory shared between mounts, like the object caches, is not
+   * included.
+   */
+  struct MemoryUsage {
+    size_t inodes = 0;
+    size_t journal = 0;
+    size_t overlayFileCache = 0;
+
+    size_t total() const {
+      return inodes + journal + overlayFileCache;
+    }
+  };
+
+  MemoryUsage estimateMemoryUsage();
+
   /**
    * Mounts the filesystem in the VFS and spawns worker threads to
    * dispatch the fuse session.
@@ -883,6 +1144,21 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       CheckoutMode checkoutMode,
       ObjectFetchContext& context);
 
+  /**
+   * Graft several trees or blobs at once, with the same CheckoutMode semantics
+   * as setPathObjectId.
+   *
+   * The objects are applied in path order while holding the rename lock, and
+   * the files that share a parent directory are checked out together, so each
+   * directory is journaled and invalidated once. When a path is given more
+   * than once, the last object wins.
+   */
+  FOLLY_NODISCARD folly::Future<SetPathObjectIdResultAndTimes>
+  setPathObjectIds(
+      std::vector<SetPathObjectIdObject> objects,
+      CheckoutMode checkoutMode,
+      ObjectFetchContext& context);
+
   /**
    * Should only be called by the mount contructor. We decide wether this
    * mount should use nfs at construction time and do not change the decision.
@@ -919,6 +1195,14 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> flushInvalidations();
 
+  /**
+   * Flush the invalidations scheduled by a checkout. This is
+   * flushInvalidations(), unless fuse:checkout-waits-for-all-invalidations is
+   * false on a FUSE mount: then only the invalidations of recently accessed
+   * directories are waited for and the rest complete in the background.
+   */
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> flushCheckoutInvalidations();
+
  private:
   friend class RenameLock;
   friend class SharedRenameLock;
@@ -949,6 +1233,21 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   void transitionState(State expected, State newState);
 
+  AbsolutePath getSavedJournalPath() const;
+
+  /**
+   * Restores the journal saved by the last clean shutdown of this mount, if
+   * any, and removes it so that it is never restored twice. Returns the mount
+   * generation to use: that of the saved journal, or a new one.
+   */
+  uint64_t restoreJournal();
+
+  /**
+   * Saves the journal for the next incarnation of this mount. Must only be
+   * called once nothing can change the working copy any more.
+   */
+  void saveJournal();
+
   /**
    * Transition from the STARTING state to the FUSE_ERROR state.
    *
@@ -968,6 +1267,12 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   Overlay::OverlayType getOverlayType();
 
+  /**
+   * Prefetch the files of the recorded prefetch profiles in the commit that
+   * was just checked out, in the background.
+   */
+  void replayRecordedPrefetchProfiles();
+
   EdenMount(
       std::unique_ptr<CheckoutConfig> checkoutConfig,
       std::shared_ptr<ObjectStore> objectStore,
@@ -995,21 +1300,15 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   std::unique_ptr<DiffContext> createDiffContext(
       DiffCallback* callback,
       folly::CancellationToken cancellation,
-      bool listIgnored = false) const;
+      bool listIgnored = false,
+      std::vector<RelativePath> pathPrefixes = {}) const;
 
   /**
-   * This accepts a callback which will be invoked as differences are found.
-   * Note that the callback methods may be invoked simultaneously from multiple
-   * different threads, and the callback is responsible for performing
-   * synchronization (if it is needed). It will be packaged into a DiffContext
-   * and passed through the TreeInode diff() codepath
+   * Returns an error if `commitHash` is not the working copy's parent or a
+   * checkout is in progress, as enforced by diff() when enforceCurrentParent
+   * is set.
    */
-  FOLLY_NODISCARD folly::Future<folly::Unit> diff(
-      DiffCallback* callback,
-      const RootId& commitHash,
-      bool listIgnored,
-      bool enforceCurrentParent,
-      folly::CancellationToken cancellation) const;
+  folly::exception_wrapper checkCurrentParent(const RootId& commitHash) const;
 
   /**
    * Signal to unmount() that fuseMount() or takeoverFuse() has started.
@@ -1129,6 +1428,12 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
     // differ.
     RootId workingCopyParentRootId;
     bool checkoutInProgress = false;
+    // Set if the working copy is only partially checked out to
+    // checkedOutRootId, to the commit that the interrupted checkout started
+    // from.
+    std::optional<RootId> interruptedCheckoutFrom;
+    // Cancels the checkout in progress.
+    folly::CancellationSource checkoutCancellation;
   };
 
   /**
@@ -1140,12 +1445,27 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
  private:
   ParentLock parentState_;
 
+  /**
+   * The paths excluded from the working copy, saved in the FILTER file of the
+   * client directory. Replaced by checkouts that change it.
+   */
+  folly::Synchronized<std::shared_ptr<const TreeFilter>> checkoutFilter_;
+
   std::unique_ptr<Journal> journal_;
   folly::Synchronized<std::unique_ptr<IActivityRecorder>> activityRecorder_;
+  RecordedPrefetchProfiles recordedPrefetchProfiles_;
+  SpeculativeTreePrefetcher speculativeTreePrefetcher_;
+  WorkingCopyStatusCache statusCache_;
+  GitIgnoreCache gitIgnoreCache_;
+  NameIndexCache nameIndexCache_;
+  // Mutable because lookups through the const getInodeSlow() fill it.
+  mutable PathInodeCache pathInodeCache_;
 
   /**
    * A number to uniquely identify this particular incarnation of this mount.
-   * We use bits from the process id and the time at which we were mounted.
+   * We use bits from the process id and the time at which we were mounted,
+   * unless the journal of an earlier incarnation was restored, in which case
+   * its generation carries over.
    */
   const uint64_t mountGeneration_;
 
@@ -1170,6 +1490,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::atomic<EdenTimestamp> lastCheckoutTime_;
 
+  std::shared_ptr<TraceBus<CheckoutTraceEvent>> checkoutTraceBus_;
+
   struct MountingUnmountingState {
     bool channelMountStarted() const noexcept;
     bool channelUnmountStarted() const noexcept;
@@ -1214,6 +1536,18 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 
   folly::Synchronized<MountingUnmountingState> mountingUnmountingState_;
 
+  struct DeferredInitialization {
+    /// Whether deferInitialization() was called.
+    bool deferred{false};
+    /// Reset once the deferred initialization starts.
+    std::optional<OverlayChecker::ProgressCallback> progressCallback;
+    /// Whether channelInitSuccessful() was called.
+    bool channelStarted{false};
+    folly::SharedPromise<folly::Unit> initialized;
+  };
+
+  folly::Synchronized<DeferredInitialization> deferredInitialization_;
+
   /**
    * The current state of the mount point.
    */
@@ -7,6 +7,7 @@
 
 #include "eden/fs/inodes/FileInode.h"
 
+#include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/EventBase.h>
@@ -45,6 +46,47 @@ using std::vector;
 namespace facebook {
 namespace eden {
 
+#ifndef _WIN32
+namespace {
+
+/**
+ * Number of consecutive sequential reads after which a file is considered to
+ * be streamed and readahead starts.
+ */
+constexpr uint32_t kReadaheadMinSequentialReads = 2;
+
+/**
+ * Readahead outlives the read that started it, and a stream's next reads
+ * wait on it, so it is fetched at a higher priority than ordinary reads.
+ */
+class ReadaheadFetchContext : public ObjectFetchContext {
+ public:
+  Cause getCause() const override {
+    return Cause::Prefetch;
+  }
+
+  std::optional<folly::StringPiece> getCauseDetail() const override {
+    return folly::StringPiece{"readahead"};
+  }
+
+  ImportPriority getPriority() const override {
+    return ImportPriority::kHigh();
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+};
+
+ObjectFetchContext& getReadaheadFetchContext() {
+  static auto* context = new ReadaheadFetchContext;
+  return *context;
+}
+
+} // namespace
+#endif
+
 /*********************************************************************
  * FileInode::LockedState
  ********************************************************************/
@@ -58,9 +100,10 @@ namespace eden {
  */
 class FileInode::LockedState {
  public:
-  explicit LockedState(FileInode* inode) : ptr_{inode->state_.wlock()} {}
+  explicit LockedState(FileInode* inode)
+      : inode_{inode}, ptr_{inode->state_.wlock()} {}
   explicit LockedState(const FileInodePtr& inode)
-      : ptr_{inode->state_.wlock()} {}
+      : inode_{inode.get()}, ptr_{inode->state_.wlock()} {}
 
   LockedState(LockedState&&) = default;
   LockedState& operator=(LockedState&&) = default;
@@ -83,6 +126,9 @@ class FileInode::LockedState {
 
   /**
    * Explicitly unlock the LockedState object before it is destroyed.
+   *
+   * If state->journalUpdatePending is set, the journal is updated after
+   * unlocking.
    */
   void unlock();
 
@@ -103,6 +149,7 @@ class FileInode::LockedState {
       BlobCache::Interest interest);
 
  private:
+  FileInode* inode_;
   folly::Synchronized<State>::LockedPtr ptr_;
 };
 
@@ -110,13 +157,17 @@ FileInode::LockedState::~LockedState() {
   if (!ptr_) {
     return;
   }
-  // Check the state invariants every time we release the lock
-  ptr_->checkInvariants();
+  unlock();
 }
 
 void FileInode::LockedState::unlock() {
+  // Check the state invariants every time we release the lock
   ptr_->checkInvariants();
+  bool updateJournal = std::exchange(ptr_->journalUpdatePending, false);
   ptr_.unlock();
+  if (updateJournal) {
+    inode_->updateJournal();
+  }
 }
 
 std::shared_ptr<const Blob> FileInode::LockedState::getCachedBlob(
@@ -394,12 +445,16 @@ void FileInodeState::checkInvariants() {
     case BLOB_NOT_LOADING:
       XCHECK(nonMaterializedState);
       XCHECK(!blobLoadingPromise);
+#ifndef _WIN32
+      XCHECK(pendingWrites.empty());
+#endif
       return;
     case BLOB_LOADING:
       XCHECK(nonMaterializedState);
       XCHECK(blobLoadingPromise);
 #ifndef _WIN32
       XCHECK(readByteRanges.empty());
+      XCHECK(pendingWrites.empty());
 #endif
       return;
     case MATERIALIZED_IN_OVERLAY:
@@ -695,7 +750,11 @@ AbsolutePath FileInode::getMaterializedFilePath() {
 #endif
 
 ImmediateFuture<Hash20> FileInode::getSha1(ObjectFetchContext& fetchContext) {
-  auto state = LockedState{this};
+#ifdef _WIN32
+  auto state = state_.rlock();
+#else
+  auto state = rlockWithoutPendingWrites();
+#endif
 
   logAccess(fetchContext);
   switch (state->tag) {
@@ -709,7 +768,7 @@ ImmediateFuture<Hash20> FileInode::getSha1(ObjectFetchContext& fetchContext) {
       return makeImmediateFutureWith(
           [this] { return getFileSha1(getMaterializedFilePath()); });
 #else
-      return getOverlayFileAccess(state)->getSha1(*this);
+      return getOverlayFileAccess(*state)->getSha1(*this);
 #endif // _WIN32
   }
 
@@ -717,28 +776,39 @@ ImmediateFuture<Hash20> FileInode::getSha1(ObjectFetchContext& fetchContext) {
 }
 
 ImmediateFuture<BlobMetadata> FileInode::getBlobMetadata(
-    ObjectFetchContext& fetchContext) {
-  auto state = LockedState{this};
+    ObjectFetchContext& fetchContext,
+    bool includeBlake3) {
+#ifdef _WIN32
+  auto state = state_.rlock();
+#else
+  auto state = rlockWithoutPendingWrites();
+#endif
 
   logAccess(fetchContext);
   switch (state->tag) {
     case State::BLOB_NOT_LOADING:
     case State::BLOB_LOADING:
       // If a file is not materialized, it should have a hash value.
+      if (includeBlake3) {
+        return getObjectStore()->getBlobMetadataWithBlake3(
+            state->nonMaterializedState->hash, fetchContext);
+      }
       return getObjectStore()->getBlobMetadata(
           state->nonMaterializedState->hash, fetchContext);
     case State::MATERIALIZED_IN_OVERLAY:
 #ifdef _WIN32
-      return makeImmediateFutureWith([this] {
+      return makeImmediateFutureWith([this, includeBlake3] {
         auto pathToFile = getMaterializedFilePath();
         struct stat st = getMount()->initStatData();
         return BlobMetadata(
-            getFileSha1(pathToFile), getMaterializedFileSize(st, pathToFile));
+            getFileSha1(pathToFile),
+            getMaterializedFileSize(st, pathToFile),
+            includeBlake3 ? std::make_optional(getFileBlake3(pathToFile))
+                          : std::nullopt);
       });
 #else
-      auto sha1 = getOverlayFileAccess(state)->getSha1(*this);
-      auto fileSize = getOverlayFileAccess(state)->getFileSize(*this);
-      return BlobMetadata(sha1, fileSize);
+      return getOverlayFileAccess(*state)->getBlobMetadata(
+          *this, includeBlake3);
 #endif // _WIN32
   }
 
@@ -752,9 +822,10 @@ ImmediateFuture<struct stat> FileInode::stat(ObjectFetchContext& context) {
   // NOTE: we don't set rdev to anything special here because we
   // don't support committing special device nodes.
 
-  auto state = LockedState{this};
-
-#ifndef _WIN32
+#ifdef _WIN32
+  auto state = state_.rlock();
+#else
+  auto state = rlockWithoutPendingWrites();
   getMetadataLocked(*state).applyToStat(st);
 #endif
 
@@ -763,7 +834,7 @@ ImmediateFuture<struct stat> FileInode::stat(ObjectFetchContext& context) {
     auto pathToFile = getMaterializedFilePath();
     getMaterializedFileSize(st, pathToFile);
 #else
-    st.st_size = getOverlayFileAccess(state)->getFileSize(*this);
+    st.st_size = getOverlayFileAccess(*state)->getFileSize(*this);
 #endif
     updateBlockCount(st);
     return st;
@@ -810,11 +881,12 @@ void FileInode::updateBlockCount(FOLLY_MAYBE_UNUSED struct stat& st) {
 }
 
 #ifndef _WIN32
-void FileInode::fsync(bool datasync) {
+ImmediateFuture<folly::Unit> FileInode::fsync(bool datasync) {
   auto state = LockedState{this};
-  if (state->isMaterialized()) {
-    getOverlayFileAccess(state)->fsync(*this, datasync);
+  if (!state->isMaterialized()) {
+    return folly::unit;
   }
+  return getOverlayFileAccess(state)->fsync(*this, datasync);
 }
 
 folly::Future<folly::Unit> FileInode::fallocate(
@@ -897,31 +969,66 @@ void FileInode::materialize() {
 }
 #else
 
+namespace {
+/**
+ * Returns up to `size` bytes of `blob` from `off`, and whether they reach
+ * the end of the blob.
+ */
+std::tuple<BufVec, bool> readBlob(const Blob& blob, size_t size, off_t off) {
+  auto buf = blob.getContents();
+  folly::io::Cursor cursor(&buf);
+
+  if (!cursor.canAdvance(off)) {
+    // Seek beyond EOF.  Return an empty result.
+    return std::make_tuple(BufVec{folly::IOBuf::wrapBuffer("", 0)}, true);
+  }
+
+  cursor.skip(off);
+
+  std::unique_ptr<folly::IOBuf> result;
+  cursor.cloneAtMost(result, size);
+
+  return std::make_tuple(BufVec{std::move(result)}, cursor.isAtEnd());
+}
+} // namespace
+
 Future<std::tuple<BufVec, bool>>
 FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
   XDCHECK_GE(off, 0);
+  {
+    auto state = rlockWithoutPendingWrites();
+    if (auto result = tryReadShared(*state, size, off)) {
+      logAccess(context);
+      return std::move(*result);
+    }
+  }
+
+  auto state = LockedState{this};
+  std::shared_ptr<const Blob> blob;
+  if (state->tag == State::BLOB_NOT_LOADING) {
+    // A blob that is already in memory is cheaper to read from than chunks.
+    blob = state.getCachedBlob(getMount(), BlobCache::Interest::WantHandle);
+    if (!blob && shouldReadChunked(*state)) {
+      return readChunked(std::move(state), size, off, context);
+    }
+  }
+
   return runWhileDataLoaded<Future<std::tuple<BufVec, bool>>>(
-      LockedState{this},
+      std::move(state),
       BlobCache::Interest::WantHandle,
       // This function is only called by FUSE.
       context,
-      nullptr,
+      std::move(blob),
       [size, off, self = inodePtrFromThis()](
-          LockedState&& state,
-          std::shared_ptr<const Blob> blob) -> std::tuple<BufVec, bool> {
+          LockedState&& state, std::shared_ptr<const Blob> blob)
+          -> Future<std::tuple<BufVec, bool>> {
         SCOPE_SUCCESS {
           self->updateAtimeLocked(*state);
         };
 
         // Materialized either before or during blob load.
         if (state->tag == State::MATERIALIZED_IN_OVERLAY) {
-          // TODO(xavierd): For materialized files, only return EOF when read
-          // returned no bytes. This will force some FS Channel (like NFS) to
-          // issue at least 2 read calls: one for reading the entire file, and
-          // the second one to get the EOF bit.
-          auto buf = self->getOverlayFileAccess(state)->read(*self, size, off);
-          auto eof = size != 0 && buf->empty();
-          return {std::move(buf), eof};
+          return self->readFromOverlay(*state, size, off);
         }
 
         // runWhileDataLoaded() ensures that the state is either
@@ -938,39 +1045,276 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
           state->readByteRanges.clear();
         }
 
-        auto buf = blob->getContents();
-        folly::io::Cursor cursor(&buf);
-
-        if (!cursor.canAdvance(off)) {
-          // Seek beyond EOF.  Return an empty result.
-          return {BufVec{folly::IOBuf::wrapBuffer("", 0)}, true};
-        }
+        return readBlob(*blob, size, off);
+      });
+}
 
-        cursor.skip(off);
+std::optional<Future<std::tuple<BufVec, bool>>>
+FileInode::tryReadShared(const State& state, size_t size, off_t off) {
+  if (state.tag == State::MATERIALIZED_IN_OVERLAY) {
+    SCOPE_SUCCESS {
+      updateAtimeLocked(state);
+    };
+    return readFromOverlay(state, size, off);
+  }
 
-        std::unique_ptr<folly::IOBuf> result;
-        cursor.cloneAtMost(result, size);
+  // Reading a range that isn't covered by readByteRanges yet has to record
+  // it, and a blob that isn't referenced by interestHandle has to be looked
+  // up in the BlobCache, which updates interestHandle.
+  if (state.tag != State::BLOB_NOT_LOADING ||
+      !state.readByteRanges.covers(off, off + size)) {
+    return std::nullopt;
+  }
+  auto blob = state.interestHandle.getObject();
+  if (!blob) {
+    return std::nullopt;
+  }
+  updateAtimeLocked(state);
+  return folly::makeFuture(readBlob(*blob, size, off));
+}
 
-        return {BufVec{std::move(result)}, cursor.isAtEnd()};
-      });
+Future<std::tuple<BufVec, bool>>
+FileInode::readFromOverlay(const State& state, size_t size, off_t off) {
+  // TODO(xavierd): For materialized files, only return EOF when read
+  // returned no bytes. This will force some FS Channel (like NFS) to
+  // issue at least 2 read calls: one for reading the entire file, and
+  // the second one to get the EOF bit.
+  return getOverlayFileAccess(state)
+      ->read(*this, size, off)
+      .thenValue([size](BufVec&& buf) {
+        auto eof = size != 0 && buf->empty();
+        return std::make_tuple(std::move(buf), eof);
+      })
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance());
 }
 
-size_t FileInode::writeImpl(
-    LockedState& state,
-    const struct iovec* iov,
-    size_t numIovecs,
+std::optional<FileRange> FileInode::readMaterializedRange(
+    size_t size,
     off_t off) {
-  XDCHECK_EQ(state->tag, State::MATERIALIZED_IN_OVERLAY);
+  XDCHECK_GE(off, 0);
+  auto state = LockedState{this};
+  if (state->tag != State::MATERIALIZED_IN_OVERLAY) {
+    return std::nullopt;
+  }
+  updateAtimeLocked(*state);
+  return getOverlayFileAccess(state)->getFileRange(*this, size, off);
+}
 
-  auto xfer = getOverlayFileAccess(state)->write(*this, iov, numIovecs, off);
+bool FileInode::shouldReadChunked(const State& state) const {
+  auto threshold =
+      getMount()->getEdenConfig()->chunkedBlobReadThreshold.getValue();
+  auto blobSize = state.nonMaterializedState->size;
+  return threshold != 0 &&
+      blobSize != State::NonMaterializedState::kUnknownSize &&
+      blobSize >= threshold &&
+      getMount()->getObjectStore()->supportsBlobRanges();
+}
+
+Future<std::tuple<BufVec, bool>> FileInode::readChunked(
+    LockedState state,
+    size_t size,
+    off_t off,
+    ObjectFetchContext& context) {
+  auto hash = state->nonMaterializedState->hash;
+  auto blobSize = state->nonMaterializedState->size;
+  updateAtimeLocked(*state);
+
+  auto chunkSize = std::max<uint64_t>(
+      getMount()->getEdenConfig()->blobChunkSize.getValue(), 1);
+  auto [readaheadStart, readaheadEnd] =
+      updateReadaheadLocked(*state, size, off, chunkSize);
+  state.unlock();
+  logAccess(context);
+
+  auto result =
+      getMount()
+          ->getBlobAccess()
+          ->getBlobRange(hash, blobSize, off, size, chunkSize, context)
+          .thenValue([end = static_cast<uint64_t>(off) + size,
+                      blobSize](std::unique_ptr<folly::IOBuf> buf) {
+            return std::tuple<BufVec, bool>{
+                BufVec{std::move(buf)}, end >= blobSize};
+          });
+  if (readaheadStart < readaheadEnd) {
+    startReadahead(hash, blobSize, readaheadStart, readaheadEnd, chunkSize);
+  }
+  return result;
+}
+
+std::pair<uint64_t, uint64_t> FileInode::updateReadaheadLocked(
+    State& state,
+    size_t size,
+    off_t off,
+    uint64_t chunkSize) {
+  auto start = static_cast<uint64_t>(off);
+  auto end = start + size;
+  if (start == state.nextSequentialOffset) {
+    state.sequentialReads = std::min<uint32_t>(
+        state.sequentialReads + 1, kReadaheadMinSequentialReads);
+  } else {
+    state.sequentialReads = 0;
+    state.readaheadEnd = 0;
+  }
+  state.nextSequentialOffset = end;
+
+  auto readaheadChunks =
+      getMount()->getEdenConfig()->readaheadChunks.getValue();
+  if (state.sequentialReads < kReadaheadMinSequentialReads ||
+      readaheadChunks == 0) {
+    return {0, 0};
+  }
+
+  // Read ahead whole chunks past the one this read ends in, skipping what an
+  // earlier readahead of this stream already started.
+  auto readaheadStart = std::max(state.readaheadEnd, end);
+  auto readaheadEnd = std::min(
+      state.nonMaterializedState->size,
+      ((end + chunkSize - 1) / chunkSize + readaheadChunks) * chunkSize);
+  if (readaheadStart >= readaheadEnd) {
+    return {0, 0};
+  }
+  state.readaheadEnd = readaheadEnd;
+  return {readaheadStart, readaheadEnd};
+}
+
+void FileInode::startReadahead(
+    const ObjectId& hash,
+    uint64_t blobSize,
+    uint64_t start,
+    uint64_t end,
+    uint64_t chunkSize) {
+  XLOG(DBG7) << "readahead of inode " << getNodeId() << " from " << start
+             << " to " << end;
+  // The reads that follow wait on the chunks themselves, not on this.
+  folly::futures::detachOn(
+      getMount()->getServerThreadPool().get(),
+      getMount()
+          ->getBlobAccess()
+          ->getBlobRange(
+              hash,
+              blobSize,
+              start,
+              end - start,
+              chunkSize,
+              getReadaheadFetchContext())
+          .thenError([ino = getNodeId()](folly::exception_wrapper&& ew) {
+            XLOG(DBG3) << "readahead of inode " << ino
+                       << " failed: " << ew.what();
+            return std::unique_ptr<folly::IOBuf>{};
+          })
+          .semi());
+}
+
+folly::Future<size_t>
+FileInode::writeImpl(LockedState& state, BufVec buf, off_t off) {
+  XDCHECK_EQ(state->tag, State::MATERIALIZED_IN_OVERLAY);
 
   updateMtimeAndCtimeLocked(*state, getNow());
 
+  if (tryBufferWrite(state, *buf, off)) {
+    return folly::makeFuture(buf->computeChainDataLength());
+  }
+
+  auto xfer = getOverlayFileAccess(state)->write(*this, std::move(buf), off);
+
+  state->journalUpdatePending = true;
   state.unlock();
 
-  updateJournal();
+  return std::move(xfer).semi().via(
+      &folly::QueuedImmediateExecutor::instance());
+}
 
-  return xfer;
+bool FileInode::tryBufferWrite(
+    LockedState& state,
+    const folly::IOBuf& buf,
+    off_t off) {
+  auto* mount = getMount();
+  auto config = mount->getEdenConfig();
+  auto delay = config->overlayWriteCoalescingDelay.getValue();
+  auto maxBytes = config->overlayWriteCoalescingMaxBytes.getValue();
+  auto size = buf.computeChainDataLength();
+  // With io_uring, flushing would complete asynchronously, after the state
+  // lock is released, so later reads could miss the buffered data.
+  if (delay.count() == 0 || size > maxBytes / 16 ||
+      mount->getOverlayFileAccess()->usesIoUring()) {
+    return false;
+  }
+
+  auto& pending = state->pendingWrites;
+  if (!pending.empty() &&
+      (off != state->pendingWriteOffset +
+               static_cast<off_t>(pending.chainLength()) ||
+       pending.chainLength() + size > maxBytes)) {
+    flushPendingWrites(state);
+  }
+  if (pending.empty()) {
+    state->pendingWriteOffset = off;
+  }
+  // The caller's buffer may be reused once the write returns.
+  for (auto range : buf) {
+    pending.append(range.data(), range.size());
+  }
+
+  if (!state->pendingWriteFlushScheduled) {
+    state->pendingWriteFlushScheduled = true;
+    // The timer holds a reference to this inode, which keeps it from being
+    // unloaded with writes still buffered.
+    folly::futures::sleep(delay)
+        .via(mount->getServerThreadPool().get())
+        .thenValue([self = inodePtrFromThis()](auto&&) {
+          auto state = LockedState{self};
+          state->pendingWriteFlushScheduled = false;
+          self->flushPendingWrites(state);
+        })
+        .thenError([ino = getNodeId()](const folly::exception_wrapper& ew) {
+          XLOG(ERR) << "error writing buffered writes of inode " << ino
+                    << " to the overlay: " << ew.what();
+        });
+  }
+  return true;
+}
+
+void FileInode::flushPendingWrites(LockedState& state) {
+  auto& pending = state->pendingWrites;
+  if (pending.empty()) {
+    return;
+  }
+  // The buffered writes are only dropped once written, so a failure here is
+  // reported again to the next caller.
+  auto* overlayFileAccess = getMount()->getOverlayFileAccess();
+  while (!pending.empty()) {
+    auto written = overlayFileAccess
+                       ->write(
+                           *this,
+                           pending.front()->clone(),
+                           state->pendingWriteOffset)
+                       .get();
+    if (written == 0) {
+      throw InodeError(
+          EIO, inodePtrFromThis(), "unable to write buffered writes");
+    }
+    pending.trimStart(written);
+    state->pendingWriteOffset += written;
+    state->journalUpdatePending = true;
+  }
+}
+
+folly::Synchronized<FileInodeState>::RLockedPtr
+FileInode::rlockWithoutPendingWrites() {
+  {
+    auto state = state_.rlock();
+    if (state->pendingWrites.empty()) {
+      return state;
+    }
+  }
+  {
+    auto state = LockedState{this};
+    flushPendingWrites(state);
+  }
+  // Writes buffered since then are concurrent with the caller, which may
+  // ignore them.
+  return state_.rlock();
 }
 
 folly::Future<size_t>
@@ -979,9 +1323,8 @@ FileInode::write(BufVec&& buf, off_t off, ObjectFetchContext& fetchContext) {
       LockedState{this},
       nullptr,
       [buf = std::move(buf), off, self = inodePtrFromThis()](
-          LockedState&& state) {
-        auto vec = buf->getIov();
-        return self->writeImpl(state, vec.data(), vec.size(), off);
+          LockedState&& state) mutable {
+        return self->writeImpl(state, std::move(buf), off);
       },
       fetchContext);
 }
@@ -992,23 +1335,21 @@ folly::Future<size_t> FileInode::write(
     ObjectFetchContext& fetchContext) {
   auto state = LockedState{this};
 
-  // If we are currently materialized we don't need to copy the input data.
+  // If we are currently materialized we don't need to copy the input data,
+  // unless the write completes after this call returns.
   if (state->tag == State::MATERIALIZED_IN_OVERLAY) {
-    struct iovec iov;
-    iov.iov_base = const_cast<char*>(data.data());
-    iov.iov_len = data.size();
-    return writeImpl(state, &iov, 1, off);
+    auto buf = getOverlayFileAccess(state)->usesIoUring()
+        ? folly::IOBuf::copyBuffer(data)
+        : folly::IOBuf::wrapBuffer(data.data(), data.size());
+    return writeImpl(state, std::move(buf), off);
   }
 
   return runWhileMaterialized(
       std::move(state),
       nullptr,
-      [data = data.str(), off, self = inodePtrFromThis()](
-          LockedState&& stateLock) {
-        struct iovec iov;
-        iov.iov_base = const_cast<char*>(data.data());
-        iov.iov_len = data.size();
-        return self->writeImpl(stateLock, &iov, 1, off);
+      [buf = folly::IOBuf::copyBuffer(data), off, self = inodePtrFromThis()](
+          LockedState&& stateLock) mutable {
+        return self->writeImpl(stateLock, std::move(buf), off);
       },
       fetchContext);
 }
@@ -1036,6 +1377,13 @@ Future<std::shared_ptr<const Blob>> FileInode::startLoadingData(
   // Unlock state_ while we wait on the blob data to load
   state.unlock();
 
+  auto& prefetchProfiles = getMount()->getRecordedPrefetchProfiles();
+  if (prefetchProfiles.isRecording()) {
+    if (auto path = getPath()) {
+      prefetchProfiles.recordFetch(*path, fetchContext);
+    }
+  }
+
   auto self = inodePtrFromThis(); // separate line for formatting
   std::move(getBlobFuture)
       .thenTry([self](folly::Try<BlobCache::GetResult> tryResult) mutable {
@@ -1131,10 +1479,17 @@ void FileInode::truncateInOverlay(LockedState& state) {
   XCHECK_EQ(state->tag, State::MATERIALIZED_IN_OVERLAY);
   XCHECK(!state->nonMaterializedState);
 
+  // The buffered writes would be truncated away.
+  state->pendingWrites.reset();
   getOverlayFileAccess(state)->truncate(*this);
 }
 
-OverlayFileAccess* FileInode::getOverlayFileAccess(LockedState&) const {
+OverlayFileAccess* FileInode::getOverlayFileAccess(LockedState& state) {
+  flushPendingWrites(state);
+  return getMount()->getOverlayFileAccess();
+}
+
+OverlayFileAccess* FileInode::getOverlayFileAccess(const State&) const {
   return getMount()->getOverlayFileAccess();
 }
 #endif // !_WIN32
@@ -9,6 +9,7 @@
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/SharedPromise.h>
+#include <folly/io/IOBufQueue.h>
 #include <chrono>
 #include <optional>
 #include "eden/fs/inodes/CacheHint.h"
@@ -130,7 +131,38 @@ struct FileInodeState {
    * Records the ranges that have been read() when not materialized.
    */
   CoverageSet readByteRanges;
+
+  /**
+   * Sequential access detection for chunked reads: the offset a read
+   * continuing the previous one would start at, the number of consecutive
+   * reads that did, and how far into the file readahead has been started.
+   *
+   * FUSE and NFS reads carry no usable file handle, so streams are tracked
+   * per inode.
+   */
+  uint64_t nextSequentialOffset{0};
+  uint64_t readaheadEnd{0};
+  uint32_t sequentialReads{0};
+
+  /**
+   * Small sequential writes buffered in memory, when
+   * `overlay:write-coalescing-delay` is set, until they are written to the
+   * overlay file at pendingWriteOffset together. Only set when materialized.
+   */
+  folly::IOBufQueue pendingWrites{folly::IOBufQueue::cacheChainLength()};
+  off_t pendingWriteOffset{0};
+
+  /**
+   * Whether a flush of pendingWrites is scheduled.
+   */
+  bool pendingWriteFlushScheduled{false};
 #endif
+
+  /**
+   * Set when the contents of the file changed while the state was locked.
+   * The journal is updated once the lock is released.
+   */
+  bool journalUpdatePending{false};
 };
 
 class FileInode final : public InodeBaseMetadata<FileInodeState> {
@@ -180,8 +212,14 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
 
   ImmediateFuture<Hash20> getSha1(ObjectFetchContext& fetchContext);
 
+  /**
+   * Returns the size and SHA-1 of the file, and its BLAKE3 hash if
+   * `includeBlake3` is set. The overlay file of a materialized file is read
+   * at most once.
+   */
   ImmediateFuture<BlobMetadata> getBlobMetadata(
-      ObjectFetchContext& fetchContext);
+      ObjectFetchContext& fetchContext,
+      bool includeBlake3 = false);
 
   /**
    * Check to see if the file has the same contents as the specified blob
@@ -272,12 +310,19 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
   folly::Future<std::tuple<BufVec, bool>>
   read(size_t size, off_t off, ObjectFetchContext& context);
 
+  /**
+   * If the file is materialized, returns the range of its overlay file
+   * holding size bytes at offset off, and counts this as a read of them.
+   * Returns std::nullopt otherwise, in which case read() should be used.
+   */
+  std::optional<FileRange> readMaterializedRange(size_t size, off_t off);
+
   folly::Future<size_t>
   write(BufVec&& buf, off_t off, ObjectFetchContext& fetchContext);
   folly::Future<size_t>
   write(folly::StringPiece data, off_t off, ObjectFetchContext& fetchContext);
 
-  void fsync(bool datasync);
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> fsync(bool datasync);
 
   FOLLY_NODISCARD folly::Future<folly::Unit>
   fallocate(uint64_t offset, uint64_t length, ObjectFetchContext& fetchContext);
@@ -382,6 +427,64 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   void truncateInOverlay(LockedState& state);
 
+  /**
+   * Serve a read() with the state lock held shared, so that concurrent reads
+   * of the same file don't serialize. This is possible when the file is
+   * materialized, or when its blob is still in memory and the range was
+   * read before, since neither needs to modify the state.
+   *
+   * Returns std::nullopt if the read needs the state lock held exclusively.
+   */
+  std::optional<folly::Future<std::tuple<BufVec, bool>>>
+  tryReadShared(const State& state, size_t size, off_t off);
+
+  /**
+   * Read from this file's materialized contents in the overlay.
+   */
+  folly::Future<std::tuple<BufVec, bool>> readFromOverlay(
+      const State& state,
+      size_t size,
+      off_t off);
+
+  /**
+   * Whether reads from this non-materialized, not loading file should fetch
+   * only the chunks they cover instead of loading the whole blob. Only large
+   * files whose size is already known are read this way, and only when the
+   * backing store can fetch byte ranges.
+   */
+  bool shouldReadChunked(const State& state) const;
+
+  /**
+   * Serve a read() from the chunks of the blob it covers. Releases the state
+   * lock before fetching.
+   */
+  folly::Future<std::tuple<BufVec, bool>> readChunked(
+      LockedState state,
+      size_t size,
+      off_t off,
+      ObjectFetchContext& context);
+
+  /**
+   * Record a chunked read of `size` bytes at `off`. If it continues a
+   * sequential stream, returns the byte range to read ahead, which is empty
+   * otherwise.
+   */
+  std::pair<uint64_t, uint64_t> updateReadaheadLocked(
+      State& state,
+      size_t size,
+      off_t off,
+      uint64_t chunkSize);
+
+  /**
+   * Fetch the chunks of the blob covering [start, end) in the background.
+   */
+  void startReadahead(
+      const ObjectId& hash,
+      uint64_t blobSize,
+      uint64_t start,
+      uint64_t end,
+      uint64_t chunkSize);
+
 #endif // !_WIN32
 
   /**
@@ -448,13 +551,36 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    * An unused LockedState& is passed in to help avoid unsynchronized access.
    * (Don't use the returned OverlayFileAccess outside of the lock).
    */
-  OverlayFileAccess* getOverlayFileAccess(LockedState&) const;
+  OverlayFileAccess* getOverlayFileAccess(LockedState&);
+  /**
+   * Like getOverlayFileAccess(LockedState&), for callers that only hold the
+   * state lock shared. They may read the overlay file but not modify it, and
+   * should have locked the state with rlockWithoutPendingWrites().
+   */
+  OverlayFileAccess* getOverlayFileAccess(const State&) const;
 
-  size_t writeImpl(
-      LockedState& state,
-      const struct iovec* iov,
-      size_t numIovecs,
-      off_t off);
+  folly::Future<size_t> writeImpl(LockedState& state, BufVec buf, off_t off);
+
+  /**
+   * Buffer a write in state->pendingWrites if it is small and extends the
+   * writes already buffered. Returns false if it must be written to the
+   * overlay file instead.
+   */
+  bool tryBufferWrite(LockedState& state, const folly::IOBuf& buf, off_t off);
+
+  /**
+   * Write state->pendingWrites to the overlay file.
+   *
+   * getOverlayFileAccess(LockedState&) calls this, so that callers holding
+   * the state lock exclusively always see the buffered writes.
+   */
+  void flushPendingWrites(LockedState& state);
+
+  /**
+   * Lock the state shared, after writing out any buffered writes so that
+   * the overlay file is up to date.
+   */
+  folly::Synchronized<State>::RLockedPtr rlockWithoutPendingWrites();
 #endif // !_WIN32
 
   /**
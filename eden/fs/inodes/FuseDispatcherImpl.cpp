@@ -58,6 +58,10 @@ FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
       mount_(mount),
       inodeMap_(mount_->getInodeMap()) {}
 
+ImmediateFuture<folly::Unit> FuseDispatcherImpl::ensureInitialized() {
+  return mount_->ensureInitialized();
+}
+
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::getattr(
     InodeNumber ino,
     ObjectFetchContext& context) {
@@ -195,6 +199,13 @@ ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::setattr(
         } else if (attr.valid & FATTR_MTIME_NOW) {
           desired.mtime = now;
         }
+#ifdef FATTR_CTIME
+        // Only sent with FUSE_WRITEBACK_CACHE, when the kernel maintains the
+        // ctime of files it has cached writes for.
+        if (attr.valid & FATTR_CTIME) {
+          desired.ctime = fuseTimeToTimespec(attr.ctime, attr.ctimensec);
+        }
+#endif
 
         return inode->setattr(desired, context).semi();
       })
@@ -207,9 +218,23 @@ void FuseDispatcherImpl::forget(InodeNumber ino, unsigned long nlookup) {
   inodeMap_->decFsRefcount(ino, nlookup);
 }
 
+void FuseDispatcherImpl::batchForget(
+    folly::Range<const fuse_forget_one*> forgets) {
+  std::vector<std::pair<InodeNumber, uint32_t>> counts;
+  counts.reserve(forgets.size());
+  for (const auto& item : forgets) {
+    counts.emplace_back(InodeNumber{item.nodeid}, item.nlookup);
+  }
+  inodeMap_->decFsRefcounts(std::move(counts));
+}
+
 ImmediateFuture<uint64_t> FuseDispatcherImpl::open(
     InodeNumber /*ino*/,
     int /*flags*/) {
+  // FUSE passthrough (FOPEN_PASSTHROUGH) can not be used for materialized
+  // files: the kernel maps file offsets one to one onto the backing file, but
+  // overlay files start with an FsOverlay::kHeaderLength byte header. Large
+  // reads from them are spliced instead, see fuse:splice-read-threshold.
 #ifdef FUSE_NO_OPEN_SUPPORT
   if (getConnInfo().flags & FUSE_NO_OPEN_SUPPORT) {
     // If the kernel understands FUSE_NO_OPEN_SUPPORT, then returning ENOSYS
@@ -257,6 +282,27 @@ ImmediateFuture<BufVec> FuseDispatcherImpl::read(
       });
 }
 
+ImmediateFuture<std::variant<BufVec, FileRange>>
+FuseDispatcherImpl::readSpliceable(
+    InodeNumber ino,
+    size_t size,
+    off_t off,
+    ObjectFetchContext& context) {
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [&context, size, off](FileInodePtr&& inode)
+          -> ImmediateFuture<std::variant<BufVec, FileRange>> {
+        if (auto range = inode->readMaterializedRange(size, off)) {
+          return std::variant<BufVec, FileRange>{std::move(*range)};
+        }
+        return inode->read(size, off, context)
+            .thenValue([](std::tuple<BufVec, bool>&& readRes) {
+              return std::variant<BufVec, FileRange>{
+                  std::get<BufVec>(std::move(readRes))};
+            })
+            .semi();
+      });
+}
+
 ImmediateFuture<size_t> FuseDispatcherImpl::write(
     InodeNumber ino,
     folly::StringPiece data,
@@ -335,6 +381,61 @@ ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdir(
       });
 }
 
+ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdirplus(
+    InodeNumber ino,
+    FuseDirList&& dirList,
+    off_t offset,
+    uint64_t /*fh*/,
+    ObjectFetchContext& context) {
+  return inodeMap_->lookupTreeInode(ino).thenValue(
+      [dirList = std::move(dirList), offset, &context](
+          TreeInodePtr inode) mutable {
+        // fuseReaddir prefetches the metadata of all children in one batch,
+        // so their stats below do not each have to fetch it.
+        auto list = inode->fuseReaddir(std::move(dirList), offset, context);
+        std::vector<ImmediateFuture<folly::Unit>> futures;
+        for (auto& entryOut : list.getEntryOuts()) {
+          if (entryOut.name == "." || entryOut.name == "..") {
+            continue;
+          }
+          // An entry whose attributes are not known is left zeroed, which
+          // the kernel treats as if READDIR had returned it.
+          futures.push_back(
+              inode->getOrLoadChild(PathComponentPiece{entryOut.name}, context)
+                  .thenValue([&context](InodePtr&& child) {
+                    return child->stat(context).thenValue(
+                        [child](struct stat st) {
+                          return std::make_pair(child, st);
+                        });
+                  })
+                  .thenTry([entryOut](
+                               folly::Try<std::pair<InodePtr, struct stat>>
+                                   result) {
+                    if (result.hasException()) {
+                      XLOG(DBG4) << "no attributes for readdirplus entry "
+                                 << entryOut.name << ": "
+                                 << result.exception().what();
+                      return folly::unit;
+                    }
+                    auto& [child, st] = result.value();
+                    // The entry may have been replaced since it was listed.
+                    if (child->getNodeId().get() != entryOut.inode) {
+                      return folly::unit;
+                    }
+                    child->incFsRefcount();
+                    *entryOut.entry =
+                        computeEntryParam(FuseDispatcher::Attr{st});
+                    return folly::unit;
+                  }));
+        }
+        return collectAllSafe(std::move(futures))
+            .thenValue([list = std::move(list)](
+                           std::vector<folly::Unit>&&) mutable {
+              return std::move(list);
+            });
+      });
+}
+
 ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     InodeNumber parent,
     PathComponentPiece name,
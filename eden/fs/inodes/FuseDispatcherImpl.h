@@ -24,6 +24,7 @@ class FuseDispatcherImpl : public FuseDispatcher {
  public:
   explicit FuseDispatcherImpl(EdenMount* mount);
 
+  ImmediateFuture<folly::Unit> ensureInitialized() override;
   ImmediateFuture<struct fuse_kstatfs> statfs(InodeNumber ino) override;
   ImmediateFuture<Attr> getattr(InodeNumber ino, ObjectFetchContext& context)
       override;
@@ -41,6 +42,7 @@ class FuseDispatcherImpl : public FuseDispatcher {
       ObjectFetchContext& context) override;
 
   void forget(InodeNumber ino, unsigned long nlookup) override;
+  void batchForget(folly::Range<const fuse_forget_one*> forgets) override;
   ImmediateFuture<uint64_t> open(InodeNumber ino, int flags) override;
   ImmediateFuture<std::string> readlink(
       InodeNumber ino,
@@ -94,6 +96,11 @@ class FuseDispatcherImpl : public FuseDispatcher {
       size_t size,
       off_t off,
       ObjectFetchContext& context) override;
+  ImmediateFuture<std::variant<BufVec, FileRange>> readSpliceable(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      ObjectFetchContext& context) override;
   ImmediateFuture<size_t> write(
       InodeNumber ino,
       folly::StringPiece data,
@@ -117,6 +124,12 @@ class FuseDispatcherImpl : public FuseDispatcher {
       off_t offset,
       uint64_t fh,
       ObjectFetchContext& context) override;
+  ImmediateFuture<FuseDirList> readdirplus(
+      InodeNumber ino,
+      FuseDirList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      ObjectFetchContext& context) override;
 
   ImmediateFuture<std::string> getxattr(
       InodeNumber ino,
@@ -9,6 +9,7 @@
 #include <iomanip>
 #include <iostream>
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/NameIndex.h"
 
 using folly::StringPiece;
 using std::string;
@@ -218,8 +219,62 @@ struct TreeRoot {
     return this->entryToResult(std::move(entryPath), &entry, originRootId);
   }
 };
+
+/**
+ * When evaluating in parallel, continue the evaluation on the CPU pool once
+ * `future` completes.
+ */
+template <typename T>
+ImmediateFuture<T> continueOn(
+    ImmediateFuture<T>&& future,
+    GlobNode::ParallelEvaluation* parallel) {
+  if (!parallel) {
+    return std::move(future);
+  }
+  return std::move(future).semi().via(parallel->executor).semi();
+}
+
+ImmediateFuture<std::shared_ptr<const Tree>> getTree(
+    const ObjectStore* store,
+    ObjectFetchContext& context,
+    const ObjectId& id,
+    GlobNode::ParallelEvaluation* parallel) {
+  if (!parallel) {
+    return store->getTree(id, context);
+  }
+  return continueOn(
+      parallel->treeLoads.run(
+          [store, &context, id] { return store->getTree(id, context); }),
+      parallel);
+}
 } // namespace
 
+void GlobNode::ResultList::add(GlobResult&& result) {
+  std::vector<GlobResult> chunk;
+  {
+    auto results = results_.wlock();
+    results->push_back(std::move(result));
+    if (chunkSize_ == 0 || results->size() < chunkSize_) {
+      return;
+    }
+    chunk.swap(*results);
+  }
+  // Chunks may be handed over concurrently, but not while holding the lock,
+  // so that evaluation isn't blocked on the consumer.
+  onChunk_(std::move(chunk));
+}
+
+void GlobNode::ResultList::flush() {
+  if (chunkSize_ == 0) {
+    return;
+  }
+  std::vector<GlobResult> chunk;
+  chunk.swap(*results_.wlock());
+  if (!chunk.empty()) {
+    onChunk_(std::move(chunk));
+  }
+}
+
 GlobNode::GlobNode(StringPiece pattern, bool includeDotfiles, bool hasSpecials)
     : pattern_(pattern.str()),
       includeDotfiles_(includeDotfiles),
@@ -282,6 +337,7 @@ void GlobNode::parse(StringPiece pattern) {
       container->emplace_back(
           std::make_unique<GlobNode>(token, includeDotfiles_, hasSpecials));
       node = container->back().get();
+      parent->addChildMatcher(node, container == &parent->recursiveChildren_);
     }
 
     // If there are no more tokens remaining then we have a leaf node
@@ -306,8 +362,9 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
     ROOT&& root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
-  vector<std::pair<PathComponentPiece, GlobNode*>> recurse;
+    const RootId& originRootId,
+    ParallelEvaluation* parallel) const {
+  vector<std::pair<PathComponentPiece, const GlobNode*>> recurse;
   vector<ImmediateFuture<folly::Unit>> futures;
 
   if (!recursiveChildren_.empty()) {
@@ -319,25 +376,27 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
         root,
         fileBlobsToPrefetch,
         globResult,
-        originRootId));
+        originRootId,
+        parallel));
   }
 
   auto recurseIfNecessary =
-      [&](PathComponentPiece name, GlobNode* node, const auto& entry) {
+      [&](PathComponentPiece name, const GlobNode* node, const auto& entry) {
         if ((!node->children_.empty() || !node->recursiveChildren_.empty()) &&
             root.entryIsTree(entry)) {
           if (root.entryShouldLoadChildTree(entry)) {
             recurse.emplace_back(name, node);
           } else {
             futures.emplace_back(
-                store->getTree(root.entryHash(entry), context)
+                getTree(store, context, root.entryHash(entry), parallel)
                     .thenValue([candidateName = rootPath + name,
                                 store,
                                 &context,
                                 innerNode = node,
                                 fileBlobsToPrefetch,
                                 &globResult,
-                                &originRootId](
+                                &originRootId,
+                                parallel](
                                    std::shared_ptr<const Tree> dir) mutable {
                       return innerNode->evaluateImpl(
                           store,
@@ -346,7 +405,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
                           TreeRoot(std::move(dir)),
                           fileBlobsToPrefetch,
                           globResult,
-                          originRootId);
+                          originRootId,
+                          parallel);
                     }));
           }
         }
@@ -362,7 +422,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
         if (entry) {
           // Matched!
           if (node->isLeaf_) {
-            globResult.wlock()->emplace_back(
+            globResult.add(
                 root.entryToResult(rootPath + name, entry, originRootId));
 
             if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
@@ -373,24 +433,31 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           // Not the leaf of a pattern; if this is a dir, we need to recurse
           recurseIfNecessary(name, node.get(), entry);
         }
-      } else {
-        // We need to match it out of the entries in this inode
-        for (auto& entry : root.iterate(contents)) {
-          auto name = root.entryName(entry);
-          if (node->alwaysMatch_ || node->matcher_.match(name.stringPiece())) {
-            if (node->isLeaf_) {
-              globResult.wlock()->emplace_back(
-                  root.entryToResult(rootPath + name, entry, originRootId));
-              if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
-                fileBlobsToPrefetch->wlock()->emplace_back(
-                    root.entryHash(entry));
-              }
+      }
+    }
+
+    // We need to match the other children out of the entries in this inode.
+    // Each entry is matched against all of them at once.
+    if (!alwaysMatchChildren_.empty() || !childMatcher_.empty()) {
+      for (auto& entry : root.iterate(contents)) {
+        auto name = root.entryName(entry);
+        auto onMatch = [&](const GlobNode* node) {
+          if (node->isLeaf_) {
+            globResult.add(
+                root.entryToResult(rootPath + name, entry, originRootId));
+            if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
+              fileBlobsToPrefetch->wlock()->emplace_back(root.entryHash(entry));
             }
-            // Not the leaf of a pattern; if this is a dir, we need to
-            // recurse
-            recurseIfNecessary(name, node.get(), entry);
           }
+          // Not the leaf of a pattern; if this is a dir, we need to recurse
+          recurseIfNecessary(name, node, entry);
+        };
+        for (auto* node : alwaysMatchChildren_) {
+          onMatch(node);
         }
+        childMatcher_.match(name.stringPiece(), [&](size_t idx) {
+          onMatch(childMatcherNodes_[idx]);
+        });
       }
     }
   }
@@ -398,23 +465,26 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
   // Recursively load child inodes and evaluate matches
 
   for (auto& item : recurse) {
-    futures.emplace_back(root.getOrLoadChildTree(item.first, context)
-                             .thenValue([store,
-                                         &context,
-                                         candidateName = rootPath + item.first,
-                                         node = item.second,
-                                         fileBlobsToPrefetch,
-                                         &globResult,
-                                         &originRootId](TreeInodePtr dir) {
-                               return node->evaluateImpl(
-                                   store,
-                                   context,
-                                   candidateName,
-                                   TreeInodePtrRoot(std::move(dir)),
-                                   fileBlobsToPrefetch,
-                                   globResult,
-                                   originRootId);
-                             }));
+    futures.emplace_back(
+        continueOn(root.getOrLoadChildTree(item.first, context), parallel)
+            .thenValue([store,
+                        &context,
+                        candidateName = rootPath + item.first,
+                        node = item.second,
+                        fileBlobsToPrefetch,
+                        &globResult,
+                        &originRootId,
+                        parallel](TreeInodePtr dir) {
+              return node->evaluateImpl(
+                  store,
+                  context,
+                  candidateName,
+                  TreeInodePtrRoot(std::move(dir)),
+                  fileBlobsToPrefetch,
+                  globResult,
+                  originRootId,
+                  parallel);
+            }));
   }
 
   // Note: we use collectAll() rather than collect() here to make sure that
@@ -437,7 +507,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     TreeInodePtr root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    ParallelEvaluation* parallel) const {
   return evaluateImpl(
       store,
       context,
@@ -445,7 +516,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
       TreeInodePtrRoot(std::move(root)),
       fileBlobsToPrefetch,
       globResult,
-      originRootId);
+      originRootId,
+      parallel);
 }
 
 ImmediateFuture<folly::Unit> GlobNode::evaluate(
@@ -455,7 +527,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     std::shared_ptr<const Tree> tree,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    ParallelEvaluation* parallel) const {
   return evaluateImpl(
       store,
       context,
@@ -463,7 +536,58 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
       TreeRoot(std::move(tree)),
       fileBlobsToPrefetch,
       globResult,
-      originRootId);
+      originRootId,
+      parallel);
+}
+
+std::optional<vector<PathComponentPiece>> GlobNode::getIndexedNames() const {
+  if (!children_.empty() || recursiveChildren_.empty()) {
+    return std::nullopt;
+  }
+  vector<PathComponentPiece> names;
+  for (const auto& node : recursiveChildren_) {
+    auto pattern = StringPiece{node->pattern_};
+    if (!pattern.removePrefix("**/")) {
+      return std::nullopt;
+    }
+    bool hasSpecials;
+    auto token = tokenize(pattern, &hasSpecials);
+    if (hasSpecials || !pattern.empty() || token.empty() || token == "." ||
+        token == "..") {
+      return std::nullopt;
+    }
+    names.emplace_back(token);
+  }
+  return names;
+}
+
+bool GlobNode::canEvaluateFromNameIndex() const {
+  return getIndexedNames().has_value();
+}
+
+bool GlobNode::evaluateFromNameIndex(
+    const NameIndex& index,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    GlobNode::ResultList& globResult,
+    const RootId& originRootId) const {
+  auto names = getIndexedNames();
+  if (!names) {
+    return false;
+  }
+  for (auto name : *names) {
+    for (const auto& [path, entry] : index.lookup(name)) {
+      // The name matches, but the rest of the path may not: dotfiles, for
+      // instance.
+      if (!recursiveMatcher_.matchesAny(path.stringPiece())) {
+        continue;
+      }
+      globResult.add(GlobResult{path, entry.getDType(), originRootId});
+      if (fileBlobsToPrefetch && !entry.isTree()) {
+        fileBlobsToPrefetch->wlock()->emplace_back(entry.getHash());
+      }
+    }
+  }
+  return true;
 }
 
 StringPiece GlobNode::tokenize(StringPiece& pattern, bool* hasSpecials) {
@@ -493,6 +617,21 @@ StringPiece GlobNode::tokenize(StringPiece& pattern, bool* hasSpecials) {
   return token;
 }
 
+void GlobNode::addChildMatcher(const GlobNode* child, bool recursive) {
+  if (recursive) {
+    if (child->alwaysMatch_) {
+      recursiveAlwaysMatch_ = true;
+    } else {
+      recursiveMatcher_.add(child->matcher_);
+    }
+  } else if (child->alwaysMatch_) {
+    alwaysMatchChildren_.push_back(child);
+  } else if (child->hasSpecials_) {
+    childMatcher_.add(child->matcher_);
+    childMatcherNodes_.push_back(child);
+  }
+}
+
 GlobNode* GlobNode::lookupToken(
     vector<unique_ptr<GlobNode>>* container,
     StringPiece token) {
@@ -513,7 +652,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     ROOT&& root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    ParallelEvaluation* parallel) const {
   vector<RelativePath> subDirNames;
   vector<ImmediateFuture<folly::Unit>> futures;
   {
@@ -521,16 +661,13 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     for (auto& entry : root.iterate(contents)) {
       auto candidateName = startOfRecursive + root.entryName(entry);
 
-      for (auto& node : recursiveChildren_) {
-        if (node->alwaysMatch_ ||
-            node->matcher_.match(candidateName.stringPiece())) {
-          globResult.wlock()->emplace_back(root.entryToResult(
-              rootPath + candidateName.copy(), entry, originRootId));
-          if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
-            fileBlobsToPrefetch->wlock()->emplace_back(root.entryHash(entry));
-          }
-          // No sense running multiple matches for this same file.
-          break;
+      // No sense running multiple matches for this same file.
+      if (recursiveAlwaysMatch_ ||
+          recursiveMatcher_.matchesAny(candidateName.stringPiece())) {
+        globResult.add(root.entryToResult(
+            rootPath + candidateName.copy(), entry, originRootId));
+        if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
+          fileBlobsToPrefetch->wlock()->emplace_back(root.entryHash(entry));
         }
       }
 
@@ -541,7 +678,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
           subDirNames.emplace_back(std::move(candidateName));
         } else {
           futures.emplace_back(
-              store->getTree(root.entryHash(entry), context)
+              getTree(store, context, root.entryHash(entry), parallel)
                   .thenValue([candidateName = std::move(candidateName),
                               rootPath = rootPath.copy(),
                               store,
@@ -549,7 +686,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                               this,
                               fileBlobsToPrefetch,
                               &globResult,
-                              &originRootId](std::shared_ptr<const Tree> tree) {
+                              &originRootId,
+                              parallel](std::shared_ptr<const Tree> tree) {
                     return evaluateRecursiveComponentImpl(
                         store,
                         context,
@@ -558,7 +696,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                         TreeRoot(std::move(tree)),
                         fileBlobsToPrefetch,
                         globResult,
-                        originRootId);
+                        originRootId,
+                        parallel);
                   }));
         }
       }
@@ -567,8 +706,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
 
   // Recursively load child inodes and evaluate matches
   for (auto& candidateName : subDirNames) {
-    auto childTreeFuture =
-        root.getOrLoadChildTree(candidateName.basename(), context);
+    auto childTreeFuture = continueOn(
+        root.getOrLoadChildTree(candidateName.basename(), context), parallel);
     futures.emplace_back(
         std::move(childTreeFuture)
             .thenValue([candidateName = std::move(candidateName),
@@ -578,7 +717,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                         this,
                         fileBlobsToPrefetch,
                         &globResult,
-                        &originRootId](TreeInodePtr dir) {
+                        &originRootId,
+                        parallel](TreeInodePtr dir) {
               return evaluateRecursiveComponentImpl(
                   store,
                   context,
@@ -587,7 +727,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                   TreeInodePtrRoot(std::move(dir)),
                   fileBlobsToPrefetch,
                   globResult,
-                  originRootId);
+                  originRootId,
+                  parallel);
             }));
   }
 
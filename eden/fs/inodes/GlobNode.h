@@ -6,11 +6,15 @@
  */
 
 #pragma once
+#include <functional>
+#include <optional>
 #include <ostream>
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GlobMatcher.h"
+#include "eden/fs/model/git/MultiGlobMatcher.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/ConcurrencyLimiter.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -18,6 +22,8 @@
 namespace facebook {
 namespace eden {
 
+class NameIndex;
+
 /** Represents the compiled state of a tree-walking glob operation.
  * We split the glob into path components and build a tree of name
  * matching operations.
@@ -76,7 +82,59 @@ class GlobNode {
         : name(std::move(name)), dtype(dtype), originHash(&originHash) {}
   };
 
-  using ResultList = folly::Synchronized<std::vector<GlobResult>>;
+  /**
+   * Collects the results of evaluate().
+   *
+   * By default the results are kept until the caller takes them. A ResultList
+   * created with a chunk size instead hands them to `onChunk` as they are
+   * found, that many at a time, so that they can be streamed to the client
+   * without holding all of them in memory.
+   */
+  class ResultList {
+   public:
+    using ChunkCallback = std::function<void(std::vector<GlobResult>&&)>;
+
+    ResultList() = default;
+    ResultList(size_t chunkSize, ChunkCallback onChunk)
+        : chunkSize_{chunkSize}, onChunk_{std::move(onChunk)} {}
+
+    void add(GlobResult&& result);
+
+    /**
+     * Hand the results that do not fill a whole chunk to `onChunk`. Does
+     * nothing for a ResultList without a chunk size.
+     */
+    void flush();
+
+    auto wlock() {
+      return results_.wlock();
+    }
+
+    auto rlock() const {
+      return results_.rlock();
+    }
+
+   private:
+    size_t chunkSize_{0};
+    ChunkCallback onChunk_;
+    folly::Synchronized<std::vector<GlobResult>> results_;
+  };
+
+  /**
+   * Lets evaluate() match subtrees concurrently: the matching of each subtree
+   * continues on `executor` once it is loaded, and at most `maxTreeLoads`
+   * trees are fetched from the ObjectStore at a time.
+   *
+   * The results are the same as those of serial evaluation, but in a
+   * different order.
+   */
+  struct ParallelEvaluation {
+    ParallelEvaluation(folly::Executor* executor, size_t maxTreeLoads)
+        : executor{executor}, treeLoads{maxTreeLoads} {}
+
+    folly::Executor* const executor;
+    ConcurrencyLimiter treeLoads;
+  };
 
   // Compile and add a new glob pattern to the tree.
   // Compilation splits the pattern into nodes, with one node for each
@@ -92,6 +150,10 @@ class GlobNode {
    *
    * When fileBlobsToPrefetch is non-null, the Hash of the globbed files will
    * be appended to it.
+   *
+   * When parallel is non-null, subtrees are evaluated concurrently as
+   * described by ParallelEvaluation. It must outlive the returned
+   * ImmediateFuture.
    */
   ImmediateFuture<folly::Unit> evaluate(
       const ObjectStore* store,
@@ -100,7 +162,8 @@ class GlobNode {
       TreeInodePtr root,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      ParallelEvaluation* parallel = nullptr) const;
 
   /**
    * Evaluate the compiled glob against the provided Tree.
@@ -114,8 +177,29 @@ class GlobNode {
       std::shared_ptr<const Tree> tree,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
+      const RootId& originRootId,
+      ParallelEvaluation* parallel = nullptr) const;
+
+  /**
+   * If every pattern of this glob has the form `**/name`, where `name` has no
+   * special characters, evaluate it against the root of `index` by matching
+   * only the entries with those names, and return true. Otherwise return
+   * false without evaluating anything.
+   *
+   * The results are the same as those of evaluate() against the root tree
+   * that `index` was built from.
+   */
+  bool evaluateFromNameIndex(
+      const NameIndex& index,
+      PrefetchList* fileBlobsToPrefetch,
+      ResultList& globResult,
       const RootId& originRootId) const;
 
+  /**
+   * Whether evaluateFromNameIndex() would evaluate this glob.
+   */
+  bool canEvaluateFromNameIndex() const;
+
   /**
    * Print a human-readable description of this GlobNode to stderr.
    *
@@ -140,6 +224,12 @@ class GlobNode {
   GlobNode* lookupToken(
       std::vector<std::unique_ptr<GlobNode>>* container,
       folly::StringPiece token);
+  // The names matched by the patterns of this glob, if they all have the
+  // form `**/name` where name has no special characters.
+  std::optional<std::vector<PathComponentPiece>> getIndexedNames() const;
+  // Add the matcher of a new child node to childMatcher_, or to
+  // recursiveMatcher_ if it is one of recursiveChildren_.
+  void addChildMatcher(const GlobNode* child, bool recursive);
   // Evaluates any recursive glob entries associated with this node.
   // This is a recursive function which evaluates the current GlobNode against
   // the recursive set of children.
@@ -156,7 +246,8 @@ class GlobNode {
       ROOT&& root,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      ParallelEvaluation* parallel) const;
 
   template <typename ROOT>
   ImmediateFuture<folly::Unit> evaluateImpl(
@@ -166,7 +257,8 @@ class GlobNode {
       ROOT&& root,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      ParallelEvaluation* parallel) const;
 
   void debugDump(int currentDepth) const;
 
@@ -179,6 +271,18 @@ class GlobNode {
   // List of ** child rules
   std::vector<std::unique_ptr<GlobNode>> recursiveChildren_;
 
+  // The matchers of the children_ with special characters, so that each
+  // entry is matched against all of them at once. childMatcherNodes_ maps
+  // the indices reported by childMatcher_ to the children.
+  // alwaysMatchChildren_ holds the children that match every entry.
+  MultiGlobMatcher childMatcher_;
+  std::vector<const GlobNode*> childMatcherNodes_;
+  std::vector<const GlobNode*> alwaysMatchChildren_;
+  // Likewise for recursiveChildren_, for which we only need to know whether
+  // any of them matches.
+  MultiGlobMatcher recursiveMatcher_;
+  bool recursiveAlwaysMatch_{false};
+
   // For a child GlobNode that is added to this GlobNode (presumably via
   // parse()), the GlobMatcher pattern associated with the child node should use
   // this value for its includeDotfiles parameter.
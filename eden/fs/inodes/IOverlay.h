@@ -18,6 +18,8 @@
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
@@ -121,6 +123,41 @@ class IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) = 0;
 
+  /**
+   * Create an overlay file for a FileInode materialized from the blob
+   * `blobId`, whose contents are `contents`. Implementations may clone the
+   * file from an on-disk copy of the blob instead of writing `contents`.
+   */
+  virtual folly::File createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) = 0;
+
+  struct FileCopyStats {
+    /// Bytes of overlay files cloned from on-disk copies of their blobs.
+    uint64_t bytesCloned{0};
+    /// Bytes of overlay files created from blobs by copying their contents.
+    uint64_t bytesCopied{0};
+    /// Bytes of overlay files made to share their data with identical files.
+    uint64_t bytesDeduplicated{0};
+  };
+
+  /**
+   * How the overlay files created by createOverlayFileFromBlob() were filled.
+   */
+  virtual FileCopyStats getFileCopyStats() const = 0;
+
+  /**
+   * Let the overlay file `fd`, whose contents have the SHA-1 `sha1`, share
+   * its data with an identical overlay file, if the overlay keeps a store of
+   * them. Returns whether it does now.
+   */
+  virtual bool deduplicateFile(int fd, const Hash20& sha1) {
+    (void)fd;
+    (void)sha1;
+    return false;
+  }
+
   /**
    * Helper function that opens an existing overlay file,
    * checks if the file has valid header, and returns the file.
@@ -162,5 +199,20 @@ class IOverlay {
       InodeNumber /* dst */,
       PathComponentPiece /* srcName */,
       PathComponentPiece /* destName */) {}
+
+  /**
+   * Group the following mutations, until the matching endBatch(), so that
+   * they are committed together every `commitInterval` mutations, or only
+   * at the end if it is 0, instead of one at a time. Mutations made from
+   * other threads while a batch is open join it. Batches may nest.
+   *
+   * Implementations that commit each mutation on its own may ignore this.
+   */
+  virtual void beginBatch(size_t /* commitInterval */) {}
+
+  /**
+   * Commit the mutations of the batch started by the matching beginBatch().
+   */
+  virtual void endBatch() {}
 };
 } // namespace facebook::eden
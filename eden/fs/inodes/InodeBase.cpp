@@ -15,6 +15,7 @@
 #include "eden/fs/inodes/ParentInodeInfo.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/utils/Clock.h"
+#include "eden/fs/utils/MemoryArena.h"
 #include "eden/fs/utils/NotImplemented.h"
 
 #ifndef _WIN32
@@ -74,6 +75,14 @@ InodeBase::~InodeBase() {
              << ") destroyed: " << getLogPath();
 }
 
+void* InodeBase::operator new(size_t size) {
+  return MemoryArena::inodes().allocate(size);
+}
+
+void InodeBase::operator delete(void* ptr, size_t size) noexcept {
+  MemoryArena::inodes().deallocate(ptr, size);
+}
+
 #ifndef _WIN32
 folly::Future<folly::Unit> InodeBase::setxattr(
     folly::StringPiece /*name*/,
@@ -106,6 +115,16 @@ bool InodeBase::isUnlinked() const {
 bool InodeBase::getPathHelper(
     std::vector<PathComponent>& names,
     bool stopOnUnlinked) const {
+  // Stop at the root inode.
+  //
+  // We check for this based on inode number before taking a reference to
+  // each parent.  This way path lookups neither acquire the root inode's
+  // location lock nor touch its reference count, both of which would
+  // otherwise be contended by every thread computing a path.
+  auto isRoot = [](const TreeInodePtr& inode) {
+    return inode->ino_ == kRootNodeId;
+  };
+
   TreeInodePtr parent;
   bool unlinked = false;
   {
@@ -116,24 +135,15 @@ bool InodeBase::getPathHelper(
       }
       unlinked = true;
     }
-    parent = loc->parent;
     // Our caller should ensure that we are not the root
-    XDCHECK(parent);
+    XDCHECK(loc->parent);
     names.push_back(loc->name);
-  }
-
-  while (true) {
-    // Stop at the root inode.
-    // We check for this based on inode number so we can stop without having to
-    // acquire the root inode's location lock.  (Otherwise all path lookups
-    // would have to acquire the root's lock, making it more likely to be
-    // contended.)
-    if (parent->ino_ == kRootNodeId) {
-      // Reverse the names vector, since we built it from bottom to top.
-      std::reverse(names.begin(), names.end());
-      return !unlinked;
+    if (!isRoot(loc->parent)) {
+      parent = loc->parent;
     }
+  }
 
+  while (parent) {
     auto loc = parent->location_.rlock();
     // In general our parent should not be unlinked if we are not unlinked,
     // which we checked above.  However, we have since released our location
@@ -146,9 +156,16 @@ bool InodeBase::getPathHelper(
       unlinked = true;
     }
     names.push_back(loc->name);
+    XDCHECK(loc->parent);
+    if (isRoot(loc->parent)) {
+      break;
+    }
     parent = loc->parent;
-    XDCHECK(parent);
   }
+
+  // Reverse the names vector, since we built it from bottom to top.
+  std::reverse(names.begin(), names.end());
+  return !unlinked;
 }
 
 std::optional<RelativePath> InodeBase::getPath() const {
@@ -200,8 +217,23 @@ std::unique_ptr<InodeBase> InodeBase::markUnlinked(
     TreeInode* parent,
     PathComponentPiece name,
     const RenameLock& renameLock) {
-  XLOG(DBG5) << "inode " << this << " unlinked: " << getLogPath();
   XDCHECK(renameLock.isHeld(mount_));
+  return markUnlinkedImpl(parent, name);
+}
+
+std::unique_ptr<InodeBase> InodeBase::markUnlinked(
+    TreeInode* parent,
+    PathComponentPiece name,
+    const SharedRenameLock& renameLock) {
+  XDCHECK(renameLock.isHeld(mount_));
+  XDCHECK(!isDir());
+  return markUnlinkedImpl(parent, name);
+}
+
+std::unique_ptr<InodeBase> InodeBase::markUnlinkedImpl(
+    TreeInode* parent,
+    PathComponentPiece name) {
+  XLOG(DBG5) << "inode " << this << " unlinked: " << getLogPath();
 
   {
     auto loc = location_.wlock();
@@ -211,9 +243,10 @@ std::unique_ptr<InodeBase> InodeBase::markUnlinked(
   }
 
   // Grab the inode map lock, and check if we should unload
-  // ourself immediately.
+  // ourself immediately. We are unlinked, so we will only be unloaded if we
+  // can be forgotten entirely, for which our own shard is enough.
   auto* inodeMap = getMount()->getInodeMap();
-  auto inodeMapLock = inodeMap->lockForUnload();
+  auto inodeMapLock = inodeMap->lockForUnload(getNodeId());
   if (isPtrAcquireCountZero() && getFsRefcount() == 0) {
     inodeMap->unloadInode(this, parent, name, true, inodeMapLock);
     // We have to delete ourself now.
@@ -241,9 +274,24 @@ void InodeBase::updateLocation(
     TreeInodePtr newParent,
     PathComponentPiece newName,
     const RenameLock& renameLock) {
+  XDCHECK(renameLock.isHeld(mount_));
+  updateLocationImpl(std::move(newParent), newName);
+}
+
+void InodeBase::updateLocation(
+    TreeInodePtr newParent,
+    PathComponentPiece newName,
+    const SharedRenameLock& renameLock) {
+  XDCHECK(renameLock.isHeld(mount_));
+  XDCHECK(!isDir());
+  updateLocationImpl(std::move(newParent), newName);
+}
+
+void InodeBase::updateLocationImpl(
+    TreeInodePtr newParent,
+    PathComponentPiece newName) {
   XLOG(DBG5) << "inode " << this << " renamed: " << getLogPath() << " --> "
              << newParent->getLogPath() << " / \"" << newName << "\"";
-  XDCHECK(renameLock.isHeld(mount_));
   XDCHECK_EQ(mount_, newParent->mount_);
 
   auto loc = location_.wlock();
@@ -53,6 +53,13 @@ class InodeBase {
 
   virtual ~InodeBase();
 
+  /**
+   * Inodes are allocated from MemoryArena::inodes(), apart from the
+   * short-lived allocations of the requests that load them.
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size) noexcept;
+
   InodeNumber getNodeId() const {
     return ino_;
   }
@@ -235,6 +242,14 @@ class InodeBase {
       TreeInode* parent,
       PathComponentPiece name,
       const RenameLock& renameLock);
+  /**
+   * Files can be unlinked by a rename that holds the rename lock shared, as
+   * that doesn't move any directory.
+   */
+  std::unique_ptr<InodeBase> markUnlinked(
+      TreeInode* parent,
+      PathComponentPiece name,
+      const SharedRenameLock& renameLock);
 
   /**
    * This method should only be called by TreeInode::loadUnlinkedChildInode().
@@ -253,6 +268,13 @@ class InodeBase {
       TreeInodePtr newParent,
       PathComponentPiece newName,
       const RenameLock& renameLock);
+  /**
+   * Files can also be renamed while holding the rename lock shared.
+   */
+  void updateLocation(
+      TreeInodePtr newParent,
+      PathComponentPiece newName,
+      const SharedRenameLock& renameLock);
 
   /**
    * Check to see if the ptrAcquire reference count is zero.
@@ -466,9 +488,18 @@ class InodeBase {
   bool getPathHelper(std::vector<PathComponent>& names, bool stopOnUnlinked)
       const;
 
+  std::unique_ptr<InodeBase> markUnlinkedImpl(
+      TreeInode* parent,
+      PathComponentPiece name);
+  void updateLocationImpl(TreeInodePtr newParent, PathComponentPiece newName);
+
   // incrementPtrRef() is called by InodePtr whenever an InodePtr is copied.
+  //
+  // The caller already holds a reference, so the inode can't be unloaded
+  // concurrently and the increment needs no ordering, as with
+  // std::shared_ptr.  This keeps copies down to a single plain atomic add.
   void incrementPtrRef() const {
-    auto prevValue = ptrRefcount_.fetch_add(1, std::memory_order_acq_rel);
+    auto prevValue = ptrRefcount_.fetch_add(1, std::memory_order_relaxed);
     // Calls to incrementPtrRef() are not allowed to increment the reference
     // count from 0 to 1.
     //
@@ -489,8 +520,11 @@ class InodeBase {
     }
   }
   void decrementPtrRef() const {
-    auto prevValue = ptrRefcount_.fetch_sub(1, std::memory_order_acq_rel);
+    // Only the thread that drops the last reference needs to see the writes
+    // made through the other references, so it alone pays for the acquire.
+    auto prevValue = ptrRefcount_.fetch_sub(1, std::memory_order_release);
     if (prevValue == 1) {
+      std::atomic_thread_fence(std::memory_order_acquire);
       onPtrRefZero();
     }
   }
@@ -659,7 +693,7 @@ class InodeBaseMetadata : public InodeBase {
    * Note that FUSE doesn't claim to fully implement atime.
    * https://sourceforge.net/p/fuse/mailman/message/34448996/
    */
-  void updateAtimeLocked(InodeState&) {
+  void updateAtimeLocked(const InodeState&) {
     return InodeBase::updateAtime();
   }
 
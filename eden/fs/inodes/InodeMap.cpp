@@ -8,9 +8,11 @@
 #include "eden/fs/inodes/InodeMap.h"
 
 #include <boost/polymorphic_cast.hpp>
+#include <algorithm>
 
 #include <folly/Exception.h>
 #include <folly/Likely.h>
+#include <folly/Utility.h>
 #include <folly/chrono/Conv.h>
 #include <folly/logging/xlog.h>
 
@@ -25,6 +27,7 @@
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/TimeUtil.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 using folly::Future;
 using folly::Promise;
@@ -38,46 +41,46 @@ namespace eden {
 InodeMap::UnloadedInode::UnloadedInode(
     InodeNumber parentNum,
     PathComponentPiece entryName)
-    : parent(parentNum), name(entryName) {}
+    : UnloadedInode{
+          parentNum,
+          entryName,
+          /*isUnlinked=*/false,
+          /*mode=*/0,
+          static_cast<const ObjectId*>(nullptr),
+          /*fsRefcount=*/0} {}
 
 InodeMap::UnloadedInode::UnloadedInode(
     InodeNumber parentNum,
     PathComponentPiece entryName,
     bool isUnlinked,
     mode_t mode,
-    std::optional<ObjectId> hash,
+    const std::optional<ObjectId>& hash,
     uint32_t fsRefcount)
-    : parent(parentNum),
-      name(entryName),
-      isUnlinked{isUnlinked},
-      mode{mode},
-      hash{hash},
-      numFsReferences{fsRefcount} {
-  if (folly::kIsWindows) {
-    XDCHECK_LE(numFsReferences, 1u);
-  }
-}
+    : UnloadedInode{
+          parentNum,
+          entryName,
+          isUnlinked,
+          mode,
+          hash ? &hash.value() : nullptr,
+          fsRefcount} {}
 
 InodeMap::UnloadedInode::UnloadedInode(
     TreeInode* parent,
     PathComponentPiece entryName,
     bool isUnlinked,
-    std::optional<ObjectId> hash,
+    const std::optional<ObjectId>& hash,
     uint32_t fsRefcount)
-    : parent{parent->getNodeId()},
-      name{entryName},
-      isUnlinked{isUnlinked},
-      // There is no asTree->getMode() we can call,
-      // however, directories are always represented with
-      // this specific mode bit pattern in eden so we can
-      // force the value down here.
-      mode{S_IFDIR | 0755},
-      hash{hash},
-      numFsReferences{fsRefcount} {
-  if (folly::kIsWindows) {
-    XDCHECK_LE(numFsReferences, 1u);
-  }
-}
+    : UnloadedInode{
+          parent->getNodeId(),
+          entryName,
+          isUnlinked,
+          // There is no asTree->getMode() we can call,
+          // however, directories are always represented with
+          // this specific mode bit pattern in eden so we can
+          // force the value down here.
+          S_IFDIR | 0755,
+          hash,
+          fsRefcount} {}
 
 InodeMap::UnloadedInode::UnloadedInode(
     FileInode* inode,
@@ -85,15 +88,84 @@ InodeMap::UnloadedInode::UnloadedInode(
     PathComponentPiece entryName,
     bool isUnlinked,
     uint32_t fsRefcount)
-    : parent{parent->getNodeId()},
-      name{entryName},
-      isUnlinked{isUnlinked},
-      mode{inode->getMode()},
-      hash{inode->getBlobHash()},
-      numFsReferences{fsRefcount} {
+    : UnloadedInode{
+          parent->getNodeId(),
+          entryName,
+          isUnlinked,
+          inode->getMode(),
+          inode->getBlobHash(),
+          fsRefcount} {}
+
+InodeMap::UnloadedInode::UnloadedInode(
+    InodeNumber parentNum,
+    PathComponentPiece entryName,
+    bool isUnlinked,
+    mode_t mode,
+    const ObjectId* hash,
+    uint32_t fsRefcount)
+    : numFsReferences{fsRefcount},
+      parent_{parentNum},
+      mode_{mode},
+      nameSize_{folly::to_narrow(entryName.value().size())},
+      hasHash_{hash != nullptr},
+      isUnlinked_{isUnlinked} {
   if (folly::kIsWindows) {
     XDCHECK_LE(numFsReferences, 1u);
   }
+
+  auto hashBytes = hash ? hash->getBytes() : folly::ByteRange{};
+  XCHECK_LE(hashBytes.size(), std::numeric_limits<uint16_t>::max());
+  hashSize_ = static_cast<uint16_t>(hashBytes.size());
+  if (nameSize_ + hashSize_ > 0) {
+    data_ = std::make_unique<char[]>(nameSize_ + hashSize_);
+    memcpy(data_.get(), entryName.value().data(), nameSize_);
+    if (hashSize_ > 0) {
+      memcpy(data_.get() + nameSize_, hashBytes.data(), hashSize_);
+    }
+  }
+}
+
+std::optional<ObjectId> InodeMap::UnloadedInode::getHash() const {
+  if (!hasHash_) {
+    return std::nullopt;
+  }
+  return ObjectId{folly::ByteRange{
+      reinterpret_cast<const uint8_t*>(data_.get() + nameSize_), hashSize_}};
+}
+
+folly::Promise<InodePtr>& InodeMap::UnloadedInode::addPromise() {
+  if (!promises_) {
+    promises_ = std::make_unique<PromiseVector>();
+  }
+  return promises_->emplace_back();
+}
+
+InodeMap::PromiseVector InodeMap::UnloadedInode::extractPromises() {
+  PromiseVector promises;
+  if (promises_) {
+    promises = std::move(*promises_);
+    promises_.reset();
+  }
+  return promises;
+}
+
+size_t InodeMap::Members::getUnloadedInodeMemory() const {
+  // std::unordered_map allocates one node per entry, holding the value and a
+  // pointer to the next node, plus one pointer per bucket.
+  constexpr size_t kNodeSize =
+      sizeof(UnloadedInodeMap::value_type) + sizeof(void*);
+  return unloadedInodes_.size() * kNodeSize +
+      unloadedInodes_.bucket_count() * sizeof(void*) + unloadedInodeHeapBytes_;
+}
+
+size_t InodeMap::Members::getLoadedInodeMemory() const {
+  // Only the fixed size of each inode is counted: the entries of a TreeInode
+  // are behind its own lock, and walking them here would be too costly.
+  constexpr size_t kNodeSize =
+      sizeof(decltype(loadedInodes_)::value_type) + sizeof(void*);
+  return loadedInodes_.size() * kNodeSize +
+      loadedInodes_.bucket_count() * sizeof(void*) +
+      numTreeInodes_ * sizeof(TreeInode) + numFileInodes_ * sizeof(FileInode);
 }
 
 InodeMap::InodeMap(
@@ -121,45 +193,87 @@ InodeMap::~InodeMap() {
   // destroy the EdenMount.
 }
 
+InodeMap::Members& InodeMapLock::get(InodeNumber number) const {
+  auto& shard = shards_[InodeMap::shardIndex(number)];
+  XCHECK(shard) << "InodeMap shard of inode " << number << " is not locked";
+  return *shard;
+}
+
+size_t InodeMapLock::loadedInodeCount() const {
+  size_t count = 0;
+  for (const auto& shard : shards_) {
+    if (shard) {
+      count += shard->loadedInodes_.size();
+    }
+  }
+  return count;
+}
+
+size_t InodeMapLock::unloadedInodeCount() const {
+  size_t count = 0;
+  for (const auto& shard : shards_) {
+    if (shard) {
+      count += shard->unloadedInodes_.size();
+    }
+  }
+  return count;
+}
+
+InodeMapLock InodeMap::lockShard(InodeNumber number) {
+  InodeMapLock lock;
+  lock.shards_[shardIndex(number)] = getShard(number).wlock();
+  return lock;
+}
+
+InodeMapLock InodeMap::lockAllShards() {
+  InodeMapLock lock;
+  for (size_t i = 0; i < kShardCount; ++i) {
+    lock.shards_[i] = shards_[i].members.wlock();
+  }
+  lock.holdsAllShards_ = true;
+  return lock;
+}
+
 inline void InodeMap::insertLoadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const InodeMapLock& lock,
     InodeBase* inode) {
-  auto ret = data->loadedInodes_.emplace(inode->getNodeId(), inode);
+  auto& data = lock.get(inode->getNodeId());
+  auto ret = data.loadedInodes_.emplace(inode->getNodeId(), inode);
   XCHECK(ret.second);
   if (inode->getType() == dtype_t::Dir) {
-    ++data->numTreeInodes_;
+    ++data.numTreeInodes_;
   } else {
-    ++data->numFileInodes_;
+    ++data.numFileInodes_;
   }
 }
 
-void InodeMap::initializeRoot(
-    const folly::Synchronized<Members>::LockedPtr& data,
-    TreeInodePtr root) {
-  XCHECK_EQ(data->loadedInodes_.size(), 0ul)
+void InodeMap::initializeRoot(const InodeMapLock& lock, TreeInodePtr root) {
+  XCHECK(lock.holdsAllShards());
+  XCHECK_EQ(lock.loadedInodeCount(), 0ul)
       << "cannot load InodeMap data over a populated instance";
-  XCHECK_EQ(data->unloadedInodes_.size(), 0ul)
+  XCHECK_EQ(lock.unloadedInodeCount(), 0ul)
       << "cannot load InodeMap data over a populated instance";
 
   XCHECK(!root_);
   root_ = std::move(root);
-  insertLoadedInode(data, root_.get());
-  XDCHECK_EQ(1ul, data->numTreeInodes_);
-  XDCHECK_EQ(0ul, data->numFileInodes_);
+  insertLoadedInode(lock, root_.get());
+  XDCHECK_EQ(1ul, lock.get(root_->getNodeId()).numTreeInodes_);
+  XDCHECK_EQ(0ul, lock.get(root_->getNodeId()).numFileInodes_);
 }
 
 void InodeMap::initialize(TreeInodePtr root) {
-  initializeRoot(data_.wlock(), std::move(root));
+  initializeRoot(lockAllShards(), std::move(root));
 }
 
 template <class... Args>
 void InodeMap::initializeUnloadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const InodeMapLock& lock,
     InodeNumber parentIno,
     InodeNumber ino,
     Args&&... args) {
   auto unloadedEntry = UnloadedInode(parentIno, std::forward<Args>(args)...);
-  auto result = data->unloadedInodes_.emplace(ino, std::move(unloadedEntry));
+  auto result =
+      lock.get(ino).emplaceUnloadedInode(ino, std::move(unloadedEntry));
   if (!result.second) {
     auto message = fmt::format(
         "failed to emplace inode number {}; is it already present in the InodeMap?",
@@ -172,8 +286,8 @@ void InodeMap::initializeUnloadedInode(
 void InodeMap::initializeFromTakeover(
     TreeInodePtr root,
     const SerializedInodeMap& takeover) {
-  auto data = data_.wlock();
-  initializeRoot(data, std::move(root));
+  auto lock = lockAllShards();
+  initializeRoot(lock, std::move(root));
 
   for (const auto& entry : *takeover.unloadedInodes_ref()) {
     if (*entry.numFsReferences_ref() < 0) {
@@ -198,7 +312,7 @@ void InodeMap::initializeFromTakeover(
       }
     }
     initializeUnloadedInode(
-        data,
+        lock,
         InodeNumber::fromThrift(*entry.parentInode_ref()),
         InodeNumber::fromThrift(*entry.inodeNumber_ref()),
         PathComponentPiece{*entry.name_ref()},
@@ -209,7 +323,7 @@ void InodeMap::initializeFromTakeover(
   }
 
   XLOG(DBG2) << "InodeMap initialized mount " << mount_->getPath()
-             << " from takeover, " << data->unloadedInodes_.size()
+             << " from takeover, " << lock.unloadedInodeCount()
              << " inodes registered";
 }
 
@@ -254,8 +368,8 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
   XLOG(DBG2) << "Initializing InodeMap for " << mount_->getPath()
              << ", fast=" << fastInitialization;
 
-  auto data = data_.wlock();
-  initializeRoot(data, std::move(root));
+  auto lock = lockAllShards();
+  initializeRoot(lock, std::move(root));
 
   std::vector<std::tuple<AbsolutePath, InodeNumber>> pending;
   pending.emplace_back(mount_->getPath(), root_->getNodeId());
@@ -292,7 +406,7 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
       }
 
       initializeUnloadedInode(
-          data,
+          lock,
           dirInode,
           ino,
           name,
@@ -304,17 +418,29 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
   }
 
   XLOG(DBG2) << "InodeMap initialized mount " << mount_->getPath()
-             << " from overlay, " << data->unloadedInodes_.size()
+             << " from overlay, " << lock.unloadedInodeCount()
              << " inodes registered";
 }
 
 ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
+  auto& shard = getShard(number);
+
+  // Check to see if this Inode is already loaded. This is by far the most
+  // common case, so check with only a shared lock first.
+  {
+    auto data = shard.rlock();
+    auto loadedIter = data->loadedInodes_.find(number);
+    if (loadedIter != data->loadedInodes_.end()) {
+      return loadedIter->second.getPtr();
+    }
+  }
+
   // Lock the data.
   // We hold it while doing most of our work below, but explicitly unlock it
   // before triggering inode loading or before fulfilling any Promises.
-  auto data = data_.wlock();
+  auto data = shard.wlock();
 
-  // Check to see if this Inode is already loaded
+  // Check again, in case the inode was loaded since we released the lock.
   auto loadedIter = data->loadedInodes_.find(number);
   if (loadedIter != data->loadedInodes_.end()) {
     return loadedIter->second.getPtr();
@@ -341,11 +467,10 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
 
   // Check to see if anyone else has already started loading this inode.
   auto* unloadedData = &unloadedIter->second;
-  bool alreadyLoading = !unloadedData->promises.empty();
+  bool alreadyLoading = unloadedData->isLoading();
 
   // Add a new entry to the promises list.
-  unloadedData->promises.emplace_back();
-  auto result = unloadedData->promises.back().getSemiFuture();
+  auto result = unloadedData->addPromise().getSemiFuture();
 
   // If someone else has already started loading this inode we are done.
   // The current loading attempt will signal our promise when it completes.
@@ -364,25 +489,35 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
   // (It might have been simpler to recursively call lookupInode() to get the
   // parent, but that would require releasing and re-acquiring the lock more
   // than necessary.)
+  //
+  // The parent can live in a different shard, so only one shard is locked at
+  // a time, and the parts of the child entry needed below are copied out
+  // before its lock is released. This is safe since we have already
+  // registered as the loader of the child: whatever happens to the parent in
+  // between, it is either loaded (and we start the child lookup) or we attach
+  // a promise to it under its shard lock, which its loader will fulfill.
   auto childInodeNumber = number;
+  auto parentNumber = unloadedData->getParent();
+  PathComponent childName{unloadedData->getName()};
+  bool isUnlinked = unloadedData->isUnlinked();
+  auto optionalHash = unloadedData->getHash();
+  auto mode = unloadedData->getMode();
+  data.unlock();
+
   while (true) {
+    auto parentData = getShard(parentNumber).wlock();
+
     // Check to see if this parent is loaded
-    loadedIter = data->loadedInodes_.find(unloadedData->parent);
-    if (loadedIter != data->loadedInodes_.end()) {
+    loadedIter = parentData->loadedInodes_.find(parentNumber);
+    if (loadedIter != parentData->loadedInodes_.end()) {
       // We found a loaded parent.
-      // Grab copies of the arguments we need for startChildLookup(),
-      // with the lock still held.
       InodePtr firstLoadedParent = loadedIter->second.getPtr();
-      PathComponent requiredChildName = unloadedData->name;
-      bool isUnlinked = unloadedData->isUnlinked;
-      auto optionalHash = unloadedData->hash;
-      auto mode = unloadedData->mode;
       // Unlock the data before starting the child lookup
-      data.unlock();
+      parentData.unlock();
       // Trigger the lookup, then return to our caller.
       startChildLookup(
           firstLoadedParent,
-          requiredChildName,
+          childName,
           isUnlinked,
           childInodeNumber,
           optionalHash,
@@ -391,33 +526,31 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     }
 
     // Look up the parent in unloadedInodes_
-    unloadedIter = data->unloadedInodes_.find(unloadedData->parent);
-    if (UNLIKELY(unloadedIter == data->unloadedInodes_.end())) {
+    unloadedIter = parentData->unloadedInodes_.find(parentNumber);
+    if (UNLIKELY(unloadedIter == parentData->unloadedInodes_.end())) {
       // This shouldn't happen.  We must know about the parent inode number if
       // we knew about the child.
-      auto bug = EDEN_BUG_EXCEPTION()
-          << "unknown parent inode " << unloadedData->parent << " (of "
-          << unloadedData->name << ")";
+      auto bug = EDEN_BUG_EXCEPTION() << "unknown parent inode " << parentNumber
+                                      << " (of " << childName << ")";
       // Unlock our data before calling inodeLoadFailed()
-      data.unlock();
+      parentData.unlock();
       inodeLoadFailed(childInodeNumber, bug);
       return result;
     }
 
-    auto* parentData = &unloadedIter->second;
-    alreadyLoading = !parentData->promises.empty();
+    auto* parentEntry = &unloadedIter->second;
+    alreadyLoading = parentEntry->isLoading();
 
     // Add a new entry to the promises list.
     // It should kick off loading of the current child inode when
     // it is fulfilled.
-    parentData->promises.emplace_back();
     setupParentLookupPromise(
-        parentData->promises.back(),
-        unloadedData->name,
-        unloadedData->isUnlinked,
+        parentEntry->addPromise(),
+        childName,
+        isUnlinked,
         childInodeNumber,
-        unloadedData->hash,
-        unloadedData->mode);
+        optionalHash,
+        mode);
 
     if (alreadyLoading) {
       // This parent is already being loaded.
@@ -426,8 +559,12 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     }
 
     // Continue around the loop to look up our parent's parent
-    childInodeNumber = unloadedData->parent;
-    unloadedData = parentData;
+    childInodeNumber = parentNumber;
+    parentNumber = parentEntry->getParent();
+    childName = PathComponent{parentEntry->getName()};
+    isUnlinked = parentEntry->isUnlinked();
+    optionalHash = parentEntry->getHash();
+    mode = parentEntry->getMode();
   }
 }
 
@@ -490,18 +627,19 @@ InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
 
   PromiseVector promises;
   try {
-    auto data = data_.wlock();
-    auto it = data->unloadedInodes_.find(number);
-    XCHECK(it != data->unloadedInodes_.end())
+    auto lock = lockShard(number);
+    auto& data = lock.get(number);
+    auto it = data.unloadedInodes_.find(number);
+    XCHECK(it != data.unloadedInodes_.end())
         << "failed to find unloaded inode data when finishing load of inode "
         << number << ": " << inode->getLogPath();
-    swap(promises, it->second.promises);
+    promises = it->second.extractPromises();
 
     inode->setChannelRefcount(it->second.numFsReferences);
 
     // Insert the entry into loadedInodes_, and remove it from unloadedInodes_
-    insertLoadedInode(data, inode);
-    data->unloadedInodes_.erase(it);
+    insertLoadedInode(lock, inode);
+    data.eraseUnloadedInode(it);
     return promises;
   } catch (const std::exception& ex) {
     XLOG(ERR) << "error marking inode " << number
@@ -528,12 +666,12 @@ void InodeMap::inodeLoadFailed(
 InodeMap::PromiseVector InodeMap::extractPendingPromises(InodeNumber number) {
   PromiseVector promises;
   {
-    auto data = data_.wlock();
+    auto data = getShard(number).wlock();
     auto it = data->unloadedInodes_.find(number);
     XCHECK(it != data->unloadedInodes_.end())
         << "failed to find unloaded inode data when finishing load of inode "
         << number;
-    swap(promises, it->second.promises);
+    promises = it->second.extractPromises();
   }
   return promises;
 }
@@ -549,7 +687,7 @@ ImmediateFuture<FileInodePtr> InodeMap::lookupFileInode(InodeNumber number) {
 }
 
 InodePtr InodeMap::lookupLoadedInode(InodeNumber number) {
-  auto data = data_.rlock();
+  auto data = getShard(number).rlock();
   auto it = data->loadedInodes_.find(number);
   if (it == data->loadedInodes_.end()) {
     return nullptr;
@@ -574,62 +712,99 @@ FileInodePtr InodeMap::lookupLoadedFile(InodeNumber number) {
 }
 
 std::optional<RelativePath> InodeMap::getPathForInode(InodeNumber inodeNumber) {
-  auto data = data_.rlock();
-  return getPathForInodeHelper(inodeNumber, data);
+  return getPathForInodeHelper(inodeNumber);
 }
 
 std::optional<RelativePath> InodeMap::getPathForInodeHelper(
-    InodeNumber inodeNumber,
-    const folly::Synchronized<Members>::RLockedPtr& data) {
-  auto loadedIt = data->loadedInodes_.find(inodeNumber);
-  if (loadedIt != data->loadedInodes_.cend()) {
-    // If the inode is loaded, return its RelativePath
-    return loadedIt->second->getPath();
-  } else {
+    InodeNumber inodeNumber) {
+  InodeNumber parent;
+  std::optional<PathComponent> name;
+  {
+    auto data = getShard(inodeNumber).rlock();
+    auto loadedIt = data->loadedInodes_.find(inodeNumber);
+    if (loadedIt != data->loadedInodes_.cend()) {
+      // If the inode is loaded, return its RelativePath
+      return loadedIt->second->getPath();
+    }
     auto unloadedIt = data->unloadedInodes_.find(inodeNumber);
-    if (unloadedIt != data->unloadedInodes_.cend()) {
-      if (unloadedIt->second.isUnlinked) {
-        return std::nullopt;
-      }
-      // If the inode is not loaded, return its parent's path as long as it's
-      // parent isn't the root
-      auto parent = unloadedIt->second.parent;
-      if (parent == kRootNodeId) {
-        // The parent is the Eden mount root, just return its name (base case)
-        return RelativePath(unloadedIt->second.name);
-      }
-      auto dir = getPathForInodeHelper(parent, data);
-      if (!dir) {
-        EDEN_BUG() << "unlinked parent inode " << parent
-                   << "appears to contain non-unlinked child " << inodeNumber;
-      }
-      return *dir + unloadedIt->second.name;
-    } else {
+    if (unloadedIt == data->unloadedInodes_.cend()) {
       throwSystemErrorExplicit(EINVAL, "unknown inode number ", inodeNumber);
     }
+    if (unloadedIt->second.isUnlinked()) {
+      return std::nullopt;
+    }
+    parent = unloadedIt->second.getParent();
+    name = PathComponent{unloadedIt->second.getName()};
   }
+
+  // If the inode is not loaded, return its parent's path as long as it's
+  // parent isn't the root
+  if (parent == kRootNodeId) {
+    // The parent is the Eden mount root, just return its name (base case)
+    return RelativePath(*name);
+  }
+  auto dir = getPathForInodeHelper(parent);
+  if (!dir) {
+    EDEN_BUG() << "unlinked parent inode " << parent
+               << "appears to contain non-unlinked child " << inodeNumber;
+  }
+  return *dir + *name;
 }
+
 void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
   InodePtr inodePtr;
   {
-    auto data = data_.wlock();
-    inodePtr = decFsRefcountHelper(data, number, count);
+    auto lock = lockShard(number);
+    inodePtr = decFsRefcountHelper(lock, number, count);
   }
   // Now release our lock before decrementing the inode's FS reference
   // count and immediately releasing our pointer reference.
   if (inodePtr) {
-    inodePtr->decFsRefcount();
+    inodePtr->decFsRefcount(count);
+  }
+}
+
+void InodeMap::decFsRefcounts(
+    std::vector<std::pair<InodeNumber, uint32_t>> counts) {
+  std::sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {
+    return shardIndex(a.first) < shardIndex(b.first);
+  });
+
+  std::vector<std::pair<InodePtr, uint32_t>> loaded;
+  auto it = counts.begin();
+  while (it != counts.end()) {
+    auto lock = lockShard(it->first);
+    auto shard = shardIndex(it->first);
+    for (; it != counts.end() && shardIndex(it->first) == shard; ++it) {
+      if (auto inodePtr = decFsRefcountHelper(lock, it->first, it->second)) {
+        loaded.emplace_back(std::move(inodePtr), it->second);
+      }
+    }
+  }
+  if (loaded.empty()) {
+    return;
+  }
+
+  // As in decFsRefcount(), the loaded inodes' FS reference counts are
+  // decremented without the lock held. Dropping the last pointer reference to
+  // them may then unload them, which is left to the server thread pool so
+  // that the FUSE thread can get back to serving requests.
+  for (auto& [inodePtr, count] : loaded) {
+    inodePtr->decFsRefcount(count);
   }
+  mount_->getServerThreadPool()->add(
+      [loaded = std::move(loaded)]() mutable { loaded.clear(); });
 }
 
 InodePtr InodeMap::decFsRefcountHelper(
-    folly::Synchronized<Members>::LockedPtr& data,
+    const InodeMapLock& lock,
     InodeNumber number,
     uint32_t count,
     bool clearRefCount) {
   if (folly::kIsWindows) {
     XDCHECK_EQ(count, 1u);
   }
+  auto* data = &lock.get(number);
 
   // First check in the loaded inode map
   auto loadedIter = data->loadedInodes_.find(number);
@@ -662,8 +837,9 @@ InodePtr InodeMap::decFsRefcountHelper(
   if (unloadedEntry.numFsReferences == 0) {
     // We can completely forget about this unloaded inode now.
     XLOG(DBG5) << "forgetting unloaded inode " << number << ": "
-               << unloadedEntry.parent << ":" << unloadedEntry.name;
-    data->unloadedInodes_.erase(unloadedIter);
+               << unloadedEntry.getParent() << ":"
+               << unloadedEntry.getName();
+    data->eraseUnloadedInode(unloadedIter);
   }
   return nullptr;
 }
@@ -697,23 +873,25 @@ void InodeMap::forgetStaleInodes() {
   std::vector<InodeNumber> unloadedInodesToClearFSRef;
 
   {
-    auto data = data_.wlock();
-
-    for (auto& inode : data->unloadedInodes_) {
-      XLOG(DBG9) << "Considering forgetting unloaded inode " << inode.first;
-      if (inode.second.isUnlinked) {
-        // We can't directly call decFsRefcountHelper here because it will
-        // invalidate the iterator we are using for this for loop.
-        unloadedInodesToClearFSRef.push_back(inode.first);
-      } else {
-        XLOG(DBG9) << "Not forgetting unloaded inode " << inode.first
-                   << " because inode is still linked";
+    auto lock = lockAllShards();
+
+    for (const auto& data : lock.shards_) {
+      for (auto& inode : data->unloadedInodes_) {
+        XLOG(DBG9) << "Considering forgetting unloaded inode " << inode.first;
+        if (inode.second.isUnlinked()) {
+          // We can't directly call decFsRefcountHelper here because it will
+          // invalidate the iterator we are using for this for loop.
+          unloadedInodesToClearFSRef.push_back(inode.first);
+        } else {
+          XLOG(DBG9) << "Not forgetting unloaded inode " << inode.first
+                     << " because inode is still linked";
+        }
       }
     }
 
     for (auto& inodeNumber : unloadedInodesToClearFSRef) {
       auto inodePtr = decFsRefcountHelper(
-          data,
+          lock,
           inodeNumber,
           /*count=*/0, // Doesn't matter what we set this to because we are
                        // going to clear the ref count.
@@ -726,41 +904,44 @@ void InodeMap::forgetStaleInodes() {
     // we do this second because dereferencing a loaded inode will cause it to
     // be unloaded. Thus this will create lots of unloaded inodes. we don't want
     // to double decRef them, so we decref loaded inodes after unloaded ones.
-    for (auto& inode : data->loadedInodes_) {
-      XLOG(DBG9) << "Considering forgetting loaded inode " << inode.first;
-      auto inodePtr = decFsRefcountHelper(
-          data,
-          inode.first,
-          /*count=*/0, // Doesn't matter what we set this to because we are
-                       // going to clear the ref count.
-          /*clearRefCount=*/true);
-      if (inodePtr) {
-        auto unlinked = inodePtr->isUnlinked();
-        if (unlinked &&
-            inode.second->getMetadata().timestamps.atime < cutoff_ts) {
-          XLOG(DBG9) << "Will forget loaded inode " << inode.first;
-          toClearFSRef.push_back(inodePtr);
-        } else {
-          // even though we are not going to do anything with these inodes we
-          // need to keep them around until we let go of the lock. It is not
-          // safe to drop an inodePtr while holding the lock.
-          if (!unlinked) {
-            XLOG(DBG9) << "Not forgetting loaded inode " << inode.first
-                       << " because it is still linked";
+    for (const auto& data : lock.shards_) {
+      for (auto& inode : data->loadedInodes_) {
+        XLOG(DBG9) << "Considering forgetting loaded inode " << inode.first;
+        auto inodePtr = decFsRefcountHelper(
+            lock,
+            inode.first,
+            /*count=*/0, // Doesn't matter what we set this to because we are
+                         // going to clear the ref count.
+            /*clearRefCount=*/true);
+        if (inodePtr) {
+          auto unlinked = inodePtr->isUnlinked();
+          if (unlinked &&
+              inode.second->getMetadata().timestamps.atime < cutoff_ts) {
+            XLOG(DBG9) << "Will forget loaded inode " << inode.first;
+            toClearFSRef.push_back(inodePtr);
           } else {
-            XLOG(DBG9) << "Not forgetting loaded inode " << inode.first
-                       << " because it was referenced."
-                       << durationStr(
-                              config_->getEdenConfig()
-                                  ->postCheckoutDelayToUnloadInodes.getValue() -
-                              std::chrono::nanoseconds{
-                                  inode.second->getMetadata()
-                                      .timestamps.atime.toTimespec()
-                                      .tv_nsec -
-                                  cutoff_ts.tv_nsec})
-                       << " ago";
+            // even though we are not going to do anything with these inodes we
+            // need to keep them around until we let go of the lock. It is not
+            // safe to drop an inodePtr while holding the lock.
+            if (!unlinked) {
+              XLOG(DBG9) << "Not forgetting loaded inode " << inode.first
+                         << " because it is still linked";
+            } else {
+              XLOG(DBG9) << "Not forgetting loaded inode " << inode.first
+                         << " because it was referenced."
+                         << durationStr(
+                                config_->getEdenConfig()
+                                    ->postCheckoutDelayToUnloadInodes
+                                    .getValue() -
+                                std::chrono::nanoseconds{
+                                    inode.second->getMetadata()
+                                        .timestamps.atime.toTimespec()
+                                        .tv_nsec -
+                                    cutoff_ts.tv_nsec})
+                         << " ago";
+            }
+            justToHoldBeyondScopeOfLock.push_back(inodePtr);
           }
-          justToHoldBeyondScopeOfLock.push_back(inodePtr);
         }
       }
     }
@@ -777,9 +958,9 @@ void InodeMap::forgetStaleInodes() {
 }
 
 void InodeMap::setUnmounted() {
-  auto data = data_.wlock();
-  XDCHECK(!data->isUnmounted_);
-  data->isUnmounted_ = true;
+  auto lock = lockAllShards();
+  XDCHECK(!isUnmounted_);
+  isUnmounted_ = true;
 }
 
 Future<SerializedInodeMap> InodeMap::shutdown(
@@ -787,16 +968,17 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   // Record that we are in the process of shutting down.
   auto future = Future<folly::Unit>::makeEmpty();
   {
-    auto data = data_.wlock();
-    XCHECK(!data->shutdownPromise.has_value())
+    auto lock = lockAllShards();
+    XCHECK(!shutdownPromise_.has_value())
         << "shutdown() invoked more than once on InodeMap for "
         << mount_->getPath();
-    data->shutdownPromise.emplace(Promise<Unit>{});
-    future = data->shutdownPromise->getFuture();
+    shutdownPromise_.emplace(Promise<Unit>{});
+    isShuttingDown_.store(true, std::memory_order_release);
+    future = shutdownPromise_->getFuture();
 
     XLOG(DBG3) << "starting InodeMap::shutdown: loadedCount="
-               << data->loadedInodes_.size()
-               << " unloadedCount=" << data->unloadedInodes_.size();
+               << lock.loadedInodeCount()
+               << " unloadedCount=" << lock.unloadedInodeCount();
   }
 
   // If an error occurs during mount point initialization, shutdown() can be
@@ -809,13 +991,14 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   // Walk from the root of the tree down, finding all unreferenced inodes,
   // and immediately destroy them.
   //
-  // Hold the the mountpoint-wide rename lock in shared mode while doing the
-  // walk.  We want to make sure that we walk *all* children.  While doing the
-  // walk we want to make sure that an Inode that hasn't been processed yet
-  // cannot be moved from the unprocessed part of the tree into a processed
-  // part of the tree.
+  // Hold the the mountpoint-wide rename lock while doing the walk.  We want
+  // to make sure that we walk *all* children.  While doing the walk we want
+  // to make sure that an Inode that hasn't been processed yet cannot be
+  // moved from the unprocessed part of the tree into a processed part of the
+  // tree.  This needs the lock exclusively, since files can be renamed while
+  // it is held shared.
   {
-    auto renameLock = mount_->acquireSharedRenameLock();
+    auto renameLock = mount_->acquireRenameLock();
     root_->unloadChildrenNow();
   }
 
@@ -833,19 +1016,21 @@ Future<SerializedInodeMap> InodeMap::shutdown(
     // to them, then let the normal pointer release process be responsible for
     // unloading them.
     std::vector<InodePtr> inodesToUnload;
-    auto data = data_.wlock();
-    for (const auto& entry : data->loadedInodes_) {
-      if (!entry.second->isPtrAcquireCountZero()) {
-        continue;
-      }
-      if (!entry.second->isUnlinked()) {
-        continue;
+    auto lock = lockAllShards();
+    for (const auto& data : lock.shards_) {
+      for (const auto& entry : data->loadedInodes_) {
+        if (!entry.second->isPtrAcquireCountZero()) {
+          continue;
+        }
+        if (!entry.second->isUnlinked()) {
+          continue;
+        }
+        inodesToUnload.push_back(entry.second.getPtr());
       }
-      inodesToUnload.push_back(entry.second.getPtr());
     }
     // Release the lock, then release all of our InodePtrs to unload
     // the inodes.
-    data.unlock();
+    lock.unlock();
     inodesToUnload.clear();
   }
 
@@ -872,39 +1057,42 @@ Future<SerializedInodeMap> InodeMap::shutdown(
       return SerializedInodeMap{};
     }
 
-    auto data = data_.wlock();
+    auto lock = lockAllShards();
+    auto loadedCount = lock.loadedInodeCount();
+    auto unloadedCount = lock.unloadedInodeCount();
     XLOG(DBG3)
         << "InodeMap::shutdown after releasing inodesToClear: loadedCount="
-        << data->loadedInodes_.size()
-        << " unloadedCount=" << data->unloadedInodes_.size();
+        << loadedCount << " unloadedCount=" << unloadedCount;
 
-    if (data->loadedInodes_.size() != 1) {
-      EDEN_BUG() << "After InodeMap::shutdown() finished, "
-                 << data->loadedInodes_.size()
+    if (loadedCount != 1) {
+      EDEN_BUG() << "After InodeMap::shutdown() finished, " << loadedCount
                  << " inodes still loaded; they must all (except the root) "
                  << "have been unloaded for this to succeed!";
     }
 
     SerializedInodeMap result;
-    result.unloadedInodes_ref()->reserve(data->unloadedInodes_.size());
-    for (const auto& [inodeNumber, entry] : data->unloadedInodes_) {
-      SerializedInodeMapEntry serializedEntry;
-
-      XLOG(DBG5) << "  serializing unloaded inode " << inodeNumber
-                 << " parent=" << entry.parent.get() << " name=" << entry.name;
-
-      serializedEntry.inodeNumber_ref() = inodeNumber.get();
-      serializedEntry.parentInode_ref() = entry.parent.get();
-      serializedEntry.name_ref() = entry.name.stringPiece().str();
-      serializedEntry.isUnlinked_ref() = entry.isUnlinked;
-      serializedEntry.numFsReferences_ref() = entry.numFsReferences;
-      if (entry.hash.has_value()) {
-        serializedEntry.hash_ref() = entry.hash.value().asString();
-      }
-      // If entry.hash is empty, the inode is not materialized.
-      serializedEntry.mode_ref() = entry.mode;
+    result.unloadedInodes_ref()->reserve(unloadedCount);
+    for (const auto& data : lock.shards_) {
+      for (const auto& [inodeNumber, entry] : data->unloadedInodes_) {
+        SerializedInodeMapEntry serializedEntry;
+
+        XLOG(DBG5) << "  serializing unloaded inode " << inodeNumber
+                   << " parent=" << entry.getParent().get()
+                   << " name=" << entry.getName();
+
+        serializedEntry.inodeNumber_ref() = inodeNumber.get();
+        serializedEntry.parentInode_ref() = entry.getParent().get();
+        serializedEntry.name_ref() = entry.getName().stringPiece().str();
+        serializedEntry.isUnlinked_ref() = entry.isUnlinked();
+        serializedEntry.numFsReferences_ref() = entry.numFsReferences;
+        if (auto hash = entry.getHash()) {
+          serializedEntry.hash_ref() = hash->asString();
+        }
+        // If the hash is empty, the inode is not materialized.
+        serializedEntry.mode_ref() = entry.getMode();
 
-      result.unloadedInodes_ref()->emplace_back(std::move(serializedEntry));
+        result.unloadedInodes_ref()->emplace_back(std::move(serializedEntry));
+      }
     }
 
     return result;
@@ -912,8 +1100,7 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   });
 }
 
-void InodeMap::shutdownComplete(
-    folly::Synchronized<Members>::LockedPtr&& data) {
+void InodeMap::shutdownComplete(InodeMapLock&& lock) {
   // We manually dropped our reference count to the root inode in
   // beginShutdown().  Destroy it now, and call resetNoDecRef() on our pointer
   // to make sure it doesn't try to decrement the reference count again when
@@ -921,16 +1108,16 @@ void InodeMap::shutdownComplete(
   delete root_.get();
   root_.resetNoDecRef();
 
-  // Unlock data_ before fulfilling the shutdown promise, just in case the
-  // promise invokes a callback that calls some of our other methods that
-  // may need to acquire this lock.
-  auto* shutdownPromise = &data->shutdownPromise.value();
-  data.unlock();
+  // Unlock the shards before fulfilling the shutdown promise, just in case
+  // the promise invokes a callback that calls some of our other methods that
+  // may need to acquire these locks.
+  auto* shutdownPromise = &shutdownPromise_.value();
+  lock.unlock();
   shutdownPromise->setValue();
 }
 
 bool InodeMap::isInodeRemembered(InodeNumber ino) const {
-  return data_.rlock()->unloadedInodes_.count(ino) > 0;
+  return getShard(ino).rlock()->unloadedInodes_.count(ino) > 0;
 }
 
 void InodeMap::onInodeUnreferenced(
@@ -939,7 +1126,19 @@ void InodeMap::onInodeUnreferenced(
   XLOG(DBG8) << "inode " << inode->getNodeId()
              << " unreferenced: " << inode->getLogPath();
   // Acquire our lock.
-  auto data = data_.wlock();
+  //
+  // Outside of shutdown we only ever unload unlinked inodes with no FS
+  // references, which only requires this inode's shard. During shutdown,
+  // unloading may need to look at the inode's children, and completing
+  // shutdown needs every shard, so lock them all then.
+  auto lock = isShuttingDown_.load(std::memory_order_acquire)
+      ? lockAllShards()
+      : lockShard(inode->getNodeId());
+  if (!lock.holdsAllShards() && shutdownPromise_.has_value()) {
+    // Shutdown started after we checked.
+    lock.unlock();
+    lock = lockAllShards();
+  }
 
   // Decrement the Inode's acquire count
   auto acquireCount = inode->decPtrAcquireCount();
@@ -951,13 +1150,13 @@ void InodeMap::onInodeUnreferenced(
 
   // Decide if we should unload the inode now, or wait until later.
   bool unloadNow = false;
-  bool shuttingDown = data->shutdownPromise.has_value();
+  bool shuttingDown = shutdownPromise_.has_value();
   XDCHECK(shuttingDown || inode != root_.get());
   if (shuttingDown) {
     // Check to see if this was the root inode that got unloaded.
     // This indicates that the shutdown is complete.
     if (inode == root_.get()) {
-      shutdownComplete(std::move(data));
+      shutdownComplete(std::move(lock));
       return;
     }
 
@@ -981,7 +1180,7 @@ void InodeMap::onInodeUnreferenced(
         parentInfo.getParent().get(),
         parentInfo.getName(),
         parentInfo.isUnlinked(),
-        data);
+        lock);
     if (!parentInfo.isUnlinked()) {
       const auto& parentContents = parentInfo.getParentContents();
       auto it = parentContents->entries.find(parentInfo.getName());
@@ -995,7 +1194,7 @@ void InodeMap::onInodeUnreferenced(
   // Deleting it may cause its parent TreeInode to become unreferenced, causing
   // another recursive call to onInodeUnreferenced(), which will need to
   // reacquire the lock.
-  data.unlock();
+  lock.unlock();
   parentInfo.reset();
   if (unloadNow) {
     delete inode;
@@ -1003,16 +1202,11 @@ void InodeMap::onInodeUnreferenced(
 }
 
 InodeMapLock InodeMap::lockForUnload() {
-  return InodeMapLock{data_.wlock()};
+  return lockAllShards();
 }
 
-void InodeMap::unloadInode(
-    InodeBase* inode,
-    TreeInode* parent,
-    PathComponentPiece name,
-    bool isUnlinked,
-    const InodeMapLock& lock) {
-  return unloadInode(inode, parent, name, isUnlinked, lock.data_);
+InodeMapLock InodeMap::lockForUnload(InodeNumber number) {
+  return lockShard(number);
 }
 
 void InodeMap::unloadInode(
@@ -1020,27 +1214,28 @@ void InodeMap::unloadInode(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const InodeMapLock& lock) {
   // Call updateOverlayForUnload() to update the overlay and compute
   // if we need to remember an UnloadedInode entry.
   auto unloadedEntry =
-      updateOverlayForUnload(inode, parent, name, isUnlinked, data);
+      updateOverlayForUnload(inode, parent, name, isUnlinked, lock);
+  auto& data = lock.get(inode->getNodeId());
   if (unloadedEntry) {
     // Insert the unloaded entry
     XLOG(DBG7) << "inserting unloaded map entry for inode "
                << inode->getNodeId();
-    auto ret = data->unloadedInodes_.emplace(
+    auto ret = data.emplaceUnloadedInode(
         inode->getNodeId(), std::move(unloadedEntry.value()));
     XCHECK(ret.second);
   }
 
-  auto numErased = data->loadedInodes_.erase(inode->getNodeId());
+  auto numErased = data.loadedInodes_.erase(inode->getNodeId());
   XCHECK_EQ(numErased, 1u) << "inconsistent loaded inodes data: "
                            << inode->getLogPath();
   if (inode->getType() == dtype_t::Dir) {
-    --data->numTreeInodes_;
+    --data.numTreeInodes_;
   } else {
-    --data->numFileInodes_;
+    --data.numFileInodes_;
   }
 }
 
@@ -1049,9 +1244,9 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const InodeMapLock& lock) {
   auto fsCount = inode->getFsRefcount();
-  if (isUnlinked && (data->isUnmounted_ || fsCount == 0)) {
+  if (isUnlinked && (isUnmounted_ || fsCount == 0)) {
     try {
       mount_->getOverlay()->removeOverlayData(inode->getNodeId());
     } catch (const std::exception& ex) {
@@ -1074,7 +1269,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
   // refcounts on inodes that still existed before it was unmounted.
   // Everything is unreferenced by FS after an unmount operation, and we no
   // longer need to remember anything in the unloadedInodes_ map.
-  if (data->isUnmounted_) {
+  if (isUnmounted_) {
     XLOG(DBG5) << "forgetting unreferenced inode " << inode->getNodeId()
                << " after unmount: " << inode->getLogPath();
     return std::nullopt;
@@ -1107,11 +1302,14 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     }
 
     // If any of this inode's childrens are in unloadedInodes_, then this
-    // inode, as its parent, must not be forgotten.
+    // inode, as its parent, must not be forgotten. The children live in other
+    // shards, which is why unloading a linked inode requires all of them to
+    // be locked.
     for (const auto& pair : treeContents.entries) {
       const auto& childName = pair.first;
       const auto& entry = pair.second;
-      if (data->unloadedInodes_.count(entry.getInodeNumber())) {
+      auto childNumber = entry.getInodeNumber();
+      if (lock.get(childNumber).unloadedInodes_.count(childNumber)) {
         XLOG(DBG5) << "remembering inode " << asTree->getNodeId() << " ("
                    << asTree->getLogPath() << ") because its child "
                    << childName << " was remembered";
@@ -1141,24 +1339,24 @@ bool InodeMap::shouldLoadChild(
     PathComponentPiece name,
     InodeNumber childInode,
     folly::Promise<InodePtr> promise) {
-  auto data = data_.wlock();
+  auto data = getShard(childInode).wlock();
   UnloadedInode* unloadedData{nullptr};
   auto iter = data->unloadedInodes_.find(childInode);
   if (iter == data->unloadedInodes_.end()) {
     InodeNumber parentNumber = parent->getNodeId();
     auto newUnloadedData = UnloadedInode(parentNumber, name);
     auto ret =
-        data->unloadedInodes_.emplace(childInode, std::move(newUnloadedData));
+        data->emplaceUnloadedInode(childInode, std::move(newUnloadedData));
     XDCHECK(ret.second);
     unloadedData = &ret.first->second;
   } else {
     unloadedData = &iter->second;
   }
 
-  bool isFirstPromise = unloadedData->promises.empty();
+  bool isFirstPromise = !unloadedData->isLoading();
 
   // Add the promise to the existing list for this inode.
-  unloadedData->promises.push_back(std::move(promise));
+  unloadedData->addPromise() = std::move(promise);
 
   // If this is the very first promise then tell the caller they need
   // to start the load operation.  Otherwise someone else (whoever added the
@@ -1169,8 +1367,7 @@ bool InodeMap::shouldLoadChild(
 void InodeMap::inodeCreated(const InodePtr& inode) {
   XLOG(DBG4) << "created new inode " << inode->getNodeId() << ": "
              << inode->getLogPath();
-  auto data = data_.wlock();
-  insertLoadedInode(data, inode.get());
+  insertLoadedInode(lockShard(inode->getNodeId()), inode.get());
 }
 
 void InodeMap::recordPeriodicInodeUnload(size_t numInodesToUnload) {
@@ -1180,12 +1377,17 @@ void InodeMap::recordPeriodicInodeUnload(size_t numInodesToUnload) {
 
 InodeMap::InodeCounts InodeMap::getInodeCounts() const {
   InodeCounts counts;
-  auto data = data_.rlock();
-  XDCHECK_EQ(
-      data->numTreeInodes_ + data->numFileInodes_, data->loadedInodes_.size());
-  counts.treeCount = data->numTreeInodes_;
-  counts.fileCount = data->numFileInodes_;
-  counts.unloadedInodeCount = data->unloadedInodes_.size();
+  for (const auto& shard : shards_) {
+    auto data = shard.members.rlock();
+    XDCHECK_EQ(
+        data->numTreeInodes_ + data->numFileInodes_,
+        data->loadedInodes_.size());
+    counts.treeCount += data->numTreeInodes_;
+    counts.fileCount += data->numFileInodes_;
+    counts.unloadedInodeCount += data->unloadedInodes_.size();
+    counts.loadedInodeMemory += data->getLoadedInodeMemory();
+    counts.unloadedInodeMemory += data->getUnloadedInodeMemory();
+  }
   counts.periodicUnlinkedUnloadInodeCount =
       numPeriodicallyUnloadedUnlinkedInodes_.load(std::memory_order_relaxed);
   counts.periodicLinkedUnloadInodeCount =
@@ -1195,8 +1397,8 @@ InodeMap::InodeCounts InodeMap::getInodeCounts() const {
 
 std::vector<InodeNumber> InodeMap::getReferencedInodes() const {
   std::vector<InodeNumber> inodes;
-  {
-    auto data = data_.rlock();
+  for (const auto& shard : shards_) {
+    auto data = shard.members.rlock();
 
     for (auto& kv : data->loadedInodes_) {
       auto& loadedInode = kv.second;
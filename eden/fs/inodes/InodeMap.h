@@ -9,6 +9,9 @@
 
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <atomic>
 #include <list>
 #include <memory>
 #include <optional>
@@ -93,6 +96,13 @@ class InodeMapLock;
  *
  *   We currently always allocate a InodeNumber value for any new Inode object
  *   even if it is not needed yet by the FUSE APIs.
+ *
+ * Both maps are split into shards by InodeNumber, each with its own lock, so
+ * that FS worker threads operating on unrelated inodes do not contend with
+ * each other. All state for a given inode number lives in one shard, so moving
+ * an inode between the loaded and unloaded maps only needs that shard's lock.
+ * Looking up an inode that is already loaded only takes its shard's lock in
+ * shared mode.
  */
 class InodeMap {
  public:
@@ -239,6 +249,16 @@ class InodeMap {
    */
   void decFsRefcount(InodeNumber number, uint32_t count = 1);
 
+  /**
+   * Decrement the FS reference counts of many inode numbers at once, as the
+   * kernel does when it drops its dentry cache under memory pressure.
+   *
+   * Each shard is locked once for all of its inodes, and the inodes that this
+   * may unload are released together on the server thread pool rather than
+   * in the calling thread.
+   */
+  void decFsRefcounts(std::vector<std::pair<InodeNumber, uint32_t>> counts);
+
   /**
    * See EdenMount::forgetStaleInodes
    */
@@ -294,10 +314,21 @@ class InodeMap {
    * unloading.  It should only be called *after* acquring the TreeInode
    * contents lock.
    *
+   * This locks every shard, since unloading a tree needs to check whether any
+   * of its children are remembered in the unloaded map.
+   *
    * This is an internal API that should not be used by most callers.
    */
   InodeMapLock lockForUnload();
 
+  /**
+   * Like lockForUnload(), but only locks the shard holding `number`.
+   *
+   * This is only sufficient to unload an unlinked inode with no outstanding
+   * FS references, which is forgotten without looking at any other inode.
+   */
+  InodeMapLock lockForUnload(InodeNumber number);
+
   /**
    * unloadedInode() should be called to unload an unreferenced inode.
    *
@@ -386,6 +417,13 @@ class InodeMap {
     size_t fileCount = 0;
     size_t treeCount = 0;
     size_t unloadedInodeCount = 0;
+    /**
+     * Estimated bytes used by the loaded inode objects. The children of a
+     * TreeInode are not counted.
+     */
+    size_t loadedInodeMemory = 0;
+    /** Estimated bytes used to remember the unloaded inodes. */
+    size_t unloadedInodeMemory = 0;
     size_t periodicUnlinkedUnloadInodeCount = 0;
     size_t periodicLinkedUnloadInodeCount = 0;
   };
@@ -408,21 +446,27 @@ class InodeMap {
 
   /**
    * Data about an unloaded inode.
+   *
+   * Large mounts can remember tens of millions of unloaded inodes, so this is
+   * kept compact: the name and the hash share a single heap allocation, and
+   * the list of waiting promises is only allocated while the inode is being
+   * loaded.
    */
-  struct UnloadedInode {
+  class UnloadedInode {
+   public:
     UnloadedInode(InodeNumber parentNum, PathComponentPiece entryName);
     UnloadedInode(
         InodeNumber parentNum,
         PathComponentPiece entryName,
         bool isUnlinked,
         mode_t mode,
-        std::optional<ObjectId> hash,
+        const std::optional<ObjectId>& hash,
         uint32_t fsRefcount);
     UnloadedInode(
         TreeInode* parent,
         PathComponentPiece entryName,
         bool isUnlinked,
-        std::optional<ObjectId> hash,
+        const std::optional<ObjectId>& hash,
         uint32_t fsRefcount);
     UnloadedInode(
         FileInode* inode,
@@ -431,37 +475,69 @@ class InodeMap {
         bool isUnlinked,
         uint32_t fsRefcount);
 
-    InodeNumber const parent;
-    PathComponent const name;
+    UnloadedInode(UnloadedInode&&) = default;
+    UnloadedInode& operator=(UnloadedInode&&) = default;
+
+    InodeNumber getParent() const {
+      return parent_;
+    }
+
+    PathComponentPiece getName() const {
+      return PathComponentPiece{
+          folly::StringPiece{data_.get(), nameSize_}, SkipPathSanityCheck{}};
+    }
 
     /**
-     * A boolean indicating if this inode is unlinked.
+     * Whether this inode is unlinked.
      */
-    bool const isUnlinked{false};
+    bool isUnlinked() const {
+      return isUnlinked_;
+    }
 
     /** The complete st_mode value for this entry */
-    mode_t const mode{0};
+    mode_t getMode() const {
+      return mode_;
+    }
 
     /**
-     * If the entry is not materialized, this contains the hash
-     * identifying the source control Tree (if this is a directory) or Blob
-     * (if this is a file) that contains the entry contents.
+     * If the entry is not materialized, this returns the hash identifying the
+     * source control Tree (if this is a directory) or Blob (if this is a
+     * file) that contains the entry contents.
      *
-     * If the entry is materialized, this field is not set.
+     * If the entry is materialized, this returns std::nullopt.
      */
-    std::optional<ObjectId> const hash;
+    std::optional<ObjectId> getHash() const;
 
     /**
-     * A list of promises waiting on this inode to be loaded.
-     *
-     * If this list is non-empty then the inode is currently in the process of
-     * being loaded.
+     * Whether any promises are waiting on this inode to be loaded, which
+     * means it is currently in the process of being loaded.
+     */
+    bool isLoading() const {
+      return promises_ && !promises_->empty();
+    }
+
+    /**
+     * Add a promise to be fulfilled once this inode is loaded.
      *
      * (We could use folly::SharedPromise here instead, but it has extra
-     * overhead that we don't really need.  It performs its own locking, but we
-     * are already protected by the data_ lock.)
+     * overhead that we don't really need.  It performs its own locking, but
+     * we are already protected by the shard lock.)
      */
-    PromiseVector promises;
+    folly::Promise<InodePtr>& addPromise();
+
+    /**
+     * Remove and return all the promises waiting on this inode.
+     */
+    PromiseVector extractPromises();
+
+    /**
+     * The number of bytes allocated on the heap for this entry while it is
+     * not being loaded.
+     */
+    size_t getHeapSize() const {
+      return nameSize_ + hashSize_;
+    }
+
     /**
      * The number of times we have returned this inode number to FUSE via
      * lookup() calls that have not yet been released with a corresponding
@@ -469,6 +545,25 @@ class InodeMap {
      * placeholder for that inode that hasn't been invalided.
      */
     uint32_t numFsReferences{0};
+
+   private:
+    UnloadedInode(
+        InodeNumber parentNum,
+        PathComponentPiece entryName,
+        bool isUnlinked,
+        mode_t mode,
+        const ObjectId* hash,
+        uint32_t fsRefcount);
+
+    InodeNumber parent_;
+    /** The entry name, immediately followed by the hash bytes, if any. */
+    std::unique_ptr<char[]> data_;
+    std::unique_ptr<PromiseVector> promises_;
+    mode_t mode_{0};
+    uint32_t nameSize_{0};
+    uint16_t hashSize_{0};
+    bool hasHash_{false};
+    bool isUnlinked_{false};
   };
 
   struct LoadedInode {
@@ -485,7 +580,9 @@ class InodeMap {
 
     InodePtr getPtr() const {
       // Calling InodePtr::newPtrLocked is safe because interacting with
-      // LoadedInode implies the data_ lock is held.
+      // LoadedInode implies the lock on its shard is held. A shared lock is
+      // enough: the ptr acquire count is only decremented while holding the
+      // shard lock exclusively.
       return InodePtr::newPtrLocked(inode_);
     }
 
@@ -504,6 +601,14 @@ class InodeMap {
     InodeBase* inode_{nullptr};
   };
 
+  /**
+   * The number of shards the inode maps are split into.
+   */
+  static constexpr size_t kShardCount = 32;
+
+  /**
+   * The data in one shard of the InodeMap.
+   */
   struct Members {
     /**
      * The map of loaded inodes
@@ -515,18 +620,47 @@ class InodeMap {
      */
     std::unordered_map<InodeNumber, LoadedInode> loadedInodes_;
 
+    using UnloadedInodeMap = std::unordered_map<InodeNumber, UnloadedInode>;
+
     /**
      * The map of currently unloaded inodes
+     *
+     * Entries should be added and removed with emplaceUnloadedInode() and
+     * eraseUnloadedInode() so that unloadedInodeHeapBytes_ stays accurate.
      */
-    std::unordered_map<InodeNumber, UnloadedInode> unloadedInodes_;
+    UnloadedInodeMap unloadedInodes_;
 
     /**
-     * Indicates if the FS mount point has been unmounted.
-     *
-     * If this is true then the FS refcount on all inodes should be treated
-     * as 0, and we can forget all inodes while shutting down.
+     * The sum of UnloadedInode::getHeapSize() over unloadedInodes_.
      */
-    bool isUnmounted_{false};
+    size_t unloadedInodeHeapBytes_{0};
+
+    std::pair<UnloadedInodeMap::iterator, bool> emplaceUnloadedInode(
+        InodeNumber number,
+        UnloadedInode&& entry) {
+      auto heapSize = entry.getHeapSize();
+      auto result = unloadedInodes_.emplace(number, std::move(entry));
+      if (result.second) {
+        unloadedInodeHeapBytes_ += heapSize;
+      }
+      return result;
+    }
+
+    void eraseUnloadedInode(UnloadedInodeMap::iterator it) {
+      unloadedInodeHeapBytes_ -= it->second.getHeapSize();
+      unloadedInodes_.erase(it);
+    }
+
+    /**
+     * An estimate of the memory used by unloadedInodes_, including the hash
+     * table itself.
+     */
+    size_t getUnloadedInodeMemory() const;
+
+    /**
+     * Estimated bytes used by loadedInodes_ and the inodes it points to.
+     */
+    size_t getLoadedInodeMemory() const;
 
     /**
      * The number of loaded TreeInode objects
@@ -541,25 +675,44 @@ class InodeMap {
      * hold true to make sure our calculations are correct.
      */
     size_t numFileInodes_{0};
+  };
 
-    /**
-     * A promise to fulfill once shutdown() completes.
-     *
-     * This is only initialized when shutdown() is called, and will be
-     * std::nullopt until we are shutting down.
-     *
-     * In the future we could update this to just use an empty promise to
-     * indicate that we are not shutting down yet.  However, currently
-     * folly::Promise does not have a simple API to check if it is empty or not,
-     * so we have to wrap it in a std::optional.
-     */
-    std::optional<folly::Promise<folly::Unit>> shutdownPromise;
+  /**
+   * Each shard is padded to its own cache line(s) so that threads working on
+   * different shards do not false-share the locks.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    folly::Synchronized<Members> members;
   };
 
   InodeMap(InodeMap const&) = delete;
   InodeMap& operator=(InodeMap const&) = delete;
 
-  void shutdownComplete(folly::Synchronized<Members>::LockedPtr&& data);
+  static size_t shardIndex(InodeNumber number) {
+    // Inode numbers are allocated sequentially, so the low bits alone spread
+    // them evenly.
+    return number.get() % kShardCount;
+  }
+
+  folly::Synchronized<Members>& getShard(InodeNumber number) {
+    return shards_[shardIndex(number)].members;
+  }
+  const folly::Synchronized<Members>& getShard(InodeNumber number) const {
+    return shards_[shardIndex(number)].members;
+  }
+
+  /**
+   * Exclusively lock the shard holding `number`.
+   */
+  InodeMapLock lockShard(InodeNumber number);
+
+  /**
+   * Exclusively lock every shard. Shards are always locked in index order
+   * so that this can not deadlock against itself.
+   */
+  InodeMapLock lockAllShards();
+
+  void shutdownComplete(InodeMapLock&& lock);
 
   void setupParentLookupPromise(
       folly::Promise<InodePtr>& promise,
@@ -580,30 +733,16 @@ class InodeMap {
    * Extract the list of promises waiting on the specified inode number to be
    * loaded.
    *
-   * This method acquires the data_ lock internally.
+   * This method acquires the shard lock internally.
    * It should never be called while already holding the lock.
    */
   PromiseVector extractPendingPromises(InodeNumber number);
 
-  std::optional<RelativePath> getPathForInodeHelper(
-      InodeNumber inodeNumber,
-      const folly::Synchronized<Members>::RLockedPtr& data);
-
   /**
-   * Unload an inode
-   *
-   * This simply removes it from the loadedInodes_ map and, if it is still
-   * referenced by the FS, adds it to the unloadedInodes_ map.
-   *
-   * The caller is responsible for actually deleting the Inode object after
-   * releasing the InodeMap lock.
+   * Locks the shard of each inode on the way to the root in turn, holding
+   * at most one shard lock at a time.
    */
-  void unloadInode(
-      InodeBase* inode,
-      TreeInode* parent,
-      PathComponentPiece name,
-      bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+  std::optional<RelativePath> getPathForInodeHelper(InodeNumber inodeNumber);
 
   /**
    * Update the overlay data for an inode before unloading it.
@@ -617,18 +756,14 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const InodeMapLock& lock);
 
-  void insertLoadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
-      InodeBase* inode);
+  void insertLoadedInode(const InodeMapLock& lock, InodeBase* inode);
 
   /**
    * Verify the InodeMap precondition and initialize the root_ member.
    */
-  void initializeRoot(
-      const folly::Synchronized<Members>::LockedPtr& data,
-      TreeInodePtr root);
+  void initializeRoot(const InodeMapLock& lock, TreeInodePtr root);
 
   /**
    * Construct an UnloadedInode and insert it onto the unloadedInodes_ map.
@@ -641,7 +776,7 @@ class InodeMap {
    */
   template <class... Args>
   void initializeUnloadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const InodeMapLock& lock,
       InodeNumber parentIno,
       InodeNumber ino,
       Args&&... args);
@@ -654,7 +789,7 @@ class InodeMap {
    * WARNING: The returned inodePtr must be destroyed OUTSIDE of the data lock!
    */
   InodePtr decFsRefcountHelper(
-      folly::Synchronized<Members>::LockedPtr& data,
+      const InodeMapLock& lock,
       InodeNumber number,
       uint32_t count = 0,
       bool clearRefCount = false);
@@ -675,16 +810,48 @@ class InodeMap {
   TreeInodePtr root_;
 
   /**
-   * The locked data.
+   * The locked data, split into shards by inode number.
+   *
+   * Note: be very careful to hold these locks only when necessary.  No other
+   * locks should be acquired when holding one of them, except for other
+   * shards through lockAllShards().  In particular this means that we should
+   * never access any InodeBase objects while holding a shard lock, since we
+   * should not hold our lock while an InodeBase acquires its own internal
+   * lock.  (This makes it safe for InodeBase to perform operations on the
+   * InodeMap while holding their own lock.)
+   */
+  std::array<Shard, kShardCount> shards_;
+
+  /**
+   * Indicates if the FS mount point has been unmounted.
+   *
+   * If this is true then the FS refcount on all inodes should be treated
+   * as 0, and we can forget all inodes while shutting down.
+   *
+   * This and shutdownPromise_ are only modified while holding every shard
+   * lock, so holding any one shard lock is enough to read them.
+   */
+  bool isUnmounted_{false};
+
+  /**
+   * A promise to fulfill once shutdown() completes.
+   *
+   * This is only initialized when shutdown() is called, and will be
+   * std::nullopt until we are shutting down.
    *
-   * Note: be very careful to hold this lock only when necessary.  No other
-   * locks should be acquired when holding this lock.  In particular this means
-   * that we should never access any InodeBase objects while holding the lock,
-   * since we should not hold our lock while an InodeBase acquires its own
-   * internal lock.  (This makes it safe for InodeBase to perform operations on
-   * the InodeMap while holding their own lock.)
+   * In the future we could update this to just use an empty promise to
+   * indicate that we are not shutting down yet.  However, currently
+   * folly::Promise does not have a simple API to check if it is empty or not,
+   * so we have to wrap it in a std::optional.
    */
-  folly::Synchronized<Members> data_;
+  std::optional<folly::Promise<folly::Unit>> shutdownPromise_;
+
+  /**
+   * Set once shutdownPromise_ is initialized. Unlike shutdownPromise_ this
+   * may be checked without holding any lock, to decide up front whether an
+   * operation needs every shard.
+   */
+  std::atomic<bool> isShuttingDown_{false};
 
   /**
    * This boolean controls EdenFS's response to receiving a request for an
@@ -719,21 +886,46 @@ class InodeMap {
  * in order to make multiple calls to unloadInode() without releasing and
  * re-acquiring the lock.
  *
+ * It holds the exclusive locks of either one shard or all of them.
+ *
  * This mostly exists to make forward declarations simpler.
  */
 class InodeMapLock {
  public:
-  explicit InodeMapLock(
-      folly::Synchronized<InodeMap::Members>::LockedPtr&& data)
-      : data_(std::move(data)) {}
+  InodeMapLock(InodeMapLock&&) = default;
+  InodeMapLock& operator=(InodeMapLock&&) = default;
 
   void unlock() {
-    data_.unlock();
+    for (auto& shard : shards_) {
+      if (shard) {
+        shard.unlock();
+      }
+    }
+    holdsAllShards_ = false;
   }
 
  private:
   friend class InodeMap;
-  folly::Synchronized<InodeMap::Members>::LockedPtr data_;
+  using LockedPtr = folly::Synchronized<InodeMap::Members>::LockedPtr;
+
+  InodeMapLock() = default;
+
+  /**
+   * Get the locked shard holding `number`. That shard must be held.
+   */
+  InodeMap::Members& get(InodeNumber number) const;
+
+  bool holdsAllShards() const {
+    return holdsAllShards_;
+  }
+
+  /// Number of loaded inodes in the held shards.
+  size_t loadedInodeCount() const;
+  /// Number of unloaded inodes in the held shards.
+  size_t unloadedInodeCount() const;
+
+  std::array<LockedPtr, InodeMap::kShardCount> shards_;
+  bool holdsAllShards_{false};
 };
 } // namespace eden
 } // namespace facebook
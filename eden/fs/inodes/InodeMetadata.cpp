@@ -55,6 +55,9 @@ bool InodeMetadata::shouldShortCircuitMetadataUpdate(
   if (desired.mtime.has_value() && !(desired.mtime == timestamps.mtime)) {
     return false;
   }
+  if (desired.ctime.has_value() && !(desired.ctime == timestamps.ctime)) {
+    return false;
+  }
 
   return true;
 }
@@ -29,6 +29,9 @@ struct DesiredMetadata {
   std::optional<gid_t> gid;
   std::optional<timespec> atime;
   std::optional<timespec> mtime;
+  // Only set by FUSE mounts using the writeback cache, where the kernel
+  // maintains ctime. Otherwise ctime is set to the time of the change.
+  std::optional<timespec> ctime;
 };
 
 /**
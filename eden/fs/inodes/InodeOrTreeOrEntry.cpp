@@ -25,6 +25,13 @@ InodePtr InodeOrTreeOrEntry::asInodePtr() const {
   return std::get<InodePtr>(variant_);
 }
 
+TreePtr InodeOrTreeOrEntry::asTreePtrOrNull() const {
+  if (auto* tree = std::get_if<TreePtr>(&variant_)) {
+    return *tree;
+  }
+  return nullptr;
+}
+
 // Helper template for std::visit calls below
 template <class>
 inline constexpr bool always_false_v = false;
@@ -50,6 +57,27 @@ dtype_t InodeOrTreeOrEntry::getDtype() const {
       variant_);
 }
 
+std::optional<ObjectId> InodeOrTreeOrEntry::getSourceBlobId() const {
+  if (getDtype() != dtype_t::Regular) {
+    return std::nullopt;
+  }
+  return std::visit(
+      [](auto&& arg) -> std::optional<ObjectId> {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (
+            std::is_same_v<T, UnmaterializedUnloadedBlobDirEntry> ||
+            std::is_same_v<T, TreeEntry>) {
+          return arg.getHash();
+        } else if constexpr (std::is_same_v<T, InodePtr>) {
+          auto file = arg.asFilePtrOrNull();
+          return file ? file->getBlobHash() : std::nullopt;
+        } else {
+          return std::nullopt;
+        }
+      },
+      variant_);
+}
+
 ImmediateFuture<Hash20> InodeOrTreeOrEntry::getSHA1(
     RelativePathPiece path,
     ObjectStore* objectStore,
@@ -102,7 +130,8 @@ ImmediateFuture<Hash20> InodeOrTreeOrEntry::getSHA1(
 ImmediateFuture<BlobMetadata> InodeOrTreeOrEntry::getBlobMetadata(
     RelativePathPiece path,
     ObjectStore* objectStore,
-    ObjectFetchContext& fetchContext) const {
+    ObjectFetchContext& fetchContext,
+    bool includeBlake3) const {
   // Ensure this is a regular file.
   // We intentionally want to refuse to compute the SHA1 of symlinks
   switch (getDtype()) {
@@ -122,14 +151,18 @@ ImmediateFuture<BlobMetadata> InodeOrTreeOrEntry::getBlobMetadata(
   // need for a Tree case, as Trees are always directories. It's included to
   // check that the visitor here is exhaustive.
   return std::visit(
-      [path, objectStore, &fetchContext](
+      [path, objectStore, &fetchContext, includeBlake3](
           auto&& arg) -> ImmediateFuture<BlobMetadata> {
         using T = std::decay_t<decltype(arg)>;
         if constexpr (std::is_same_v<T, InodePtr>) {
-          return arg.asFilePtr()->getBlobMetadata(fetchContext);
+          return arg.asFilePtr()->getBlobMetadata(fetchContext, includeBlake3);
         } else if constexpr (
             std::is_same_v<T, UnmaterializedUnloadedBlobDirEntry> ||
             std::is_same_v<T, TreeEntry>) {
+          if (includeBlake3) {
+            return objectStore->getBlobMetadataWithBlake3(
+                arg.getHash(), fetchContext);
+          }
           return objectStore->getBlobMetadata(arg.getHash(), fetchContext);
         } else if constexpr (std::is_same_v<T, TreePtr>) {
           return makeImmediateFuture<BlobMetadata>(PathError(EISDIR, path));
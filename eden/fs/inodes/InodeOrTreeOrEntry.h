@@ -8,6 +8,7 @@
 #pragma once
 
 #include <sys/stat.h>
+#include <optional>
 #include <variant>
 
 #include <folly/String.h>
@@ -54,12 +55,25 @@ class InodeOrTreeOrEntry {
    */
   InodePtr asInodePtr() const;
 
+  /**
+   * Returns the contained source control Tree, or nullptr if there is not
+   * one.
+   */
+  detail::TreePtr asTreePtrOrNull() const;
+
   dtype_t getDtype() const;
 
   bool isDirectory() const {
     return getDtype() == dtype_t::Dir;
   }
 
+  /**
+   * Returns the id of the blob of a regular file that isn't materialized,
+   * whose metadata getBlobMetadata() would read from the ObjectStore, whether
+   * or not it is loaded as an inode. Returns std::nullopt otherwise.
+   */
+  std::optional<ObjectId> getSourceBlobId() const;
+
   /**
    * Get the InodeOrTreeOrEntry object for a child of this directory.
    *
@@ -78,10 +92,18 @@ class InodeOrTreeOrEntry {
       ObjectStore* objectStore,
       ObjectFetchContext& fetchContext) const;
 
+  /**
+   * Returns the metadata of a regular file. Its BLAKE3 hash is only filled in
+   * if `includeBlake3` is set.
+   *
+   * The metadata of a materialized file is computed with a single read of its
+   * overlay file.
+   */
   ImmediateFuture<BlobMetadata> getBlobMetadata(
       RelativePathPiece path,
       ObjectStore* objectStore,
-      ObjectFetchContext& fetchContext) const;
+      ObjectFetchContext& fetchContext,
+      bool includeBlake3 = false) const;
 
   /**
    * Emulate stat in a way that works for source control.
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include "eden/fs/inodes/InodeMetadata.h"
 #include "eden/fs/inodes/InodeNumber.h"
@@ -185,7 +186,7 @@ class InodeTable {
       auto index = iter->second;
       XCHECK_LT(index, state.storage.size());
       fn(state.storage[index].record);
-      // TODO: maybe trigger a background msync
+      dirty_.store(true, std::memory_order_relaxed);
       return state.storage[index].record;
     });
   }
@@ -219,9 +220,24 @@ class InodeTable {
       }
 
       storage.pop_back();
+      dirty_.store(true, std::memory_order_relaxed);
     });
   }
 
+  /**
+   * If records were modified since the last call, starts writing them back to
+   * disk without waiting for the writes to complete.
+   *
+   * Called periodically so the kernel writes back dirty pages in small,
+   * regular batches instead of all at once at an unpredictable time.
+   */
+  void flushAsync() {
+    if (!dirty_.exchange(false, std::memory_order_relaxed)) {
+      return;
+    }
+    state_.withRLock([](const auto& state) { state.storage.flushAsync(); });
+  }
+
   /**
    * Iterate over all entries of the table and call fn with the inode
    * and record
@@ -237,6 +253,7 @@ class InodeTable {
       auto& record = state->storage[index].record;
       fn(inode, record);
     }
+    dirty_.store(true, std::memory_order_relaxed);
   }
 
  private:
@@ -275,6 +292,7 @@ class InodeTable {
       auto iter = state->indices.find(ino);
       if (LIKELY(iter != state->indices.end())) {
         auto index = iter->second;
+        dirty_.store(true, std::memory_order_relaxed);
         return modify(state->storage[index].record);
       }
     }
@@ -286,6 +304,7 @@ class InodeTable {
     auto state = state_.wlock();
     // Check again - something may have raced between the locks.
     auto iter = state->indices.find(ino);
+    dirty_.store(true, std::memory_order_relaxed);
     if (UNLIKELY(iter != state->indices.end())) {
       auto index = iter->second;
       return modify(state->storage[index].record);
@@ -299,6 +318,8 @@ class InodeTable {
 
   struct State {
     State(MappedDiskVector<Entry>&& mdv) : storage{std::move(mdv)} {
+      // Records are looked up by inode number, in no particular order.
+      storage.advise(MappedDiskVectorAccess::Random, /*useHugePages=*/true);
       for (size_t i = 0; i < storage.size(); ++i) {
         const Entry& entry = storage[i];
         if (entry.inode.empty()) {
@@ -331,6 +352,9 @@ class InodeTable {
   };
 
   folly::Synchronized<State> state_;
+
+  /// Whether records were modified since the last flushAsync().
+  std::atomic<bool> dirty_{false};
 }; // namespace eden
 
 static_assert(
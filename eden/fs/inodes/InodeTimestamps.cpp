@@ -133,8 +133,13 @@ void InodeTimestamps::setattrTimes(
 
   // we do not allow users to set ctime using setattr. ctime should be changed
   // when ever setattr is called, as this function is called in setattr, update
-  // ctime to now.
-  ctime = now;
+  // ctime to now. The exception is the kernel reporting the ctime it
+  // maintains with FUSE_WRITEBACK_CACHE.
+  if (attr.ctime.has_value()) {
+    ctime = attr.ctime.value();
+  } else {
+    ctime = now;
+  }
 }
 
 void InodeTimestamps::applyToStat(struct stat& st) const {
@@ -16,13 +16,17 @@
 #include "eden/fs/inodes/InodeMap.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/nfs/NfsUtils.h"
+#include "eden/fs/store/ObjectStore.h"
 
 namespace facebook::eden {
 
 NfsDispatcherImpl::NfsDispatcherImpl(EdenMount* mount)
     : NfsDispatcher(mount->getStats(), mount->getClock()),
       mount_(mount),
-      inodeMap_(mount_->getInodeMap()) {}
+      inodeMap_(mount_->getInodeMap()),
+      readdirSnapshots_(
+          mount->getEdenConfig()->nfsReaddirSnapshotCacheSize.getValue(),
+          mount->getEdenConfig()->nfsReaddirSnapshotTtl.getValue()) {}
 
 ImmediateFuture<struct stat> NfsDispatcherImpl::getattr(
     InodeNumber ino,
@@ -118,6 +122,16 @@ ImmediateFuture<NfsDispatcher::WriteRes> NfsDispatcherImpl::write(
       });
 }
 
+ImmediateFuture<folly::Unit> NfsDispatcherImpl::fsync(
+    InodeNumber ino,
+    bool datasync,
+    ObjectFetchContext& /*context*/) {
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [datasync](const FileInodePtr& inode) {
+        return inode->fsync(datasync);
+      });
+}
+
 ImmediateFuture<NfsDispatcher::CreateRes> NfsDispatcherImpl::create(
     InodeNumber dir,
     PathComponent name,
@@ -125,6 +139,9 @@ ImmediateFuture<NfsDispatcher::CreateRes> NfsDispatcherImpl::create(
     ObjectFetchContext& context) {
   // Make sure that we're attempting to create a file.
   mode = S_IFREG | (0777 & mode);
+  // Listings of the directory that are in progress carry on from a new
+  // snapshot, which has the change.
+  readdirSnapshots_.invalidate(dir);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), mode](const TreeInodePtr& inode) {
         // TODO(xavierd): Modify mknod to obtain the pre and post stat of the
@@ -149,6 +166,7 @@ ImmediateFuture<NfsDispatcher::MkdirRes> NfsDispatcherImpl::mkdir(
     PathComponent name,
     mode_t mode,
     ObjectFetchContext& context) {
+  readdirSnapshots_.invalidate(dir);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), mode](const TreeInodePtr& inode) {
         // TODO(xavierd): Modify mkdir to obtain the pre and post stat of the
@@ -169,6 +187,7 @@ ImmediateFuture<NfsDispatcher::SymlinkRes> NfsDispatcherImpl::symlink(
     PathComponent name,
     std::string data,
     ObjectFetchContext& context) {
+  readdirSnapshots_.invalidate(dir);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), data = std::move(data)](
           const TreeInodePtr& inode) {
@@ -194,6 +213,7 @@ ImmediateFuture<NfsDispatcher::MknodRes> NfsDispatcherImpl::mknod(
     mode_t mode,
     dev_t rdev,
     ObjectFetchContext& context) {
+  readdirSnapshots_.invalidate(dir);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), mode, rdev](
           const TreeInodePtr& inode) {
@@ -217,6 +237,7 @@ ImmediateFuture<NfsDispatcher::UnlinkRes> NfsDispatcherImpl::unlink(
     InodeNumber dir,
     PathComponent name,
     ObjectFetchContext& context) {
+  readdirSnapshots_.invalidate(dir);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name)](const TreeInodePtr& inode) {
         return inode->unlink(name, InvalidationRequired::No, context)
@@ -232,6 +253,7 @@ ImmediateFuture<NfsDispatcher::RmdirRes> NfsDispatcherImpl::rmdir(
     InodeNumber dir,
     PathComponent name,
     ObjectFetchContext& context) {
+  readdirSnapshots_.invalidate(dir);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name)](const TreeInodePtr& inode) {
         return inode->rmdir(name, InvalidationRequired::No, context)
@@ -249,6 +271,8 @@ ImmediateFuture<NfsDispatcher::RenameRes> NfsDispatcherImpl::rename(
     InodeNumber toIno,
     PathComponent toName,
     ObjectFetchContext& context) {
+  readdirSnapshots_.invalidate(fromIno);
+  readdirSnapshots_.invalidate(toIno);
   auto fromDir = inodeMap_->lookupTreeInode(fromIno);
   return inodeMap_->lookupTreeInode(toIno)
       .thenValue([fromDir = std::move(fromDir),
@@ -276,55 +300,134 @@ ImmediateFuture<NfsDispatcher::RenameRes> NfsDispatcherImpl::rename(
       });
 }
 
+NfsDispatcher::ReaddirRes NfsDispatcherImpl::readdirFromSnapshot(
+    const TreeInodePtr& inode,
+    NfsDirList&& list,
+    off_t offset,
+    uint64_t cookieverf,
+    ObjectFetchContext& context) {
+  auto dir = inode->getNodeId();
+  std::shared_ptr<const ReaddirSnapshot> snapshot;
+  if (offset != 0) {
+    snapshot = readdirSnapshots_.get(dir, cookieverf);
+  }
+  if (!snapshot) {
+    // Offsets are derived from inode numbers, so listings whose snapshot was
+    // dropped can carry on from a new one.
+    snapshot = inode->takeReaddirSnapshot();
+    cookieverf = readdirSnapshots_.insert(dir, snapshot);
+  }
+  auto [dirList, isEof] =
+      inode->nfsReaddir(std::move(list), offset, *snapshot, context);
+  if (isEof) {
+    readdirSnapshots_.erase(cookieverf);
+  }
+  return ReaddirRes{std::move(dirList), isEof, cookieverf};
+}
+
 ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdir(
     InodeNumber dir,
     off_t offset,
+    uint64_t cookieverf,
     uint32_t count,
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(dir).thenValue(
-      [&context, offset, count](const TreeInodePtr& inode) {
-        auto [dirList, isEof] = inode->nfsReaddir(
-            NfsDirList{count, nfsv3Procs::readdir}, offset, context);
-        return ReaddirRes{std::move(dirList), isEof};
+      [this, &context, offset, cookieverf, count](const TreeInodePtr& inode) {
+        return readdirFromSnapshot(
+            inode,
+            NfsDirList{count, nfsv3Procs::readdir},
+            offset,
+            cookieverf,
+            context);
       });
 }
 
 ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
     InodeNumber dir,
     off_t offset,
+    uint64_t cookieverf,
     uint32_t count,
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(dir).thenValue(
-      [&context, offset, count, this](const TreeInodePtr& inode) {
-        auto [dirList, isEof] = inode->nfsReaddir(
-            NfsDirList{count, nfsv3Procs::readdirplus}, offset, context);
-        auto& dirListRef = dirList.getListRef();
-        std::vector<ImmediateFuture<folly::Unit>> futuresVec{};
-        for (auto& entry : dirListRef) {
-          if (entry.name == "." || entry.name == "..") {
-            futuresVec.push_back(
-                this->getattr(InodeNumber{entry.fileid}, context)
-                    .thenTry([&entry](folly::Try<struct stat> st) {
-                      entry.name_attributes = statToPostOpAttr(st);
-                      return folly::unit;
-                    }));
-          } else {
-            futuresVec.push_back(
-                inode->getOrLoadChild(PathComponent{entry.name}, context)
-                    .thenValue([entry, &context](InodePtr&& inodep) {
-                      return inodep->stat(context);
-                    })
-                    .thenTry([&entry](folly::Try<struct stat> st) {
-                      entry.name_attributes = statToPostOpAttr(st);
-                      return folly::unit;
-                    }));
+      [&context, offset, cookieverf, count, this](const TreeInodePtr& inode) {
+        auto [dirList, isEof, newCookieverf] = readdirFromSnapshot(
+            inode,
+            NfsDirList{count, nfsv3Procs::readdirplus},
+            offset,
+            cookieverf,
+            context);
+
+        // Stat'ing an unloaded file looks up the size of its blob. Look up
+        // those of all the listed files with a single LocalStore read first,
+        // rather than one read per entry. The ones missing from the LocalStore
+        // are then fetched concurrently below, letting the backing store batch
+        // them.
+        std::vector<ObjectId> blobs;
+        {
+          auto contents = inode->getContents().rlock();
+          for (const auto& entry : dirList.getListRef()) {
+            if (entry.name == "." || entry.name == "..") {
+              continue;
+            }
+            auto it = contents->entries.find(PathComponentPiece{entry.name});
+            if (it == contents->entries.end()) {
+              continue;
+            }
+            const auto& dirEntry = it->second;
+            if (!dirEntry.getInode() && !dirEntry.isMaterialized() &&
+                !dirEntry.isDirectory()) {
+              blobs.push_back(dirEntry.getHash());
+            }
           }
         }
-        auto res = collectAllSafe(std::move(futuresVec));
-        return std::move(res).thenValue(
-            [dirList = std::move(dirList),
-             isEof = isEof](std::vector<folly::Unit>&&) mutable {
-              return ReaddirRes{std::move(dirList), isEof};
+        auto metadataFuture = blobs.empty()
+            ? ImmediateFuture<folly::Unit>{folly::unit}
+            : mount_->getObjectStore()
+                  ->prefetchBlobMetadata(std::move(blobs))
+                  .thenTry([](folly::Try<folly::Unit>&&) {
+                    // Entries look up their metadata themselves on failure.
+                  });
+
+        return std::move(metadataFuture)
+            .thenValue([this,
+                        inode,
+                        &context,
+                        dirList = std::move(dirList),
+                        isEof = isEof,
+                        cookieverf = newCookieverf](folly::Unit) mutable {
+              auto& dirListRef = dirList.getListRef();
+              std::vector<ImmediateFuture<folly::Unit>> futuresVec{};
+              for (auto& entry : dirListRef) {
+                if (entry.name == "." || entry.name == "..") {
+                  futuresVec.push_back(
+                      this->getattr(InodeNumber{entry.fileid}, context)
+                          .thenTry([&entry](folly::Try<struct stat> st) {
+                            entry.name_attributes = statToPostOpAttr(st);
+                            return folly::unit;
+                          }));
+                } else {
+                  futuresVec.push_back(
+                      inode->getOrLoadChild(PathComponent{entry.name}, context)
+                          .thenValue([&context](InodePtr&& inodep) {
+                            // The reply carries a file handle for the entry,
+                            // which the kernel may use without a LOOKUP. Count
+                            // it like one so that the inode stays resolvable
+                            // by number after it is unloaded.
+                            inodep->incFsRefcount();
+                            return inodep->stat(context);
+                          })
+                          .thenTry([&entry](folly::Try<struct stat> st) {
+                            entry.name_attributes = statToPostOpAttr(st);
+                            return folly::unit;
+                          }));
+                }
+              }
+              auto res = collectAllSafe(std::move(futuresVec));
+              return std::move(res).thenValue(
+                  [dirList = std::move(dirList), isEof, cookieverf](
+                      std::vector<folly::Unit>&&) mutable {
+                    return ReaddirRes{std::move(dirList), isEof, cookieverf};
+                  });
             });
       });
 }
@@ -9,6 +9,8 @@
 
 #ifndef _WIN32
 
+#include "eden/fs/inodes/InodePtrFwd.h"
+#include "eden/fs/inodes/ReaddirSnapshotCache.h"
 #include "eden/fs/nfs/NfsDispatcher.h"
 
 namespace facebook::eden {
@@ -53,6 +55,11 @@ class NfsDispatcherImpl : public NfsDispatcher {
       off_t offset,
       ObjectFetchContext& context) override;
 
+  ImmediateFuture<folly::Unit> fsync(
+      InodeNumber ino,
+      bool datasync,
+      ObjectFetchContext& context) override;
+
   ImmediateFuture<NfsDispatcher::CreateRes> create(
       InodeNumber ino,
       PathComponent name,
@@ -98,12 +105,14 @@ class NfsDispatcherImpl : public NfsDispatcher {
   ImmediateFuture<NfsDispatcher::ReaddirRes> readdir(
       InodeNumber dir,
       off_t offset,
+      uint64_t cookieverf,
       uint32_t count,
       ObjectFetchContext& context) override;
 
   ImmediateFuture<NfsDispatcher::ReaddirRes> readdirplus(
       InodeNumber dir,
       off_t offset,
+      uint64_t cookieverf,
       uint32_t count,
       ObjectFetchContext& context) override;
 
@@ -112,9 +121,23 @@ class NfsDispatcherImpl : public NfsDispatcher {
       ObjectFetchContext& context) override;
 
  private:
+  /**
+   * List the entries of `inode` after `offset`, from the snapshot that
+   * `cookieverf` was handed out for if it is still cached.
+   */
+  ReaddirRes readdirFromSnapshot(
+      const TreeInodePtr& inode,
+      NfsDirList&& list,
+      off_t offset,
+      uint64_t cookieverf,
+      ObjectFetchContext& context);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
   InodeMap* const inodeMap_;
+
+  // Snapshots of the directories that listings are in progress for.
+  ReaddirSnapshotCache readdirSnapshots_;
 };
 } // namespace facebook::eden
 
@@ -14,14 +14,17 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/ScopeGuard.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
+#include <gflags/gflags.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/inodes/treeoverlay/BufferedTreeOverlay.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
 #include "eden/fs/sqlite/SqliteDatabase.h"
 #include "eden/fs/utils/Bug.h"
@@ -30,8 +33,15 @@
 #ifndef _WIN32
 #include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/OverlayFile.h"
+#include "eden/fs/model/Blob.h"
 #endif // !_WIN32
 
+DEFINE_uint32(
+    overlayFsckThreads,
+    0,
+    "Number of threads scanning the overlay for errors after an unclean "
+    "shutdown. 0 uses one thread per CPU");
+
 namespace facebook {
 namespace eden {
 
@@ -39,9 +49,29 @@ namespace {
 constexpr uint64_t ioCountMask = 0x7FFFFFFFFFFFFFFFull;
 constexpr uint64_t ioClosedMask = 1ull << 63;
 
+/**
+ * How many inode numbers a thread reserves at a time.
+ */
+constexpr uint64_t kInodeNumberBlockSize = 1024;
+
+/**
+ * How many directories a GC thread takes from the queue at a time.
+ */
+constexpr size_t kGCChunkSize = 64;
+
+/**
+ * How many removals the GC threads commit together in the tree overlay. A
+ * crash before the commit leaks no more than one before the GC got to them.
+ */
+constexpr size_t kGCCommitInterval = 1024;
+
 std::unique_ptr<IOverlay> makeOverlay(
     AbsolutePathPiece localDir,
-    Overlay::OverlayType overlayType) {
+    Overlay::OverlayType overlayType,
+    uint64_t blobFileCacheSize,
+    size_t bufferMaxBytes,
+    std::chrono::milliseconds bufferMaxAge,
+    uint64_t dedupStoreSize) {
   if (overlayType == Overlay::OverlayType::Tree) {
     return std::make_unique<TreeOverlay>(localDir);
   } else if (overlayType == Overlay::OverlayType::TreeInMemory) {
@@ -51,15 +81,25 @@ std::unique_ptr<IOverlay> makeOverlay(
   } else if (overlayType == Overlay::OverlayType::TreeSynchronousOff) {
     return std::make_unique<TreeOverlay>(
         localDir, TreeOverlayStore::SynchronousMode::Off);
+  } else if (overlayType == Overlay::OverlayType::TreeBuffered) {
+    return std::make_unique<BufferedTreeOverlay>(
+        localDir, bufferMaxBytes, bufferMaxAge);
   }
 #ifdef _WIN32
-  if (overlayType == Overlay::OverlayType::Legacy) {
+  if (overlayType == Overlay::OverlayType::Legacy ||
+      overlayType == Overlay::OverlayType::LegacyPacked) {
     throw std::runtime_error(
         "Legacy overlay type is not supported. Please reclone.");
   }
+  (void)blobFileCacheSize;
+  (void)dedupStoreSize;
   return std::make_unique<TreeOverlay>(localDir);
 #else
-  return std::make_unique<FsOverlay>(localDir);
+  return std::make_unique<FsOverlay>(
+      localDir,
+      blobFileCacheSize,
+      overlayType == Overlay::OverlayType::LegacyPacked,
+      dedupStoreSize);
 #endif
 }
 } // namespace
@@ -71,28 +111,73 @@ std::shared_ptr<Overlay> Overlay::create(
     AbsolutePathPiece localDir,
     CaseSensitivity caseSensitive,
     OverlayType overlayType,
-    std::shared_ptr<StructuredLogger> logger) {
+    std::shared_ptr<StructuredLogger> logger,
+    uint64_t blobFileCacheSize,
+    size_t bufferMaxBytes,
+    std::chrono::milliseconds bufferMaxAge,
+    size_t gcThreads,
+    uint64_t gcMaxOpsPerSecond,
+    uint64_t dedupStoreSize) {
   // This allows us to access the private constructor.
   struct MakeSharedEnabler : public Overlay {
     explicit MakeSharedEnabler(
         AbsolutePathPiece localDir,
         CaseSensitivity caseSensitive,
         OverlayType overlayType,
-        std::shared_ptr<StructuredLogger> logger)
-        : Overlay(localDir, caseSensitive, overlayType, logger) {}
+        std::shared_ptr<StructuredLogger> logger,
+        uint64_t blobFileCacheSize,
+        size_t bufferMaxBytes,
+        std::chrono::milliseconds bufferMaxAge,
+        size_t gcThreads,
+        uint64_t gcMaxOpsPerSecond,
+        uint64_t dedupStoreSize)
+        : Overlay(
+              localDir,
+              caseSensitive,
+              overlayType,
+              logger,
+              blobFileCacheSize,
+              bufferMaxBytes,
+              bufferMaxAge,
+              gcThreads,
+              gcMaxOpsPerSecond,
+              dedupStoreSize) {}
   };
   return std::make_shared<MakeSharedEnabler>(
-      localDir, caseSensitive, overlayType, logger);
+      localDir,
+      caseSensitive,
+      overlayType,
+      logger,
+      blobFileCacheSize,
+      bufferMaxBytes,
+      bufferMaxAge,
+      gcThreads,
+      gcMaxOpsPerSecond,
+      dedupStoreSize);
 }
 
 Overlay::Overlay(
     AbsolutePathPiece localDir,
     CaseSensitivity caseSensitive,
     OverlayType overlayType,
-    std::shared_ptr<StructuredLogger> logger)
-    : backingOverlay_{makeOverlay(localDir, overlayType)},
+    std::shared_ptr<StructuredLogger> logger,
+    uint64_t blobFileCacheSize,
+    size_t bufferMaxBytes,
+    std::chrono::milliseconds bufferMaxAge,
+    size_t gcThreads,
+    uint64_t gcMaxOpsPerSecond,
+    uint64_t dedupStoreSize)
+    : backingOverlay_{makeOverlay(
+          localDir,
+          overlayType,
+          blobFileCacheSize,
+          bufferMaxBytes,
+          bufferMaxAge,
+          dedupStoreSize)},
       supportsSemanticOperations_{
           backingOverlay_->supportsSemanticOperations()},
+      gcThreads_{std::max(gcThreads, size_t{1})},
+      gcMaxOpsPerSecond_{gcMaxOpsPerSecond},
       caseSensitive_{caseSensitive},
       structuredLogger_{logger} {}
 
@@ -104,7 +189,7 @@ void Overlay::close() {
   XCHECK_NE(std::this_thread::get_id(), gcThread_.get_id());
 
   gcQueue_.lock()->stop = true;
-  gcCondVar_.notify_one();
+  gcCondVar_.notify_all();
   if (gcThread_.joinable()) {
     gcThread_.join();
   }
@@ -119,10 +204,13 @@ void Overlay::close() {
   // it. They must have used some external synchronization mechanism to
   // ensure this, so it is okay for us to still use relaxed access to
   // nextInodeNumber_.
+  //
+  // Record the number after the largest allocated one rather than the end of
+  // the reserved blocks, so that the unused parts of the blocks are not lost.
   std::optional<InodeNumber> optNextInodeNumber;
   auto nextInodeNumber = nextInodeNumber_.load(std::memory_order_relaxed);
   if (nextInodeNumber) {
-    optNextInodeNumber = InodeNumber{nextInodeNumber};
+    optNextInodeNumber = InodeNumber{getMaxAllocatedInodeNumber() + 1};
   }
 
   closeAndWaitForOutstandingIO();
@@ -160,7 +248,9 @@ folly::SemiFuture<Unit> Overlay::initialize(
                            progressCallback = std::move(progressCallback),
                            promise = std::move(initPromise)]() mutable {
     try {
+      folly::stop_watch<> initWatch;
       initOverlay(std::move(mountPath), progressCallback);
+      initDuration_ = initWatch.elapsed();
     } catch (std::exception& ex) {
       XLOG(ERR) << "overlay initialization failed for "
                 << backingOverlay_->getLocalDir() << ": " << ex.what();
@@ -195,13 +285,19 @@ void Overlay::initOverlay(
 
     // TODO(zeyi): `OverlayCheck` should be associated with the specific
     // Overlay implementation. `reinterpret_cast` is a temporary workaround.
+    size_t fsckThreads = FLAGS_overlayFsckThreads;
+    if (fsckThreads == 0) {
+      fsckThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
     OverlayChecker checker(
-        reinterpret_cast<FsOverlay*>(backingOverlay_.get()), std::nullopt);
+        reinterpret_cast<FsOverlay*>(backingOverlay_.get()),
+        std::nullopt,
+        fsckThreads);
     folly::stop_watch<> fsckRuntime;
     checker.scanForErrors(progressCallback);
     auto result = checker.repairErrors();
-    auto fsckRuntimeInSeconds =
-        std::chrono::duration<double>{fsckRuntime.elapsed()}.count();
+    fsckDuration_ = fsckRuntime.elapsed();
+    auto fsckRuntimeInSeconds = fsckDuration_.count();
     if (result) {
       // If totalErrors - fixedErrors is nonzero, then we failed to
       // fix all of the problems.
@@ -234,6 +330,8 @@ void Overlay::initOverlay(
                              ->scanLocalChanges(*mountPath);
   }
 
+  maxRetiredInodeNumber_.store(
+      optNextInodeNumber->get() - 1, std::memory_order_relaxed);
   nextInodeNumber_.store(optNextInodeNumber->get(), std::memory_order_relaxed);
 
 #ifndef _WIN32
@@ -258,16 +356,39 @@ InodeNumber Overlay::allocateInodeNumber() {
   static_assert(
       sizeof(InodeNumber) >= 8, "expected InodeNumber to be at least 64 bits");
 
-  // This could be a relaxed atomic operation.  It doesn't matter on x86 but
-  // might on ARM.
-  auto previous = nextInodeNumber_++;
+  auto& block = *inodeNumberBlocks_;
+  if (block.next == block.end) {
+    block.next = nextInodeNumber_.fetch_add(
+        kInodeNumberBlockSize, std::memory_order_relaxed);
+    XDCHECK_NE(0u, block.next)
+        << "allocateInodeNumber called before initialize";
+    block.end = block.next + kInodeNumberBlockSize;
+  }
+  auto previous = block.next++;
+  block.lastAllocated.store(previous, std::memory_order_relaxed);
 #ifdef _WIN32
   backingOverlay_->updateUsedInodeNumber(previous);
 #endif
-  XDCHECK_NE(0u, previous) << "allocateInodeNumber called before initialize";
   return InodeNumber{previous};
 }
 
+Overlay::InodeNumberBlock::~InodeNumberBlock() {
+  auto last = lastAllocated.load(std::memory_order_relaxed);
+  auto max = maxRetiredInodeNumber.load(std::memory_order_relaxed);
+  while (last > max &&
+         !maxRetiredInodeNumber.compare_exchange_weak(
+             max, last, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t Overlay::getMaxAllocatedInodeNumber() {
+  auto max = maxRetiredInodeNumber_.load(std::memory_order_relaxed);
+  for (const auto& block : inodeNumberBlocks_.accessAllThreads()) {
+    max = std::max(max, block.lastAllocated.load(std::memory_order_relaxed));
+  }
+  return max;
+}
+
 DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
   DirContents result(caseSensitive_);
   IORequest req{this};
@@ -360,6 +481,20 @@ void Overlay::saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir) {
       inodeNumber, serializeOverlayDir(inodeNumber, dir));
 }
 
+#ifndef _WIN32
+void Overlay::flushInodeMetadataAsync() {
+  if (!tryIncOutstandingIORequests()) {
+    return;
+  }
+  SCOPE_EXIT {
+    decOutstandingIORequests();
+  };
+  if (inodeMetadataTable_) {
+    inodeMetadataTable_->flushAsync();
+  }
+}
+#endif // !_WIN32
+
 void Overlay::freeInodeFromMetadataTable(InodeNumber ino) {
 #ifndef _WIN32
   // TODO: batch request during GC
@@ -387,7 +522,13 @@ void Overlay::recursivelyRemoveOverlayData(InodeNumber inodeNumber) {
   // remove this data.
   auto dirData = backingOverlay_->loadAndRemoveOverlayDir(inodeNumber);
   if (dirData) {
-    gcQueue_.lock()->queue.emplace_back(std::move(*dirData));
+    {
+      auto lock = gcQueue_.lock();
+      if (!lock->busy()) {
+        lock->busySince = std::chrono::steady_clock::now();
+      }
+      lock->dirs.push_back(std::move(*dirData));
+    }
     gcCondVar_.notify_one();
   }
 }
@@ -396,12 +537,26 @@ void Overlay::recursivelyRemoveOverlayData(InodeNumber inodeNumber) {
 folly::Future<folly::Unit> Overlay::flushPendingAsync() {
   folly::Promise<folly::Unit> promise;
   auto future = promise.getFuture();
-  gcQueue_.lock()->queue.emplace_back(std::move(promise));
+  gcQueue_.lock()->flushes.push_back(std::move(promise));
   gcCondVar_.notify_one();
   return future;
 }
 #endif // !_WIN32
 
+size_t Overlay::getGCBacklog() {
+  auto lock = gcQueue_.lock();
+  return lock->dirs.size() + lock->inodes.size();
+}
+
+std::chrono::milliseconds Overlay::getGCBacklogAge() {
+  auto lock = gcQueue_.lock();
+  if (!lock->busy()) {
+    return std::chrono::milliseconds{0};
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - lock->busySince);
+}
+
 bool Overlay::hasOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
   return backingOverlay_->hasOverlayData(inodeNumber);
@@ -446,12 +601,32 @@ OverlayFile Overlay::createOverlayFile(
       weak_from_this());
 }
 
+OverlayFile Overlay::createOverlayFileFromBlob(
+    InodeNumber inodeNumber,
+    const Blob& blob) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createOverlayFileFromBlob called with unallocated inode number";
+  return OverlayFile(
+      backingOverlay_->createOverlayFileFromBlob(
+          inodeNumber, blob.getHash(), blob.getContents()),
+      weak_from_this());
+}
+
+IOverlay::FileCopyStats Overlay::getFileCopyStats() const {
+  return backingOverlay_->getFileCopyStats();
+}
+
+bool Overlay::deduplicateFile(const OverlayFile& file, const Hash20& sha1) {
+  IORequest req{this};
+  return backingOverlay_->deduplicateFile(file.fd(), sha1);
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
-  auto ino = nextInodeNumber_.load(std::memory_order_relaxed);
-  XCHECK_GT(ino, 1u);
-  return InodeNumber{ino - 1};
+  XCHECK_GT(nextInodeNumber_.load(std::memory_order_relaxed), 1u);
+  return InodeNumber{getMaxAllocatedInodeNumber()};
 }
 
 bool Overlay::tryIncOutstandingIORequests() {
@@ -501,45 +676,98 @@ void Overlay::closeAndWaitForOutstandingIO() {
 }
 
 void Overlay::gcThread() noexcept {
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < gcThreads_; ++i) {
+    workers.emplace_back([this] { gcWorker(); });
+  }
+  gcWorker();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void Overlay::gcWorker() noexcept {
   for (;;) {
-    std::vector<GCRequest> requests;
+    std::optional<overlay::OverlayDir> removedDir;
+    std::vector<InodeNumber> dirs;
+    std::vector<folly::Promise<Unit>> flushes;
     {
       auto lock = gcQueue_.lock();
-      while (lock->queue.empty()) {
+      while (lock->dirs.empty() && lock->inodes.empty()) {
+        if (lock->activeWorkers == 0 && !lock->flushes.empty()) {
+          flushes.swap(lock->flushes);
+          break;
+        }
         if (lock->stop) {
           return;
         }
         gcCondVar_.wait(lock.as_lock());
-        continue;
       }
 
-      requests = std::move(lock->queue);
+      if (flushes.empty()) {
+        if (!lock->dirs.empty()) {
+          removedDir = std::move(lock->dirs.back());
+          lock->dirs.pop_back();
+        } else {
+          // Take the most recently found directories, so that the GC walks
+          // the trees depth first and the queue stays short.
+          auto count = std::min(lock->inodes.size(), kGCChunkSize);
+          dirs.assign(lock->inodes.end() - count, lock->inodes.end());
+          lock->inodes.resize(lock->inodes.size() - count);
+        }
+        ++lock->activeWorkers;
+      }
     }
 
-    for (auto& request : requests) {
-      try {
-        handleGCRequest(request);
-      } catch (const std::exception& e) {
-        XLOG(ERR) << "handleGCRequest should never throw, but it did: "
-                  << e.what();
+    if (!flushes.empty()) {
+      for (auto& flush : flushes) {
+        flush.setValue();
       }
+      continue;
     }
-  }
-}
 
-void Overlay::handleGCRequest(GCRequest& request) {
-  IORequest req{this};
-  if (request.flush) {
-    request.flush->setValue();
-    return;
+    std::vector<InodeNumber> subdirs;
+    size_t removed = 0;
+    try {
+      removed = collectGarbage(removedDir, dirs, subdirs);
+    } catch (const std::exception& e) {
+      XLOG(ERR) << "collectGarbage should never throw, but it did: "
+                << e.what();
+    }
+
+    {
+      auto lock = gcQueue_.lock();
+      lock->inodes.insert(lock->inodes.end(), subdirs.begin(), subdirs.end());
+      --lock->activeWorkers;
+      // Share the subdirectories with idle threads, or let them complete
+      // the flushes if the GC is done.
+      if (!subdirs.empty() || !lock->busy()) {
+        gcCondVar_.notify_all();
+      }
+    }
+
+    // Wait out the I/O budget outside of the batch, so that the removals
+    // are committed without delay.
+    if (gcMaxOpsPerSecond_ != 0) {
+      auto rate = static_cast<double>(gcMaxOpsPerSecond_);
+      auto remaining = static_cast<double>(removed);
+      while (remaining > 0) {
+        auto ops = std::min(remaining, rate);
+        gcBudget_.consumeWithBorrowAndWait(ops, rate, rate);
+        remaining -= ops;
+      }
+    }
   }
+}
 
-  // Should only include inode numbers for trees.
-  std::queue<InodeNumber> queue;
+size_t Overlay::collectGarbage(
+    const std::optional<overlay::OverlayDir>& removedDir,
+    const std::vector<InodeNumber>& dirs,
+    std::vector<InodeNumber>& subdirs) {
+  // Commit the removals together, rather than one transaction each.
+  OverlayBatch batch{this, kGCCommitInterval};
+  size_t removed = 0;
 
-  // TODO: For better throughput on large tree collections, it might make
-  // sense to split this into two threads: one for traversing the tree and
-  // another that makes the actual unlink calls.
   auto safeRemoveOverlayData = [&](InodeNumber inodeNumber) {
     try {
       removeOverlayData(inodeNumber);
@@ -560,24 +788,25 @@ void Overlay::handleGCRequest(GCRequest& request) {
       auto ino = InodeNumber::fromThrift(*value.inodeNumber_ref());
 
       if (S_ISDIR(*value.mode_ref())) {
-        queue.push(ino);
+        subdirs.push_back(ino);
       } else {
         // No need to recurse, but delete any file at this inode.  Note that,
         // under normal operation, there should be nothing at this path
         // because files are only written into the overlay if they're
         // materialized.
         safeRemoveOverlayData(ino);
+        ++removed;
       }
     }
   };
 
-  processDir(request.dir);
-
-  while (!queue.empty()) {
-    auto ino = queue.front();
-    queue.pop();
+  if (removedDir) {
+    processDir(*removedDir);
+  }
 
+  for (auto ino : dirs) {
     overlay::OverlayDir dir;
+    ++removed;
     try {
       freeInodeFromMetadataTable(ino);
       auto dirData = backingOverlay_->loadAndRemoveOverlayDir(ino);
@@ -595,6 +824,7 @@ void Overlay::handleGCRequest(GCRequest& request) {
 
     processDir(dir);
   }
+  return removed;
 }
 
 void Overlay::addChild(
@@ -640,5 +870,21 @@ void Overlay::renameChild(
     }
   }
 }
+
+void Overlay::beginBatch(size_t commitInterval) {
+  backingOverlay_->beginBatch(commitInterval);
+}
+
+void Overlay::endBatch() {
+  backingOverlay_->endBatch();
+}
+
+OverlayBatch::~OverlayBatch() {
+  try {
+    overlay_->endBatch();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "failed to commit overlay batch: " << ex.what();
+  }
+}
 } // namespace eden
 } // namespace facebook
@@ -8,11 +8,14 @@
 #pragma once
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <folly/ThreadLocal.h>
+#include <folly/TokenBucket.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/Baton.h>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <optional>
 #include <thread>
@@ -42,6 +45,7 @@ class IOverlay;
 class DirEntry;
 
 #ifndef _WIN32
+class Blob;
 struct InodeMetadata;
 template <typename T>
 class InodeTable;
@@ -74,19 +78,47 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     Tree = 1,
     TreeInMemory = 2,
     TreeSynchronousOff = 3,
+    TreeBuffered = 4,
+    /// Legacy, with directories kept in a DirectoryLog.
+    LegacyPacked = 5,
   };
 
+  static constexpr size_t kDefaultBufferMaxBytes = 64 * 1024 * 1024;
+  static constexpr std::chrono::milliseconds kDefaultBufferMaxAge{1000};
+  static constexpr size_t kDefaultGCThreads = 4;
+
   /**
    * Create a new Overlay object.
    *
    * The caller must call initialize() after creating the Overlay and wait for
    * it to succeed before using any other methods.
+   *
+   * `blobFileCacheSize` bounds the on-disk cache of blob contents that
+   * materialized files are cloned from, when the overlay type supports one.
+   * 0 disables it.
+   *
+   * `bufferMaxBytes` and `bufferMaxAge` bound the directory writes that the
+   * TreeBuffered overlay type keeps in memory before writing them to disk.
+   *
+   * The contents of removed directories are collected by `gcThreads`
+   * threads, which remove at most `gcMaxOpsPerSecond` inodes a second
+   * between them, or as many as they can if it is 0.
+   *
+   * `dedupStoreSize` bounds the on-disk store of file contents that
+   * identical overlay files share their data with, when the overlay type
+   * supports one. 0 disables it.
    */
   static std::shared_ptr<Overlay> create(
       AbsolutePathPiece localDir,
       CaseSensitivity caseSensitive,
       OverlayType overlayType,
-      std::shared_ptr<StructuredLogger> logger);
+      std::shared_ptr<StructuredLogger> logger,
+      uint64_t blobFileCacheSize = 0,
+      size_t bufferMaxBytes = kDefaultBufferMaxBytes,
+      std::chrono::milliseconds bufferMaxAge = kDefaultBufferMaxAge,
+      size_t gcThreads = kDefaultGCThreads,
+      uint64_t gcMaxOpsPerSecond = 0,
+      uint64_t dedupStoreSize = 0);
 
   ~Overlay();
 
@@ -143,6 +175,18 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     return hadCleanStartup_;
   }
 
+  /**
+   * How long initialize() took to open the overlay, and the part of that
+   * spent in the fsck of an overlay that was not shut down cleanly. Both are
+   * zero until initialize() has completed.
+   */
+  std::chrono::duration<double> getInitDuration() const {
+    return initDuration_;
+  }
+  std::chrono::duration<double> getFsckDuration() const {
+    return fsckDuration_;
+  }
+
   /**
    * Get the maximum inode number that has ever been allocated to an inode.
    */
@@ -159,8 +203,8 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    *   inodeCreated() should be called immediately afterwards to register the
    *   new child Inode object.
    *
-   * TODO: It would be easy to extend this function to allocate a range of
-   * inode values in one atomic operation.
+   * Each thread reserves a block of inode numbers at a time, so that threads
+   * creating many inodes concurrently do not all contend on the same counter.
    */
   InodeNumber allocateInodeNumber();
 #ifndef _WIN32
@@ -173,6 +217,12 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   InodeMetadataTable* getInodeMetadataTable() const {
     return inodeMetadataTable_.get();
   }
+
+  /**
+   * Starts writing back the records of the InodeMetadataTable modified since
+   * the last call. Does nothing if the overlay is not initialized or closed.
+   */
+  void flushInodeMetadataAsync();
 #endif // !_WIN32
 
   void saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir);
@@ -199,6 +249,18 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    */
   folly::Future<folly::Unit> flushPendingAsync();
 
+  /**
+   * Returns the number of removed directories whose contents are yet to be
+   * collected.
+   */
+  size_t getGCBacklog();
+
+  /**
+   * Returns how long the garbage collection has been busy, or 0 if it is
+   * idle.
+   */
+  std::chrono::milliseconds getGCBacklogAge();
+
   bool hasOverlayData(InodeNumber inodeNumber);
 
 #ifndef _WIN32
@@ -228,6 +290,24 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Create an overlay file for a FileInode materialized from `blob`.
+   */
+  OverlayFile createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const Blob& blob);
+
+  /**
+   * How the overlay files created from blobs were filled.
+   */
+  IOverlay::FileCopyStats getFileCopyStats() const;
+
+  /**
+   * Let the overlay file, whose contents have the SHA-1 `sha1`, share its
+   * data with identical overlay files. See IOverlay::deduplicateFile().
+   */
+  bool deduplicateFile(const OverlayFile& file, const Hash20& sha1);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -253,44 +333,71 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       const DirContents& srcContent,
       const DirContents& dstContent);
 
+  /**
+   * Group overlay mutations into batches committed together. Use
+   * OverlayBatch rather than calling these directly. See
+   * IOverlay::beginBatch().
+   */
+  void beginBatch(size_t commitInterval);
+  void endBatch();
+
  private:
   explicit Overlay(
       AbsolutePathPiece localDir,
       CaseSensitivity caseSensitive,
       OverlayType overlayType,
-      std::shared_ptr<StructuredLogger> logger);
+      std::shared_ptr<StructuredLogger> logger,
+      uint64_t blobFileCacheSize,
+      size_t bufferMaxBytes,
+      std::chrono::milliseconds bufferMaxAge,
+      size_t gcThreads,
+      uint64_t gcMaxOpsPerSecond,
+      uint64_t dedupStoreSize);
 
   /**
-   * A request for the background GC thread.  There are two types of requests:
-   * recursively forget data underneath an given directory, or complete a
-   * promise.  The latter is used for synchronization with the GC thread,
-   * primarily in unit tests.
+   * The work of the GC threads. Recursive collection of forgotten inode
+   * numbers is the only operation that can be made async while preserving
+   * our durability goals.
    *
-   * If additional request types are added in the future, consider renaming to
-   * AsyncRequest.  However, recursive collection of forgotten inode numbers
-   * is the only operation that can be made async while preserving our
-   * durability goals.
-   */
-  struct GCRequest {
-    GCRequest() {}
-    explicit GCRequest(overlay::OverlayDir&& d) : dir{std::move(d)} {}
-    explicit GCRequest(folly::Promise<folly::Unit> p) : flush{std::move(p)} {}
-
-    overlay::OverlayDir dir;
-    // Iff set, this is a flush request.
-    std::optional<folly::Promise<folly::Unit>> flush;
-  };
-
+   * Directories are taken from the queue a chunk at a time, and the
+   * subdirectories found in them are put back for any thread to take, so
+   * that a large tree is collected by all of the threads.
+   */
   struct GCQueue {
     bool stop = false;
-    std::vector<GCRequest> queue;
+    /// Directories removed by recursivelyRemoveOverlayData(), whose children
+    /// are yet to be collected.
+    std::vector<overlay::OverlayDir> dirs;
+    /// Directories yet to be loaded, removed and collected.
+    std::vector<InodeNumber> inodes;
+    /// Completed once the GC threads run out of work. Used for
+    /// synchronization with the GC threads, primarily in unit tests.
+    std::vector<folly::Promise<folly::Unit>> flushes;
+    /// Number of threads collecting work they took from the queue.
+    size_t activeWorkers = 0;
+    /// When the GC last went from idle to busy.
+    std::chrono::steady_clock::time_point busySince;
+
+    bool busy() const {
+      return !dirs.empty() || !inodes.empty() || activeWorkers != 0;
+    }
   };
 
   void initOverlay(
       std::optional<AbsolutePath> mountPath,
       const OverlayChecker::ProgressCallback& progressCallback = [](auto) {});
   void gcThread() noexcept;
-  void handleGCRequest(GCRequest& request);
+  void gcWorker() noexcept;
+
+  /**
+   * Collects the children of `removedDir` if set, and the directories in
+   * `dirs`, adding the subdirectories found to `subdirs`. Returns the number
+   * of inodes removed.
+   */
+  size_t collectGarbage(
+      const std::optional<overlay::OverlayDir>& removedDir,
+      const std::vector<InodeNumber>& dirs,
+      std::vector<InodeNumber>& subdirs);
 
   // Serialize EdenFS overlay data structure into Thrift data structure
   overlay::OverlayEntry serializeOverlayEntry(const DirEntry& entry);
@@ -304,15 +411,53 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   void closeAndWaitForOutstandingIO();
 
   bool hadCleanStartup_{false};
+  std::chrono::duration<double> initDuration_{0};
+  std::chrono::duration<double> fsckDuration_{0};
+
+  /**
+   * The inode numbers a thread reserved from nextInodeNumber_ and has not
+   * allocated yet.
+   */
+  struct InodeNumberBlock {
+    explicit InodeNumberBlock(std::atomic<uint64_t>& maxRetired)
+        : maxRetiredInodeNumber{maxRetired} {}
+    ~InodeNumberBlock();
+
+    uint64_t next{0};
+    uint64_t end{0};
+    /**
+     * The last inode number this thread allocated, or 0. Only written by the
+     * owning thread, but read by getMaxAllocatedInodeNumber().
+     */
+    std::atomic<uint64_t> lastAllocated{0};
+    std::atomic<uint64_t>& maxRetiredInodeNumber;
+  };
+
+  /**
+   * Returns the largest inode number allocated so far, or the largest one
+   * recorded in the overlay if none was allocated.
+   */
+  uint64_t getMaxAllocatedInodeNumber();
 
   /**
-   * The next inode number to allocate.  Zero indicates that neither
-   * initializeFromTakeover nor getMaxRecordedInode have been called.
+   * The start of the next block of inode numbers to reserve.  Zero indicates
+   * that neither initializeFromTakeover nor getMaxRecordedInode have been
+   * called.
    *
-   * This value will never be 1.
+   * This value will never be 1. Numbers below it may still be unallocated,
+   * but numbers at or above it have never been allocated.
    */
   std::atomic<uint64_t> nextInodeNumber_{0};
 
+  /**
+   * The largest inode number recorded in the overlay when it was opened or
+   * allocated by a thread that has exited since.
+   */
+  std::atomic<uint64_t> maxRetiredInodeNumber_{0};
+
+  folly::ThreadLocal<InodeNumberBlock> inodeNumberBlocks_{
+      [this] { return new InodeNumberBlock{maxRetiredInodeNumber_}; }};
+
   std::unique_ptr<IOverlay> backingOverlay_;
 
   /**
@@ -339,12 +484,20 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   /**
    * Thread which recursively removes entries from the overlay underneath the
-   * trees added to gcQueue_.
+   * trees added to gcQueue_, with the help of gcThreads_ - 1 others.
    */
   std::thread gcThread_;
+  const size_t gcThreads_;
   folly::Synchronized<GCQueue, std::mutex> gcQueue_;
   std::condition_variable gcCondVar_;
 
+  /**
+   * Limits the rate at which the GC threads remove inodes, so that they
+   * leave I/O for the filesystem requests. Unlimited if the rate is 0.
+   */
+  const uint64_t gcMaxOpsPerSecond_;
+  folly::DynamicTokenBucket gcBudget_;
+
   /**
    * This uint64_t holds two values, a single bit on the MSB that
    * acts a boolean closed: True if the the Overlay has been closed with
@@ -393,5 +546,32 @@ class IORequest {
   Overlay* const overlay_;
 };
 
+/**
+ * Groups the overlay mutations made during its lifetime into batches of
+ * `commitInterval` mutations that are committed together, which is much
+ * cheaper than committing each of them when many are made in a row, such as
+ * during checkout. Mutations are still committed when the batch is
+ * destroyed.
+ *
+ * A batch counts as an outstanding IO request, so the overlay can't be
+ * closed under it.
+ */
+class OverlayBatch {
+ public:
+  OverlayBatch(Overlay* overlay, size_t commitInterval)
+      : request_{overlay}, overlay_{overlay} {
+    overlay_->beginBatch(commitInterval);
+  }
+
+  ~OverlayBatch();
+
+ private:
+  OverlayBatch(OverlayBatch&&) = delete;
+  OverlayBatch& operator=(OverlayBatch&&) = delete;
+
+  IORequest request_;
+  Overlay* const overlay_;
+};
+
 } // namespace eden
 } // namespace facebook
@@ -12,6 +12,8 @@
 #include <folly/FileUtil.h>
 
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/utils/IoUring.h"
+#include "eden/fs/utils/XAttr.h"
 
 namespace facebook {
 namespace eden {
@@ -160,6 +162,93 @@ folly::Expected<std::string, int> OverlayFile::readFile() const {
   return folly::makeExpected<int>(std::move(out));
 }
 
+folly::Expected<std::string, int> OverlayFile::fgetxattr(
+    folly::StringPiece name) const {
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  try {
+    return facebook::eden::fgetxattr(file_.fd(), name);
+  } catch (const std::system_error& ex) {
+    return folly::makeUnexpected(ex.code().value());
+  }
+}
+
+folly::Expected<folly::Unit, int> OverlayFile::fsetxattr(
+    folly::StringPiece name,
+    folly::StringPiece value) const {
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  try {
+    facebook::eden::fsetxattr(file_.fd(), name, value);
+  } catch (const std::system_error& ex) {
+    return folly::makeUnexpected(ex.code().value());
+  }
+  return folly::unit;
+}
+
+template <typename Submit>
+ImmediateFuture<folly::Expected<ssize_t, int>> OverlayFile::submitAsync(
+    Submit&& submit) const {
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::Expected<ssize_t, int>{folly::makeUnexpected(EIO)};
+  }
+  // The overlay must not close until the operation completes.
+  auto req = std::make_unique<IORequest>(overlay.get());
+
+  return ImmediateFuture<int>{submit(file_.fd())}.thenValue(
+      [overlay = std::move(overlay),
+       req = std::move(req)](int result) -> folly::Expected<ssize_t, int> {
+        if (result < 0) {
+          return folly::makeUnexpected(-result);
+        }
+        return result;
+      });
+}
+
+ImmediateFuture<folly::Expected<ssize_t, int>>
+OverlayFile::preadAsync(IoUring* ring, void* buf, size_t n, off_t offset)
+    const {
+  if (!ring) {
+    return preadNoInt(buf, n, offset);
+  }
+  return submitAsync([&](int fd) { return ring->pread(fd, buf, n, offset); });
+}
+
+ImmediateFuture<folly::Expected<ssize_t, int>> OverlayFile::pwritevAsync(
+    IoUring* ring,
+    const iovec* iov,
+    int iovcnt,
+    off_t offset) const {
+  if (!ring) {
+    return pwritev(iov, iovcnt, offset);
+  }
+  return submitAsync(
+      [&](int fd) { return ring->pwritev(fd, iov, iovcnt, offset); });
+}
+
+ImmediateFuture<folly::Expected<ssize_t, int>> OverlayFile::fsyncAsync(
+    IoUring* ring,
+    bool datasync) const {
+  if (!ring) {
+    auto result = datasync ? fdatasync() : fsync();
+    if (result.hasError()) {
+      return folly::Expected<ssize_t, int>{
+          folly::makeUnexpected(result.error())};
+    }
+    return folly::Expected<ssize_t, int>{result.value()};
+  }
+  return submitAsync([&](int fd) { return ring->fsync(fd, datasync); });
+}
+
 } // namespace eden
 } // namespace facebook
 
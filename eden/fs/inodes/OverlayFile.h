@@ -9,8 +9,12 @@
 
 #include <folly/Expected.h>
 #include <folly/File.h>
+#include <folly/Range.h>
+#include <folly/Unit.h>
 #include <folly/portability/SysUio.h>
 
+#include "eden/fs/utils/ImmediateFuture.h"
+
 namespace folly {
 class File;
 }
@@ -18,6 +22,7 @@ class File;
 namespace facebook {
 namespace eden {
 
+class IoUring;
 class Overlay;
 
 class OverlayFile {
@@ -28,6 +33,14 @@ class OverlayFile {
   OverlayFile(OverlayFile&&) = default;
   OverlayFile& operator=(OverlayFile&&) = default;
 
+  /**
+   * The file descriptor of the overlay file, for splicing its contents
+   * elsewhere. It is only valid while this OverlayFile exists.
+   */
+  int fd() const {
+    return file_.fd();
+  }
+
   folly::Expected<struct stat, int> fstat() const;
   folly::Expected<ssize_t, int> preadNoInt(void* buf, size_t n, off_t offset)
       const;
@@ -39,8 +52,35 @@ class OverlayFile {
   folly::Expected<int, int> fallocate(off_t offset, off_t length) const;
   folly::Expected<int, int> fdatasync() const;
   folly::Expected<std::string, int> readFile() const;
+  folly::Expected<std::string, int> fgetxattr(folly::StringPiece name) const;
+  folly::Expected<folly::Unit, int> fsetxattr(
+      folly::StringPiece name,
+      folly::StringPiece value) const;
+
+  /**
+   * Like preadNoInt(), pwritev(), and fsync() or fdatasync(), but submitted to
+   * `ring` so the calling thread does not wait on the disk. When `ring` is
+   * null, the I/O is performed synchronously and the returned future is
+   * ready.
+   *
+   * Buffers must stay valid until the returned future completes.
+   */
+  ImmediateFuture<folly::Expected<ssize_t, int>>
+  preadAsync(IoUring* ring, void* buf, size_t n, off_t offset) const;
+  ImmediateFuture<folly::Expected<ssize_t, int>> pwritevAsync(
+      IoUring* ring,
+      const iovec* iov,
+      int iovcnt,
+      off_t offset) const;
+  ImmediateFuture<folly::Expected<ssize_t, int>> fsyncAsync(
+      IoUring* ring,
+      bool datasync) const;
 
  private:
+  template <typename Submit>
+  ImmediateFuture<folly::Expected<ssize_t, int>> submitAsync(
+      Submit&& submit) const;
+
   OverlayFile(const OverlayFile&) = delete;
   OverlayFile& operator=(const OverlayFile&) = delete;
 
@@ -14,6 +14,9 @@
 #include <folly/logging/xlog.h>
 #include <gflags/gflags.h>
 #include <openssl/sha.h>
+#include <chrono>
+#include <cstring>
+#include <vector>
 
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeError.h"
@@ -23,6 +26,9 @@
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/IoUring.h"
+#include "eden/fs/utils/StatTimes.h"
+#include "eden/fs/utils/XAttr.h"
 #include "folly/FileUtil.h"
 
 namespace facebook {
@@ -35,11 +41,135 @@ namespace eden {
  */
 
 DEFINE_uint64(overlayFileCacheSize, 100, "");
+DEFINE_uint32(
+    overlayIoUringQueueDepth,
+    256,
+    "Number of overlay I/O submissions an io_uring has room for");
 
-void OverlayFileAccess::Entry::Info::invalidateMetadata() {
+namespace {
+
+/// Extended attribute of overlay files holding a SavedSha1.
+constexpr folly::StringPiece kXattrSavedSha1{"user.eden.sha1"};
+constexpr uint32_t kSavedSha1Version = 1;
+
+/**
+ * A write in the same timestamp tick as the mtime a SHA-1 is saved with would
+ * go unnoticed, so a SHA-1 is only saved once the file's mtime is older than
+ * the hashed contents by this much.
+ */
+constexpr auto kSavedSha1MinAge = std::chrono::seconds{1};
+
+/// Large reads let BLAKE3 compress whole chunks straight from the buffer.
+constexpr size_t kBlake3ReadSize = 256 * 1024;
+
+/**
+ * The SHA-1 of an overlay file, valid as long as the file's size and mtime
+ * match, and optionally the SHA-1 state to extend it with appended data.
+ *
+ * This is only ever read back on the machine that wrote it, so it is stored
+ * in native byte order. A different SHA_CTX layout invalidates it.
+ */
+struct SavedSha1 {
+  uint32_t version;
+  /// sizeof(SHA_CTX), or 0 if ctx is not set.
+  uint32_t ctxSize;
+  /// Size of the overlay file, header included.
+  uint64_t fileSize;
+  int64_t mtimeSec;
+  int64_t mtimeNsec;
+  uint8_t sha1[Hash20::RAW_SIZE];
+  SHA_CTX ctx;
+};
+
+std::optional<SavedSha1> loadSavedSha1(const OverlayFile& file) {
+  auto value = file.fgetxattr(kXattrSavedSha1);
+  if (value.hasError()) {
+    if (value.error() != kENOATTR) {
+      XLOG(DBG3) << "unable to read saved overlay file SHA-1: "
+                 << folly::errnoStr(value.error());
+    }
+    return std::nullopt;
+  }
+
+  SavedSha1 saved;
+  if (value->size() != sizeof(saved)) {
+    return std::nullopt;
+  }
+  memcpy(&saved, value->data(), sizeof(saved));
+  if (saved.version != kSavedSha1Version ||
+      (saved.ctxSize != 0 && saved.ctxSize != sizeof(SHA_CTX))) {
+    return std::nullopt;
+  }
+
+  auto st = file.fstat();
+  if (st.hasError()) {
+    return std::nullopt;
+  }
+  auto mtime = stMtime(*st);
+  if (saved.fileSize != static_cast<uint64_t>(st->st_size) ||
+      saved.fileSize < FsOverlay::kHeaderLength ||
+      saved.mtimeSec != mtime.tv_sec || saved.mtimeNsec != mtime.tv_nsec) {
+    return std::nullopt;
+  }
+  return saved;
+}
+
+/**
+ * Save the SHA-1 of the overlay file's contents as of `hashedAt`, and the
+ * SHA-1 state after hashing them if `ctx` is set.
+ *
+ * Returns false if the SHA-1 can't be saved yet, because the file was modified
+ * too recently.
+ */
+bool saveSha1(
+    const OverlayFile& file,
+    const Hash20& sha1,
+    const SHA_CTX* ctx,
+    std::chrono::system_clock::time_point hashedAt) {
+  auto st = file.fstat();
+  if (st.hasError()) {
+    return false;
+  }
+  if (stMtimepoint(*st) + kSavedSha1MinAge > hashedAt) {
+    return false;
+  }
+
+  SavedSha1 saved;
+  memset(&saved, 0, sizeof(saved));
+  saved.version = kSavedSha1Version;
+  saved.fileSize = st->st_size;
+  auto mtime = stMtime(*st);
+  saved.mtimeSec = mtime.tv_sec;
+  saved.mtimeNsec = mtime.tv_nsec;
+  memcpy(saved.sha1, sha1.getBytes().data(), sizeof(saved.sha1));
+  if (ctx) {
+    saved.ctxSize = sizeof(SHA_CTX);
+    saved.ctx = *ctx;
+  }
+
+  auto result = file.fsetxattr(
+      kXattrSavedSha1,
+      folly::StringPiece{reinterpret_cast<const char*>(&saved), sizeof(saved)});
+  if (result.hasError()) {
+    // Not retried: the overlay filesystem likely doesn't support xattrs.
+    XLOG(DBG3) << "unable to save overlay file SHA-1: "
+               << folly::errnoStr(result.error());
+  }
+  return true;
+}
+
+} // namespace
+
+void OverlayFileAccess::Entry::Info::invalidateMetadata(
+    uint64_t unchangedLength) {
   ++version;
   size = std::nullopt;
   sha1 = std::nullopt;
+  blake3 = std::nullopt;
+  sha1Saved = false;
+  if (sha1Prefix && sha1Prefix->length > unchangedLength) {
+    sha1Prefix = std::nullopt;
+  }
 }
 
 OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
@@ -48,11 +178,28 @@ OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
   }
 }
 
-OverlayFileAccess::OverlayFileAccess(Overlay* overlay)
-    : overlay_{overlay}, state_{folly::in_place, FLAGS_overlayFileCacheSize} {}
+OverlayFileAccess::OverlayFileAccess(Overlay* overlay, bool useIoUring)
+    : overlay_{overlay}, state_{folly::in_place, FLAGS_overlayFileCacheSize} {
+  if (useIoUring) {
+    try {
+      ioUring_ = std::make_unique<IoUring>(FLAGS_overlayIoUringQueueDepth);
+    } catch (const std::system_error& ex) {
+      XLOG(WARN) << "unable to use io_uring for overlay I/O, falling back to "
+                 << "synchronous I/O: " << ex.what();
+    }
+  }
+}
 
 OverlayFileAccess::~OverlayFileAccess() = default;
 
+size_t OverlayFileAccess::estimateMemoryUsage() const {
+  // Each cached entry is a shared_ptr control block holding the Entry, plus
+  // an EvictingCacheMap node linking it into the LRU list and hash index.
+  constexpr size_t kEntrySize = sizeof(Entry) + 2 * sizeof(void*) +
+      sizeof(InodeNumber) + sizeof(EntryPtr) + 3 * sizeof(void*);
+  return state_.rlock()->entries.size() * kEntrySize;
+}
+
 void OverlayFileAccess::createEmptyFile(InodeNumber ino) {
   auto file = overlay_->createOverlayFile(ino, folly::ByteRange{});
   auto state = state_.wlock();
@@ -66,7 +213,7 @@ void OverlayFileAccess::createFile(
     InodeNumber ino,
     const Blob& blob,
     const std::optional<Hash20>& sha1) {
-  auto file = overlay_->createOverlayFile(ino, blob.getContents());
+  auto file = overlay_->createOverlayFileFromBlob(ino, blob);
   auto state = state_.wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
@@ -122,55 +269,220 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
 }
 
 Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
+  // Taken before looking at the entry, so that it precedes any write the
+  // SHA-1 computed below may not reflect.
+  auto now = std::chrono::system_clock::now();
+
   auto entry = getEntryForInode(inode.getNodeId());
   uint64_t version;
+  std::optional<Sha1Prefix> prefix;
+  bool loadSaved;
   {
     auto info = entry->info.rlock();
-    if (info->sha1.has_value()) {
+    if (info->sha1.has_value() && info->sha1Saved) {
       return *info->sha1;
     }
     version = info->version;
+    prefix = info->sha1Prefix;
+    loadSaved = !info->loadedSavedSha1;
+
+    if (info->sha1.has_value()) {
+      // The SHA-1 of a recently modified file could not be saved when it was
+      // computed. Try again, now that the file may be old enough.
+      auto sha1 = *info->sha1;
+      info.unlock();
+      auto saved = saveSha1(
+          entry->file, sha1, prefix ? &prefix->ctx : nullptr, now);
+      if (saved) {
+        markSha1Saved(*entry, version, sha1);
+      }
+      return sha1;
+    }
   }
 
-  // SHA-1 is not known, so recompute it. Do so while the lock is not held to
-  // improve concurrency.
+  if (loadSaved) {
+    auto saved = loadSavedSha1(entry->file);
+    auto info = entry->info.wlock();
+    if (version == info->version) {
+      info->loadedSavedSha1 = true;
+      if (saved) {
+        Hash20 sha1{folly::ByteRange{saved->sha1, sizeof(saved->sha1)}};
+        info->sha1 = sha1;
+        info->sha1Saved = true;
+        // The saved SHA-1 is only valid for the current size of the file.
+        info->size = saved->fileSize - FsOverlay::kHeaderLength;
+        if (saved->ctxSize) {
+          info->sha1Prefix = Sha1Prefix{
+              saved->ctx, saved->fileSize - FsOverlay::kHeaderLength};
+        }
+        return sha1;
+      }
+    }
+  }
 
-  SHA_CTX ctx;
-  SHA1_Init(&ctx);
+  // SHA-1 is not known, so compute it. Do so while the lock is not held to
+  // improve concurrency. When the SHA-1 state after hashing the start of the
+  // file is known, only the rest of the file needs hashing.
+
+  while (true) {
+    SHA_CTX ctx;
+    off_t off = FsOverlay::kHeaderLength;
+    if (prefix) {
+      ctx = prefix->ctx;
+      off += prefix->length;
+    } else {
+      SHA1_Init(&ctx);
+    }
 
+    while (true) {
+      // Using pread here so that we don't move the file position;
+      // the file descriptor is shared between multiple file handles
+      // and while we serialize the requests to FileData, it seems
+      // like a good property of this function to avoid changing that
+      // state.
+      uint8_t buf[8192];
+      auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
+      if (ret.hasError()) {
+        throw InodeError(
+            ret.error(),
+            inode.inodePtrFromThis(),
+            "pread failed during SHA-1 calculation");
+      }
+      auto len = ret.value();
+      if (len == 0) {
+        break;
+      }
+      SHA1_Update(&ctx, buf, len);
+      off += len;
+    }
+
+    // SHA1_Final() consumes the state, so keep a copy to extend after appends.
+    Sha1Prefix hashed{ctx, off - FsOverlay::kHeaderLength};
+
+    static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
+    Hash20 sha1;
+    SHA1_Final(sha1.mutableBytes().begin(), &ctx);
+
+    {
+      // Update the cache if the version still matches.
+      auto info = entry->info.wlock();
+      if (version != info->version) {
+        if (!prefix) {
+          return sha1;
+        }
+        // The file was modified while it was hashed, maybe within the prefix
+        // the hash was extended from. Hash all of it again.
+        prefix = std::nullopt;
+        continue;
+      }
+      info->sha1 = sha1;
+      info->sha1Prefix = hashed;
+      // The file was read to its end, so there is no need to stat it.
+      info->size = hashed.length;
+    }
+
+    if (saveSha1(entry->file, sha1, &hashed.ctx, now)) {
+      markSha1Saved(*entry, version, sha1);
+    }
+    return sha1;
+  }
+}
+
+void OverlayFileAccess::markSha1Saved(
+    Entry& entry,
+    uint64_t version,
+    const Hash20& sha1) {
+  {
+    auto info = entry.info.wlock();
+    if (version != info->version) {
+      return;
+    }
+    info->sha1Saved = true;
+  }
+  // Contents that stayed unmodified long enough for their SHA-1 to be saved
+  // are worth sharing with identical files. The filesystem compares the
+  // contents first, so a write since the SHA-1 was computed is harmless.
+  overlay_->deduplicateFile(entry.file, sha1);
+}
+
+BlobMetadata OverlayFileAccess::getBlobMetadata(
+    FileInode& inode,
+    bool includeBlake3) {
+  std::optional<Blake3::Digest> blake3;
+  if (includeBlake3) {
+    auto entry = getEntryForInode(inode.getNodeId());
+    bool withSha1;
+    {
+      auto info = entry->info.rlock();
+      blake3 = info->blake3;
+      withSha1 = !info->sha1.has_value();
+    }
+    if (!blake3) {
+      blake3 = hashContents(inode, *entry, withSha1);
+    }
+  }
+
+  // Unless the file was modified concurrently, the SHA-1 and size are cached
+  // by now, or computed and cached together by getSha1().
+  auto sha1 = getSha1(inode);
+  auto size = static_cast<uint64_t>(getFileSize(inode));
+  return BlobMetadata{sha1, size, blake3};
+}
+
+Blake3::Digest OverlayFileAccess::hashContents(
+    FileInode& inode,
+    Entry& entry,
+    bool withSha1) {
+  auto version = entry.info.rlock()->version;
+
+  // Hash while the lock is not held, and only cache the results if the file
+  // was not modified in the meantime.
+  Blake3 blake3;
+  SHA_CTX ctx;
+  if (withSha1) {
+    SHA1_Init(&ctx);
+  }
+  std::vector<uint8_t> buf(kBlake3ReadSize);
   off_t off = FsOverlay::kHeaderLength;
   while (true) {
-    // Using pread here so that we don't move the file position;
-    // the file descriptor is shared between multiple file handles
-    // and while we serialize the requests to FileData, it seems
-    // like a good property of this function to avoid changing that
-    // state.
-    uint8_t buf[8192];
-    auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
+    auto ret = entry.file.preadNoInt(buf.data(), buf.size(), off);
     if (ret.hasError()) {
       throw InodeError(
           ret.error(),
           inode.inodePtrFromThis(),
-          "pread failed during SHA-1 calculation");
+          "pread failed during hash calculation");
     }
     auto len = ret.value();
     if (len == 0) {
       break;
     }
-    SHA1_Update(&ctx, buf, len);
+    blake3.update(folly::ByteRange{buf.data(), static_cast<size_t>(len)});
+    if (withSha1) {
+      SHA1_Update(&ctx, buf.data(), len);
+    }
     off += len;
   }
+  uint64_t length = off - FsOverlay::kHeaderLength;
+  auto digest = blake3.finalize();
+
+  std::optional<Sha1Prefix> prefix;
+  std::optional<Hash20> sha1;
+  if (withSha1) {
+    prefix = Sha1Prefix{ctx, length};
+    sha1.emplace();
+    SHA1_Final(sha1->mutableBytes().begin(), &ctx);
+  }
 
-  static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
-  Hash20 sha1;
-  SHA1_Final(sha1.mutableBytes().begin(), &ctx);
-
-  // Update the cache if the version still matches.
-  auto info = entry->info.wlock();
+  auto info = entry.info.wlock();
   if (version == info->version) {
-    info->sha1 = sha1;
+    info->blake3 = digest;
+    info->size = length;
+    if (sha1) {
+      info->sha1 = sha1;
+      info->sha1Prefix = prefix;
+    }
   }
-  return sha1;
+  return digest;
 }
 
 std::string OverlayFileAccess::readAllContents(FileInode& inode) {
@@ -205,42 +517,65 @@ std::string OverlayFileAccess::readAllContents(FileInode& inode) {
   return result.value();
 }
 
-BufVec OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
+ImmediateFuture<BufVec>
+OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
 
   auto buf = folly::IOBuf::createCombined(size);
-  auto res = entry->file.preadNoInt(
-      buf->writableBuffer(), size, off + FsOverlay::kHeaderLength);
-
-  if (res.hasError()) {
-    throw InodeError(
-        res.error(),
-        inode.inodePtrFromThis(),
-        "pread failed during overlay file read");
-  }
-
-  buf->append(res.value());
-  return BufVec{std::move(buf)};
+  auto res = entry->file.preadAsync(
+      ioUring_.get(),
+      buf->writableBuffer(),
+      size,
+      off + FsOverlay::kHeaderLength);
+
+  return std::move(res).thenValue(
+      [entry, buf = std::move(buf), inode = inode.inodePtrFromThis()](
+          folly::Expected<ssize_t, int> res) mutable {
+        if (res.hasError()) {
+          throw InodeError(
+              res.error(), inode, "pread failed during overlay file read");
+        }
+
+        buf->append(res.value());
+        return BufVec{std::move(buf)};
+      });
 }
 
-size_t OverlayFileAccess::write(
-    FileInode& inode,
-    const struct iovec* iov,
-    size_t iovcnt,
-    off_t off) {
+FileRange
+OverlayFileAccess::getFileRange(FileInode& inode, size_t size, off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  auto fd = entry->file.fd();
+  return FileRange{
+      fd,
+      static_cast<off_t>(off + FsOverlay::kHeaderLength),
+      size,
+      std::move(entry)};
+}
 
-  auto xfer = entry->file.pwritev(iov, iovcnt, off + FsOverlay::kHeaderLength);
-  if (xfer.hasError()) {
-    throw InodeError(
-        xfer.error(),
-        inode.inodePtrFromThis(),
-        "pwritev failed during file write");
-  }
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+ImmediateFuture<size_t>
+OverlayFileAccess::write(FileInode& inode, BufVec buf, off_t off) {
+  auto entry = getEntryForInode(inode.getNodeId());
 
-  return xfer.value();
+  // Like the data it points to, the iovec array must outlive the write.
+  auto iov = buf->getIov();
+  auto xfer = entry->file.pwritevAsync(
+      ioUring_.get(), iov.data(), iov.size(), off + FsOverlay::kHeaderLength);
+
+  return std::move(xfer).thenValue(
+      [entry,
+       buf = std::move(buf),
+       iov = std::move(iov),
+       inode = inode.inodePtrFromThis(),
+       off](folly::Expected<ssize_t, int> xfer) -> size_t {
+        if (xfer.hasError()) {
+          throw InodeError(
+              xfer.error(), inode, "pwritev failed during file write");
+        }
+        auto info = entry->info.wlock();
+        info->invalidateMetadata(off);
+
+        return xfer.value();
+      });
 }
 
 void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
@@ -254,21 +589,26 @@ void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
   }
 
   auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  info->invalidateMetadata(size);
 }
 
-void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
+ImmediateFuture<folly::Unit> OverlayFileAccess::fsync(
+    FileInode& inode,
+    bool datasync) {
   // TODO: If the inode is not currently in cache, we could avoid calling fsync.
   // That said, close() does not ensure data is synced, so it's safest to
   // reopen.
   auto entry = getEntryForInode(inode.getNodeId());
-  auto result = datasync ? entry->file.fdatasync() : entry->file.fsync();
-  if (result.hasError()) {
-    throw InodeError(
-        result.error(),
-        inode.inodePtrFromThis(),
-        "unable to fsync overlay file");
-  }
+  auto result = entry->file.fsyncAsync(ioUring_.get(), datasync);
+
+  return std::move(result).thenValue(
+      [entry, inode = inode.inodePtrFromThis()](
+          folly::Expected<ssize_t, int> result) {
+        if (result.hasError()) {
+          throw InodeError(
+              result.error(), inode, "unable to fsync overlay file");
+        }
+      });
 }
 
 void OverlayFileAccess::fallocate(
@@ -297,9 +637,6 @@ OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
   }
 
   // No entry found. Open one while the lock is not held.
-  // TODO: A possible future optimization here is, if a SHA-1 is known when
-  // the blob is evicted, write it into an xattr when the blob is closed. When
-  // reopened, if the xattr exists, read it back out (and clear).
   auto entry = std::make_shared<Entry>(
       overlay_->openFileNoVerify(ino), std::nullopt, std::nullopt);
 
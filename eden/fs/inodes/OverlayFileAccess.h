@@ -10,28 +10,38 @@
 #include <folly/File.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <openssl/sha.h>
 #include <memory>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/OverlayFile.h"
+#include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/Blake3.h"
 #include "eden/fs/utils/BufVec.h"
+#include "eden/fs/utils/ImmediateFuture.h"
 
 namespace facebook {
 namespace eden {
 
 class Blob;
 class FileInode;
+class IoUring;
 class Overlay;
 
 /**
  * Provides a file handle caching layer between FileInode and the Overlay. Read
  * and write operations for different inodes can be interleaved, and the
  * OverlayFileAccess will keep a number of file handles open in LRU.
+ *
+ * Reads, writes and fsyncs are submitted to an io_uring when `useIoUring` is
+ * set and the kernel supports it, so the threads serving filesystem requests
+ * don't wait on the disk. Otherwise, they are performed synchronously and the
+ * returned futures are ready.
  */
 class OverlayFileAccess {
  public:
-  explicit OverlayFileAccess(Overlay* overlay);
+  explicit OverlayFileAccess(Overlay* overlay, bool useIoUring = false);
   ~OverlayFileAccess();
 
   /**
@@ -45,7 +55,8 @@ class OverlayFileAccess {
 
   /**
    * Creates a new file in the overlay populated with the contents of the given
-   * blob. If a sha1 is given, it is cached in memory.
+   * blob, cloned from the overlay's blob file cache when it has the blob. If a
+   * sha1 is given, it is cached in memory.
    *
    * The caller must verify the overlay file does not already exist. Calls to
    * any other OverlayFileAccess functions for this inode must occur after
@@ -68,9 +79,22 @@ class OverlayFileAccess {
 
   /**
    * Returns the SHA-1 hash of the file contents for the given inode number.
+   *
+   * The hash is saved in an extended attribute of the overlay file, keyed by
+   * the file's size and mtime, so that it survives the file being closed or
+   * EdenFS restarting. After appends, only the appended data is hashed.
    */
   Hash20 getSha1(FileInode& inode);
 
+  /**
+   * Returns the size and SHA-1 of the file contents for the given inode
+   * number, and their BLAKE3 hash if `includeBlake3` is set.
+   *
+   * Whatever isn't cached is computed with a single pass over the file. The
+   * BLAKE3 hash is only cached in memory, until the file is modified.
+   */
+  BlobMetadata getBlobMetadata(FileInode& inode, bool includeBlake3);
+
   /**
    * Reads the entire file's contents into memory and returns it.
    */
@@ -80,14 +104,19 @@ class OverlayFileAccess {
    * Reads a range from the file. At EOF, may return a BufVec smaller than the
    * requested size.
    */
-  BufVec read(FileInode& inode, size_t size, off_t off);
+  ImmediateFuture<BufVec> read(FileInode& inode, size_t size, off_t off);
+
+  /**
+   * Returns the range of the overlay file holding the given range of the
+   * file's contents, without reading it.
+   */
+  FileRange getFileRange(FileInode& inode, size_t size, off_t off);
 
   /**
    * Writes data into the file at the specified offset. Returns the number of
    * bytes written.
    */
-  size_t
-  write(FileInode& inode, const struct iovec* iov, size_t iovcnt, off_t off);
+  ImmediateFuture<size_t> write(FileInode& inode, BufVec buf, off_t off);
 
   /**
    * Sets the size of the file in the overlay.
@@ -98,13 +127,27 @@ class OverlayFileAccess {
    * If datasync is true, only the user data should be flushed, not the
    * metadata. It corresponds to datasync parameter to fuse_lowlevel_ops::fsync.
    */
-  void fsync(FileInode& inode, bool datasync);
+  ImmediateFuture<folly::Unit> fsync(FileInode& inode, bool datasync);
+
+  /**
+   * Whether I/O is submitted to an io_uring. If so, buffers passed to write()
+   * must outlive the call.
+   */
+  bool usesIoUring() const {
+    return ioUring_ != nullptr;
+  }
 
   /**
    * Call fallocate(mode=0) or posix_fallocate on the backing overlay storage.
    */
   void fallocate(FileInode& inode, uint64_t offset, uint64_t size);
 
+  /**
+   * Estimated bytes used by the cache of open overlay files and their size
+   * and SHA-1 metadata.
+   */
+  size_t estimateMemoryUsage() const;
+
  private:
   /*
    * OverlayFileAccess can be accessed concurrently. There are two types of data
@@ -123,8 +166,18 @@ class OverlayFileAccess {
    * concurrent with write or truncate, a version number is incremented on every
    * modification to an entry's file, and checked before writing the cached
    * value back.
+   *
+   * Besides the SHA-1 itself, the SHA-1 state after hashing a prefix of the
+   * file is kept. Modifications past the end of that prefix, like appends,
+   * leave it valid, so the next getSha1 call only hashes the rest of the file.
    */
 
+  /// The SHA-1 state after hashing the first `length` bytes of a file.
+  struct Sha1Prefix {
+    SHA_CTX ctx;
+    uint64_t length;
+  };
+
   struct Entry {
     Entry(
         OverlayFile f,
@@ -136,10 +189,20 @@ class OverlayFileAccess {
       Info(std::optional<size_t> s, const std::optional<Hash20>& h)
           : size{s}, sha1{h} {}
 
-      void invalidateMetadata();
+      /**
+       * Forget the cached metadata after the file was modified. The file's
+       * first `unchangedLength` bytes must not have been modified.
+       */
+      void invalidateMetadata(uint64_t unchangedLength = 0);
 
       std::optional<size_t> size;
       std::optional<Hash20> sha1;
+      std::optional<Blake3::Digest> blake3;
+      std::optional<Sha1Prefix> sha1Prefix;
+      /// Whether the SHA-1 saved in the overlay file was looked up already.
+      bool loadedSavedSha1{false};
+      /// Whether sha1 no longer needs to be saved in the overlay file.
+      bool sha1Saved{false};
       uint64_t version{0};
     };
 
@@ -149,6 +212,19 @@ class OverlayFileAccess {
 
   using EntryPtr = std::shared_ptr<Entry>;
 
+  /**
+   * Hash the file contents with BLAKE3, and with SHA-1 too if `withSha1` is
+   * set, in a single pass. The results and the file's size are cached unless
+   * the file is modified in the meantime.
+   */
+  Blake3::Digest hashContents(FileInode& inode, Entry& entry, bool withSha1);
+
+  /**
+   * Record that the SHA-1 of the entry's file was saved, unless the file was
+   * modified since `version`, and deduplicate the file.
+   */
+  void markSha1Saved(Entry& entry, uint64_t version, const Hash20& sha1);
+
   struct State {
     explicit State(size_t cacheSize);
 
@@ -165,6 +241,7 @@ class OverlayFileAccess {
 
   Overlay* overlay_ = nullptr;
   folly::Synchronized<State> state_;
+  std::unique_ptr<IoUring> ioUring_;
 };
 
 } // namespace eden
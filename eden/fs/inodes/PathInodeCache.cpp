@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/PathInodeCache.h"
+
+namespace facebook::eden {
+
+std::optional<InodeNumber> PathInodeCache::get(RelativePathPiece path) {
+  if (!enabled_) {
+    return std::nullopt;
+  }
+  auto key = std::hash<RelativePathPiece>{}(path);
+  auto generation = getGeneration();
+  auto cache = cache_.lock();
+  auto it = cache->find(key);
+  if (it == cache->end()) {
+    return std::nullopt;
+  }
+  const auto& entry = it->second;
+  if (entry.generation != generation) {
+    cache->erase(it);
+    return std::nullopt;
+  }
+  if (entry.path != path) {
+    return std::nullopt;
+  }
+  return entry.ino;
+}
+
+void PathInodeCache::insert(
+    RelativePathPiece path,
+    InodeNumber ino,
+    uint64_t generation) {
+  if (!enabled_ || generation != getGeneration()) {
+    return;
+  }
+  auto key = std::hash<RelativePathPiece>{}(path);
+  Entry entry{path.copy(), ino, generation};
+  cache_.lock()->set(key, std::move(entry));
+}
+
+} // namespace facebook::eden
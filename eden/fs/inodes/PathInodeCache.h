@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded, in-memory LRU cache of the inode numbers that paths in a mount
+ * resolved to.
+ *
+ * Thrift and ProjectedFS APIs that take full paths would otherwise look up
+ * every component of the path, locking each directory along the way, even
+ * though the same tools tend to ask about the same paths repeatedly.
+ *
+ * Rather than tracking which paths each change affects, every result is
+ * tagged with the generation it was resolved in. Anything that can make an
+ * existing path refer to another inode or to none (renames, removals and
+ * checkouts) starts a new generation, which invalidates the whole cache.
+ * Creating new entries doesn't, since only paths that exist are cached.
+ *
+ * A maximumEntries of 0 disables the cache.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class PathInodeCache {
+ public:
+  explicit PathInodeCache(size_t maximumEntries)
+      : enabled_{maximumEntries != 0},
+        cache_{folly::in_place, maximumEntries} {}
+
+  /**
+   * The generation to pass to insert() for a lookup that starts now.
+   */
+  uint64_t getGeneration() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Returns the inode number that `path` resolved to in the current
+   * generation, if it is cached.
+   */
+  std::optional<InodeNumber> get(RelativePathPiece path);
+
+  /**
+   * Remember that `path` resolved to `ino` in a lookup that started in
+   * `generation`. Does nothing if the generation has since ended, since the
+   * lookup might have raced with the change that ended it.
+   */
+  void insert(RelativePathPiece path, InodeNumber ino, uint64_t generation);
+
+  /**
+   * Start a new generation. Must be called after the change that requires
+   * it is visible to lookups, so that lookups that might have missed the
+   * change started in the old generation.
+   */
+  void invalidate() {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  size_t size() const {
+    return cache_.lock()->size();
+  }
+
+ private:
+  struct Entry {
+    RelativePath path;
+    InodeNumber ino;
+    uint64_t generation;
+  };
+
+  // EvictingCacheMap treats a maximum size of 0 as unbounded.
+  const bool enabled_;
+  std::atomic<uint64_t> generation_{0};
+
+  // Entries are keyed by the hash of their path, so that lookups don't have
+  // to copy it. The path is kept in the entry to detect collisions.
+  //
+  // A lookup updates the LRU order, so there is no point in a shared lock.
+  folly::Synchronized<folly::EvictingCacheMap<size_t, Entry>, std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
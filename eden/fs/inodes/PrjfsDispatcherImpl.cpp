@@ -11,8 +11,10 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <cpptoml.h>
+#include <folly/executors/GlobalExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/executors/SerialExecutor.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/config/CheckoutConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
@@ -40,6 +42,9 @@ const std::string kConfigSocketPath{"socket"};
 const std::string kConfigClientPath{"client"};
 const std::string kConfigTable{"Config"};
 
+// Number of directory listings kept in the enumeration cache.
+constexpr size_t kEnumerationCacheSize = 1024;
+
 std::string makeDotEdenConfig(EdenMount& mount) {
   auto repoPath = mount.getPath();
   auto socketPath = mount.getServerState()->getSocketPath();
@@ -62,6 +67,9 @@ std::string makeDotEdenConfig(EdenMount& mount) {
 PrjfsDispatcherImpl::PrjfsDispatcherImpl(EdenMount* mount)
     : PrjfsDispatcher(mount->getStats()),
       mount_{mount},
+      enumerationCache_{std::make_shared<EnumerationCache>(
+          folly::in_place,
+          kEnumerationCacheSize)},
       executor_{1, "PrjfsDispatcher"},
       notificationExecutor_{
           folly::SerialExecutor::create(folly::getKeepAliveToken(&executor_))},
@@ -74,6 +82,7 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
   return mount_->getTreeOrTreeEntry(path, *context)
       .thenValue([isRoot,
                   objectStore = mount_->getObjectStore(),
+                  cache = enumerationCache_,
                   context = std::move(context)](
                      std::variant<std::shared_ptr<const Tree>, TreeEntry>
                          treeOrTreeEntry) mutable {
@@ -82,15 +91,73 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
 
         std::vector<PrjfsDirEntry> ret;
         ret.reserve(treeEntries.size() + isRoot);
-        for (const auto& treeEntry : treeEntries) {
-          if (treeEntry.isTree()) {
-            ret.emplace_back(
-                treeEntry.getName(), true, ImmediateFuture<uint64_t>(0));
-          } else {
-            auto sizeFut =
-                objectStore->getBlobSize(treeEntry.getHash(), *context)
-                    .ensure([context]() {});
-            ret.emplace_back(treeEntry.getName(), false, std::move(sizeFut));
+
+        std::shared_ptr<const std::vector<PrjfsDirEntry::Ready>> cached;
+        {
+          auto lockedCache = cache->wlock();
+          auto it = lockedCache->find(tree->getHash());
+          if (it != lockedCache->end()) {
+            cached = it->second;
+          }
+        }
+
+        if (cached) {
+          for (const auto& ready : *cached) {
+            ret.emplace_back(ready);
+          }
+        } else {
+          // Read the metadata of all the blobs from the LocalStore at once
+          // instead of one read per entry.
+          std::vector<ObjectId> blobs;
+          for (const auto& treeEntry : treeEntries) {
+            if (!treeEntry.isTree()) {
+              blobs.push_back(treeEntry.getHash());
+            }
+          }
+          auto prefetch = objectStore->prefetchBlobMetadata(std::move(blobs))
+                              .thenTry([](folly::Try<folly::Unit>&&) {})
+                              .semi()
+                              .via(folly::getGlobalCPUExecutor())
+                              .splitter();
+
+          for (const auto& treeEntry : treeEntries) {
+            if (treeEntry.isTree()) {
+              ret.emplace_back(
+                  treeEntry.getName(), true, ImmediateFuture<uint64_t>(0));
+            } else {
+              auto sizeFut =
+                  ImmediateFuture{prefetch.getSemiFuture()}
+                      .thenValue([objectStore,
+                                  id = treeEntry.getHash(),
+                                  context](folly::Unit) {
+                        return objectStore->getBlobSize(id, *context);
+                      })
+                      .ensure([context]() {});
+              ret.emplace_back(treeEntry.getName(), false, std::move(sizeFut));
+            }
+          }
+
+          // Sort the listing once and cache it when all the sizes are known,
+          // so the next enumerations of this tree neither fetch nor sort.
+          std::sort(ret.begin(), ret.end());
+          std::vector<ImmediateFuture<PrjfsDirEntry::Ready>> readyFutures;
+          readyFutures.reserve(ret.size());
+          for (auto& entry : ret) {
+            readyFutures.push_back(entry.getFuture());
+          }
+          auto cacheFuture =
+              collectAllSafe(std::move(readyFutures))
+                  .thenValue([cache, id = tree->getHash()](
+                                 std::vector<PrjfsDirEntry::Ready>&& entries) {
+                    cache->wlock()->set(
+                        id,
+                        std::make_shared<
+                            const std::vector<PrjfsDirEntry::Ready>>(
+                            std::move(entries)));
+                  });
+          if (!cacheFuture.isReady()) {
+            folly::futures::detachOnGlobalCPUExecutor(
+                std::move(cacheFuture).semi());
           }
         }
 
@@ -560,40 +627,50 @@ ImmediateFuture<folly::Unit> handleMaterializedFileNotification(
       });
 }
 
-ImmediateFuture<folly::Unit> fileNotification(
-    EdenMount& mount,
+} // namespace
+
+ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileNotification(
     RelativePath path,
-    folly::Executor::KeepAlive<folly::SequencedExecutor> executor,
     std::shared_ptr<ObjectFetchContext> context) {
-  folly::via(executor, [&mount, path, context = std::move(context)]() mutable {
-    return fileNotificationImpl(mount, std::move(path), *context).get();
-  }).thenError([path](const folly::exception_wrapper& ew) {
-    XLOG(ERR) << "While handling notification on: " << path << ": " << ew;
-  });
+  // Notifications are handled by looking at the on-disk state of the path
+  // when they run, thus a queued notification on the same path that hasn't
+  // started yet will also account for this one. A `git clean` or a build
+  // touching the same files repeatedly would otherwise queue work that is
+  // redundant, delaying status and checkout in waitForPendingNotifications.
+  if (!queuedNotifications_.wlock()->insert(path).second) {
+    return folly::unit;
+  }
+
+  folly::via(
+      notificationExecutor_,
+      [this, path, context = std::move(context)]() mutable {
+        // Remove the path before looking at the disk so a notification
+        // received while this one is being handled gets queued.
+        queuedNotifications_.wlock()->erase(path);
+        return fileNotificationImpl(*mount_, std::move(path), *context).get();
+      })
+      .thenError([path](const folly::exception_wrapper& ew) {
+        XLOG(ERR) << "While handling notification on: " << path << ": " << ew;
+      });
   return folly::unit;
 }
 
-} // namespace
-
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileCreated(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
-  return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+  return fileNotification(std::move(path), std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirCreated(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
-  return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+  return fileNotification(std::move(path), std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileModified(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
-  return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+  return fileNotification(std::move(path), std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
@@ -602,10 +679,9 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
     std::shared_ptr<ObjectFetchContext> context) {
   // A rename is just handled like 2 notifications separate notifications on
   // the old and new paths.
-  auto oldNotification =
-      fileNotification(*mount_, oldPath, notificationExecutor_, context);
-  auto newNotification = fileNotification(
-      *mount_, newPath, notificationExecutor_, std::move(context));
+  auto oldNotification = fileNotification(std::move(oldPath), context);
+  auto newNotification =
+      fileNotification(std::move(newPath), std::move(context));
 
   return collectAllSafe(std::move(oldNotification), std::move(newNotification))
       .thenValue(
@@ -645,8 +721,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirRename(
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileDeleted(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
-  return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+  return fileNotification(std::move(path), std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
@@ -662,8 +737,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirDeleted(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
-  return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+  return fileNotification(std::move(path), std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
@@ -7,7 +7,11 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Set.h>
 #include <folly/executors/SequencedExecutor.h>
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
@@ -81,9 +85,30 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
   ImmediateFuture<folly::Unit> waitForPendingNotifications() override;
 
  private:
+  /**
+   * Queue the handling of a notification on path to the notificationExecutor_.
+   */
+  ImmediateFuture<folly::Unit> fileNotification(
+      RelativePath path,
+      std::shared_ptr<ObjectFetchContext> context);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
+  /**
+   * Sorted entries of the recently listed source control trees, with their
+   * sizes. Trees are immutable, thus a cached listing never goes stale.
+   */
+  using EnumerationCache = folly::Synchronized<folly::EvictingCacheMap<
+      ObjectId,
+      std::shared_ptr<const std::vector<PrjfsDirEntry::Ready>>>>;
+  std::shared_ptr<EnumerationCache> enumerationCache_;
+
+  // Paths whose notification is queued in the notificationExecutor_ but
+  // hasn't started being handled yet. Further notifications on these paths
+  // are coalesced into the queued one.
+  folly::Synchronized<folly::F14FastSet<RelativePath>> queuedNotifications_;
+
   UnboundedQueueExecutor executor_;
   // All the notifications are dispatched to this executor. The
   // waitForPendingNotifications implementation depends on this being a
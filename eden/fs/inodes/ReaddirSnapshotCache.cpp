@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ReaddirSnapshotCache.h"
+
+namespace facebook::eden {
+
+std::shared_ptr<const ReaddirSnapshot> ReaddirSnapshotCache::get(
+    InodeNumber dir,
+    uint64_t verifier) {
+  auto cache = cache_.lock();
+  auto it = cache->find(verifier);
+  if (it == cache->end() || it->second.dir != dir) {
+    return nullptr;
+  }
+  if (it->second.expiry <= std::chrono::steady_clock::now()) {
+    cache->erase(it);
+    return nullptr;
+  }
+  return it->second.snapshot;
+}
+
+uint64_t ReaddirSnapshotCache::insert(
+    InodeNumber dir,
+    std::shared_ptr<const ReaddirSnapshot> snapshot) {
+  auto verifier = nextVerifier_.fetch_add(1, std::memory_order_relaxed);
+  auto expiry = std::chrono::steady_clock::now() + ttl_;
+  cache_.lock()->set(verifier, Entry{dir, expiry, std::move(snapshot)});
+  return verifier;
+}
+
+void ReaddirSnapshotCache::erase(uint64_t verifier) {
+  cache_.lock()->erase(verifier);
+}
+
+void ReaddirSnapshotCache::invalidate(InodeNumber dir) {
+  auto cache = cache_.lock();
+  // There are only ever a few listings in progress, so a scan is cheap.
+  for (auto it = cache->begin(); it != cache->end();) {
+    if (it->second.dir == dir) {
+      it = cache->erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+} // namespace facebook::eden
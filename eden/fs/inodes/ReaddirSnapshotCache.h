@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * The entries of a directory at the start of a listing, sorted by inode
+ * number, which readdir offsets are derived from.
+ */
+struct ReaddirSnapshot {
+  struct Entry {
+    InodeNumber ino;
+    dtype_t type;
+    PathComponent name;
+  };
+
+  std::vector<Entry> entries;
+};
+
+/**
+ * A bounded cache of the directory snapshots that NFS listings in progress
+ * are paged through, keyed by the cookie verifier handed out with the first
+ * page.
+ *
+ * Without it, every READDIR continuation would list the whole directory again
+ * to find where the previous page ended, which makes paging through a large
+ * directory quadratic.
+ *
+ * Snapshots are dropped when their directory is modified through NFS, when
+ * their listing completes, and after a TTL. Listings whose snapshot is gone
+ * carry on from a new one, since offsets don't depend on the snapshot.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class ReaddirSnapshotCache {
+ public:
+  ReaddirSnapshotCache(size_t maximumSnapshots, std::chrono::nanoseconds ttl)
+      : ttl_{std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            ttl)},
+        cache_{folly::in_place, std::max(maximumSnapshots, size_t{1})} {}
+
+  /**
+   * Returns the snapshot of `dir` that `verifier` was handed out for, or
+   * nullptr if it was dropped.
+   */
+  std::shared_ptr<const ReaddirSnapshot> get(
+      InodeNumber dir,
+      uint64_t verifier);
+
+  /**
+   * Remember `snapshot` of `dir`. Returns the verifier to hand out for it,
+   * which is never 0, the verifier of the first page of a listing.
+   */
+  uint64_t insert(
+      InodeNumber dir,
+      std::shared_ptr<const ReaddirSnapshot> snapshot);
+
+  /**
+   * Drop the snapshot that `verifier` was handed out for.
+   */
+  void erase(uint64_t verifier);
+
+  /**
+   * Drop the snapshots of `dir`, which was modified.
+   */
+  void invalidate(InodeNumber dir);
+
+  size_t size() const {
+    return cache_.lock()->size();
+  }
+
+ private:
+  struct Entry {
+    InodeNumber dir;
+    std::chrono::steady_clock::time_point expiry;
+    std::shared_ptr<const ReaddirSnapshot> snapshot;
+  };
+
+  const std::chrono::steady_clock::duration ttl_;
+  std::atomic<uint64_t> nextVerifier_{1};
+  folly::Synchronized<folly::EvictingCacheMap<uint64_t, Entry>, std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
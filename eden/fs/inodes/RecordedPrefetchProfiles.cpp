@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/RecordedPrefetchProfiles.h"
+
+#include <folly/String.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <map>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/EdenError.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Maximum number of blobs passed to a single prefetchBlobs() call, as for
+ * prefetching glob results.
+ */
+constexpr size_t kPrefetchBatchSize = 20480;
+
+class ReplayFetchContext : public ObjectFetchContext {
+ public:
+  ImportPriority getPriority() const override {
+    return ImportPriority::kLow();
+  }
+
+  Cause getCause() const override {
+    return ObjectFetchContext::Cause::Prefetch;
+  }
+
+  std::optional<folly::StringPiece> getCauseDetail() const override {
+    return folly::StringPiece{"recorded prefetch profile"};
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+};
+
+/**
+ * Paths arranged by directory, so that each tree is fetched only once however
+ * many of its files are listed.
+ */
+struct PathTrie {
+  std::vector<PathComponent> files;
+  std::map<PathComponent, std::unique_ptr<PathTrie>> directories;
+
+  void insert(RelativePathPiece path) {
+    auto* node = this;
+    for (auto component : path.dirname().components()) {
+      auto& child = node->directories[PathComponent{component}];
+      if (!child) {
+        child = std::make_unique<PathTrie>();
+      }
+      node = child.get();
+    }
+    node->files.emplace_back(path.basename());
+  }
+};
+
+struct ReplayState {
+  PathTrie paths;
+  ReplayFetchContext context;
+  folly::Synchronized<std::vector<ObjectId>> blobIds;
+};
+
+/**
+ * Add the blob IDs of the files of `paths` found in `tree` to
+ * `state.blobIds`. Missing trees are skipped rather than failing the replay.
+ */
+ImmediateFuture<folly::Unit> collectBlobIds(
+    const Tree& tree,
+    const PathTrie& paths,
+    const std::shared_ptr<ObjectStore>& objectStore,
+    ReplayState& state) {
+  {
+    auto blobIds = state.blobIds.wlock();
+    for (const auto& name : paths.files) {
+      auto* entry = tree.getEntryPtr(name);
+      if (entry && !entry->isTree()) {
+        blobIds->push_back(entry->getHash());
+      }
+    }
+  }
+
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+  for (const auto& [name, child] : paths.directories) {
+    auto* entry = tree.getEntryPtr(name);
+    if (!entry || !entry->isTree()) {
+      continue;
+    }
+    futures.push_back(
+        objectStore->getTree(entry->getHash(), state.context)
+            .thenValue([&childPaths = *child, objectStore, &state](
+                           std::shared_ptr<const Tree> subtree) {
+              return collectBlobIds(*subtree, childPaths, objectStore, state);
+            }));
+  }
+  return collectAll(std::move(futures)).unit();
+}
+
+} // namespace
+
+RecordedPrefetchProfiles::RecordedPrefetchProfiles(AbsolutePath directory)
+    : directory_{std::move(directory)} {}
+
+void RecordedPrefetchProfiles::startRecording(
+    folly::StringPiece name,
+    std::optional<pid_t> pid) {
+  // Validates that the name can be used as a file name.
+  (void)PathComponentPiece{name};
+
+  auto recordings = recordings_.wlock();
+  auto [it, inserted] = recordings->try_emplace(name.str());
+  it->second.pid = pid;
+  if (inserted) {
+    numRecording_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+size_t RecordedPrefetchProfiles::stopRecording(folly::StringPiece name) {
+  Recording recording;
+  {
+    auto recordings = recordings_.wlock();
+    auto it = recordings->find(name.str());
+    if (it == recordings->end()) {
+      throw newEdenError(
+          EdenErrorType::ARGUMENT_ERROR,
+          "prefetch profile ",
+          name,
+          " is not being recorded");
+    }
+    recording = std::move(it->second);
+    recordings->erase(it);
+    numRecording_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::vector<std::string> paths{
+      recording.paths.begin(), recording.paths.end()};
+  std::sort(paths.begin(), paths.end());
+  std::string contents;
+  for (const auto& path : paths) {
+    contents.append(path);
+    contents.push_back('\n');
+  }
+
+  ensureDirectoryExists(directory_);
+  writeFileAtomic(
+      directory_ + PathComponentPiece{name},
+      folly::ByteRange{folly::StringPiece{contents}})
+      .value();
+  XLOG(DBG2) << "saved prefetch profile " << name << " with " << paths.size()
+             << " paths";
+  return paths.size();
+}
+
+void RecordedPrefetchProfiles::recordFetch(
+    RelativePathPiece path,
+    const ObjectFetchContext& context) {
+  // Replaying a profile must not record into it.
+  if (context.getCause() == ObjectFetchContext::Cause::Prefetch) {
+    return;
+  }
+
+  auto pid = context.getClientPid();
+  auto recordings = recordings_.wlock();
+  for (auto& entry : *recordings) {
+    auto& recording = entry.second;
+    if (recording.pid && recording.pid != pid) {
+      continue;
+    }
+    recording.paths.insert(path.stringPiece().str());
+  }
+}
+
+std::vector<std::string> RecordedPrefetchProfiles::listProfiles() const {
+  std::vector<std::string> names;
+  auto entries = getAllDirectoryEntryNames(directory_);
+  if (entries.hasException()) {
+    // The directory does not exist until a profile has been saved.
+    return names;
+  }
+  for (const auto& entry : entries.value()) {
+    names.push_back(entry.stringPiece().str());
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+std::vector<RelativePath> RecordedPrefetchProfiles::loadProfile(
+    folly::StringPiece name) const {
+  std::vector<RelativePath> paths;
+  auto contents = readFile(directory_ + PathComponentPiece{name});
+  if (contents.hasException()) {
+    return paths;
+  }
+
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents.value(), lines, /*ignoreEmpty=*/true);
+  for (auto line : lines) {
+    try {
+      paths.emplace_back(line);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "skipping invalid path in prefetch profile " << name
+                 << ": " << folly::exceptionStr(ex);
+    }
+  }
+  return paths;
+}
+
+folly::Future<size_t> RecordedPrefetchProfiles::replay(
+    std::shared_ptr<const Tree> rootTree,
+    std::shared_ptr<ObjectStore> objectStore) const {
+  auto state = std::make_shared<ReplayState>();
+  bool empty = true;
+  for (const auto& name : listProfiles()) {
+    for (const auto& path : loadProfile(name)) {
+      state->paths.insert(path);
+      empty = false;
+    }
+  }
+  if (empty) {
+    return folly::makeFuture<size_t>(0);
+  }
+
+  return collectBlobIds(*rootTree, state->paths, objectStore, *state)
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenValue([rootTree, objectStore, state](folly::Unit) {
+        auto blobIds = state->blobIds.wlock();
+        std::sort(blobIds->begin(), blobIds->end());
+        blobIds->erase(
+            std::unique(blobIds->begin(), blobIds->end()), blobIds->end());
+
+        std::vector<folly::Future<folly::Unit>> futures;
+        auto range = ObjectIdRange{blobIds->data(), blobIds->size()};
+        while (!range.empty()) {
+          auto batch = range.subpiece(0, kPrefetchBatchSize);
+          range.advance(batch.size());
+          futures.push_back(objectStore->prefetchBlobs(batch, state->context));
+        }
+        return folly::collectUnsafe(futures).thenValue(
+            [state, count = blobIds->size()](auto&&) { return count; });
+      });
+}
+
+} // namespace facebook::eden
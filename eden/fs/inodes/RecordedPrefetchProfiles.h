@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/futures/Future.h>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class Tree;
+
+/**
+ * Named sets of file paths recorded from a mount's blob loads, and replayed
+ * as one batched prefetch after a checkout.
+ *
+ * While a profile is recording, every file whose contents are loaded for a
+ * request that is not itself a prefetch is added to it. A profile started for
+ * a pid only records that process's loads. Stopping the recording saves the
+ * profile in the mount's client directory, replacing any earlier recording
+ * of the same name.
+ *
+ * Profiles hold paths rather than object IDs so that they stay useful across
+ * commits: replay() looks the paths up in the new root tree and fetches the
+ * blobs found there with ObjectStore::prefetchBlobs at low priority.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class RecordedPrefetchProfiles {
+ public:
+  /**
+   * Profiles are saved as files in `directory`, one path per line. The
+   * directory is created when the first profile is saved.
+   */
+  explicit RecordedPrefetchProfiles(AbsolutePath directory);
+
+  /**
+   * Start recording the profile `name`. Recording a profile that is already
+   * recording keeps the paths recorded so far.
+   *
+   * Throws if `name` is not a valid path component.
+   */
+  void startRecording(folly::StringPiece name, std::optional<pid_t> pid);
+
+  /**
+   * Stop recording the profile `name` and save it. Returns the number of
+   * paths saved.
+   */
+  size_t stopRecording(folly::StringPiece name);
+
+  /**
+   * Cheap check for whether recordFetch() needs to be called at all.
+   */
+  bool isRecording() const {
+    return numRecording_.load(std::memory_order_relaxed) > 0;
+  }
+
+  /**
+   * Add `path` to every recording profile that `context` matches.
+   */
+  void recordFetch(RelativePathPiece path, const ObjectFetchContext& context);
+
+  /**
+   * The names of the saved profiles.
+   */
+  std::vector<std::string> listProfiles() const;
+
+  /**
+   * The paths of the saved profile `name`, or none if it does not exist.
+   */
+  std::vector<RelativePath> loadProfile(folly::StringPiece name) const;
+
+  /**
+   * Prefetch the blobs of the files of every saved profile, as found in
+   * `rootTree`. Paths that no longer exist, or are no longer files, are
+   * skipped. Returns the number of blobs prefetched.
+   */
+  folly::Future<size_t> replay(
+      std::shared_ptr<const Tree> rootTree,
+      std::shared_ptr<ObjectStore> objectStore) const;
+
+ private:
+  struct Recording {
+    std::optional<pid_t> pid;
+    std::unordered_set<std::string> paths;
+  };
+
+  AbsolutePath directory_;
+  std::atomic<size_t> numRecording_{0};
+  folly::Synchronized<std::unordered_map<std::string, Recording>> recordings_;
+};
+
+} // namespace facebook::eden
@@ -19,11 +19,13 @@ namespace facebook::eden {
 void RequestContext::startRequest(
     EdenStats* stats,
     ChannelThreadStats::StatPtr stat,
+    folly::StringPiece operation,
     std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>&
         requestWatches) {
   startTime_ = steady_clock::now();
   XDCHECK(latencyStat_ == nullptr);
   latencyStat_ = stat;
+  operation_ = operation;
   stats_ = stats;
   channelThreadLocalStats_ = requestWatches;
   if (channelThreadLocalStats_) {
@@ -31,6 +33,47 @@ void RequestContext::startRequest(
   }
 }
 
+namespace {
+folly::StringPiece fetchOriginName(ObjectFetchContext::Origin origin) {
+  switch (origin) {
+    case ObjectFetchContext::Origin::NotFetched:
+      return "not_fetched";
+    case ObjectFetchContext::Origin::FromMemoryCache:
+      return "memory_cache";
+    case ObjectFetchContext::Origin::FromDiskCache:
+      return "disk_cache";
+    case ObjectFetchContext::Origin::FromNetworkFetch:
+      return "network";
+    case ObjectFetchContext::Origin::kOriginEnumMax:
+      break;
+  }
+  return "unknown";
+}
+} // namespace
+
+void RequestContext::recordIfSlow(
+    SlowRequestLog& slowRequests,
+    std::chrono::microseconds elapsed) {
+  auto now = system_clock::now();
+  if (!slowRequests.isSlowEnough(elapsed, now)) {
+    return;
+  }
+
+  SlowRequest request;
+  request.operation = operation_.str();
+  request.duration = elapsed;
+  request.finishTime = now;
+  request.pid = getClientPid();
+  request.requestId = getRequestId();
+  request.inode = getRequestInode();
+  request.path = getRequestPath();
+  request.fetchOrigin =
+      fetchOriginName(getEdenTopStats().getFetchOrigin()).str();
+  request.backingStoreDuration =
+      microseconds{backingStoreUs_.load(std::memory_order_relaxed)};
+  slowRequests.record(std::move(request));
+}
+
 void RequestContext::finishRequest() noexcept {
   try {
     const auto now = steady_clock::now();
@@ -42,6 +85,8 @@ void RequestContext::finishRequest() noexcept {
     if (stats_ != nullptr) {
       stats_->getChannelStatsForCurrentThread().recordLatency(
           latencyStat_, diff_us);
+      stats_->recordChannelLatency(operation_, diff_us);
+      recordIfSlow(stats_->getSlowRequestLog(), diff_us);
       latencyStat_ = nullptr;
       stats_ = nullptr;
     }
@@ -9,6 +9,8 @@
 
 #include <folly/futures/Future.h>
 #include <atomic>
+#include <optional>
+#include <string>
 #include <utility>
 
 #include "eden/fs/store/ImportPriority.h"
@@ -28,16 +30,14 @@ class RequestContext : public ObjectFetchContext {
    *
    * Sub-classes should call this instead of std::make_shared to make sure that
    * finishRequest is called once the last shared_ptr holding the
-   * RequestContext is destroyed.
+   * RequestContext is destroyed. The context and its control block share a
+   * single allocation, since every channel request allocates one.
    */
   template <typename T, typename... Args>
   static std::
       enable_if_t<std::is_base_of_v<RequestContext, T>, std::shared_ptr<T>>
       makeSharedRequestContext(Args&&... args) {
-    return std::shared_ptr<T>{new T(std::forward<Args>(args)...), [](T* ptr) {
-                                ptr->finishRequest();
-                                delete ptr;
-                              }};
+    return std::make_shared<Finishing<T>>(std::forward<Args>(args)...);
   }
 
   RequestContext(const RequestContext&) = delete;
@@ -56,6 +56,11 @@ class RequestContext : public ObjectFetchContext {
     edenTopStats_.setFetchOrigin(origin);
   }
 
+  // Override of `ObjectFetchContext`
+  void didWaitForBackingStore(std::chrono::microseconds elapsed) override {
+    backingStoreUs_.fetch_add(elapsed.count(), std::memory_order_relaxed);
+  }
+
   // Override of `getPriority`
   ImportPriority getPriority() const override {
     return priority_;
@@ -81,14 +86,50 @@ class RequestContext : public ObjectFetchContext {
     return nullptr;
   }
 
+  /**
+   * The inode this request was made on, reported in the slow request log.
+   */
+  virtual std::optional<uint64_t> getRequestInode() const {
+    return std::nullopt;
+  }
+
+  /**
+   * The path this request was made on, reported in the slow request log.
+   */
+  virtual std::string getRequestPath() const {
+    return {};
+  }
+
+  /**
+   * operation names the FUSE opcode, NFS procedure or ProjectedFS callback,
+   * and must outlive the request.
+   */
   void startRequest(
       EdenStats* stats,
       ChannelThreadStats::StatPtr stat,
+      folly::StringPiece operation,
       std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>&
           requestWatches);
 
  private:
+  /**
+   * Calls finishRequest from the destructor of the most derived class, where
+   * the overrides of T that it calls are still usable.
+   */
+  template <typename T>
+  class Finishing final : public T {
+   public:
+    using T::T;
+
+    ~Finishing() override {
+      static_cast<RequestContext*>(this)->finishRequest();
+    }
+  };
+
   void finishRequest() noexcept;
+  void recordIfSlow(
+      SlowRequestLog& slowRequests,
+      std::chrono::microseconds elapsed);
 
   struct EdenTopStats {
    public:
@@ -111,7 +152,9 @@ class RequestContext : public ObjectFetchContext {
   // Needed to track stats
   std::chrono::time_point<std::chrono::steady_clock> startTime_;
   ChannelThreadStats::StatPtr latencyStat_{nullptr};
+  folly::StringPiece operation_;
   EdenStats* stats_{nullptr};
+  std::atomic<uint64_t> backingStoreUs_{0};
   RequestMetricsScope requestMetricsScope_;
   std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>
       channelThreadLocalStats_;
@@ -60,6 +60,7 @@ ServerState::ServerState(
               ? std::make_shared<NfsServer>(
                     mainEventBase,
                     initialConfig.numNfsThreads.getValue(),
+                    initialConfig.numNfsIoThreads.getValue(),
                     initialConfig.maxNfsInflightRequests.getValue(),
                     structuredLogger_)
               :
@@ -69,10 +70,12 @@ ServerState::ServerState(
       config_{std::move(reloadableConfig)},
       userIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
           initialConfig.userIgnoreFile.getValue(),
-          kUserIgnoreMinPollSeconds}},
+          kUserIgnoreMinPollSeconds,
+          /*useWatcher=*/true}},
       systemIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
           initialConfig.systemIgnoreFile.getValue(),
-          kSystemIgnoreMinPollSeconds}},
+          kSystemIgnoreMinPollSeconds,
+          /*useWatcher=*/true}},
       notifier_{std::move(notifier)},
       fsEventLogger_{
           initialConfig.requestSamplesPerMinute.getValue()
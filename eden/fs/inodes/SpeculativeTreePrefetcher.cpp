@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/SpeculativeTreePrefetcher.h"
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Number of counted prefetched trees remembered until they are loaded. Also
+ * the window over which the hit rate is computed: once this many prefetches
+ * have been counted, the counts are halved.
+ */
+constexpr size_t kHitRateWindow = 10000;
+
+/**
+ * The hit rate is not trusted until this many prefetches have been counted.
+ */
+constexpr uint64_t kMinSamples = 500;
+
+/**
+ * While the hit rate is too low, one readdir in this many still prefetches.
+ */
+constexpr uint64_t kProbeInterval = 16;
+
+/**
+ * Maximum number of trees a single readdir prefetches, however wide the
+ * directories below it are.
+ */
+constexpr int64_t kMaxTreesPerPrefetch = 1024;
+
+} // namespace
+
+struct SpeculativeTreePrefetcher::Walk {
+  Walk(uint32_t depth, bool blobMetadata, ObjectFetchContext& context)
+      : depth{depth}, blobMetadata{blobMetadata}, context{context} {}
+
+  const uint32_t depth;
+  const bool blobMetadata;
+  ObjectFetchContext& context;
+  std::atomic<int64_t> budget{kMaxTreesPerPrefetch};
+};
+
+SpeculativeTreePrefetcher::State::State() : pending{kHitRateWindow} {}
+
+SpeculativeTreePrefetcher::SpeculativeTreePrefetcher(
+    std::shared_ptr<ObjectStore> objectStore)
+    : objectStore_{std::move(objectStore)} {}
+
+uint32_t SpeculativeTreePrefetcher::hitRatePercent(const State& state) {
+  if (state.recentPrefetches == 0) {
+    return 100;
+  }
+  return static_cast<uint32_t>(
+      state.recentHits * 100 / state.recentPrefetches);
+}
+
+uint32_t SpeculativeTreePrefetcher::getHitRatePercent() const {
+  return hitRatePercent(*state_.lock());
+}
+
+bool SpeculativeTreePrefetcher::shouldPrefetch(uint32_t minHitRatePercent) {
+  auto state = state_.lock();
+  if (state->recentPrefetches < kMinSamples ||
+      hitRatePercent(*state) >= minHitRatePercent) {
+    state->skipped = 0;
+    return true;
+  }
+  return ++state->skipped % kProbeInterval == 0;
+}
+
+folly::SemiFuture<folly::Unit> SpeculativeTreePrefetcher::prefetch(
+    std::vector<ObjectId> childTreeIds,
+    uint32_t depth,
+    bool blobMetadata,
+    ObjectFetchContext& context) {
+  if (depth == 0 || childTreeIds.empty()) {
+    return folly::makeSemiFuture();
+  }
+
+  auto walk = std::make_shared<Walk>(depth, blobMetadata, context);
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+  for (const auto& id : childTreeIds) {
+    futures.push_back(prefetchTree(walk, id, 1));
+  }
+  return collectAll(std::move(futures)).unit().semi();
+}
+
+ImmediateFuture<folly::Unit> SpeculativeTreePrefetcher::prefetchTree(
+    std::shared_ptr<Walk> walk,
+    const ObjectId& id,
+    uint32_t level) {
+  if (walk->budget.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+    return folly::unit;
+  }
+  if (level >= 2) {
+    recordPrefetch(id);
+  }
+
+  return objectStore_->getTree(id, walk->context)
+      .thenValue([this, walk, level](std::shared_ptr<const Tree> tree) {
+        std::vector<ImmediateFuture<folly::Unit>> futures;
+        for (const auto& entry : tree->getTreeEntries()) {
+          if (entry.isTree()) {
+            if (level < walk->depth) {
+              futures.push_back(
+                  prefetchTree(walk, entry.getHash(), level + 1));
+            }
+          } else if (walk->blobMetadata) {
+            futures.push_back(
+                objectStore_->getBlobMetadata(entry.getHash(), walk->context)
+                    .unit());
+          }
+        }
+        return collectAll(std::move(futures)).unit();
+      });
+}
+
+void SpeculativeTreePrefetcher::recordPrefetch(const ObjectId& id) {
+  prefetchCount_.fetch_add(1, std::memory_order_relaxed);
+  auto state = state_.lock();
+  state->pending.set(id, folly::unit);
+  if (++state->recentPrefetches >= kHitRateWindow) {
+    state->recentPrefetches /= 2;
+    state->recentHits /= 2;
+  }
+}
+
+void SpeculativeTreePrefetcher::recordDemand(const ObjectId& id) {
+  if (getPrefetchCount() == 0) {
+    return;
+  }
+  {
+    auto state = state_.lock();
+    if (!state->pending.erase(id)) {
+      return;
+    }
+    ++state->recentHits;
+  }
+  hitCount_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/futures/Future.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+
+/**
+ * Prefetches the subtrees of a directory after it is listed, on the theory
+ * that tools which list a directory usually recurse into it next, and keeps
+ * track of how often that theory holds.
+ *
+ * A tree prefetched two or more levels below the listed directory counts as
+ * a hit if an inode is later loaded for it. Direct children are not counted,
+ * since readdir already loads them. While the recent hit rate is below the
+ * caller's threshold, only an occasional readdir is let through, so that the
+ * hit rate can recover if the workload changes.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class SpeculativeTreePrefetcher {
+ public:
+  explicit SpeculativeTreePrefetcher(std::shared_ptr<ObjectStore> objectStore);
+
+  /**
+   * Whether a readdir should start a speculative prefetch, given the minimum
+   * acceptable hit rate.
+   */
+  bool shouldPrefetch(uint32_t minHitRatePercent);
+
+  /**
+   * Fetch the trees `childTreeIds`, the subdirectories of a listed
+   * directory, and their subtrees down to `depth` levels below the listed
+   * directory. If `blobMetadata` is set, also fetch the metadata of the files
+   * found along the way.
+   *
+   * `context` must stay alive until the returned future completes. Failures
+   * to fetch individual objects are ignored.
+   */
+  folly::SemiFuture<folly::Unit> prefetch(
+      std::vector<ObjectId> childTreeIds,
+      uint32_t depth,
+      bool blobMetadata,
+      ObjectFetchContext& context);
+
+  /**
+   * Note that an inode was loaded for the tree `id`.
+   */
+  void recordDemand(const ObjectId& id);
+
+  /// Number of trees prefetched that count towards the hit rate.
+  uint64_t getPrefetchCount() const {
+    return prefetchCount_.load(std::memory_order_relaxed);
+  }
+
+  /// Number of counted prefetched trees that were later loaded.
+  uint64_t getHitCount() const {
+    return hitCount_.load(std::memory_order_relaxed);
+  }
+
+  /// Hit rate over recent prefetches, from 0 to 100.
+  uint32_t getHitRatePercent() const;
+
+ private:
+  struct Walk;
+
+  struct State {
+    State();
+
+    /// Counted prefetched trees that have not been loaded yet.
+    folly::EvictingCacheMap<ObjectId, folly::Unit> pending;
+    /// Decaying counts over recent prefetches, for the hit rate.
+    uint64_t recentPrefetches = 0;
+    uint64_t recentHits = 0;
+    /// Readdirs turned away since the hit rate dropped too low.
+    uint64_t skipped = 0;
+  };
+
+  static uint32_t hitRatePercent(const State& state);
+
+  ImmediateFuture<folly::Unit>
+  prefetchTree(std::shared_ptr<Walk> walk, const ObjectId& id, uint32_t level);
+  void recordPrefetch(const ObjectId& id);
+
+  std::shared_ptr<ObjectStore> objectStore_;
+  folly::Synchronized<State, std::mutex> state_;
+  std::atomic<uint64_t> prefetchCount_{0};
+  std::atomic<uint64_t> hitCount_{0};
+};
+
+} // namespace facebook::eden
@@ -30,6 +30,84 @@ std::vector<ChildEntry> parseDirContents(const DirContents& contents) {
   return results;
 }
 
+folly::SemiFuture<folly::Unit> traverseChildrenInParallel(
+    Overlay* overlay,
+    std::vector<ChildEntry> children,
+    RelativePath path,
+    InodeNumber ino,
+    std::optional<ObjectId> hash,
+    uint64_t fsRefcount,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor) {
+  XLOG(DBG7) << "Traversing: " << path;
+  callbacks.visitTreeInode(path, ino, hash, fsRefcount, children);
+
+  std::vector<folly::SemiFuture<folly::Unit>> subtrees;
+  for (auto& entry : children) {
+    if (entry.dtype != dtype_t::Dir || !callbacks.shouldRecurse(entry)) {
+      continue;
+    }
+    auto childPath = path + entry.name;
+    if (auto child = entry.loadedChild.asTreePtrOrNull()) {
+      subtrees.push_back(
+          folly::via(
+              executor,
+              [overlay,
+               child = std::move(child),
+               childPath = std::move(childPath),
+               &callbacks,
+               executor]() mutable {
+                std::vector<ChildEntry> grandchildren;
+                std::optional<ObjectId> childHash;
+                {
+                  auto contents = child->getContents().rlock();
+                  grandchildren = parseDirContents(contents->entries);
+                  childHash = contents->treeHash;
+                }
+                return traverseChildrenInParallel(
+                    overlay,
+                    std::move(grandchildren),
+                    std::move(childPath),
+                    child->getNodeId(),
+                    std::move(childHash),
+                    child->debugGetFsRefcount(),
+                    callbacks,
+                    executor);
+              })
+              .semi());
+    } else if (!entry.loadedChild) {
+      subtrees.push_back(
+          folly::via(
+              executor,
+              [overlay,
+               childIno = entry.ino,
+               childHash = entry.hash,
+               childPath = std::move(childPath),
+               &callbacks,
+               executor]() mutable {
+                // If we are able to load a child directory from the overlay,
+                // then this child entry has been allocated, and can be
+                // traversed.
+                auto contents = overlay->loadOverlayDir(childIno);
+                if (contents.empty()) {
+                  return folly::makeSemiFuture();
+                }
+                return traverseChildrenInParallel(
+                    overlay,
+                    parseDirContents(contents),
+                    std::move(childPath),
+                    childIno,
+                    std::move(childHash),
+                    0,
+                    callbacks,
+                    executor);
+              })
+              .semi());
+    }
+  }
+  return folly::collect(std::move(subtrees)).deferValue([](auto&&) {});
+}
+
 } // namespace
 
 void traverseTreeInodeChildren(
@@ -96,4 +174,33 @@ void traverseObservedInodes(
       callbacks);
 }
 
+folly::SemiFuture<folly::Unit> traverseObservedInodesInParallel(
+    TreeInodePtr root,
+    RelativePath rootPath,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor) {
+  if (!callbacks.canRunConcurrently()) {
+    return folly::makeSemiFutureWith(
+        [&] { traverseObservedInodes(*root, rootPath, callbacks); });
+  }
+
+  std::vector<ChildEntry> children;
+  std::optional<ObjectId> hash;
+  {
+    auto contents = root->getContents().rlock();
+    children = parseDirContents(contents->entries);
+    hash = contents->treeHash;
+  }
+
+  return traverseChildrenInParallel(
+      root->getMount()->getOverlay(),
+      std::move(children),
+      std::move(rootPath),
+      root->getNodeId(),
+      std::move(hash),
+      root->debugGetFsRefcount(),
+      callbacks,
+      std::move(executor));
+}
+
 } // namespace facebook::eden
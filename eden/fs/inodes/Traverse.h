@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <folly/Executor.h>
+#include <folly/futures/Future.h>
 #include <variant>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
@@ -51,6 +53,15 @@ struct TraversalCallbacks {
    * should recurse to the entry's children.
    */
   virtual bool shouldRecurse(const ChildEntry& entry) = 0;
+
+  /**
+   * Whether visitTreeInode() and shouldRecurse() may be called concurrently
+   * from several threads, which lets traverseObservedInodesInParallel() walk
+   * subtrees in parallel.
+   */
+  virtual bool canRunConcurrently() const {
+    return false;
+  }
 };
 
 /**
@@ -70,4 +81,21 @@ void traverseObservedInodes(
     RelativePathPiece rootPath,
     TraversalCallbacks& callbacks);
 
+/**
+ * Like traverseObservedInodes(), but each directory is visited by its own
+ * task on `executor`, so subtrees are walked in parallel and no order is
+ * guaranteed between them. A directory is always visited before its
+ * children.
+ *
+ * Each TreeInode's contents lock is only held while copying its entries.
+ *
+ * Callbacks that cannot run concurrently are called serially, in pre-order,
+ * from the calling thread. `callbacks` must outlive the returned future.
+ */
+folly::SemiFuture<folly::Unit> traverseObservedInodesInParallel(
+    TreeInodePtr root,
+    RelativePath rootPath,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor);
+
 } // namespace facebook::eden
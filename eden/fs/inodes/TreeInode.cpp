@@ -8,6 +8,7 @@
 #include "eden/fs/inodes/TreeInode.h"
 
 #include <boost/polymorphic_cast.hpp>
+#include <folly/CancellationToken.h>
 #include <folly/chrono/Conv.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
@@ -25,9 +26,11 @@
 #include "eden/fs/inodes/InodeMap.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/OverlayFile.h"
+#include "eden/fs/inodes/ReaddirSnapshotCache.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreePrefetchLease.h"
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/model/SerializedTreeView.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
@@ -159,6 +162,21 @@ TreeInode::TreeInode(
           saveDirFromTree(ino, tree.get(), parent->getMount()),
           tree->getHash()) {}
 
+TreeInode::TreeInode(
+    InodeNumber ino,
+    TreeInodePtr parent,
+    PathComponentPiece name,
+    mode_t initialMode,
+    const SerializedTreeView& tree)
+    : TreeInode(
+          ino,
+          parent,
+          name,
+          initialMode,
+          std::nullopt,
+          saveDirFromTree(ino, tree, parent->getMount()),
+          tree.getHash()) {}
+
 TreeInode::TreeInode(
     InodeNumber ino,
     TreeInodePtr parent,
@@ -677,6 +695,7 @@ Future<unique_ptr<InodeBase>> TreeInode::startLoadingInode(
   }
 
   if (!entry.isMaterialized()) {
+    getMount()->getSpeculativeTreePrefetcher().recordDemand(entry.getHash());
     return getStore()
         ->getTree(entry.getHash(), fetchContext)
         .semi()
@@ -880,6 +899,141 @@ void TreeInode::childDematerialized(
   }
 }
 
+namespace {
+/**
+ * Returns whether the entries of a directory are identical to the given
+ * source control Tree, so that the directory doesn't need to be materialized.
+ */
+bool isIdenticalToTree(const DirContents& entries, const Tree& tree) {
+  const auto& scmEntries = tree.getTreeEntries();
+  // If we have a different number of entries we must be different from
+  // the Tree, and therefore must be materialized.
+  if (scmEntries.size() != entries.size()) {
+    return false;
+  }
+
+  // This code relies on the fact that our entries PathMap sorts paths in the
+  // same order as Tree's entry list.
+  auto inodeIter = entries.begin();
+  auto scmIter = scmEntries.begin();
+  for (; scmIter != scmEntries.end(); ++inodeIter, ++scmIter) {
+    // If any of our children are materialized, we need to be materialized
+    // too to record the fact that we have materialized children.
+    //
+    // If our children are materialized this means they are likely
+    // different from the source control state.  (This is not a 100%
+    // guarantee though, as writes may still be happening concurrently.)
+    // Even if the child is still identical to its source control state we
+    // still want to make sure we are materialized if the child is.
+    if (inodeIter->second.isMaterialized()) {
+      return false;
+    }
+
+    // If the child is not materialized, it is the same as some source
+    // control object.  However, if it isn't the same as the object in our
+    // Tree, we have to materialize ourself.
+    if (inodeIter->first != scmIter->getName() ||
+        inodeIter->second.getHash() != scmIter->getHash()) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+ImmediateFuture<size_t> TreeInode::dematerializeUnchanged(
+    ObjectId scmHash,
+    ObjectFetchContext& context,
+    folly::CancellationToken cancel) {
+  // Trees synthesized without an ID, such as by setPathRootId, cannot be
+  // referred to once dematerialized.
+  if (cancel.isCancellationRequested() || scmHash.size() == 0 ||
+      !contents_.rlock()->isMaterialized()) {
+    return size_t{0};
+  }
+
+  return getMount()
+      ->getObjectStore()
+      ->getTree(scmHash, context)
+      .thenValue([self = inodePtrFromThis(), &context, cancel](
+                     std::shared_ptr<const Tree> tree) {
+        // Start with the materialized subdirectories that still have a
+        // source control counterpart, as we can only be dematerialized once
+        // all of them are.
+        std::vector<ImmediateFuture<size_t>> childFutures;
+        {
+          auto contents = self->contents_.rlock();
+          for (const auto& scmEntry : tree->getTreeEntries()) {
+            if (!scmEntry.isTree()) {
+              continue;
+            }
+            auto iter = contents->entries.find(scmEntry.getName());
+            if (iter == contents->entries.end() ||
+                !iter->second.isDirectory() ||
+                !iter->second.isMaterialized()) {
+              continue;
+            }
+            childFutures.push_back(
+                self->getOrLoadChildTree(scmEntry.getName(), context)
+                    .thenValue([childHash = scmEntry.getHash(),
+                                &context,
+                                cancel](TreeInodePtr child) {
+                      return child->dematerializeUnchanged(
+                          childHash, context, cancel);
+                    }));
+          }
+        }
+
+        return collectAll(std::move(childFutures))
+            .thenValue([self, tree = std::move(tree), cancel](
+                           std::vector<folly::Try<size_t>> results) {
+              size_t count = 0;
+              for (auto& result : results) {
+                if (result.hasException()) {
+                  // The child may have been removed or renamed since we
+                  // looked at it, it is simply left alone.
+                  XLOG(DBG3) << "unable to dematerialize a child of "
+                             << self->getLogPath() << ": "
+                             << result.exception().what();
+                  continue;
+                }
+                count += result.value();
+              }
+              if (!cancel.isCancellationRequested() &&
+                  self->dematerializeIfIdentical(*tree)) {
+                ++count;
+              }
+              return count;
+            });
+      });
+}
+
+bool TreeInode::dematerializeIfIdentical(const Tree& tree) {
+  auto renameLock = getMount()->acquireRenameLock();
+  auto location = getLocationInfo(renameLock);
+  if (location.unlinked) {
+    return false;
+  }
+
+  {
+    auto contents = contents_.wlock();
+    if (!contents->isMaterialized() ||
+        !isIdenticalToTree(contents->entries, tree)) {
+      return false;
+    }
+    XLOG(DBG4) << "dematerializing " << getLogPath() << " to "
+               << tree.getHash();
+    contents->treeHash = tree.getHash();
+    saveOverlayDir(contents->entries);
+  }
+
+  if (location.parent) {
+    location.parent->childDematerialized(
+        renameLock, location.name, tree.getHash());
+  }
+  return true;
+}
+
 Overlay* TreeInode::getOverlay() const {
   return getMount()->getOverlay();
 }
@@ -910,6 +1064,17 @@ DirContents TreeInode::saveDirFromTree(
   return dir;
 }
 
+DirContents TreeInode::saveDirFromTree(
+    InodeNumber inodeNumber,
+    const SerializedTreeView& tree,
+    EdenMount* mount) {
+  auto overlay = mount->getOverlay();
+  auto dir = buildDirFromTree(
+      tree, overlay, mount->getCheckoutConfig()->getCaseSensitive());
+  overlay->saveOverlayDir(inodeNumber, dir);
+  return dir;
+}
+
 DirContents TreeInode::buildDirFromTree(
     const Tree* tree,
     Overlay* overlay,
@@ -933,6 +1098,24 @@ DirContents TreeInode::buildDirFromTree(
   return dir;
 }
 
+DirContents TreeInode::buildDirFromTree(
+    const SerializedTreeView& tree,
+    Overlay* overlay,
+    CaseSensitivity caseSensitive) {
+  DirContents dir(caseSensitive);
+  // Names are copied straight out of the serialized buffer into the
+  // DirContents keys, so no TreeEntry is ever built.
+  for (size_t i = 0; i < tree.size(); ++i) {
+    auto treeEntry = tree[i];
+    dir.emplace(
+        treeEntry.getName(),
+        modeFromTreeEntryType(treeEntry.getType()),
+        overlay->allocateInodeNumber(),
+        treeEntry.getHash());
+  }
+  return dir;
+}
+
 FileInodePtr TreeInode::createImpl(
     folly::Synchronized<TreeInodeState>::LockedPtr contents,
     PathComponentPiece name,
@@ -1259,6 +1442,7 @@ void TreeInode::removeAllChildrenRecursively(
     }
     // Erase from contents must happen right after markUnlink
     it = contents->entries.erase(it);
+    getMount()->getPathInodeCache().invalidate();
 
     if (isDir) {
       getOverlay()->recursivelyRemoveOverlayData(inodeNum);
@@ -1298,6 +1482,7 @@ InodePtr TreeInode::tryRemoveUnloadedChild(
   }
 
   contents->entries.erase(it);
+  getMount()->getPathInodeCache().invalidate();
   if (InvalidationRequired::Yes == invalidate) {
     invalidateChannelEntryCache(*contents, inodeName, inodeNumber)
         .throwUnlessValue();
@@ -1518,6 +1703,7 @@ int TreeInode::tryRemoveChild(
 
     // Remove it from our entries list
     contents->entries.erase(entIter);
+    getMount()->getPathInodeCache().invalidate();
 
     // We want to update mtime and ctime of parent directory after removing the
     // child.
@@ -1674,6 +1860,10 @@ ImmediateFuture<Unit> TreeInode::rename(
 #endif
   validatePathComponentLength(destName);
 
+  if (auto result = tryRenameFile(name, destParent, destName, invalidate)) {
+    return std::move(*result);
+  }
+
   bool needSrc = false;
   bool needDest = false;
   {
@@ -1805,8 +1995,151 @@ bool isAncestor(const RenameLock& renameLock, TreeInode* a, TreeInode* b) {
   }
   return false;
 }
+
+size_t getDepth(const SharedRenameLock& renameLock, TreeInode* tree) {
+  size_t depth = 0;
+  for (auto parent = tree->getParent(renameLock); parent;
+       parent = parent->getParent(renameLock)) {
+    ++depth;
+  }
+  return depth;
+}
+
+void recordRenameInJournal(
+    TreeInode* srcParent,
+    PathComponentPiece srcName,
+    TreeInode* destParent,
+    PathComponentPiece destName,
+    bool replaced) {
+  auto srcPath = srcParent->getPath();
+  auto destPath = destParent->getPath();
+  if (srcPath.has_value() && destPath.has_value()) {
+    auto& journal = srcParent->getMount()->getJournal();
+    if (replaced) {
+      journal.recordReplaced(
+          srcPath.value() + srcName, destPath.value() + destName);
+    } else {
+      journal.recordRenamed(
+          srcPath.value() + srcName, destPath.value() + destName);
+    }
+  }
+}
 } // namespace
 
+std::optional<ImmediateFuture<Unit>> TreeInode::tryRenameFile(
+    PathComponentPiece name,
+    const TreeInodePtr& destParent,
+    PathComponentPiece destName,
+    InvalidationRequired invalidate) {
+  auto renameLock = getMount()->acquireSharedRenameLock();
+  if (isUnlinked() || destParent->isUnlinked()) {
+    return std::nullopt;
+  }
+
+  // Directories only move while the rename lock is held exclusively, so
+  // their depths can't change now. Locking the shallower directory first,
+  // and otherwise the one with the lower inode number, locks ancestors
+  // before their descendants like everything else does, and locks any two
+  // directories in the same order in every concurrent rename.
+  folly::Synchronized<TreeInodeState>::LockedPtr srcLock;
+  folly::Synchronized<TreeInodeState>::LockedPtr destLock;
+  if (destParent.get() == this) {
+    srcLock = contents_.wlock();
+  } else {
+    auto srcOrder = std::make_pair(getDepth(renameLock, this), getNodeId());
+    auto destOrder = std::make_pair(
+        getDepth(renameLock, destParent.get()), destParent->getNodeId());
+    if (srcOrder < destOrder) {
+      srcLock = contents_.wlock();
+      destLock = destParent->contents_.wlock();
+    } else {
+      destLock = destParent->contents_.wlock();
+      srcLock = contents_.wlock();
+    }
+  }
+  auto& srcState = *srcLock;
+  auto& destState = destLock ? *destLock : *srcLock;
+
+  if (!srcState.isMaterialized() || !destState.isMaterialized()) {
+    return std::nullopt;
+  }
+  auto srcIter = srcState.entries.find(name);
+  if (srcIter == srcState.entries.end() || srcIter->second.isDirectory() ||
+      !srcIter->second.getInode()) {
+    return std::nullopt;
+  }
+  auto destIter = destState.entries.find(destName);
+  bool destChildExists = destIter != destState.entries.end();
+  if (destChildExists &&
+      (destIter->second.isDirectory() || !destIter->second.getInode())) {
+    return std::nullopt;
+  }
+  auto* childInode = srcIter->second.getInode();
+  if (destChildExists && destIter->second.getInode() == childInode) {
+    return ImmediateFuture<Unit>{folly::unit};
+  }
+
+  if (InvalidationRequired::Yes == invalidate) {
+    invalidateChannelEntryCache(
+        srcState, name, srcIter->second.getInodeNumber())
+        .throwUnlessValue();
+    destParent->invalidateChannelEntryCache(destState, destName, std::nullopt)
+        .throwUnlessValue();
+
+    invalidateChannelDirCache(srcState).get();
+    if (destParent.get() != this) {
+      destParent->invalidateChannelDirCache(destState).get();
+    }
+  }
+
+  std::unique_ptr<InodeBase> deletedInode;
+  if (destChildExists) {
+    deletedInode = destIter->second.getInode()->markUnlinked(
+        destParent.get(), destName, renameLock);
+    destIter->second = std::move(srcIter->second);
+  } else {
+    auto ret = destState.entries.emplace(destName, std::move(srcIter->second));
+    XCHECK(ret.second);
+    if (destParent.get() == this) {
+      srcIter = srcState.entries.find(name);
+    }
+  }
+  childInode->updateLocation(destParent, destName, renameLock);
+  srcState.entries.erase(srcIter);
+  getMount()->getPathInodeCache().invalidate();
+
+  auto now = getNow();
+  updateMtimeAndCtimeLocked(srcState.entries, now);
+  if (destParent.get() != this) {
+    destParent->updateMtimeAndCtimeLocked(destState.entries, now);
+  }
+
+  getOverlay()->renameChild(
+      getNodeId(),
+      destParent->getNodeId(),
+      name,
+      destName,
+      srcState.entries,
+      destState.entries);
+
+  // Unlike doRename(), other renames may run concurrently, so the journal
+  // entry is recorded before the directories are unlocked. This keeps it in
+  // order with the entries of any other change to the same names.
+  recordRenameInJournal(
+      this, name, destParent.get(), destName, destChildExists);
+
+  // As in doRename(), destroy the replaced inode only after releasing the
+  // locks.
+  srcLock.unlock();
+  if (destLock) {
+    destLock.unlock();
+  }
+  renameLock.unlock();
+  deletedInode.reset();
+
+  return ImmediateFuture<Unit>{folly::unit};
+}
+
 ImmediateFuture<Unit> TreeInode::doRename(
     TreeRenameLocks&& locks,
     PathComponentPiece srcName,
@@ -1890,6 +2223,7 @@ ImmediateFuture<Unit> TreeInode::doRename(
 
   // Now remove the source information
   locks.srcContents()->erase(srcIter);
+  getMount()->getPathInodeCache().invalidate();
 
   auto now = getNow();
   updateMtimeAndCtimeLocked(*locks.srcContents(), now);
@@ -1912,17 +2246,8 @@ ImmediateFuture<Unit> TreeInode::doRename(
   locks.releaseAllButRename();
 
   // Add a journal entry
-  auto srcPath = getPath();
-  auto destPath = destParent->getPath();
-  if (srcPath.has_value() && destPath.has_value()) {
-    if (destChildExists) {
-      getMount()->getJournal().recordReplaced(
-          srcPath.value() + srcName, destPath.value() + destName);
-    } else {
-      getMount()->getJournal().recordRenamed(
-          srcPath.value() + srcName, destPath.value() + destName);
-    }
-  }
+  recordRenameInJournal(
+      this, srcName, destParent.get(), destName, destChildExists);
 
   // Release the rename lock before we destroy the deleted destination child
   // inode (if it exists).
@@ -2011,7 +2336,11 @@ void TreeInode::TreeRenameLocks::lockDestChild(PathComponentPiece destName) {
 
 #ifndef _WIN32
 template <typename Fn>
-bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
+bool TreeInode::readdirImpl(
+    off_t off,
+    const ReaddirSnapshot* snapshot,
+    ObjectFetchContext& context,
+    Fn add) {
   /*
    * Implementing readdir correctly in the presence of concurrent modifications
    * to the directory is nontrivial. This function will be called multiple
@@ -2040,6 +2369,9 @@ bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
    * inode-sorted list of entries. This has quadratic time complexity without an
    * additional index but is correct.
    *
+   * NFS listings avoid the quadratic cost by paging through a snapshot of the
+   * entries sorted by inode number, taken at the start of the listing.
+   *
    * In the long term, especially when Eden's tree directory structure is stored
    * in SQLite or something similar, we should maintain a seekdir/readdir cookie
    * index and use said cookies to enumerate entries.
@@ -2061,6 +2393,7 @@ bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
   // return early if the metadata for this inode's children has already been
   // prefetched.
   prefetch(context);
+  speculativePrefetch(context);
 
   // Possible offset values are:
   //   0: start at the beginning
@@ -2069,7 +2402,7 @@ bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
   //   2+N: start after inode N
 
   if (off == 0) {
-    if (!add(".", DirEntry{dtype_to_mode(dtype_t::Dir), getNodeId()}, 1)) {
+    if (!add(".", getNodeId(), dtype_t::Dir, 1)) {
       return false;
     }
   }
@@ -2081,11 +2414,57 @@ bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
     // For the root of the mount point, just add its own inode ID as its parent.
     // FUSE seems to overwrite the parent inode number on the root dir anyway.
     auto parentNodeId = parent ? parent->getNodeId() : getNodeId();
-    if (!add("..", DirEntry{dtype_to_mode(dtype_t::Dir), parentNodeId}, 2)) {
+    if (!add("..", parentNodeId, dtype_t::Dir, 2)) {
       return false;
     }
   }
 
+  if (snapshot) {
+    // Continue after the entry with the offset `off`.
+    auto& snapshotEntries = snapshot->entries;
+    auto it = std::upper_bound(
+        snapshotEntries.begin(),
+        snapshotEntries.end(),
+        off,
+        [](off_t offset, const ReaddirSnapshot::Entry& entry) {
+          return offset < static_cast<off_t>(entry.ino.get() + 2);
+        });
+
+    // Check batches of entries against the current contents, and only add
+    // them, which may allocate, once the contents lock is released. The
+    // snapshot owns the names, so they don't need to be copied.
+    constexpr size_t kBatchSize = 64;
+    std::vector<const ReaddirSnapshot::Entry*> batch;
+    batch.reserve(kBatchSize);
+    while (it != snapshotEntries.end()) {
+      batch.clear();
+      {
+        auto dir = contents_.rlock();
+        auto& entries = dir->entries;
+        for (; it != snapshotEntries.end() && batch.size() < kBatchSize;
+             ++it) {
+          auto found = entries.find(it->name);
+          // Skip the entries that were removed or renamed since the snapshot
+          // was taken.
+          if (found != entries.end() &&
+              found->second.getInodeNumber() == it->ino &&
+              found->first == it->name) {
+            batch.push_back(&*it);
+          }
+        }
+      }
+      for (auto* entry : batch) {
+        if (!add(entry->name.stringPiece(),
+                 entry->ino,
+                 entry->type,
+                 entry->ino.get() + 2)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
   auto dir = contents_.rlock();
   auto& entries = dir->entries;
 
@@ -2109,7 +2488,11 @@ bool TreeInode::readdirImpl(off_t off, ObjectFetchContext& context, Fn add) {
     auto& [name, entry] = entries.begin()[indices.back().second];
     indices.pop_back();
 
-    if (!add(name.stringPiece(), entry, entry.getInodeNumber().get() + 2)) {
+    if (!add(
+            name.stringPiece(),
+            entry.getInodeNumber(),
+            entry.getDtype(),
+            entry.getInodeNumber().get() + 2)) {
       break;
     }
   }
@@ -2123,10 +2506,11 @@ FuseDirList TreeInode::fuseReaddir(
     ObjectFetchContext& context) {
   readdirImpl(
       off,
+      nullptr,
       context,
-      [&list](StringPiece name, const DirEntry& entry, uint64_t offset) {
-        return list.add(
-            name, entry.getInodeNumber().get(), entry.getDtype(), offset);
+      [&list](
+          StringPiece name, InodeNumber ino, dtype_t type, uint64_t offset) {
+        return list.add(name, ino.get(), type, offset);
       });
 
   return std::move(list);
@@ -2135,17 +2519,38 @@ FuseDirList TreeInode::fuseReaddir(
 std::tuple<NfsDirList, bool> TreeInode::nfsReaddir(
     NfsDirList&& list,
     off_t off,
+    const ReaddirSnapshot& snapshot,
     ObjectFetchContext& context) {
   updateAtime();
   bool isEof = readdirImpl(
       off,
+      &snapshot,
       context,
-      [&list](StringPiece name, const DirEntry& entry, uint64_t offset) {
-        return list.add(name, entry.getInodeNumber(), offset);
+      [&list](StringPiece name, InodeNumber ino, dtype_t, uint64_t offset) {
+        return list.add(name, ino, offset);
       });
 
   return {std::move(list), isEof};
 }
+
+std::shared_ptr<const ReaddirSnapshot> TreeInode::takeReaddirSnapshot() {
+  auto snapshot = std::make_shared<ReaddirSnapshot>();
+  {
+    auto dir = contents_.rlock();
+    snapshot->entries.reserve(dir->entries.size());
+    for (const auto& [name, entry] : dir->entries) {
+      snapshot->entries.push_back(ReaddirSnapshot::Entry{
+          entry.getInodeNumber(), entry.getDtype(), name});
+    }
+  }
+  std::sort(
+      snapshot->entries.begin(),
+      snapshot->entries.end(),
+      [](const ReaddirSnapshot::Entry& a, const ReaddirSnapshot::Entry& b) {
+        return a.ino < b.ino;
+      });
+  return snapshot;
+}
 #endif // _WIN32
 
 InodeMap* TreeInode::getInodeMap() const {
@@ -2252,6 +2657,23 @@ Future<Unit> TreeInode::diff(
           isIgnored);
     }
 
+    // An unmodified .gitignore file may already have been parsed, here or in
+    // another directory with an identical one.
+    if (!gitignoreEntry->isMaterialized() &&
+        gitignoreEntry->getDtype() == dtype_t::Regular) {
+      if (auto ignore =
+              getMount()->getGitIgnoreCache().get(gitignoreEntry->getHash())) {
+        XLOG(DBG7) << "Using cached ignore file for " << getLogPath();
+        return computeDiff(
+            std::move(contents),
+            context,
+            currentPath,
+            std::move(tree),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
+            isIgnored);
+      }
+    }
+
     XLOG(DBG7) << "Loading ignore file for " << getLogPath();
     inode = gitignoreEntry->getInodePtr();
     if (!inode) {
@@ -2304,24 +2726,43 @@ Future<Unit> TreeInode::loadGitIgnoreThenDiff(
     shared_ptr<const Tree> tree,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
+  // Only the contents of unmodified regular files can be cached by blob ID.
+  auto gitignoreFile = gitignoreInode.asFilePtrOrNull();
+  std::optional<ObjectId> blobHash;
+  if (gitignoreFile && gitignoreFile->getType() == dtype_t::Regular) {
+    blobHash = gitignoreFile->getBlobHash();
+  }
+
   return getMount()
       ->loadFileContents(context->getFetchContext(), gitignoreInode)
+      .thenValue([mount = getMount(), gitignoreFile, blobHash](
+                     std::string&& ignoreFileContents) {
+        // Make sure the file wasn't modified while it was being read.
+        if (blobHash && gitignoreFile->getBlobHash() == blobHash) {
+          return mount->getGitIgnoreCache().insert(
+              *blobHash, ignoreFileContents);
+        }
+        auto ignore = std::make_shared<GitIgnore>();
+        ignore->loadFile(ignoreFileContents);
+        return std::shared_ptr<const GitIgnore>{std::move(ignore)};
+      })
       .thenError([](const folly::exception_wrapper& ex) {
         XLOG(WARN) << "error reading ignore file: " << folly::exceptionStr(ex);
-        return std::string{};
+        return std::shared_ptr<const GitIgnore>{std::make_shared<GitIgnore>()};
       })
       .thenValue([self = inodePtrFromThis(),
                   context,
                   currentPath = RelativePath{currentPath}, // deep copy
                   tree,
                   parentIgnore,
-                  isIgnored](std::string&& ignoreFileContents) mutable {
+                  isIgnored](
+                     std::shared_ptr<const GitIgnore>&& ignore) mutable {
         return self->computeDiff(
             self->contents_.wlock(),
             context,
             currentPath,
             std::move(tree),
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
             isIgnored);
       });
 }
@@ -2362,6 +2803,8 @@ Future<Unit> TreeInode::computeDiff(
       << "the ignore stack is required if this directory is not ignored";
 
   std::vector<std::unique_ptr<DeferredDiffEntry>> deferredEntries;
+  // Blobs whose metadata the deferred entries will need to compare files.
+  std::vector<ObjectId> blobsToCompare;
   auto self = inodePtrFromThis();
 
   // Grab the contents_ lock, and loop to find children that might be
@@ -2390,6 +2833,9 @@ Future<Unit> TreeInode::computeDiff(
       auto fileType = inodeEntry->isDirectory() ? GitIgnore::TYPE_DIR
                                                 : GitIgnore::TYPE_FILE;
       auto entryPath = currentPath + name;
+      if (!context->shouldDiffPath(entryPath)) {
+        return;
+      }
       if (!isIgnored) {
         auto ignoreStatus = ignore->match(entryPath, fileType);
         if (ignoreStatus == GitIgnore::HIDDEN) {
@@ -2455,12 +2901,15 @@ Future<Unit> TreeInode::computeDiff(
     };
 
     auto processRemoved = [&](const TreeEntry& scmEntry) {
-      XLOG(DBG5) << "diff: removed file: " << currentPath + scmEntry.getName();
-      context->callback->removedPath(
-          currentPath + scmEntry.getName(), scmEntry.getDType());
+      auto entryPath = currentPath + scmEntry.getName();
+      if (!context->shouldDiffPath(entryPath)) {
+        return;
+      }
+      XLOG(DBG5) << "diff: removed file: " << entryPath;
+      context->callback->removedPath(entryPath, scmEntry.getDType());
       if (scmEntry.isTree()) {
         deferredEntries.emplace_back(DeferredDiffEntry::createRemovedScmEntry(
-            context, currentPath + scmEntry.getName(), scmEntry.getHash()));
+            context, entryPath, scmEntry.getHash()));
       }
     };
 
@@ -2471,6 +2920,9 @@ Future<Unit> TreeInode::computeDiff(
       // is always included since it is already tracked in source control.
       bool entryIgnored = isIgnored;
       auto entryPath = currentPath + scmEntry.getName();
+      if (!context->shouldDiffPath(entryPath)) {
+        return;
+      }
       if (!isIgnored && (inodeEntry->isDirectory() || scmEntry.isTree())) {
         auto fileType = inodeEntry->isDirectory() ? GitIgnore::TYPE_DIR
                                                   : GitIgnore::TYPE_FILE;
@@ -2490,16 +2942,24 @@ Future<Unit> TreeInode::computeDiff(
       if (inodeEntry->getInode()) {
         // This inode is already loaded.
         auto childInodePtr = inodeEntry->getInodePtr();
+        bool materialized = inodeEntry->isMaterialized();
+        if (materialized && !scmEntry.isTree() && !inodeEntry->isDirectory()) {
+          blobsToCompare.push_back(scmEntry.getHash());
+        }
         deferredEntries.emplace_back(DeferredDiffEntry::createModifiedEntry(
             context,
             entryPath,
             scmEntry,
             std::move(childInodePtr),
             ignore.get(),
-            entryIgnored));
+            entryIgnored,
+            materialized));
       } else if (inodeEntry->isMaterialized()) {
         // This inode is not loaded but is materialized.
         // We'll have to load it to confirm if it is the same or different.
+        if (!scmEntry.isTree() && !inodeEntry->isDirectory()) {
+          blobsToCompare.push_back(scmEntry.getHash());
+        }
         auto inodeFuture = self->loadChildLocked(
             contents->entries,
             scmEntry.getName(),
@@ -2578,6 +3038,8 @@ Future<Unit> TreeInode::computeDiff(
           // parent TreeInode::Entry and the TreeEntry.  Once we have file
           // sizes, we could check for differing file sizes first, and
           // avoid loading the blob if they are different.
+          blobsToCompare.push_back(scmEntry.getHash());
+          blobsToCompare.push_back(inodeEntry->getHash());
           deferredEntries.emplace_back(DeferredDiffEntry::createModifiedEntry(
               context,
               entryPath,
@@ -2641,35 +3103,49 @@ Future<Unit> TreeInode::computeDiff(
     load.finish();
   }
 
-  // Now process all of the deferred work.
-  vector<Future<Unit>> deferredFutures;
-  for (auto& entry : deferredEntries) {
-    deferredFutures.push_back(entry->run());
-  }
-
-  // Wait on all of the deferred entries to complete.
-  // Note that we explicitly move-capture the deferredFutures vector into this
-  // callback, to ensure that the DeferredDiffEntry objects do not get
-  // destroyed before they complete.
-  return folly::collectAll(deferredFutures)
-      .toUnsafeFuture()
+  // Look up the metadata of all the blobs the deferred entries compare in a
+  // single batch rather than one at a time. Failing to do so only means the
+  // entries will look it up themselves.
+  auto metadataFuture = blobsToCompare.empty()
+      ? makeFuture()
+      : context->store->prefetchBlobMetadata(std::move(blobsToCompare))
+            .thenTry([](folly::Try<Unit>&&) {})
+            .semi()
+            .via(&folly::QueuedImmediateExecutor::instance());
+
+  // Now process all of the deferred work, and wait on all of the deferred
+  // entries to complete.
+  // Note that we explicitly capture the deferred entries in these callbacks,
+  // to ensure that the DeferredDiffEntry objects do not get destroyed before
+  // they complete.
+  auto deferredJobs =
+      std::make_shared<std::vector<std::unique_ptr<DeferredDiffEntry>>>(
+          std::move(deferredEntries));
+  return std::move(metadataFuture)
+      .thenValue([deferredJobs](Unit) {
+        vector<Future<Unit>> deferredFutures;
+        for (auto& entry : *deferredJobs) {
+          deferredFutures.push_back(entry->run());
+        }
+        return folly::collectAll(deferredFutures).toUnsafeFuture();
+      })
       .thenValue([self = std::move(self),
                   currentPath = RelativePath{std::move(currentPath)},
                   context,
                   // Capture ignore to ensure it remains valid until all of our
                   // children's diff operations complete.
                   ignore = std::move(ignore),
-                  deferredJobs = std::move(deferredEntries)](
+                  deferredJobs = std::move(deferredJobs)](
                      vector<folly::Try<Unit>> results) {
         // Call diffError() for any jobs that failed.
         for (size_t n = 0; n < results.size(); ++n) {
           auto& result = results[n];
           if (result.hasException()) {
             XLOG(WARN) << "exception processing diff for "
-                       << deferredJobs[n]->getPath() << ": "
+                       << (*deferredJobs)[n]->getPath() << ": "
                        << folly::exceptionStr(result.exception());
             context->callback->diffError(
-                deferredJobs[n]->getPath(), result.exception());
+                (*deferredJobs)[n]->getPath(), result.exception());
           }
         }
         // Report success here, even if some of our deferred jobs failed.
@@ -2776,8 +3252,11 @@ Future<Unit> TreeInode::checkout(
             if (fut.isReady()) {
               return folly::makeFuture(std::move(fut).getTry());
             } else {
+              // Checkout is bulk work, queue it behind interactive requests.
               return std::move(fut).semi().via(
-                  self->getMount()->getServerThreadPool().get());
+                  self->getMount()
+                      ->getServerThreadPool()
+                      ->getLowPriorityExecutor());
             }
           });
 }
@@ -2807,6 +3286,12 @@ bool TreeInode::canShortCircuitCheckout(
     return false;
   }
 
+  // A resumed checkout is done with the directories that the interrupted
+  // one already brought to the desired destination state.
+  if (ctx->isResuming()) {
+    return true;
+  }
+
   // If we still here we are already in the desired destination state.
   // If there is no fromTree then the only possible conflicts are
   // UNTRACKED_ADDED conflicts, but since we are already in the desired
@@ -2975,9 +3460,12 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
       // tree.  It has already been removed from the local filesystem, so
       // we are already in the desired state.
       //
-      // We can proceed, but we still flag this as a conflict.
-      ctx->addConflict(
-          ConflictType::MISSING_REMOVED, this, oldScmEntry->getName());
+      // We can proceed, but we still flag this as a conflict, unless the
+      // interrupted checkout that we resume removed it.
+      if (!ctx->isResuming()) {
+        ctx->addConflict(
+            ConflictType::MISSING_REMOVED, this, oldScmEntry->getName());
+      }
     } else {
       // The file was removed locally, but modified in the new tree.
       ctx->addConflict(
@@ -3014,6 +3502,13 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
   }
 
   auto& entry = it->second;
+  if (ctx->isResuming() && newScmEntry && !entry.isMaterialized() &&
+      entry.getHash() == newScmEntry->getHash() &&
+      entry.getInitialMode() == modeFromTreeEntryType(newScmEntry->getType())) {
+    // The interrupted checkout that we resume already updated this entry.
+    return nullptr;
+  }
+
   if (auto childPtr = entry.getInodePtr()) {
     // If the inode is already loaded, create a CheckoutAction to process it
     return make_unique<CheckoutAction>(
@@ -3109,6 +3604,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
   // This logic could potentially be unified with TreeInode::tryRemoveChild
   // and TreeInode::checkoutUpdateEntry.
   contents.erase(it);
+  getMount()->getPathInodeCache().invalidate();
   if (newScmEntry) {
     contents.emplace(
         newScmEntry->getName(),
@@ -3196,6 +3692,7 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
       // entry as desired.
       deletedInode = inode->markUnlinked(this, it->first, ctx->renameLock());
       contents->entries.erase(it);
+      getMount()->getPathInodeCache().invalidate();
 
       if (newScmEntry) {
         auto [it, inserted] = contents->entries.emplace(
@@ -3213,6 +3710,12 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
     return InvalidationRequired::Yes;
   }
 
+  if (ctx->isCancelled()) {
+    // Leave this directory as it is, for the checkout to update when it is
+    // resumed.
+    return makeFuture<InvalidationRequired>(folly::OperationCancelled{});
+  }
+
   // If we are going from a directory to a directory, all we need to do
   // is call checkout().
   if (newTree) {
@@ -3455,39 +3958,10 @@ void TreeInode::saveOverlayPostCheckout(
         return std::nullopt;
       }
 
-      const auto& scmEntries = tree->getTreeEntries();
-      // If we have a different number of entries we must be different from
-      // the Tree, and therefore must be materialized.
-      if (scmEntries.size() != contents->entries.size()) {
+      if (!isIdenticalToTree(contents->entries, *tree)) {
         return std::nullopt;
       }
 
-      // This code relies on the fact that our contents->entries PathMap sorts
-      // paths in the same order as Tree's entry list.
-      auto inodeIter = contents->entries.begin();
-      auto scmIter = scmEntries.begin();
-      for (; scmIter != scmEntries.end(); ++inodeIter, ++scmIter) {
-        // If any of our children are materialized, we need to be materialized
-        // too to record the fact that we have materialized children.
-        //
-        // If our children are materialized this means they are likely
-        // different from the new source control state.  (This is not a 100%
-        // guarantee though, as writes may still be happening concurrently to
-        // the checkout operation.)  Even if the child is still identical to
-        // its source control state we still want to make sure we are
-        // materialized if the child is.
-        if (inodeIter->second.isMaterialized()) {
-          return std::nullopt;
-        }
-
-        // If the child is not materialized, it is the same as some source
-        // control object.  However, if it isn't the same as the object in our
-        // Tree, we have to materialize ourself.
-        if (inodeIter->second.getHash() != scmIter->getHash()) {
-          return std::nullopt;
-        }
-      }
-
       // TODO: This check should be removed and instead a
       // std::optional<ObjectId> should be passed to
       // TreeInode::saveoverlayPostCheckout. The issue is that setPathRootId
@@ -3821,7 +4295,7 @@ void TreeInode::prefetch(ObjectFetchContext& context) {
   XLOG(DBG4) << "starting prefetch for " << getLogPath();
 
   folly::via(
-      getMount()->getServerThreadPool().get(),
+      getMount()->getServerThreadPool()->getLowPriorityExecutor(),
       [lease = std::move(*prefetchLease)]() mutable {
         // prefetch() is called by readdir, under the assumption that a series
         // of stat calls on its entries will follow. (e.g. `ls -l` or `find
@@ -3875,6 +4349,74 @@ void TreeInode::prefetch(ObjectFetchContext& context) {
       });
 }
 
+void TreeInode::speculativePrefetch(ObjectFetchContext& context) {
+  auto* checkoutConfig = getMount()->getCheckoutConfig();
+  auto depth = checkoutConfig->getSpeculativeTreePrefetchDepth();
+  if (depth == 0) {
+    return;
+  }
+  bool expected = false;
+  if (!speculativelyPrefetched_.compare_exchange_strong(expected, true)) {
+    return;
+  }
+
+  auto& prefetcher = getMount()->getSpeculativeTreePrefetcher();
+  auto config = getMount()->getServerState()->getEdenConfig();
+  if (!prefetcher.shouldPrefetch(
+          config->speculativePrefetchMinHitRatePercent.getValue())) {
+    XLOG(DBG4) << "skipping speculative prefetch for " << getLogPath()
+               << ": hit rate is too low";
+    return;
+  }
+
+  std::vector<ObjectId> childTreeIds;
+  {
+    auto contents = contents_.rlock();
+    for (auto& entry : contents->entries) {
+      if (entry.second.isDirectory() && !entry.second.isMaterialized()) {
+        childTreeIds.push_back(entry.second.getHash());
+      }
+    }
+  }
+  if (childTreeIds.empty()) {
+    return;
+  }
+
+  auto prefetchLease =
+      getMount()->tryStartTreePrefetch(inodePtrFromThis(), context);
+  if (!prefetchLease) {
+    XLOG(DBG3) << "skipping speculative prefetch for " << getLogPath()
+               << ": too many prefetches already in progress";
+    speculativelyPrefetched_.store(false);
+    return;
+  }
+  XLOG(DBG4) << "starting speculative prefetch for " << getLogPath();
+
+  folly::via(
+      getMount()->getServerThreadPool()->getLowPriorityExecutor(),
+      [lease = std::move(*prefetchLease),
+       childTreeIds = std::move(childTreeIds),
+       depth,
+       blobMetadata =
+           checkoutConfig->getSpeculativePrefetchBlobMetadata()]() mutable {
+        // The lease keeps this inode, and therefore the mount and its
+        // prefetcher, alive until the prefetch completes.
+        auto& prefetcher =
+            lease.getTreeInode()->getMount()->getSpeculativeTreePrefetcher();
+        return prefetcher
+            .prefetch(
+                std::move(childTreeIds),
+                depth,
+                blobMetadata,
+                lease.getContext())
+            .via(&folly::QueuedImmediateExecutor::instance())
+            .thenTry([lease = std::move(lease)](auto&&) {
+              XLOG(DBG4) << "finished speculative prefetch for "
+                         << lease.getTreeInode()->getLogPath();
+            });
+      });
+}
+
 folly::Future<struct stat> TreeInode::setattr(
     const DesiredMetadata& desired,
     ObjectFetchContext& /*fetchContext*/) {
@@ -6,6 +6,7 @@
  */
 
 #pragma once
+#include <folly/CancellationToken.h>
 #include <folly/File.h>
 #include <folly/Portability.h>
 #include <folly/Synchronized.h>
@@ -33,10 +34,12 @@ class ObjectFetchContext;
 class ObjectStore;
 class Overlay;
 class RenameLock;
+class SerializedTreeView;
 class Tree;
 class TreeEntry;
 class TreeInodeDebugInfo;
 class PrjfsDirEntry;
+struct ReaddirSnapshot;
 
 constexpr folly::StringPiece kDotEdenName{".eden"};
 
@@ -87,6 +90,17 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       mode_t initialMode,
       std::shared_ptr<const Tree>&& tree);
 
+  /**
+   * Construct a TreeInode from the serialized form of a source control tree,
+   * without first decoding it into a Tree.
+   */
+  TreeInode(
+      InodeNumber ino,
+      TreeInodePtr parent,
+      PathComponentPiece name,
+      mode_t initialMode,
+      const SerializedTreeView& tree);
+
   /**
    * Construct an inode that only has backing in the Overlay area.
    */
@@ -179,11 +193,25 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * Populate the list with as many directory entries as possible starting from
    * the inode start.
    *
+   * The entries are those of `snapshot`, taken by takeReaddirSnapshot() at
+   * the start of the listing, so that each page doesn't need to go through
+   * the whole directory again. Entries that were removed or renamed since
+   * are skipped, and ones that were added show up in the next listing, as
+   * POSIX allows for changes made during a listing.
+   *
    * Return the filled directory list as well as a boolean indicating if the
    * listing is complete.
    */
-  std::tuple<NfsDirList, bool>
-  nfsReaddir(NfsDirList&& list, off_t off, ObjectFetchContext& context);
+  std::tuple<NfsDirList, bool> nfsReaddir(
+      NfsDirList&& list,
+      off_t off,
+      const ReaddirSnapshot& snapshot,
+      ObjectFetchContext& context);
+
+  /**
+   * Take a snapshot of the entries of this directory for nfsReaddir().
+   */
+  std::shared_ptr<const ReaddirSnapshot> takeReaddirSnapshot();
 #endif
 
   const folly::Synchronized<TreeInodeState>& getContents() const {
@@ -235,6 +263,26 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       ObjectFetchContext& context,
       const RenameLock& renameLock);
 
+  /**
+   * Dematerialize this directory, and the materialized directories below it,
+   * whose entries are identical again to their source control Tree, for
+   * instance once a temporary file was created and removed, or a file was
+   * moved away and back.
+   *
+   * scmHash is the ID of the source control Tree this directory is compared
+   * to. Directories are processed bottom-up, so that a directory whose
+   * children were all dematerialized can be dematerialized in turn.
+   * Materialized files are not compared to their blobs, and keep their
+   * parent materialized.
+   *
+   * The returned future holds the number of directories that were
+   * dematerialized.
+   */
+  ImmediateFuture<size_t> dematerializeUnchanged(
+      ObjectId scmHash,
+      ObjectFetchContext& context,
+      folly::CancellationToken cancel);
+
   /**
    * For unloaded nodes, the removal should be simpler: remove the node
    * from entries and update the overlay.
@@ -501,6 +549,23 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   void materialize(const RenameLock* renameLock = nullptr);
 
+  /**
+   * Rename a file holding the mount point rename lock shared, so that it
+   * doesn't serialize with renames elsewhere in the mount.
+   *
+   * Moving a file doesn't change where any directory is in the tree, which
+   * is what the exclusive rename lock protects. This is only done when the
+   * source is a loaded file, the destination is absent or a loaded file, and
+   * both directories are already materialized. Returns std::nullopt in every
+   * other case, which rename() then handles with the exclusive lock, and
+   * also when an error has to be reported.
+   */
+  std::optional<ImmediateFuture<folly::Unit>> tryRenameFile(
+      PathComponentPiece name,
+      const TreeInodePtr& destParent,
+      PathComponentPiece destName,
+      InvalidationRequired invalidate);
+
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> doRename(
       TreeRenameLocks&& locks,
       PathComponentPiece srcName,
@@ -533,6 +598,10 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   static DirContents
   saveDirFromTree(InodeNumber inodeNumber, const Tree* tree, EdenMount* mount);
+  static DirContents saveDirFromTree(
+      InodeNumber inodeNumber,
+      const SerializedTreeView& tree,
+      EdenMount* mount);
 
   /** Translates a Tree object from our store into a Dir object
    * used to track the directory in the inode */
@@ -540,11 +609,21 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       const Tree* tree,
       Overlay* overlay,
       CaseSensitivity caseSensitive);
+  static DirContents buildDirFromTree(
+      const SerializedTreeView& tree,
+      Overlay* overlay,
+      CaseSensitivity caseSensitive);
 
   void updateAtime();
 
   void prefetch(ObjectFetchContext& context);
 
+  /**
+   * Prefetch the subtrees of this directory, if the mount is configured to
+   * and its SpeculativeTreePrefetcher allows it.
+   */
+  void speculativePrefetch(ObjectFetchContext& context);
+
   /**
    * Get a TreeInodePtr to ourself.
    *
@@ -559,13 +638,19 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   }
 
   /**
-   * Helper function to implement both fuseReaddir and nfsReaddir.
+   * Helper function to implement both fuseReaddir and nfsReaddir. Lists the
+   * entries of `snapshot` if it is not null, and the current ones otherwise.
+   * `add` is given the name, inode number, type and offset of each entry.
    *
    * Returns a boolean that indicates if readdir finished reading the entire
    * directory.
    */
   template <typename Fn>
-  bool readdirImpl(off_t offset, ObjectFetchContext& context, Fn add);
+  bool readdirImpl(
+      off_t offset,
+      const ReaddirSnapshot* snapshot,
+      ObjectFetchContext& context,
+      Fn add);
 
   /**
    * createImpl() is a helper function for creating new children inodes.
@@ -739,6 +824,13 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       bool& wasDirectoryListModified);
   void saveOverlayPostCheckout(CheckoutContext* ctx, const Tree* tree);
 
+  /**
+   * Mark this directory identical to the given source control Tree if all of
+   * its entries are, and tell our parent. Returns whether we were
+   * dematerialized.
+   */
+  bool dematerializeIfIdentical(const Tree& tree);
+
   /**
    * Send a request to the kernel to invalidate its directory cache for this
    * inode.  This is required when the child entry list has changed.
@@ -781,6 +873,11 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * Only prefetch blob metadata on the first readdir() of a loaded inode.
    */
   std::atomic<bool> prefetched_{false};
+
+  /**
+   * Likewise, only speculatively prefetch subtrees on the first readdir().
+   */
+  std::atomic<bool> speculativelyPrefetched_{false};
 };
 
 /**
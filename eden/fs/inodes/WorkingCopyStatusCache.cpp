@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/WorkingCopyStatusCache.h"
+
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/journal/Journal.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/SystemError.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Beyond this many changed paths, diffing the whole working copy is about as
+ * fast as looking each of them up.
+ */
+constexpr size_t kMaxReplayedPaths = 10000;
+
+/**
+ * How the status of a changed path is brought up to date.
+ */
+struct PathUpdate {
+  enum Kind {
+    /// The path's status didn't change.
+    Keep,
+    /// The path is clean or doesn't exist.
+    Erase,
+    /// The path now has `status`.
+    Set,
+    /// The status can't be known without a full diff.
+    Unknown,
+  };
+
+  /* implicit */ PathUpdate(Kind k) : kind{k} {}
+  /* implicit */ PathUpdate(ScmFileStatus s) : kind{Set}, status{s} {}
+
+  Kind kind;
+  ScmFileStatus status{ScmFileStatus::MODIFIED};
+};
+
+/**
+ * Returns the entry at `path` under `root`, or std::nullopt if there is no
+ * entry at that path.
+ */
+ImmediateFuture<std::optional<TreeEntry>> getEntry(
+    std::shared_ptr<ObjectStore> store,
+    std::shared_ptr<const Tree> root,
+    RelativePathPiece path,
+    ObjectFetchContext& context) {
+  auto findEntry = [name = path.basename().copy()](const Tree& tree) {
+    auto* entry = tree.getEntryPtr(name);
+    return entry ? std::optional<TreeEntry>{*entry} : std::nullopt;
+  };
+  auto dir = path.dirname();
+  if (dir.empty()) {
+    return findEntry(*root);
+  }
+  return getEntry(store, std::move(root), dir, context)
+      .thenValue(
+          [store, findEntry = std::move(findEntry), &context](
+              std::optional<TreeEntry> parent)
+              -> ImmediateFuture<std::optional<TreeEntry>> {
+            if (!parent || !parent->isTree()) {
+              return std::optional<TreeEntry>{};
+            }
+            return store->getTree(parent->getHash(), context)
+                .thenValue([findEntry = std::move(findEntry)](
+                               std::shared_ptr<const Tree> tree) {
+                  return findEntry(*tree);
+                });
+          });
+}
+
+/**
+ * Returns the inode at `path`, or nullptr if there is none.
+ */
+ImmediateFuture<InodePtr> getInodeIfExists(
+    EdenMount* mount,
+    RelativePathPiece path,
+    ObjectFetchContext& context) {
+  return mount->getInodeSlow(path, context)
+      .thenTry([](folly::Try<InodePtr>&& inode) {
+        if (auto* ex = inode.tryGetExceptionObject<std::system_error>()) {
+          if (isErrnoError(*ex) &&
+              (ex->code().value() == ENOENT ||
+               ex->code().value() == ENOTDIR)) {
+            return InodePtr{};
+          }
+        }
+        return std::move(inode).value();
+      });
+}
+
+/**
+ * Compare the working copy at `path` to the commit the same way
+ * TreeInode::diff() would.
+ */
+ImmediateFuture<PathUpdate> replayPath(
+    EdenMount* mount,
+    std::shared_ptr<const Tree> root,
+    RelativePath path,
+    PathChangeInfo info,
+    ObjectFetchContext& context) {
+  if (path.basename() == ".gitignore"_pc) {
+    return PathUpdate{PathUpdate::Unknown};
+  }
+  auto entryFuture = getEntry(mount->getObjectStore(), root, path, context);
+  auto inodeFuture = getInodeIfExists(mount, path, context);
+  return collectAllSafe(std::move(entryFuture), std::move(inodeFuture))
+      .thenValue(
+          [info, &context](
+              std::tuple<std::optional<TreeEntry>, InodePtr>&& result)
+              -> ImmediateFuture<PathUpdate> {
+            auto& [entry, inode] = result;
+            if (entry && entry->isTree()) {
+              return PathUpdate{PathUpdate::Unknown};
+            }
+            auto file = inode.asFilePtrOrNull();
+            if (inode && !file) {
+              return PathUpdate{PathUpdate::Unknown};
+            }
+
+            if (entry) {
+              if (!file) {
+                return PathUpdate{ScmFileStatus::REMOVED};
+              }
+              return file->isSameAs(entry->getHash(), entry->getType(), context)
+                  .thenValue([file](bool same) {
+                    return same ? PathUpdate{PathUpdate::Erase}
+                                : PathUpdate{ScmFileStatus::MODIFIED};
+                  });
+            }
+
+            if (!file) {
+              return PathUpdate{PathUpdate::Erase};
+            }
+            // An untracked file that existed throughout is still added or
+            // ignored, as it was. Whether a new one is ignored depends on the
+            // ignore files of all its parent directories.
+            return info.existedBefore && info.existedAfter
+                ? PathUpdate{PathUpdate::Keep}
+                : PathUpdate{PathUpdate::Unknown};
+          });
+}
+
+} // namespace
+
+ImmediateFuture<std::optional<ScmStatus>> WorkingCopyStatusCache::get(
+    const RootId& commit,
+    bool listIgnored,
+    ObjectFetchContext& context) {
+  auto entry = *entry_.rlock();
+  if (!entry || entry->commit != commit || entry->listIgnored != listIgnored) {
+    return std::optional<ScmStatus>{};
+  }
+
+  auto& journal = mount_->getJournal();
+  auto range = journal.accumulateRange(entry->sequence + 1);
+  if (!range) {
+    return std::optional<ScmStatus>{std::move(entry->status)};
+  }
+  if (range->isTruncated || range->snapshotTransitions.size() > 1 ||
+      !range->uncleanPaths.empty() ||
+      range->changedFilesInOverlay.size() > kMaxReplayedPaths) {
+    return std::optional<ScmStatus>{};
+  }
+
+  auto sequence = range->toSequence;
+  auto rootFuture = ImmediateFuture<std::shared_ptr<const Tree>>{
+      mount_->getFilteredRootTree(commit, context).semi()};
+  return std::move(rootFuture)
+      .thenValue([this, range = std::move(range), &context](
+                     std::shared_ptr<const Tree> root) {
+        std::vector<RelativePath> paths;
+        std::vector<ImmediateFuture<PathUpdate>> updates;
+        paths.reserve(range->changedFilesInOverlay.size());
+        updates.reserve(range->changedFilesInOverlay.size());
+        for (const auto& [path, info] : range->changedFilesInOverlay) {
+          paths.push_back(path);
+          updates.push_back(replayPath(mount_, root, path, info, context));
+        }
+        return collectAllSafe(std::move(updates))
+            .thenValue([paths = std::move(paths)](
+                           std::vector<PathUpdate>&& updates) {
+              return std::make_pair(std::move(paths), std::move(updates));
+            });
+      })
+      .thenValue(
+          [this,
+           commit,
+           listIgnored,
+           sequence,
+           status = std::move(entry->status)](
+              std::pair<std::vector<RelativePath>, std::vector<PathUpdate>>&&
+                  result) mutable -> std::optional<ScmStatus> {
+            auto& [paths, updates] = result;
+            auto& entries = *status.entries_ref();
+            for (size_t i = 0; i < paths.size(); ++i) {
+              switch (updates[i].kind) {
+                case PathUpdate::Keep:
+                  break;
+                case PathUpdate::Erase:
+                  entries.erase(paths[i].value());
+                  break;
+                case PathUpdate::Set:
+                  entries[paths[i].value()] = updates[i].status;
+                  break;
+                case PathUpdate::Unknown:
+                  XLOG(DBG4) << "full status needed for " << paths[i];
+                  return std::nullopt;
+              }
+            }
+
+            // Only remember the result if the working copy didn't change
+            // while the paths were being looked up.
+            auto latest = mount_->getJournal().getLatest();
+            if (latest && latest->sequenceID == sequence) {
+              insert(commit, listIgnored, sequence, status);
+            }
+            return status;
+          });
+}
+
+void WorkingCopyStatusCache::insert(
+    const RootId& commit,
+    bool listIgnored,
+    JournalDelta::SequenceNumber sequence,
+    ScmStatus status) {
+  if (!status.errors_ref()->empty()) {
+    return;
+  }
+  *entry_.wlock() = Entry{commit, listIgnored, sequence, std::move(status)};
+}
+
+void WorkingCopyStatusCache::clear() {
+  entry_.wlock()->reset();
+}
+
+} // namespace facebook::eden
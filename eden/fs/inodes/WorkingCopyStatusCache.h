@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <optional>
+
+#include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class EdenMount;
+class ObjectFetchContext;
+
+/**
+ * Remembers the last status computed between a mount's working copy and a
+ * commit, along with the journal sequence number it is current as of.
+ *
+ * A later status against the same commit only has to look at the paths
+ * changed in the journal since then: tracked files are compared to the
+ * commit like TreeInode::diff() does, and untracked files keep their previous
+ * status if they existed throughout. Whenever that isn't enough to know the
+ * status, get() returns std::nullopt and the caller must diff the whole
+ * working copy: when the journal was truncated or the commit changed, when a
+ * directory or .gitignore file changed, or when an untracked file was
+ * created.
+ *
+ * Changes to the user and system ignore files are only picked up by the next
+ * full diff.
+ */
+class WorkingCopyStatusCache {
+ public:
+  explicit WorkingCopyStatusCache(EdenMount* mount) : mount_{mount} {}
+
+  /**
+   * Returns the status of the working copy against `commit`, or std::nullopt
+   * if it is not cached or can't be brought up to date from the journal.
+   */
+  ImmediateFuture<std::optional<ScmStatus>> get(
+      const RootId& commit,
+      bool listIgnored,
+      ObjectFetchContext& context);
+
+  /**
+   * Remember the status of the working copy against `commit` as of the
+   * journal sequence number `sequence`. The caller must ensure that nothing
+   * changed in the working copy while computing it. Statuses that contain
+   * errors are not cached, since they may be incomplete.
+   */
+  void insert(
+      const RootId& commit,
+      bool listIgnored,
+      JournalDelta::SequenceNumber sequence,
+      ScmStatus status);
+
+  void clear();
+
+ private:
+  struct Entry {
+    RootId commit;
+    bool listIgnored;
+    JournalDelta::SequenceNumber sequence;
+    ScmStatus status;
+  };
+
+  EdenMount* const mount_;
+  folly::Synchronized<std::optional<Entry>> entry_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/fsoverlay/BlobFileCache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#include <folly/Exception.h>
+#include <folly/ScopeGuard.h>
+#include <folly/logging/xlog.h>
+
+// <linux/fs.h> defines FICLONE, but conflicts with <sys/mount.h>, which the
+// overlay code includes, on some glibc versions.
+#if defined(__linux__) && !defined(FICLONE)
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kTmpSuffix{".tmp"};
+
+#ifdef __linux__
+// The layout of struct file_dedupe_range from <linux/fs.h>, for the same
+// reason as FICLONE above, followed by its single destination.
+struct DedupeRangeHeader {
+  uint64_t srcOffset;
+  uint64_t srcLength;
+  uint16_t destCount;
+  uint16_t reserved1;
+  uint32_t reserved2;
+};
+
+struct DedupeRangeInfo {
+  int64_t destFd;
+  uint64_t destOffset;
+  uint64_t bytesDeduped;
+  int32_t status;
+  uint32_t reserved;
+};
+
+struct DedupeRange {
+  DedupeRangeHeader header;
+  DedupeRangeInfo info;
+};
+
+const unsigned long kFiDedupeRange = _IOWR(0x94, 54, DedupeRangeHeader);
+constexpr int32_t kDedupeRangeDiffers = 1;
+
+/**
+ * Filesystems may deduplicate less than requested at once, such as btrfs,
+ * which caps each call at 16MiB.
+ */
+constexpr uint64_t kMaxDedupeLength = 16 * 1024 * 1024;
+#endif
+} // namespace
+
+BlobFileCache::CopyResult copyFileData(int srcFd, int dstFd, uint64_t size) {
+#ifdef __linux__
+  if (ioctl(dstFd, FICLONE, srcFd) == 0) {
+    return BlobFileCache::CopyResult::Cloned;
+  }
+
+  loff_t srcOffset = 0;
+  loff_t dstOffset = 0;
+  while (static_cast<uint64_t>(srcOffset) < size) {
+    auto copied = copy_file_range(
+        srcFd, &srcOffset, dstFd, &dstOffset, size - srcOffset, 0);
+    if (copied < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      folly::throwSystemError("copy_file_range failed");
+    }
+    if (copied == 0) {
+      throw std::runtime_error(
+          "source file ended before the requested number of bytes");
+    }
+  }
+  return BlobFileCache::CopyResult::Copied;
+#else
+  (void)srcFd;
+  (void)dstFd;
+  (void)size;
+  folly::throwSystemErrorExplicit(
+      ENOSYS, "in-kernel file copies are only supported on Linux");
+#endif
+}
+
+// A maximum size of 0 lets the map grow: the cache evicts by bytes instead.
+BlobFileCache::Index::Index() : files{0} {}
+
+BlobFileCache::BlobFileCache(folly::File dir, uint64_t maxBytes)
+    : dir_{std::move(dir)}, maxBytes_{maxBytes} {}
+
+std::unique_ptr<BlobFileCache>
+BlobFileCache::open(int parentDirFd, const char* name, uint64_t maxBytes) {
+  if (mkdirat(parentDirFd, name, 0700) != 0 && errno != EEXIST) {
+    folly::throwSystemError(
+        "failed to create blob file cache directory ", name);
+  }
+  int fd = openat(parentDirFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  folly::checkUnixError(fd, "failed to open blob file cache directory ", name);
+
+  auto cache = std::unique_ptr<BlobFileCache>{
+      new BlobFileCache{folly::File{fd, /* ownsFd */ true}, maxBytes}};
+  cache->load();
+  return cache;
+}
+
+void BlobFileCache::load() {
+  // fdopendir() takes ownership of the descriptor it is given.
+  int fd = dup(dir_.fd());
+  folly::checkUnixError(fd, "failed to duplicate blob file cache descriptor");
+  DIR* dir = fdopendir(fd);
+  if (!dir) {
+    ::close(fd);
+    folly::throwSystemError("failed to list blob file cache directory");
+  }
+  SCOPE_EXIT {
+    closedir(dir);
+  };
+
+  auto index = index_.wlock();
+  while (auto* entry = readdir(dir)) {
+    folly::StringPiece name{entry->d_name};
+    if (name == "." || name == "..") {
+      continue;
+    }
+
+    // Remove leftovers of interrupted inserts and anything else that is not
+    // a cached blob.
+    struct stat st;
+    std::optional<ObjectId> id;
+    if (!name.endsWith(kTmpSuffix) &&
+        fstatat(dir_.fd(), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+        S_ISREG(st.st_mode)) {
+      try {
+        id = ObjectId::fromHex(name);
+      } catch (const std::exception&) {
+      }
+    }
+    if (!id) {
+      unlinkat(dir_.fd(), entry->d_name, 0);
+      continue;
+    }
+
+    index->files.set(*id, st.st_size);
+    index->totalBytes += st.st_size;
+  }
+  evictLocked(*index);
+  XLOG(DBG2) << "loaded " << index->files.size() << " cached blob files, "
+             << index->totalBytes << " bytes";
+}
+
+std::optional<std::pair<folly::File, uint64_t>> BlobFileCache::openCached(
+    const ObjectId& id) {
+  uint64_t size;
+  {
+    auto index = index_.wlock();
+    auto it = index->files.find(id);
+    if (it == index->files.end()) {
+      return std::nullopt;
+    }
+    size = it->second;
+  }
+
+  auto name = id.asHexString();
+  int fd = openat(dir_.fd(), name.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      // Evicted since the index was checked.
+      return std::nullopt;
+    }
+    folly::throwSystemError("failed to open cached blob file ", name);
+  }
+  return std::make_pair(folly::File{fd, /* ownsFd */ true}, size);
+}
+
+BlobFileCache::CopyResult BlobFileCache::copyTo(
+    const ObjectId& blobId,
+    int dstFd) {
+  auto cached = openCached(blobId);
+  if (!cached) {
+    return CopyResult::Missing;
+  }
+  return copyFileData(cached->first.fd(), dstFd, cached->second);
+}
+
+BlobFileCache::CopyResult
+BlobFileCache::deduplicate(const ObjectId& id, int dstFd, uint64_t size) {
+#ifdef __linux__
+  auto cached = openCached(id);
+  if (!cached || cached->second != size) {
+    return CopyResult::Missing;
+  }
+
+  uint64_t offset = 0;
+  while (offset < size) {
+    DedupeRange range;
+    memset(&range, 0, sizeof(range));
+    range.header.srcOffset = offset;
+    range.header.srcLength = std::min(size - offset, kMaxDedupeLength);
+    range.header.destCount = 1;
+    range.info.destFd = dstFd;
+    range.info.destOffset = offset;
+    if (ioctl(cached->first.fd(), kFiDedupeRange, &range) != 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      folly::throwSystemError("FIDEDUPERANGE failed");
+    }
+    if (range.info.status < 0) {
+      folly::throwSystemErrorExplicit(
+          -range.info.status, "FIDEDUPERANGE failed");
+    }
+    if (range.info.status == kDedupeRangeDiffers ||
+        range.info.bytesDeduped == 0) {
+      return CopyResult::Missing;
+    }
+    offset += range.info.bytesDeduped;
+  }
+  return CopyResult::Cloned;
+#else
+  (void)id;
+  (void)dstFd;
+  (void)size;
+  folly::throwSystemErrorExplicit(
+      ENOSYS, "file deduplication is only supported on Linux");
+#endif
+}
+
+BlobFileCache::CopyResult
+BlobFileCache::insert(const ObjectId& blobId, int srcFd, uint64_t size) {
+  if (size > maxBytes_ || index_.rlock()->files.exists(blobId)) {
+    return CopyResult::Missing;
+  }
+
+  auto name = blobId.asHexString();
+  auto tmpName = name + kTmpSuffix.str();
+  int fd = openat(
+      dir_.fd(),
+      tmpName.c_str(),
+      O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC | O_NOFOLLOW,
+      0600);
+  if (fd < 0) {
+    if (errno == EEXIST) {
+      // Another thread is inserting this blob.
+      return CopyResult::Missing;
+    }
+    folly::throwSystemError("failed to create cached blob file ", tmpName);
+  }
+  folly::File tmpFile{fd, /* ownsFd */ true};
+  SCOPE_FAIL {
+    unlinkat(dir_.fd(), tmpName.c_str(), 0);
+  };
+
+  auto result = copyFileData(srcFd, tmpFile.fd(), size);
+  folly::checkUnixError(
+      renameat(dir_.fd(), tmpName.c_str(), dir_.fd(), name.c_str()),
+      "failed to commit cached blob file ",
+      name);
+
+  auto index = index_.wlock();
+  if (!index->files.exists(blobId)) {
+    index->files.set(blobId, size);
+    index->totalBytes += size;
+    evictLocked(*index);
+  }
+  return result;
+}
+
+uint64_t BlobFileCache::getTotalBytes() const {
+  return index_.rlock()->totalBytes;
+}
+
+void BlobFileCache::evictLocked(Index& index) {
+  while (index.totalBytes > maxBytes_ && !index.files.empty()) {
+    auto oldest = index.files.rbegin();
+    auto id = oldest->first;
+    auto name = id.asHexString();
+    if (unlinkat(dir_.fd(), name.c_str(), 0) != 0 && errno != ENOENT) {
+      XLOG(WARN) << "failed to remove cached blob file " << name << ": "
+                 << folly::errnoStr(errno);
+    }
+    index.totalBytes -= oldest->second;
+    index.files.erase(id);
+  }
+}
+
+} // namespace facebook::eden
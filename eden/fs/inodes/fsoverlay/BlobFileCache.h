@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * A size-bounded cache of blob contents kept on disk, next to the overlay, so
+ * that materializing a file whose blob was materialized before can clone the
+ * cached copy instead of writing the blob's contents out again.
+ *
+ * Each cached blob is stored as a complete overlay file, header included,
+ * named after the blob ID. Copies are always of whole files, so a reflink
+ * can be used whatever the filesystem's alignment requirements are. When
+ * the filesystem can't clone files, the copy is made in the kernel with
+ * copy_file_range(2).
+ *
+ * FsOverlay also keeps a second cache, keyed by the SHA-1 of the contents
+ * instead of a blob ID, that materialized files with identical contents are
+ * deduplicated against. See deduplicate().
+ *
+ * The cache is only supported on Linux. Its index is kept in memory and
+ * rebuilt from the cache directory when it is opened. It is safe to use this
+ * object from arbitrary threads.
+ */
+class BlobFileCache {
+ public:
+  enum class CopyResult {
+    /// The blob is not cached. Nothing was written.
+    Missing,
+    /// The file was cloned, sharing its data with the cached copy.
+    Cloned,
+    /// The file's data was copied.
+    Copied,
+  };
+
+  /**
+   * Open the cache stored in the directory `name` of the directory
+   * `parentDirFd`, creating it if needed, and evict blobs until it holds at
+   * most `maxBytes`.
+   */
+  static std::unique_ptr<BlobFileCache>
+  open(int parentDirFd, const char* name, uint64_t maxBytes);
+
+  /**
+   * Fill `dstFd`, an empty file, with the cached copy of `blobId`.
+   */
+  CopyResult copyTo(const ObjectId& blobId, int dstFd);
+
+  /**
+   * Cache the `size` bytes long overlay file `srcFd` as the copy of `blobId`,
+   * and return how it was copied.
+   *
+   * Does nothing and returns Missing if the blob is already cached or does
+   * not fit in the cache.
+   */
+  CopyResult insert(const ObjectId& blobId, int srcFd, uint64_t size);
+
+  /**
+   * Make `dstFd`, a `size` bytes long file with the same contents as the
+   * cached copy of `id`, share its data with the cached copy. Writes to
+   * either file unshare the data they modify again.
+   *
+   * The filesystem compares the contents before sharing them, so this
+   * returns Missing if they differ, as well as if `id` is not cached.
+   * Returns Cloned once the data is shared, and throws if the filesystem
+   * can't share data between files.
+   */
+  CopyResult deduplicate(const ObjectId& id, int dstFd, uint64_t size);
+
+  /// Total size of the cached files, in bytes.
+  uint64_t getTotalBytes() const;
+
+ private:
+  struct Index {
+    Index();
+
+    /// Size of each cached file, from most to least recently used.
+    folly::EvictingCacheMap<ObjectId, uint64_t> files;
+    uint64_t totalBytes{0};
+  };
+
+  BlobFileCache(folly::File dir, uint64_t maxBytes);
+
+  void load();
+  /**
+   * Open the cached copy of `id`, whose size is returned, or return
+   * std::nullopt if it is not cached.
+   */
+  std::optional<std::pair<folly::File, uint64_t>> openCached(
+      const ObjectId& id);
+  void evictLocked(Index& index);
+
+  folly::File dir_;
+  const uint64_t maxBytes_;
+  folly::Synchronized<Index> index_;
+};
+
+/**
+ * Copy the first `size` bytes of `srcFd` into `dstFd`, an empty file, cloning
+ * them if the filesystem supports it. Throws on error.
+ */
+BlobFileCache::CopyResult copyFileData(int srcFd, int dstFd, uint64_t size);
+
+} // namespace facebook::eden
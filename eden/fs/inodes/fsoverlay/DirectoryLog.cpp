@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/fsoverlay/DirectoryLog.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <folly/hash/Checksum.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kSegmentPrefix{"segment-"};
+constexpr uint32_t kRecordMagic = 0x474c4445; // "EDLG"
+constexpr uint32_t kTombstone = 0x1;
+
+/**
+ * Precedes the contents of every record. Segments are only ever read by the
+ * machine that wrote them, so fields are stored in native byte order.
+ */
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t flags;
+  uint64_t inode;
+  uint32_t length;
+  /// CRC32C of the header, with this field set to 0, and of the contents.
+  uint32_t checksum;
+};
+static_assert(sizeof(RecordHeader) == 24, "RecordHeader must not be padded");
+
+struct Record {
+  RecordHeader header;
+  folly::ByteRange contents;
+
+  size_t size() const {
+    return sizeof(RecordHeader) + contents.size();
+  }
+};
+
+uint32_t computeChecksum(RecordHeader header, folly::ByteRange contents) {
+  header.checksum = 0;
+  auto checksum = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+  return folly::crc32c(contents.data(), contents.size(), checksum);
+}
+
+std::string makeRecord(
+    InodeNumber inodeNumber,
+    folly::ByteRange contents,
+    bool tombstone) {
+  RecordHeader header;
+  header.magic = kRecordMagic;
+  header.flags = tombstone ? kTombstone : 0;
+  header.inode = inodeNumber.get();
+  header.length = folly::to<uint32_t>(contents.size());
+  header.checksum = computeChecksum(header, contents);
+
+  std::string record;
+  record.reserve(sizeof(header) + contents.size());
+  record.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  record.append(
+      reinterpret_cast<const char*>(contents.data()), contents.size());
+  return record;
+}
+
+/**
+ * Parse the record at the start of `data`. Returns std::nullopt if `data`
+ * does not start with an intact record.
+ */
+std::optional<Record> parseRecord(folly::ByteRange data) {
+  Record record;
+  if (data.size() < sizeof(record.header)) {
+    return std::nullopt;
+  }
+  memcpy(&record.header, data.data(), sizeof(record.header));
+  data.advance(sizeof(record.header));
+  if (record.header.magic != kRecordMagic ||
+      data.size() < record.header.length) {
+    return std::nullopt;
+  }
+  record.contents = data.subpiece(0, record.header.length);
+  if (computeChecksum(record.header, record.contents) !=
+      record.header.checksum) {
+    return std::nullopt;
+  }
+  return record;
+}
+
+std::string segmentName(uint64_t id) {
+  return folly::to<std::string>(kSegmentPrefix, id);
+}
+
+} // namespace
+
+DirectoryLog::DirectoryLog(folly::File dir, uint64_t maxSegmentSize)
+    : dir_{std::move(dir)}, maxSegmentSize_{maxSegmentSize} {}
+
+DirectoryLog::~DirectoryLog() {
+  {
+    std::lock_guard<std::mutex> lock{compactionMutex_};
+    stopping_ = true;
+  }
+  compactionCv_.notify_one();
+  if (compactionThread_.joinable()) {
+    compactionThread_.join();
+  }
+}
+
+std::unique_ptr<DirectoryLog> DirectoryLog::open(
+    int parentDirFd,
+    const char* name,
+    uint64_t maxSegmentSize) {
+  if (mkdirat(parentDirFd, name, 0700) != 0 && errno != EEXIST) {
+    folly::throwSystemError("failed to create directory log ", name);
+  }
+  int fd = openat(parentDirFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  folly::checkUnixError(fd, "failed to open directory log ", name);
+
+  auto log = std::unique_ptr<DirectoryLog>{
+      new DirectoryLog{folly::File{fd, /* ownsFd */ true}, maxSegmentSize}};
+  log->replay();
+  log->compactionThread_ = std::thread{[log = log.get()] {
+    log->runCompaction();
+  }};
+  if (needsCompaction(*log->state_.rlock())) {
+    log->requestCompaction();
+  }
+  return log;
+}
+
+bool DirectoryLog::exists(int parentDirFd, const char* name) {
+  struct stat st;
+  return fstatat(parentDirFd, name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+}
+
+void DirectoryLog::replay() {
+  // fdopendir() takes ownership of the descriptor it is given.
+  int fd = dup(dir_.fd());
+  folly::checkUnixError(fd, "failed to duplicate directory log descriptor");
+  DIR* dir = fdopendir(fd);
+  if (!dir) {
+    ::close(fd);
+    folly::throwSystemError("failed to list directory log");
+  }
+  SCOPE_EXIT {
+    closedir(dir);
+  };
+
+  std::vector<uint64_t> ids;
+  while (auto* entry = readdir(dir)) {
+    folly::StringPiece name{entry->d_name};
+    if (!name.removePrefix(kSegmentPrefix)) {
+      continue;
+    }
+    if (auto id = folly::tryTo<uint64_t>(name)) {
+      ids.push_back(*id);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+
+  auto state = state_.wlock();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    replaySegment(*state, ids[i], i + 1 == ids.size());
+  }
+  if (state->segments.empty()) {
+    openSegment(*state, 1);
+  }
+  XLOG(DBG2) << "loaded " << state->index.size() << " directories from "
+             << state->segments.size() << " directory log segments";
+}
+
+void DirectoryLog::replaySegment(State& state, uint64_t id, bool last) {
+  auto& segment = openSegment(state, id);
+  std::string data;
+  if (!folly::readFile(segment.file->fd(), data)) {
+    folly::throwSystemError("failed to read directory log ", segmentName(id));
+  }
+
+  folly::ByteRange remaining{folly::StringPiece{data}};
+  uint64_t offset = 0;
+  while (auto record = parseRecord(remaining)) {
+    auto length = record->size();
+    auto it = state.index.find(record->header.inode);
+    if (it != state.index.end()) {
+      state.segments[it->second.segment].liveBytes -= it->second.length;
+    }
+    if (record->header.flags & kTombstone) {
+      if (it != state.index.end()) {
+        state.index.erase(it);
+      }
+    } else {
+      state.index[record->header.inode] = Location{id, offset, length};
+      segment.liveBytes += length;
+    }
+    offset += length;
+    remaining.advance(length);
+  }
+
+  segment.size = data.size();
+  if (offset == data.size()) {
+    return;
+  }
+  if (last) {
+    // The tail of the active segment was torn by a crash. Drop it so that
+    // new records are appended after the last intact one.
+    XLOG(WARN) << "truncating directory log " << segmentName(id) << " from "
+               << data.size() << " to " << offset << " bytes";
+    folly::checkUnixError(
+        ftruncate(segment.file->fd(), offset),
+        "failed to truncate directory log ",
+        segmentName(id));
+    segment.size = offset;
+  } else {
+    XLOG(ERR) << "ignoring " << data.size() - offset
+              << " corrupt bytes at the end of directory log "
+              << segmentName(id);
+  }
+}
+
+DirectoryLog::Segment& DirectoryLog::openSegment(State& state, uint64_t id) {
+  auto name = segmentName(id);
+  int fd = openat(dir_.fd(), name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  folly::checkUnixError(fd, "failed to open directory log ", name);
+  auto& segment = state.segments[id];
+  segment.file = std::make_shared<folly::File>(fd, /* ownsFd */ true);
+  return segment;
+}
+
+std::optional<std::string> DirectoryLog::load(InodeNumber inodeNumber) {
+  Location location;
+  std::shared_ptr<folly::File> file;
+  {
+    auto state = state_.rlock();
+    auto it = state->index.find(inodeNumber.get());
+    if (it == state->index.end()) {
+      return std::nullopt;
+    }
+    location = it->second;
+    file = state->segments.at(location.segment).file;
+  }
+  // The file stays readable even if compaction deletes the segment now.
+  return readRecord(*file, location, inodeNumber);
+}
+
+std::string DirectoryLog::readRecord(
+    const folly::File& file,
+    const Location& location,
+    InodeNumber inodeNumber) {
+  std::string data;
+  data.resize(location.length);
+  auto bytesRead =
+      folly::preadFull(file.fd(), data.data(), data.size(), location.offset);
+  folly::checkUnixError(
+      bytesRead, "failed to read directory log record for inode ", inodeNumber);
+
+  auto record = parseRecord(folly::ByteRange{folly::StringPiece{data}});
+  if (!record || record->size() != data.size() ||
+      record->header.inode != inodeNumber.get()) {
+    throw std::runtime_error(folly::to<std::string>(
+        "corrupt directory log record for inode ", inodeNumber));
+  }
+  data.erase(0, sizeof(RecordHeader));
+  return data;
+}
+
+void DirectoryLog::save(InodeNumber inodeNumber, folly::ByteRange contents) {
+  auto record = makeRecord(inodeNumber, contents, /*tombstone=*/false);
+  auto state = state_.wlock();
+  appendLocked(
+      *state,
+      inodeNumber,
+      folly::ByteRange{folly::StringPiece{record}},
+      /*tombstone=*/false);
+}
+
+bool DirectoryLog::saveIfMissing(
+    InodeNumber inodeNumber,
+    folly::ByteRange contents) {
+  auto record = makeRecord(inodeNumber, contents, /*tombstone=*/false);
+  auto state = state_.wlock();
+  if (state->index.count(inodeNumber.get())) {
+    return false;
+  }
+  appendLocked(
+      *state,
+      inodeNumber,
+      folly::ByteRange{folly::StringPiece{record}},
+      /*tombstone=*/false);
+  return true;
+}
+
+bool DirectoryLog::remove(InodeNumber inodeNumber) {
+  auto record = makeRecord(inodeNumber, {}, /*tombstone=*/true);
+  auto state = state_.wlock();
+  if (!state->index.count(inodeNumber.get())) {
+    return false;
+  }
+  appendLocked(
+      *state,
+      inodeNumber,
+      folly::ByteRange{folly::StringPiece{record}},
+      /*tombstone=*/true);
+  return true;
+}
+
+bool DirectoryLog::contains(InodeNumber inodeNumber) const {
+  return state_.rlock()->index.count(inodeNumber.get()) != 0;
+}
+
+void DirectoryLog::appendLocked(
+    State& state,
+    InodeNumber inodeNumber,
+    folly::ByteRange record,
+    bool tombstone) {
+  auto& [id, segment] = *state.segments.rbegin();
+  auto bytesWritten = folly::pwriteFull(
+      segment.file->fd(), record.data(), record.size(), segment.size);
+  folly::checkUnixError(
+      bytesWritten, "failed to append to directory log ", segmentName(id));
+  // As with the legacy overlay files, only the root directory is synced: its
+  // loss would prevent the checkout from being remounted.
+  if (inodeNumber == kRootNodeId) {
+    folly::checkUnixError(
+        folly::fdatasyncNoInt(segment.file->fd()),
+        "failed to sync directory log ",
+        segmentName(id));
+  }
+
+  Location location{id, segment.size, record.size()};
+  segment.size += record.size();
+  auto it = state.index.find(inodeNumber.get());
+  if (it != state.index.end()) {
+    state.segments[it->second.segment].liveBytes -= it->second.length;
+  }
+  if (tombstone) {
+    if (it != state.index.end()) {
+      state.index.erase(it);
+    }
+  } else {
+    state.index[inodeNumber.get()] = location;
+    segment.liveBytes += location.length;
+  }
+
+  if (segment.size >= maxSegmentSize_) {
+    openSegment(state, id + 1);
+    if (needsCompaction(state)) {
+      requestCompaction();
+    }
+  }
+}
+
+void DirectoryLog::forEach(
+    folly::FunctionRef<void(InodeNumber, folly::ByteRange)> fn) const {
+  std::vector<std::pair<Location, std::shared_ptr<folly::File>>> records;
+  {
+    auto state = state_.rlock();
+    records.reserve(state->index.size());
+    for (const auto& [inode, location] : state->index) {
+      records.emplace_back(location, state->segments.at(location.segment).file);
+    }
+  }
+  // Read in log order rather than in hash order.
+  std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+    return std::tie(a.first.segment, a.first.offset) <
+        std::tie(b.first.segment, b.first.offset);
+  });
+
+  for (const auto& [location, file] : records) {
+    std::string data;
+    data.resize(location.length);
+    auto bytesRead =
+        folly::preadFull(file->fd(), data.data(), data.size(), location.offset);
+    folly::checkUnixError(bytesRead, "failed to read directory log");
+    auto record = parseRecord(folly::ByteRange{folly::StringPiece{data}});
+    if (!record) {
+      throw std::runtime_error("corrupt directory log record");
+    }
+    fn(InodeNumber{record->header.inode}, record->contents);
+  }
+}
+
+bool DirectoryLog::needsCompaction(const State& state) {
+  if (state.segments.empty()) {
+    return false;
+  }
+  auto active = std::prev(state.segments.end());
+  for (auto it = state.segments.begin(); it != active; ++it) {
+    if (it->second.liveBytes * 2 < it->second.size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void DirectoryLog::compact() {
+  std::vector<uint64_t> ids;
+  {
+    auto state = state_.rlock();
+    if (state->segments.empty()) {
+      return;
+    }
+    auto active = std::prev(state->segments.end());
+    for (auto it = state->segments.begin(); it != active; ++it) {
+      if (it->second.liveBytes * 2 < it->second.size) {
+        ids.push_back(it->first);
+      }
+    }
+  }
+  for (auto id : ids) {
+    compactSegment(id);
+  }
+}
+
+void DirectoryLog::compactSegment(uint64_t id) {
+  std::shared_ptr<folly::File> file;
+  {
+    auto state = state_.rlock();
+    auto it = state->segments.find(id);
+    if (it == state->segments.end() ||
+        std::next(it) == state->segments.end()) {
+      return;
+    }
+    file = it->second.file;
+  }
+
+  // Sealed segments are never written again, so they can be read without
+  // holding the lock.
+  std::string data;
+  if (!folly::readFile(file->fd(), data)) {
+    folly::throwSystemError("failed to read directory log ", segmentName(id));
+  }
+
+  folly::ByteRange remaining{folly::StringPiece{data}};
+  uint64_t offset = 0;
+  size_t copied = 0;
+  while (auto record = parseRecord(remaining)) {
+    auto length = record->size();
+    InodeNumber inodeNumber{record->header.inode};
+    auto bytes = remaining.subpiece(0, length);
+    bool tombstone = record->header.flags & kTombstone;
+    {
+      auto state = state_.wlock();
+      auto it = state->index.find(inodeNumber.get());
+      if (tombstone) {
+        // A tombstone is only needed while an older segment may still hold
+        // a record for the inode.
+        if (it == state->index.end() && state->segments.begin()->first != id) {
+          appendLocked(*state, inodeNumber, bytes, /*tombstone=*/true);
+          ++copied;
+        }
+      } else if (
+          it != state->index.end() && it->second.segment == id &&
+          it->second.offset == offset) {
+        appendLocked(*state, inodeNumber, bytes, /*tombstone=*/false);
+        ++copied;
+      }
+    }
+    offset += length;
+    remaining.advance(length);
+  }
+
+  auto state = state_.wlock();
+  auto it = state->segments.find(id);
+  if (it == state->segments.end()) {
+    return;
+  }
+  if (it->second.liveBytes != 0) {
+    XLOG(WARN) << "not removing directory log " << segmentName(id)
+               << " which still holds " << it->second.liveBytes
+               << " live bytes";
+    return;
+  }
+  state->segments.erase(it);
+  if (unlinkat(dir_.fd(), segmentName(id).c_str(), 0) != 0) {
+    XLOG(WARN) << "failed to remove directory log " << segmentName(id) << ": "
+               << folly::errnoStr(errno);
+  }
+  XLOG(DBG3) << "compacted directory log " << segmentName(id) << ", copied "
+             << copied << " records";
+}
+
+void DirectoryLog::requestCompaction() {
+  {
+    std::lock_guard<std::mutex> lock{compactionMutex_};
+    compactionRequested_ = true;
+  }
+  compactionCv_.notify_one();
+}
+
+void DirectoryLog::runCompaction() {
+  folly::setThreadName("DirLogCompact");
+  std::unique_lock<std::mutex> lock{compactionMutex_};
+  while (true) {
+    compactionCv_.wait(
+        lock, [this] { return compactionRequested_ || stopping_; });
+    if (stopping_) {
+      return;
+    }
+    compactionRequested_ = false;
+    lock.unlock();
+    try {
+      compact();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "failed to compact directory log: " << ex.what();
+    }
+    lock.lock();
+  }
+}
+
+DirectoryLog::Stats DirectoryLog::getStats() const {
+  auto state = state_.rlock();
+  Stats stats;
+  stats.segmentCount = state->segments.size();
+  for (const auto& [id, segment] : state->segments) {
+    stats.totalBytes += segment.size;
+    stats.liveBytes += segment.liveBytes;
+  }
+  return stats;
+}
+
+} // namespace facebook::eden
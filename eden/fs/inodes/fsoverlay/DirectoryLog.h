@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "eden/fs/inodes/InodeNumber.h"
+
+namespace facebook::eden {
+
+/**
+ * Stores the serialized contents of overlay directories in a few large,
+ * append-only segment files instead of one file per directory.
+ *
+ * Every save appends a checksummed record to the active segment and every
+ * removal appends a tombstone, each with a single write. An in-memory index,
+ * rebuilt by replaying the segments when the log is opened, maps each inode
+ * to its latest record so that a load is a single read. A record torn by a
+ * crash at the end of the last segment is truncated away when the log is
+ * opened.
+ *
+ * Once the active segment reaches the maximum segment size a new one is
+ * started. A background thread compacts sealed segments in which most
+ * records were superseded, copying their live records to the active segment
+ * and then deleting them.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class DirectoryLog {
+ public:
+  static constexpr uint64_t kDefaultMaxSegmentSize = 64 * 1024 * 1024;
+
+  struct Stats {
+    size_t segmentCount{0};
+    /// Size of all the segments, in bytes.
+    uint64_t totalBytes{0};
+    /// Size of the records that have not been superseded, in bytes.
+    uint64_t liveBytes{0};
+  };
+
+  ~DirectoryLog();
+
+  DirectoryLog(const DirectoryLog&) = delete;
+  DirectoryLog& operator=(const DirectoryLog&) = delete;
+
+  /**
+   * Open the log stored in the directory `name` of the directory
+   * `parentDirFd`, creating it if needed, and replay its segments.
+   */
+  static std::unique_ptr<DirectoryLog> open(
+      int parentDirFd,
+      const char* name,
+      uint64_t maxSegmentSize = kDefaultMaxSegmentSize);
+
+  /**
+   * Whether the directory `name` of the directory `parentDirFd` exists, i.e.
+   * whether a log was opened there before.
+   */
+  static bool exists(int parentDirFd, const char* name);
+
+  /**
+   * Return the contents last saved for `inodeNumber`, or std::nullopt if
+   * there are none.
+   */
+  std::optional<std::string> load(InodeNumber inodeNumber);
+
+  void save(InodeNumber inodeNumber, folly::ByteRange contents);
+
+  /**
+   * Save `contents` unless contents were already saved for `inodeNumber`.
+   * Returns whether they were saved.
+   */
+  bool saveIfMissing(InodeNumber inodeNumber, folly::ByteRange contents);
+
+  /**
+   * Remove the contents of `inodeNumber`. Returns false, without writing
+   * anything, if there were none.
+   */
+  bool remove(InodeNumber inodeNumber);
+
+  bool contains(InodeNumber inodeNumber) const;
+
+  /**
+   * Call `fn` with the contents of every inode in the log.
+   */
+  void forEach(
+      folly::FunctionRef<void(InodeNumber, folly::ByteRange)> fn) const;
+
+  /**
+   * Compact every sealed segment in which less than half of the bytes are
+   * live. This is normally done by the background thread.
+   */
+  void compact();
+
+  Stats getStats() const;
+
+ private:
+  struct Location {
+    uint64_t segment;
+    /// Offset of the record header in the segment.
+    uint64_t offset;
+    /// Length of the whole record, header included.
+    uint64_t length;
+  };
+
+  struct Segment {
+    std::shared_ptr<folly::File> file;
+    uint64_t size{0};
+    uint64_t liveBytes{0};
+  };
+
+  struct State {
+    folly::F14FastMap<uint64_t, Location> index;
+    /// Ordered from oldest to newest. The last one is the active segment.
+    std::map<uint64_t, Segment> segments;
+  };
+
+  DirectoryLog(folly::File dir, uint64_t maxSegmentSize);
+
+  void replay();
+  void replaySegment(State& state, uint64_t id, bool last);
+  Segment& openSegment(State& state, uint64_t id);
+
+  /**
+   * Append a complete record to the active segment and point the index at
+   * it, rolling over to a new segment if the active one is full.
+   */
+  void appendLocked(
+      State& state,
+      InodeNumber inodeNumber,
+      folly::ByteRange record,
+      bool tombstone);
+
+  /**
+   * Read the record at `location` and return its contents, throwing if it
+   * is not an intact record for `inodeNumber`.
+   */
+  static std::string readRecord(
+      const folly::File& file,
+      const Location& location,
+      InodeNumber inodeNumber);
+
+  void compactSegment(uint64_t id);
+  static bool needsCompaction(const State& state);
+  void requestCompaction();
+  void runCompaction();
+
+  folly::File dir_;
+  const uint64_t maxSegmentSize_;
+  folly::Synchronized<State> state_;
+
+  std::mutex compactionMutex_;
+  std::condition_variable compactionCv_;
+  bool compactionRequested_{false};
+  bool stopping_{false};
+  std::thread compactionThread_;
+};
+
+} // namespace facebook::eden
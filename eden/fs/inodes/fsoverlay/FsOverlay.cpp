@@ -17,6 +17,7 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/lang/ToAscii.h>
@@ -47,6 +48,9 @@ using std::string;
  */
 constexpr StringPiece kInfoFile{"info"};
 constexpr const char* kNextInodeNumberFile{"next-inode-number"};
+constexpr const char* kBlobFileCacheDir{"blob-cache"};
+constexpr const char* kDedupStoreDir{"dedup-store"};
+constexpr const char* kDirectoryLogDir{"dir-log"};
 
 /**
  * 4-byte magic identifier to put at the start of the info file.
@@ -134,6 +138,34 @@ std::optional<InodeNumber> FsOverlay::initOverlay(bool createIfNonExisting) {
       dirFd, "error opening overlay directory handle for ", localDir_.value());
   dirFile_ = File{dirFd, /* ownsFd */ true};
 
+#ifdef __linux__
+  if (blobFileCacheSize_ > 0) {
+    try {
+      blobFileCache_ = BlobFileCache::open(
+          dirFile_.fd(), kBlobFileCacheDir, blobFileCacheSize_);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "not using a blob file cache for " << localDir_ << ": "
+                 << ex.what();
+    }
+  }
+  if (dedupStoreSize_ > 0) {
+    try {
+      dedupStore_ =
+          BlobFileCache::open(dirFile_.fd(), kDedupStoreDir, dedupStoreSize_);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "not deduplicating the overlay files of " << localDir_
+                 << ": " << ex.what();
+    }
+  }
+#endif
+
+  // Keep using the log once directories were written to it, or they would
+  // be lost.
+  if (packedDirectories_ ||
+      DirectoryLog::exists(dirFile_.fd(), kDirectoryLogDir)) {
+    directoryLog_ = DirectoryLog::open(dirFile_.fd(), kDirectoryLogDir);
+  }
+
   if (overlayCreated) {
     return InodeNumber{kRootNodeId.get() + 1};
   }
@@ -150,6 +182,9 @@ void FsOverlay::close(std::optional<InodeNumber> inodeNumber) {
   if (inodeNumber) {
     saveNextInodeNumber(inodeNumber.value());
   }
+  blobFileCache_.reset();
+  dedupStore_.reset();
+  directoryLog_.reset();
   dirFile_.close();
   infoFile_.close();
 }
@@ -292,7 +327,31 @@ void FsOverlay::initNewOverlay() {
 
 optional<overlay::OverlayDir> FsOverlay::loadOverlayDir(
     InodeNumber inodeNumber) {
-  return deserializeOverlayDir(inodeNumber);
+  if (!directoryLog_) {
+    return deserializeOverlayDir(inodeNumber);
+  }
+
+  if (auto serializedData = directoryLog_->load(inodeNumber)) {
+    return CompactSerializer::deserialize<overlay::OverlayDir>(
+        StringPiece{*serializedData});
+  }
+
+  // Move directories written before the log was enabled into it. The file
+  // is only removed once the log holds the directory, and a directory saved
+  // concurrently is not overwritten.
+  auto dir = deserializeOverlayDir(inodeNumber);
+  if (dir) {
+    auto serializedData = CompactSerializer::serialize<std::string>(*dir);
+    directoryLog_->saveIfMissing(
+        inodeNumber, ByteRange{StringPiece{serializedData}});
+    auto path = getFilePath(inodeNumber);
+    if (::unlinkat(dirFile_.fd(), path.c_str(), 0) != 0 && errno != ENOENT) {
+      XLOG(WARN) << "failed to remove overlay file for inode " << inodeNumber
+                 << " after moving it to the directory log: "
+                 << folly::errnoStr(errno);
+    }
+  }
+  return dir;
 }
 
 std::optional<overlay::OverlayDir> FsOverlay::loadAndRemoveOverlayDir(
@@ -308,6 +367,11 @@ void FsOverlay::saveOverlayDir(
   // Ask thrift to serialize it.
   auto serializedData = CompactSerializer::serialize<std::string>(odir);
 
+  if (directoryLog_) {
+    directoryLog_->save(inodeNumber, ByteRange{StringPiece{serializedData}});
+    return;
+  }
+
   // Add header to the overlay directory.
   auto header = FsOverlay::createHeader(kHeaderIdentifierDir, kHeaderVersion);
 
@@ -465,6 +529,20 @@ folly::File FsOverlay::createOverlayFileImpl(
     InodeNumber inodeNumber,
     iovec* iov,
     size_t iovCount) {
+  return createOverlayFileImpl(inodeNumber, [&](int fd) {
+    auto sizeWritten = folly::writevFull(fd, iov, iovCount);
+    folly::checkUnixError(
+        sizeWritten,
+        "error writing to overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_);
+  });
+}
+
+folly::File FsOverlay::createOverlayFileImpl(
+    InodeNumber inodeNumber,
+    folly::FunctionRef<void(int fd)> writeContents) {
   // We do not use mkstemp() to create the temporary file, since there is no
   // mkstempat() equivalent that can create files relative to dirFile.  We
   // simply create the file with a fixed suffix, and do not use O_EXCL.  This
@@ -499,13 +577,7 @@ folly::File FsOverlay::createOverlayFileImpl(
     }
   };
 
-  auto sizeWritten = folly::writevFull(tmpFD, iov, iovCount);
-  folly::checkUnixError(
-      sizeWritten,
-      "error writing to overlay file for inode ",
-      inodeNumber,
-      " in ",
-      localDir_);
+  writeContents(tmpFD);
 
   // fdatasync() is required to ensure that we are really reliably and
   // atomically writing out the new file.  Without calling fdatasync() the file
@@ -582,6 +654,132 @@ folly::File FsOverlay::createOverlayFile(
   return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
 }
 
+folly::File FsOverlay::createOverlayFileFromBlob(
+    InodeNumber inodeNumber,
+    const ObjectId& blobId,
+    const IOBuf& contents) {
+  uint64_t fileSize = kHeaderLength + contents.computeChainDataLength();
+  if (!blobFileCache_) {
+    auto file = createOverlayFile(inodeNumber, contents);
+    bytesCopied_.fetch_add(fileSize, std::memory_order_relaxed);
+    return file;
+  }
+
+  auto copyResult = BlobFileCache::CopyResult::Missing;
+  auto file = createOverlayFileImpl(inodeNumber, [&](int fd) {
+    try {
+      copyResult = blobFileCache_->copyTo(blobId, fd);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to copy blob " << blobId
+                 << " from the blob file cache: " << ex.what();
+      folly::checkUnixError(
+          ftruncate(fd, 0),
+          "error truncating overlay file for inode ",
+          inodeNumber,
+          " in ",
+          localDir_);
+    }
+    if (copyResult != BlobFileCache::CopyResult::Missing) {
+      return;
+    }
+
+    auto header = createHeader(kHeaderIdentifierFile, kHeaderVersion);
+    fbvector<struct iovec> iov;
+    iov.resize(1);
+    iov[0].iov_base = header.data();
+    iov[0].iov_len = header.size();
+    contents.appendToIov(&iov);
+    auto sizeWritten = folly::writevFull(fd, iov.data(), iov.size());
+    folly::checkUnixError(
+        sizeWritten,
+        "error writing to overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_);
+  });
+
+  if (copyResult == BlobFileCache::CopyResult::Cloned) {
+    bytesCloned_.fetch_add(fileSize, std::memory_order_relaxed);
+    return file;
+  }
+  bytesCopied_.fetch_add(fileSize, std::memory_order_relaxed);
+
+  // Caching a copy of every materialized file is only worth it when the copy
+  // shares its data with the overlay file.
+  if (copyResult == BlobFileCache::CopyResult::Missing &&
+      blobFileCacheInserts_.load(std::memory_order_relaxed)) {
+    try {
+      if (blobFileCache_->insert(blobId, file.fd(), fileSize) ==
+          BlobFileCache::CopyResult::Copied) {
+        XLOG(INFO) << "the filesystem of " << localDir_
+                   << " does not support cloning files, no longer adding "
+                      "blobs to the blob file cache";
+        blobFileCacheInserts_.store(false, std::memory_order_relaxed);
+      }
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to add blob " << blobId
+                 << " to the blob file cache: " << ex.what();
+    }
+  }
+  return file;
+}
+
+IOverlay::FileCopyStats FsOverlay::getFileCopyStats() const {
+  return FileCopyStats{
+      bytesCloned_.load(std::memory_order_relaxed),
+      bytesCopied_.load(std::memory_order_relaxed),
+      bytesDeduplicated_.load(std::memory_order_relaxed)};
+}
+
+bool FsOverlay::deduplicateFile(int fd, const Hash20& sha1) {
+  if (!dedupStore_ || !dedupSupported_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return false;
+  }
+  // Data is shared by whole filesystem blocks, so smaller files have nothing
+  // to share.
+  uint64_t fileSize = st.st_size;
+  if (fileSize < static_cast<uint64_t>(st.st_blksize)) {
+    return false;
+  }
+
+  // The store's copies are complete overlay files, which all have the same
+  // header, so the whole file can be shared.
+  ObjectId id{sha1.getBytes()};
+  try {
+    if (dedupStore_->deduplicate(id, fd, fileSize) ==
+        BlobFileCache::CopyResult::Cloned) {
+      bytesDeduplicated_.fetch_add(fileSize, std::memory_order_relaxed);
+      return true;
+    }
+    if (dedupStore_->insert(id, fd, fileSize) ==
+        BlobFileCache::CopyResult::Copied) {
+      XLOG(INFO) << "the filesystem of " << localDir_
+                 << " does not support cloning files, no longer "
+                    "deduplicating overlay files";
+      dedupSupported_.store(false, std::memory_order_relaxed);
+    }
+  } catch (const std::system_error& ex) {
+    auto error = ex.code().value();
+    if (error == EOPNOTSUPP || error == EINVAL || error == ENOTTY ||
+        error == ENOSYS) {
+      XLOG(INFO) << "the filesystem of " << localDir_
+                 << " does not support deduplicating files, no longer "
+                    "deduplicating overlay files: "
+                 << ex.what();
+      dedupSupported_.store(false, std::memory_order_relaxed);
+    } else {
+      XLOG(WARN) << "failed to deduplicate overlay file: " << ex.what();
+    }
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "failed to deduplicate overlay file: " << ex.what();
+  }
+  return false;
+}
+
 void FsOverlay::validateHeader(
     InodeNumber inodeNumber,
     folly::StringPiece contents,
@@ -625,6 +823,12 @@ void FsOverlay::validateHeader(
 }
 
 void FsOverlay::removeOverlayData(InodeNumber inodeNumber) {
+  if (directoryLog_ && directoryLog_->remove(inodeNumber)) {
+    XLOG(DBG4) << "removed packed overlay data for inode " << inodeNumber;
+  }
+
+  // A directory may still have a file if it was never loaded since the log
+  // was enabled.
   auto path = getFilePath(inodeNumber);
   int result = ::unlinkat(dirFile_.fd(), path.c_str(), 0);
   if (result == 0) {
@@ -651,6 +855,9 @@ bool FsOverlay::hasOverlayData(InodeNumber inodeNumber) {
   // TODO: It might be worth maintaining a memory-mapped set to rapidly
   // query whether the overlay has an entry for a particular inode.  As it is,
   // this function requires a syscall to see if the overlay has an entry.
+  if (directoryLog_ && directoryLog_->contains(inodeNumber)) {
+    return true;
+  }
   auto path = FsOverlay::getFilePath(inodeNumber);
   struct stat st;
   if (0 == fstatat(dirFile_.fd(), path.c_str(), &st, AT_SYMLINK_NOFOLLOW)) {
@@ -660,6 +867,13 @@ bool FsOverlay::hasOverlayData(InodeNumber inodeNumber) {
   }
 }
 
+void FsOverlay::forEachPackedDir(
+    folly::FunctionRef<void(InodeNumber, folly::ByteRange)> fn) const {
+  if (directoryLog_) {
+    directoryLog_->forEach(fn);
+  }
+}
+
 InodePath::InodePath() noexcept : path_{'\0'} {}
 
 const char* InodePath::c_str() const noexcept {
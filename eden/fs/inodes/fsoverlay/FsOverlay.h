@@ -8,13 +8,18 @@
 #pragma once
 
 #include <folly/File.h>
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <gtest/gtest_prod.h>
 #include <array>
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <optional>
 #include "eden/fs/inodes/IOverlay.h"
 #include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/fsoverlay/BlobFileCache.h"
+#include "eden/fs/inodes/fsoverlay/DirectoryLog.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -40,7 +45,28 @@ class InodePath;
  */
 class FsOverlay : public IOverlay {
  public:
-  explicit FsOverlay(AbsolutePathPiece localDir) : localDir_{localDir} {}
+  /**
+   * If `blobFileCacheSize` is not 0, materialized files are cloned from, and
+   * added to, a cache of up to this many bytes of blob contents kept in the
+   * overlay directory. See BlobFileCache.
+   *
+   * If `packedDirectories` is true, or if directories were packed by a
+   * previous user of the overlay, directories are stored in a DirectoryLog
+   * instead of in individual files.
+   *
+   * If `dedupStoreSize` is not 0, overlay files are deduplicated against a
+   * store of up to this many bytes of file contents, keyed by their SHA-1.
+   * See deduplicateFile().
+   */
+  explicit FsOverlay(
+      AbsolutePathPiece localDir,
+      uint64_t blobFileCacheSize = 0,
+      bool packedDirectories = false,
+      uint64_t dedupStoreSize = 0)
+      : localDir_{localDir},
+        blobFileCacheSize_{blobFileCacheSize},
+        packedDirectories_{packedDirectories},
+        dedupStoreSize_{dedupStoreSize} {}
 
   bool supportsSemanticOperations() const override {
     return false;
@@ -156,6 +182,21 @@ class FsOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  folly::File createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) override;
+
+  FileCopyStats getFileCopyStats() const override;
+
+  /**
+   * Share the data of the overlay file with the copy of its contents in the
+   * dedup store, or add it to the store if there is none. This requires a
+   * filesystem that can share data between files, such as btrfs or XFS; on
+   * others, deduplication stops after the first attempt.
+   */
+  bool deduplicateFile(int fd, const Hash20& sha1) override;
+
   /**
    * Remove the overlay data associated with the passed InodeNumber.
    */
@@ -196,6 +237,13 @@ class FsOverlay : public IOverlay {
 
   bool hasOverlayData(InodeNumber inodeNumber) override;
 
+  /**
+   * Call `fn` with the serialized contents of every directory stored in the
+   * DirectoryLog, if directories are packed.
+   */
+  void forEachPackedDir(
+      folly::FunctionRef<void(InodeNumber, folly::ByteRange)> fn) const;
+
   static constexpr folly::StringPiece kMetadataFile{"metadata.table"};
 
   /**
@@ -237,6 +285,9 @@ class FsOverlay : public IOverlay {
 
   folly::File
   createOverlayFileImpl(InodeNumber inodeNumber, iovec* iov, size_t iovCount);
+  folly::File createOverlayFileImpl(
+      InodeNumber inodeNumber,
+      folly::FunctionRef<void(int fd)> writeContents);
 
  private:
   /** Path to ".eden/CLIENT/local" */
@@ -257,6 +308,23 @@ class FsOverlay : public IOverlay {
    * We maintain this so we can use openat(), unlinkat(), etc.
    */
   folly::File dirFile_;
+
+  const uint64_t blobFileCacheSize_;
+  std::unique_ptr<BlobFileCache> blobFileCache_;
+  /// Cleared once the overlay's filesystem is found not to clone files.
+  std::atomic<bool> blobFileCacheInserts_{true};
+
+  const bool packedDirectories_;
+  std::unique_ptr<DirectoryLog> directoryLog_;
+
+  const uint64_t dedupStoreSize_;
+  std::unique_ptr<BlobFileCache> dedupStore_;
+  /// Cleared once the overlay's filesystem is found not to share file data.
+  std::atomic<bool> dedupSupported_{true};
+  std::atomic<uint64_t> bytesDeduplicated_{0};
+
+  std::atomic<uint64_t> bytesCloned_{0};
+  std::atomic<uint64_t> bytesCopied_{0};
 };
 
 class InodePath {
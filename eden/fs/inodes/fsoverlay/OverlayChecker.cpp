@@ -13,6 +13,10 @@
 #include <fcntl.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #include <folly/Conv.h>
 #include <folly/ExceptionWrapper.h>
@@ -309,8 +313,13 @@ class OverlayChecker::InodeDataError : public OverlayChecker::Error {
     ensureDirectoryExists(outputPath.dirname());
     auto srcPath = repair.fs()->getAbsoluteFilePath(number_);
     auto ret = ::rename(srcPath.c_str(), outputPath.c_str());
-    folly::checkUnixError(
-        ret, "failed to rename inode data ", srcPath, " to ", outputPath);
+    if (ret != 0 && errno == ENOENT) {
+      // Packed directories have no file of their own to move.
+      repair.fs()->removeOverlayData(number_);
+    } else {
+      folly::checkUnixError(
+          ret, "failed to rename inode data ", srcPath, " to ", outputPath);
+    }
 
     // Create replacement data for this inode in the overlay.
     const auto& inodes = repair.checker()->inodes_;
@@ -654,8 +663,11 @@ class OverlayChecker::BadNextInodeNumber : public OverlayChecker::Error {
 
 OverlayChecker::OverlayChecker(
     FsOverlay* fs,
-    optional<InodeNumber> nextInodeNumber)
-    : fs_(fs), loadedNextInodeNumber_(nextInodeNumber) {}
+    optional<InodeNumber> nextInodeNumber,
+    size_t numScanThreads)
+    : fs_(fs),
+      loadedNextInodeNumber_(nextInodeNumber),
+      numScanThreads_(numScanThreads) {}
 
 OverlayChecker::~OverlayChecker() {}
 
@@ -857,26 +869,90 @@ PathComponent OverlayChecker::findChildName(
 }
 
 void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
-  // Walk through all of the sharded subdirectories
+  std::vector<ShardScan> shards(FsOverlay::kNumShards);
+  std::atomic<ShardID> nextShard{0};
+  std::atomic<size_t> inodesScanned{0};
+
+  // Progress is reported by whichever thread completes the shard that makes
+  // it reach the next 10%.
+  std::mutex progressMutex;
   uint32_t progress10pct = 0;
-  std::array<char, 2> subdirBuffer;
-  MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
-  for (uint32_t shardID = 0; shardID < FsOverlay::kNumShards; ++shardID) {
-    // Log a INFO message every 10% done
-    uint32_t progress = (10 * shardID) / FsOverlay::kNumShards;
-    if (progress > progress10pct) {
+  uint32_t shardsDone = 0;
+  auto shardDone = [&] {
+    std::lock_guard<std::mutex> guard{progressMutex};
+    uint32_t progress = (10 * ++shardsDone) / FsOverlay::kNumShards;
+    if (progress > progress10pct && progress < 10) {
       XLOG(INFO) << "fsck:" << fs_->getLocalDir() << ": scan " << progress
-                 << "0% complete: " << inodes_.size() << " inodes scanned";
+                 << "0% complete: " << inodesScanned.load()
+                 << " inodes scanned";
       if (auto callback = progressCallback) {
         callback(progress);
       }
       progress10pct = progress;
     }
-    FsOverlay::formatSubdirShardPath(shardID, subdir);
-    auto subdirPath = fs_->getLocalDir() + PathComponentPiece{subdir};
+  };
+
+  // Walk through all of the sharded subdirectories
+  auto scanShards = [&] {
+    std::array<char, 2> subdirBuffer;
+    MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
+    for (auto shardID = nextShard++; shardID < FsOverlay::kNumShards;
+         shardID = nextShard++) {
+      FsOverlay::formatSubdirShardPath(shardID, subdir);
+      auto subdirPath = fs_->getLocalDir() + PathComponentPiece{subdir};
+
+      auto& scan = shards[shardID];
+      readInodeSubdir(subdirPath, shardID, scan);
+      inodesScanned += scan.inodes.size();
+      shardDone();
+    }
+  };
 
-    readInodeSubdir(subdirPath, shardID);
+  auto numThreads =
+      std::clamp<size_t>(numScanThreads_, 1, FsOverlay::kNumShards);
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (size_t n = 1; n < numThreads; ++n) {
+    threads.emplace_back(scanShards);
+  }
+  scanShards();
+  for (auto& thread : threads) {
+    thread.join();
   }
+
+  // Merge in shard order, so that errors are reported in the same order
+  // however many threads scanned the overlay.
+  for (auto& scan : shards) {
+    if (scan.maxInodeNumber > maxInodeNumber_) {
+      maxInodeNumber_ = scan.maxInodeNumber;
+    }
+    for (auto& info : scan.inodes) {
+      auto number = info.number;
+      inodes_.emplace(number, std::move(info));
+    }
+    for (auto& error : scan.errors) {
+      addError(std::move(error));
+    }
+  }
+
+  // Packed directories supersede any file left from before they were packed.
+  fs_->forEachPackedDir([this](InodeNumber number, ByteRange contents) {
+    updateMaxInodeNumber(number);
+    try {
+      inodes_.insert_or_assign(
+          number,
+          InodeInfo(
+              number,
+              CompactSerializer::deserialize<overlay::OverlayDir>(contents)));
+    } catch (const std::exception& ex) {
+      addError<InodeDataError>(
+          number,
+          "error parsing directory contents: ",
+          folly::exceptionStr(ex));
+      inodes_.insert_or_assign(number, InodeInfo(number, InodeType::Error));
+    }
+  });
+
   if (auto callback = progressCallback) {
     callback(10);
   }
@@ -886,14 +962,15 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
 
 void OverlayChecker::readInodeSubdir(
     const AbsolutePath& path,
-    ShardID shardID) {
+    ShardID shardID,
+    ShardScan& scan) {
   XLOG(DBG5) << "fsck:" << fs_->getLocalDir() << ": scanning " << path;
 
   boost::system::error_code error;
   auto boostPath = boost::filesystem::path{path.value().c_str()};
   auto iterator = boost::filesystem::directory_iterator(boostPath, error);
   if (error.value() != 0) {
-    addError<ShardDirectoryEnumerationError>(path, error);
+    scan.addError<ShardDirectoryEnumerationError>(path, error);
     return;
   }
 
@@ -904,37 +981,42 @@ void OverlayChecker::readInodeSubdir(
     auto entryInodeNumber =
         folly::tryTo<uint64_t>(inodePath.basename().value());
     if (entryInodeNumber.hasValue()) {
-      loadInode(InodeNumber(*entryInodeNumber), shardID);
+      loadInode(InodeNumber(*entryInodeNumber), shardID, scan);
     } else {
-      addError<UnexpectedOverlayFile>(inodePath);
+      scan.addError<UnexpectedOverlayFile>(inodePath);
     }
 
     iterator.increment(error);
     if (error.value() != 0) {
-      addError<ShardDirectoryEnumerationError>(path, error);
+      scan.addError<ShardDirectoryEnumerationError>(path, error);
       break;
     }
   }
 }
 
-void OverlayChecker::loadInode(InodeNumber number, ShardID shardID) {
+void OverlayChecker::loadInode(
+    InodeNumber number,
+    ShardID shardID,
+    ShardScan& scan) {
   XLOG(DBG9) << "fsck: loading inode " << number;
-  updateMaxInodeNumber(number);
+  scan.maxInodeNumber = std::max(scan.maxInodeNumber, number.get());
 
   // Verify that we found this inode in the correct shard subdirectory.
   // Ignore the data if it is in the wrong directory.
   ShardID expectedShard = static_cast<ShardID>(number.get() & 0xff);
   if (expectedShard != shardID) {
-    addError<UnexpectedInodeShard>(number, shardID);
+    scan.addError<UnexpectedInodeShard>(number, shardID);
     return;
   }
 
-  inodes_.emplace(number, loadInodeInfo(number));
+  scan.inodes.push_back(loadInodeInfo(number, scan));
 }
 
-OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(InodeNumber number) {
-  auto inodeError = [this, number](auto&&... args) {
-    addError<InodeDataError>(number, args...);
+OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(
+    InodeNumber number,
+    ShardScan& scan) {
+  auto inodeError = [&scan, number](auto&&... args) {
+    scan.addError<InodeDataError>(number, args...);
     return InodeInfo(number, InodeType::Error);
   };
 
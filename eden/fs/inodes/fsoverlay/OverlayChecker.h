@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <folly/CppAttributes.h>
 #include <folly/small_vector.h>
@@ -56,8 +57,14 @@ class OverlayChecker {
    * The OverlayChecker stores a raw pointer to the FsOverlay for the duration
    * of the check operation.  The caller is responsible for ensuring that the
    * FsOverlay object exists for at least as long as the OverlayChecker object.
+   *
+   * scanForErrors() reads the overlay's shard directories from
+   * `numScanThreads` threads.
    */
-  OverlayChecker(FsOverlay* fs, std::optional<InodeNumber> nextInodeNumber);
+  OverlayChecker(
+      FsOverlay* fs,
+      std::optional<InodeNumber> nextInodeNumber,
+      size_t numScanThreads = 1);
 
   ~OverlayChecker();
 
@@ -187,10 +194,30 @@ class OverlayChecker {
   PathInfo cachedPathComputation(InodeNumber number, Fn&& fn);
 
   using ShardID = uint32_t;
+
+  /**
+   * What was found in one shard directory. Shards are scanned in parallel,
+   * and their results merged in shard order afterwards.
+   */
+  struct ShardScan {
+    template <typename ErrorType, typename... Args>
+    void addError(Args&&... args) {
+      errors.push_back(
+          std::make_unique<ErrorType>(std::forward<Args>(args)...));
+    }
+
+    std::vector<InodeInfo> inodes;
+    std::vector<std::unique_ptr<Error>> errors;
+    uint64_t maxInodeNumber{0};
+  };
+
   void readInodes(const ProgressCallback& progressCallback = [](auto) {});
-  void readInodeSubdir(const AbsolutePath& path, ShardID shardID);
-  void loadInode(InodeNumber number, ShardID shardID);
-  InodeInfo loadInodeInfo(InodeNumber number);
+  void readInodeSubdir(
+      const AbsolutePath& path,
+      ShardID shardID,
+      ShardScan& scan);
+  void loadInode(InodeNumber number, ShardID shardID, ShardScan& scan);
+  InodeInfo loadInodeInfo(InodeNumber number, ShardScan& scan);
   overlay::OverlayDir loadDirectoryChildren(folly::File& file);
 
   void linkInodeChildren();
@@ -211,6 +238,7 @@ class OverlayChecker {
 
   FsOverlay* const fs_;
   std::optional<InodeNumber> loadedNextInodeNumber_;
+  const size_t numScanThreads_;
   std::unordered_map<InodeNumber, InodeInfo> inodes_;
   std::vector<std::unique_ptr<Error>> errors_;
   uint64_t maxInodeNumber_{kRootNodeId.get()};
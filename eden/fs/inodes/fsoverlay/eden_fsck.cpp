@@ -23,6 +23,7 @@ DEFINE_bool(
     dry_run,
     false,
     "Only report errors, without attempting to fix any problems");
+DEFINE_uint32(threads, 8, "Number of threads scanning the overlay");
 
 using namespace facebook::eden;
 
@@ -49,7 +50,7 @@ int main(int argc, char** argv) {
     XLOG(INFO) << "Overlay was shut down uncleanly";
   }
 
-  OverlayChecker checker(&fsOverlay.value(), nextInodeNumber);
+  OverlayChecker checker(&fsOverlay.value(), nextInodeNumber, FLAGS_threads);
   checker.scanForErrors();
   if (FLAGS_dry_run) {
     checker.logErrors();
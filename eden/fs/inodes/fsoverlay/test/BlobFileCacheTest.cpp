@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifdef __linux__
+
+#include "eden/fs/inodes/fsoverlay/BlobFileCache.h"
+
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+const auto blobA =
+    ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto blobB =
+    ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto blobC =
+    ObjectId::fromHex("0000000000000000000000000000000000000003");
+
+class BlobFileCacheTest : public ::testing::Test {
+ protected:
+  BlobFileCacheTest()
+      : tmpDir_{makeTempDir()},
+        dir_{tmpDir_.path().string(), O_RDONLY | O_DIRECTORY} {}
+
+  std::unique_ptr<BlobFileCache> open(uint64_t maxBytes) {
+    return BlobFileCache::open(dir_.fd(), "cache", maxBytes);
+  }
+
+  folly::File makeFile(const std::string& name, folly::StringPiece contents) {
+    auto path = (tmpDir_.path() / name).string();
+    folly::writeFile(contents, path.c_str());
+    return folly::File{path, O_RDONLY};
+  }
+
+  folly::File makeEmptyFile(const std::string& name) {
+    return folly::File{(tmpDir_.path() / name).string(), O_RDWR | O_CREAT};
+  }
+
+  void insert(
+      BlobFileCache& cache,
+      const ObjectId& id,
+      folly::StringPiece contents) {
+    auto file = makeFile(id.asHexString(), contents);
+    EXPECT_NE(
+        BlobFileCache::CopyResult::Missing,
+        cache.insert(id, file.fd(), contents.size()));
+  }
+
+  std::optional<std::string> read(BlobFileCache& cache, const ObjectId& id) {
+    auto name = "out-" + id.asHexString();
+    auto file = makeEmptyFile(name);
+    if (cache.copyTo(id, file.fd()) == BlobFileCache::CopyResult::Missing) {
+      return std::nullopt;
+    }
+    std::string contents;
+    folly::readFile((tmpDir_.path() / name).string().c_str(), contents);
+    return contents;
+  }
+
+  folly::test::TemporaryDirectory tmpDir_;
+  folly::File dir_;
+};
+
+} // namespace
+
+TEST_F(BlobFileCacheTest, copiesCachedBlobs) {
+  auto cache = open(100);
+  EXPECT_EQ(std::nullopt, read(*cache, blobA));
+
+  insert(*cache, blobA, "contents of a");
+  EXPECT_EQ("contents of a", read(*cache, blobA));
+  EXPECT_EQ(13, cache->getTotalBytes());
+
+  // Inserting a blob twice keeps the first copy.
+  auto file = makeFile("other", "other");
+  EXPECT_EQ(
+      BlobFileCache::CopyResult::Missing, cache->insert(blobA, file.fd(), 5));
+  EXPECT_EQ("contents of a", read(*cache, blobA));
+}
+
+TEST_F(BlobFileCacheTest, evictsLeastRecentlyUsedBlobs) {
+  auto cache = open(10);
+  insert(*cache, blobA, "aaaaaa");
+  insert(*cache, blobB, "bbbb");
+  EXPECT_EQ("aaaaaa", read(*cache, blobA));
+
+  insert(*cache, blobC, "cccc");
+  EXPECT_EQ(std::nullopt, read(*cache, blobB));
+  EXPECT_EQ("aaaaaa", read(*cache, blobA));
+  EXPECT_EQ("cccc", read(*cache, blobC));
+  EXPECT_EQ(10, cache->getTotalBytes());
+
+  // Blobs larger than the cache are not added.
+  auto file = makeFile("big", "01234567890");
+  EXPECT_EQ(
+      BlobFileCache::CopyResult::Missing, cache->insert(blobB, file.fd(), 11));
+}
+
+TEST_F(BlobFileCacheTest, reloadsCachedBlobsWhenReopened) {
+  insert(*open(100), blobA, "contents of a");
+  makeFile("cache/" + blobB.asHexString() + ".tmp", "partial");
+  makeFile("cache/not-a-blob", "junk");
+
+  auto cache = open(100);
+  EXPECT_EQ("contents of a", read(*cache, blobA));
+  EXPECT_EQ(13, cache->getTotalBytes());
+
+  // Reopening with a smaller size evicts.
+  cache.reset();
+  cache = open(5);
+  EXPECT_EQ(std::nullopt, read(*cache, blobA));
+  EXPECT_EQ(0, cache->getTotalBytes());
+}
+
+TEST_F(BlobFileCacheTest, deduplicatesIdenticalFiles) {
+  auto cache = open(1 << 20);
+  std::string contents(64 * 1024, 'a');
+  insert(*cache, blobA, contents);
+
+  auto dstPath = (tmpDir_.path() / "dst").string();
+  folly::writeFile(contents, dstPath.c_str());
+  folly::File dst{dstPath, O_RDWR};
+  EXPECT_EQ(
+      BlobFileCache::CopyResult::Missing,
+      cache->deduplicate(blobB, dst.fd(), contents.size()));
+  EXPECT_EQ(
+      BlobFileCache::CopyResult::Missing,
+      cache->deduplicate(blobA, dst.fd(), contents.size() - 1));
+
+  BlobFileCache::CopyResult result;
+  try {
+    result = cache->deduplicate(blobA, dst.fd(), contents.size());
+  } catch (const std::system_error&) {
+    GTEST_SKIP() << "the filesystem can't share data between files";
+  }
+  EXPECT_EQ(BlobFileCache::CopyResult::Cloned, result);
+  std::string dstContents;
+  folly::readFile(dstPath.c_str(), dstContents);
+  EXPECT_EQ(contents, dstContents);
+
+  // Files whose contents differ from the cached copy are left alone.
+  auto otherPath = (tmpDir_.path() / "other").string();
+  folly::writeFile(std::string(contents.size(), 'b'), otherPath.c_str());
+  folly::File other{otherPath, O_RDWR};
+  EXPECT_EQ(
+      BlobFileCache::CopyResult::Missing,
+      cache->deduplicate(blobA, other.fd(), contents.size()));
+}
+
+#endif
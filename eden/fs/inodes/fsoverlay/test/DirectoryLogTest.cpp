@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/fsoverlay/DirectoryLog.h"
+
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+folly::ByteRange bytes(folly::StringPiece contents) {
+  return folly::ByteRange{contents};
+}
+
+class DirectoryLogTest : public ::testing::Test {
+ protected:
+  DirectoryLogTest()
+      : tmpDir_{makeTempDir()},
+        dir_{tmpDir_.path().string(), O_RDONLY | O_DIRECTORY} {}
+
+  std::unique_ptr<DirectoryLog> open(
+      uint64_t maxSegmentSize = DirectoryLog::kDefaultMaxSegmentSize) {
+    return DirectoryLog::open(dir_.fd(), "log", maxSegmentSize);
+  }
+
+  std::string segmentPath(uint64_t id) {
+    return (tmpDir_.path() / "log" / ("segment-" + std::to_string(id)))
+        .string();
+  }
+
+  folly::test::TemporaryDirectory tmpDir_;
+  folly::File dir_;
+};
+
+} // namespace
+
+TEST_F(DirectoryLogTest, saved_directories_survive_reopening) {
+  EXPECT_FALSE(DirectoryLog::exists(dir_.fd(), "log"));
+  {
+    auto log = open();
+    EXPECT_TRUE(DirectoryLog::exists(dir_.fd(), "log"));
+    log->save(InodeNumber{1}, bytes("root"));
+    log->save(InodeNumber{2}, bytes("first"));
+    log->save(InodeNumber{2}, bytes("second"));
+    log->save(InodeNumber{3}, bytes("removed"));
+    EXPECT_TRUE(log->remove(InodeNumber{3}));
+    EXPECT_FALSE(log->remove(InodeNumber{4}));
+    EXPECT_FALSE(log->saveIfMissing(InodeNumber{2}, bytes("stale")));
+    EXPECT_TRUE(log->saveIfMissing(InodeNumber{5}, bytes("migrated")));
+
+    EXPECT_EQ("second", log->load(InodeNumber{2}).value());
+    EXPECT_FALSE(log->contains(InodeNumber{3}));
+  }
+
+  auto log = open();
+  EXPECT_EQ("root", log->load(InodeNumber{1}).value());
+  EXPECT_EQ("second", log->load(InodeNumber{2}).value());
+  EXPECT_EQ(std::nullopt, log->load(InodeNumber{3}));
+  EXPECT_EQ("migrated", log->load(InodeNumber{5}).value());
+
+  size_t count = 0;
+  log->forEach([&](InodeNumber, folly::ByteRange) { ++count; });
+  EXPECT_EQ(3u, count);
+}
+
+TEST_F(DirectoryLogTest, torn_record_is_truncated) {
+  {
+    auto log = open();
+    log->save(InodeNumber{2}, bytes("intact"));
+  }
+  std::string segment;
+  ASSERT_TRUE(folly::readFile(segmentPath(1).c_str(), segment));
+  // Simulate a crash in the middle of appending a second record.
+  ASSERT_TRUE(folly::writeFile(
+      segment + segment.substr(0, segment.size() - 1),
+      segmentPath(1).c_str()));
+
+  {
+    auto log = open();
+    EXPECT_EQ("intact", log->load(InodeNumber{2}).value());
+    EXPECT_EQ(segment.size(), log->getStats().totalBytes);
+    log->save(InodeNumber{3}, bytes("appended"));
+  }
+
+  auto log = open();
+  EXPECT_EQ("intact", log->load(InodeNumber{2}).value());
+  EXPECT_EQ("appended", log->load(InodeNumber{3}).value());
+}
+
+TEST_F(DirectoryLogTest, compaction_removes_superseded_segments) {
+  constexpr uint64_t kMaxSegmentSize = 256;
+  {
+    auto log = open(kMaxSegmentSize);
+    log->save(InodeNumber{2}, bytes("kept"));
+    log->save(InodeNumber{3}, bytes("removed"));
+    log->remove(InodeNumber{3});
+    for (int i = 0; i < 100; ++i) {
+      log->save(InodeNumber{4}, bytes("version " + std::to_string(i)));
+    }
+    EXPECT_GT(log->getStats().segmentCount, 10u);
+
+    log->compact();
+    auto stats = log->getStats();
+    EXPECT_LE(stats.segmentCount, 3u);
+    EXPECT_EQ("kept", log->load(InodeNumber{2}).value());
+    EXPECT_EQ("version 99", log->load(InodeNumber{4}).value());
+  }
+
+  auto log = open(kMaxSegmentSize);
+  EXPECT_EQ("kept", log->load(InodeNumber{2}).value());
+  EXPECT_EQ(std::nullopt, log->load(InodeNumber{3}));
+  EXPECT_EQ("version 99", log->load(InodeNumber{4}).value());
+}
+
+#endif
@@ -435,6 +435,29 @@ TEST(Fsck, testBadFileData) {
   overlay->fs().close(checker.getNextInodeNumber());
 }
 
+TEST(Fsck, testParallelScan) {
+  auto overlay = make_shared<TestOverlay>();
+  auto root = overlay->init();
+  SimpleOverlayLayout layout(root);
+
+  std::string badHeader(FsOverlay::kHeaderLength, 0x55);
+  overlay->corruptInodeHeader(layout.src_foo_testTxt.number(), badHeader);
+  auto srcDataFile = overlay->fs().openFileNoVerify(layout.src.number());
+  folly::checkUnixError(ftruncate(srcDataFile.fd(), 0), "truncate failed");
+
+  OverlayChecker serial(&overlay->fs(), std::nullopt);
+  serial.scanForErrors();
+  OverlayChecker parallel(&overlay->fs(), std::nullopt, 8);
+  parallel.scanForErrors();
+
+  // Results are merged in shard order, so they match the serial scan's.
+  EXPECT_EQ(4, serial.getErrors().size());
+  EXPECT_EQ(errorMessages(serial), errorMessages(parallel));
+  EXPECT_EQ(serial.getNextInodeNumber(), parallel.getNextInodeNumber());
+
+  overlay->fs().close(parallel.getNextInodeNumber());
+}
+
 TEST(Fsck, testTruncatedDirData) {
   auto overlay = make_shared<TestOverlay>();
   auto root = overlay->init();
@@ -1425,6 +1425,62 @@ TEST(Checkout, testSetPathObjectIdCheckoutMultipleFiles) {
   EXPECT_FILE_INODE(testMount.getFileInode(path2), contents2, 0644);
 }
 
+TEST(Checkout, testSetPathObjectIds) {
+  // Start with an empty mount
+  auto builder1 = FakeTreeBuilder{};
+  TestMount testMount{builder1, false};
+
+  testMount.getBackingStore()->putBlob(ObjectId{"1"}, "one")->setReady();
+  testMount.getBackingStore()->putBlob(ObjectId{"2"}, "two")->setReady();
+  testMount.getBackingStore()->putBlob(ObjectId{"3"}, "three")->setReady();
+
+  auto builder2 = FakeTreeBuilder{};
+  builder2.setFile("sub/file.txt", "tree");
+  builder2.finalize(testMount.getBackingStore(), true);
+  auto commit2 = testMount.getBackingStore()->putCommit("4", builder2);
+  commit2->setReady();
+
+  // The files of dir are grafted together, on top of the tree grafted at dir,
+  // and the second object given for dir/b.txt replaces the first one.
+  std::vector<SetPathObjectIdObject> objects;
+  objects.push_back(SetPathObjectIdObject{
+      RelativePath{"dir/b.txt"},
+      RootId{"1"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+  objects.push_back(SetPathObjectIdObject{
+      RelativePath{"dir/a.txt"},
+      RootId{"1"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+  objects.push_back(SetPathObjectIdObject{
+      RelativePath{"dir"}, RootId{"4"}, facebook::eden::ObjectType::TREE});
+  objects.push_back(SetPathObjectIdObject{
+      RelativePath{"dir/b.txt"},
+      RootId{"2"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+  objects.push_back(SetPathObjectIdObject{
+      RelativePath{"other/c.txt"},
+      RootId{"3"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+
+  auto setPathObjectIdResultAndTimes =
+      testMount.getEdenMount()->setPathObjectIds(
+          std::move(objects),
+          facebook::eden::CheckoutMode::NORMAL,
+          ObjectFetchContext::getNullContext());
+
+  auto executor = testMount.getServerExecutor().get();
+  auto waitedSetPathObjectIdResultAndTimes =
+      std::move(setPathObjectIdResultAndTimes).waitVia(executor);
+  ASSERT_TRUE(waitedSetPathObjectIdResultAndTimes.isReady());
+  auto result = std::move(waitedSetPathObjectIdResultAndTimes).get();
+  EXPECT_EQ(0, result.result.conflicts_ref()->size());
+
+  EXPECT_FILE_INODE(testMount.getFileInode("dir/a.txt"), "one", 0644);
+  EXPECT_FILE_INODE(testMount.getFileInode("dir/b.txt"), "two", 0644);
+  EXPECT_FILE_INODE(testMount.getFileInode("dir/sub/file.txt"), "tree", 0644);
+  EXPECT_FILE_INODE(testMount.getFileInode("other/c.txt"), "three", 0644);
+}
+
 #endif
 
 template <typename Unloader>
@@ -1648,6 +1704,74 @@ TEST(Checkout, checkoutFailsOnInProgressCheckout) {
   EXPECT_NO_THROW(std::move(checkout2).get());
 }
 
+TEST(Checkout, cancelledCheckoutIsResumed) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("src/main.c", "// Some code.\n");
+  builder1.setFile("lib/util.c", "// Utilities.\n");
+  TestMount testMount{RootId("1"), builder1};
+
+  auto builder2 = FakeTreeBuilder();
+  builder2.setFile("src/main.c", "// More code.\n");
+  builder2.setFile("lib/util.c", "// More utilities.\n");
+  builder2.finalize(testMount.getBackingStore(), true);
+  auto commit2 = testMount.getBackingStore()->putCommit("2", builder2);
+  commit2->setReady();
+
+  // Keep the directories loaded, so that the checkout has to recurse into
+  // them rather than replace them.
+  auto src = testMount.getTreeInode("src"_relpath);
+  auto lib = testMount.getTreeInode("lib"_relpath);
+
+  // Cancel the checkout once it has updated the SNAPSHOT file.
+  auto& faultInjector = testMount.getServerState()->getFaultInjector();
+  faultInjector.injectBlock("inodeCheckout", ".*");
+  auto executor = testMount.getServerExecutor().get();
+  auto edenMount = testMount.getEdenMount();
+  auto checkout = edenMount->checkout(RootId{"2"}, std::nullopt, __func__);
+  executor->drain();
+  EXPECT_TRUE(edenMount->cancelCheckout());
+  EXPECT_EQ(1, faultInjector.unblock("inodeCheckout", ".*"));
+  faultInjector.removeFault("inodeCheckout", ".*");
+
+  try {
+    std::move(checkout).getVia(executor);
+    FAIL() << "checkout should have been cancelled";
+  } catch (const EdenError& exception) {
+    EXPECT_EQ(ECANCELED, exception.errorCode_ref().value_or(0));
+  }
+  EXPECT_FALSE(edenMount->cancelCheckout());
+  EXPECT_EQ("// Some code.\n", testMount.readFile("src/main.c"));
+  EXPECT_TRUE(
+      edenMount->getCheckoutConfig()->getParentCommit().isCheckoutInProgress());
+
+  // Only a checkout to the same commit may follow.
+  try {
+    edenMount->checkout(RootId{"1"}, std::nullopt, __func__).getVia(executor);
+    FAIL() << "checkout should have failed with "
+              "EdenErrorType::CHECKOUT_IN_PROGRESS";
+  } catch (const EdenError& exception) {
+    EXPECT_EQ(exception.get_errorType(), EdenErrorType::CHECKOUT_IN_PROGRESS);
+  }
+
+  // The interrupted checkout is remembered across restarts.
+  src.reset();
+  lib.reset();
+  edenMount.reset();
+  testMount.remount();
+
+  executor = testMount.getServerExecutor().get();
+  auto result = testMount.getEdenMount()
+                    ->checkout(RootId{"2"}, std::nullopt, __func__)
+                    .getVia(executor);
+  EXPECT_THAT(result.conflicts, UnorderedElementsAre());
+  EXPECT_EQ("// More code.\n", testMount.readFile("src/main.c"));
+  EXPECT_EQ("// More utilities.\n", testMount.readFile("lib/util.c"));
+  EXPECT_FALSE(testMount.getEdenMount()
+                   ->getCheckoutConfig()
+                   ->getParentCommit()
+                   .isCheckoutInProgress());
+}
+
 TEST(Checkout, changing_hash_scheme_does_not_conflict_if_contents_are_same) {
   TestMount mount;
   auto backingStore = mount.getBackingStore();
@@ -14,6 +14,7 @@
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 #include <chrono>
+#include <thread>
 
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/IObjectStore.h"
@@ -356,6 +357,36 @@ TEST_F(FileInodeTest, setattrMtimeMaterialized) {
   testSetattrMtime(mount_);
 }
 
+TEST_F(FileInodeTest, setattrCtimeFromWritebackCache) {
+  auto inode = mount_.getFileInode("dir/a.txt");
+  DesiredMetadata desired;
+
+  // The kernel reports the mtime and ctime it maintains with
+  // FUSE_WRITEBACK_CACHE.
+  timespec time;
+  time.tv_sec = 1234;
+  time.tv_nsec = 5678;
+  desired.mtime = time;
+  desired.ctime = time;
+
+  auto attr = setFileAttr(inode, desired);
+
+  BASIC_ATTR_XCHECKS(inode, attr);
+  EXPECT_EQ(1234, stCtime(attr).tv_sec);
+  EXPECT_EQ(5678, stCtime(attr).tv_nsec);
+
+  // Without it, ctime is the time of the change.
+  mount_.getClock().advance(10min);
+  desired.ctime.reset();
+
+  attr = setFileAttr(inode, desired);
+
+  BASIC_ATTR_XCHECKS(inode, attr);
+  EXPECT_EQ(
+      mount_.getClock().getTimePoint(),
+      folly::to<FakeClock::time_point>(stCtime(attr)));
+}
+
 namespace {
 bool isInodeMaterialized(const TreeInodePtr& inode) {
   return inode->getContents().wlock()->isMaterialized();
@@ -406,6 +437,61 @@ TEST_F(FileInodeTest, fallocate) {
 }
 #endif
 
+TEST_F(FileInodeTest, sha1IsUpdatedAfterAppendsAndOverwrites) {
+  auto inode = mount_.getFileInode("dir/a.txt");
+  auto& ctx = ObjectFetchContext::getNullContext();
+  auto expectSha1 = [&](const std::string& contents) {
+    EXPECT_EQ(Hash20::sha1(contents), inode->getSha1(ctx).get(0ms));
+  };
+
+  DesiredMetadata desired;
+  desired.size = 0;
+  (void)inode->setattr(desired, ctx).get(0ms);
+  inode->write("abcd"_sp, 0, ctx).get(0ms);
+  expectSha1("abcd");
+
+  // Appends extend the SHA-1 of the previous contents.
+  inode->write("efgh"_sp, 4, ctx).get(0ms);
+  expectSha1("abcdefgh");
+  inode->write("ij"_sp, 10, ctx).get(0ms);
+  expectSha1(std::string{"abcdefgh\0\0ij", 12});
+
+  inode->write("x"_sp, 0, ctx).get(0ms);
+  expectSha1(std::string{"xbcdefgh\0\0ij", 12});
+
+  desired.size = 2;
+  (void)inode->setattr(desired, ctx).get(0ms);
+  expectSha1("xb");
+}
+
+TEST_F(FileInodeTest, bufferedWritesAreVisibleToReads) {
+  mount_.getEdenConfig()->overlayWriteCoalescingDelay.setValue(
+      1ms, ConfigSource::CommandLine);
+  auto inode = mount_.getFileInode("dir/a.txt");
+  auto& ctx = ObjectFetchContext::getNullContext();
+
+  DesiredMetadata desired;
+  desired.size = 0;
+  (void)inode->setattr(desired, ctx).get(0ms);
+  EXPECT_EQ(2, inode->write("ab"_sp, 0, ctx).get(0ms));
+  EXPECT_EQ(2, inode->write("cd"_sp, 2, ctx).get(0ms));
+  EXPECT_EQ(4, getFileAttr(inode).st_size);
+  inode->write("ef"_sp, 4, ctx).get(0ms);
+  EXPECT_EQ(Hash20::sha1("abcdef"), inode->getSha1(ctx).get(0ms));
+
+  // A write that doesn't extend the buffered ones writes them out first.
+  inode->write("gh"_sp, 6, ctx).get(0ms);
+  inode->write("x"_sp, 0, ctx).get(0ms);
+  EXPECT_EQ("xbcdefgh", inode->readAll(ctx).get(0ms));
+
+  // Wait for the scheduled flush, which holds a reference to the inode.
+  inode->write("ij"_sp, 8, ctx).get(0ms);
+  for (int i = 0; i < 1000 && mount_.drainServerExecutor() == 0; ++i) {
+    /* sleep override */ std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ("xbcdefghij", inode->readAll(ctx).get(0ms));
+}
+
 TEST(FileInode, truncatingDuringLoad) {
   FakeTreeBuilder builder;
   builder.setFiles({{"notready.txt", "Contents not ready.\n"}});
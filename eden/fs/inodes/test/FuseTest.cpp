@@ -190,4 +190,43 @@ TEST(FuseTest, destroyWithInitRace) {
   }
 }
 
+TEST(FuseTest, deferredInitializationRunsOnFirstRequest) {
+  auto builder = FakeTreeBuilder();
+  builder.setFile("src/main.c", "int main() { return 0; }\n");
+  TestMount testMount;
+  testMount.createMountWithoutInitializing(builder);
+  auto& mount = testMount.getEdenMount();
+  ASSERT_TRUE(mount->deferInitialization([](auto) {}));
+
+  auto fuse = make_shared<FakeFuse>();
+  testMount.startFuseAndWait(fuse);
+  EXPECT_EQ(EdenMount::State::UNINITIALIZED, mount->getState());
+
+  // The first request waits for the mount to be initialized.
+  auto reqID =
+      fuse->sendRequest(FUSE_GETATTR, kRootNodeId.get(), fuse_getattr_in{});
+  auto deadline = std::chrono::steady_clock::now() + kWaitTimeout;
+  do {
+    if (std::chrono::steady_clock::now() > deadline) {
+      FAIL() << "mount not initialized within timeout";
+    }
+    testMount.drainServerExecutor();
+  } while (mount->getState() != EdenMount::State::RUNNING);
+
+  auto response = fuse->recvResponse();
+  EXPECT_EQ(reqID, response.header.unique);
+  EXPECT_EQ(0, response.header.error);
+  EXPECT_TRUE(mount->getRootInode());
+
+  fuse->close();
+  auto fuseCompletionFuture = mount->getChannelCompletionFuture();
+  deadline = std::chrono::steady_clock::now() + kWaitTimeout;
+  do {
+    if (std::chrono::steady_clock::now() > deadline) {
+      FAIL() << "fuse completion future not ready within timeout";
+    }
+    testMount.drainServerExecutor();
+  } while (!fuseCompletionFuture.isReady());
+}
+
 #endif
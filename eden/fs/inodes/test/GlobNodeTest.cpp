@@ -7,17 +7,20 @@
 
 #include "eden/fs/inodes/GlobNode.h"
 
+#include <functional>
 #include <utility>
 
 #include <folly/Conv.h>
 #include <folly/Exception.h>
 #include <folly/Range.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/NameIndex.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
 #include "eden/fs/testharness/TestChecks.h"
@@ -40,8 +43,7 @@ folly::Future<std::vector<GlobResult>> evaluateGlob(
     const RootId& commitHash) {
   auto rootInode = mount.getTreeInode(RelativePathPiece());
   auto objectStore = mount.getEdenMount()->getObjectStore();
-  auto globResults = std::make_shared<
-      folly::Synchronized<std::vector<GlobNode::GlobResult>>>();
+  auto globResults = std::make_shared<GlobNode::ResultList>();
   return globRoot
       .evaluate(
           objectStore,
@@ -305,6 +307,23 @@ TEST_P(GlobNodeTest, matchLiteralDirectoryAndDirectoryRecursiveChildren) {
   EXPECT_EQ(expect, matches);
 }
 
+TEST_P(GlobNodeTest, matchSeveralWildcardPatternsInOneDirectory) {
+  GlobNode globRoot(/*includeDotfiles=*/false);
+  globRoot.parse("dir/*.txt");
+  globRoot.parse("dir/s*");
+  globRoot.parse("dir/[ab].txt");
+  globRoot.parse("dir/*/*");
+
+  auto matches = doGlob(globRoot, kZeroRootId);
+  EXPECT_THAT(
+      matches,
+      testing::UnorderedElementsAre(
+          GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+          GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+          GlobResult("dir/sub"_relpath, dtype_t::Dir, kZeroRootId),
+          GlobResult("dir/sub/b.txt"_relpath, dtype_t::Regular, kZeroRootId)));
+}
+
 const std::pair<enum StartReady, enum Prefetch> combinations[] = {
     {StartReady::Start, Prefetch::NoPrefetch},
     {StartReady::Start, Prefetch::PrefetchBlobs},
@@ -417,6 +436,172 @@ TEST(GlobNodeTest, treeLoadError) {
   }
 }
 
+TEST(GlobNodeTest, parallelEvaluationMatchesSerialEvaluation) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  for (auto dir : {"a", "b", "c", "a/x", "a/y", "b/x/z"}) {
+    for (auto file : {"1.py", "2.txt", "3.py"}) {
+      builder.setFile(folly::to<std::string>(dir, "/", file), file);
+    }
+  }
+  mount.initialize(builder);
+  auto objectStore = mount.getEdenMount()->getObjectStore();
+  auto rootTree = objectStore
+                      ->getRootTree(
+                          mount.getEdenMount()->getCheckedOutRootId(),
+                          ObjectFetchContext::getNullContext())
+                      .get(kSmallTimeout);
+
+  GlobNode globRoot(/*includeDotfiles=*/false);
+  globRoot.parse("**/*.py");
+  globRoot.parse("a/*/2.txt");
+
+  auto evaluate = [&](GlobNode::ParallelEvaluation* parallel) {
+    GlobNode::ResultList globResults;
+    globRoot
+        .evaluate(
+            objectStore,
+            ObjectFetchContext::getNullContext(),
+            RelativePathPiece(),
+            rootTree,
+            /*fileBlobsToPrefetch=*/nullptr,
+            globResults,
+            kZeroRootId,
+            parallel)
+        .get(kSmallTimeout);
+    auto results = std::move(*globResults.wlock());
+    std::sort(results.begin(), results.end());
+    return results;
+  };
+
+  auto serial = evaluate(nullptr);
+  EXPECT_EQ(14, serial.size());
+
+  folly::CPUThreadPoolExecutor executor{4};
+  GlobNode::ParallelEvaluation parallel{&executor, /*maxTreeLoads=*/1};
+  EXPECT_EQ(serial, evaluate(&parallel));
+}
+
+TEST(GlobNodeTest, chunkedResultListHandsOverResultsAsTheyAreFound) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  for (auto file : {"a.txt", "b.txt", "c.txt", "dir/d.txt", "dir/e.txt"}) {
+    builder.setFile(file, file);
+  }
+  mount.initialize(builder);
+
+  std::vector<size_t> chunkSizes;
+  std::vector<GlobResult> handedOver;
+  GlobNode::ResultList globResults{
+      2, [&](std::vector<GlobResult>&& chunk) {
+        chunkSizes.push_back(chunk.size());
+        handedOver.insert(handedOver.end(), chunk.begin(), chunk.end());
+      }};
+  GlobNode globRoot(/*includeDotfiles=*/false);
+  globRoot.parse("**/*.txt");
+  globRoot
+      .evaluate(
+          mount.getEdenMount()->getObjectStore(),
+          ObjectFetchContext::getNullContext(),
+          RelativePathPiece(),
+          mount.getTreeInode(RelativePathPiece()),
+          /*fileBlobsToPrefetch=*/nullptr,
+          globResults,
+          kZeroRootId)
+      .get(kSmallTimeout);
+  EXPECT_EQ(1, globResults.rlock()->size());
+  globResults.flush();
+  EXPECT_TRUE(globResults.rlock()->empty());
+
+  EXPECT_EQ((std::vector<size_t>{2, 2, 1}), chunkSizes);
+  std::sort(handedOver.begin(), handedOver.end());
+  std::vector<GlobResult> expected{
+      GlobResult("a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("b.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("c.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/d.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      GlobResult("dir/e.txt"_relpath, dtype_t::Regular, kZeroRootId)};
+  EXPECT_EQ(expected, handedOver);
+}
+
+TEST(GlobNodeTest, nameIndexMatchesTreeEvaluation) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  builder.setFile("BUCK", "root");
+  builder.setFile("a/BUCK", "a");
+  builder.setFile("a/b/TARGETS", "b");
+  builder.setFile(".hidden/BUCK", "hidden");
+  builder.setFile("c/BUCK/file", "dir");
+  mount.initialize(builder);
+  auto objectStore = mount.getEdenMount()->getObjectStore();
+  auto rootTree = objectStore
+                      ->getRootTree(
+                          mount.getEdenMount()->getCheckedOutRootId(),
+                          ObjectFetchContext::getNullContext())
+                      .get(kSmallTimeout);
+
+  std::vector<NameIndex::Entry> entries;
+  std::function<void(RelativePathPiece, const Tree&)> addTree =
+      [&](RelativePathPiece dir, const Tree& tree) {
+        for (const auto& entry : tree.getTreeEntries()) {
+          entries.emplace_back(dir + entry.getName(), entry);
+          if (entry.isTree()) {
+            auto subtree =
+                objectStore
+                    ->getTree(
+                        entry.getHash(), ObjectFetchContext::getNullContext())
+                    .get(kSmallTimeout);
+            addTree(dir + entry.getName(), *subtree);
+          }
+        }
+      };
+  addTree(RelativePathPiece{}, *rootTree);
+  NameIndex index{std::move(entries)};
+
+  for (auto includeDotfiles : {false, true}) {
+    GlobNode globRoot(includeDotfiles);
+    globRoot.parse("**/BUCK");
+    globRoot.parse("**/TARGETS");
+    ASSERT_TRUE(globRoot.canEvaluateFromNameIndex());
+
+    GlobNode::ResultList fromTree;
+    GlobNode::PrefetchList fromTreePrefetches;
+    globRoot
+        .evaluate(
+            objectStore,
+            ObjectFetchContext::getNullContext(),
+            RelativePathPiece(),
+            rootTree,
+            &fromTreePrefetches,
+            fromTree,
+            kZeroRootId)
+        .get(kSmallTimeout);
+    GlobNode::ResultList fromIndex;
+    GlobNode::PrefetchList fromIndexPrefetches;
+    EXPECT_TRUE(globRoot.evaluateFromNameIndex(
+        index, &fromIndexPrefetches, fromIndex, kZeroRootId));
+
+    auto expected = std::move(*fromTree.wlock());
+    auto actual = std::move(*fromIndex.wlock());
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(includeDotfiles ? 5 : 4, expected.size());
+    EXPECT_EQ(expected, actual);
+    EXPECT_THAT(
+        *fromIndexPrefetches.rlock(),
+        ::testing::UnorderedElementsAreArray(*fromTreePrefetches.rlock()));
+  }
+
+  GlobNode other(/*includeDotfiles=*/false);
+  other.parse("**/*.txt");
+  other.parse("a/BUCK");
+  EXPECT_FALSE(other.canEvaluateFromNameIndex());
+  GlobNode::ResultList results;
+  EXPECT_FALSE(
+      other.evaluateFromNameIndex(index, nullptr, results, kZeroRootId));
+  EXPECT_TRUE(results.rlock()->empty());
+}
+
 TEST_P(GlobNodeTest, testCommitHashSet) {
   const RootId randomHash{"37ce5515c1b313ce722366c31c10db0883fff7e0"};
 
@@ -7,9 +7,11 @@
 
 #include "eden/fs/inodes/InodeMap.h"
 
+#include <folly/Conv.h>
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -183,6 +185,87 @@ TEST(InodeMap, recursiveLookup) {
   EXPECT_EQ("a/b/c/d/file.txt"_relpath, fileInode->getPath().value());
 }
 
+TEST(InodeMap, lookupUnloadedInodeAcrossShards) {
+  auto builder = FakeTreeBuilder();
+  builder.setFile("a/b/c/d/file.txt", "this is a test file");
+  TestMount testMount{builder};
+  const auto& edenMount = testMount.getEdenMount();
+  auto inodeMap = edenMount->getInodeMap();
+
+  // Consecutive inode numbers map to different shards, so looking the file
+  // back up has to walk through the shard of each of its ancestors.
+  InodeNumber fileNumber;
+  {
+    auto file = testMount.getInode("a/b/c/d/file.txt"_relpath);
+    file->incFsRefcount();
+    fileNumber = file->getNodeId();
+  }
+  edenMount->getRootInode()->unloadChildrenNow();
+  EXPECT_FALSE(inodeMap->lookupLoadedInode(fileNumber));
+  EXPECT_EQ(
+      "a/b/c/d/file.txt"_relpath,
+      inodeMap->getPathForInode(fileNumber).value());
+
+  auto fileFuture = inodeMap->lookupInode(fileNumber)
+                        .semi()
+                        .via(&folly::QueuedImmediateExecutor::instance());
+  ASSERT_TRUE(fileFuture.isReady());
+  EXPECT_EQ(
+      "a/b/c/d/file.txt"_relpath,
+      std::move(fileFuture).get()->getPath().value());
+}
+
+TEST(InodeMap, unloadedInodeMemoryIsReported) {
+  auto builder = FakeTreeBuilder();
+  builder.setFile("a/b/file.txt", "this is a test file");
+  TestMount testMount{builder};
+  const auto& edenMount = testMount.getEdenMount();
+  auto inodeMap = edenMount->getInodeMap();
+
+  InodeNumber fileNumber;
+  std::optional<ObjectId> blobHash;
+  {
+    auto file = testMount.getFileInode("a/b/file.txt"_relpath);
+    file->incFsRefcount();
+    fileNumber = file->getNodeId();
+    blobHash = file->getBlobHash();
+  }
+  edenMount->getRootInode()->unloadChildrenNow();
+
+  auto counts = inodeMap->getInodeCounts();
+  EXPECT_EQ(3, counts.unloadedInodeCount);
+  EXPECT_GE(
+      counts.unloadedInodeMemory,
+      counts.unloadedInodeCount * (sizeof(InodeNumber) + blobHash->size()));
+
+  // The name and hash are still available once the inode is loaded again.
+  auto file = testMount.getFileInode("a/b/file.txt"_relpath);
+  EXPECT_EQ(fileNumber, file->getNodeId());
+  EXPECT_EQ(blobHash, file->getBlobHash());
+}
+
+TEST(InodeMap, concurrentLookupsOfLoadedInode) {
+  auto builder = FakeTreeBuilder();
+  builder.setFile("dir/file.txt", "this is a test file");
+  TestMount testMount{builder};
+  auto inodeMap = testMount.getEdenMount()->getInodeMap();
+  auto file = testMount.getInode("dir/file.txt"_relpath);
+  auto fileNumber = file->getNodeId();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 1000; ++j) {
+        auto inode = inodeMap->lookupInode(fileNumber).get();
+        EXPECT_EQ(file.get(), inode.get());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST(InodeMap, recursiveLookupError) {
   auto builder = FakeTreeBuilder();
   builder.setFile("a/b/c/d/file.txt", "this is a test file");
@@ -360,6 +443,47 @@ TEST(InodeMap, unloadedUnlinkedTreesAreRemovedFromOverlay) {
 #endif // !_WIN32
 }
 
+TEST(InodeMap, batchedFsRefcountDecrements) {
+  FakeTreeBuilder builder;
+  for (int i = 0; i < 8; ++i) {
+    builder.setFile(folly::to<std::string>("dir/file", i), "contents");
+  }
+  TestMount mount{builder};
+  auto edenMount = mount.getEdenMount();
+  auto inodeMap = edenMount->getInodeMap();
+  auto dir = mount.getTreeInode("dir"_relpath);
+
+  // Unlinked files that the kernel looked up twice. All but the first are
+  // unloaded, and so only remembered by the InodeMap.
+  std::vector<std::pair<InodeNumber, uint32_t>> counts;
+  InodePtr stillLoaded;
+  for (int i = 0; i < 8; ++i) {
+    auto name = PathComponent{folly::to<std::string>("file", i)};
+    auto file = mount.getFileInode(RelativePath{"dir"} + name);
+    file->incFsRefcount();
+    file->incFsRefcount();
+    counts.emplace_back(file->getNodeId(), 2);
+    dir->unlink(
+            name,
+            InvalidationRequired::No,
+            ObjectFetchContext::getNullContext())
+        .get(0ms);
+    if (i == 0) {
+      stillLoaded = file;
+    }
+  }
+  for (const auto& [ino, count] : counts) {
+    EXPECT_TRUE(inodeMap->isInodeRemembered(ino));
+  }
+
+  inodeMap->decFsRefcounts(counts);
+  mount.drainServerExecutor();
+  stillLoaded.reset();
+  for (const auto& [ino, count] : counts) {
+    EXPECT_FALSE(inodeMap->isInodeRemembered(ino));
+  }
+}
+
 #ifndef _WIN32
 
 TEST(InodeMap, unloadedFileMetadataIsForgotten) {
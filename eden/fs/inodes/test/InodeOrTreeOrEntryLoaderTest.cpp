@@ -147,3 +147,67 @@ TEST(InodeLoader, notReady) {
     EXPECT_EQ(Hash20::sha1("dir/sub/b.txt"), results[3].value());
   }
 }
+
+TEST(InodeLoader, sourceBlobId) {
+  FakeTreeBuilder builder;
+  builder.setFiles(FILES);
+  TestMount mount(builder);
+
+  auto rootInode = mount.getTreeInode(RelativePathPiece());
+  auto objectStore = mount.getEdenMount()->getObjectStore();
+  auto& fetchContext = ObjectFetchContext::getNullContext();
+
+  auto load = [&](std::vector<std::string> paths) {
+    return collectAll(applyToInodeOrTreeOrEntry(
+                          rootInode,
+                          paths,
+                          [](InodeOrTreeOrEntry entry) { return entry; },
+                          objectStore,
+                          fetchContext))
+        .get();
+  };
+
+  auto results = load({"dir/a.txt", "dir/sub"});
+  EXPECT_TRUE(results[0].value().getSourceBlobId().has_value());
+  EXPECT_FALSE(results[1].value().getSourceBlobId().has_value())
+      << "directories have no blob";
+
+  // A loaded inode still has the blob it was loaded from.
+  mount.getFileInode("dir/a.txt");
+  results = load({"dir/a.txt"});
+  EXPECT_TRUE(results[0].value().getSourceBlobId().has_value());
+
+  // Until it is materialized.
+  mount.overwriteFile("dir/a.txt", "modified");
+  results = load({"dir/a.txt"});
+  EXPECT_FALSE(results[0].value().getSourceBlobId().has_value());
+}
+
+TEST(InodeLoader, unloadedTreesAreNotLoaded) {
+  FakeTreeBuilder builder;
+  builder.setFiles(FILES);
+  TestMount mount(builder);
+
+  auto edenMount = mount.getEdenMount();
+  auto countLoaded = [&] {
+    auto counts = edenMount->getInodeMap()->getInodeCounts();
+    return counts.fileCount + counts.treeCount;
+  };
+  auto loadedBefore = countLoaded();
+
+  auto entry = edenMount
+                   ->getInodeOrTreeOrEntry(
+                       "dir/sub"_relpath, ObjectFetchContext::getNullContext())
+                   .get();
+  ASSERT_NE(nullptr, entry.asTreePtrOrNull());
+  EXPECT_EQ(loadedBefore, countLoaded());
+
+  // Loaded directories are returned as inodes.
+  mount.getTreeInode("dir/sub");
+  entry = edenMount
+              ->getInodeOrTreeOrEntry(
+                  "dir/sub"_relpath, ObjectFetchContext::getNullContext())
+              .get();
+  EXPECT_EQ(nullptr, entry.asTreePtrOrNull());
+  EXPECT_TRUE(entry.asInodePtr());
+}
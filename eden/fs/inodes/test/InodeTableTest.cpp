@@ -164,6 +164,21 @@ TEST_F(InodeTableTest, setDefault) {
   EXPECT_EQ(14, inodeTable->setDefault(1_ino, 16));
 }
 
+TEST_F(InodeTableTest, flushAsync) {
+  {
+    auto inodeTable = InodeTable<Int>::open(tablePath);
+    // Nothing to flush yet.
+    inodeTable->flushAsync();
+    inodeTable->set(1_ino, 15);
+    inodeTable->modifyOrThrow(1_ino, [](Int& value) { value.value = 16; });
+    inodeTable->flushAsync();
+    inodeTable->flushAsync();
+  }
+
+  auto inodeTable = InodeTable<Int>::open(tablePath);
+  EXPECT_EQ(16, inodeTable->getOrThrow(1_ino));
+}
+
 // TEST(INodeTable, set) {}
 // TEST(INodeTable, getOrThrow) {}
 // TEST(INodeTable, getOptional) {}
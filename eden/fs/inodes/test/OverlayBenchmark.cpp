@@ -5,79 +5,266 @@
  * GNU General Public License version 2.
  */
 
+#include <boost/filesystem.hpp>
+#include <fmt/core.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
 #include <folly/init/Init.h>
+#include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include <gflags/gflags.h>
 #include <stdlib.h>
+#include <algorithm>
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/OverlayFile.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 
 using namespace facebook::eden;
 using namespace folly::string_piece_literals;
 
-DEFINE_string(overlayPath, "", "Directory where the test overlay is created");
+DEFINE_string(overlayPath, "", "Directory where the test overlays are created");
+DEFINE_string(
+    overlayTypes,
+    "Legacy,LegacyPacked,Tree,TreeInMemory,TreeSynchronousOff,TreeBuffered",
+    "Comma-separated overlay types to compare");
+DEFINE_uint64(ops, 100000, "Number of operations in each workload");
 
 namespace {
 
-void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
-  // A large mount will contain 500,000 trees. If they're all loaded, they
-  // will all be written into the overlay. This benchmark simulates that
-  // workload and measures how long it takes.
-  //
-  // overlayPath is parameterized to measure on different filesystem types.
+// Directories get this many children before the workloads move on to a new
+// one, so that a single directory doesn't grow without bound.
+constexpr size_t kChildrenPerDir = 1000;
+
+const ObjectId kHash{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
+
+using Latencies = std::vector<std::chrono::nanoseconds>;
+
+/**
+ * Times `op(i)` for i in [0, FLAGS_ops).
+ */
+template <typename Op>
+Latencies timeOps(Op&& op) {
+  Latencies latencies;
+  latencies.reserve(FLAGS_ops);
+  for (uint64_t i = 0; i < FLAGS_ops; ++i) {
+    folly::stop_watch<std::chrono::nanoseconds> timer;
+    op(i);
+    latencies.push_back(timer.elapsed());
+  }
+  return latencies;
+}
+
+/**
+ * Adds children to a sequence of directories, saving the new child with
+ * `saveChild` and then the parent, the way TreeInode::mkdir and
+ * TreeInode::create do.
+ */
+template <typename SaveChild>
+Latencies addChildren(Overlay& overlay, mode_t mode, SaveChild&& saveChild) {
+  DirContents parent(kPathMapDefaultCaseSensitive);
+  auto parentIno = overlay.allocateInodeNumber();
+  return timeOps([&](uint64_t i) {
+    if (i % kChildrenPerDir == 0 && i != 0) {
+      parent = DirContents(kPathMapDefaultCaseSensitive);
+      parentIno = overlay.allocateInodeNumber();
+    }
+    auto ino = overlay.allocateInodeNumber();
+    saveChild(ino);
+    parent.emplace(
+        PathComponent{folly::to<std::string>("child", i)}, mode, ino);
+    overlay.saveOverlayDir(parentIno, parent);
+  });
+}
+
+/**
+ * Creates empty directories.
+ */
+Latencies mkdirStorm(Overlay& overlay) {
+  DirContents empty(kPathMapDefaultCaseSensitive);
+  return addChildren(overlay, S_IFDIR | 0755, [&](InodeNumber ino) {
+    overlay.saveOverlayDir(ino, empty);
+  });
+}
+
+/**
+ * Creates 4 KiB files.
+ */
+Latencies createFiles(Overlay& overlay) {
+#ifndef _WIN32
+  std::string contents(4096, 'x');
+  return addChildren(overlay, S_IFREG | 0644, [&](InodeNumber ino) {
+    overlay.createOverlayFile(
+        ino, folly::ByteRange{folly::StringPiece{contents}});
+  });
+#else
+  (void)overlay;
+  return {};
+#endif
+}
+
+/**
+ * Moves entries back and forth between two directories of kChildrenPerDir
+ * entries, saving both directories each time.
+ */
+Latencies renames(Overlay& overlay) {
+  std::array<DirContents, 2> dirs{
+      DirContents(kPathMapDefaultCaseSensitive),
+      DirContents(kPathMapDefaultCaseSensitive)};
+  std::array<InodeNumber, 2> dirInos{
+      overlay.allocateInodeNumber(), overlay.allocateInodeNumber()};
+  std::vector<PathComponent> names;
+  for (size_t i = 0; i < kChildrenPerDir; ++i) {
+    names.emplace_back(folly::to<std::string>("child", i));
+    dirs[0].emplace(
+        names.back(), S_IFREG | 0644, overlay.allocateInodeNumber(), kHash);
+  }
+  overlay.saveOverlayDir(dirInos[0], dirs[0]);
+  overlay.saveOverlayDir(dirInos[1], dirs[1]);
+
+  return timeOps([&](uint64_t i) {
+    auto from = (i / kChildrenPerDir) % 2;
+    auto to = 1 - from;
+    const auto& name = names[i % kChildrenPerDir];
+    auto it = dirs[from].find(name);
+    auto mode = it->second.getInitialMode();
+    auto ino = it->second.getInodeNumber();
+    dirs[from].erase(it);
+    dirs[to].emplace(name, mode, ino, kHash);
+    overlay.saveOverlayDir(dirInos[from], dirs[from]);
+    overlay.saveOverlayDir(dirInos[to], dirs[to]);
+  });
+}
+
+/**
+ * Saves a directory of 10,000 entries, changing one entry each time.
+ */
+Latencies largeDirSaves(Overlay& overlay) {
+  constexpr size_t kEntries = 10000;
+  DirContents dir(kPathMapDefaultCaseSensitive);
+  for (size_t i = 0; i < kEntries; ++i) {
+    dir.emplace(
+        PathComponent{folly::to<std::string>("child", i)},
+        S_IFREG | 0644,
+        overlay.allocateInodeNumber(),
+        kHash);
+  }
+  auto dirIno = overlay.allocateInodeNumber();
+  return timeOps([&](uint64_t i) {
+    auto it = dir.find(
+        PathComponentPiece{folly::to<std::string>("child", i % kEntries)});
+    it->second.setMaterialized();
+    overlay.saveOverlayDir(dirIno, dir);
+  });
+}
+
+/**
+ * Loads directories of 100 entries that were saved beforehand.
+ */
+Latencies loadDirs(Overlay& overlay) {
+  DirContents dir(kPathMapDefaultCaseSensitive);
+  for (size_t i = 0; i < 100; ++i) {
+    dir.emplace(
+        PathComponent{folly::to<std::string>("child", i)},
+        S_IFREG | 0644,
+        overlay.allocateInodeNumber(),
+        kHash);
+  }
+  std::vector<InodeNumber> dirInos;
+  for (uint64_t i = 0; i < FLAGS_ops; ++i) {
+    dirInos.push_back(overlay.allocateInodeNumber());
+    overlay.saveOverlayDir(dirInos.back(), dir);
+  }
+  overlay.flushPendingAsync().get();
+
+  return timeOps([&](uint64_t i) {
+    auto loaded = overlay.loadOverlayDir(dirInos[i]);
+    XCHECK_EQ(100, loaded.size());
+  });
+}
+
+struct Workload {
+  folly::StringPiece name;
+  Latencies (*run)(Overlay& overlay);
+};
+
+constexpr Workload kWorkloads[] = {
+    {"mkdir_storm", mkdirStorm},
+    {"create_files", createFiles},
+    {"renames", renames},
+    {"large_dir_saves", largeDirSaves},
+    {"load_dirs", loadDirs},
+};
+
+Overlay::OverlayType parseOverlayType(folly::StringPiece name) {
+  using OverlayType = Overlay::OverlayType;
+  static const std::pair<folly::StringPiece, OverlayType> kTypes[] = {
+      {"Legacy", OverlayType::Legacy},
+      {"Tree", OverlayType::Tree},
+      {"TreeInMemory", OverlayType::TreeInMemory},
+      {"TreeSynchronousOff", OverlayType::TreeSynchronousOff},
+      {"TreeBuffered", OverlayType::TreeBuffered},
+      {"LegacyPacked", OverlayType::LegacyPacked},
+  };
+  for (const auto& [typeName, type] : kTypes) {
+    if (name == typeName) {
+      return type;
+    }
+  }
+  throw std::invalid_argument(
+      folly::to<std::string>("unknown overlay type: ", name));
+}
+
+uint64_t getDiskUsage(AbsolutePathPiece path) {
+  uint64_t total = 0;
+  for (const auto& entry : boost::filesystem::recursive_directory_iterator(
+           path.stringPiece().str())) {
+    if (boost::filesystem::is_regular_file(entry.status())) {
+      total += boost::filesystem::file_size(entry.path());
+    }
+  }
+  return total;
+}
+
+/**
+ * Runs `workload` on a new overlay of the given type, and prints its
+ * throughput, 99th percentile latency and the size of the overlay on disk.
+ */
+void runWorkload(
+    AbsolutePathPiece overlayPath,
+    folly::StringPiece typeName,
+    const Workload& workload) {
+  auto localDir = overlayPath +
+      PathComponent{folly::to<std::string>(typeName, "-", workload.name)};
+  boost::filesystem::remove_all(localDir.stringPiece().str());
+  boost::filesystem::create_directories(localDir.stringPiece().str());
 
   auto overlay = Overlay::create(
-      overlayPath,
+      localDir,
       kPathMapDefaultCaseSensitive,
-      Overlay::OverlayType::Legacy,
+      parseOverlayType(typeName),
       std::make_shared<NullStructuredLogger>());
   overlay->initialize().get();
 
-  ObjectId hash1{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
-  ObjectId hash2{folly::ByteRange{"01234012340123401234"_sp}};
-
-  DirContents contents(kPathMapDefaultCaseSensitive);
-  contents.emplace(
-      PathComponent{"one"},
-      S_IFREG | 0644,
-      overlay->allocateInodeNumber(),
-      hash1);
-  contents.emplace(
-      PathComponent{"two"},
-      S_IFDIR | 0755,
-      overlay->allocateInodeNumber(),
-      hash2);
-
-  uint64_t N = 500000;
-
   folly::stop_watch<> timer;
-
-  for (uint64_t i = 1; i <= N; i++) {
-    auto ino = overlay->allocateInodeNumber();
-    overlay->saveOverlayDir(ino, contents);
+  auto latencies = workload.run(*overlay);
+  auto elapsed = std::chrono::duration<double>{timer.elapsed()}.count();
+  // Closing writes back whatever the overlay buffered, so it counts towards
+  // the on-disk size.
+  overlay->close();
+  if (latencies.empty()) {
+    return;
   }
 
-  auto elapsed = timer.elapsed();
-
-  printf(
-      "Total elapsed time for %" SCNu64 " entries: %.2f s\n",
-      N,
-      std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
-          .count());
-
-  // Normally, I prefer to use minimum, but the cost of writing into the
-  // overlay increases as the overlay grows, as xfs especially updates its
-  // btrees.
-  //
-  // That reason, plus the reason that we want a fixed N for comparable results
-  // is why this benchmark doesn't use folly Benchmark.
-  printf(
-      "Average time per call: %.2f us\n",
-      static_cast<double>(
-          std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
-              elapsed / N)
-              .count()));
+  std::sort(latencies.begin(), latencies.end());
+  auto p99 = latencies[(latencies.size() - 1) * 99 / 100];
+  fmt::print(
+      "{:<20}{:<18}{:>12.0f}{:>12.1f}{:>14}\n",
+      typeName,
+      workload.name,
+      latencies.size() / elapsed,
+      std::chrono::duration<double, std::micro>{p99}.count(),
+      getDiskUsage(localDir));
 }
 
 } // namespace
@@ -90,8 +277,23 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  // overlayPath is parameterized to measure on different filesystem types.
   auto overlayPath = normalizeBestEffort(FLAGS_overlayPath.c_str());
-  benchmarkOverlayTreeWrites(overlayPath);
+  std::vector<folly::StringPiece> typeNames;
+  folly::split(',', FLAGS_overlayTypes, typeNames, /*ignoreEmpty=*/true);
+
+  fmt::print(
+      "{:<20}{:<18}{:>12}{:>12}{:>14}\n",
+      "overlay",
+      "workload",
+      "ops/s",
+      "p99 (us)",
+      "disk bytes");
+  for (auto typeName : typeNames) {
+    for (const auto& workload : kWorkloads) {
+      runWorkload(overlayPath, typeName, workload);
+    }
+  }
 
   return 0;
 }
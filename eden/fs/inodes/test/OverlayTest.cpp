@@ -10,6 +10,7 @@
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/fsoverlay/FsOverlay.h"
 
+#include <folly/Conv.h>
 #include <folly/Exception.h>
 #include <folly/Expected.h>
 #include <folly/FileUtil.h>
@@ -23,6 +24,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -40,6 +42,7 @@
 #include "eden/fs/utils/SpawnedProcess.h"
 
 using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
 
 namespace facebook {
 namespace eden {
@@ -529,6 +532,36 @@ TEST_P(RawOverlayTest, max_inode_number_is_1_if_overlay_is_empty) {
   EXPECT_EQ(2_ino, overlay->allocateInodeNumber());
 }
 
+TEST_P(RawOverlayTest, inode_numbers_allocated_by_many_threads_are_unique) {
+  constexpr unsigned kThreadCount = 4;
+  constexpr unsigned kInodesPerThread = 3000;
+  std::vector<std::vector<InodeNumber>> allocated(kThreadCount);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i] {
+      for (unsigned j = 0; j < kInodesPerThread; ++j) {
+        allocated[i].push_back(overlay->allocateInodeNumber());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<InodeNumber> all;
+  for (const auto& numbers : allocated) {
+    all.insert(all.end(), numbers.begin(), numbers.end());
+  }
+  std::sort(all.begin(), all.end());
+  EXPECT_EQ(all.end(), std::adjacent_find(all.begin(), all.end()));
+  EXPECT_EQ(all.back(), overlay->getMaxInodeNumber());
+
+  recreate(OverlayRestartMode::CLEAN);
+
+  EXPECT_EQ(all.back(), overlay->getMaxInodeNumber());
+  EXPECT_LT(all.back(), overlay->allocateInodeNumber());
+}
+
 TEST_P(RawOverlayTest, remembers_max_inode_number_of_tree_inodes) {
   auto ino2 = overlay->allocateInodeNumber();
   EXPECT_EQ(2_ino, ino2);
@@ -739,6 +772,44 @@ TEST_P(RawOverlayTest, inode_numbers_after_takeover) {
   EXPECT_EQ(5_ino, overlay->getMaxInodeNumber());
 }
 
+TEST_P(RawOverlayTest, recursive_removal_collects_whole_tree) {
+  // Enough directories for the GC threads to split the tree between them.
+  constexpr size_t kFanout = 8;
+  std::vector<InodeNumber> dirs;
+  std::vector<InodeNumber> files;
+  auto saveTree = [&](auto& self, InodeNumber ino, size_t depth) -> void {
+    DirContents dir(kPathMapDefaultCaseSensitive);
+    for (size_t i = 0; i < kFanout; ++i) {
+      auto child = overlay->allocateInodeNumber();
+      auto name = PathComponent{folly::to<std::string>("child", i)};
+      if (depth == 0) {
+        overlay->createOverlayFile(child, folly::ByteRange{"contents"_sp});
+        dir.emplace(name, S_IFREG | 0644, child);
+        files.push_back(child);
+      } else {
+        self(self, child, depth - 1);
+        dir.emplace(name, S_IFDIR | 0755, child);
+      }
+    }
+    overlay->saveOverlayDir(ino, dir);
+    dirs.push_back(ino);
+  };
+  auto top = overlay->allocateInodeNumber();
+  saveTree(saveTree, top, 3);
+
+  overlay->recursivelyRemoveOverlayData(top);
+  overlay->flushPendingAsync().get(60s);
+
+  EXPECT_EQ(0, overlay->getGCBacklog());
+  EXPECT_EQ(0, overlay->getGCBacklogAge().count());
+  for (auto ino : dirs) {
+    EXPECT_FALSE(overlay->hasOverlayData(ino)) << ino;
+  }
+  for (auto ino : files) {
+    EXPECT_FALSE(overlay->hasOverlayData(ino)) << ino;
+  }
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
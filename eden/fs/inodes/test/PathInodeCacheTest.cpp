@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/PathInodeCache.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(PathInodeCache, getReturnsInsertedInodes) {
+  PathInodeCache cache{10};
+  auto generation = cache.getGeneration();
+  cache.insert("a/b"_relpath, InodeNumber{5}, generation);
+  EXPECT_EQ(InodeNumber{5}, cache.get("a/b"_relpath));
+  EXPECT_EQ(std::nullopt, cache.get("a"_relpath));
+}
+
+TEST(PathInodeCache, invalidateDropsEverything) {
+  PathInodeCache cache{10};
+  auto generation = cache.getGeneration();
+  cache.insert("a"_relpath, InodeNumber{5}, generation);
+  cache.invalidate();
+  EXPECT_EQ(std::nullopt, cache.get("a"_relpath));
+
+  // Lookups that started before the invalidation aren't cached.
+  cache.insert("a"_relpath, InodeNumber{5}, generation);
+  EXPECT_EQ(std::nullopt, cache.get("a"_relpath));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(PathInodeCache, evictsLeastRecentlyUsed) {
+  PathInodeCache cache{2};
+  auto generation = cache.getGeneration();
+  cache.insert("a"_relpath, InodeNumber{1}, generation);
+  cache.insert("b"_relpath, InodeNumber{2}, generation);
+  EXPECT_EQ(InodeNumber{1}, cache.get("a"_relpath));
+  cache.insert("c"_relpath, InodeNumber{3}, generation);
+  EXPECT_EQ(InodeNumber{1}, cache.get("a"_relpath));
+  EXPECT_EQ(std::nullopt, cache.get("b"_relpath));
+  EXPECT_EQ(InodeNumber{3}, cache.get("c"_relpath));
+}
+
+TEST(PathInodeCache, zeroSizeDisablesCache) {
+  PathInodeCache cache{0};
+  cache.insert("a"_relpath, InodeNumber{1}, cache.getGeneration());
+  EXPECT_EQ(std::nullopt, cache.get("a"_relpath));
+}
+
+TEST(PathInodeCache, renamesAreNotServedStale) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/a", "a\n");
+  builder.setFile("dir/b", "b\n");
+  TestMount mount{builder};
+  auto& edenMount = mount.getEdenMount();
+  auto getInode = [&](folly::StringPiece path) {
+    return edenMount
+        ->getInodeSlow(
+            RelativePathPiece{path}, ObjectFetchContext::getNullContext())
+        .get(10ms);
+  };
+
+  auto a = getInode("dir/a");
+  EXPECT_EQ(a, getInode("dir/a"));
+  EXPECT_EQ(
+      a->getNodeId(), edenMount->getPathInodeCache().get("dir/a"_relpath));
+
+  mount.move("dir/a", "dir/b");
+  EXPECT_EQ(a, getInode("dir/b"));
+  EXPECT_THROW(getInode("dir/a"), std::system_error);
+
+  mount.deleteFile("dir/b");
+  EXPECT_THROW(getInode("dir/b"), std::system_error);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ReaddirSnapshotCache.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+std::shared_ptr<const ReaddirSnapshot> makeSnapshot() {
+  return std::make_shared<ReaddirSnapshot>();
+}
+} // namespace
+
+TEST(ReaddirSnapshotCache, getReturnsSnapshotOfVerifier) {
+  ReaddirSnapshotCache cache{10, 1h};
+  auto snapshot = makeSnapshot();
+  auto verifier = cache.insert(InodeNumber{5}, snapshot);
+  EXPECT_NE(0, verifier);
+  EXPECT_EQ(snapshot, cache.get(InodeNumber{5}, verifier));
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{6}, verifier));
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{5}, verifier + 1));
+
+  cache.erase(verifier);
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{5}, verifier));
+}
+
+TEST(ReaddirSnapshotCache, invalidateDropsSnapshotsOfDirectory) {
+  ReaddirSnapshotCache cache{10, 1h};
+  auto first = cache.insert(InodeNumber{5}, makeSnapshot());
+  auto second = cache.insert(InodeNumber{5}, makeSnapshot());
+  auto other = cache.insert(InodeNumber{6}, makeSnapshot());
+  EXPECT_NE(first, second);
+
+  cache.invalidate(InodeNumber{5});
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{5}, first));
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{5}, second));
+  EXPECT_NE(nullptr, cache.get(InodeNumber{6}, other));
+}
+
+TEST(ReaddirSnapshotCache, snapshotsExpire) {
+  ReaddirSnapshotCache cache{10, 0s};
+  auto verifier = cache.insert(InodeNumber{5}, makeSnapshot());
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{5}, verifier));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(ReaddirSnapshotCache, evictsOldestSnapshots) {
+  ReaddirSnapshotCache cache{2, 1h};
+  auto first = cache.insert(InodeNumber{1}, makeSnapshot());
+  auto second = cache.insert(InodeNumber{2}, makeSnapshot());
+  auto third = cache.insert(InodeNumber{3}, makeSnapshot());
+  EXPECT_EQ(nullptr, cache.get(InodeNumber{1}, first));
+  EXPECT_NE(nullptr, cache.get(InodeNumber{2}, second));
+  EXPECT_NE(nullptr, cache.get(InodeNumber{3}, third));
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/RecordedPrefetchProfiles.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/testharness/TestMount.h"
+#include "eden/fs/utils/EdenError.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+class PidFetchContext : public ObjectFetchContext {
+ public:
+  explicit PidFetchContext(std::optional<pid_t> pid, Cause cause = Cause::Fs)
+      : pid_{pid}, cause_{cause} {}
+
+  std::optional<pid_t> getClientPid() const override {
+    return pid_;
+  }
+
+  Cause getCause() const override {
+    return cause_;
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+
+ private:
+  std::optional<pid_t> pid_;
+  Cause cause_;
+};
+
+} // namespace
+
+TEST(RecordedPrefetchProfiles, savesRecordedPaths) {
+  auto tempDir = makeTempDir();
+  RecordedPrefetchProfiles profiles{
+      canonicalPath(tempDir.path().string()) + "profiles"_pc};
+  EXPECT_TRUE(profiles.listProfiles().empty());
+  EXPECT_FALSE(profiles.isRecording());
+
+  profiles.startRecording("build", std::nullopt);
+  profiles.startRecording("tool", pid_t{42});
+  EXPECT_TRUE(profiles.isRecording());
+
+  profiles.recordFetch(RelativePathPiece{"src/b.cpp"}, PidFetchContext{42});
+  profiles.recordFetch(RelativePathPiece{"src/a.cpp"}, PidFetchContext{7});
+  profiles.recordFetch(RelativePathPiece{"src/a.cpp"}, PidFetchContext{7});
+  // Replays are never recorded.
+  profiles.recordFetch(
+      RelativePathPiece{"src/c.cpp"},
+      PidFetchContext{42, ObjectFetchContext::Cause::Prefetch});
+
+  EXPECT_EQ(2, profiles.stopRecording("build"));
+  EXPECT_EQ(1, profiles.stopRecording("tool"));
+  EXPECT_FALSE(profiles.isRecording());
+  EXPECT_THROW(profiles.stopRecording("build"), EdenError);
+
+  EXPECT_EQ(
+      (std::vector<std::string>{"build", "tool"}), profiles.listProfiles());
+  EXPECT_EQ(
+      (std::vector<RelativePath>{
+          RelativePath{"src/a.cpp"}, RelativePath{"src/b.cpp"}}),
+      profiles.loadProfile("build"));
+  EXPECT_EQ(
+      std::vector<RelativePath>{RelativePath{"src/b.cpp"}},
+      profiles.loadProfile("tool"));
+  EXPECT_TRUE(profiles.loadProfile("missing").empty());
+}
+
+TEST(RecordedPrefetchProfiles, rejectsInvalidNames) {
+  auto tempDir = makeTempDir();
+  RecordedPrefetchProfiles profiles{canonicalPath(tempDir.path().string())};
+  EXPECT_ANY_THROW(profiles.startRecording("a/b", std::nullopt));
+  EXPECT_ANY_THROW(profiles.startRecording("..", std::nullopt));
+  EXPECT_FALSE(profiles.isRecording());
+}
+
+TEST(RecordedPrefetchProfiles, recordsFileLoadsInMount) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"src/a.txt", "a"}, {"src/b.txt", "b"}});
+  TestMount mount{builder};
+  auto& profiles = mount.getEdenMount()->getRecordedPrefetchProfiles();
+
+  profiles.startRecording("build", std::nullopt);
+  EXPECT_EQ("a", mount.readFile("src/a.txt"));
+  EXPECT_EQ(1, profiles.stopRecording("build"));
+
+  EXPECT_EQ(
+      std::vector<RelativePath>{RelativePath{"src/a.txt"}},
+      profiles.loadProfile("build"));
+}
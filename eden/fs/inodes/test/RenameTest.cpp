@@ -8,6 +8,7 @@
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -193,6 +194,59 @@ TEST_F(RenameTest, renameFileToSamePath) {
   EXPECT_EQ(path, origFile->getPath().value());
 }
 
+TEST_F(RenameTest, concurrentFileRenamesInOppositeDirections) {
+  // Both directories are materialized and all files loaded, so that the
+  // renames below hold the rename lock shared and run concurrently.
+  constexpr size_t kFiles = 32;
+  for (size_t i = 0; i < kFiles; ++i) {
+    mount_->addFile(folly::to<std::string>("a/b/c/d/left", i), "left\n");
+    mount_->addFile(folly::to<std::string>("a/x/y/z/right", i), "right\n");
+  }
+  auto left = mount_->getTreeInode("a/b/c/d");
+  auto right = mount_->getTreeInode("a/x/y/z");
+  std::vector<FileInodePtr> files;
+  for (size_t i = 0; i < kFiles; ++i) {
+    files.push_back(
+        mount_->getFileInode(folly::to<std::string>("a/b/c/d/left", i)));
+    files.push_back(
+        mount_->getFileInode(folly::to<std::string>("a/x/y/z/right", i)));
+  }
+
+  auto moveAll = [&](const TreeInodePtr& from,
+                     const TreeInodePtr& to,
+                     StringPiece prefix) {
+    for (size_t round = 0; round < 50; ++round) {
+      for (size_t i = 0; i < kFiles; ++i) {
+        PathComponent name{folly::to<std::string>(prefix, i)};
+        bool back = round % 2 == 1;
+        auto future = (back ? to : from)
+                          ->rename(
+                              name,
+                              back ? from : to,
+                              name,
+                              InvalidationRequired::No,
+                              ObjectFetchContext::getNullContext());
+        ASSERT_TRUE(future.isReady());
+        std::move(future).get();
+      }
+    }
+  };
+  std::thread leftToRight{[&] { moveAll(left, right, "left"); }};
+  std::thread rightToLeft{[&] { moveAll(right, left, "right"); }};
+  leftToRight.join();
+  rightToLeft.join();
+
+  // Every file made an even number of moves, so it is back where it started.
+  for (size_t i = 0; i < kFiles; ++i) {
+    auto leftPath = RelativePath{folly::to<std::string>("a/b/c/d/left", i)};
+    auto rightPath = RelativePath{folly::to<std::string>("a/x/y/z/right", i)};
+    EXPECT_EQ(files[2 * i].get(), mount_->getFileInode(leftPath).get());
+    EXPECT_EQ(leftPath, files[2 * i]->getPath().value());
+    EXPECT_EQ(files[2 * i + 1].get(), mount_->getFileInode(rightPath).get());
+    EXPECT_EQ(rightPath, files[2 * i + 1]->getPath().value());
+  }
+}
+
 /*
  * Basic tests for renaming directories
  */
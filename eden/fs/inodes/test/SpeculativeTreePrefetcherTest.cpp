@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/SpeculativeTreePrefetcher.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+TEST(SpeculativeTreePrefetcher, countsLoadsOfDeeperTrees) {
+  FakeTreeBuilder builder;
+  builder.setFiles({
+      {"a/b/c/file.txt", "c"},
+      {"a/other/file.txt", "other"},
+  });
+  TestMount mount{builder};
+  auto& prefetcher = mount.getEdenMount()->getSpeculativeTreePrefetcher();
+  EXPECT_EQ(100, prefetcher.getHitRatePercent());
+
+  auto aId = builder.getStoredTree("a"_relpath)->get().getHash();
+  auto executor = mount.getServerExecutor().get();
+  auto future = prefetcher
+                    .prefetch(
+                        {aId},
+                        /*depth=*/3,
+                        /*blobMetadata=*/false,
+                        ObjectFetchContext::getNullContext())
+                    .via(executor)
+                    .waitVia(executor);
+  ASSERT_TRUE(future.isReady());
+  std::move(future).get();
+
+  // a is a direct child of the listed directory, so only a/b, a/other and
+  // a/b/c count.
+  EXPECT_EQ(3, prefetcher.getPrefetchCount());
+  EXPECT_EQ(0, prefetcher.getHitCount());
+
+  mount.getTreeInode("a/b/c");
+  EXPECT_EQ(2, prefetcher.getHitCount());
+  EXPECT_EQ(66, prefetcher.getHitRatePercent());
+
+  // Each tree is only counted once.
+  mount.getTreeInode("a/b")->unloadChildrenNow();
+  mount.getTreeInode("a/b/c");
+  EXPECT_EQ(2, prefetcher.getHitCount());
+}
+
+TEST(SpeculativeTreePrefetcher, stopsAtDepth) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a/b/c/file.txt", "c"}});
+  TestMount mount{builder};
+  auto& prefetcher = mount.getEdenMount()->getSpeculativeTreePrefetcher();
+
+  auto aId = builder.getStoredTree("a"_relpath)->get().getHash();
+  auto executor = mount.getServerExecutor().get();
+  auto future = prefetcher
+                    .prefetch(
+                        {aId},
+                        /*depth=*/2,
+                        /*blobMetadata=*/false,
+                        ObjectFetchContext::getNullContext())
+                    .via(executor)
+                    .waitVia(executor);
+  ASSERT_TRUE(future.isReady());
+  EXPECT_EQ(1, prefetcher.getPrefetchCount());
+  EXPECT_TRUE(prefetcher.shouldPrefetch(/*minHitRatePercent=*/100));
+}
@@ -7,7 +7,10 @@
 
 #include "eden/fs/inodes/Traverse.h"
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/portability/GTest.h>
+#include <algorithm>
+#include <mutex>
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/TreeInode.h"
@@ -38,6 +41,24 @@ struct TestCallbacks : TraversalCallbacks {
   }
 };
 
+struct ConcurrentTestCallbacks : TestCallbacks {
+  std::mutex mutex;
+
+  void visitTreeInode(
+      RelativePathPiece path,
+      InodeNumber ino,
+      const std::optional<ObjectId>& hash,
+      uint64_t fuseRefcount,
+      const std::vector<ChildEntry>& entries) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    TestCallbacks::visitTreeInode(path, ino, hash, fuseRefcount, entries);
+  }
+
+  bool canRunConcurrently() const override {
+    return true;
+  }
+};
+
 TEST(TraverseTest, does_not_traverse_unallocated_and_unmaterialized_trees) {
   FakeTreeBuilder builder;
   builder.setFile("dir1/dir2/file", "test\n");
@@ -74,3 +95,31 @@ TEST(TraverseTest, does_traverse_loaded_trees) {
   EXPECT_EQ("dir1", callbacks.paths.at(2));
   EXPECT_EQ("dir1/dir2", callbacks.paths.at(3));
 }
+
+TEST(TraverseTest, parallel_traversal_visits_the_same_trees) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir1/dir2/file", "test\n");
+  builder.setFile("dir3/dir4/file", "test\n");
+  builder.setFile("dir3/dir5/file", "test\n");
+  TestMount mount{builder};
+
+  auto rootPath = RelativePath{""};
+  auto root = mount.getTreeInode(rootPath);
+  auto file1 = mount.getFileInode("dir1/dir2/file");
+  auto file2 = mount.getFileInode("dir3/dir5/file");
+
+  TestCallbacks serial;
+  traverseObservedInodes(*root, rootPath, serial);
+
+  folly::CPUThreadPoolExecutor executor{4};
+  ConcurrentTestCallbacks parallel;
+  traverseObservedInodesInParallel(
+      root, rootPath, parallel, folly::getKeepAliveToken(executor))
+      .get();
+
+  EXPECT_EQ(6, serial.paths.size());
+  EXPECT_EQ("", parallel.paths.at(0));
+  std::sort(serial.paths.begin(), serial.paths.end());
+  std::sort(parallel.paths.begin(), parallel.paths.end());
+  EXPECT_EQ(serial.paths, parallel.paths);
+}
@@ -10,6 +10,7 @@
 #include <folly/Exception.h>
 #include <folly/Random.h>
 #include <folly/executors/ManualExecutor.h>
+#include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 #include <gflags/gflags.h>
@@ -17,6 +18,8 @@
 #include "eden/fs/prjfs/Enumerator.h"
 #else
 #include "eden/fs/fuse/DirList.h"
+#include "eden/fs/inodes/ReaddirSnapshotCache.h"
+#include "eden/fs/nfs/DirList.h"
 #endif // _WIN32
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/model/Tree.h"
@@ -117,6 +120,32 @@ TEST(TreeInode, fuseReaddirReturnsSelfAndParentBeforeEntries) {
   EXPECT_EQ(".eden", result[3].name);
 }
 
+#ifdef __linux__
+TEST(TreeInode, fuseReaddirplusListsSameEntriesWithZeroedAttributes) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file", ""}});
+  TestMount mount{builder};
+
+  auto root = mount.getEdenMount()->getRootInode();
+  auto list = root->fuseReaddir(
+      FuseDirList{4096, /*plus=*/true}, 0, ObjectFetchContext::getNullContext());
+  auto result = list.extract();
+  auto entryOuts = list.getEntryOuts();
+
+  ASSERT_EQ(4, result.size());
+  ASSERT_EQ(4, entryOuts.size());
+  EXPECT_EQ(".", result[0].name);
+  EXPECT_EQ("..", result[1].name);
+  EXPECT_EQ("file", result[2].name);
+  EXPECT_EQ(".eden", result[3].name);
+  for (size_t i = 0; i < result.size(); ++i) {
+    EXPECT_EQ(result[i].name, entryOuts[i].name);
+    EXPECT_EQ(result[i].inode, entryOuts[i].inode);
+    EXPECT_EQ(0, entryOuts[i].entry->nodeid);
+  }
+}
+#endif
+
 TEST(TreeInode, fuseReaddirOffsetsAreNonzero) {
   // fuseReaddir's offset parameter means "start here". 0 means start from the
   // beginning. To start after a particular entry, the offset given must be that
@@ -325,6 +354,61 @@ TEST(TreeInode, fuzzConcurrentModificationAndReaddir) {
   }
   std::cout << "Ran " << iterations << " iterations" << std::endl;
 }
+
+namespace {
+std::vector<entry3> nfsReaddir(
+    TreeInode& inode,
+    off_t offset,
+    const ReaddirSnapshot& snapshot,
+    uint32_t count = 4096) {
+  auto [list, isEof] = inode.nfsReaddir(
+      NfsDirList{count, nfsv3Procs::readdir},
+      offset,
+      snapshot,
+      ObjectFetchContext::getNullContext());
+  return list.extractList<entry3>().list;
+}
+} // namespace
+
+TEST(TreeInode, nfsReaddirPagesThroughSnapshot) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a", ""}, {"b", ""}, {"c", ""}});
+  TestMount mount{builder};
+  auto root = mount.getEdenMount()->getRootInode();
+  auto snapshot = root->takeReaddirSnapshot();
+  // a, b, c and .eden
+  ASSERT_EQ(4, snapshot->entries.size());
+
+  // Small enough to need several pages.
+  auto page = nfsReaddir(*root, 0, *snapshot, 180);
+  ASSERT_LT(page.size(), 6);
+  std::vector<std::string> names;
+  while (!page.empty()) {
+    for (auto& entry : page) {
+      names.push_back(entry.name);
+    }
+    page = nfsReaddir(*root, page.back().cookie, *snapshot, 180);
+  }
+  EXPECT_THAT(names, testing::ElementsAre(".", "..", "a", "b", "c", ".eden"));
+}
+
+TEST(TreeInode, nfsReaddirSkipsEntriesRemovedFromSnapshot) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a", ""}, {"b", ""}});
+  TestMount mount{builder};
+  auto root = mount.getEdenMount()->getRootInode();
+  auto snapshot = root->takeReaddirSnapshot();
+
+  mount.deleteFile("a");
+  mount.addFile("new", "");
+
+  std::vector<std::string> names;
+  for (auto& entry : nfsReaddir(*root, 0, *snapshot)) {
+    names.push_back(entry.name);
+  }
+  // Entries added during a listing only show up in the next one.
+  EXPECT_THAT(names, testing::ElementsAre(".", "..", "b", ".eden"));
+}
 #endif
 
 TEST(TreeInode, create) {
@@ -426,6 +510,48 @@ TEST(TreeInode, removeRecursivelyNotReady) {
   EXPECT_THROW_ERRNO(mount.getTreeInode("somedir"_relpath), ENOENT);
 }
 
+TEST(TreeInode, dematerializeUnchangedDirectories) {
+  FakeTreeBuilder builder;
+  builder.setFile("somedir/foo.txt", "foo\n");
+  builder.setFile("somedir/subdir/bar.txt", "bar\n");
+  builder.setFile("otherdir/baz.txt", "baz\n");
+  TestMount mount{builder};
+
+  // Return somedir/subdir to its source control state after materializing it
+  // and its parents, and leave otherdir modified.
+  mount.addFile("somedir/subdir/tmp.txt", "tmp\n");
+  mount.deleteFile("somedir/subdir/tmp.txt");
+  mount.move("somedir/foo.txt", "somedir/moved.txt");
+  mount.move("somedir/moved.txt", "somedir/foo.txt");
+  mount.addFile("otherdir/new.txt", "new\n");
+
+  const auto& edenMount = mount.getEdenMount();
+  auto root = edenMount->getRootInode();
+  auto somedir = mount.getTreeInode("somedir"_relpath);
+  auto subdir = mount.getTreeInode("somedir/subdir"_relpath);
+  auto otherdir = mount.getTreeInode("otherdir"_relpath);
+  EXPECT_TRUE(subdir->getContents().rlock()->isMaterialized());
+  EXPECT_TRUE(somedir->getContents().rlock()->isMaterialized());
+
+  auto count =
+      edenMount->dematerializeUnchangedDirectories(folly::CancellationToken{})
+          .get(0ms);
+  EXPECT_EQ(2, count);
+  EXPECT_FALSE(subdir->getContents().rlock()->isMaterialized());
+  EXPECT_FALSE(somedir->getContents().rlock()->isMaterialized());
+  EXPECT_TRUE(otherdir->getContents().rlock()->isMaterialized());
+  EXPECT_TRUE(root->getContents().rlock()->isMaterialized());
+
+  mount.deleteFile("otherdir/new.txt");
+  count =
+      edenMount->dematerializeUnchangedDirectories(folly::CancellationToken{})
+          .get(0ms);
+  EXPECT_EQ(2, count);
+  EXPECT_FALSE(otherdir->getContents().rlock()->isMaterialized());
+  EXPECT_FALSE(root->getContents().rlock()->isMaterialized());
+  EXPECT_FILE_INODE(mount.getFileInode("somedir/foo.txt"), "foo\n", 0644);
+}
+
 #ifndef _WIN32
 
 TEST(TreeInode, setattr) {
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/WorkingCopyStatusCache.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using ::testing::UnorderedElementsAre;
+
+namespace {
+
+class WorkingCopyStatusCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FakeTreeBuilder builder;
+    builder.setFile("src/main.c", "int main() { return 0; }\n");
+    builder.setFile("src/lib.c", "int lib() { return 1; }\n");
+    builder.setFile("README", "readme\n");
+    mount_.initialize(builder);
+    commit_ = mount_.getEdenMount()->getWorkingCopyParent();
+    cache_ = std::make_unique<WorkingCopyStatusCache>(
+        mount_.getEdenMount().get());
+  }
+
+  std::unique_ptr<ScmStatus> getStatus() {
+    return mount_.getEdenMount()
+        ->diff(
+            commit_,
+            folly::CancellationToken{},
+            /*listIgnored=*/false,
+            /*enforceCurrentParent=*/false)
+        .get(10ms);
+  }
+
+  /// Cache the status of the working copy as it is now.
+  void cacheFullDiff() {
+    auto sequence =
+        mount_.getEdenMount()->getJournal().getLatest()->sequenceID;
+    cache_->insert(commit_, false, sequence, *getStatus());
+  }
+
+  std::optional<ScmStatus> getCached() {
+    return cache_
+        ->get(commit_, false, ObjectFetchContext::getNullContext())
+        .get(10ms);
+  }
+
+  TestMount mount_;
+  RootId commit_;
+  std::unique_ptr<WorkingCopyStatusCache> cache_;
+};
+
+} // namespace
+
+TEST_F(WorkingCopyStatusCacheTest, unchangedWorkingCopyIsCached) {
+  mount_.overwriteFile("README", "changed\n");
+  cacheFullDiff();
+  auto cached = getCached();
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_THAT(
+      *cached->entries_ref(),
+      UnorderedElementsAre(std::make_pair("README", ScmFileStatus::MODIFIED)));
+
+  // Other commits and listIgnored values aren't.
+  EXPECT_FALSE(cache_
+                   ->get(
+                       RootId{"other"},
+                       false,
+                       ObjectFetchContext::getNullContext())
+                   .get(10ms)
+                   .has_value());
+  EXPECT_FALSE(
+      cache_->get(commit_, true, ObjectFetchContext::getNullContext())
+          .get(10ms)
+          .has_value());
+}
+
+TEST_F(WorkingCopyStatusCacheTest, trackedFileChangesAreReplayed) {
+  cacheFullDiff();
+
+  mount_.overwriteFile("src/main.c", "int main() { return 2; }\n");
+  mount_.deleteFile("README");
+  auto cached = getCached();
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_THAT(
+      *cached->entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/main.c", ScmFileStatus::MODIFIED),
+          std::make_pair("README", ScmFileStatus::REMOVED)));
+  EXPECT_EQ(*getStatus()->entries_ref(), *cached->entries_ref());
+
+  // Restoring the original contents makes the file clean again.
+  mount_.overwriteFile("src/main.c", "int main() { return 0; }\n");
+  cached = getCached();
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_THAT(
+      *cached->entries_ref(),
+      UnorderedElementsAre(std::make_pair("README", ScmFileStatus::REMOVED)));
+}
+
+TEST_F(WorkingCopyStatusCacheTest, newUntrackedFilesNeedAFullDiff) {
+  cacheFullDiff();
+  mount_.addFile("src/new.c", "new\n");
+  EXPECT_FALSE(getCached().has_value());
+
+  // Once it is known to be added, changing it doesn't.
+  cacheFullDiff();
+  mount_.overwriteFile("src/new.c", "newer\n");
+  auto cached = getCached();
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_THAT(
+      *cached->entries_ref(),
+      UnorderedElementsAre(std::make_pair("src/new.c", ScmFileStatus::ADDED)));
+
+  mount_.deleteFile("src/new.c");
+  cached = getCached();
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_TRUE(cached->entries_ref()->empty());
+}
+
+TEST_F(WorkingCopyStatusCacheTest, directoryChangesNeedAFullDiff) {
+  cacheFullDiff();
+  mount_.mkdir("newdir");
+  EXPECT_FALSE(getCached().has_value());
+}
+
+TEST_F(WorkingCopyStatusCacheTest, diffUsesTheCacheWhenEnabled) {
+  mount_.getEdenConfig()->incrementalStatus.setValue(
+      true, ConfigSource::CommandLine);
+  EXPECT_TRUE(getStatus()->entries_ref()->empty());
+
+  mount_.overwriteFile("src/lib.c", "int lib() { return 2; }\n");
+  EXPECT_THAT(
+      *getStatus()->entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/lib.c", ScmFileStatus::MODIFIED)));
+  mount_.addFile("src/new.c", "new\n");
+  EXPECT_THAT(
+      *getStatus()->entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/lib.c", ScmFileStatus::MODIFIED),
+          std::make_pair("src/new.c", ScmFileStatus::ADDED)));
+}
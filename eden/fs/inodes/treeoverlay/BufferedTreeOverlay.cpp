@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/treeoverlay/BufferedTreeOverlay.h"
+
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+#include "eden/fs/utils/Bug.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * Approximate memory used by a pending write of `dir`.
+ */
+size_t estimateSize(const std::optional<overlay::OverlayDir>& dir) {
+  size_t size = sizeof(InodeNumber) + sizeof(dir);
+  if (dir) {
+    for (const auto& [name, entry] : *dir->entries_ref()) {
+      size += sizeof(name) + name.size() + sizeof(entry);
+      if (entry.hash_ref()) {
+        size += entry.hash_ref()->size();
+      }
+    }
+  }
+  return size;
+}
+} // namespace
+
+BufferedTreeOverlay::BufferedTreeOverlay(
+    AbsolutePathPiece path,
+    size_t maxDirtyBytes,
+    std::chrono::milliseconds maxDirtyAge,
+    TreeOverlayStore::SynchronousMode mode)
+    : TreeOverlay{path, mode},
+      maxDirtyBytes_{maxDirtyBytes},
+      maxDirtyAge_{maxDirtyAge} {}
+
+BufferedTreeOverlay::BufferedTreeOverlay(
+    std::unique_ptr<SqliteDatabase> store,
+    size_t maxDirtyBytes,
+    std::chrono::milliseconds maxDirtyAge)
+    : TreeOverlay{std::move(store)},
+      maxDirtyBytes_{maxDirtyBytes},
+      maxDirtyAge_{maxDirtyAge} {}
+
+BufferedTreeOverlay::~BufferedTreeOverlay() {
+  stopFlusher();
+}
+
+std::optional<InodeNumber> BufferedTreeOverlay::initOverlay(
+    bool createIfNonExisting) {
+  auto nextInodeNumber = TreeOverlay::initOverlay(createIfNonExisting);
+  state_.lock()->flusherRunning = true;
+  flusher_ = std::thread{[this] { flusherThread(); }};
+  return nextInodeNumber;
+}
+
+void BufferedTreeOverlay::close(std::optional<InodeNumber> nextInodeNumber) {
+  stopFlusher();
+  flush();
+  TreeOverlay::close(nextInodeNumber);
+}
+
+void BufferedTreeOverlay::stopFlusher() {
+  {
+    auto state = state_.lock();
+    state->stop = true;
+    state->flusherRunning = false;
+  }
+  flusherCondVar_.notify_one();
+  writersCondVar_.notify_all();
+  if (flusher_.joinable()) {
+    flusher_.join();
+  }
+}
+
+const BufferedTreeOverlay::DirtyDir* BufferedTreeOverlay::findDirty(
+    const State& state,
+    InodeNumber inode) {
+  auto it = state.dirty.find(inode);
+  if (it != state.dirty.end()) {
+    return &it->second;
+  }
+  if (state.flushing) {
+    it = state.flushing->find(inode);
+    if (it != state.flushing->end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+void BufferedTreeOverlay::markDirty(
+    LockedState& state,
+    InodeNumber inode,
+    DirtyDir dir) {
+  auto size = estimateSize(dir);
+  if (state->dirty.empty()) {
+    state->dirtySince = std::chrono::steady_clock::now();
+  }
+  auto [it, inserted] = state->dirty.try_emplace(inode);
+  if (!inserted) {
+    state->dirtyBytes -= estimateSize(it->second);
+  }
+  it->second = std::move(dir);
+  state->dirtyBytes += size;
+
+  if (state->dirtyBytes >= maxDirtyBytes_) {
+    flusherCondVar_.notify_one();
+    // Without a flusher, the writes are only flushed on close.
+    writersCondVar_.wait(state.as_lock(), [&] {
+      return state->dirtyBytes < maxDirtyBytes_ || !state->flusherRunning;
+    });
+  }
+}
+
+std::optional<overlay::OverlayDir> BufferedTreeOverlay::loadOverlayDir(
+    InodeNumber inodeNumber) {
+  {
+    auto state = state_.lock();
+    if (auto* dir = findDirty(*state, inodeNumber)) {
+      return *dir;
+    }
+  }
+  return TreeOverlay::loadOverlayDir(inodeNumber);
+}
+
+std::optional<overlay::OverlayDir> BufferedTreeOverlay::loadAndRemoveOverlayDir(
+    InodeNumber inodeNumber) {
+  // Keep the lock while reading the store so that the directory can't be
+  // written in between.
+  auto state = state_.lock();
+  DirtyDir dir;
+  if (auto* dirty = findDirty(*state, inodeNumber)) {
+    dir = *dirty;
+  } else {
+    dir = TreeOverlay::loadOverlayDir(inodeNumber);
+  }
+  markDirty(state, inodeNumber, std::nullopt);
+  return dir;
+}
+
+void BufferedTreeOverlay::saveOverlayDir(
+    InodeNumber inodeNumber,
+    const overlay::OverlayDir& odir) {
+  auto state = state_.lock();
+  markDirty(state, inodeNumber, odir);
+}
+
+void BufferedTreeOverlay::removeOverlayData(InodeNumber inodeNumber) {
+  auto state = state_.lock();
+  markDirty(state, inodeNumber, std::nullopt);
+}
+
+bool BufferedTreeOverlay::hasOverlayData(InodeNumber inodeNumber) {
+  {
+    auto state = state_.lock();
+    if (auto* dir = findDirty(*state, inodeNumber)) {
+      // Like the store, which only knows about directories with entries.
+      return dir->has_value() && !(*dir)->entries_ref()->empty();
+    }
+  }
+  return TreeOverlay::hasOverlayData(inodeNumber);
+}
+
+void BufferedTreeOverlay::addChild(
+    InodeNumber /*parent*/,
+    PathComponentPiece /*name*/,
+    overlay::OverlayEntry /*entry*/) {
+  EDEN_BUG() << "semantic operations are not supported by "
+                "BufferedTreeOverlay";
+}
+
+void BufferedTreeOverlay::removeChild(
+    InodeNumber /*parent*/,
+    PathComponentPiece /*childName*/) {
+  EDEN_BUG() << "semantic operations are not supported by "
+                "BufferedTreeOverlay";
+}
+
+void BufferedTreeOverlay::renameChild(
+    InodeNumber /*src*/,
+    InodeNumber /*dst*/,
+    PathComponentPiece /*srcName*/,
+    PathComponentPiece /*dstName*/) {
+  EDEN_BUG() << "semantic operations are not supported by "
+                "BufferedTreeOverlay";
+}
+
+size_t BufferedTreeOverlay::getDirtyBytes() const {
+  return state_.lock()->dirtyBytes;
+}
+
+void BufferedTreeOverlay::flush() {
+  std::lock_guard<std::mutex> guard{flushMutex_};
+  flushLocked();
+}
+
+void BufferedTreeOverlay::flusherThread() noexcept {
+  folly::setThreadName("OverlayFlusher");
+  for (;;) {
+    {
+      auto state = state_.lock();
+      while (!state->stop && state->dirtyBytes < maxDirtyBytes_) {
+        if (state->dirty.empty()) {
+          flusherCondVar_.wait(state.as_lock());
+          continue;
+        }
+        auto deadline = state->dirtySince + maxDirtyAge_;
+        if (std::chrono::steady_clock::now() >= deadline) {
+          break;
+        }
+        flusherCondVar_.wait_until(state.as_lock(), deadline);
+      }
+      if (state->stop) {
+        // close() flushes what is left.
+        return;
+      }
+    }
+
+    std::lock_guard<std::mutex> guard{flushMutex_};
+    flushLocked();
+  }
+}
+
+void BufferedTreeOverlay::flushLocked() {
+  std::shared_ptr<const DirtyTable> flushing;
+  {
+    auto state = state_.lock();
+    if (state->dirty.empty()) {
+      return;
+    }
+    flushing = std::make_shared<const DirtyTable>(std::move(state->dirty));
+    state->dirty.clear();
+    state->dirtyBytes = 0;
+    state->flushing = flushing;
+  }
+  writersCondVar_.notify_all();
+
+  bool committed = false;
+  try {
+    store_.beginBatch(0);
+    for (const auto& [inode, dir] : *flushing) {
+      try {
+        if (dir) {
+          store_.saveTree(inode, *dir);
+        } else {
+          store_.loadAndRemoveTree(inode);
+        }
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "failed to flush overlay directory " << inode << ": "
+                  << ex.what();
+      }
+    }
+    store_.endBatch();
+    committed = true;
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "failed to flush " << flushing->size()
+              << " overlay directories: " << ex.what();
+  }
+
+  auto state = state_.lock();
+  if (!committed) {
+    // Retry the writes that weren't superseded with the next flush.
+    if (state->dirty.empty()) {
+      state->dirtySince = std::chrono::steady_clock::now();
+    }
+    for (const auto& [inode, dir] : *flushing) {
+      if (state->dirty.emplace(inode, dir).second) {
+        state->dirtyBytes += estimateSize(dir);
+      }
+    }
+  }
+  state->flushing.reset();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
+
+namespace facebook::eden {
+
+/**
+ * A TreeOverlay that buffers directory writes in memory and writes them to
+ * the TreeOverlayStore from a background thread.
+ *
+ * Writes return as soon as the directory is in the in-memory dirty table,
+ * and reads look it up before the store. The dirty table is flushed when it
+ * holds `maxDirtyBytes` or when its oldest write is `maxDirtyAge` old, and
+ * on close(). Writers block while the dirty table is full, so at most
+ * `maxDirtyBytes` are waiting for a flush besides those being flushed.
+ *
+ * Each flush writes the whole dirty table in a single SQLite transaction, so
+ * the store always holds the overlay as it was at some point in time: a crash
+ * loses the writes of the last `maxDirtyAge`, but doesn't leave a directory
+ * referencing an unsaved child.
+ *
+ * This overlay doesn't support semantic operations: Overlay saves the whole
+ * parent directory on each change, and successive saves of a directory are
+ * coalesced in the dirty table.
+ */
+class BufferedTreeOverlay : public TreeOverlay {
+ public:
+  BufferedTreeOverlay(
+      AbsolutePathPiece path,
+      size_t maxDirtyBytes,
+      std::chrono::milliseconds maxDirtyAge,
+      TreeOverlayStore::SynchronousMode mode =
+          TreeOverlayStore::SynchronousMode::Normal);
+
+  BufferedTreeOverlay(
+      std::unique_ptr<SqliteDatabase> store,
+      size_t maxDirtyBytes,
+      std::chrono::milliseconds maxDirtyAge);
+
+  ~BufferedTreeOverlay() override;
+
+  BufferedTreeOverlay(const BufferedTreeOverlay&) = delete;
+  BufferedTreeOverlay& operator=(const BufferedTreeOverlay&) = delete;
+
+  BufferedTreeOverlay(BufferedTreeOverlay&&) = delete;
+  BufferedTreeOverlay& operator=(BufferedTreeOverlay&&) = delete;
+
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  std::optional<InodeNumber> initOverlay(bool createIfNonExisting) override;
+
+  /**
+   * Flush the dirty table and stop the flusher before closing the store.
+   */
+  void close(std::optional<InodeNumber> nextInodeNumber) override;
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override;
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  void saveOverlayDir(InodeNumber inodeNumber, const overlay::OverlayDir& odir)
+      override;
+
+  void removeOverlayData(InodeNumber inodeNumber) override;
+
+  bool hasOverlayData(InodeNumber inodeNumber) override;
+
+  void addChild(
+      InodeNumber parent,
+      PathComponentPiece name,
+      overlay::OverlayEntry entry) override;
+
+  void removeChild(InodeNumber parent, PathComponentPiece childName) override;
+
+  void renameChild(
+      InodeNumber src,
+      InodeNumber dst,
+      PathComponentPiece srcName,
+      PathComponentPiece dstName) override;
+
+  // Flushes already group writes into transactions.
+  void beginBatch(size_t /* commitInterval */) override {}
+  void endBatch() override {}
+
+  /**
+   * Write the directories dirty when flush() is called to the store, and
+   * wait for them to be committed.
+   */
+  void flush();
+
+  /// Approximate size of the directories waiting for a flush, in bytes.
+  size_t getDirtyBytes() const;
+
+ private:
+  /// A pending write: the new contents of a directory, or nullopt if it was
+  /// removed.
+  using DirtyDir = std::optional<overlay::OverlayDir>;
+  using DirtyTable = std::unordered_map<InodeNumber, DirtyDir>;
+
+  struct State {
+    /// Directories written since the last flush started.
+    DirtyTable dirty;
+    size_t dirtyBytes{0};
+    /// When the oldest write of `dirty` was made.
+    std::chrono::steady_clock::time_point dirtySince;
+
+    /// Directories being written by the current flush. They are only dropped
+    /// once committed, so that reads keep seeing them until then.
+    std::shared_ptr<const DirtyTable> flushing;
+
+    bool flusherRunning{false};
+    bool stop{false};
+  };
+
+  using LockedState = folly::Synchronized<State, std::mutex>::LockedPtr;
+
+  /**
+   * Return the pending write of the directory, or nullptr if the store is up
+   * to date.
+   */
+  static const DirtyDir* findDirty(const State& state, InodeNumber inode);
+
+  /**
+   * Record a write of the directory, and wait for room in the dirty table.
+   */
+  void markDirty(LockedState& state, InodeNumber inode, DirtyDir dir);
+
+  void flusherThread() noexcept;
+
+  /**
+   * Write the dirty table to the store. Callers must hold flushMutex_.
+   */
+  void flushLocked();
+
+  void stopFlusher();
+
+  const size_t maxDirtyBytes_;
+  const std::chrono::milliseconds maxDirtyAge_;
+
+  folly::Synchronized<State, std::mutex> state_;
+  /// Signaled when the dirty table is full or the flusher should stop.
+  std::condition_variable flusherCondVar_;
+  /// Signaled when a flush frees room in the dirty table.
+  std::condition_variable writersCondVar_;
+
+  /// Serializes flushes, so that flush() waits for a flush in progress.
+  std::mutex flushMutex_;
+
+  std::thread flusher_;
+};
+
+} // namespace facebook::eden
@@ -18,7 +18,7 @@ namespace facebook::eden {
 TreeOverlay::TreeOverlay(
     AbsolutePathPiece path,
     TreeOverlayStore::SynchronousMode mode)
-    : path_{path.copy()}, store_{path_, mode} {}
+    : store_{path, mode}, path_{path.copy()} {}
 
 std::optional<InodeNumber> TreeOverlay::initOverlay(bool createIfNonExisting) {
   if (createIfNonExisting) {
@@ -30,6 +30,13 @@ std::optional<InodeNumber> TreeOverlay::initOverlay(bool createIfNonExisting) {
 
 void TreeOverlay::close(std::optional<InodeNumber> /*nextInodeNumber*/) {
   store_.close();
+#ifdef _WIN32
+  if (mountPath_) {
+    if (auto checkpoint = getUsnCheckpoint(*mountPath_)) {
+      saveUsnCheckpoint(path_, *checkpoint);
+    }
+  }
+#endif
 }
 
 const AbsolutePath& TreeOverlay::getLocalDir() const {
@@ -65,6 +72,17 @@ folly::File TreeOverlay::createOverlayFile(
   EDEN_BUG() << "UNIMPLEMENTED";
 }
 
+folly::File TreeOverlay::createOverlayFileFromBlob(
+    InodeNumber /*inodeNumber*/,
+    const ObjectId& /*blobId*/,
+    const folly::IOBuf& /*contents*/) {
+  EDEN_BUG() << "UNIMPLEMENTED";
+}
+
+IOverlay::FileCopyStats TreeOverlay::getFileCopyStats() const {
+  return {};
+}
+
 folly::File TreeOverlay::openFile(
     InodeNumber /*inodeNumber*/,
     folly::StringPiece /*headerId*/) {
@@ -109,13 +127,32 @@ void TreeOverlay::renameChild(
   return store_.renameChild(src, dst, srcName, dstName);
 }
 
+void TreeOverlay::beginBatch(size_t commitInterval) {
+  store_.beginBatch(commitInterval);
+}
+
+void TreeOverlay::endBatch() {
+  store_.endBatch();
+}
+
 InodeNumber TreeOverlay::nextInodeNumber() {
   return store_.nextInodeNumber();
 }
 
 InodeNumber TreeOverlay::scanLocalChanges(AbsolutePathPiece mountPath) {
 #ifdef _WIN32
-  windowsFsckScanLocalChanges(*this, mountPath);
+  if (path_.empty()) {
+    windowsFsckScanLocalChanges(*this, mountPath);
+  } else {
+    // Changes made during the scan are picked up by the next one. Recording
+    // the position now also covers a crash before close() records it again.
+    auto current = getUsnCheckpoint(mountPath);
+    windowsFsckScanLocalChanges(*this, mountPath, loadUsnCheckpoint(path_));
+    if (current) {
+      saveUsnCheckpoint(path_, *current);
+    }
+    mountPath_ = mountPath.copy();
+  }
 #else
   (void)mountPath;
 #endif
@@ -73,6 +73,13 @@ class TreeOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  folly::File createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) override;
+
+  FileCopyStats getFileCopyStats() const override;
+
   folly::File openFile(InodeNumber inodeNumber, folly::StringPiece headerId)
       override;
 
@@ -98,19 +105,32 @@ class TreeOverlay : public IOverlay {
       PathComponentPiece srcName,
       PathComponentPiece dstName) override;
 
+  void beginBatch(size_t commitInterval) override;
+
+  void endBatch() override;
+
   InodeNumber nextInodeNumber();
 
   /**
    * Scan filesystem changes when EdenFS is not running. This is only required
    * on Windows as ProjectedFS allows user to make changes under certain
    * directory when EdenFS is not running.
+   *
+   * On Windows, only the directories that the NTFS change journal recorded
+   * changes in since the overlay was last closed are scanned.
    */
   InodeNumber scanLocalChanges(AbsolutePathPiece mountPath);
 
+ protected:
+  TreeOverlayStore store_;
+
  private:
   AbsolutePath path_;
 
-  TreeOverlayStore store_;
+#ifdef _WIN32
+  // Set by scanLocalChanges, to record the change journal position on close.
+  std::optional<AbsolutePath> mountPath_;
+#endif
 
   bool initialized_ = false;
 };
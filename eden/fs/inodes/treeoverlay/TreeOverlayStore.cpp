@@ -37,6 +37,25 @@ constexpr uint32_t kSchemaVersion = 1;
 // Maximum number of values when we do batch insertion
 constexpr size_t kBatchInsertSize = 8;
 
+// Number of read-only connections, so that loading trees does not wait
+// behind writes such as checkout saving trees.
+constexpr size_t kReadConnectionCount = 4;
+
+/**
+ * Append the rows returned by a `selectTree` query to `dir`.
+ */
+void readTree(SqliteStatement& query, overlay::OverlayDir& dir) {
+  while (query.step()) {
+    auto name = query.columnBlob(0);
+    overlay::OverlayEntry entry;
+    entry.mode_ref() =
+        dtype_to_mode(static_cast<dtype_t>(query.columnUint64(1)));
+    entry.inodeNumber_ref() = query.columnUint64(2);
+    entry.hash_ref() = query.columnBlob(3).toString();
+    dir.entries_ref()->emplace(std::make_pair(name, entry));
+  }
+}
+
 } // namespace
 
 struct TreeOverlayStore::StatementCache {
@@ -119,6 +138,22 @@ struct TreeOverlayStore::StatementCache {
   std::array<PersistentSqliteStatement, kBatchInsertSize> batchInsert;
 };
 
+/**
+ * The statements that are run on read-only connections.
+ */
+struct TreeOverlayStore::ReadStatementCache {
+  explicit ReadStatementCache(SqliteDatabase::Connection& db)
+      : selectTree{
+            db,
+            "SELECT name, dtype, inode, hash FROM ",
+            kEntryTable,
+            " WHERE parent = ? ORDER BY name"},
+        hasTree{db, "SELECT 1 FROM ", kEntryTable, " WHERE parent = ?"} {}
+
+  PersistentSqliteStatement selectTree;
+  PersistentSqliteStatement hasTree;
+};
+
 TreeOverlayStore::TreeOverlayStore(
     AbsolutePathPiece path,
     TreeOverlayStore::SynchronousMode synchronous_mode) {
@@ -136,6 +171,9 @@ TreeOverlayStore::TreeOverlayStore(
         << "Synchronous mode is off. Data loss may happen when system crashes.";
     SqliteStatement(dbLock, "PRAGMA synchronous=OFF").step();
   }
+  dbLock.unlock();
+
+  db_->openReadConnections(kReadConnectionCount);
 }
 
 TreeOverlayStore::TreeOverlayStore(std::unique_ptr<SqliteDatabase> db)
@@ -147,13 +185,23 @@ TreeOverlayStore::~TreeOverlayStore() = default;
 
 void TreeOverlayStore::close() {
   cache_.reset();
+  readCaches_.clear();
   if (db_) {
     db_->close();
   }
 }
 
+void TreeOverlayStore::beginBatch(size_t commitInterval) {
+  db_->beginBatch(commitInterval);
+}
+
+void TreeOverlayStore::endBatch() {
+  db_->endBatch();
+}
+
 std::unique_ptr<SqliteDatabase> TreeOverlayStore::takeDatabase() {
   cache_.reset();
+  readCaches_.clear();
   return std::move(db_);
 }
 
@@ -221,6 +269,15 @@ void TreeOverlayStore::createTableIfNonExisting() {
     auto conn = db_->lock();
     cache_ = std::make_unique<StatementCache>(conn);
   }
+
+  // Read connections only see committed data, which now includes the tables.
+  readCaches_.clear();
+  for (size_t i = 0; i < db_->getReadConnectionCount(); ++i) {
+    auto conn = db_->lockForRead();
+    XCHECK(conn.has_value());
+    XCHECK_EQ(i, conn->index);
+    readCaches_.push_back(std::make_unique<ReadStatementCache>(conn->conn));
+  }
 }
 
 InodeNumber TreeOverlayStore::loadCounters() {
@@ -314,19 +371,17 @@ void TreeOverlayStore::saveTree(
 overlay::OverlayDir TreeOverlayStore::loadTree(InodeNumber inode) {
   overlay::OverlayDir dir;
 
+  if (auto read = lockForRead()) {
+    auto& query = readCaches_[read->index]->selectTree.get(read->conn);
+    query.bind(1, inode.get());
+    readTree(query, dir);
+    return dir;
+  }
+
   db_->transaction([&](auto& txn) {
     auto& query = cache_->selectTree.get(txn);
     query.bind(1, inode.get());
-
-    while (query.step()) {
-      auto name = query.columnBlob(0);
-      overlay::OverlayEntry entry;
-      entry.mode_ref() =
-          dtype_to_mode(static_cast<dtype_t>(query.columnUint64(1)));
-      entry.inodeNumber_ref() = query.columnUint64(2);
-      entry.hash_ref() = query.columnBlob(3).toString();
-      dir.entries_ref()->emplace(std::make_pair(name, entry));
-    }
+    readTree(query, dir);
   });
 
   return dir;
@@ -339,16 +394,7 @@ overlay::OverlayDir TreeOverlayStore::loadAndRemoveTree(InodeNumber inode) {
     // SQLite does not support select-and-delete in one query.
     auto& query = cache_->selectTree.get(txn);
     query.bind(1, inode.get());
-
-    while (query.step()) {
-      auto name = query.columnBlob(0);
-      overlay::OverlayEntry entry;
-      entry.mode_ref() =
-          dtype_to_mode(static_cast<dtype_t>(query.columnUint64(1)));
-      entry.inodeNumber_ref() = query.columnUint64(2);
-      entry.hash_ref() = query.columnBlob(3).toString();
-      dir.entries_ref()->emplace(std::make_pair(name, entry));
-    }
+    readTree(query, dir);
 
     auto& deleteInode = cache_->deleteTree.get(txn);
     deleteInode.reset();
@@ -376,6 +422,12 @@ void TreeOverlayStore::removeTree(InodeNumber inode) {
 }
 
 bool TreeOverlayStore::hasTree(InodeNumber inode) {
+  if (auto read = lockForRead()) {
+    auto& query = readCaches_[read->index]->hasTree.get(read->conn);
+    query.bind(1, inode.get());
+    return query.step() && query.columnUint64(0) == 1;
+  }
+
   auto db = db_->lock();
   auto& query = cache_->hasTree.get(db);
   query.bind(1, inode.get());
@@ -389,20 +441,24 @@ void TreeOverlayStore::addChild(
     InodeNumber parent,
     PathComponentPiece name,
     overlay::OverlayEntry entry) {
-  auto db = db_->lock();
-  auto& stmt = cache_->insertChild.get(db);
-  insertInodeEntry(stmt, 0, parent, name, entry);
-  stmt.step();
+  // A single statement is already atomic, but running it as a transaction
+  // makes it count towards the commit interval of a batch.
+  db_->transaction([&](auto& txn) {
+    auto& stmt = cache_->insertChild.get(txn);
+    insertInodeEntry(stmt, 0, parent, name, entry);
+    stmt.step();
+  });
 }
 
 void TreeOverlayStore::removeChild(
     InodeNumber parent,
     PathComponentPiece childName) {
-  auto db = db_->lock();
-  auto& stmt = cache_->deleteChild.get(db);
-  stmt.bind(1, parent.get());
-  stmt.bind(2, childName.stringPiece());
-  stmt.step();
+  db_->transaction([&](auto& txn) {
+    auto& stmt = cache_->deleteChild.get(txn);
+    stmt.bind(1, parent.get());
+    stmt.bind(2, childName.stringPiece());
+    stmt.step();
+  });
 }
 
 void TreeOverlayStore::renameChild(
@@ -436,6 +492,15 @@ void TreeOverlayStore::renameChild(
   });
 }
 
+std::optional<SqliteDatabase::ReadConnection>
+TreeOverlayStore::lockForRead() {
+  // Before createTableIfNonExisting() there are no read statements yet.
+  if (readCaches_.empty()) {
+    return std::nullopt;
+  }
+  return db_->lockForRead();
+}
+
 void TreeOverlayStore::insertInodeEntry(
     SqliteStatement& inserts,
     size_t index,
@@ -10,6 +10,7 @@
 #include <gtest/gtest_prod.h>
 #include <atomic>
 #include <memory>
+#include <vector>
 
 #include <fmt/format.h>
 #include "eden/fs/sqlite/SqliteDatabase.h"
@@ -134,12 +135,27 @@ class TreeOverlayStore {
       PathComponentPiece srcName,
       PathComponentPiece dstName);
 
+  /**
+   * Group the following mutations into a single SQLite transaction,
+   * committed every `commitInterval` mutations and when the matching
+   * endBatch() is called. See SqliteDatabase::beginBatch().
+   */
+  void beginBatch(size_t commitInterval);
+  void endBatch();
+
   std::unique_ptr<SqliteDatabase> takeDatabase();
 
  private:
   FRIEND_TEST(TreeOverlayStoreTest, testRecoverInodeEntryNumber);
 
   struct StatementCache;
+  struct ReadStatementCache;
+
+  /**
+   * Lock a read-only connection for which read statements were prepared.
+   * Returns std::nullopt if reads must use the writer connection.
+   */
+  std::optional<SqliteDatabase::ReadConnection> lockForRead();
 
   /**
    * Private helper function to add a SQLite statement that inserts a row to the
@@ -156,6 +172,12 @@ class TreeOverlayStore {
 
   std::unique_ptr<StatementCache> cache_;
 
+  /**
+   * Prepared read statements for each of the database's read connections,
+   * indexed by SqliteDatabase::ReadConnection::index.
+   */
+  std::vector<std::unique_ptr<ReadStatementCache>> readCaches_;
+
   std::atomic_uint64_t nextEntryId_{0};
 
   std::atomic_uint64_t nextInode_{0};
@@ -9,7 +9,12 @@
 
 #ifdef _WIN32
 #include <boost/filesystem.hpp>
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/ScopeGuard.h>
+#include <folly/String.h>
 #include <folly/portability/Windows.h>
+#include <unordered_set>
 
 #include <ProjectedFSLib.h> // @manual
 #include <winioctl.h> // @manual
@@ -19,6 +24,7 @@
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/FileUtils.h"
 
 namespace facebook::eden {
 namespace {
@@ -200,20 +206,257 @@ void removeOverlayEntry(
   overlay.removeChild(parent, name);
 }
 
-void scanCurrentDir(
-    TreeOverlay& overlay,
-    AbsolutePathPiece dir,
-    InodeNumber inode,
-    overlay::OverlayDir knownState,
-    bool recordDeletion) {
-  auto boostPath = boost::filesystem::path(dir.stringPiece());
-  if (!boost::filesystem::is_directory(boostPath)) {
-    XLOGF(WARN, "Attempting to scan '{}' which is not a directory", dir);
-    return;
+/**
+ * The directories under a mount whose entries changed, keyed by their
+ * lowercased path since the mount is case insensitive.
+ */
+struct ChangedDirs {
+  std::unordered_set<std::string> dirs;
+  // Every ancestor of the changed directories, up to the mount.
+  std::unordered_set<std::string> ancestors;
+};
+
+std::string changedDirsKey(AbsolutePathPiece path) {
+  auto key = path.stringPiece().str();
+  folly::toLowerAscii(key);
+  return key;
+}
+
+const PathComponentPiece kUsnCheckpointFile{"usn-checkpoint"};
+
+const DWORD kUsnReasons = USN_REASON_FILE_CREATE | USN_REASON_FILE_DELETE |
+    USN_REASON_RENAME_OLD_NAME | USN_REASON_RENAME_NEW_NAME;
+
+#ifdef FSCTL_READ_UNPRIVILEGED_USN_JOURNAL
+// Doesn't require EdenFS to run as an administrator.
+const DWORD kReadUsnJournal = FSCTL_READ_UNPRIVILEGED_USN_JOURNAL;
+#else
+const DWORD kReadUsnJournal = FSCTL_READ_USN_JOURNAL;
+#endif
+
+/**
+ * Open the volume holding `path`, or return INVALID_HANDLE_VALUE.
+ */
+HANDLE openVolume(AbsolutePathPiece path) {
+  auto wpath = path.wide();
+  wchar_t mountPoint[MAX_PATH];
+  wchar_t volume[MAX_PATH];
+  if (!GetVolumePathNameW(wpath.c_str(), mountPoint, MAX_PATH) ||
+      !GetVolumeNameForVolumeMountPointW(mountPoint, volume, MAX_PATH)) {
+    XLOGF(DBG3, "Unable to find the volume of {}: {}", path, GetLastError());
+    return INVALID_HANDLE_VALUE;
+  }
+  // The volume name ends with a backslash, which would open its root
+  // directory instead of the volume.
+  std::wstring volumeName{volume};
+  if (!volumeName.empty() && volumeName.back() == L'\\') {
+    volumeName.pop_back();
+  }
+  return CreateFileW(
+      volumeName.c_str(),
+      FILE_READ_ATTRIBUTES,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr,
+      OPEN_EXISTING,
+      0,
+      nullptr);
+}
+
+std::optional<USN_JOURNAL_DATA_V0> queryUsnJournal(HANDLE volume) {
+  USN_JOURNAL_DATA_V0 data;
+  DWORD bytes;
+  if (!DeviceIoControl(
+          volume,
+          FSCTL_QUERY_USN_JOURNAL,
+          nullptr,
+          0,
+          &data,
+          sizeof(data),
+          &bytes,
+          nullptr)) {
+    XLOGF(DBG3, "Unable to query the USN journal: {}", GetLastError());
+    return std::nullopt;
+  }
+  return data;
+}
+
+/**
+ * Returns the path of an open file, without the \\?\ prefix.
+ */
+std::optional<AbsolutePath> getFinalPath(HANDLE handle) {
+  std::wstring path(MAX_PATH, L'\0');
+  auto length = GetFinalPathNameByHandleW(
+      handle, path.data(), static_cast<DWORD>(path.size()), 0);
+  if (length >= path.size()) {
+    path.resize(length);
+    length = GetFinalPathNameByHandleW(
+        handle, path.data(), static_cast<DWORD>(path.size()), 0);
+  }
+  if (length == 0 || length >= path.size()) {
+    return std::nullopt;
   }
+  path.resize(length);
+  std::wstring_view view{path};
+  constexpr std::wstring_view kPrefix{L"\\\\?\\"};
+  if (view.substr(0, kPrefix.size()) == kPrefix) {
+    view.remove_prefix(kPrefix.size());
+  }
+  return AbsolutePath{view};
+}
 
-  XLOGF(DBG3, "Scanning {}", dir);
+/**
+ * Read the change journal of the volume holding `mountPath` from `since` on,
+ * and return the directories under `mountPath` that had entries created,
+ * deleted or renamed. Returns std::nullopt when the journal can't tell, in
+ * which case the whole mount needs to be scanned.
+ */
+std::optional<ChangedDirs> readChangedDirs(
+    AbsolutePathPiece mountPath,
+    UsnCheckpoint since) {
+  auto volume = openVolume(mountPath);
+  if (volume == INVALID_HANDLE_VALUE) {
+    XLOGF(DBG3, "Unable to open the volume of {}", mountPath);
+    return std::nullopt;
+  }
+  SCOPE_EXIT {
+    CloseHandle(volume);
+  };
+
+  auto journal = queryUsnJournal(volume);
+  if (!journal) {
+    return std::nullopt;
+  }
+  if (journal->UsnJournalID != since.journalId) {
+    XLOGF(INFO, "The USN journal of {} was recreated", mountPath);
+    return std::nullopt;
+  }
+  if (journal->LowestValidUsn > since.usn) {
+    XLOGF(INFO, "The USN journal of {} wrapped", mountPath);
+    return std::nullopt;
+  }
 
+  // Collect the file reference numbers of the parent directories first, as
+  // many changes are usually made to the same directories.
+  std::unordered_set<DWORDLONG> parents;
+  READ_USN_JOURNAL_DATA_V1 read{};
+  read.StartUsn = since.usn;
+  read.ReasonMask = kUsnReasons;
+  read.UsnJournalID = since.journalId;
+  read.MinMajorVersion = 2;
+  read.MaxMajorVersion = 2;
+  std::vector<uint64_t> buffer(64 * 1024 / sizeof(uint64_t));
+  DWORD bytes;
+  auto data = reinterpret_cast<const char*>(buffer.data());
+  while (read.StartUsn < journal->NextUsn) {
+    if (!DeviceIoControl(
+            volume,
+            kReadUsnJournal,
+            &read,
+            sizeof(read),
+            buffer.data(),
+            buffer.size() * sizeof(uint64_t),
+            &bytes,
+            nullptr)) {
+      XLOGF(DBG3, "Unable to read the USN journal: {}", GetLastError());
+      return std::nullopt;
+    }
+    if (bytes <= sizeof(USN)) {
+      break;
+    }
+    for (auto offset = sizeof(USN); offset < bytes;) {
+      auto record = reinterpret_cast<const USN_RECORD_V2*>(data + offset);
+      parents.insert(record->ParentFileReferenceNumber);
+      offset += record->RecordLength;
+    }
+    read.StartUsn = *reinterpret_cast<const USN*>(data);
+  }
+
+  auto mountHandle = CreateFileW(
+      mountPath.wide().c_str(),
+      FILE_READ_ATTRIBUTES,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_FLAG_BACKUP_SEMANTICS,
+      nullptr);
+  if (mountHandle == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  auto finalMount = getFinalPath(mountHandle);
+  CloseHandle(mountHandle);
+  if (!finalMount) {
+    return std::nullopt;
+  }
+  // The journal names directories by their final path, which may differ from
+  // the mount path, e.g. when the mount is reached through a junction.
+  auto finalMountKey = changedDirsKey(*finalMount);
+  auto mountKey = changedDirsKey(mountPath);
+
+  ChangedDirs changed;
+  for (auto parent : parents) {
+    FILE_ID_DESCRIPTOR id{};
+    id.dwSize = sizeof(id);
+    id.Type = FileIdType;
+    id.FileId.QuadPart = parent;
+    auto handle = OpenFileById(
+        volume,
+        &id,
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        FILE_FLAG_BACKUP_SEMANTICS);
+    if (handle == INVALID_HANDLE_VALUE) {
+      auto error = GetLastError();
+      // The directory was removed since. Its own removal was recorded in its
+      // parent.
+      if (error == ERROR_INVALID_PARAMETER || error == ERROR_FILE_NOT_FOUND ||
+          error == ERROR_PATH_NOT_FOUND) {
+        continue;
+      }
+      XLOGF(DBG3, "Unable to open directory {}: {}", parent, error);
+      return std::nullopt;
+    }
+    auto path = getFinalPath(handle);
+    CloseHandle(handle);
+    if (!path) {
+      return std::nullopt;
+    }
+
+    auto key = changedDirsKey(*path);
+    if (!folly::StringPiece{key}.startsWith(finalMountKey) ||
+        (key.size() > finalMountKey.size() &&
+         !detail::isDirSeparator(key[finalMountKey.size()]))) {
+      continue;
+    }
+    key = mountKey + key.substr(finalMountKey.size());
+    changed.dirs.insert(key);
+    auto ancestor = AbsolutePathPiece{key};
+    while (ancestor.stringPiece().size() > mountKey.size()) {
+      ancestor = ancestor.dirname();
+      if (!changed.ancestors.insert(ancestor.stringPiece().str()).second) {
+        break;
+      }
+    }
+  }
+  XLOGF(
+      INFO,
+      "{} directories of {} changed since the last scan",
+      changed.dirs.size(),
+      mountPath);
+  return changed;
+}
+
+/**
+ * Synchronize the overlay entries of `dir` with its entries on disk, and
+ * return the lowercased names of the directories that were added.
+ */
+std::unordered_set<std::string> reconcileCurrentDir(
+    TreeOverlay& overlay,
+    const boost::filesystem::path& boostPath,
+    InodeNumber inode,
+    const overlay::OverlayDir& knownState,
+    bool recordDeletion) {
+  std::unordered_set<std::string> addedDirs;
   auto overlayEntries = makeEntriesSet(knownState);
   // Loop to synchronize overlay state with disk state
   for (const auto& entry : boost::filesystem::directory_iterator(boostPath)) {
@@ -274,6 +517,11 @@ void scanCurrentDir(
       overlayEntry.set_mode(dtype_to_mode(dtype));
       overlayEntry.set_inodeNumber(overlay.nextInodeNumber().get());
       overlay.addChild(inode, name, overlayEntry);
+      if (dtype == dtype_t::Dir) {
+        auto lowered = name.stringPiece().str();
+        folly::toLowerAscii(lowered);
+        addedDirs.insert(std::move(lowered));
+      }
     }
   }
 
@@ -290,6 +538,33 @@ void scanCurrentDir(
       removeOverlayEntry(overlay, inode, *removed);
     }
   }
+  return addedDirs;
+}
+
+/**
+ * Scan `dir` and the directories below it that users could have modified.
+ * With `changed` set, only the changed directories are reconciled, and only
+ * the directories leading to them are visited.
+ */
+void scanCurrentDir(
+    TreeOverlay& overlay,
+    AbsolutePathPiece dir,
+    InodeNumber inode,
+    overlay::OverlayDir knownState,
+    bool recordDeletion,
+    const ChangedDirs* changed) {
+  auto boostPath = boost::filesystem::path(dir.stringPiece());
+  if (!boost::filesystem::is_directory(boostPath)) {
+    XLOGF(WARN, "Attempting to scan '{}' which is not a directory", dir);
+    return;
+  }
+
+  std::unordered_set<std::string> addedDirs;
+  if (!changed || changed->dirs.count(changedDirsKey(dir))) {
+    XLOGF(DBG3, "Scanning {}", dir);
+    addedDirs = reconcileCurrentDir(
+        overlay, boostPath, inode, knownState, recordDeletion);
+  }
 
   XLOGF(DBG9, "Reloading {} from overlay.", inode);
   // Reload the updated overlay as we have fixed the inconsistency.
@@ -309,6 +584,20 @@ void scanCurrentDir(
       continue;
     }
 
+    // Directories that were just added may have been moved in along with
+    // their contents, which the journal doesn't list, so scan all of them.
+    auto childChanged = changed;
+    if (changed) {
+      auto name = path.basename().stringPiece().str();
+      folly::toLowerAscii(name);
+      auto key = changedDirsKey(path);
+      if (addedDirs.count(name)) {
+        childChanged = nullptr;
+      } else if (!changed->dirs.count(key) && !changed->ancestors.count(key)) {
+        continue;
+      }
+    }
+
     auto state = getPrjFileState(path);
     // User can only modify directory content if it is Full or Dirty
     // Placeholder.
@@ -320,18 +609,83 @@ void scanCurrentDir(
       auto entryInode =
           InodeNumber::fromThrift(*overlayEntry->inodeNumber_ref());
       auto entryDir = overlay.loadOverlayDir(entryInode);
-      scanCurrentDir(overlay, path, entryInode, *entryDir, isFull);
+      scanCurrentDir(
+          overlay, path, entryInode, *entryDir, isFull, childChanged);
     }
   }
 }
 } // namespace
 
+std::optional<UsnCheckpoint> getUsnCheckpoint(AbsolutePathPiece mountPath) {
+  auto volume = openVolume(mountPath);
+  if (volume == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  SCOPE_EXIT {
+    CloseHandle(volume);
+  };
+  if (auto journal = queryUsnJournal(volume)) {
+    return UsnCheckpoint{journal->UsnJournalID, journal->NextUsn};
+  }
+  return std::nullopt;
+}
+
+std::optional<UsnCheckpoint> loadUsnCheckpoint(AbsolutePathPiece overlayDir) {
+  auto contents = readFile(overlayDir + kUsnCheckpointFile);
+  if (contents.hasException()) {
+    return std::nullopt;
+  }
+  folly::StringPiece journalId;
+  folly::StringPiece usn;
+  if (!folly::split(' ', folly::trimWhitespace(*contents), journalId, usn)) {
+    XLOGF(WARN, "Ignoring malformed USN checkpoint in {}", overlayDir);
+    return std::nullopt;
+  }
+  auto parsedId = folly::tryTo<uint64_t>(journalId);
+  auto parsedUsn = folly::tryTo<int64_t>(usn);
+  if (!parsedId || !parsedUsn) {
+    XLOGF(WARN, "Ignoring malformed USN checkpoint in {}", overlayDir);
+    return std::nullopt;
+  }
+  return UsnCheckpoint{*parsedId, *parsedUsn};
+}
+
+void saveUsnCheckpoint(AbsolutePathPiece overlayDir, UsnCheckpoint checkpoint) {
+  auto contents =
+      fmt::format("{} {}\n", checkpoint.journalId, checkpoint.usn);
+  auto result = writeFileAtomic(
+      overlayDir + kUsnCheckpointFile,
+      folly::ByteRange{folly::StringPiece{contents}});
+  if (result.hasException()) {
+    XLOGF(
+        WARN,
+        "Unable to save the USN checkpoint in {}: {}",
+        overlayDir,
+        result.exception().what());
+  }
+}
+
 void windowsFsckScanLocalChanges(
     TreeOverlay& overlay,
-    AbsolutePathPiece mountPath) {
-  XLOGF(INFO, "Start scanning {}", mountPath);
+    AbsolutePathPiece mountPath,
+    std::optional<UsnCheckpoint> since) {
+  std::optional<ChangedDirs> changed;
+  if (since) {
+    changed = readChangedDirs(mountPath, *since);
+  }
+  XLOGF(
+      INFO,
+      "Start scanning {}{}",
+      mountPath,
+      changed ? " for journaled changes" : "");
   if (auto view = overlay.loadOverlayDir(kRootNodeId)) {
-    scanCurrentDir(overlay, mountPath, kRootNodeId, *view, false);
+    scanCurrentDir(
+        overlay,
+        mountPath,
+        kRootNodeId,
+        *view,
+        false,
+        changed ? &*changed : nullptr);
     XLOGF(INFO, "Scanning complete for {}", mountPath);
   } else {
     XLOG(INFO)
@@ -9,12 +9,38 @@
 
 #ifdef _WIN32
 
+#include <optional>
+
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
 
 class TreeOverlay;
 
+/**
+ * A position in the NTFS change journal of the volume holding a mount.
+ */
+struct UsnCheckpoint {
+  uint64_t journalId;
+  int64_t usn;
+};
+
+/**
+ * Returns the current end of the change journal of the volume holding
+ * `mountPath`, or std::nullopt if the volume has no change journal.
+ */
+std::optional<UsnCheckpoint> getUsnCheckpoint(AbsolutePathPiece mountPath);
+
+/**
+ * Load the checkpoint saved in the overlay directory, if any.
+ */
+std::optional<UsnCheckpoint> loadUsnCheckpoint(AbsolutePathPiece overlayDir);
+
+/**
+ * Save a checkpoint to the overlay directory, replacing the previous one.
+ */
+void saveUsnCheckpoint(AbsolutePathPiece overlayDir, UsnCheckpoint checkpoint);
+
 /**
  * Walk the directory hierarchy for the given `mountPath` and fix the
  * divergence in our overlay.
@@ -44,10 +70,15 @@ class TreeOverlay;
  *
  * See also: https://docs.microsoft.com/en-us/windows/win32/projfs/cache-state
  *
+ * When `since` is set, only the directories whose entries the change journal
+ * recorded as created, deleted or renamed after it are reconciled, along with
+ * directories newly added under them. The whole mount is scanned if the
+ * journal no longer goes back that far or can't be read.
  */
 void windowsFsckScanLocalChanges(
     TreeOverlay& overlay,
-    AbsolutePathPiece mountPath);
+    AbsolutePathPiece mountPath,
+    std::optional<UsnCheckpoint> since = std::nullopt);
 
 } // namespace facebook::eden
 
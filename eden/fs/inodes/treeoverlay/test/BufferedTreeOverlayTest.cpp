@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/treeoverlay/BufferedTreeOverlay.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/DirType.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr InodeNumber kDirInode{2};
+constexpr InodeNumber kSubdirInode{3};
+
+overlay::OverlayDir makeDir(std::initializer_list<const char*> names) {
+  overlay::OverlayDir dir;
+  uint64_t inode = 10;
+  for (auto name : names) {
+    overlay::OverlayEntry entry;
+    entry.mode_ref() = dtype_to_mode(dtype_t::Regular);
+    entry.inodeNumber_ref() = inode++;
+    dir.entries_ref()->emplace(name, std::move(entry));
+  }
+  return dir;
+}
+
+class BufferedTreeOverlayTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<BufferedTreeOverlay> open(
+      size_t maxDirtyBytes,
+      std::chrono::milliseconds maxDirtyAge = 1h) {
+    auto overlay = std::make_unique<BufferedTreeOverlay>(
+        localDir_, maxDirtyBytes, maxDirtyAge);
+    overlay->initOverlay(true);
+    return overlay;
+  }
+
+  folly::test::TemporaryDirectory testDir_{makeTempDir()};
+  AbsolutePath localDir_{testDir_.path().string()};
+};
+
+} // namespace
+
+TEST_F(BufferedTreeOverlayTest, writesAreVisibleBeforeBeingFlushed) {
+  auto overlay = open(1024 * 1024);
+  overlay->saveOverlayDir(kDirInode, makeDir({"a", "b"}));
+  EXPECT_GT(overlay->getDirtyBytes(), 0);
+  EXPECT_TRUE(overlay->hasOverlayData(kDirInode));
+  EXPECT_EQ(2, overlay->loadOverlayDir(kDirInode)->entries_ref()->size());
+
+  // Successive writes of a directory are coalesced.
+  overlay->saveOverlayDir(kDirInode, makeDir({"a"}));
+  EXPECT_EQ(1, overlay->loadOverlayDir(kDirInode)->entries_ref()->size());
+
+  auto removed = overlay->loadAndRemoveOverlayDir(kDirInode);
+  ASSERT_TRUE(removed.has_value());
+  EXPECT_EQ(1, removed->entries_ref()->size());
+  EXPECT_FALSE(overlay->hasOverlayData(kDirInode));
+  EXPECT_FALSE(overlay->loadOverlayDir(kDirInode).has_value());
+  overlay->close(std::nullopt);
+}
+
+TEST_F(BufferedTreeOverlayTest, flushWritesToTheStore) {
+  auto overlay = open(1024 * 1024);
+  overlay->saveOverlayDir(kDirInode, makeDir({"a", "b"}));
+  overlay->saveOverlayDir(kSubdirInode, makeDir({"c"}));
+  overlay->flush();
+  EXPECT_EQ(0, overlay->getDirtyBytes());
+  EXPECT_EQ(2, overlay->loadOverlayDir(kDirInode)->entries_ref()->size());
+
+  // Removals are flushed by close().
+  overlay->removeOverlayData(kSubdirInode);
+  overlay->close(std::nullopt);
+  overlay.reset();
+
+  TreeOverlay store{localDir_};
+  store.initOverlay(false);
+  EXPECT_EQ(2, store.loadOverlayDir(kDirInode)->entries_ref()->size());
+  EXPECT_FALSE(store.hasOverlayData(kSubdirInode));
+  store.close(std::nullopt);
+}
+
+TEST_F(BufferedTreeOverlayTest, writersWaitForRoomInTheDirtyTable) {
+  // Every write fills the dirty table, so it returns once flushed.
+  auto overlay = open(1);
+  overlay->saveOverlayDir(kDirInode, makeDir({"a", "b"}));
+  EXPECT_EQ(0, overlay->getDirtyBytes());
+  overlay->saveOverlayDir(kSubdirInode, makeDir({"c"}));
+  EXPECT_EQ(0, overlay->getDirtyBytes());
+  EXPECT_EQ(1, overlay->loadOverlayDir(kSubdirInode)->entries_ref()->size());
+  overlay->close(std::nullopt);
+}
+
+TEST_F(BufferedTreeOverlayTest, flushesOldWrites) {
+  auto overlay = open(1024 * 1024, 1ms);
+  overlay->saveOverlayDir(kDirInode, makeDir({"a"}));
+  for (int i = 0; i < 1000 && overlay->getDirtyBytes() != 0; ++i) {
+    /* sleep override */ std::this_thread::sleep_for(10ms);
+  }
+  EXPECT_EQ(0, overlay->getDirtyBytes());
+  overlay->close(std::nullopt);
+}
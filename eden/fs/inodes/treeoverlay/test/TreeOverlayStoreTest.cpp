@@ -7,10 +7,13 @@
 
 #include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
 
+#include <folly/experimental/TestUtil.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <vector>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/model/Hash.h"
@@ -199,6 +202,30 @@ TEST_F(TreeOverlayStoreTest, testRemoveChild) {
   EXPECT_EQ(entries->begin()->first, "world");
 }
 
+TEST_F(TreeOverlayStoreTest, testBatchedMutations) {
+  auto inode = InodeNumber{overlay_->nextInodeNumber()};
+  overlay::OverlayDir dir;
+  dir.entries_ref()->emplace(std::make_pair("hello", makeEntry()));
+
+  overlay_->beginBatch(2);
+  overlay_->beginBatch(100);
+  overlay_->saveTree(inode, dir);
+  overlay_->addChild(inode, "world"_pc, makeEntry());
+  EXPECT_EQ(overlay_->loadTree(inode).entries_ref()->size(), 2);
+
+  // A failed mutation only rolls back itself, the batch goes on.
+  EXPECT_THROW(overlay_->removeTree(inode), TreeOverlayNonEmptyError);
+  overlay_->removeChild(inode, "hello"_pc);
+  overlay_->endBatch();
+  EXPECT_EQ(overlay_->loadTree(inode).entries_ref()->size(), 1);
+  overlay_->endBatch();
+
+  // Mutations are committed one by one again.
+  overlay_->removeChild(inode, "world"_pc);
+  overlay_->removeTree(inode);
+  EXPECT_EQ(overlay_->loadTree(inode).entries_ref()->size(), 0);
+}
+
 TEST_F(TreeOverlayStoreTest, testRenameChild) {
   auto subdirInode = InodeNumber{overlay_->nextInodeNumber()};
 
@@ -272,4 +299,51 @@ TEST_F(TreeOverlayStoreTest, testRenameChild) {
     expect_entry(it->second, entry);
   }
 }
+
+TEST(TreeOverlayStoreOnDiskTest, readConnectionsSeeCommittedAndBatchedWrites) {
+  folly::test::TemporaryDirectory tmpDir{"eden_tree_overlay_store_"};
+  TreeOverlayStore store{AbsolutePath{tmpDir.path().string()}};
+  store.createTableIfNonExisting();
+  store.loadCounters();
+
+  auto makeDir = [&](folly::StringPiece name) {
+    overlay::OverlayDir dir;
+    overlay::OverlayEntry entry;
+    entry.mode_ref() = dtype_to_mode(dtype_t::Regular);
+    entry.inodeNumber_ref() = store.nextInodeNumber().get();
+    dir.entries_ref()->emplace(name.str(), entry);
+    return dir;
+  };
+
+  auto committed = store.nextInodeNumber();
+  store.saveTree(committed, makeDir("committed"));
+
+  // Readers run concurrently on the read connections.
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 8; ++i) {
+    readers.emplace_back([&] {
+      for (int j = 0; j < 100; ++j) {
+        auto dir = store.loadTree(committed);
+        ASSERT_EQ(1, dir.entries_ref()->size());
+        EXPECT_EQ("committed", dir.entries_ref()->begin()->first);
+        EXPECT_TRUE(store.hasTree(committed));
+      }
+    });
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  // Writes of an uncommitted batch are only visible on the writer
+  // connection, which reads must use until the batch ends.
+  auto batched = store.nextInodeNumber();
+  store.beginBatch(0);
+  store.saveTree(batched, makeDir("batched"));
+  EXPECT_TRUE(store.hasTree(batched));
+  EXPECT_EQ(1, store.loadTree(batched).entries_ref()->size());
+  store.endBatch();
+  EXPECT_EQ(1, store.loadTree(batched).entries_ref()->size());
+
+  store.close();
+}
 } // namespace facebook::eden
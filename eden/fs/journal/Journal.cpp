@@ -6,11 +6,68 @@
  */
 
 #include "Journal.h"
+#include <folly/ScopeGuard.h>
+#include <folly/Varint.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <limits>
+#include <thread>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/utils/MemoryArena.h"
 
 namespace facebook::eden {
 
+namespace {
+
+/**
+ * The first byte of a serialized journal. Bump it when changing the format, so
+ * that journals saved in the old format are ignored.
+ */
+constexpr char kSerializedVersion = '1';
+constexpr char kFileChangeRecord = 'F';
+constexpr char kRootUpdateRecord = 'R';
+
+enum : uint8_t {
+  kPath1Valid = 1 << 0,
+  kPath2Valid = 1 << 1,
+  kPath1ExistedBefore = 1 << 2,
+  kPath1ExistedAfter = 1 << 3,
+  kPath2ExistedBefore = 1 << 4,
+  kPath2ExistedAfter = 1 << 5,
+};
+
+void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buffer[folly::kMaxVarintLength64];
+  out.append(
+      reinterpret_cast<const char*>(buffer),
+      folly::encodeVarint(value, buffer));
+}
+
+void appendBytes(std::string& out, folly::StringPiece bytes) {
+  appendVarint(out, bytes.size());
+  out.append(bytes.data(), bytes.size());
+}
+
+std::optional<uint64_t> readVarint(folly::ByteRange& data) {
+  auto value = folly::tryDecodeVarint(data);
+  if (value.hasError()) {
+    return std::nullopt;
+  }
+  return *value;
+}
+
+std::optional<folly::StringPiece> readBytes(folly::ByteRange& data) {
+  auto length = readVarint(data);
+  if (!length || *length > data.size()) {
+    return std::nullopt;
+  }
+  auto bytes = folly::StringPiece{data.subpiece(0, *length)};
+  data.advance(*length);
+  return bytes;
+}
+
+} // namespace
+
 JournalDeltaPtr Journal::DeltaState::frontPtr() noexcept {
   bool isFileChangeEmpty = fileChangeDeltas.empty();
   bool isHashUpdateEmpty = hashUpdateDeltas.empty();
@@ -98,34 +155,44 @@ void Journal::DeltaState::appendDelta(RootUpdateJournalDelta&& delta) {
 
 Journal::Journal(std::shared_ptr<EdenStats> edenStats)
     : edenStats_{std::move(edenStats)} {
-  // Add 0 so that this counter shows up in ODS
-  edenStats_->getJournalStatsForCurrentThread().truncatedReads.addValue(0);
+  // Add 0 so that these counters show up in ODS
+  auto& stats = edenStats_->getJournalStatsForCurrentThread();
+  stats.truncatedReads.addValue(0);
+  stats.notificationsDropped.addValue(0);
+  stats.trailingNotifications.addValue(0);
 }
 
 void Journal::recordCreated(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CREATED));
+  addDelta(FileChangeJournalDelta(
+      internPath(fileName), FileChangeJournalDelta::CREATED));
 }
 
 void Journal::recordRemoved(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::REMOVED));
+  addDelta(FileChangeJournalDelta(
+      internPath(fileName), FileChangeJournalDelta::REMOVED));
 }
 
 void Journal::recordChanged(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CHANGED));
+  addDelta(FileChangeJournalDelta(
+      internPath(fileName), FileChangeJournalDelta::CHANGED));
 }
 
 void Journal::recordRenamed(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
   addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::RENAMED));
+      internPath(oldName),
+      internPath(newName),
+      FileChangeJournalDelta::RENAMED));
 }
 
 void Journal::recordReplaced(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
   addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::REPLACED));
+      internPath(oldName),
+      internPath(newName),
+      FileChangeJournalDelta::REPLACED));
 }
 
 void Journal::recordHashUpdate(RootId toHash) {
@@ -150,7 +217,10 @@ void Journal::recordUncleanPaths(
   }
   RootUpdateJournalDelta delta;
   delta.fromHash = std::move(fromHash);
-  delta.uncleanPaths = std::move(uncleanPaths);
+  delta.uncleanPaths.reserve(uncleanPaths.size());
+  for (const auto& path : uncleanPaths) {
+    delta.uncleanPaths.push_back(internPath(path));
+  }
   addDelta(std::move(delta), std::move(toHash));
 }
 
@@ -162,7 +232,51 @@ void Journal::truncateIfNecessary(DeltaState& deltaState) {
     deltaState.stats->entryCount--;
 
     deltaState.deltaMemoryUsage -= front.estimateMemoryUsage();
+    if (front->sequenceID > deltaState.lastSummarizedSequence) {
+      --deltaState.unsummarizedCount;
+    }
     deltaState.popFront();
+
+    // Summaries that lost deltas would be wrong.
+    auto& summaries = deltaState.summaries;
+    while (!summaries.empty() &&
+           (deltaState.empty() ||
+            summaries.front()->fromSequence <
+                deltaState.getFrontSequenceID())) {
+      deltaState.summaryMemoryUsage -= summaries.front()->estimateMemoryUsage();
+      summaries.pop_front();
+    }
+  }
+}
+
+void Journal::summarizeIfNecessary(DeltaState& deltaState) {
+  while (deltaState.unsummarizedCount > kDeltasPerSummary) {
+    auto from = deltaState.lastSummarizedSequence + 1;
+    auto isBefore = [](const JournalDelta& delta, SequenceNumber sequence) {
+      return delta.sequenceID < sequence;
+    };
+    auto& fileChanges = deltaState.fileChangeDeltas;
+    auto& hashUpdates = deltaState.hashUpdateDeltas;
+    auto fileChangeIt = std::lower_bound(
+        fileChanges.begin(), fileChanges.end(), from, isBefore);
+    auto hashUpdateIt = std::lower_bound(
+        hashUpdates.begin(), hashUpdates.end(), from, isBefore);
+    SequenceNumber to = from;
+    for (size_t i = 0; i < kDeltasPerSummary; ++i) {
+      bool isFileChange = hashUpdateIt == hashUpdates.end() ||
+          (fileChangeIt != fileChanges.end() &&
+           fileChangeIt->sequenceID < hashUpdateIt->sequenceID);
+      to = isFileChange ? (fileChangeIt++)->sequenceID
+                        : (hashUpdateIt++)->sequenceID;
+    }
+
+    auto summary = std::make_shared<DeltaSummary>();
+    auto merge = [&](const auto& delta) { mergeOlder(*summary, delta); };
+    forEachDeltaBetween(deltaState, from, to, std::nullopt, merge, merge);
+    deltaState.summaryMemoryUsage += summary->estimateMemoryUsage();
+    deltaState.summaries.push_back(std::move(summary));
+    deltaState.lastSummarizedSequence = to;
+    deltaState.unsummarizedCount -= kDeltasPerSummary;
   }
 }
 
@@ -187,6 +301,7 @@ bool Journal::compact(
 template <typename T>
 bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   delta.sequenceID = deltaState.nextSequence++;
+  latestSequence_.store(delta.sequenceID, std::memory_order_relaxed);
   delta.time = std::chrono::steady_clock::now();
 
   truncateIfNecessary(deltaState);
@@ -213,6 +328,8 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
     }
     deltaState.stats->latestTimestamp = delta.time;
     deltaState.appendDelta(std::forward<T>(delta));
+    ++deltaState.unsummarizedCount;
+    summarizeIfNecessary(deltaState);
   }
 
   deltaState.stats->earliestTimestamp = deltaState.frontPtr()->time;
@@ -224,65 +341,206 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
 
 void Journal::notifySubscribers() const {
   auto subscribers = subscriberState_.rlock()->subscribers;
+  auto latest = latestSequence_.load(std::memory_order_relaxed);
   for (auto& sub : subscribers) {
-    sub.second();
+    if (sub.second->isThrottled()) {
+      notifyThrottledSubscriber(sub.second, latest, edenStats_);
+    } else {
+      sub.second->callback();
+    }
   }
 }
 
-void Journal::addDelta(FileChangeJournalDelta&& delta) {
-  bool shouldNotify;
+void Journal::notifyThrottledSubscriber(
+    const std::shared_ptr<Subscriber>& subscriber,
+    SequenceNumber latest,
+    const std::shared_ptr<EdenStats>& edenStats) {
+  auto& options = subscriber->options;
+  auto now = std::chrono::steady_clock::now();
+  std::optional<std::chrono::steady_clock::duration> trailingDelay;
   {
-    auto deltaState = deltaState_.lock();
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    auto throttle = subscriber->throttle.lock();
+    if (throttle->cancelled || latest <= throttle->lastNotifiedSequence) {
+      return;
+    }
+    auto elapsed = now - throttle->lastNotified;
+    bool batchIsFull = options.maxDeltas != 0 &&
+        latest - throttle->lastNotifiedSequence >= options.maxDeltas;
+    if (elapsed < options.minInterval && !batchIsFull) {
+      throttle->pendingSequence = std::max(throttle->pendingSequence, latest);
+      if (!throttle->trailingScheduled) {
+        throttle->trailingScheduled = true;
+        trailingDelay = options.minInterval - elapsed;
+      }
+    } else {
+      throttle->lastNotified = now;
+      throttle->lastNotifiedSequence = latest;
+    }
+  }
+
+  if (!trailingDelay) {
+    subscriber->callback();
+    return;
+  }
+
+  if (edenStats) {
+    edenStats->getJournalStatsForCurrentThread().notificationsDropped.addValue(
+        1);
+  }
+  // The timer keeps the subscriber alive, but not the Journal, which may be
+  // destroyed first.
+  folly::futures::sleep(
+      std::chrono::duration_cast<folly::HighResDuration>(*trailingDelay))
+      .toUnsafeFuture()
+      .thenValue([subscriber, edenStats](folly::Unit) {
+        bool shouldNotify = false;
+        {
+          auto throttle = subscriber->throttle.lock();
+          throttle->trailingScheduled = false;
+          if (!throttle->cancelled &&
+              throttle->pendingSequence > throttle->lastNotifiedSequence) {
+            throttle->lastNotified = std::chrono::steady_clock::now();
+            throttle->lastNotifiedSequence = throttle->pendingSequence;
+            shouldNotify = true;
+          }
+        }
+        if (shouldNotify) {
+          if (edenStats) {
+            edenStats->getJournalStatsForCurrentThread()
+                .trailingNotifications.addValue(1);
+          }
+          subscriber->callback();
+        }
+      });
+}
+
+JournalPath Journal::internPath(RelativePathPiece path) {
+  MemoryArena::Scope arenaScope{MemoryArena::journal()};
+  return pathTable_.intern(path);
+}
+
+bool Journal::mergeStagedDeltas(DeltaState& deltaState) {
+  // A ticket is taken in the same critical section that stages its delta, so
+  // every delta with a ticket below `end` is in its shard by now.
+  auto end = nextTicket_.load(std::memory_order_seq_cst);
+  auto begin = mergedTicket_.load(std::memory_order_relaxed);
+  if (begin == end) {
+    return false;
+  }
+
+  std::vector<StagedDelta> staged;
+  staged.reserve(end - begin);
+  for (auto& shard : stagingShards_) {
+    auto deltas = shard.deltas.lock();
+    auto stagedEnd = std::partition_point(
+        deltas->begin(), deltas->end(), [end](const StagedDelta& delta) {
+          return delta.ticket < end;
+        });
+    staged.insert(
+        staged.end(),
+        std::make_move_iterator(deltas->begin()),
+        std::make_move_iterator(stagedEnd));
+    deltas->erase(deltas->begin(), stagedEnd);
+  }
+  std::sort(
+      staged.begin(),
+      staged.end(),
+      [](const StagedDelta& a, const StagedDelta& b) {
+        return a.ticket < b.ticket;
+      });
+
+  MemoryArena::Scope arenaScope{MemoryArena::journal()};
+  bool shouldNotify = false;
+  for (auto& stagedDelta : staged) {
+    shouldNotify |=
+        addDeltaBeforeNotifying(std::move(stagedDelta.delta), deltaState);
+  }
+  mergedTicket_.store(end, std::memory_order_seq_cst);
+  return shouldNotify;
+}
+
+void Journal::mergeRemainingStagedDeltas(bool shouldNotify) {
+  // A thread that fails to take the lock below staged its delta before
+  // trying, so the holder sees it here once it has let go of the lock.
+  while (mergedTicket_.load(std::memory_order_seq_cst) !=
+         nextTicket_.load(std::memory_order_seq_cst)) {
+    auto deltaState = deltaState_.tryLock();
+    if (!deltaState) {
+      break;
+    }
+    shouldNotify |= mergeStagedDeltas(*deltaState);
   }
   if (shouldNotify) {
     notifySubscribers();
   }
 }
 
+void Journal::addDelta(FileChangeJournalDelta&& delta) {
+  auto shard = std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+      kStagingShardCount;
+  {
+    auto deltas = stagingShards_[shard].deltas.lock();
+    deltas->push_back(StagedDelta{
+        nextTicket_.fetch_add(1, std::memory_order_seq_cst),
+        std::move(delta)});
+  }
+  mergeRemainingStagedDeltas(false);
+}
+
 void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
+    shouldNotify = mergeStagedDeltas(*deltaState);
 
     // If the hashes were not set to anything, default to copying
     // the value from the prior journal entry
     if (delta.fromHash == RootId{}) {
       delta.fromHash = deltaState->currentHash;
     }
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    MemoryArena::Scope arenaScope{MemoryArena::journal()};
+    shouldNotify |= addDeltaBeforeNotifying(std::move(delta), *deltaState);
     deltaState->currentHash = std::move(newRootId);
   }
-  if (shouldNotify) {
-    notifySubscribers();
-  }
+  mergeRemainingStagedDeltas(shouldNotify);
 }
 
 std::optional<JournalDeltaInfo> Journal::getLatest() {
-  auto deltaState = deltaState_.lock();
-  deltaState->lastModificationHasBeenObserved = true;
-  if (deltaState->empty()) {
-    return std::nullopt;
-  } else {
-    if (deltaState->isFileChangeInBack()) {
+  std::optional<JournalDeltaInfo> result;
+  bool shouldNotify;
+  {
+    auto deltaState = deltaState_.lock();
+    shouldNotify = mergeStagedDeltas(*deltaState);
+    deltaState->lastModificationHasBeenObserved = true;
+    if (deltaState->empty()) {
+      result = std::nullopt;
+    } else if (deltaState->isFileChangeInBack()) {
       const FileChangeJournalDelta& back = deltaState->fileChangeDeltas.back();
-      return JournalDeltaInfo{
+      result = JournalDeltaInfo{
           deltaState->currentHash,
           deltaState->currentHash,
           back.sequenceID,
           back.time};
     } else {
       const RootUpdateJournalDelta& back = deltaState->hashUpdateDeltas.back();
-      return JournalDeltaInfo{
+      result = JournalDeltaInfo{
           back.fromHash, deltaState->currentHash, back.sequenceID, back.time};
     }
   }
+  mergeRemainingStagedDeltas(shouldNotify);
+  return result;
 }
 
-uint64_t Journal::registerSubscriber(SubscriberCallback&& callback) {
+uint64_t Journal::registerSubscriber(
+    SubscriberCallback&& callback,
+    SubscriberOptions options) {
+  auto subscriber = std::make_shared<Subscriber>(std::move(callback), options);
+  // Deltas from before the registration do not count towards maxDeltas.
+  subscriber->throttle.lock()->lastNotifiedSequence =
+      latestSequence_.load(std::memory_order_relaxed);
   auto subscriberState = subscriberState_.wlock();
   auto id = subscriberState->nextSubscriberId++;
-  subscriberState->subscribers[id] = std::move(callback);
+  subscriberState->subscribers[id] = std::move(subscriber);
   return id;
 }
 
@@ -293,10 +551,12 @@ void Journal::cancelSubscriber(uint64_t id) {
     return;
   }
   // Extend the lifetime of the value we're removing
-  auto callback = std::move(it->second);
+  auto subscriber = std::move(it->second);
   subscriberState->subscribers.erase(it);
   // release the lock before we trigger the destructor
   subscriberState.unlock();
+  // A pending trailing notification must not call it any more.
+  subscriber->throttle.lock()->cancelled = true;
   // callback can now run its destructor outside the lock
 }
 
@@ -304,8 +564,11 @@ void Journal::cancelAllSubscribers() {
   // Take care: some subscribers will attempt to call cancelSubscriber()
   // as part of their tear down, so we need to make sure that we aren't
   // holding the lock when we trigger that.
-  std::unordered_map<SubscriberId, SubscriberCallback> subscribers;
+  std::unordered_map<SubscriberId, std::shared_ptr<Subscriber>> subscribers;
   subscriberState_.wlock()->subscribers.swap(subscribers);
+  for (auto& sub : subscribers) {
+    sub.second->throttle.lock()->cancelled = true;
+  }
   subscribers.clear();
 }
 
@@ -316,7 +579,15 @@ bool Journal::isSubscriberValid(uint64_t id) const {
 }
 
 std::optional<JournalStats> Journal::getStats() {
-  return deltaState_.lock()->stats;
+  std::optional<JournalStats> stats;
+  bool shouldNotify;
+  {
+    auto deltaState = deltaState_.lock();
+    shouldNotify = mergeStagedDeltas(*deltaState);
+    stats = deltaState->stats;
+  }
+  mergeRemainingStagedDeltas(shouldNotify);
+  return stats;
 }
 
 namespace {
@@ -366,6 +637,9 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
   }
+  memoryUsage += deltaState.summaryMemoryUsage;
+  // This includes the paths of staged deltas, which are about to be merged.
+  memoryUsage += pathTable_.estimateMemoryUsage();
   return memoryUsage;
 }
 
@@ -373,11 +647,17 @@ void Journal::flush() {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
+    // Changes recorded before the flush are flushed too.
+    shouldNotify = mergeStagedDeltas(*deltaState);
     ++deltaState->nextSequence;
     auto lastHash = deltaState->currentHash;
     deltaState->fileChangeDeltas.clear();
     deltaState->hashUpdateDeltas.clear();
     deltaState->stats = std::nullopt;
+    deltaState->summaries.clear();
+    deltaState->lastSummarizedSequence = deltaState->nextSequence - 1;
+    deltaState->unsummarizedCount = 0;
+    deltaState->summaryMemoryUsage = 0;
     auto delta = RootUpdateJournalDelta();
     /* Tracking the hash correctly when the journal is flushed is important
      * since Watchman uses the hash to correctly determine what additional files
@@ -387,100 +667,410 @@ void Journal::flush() {
      * flush operation.
      */
     delta.fromHash = lastHash;
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
-  }
-  if (shouldNotify) {
-    notifySubscribers();
+    shouldNotify |= addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
+  mergeRemainingStagedDeltas(shouldNotify);
 }
 
-std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
-    SequenceNumber from) {
-  XDCHECK(from > 0);
-  std::unique_ptr<JournalDeltaRange> result = nullptr;
+std::string Journal::serialize(size_t sizeLimit) {
+  // Most recent first.
+  std::vector<std::string> records;
+  std::string header;
+  size_t size = 0;
+  bool shouldNotify;
+  {
+    auto deltaState = deltaState_.lock();
+    shouldNotify = mergeStagedDeltas(*deltaState);
 
-  size_t filesAccumulated = 0;
-  auto deltaState = deltaState_.lock();
-  // If this is going to be truncated, handle it before iterating.
-  if (!deltaState->empty() && deltaState->getFrontSequenceID() > from) {
-    result = std::make_unique<JournalDeltaRange>();
-    result->isTruncated = true;
-  } else {
+    header.push_back(kSerializedVersion);
+    appendVarint(header, deltaState->nextSequence);
+    appendBytes(header, deltaState->currentHash.value());
+
+    auto add = [&](std::string record) {
+      size += record.size();
+      records.push_back(std::move(record));
+    };
     forEachDelta(
         *deltaState,
-        from,
+        1,
         std::nullopt,
-        [&](const FileChangeJournalDelta& current) -> void {
-          ++filesAccumulated;
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
+        [&](const FileChangeJournalDelta& current) {
+          if (size > sizeLimit) {
+            return;
+          }
+          std::string record;
+          record.push_back(kFileChangeRecord);
+          appendVarint(record, current.sequenceID);
+          uint8_t flags = (current.isPath1Valid ? kPath1Valid : 0) |
+              (current.isPath2Valid ? kPath2Valid : 0) |
+              (current.info1.existedBefore ? kPath1ExistedBefore : 0) |
+              (current.info1.existedAfter ? kPath1ExistedAfter : 0) |
+              (current.info2.existedBefore ? kPath2ExistedBefore : 0) |
+              (current.info2.existedAfter ? kPath2ExistedAfter : 0);
+          record.push_back(static_cast<char>(flags));
+          if (current.isPath1Valid) {
+            appendBytes(record, current.path1.piece().stringPiece());
           }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-
-          for (auto& entry : current.getChangedFilesInOverlay()) {
-            auto& name = entry.first;
-            auto& currentInfo = entry.second;
-            auto* resultInfo =
-                folly::get_ptr(result->changedFilesInOverlay, name);
-            if (!resultInfo) {
-              result->changedFilesInOverlay.emplace(name, currentInfo);
-            } else {
-              if (resultInfo->existedBefore != currentInfo.existedAfter) {
-                auto event1 = eventCharacterizationFor(currentInfo);
-                auto event2 = eventCharacterizationFor(*resultInfo);
-                XLOG(ERR) << "Journal for " << name << " holds invalid "
-                          << event1 << ", " << event2 << " sequence";
-              }
-
-              resultInfo->existedBefore = currentInfo.existedBefore;
-            }
+          if (current.isPath2Valid) {
+            appendBytes(record, current.path2.piece().stringPiece());
           }
+          add(std::move(record));
         },
-        [&](const RootUpdateJournalDelta& current) -> void {
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
+        [&](const RootUpdateJournalDelta& current) {
+          if (size > sizeLimit) {
+            return;
+          }
+          std::string record;
+          record.push_back(kRootUpdateRecord);
+          appendVarint(record, current.sequenceID);
+          appendBytes(record, current.fromHash.value());
+          appendVarint(record, current.uncleanPaths.size());
+          for (const auto& path : current.uncleanPaths) {
+            appendBytes(record, path.piece().stringPiece());
           }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-          result->snapshotTransitions.push_back(current.fromHash);
-
-          // Merge the unclean status list
-          result->uncleanPaths.insert(
-              current.uncleanPaths.begin(), current.uncleanPaths.end());
+          add(std::move(record));
         });
   }
+  mergeRemainingStagedDeltas(shouldNotify);
+
+  std::string out = std::move(header);
+  out.reserve(out.size() + size);
+  for (auto it = records.rbegin(); it != records.rend(); ++it) {
+    out.append(*it);
+  }
+  return out;
+}
+
+bool Journal::restore(folly::StringPiece data) {
+  if (data.empty() || data.front() != kSerializedVersion) {
+    return false;
+  }
+  auto bytes = folly::ByteRange{data};
+  bytes.advance(1);
+
+  auto nextSequence = readVarint(bytes);
+  auto currentHash = readBytes(bytes);
+  if (!nextSequence || !currentHash) {
+    return false;
+  }
+
+  std::vector<FileChangeJournalDelta> fileChanges;
+  std::vector<RootUpdateJournalDelta> rootUpdates;
+  SequenceNumber lastSequence = 0;
+  auto readPath = [&](JournalPath& path) {
+    auto name = readBytes(bytes);
+    if (!name) {
+      return false;
+    }
+    path = internPath(RelativePathPiece{*name});
+    return true;
+  };
+  try {
+    while (!bytes.empty()) {
+      auto type = static_cast<char>(bytes.front());
+      bytes.advance(1);
+      auto sequence = readVarint(bytes);
+      if (!sequence || *sequence <= lastSequence ||
+          *sequence >= *nextSequence) {
+        return false;
+      }
+      lastSequence = *sequence;
 
-  if (result) {
-    if (edenStats_) {
-      if (result->isTruncated) {
-        edenStats_->getJournalStatsForCurrentThread().truncatedReads.addValue(
-            1);
+      if (type == kFileChangeRecord) {
+        if (bytes.empty()) {
+          return false;
+        }
+        auto flags = bytes.front();
+        bytes.advance(1);
+        FileChangeJournalDelta delta;
+        delta.sequenceID = *sequence;
+        delta.isPath1Valid = flags & kPath1Valid;
+        delta.isPath2Valid = flags & kPath2Valid;
+        delta.info1 = PathChangeInfo{
+            bool(flags & kPath1ExistedBefore),
+            bool(flags & kPath1ExistedAfter)};
+        delta.info2 = PathChangeInfo{
+            bool(flags & kPath2ExistedBefore),
+            bool(flags & kPath2ExistedAfter)};
+        if ((delta.isPath1Valid && !readPath(delta.path1)) ||
+            (delta.isPath2Valid && !readPath(delta.path2))) {
+          return false;
+        }
+        fileChanges.push_back(std::move(delta));
+      } else if (type == kRootUpdateRecord) {
+        RootUpdateJournalDelta delta;
+        delta.sequenceID = *sequence;
+        auto fromHash = readBytes(bytes);
+        auto count = readVarint(bytes);
+        if (!fromHash || !count || *count > bytes.size()) {
+          return false;
+        }
+        delta.fromHash = RootId{fromHash->str()};
+        delta.uncleanPaths.resize(*count);
+        for (auto& path : delta.uncleanPaths) {
+          if (!readPath(path)) {
+            return false;
+          }
+        }
+        rootUpdates.push_back(std::move(delta));
+      } else {
+        return false;
       }
-      edenStats_->getJournalStatsForCurrentThread().filesAccumulated.addValue(
-          filesAccumulated);
     }
-    if (deltaState->stats) {
-      deltaState->stats->maxFilesAccumulated =
-          std::max(deltaState->stats->maxFilesAccumulated, filesAccumulated);
+  } catch (const std::exception& ex) {
+    // RelativePathPiece throws on malformed paths.
+    XLOG(WARN) << "corrupt serialized journal: " << folly::exceptionStr(ex);
+    return false;
+  }
+
+  auto deltaState = deltaState_.lock();
+  XCHECK(deltaState->empty()) << "only an empty journal can be restored";
+  auto now = std::chrono::steady_clock::now();
+  deltaState->nextSequence = *nextSequence;
+  latestSequence_.store(*nextSequence - 1, std::memory_order_relaxed);
+  deltaState->currentHash = RootId{currentHash->str()};
+  for (auto& delta : fileChanges) {
+    delta.time = now;
+    deltaState->deltaMemoryUsage += delta.estimateMemoryUsage();
+    deltaState->appendDelta(std::move(delta));
+  }
+  for (auto& delta : rootUpdates) {
+    delta.time = now;
+    deltaState->deltaMemoryUsage += delta.estimateMemoryUsage();
+    deltaState->appendDelta(std::move(delta));
+  }
+  if (!deltaState->empty()) {
+    deltaState->stats = JournalStats();
+    deltaState->stats->entryCount = fileChanges.size() + rootUpdates.size();
+    deltaState->stats->earliestTimestamp = now;
+    deltaState->stats->latestTimestamp = now;
+  }
+  deltaState->unsummarizedCount = fileChanges.size() + rootUpdates.size();
+  summarizeIfNecessary(*deltaState);
+  truncateIfNecessary(*deltaState);
+  return true;
+}
+
+size_t Journal::DeltaSummary::estimateMemoryUsage() const {
+  size_t memoryUsage = sizeof(DeltaSummary) +
+      changedFiles.getAllocatedMemorySize() +
+      folly::goodMallocSize(fromHashes.capacity() * sizeof(RootId)) +
+      folly::goodMallocSize(uncleanPaths.capacity() * sizeof(JournalPath));
+  for (const auto& hash : fromHashes) {
+    memoryUsage += estimateIndirectMemoryUsage(hash.value());
+  }
+  return memoryUsage;
+}
+
+void Journal::DeltaSummary::addOlder(
+    SequenceNumber from,
+    std::chrono::steady_clock::time_point fromTimestamp,
+    SequenceNumber to,
+    std::chrono::steady_clock::time_point toTimestamp) {
+  if (empty()) {
+    toSequence = to;
+    toTime = toTimestamp;
+  }
+  fromSequence = from;
+  fromTime = fromTimestamp;
+}
+
+namespace {
+void mergeOlderPath(
+    folly::F14FastMap<JournalPath, PathChangeInfo>& changedFiles,
+    const JournalPath& path,
+    const PathChangeInfo& older) {
+  auto [it, inserted] = changedFiles.try_emplace(path, older);
+  if (!inserted) {
+    auto& newer = it->second;
+    if (newer.existedBefore != older.existedAfter) {
+      auto event1 = eventCharacterizationFor(older);
+      auto event2 = eventCharacterizationFor(newer);
+      XLOG(ERR) << "Journal for " << path.piece() << " holds invalid "
+                << event1 << ", " << event2 << " sequence";
+    }
+    newer.existedBefore = older.existedBefore;
+  }
+}
+} // namespace
+
+void Journal::mergeOlder(
+    DeltaSummary& summary,
+    const FileChangeJournalDelta& delta) {
+  summary.addOlder(delta.sequenceID, delta.time, delta.sequenceID, delta.time);
+  ++summary.fileChangeCount;
+  // When both paths are the same, the second one wins, as in
+  // getChangedFilesInOverlay().
+  if (delta.isPath1Valid &&
+      !(delta.isPath2Valid && delta.path1 == delta.path2)) {
+    mergeOlderPath(summary.changedFiles, delta.path1, delta.info1);
+  }
+  if (delta.isPath2Valid) {
+    mergeOlderPath(summary.changedFiles, delta.path2, delta.info2);
+  }
+}
+
+void Journal::mergeOlder(
+    DeltaSummary& summary,
+    const RootUpdateJournalDelta& delta) {
+  summary.addOlder(delta.sequenceID, delta.time, delta.sequenceID, delta.time);
+  summary.fromHashes.push_back(delta.fromHash);
+  summary.uncleanPaths.insert(
+      summary.uncleanPaths.end(),
+      delta.uncleanPaths.begin(),
+      delta.uncleanPaths.end());
+}
+
+void Journal::mergeOlder(DeltaSummary& summary, const DeltaSummary& older) {
+  if (older.empty()) {
+    return;
+  }
+  summary.addOlder(
+      older.fromSequence, older.fromTime, older.toSequence, older.toTime);
+  summary.fileChangeCount += older.fileChangeCount;
+  for (const auto& [path, info] : older.changedFiles) {
+    mergeOlderPath(summary.changedFiles, path, info);
+  }
+  summary.fromHashes.insert(
+      summary.fromHashes.end(),
+      older.fromHashes.begin(),
+      older.fromHashes.end());
+  summary.uncleanPaths.insert(
+      summary.uncleanPaths.end(),
+      older.uncleanPaths.begin(),
+      older.uncleanPaths.end());
+}
+
+std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
+    SequenceNumber from) {
+  XDCHECK(from > 0);
+
+  // Only deltas that are not summarized, at most about 2 * kDeltasPerSummary
+  // of them, are merged while holding the lock: the ones before the first
+  // summary in range go into `head`, and the ones after the last summary into
+  // `result`. The summaries themselves are merged after releasing it.
+  DeltaSummary summed;
+  DeltaSummary head;
+  std::vector<std::shared_ptr<const DeltaSummary>> summaries;
+  RootId currentHash;
+  bool isTruncated = false;
+  bool shouldNotify;
+  {
+    auto deltaState = deltaState_.lock();
+    shouldNotify = mergeStagedDeltas(*deltaState);
+    deltaState->lastModificationHasBeenObserved = true;
+
+    // If this is going to be truncated, handle it before iterating.
+    if (!deltaState->empty() && deltaState->getFrontSequenceID() > from) {
+      isTruncated = true;
+    } else {
+      auto mergeIntoSummed = [&](const auto& delta) {
+        mergeOlder(summed, delta);
+      };
+      auto& all = deltaState->summaries;
+      auto first = std::lower_bound(
+          all.begin(),
+          all.end(),
+          from,
+          [](const std::shared_ptr<const DeltaSummary>& summary,
+             SequenceNumber sequence) {
+            return summary->fromSequence < sequence;
+          });
+      if (first == all.end()) {
+        forEachDelta(
+            *deltaState, from, std::nullopt, mergeIntoSummed, mergeIntoSummed);
+      } else {
+        forEachDelta(
+            *deltaState,
+            deltaState->lastSummarizedSequence + 1,
+            std::nullopt,
+            mergeIntoSummed,
+            mergeIntoSummed);
+        // Most recent first.
+        summaries.assign(
+            std::make_reverse_iterator(all.end()),
+            std::make_reverse_iterator(first));
+        auto mergeIntoHead = [&](const auto& delta) {
+          mergeOlder(head, delta);
+        };
+        forEachDeltaBetween(
+            *deltaState,
+            from,
+            (*first)->fromSequence - 1,
+            std::nullopt,
+            mergeIntoHead,
+            mergeIntoHead);
+      }
+      currentHash = deltaState->currentHash;
+
+      size_t filesAccumulated = summed.fileChangeCount + head.fileChangeCount;
+      for (const auto& summary : summaries) {
+        filesAccumulated += summary->fileChangeCount;
+      }
+      if (deltaState->stats && (!summed.empty() || !summaries.empty())) {
+        deltaState->stats->maxFilesAccumulated =
+            std::max(deltaState->stats->maxFilesAccumulated, filesAccumulated);
+      }
     }
+  }
+  mergeRemainingStagedDeltas(shouldNotify);
 
+  for (const auto& summary : summaries) {
+    mergeOlder(summed, *summary);
+  }
+  mergeOlder(summed, head);
+
+  std::unique_ptr<JournalDeltaRange> result = nullptr;
+  if (isTruncated) {
+    result = std::make_unique<JournalDeltaRange>();
+    result->isTruncated = true;
+  } else if (!summed.empty()) {
+    result = std::make_unique<JournalDeltaRange>();
+    result->fromSequence = summed.fromSequence;
+    result->toSequence = summed.toSequence;
+    result->fromTime = summed.fromTime;
+    result->toTime = summed.toTime;
+    result->snapshotTransitions.push_back(std::move(currentHash));
+    result->snapshotTransitions.insert(
+        result->snapshotTransitions.end(),
+        summed.fromHashes.begin(),
+        summed.fromHashes.end());
     std::reverse(
         result->snapshotTransitions.begin(), result->snapshotTransitions.end());
+    result->changedFilesInOverlay.reserve(summed.changedFiles.size());
+    for (const auto& [path, info] : summed.changedFiles) {
+      result->changedFilesInOverlay.emplace(path.piece().copy(), info);
+    }
+    for (const auto& path : summed.uncleanPaths) {
+      result->uncleanPaths.insert(path.piece().copy());
+    }
   }
 
-  deltaState->lastModificationHasBeenObserved = true;
+  if (result && edenStats_) {
+    if (result->isTruncated) {
+      edenStats_->getJournalStatsForCurrentThread().truncatedReads.addValue(1);
+    }
+    edenStats_->getJournalStatsForCurrentThread().filesAccumulated.addValue(
+        summed.fileChangeCount);
+  }
   return result;
 }
 
+std::vector<RootId> Journal::getRecentRoots(size_t limit) {
+  std::vector<RootId> roots;
+  if (limit == 0) {
+    return roots;
+  }
+  auto deltaState = deltaState_.lock();
+  roots.push_back(deltaState->currentHash);
+  for (auto it = deltaState->hashUpdateDeltas.rbegin();
+       it != deltaState->hashUpdateDeltas.rend() && roots.size() < limit;
+       ++it) {
+    roots.push_back(it->fromHash);
+  }
+  return roots;
+}
+
 std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
     SequenceNumber from,
     std::optional<size_t> limit,
@@ -537,7 +1127,7 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
         currentHash = current.fromHash;
 
         for (auto& path : current.uncleanPaths) {
-          delta.uncleanPaths_ref()->emplace(path.stringPiece().str());
+          delta.uncleanPaths_ref()->emplace(path.piece().stringPiece().str());
         }
 
         result.push_back(delta);
@@ -556,9 +1146,38 @@ void Journal::forEachDelta(
     std::optional<size_t> lengthLimit,
     FileChangeFunc&& fileChangeDeltaCallback,
     HashUpdateFunc&& hashUpdateDeltaCallback) const {
+  forEachDeltaBetween(
+      deltaState,
+      from,
+      std::numeric_limits<JournalDelta::SequenceNumber>::max(),
+      lengthLimit,
+      std::forward<FileChangeFunc>(fileChangeDeltaCallback),
+      std::forward<HashUpdateFunc>(hashUpdateDeltaCallback));
+}
+
+template <class FileChangeFunc, class HashUpdateFunc>
+void Journal::forEachDeltaBetween(
+    const DeltaState& deltaState,
+    JournalDelta::SequenceNumber from,
+    JournalDelta::SequenceNumber to,
+    std::optional<size_t> lengthLimit,
+    FileChangeFunc&& fileChangeDeltaCallback,
+    HashUpdateFunc&& hashUpdateDeltaCallback) const {
+  auto isAfter = [](JournalDelta::SequenceNumber sequence,
+                    const JournalDelta& delta) {
+    return sequence < delta.sequenceID;
+  };
   size_t iters = 0;
-  auto fileChangeIt = deltaState.fileChangeDeltas.rbegin();
-  auto hashUpdateIt = deltaState.hashUpdateDeltas.rbegin();
+  auto fileChangeIt = std::make_reverse_iterator(std::upper_bound(
+      deltaState.fileChangeDeltas.begin(),
+      deltaState.fileChangeDeltas.end(),
+      to,
+      isAfter));
+  auto hashUpdateIt = std::make_reverse_iterator(std::upper_bound(
+      deltaState.hashUpdateDeltas.begin(),
+      deltaState.hashUpdateDeltas.end(),
+      to,
+      isAfter));
   auto fileChangeRend = deltaState.fileChangeDeltas.rend();
   auto hashUpdateRend = deltaState.hashUpdateDeltas.rend();
   while (fileChangeIt != fileChangeRend || hashUpdateIt != hashUpdateRend) {
@@ -9,12 +9,18 @@
 
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <unordered_map>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/journal/JournalPathTable.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -55,7 +61,8 @@ struct JournalDeltaInfo {
  * the larger list of files.
  *
  * The Journal class is thread-safe.  Subscribers are called on the thread
- * that called addDelta.
+ * that called addDelta, or on the thread that merged its delta into the
+ * journal on its behalf.
  */
 class Journal {
  public:
@@ -63,6 +70,24 @@ class Journal {
   using SubscriberId = uint64_t;
   using SubscriberCallback = std::function<void()>;
 
+  /**
+   * Limits how often a subscriber is notified. With the defaults, it is
+   * notified of every change that was observed since the last notification.
+   */
+  struct SubscriberOptions {
+    /**
+     * The minimum time between two notifications. A notification that would
+     * come sooner is dropped, and one trailing notification is sent at the
+     * end of the interval instead.
+     */
+    std::chrono::steady_clock::duration minInterval{0};
+    /**
+     * If nonzero, a notification is sent before the end of minInterval once
+     * this many deltas were added since the last one.
+     */
+    SequenceNumber maxDeltas{0};
+  };
+
   explicit Journal(std::shared_ptr<EdenStats> edenStats);
 
   Journal(const Journal&) = delete;
@@ -124,6 +149,13 @@ class Journal {
   std::unique_ptr<JournalDeltaRange> accumulateRange(
       SequenceNumber limitSequence = 1);
 
+  /**
+   * Returns the current root followed by up to `limit - 1` roots it was
+   * previously checked out at, most recent first, as far back as the journal
+   * remembers. Roots may repeat.
+   */
+  std::vector<RootId> getRecentRoots(size_t limit);
+
   // Subscription functionality:
 
   /**
@@ -139,10 +171,16 @@ class Journal {
    * modifications between subscriber notifications and calls to getLatest or
    * accumulateRange.
    *
+   * `options` can further limit how often this subscriber is notified. A
+   * trailing notification sent at the end of an interval is called on a timer
+   * thread.
+   *
    * The return value of registerSubscriber is an identifier than can be passed
    * to cancelSubscriber to later remove the registration.
    */
-  SubscriberId registerSubscriber(SubscriberCallback&& callback);
+  SubscriberId registerSubscriber(
+      SubscriberCallback&& callback,
+      SubscriberOptions options = {});
   void cancelSubscriber(SubscriberId id);
 
   void cancelAllSubscribers();
@@ -160,6 +198,8 @@ class Journal {
    * done by the latest 'limit' deltas, if the
    * beginning of the journal is reached before 'limit' number of deltas are
    * reached then it will just return what had been currently found.
+   *
+   * File changes that are still being recorded concurrently may be missing.
    * */
   std::vector<DebugJournalDelta> getDebugRawJournalInfo(
       SequenceNumber from,
@@ -178,6 +218,25 @@ class Journal {
 
   size_t estimateMemoryUsage() const;
 
+  // Persistence across restarts:
+
+  /**
+   * Serializes the most recent deltas, up to about `sizeLimit` bytes of them,
+   * so that a later EdenFS process can restore() them and honor the sequence
+   * numbers handed out by this one.
+   */
+  std::string serialize(size_t sizeLimit);
+
+  /**
+   * Restores the deltas saved by serialize() into this journal, which must be
+   * empty. Positions from before the oldest saved delta are reported as
+   * truncated. The times of the restored deltas are the time of the restore,
+   * since steady_clock times do not carry over to another process.
+   *
+   * Returns false, leaving the journal unchanged, if `data` can not be parsed.
+   */
+  bool restore(folly::StringPiece data);
+
  private:
   /** Add a delta to the journal and notify subscribers.
    * The delta will have a new sequence number and timestamp
@@ -188,6 +247,60 @@ class Journal {
 
   static constexpr size_t kDefaultJournalMemoryLimit = 1000000000;
 
+  /**
+   * The number of consecutive deltas merged into each DeltaSummary. A range
+   * query merges, under the lock, at most about twice this many deltas.
+   */
+  static constexpr size_t kDeltasPerSummary = 1024;
+
+  /**
+   * The paths of all deltas, including staged ones. Declared first so that it
+   * outlives them.
+   */
+  JournalPathTable pathTable_;
+
+  /**
+   * The changes made by a run of consecutive deltas, merged the way
+   * accumulateRange() merges them.
+   */
+  struct DeltaSummary {
+    bool empty() const {
+      return fromSequence == 0;
+    }
+
+    size_t estimateMemoryUsage() const;
+
+    /** Extends the summarized range back to cover from..to. */
+    void addOlder(
+        SequenceNumber from,
+        std::chrono::steady_clock::time_point fromTimestamp,
+        SequenceNumber to,
+        std::chrono::steady_clock::time_point toTimestamp);
+
+    SequenceNumber fromSequence{0};
+    SequenceNumber toSequence{0};
+    std::chrono::steady_clock::time_point fromTime;
+    std::chrono::steady_clock::time_point toTime;
+    folly::F14FastMap<JournalPath, PathChangeInfo> changedFiles;
+    /// The root each root update started from, most recent first.
+    std::vector<RootId> fromHashes;
+    /// May repeat.
+    std::vector<JournalPath> uncleanPaths;
+    size_t fileChangeCount{0};
+  };
+
+  /**
+   * Merge deltas or summaries that are older than everything merged into
+   * `summary` so far.
+   */
+  static void mergeOlder(
+      DeltaSummary& summary,
+      const FileChangeJournalDelta& delta);
+  static void mergeOlder(
+      DeltaSummary& summary,
+      const RootUpdateJournalDelta& delta);
+  static void mergeOlder(DeltaSummary& summary, const DeltaSummary& older);
+
   struct DeltaState {
     /**
      * The sequence number that we'll use for the next entry that we link into
@@ -206,6 +319,17 @@ class Journal {
     size_t memoryLimit = kDefaultJournalMemoryLimit;
     size_t deltaMemoryUsage = 0;
 
+    /**
+     * Summaries of the deltas up to lastSummarizedSequence, oldest first, each
+     * of kDeltasPerSummary deltas. Summaries are immutable so that range
+     * queries can merge them without holding the lock. The most recent delta
+     * is never summarized, since compaction may still replace it.
+     */
+    std::deque<std::shared_ptr<const DeltaSummary>> summaries;
+    SequenceNumber lastSummarizedSequence = 0;
+    size_t unsummarizedCount = 0;
+    size_t summaryMemoryUsage = 0;
+
     // Set to false when a delta is added.
     // Set to true when getLatest() or accumulateRange() are called.
     // If true before calling addDelta, subscribers are notified.
@@ -235,12 +359,68 @@ class Journal {
   };
   folly::Synchronized<DeltaState, std::mutex> deltaState_;
 
+  /**
+   * File changes are recorded by many filesystem threads at once. Rather than
+   * wait for deltaState_, each of them stages its delta in the shard of its
+   * thread, and whichever thread holds deltaState_ merges all staged deltas
+   * in the order they were staged. That thread assigns their sequence
+   * numbers and compacts them, so that this work happens in batches.
+   */
+  struct StagedDelta {
+    uint64_t ticket;
+    FileChangeJournalDelta delta;
+  };
+  struct alignas(folly::hardware_destructive_interference_size) StagingShard {
+    // Sorted by ticket.
+    folly::Synchronized<std::vector<StagedDelta>, std::mutex> deltas;
+  };
+  static constexpr size_t kStagingShardCount = 16;
+  std::array<StagingShard, kStagingShardCount> stagingShards_;
+  /**
+   * The ticket of the next staged delta. It is taken while holding the lock of
+   * the shard the delta is staged in.
+   */
+  std::atomic<uint64_t> nextTicket_{0};
+  /**
+   * All deltas with a lower ticket have been merged. Only written while
+   * holding deltaState_.
+   */
+  std::atomic<uint64_t> mergedTicket_{0};
+
+  /**
+   * Merges the deltas staged before this call into deltaState, whose lock
+   * must be held. Readers call this first, so that they see every change that
+   * was recorded before they were called.
+   *
+   * Returns true if subscribers should be notified.
+   */
+  [[nodiscard]] bool mergeStagedDeltas(DeltaState& deltaState);
+
+  /**
+   * Intern `path` into pathTable_, allocating from MemoryArena::journal().
+   */
+  JournalPath internPath(RelativePathPiece path);
+
+  /**
+   * Must be called after releasing deltaState_ by anything that merged or
+   * staged deltas. Merges the deltas that were staged while the lock was
+   * held, unless some other thread now holds it and will therefore merge
+   * them, then notifies subscribers if any merge asked for it.
+   */
+  void mergeRemainingStagedDeltas(bool shouldNotify);
+
   /**
    * Removes the oldest deltas until the memory usage of the journal is below
    * the journal's memory limit.
    */
   void truncateIfNecessary(DeltaState& deltaState);
 
+  /**
+   * Summarizes the oldest unsummarized deltas while more than
+   * kDeltasPerSummary of them are left.
+   */
+  void summarizeIfNecessary(DeltaState& deltaState);
+
   /**
    * Tries to compact a new Journal Delta with an old one if possible,
    * returning true if it did compact it and false if not
@@ -248,9 +428,31 @@ class Journal {
   bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
   bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState);
 
+  struct Subscriber {
+    Subscriber(SubscriberCallback&& callback, SubscriberOptions options)
+        : callback{std::move(callback)}, options{options} {}
+
+    bool isThrottled() const {
+      return options.minInterval.count() > 0;
+    }
+
+    SubscriberCallback callback;
+    const SubscriberOptions options;
+
+    struct Throttle {
+      std::chrono::steady_clock::time_point lastNotified;
+      SequenceNumber lastNotifiedSequence{0};
+      /// The latest delta a dropped notification was about.
+      SequenceNumber pendingSequence{0};
+      bool trailingScheduled{false};
+      bool cancelled{false};
+    };
+    folly::Synchronized<Throttle, std::mutex> throttle;
+  };
+
   struct SubscriberState {
     SubscriberId nextSubscriberId{1};
-    std::unordered_map<SubscriberId, SubscriberCallback> subscribers;
+    std::unordered_map<SubscriberId, std::shared_ptr<Subscriber>> subscribers;
   };
 
   /**
@@ -270,6 +472,22 @@ class Journal {
    */
   void notifySubscribers() const;
 
+  /**
+   * Notifies a throttled subscriber of the deltas up to `latest`, or drops
+   * the notification and makes sure a trailing one is scheduled.
+   */
+  static void notifyThrottledSubscriber(
+      const std::shared_ptr<Subscriber>& subscriber,
+      SequenceNumber latest,
+      const std::shared_ptr<EdenStats>& edenStats);
+
+  /**
+   * The sequence number of the latest delta. Written while holding
+   * deltaState_, so that subscribers can be told how far the journal got
+   * without taking it.
+   */
+  std::atomic<SequenceNumber> latestSequence_{0};
+
   size_t estimateMemoryUsage(const DeltaState& deltaState) const;
 
   /**
@@ -285,6 +503,19 @@ class Journal {
       FileChangeFunc&& fileChangeDeltaCallback,
       HashUpdateFunc&& hashUpdateDeltaCallback) const;
 
+  /**
+   * Like forEachDelta, but starts from the delta with sequence ID 'to' or the
+   * latest one before it.
+   */
+  template <class FileChangeFunc, class HashUpdateFunc>
+  void forEachDeltaBetween(
+      const DeltaState& deltaState,
+      JournalDelta::SequenceNumber from,
+      JournalDelta::SequenceNumber to,
+      std::optional<size_t> lengthLimit,
+      FileChangeFunc&& fileChangeDeltaCallback,
+      HashUpdateFunc&& hashUpdateDeltaCallback) const;
+
   folly::Synchronized<SubscriberState> subscriberState_;
 
   std::shared_ptr<EdenStats> edenStats_;
@@ -11,6 +11,8 @@
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
+#include <vector>
+#include "eden/fs/journal/JournalPathTable.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -75,30 +77,24 @@ class FileChangeJournalDelta : public JournalDelta {
   FileChangeJournalDelta& operator=(FileChangeJournalDelta&&) = default;
   FileChangeJournalDelta(const FileChangeJournalDelta&) = delete;
   FileChangeJournalDelta& operator=(const FileChangeJournalDelta&) = delete;
-  FileChangeJournalDelta(RelativePathPiece fileName, Created);
-  FileChangeJournalDelta(RelativePathPiece fileName, Removed);
-  FileChangeJournalDelta(RelativePathPiece fileName, Changed);
+  FileChangeJournalDelta(JournalPath fileName, Created);
+  FileChangeJournalDelta(JournalPath fileName, Removed);
+  FileChangeJournalDelta(JournalPath fileName, Changed);
 
   /**
    * "Renamed" means that that newName was created as a result of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Renamed);
+  FileChangeJournalDelta(JournalPath oldName, JournalPath newName, Renamed);
 
   /**
    * "Replaced" means that that newName was overwritten by oldName as a result
    * of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Replaced);
+  FileChangeJournalDelta(JournalPath oldName, JournalPath newName, Replaced);
 
   /** Which of these paths actually contain information */
-  RelativePath path1;
-  RelativePath path2;
+  JournalPath path1;
+  JournalPath path2;
   PathChangeInfo info1;
   PathChangeInfo info2;
   bool isPath1Valid = false;
@@ -114,7 +110,10 @@ class FileChangeJournalDelta : public JournalDelta {
    * sequenceID [whether they do the same action] */
   bool isSameAction(const FileChangeJournalDelta& other) const;
 
-  /** Get memory used (in bytes) by this Delta */
+  /**
+   * Get memory used (in bytes) by this Delta. The paths are accounted for by
+   * their JournalPathTable.
+   */
   size_t estimateMemoryUsage() const;
 };
 
@@ -135,10 +134,13 @@ class RootUpdateJournalDelta : public JournalDelta {
   RootId fromHash;
 
   /** The set of files that had differing status across a checkout or
-   * some other operation that changes the snapshot hash */
-  std::unordered_set<RelativePath> uncleanPaths;
+   * some other operation that changes the snapshot hash. Unique. */
+  std::vector<JournalPath> uncleanPaths;
 
-  /** Get memory used (in bytes) by this Delta */
+  /**
+   * Get memory used (in bytes) by this Delta. The paths are accounted for by
+   * their JournalPathTable.
+   */
   size_t estimateMemoryUsage() const;
 };
 
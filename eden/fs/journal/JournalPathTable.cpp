@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/memory/Malloc.h>
+
+namespace facebook::eden {
+
+struct JournalPath::Node {
+  Node(JournalPathTable& table, size_t shard, RelativePathPiece path)
+      : table{table}, shard{shard}, path{path.copy()} {}
+
+  size_t estimateMemoryUsage() const {
+    return folly::goodMallocSize(sizeof(Node)) +
+        estimateIndirectMemoryUsage(path) +
+        sizeof(std::pair<RelativePathPiece, Node*>);
+  }
+
+  // Once this reaches zero, the node is never resurrected: intern() replaces a
+  // dying node with a new one.
+  std::atomic<size_t> refCount{1};
+  JournalPathTable& table;
+  size_t shard;
+  RelativePath path;
+};
+
+JournalPath::JournalPath(const JournalPath& other) noexcept
+    : node_{other.node_} {
+  if (node_) {
+    node_->refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+JournalPath& JournalPath::operator=(const JournalPath& other) noexcept {
+  JournalPath copy{other};
+  std::swap(node_, copy.node_);
+  return *this;
+}
+
+JournalPath& JournalPath::operator=(JournalPath&& other) noexcept {
+  JournalPath moved{std::move(other)};
+  std::swap(node_, moved.node_);
+  return *this;
+}
+
+JournalPath::~JournalPath() {
+  if (node_) {
+    JournalPathTable::release(node_);
+  }
+}
+
+RelativePathPiece JournalPath::piece() const {
+  return node_ ? node_->path.piece() : RelativePathPiece{};
+}
+
+JournalPath JournalPathTable::intern(RelativePathPiece path) {
+  auto shardIndex = std::hash<RelativePathPiece>{}(path) % kShardCount;
+  auto nodes = shards_[shardIndex].nodes.wlock();
+  auto it = nodes->find(path);
+  if (it != nodes->end()) {
+    auto* node = it->second;
+    auto refCount = node->refCount.load(std::memory_order_relaxed);
+    while (refCount != 0) {
+      if (node->refCount.compare_exchange_weak(
+              refCount, refCount + 1, std::memory_order_relaxed)) {
+        return JournalPath{node};
+      }
+    }
+    // The node is being released; its key points into it.
+    nodes->erase(it);
+  }
+
+  auto* node = new JournalPath::Node{*this, shardIndex, path};
+  nodes->emplace(node->path.piece(), node);
+  memoryUsage_.fetch_add(
+      node->estimateMemoryUsage(), std::memory_order_relaxed);
+  return JournalPath{node};
+}
+
+size_t JournalPathTable::size() const {
+  size_t size = 0;
+  for (const auto& shard : shards_) {
+    size += shard.nodes.rlock()->size();
+  }
+  return size;
+}
+
+void JournalPathTable::release(JournalPath::Node* node) {
+  if (node->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  auto& table = node->table;
+  {
+    auto nodes = table.shards_[node->shard].nodes.wlock();
+    auto it = nodes->find(node->path.piece());
+    if (it != nodes->end() && it->second == node) {
+      nodes->erase(it);
+    }
+  }
+  table.memoryUsage_.fetch_sub(
+      node->estimateMemoryUsage(), std::memory_order_relaxed);
+  delete node;
+}
+
+} // namespace facebook::eden
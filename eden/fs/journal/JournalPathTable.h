@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class JournalPathTable;
+
+/**
+ * A reference to a path interned in a JournalPathTable.
+ *
+ * The same paths show up in many journal deltas, so each delta holds one of
+ * these, the size of a pointer, instead of its own copy of the path. Two
+ * JournalPaths from the same table are equal if and only if their paths are.
+ */
+class JournalPath {
+ public:
+  JournalPath() = default;
+  JournalPath(const JournalPath& other) noexcept;
+  JournalPath(JournalPath&& other) noexcept
+      : node_{std::exchange(other.node_, nullptr)} {}
+  JournalPath& operator=(const JournalPath& other) noexcept;
+  JournalPath& operator=(JournalPath&& other) noexcept;
+  ~JournalPath();
+
+  /**
+   * Returns the empty path if this JournalPath is empty.
+   */
+  RelativePathPiece piece() const;
+
+  bool operator==(const JournalPath& other) const {
+    return node_ == other.node_;
+  }
+  bool operator!=(const JournalPath& other) const {
+    return node_ != other.node_;
+  }
+
+  size_t hash() const noexcept {
+    return std::hash<const void*>{}(node_);
+  }
+
+ private:
+  friend class JournalPathTable;
+  struct Node;
+
+  explicit JournalPath(Node* node) : node_{node} {}
+
+  Node* node_{nullptr};
+};
+
+/**
+ * Refcounted storage for the paths of a Journal. A path is removed once the
+ * last JournalPath referring to it is gone, typically when the journal
+ * truncates its oldest deltas.
+ *
+ * It is safe to use this object and its JournalPaths from arbitrary threads.
+ * The table must outlive the JournalPaths it returns.
+ */
+class JournalPathTable {
+ public:
+  JournalPathTable() = default;
+  JournalPathTable(const JournalPathTable&) = delete;
+  JournalPathTable& operator=(const JournalPathTable&) = delete;
+
+  JournalPath intern(RelativePathPiece path);
+
+  /** The number of distinct paths that are referenced. */
+  size_t size() const;
+
+  /** Get memory used (in bytes) by the interned paths. */
+  size_t estimateMemoryUsage() const {
+    return memoryUsage_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class JournalPath;
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    // The keys point into the nodes.
+    folly::
+        Synchronized<folly::F14FastMap<RelativePathPiece, JournalPath::Node*>>
+            nodes;
+  };
+
+  static constexpr size_t kShardCount = 16;
+
+  static void release(JournalPath::Node* node);
+
+  std::array<Shard, kShardCount> shards_;
+  std::atomic<size_t> memoryUsage_{0};
+};
+
+} // namespace facebook::eden
+
+namespace std {
+template <>
+struct hash<facebook::eden::JournalPath> {
+  size_t operator()(const facebook::eden::JournalPath& path) const noexcept {
+    return path.hash();
+  }
+};
+} // namespace std
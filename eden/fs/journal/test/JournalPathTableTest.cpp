@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(JournalPathTableTest, equalPathsShareStorage) {
+  JournalPathTable table;
+  auto foo = table.intern("dir/foo"_relpath);
+  auto fooAgain = table.intern("dir/foo"_relpath);
+  auto bar = table.intern("dir/bar"_relpath);
+  EXPECT_EQ(foo, fooAgain);
+  EXPECT_NE(foo, bar);
+  EXPECT_EQ("dir/foo"_relpath, foo.piece());
+  EXPECT_EQ("dir/bar"_relpath, bar.piece());
+  EXPECT_EQ(2, table.size());
+  EXPECT_EQ(RelativePathPiece{}, JournalPath{}.piece());
+}
+
+TEST(JournalPathTableTest, pathsAreRemovedWithTheirLastReference) {
+  JournalPathTable table;
+  EXPECT_EQ(0, table.estimateMemoryUsage());
+  auto foo = table.intern("foo"_relpath);
+  auto memory = table.estimateMemoryUsage();
+  EXPECT_GT(memory, 0);
+
+  auto copy = foo;
+  foo = JournalPath{};
+  EXPECT_EQ(1, table.size());
+  EXPECT_EQ(memory, table.estimateMemoryUsage());
+  EXPECT_EQ("foo"_relpath, copy.piece());
+
+  copy = JournalPath{};
+  EXPECT_EQ(0, table.size());
+  EXPECT_EQ(0, table.estimateMemoryUsage());
+
+  // Interning it again works.
+  auto again = table.intern("foo"_relpath);
+  EXPECT_EQ("foo"_relpath, again.piece());
+  EXPECT_EQ(1, table.size());
+}
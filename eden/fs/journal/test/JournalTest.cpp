@@ -7,8 +7,11 @@
 
 #include "eden/fs/journal/Journal.h"
 
+#include <fmt/format.h>
 #include <folly/portability/GMock.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/portability/GTest.h>
+#include <thread>
 
 #include "eden/fs/model/RootId.h"
 
@@ -201,6 +204,21 @@ TEST_F(JournalTest, accumulate_range_with_hash_updates) {
   checkHashMatches({hash1}, journal);
 }
 
+TEST_F(JournalTest, getRecentRoots) {
+  RootId hash0;
+  RootId hash1{"1111111111111111111111111111111111111111"};
+  RootId hash2{"2222222222222222222222222222222222222222"};
+  EXPECT_EQ(std::vector<RootId>{hash0}, journal.getRecentRoots(10));
+
+  journal.recordHashUpdate(hash1);
+  journal.recordChanged("foo/bar"_relpath);
+  journal.recordHashUpdate(hash1, hash2);
+  EXPECT_EQ(
+      (std::vector<RootId>{hash2, hash1, hash0}), journal.getRecentRoots(10));
+  EXPECT_EQ((std::vector<RootId>{hash2, hash1}), journal.getRecentRoots(2));
+  EXPECT_TRUE(journal.getRecentRoots(0).empty());
+}
+
 TEST_F(JournalTest, debugRawJournalInfoRemoveCreateUpdate) {
   // Remove test.txt
   journal.recordRemoved("test.txt"_relpath);
@@ -657,3 +675,175 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST_F(JournalTest, throttled_subscribers_get_one_trailing_notification) {
+  std::atomic<unsigned> calls{0};
+  folly::Baton<> trailing;
+  Journal::SubscriberOptions options;
+  options.minInterval = std::chrono::milliseconds(50);
+  auto sub = journal.registerSubscriber(
+      [&] {
+        if (++calls == 2) {
+          trailing.post();
+        }
+      },
+      options);
+  (void)sub;
+
+  journal.recordChanged("foo"_relpath);
+  EXPECT_EQ(1u, calls);
+  for (int i = 0; i < 10; ++i) {
+    journal.getLatest();
+    journal.recordChanged("foo"_relpath);
+  }
+  EXPECT_EQ(1u, calls);
+
+  ASSERT_TRUE(trailing.try_wait_for(std::chrono::seconds(10)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(2u, calls);
+}
+
+TEST_F(JournalTest, throttled_subscribers_are_notified_after_max_deltas) {
+  unsigned calls = 0;
+  Journal::SubscriberOptions options;
+  options.minInterval = std::chrono::hours(1);
+  options.maxDeltas = 3;
+  auto sub = journal.registerSubscriber([&] { ++calls; }, options);
+
+  journal.recordChanged("foo"_relpath);
+  EXPECT_EQ(1u, calls);
+  journal.getLatest();
+  journal.recordChanged("bar"_relpath);
+  journal.getLatest();
+  journal.recordChanged("baz"_relpath);
+  EXPECT_EQ(1u, calls);
+  journal.getLatest();
+  journal.recordChanged("qux"_relpath);
+  EXPECT_EQ(2u, calls);
+
+  // The trailing notification scheduled above must not fire once cancelled.
+  journal.cancelSubscriber(sub);
+  EXPECT_FALSE(journal.isSubscriberValid(sub));
+}
+
+TEST_F(JournalTest, concurrent_changes_are_all_recorded_in_order) {
+  constexpr size_t kThreads = 8;
+  constexpr size_t kFilesPerThread = 100;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([this, i] {
+      for (size_t j = 0; j < kFilesPerThread; ++j) {
+        auto path = RelativePath{fmt::format("{}/{}", i, j)};
+        journal.recordCreated(path);
+        journal.recordRemoved(path);
+        journal.recordCreated(path);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(3 * kThreads * kFilesPerThread, journal.getLatest()->sequenceID);
+  auto summed = journal.accumulateRange();
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(kThreads * kFilesPerThread, summed->changedFilesInOverlay.size());
+  for (const auto& [path, info] : summed->changedFilesInOverlay) {
+    // Each thread's changes are recorded in the order it made them.
+    EXPECT_FALSE(info.existedBefore) << path;
+    EXPECT_TRUE(info.existedAfter) << path;
+  }
+}
+
+TEST_F(JournalTest, serialized_journal_can_be_restored) {
+  journal.recordHashUpdate(RootId{"0000"});
+  journal.recordCreated("created"_relpath);
+  journal.recordRenamed("created"_relpath, "renamed"_relpath);
+  journal.recordUncleanPaths(
+      RootId{"0000"}, RootId{"1111"}, {RelativePath{"unclean"}});
+  journal.recordChanged("renamed"_relpath);
+
+  Journal restored{edenStats};
+  ASSERT_TRUE(restored.restore(journal.serialize(1024 * 1024)));
+  EXPECT_EQ(5, restored.getLatest()->sequenceID);
+  EXPECT_EQ(RootId{"1111"}, restored.getLatest()->toHash);
+
+  auto expected = journal.accumulateRange(2);
+  auto summed = restored.accumulateRange(2);
+  ASSERT_TRUE(summed);
+  EXPECT_FALSE(summed->isTruncated);
+  EXPECT_EQ(2, summed->fromSequence);
+  EXPECT_EQ(5, summed->toSequence);
+  EXPECT_EQ(expected->changedFilesInOverlay, summed->changedFilesInOverlay);
+  EXPECT_EQ(expected->snapshotTransitions, summed->snapshotTransitions);
+  EXPECT_EQ(expected->uncleanPaths, summed->uncleanPaths);
+
+  // New deltas continue the sequence.
+  restored.recordRemoved("renamed"_relpath);
+  EXPECT_EQ(6, restored.getLatest()->sequenceID);
+}
+
+TEST_F(JournalTest, serialized_journal_keeps_the_most_recent_deltas) {
+  journal.recordHashUpdate(RootId{"0000"});
+  for (int i = 0; i < 100; ++i) {
+    journal.recordCreated(RelativePath{fmt::format("file{}", i)});
+  }
+
+  Journal restored{edenStats};
+  ASSERT_TRUE(restored.restore(journal.serialize(100)));
+  EXPECT_EQ(101, restored.getLatest()->sequenceID);
+  EXPECT_TRUE(restored.accumulateRange(1)->isTruncated);
+  auto summed = restored.accumulateRange(101);
+  ASSERT_TRUE(summed);
+  EXPECT_FALSE(summed->isTruncated);
+  EXPECT_EQ(1, summed->changedFilesInOverlay.count("file99"_relpath));
+}
+
+TEST_F(JournalTest, corrupt_serialized_journals_are_not_restored) {
+  journal.recordHashUpdate(RootId{"0000"});
+  journal.recordCreated("created"_relpath);
+  auto data = journal.serialize(1024);
+
+  Journal restored{edenStats};
+  EXPECT_FALSE(restored.restore(""));
+  EXPECT_FALSE(restored.restore("x"));
+  EXPECT_FALSE(restored.restore(data.substr(0, data.size() - 1)));
+  EXPECT_FALSE(restored.getLatest());
+  EXPECT_TRUE(restored.restore(data));
+}
+
+TEST_F(JournalTest, accumulate_range_across_summarized_deltas) {
+  // Enough deltas for a couple of summaries, plus some that are not.
+  constexpr size_t kDeltas = 3000;
+  journal.recordCreated("x"_relpath);
+  for (size_t i = 2; i < kDeltas; ++i) {
+    journal.recordCreated(RelativePath{fmt::format("file{}", i)});
+  }
+  journal.recordRemoved("x"_relpath);
+
+  for (size_t from : {1, 2, 1024, 1025, 1026, 2048, 2050, 2999, 3000}) {
+    auto summed = journal.accumulateRange(from);
+    ASSERT_TRUE(summed) << from;
+    EXPECT_FALSE(summed->isTruncated);
+    EXPECT_EQ(from, summed->fromSequence);
+    EXPECT_EQ(kDeltas, summed->toSequence);
+    auto expectedFiles = kDeltas - from + (from == 1 ? 0 : 1);
+    EXPECT_EQ(expectedFiles, summed->changedFilesInOverlay.size()) << from;
+    if (from > 2 && from < kDeltas) {
+      EXPECT_EQ(
+          1,
+          summed->changedFilesInOverlay.count(
+              RelativePath{fmt::format("file{}", from)}))
+          << from;
+      EXPECT_EQ(
+          0,
+          summed->changedFilesInOverlay.count(
+              RelativePath{fmt::format("file{}", from - 1)}))
+          << from;
+    }
+    auto& x = summed->changedFilesInOverlay.at(RelativePath{"x"});
+    EXPECT_EQ(from != 1, x.existedBefore) << from;
+    EXPECT_FALSE(x.existedAfter) << from;
+  }
+  EXPECT_EQ(kDeltas, journal.getStats()->maxFilesAccumulated);
+}
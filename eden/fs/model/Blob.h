@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <string>
 #include "eden/fs/model/Hash.h"
@@ -47,6 +48,21 @@ class Blob {
     return size_;
   }
 
+  /**
+   * Returns up to `length` bytes of the contents, starting at `offset`. The
+   * result shares the underlying buffers with this Blob.
+   */
+  std::unique_ptr<folly::IOBuf> cloneRange(uint64_t offset, uint64_t length)
+      const {
+    std::unique_ptr<folly::IOBuf> result;
+    if (offset < size_) {
+      folly::io::Cursor cursor{&contents_};
+      cursor.skip(offset);
+      cursor.cloneAtMost(result, length);
+    }
+    return result ? std::move(result) : folly::IOBuf::create(0);
+  }
+
   size_t getSizeBytes() const {
     return size_;
   }
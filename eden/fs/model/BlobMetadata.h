@@ -8,21 +8,34 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/Blake3.h"
 
 namespace facebook::eden {
 
 /**
  * A small struct containing both the size and the SHA-1 hash of
- * a Blob's contents.
+ * a Blob's contents, and its BLAKE3 hash once that has been computed.
  */
 class BlobMetadata {
  public:
   BlobMetadata(Hash20 contentsHash, uint64_t fileLength)
       : sha1(contentsHash), size(fileLength) {}
 
+  BlobMetadata(
+      Hash20 contentsHash,
+      uint64_t fileLength,
+      std::optional<Blake3::Digest> contentsBlake3)
+      : sha1(contentsHash), size(fileLength), blake3(contentsBlake3) {}
+
   Hash20 sha1;
   uint64_t size;
+  /**
+   * Only computed on demand, since hashing requires the blob's contents and
+   * most callers don't ask for it.
+   */
+  std::optional<Blake3::Digest> blake3;
 };
 
 } // namespace facebook::eden
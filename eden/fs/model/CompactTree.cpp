@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/CompactTree.h"
+
+#include <folly/Memory.h>
+#include <folly/logging/xlog.h>
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+TreeEntry CompactTree::Entry::toTreeEntry() const {
+  return TreeEntry{
+      ObjectId{hash_}, PathComponent{name_}, type_, size_, contentSha1_};
+}
+
+CompactTree::CompactTree(const Tree& tree) : hash_{tree.getHash()} {
+  const auto& entries = tree.getTreeEntries();
+  XCHECK_LE(entries.size(), std::numeric_limits<uint32_t>::max());
+  numEntries_ = static_cast<uint32_t>(entries.size());
+
+  size_t variableSize = 0;
+  for (const auto& entry : entries) {
+    variableSize += entry.getHash().size() + entry.getName().value().size();
+    hasSize_ |= entry.getSize().has_value();
+    hasContentSha1_ |= entry.getContentSha1().has_value();
+  }
+  size_t fixedSize = numEntries_ * sizeof(Record);
+  if (hasSize_) {
+    fixedSize += numEntries_ * sizeof(uint64_t);
+  }
+  if (hasContentSha1_) {
+    fixedSize += numEntries_ * Hash20::RAW_SIZE;
+  }
+  arenaSize_ = fixedSize + variableSize;
+  XCHECK_LE(arenaSize_, std::numeric_limits<uint32_t>::max());
+  // Zero-filled, and an all-zero SHA-1 means "none".
+  arena_ = std::make_unique<uint8_t[]>(arenaSize_);
+
+  auto* record = reinterpret_cast<Record*>(arena_.get());
+  auto* size = const_cast<uint8_t*>(sizes());
+  auto* sha1 = const_cast<uint8_t*>(sha1s());
+  auto offset = static_cast<uint32_t>(fixedSize);
+  for (const auto& entry : entries) {
+    auto hash = entry.getHash().getBytes();
+    auto name = entry.getName().stringPiece();
+    XCHECK_LE(hash.size(), std::numeric_limits<uint16_t>::max());
+    XCHECK_LE(name.size(), std::numeric_limits<uint16_t>::max());
+
+    // Not getType(), which folds some types together on Windows.
+    record->type = entry.type_;
+    record->hashOffset = offset;
+    record->hashSize = static_cast<uint16_t>(hash.size());
+    record->nameSize = static_cast<uint16_t>(name.size());
+    memcpy(arena_.get() + offset, hash.data(), hash.size());
+    offset += record->hashSize;
+    memcpy(arena_.get() + offset, name.data(), name.size());
+    offset += record->nameSize;
+    ++record;
+
+    if (size) {
+      uint64_t value = entry.getSize().value_or(TreeEntry::NO_SIZE);
+      memcpy(size, &value, sizeof(uint64_t));
+      size += sizeof(uint64_t);
+    }
+    if (sha1) {
+      if (auto& contentSha1 = entry.getContentSha1()) {
+        memcpy(sha1, contentSha1->getBytes().data(), Hash20::RAW_SIZE);
+      }
+      sha1 += Hash20::RAW_SIZE;
+    }
+  }
+  XDCHECK_EQ(offset, arenaSize_);
+}
+
+CompactTree::CompactTree(
+    const ObjectId& hash,
+    folly::Range<const EntryRef*> entries)
+    : hash_{hash} {
+  XCHECK_LE(entries.size(), std::numeric_limits<uint32_t>::max());
+  numEntries_ = static_cast<uint32_t>(entries.size());
+
+  size_t fixedSize = numEntries_ * sizeof(Record);
+  arenaSize_ = fixedSize;
+  for (const auto& entry : entries) {
+    arenaSize_ += entry.hash.size() + entry.name.value().size();
+  }
+  XCHECK_LE(arenaSize_, std::numeric_limits<uint32_t>::max());
+  arena_ = std::make_unique<uint8_t[]>(arenaSize_);
+
+  auto* record = reinterpret_cast<Record*>(arena_.get());
+  auto offset = static_cast<uint32_t>(fixedSize);
+  for (const auto& entry : entries) {
+    auto name = entry.name.stringPiece();
+    XCHECK_LE(entry.hash.size(), std::numeric_limits<uint16_t>::max());
+    XCHECK_LE(name.size(), std::numeric_limits<uint16_t>::max());
+
+    record->type = entry.type;
+    record->hashOffset = offset;
+    record->hashSize = static_cast<uint16_t>(entry.hash.size());
+    record->nameSize = static_cast<uint16_t>(name.size());
+    memcpy(arena_.get() + offset, entry.hash.data(), entry.hash.size());
+    offset += record->hashSize;
+    memcpy(arena_.get() + offset, name.data(), name.size());
+    offset += record->nameSize;
+    ++record;
+  }
+  XDCHECK_EQ(offset, arenaSize_);
+}
+
+const uint8_t* CompactTree::sizes() const {
+  if (!hasSize_) {
+    return nullptr;
+  }
+  return arena_.get() + numEntries_ * sizeof(Record);
+}
+
+const uint8_t* CompactTree::sha1s() const {
+  if (!hasContentSha1_) {
+    return nullptr;
+  }
+  auto offset = numEntries_ * sizeof(Record);
+  if (hasSize_) {
+    offset += numEntries_ * sizeof(uint64_t);
+  }
+  return arena_.get() + offset;
+}
+
+CompactTree::Entry CompactTree::operator[](size_t index) const {
+  XDCHECK_LT(index, numEntries_);
+  const auto& record = records()[index];
+
+  auto hash =
+      folly::ByteRange{arena_.get() + record.hashOffset, record.hashSize};
+  // Names were validated when the source Tree or EntryRef was built.
+  auto name = PathComponentPiece{
+      folly::StringPiece{
+          reinterpret_cast<const char*>(hash.end()), record.nameSize},
+      detail::SkipPathSanityCheck{}};
+
+  std::optional<uint64_t> size;
+  if (auto* sizeBytes = sizes()) {
+    uint64_t value;
+    memcpy(&value, sizeBytes + index * sizeof(uint64_t), sizeof(uint64_t));
+    if (value != TreeEntry::NO_SIZE) {
+      size = value;
+    }
+  }
+
+  std::optional<Hash20> contentSha1;
+  if (auto* sha1 = sha1s()) {
+    Hash20::Storage bytes;
+    memcpy(bytes.data(), sha1 + index * Hash20::RAW_SIZE, Hash20::RAW_SIZE);
+    Hash20 value{bytes};
+    if (value != kZeroHash) {
+      contentSha1 = value;
+    }
+  }
+
+  return Entry{record.type, name, hash, size, contentSha1};
+}
+
+size_t CompactTree::getSizeBytes() const {
+  return sizeof(*this) + folly::goodMallocSize(arenaSize_);
+}
+
+std::unique_ptr<Tree> CompactTree::toTree() const {
+  std::vector<TreeEntry> entries;
+  entries.reserve(numEntries_);
+  for (size_t i = 0; i < numEntries_; ++i) {
+    entries.push_back((*this)[i].toTreeEntry());
+  }
+  return std::make_unique<Tree>(std::move(entries), hash_);
+}
+
+} // namespace facebook::eden
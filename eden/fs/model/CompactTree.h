@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * An immutable tree that stores all of its entries in a single allocation.
+ *
+ * A Tree costs at least one TreeEntry per entry plus a heap allocation for
+ * every name that does not fit in std::string's inline buffer, and the
+ * allocator overhead of those dominates the size of most trees. CompactTree
+ * instead keeps small fixed-width per-entry records followed by the sizes,
+ * content SHA-1s, object ids and names, all in one arena, and hands out Entry
+ * views into it. Sizes and SHA-1s take no space in trees that have none.
+ *
+ * This is meant for holding many trees in memory at once; use toTree() to get
+ * something the rest of EdenFS can consume.
+ */
+class CompactTree {
+ public:
+  /**
+   * A view of one entry. It points into the CompactTree's arena and must not
+   * outlive it.
+   */
+  class Entry {
+   public:
+    TreeEntryType getType() const {
+      return type_;
+    }
+
+    PathComponentPiece getName() const {
+      return name_;
+    }
+
+    folly::ByteRange getHashBytes() const {
+      return hash_;
+    }
+
+    const std::optional<uint64_t>& getSize() const {
+      return size_;
+    }
+
+    const std::optional<Hash20>& getContentSha1() const {
+      return contentSha1_;
+    }
+
+    TreeEntry toTreeEntry() const;
+
+   private:
+    friend class CompactTree;
+
+    Entry(
+        TreeEntryType type,
+        PathComponentPiece name,
+        folly::ByteRange hash,
+        std::optional<uint64_t> size,
+        std::optional<Hash20> contentSha1)
+        : type_{type},
+          name_{name},
+          hash_{hash},
+          size_{size},
+          contentSha1_{contentSha1} {}
+
+    TreeEntryType type_;
+    PathComponentPiece name_;
+    folly::ByteRange hash_;
+    std::optional<uint64_t> size_;
+    std::optional<Hash20> contentSha1_;
+  };
+
+  /**
+   * An entry without a size or content SHA-1 whose name and object id are
+   * borrowed from some other buffer, such as a serialized tree.
+   */
+  struct EntryRef {
+    TreeEntryType type;
+    PathComponentPiece name;
+    folly::ByteRange hash;
+  };
+
+  explicit CompactTree(const Tree& tree);
+
+  /**
+   * Build a tree directly from borrowed entries, copying their names and
+   * object ids into the arena without any intermediate TreeEntry.
+   */
+  CompactTree(const ObjectId& hash, folly::Range<const EntryRef*> entries);
+
+  CompactTree(const CompactTree&) = delete;
+  CompactTree& operator=(const CompactTree&) = delete;
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  size_t size() const {
+    return numEntries_;
+  }
+
+  Entry operator[](size_t index) const;
+
+  /**
+   * The memory footprint of this tree. Called by ObjectCache to limit the
+   * number of cached trees in memory at a time.
+   */
+  size_t getSizeBytes() const;
+
+  std::unique_ptr<Tree> toTree() const;
+
+ private:
+  struct Record {
+    uint32_t hashOffset;
+    uint16_t hashSize;
+    uint16_t nameSize;
+    TreeEntryType type;
+  };
+
+  const Record* records() const {
+    return reinterpret_cast<const Record*>(arena_.get());
+  }
+
+  /// Sizes, or nullptr if no entry in this tree has one.
+  const uint8_t* sizes() const;
+
+  /// Content SHA-1s, or nullptr if no entry in this tree has one.
+  const uint8_t* sha1s() const;
+
+  const ObjectId hash_;
+  uint32_t numEntries_{0};
+  bool hasSize_{false};
+  bool hasContentSha1_{false};
+  size_t arenaSize_{0};
+  /**
+   * Records, then sizes (if hasSize_), then content SHA-1s (if
+   * hasContentSha1_), then each entry's object id immediately followed by its
+   * name.
+   */
+  std::unique_ptr<uint8_t[]> arena_;
+};
+
+} // namespace facebook::eden
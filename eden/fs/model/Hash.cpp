@@ -15,6 +15,8 @@
 #include <folly/ssl/OpenSSLHash.h>
 #include <string>
 
+#include "eden/fs/utils/Hex.h"
+
 using folly::ByteRange;
 using folly::range;
 using folly::ssl::OpenSSLHash;
@@ -31,10 +33,21 @@ folly::MutableByteRange Hash20::mutableBytes() {
   return folly::MutableByteRange{bytes_.data(), bytes_.size()};
 }
 
+Hash20 Hash20::fromHex(folly::StringPiece hex) {
+  if (hex.size() != (RAW_SIZE * 2)) {
+    throwInvalidArgument(
+        "incorrect data size for Hash constructor from string: ", hex.size());
+  }
+  Hash20 hash;
+  if (!hexDecode(hex, hash.bytes_.data())) {
+    // Run the scalar decoder to report the offending digit.
+    return Hash20{hex};
+  }
+  return hash;
+}
+
 std::string Hash20::toString() const {
-  std::string result;
-  folly::hexlify(bytes_, result);
-  return result;
+  return hexEncode(getBytes());
 }
 
 std::string Hash20::toByteString() const {
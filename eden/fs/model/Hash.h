@@ -43,6 +43,12 @@ class Hash20 : boost::totally_ordered<Hash20> {
   explicit constexpr Hash20(folly::StringPiece hex)
       : bytes_{constructFromHex(hex)} {}
 
+  /**
+   * Same as the hex string constructor, but not constexpr, which lets it use
+   * the vectorized decoder. Prefer this when parsing at runtime.
+   */
+  static Hash20 fromHex(folly::StringPiece hex);
+
   /**
    * Compute the SHA1 hash of an IOBuf chain.
    */
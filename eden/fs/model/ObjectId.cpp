@@ -14,7 +14,11 @@
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/ssl/OpenSSLHash.h>
+#include <algorithm>
 #include <string>
+#include <string_view>
+
+#include "eden/fs/utils/Hex.h"
 
 using folly::ByteRange;
 using folly::range;
@@ -23,10 +27,7 @@ using folly::ssl::OpenSSLHash;
 namespace facebook::eden {
 
 std::string ObjectId::asHexString() const {
-  auto bytes = getBytes();
-  std::string result;
-  folly::hexlify(bytes, result);
-  return result;
+  return hexEncode(getBytes());
 }
 
 std::string ObjectId::asString() const {
@@ -34,16 +35,21 @@ std::string ObjectId::asString() const {
   return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
-size_t ObjectId::getHashCode() const noexcept {
-  return std::hash<folly::fbstring>{}(bytes_);
-}
-
-bool ObjectId::operator==(const ObjectId& otherHash) const {
-  return bytes_ == otherHash.bytes_;
+size_t ObjectId::getHeapHashCode() const noexcept {
+  return std::hash<std::string_view>{}(std::string_view{
+      reinterpret_cast<const char*>(heap_.data), heap_.size});
 }
 
 bool ObjectId::operator<(const ObjectId& otherHash) const {
-  return bytes_ < otherHash.bytes_;
+  auto left = getBytes();
+  auto right = otherHash.getBytes();
+  auto common = std::min(left.size(), right.size());
+  if (common != 0) {
+    if (auto cmp = memcmp(left.data(), right.data(), common)) {
+      return cmp < 0;
+    }
+  }
+  return left.size() < right.size();
 }
 
 ObjectId ObjectId::sha1(const folly::IOBuf& buf) {
@@ -58,6 +64,22 @@ ObjectId ObjectId::sha1(ByteRange data) {
   return ObjectId{hashBytes};
 }
 
+ObjectId ObjectId::fromHex(folly::StringPiece hex) {
+  if (hex.size() % 2 != 0) {
+    throwInvalidArgument(
+        "incorrect data size for Hash constructor from string: ", hex.size());
+  }
+  ObjectId result;
+  auto* data = result.initialize(hex.size() / 2);
+  if (!hexDecode(hex, data)) {
+    // Run the scalar decoder to report the offending digit.
+    for (size_t i = 0; i < hex.size() / 2; i++) {
+      hexByteAt(hex, i);
+    }
+  }
+  return result;
+}
+
 void ObjectId::throwInvalidArgument(const char* message, size_t number) {
   throw std::invalid_argument(folly::to<std::string>(message, number));
 }
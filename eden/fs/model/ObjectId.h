@@ -9,9 +9,10 @@
 
 #include <boost/operators.hpp>
 #include <fmt/format.h>
-#include <folly/FBString.h>
 #include <folly/Range.h>
+#include <folly/hash/Hash.h>
 #include <stdint.h>
+#include <string.h>
 #include <array>
 #include <iosfwd>
 
@@ -27,19 +28,59 @@ namespace facebook::eden {
 */
 class ObjectId : boost::totally_ordered<ObjectId> {
  public:
-  // fbstring has more SSO space (23 bytes!) than std::string and thus can hold
-  // 20-byte hashes inline.
-  using Storage = folly::fbstring;
+  /**
+   * IDs of up to this many bytes, which covers 20-byte hashes and embedded
+   * proxy hashes, are stored inline. Longer ones are stored on the heap.
+   */
+  static constexpr size_t kInlineSize = 23;
 
   /**
    * Create an empty object id
    */
-  ObjectId() noexcept : bytes_{} {}
+  ObjectId() noexcept : words_{} {}
 
-  explicit ObjectId(Storage fbs) noexcept : bytes_{std::move(fbs)} {}
+  explicit ObjectId(folly::ByteRange bytes) : words_{} {
+    auto* data = initialize(bytes.size());
+    if (!bytes.empty()) {
+      memcpy(data, bytes.data(), bytes.size());
+    }
+  }
 
-  explicit ObjectId(folly::ByteRange bytes)
-      : bytes_{constructFromByteRange(bytes)} {}
+  explicit ObjectId(folly::StringPiece bytes)
+      : ObjectId{folly::ByteRange{bytes}} {}
+
+  ObjectId(const ObjectId& other) : words_{} {
+    if (other.isHeap()) {
+      memcpy(initialize(other.heap_.size), other.heap_.data, other.heap_.size);
+    } else {
+      copyWords(other);
+    }
+  }
+
+  ObjectId(ObjectId&& other) noexcept : words_{} {
+    copyWords(other);
+    other.clearWords();
+  }
+
+  ObjectId& operator=(const ObjectId& other) {
+    if (this != &other) {
+      *this = ObjectId{other};
+    }
+    return *this;
+  }
+
+  ObjectId& operator=(ObjectId&& other) noexcept {
+    if (this != &other) {
+      release();
+      copyWords(other);
+      other.clearWords();
+    }
+    return *this;
+  }
+
+  ~ObjectId() {
+    release();
+  }
 
   /**
    * Compute the SHA1 hash of an IOBuf chain.
@@ -62,18 +103,21 @@ class ObjectId : boost::totally_ordered<ObjectId> {
    * Returns bytes content of the ObjectId
    */
   folly::ByteRange getBytes() const {
-    return folly::ByteRange{folly::StringPiece{bytes_}};
+    if (isHeap()) {
+      return folly::ByteRange{heap_.data, heap_.size};
+    }
+    return folly::ByteRange{inline_, inline_[kInlineSize]};
   }
 
   char operator[](size_t pos) const {
-    return bytes_[pos];
+    return static_cast<char>(getBytes()[pos]);
   }
 
   /**
    * Returns size of this ObjectId
    */
   size_t size() const {
-    return bytes_.size();
+    return isHeap() ? heap_.size : inline_[kInlineSize];
   }
 
   /** @return [lowercase] hex representation of this ObjectId. */
@@ -86,32 +130,74 @@ class ObjectId : boost::totally_ordered<ObjectId> {
   /** @return bytes of this ObjectId. */
   std::string asString() const;
 
-  size_t getHashCode() const noexcept;
+  size_t getHashCode() const noexcept {
+    if (isHeap()) {
+      return getHeapHashCode();
+    }
+    // Inline IDs are zero-padded with their size in the last byte, so the
+    // words can be hashed without looking at the size.
+    return folly::hash::hash_128_to_64(
+        folly::hash::hash_128_to_64(words_[0], words_[1]), words_[2]);
+  }
+
+  bool operator==(const ObjectId& other) const {
+    // Inline IDs are equal exactly when their words are. An inline ID is
+    // never equal to a heap one, which is longer.
+    if (words_[0] == other.words_[0] && words_[1] == other.words_[1] &&
+        words_[2] == other.words_[2]) {
+      return true;
+    }
+    return isHeap() && other.isHeap() && getBytes() == other.getBytes();
+  }
 
-  bool operator==(const ObjectId&) const;
   bool operator<(const ObjectId&) const;
 
-  static ObjectId fromHex(folly::StringPiece hex) {
-    return ObjectId{constructFromHex(hex)};
-  }
+  static ObjectId fromHex(folly::StringPiece hex);
 
  private:
-  static Storage constructFromByteRange(folly::ByteRange bytes) {
-    return Storage{(const char*)bytes.data(), bytes.size()};
+  static constexpr uint8_t kHeapMarker = 0xff;
+
+  struct Heap {
+    uint8_t* data;
+    size_t size;
+  };
+
+  bool isHeap() const {
+    return inline_[kInlineSize] == kHeapMarker;
   }
-  static Storage constructFromHex(folly::StringPiece hex) {
-    if (hex.size() % 2 != 0) {
-      throwInvalidArgument(
-          "incorrect data size for Hash constructor from string: ", hex.size());
+
+  /**
+   * Sets up storage for `size` bytes in an empty ObjectId, and returns it.
+   */
+  uint8_t* initialize(size_t size) {
+    if (size <= kInlineSize) {
+      inline_[kInlineSize] = static_cast<uint8_t>(size);
+      return inline_;
     }
-    folly::fbstring result;
-    auto size = hex.size() / 2;
-    result.reserve(size);
-    for (size_t i = 0; i < size; i++) {
-      result.push_back(hexByteAt(hex, i));
+    heap_.data = new uint8_t[size];
+    heap_.size = size;
+    inline_[kInlineSize] = kHeapMarker;
+    return heap_.data;
+  }
+
+  void release() {
+    if (isHeap()) {
+      delete[] heap_.data;
     }
-    return result;
   }
+
+  void copyWords(const ObjectId& other) {
+    words_[0] = other.words_[0];
+    words_[1] = other.words_[1];
+    words_[2] = other.words_[2];
+  }
+
+  void clearWords() {
+    words_[0] = words_[1] = words_[2] = 0;
+  }
+
+  size_t getHeapHashCode() const noexcept;
+
   static constexpr char hexByteAt(folly::StringPiece hex, size_t index) {
     return (nibbleToHex(hex.data()[index * 2]) * 16) +
         nibbleToHex(hex.data()[(index * 2) + 1]);
@@ -133,9 +219,19 @@ class ObjectId : boost::totally_ordered<ObjectId> {
       const char* message,
       size_t number);
 
-  Storage bytes_;
+  /**
+   * Inline IDs are zero-padded and keep their size in the last byte, so
+   * that equal IDs have equal words. Heap IDs keep kHeapMarker there.
+   */
+  union {
+    uint64_t words_[3];
+    uint8_t inline_[kInlineSize + 1];
+    Heap heap_;
+  };
 };
 
+static_assert(sizeof(ObjectId) == 24);
+
 using ObjectIdRange = folly::Range<const ObjectId*>;
 
 /**
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/SerializedTreeView.h"
+
+#include <folly/logging/xlog.h>
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+namespace {
+template <typename T>
+T load(const char* data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+/**
+ * Bytes following an entry's name: its size and its content SHA-1.
+ */
+constexpr size_t kTrailerSize = sizeof(uint64_t) + Hash20::RAW_SIZE;
+} // namespace
+
+std::optional<uint64_t> SerializedTreeEntry::getSize() const {
+  auto size = load<uint64_t>(trailer_);
+  if (size == TreeEntry::NO_SIZE) {
+    return std::nullopt;
+  }
+  return size;
+}
+
+std::optional<Hash20> SerializedTreeEntry::getContentSha1() const {
+  Hash20::Storage sha1Bytes;
+  memcpy(&sha1Bytes, trailer_ + sizeof(uint64_t), Hash20::RAW_SIZE);
+  Hash20 sha1{sha1Bytes};
+  if (sha1 == kZeroHash) {
+    return std::nullopt;
+  }
+  return sha1;
+}
+
+TreeEntry SerializedTreeEntry::toTreeEntry() const {
+  return TreeEntry{
+      getHash(), PathComponent{name_}, type_, getSize(), getContentSha1()};
+}
+
+std::unique_ptr<SerializedTreeView> SerializedTreeView::tryCreate(
+    ObjectId hash,
+    folly::IOBuf buffer) {
+  auto data = folly::StringPiece{buffer.coalesce()};
+  auto begin = data.data();
+
+  if (data.size() < sizeof(uint32_t) * 2) {
+    XLOG(ERR) << "Can not read tree header, bytes remaining " << data.size();
+    return nullptr;
+  }
+  if (load<uint32_t>(data.data()) != Tree::V1_VERSION) {
+    return nullptr;
+  }
+  auto numEntries = load<uint32_t>(data.data() + sizeof(uint32_t));
+  data.advance(sizeof(uint32_t) * 2);
+
+  // Don't trust a corrupt entry count to size the allocation.
+  constexpr size_t kMinEntrySize =
+      sizeof(uint8_t) + sizeof(uint16_t) * 2 + kTrailerSize;
+  std::vector<uint32_t> offsets;
+  offsets.reserve(std::min<size_t>(numEntries, data.size() / kMinEntrySize));
+  for (uint32_t i = 0; i < numEntries; ++i) {
+    auto offset = static_cast<size_t>(data.data() - begin);
+    if (offset > std::numeric_limits<uint32_t>::max()) {
+      XLOG(ERR) << "Serialized tree " << hash << " is too large";
+      return nullptr;
+    }
+
+    // type, hash size, hash, name size, name, size, content sha1
+    size_t needed = sizeof(uint8_t) + sizeof(uint16_t);
+    if (data.size() < needed) {
+      XLOG(ERR) << "Can not read tree entry hash size, bytes remaining "
+                << data.size();
+      return nullptr;
+    }
+    auto hashSize = load<uint16_t>(data.data() + sizeof(uint8_t));
+    needed += hashSize + sizeof(uint16_t);
+    if (data.size() < needed) {
+      XLOG(ERR) << "Can not read tree entry name size, bytes remaining "
+                << data.size() << " need " << needed;
+      return nullptr;
+    }
+    auto nameSize = load<uint16_t>(data.data() + needed - sizeof(uint16_t));
+    auto name = folly::StringPiece{data.data() + needed, nameSize};
+    needed += nameSize + kTrailerSize;
+    if (data.size() < needed) {
+      XLOG(ERR) << "Can not read tree entry, bytes remaining " << data.size()
+                << " need " << needed;
+      return nullptr;
+    }
+
+    // Check the name once here so that operator[] can skip it.
+    try {
+      (void)PathComponentPiece{name};
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Invalid tree entry name in " << hash << ": " << ex.what();
+      return nullptr;
+    }
+
+    offsets.push_back(static_cast<uint32_t>(offset));
+    data.advance(needed);
+  }
+
+  if (data.size() != 0u) {
+    XLOG(ERR) << "Corrupted tree data, extra bytes remaining " << data.size();
+    return nullptr;
+  }
+
+  return std::unique_ptr<SerializedTreeView>{new SerializedTreeView{
+      std::move(hash), std::move(buffer), std::move(offsets)}};
+}
+
+SerializedTreeEntry SerializedTreeView::operator[](size_t index) const {
+  XDCHECK_LT(index, offsets_.size());
+  const char* data =
+      reinterpret_cast<const char*>(buffer_.data()) + offsets_[index];
+  auto type = static_cast<TreeEntryType>(load<uint8_t>(data));
+  data += sizeof(uint8_t);
+  auto hashSize = load<uint16_t>(data);
+  data += sizeof(uint16_t);
+  auto hash =
+      folly::ByteRange{reinterpret_cast<const uint8_t*>(data), hashSize};
+  data += hashSize;
+  auto nameSize = load<uint16_t>(data);
+  data += sizeof(uint16_t);
+  // The name was checked by tryCreate().
+  auto name = PathComponentPiece{
+      folly::StringPiece{data, nameSize}, detail::SkipPathSanityCheck{}};
+  data += nameSize;
+  return SerializedTreeEntry{type, hash, name, data};
+}
+
+std::optional<SerializedTreeEntry> SerializedTreeView::find(
+    PathComponentPiece name) const {
+  size_t low = 0;
+  size_t high = offsets_.size();
+  while (low < high) {
+    auto mid = low + (high - low) / 2;
+    auto entry = (*this)[mid];
+    if (entry.getName() < name) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low < offsets_.size()) {
+    auto entry = (*this)[low];
+    if (entry.getName() == name) {
+      return entry;
+    }
+  }
+
+#ifdef _WIN32
+  // See Tree::getEntryPtr().
+  const auto& fileName = name.stringPiece();
+  for (size_t i = 0; i < offsets_.size(); ++i) {
+    auto entry = (*this)[i];
+    if (equalsIgnoringAsciiCase(entry.getName().stringPiece(), fileName)) {
+      return entry;
+    }
+  }
+#endif
+  return std::nullopt;
+}
+
+size_t SerializedTreeView::getSizeBytes() const {
+  return sizeof(*this) + buffer_.capacity() +
+      folly::goodMallocSize(sizeof(uint32_t) * offsets_.capacity());
+}
+
+std::unique_ptr<Tree> SerializedTreeView::toTree() const {
+  std::vector<TreeEntry> entries;
+  entries.reserve(offsets_.size());
+  for (size_t i = 0; i < offsets_.size(); ++i) {
+    entries.push_back((*this)[i].toTreeEntry());
+  }
+  return std::make_unique<Tree>(std::move(entries), hash_);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A view of one entry of a SerializedTreeView. It points into the view's
+ * buffer and must not outlive it.
+ */
+class SerializedTreeEntry {
+ public:
+  TreeEntryType getType() const {
+#ifdef _WIN32
+    // See TreeEntry::getType().
+    switch (type_) {
+      case TreeEntryType::REGULAR_FILE:
+      case TreeEntryType::EXECUTABLE_FILE:
+      case TreeEntryType::SYMLINK:
+        return TreeEntryType::REGULAR_FILE;
+      default:
+        return type_;
+    }
+#else
+    return type_;
+#endif
+  }
+
+  bool isTree() const {
+    return type_ == TreeEntryType::TREE;
+  }
+
+  PathComponentPiece getName() const {
+    return name_;
+  }
+
+  folly::ByteRange getHashBytes() const {
+    return hash_;
+  }
+
+  ObjectId getHash() const {
+    return ObjectId{hash_};
+  }
+
+  std::optional<uint64_t> getSize() const;
+
+  std::optional<Hash20> getContentSha1() const;
+
+  /**
+   * Copy this entry out of the serialized buffer.
+   */
+  TreeEntry toTreeEntry() const;
+
+ private:
+  friend class SerializedTreeView;
+
+  SerializedTreeEntry(
+      TreeEntryType type,
+      folly::ByteRange hash,
+      PathComponentPiece name,
+      const char* trailer)
+      : type_{type}, hash_{hash}, name_{name}, trailer_{trailer} {}
+
+  TreeEntryType type_;
+  folly::ByteRange hash_;
+  PathComponentPiece name_;
+  /// Points at the size and content SHA-1 that follow the name.
+  const char* trailer_;
+};
+
+/**
+ * A read-only tree that keeps the bytes produced by Tree::serialize() and
+ * decodes entries on demand, rather than copying every name and hash into a
+ * std::vector<TreeEntry> up front.
+ *
+ * Construction makes a single pass over the buffer to validate it and record
+ * where each entry starts, so lookups by name are a binary search and only
+ * touch the entries they compare against.
+ *
+ * Only the V1 serialization format is supported; git-format trees have to go
+ * through Tree.
+ */
+class SerializedTreeView {
+ public:
+  /**
+   * Returns nullptr if the buffer is not a well-formed V1 serialized tree.
+   */
+  static std::unique_ptr<SerializedTreeView> tryCreate(
+      ObjectId hash,
+      folly::IOBuf buffer);
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  size_t size() const {
+    return offsets_.size();
+  }
+
+  bool empty() const {
+    return offsets_.empty();
+  }
+
+  SerializedTreeEntry operator[](size_t index) const;
+
+  /**
+   * Find the entry with the given name. Like Tree::getEntryPtr(), this falls
+   * back to a case insensitive search on Windows.
+   */
+  std::optional<SerializedTreeEntry> find(PathComponentPiece name) const;
+
+  /**
+   * An estimate of the memory footprint of this view.
+   */
+  size_t getSizeBytes() const;
+
+  /**
+   * Decode every entry into a regular Tree.
+   */
+  std::unique_ptr<Tree> toTree() const;
+
+ private:
+  SerializedTreeView(
+      ObjectId hash,
+      folly::IOBuf buffer,
+      std::vector<uint32_t> offsets)
+      : hash_{std::move(hash)},
+        buffer_{std::move(buffer)},
+        offsets_{std::move(offsets)} {}
+
+  const ObjectId hash_;
+  const folly::IOBuf buffer_;
+  /// Offset of each entry from the start of buffer_.
+  const std::vector<uint32_t> offsets_;
+};
+
+} // namespace facebook::eden
@@ -7,6 +7,7 @@
 
 #include "Tree.h"
 #include <folly/io/IOBuf.h>
+#include "eden/fs/utils/MemoryArena.h"
 
 namespace facebook::eden {
 using namespace folly;
@@ -57,6 +58,8 @@ IOBuf Tree::serialize() const {
 std::unique_ptr<Tree> Tree::tryDeserialize(
     ObjectId hash,
     folly::StringPiece data) {
+  // Trees read from the local store are mostly kept in the tree cache.
+  MemoryArena::Scope arenaScope{MemoryArena::objectCache()};
   if (data.size() < sizeof(uint32_t)) {
     XLOG(ERR) << "Can not read tree version, bytes remaining " << data.size();
     return nullptr;
@@ -50,8 +50,7 @@ class Tree {
       // case sensitive search.
       const auto& fileName = path.stringPiece();
       for (const auto& entry : entries_) {
-        if (entry.getName().stringPiece().equals(
-                fileName, folly::AsciiCaseInsensitive())) {
+        if (equalsIgnoringAsciiCase(entry.getName().stringPiece(), fileName)) {
           return &entry;
         }
       }
@@ -80,6 +79,8 @@ class Tree {
       folly::StringPiece data);
 
  private:
+  friend class SerializedTreeView;
+
   const ObjectId hash_;
   const std::vector<TreeEntry> entries_;
 
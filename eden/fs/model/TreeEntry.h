@@ -140,6 +140,9 @@ class TreeEntry {
   static std::optional<TreeEntry> deserialize(folly::StringPiece& data);
 
  private:
+  friend class CompactTree;
+  friend class SerializedTreeEntry;
+
   TreeEntryType type_;
   ObjectId hash_;
   PathComponent name_;
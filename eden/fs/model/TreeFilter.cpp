@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/TreeFilter.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#include <folly/Varint.h>
+
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * Filtered IDs start with this byte. The IDs of git and hg are 20-byte
+ * hashes, which may start with anything, so filtered IDs are never 20 bytes
+ * long; hg's longer IDs start with a small type byte.
+ *
+ * The marker is followed by the varint-encoded size of the unfiltered ID, the
+ * unfiltered ID, and the excluded paths, each terminated by a NUL byte.
+ */
+constexpr uint8_t kFilteredIdMarker = 0xf1;
+constexpr size_t kAmbiguousIdSize = 20;
+
+/**
+ * Splits the first component off a path.
+ */
+std::pair<folly::StringPiece, folly::StringPiece> splitFirstComponent(
+    folly::StringPiece path) {
+  auto separator = path.find(kDirSeparator);
+  if (separator == folly::StringPiece::npos) {
+    return {path, folly::StringPiece{}};
+  }
+  return {path.subpiece(0, separator), path.subpiece(separator + 1)};
+}
+} // namespace
+
+TreeFilter::TreeFilter(std::vector<RelativePath> excludedPaths) {
+  // Parents sort before their children, so each path only has to be checked
+  // against the ones kept before it.
+  std::sort(excludedPaths.begin(), excludedPaths.end());
+  for (auto& path : excludedPaths) {
+    if (path.empty()) {
+      throw std::invalid_argument("the root of a checkout cannot be excluded");
+    }
+    if (!isExcluded(path)) {
+      excludedPaths_.push_back(std::move(path));
+    }
+  }
+}
+
+bool TreeFilter::isExcluded(RelativePathPiece path) const {
+  return std::any_of(
+      excludedPaths_.begin(),
+      excludedPaths_.end(),
+      [&](const RelativePath& excluded) {
+        return excluded == path || excluded.isParentDirOf(path);
+      });
+}
+
+std::shared_ptr<const Tree> TreeFilter::apply(
+    std::shared_ptr<const Tree> tree) const {
+  if (empty()) {
+    return tree;
+  }
+
+  std::set<folly::StringPiece> excludedNames;
+  std::map<folly::StringPiece, std::vector<RelativePath>> subtreePaths;
+  for (const auto& path : excludedPaths_) {
+    auto [name, rest] = splitFirstComponent(path.stringPiece());
+    if (rest.empty()) {
+      excludedNames.insert(name);
+    } else {
+      subtreePaths[name].emplace_back(rest);
+    }
+  }
+
+  std::vector<TreeEntry> entries;
+  entries.reserve(tree->getTreeEntries().size());
+  for (const auto& entry : tree->getTreeEntries()) {
+    auto name = entry.getName().stringPiece();
+    if (excludedNames.count(name)) {
+      continue;
+    }
+    auto subtree = subtreePaths.find(name);
+    if (subtree != subtreePaths.end() && entry.isTree()) {
+      entries.emplace_back(
+          TreeFilter{std::move(subtree->second)}.makeFilteredId(
+              entry.getHash()),
+          entry.getName(),
+          TreeEntryType::TREE);
+    } else {
+      entries.push_back(entry);
+    }
+  }
+  return std::make_shared<const Tree>(
+      std::move(entries), makeFilteredId(tree->getHash()));
+}
+
+ObjectId TreeFilter::makeFilteredId(const ObjectId& id) const {
+  auto idBytes = id.getBytes();
+  std::string bytes;
+  bytes.push_back(static_cast<char>(kFilteredIdMarker));
+  uint8_t size[folly::kMaxVarintLength64];
+  bytes.append(
+      reinterpret_cast<const char*>(size),
+      folly::encodeVarint(idBytes.size(), size));
+  bytes.append(reinterpret_cast<const char*>(idBytes.data()), idBytes.size());
+  for (const auto& path : excludedPaths_) {
+    bytes.append(path.value());
+    bytes.push_back('\0');
+  }
+  if (bytes.size() == kAmbiguousIdSize) {
+    // An empty path, which parseFilteredId() skips.
+    bytes.push_back('\0');
+  }
+  return ObjectId{folly::StringPiece{bytes}};
+}
+
+std::optional<std::pair<ObjectId, TreeFilter>> TreeFilter::parseFilteredId(
+    const ObjectId& id) {
+  auto bytes = id.getBytes();
+  if (bytes.size() == kAmbiguousIdSize || bytes.empty() ||
+      bytes[0] != kFilteredIdMarker) {
+    return std::nullopt;
+  }
+  bytes.advance(1);
+  auto size = folly::tryDecodeVarint(bytes);
+  if (size.hasError() || *size > bytes.size()) {
+    return std::nullopt;
+  }
+  ObjectId unfilteredId{bytes.subpiece(0, *size)};
+  bytes.advance(*size);
+
+  std::vector<RelativePath> paths;
+  folly::StringPiece rest{bytes};
+  while (!rest.empty()) {
+    auto end = rest.find('\0');
+    if (end == folly::StringPiece::npos) {
+      return std::nullopt;
+    }
+    if (end > 0) {
+      paths.emplace_back(rest.subpiece(0, end));
+    }
+    rest.advance(end + 1);
+  }
+  if (paths.empty()) {
+    return std::nullopt;
+  }
+  return std::make_pair(std::move(unfilteredId), TreeFilter{std::move(paths)});
+}
+
+} // namespace facebook::eden
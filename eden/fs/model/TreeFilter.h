@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A set of paths to exclude, along with everything under them, from the
+ * trees of a checkout.
+ *
+ * Applying the filter to a root tree removes the entries it excludes, and
+ * gives the tree and each subtree containing an excluded path a filtered ID,
+ * which encodes the original ID and the paths to exclude from it.
+ * ObjectStore::getTree() applies those when it loads a filtered ID, so the
+ * excluded paths never appear however deep they are. Filtered IDs need no
+ * other state to be resolved, so they can be persisted like any other ID.
+ */
+class TreeFilter {
+ public:
+  TreeFilter() = default;
+
+  /**
+   * Paths under another excluded path are redundant and dropped. Throws
+   * std::invalid_argument if the root itself is excluded.
+   */
+  explicit TreeFilter(std::vector<RelativePath> excludedPaths);
+
+  bool empty() const {
+    return excludedPaths_.empty();
+  }
+
+  /**
+   * The excluded paths, sorted.
+   */
+  const std::vector<RelativePath>& getExcludedPaths() const {
+    return excludedPaths_;
+  }
+
+  /**
+   * Whether the path is excluded, either itself or through a parent.
+   */
+  bool isExcluded(RelativePathPiece path) const;
+
+  /**
+   * Returns the tree with the excluded paths removed, or the tree itself if
+   * the filter is empty.
+   */
+  std::shared_ptr<const Tree> apply(std::shared_ptr<const Tree> tree) const;
+
+  /**
+   * If the ID was given to a tree by apply(), returns the ID of the
+   * unfiltered tree and the filter to apply to it.
+   */
+  static std::optional<std::pair<ObjectId, TreeFilter>> parseFilteredId(
+      const ObjectId& id);
+
+  bool operator==(const TreeFilter& other) const {
+    return excludedPaths_ == other.excludedPaths_;
+  }
+  bool operator!=(const TreeFilter& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  ObjectId makeFilteredId(const ObjectId& id) const;
+
+  std::vector<RelativePath> excludedPaths_;
+};
+
+} // namespace facebook::eden
@@ -67,20 +67,65 @@ void GitIgnore::loadFile(StringPiece contents) {
   // stop at the first match.
   std::reverse(newRules.begin(), newRules.end());
   std::swap(rules_, newRules);
+
+  literalRules_.clear();
+  suffixRules_.clear();
+  suffixLengths_.clear();
+  otherRules_.clear();
+  for (size_t idx = 0; idx < rules_.size(); ++idx) {
+    const auto& rule = rules_[idx];
+    if (auto literal = rule.getBasenameLiteral(); !literal.empty()) {
+      literalRules_[literal.str()].push_back(idx);
+    } else if (auto suffix = rule.getBasenameSuffix(); !suffix.empty()) {
+      suffixRules_[suffix.str()].push_back(idx);
+      if (std::find(
+              suffixLengths_.begin(), suffixLengths_.end(), suffix.size()) ==
+          suffixLengths_.end()) {
+        suffixLengths_.push_back(suffix.size());
+      }
+    } else {
+      otherRules_.push_back(idx);
+    }
+  }
 }
 
 GitIgnore::MatchResult GitIgnore::match(
     RelativePathPiece path,
     PathComponentPiece basename,
     FileType fileType) const {
-  for (const auto& pattern : rules_) {
-    auto result = pattern.match(path, basename, fileType);
-    if (result != NO_MATCH) {
-      return result;
+  // Find the matching rule with the lowest index, since rules_ is sorted from
+  // highest to lowest precedence.
+  size_t bestIdx = rules_.size();
+  MatchResult bestResult = NO_MATCH;
+  auto tryRules = [&](const std::vector<size_t>& indices) {
+    for (auto idx : indices) {
+      if (idx >= bestIdx) {
+        return;
+      }
+      auto result = rules_[idx].match(path, basename, fileType);
+      if (result != NO_MATCH) {
+        bestIdx = idx;
+        bestResult = result;
+        return;
+      }
+    }
+  };
+
+  auto name = basename.stringPiece();
+  if (auto it = literalRules_.find(name); it != literalRules_.end()) {
+    tryRules(it->second);
+  }
+  for (auto length : suffixLengths_) {
+    if (length <= name.size()) {
+      auto it = suffixRules_.find(name.subpiece(name.size() - length));
+      if (it != suffixRules_.end()) {
+        tryRules(it->second);
+      }
     }
   }
+  tryRules(otherRules_);
 
-  return NO_MATCH;
+  return bestResult;
 }
 
 string GitIgnore::matchString(MatchResult result) {
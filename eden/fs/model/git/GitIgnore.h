@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <string>
 #include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -179,6 +181,17 @@ class GitIgnore {
    * listed in the .gitignore file).
    */
   std::vector<GitIgnorePattern> rules_;
+
+  /*
+   * An index of rules_, so that match() does not have to try every pattern.
+   * Patterns that match a literal basename, or a basename ending in a literal
+   * suffix, are looked up by that name.  All other patterns are tried in
+   * order.  Each list holds indices into rules_, in increasing order.
+   */
+  folly::F14FastMap<std::string, std::vector<size_t>> literalRules_;
+  folly::F14FastMap<std::string, std::vector<size_t>> suffixRules_;
+  std::vector<size_t> suffixLengths_;
+  std::vector<size_t> otherRules_;
 };
 
 } // namespace facebook::eden
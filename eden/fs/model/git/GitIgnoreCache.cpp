@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+namespace facebook::eden {
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::get(const ObjectId& id) {
+  auto cache = cache_.lock();
+  auto it = cache->find(id);
+  if (it == cache->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::insert(
+    const ObjectId& id,
+    folly::StringPiece contents) {
+  // Parse outside of the lock.
+  auto ignore = std::make_shared<GitIgnore>();
+  ignore->loadFile(contents);
+  std::shared_ptr<const GitIgnore> result{std::move(ignore)};
+  cache_.lock()->set(id, result);
+  return result;
+}
+
+} // namespace facebook::eden
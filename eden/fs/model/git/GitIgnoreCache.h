@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/git/GitIgnore.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded, in-memory LRU cache of parsed .gitignore files, keyed by the ID
+ * of the blob they were loaded from.
+ *
+ * Repositories commonly contain many identical .gitignore files, and every
+ * status or glob reloads the ones along its way.  Caching them by blob ID
+ * lets identical files share a single parsed GitIgnore, and lets unchanged
+ * ones be reused without reading or parsing them again.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class GitIgnoreCache {
+ public:
+  explicit GitIgnoreCache(size_t maximumEntries)
+      : cache_{folly::in_place, maximumEntries} {}
+
+  std::shared_ptr<const GitIgnore> get(const ObjectId& id);
+
+  /**
+   * Parse `contents`, the contents of blob `id`, and remember the result.
+   */
+  std::shared_ptr<const GitIgnore> insert(
+      const ObjectId& id,
+      folly::StringPiece contents);
+
+  size_t size() const {
+    return cache_.lock()->size();
+  }
+
+ private:
+  // A lookup updates the LRU order, so there is no point in a shared lock.
+  folly::Synchronized<
+      folly::EvictingCacheMap<ObjectId, std::shared_ptr<const GitIgnore>>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
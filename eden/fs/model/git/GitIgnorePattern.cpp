@@ -137,11 +137,34 @@ optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
     return std::nullopt;
   }
 
-  return GitIgnorePattern(flags, std::move(matcher).value());
+  // Remember the literal text of basename patterns without wildcards, and of
+  // the very common "*.ext" form, so that GitIgnore can look them up by name
+  // rather than trying them one by one.
+  std::string literal;
+  if (flags & FLAG_BASENAME_ONLY) {
+    constexpr StringPiece kSpecialChars{"*?[\\"};
+    auto rest = line;
+    if (rest[0] == '*') {
+      rest.advance(1);
+    }
+    if (!rest.empty() &&
+        rest.find_first_of(kSpecialChars) == StringPiece::npos) {
+      flags |= rest.size() == line.size() ? FLAG_LITERAL : FLAG_SUFFIX;
+      literal = rest.str();
+    }
+  }
+
+  return GitIgnorePattern(
+      flags, std::move(matcher).value(), std::move(literal));
 }
 
-GitIgnorePattern::GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher)
-    : flags_(flags), matcher_(std::move(matcher)) {}
+GitIgnorePattern::GitIgnorePattern(
+    uint32_t flags,
+    GlobMatcher&& matcher,
+    std::string literal)
+    : flags_(flags),
+      matcher_(std::move(matcher)),
+      literal_(std::move(literal)) {}
 
 GitIgnorePattern::~GitIgnorePattern() {}
 
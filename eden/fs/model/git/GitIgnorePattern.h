@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <optional>
+#include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 
@@ -69,6 +70,25 @@ class GitIgnorePattern {
       PathComponentPiece basename,
       GitIgnore::FileType fileType) const;
 
+  /**
+   * If this pattern only matches basenames equal to a literal string, return
+   * that string.  Otherwise return an empty string.
+   */
+  folly::StringPiece getBasenameLiteral() const {
+    return (flags_ & FLAG_LITERAL) ? folly::StringPiece{literal_}
+                                   : folly::StringPiece{};
+  }
+
+  /**
+   * If this pattern only matches basenames ending with a literal string (a
+   * pattern like "*.o"), return that string.  Otherwise return an empty
+   * string.
+   */
+  folly::StringPiece getBasenameSuffix() const {
+    return (flags_ & FLAG_SUFFIX) ? folly::StringPiece{literal_}
+                                  : folly::StringPiece{};
+  }
+
  private:
   /**
    * Flag values that can be bitwise-ORed to create the flags_ value.
@@ -82,9 +102,18 @@ class GitIgnorePattern {
     // The pattern did not contain /, so it only matches against the last
     // component of any path.
     FLAG_BASENAME_ONLY = 0x04,
+    // The pattern matches only against the basename and has no wildcards,
+    // so it is equal to literal_.
+    FLAG_LITERAL = 0x08,
+    // The pattern matches only against the basename, and is a "*" followed by
+    // literal_.
+    FLAG_SUFFIX = 0x10,
   };
 
-  GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher);
+  GitIgnorePattern(
+      uint32_t flags,
+      GlobMatcher&& matcher,
+      std::string literal = {});
 
   /**
    * A bit set of the Flags defined above.
@@ -94,6 +123,10 @@ class GitIgnorePattern {
    * The GlobMatcher object for performing matching.
    */
   GlobMatcher matcher_;
+  /**
+   * The literal text of FLAG_LITERAL and FLAG_SUFFIX patterns.
+   */
+  std::string literal_;
 };
 
 } // namespace facebook::eden
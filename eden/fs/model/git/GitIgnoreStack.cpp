@@ -14,6 +14,12 @@ constexpr static PathComponentPiece kHgName{".hg"};
 constexpr static PathComponentPiece kEdenName{".eden"};
 } // namespace
 
+const std::shared_ptr<const GitIgnore>& GitIgnoreStack::emptyIgnore() {
+  static const auto* const kEmptyIgnore =
+      new std::shared_ptr<const GitIgnore>{std::make_shared<GitIgnore>()};
+  return *kEmptyIgnore;
+}
+
 GitIgnore::MatchResult GitIgnoreStack::match(
     RelativePathPiece path,
     GitIgnore::FileType fileType) const {
@@ -47,7 +53,7 @@ GitIgnore::MatchResult GitIgnoreStack::match(
       ++suffixIter;
     }
 
-    const GitIgnore* ignore = &node->ignore_;
+    const GitIgnore* ignore = node->ignore_.get();
     node = node->parent_;
 
     const auto result = ignore->match(suffix, basename, fileType);
@@ -7,9 +7,10 @@
 
 #include "eden/fs/model/git/GitTree.h"
 #include <fmt/format.h>
-#include <folly/io/Cursor.h>
+#include <folly/Conv.h>
 #include <cstdio>
 #include <cstring>
+#include "eden/fs/model/CompactTree.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
@@ -28,44 +29,75 @@ enum GitModeMask {
   SYMLINK = 0120000,
 };
 
-std::unique_ptr<Tree> deserializeGitTree(
-    const ObjectId& hash,
-    const IOBuf* treeData) {
-  folly::io::Cursor cursor(treeData);
+namespace {
+
+/**
+ * Parse a serialized git tree in a single pass over `treeData`, calling
+ * `fn(type, name, hash)` for each entry. The name and hash point into
+ * `treeData`; nothing is allocated per entry.
+ */
+template <typename Fn>
+void parseGitTree(const ObjectId& hash, folly::ByteRange treeData, Fn&& fn) {
+  auto* pos = treeData.begin();
+  auto* end = treeData.end();
 
   // Find the end of the header and extract the size.
-  if (cursor.readFixedString(5) != "tree ") {
+  constexpr folly::StringPiece kHeader{"tree "};
+  if (treeData.size() < kHeader.size() ||
+      memcmp(pos, kHeader.data(), kHeader.size()) != 0) {
     throw invalid_argument("Contents did not start with expected header.");
   }
+  pos += kHeader.size();
 
   // 25 characters is long enough to represent any legitimate length
-  size_t maxSizeLength = 25;
-  auto sizeStr = cursor.readTerminatedString('\0', maxSizeLength);
-  auto contentSize = folly::to<unsigned int>(sizeStr);
-  if (contentSize != cursor.length()) {
+  constexpr size_t kMaxSizeLength = 25;
+  auto* sizeEnd = static_cast<const uint8_t*>(
+      memchr(pos, '\0', std::min<size_t>(end - pos, kMaxSizeLength + 1)));
+  if (!sizeEnd) {
+    throw invalid_argument("Header size is not terminated.");
+  }
+  auto contentSize = folly::to<unsigned int>(
+      folly::StringPiece{reinterpret_cast<const char*>(pos), sizeEnd});
+  pos = sizeEnd + 1;
+  if (contentSize != static_cast<size_t>(end - pos)) {
     throw invalid_argument("Size in header should match contents");
   }
 
-  // Scan the data and populate entries, as appropriate.
-  vector<TreeEntry> entries;
-  while (!cursor.isAtEnd()) {
+  while (pos != end) {
     // Extract the mode.
-    // This should only be 6 or 7 characters.
+    // This should only be 6 or 7 octal characters.
     // Stop scanning if we haven't seen a space in 10 characters
-    size_t maxModeLength = 10;
-    auto modeStr = cursor.readTerminatedString(' ', maxModeLength);
-    size_t modeEndIndex;
-    auto mode = std::stoi(modeStr, &modeEndIndex, /* base */ 8);
-    if (modeEndIndex != modeStr.size()) {
+    constexpr size_t kMaxModeLength = 10;
+    uint32_t mode = 0;
+    auto* modeStart = pos;
+    while (pos != end && *pos != ' ') {
+      if (*pos < '0' || *pos > '7' ||
+          static_cast<size_t>(pos - modeStart) >= kMaxModeLength) {
+        throw invalid_argument("Did not parse expected number of octal chars.");
+      }
+      mode = (mode << 3) | (*pos - '0');
+      ++pos;
+    }
+    if (pos == end || pos == modeStart) {
       throw invalid_argument("Did not parse expected number of octal chars.");
     }
+    ++pos;
 
     // Extract the name.
-    auto name = cursor.readTerminatedString();
+    auto* nameEnd = static_cast<const uint8_t*>(memchr(pos, '\0', end - pos));
+    if (!nameEnd) {
+      throw std::out_of_range("Entry name is not terminated.");
+    }
+    PathComponentPiece name{
+        folly::StringPiece{reinterpret_cast<const char*>(pos), nameEnd}};
+    pos = nameEnd + 1;
 
     // Extract the hash.
-    Hash20::Storage hashBytes;
-    cursor.pull(hashBytes.data(), hashBytes.size());
+    if (static_cast<size_t>(end - pos) < Hash20::RAW_SIZE) {
+      throw std::out_of_range("Entry hash is truncated.");
+    }
+    folly::ByteRange entryHash{pos, Hash20::RAW_SIZE};
+    pos += Hash20::RAW_SIZE;
 
     // Determine the individual fields from the mode.
 
@@ -88,19 +120,62 @@ std::unique_ptr<Tree> deserializeGitTree(
           fmt::format("Unrecognized mode: {:o} in object {}", mode, hash));
     }
 
-    entries.emplace_back(
-        ObjectId(hashBytes), PathComponent{std::move(name)}, fileType);
+    fn(fileType, name, entryHash);
   }
+}
 
-  return std::make_unique<Tree>(std::move(entries), hash);
+/**
+ * A lower bound on the size of a serialized entry, used to reserve space for
+ * the entries up front: a 5 character mode, a space, a 1 character name, a
+ * nul and a hash.
+ */
+constexpr size_t kMinEntrySize = 8 + Hash20::RAW_SIZE;
+
+} // namespace
+
+std::unique_ptr<Tree> deserializeGitTree(
+    const ObjectId& hash,
+    const IOBuf* treeData) {
+  if (treeData->isChained()) {
+    auto coalesced = treeData->cloneCoalescedAsValue();
+    return deserializeGitTree(
+        hash, folly::ByteRange{coalesced.data(), coalesced.length()});
+  }
+  return deserializeGitTree(
+      hash, folly::ByteRange{treeData->data(), treeData->length()});
 }
 
-// Convenience wrapper which accepts a ByteRange
 std::unique_ptr<Tree> deserializeGitTree(
     const ObjectId& hash,
     folly::ByteRange treeData) {
-  IOBuf buf(IOBuf::WRAP_BUFFER, treeData);
-  return deserializeGitTree(hash, &buf);
+  vector<TreeEntry> entries;
+  entries.reserve(treeData.size() / kMinEntrySize);
+  parseGitTree(
+      hash,
+      treeData,
+      [&](TreeEntryType type,
+          PathComponentPiece name,
+          folly::ByteRange entryHash) {
+        entries.emplace_back(ObjectId{entryHash}, PathComponent{name}, type);
+      });
+  entries.shrink_to_fit();
+  return std::make_unique<Tree>(std::move(entries), hash);
+}
+
+std::unique_ptr<CompactTree> deserializeGitCompactTree(
+    const ObjectId& hash,
+    folly::ByteRange treeData) {
+  vector<CompactTree::EntryRef> entries;
+  entries.reserve(treeData.size() / kMinEntrySize);
+  parseGitTree(
+      hash,
+      treeData,
+      [&](TreeEntryType type,
+          PathComponentPiece name,
+          folly::ByteRange entryHash) {
+        entries.push_back(CompactTree::EntryRef{type, name, entryHash});
+      });
+  return std::make_unique<CompactTree>(hash, folly::range(entries));
 }
 
 } // namespace facebook::eden
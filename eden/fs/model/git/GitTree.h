@@ -12,6 +12,7 @@
 
 namespace facebook::eden {
 
+class CompactTree;
 class ObjectId;
 class Tree;
 
@@ -26,4 +27,12 @@ std::unique_ptr<Tree> deserializeGitTree(
     const ObjectId& hash,
     folly::ByteRange treeData);
 
+/**
+ * Like deserializeGitTree, but builds a CompactTree straight from the
+ * serialized entries, without allocating anything per entry.
+ */
+std::unique_ptr<CompactTree> deserializeGitCompactTree(
+    const ObjectId& hash,
+    folly::ByteRange treeData);
+
 } // namespace facebook::eden
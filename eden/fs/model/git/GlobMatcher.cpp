@@ -89,8 +89,16 @@ bool operator&(GlobOptions a, GlobOptions b) {
   return (static_cast<uint32_t>(a) & static_cast<uint32_t>(b)) != 0;
 }
 
-GlobMatcher::GlobMatcher(vector<uint8_t> pattern)
-    : pattern_(std::move(pattern)) {}
+GlobMatcher::GlobMatcher(
+    vector<uint8_t> pattern,
+    size_t suffixIdx,
+    uint8_t suffixLength)
+    : pattern_(std::move(pattern)),
+      suffixIdx_(suffixIdx),
+      suffixLength_(suffixLength) {
+  isLiteral_ = !pattern_.empty() && pattern_[0] == GLOB_LITERAL &&
+      pattern_.size() == size_t{pattern_[1]} + 2;
+}
 
 GlobMatcher::GlobMatcher() {}
 
@@ -247,7 +255,30 @@ Expected<GlobMatcher, string> GlobMatcher::create(
     result[prevOpcodeIdx] = GLOB_ENDS_WITH;
   }
 
-  return GlobMatcher(std::move(result));
+  // Remember where the trailing literal data is, if any, so that
+  // getLiteralSuffix() does not have to decode the whole pattern.
+  size_t suffixIdx = 0;
+  uint8_t suffixLength = 0;
+  if (prevOpcodeIdx >= 0 && result[prevOpcodeIdx] == GLOB_ENDS_WITH) {
+    suffixLength = result[prevOpcodeIdx + 2];
+    suffixIdx = prevOpcodeIdx + 3;
+  } else if (curOpcodeIdx >= 0 && result[curOpcodeIdx] == GLOB_LITERAL) {
+    suffixLength = result[curOpcodeIdx + 1];
+    suffixIdx = curOpcodeIdx + 2;
+  }
+
+  return GlobMatcher(std::move(result), suffixIdx, suffixLength);
+}
+
+StringPiece GlobMatcher::getLiteralPrefix() const {
+  if (pattern_.empty() || pattern_[0] != GLOB_LITERAL) {
+    return StringPiece{};
+  }
+  return StringPiece{ByteRange(pattern_.data() + 2, pattern_[1])};
+}
+
+StringPiece GlobMatcher::getLiteralSuffix() const {
+  return StringPiece{ByteRange(pattern_.data() + suffixIdx_, suffixLength_)};
 }
 
 Expected<size_t, string> GlobMatcher::parseBracketExpr(
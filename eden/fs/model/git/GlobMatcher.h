@@ -75,8 +75,31 @@ class GlobMatcher {
    */
   bool match(folly::StringPiece text) const;
 
+  /**
+   * Returns true if this pattern has no wildcards, and so only matches the
+   * text returned by getLiteralPrefix().
+   */
+  bool isLiteral() const {
+    return isLiteral_;
+  }
+
+  /**
+   * Returns literal text that every string matched by this pattern starts
+   * with. This is empty if the pattern starts with a wildcard.
+   */
+  folly::StringPiece getLiteralPrefix() const;
+
+  /**
+   * Returns literal text that every string matched by this pattern ends with.
+   * This is empty if the pattern ends with a wildcard.
+   */
+  folly::StringPiece getLiteralSuffix() const;
+
  private:
-  explicit GlobMatcher(std::vector<uint8_t> pattern);
+  GlobMatcher(
+      std::vector<uint8_t> pattern,
+      size_t suffixIdx,
+      uint8_t suffixLength);
 
   static folly::Expected<size_t, std::string> parseBracketExpr(
       folly::StringPiece glob,
@@ -116,6 +139,13 @@ class GlobMatcher {
    * rather than heap-allocating them in a vector.
    */
   std::vector<uint8_t> pattern_;
+
+  /**
+   * The location of the literal suffix of the pattern within pattern_.
+   */
+  size_t suffixIdx_{0};
+  uint8_t suffixLength_{0};
+  bool isLiteral_{false};
 };
 
 } // namespace facebook::eden
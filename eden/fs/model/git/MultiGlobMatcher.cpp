@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/MultiGlobMatcher.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+size_t MultiGlobMatcher::add(GlobMatcher matcher) {
+  auto idx = matchers_.size();
+  if (matcher.isLiteral()) {
+    literals_[matcher.getLiteralPrefix().str()].push_back(idx);
+  } else if (auto suffix = matcher.getLiteralSuffix(); !suffix.empty()) {
+    suffixes_[suffix.str()].push_back(idx);
+    if (std::find(
+            suffixLengths_.begin(), suffixLengths_.end(), suffix.size()) ==
+        suffixLengths_.end()) {
+      suffixLengths_.push_back(suffix.size());
+    }
+  } else if (auto prefix = matcher.getLiteralPrefix(); !prefix.empty()) {
+    prefixes_[prefix[0]].push_back(idx);
+  } else {
+    others_.push_back(idx);
+  }
+  matchers_.push_back(std::move(matcher));
+  return idx;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <string>
+#include <vector>
+
+#include "eden/fs/model/git/GlobMatcher.h"
+
+namespace facebook::eden {
+
+/**
+ * MultiGlobMatcher matches text against a set of glob patterns at once.
+ *
+ * Matching a set of patterns one by one costs time proportional to the number
+ * of patterns.  Instead, MultiGlobMatcher indexes them by their literal parts
+ * when they are added: patterns without wildcards are looked up by their
+ * text, patterns ending in literal text (like "*.cpp") are looked up by the
+ * end of the matched text, and patterns starting with literal text are only
+ * tried on text starting with its first character.  Only the remaining
+ * patterns are tried on every text.
+ */
+class MultiGlobMatcher {
+ public:
+  /**
+   * Add a pattern, and return the index that match() reports it by.
+   * Indices are assigned in increasing order, starting from 0.
+   */
+  size_t add(GlobMatcher matcher);
+
+  bool empty() const {
+    return matchers_.empty();
+  }
+
+  /**
+   * Call onMatch(index) for each pattern matching `text`, in no particular
+   * order.
+   */
+  template <typename Func>
+  void match(folly::StringPiece text, Func&& onMatch) const {
+    forEachCandidate(text, [&](size_t idx) {
+      if (matchers_[idx].match(text)) {
+        onMatch(idx);
+      }
+      return true;
+    });
+  }
+
+  /**
+   * Returns true if any of the patterns matches `text`.
+   */
+  bool matchesAny(folly::StringPiece text) const {
+    bool matched = false;
+    forEachCandidate(text, [&](size_t idx) {
+      matched = matchers_[idx].match(text);
+      return !matched;
+    });
+    return matched;
+  }
+
+ private:
+  /**
+   * Call func(index) for each pattern whose literal parts are compatible with
+   * `text`, until it returns false.
+   */
+  template <typename Func>
+  void forEachCandidate(folly::StringPiece text, Func&& func) const {
+    auto tryAll = [&](const std::vector<size_t>& indices) {
+      for (auto idx : indices) {
+        if (!func(idx)) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    if (!literals_.empty()) {
+      if (auto it = literals_.find(text); it != literals_.end()) {
+        if (!tryAll(it->second)) {
+          return;
+        }
+      }
+    }
+    for (auto length : suffixLengths_) {
+      if (length <= text.size()) {
+        auto it = suffixes_.find(text.subpiece(text.size() - length));
+        if (it != suffixes_.end() && !tryAll(it->second)) {
+          return;
+        }
+      }
+    }
+    if (!text.empty()) {
+      if (auto it = prefixes_.find(text[0]); it != prefixes_.end()) {
+        for (auto idx : it->second) {
+          if (text.startsWith(matchers_[idx].getLiteralPrefix()) &&
+              !func(idx)) {
+            return;
+          }
+        }
+      }
+    }
+    tryAll(others_);
+  }
+
+  std::vector<GlobMatcher> matchers_;
+  /// Patterns without wildcards, by their text.
+  folly::F14FastMap<std::string, std::vector<size_t>> literals_;
+  /// Patterns with a literal suffix, by that suffix.
+  folly::F14FastMap<std::string, std::vector<size_t>> suffixes_;
+  /// The distinct lengths of the keys of suffixes_.
+  std::vector<size_t> suffixLengths_;
+  /// Other patterns with a literal prefix, by its first character.
+  folly::F14FastMap<char, std::vector<size_t>> prefixes_;
+  /// Patterns without any literal prefix or suffix.
+  std::vector<size_t> others_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(const std::string& name) {
+  return ObjectId::sha1(name);
+}
+} // namespace
+
+TEST(GitIgnoreCache, sharesParsedFiles) {
+  GitIgnoreCache cache{10};
+  EXPECT_EQ(nullptr, cache.get(makeId("a")));
+
+  auto inserted = cache.insert(makeId("a"), "*.o\n");
+  auto cached = cache.get(makeId("a"));
+  EXPECT_EQ(inserted, cached);
+  EXPECT_EQ(
+      GitIgnore::EXCLUDE,
+      cached->match(RelativePathPiece{"main.o"}, GitIgnore::TYPE_FILE));
+}
+
+TEST(GitIgnoreCache, evictsLeastRecentlyUsed) {
+  GitIgnoreCache cache{2};
+  cache.insert(makeId("a"), "a\n");
+  cache.insert(makeId("b"), "b\n");
+  EXPECT_NE(nullptr, cache.get(makeId("a")));
+  cache.insert(makeId("c"), "c\n");
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_NE(nullptr, cache.get(makeId("a")));
+  EXPECT_EQ(nullptr, cache.get(makeId("b")));
+  EXPECT_NE(nullptr, cache.get(makeId("c")));
+}
@@ -668,3 +668,39 @@ TEST(GitIgnore, directory) {
   // path known to be a file.  It expects ignored directories earlier in the
   // path to have already been filtered out.
 }
+
+TEST(GitIgnore, literalAndSuffixPrecedence) {
+  GitIgnore ignore;
+  // Literal and "*.ext" patterns are looked up by name, but must still follow
+  // the same last-match-wins order as every other pattern.
+  ignore.loadFile(
+      "*.o\n"
+      "!keep.o\n"
+      "build\n"
+      "b*d\n"
+      "!build\n"
+      "*.tar.gz\n"
+      "!*.gz\n"
+      "core\n"
+      "!co?e\n"
+      "*.log/\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "main.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "src/main.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, ".o");
+  EXPECT_IGNORE(ignore, INCLUDE, "keep.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "build");
+  EXPECT_IGNORE(ignore, EXCLUDE, "bad");
+  EXPECT_IGNORE(ignore, INCLUDE, "release.tar.gz");
+  EXPECT_IGNORE(ignore, INCLUDE, "core");
+  EXPECT_IGNORE(ignore, INCLUDE, "code");
+  EXPECT_IGNORE(ignore, NO_MATCH, "debug.log");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "debug.log");
+  EXPECT_IGNORE(ignore, NO_MATCH, "o");
+  EXPECT_IGNORE(ignore, NO_MATCH, "main.c");
+
+  // Reloading replaces the indexed patterns too.
+  ignore.loadFile("*.c\n");
+  EXPECT_IGNORE(ignore, NO_MATCH, "main.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "main.c");
+}
@@ -12,6 +12,7 @@
 
 #include <folly/String.h>
 
+#include "eden/fs/model/CompactTree.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
@@ -160,6 +161,27 @@ TEST(GitTree, deserializeEmpty) {
   EXPECT_EQ(0, tree->getTreeEntries().size());
 }
 
+TEST(GitTree, deserializeCompactMatchesTree) {
+  auto gitTreeObject = folly::to<string>(
+      string("tree 69\x00", 8),
+      string("100644 README.md\x00", 17),
+      toBinaryHash("c66788d87933862e2111a86304b705dd90bbd427"),
+      string("40000 build\x00", 12),
+      toBinaryHash("de0b8287939193ed239834991be65b96cbfc4508"));
+  auto hash = ObjectId::sha1(gitTreeObject);
+
+  auto tree = deserializeGitTree(hash, StringPiece(gitTreeObject));
+  auto compact = deserializeGitCompactTree(hash, StringPiece(gitTreeObject));
+  EXPECT_EQ(hash, compact->getHash());
+  ASSERT_EQ(tree->getTreeEntries().size(), compact->size());
+  for (size_t i = 0; i < compact->size(); ++i) {
+    EXPECT_EQ(tree->getTreeEntries()[i], (*compact)[i].toTreeEntry());
+  }
+
+  EXPECT_ANY_THROW(
+      deserializeGitCompactTree(hash, StringPiece("tree 1\x00x", 8)));
+}
+
 TEST(GitTree, testBadDeserialize) {
   ObjectId zero = ObjectId::fromHex("0000000000000000000000000000000000000000");
   // Partial header
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/MultiGlobMatcher.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using folly::StringPiece;
+
+namespace {
+GlobMatcher compile(StringPiece glob, GlobOptions options) {
+  auto matcher = GlobMatcher::create(glob, options);
+  if (matcher.hasError()) {
+    throw std::invalid_argument(matcher.error());
+  }
+  return std::move(matcher).value();
+}
+} // namespace
+
+TEST(GlobMatcher, literalPrefixAndSuffix) {
+  auto options = GlobOptions::DEFAULT;
+  EXPECT_TRUE(compile("BUCK", options).isLiteral());
+  EXPECT_EQ("BUCK", compile("BUCK", options).getLiteralPrefix());
+  EXPECT_EQ("BUCK", compile("BUCK", options).getLiteralSuffix());
+  EXPECT_FALSE(compile("*.cpp", options).isLiteral());
+  EXPECT_EQ("", compile("*.cpp", options).getLiteralPrefix());
+  EXPECT_EQ(".cpp", compile("*.cpp", options).getLiteralSuffix());
+  EXPECT_EQ(
+      ".py",
+      compile("**/*.py", GlobOptions::IGNORE_DOTFILES).getLiteralSuffix());
+  EXPECT_EQ("foo", compile("foo*bar", options).getLiteralPrefix());
+  EXPECT_EQ("bar", compile("foo*bar", options).getLiteralSuffix());
+  EXPECT_EQ("a", compile("a?c", options).getLiteralPrefix());
+  EXPECT_EQ("c", compile("a?c", options).getLiteralSuffix());
+  EXPECT_EQ("src/", compile("src/**", options).getLiteralPrefix());
+  EXPECT_EQ("", compile("src/**", options).getLiteralSuffix());
+  EXPECT_EQ("", compile("[ab]*", options).getLiteralPrefix());
+  EXPECT_EQ("", compile("[ab]*", options).getLiteralSuffix());
+}
+
+TEST(MultiGlobMatcher, matchesLikeEachPattern) {
+  std::vector<std::pair<StringPiece, GlobOptions>> globs{
+      {"BUCK", GlobOptions::DEFAULT},
+      {"TARGETS", GlobOptions::DEFAULT},
+      {"*.cpp", GlobOptions::DEFAULT},
+      {"*.h", GlobOptions::IGNORE_DOTFILES},
+      {"test_*.py", GlobOptions::DEFAULT},
+      {"*_test.py", GlobOptions::DEFAULT},
+      {"a?c", GlobOptions::DEFAULT},
+      {"src/**", GlobOptions::DEFAULT},
+      {"**/*.py", GlobOptions::IGNORE_DOTFILES},
+      {"[ab]*", GlobOptions::DEFAULT},
+      {"*", GlobOptions::IGNORE_DOTFILES},
+  };
+  std::vector<GlobMatcher> matchers;
+  MultiGlobMatcher multi;
+  for (const auto& [glob, options] : globs) {
+    matchers.push_back(compile(glob, options));
+    EXPECT_EQ(matchers.size() - 1, multi.add(compile(glob, options)));
+  }
+
+  for (StringPiece text :
+       {"",
+        "BUCK",
+        "BUCK.v2",
+        "TARGETS",
+        "main.cpp",
+        ".cpp",
+        "foo.h",
+        ".h",
+        "test_a.py",
+        "a_test.py",
+        "abc",
+        "ac",
+        "src/lib/x.c",
+        "lib/x.py",
+        "lib/.x.py",
+        "b",
+        ".hidden"}) {
+    SCOPED_TRACE(text);
+    std::vector<size_t> expected;
+    for (size_t idx = 0; idx < matchers.size(); ++idx) {
+      if (matchers[idx].match(text)) {
+        expected.push_back(idx);
+      }
+    }
+    std::vector<size_t> actual;
+    multi.match(text, [&](size_t idx) { actual.push_back(idx); });
+    EXPECT_THAT(actual, testing::UnorderedElementsAreArray(expected));
+    EXPECT_EQ(!expected.empty(), multi.matchesAny(text));
+  }
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/CompactTree.h"
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+ObjectId makeId(uint8_t byte) {
+  Hash20::Storage bytes;
+  bytes.fill(byte);
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+Tree makeTree(size_t numEntries, bool withMetadata) {
+  std::vector<TreeEntry> entries;
+  for (size_t i = 0; i < numEntries; ++i) {
+    auto name = fmt::format("a_reasonably_long_file_name_{:05}.cpp", i);
+    auto type = i % 4 == 0 ? TreeEntryType::TREE : TreeEntryType::REGULAR_FILE;
+    if (withMetadata && i % 2 == 1) {
+      entries.emplace_back(
+          makeId(static_cast<uint8_t>(i)),
+          PathComponent{name},
+          type,
+          i * 10,
+          Hash20::sha1(name));
+    } else {
+      entries.emplace_back(
+          makeId(static_cast<uint8_t>(i)), PathComponent{name}, type);
+    }
+  }
+  return Tree{std::move(entries), makeId(0xff)};
+}
+
+} // namespace
+
+TEST(CompactTree, roundTrip) {
+  for (bool withMetadata : {false, true}) {
+    auto tree = makeTree(100, withMetadata);
+    CompactTree compact{tree};
+    EXPECT_EQ(tree.getHash(), compact.getHash());
+    ASSERT_EQ(tree.getTreeEntries().size(), compact.size());
+
+    for (size_t i = 0; i < compact.size(); ++i) {
+      auto& expected = tree.getTreeEntries()[i];
+      auto actual = compact[i];
+      EXPECT_EQ(expected.getName(), actual.getName());
+      EXPECT_EQ(expected.getHash().getBytes(), actual.getHashBytes());
+      EXPECT_EQ(expected.getSize(), actual.getSize());
+      EXPECT_EQ(expected.getContentSha1(), actual.getContentSha1());
+    }
+
+    auto rebuilt = compact.toTree();
+    EXPECT_EQ(tree, *rebuilt);
+    for (size_t i = 0; i < compact.size(); ++i) {
+      EXPECT_EQ(
+          tree.getTreeEntries()[i].getSize(),
+          rebuilt->getTreeEntries()[i].getSize());
+      EXPECT_EQ(
+          tree.getTreeEntries()[i].getContentSha1(),
+          rebuilt->getTreeEntries()[i].getContentSha1());
+    }
+  }
+}
+
+TEST(CompactTree, emptyTree) {
+  Tree tree{{}, makeId(1)};
+  CompactTree compact{tree};
+  EXPECT_EQ(0, compact.size());
+  EXPECT_EQ(tree, *compact.toTree());
+}
+
+TEST(CompactTree, smallerThanTree) {
+  auto tree = makeTree(1000, false);
+  CompactTree compact{tree};
+  EXPECT_LT(compact.getSizeBytes() * 3, tree.getSizeBytes() * 2);
+}
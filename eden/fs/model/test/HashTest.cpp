@@ -165,6 +165,19 @@ TEST(Hash20, ensureStringConstructorRejectsArgumentBadCharacters) {
       std::invalid_argument);
 }
 
+TEST(Hash20, fromHexMatchesConstexprConstructor) {
+  EXPECT_EQ(
+      Hash20("faceb00cdeadbeefc00010ff1badb0028badf00d"),
+      Hash20::fromHex("faceb00cdeadbeefc00010ff1badb0028badf00d"));
+  EXPECT_EQ(
+      Hash20("faceb00cdeadbeefc00010ff1badb0028badf00d"),
+      Hash20::fromHex("FACEB00CDEADBEEFC00010FF1BADB0028BADF00D"));
+  EXPECT_THROW(Hash20::fromHex("badfood"), std::invalid_argument);
+  EXPECT_THROW(
+      Hash20::fromHex("faceb00cdeadbeefc00010ff1badb0028badf00Z"),
+      std::invalid_argument);
+}
+
 TEST(Hash20, sha1IOBuf) {
   // Test computing the SHA1 of data spread across an IOBuf chain
   auto buf1 = IOBuf::create(50);
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/ObjectId.h"
+
+#include <folly/String.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using folly::StringPiece;
+
+namespace {
+// One ID that fits inline and one that doesn't, sharing a prefix.
+const std::string kShort(ObjectId::kInlineSize, 'a');
+const std::string kLong = kShort + "b";
+} // namespace
+
+TEST(ObjectId, defaultIsEmpty) {
+  EXPECT_EQ(0, ObjectId{}.size());
+  EXPECT_EQ(ObjectId{}, ObjectId{StringPiece{""}});
+}
+
+TEST(ObjectId, holdsBytes) {
+  for (const auto& bytes : {std::string{"\0\xff", 2}, kShort, kLong}) {
+    ObjectId id{StringPiece{bytes}};
+    EXPECT_EQ(bytes.size(), id.size());
+    EXPECT_EQ(bytes, id.asString());
+    EXPECT_EQ(bytes[1], id[1]);
+  }
+}
+
+TEST(ObjectId, fromHex) {
+  EXPECT_EQ("\x01\xab", ObjectId::fromHex("01AB").asString());
+  EXPECT_EQ(kLong, ObjectId::fromHex(folly::hexlify(kLong)).asString());
+  EXPECT_THROW(ObjectId::fromHex("abc"), std::invalid_argument);
+  EXPECT_THROW(ObjectId::fromHex("zz"), std::invalid_argument);
+}
+
+TEST(ObjectId, compare) {
+  for (const auto& bytes : {kShort, kLong}) {
+    ObjectId a{StringPiece{bytes}};
+    ObjectId b{StringPiece{bytes}};
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.getHashCode(), b.getHashCode());
+  }
+
+  ObjectId shortId{StringPiece{kShort}};
+  ObjectId longId{StringPiece{kLong}};
+  EXPECT_NE(shortId, longId);
+  EXPECT_LT(shortId, longId);
+  EXPECT_LT(ObjectId{StringPiece{"ab"}}, ObjectId{StringPiece{"b"}});
+  // Bytes compare as unsigned.
+  EXPECT_LT(ObjectId{StringPiece{"\x01"}}, ObjectId{StringPiece{"\xff"}});
+}
+
+TEST(ObjectId, copyAndMove) {
+  for (const auto& bytes : {kShort, kLong}) {
+    ObjectId original{StringPiece{bytes}};
+    ObjectId copy{original};
+    EXPECT_EQ(original, copy);
+
+    ObjectId moved{std::move(copy)};
+    EXPECT_EQ(original, moved);
+    EXPECT_EQ(ObjectId{}, copy);
+
+    copy = moved;
+    EXPECT_EQ(original, copy);
+    copy = ObjectId{StringPiece{"x"}};
+    EXPECT_EQ("x", copy.asString());
+    copy = std::move(moved);
+    EXPECT_EQ(original, copy);
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/SerializedTreeView.h"
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+ObjectId makeId(uint8_t byte) {
+  Hash20::Storage bytes;
+  bytes.fill(byte);
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+Tree makeTree(size_t numEntries) {
+  std::vector<TreeEntry> entries;
+  for (size_t i = 0; i < numEntries; ++i) {
+    // Zero padding keeps the names in sorted order.
+    auto name = fmt::format("entry{:05}", i);
+    if (i % 3 == 0) {
+      entries.emplace_back(
+          makeId(static_cast<uint8_t>(i)),
+          PathComponent{name},
+          TreeEntryType::TREE);
+    } else {
+      entries.emplace_back(
+          makeId(static_cast<uint8_t>(i)),
+          PathComponent{name},
+          TreeEntryType::REGULAR_FILE,
+          i * 100,
+          Hash20::sha1(name));
+    }
+  }
+  return Tree{std::move(entries), makeId(0xff)};
+}
+
+} // namespace
+
+TEST(SerializedTreeView, matchesDeserializedTree) {
+  auto tree = makeTree(1000);
+  auto view = SerializedTreeView::tryCreate(tree.getHash(), tree.serialize());
+  ASSERT_TRUE(view);
+  EXPECT_EQ(tree.getHash(), view->getHash());
+  ASSERT_EQ(tree.getTreeEntries().size(), view->size());
+
+  for (size_t i = 0; i < view->size(); ++i) {
+    auto& expected = tree.getTreeEntries()[i];
+    auto actual = (*view)[i];
+    EXPECT_EQ(expected.getName(), actual.getName());
+    EXPECT_EQ(expected.getHash(), actual.getHash());
+    EXPECT_EQ(expected.getType(), actual.getType());
+    EXPECT_EQ(expected.getSize(), actual.getSize());
+    EXPECT_EQ(expected.getContentSha1(), actual.getContentSha1());
+  }
+
+  EXPECT_EQ(tree, *view->toTree());
+}
+
+TEST(SerializedTreeView, find) {
+  auto tree = makeTree(10000);
+  auto view = SerializedTreeView::tryCreate(tree.getHash(), tree.serialize());
+  ASSERT_TRUE(view);
+
+  for (auto& expected : tree.getTreeEntries()) {
+    auto actual = view->find(expected.getName());
+    ASSERT_TRUE(actual) << expected.getName();
+    EXPECT_EQ(expected.getHash(), actual->getHash());
+  }
+
+  EXPECT_FALSE(view->find(PathComponentPiece{"a"}));
+  EXPECT_FALSE(view->find(PathComponentPiece{"entry00000a"}));
+  EXPECT_FALSE(view->find(PathComponentPiece{"zzz"}));
+}
+
+TEST(SerializedTreeView, emptyTree) {
+  Tree tree{{}, makeId(1)};
+  auto view = SerializedTreeView::tryCreate(tree.getHash(), tree.serialize());
+  ASSERT_TRUE(view);
+  EXPECT_TRUE(view->empty());
+  EXPECT_FALSE(view->find(PathComponentPiece{"a"}));
+}
+
+TEST(SerializedTreeView, rejectsCorruptData) {
+  auto tree = makeTree(10);
+  auto buf = tree.serialize();
+  auto data = folly::StringPiece{buf.coalesce()};
+
+  // Truncated in the middle of an entry.
+  EXPECT_FALSE(SerializedTreeView::tryCreate(
+      tree.getHash(),
+      folly::IOBuf{
+          folly::IOBuf::COPY_BUFFER, data.data(), data.size() - 1}));
+
+  // Trailing garbage.
+  auto extended = data.str() + "x";
+  EXPECT_FALSE(SerializedTreeView::tryCreate(
+      tree.getHash(), folly::IOBuf{folly::IOBuf::COPY_BUFFER, extended}));
+
+  // Unknown format version.
+  auto badVersion = data.str();
+  badVersion[0] = 't';
+  EXPECT_FALSE(SerializedTreeView::tryCreate(
+      tree.getHash(), folly::IOBuf{folly::IOBuf::COPY_BUFFER, badVersion}));
+}
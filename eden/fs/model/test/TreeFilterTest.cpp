@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/TreeFilter.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+std::shared_ptr<const Tree> makeTree(
+    folly::StringPiece id,
+    std::vector<std::pair<folly::StringPiece, TreeEntryType>> children) {
+  std::vector<TreeEntry> entries;
+  for (auto [name, type] : children) {
+    entries.emplace_back(
+        ObjectId{fmt::format("{}/{}", id, name)}, PathComponent{name}, type);
+  }
+  return std::make_shared<const Tree>(std::move(entries), ObjectId{id});
+}
+
+TreeFilter makeFilter(std::vector<folly::StringPiece> paths) {
+  std::vector<RelativePath> excluded;
+  for (auto path : paths) {
+    excluded.emplace_back(path);
+  }
+  return TreeFilter{std::move(excluded)};
+}
+} // namespace
+
+TEST(TreeFilter, empty_filter_returns_the_same_tree) {
+  auto tree = makeTree("root", {{"a", TreeEntryType::TREE}});
+  EXPECT_EQ(tree, TreeFilter{}.apply(tree));
+}
+
+TEST(TreeFilter, nested_paths_are_dropped) {
+  auto filter = makeFilter({"a/b/c", "x", "a/b", "a/bb"});
+  std::vector<RelativePath> expected{
+      RelativePath{"a/b"}, RelativePath{"a/bb"}, RelativePath{"x"}};
+  EXPECT_EQ(expected, filter.getExcludedPaths());
+  EXPECT_TRUE(filter.isExcluded(RelativePathPiece{"a/b/d"}));
+  EXPECT_FALSE(filter.isExcluded(RelativePathPiece{"a/bc"}));
+  EXPECT_FALSE(filter.isExcluded(RelativePathPiece{"a"}));
+  EXPECT_THROW(makeFilter({""}), std::invalid_argument);
+}
+
+TEST(TreeFilter, excluded_entries_are_removed) {
+  auto filter = makeFilter({"a/b", "c", "file/x"});
+  auto tree = makeTree(
+      "root",
+      {{"a", TreeEntryType::TREE},
+       {"c", TreeEntryType::TREE},
+       {"d", TreeEntryType::TREE},
+       {"file", TreeEntryType::REGULAR_FILE}});
+  auto filtered = filter.apply(tree);
+
+  const auto& entries = filtered->getTreeEntries();
+  ASSERT_EQ(3, entries.size());
+  EXPECT_EQ("a", entries[0].getName());
+  EXPECT_EQ("d", entries[1].getName());
+  EXPECT_EQ(ObjectId{"root/d"}, entries[1].getHash());
+  EXPECT_EQ("file", entries[2].getName());
+  EXPECT_EQ(ObjectId{"root/file"}, entries[2].getHash());
+
+  auto root = TreeFilter::parseFilteredId(filtered->getHash());
+  ASSERT_TRUE(root.has_value());
+  EXPECT_EQ(ObjectId{"root"}, root->first);
+  EXPECT_EQ(filter, root->second);
+
+  // The subtree containing an excluded path is filtered when it is loaded.
+  auto child = TreeFilter::parseFilteredId(entries[0].getHash());
+  ASSERT_TRUE(child.has_value());
+  EXPECT_EQ(ObjectId{"root/a"}, child->first);
+  EXPECT_EQ(makeFilter({"b"}), child->second);
+  auto filteredChild = child->second.apply(
+      makeTree("root/a", {{"b", TreeEntryType::TREE}}));
+  EXPECT_EQ(entries[0].getHash(), filteredChild->getHash());
+  EXPECT_TRUE(filteredChild->getTreeEntries().empty());
+}
+
+TEST(TreeFilter, other_ids_are_not_filtered) {
+  EXPECT_FALSE(TreeFilter::parseFilteredId(ObjectId{"root"}));
+  std::string hash(20, '\0');
+  hash[0] = '\xf1';
+  EXPECT_FALSE(TreeFilter::parseFilteredId(ObjectId{folly::StringPiece{hash}}));
+}
+
+TEST(TreeFilter, filtered_ids_are_never_20_bytes) {
+  // 1 marker byte, 1 size byte and 16 ID bytes, then "x\0".
+  auto tree = makeTree("0123456789abcdef", {});
+  auto filtered = makeFilter({"x"}).apply(tree);
+  EXPECT_EQ(21, filtered->getHash().size());
+  auto parsed = TreeFilter::parseFilteredId(filtered->getHash());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(tree->getHash(), parsed->first);
+}
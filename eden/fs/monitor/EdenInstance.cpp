@@ -278,10 +278,12 @@ void SpawnedEdenInstance::timeoutExpired() noexcept {
   // major problem in practice.
   SpawnedProcess::Options options;
   options.dup2(
-      FileDescriptor(::dup(log_->fd()), "dup", FileDescriptor::FDType::Generic),
+      FileDescriptor(
+          log_->duplicate().release(), "dup", FileDescriptor::FDType::Generic),
       STDOUT_FILENO);
   options.dup2(
-      FileDescriptor(::dup(log_->fd()), "dup", FileDescriptor::FDType::Generic),
+      FileDescriptor(
+          log_->duplicate().release(), "dup", FileDescriptor::FDType::Generic),
       STDERR_FILENO);
   options.dup2(logPipe_.duplicate(), STDIN_FILENO);
   options.executablePath(AbsolutePathPiece(FLAGS_cat_exe));
@@ -338,15 +340,16 @@ void SpawnedEdenInstance::forwardLogOutput() {
   if (errnum == 0) {
     XLOG(DBG3) << "forwarded " << bytesRead << " log bytes";
   } else {
-    // On a write error we generally still want to keep reading from EdenFS's
-    // output and attempting to write to the log file.
+    // The log file drops output when it has too much queued already, and we
+    // still want to keep reading from EdenFS's output and attempting to write
+    // to the log file.
     //
-    // e.g., if the disk fills up we will get ENOSPC errors while writing logs,
-    // but we still want to keep reading from EdenFS even if we can't write the
-    // log output.  EdenFS will eventually start dropping logs itself if we do
-    // not read them fast enough, but other subprocess that EdenFS spawns, like
-    // hg, may not behave well if we don't consume their stdout/stderr output
-    // quickly.
+    // e.g., if the disk is slow or fills up, the queue will grow while writes
+    // fail or stall, but we still want to keep reading from EdenFS even if we
+    // can't write the log output.  EdenFS will eventually start dropping logs
+    // itself if we do not read them fast enough, but other subprocess that
+    // EdenFS spawns, like hg, may not behave well if we don't consume their
+    // stdout/stderr output quickly.
     //
     // Only try to log about this error every minute, so we don't end up trying
     // to log a lot of messages ourself when the disk is full.
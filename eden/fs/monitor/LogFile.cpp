@@ -9,13 +9,27 @@
 
 #include <fcntl.h>
 
+#include <folly/Conv.h>
 #include <folly/FileUtil.h>
 #include <folly/String.h>
 #include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <vector>
 
 #include "eden/fs/monitor/LogRotation.h"
 
 namespace {
+/**
+ * How much EdenFS output may wait to be written before more is dropped.
+ */
+constexpr size_t kMaxPendingBytes = 64 * 1024 * 1024;
+
+/**
+ * The most iovecs passed to one writev call, which is at least IOV_MAX on
+ * the platforms we support.
+ */
+constexpr size_t kMaxIovecs = 1024;
+
 size_t getFileSize(
     const facebook::eden::AbsolutePath& path,
     const folly::File& file) noexcept {
@@ -42,49 +56,136 @@ LogFile::LogFile(
     size_t maxSize,
     std::unique_ptr<LogRotationStrategy> rotationStrategy)
     : path_{path},
-      log_{path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644},
-      logSize_{getFileSize(path_, log_)},
       maxLogSize_{maxSize},
-      rotationStrategy_{std::move(rotationStrategy)},
-      rotationThread_{[this] { runRotateThread(); }} {
+      rotationStrategy_{std::move(rotationStrategy)} {
+  {
+    auto file = file_.lock();
+    file->log = folly::File{
+        path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644};
+    file->size = getFileSize(path_, file->log);
+  }
   if (rotationStrategy_) {
     rotationStrategy_->init(path_);
   }
+  rotationThread_ = std::thread{[this] { runRotateThread(); }};
+  writerThread_ = std::thread{[this] {
+    folly::setThreadName("LogFileWriter");
+    runWriterThread();
+  }};
 }
 
 LogFile::~LogFile() {
+  // The writer thread writes what is still queued before exiting.
+  pending_.lock()->stop = true;
+  pendingCV_.notify_one();
+  writerThread_.join();
+
   triggerBackgroundRotation(std::nullopt);
   rotationThread_.join();
 }
 
 int LogFile::write(const void* buffer, size_t size) {
-  // Always write the full input buffer, even if it would exceed maxLogSize_.
-  // This reduces the chances of us splitting the log in the middle of a message
-  // (but doesn't guarantee we won't).
-  auto bytesWritten = folly::writeFull(log_.fd(), buffer, size);
-  if (bytesWritten == -1) {
-    return errno;
+  {
+    auto pending = pending_.lock();
+    if (pending->bytes + size > kMaxPendingBytes) {
+      pending->droppedBytes += size;
+      return ENOBUFS;
+    }
+    pending->writes.emplace_back(static_cast<const char*>(buffer), size);
+    pending->bytes += size;
   }
+  pendingCV_.notify_one();
+  return 0;
+}
+
+void LogFile::flush() {
+  auto pending = pending_.lock();
+  drainedCV_.wait(pending.as_lock(), [&] {
+    return pending->writes.empty() && !pending->writing;
+  });
+}
 
-  // Note that our computation of state->size_ only takes into account bytes
-  // that we write to the log file.  If other processes are writing to the log
-  // file we don't account for this.  In general this should still be good
-  // enough for our log rotation accounting purposes.  We don't expect
-  // external processes to be writing lots of data to the EdenFS log file.
-  logSize_ += bytesWritten;
+folly::File LogFile::duplicate() {
+  flush();
+  return file_.lock()->log.dup();
+}
 
-  if (logSize_ >= maxLogSize_) {
-    rotate();
+void LogFile::runWriterThread() {
+  while (true) {
+    std::deque<std::string> writes;
+    {
+      auto pending = pending_.lock();
+      pendingCV_.wait(pending.as_lock(), [&] {
+        return pending->stop || !pending->writes.empty();
+      });
+      if (pending->writes.empty()) {
+        break;
+      }
+      writes.swap(pending->writes);
+      pending->bytes = 0;
+      if (pending->droppedBytes != 0) {
+        writes.push_front(folly::to<std::string>(
+            "\n[edenfs_monitor: dropped ",
+            pending->droppedBytes,
+            " bytes of EdenFS output while the log file fell behind]\n"));
+        pending->droppedBytes = 0;
+      }
+      pending->writing = true;
+    }
+
+    writeToFile(*file_.lock(), writes);
+
+    pending_.lock()->writing = false;
+    drainedCV_.notify_all();
   }
+}
 
-  return 0;
+void LogFile::writeToFile(FileState& file, std::deque<std::string>& writes) {
+  std::vector<iovec> iov;
+  auto it = writes.begin();
+  while (it != writes.end()) {
+    // Gather writes until the file reaches its maximum size. Each write is
+    // written in full even if it exceeds maxLogSize_. This reduces the chances
+    // of us splitting the log in the middle of a message (but doesn't
+    // guarantee we won't).
+    iov.clear();
+    size_t bytes = 0;
+    while (it != writes.end() &&
+           (iov.empty() ||
+            (iov.size() < kMaxIovecs && file.size + bytes < maxLogSize_))) {
+      iov.push_back({it->data(), it->size()});
+      bytes += it->size();
+      ++it;
+    }
+
+    auto bytesWritten =
+        folly::writevFull(file.log.fd(), iov.data(), iov.size());
+    if (bytesWritten == -1) {
+      // Keep trying to write later output. e.g., if the disk fills up we
+      // will get ENOSPC errors, but the disk may get some space back later.
+      //
+      // Only try to log about this error every minute, so we don't end up
+      // trying to log a lot of messages ourself when the disk is full.
+      XLOG_EVERY_MS(ERR, 60000)
+          << "error writing EdenFS log output: " << folly::errnoStr(errno);
+      continue;
+    }
+
+    // Note that our computation of the file size only takes into account
+    // bytes that we write to the log file.  If other processes are writing to
+    // the log file we don't account for this.  In general this should still
+    // be good enough for our log rotation accounting purposes.  We don't
+    // expect external processes to be writing lots of data to the EdenFS log
+    // file.
+    file.size += bytesWritten;
+
+    if (file.size >= maxLogSize_) {
+      rotate(file);
+    }
+  }
 }
 
-void LogFile::rotate() {
-  // Note: we currently do not need synchronization here since edenfs_monitor
-  // runs with a single main thread and performs all logging in this thread.
-  // If we ever changed to logging from multiple threads we would need to add
-  // synchronization here.  e.g., by putting our state in a folly::Synchronized.
+void LogFile::rotate(FileState& file) {
   XLOG(DBG1) << "rotating log file " << path_;
 
   if (!rotationStrategy_) {
@@ -94,7 +195,7 @@ void LogFile::rotate() {
   // Open the new log file.
   folly::File newLog;
   try {
-    newLog = mainThreadRotation();
+    newLog = openNewLogFile();
   } catch (const std::exception& ex) {
     XLOG(ERR) << "failed to rotate log file " << path_ << ": "
               << folly::exceptionStr(ex);
@@ -103,11 +204,11 @@ void LogFile::rotate() {
     return;
   }
 
-  log_ = std::move(newLog);
-  logSize_ = 0;
+  file.log = std::move(newLog);
+  file.size = 0;
 }
 
-folly::File LogFile::mainThreadRotation() {
+folly::File LogFile::openNewLogFile() {
   AbsolutePath newPath;
   try {
     newPath = rotationStrategy_->renameMainLogFile();
@@ -11,6 +11,8 @@
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
 
 #include <folly/File.h>
@@ -23,6 +25,15 @@ namespace eden {
 
 class LogRotationStrategy;
 
+/**
+ * Appends the output of EdenFS to a log file, rotating it once it grows
+ * past its maximum size.
+ *
+ * write() only queues data in memory, and a writer thread appends it to the
+ * file, so that a slow disk never keeps the monitor from draining the EdenFS
+ * output pipe. Compression and cleanup of rotated files happen on another
+ * thread.
+ */
 class LogFile {
  public:
   LogFile(
@@ -32,34 +43,62 @@ class LogFile {
   ~LogFile();
 
   /**
-   * Write data to the log file.
+   * Queue data to be written to the log file.
    *
-   * If the full buffer was successfully written 0 is returned.
-   * Returns an errno value on failure.
+   * Returns 0 if the data was queued, or ENOBUFS if too much data is
+   * waiting to be written already, in which case it is dropped.
    */
   int write(const void* buffer, size_t size);
 
-  int fd() const {
-    return log_.fd();
-  }
+  /**
+   * Wait until all the queued data has been written.
+   */
+  void flush();
+
+  /**
+   * Flush the queued data and return a new descriptor for the current log
+   * file, e.g. for a process to write to it directly.
+   */
+  folly::File duplicate();
 
  private:
   using RotateQueue = std::deque<std::optional<AbsolutePath>>;
 
-  void rotate();
-  folly::File mainThreadRotation();
+  struct PendingWrites {
+    /// The data of each write() call, kept apart to rotate between them.
+    std::deque<std::string> writes;
+    size_t bytes{0};
+    size_t droppedBytes{0};
+    bool writing{false};
+    bool stop{false};
+  };
+
+  struct FileState {
+    folly::File log;
+    size_t size{0};
+  };
+
+  void runWriterThread();
+  void writeToFile(FileState& file, std::deque<std::string>& writes);
+  void rotate(FileState& file);
+  folly::File openNewLogFile();
   void triggerBackgroundRotation(std::optional<AbsolutePath>&& path);
   void runRotateThread();
 
   AbsolutePath const path_;
-  folly::File log_;
-  size_t logSize_{0};
   size_t maxLogSize_{100 * 1024 * 1024};
   std::unique_ptr<LogRotationStrategy> const rotationStrategy_;
 
+  folly::Synchronized<FileState, std::mutex> file_;
+
+  std::condition_variable pendingCV_;
+  std::condition_variable drainedCV_;
+  folly::Synchronized<PendingWrites, std::mutex> pending_;
+
   std::condition_variable rotationCV_;
   folly::Synchronized<RotateQueue, std::mutex> rotationQueue_;
   std::thread rotationThread_;
+  std::thread writerThread_;
 };
 
 } // namespace eden
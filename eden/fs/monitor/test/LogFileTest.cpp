@@ -7,6 +7,7 @@
 
 #include <chrono>
 
+#include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GMock.h>
@@ -68,6 +69,9 @@ TEST(TimestampLogRotation, rotation) {
     for (size_t n = 0; n < 100; ++n) {
       auto msg = folly::to<string>("msg ", n, ": ", data, "\n");
       log.write(msg.data(), msg.size());
+      // Rotation happens on the writer thread, so let it read the clock
+      // before advancing it.
+      log.flush();
       clock->advance(300ms);
     }
   }
@@ -88,6 +92,31 @@ TEST(TimestampLogRotation, rotation) {
           "test.log-20200307.123525.2"));
 }
 
+TEST(LogFile, writesAreAppendedInOrder) {
+  auto tempdir = makeTempDir();
+  auto logPath = AbsolutePath(tempdir.path().native()) + "test.log"_pc;
+
+  string expected;
+  {
+    LogFile log(logPath, 100 * 1024 * 1024, nullptr);
+    for (size_t n = 0; n < 10000; ++n) {
+      auto msg = folly::to<string>("msg ", n, "\n");
+      EXPECT_EQ(0, log.write(msg.data(), msg.size()));
+      expected += msg;
+    }
+    log.flush();
+
+    // The duplicate refers to the same file, after the queued writes.
+    auto dup = log.duplicate();
+    folly::writeFull(dup.fd(), "direct\n", 7);
+    expected += "direct\n";
+  }
+
+  string contents;
+  ASSERT_TRUE(folly::readFile(logPath.c_str(), contents));
+  EXPECT_EQ(expected, contents);
+}
+
 TEST(TimestampLogRotation, removeOldLogFiles) {
   auto tempdir = makeTempDir();
   auto dir = AbsolutePath(tempdir.path().native());
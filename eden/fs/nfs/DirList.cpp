@@ -68,16 +68,20 @@ bool NfsDirList::add(
     // because we don't have access to stat data in this layer. In a
     // separate layer, we will fill in the post_op_attr with the
     // appropriate stat data. For entry3s, we don't need this extra data.
-    EntryT entry = EntryT{ino, name.str(), offset};
+    //
+    // The name is only copied into the entry once it is known to fit, so
+    // that entries that don't aren't allocated for.
+    EntryT entry = EntryT{ino, std::string{}, offset};
 
     // The serialized size includes a boolean indicating that this is not
     // the end of the list.
     neededSize = XdrTrait<EntryT>::serializedSize(entry) +
-        XdrTrait<bool>::serializedSize(true);
+        detail::roundUp(name.size()) + XdrTrait<bool>::serializedSize(true);
 
     if (neededSize > remainingSize) {
       return false;
     }
+    entry.name.assign(name.data(), name.size());
 
     remainingSize -= neededSize;
     list->list.push_back(std::move(entry));
@@ -223,7 +223,9 @@ Mountd::Mountd(
           proc_,
           evb,
           std::move(threadPool),
-          structuredLogger)) {}
+          structuredLogger,
+          // Clients send a single request per connection.
+          /*maxInflightRequestsPerConnection=*/0)) {}
 
 void Mountd::initialize(folly::SocketAddress addr, bool registerWithRpcbind) {
   server_->initialize(addr);
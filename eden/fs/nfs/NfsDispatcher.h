@@ -144,6 +144,14 @@ class NfsDispatcher {
       off_t offset,
       ObjectFetchContext& context) = 0;
 
+  /**
+   * Flush the data written to the file referenced by the InodeNumber ino to
+   * stable storage. When datasync is true, only the file data is flushed,
+   * not its metadata.
+   */
+  virtual ImmediateFuture<folly::Unit>
+  fsync(InodeNumber ino, bool datasync, ObjectFetchContext& context) = 0;
+
   /**
    * Return value of the create method.
    */
@@ -331,6 +339,8 @@ class NfsDispatcher {
     NfsDirList entries;
     /** Has the readdir reached the end of the directory */
     bool isEof;
+    /** Cookie verifier to pass to the readdir calls that continue this one */
+    uint64_t cookieverf;
   };
 
   /**
@@ -340,11 +350,13 @@ class NfsDispatcher {
    * For very large directories, it is possible that more than count bytes are
    * necessary to return all the directory entries. In this case, a subsequent
    * readdir call will be made by the NFS client to restart the enumeration at
-   * offset. The first readdir will have an offset of 0.
+   * offset, with the cookieverf returned by the previous call. The first
+   * readdir will have an offset and a cookieverf of 0.
    */
   virtual ImmediateFuture<ReaddirRes> readdir(
       InodeNumber dir,
       off_t offset,
+      uint64_t cookieverf,
       uint32_t count,
       ObjectFetchContext& context) = 0;
 
@@ -360,6 +372,7 @@ class NfsDispatcher {
   virtual ImmediateFuture<ReaddirRes> readdirplus(
       InodeNumber dir,
       off_t offset,
+      uint64_t cookieverf,
       uint32_t count,
       ObjectFetchContext& context) = 0;
 
@@ -11,8 +11,12 @@
 namespace facebook::eden {
 
 NfsRequestContext::NfsRequestContext(
+    uint64_t requestId,
     uint32_t xid,
     folly::StringPiece causeDetail,
     ProcessAccessLog& processAccessLog)
-    : RequestContext(processAccessLog), xid_(xid), causeDetail_(causeDetail) {}
+    : RequestContext(processAccessLog),
+      requestId_(requestId),
+      xid_(xid),
+      causeDetail_(causeDetail) {}
 } // namespace facebook::eden
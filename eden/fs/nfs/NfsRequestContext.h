@@ -22,6 +22,7 @@ class NfsRequestContext : public RequestContext {
    * The caller is responsible for ensuring this.
    */
   explicit NfsRequestContext(
+      uint64_t requestId,
       uint32_t xid,
       folly::StringPiece causeDetail,
       ProcessAccessLog& processAccessLog);
@@ -35,11 +36,16 @@ class NfsRequestContext : public RequestContext {
     return std::make_optional(causeDetail_);
   }
 
+  std::optional<uint64_t> getRequestId() const override {
+    return requestId_;
+  }
+
   inline uint32_t getXid() const {
     return xid_;
   }
 
  private:
+  uint64_t requestId_;
   uint32_t xid_;
   folly::StringPiece causeDetail_;
 };
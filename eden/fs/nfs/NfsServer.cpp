@@ -9,6 +9,7 @@
 
 #include "eden/fs/nfs/NfsServer.h"
 
+#include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/utils/EdenTaskQueue.h"
@@ -18,6 +19,7 @@ namespace facebook::eden {
 NfsServer::NfsServer(
     folly::EventBase* evb,
     uint64_t numServicingThreads,
+    uint64_t numIoThreads,
     uint64_t maxInflightRequests,
     const std::shared_ptr<StructuredLogger>& structuredLogger)
     : evb_(evb),
@@ -25,6 +27,12 @@ NfsServer::NfsServer(
           numServicingThreads,
           std::make_unique<EdenTaskQueue>(maxInflightRequests),
           std::make_unique<folly::NamedThreadFactory>("NfsThreadPool"))),
+      ioPool_(
+          numIoThreads == 0
+              ? nullptr
+              : std::make_shared<folly::IOThreadPoolExecutor>(
+                    numIoThreads,
+                    std::make_shared<folly::NamedThreadFactory>("NfsIo"))),
       mountd_(evb_, threadPool_, structuredLogger) {}
 
 void NfsServer::initialize(
@@ -48,7 +56,8 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
     folly::Duration requestTimeout,
     std::shared_ptr<Notifier> notifier,
     CaseSensitivity caseSensitive,
-    uint32_t iosize) {
+    uint32_t iosize,
+    size_t maxInflightRequests) {
   auto nfsd = std::make_unique<Nfsd3>(
       evb_,
       threadPool_,
@@ -60,7 +69,9 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
       requestTimeout,
       std::move(notifier),
       caseSensitive,
-      iosize);
+      iosize,
+      maxInflightRequests,
+      ioPool_);
   mountd_.registerMount(path, rootIno);
 
   return {std::move(nfsd), mountd_.getAddr()};
@@ -16,7 +16,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOThreadPoolExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 
@@ -31,7 +32,8 @@ class NfsServer {
    * This will handle the lifetime of the various programs involved in the NFS
    * protocol including mountd and nfsd. The requests will be serviced by a
    * blocking thread pool initialized with numServicingThreads and
-   * maxInflightRequests.
+   * maxInflightRequests. The nfsd connections are read and written on
+   * numIoThreads event base threads, or on evb if it is 0.
    *
    * One mountd program will be created per NfsServer, while one nfsd program
    * will be created per-mount point, this allows nfsd program to be only aware
@@ -40,6 +42,7 @@ class NfsServer {
   NfsServer(
       folly::EventBase* evb,
       uint64_t numServicingThreads,
+      uint64_t numIoThreads,
       uint64_t maxInflightRequests,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
 
@@ -63,7 +66,8 @@ class NfsServer {
    * Register a path as the root of a mount point.
    *
    * This will create an nfs program for that mount point and register it with
-   * the mountd program.
+   * the mountd program. At most maxInflightRequests requests of the nfsd
+   * connection are processed concurrently, 0 meaning no limit.
    *
    * @return: the created nfsd program as well as a tuple that holds the TCP
    * port number that mountd and nfsd are listening to.
@@ -79,7 +83,8 @@ class NfsServer {
       folly::Duration requestTimeout,
       std::shared_ptr<Notifier> notifier,
       CaseSensitivity caseSensitive,
-      uint32_t iosize);
+      uint32_t iosize,
+      size_t maxInflightRequests);
 
   /**
    * Unregister the mount point matching the path.
@@ -90,7 +95,7 @@ class NfsServer {
   void unregisterMount(AbsolutePathPiece path);
 
   /**
-   * Return the EventBase that the various NFS programs are running on.
+   * Return the EventBase that the various NFS programs accept connections on.
    */
   folly::EventBase* getEventBase() const {
     return evb_;
@@ -106,6 +111,8 @@ class NfsServer {
  private:
   folly::EventBase* evb_;
   std::shared_ptr<folly::Executor> threadPool_;
+  // Null when the connections are served on evb_.
+  std::shared_ptr<folly::IOThreadPoolExecutor> ioPool_;
   Mountd mountd_;
 };
 
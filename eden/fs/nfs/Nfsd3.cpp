@@ -39,8 +39,8 @@ namespace facebook::eden {
 
 namespace {
 constexpr size_t kTraceBusCapacity = 25000;
-static_assert(CheckSize<NfsTraceEvent, 40>());
-static_assert(CheckEqual<1000000, kTraceBusCapacity * sizeof(NfsTraceEvent)>());
+static_assert(CheckSize<NfsTraceEvent, 48>());
+static_assert(CheckEqual<1200000, kTraceBusCapacity * sizeof(NfsTraceEvent)>());
 
 class Nfsd3ServerProcessor final : public RpcServerProcessor {
  public:
@@ -559,6 +559,11 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
                 XDCHECK_LE(
                     length, size_t{std::numeric_limits<uint32_t>::max()});
 
+                // For files that aren't materialized, read.data references
+                // the blob contents. Serializing it shares them with the reply
+                // chain, which RpcTcpHandler then writes with a single
+                // writev, so the data is never copied in user space.
+
                 READ3res res{
                     {{nfsstat3::NFS3_OK,
                       READ3resok{
@@ -577,11 +582,14 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
 /**
  * Generate a unique per-EdenFS instance write cookie.
  *
- * TODO(xavierd): Note that for now this will always be 0 as this is to handle
- * the case where the server restart while the client isn't aware.
+ * UNSTABLE writes are only guaranteed to be durable once COMMIT succeeds. A
+ * client that sees this value change between its WRITE and COMMIT replies
+ * knows that EdenFS restarted and that it must re-send its uncommitted data.
  */
 writeverf3 makeWriteVerf() {
-  return 0;
+  static const writeverf3 verf =
+      std::chrono::system_clock::now().time_since_epoch().count();
+  return verf;
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
@@ -597,9 +605,24 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
   queue.append(std::move(args.data));
   auto data = queue.split(args.count);
 
-  return dispatcher_
-      ->write(args.file.ino, std::move(data), args.offset, context)
-      .thenTry([ser = std::move(ser)](
+  // UNSTABLE writes are left in the page cache of the overlay file, which
+  // gathers them until the client sends a COMMIT. Stable writes must be
+  // flushed before replying.
+  auto stable = args.stable;
+  auto ino = args.file.ino;
+  return dispatcher_->write(ino, std::move(data), args.offset, context)
+      .thenValue([this, stable, ino, &context](
+                     NfsDispatcher::WriteRes&& writeRes) {
+        if (stable == stable_how::UNSTABLE) {
+          return ImmediateFuture<NfsDispatcher::WriteRes>{std::move(writeRes)};
+        }
+        return dispatcher_
+            ->fsync(ino, /*datasync=*/stable == stable_how::DATA_SYNC, context)
+            .thenValue([writeRes = std::move(writeRes)](folly::Unit) mutable {
+              return std::move(writeRes);
+            });
+      })
+      .thenTry([ser = std::move(ser), stable](
                    folly::Try<NfsDispatcher::WriteRes> writeTry) mutable {
         if (writeTry.hasException()) {
           WRITE3res res{
@@ -620,12 +643,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
                     /*file_wcc*/ statToWccData(
                         writeRes.preStat, writeRes.postStat),
                     /*count*/ folly::to_narrow(writeRes.written),
-                    // TODO(xavierd): the following is a total lie and we
-                    // should call inode->fdatasync() in the case where
-                    // args.stable is anything other than
-                    // stable_how::UNSTABLE. For testing purpose, this is
-                    // OK.
-                    /*committed*/ stable_how::FILE_SYNC,
+                    /*committed*/ stable,
                     /*verf*/ makeWriteVerf(),
                 }}}};
           XdrTrait<WRITE3res>::serialize(ser, res);
@@ -1069,33 +1087,6 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::link(
           });
 }
 
-/**
- * Verify that the passed in cookie verifier is valid.
- *
- * The verifier allows the server to know whether the directory was modified
- * across readdir calls, and to restart if this is the case.
- *
- * TODO(xavierd): For now, this only checks that the verifier is 0, in the
- * future, we may want to compare it against a global counter that is
- * incremented for each update operations. The assumption being that: "The
- * client should be careful to avoid holding directory entry cookies across
- * operations that modify the directory contents, such as REMOVE and CREATE.",
- * thus we only need to protect against concurrent update and readdir
- * operations since there is only one client per mount.
- */
-bool isReaddirCookieverfValid(uint64_t verf) {
-  return verf == 0;
-}
-
-/**
- * Return the current global cookie.
- *
- * See the documentation above for the meaning of the cookie verifier.
- */
-uint64_t getReaddirCookieverf() {
-  return 0;
-}
-
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -1103,13 +1094,9 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<READDIR3args>::deserialize(deser);
 
-  if (!isReaddirCookieverfValid(args.cookieverf)) {
-    READDIR3res res{{{nfsstat3::NFS3ERR_BAD_COOKIE, READDIR3resfail{}}}};
-    XdrTrait<READDIR3res>::serialize(ser, res);
-    return folly::unit;
-  }
-
-  return dispatcher_->readdir(args.dir.ino, args.cookie, args.count, context)
+  return dispatcher_
+      ->readdir(
+          args.dir.ino, args.cookie, args.cookieverf, args.count, context)
       .thenTry([this, ino = args.dir.ino, ser = std::move(ser), &context](
                    folly::Try<NfsDispatcher::ReaddirRes> try_) mutable {
         return dispatcher_->getattr(ino, context)
@@ -1127,14 +1114,14 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
                     {{nfsstat3::NFS3_OK,
                       READDIR3resok{
                           /*dir_attributes*/ statToPostOpAttr(tryStat),
-                          /*cookieverf*/ getReaddirCookieverf(),
+                          /*cookieverf*/ readdirRes.cookieverf,
                           /*reply*/
                           dirlist3{
                               /*entries*/ readdirRes.entries
                                   .extractList<entry3>(),
                               /*eof*/ readdirRes.isEof,
                           }}}}};
-                XdrTrait<READDIR3res>::serialize(ser, res);
+                serializeReserved(ser, res);
               }
               return folly::unit;
             });
@@ -1148,16 +1135,10 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<READDIRPLUS3args>::deserialize(deser);
 
-  if (!isReaddirCookieverfValid(args.cookieverf)) {
-    READDIRPLUS3res res{
-        {{nfsstat3::NFS3ERR_BAD_COOKIE, READDIRPLUS3resfail{}}}};
-    XdrTrait<READDIRPLUS3res>::serialize(ser, res);
-    return folly::unit;
-  }
-
   // TODO(T107744453): Should probably acount for args.maxcount somewhere
   return dispatcher_
-      ->readdirplus(args.dir.ino, args.cookie, args.dircount, context)
+      ->readdirplus(
+          args.dir.ino, args.cookie, args.cookieverf, args.dircount, context)
       .thenTry([this, ino = args.dir.ino, ser = std::move(ser), &context](
                    folly::Try<NfsDispatcher::ReaddirRes> try_) mutable {
         return dispatcher_->getattr(ino, context)
@@ -1183,14 +1164,14 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
                     {{nfsstat3::NFS3_OK,
                       READDIRPLUS3resok{
                           /*dir_attributes*/ statToPostOpAttr(tryStat),
-                          /*cookieverf*/ getReaddirCookieverf(),
+                          /*cookieverf*/ readdirRes.cookieverf,
                           /*reply*/
                           dirlistplus3{
                               /*entries*/ readdirRes.entries
                                   .extractList<entryplus3>(),
                               /*eof*/ readdirRes.isEof,
                           }}}}};
-                XdrTrait<READDIRPLUS3res>::serialize(ser, res);
+                serializeReserved(ser, res);
               }
               return folly::unit;
             });
@@ -1295,11 +1276,36 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+
+  // The overlay has no notion of partial flushes, thus the offset and count
+  // are ignored and the whole file is flushed.
+  return dispatcher_->fsync(args.file.ino, /*datasync=*/false, context)
+      .thenTry([ser = std::move(ser)](folly::Try<folly::Unit> try_) mutable {
+        if (try_.hasException()) {
+          COMMIT3res res{
+              {{exceptionToNfsError(try_.exception()), COMMIT3resfail{}}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        } else {
+          // TODO(xavierd): Modify fsync to obtain the pre and post stat of
+          // the file.
+          COMMIT3res res{
+              {{nfsstat3::NFS3_OK,
+                COMMIT3resok{
+                    /*file_wcc*/ wcc_data{
+                        /*before*/ pre_op_attr{},
+                        /*after*/ post_op_attr{},
+                    },
+                    /*verf*/ makeWriteVerf(),
+                }}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 NfsArgsDetails formatNull(folly::io::Cursor /*deser*/) {
@@ -1571,9 +1577,15 @@ NfsArgsDetails formatPathconf(folly::io::Cursor deser) {
   return {fmt::format(FMT_STRING("ino={}"), args.object.ino), args.object.ino};
 }
 
-NfsArgsDetails formatCommit(folly::io::Cursor /*deser*/) {
-  // TODO(xavierd): Fill this in.
-  return {""};
+NfsArgsDetails formatCommit(folly::io::Cursor deser) {
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  return {
+      fmt::format(
+          FMT_STRING("ino={}, offset={}, count={}"),
+          args.file.ino,
+          args.offset,
+          args.count),
+      args.file.ino};
 }
 
 using Handler = ImmediateFuture<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -1758,14 +1770,18 @@ struct LiveRequest {
       std::atomic<size_t>& traceDetailedArguments,
       const HandlerEntry& handlerEntry,
       folly::io::Cursor& deser,
+      uint64_t requestId,
       uint32_t xid,
       uint32_t procNumber)
-      : traceBus_{std::move(traceBus)}, xid_{xid}, procNumber_{procNumber} {
+      : traceBus_{std::move(traceBus)},
+        requestId_{requestId},
+        xid_{xid},
+        procNumber_{procNumber} {
     if (traceDetailedArguments.load(std::memory_order_acquire)) {
       traceBus_->publish(NfsTraceEvent::start(
-          xid, procNumber, handlerEntry.formatArgs(deser)));
+          requestId, xid, procNumber, handlerEntry.formatArgs(deser)));
     } else {
-      traceBus_->publish(NfsTraceEvent::start(xid, procNumber));
+      traceBus_->publish(NfsTraceEvent::start(requestId, xid, procNumber));
     }
   }
 
@@ -1774,11 +1790,12 @@ struct LiveRequest {
 
   ~LiveRequest() {
     if (traceBus_) {
-      traceBus_->publish(NfsTraceEvent::finish(xid_, procNumber_));
+      traceBus_->publish(NfsTraceEvent::finish(requestId_, xid_, procNumber_));
     }
   }
 
   std::shared_ptr<TraceBus<NfsTraceEvent>> traceBus_;
+  uint64_t requestId_;
   uint32_t xid_;
   uint32_t procNumber_;
 };
@@ -1823,15 +1840,25 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
       handlerEntry.name,
       handlerEntry.formatArgs(deser).str);
 
+  auto requestId = generateUniqueID();
   auto liveRequest = LiveRequest{
-      traceBus_, traceDetailedArguments_, handlerEntry, deser, xid, procNumber};
+      traceBus_,
+      traceDetailedArguments_,
+      handlerEntry,
+      deser,
+      requestId,
+      xid,
+      procNumber};
 
   // TODO: Add requestMetrics for NFS.
   std::shared_ptr<RequestMetricsScope::LockedRequestWatchList> nullRequestWatch;
   auto context = RequestContext::makeSharedRequestContext<NfsRequestContext>(
-      xid, handlerEntry.name, processAccessLog_);
+      requestId, xid, handlerEntry.name, processAccessLog_);
   context->startRequest(
-      dispatcher_->getStats(), handlerEntry.stat, nullRequestWatch);
+      dispatcher_->getStats(),
+      handlerEntry.stat,
+      handlerEntry.name,
+      nullRequestWatch);
 
   // The data that contextRef reference to is alive for the duration of the
   // handler function and is deleted when context unique_ptr goes out of the
@@ -1884,7 +1911,9 @@ Nfsd3::Nfsd3(
     folly::Duration /*requestTimeout*/,
     std::shared_ptr<Notifier> /*notifier*/,
     CaseSensitivity caseSensitive,
-    uint32_t iosize)
+    uint32_t iosize,
+    size_t maxInflightRequests,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioPool)
     : server_(RpcServer::create(
           std::make_shared<Nfsd3ServerProcessor>(
               std::move(dispatcher),
@@ -1898,7 +1927,9 @@ Nfsd3::Nfsd3(
               traceBus_),
           evb,
           std::move(threadPool),
-          structuredLogger)),
+          structuredLogger,
+          maxInflightRequests,
+          std::move(ioPool))),
       processAccessLog_(std::move(processNameCache)),
       invalidationExecutor_{
           folly::SerialExecutor::create(folly::getGlobalCPUExecutor())},
@@ -1916,7 +1947,11 @@ Nfsd3::Nfsd3(
             // therefore fail. We just ignore duplicated requests.
             (void)state->requests.emplace(
                 event.getXid(),
-                OutstandingRequest{event.getXid(), event.monotonicTime});
+                OutstandingRequest{
+                    event.getXid(),
+                    event.getRequestId(),
+                    event.getProcNumber(),
+                    event.monotonicTime});
             break;
           }
           case NfsTraceEvent::FINISH: {
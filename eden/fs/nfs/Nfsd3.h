@@ -20,7 +20,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOThreadPoolExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 
@@ -49,19 +50,30 @@ struct NfsTraceEvent : TraceEventBase {
 
   NfsTraceEvent() = delete;
 
-  static NfsTraceEvent start(uint32_t xid, uint32_t procNumber) {
+  static NfsTraceEvent
+  start(uint64_t requestId, uint32_t xid, uint32_t procNumber) {
     return NfsTraceEvent{
-        xid, procNumber, StartDetails{std::unique_ptr<NfsArgsDetails>{}}};
+        requestId,
+        xid,
+        procNumber,
+        StartDetails{std::unique_ptr<NfsArgsDetails>{}}};
   }
 
-  static NfsTraceEvent
-  start(uint32_t xid, uint32_t procNumber, NfsArgsDetails&& args) {
+  static NfsTraceEvent start(
+      uint64_t requestId,
+      uint32_t xid,
+      uint32_t procNumber,
+      NfsArgsDetails&& args) {
     return NfsTraceEvent{
-        xid, procNumber, StartDetails{std::make_unique<NfsArgsDetails>(args)}};
+        requestId,
+        xid,
+        procNumber,
+        StartDetails{std::make_unique<NfsArgsDetails>(args)}};
   }
 
-  static NfsTraceEvent finish(uint32_t xid, uint32_t procNumber) {
-    return NfsTraceEvent{xid, procNumber, FinishDetails{}};
+  static NfsTraceEvent
+  finish(uint64_t requestId, uint32_t xid, uint32_t procNumber) {
+    return NfsTraceEvent{requestId, xid, procNumber, FinishDetails{}};
   }
 
   Type getType() const {
@@ -69,6 +81,14 @@ struct NfsTraceEvent : TraceEventBase {
                                                           : Type::FINISH;
   }
 
+  /**
+   * Process-unique, unlike the xid which is chosen by the client. See
+   * ObjectFetchContext::getRequestId.
+   */
+  uint64_t getRequestId() const {
+    return requestId_;
+  }
+
   uint32_t getXid() const {
     return xid_;
   }
@@ -100,9 +120,17 @@ struct NfsTraceEvent : TraceEventBase {
 
   using Details = std::variant<StartDetails, FinishDetails>;
 
-  NfsTraceEvent(uint32_t xid, uint32_t procNumber, Details&& details)
-      : xid_{xid}, procNumber_{procNumber}, details_{std::move(details)} {}
-
+  NfsTraceEvent(
+      uint64_t requestId,
+      uint32_t xid,
+      uint32_t procNumber,
+      Details&& details)
+      : requestId_{requestId},
+        xid_{xid},
+        procNumber_{procNumber},
+        details_{std::move(details)} {}
+
+  uint64_t requestId_;
   uint32_t xid_;
   uint32_t procNumber_;
   Details details_;
@@ -119,8 +147,10 @@ class Nfsd3 {
    * registered with rpcbind, and thus if a real NFS server is running on this
    * host, EdenFS won't be able to register itself.
    *
-   * All the socket processing will be run on the EventBase passed in. This
-   * also must be called on that EventBase thread.
+   * Connections are accepted on the EventBase passed in, and served on it or
+   * on the event bases of ioPool when set. This also must be called on that
+   * EventBase thread. Requests are processed on threadPool, at most
+   * maxInflightRequests of each connection at a time (0 meaning no limit).
    *
    * Note: at mount time, EdenFS will manually call mount.nfs with -o port
    * to manually specify the port on which this server is bound, so registering
@@ -137,7 +167,9 @@ class Nfsd3 {
       folly::Duration requestTimeout,
       std::shared_ptr<Notifier> notifications,
       CaseSensitivity caseSensitive,
-      uint32_t iosize);
+      uint32_t iosize,
+      size_t maxInflightRequests,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioPool = nullptr);
 
   /**
    * This is triggered when the kernel closes the socket. The socket is closed
@@ -203,6 +235,10 @@ class Nfsd3 {
 
   struct OutstandingRequest {
     uint32_t xid;
+    /// See ObjectFetchContext::getRequestId.
+    uint64_t requestId;
+    /// The NFS procedure number.
+    uint32_t procNumber;
     std::chrono::steady_clock::time_point requestStartTime;
   };
 
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/SocketAddress.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
+#include <folly/logging/Init.h>
+#include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
+#include <sysexits.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/telemetry/LatencyHistogram.h"
+
+/*
+ * Replays a mix of NFS procedures against a running NfsServer, over as many
+ * TCP connections as --concurrency, without mounting it through the kernel.
+ * Reports the throughput and latency percentiles of each procedure.
+ *
+ * The files and directories that are looked up, stat'ed and read are the
+ * entries of the directory referenced by --root_ino.
+ */
+
+using namespace facebook::eden;
+
+DEFINE_string(nfsd, "", "The host:port address of the NFS server to load");
+DEFINE_uint64(root_ino, 1, "Inode number of the directory to operate in");
+DEFINE_uint32(concurrency, 8, "Number of connections issuing requests");
+DEFINE_uint32(duration, 10, "Duration of the run, in seconds");
+DEFINE_string(
+    mix,
+    "lookup:40,getattr:40,read:15,readdirplus:5,write:0",
+    "Relative weight of each procedure");
+DEFINE_uint32(read_size, 128 * 1024, "Number of bytes requested by READs");
+DEFINE_uint32(write_size, 4096, "Number of bytes sent by WRITEs");
+DEFINE_string(
+    write_file,
+    "",
+    "Name of the file in the root directory that WRITEs overwrite. Required "
+    "when the mix has writes");
+
+FOLLY_INIT_LOGGING_CONFIG("eden=INFO");
+
+namespace {
+
+enum Procedure : size_t {
+  Lookup,
+  Getattr,
+  Read,
+  Readdirplus,
+  Write,
+  ProcedureCount,
+};
+
+constexpr std::array<folly::StringPiece, ProcedureCount> kProcedureNames{
+    "lookup",
+    "getattr",
+    "read",
+    "readdirplus",
+    "write",
+};
+
+struct Entry {
+  std::string name;
+  nfs_fh3 fh;
+  ftype3 type;
+};
+
+/**
+ * The entries of the root directory, read once before the run.
+ */
+struct Workload {
+  nfs_fh3 root;
+  std::vector<Entry> entries;
+  std::vector<nfs_fh3> files;
+  nfs_fh3 writeFile;
+};
+
+struct ProcedureStats {
+  LatencyHistogram latencies;
+  uint64_t errors{0};
+
+  void merge(const ProcedureStats& other) {
+    latencies.merge(other.latencies);
+    errors += other.errors;
+  }
+};
+
+using Stats = std::array<ProcedureStats, ProcedureCount>;
+
+std::array<double, ProcedureCount> parseMix(folly::StringPiece mix) {
+  std::array<double, ProcedureCount> weights{};
+  std::vector<folly::StringPiece> parts;
+  folly::split(',', mix, parts, /*ignoreEmpty=*/true);
+  for (auto part : parts) {
+    folly::StringPiece name, weight;
+    if (!folly::split(':', part, name, weight)) {
+      throw std::invalid_argument(
+          fmt::format("invalid --mix element: \"{}\"", part));
+    }
+    auto it = std::find(kProcedureNames.begin(), kProcedureNames.end(), name);
+    if (it == kProcedureNames.end()) {
+      throw std::invalid_argument(
+          fmt::format("unknown procedure in --mix: \"{}\"", name));
+    }
+    weights[it - kProcedureNames.begin()] = folly::to<double>(weight);
+  }
+  return weights;
+}
+
+template <class RESP, class REQ>
+RESP call(StreamClient& client, nfsv3Procs proc, const REQ& request) {
+  return client.call<RESP>(
+      kNfsdProgNumber,
+      kNfsd3ProgVersion,
+      folly::to_underlying(proc),
+      request);
+}
+
+READDIRPLUS3args readdirplusArgs(nfs_fh3 dir, uint64_t cookie) {
+  return READDIRPLUS3args{dir, cookie, 0, 64 * 1024, 64 * 1024};
+}
+
+Workload loadWorkload(StreamClient& client) {
+  Workload workload;
+  workload.root = nfs_fh3{InodeNumber{FLAGS_root_ino}};
+
+  uint64_t cookie = 0;
+  while (true) {
+    auto res = call<READDIRPLUS3res>(
+        client,
+        nfsv3Procs::readdirplus,
+        readdirplusArgs(workload.root, cookie));
+    if (res.tag != nfsstat3::NFS3_OK) {
+      throw std::runtime_error(fmt::format(
+          "READDIRPLUS of the root directory failed with {}",
+          folly::to_underlying(res.tag)));
+    }
+    auto& resok = std::get<READDIRPLUS3resok>(res.v);
+    for (auto& entry : resok.reply.entries.list) {
+      cookie = entry.cookie;
+      if (entry.name == "." || entry.name == ".." ||
+          !entry.name_handle.tag || !entry.name_attributes.tag) {
+        continue;
+      }
+      auto fh = std::get<nfs_fh3>(entry.name_handle.v);
+      auto type = std::get<fattr3>(entry.name_attributes.v).type;
+      if (type == ftype3::NF3REG) {
+        workload.files.push_back(fh);
+      }
+      if (entry.name == FLAGS_write_file) {
+        workload.writeFile = fh;
+      }
+      workload.entries.push_back(Entry{std::move(entry.name), fh, type});
+    }
+    if (resok.reply.eof) {
+      break;
+    }
+  }
+  return workload;
+}
+
+/**
+ * Issue a single request and return whether it succeeded.
+ */
+bool runProcedure(
+    StreamClient& client,
+    Procedure procedure,
+    const Workload& workload,
+    std::mt19937& rng) {
+  auto pick = [&rng](const auto& vec) -> const auto& {
+    return vec[std::uniform_int_distribution<size_t>{0, vec.size() - 1}(rng)];
+  };
+
+  switch (procedure) {
+    case Lookup: {
+      const auto& entry = pick(workload.entries);
+      auto res = call<LOOKUP3res>(
+          client,
+          nfsv3Procs::lookup,
+          LOOKUP3args{diropargs3{workload.root, entry.name}});
+      return res.tag == nfsstat3::NFS3_OK;
+    }
+    case Getattr: {
+      const auto& entry = pick(workload.entries);
+      auto res = call<GETATTR3res>(
+          client, nfsv3Procs::getattr, GETATTR3args{entry.fh});
+      return res.tag == nfsstat3::NFS3_OK;
+    }
+    case Read: {
+      auto res = call<READ3res>(
+          client,
+          nfsv3Procs::read,
+          READ3args{pick(workload.files), 0, FLAGS_read_size});
+      return res.tag == nfsstat3::NFS3_OK;
+    }
+    case Readdirplus: {
+      auto res = call<READDIRPLUS3res>(
+          client, nfsv3Procs::readdirplus, readdirplusArgs(workload.root, 0));
+      return res.tag == nfsstat3::NFS3_OK;
+    }
+    case Write: {
+      auto data = folly::IOBuf::create(FLAGS_write_size);
+      memset(data->writableData(), 'a', FLAGS_write_size);
+      data->append(FLAGS_write_size);
+      auto res = call<WRITE3res>(
+          client,
+          nfsv3Procs::write,
+          WRITE3args{
+              workload.writeFile,
+              0,
+              FLAGS_write_size,
+              stable_how::UNSTABLE,
+              std::move(data)});
+      return res.tag == nfsstat3::NFS3_OK;
+    }
+    case ProcedureCount:
+      break;
+  }
+  throw std::logic_error("invalid procedure");
+}
+
+Stats runWorker(
+    folly::SocketAddress addr,
+    const Workload& workload,
+    const std::array<double, ProcedureCount>& weights,
+    std::chrono::steady_clock::time_point deadline,
+    uint32_t seed) {
+  StreamClient client{std::move(addr)};
+  client.connect();
+
+  std::mt19937 rng{seed};
+  std::discrete_distribution<size_t> procedures{weights.begin(), weights.end()};
+  Stats stats;
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto procedure = static_cast<Procedure>(procedures(rng));
+    auto start = std::chrono::steady_clock::now();
+    bool ok = runProcedure(client, procedure, workload, rng);
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    stats[procedure].latencies.record(latency);
+    if (!ok) {
+      ++stats[procedure].errors;
+    }
+  }
+  return stats;
+}
+
+void report(const Stats& stats, std::chrono::duration<double> elapsed) {
+  fmt::print(
+      "{:<12} {:>10} {:>12} {:>10} {:>10} {:>10} {:>10} {:>8}\n",
+      "procedure",
+      "ops",
+      "ops/sec",
+      "p50 (us)",
+      "p90 (us)",
+      "p99 (us)",
+      "max (us)",
+      "errors");
+  for (size_t i = 0; i < ProcedureCount; ++i) {
+    const auto& latencies = stats[i].latencies;
+    if (latencies.count() == 0) {
+      continue;
+    }
+    fmt::print(
+        "{:<12} {:>10} {:>12.1f} {:>10} {:>10} {:>10} {:>10} {:>8}\n",
+        kProcedureNames[i],
+        latencies.count(),
+        latencies.count() / elapsed.count(),
+        latencies.percentile(50).count(),
+        latencies.percentile(90).count(),
+        latencies.percentile(99).count(),
+        latencies.max().count(),
+        stats[i].errors);
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (FLAGS_nfsd.empty() || FLAGS_concurrency == 0) {
+    fprintf(stderr, "usage: nfs_load --nfsd=HOST:PORT [--concurrency=N]\n");
+    return EX_USAGE;
+  }
+
+  auto weights = parseMix(FLAGS_mix);
+  folly::SocketAddress addr;
+  addr.setFromHostPort(FLAGS_nfsd);
+
+  StreamClient client{folly::SocketAddress{addr}};
+  client.connect();
+  auto workload = loadWorkload(client);
+  if (workload.entries.empty()) {
+    fprintf(stderr, "the root directory is empty\n");
+    return EX_DATAERR;
+  }
+  if (workload.files.empty()) {
+    weights[Read] = 0;
+  }
+  if (weights[Write] > 0 && workload.writeFile.ino.empty()) {
+    fprintf(stderr, "--write_file must name a file of the root directory\n");
+    return EX_USAGE;
+  }
+  XLOGF(
+      INFO,
+      "Loading {} with {} connections for {}s over {} entries",
+      FLAGS_nfsd,
+      FLAGS_concurrency,
+      FLAGS_duration,
+      workload.entries.size());
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::seconds{FLAGS_duration};
+  Stats total;
+  std::mutex totalMutex;
+  std::vector<std::thread> workers;
+  for (uint32_t i = 0; i < FLAGS_concurrency; ++i) {
+    workers.emplace_back([&, i] {
+      auto stats = runWorker(addr, workload, weights, deadline, i);
+      std::lock_guard lock{totalMutex};
+      for (size_t p = 0; p < ProcedureCount; ++p) {
+        total[p].merge(stats[p]);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  report(total, std::chrono::steady_clock::now() - start);
+  return EX_OK;
+}
@@ -13,6 +13,7 @@
 
 #include <folly/Exception.h>
 #include <folly/String.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBufQueue.h>
@@ -109,11 +110,13 @@ RpcTcpHandler::RpcTcpHandler(
     AsyncSocket::UniquePtr&& socket,
     std::shared_ptr<folly::Executor> threadPool,
     const std::shared_ptr<StructuredLogger>& structuredLogger,
+    size_t maxInflightRequests,
     std::weak_ptr<RpcServer> owningServer)
     : proc_(proc),
       sock_(std::move(socket)),
       threadPool_(std::move(threadPool)),
       errorLogger_(structuredLogger),
+      maxInflightRequests_(maxInflightRequests),
       reader_(std::make_unique<Reader>(this)),
       state_(sock_->getEventBase()),
       owningServer_(std::move(owningServer)) {
@@ -147,6 +150,14 @@ folly::SemiFuture<folly::Unit> RpcTcpHandler::takeoverStop() {
   // once.
   sock_->setReadCB(nullptr);
 
+  // Requests held back by maxInflightRequests_ were already received, so
+  // process them before handing the socket over. Any reply we did not send
+  // would otherwise be lost.
+  state_.get().readingPaused = false;
+  while (auto buf = readOneRequest()) {
+    dispatchRequest(std::move(buf));
+  }
+
   // Trigger the reader to shutdown now, this will shutdown the handler as well.
   return reader_->deleteMe(RpcStopReason::TAKEOVER);
 }
@@ -224,49 +235,52 @@ std::string displayBuffer(folly::IOBuf* buf) {
 void RpcTcpHandler::tryConsumeReadBuffer() noexcept {
   // Iterate over all the complete fragments and dispatch these to the
   // threadPool_.
-  while (true) {
+  auto& state = state_.get();
+  while (maxInflightRequests_ == 0 ||
+         state.pendingRequests < maxInflightRequests_) {
     auto buf = readOneRequest();
     if (!buf) {
-      break;
+      return;
     }
-    XLOG(DBG7) << "received a request";
-    state_.get().pendingRequests += 1;
-    // Send the work to a thread pool to increase the number of inflight
-    // requests that can be handled concurrently.
-    threadPool_->add(
-        [this, buf = std::move(buf), guard = DestructorGuard(this)]() mutable {
-          XLOG(DBG8) << "Received:\n" << displayBuffer(buf.get());
-          // We use a scope so that the cursor is not still around after we
-          // delete part of the IOBuf later. Attempting to use this cursor
-          // after mutating the buffer could result in bad memory accesses.
-          {
-            folly::io::Cursor c(buf.get());
-            uint32_t fragmentHeader = c.readBE<uint32_t>();
-            bool isLast = (fragmentHeader & 0x80000000) != 0;
-
-            // Supporting multiple fragments is expensive and requires playing
-            // with IOBuf to avoid copying data. Since neither macOS nor Linux
-            // are sending requests spanning multiple segments, let's not
-            // support these.
-            XCHECK(isLast);
-          }
+    dispatchRequest(std::move(buf));
+  }
+
+  // Leave the remaining requests in the socket so that the client, rather
+  // than the threadPool_ queue, absorbs the backlog.
+  if (!state.readingPaused && state.stopReason == RpcStopReason::RUNNING) {
+    XLOG(DBG7) << "Too many pending requests, pausing reads";
+    state.readingPaused = true;
+    sock_->setReadCB(nullptr);
+  }
+}
 
-          // Trim off the fragment header.
-          // We need to upgrade to an IOBufQueue because the IOBuf here is
-          // actually part of a chain. The first buffer in the chain may not
-          // have the full fragment header. Thus we need to be trimming off the
-          // whole chain and not just from the first buffer.
-          //
-          // For example, this IOBuf might be the head of a chain of two IOBufs,
-          // and the first IOBuf only contains 2 bytes. Trimming the IOBuf
-          // would fail in this case.
-          folly::IOBufQueue bufQueue{};
-          bufQueue.append(std::move(buf));
-          bufQueue.trimStart(sizeof(uint32_t));
-
-          dispatchAndReply(bufQueue.move(), std::move(guard));
-        });
+void RpcTcpHandler::maybeResumeReading() noexcept {
+  auto& state = state_.get();
+  if (!state.readingPaused || state.stopReason != RpcStopReason::RUNNING ||
+      state.pendingRequests >= maxInflightRequests_) {
+    return;
   }
+  state.readingPaused = false;
+  // Dispatch what is already buffered first, which may pause reading again.
+  tryConsumeReadBuffer();
+  if (!state.readingPaused) {
+    XLOG(DBG7) << "Resuming reads";
+    sock_->setReadCB(reader_.get());
+  }
+}
+
+void RpcTcpHandler::dispatchRequest(
+    std::unique_ptr<folly::IOBuf> request) noexcept {
+  XLOG(DBG7) << "received a request";
+  state_.get().pendingRequests += 1;
+  // Send the work to a thread pool to increase the number of inflight
+  // requests that can be handled concurrently.
+  threadPool_->add([this,
+                    buf = std::move(request),
+                    guard = DestructorGuard(this)]() mutable {
+    XLOG(DBG8) << "Received:\n" << displayBuffer(buf.get());
+    dispatchAndReply(std::move(buf), std::move(guard));
+  });
 }
 
 std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
@@ -291,7 +305,32 @@ std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
       break;
     }
   }
-  return readBuf_.split(c.getCurrentPosition());
+  auto request = readBuf_.split(c.getCurrentPosition());
+
+  {
+    folly::io::Cursor fragment(request.get());
+    bool isLast = (fragment.readBE<uint32_t>() & 0x80000000) != 0;
+
+    // Supporting multiple fragments is expensive and requires playing
+    // with IOBuf to avoid copying data. Since neither macOS nor Linux
+    // are sending requests spanning multiple segments, let's not
+    // support these.
+    XCHECK(isLast);
+  }
+
+  // Trim off the fragment header.
+  // We need to upgrade to an IOBufQueue because the IOBuf here is
+  // actually part of a chain. The first buffer in the chain may not
+  // have the full fragment header. Thus we need to be trimming off the
+  // whole chain and not just from the first buffer.
+  //
+  // For example, this IOBuf might be the head of a chain of two IOBufs,
+  // and the first IOBuf only contains 2 bytes. Trimming the IOBuf
+  // would fail in this case.
+  folly::IOBufQueue bufQueue{};
+  bufQueue.append(std::move(request));
+  bufQueue.trimStart(sizeof(uint32_t));
+  return bufQueue.move();
 }
 
 namespace {
@@ -473,6 +512,7 @@ void RpcTcpHandler::dispatchAndReply(
             }
           }
         }
+        this->maybeResumeReading();
       });
 }
 
@@ -483,7 +523,12 @@ void RpcServer::RpcAcceptCallback::connectionAccepted(
   XLOG(DBG7) << "Accepted connection from: " << clientAddr;
   auto socket = AsyncSocket::newSocket(evb_, fd);
   auto handler = RpcTcpHandler::create(
-      proc_, std::move(socket), threadPool_, structuredLogger_, owningServer_);
+      proc_,
+      std::move(socket),
+      threadPool_,
+      structuredLogger_,
+      maxInflightRequestsPerConnection_,
+      owningServer_);
 
   if (auto server = owningServer_.lock()) {
     server->registerRpcHandler(std::move(handler));
@@ -531,38 +576,65 @@ std::shared_ptr<RpcServer> RpcServer::create(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
-    const std::shared_ptr<StructuredLogger>& structuredLogger) {
+    const std::shared_ptr<StructuredLogger>& structuredLogger,
+    size_t maxInflightRequestsPerConnection,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioPool) {
   return std::shared_ptr<RpcServer>{new RpcServer{
-      std::move(proc), evb, std::move(threadPool), structuredLogger}};
+      std::move(proc),
+      evb,
+      std::move(threadPool),
+      structuredLogger,
+      maxInflightRequestsPerConnection,
+      std::move(ioPool)}};
 }
 
 RpcServer::RpcServer(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
-    const std::shared_ptr<StructuredLogger>& structuredLogger)
+    const std::shared_ptr<StructuredLogger>& structuredLogger,
+    size_t maxInflightRequestsPerConnection,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioPool)
     : evb_(evb),
+      ioPool_(std::move(ioPool)),
       threadPool_(threadPool),
       structuredLogger_(structuredLogger),
-      acceptCb_(nullptr),
+      maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
       serverSocket_(new AsyncServerSocket(evb_)),
       proc_(std::move(proc)),
       rpcTcpHandlers_{} {}
 
-void RpcServer::initialize(folly::SocketAddress addr) {
-  acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-      proc_,
-      evb_,
-      threadPool_,
-      structuredLogger_,
-      std::weak_ptr<RpcServer>{shared_from_this()}});
+void RpcServer::startAccepting() {
+  std::vector<folly::EventBase*> connectionEvbs;
+  if (ioPool_) {
+    for (auto& ioEvb : ioPool_->getAllEventBases()) {
+      connectionEvbs.push_back(ioEvb.get());
+    }
+  } else {
+    connectionEvbs.push_back(evb_);
+  }
 
+  // The AsyncServerSocket accepts on evb_ and hands the connections out to
+  // its callbacks round-robin, each on its own event base.
+  for (auto* connectionEvb : connectionEvbs) {
+    acceptCbs_.emplace_back(new RpcServer::RpcAcceptCallback{
+        proc_,
+        connectionEvb,
+        threadPool_,
+        structuredLogger_,
+        maxInflightRequestsPerConnection_,
+        std::weak_ptr<RpcServer>{shared_from_this()}});
+    serverSocket_->addAcceptCallback(acceptCbs_.back().get(), connectionEvb);
+  }
+  serverSocket_->startAccepting();
+}
+
+void RpcServer::initialize(folly::SocketAddress addr) {
   // Ask kernel to assign us a port on the loopback interface
   serverSocket_->bind(addr);
   serverSocket_->listen(1024);
 
-  serverSocket_->addAcceptCallback(acceptCb_.get(), evb_);
-  serverSocket_->startAccepting();
+  startAccepting();
 }
 
 void RpcServer::initialize(folly::File&& socket, InitialSocketType type) {
@@ -580,21 +652,15 @@ void RpcServer::initialize(folly::File&& socket, InitialSocketType type) {
               evb_, folly::NetworkSocket::fromFd(socket.release())),
           threadPool_,
           structuredLogger_,
+          maxInflightRequestsPerConnection_,
           shared_from_this()));
       return;
     case InitialSocketType::SERVER_SOCKET:
       XLOG(DBG7) << "Initializing server from server socket: " << socket.fd();
-      acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-          proc_,
-          evb_,
-          threadPool_,
-          structuredLogger_,
-          std::weak_ptr<RpcServer>{shared_from_this()}});
       serverSocket_->useExistingSocket(
           folly::NetworkSocket::fromFd(socket.release()));
 
-      serverSocket_->addAcceptCallback(acceptCb_.get(), evb_);
-      serverSocket_->startAccepting();
+      startAccepting();
       return;
   }
   throw std::runtime_error("Impossible socket type.");
@@ -619,9 +685,9 @@ void RpcServer::unregisterRpcHandler(RpcTcpHandler* handlerToErase) {
 folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   evb_->dcheckIsInEventBaseThread();
 
-  XLOG(DBG7) << "Removing accept callback";
-  if (acceptCb_) {
-    serverSocket_->removeAcceptCallback(acceptCb_.get(), evb_);
+  XLOG(DBG7) << "Removing accept callbacks";
+  for (auto& acceptCb : acceptCbs_) {
+    serverSocket_->removeAcceptCallback(acceptCb.get(), nullptr);
   }
   // implicitly pauses accepting on the socket.
   // not more connections will be made after this point.
@@ -638,7 +704,19 @@ folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   std::vector<folly::SemiFuture<folly::Unit>> futures{};
   futures.reserve(handlers.size());
   for (auto& handler : handlers) {
-    futures.emplace_back(handler->takeoverStop());
+    auto* handlerEvb = handler->getEventBase();
+    if (handlerEvb->isInEventBaseThread()) {
+      futures.emplace_back(handler->takeoverStop());
+    } else {
+      // The handler must be stopped, and released, on the event base that
+      // serves its connection.
+      futures.emplace_back(
+          folly::via(handlerEvb)
+              .thenValue([handler = std::move(handler)](auto&&) mutable {
+                return handler->takeoverStop();
+              })
+              .semi());
+    }
   }
   return collectAll(futures)
       .via(evb_) // make sure we are running on the eventbase to do some more
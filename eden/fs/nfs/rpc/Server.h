@@ -23,7 +23,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOThreadPoolExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 class StructuredLogger;
@@ -100,12 +101,20 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   folly::SemiFuture<folly::Unit> takeoverStop();
 
+  /**
+   * The event base the socket is read and written on.
+   */
+  folly::EventBase* getEventBase() const {
+    return sock_->getEventBase();
+  }
+
  private:
   RpcTcpHandler(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::AsyncSocket::UniquePtr&& socket,
       std::shared_ptr<folly::Executor> threadPool,
       const std::shared_ptr<StructuredLogger>& structuredLogger,
+      size_t maxInflightRequests,
       std::weak_ptr<RpcServer> owningServer);
 
   class Reader : public folly::AsyncReader::ReadCallback {
@@ -153,9 +162,32 @@ class RpcTcpHandler : public folly::DelayedDestruction {
   /**
    * Parse the buffer that was just read from the socket. Complete RPC buffers
    * will be dispatched to the RpcServerProcessor.
+   *
+   * Once maxInflightRequests_ requests are being processed, the remaining
+   * requests are left in readBuf_ and reading from the socket is paused until
+   * some of the requests complete.
+   *
+   * This must be called on the main event base of the socket.
    */
   void tryConsumeReadBuffer() noexcept;
 
+  /**
+   * Dispatch a request to the threadPool_. Its reply is written to the socket
+   * as soon as it completes, regardless of the order in which requests were
+   * received: the client matches replies to requests by XID.
+   *
+   * This must be called on the main event base of the socket.
+   */
+  void dispatchRequest(std::unique_ptr<folly::IOBuf> request) noexcept;
+
+  /**
+   * Resume reading from the socket if it was paused and a request slot is
+   * available again.
+   *
+   * This must be called on the main event base of the socket.
+   */
+  void maybeResumeReading() noexcept;
+
   /**
    * Delete the reader, called when the socket is closed or on takeover.
    *
@@ -167,7 +199,7 @@ class RpcTcpHandler : public folly::DelayedDestruction {
   folly::SemiFuture<folly::Unit> resetReader(RpcStopReason stopReason);
 
   /**
-   * Try to read one request from the buffer.
+   * Try to read one request from the buffer, and strip its record marking.
    *
    * Return a nullptr if no complete RPC request can be read.
    */
@@ -225,6 +257,14 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   std::shared_ptr<StructuredLogger> errorLogger_;
 
+  /**
+   * Maximum number of requests from this connection that are processed
+   * concurrently, or 0 for no limit. Past it, requests queue up in the
+   * socket rather than in the threadPool_, whose queue may block the event
+   * base when full.
+   */
+  const size_t maxInflightRequests_;
+
   /**
    * Reads raw data off the socket.
    */
@@ -248,6 +288,8 @@ class RpcTcpHandler : public folly::DelayedDestruction {
     RpcStopReason stopReason = RpcStopReason::RUNNING;
     // number of requests we are in the middle of processing
     size_t pendingRequests = 0;
+    // whether reading was paused because maxInflightRequests_ was reached
+    bool readingPaused = false;
 
     State() {}
     State(const State& state) = delete;
@@ -296,14 +338,24 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   /**
    * Create an RPC server.
    *
-   * Request will be received on the passed EventBase and dispatched to the
-   * RpcServerProcessor on the passed in threadPool.
+   * Connections will be accepted on the passed EventBase and their requests
+   * dispatched to the RpcServerProcessor on the passed in threadPool. At most
+   * maxInflightRequestsPerConnection requests of each connection are
+   * processed concurrently, 0 meaning no limit.
+   *
+   * When ioPool is set, accepted connections are handed out round-robin to
+   * its event bases, which read, parse and reply to their requests, so that a
+   * client opening several connections is served by several threads.
+   * Otherwise, and for an already connected socket, the connection is served
+   * on evb.
    */
   static std::shared_ptr<RpcServer> create(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
-      const std::shared_ptr<StructuredLogger>& structuredLogger);
+      const std::shared_ptr<StructuredLogger>& structuredLogger,
+      size_t maxInflightRequestsPerConnection,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioPool = nullptr);
 
   ~RpcServer();
 
@@ -326,7 +378,7 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   void registerService(uint32_t progNumber, uint32_t progVersion);
 
   /**
-   * Return the EventBase that this RpcServer is running on.
+   * Return the EventBase that this RpcServer accepts connections on.
    */
   folly::EventBase* getEventBase() const {
     return evb_;
@@ -356,7 +408,15 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
-      const std::shared_ptr<StructuredLogger>& structuredLogger);
+      const std::shared_ptr<StructuredLogger>& structuredLogger,
+      size_t maxInflightRequestsPerConnection,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioPool);
+
+  /**
+   * Create the accept callbacks and register them with serverSocket_, one
+   * for each event base that serves connections.
+   */
+  void startAccepting();
 
   class RpcAcceptCallback : public folly::AsyncServerSocket::AcceptCallback,
                             public folly::DelayedDestruction {
@@ -369,11 +429,13 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
         folly::EventBase* evb,
         std::shared_ptr<folly::Executor> threadPool,
         const std::shared_ptr<StructuredLogger>& structuredLogger,
+        size_t maxInflightRequestsPerConnection,
         std::weak_ptr<RpcServer> owningServer)
         : evb_(evb),
           proc_(proc),
           threadPool_(std::move(threadPool)),
           structuredLogger_(structuredLogger),
+          maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
           owningServer_(std::move(owningServer)),
           guard_(this) {}
 
@@ -393,6 +455,7 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
     std::shared_ptr<RpcServerProcessor> proc_;
     std::shared_ptr<folly::Executor> threadPool_;
     std::shared_ptr<StructuredLogger> structuredLogger_;
+    size_t maxInflightRequestsPerConnection_;
     std::weak_ptr<RpcServer> owningServer_;
 
     /**
@@ -403,18 +466,25 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   };
 
   // main event base that is used for socket interactions. Do not block this
-  // event base, it needs to be available to process incoming reads and writes
-  // on the socket.
+  // event base, it needs to be available to accept connections, and to process
+  // incoming reads and writes on the sockets that are served on it.
   folly::EventBase* evb_;
 
+  // Event bases that accepted connections are served on, when set.
+  std::shared_ptr<folly::IOThreadPoolExecutor> ioPool_;
+
   // Threadpool for processing requests off the main event base.
   std::shared_ptr<folly::Executor> threadPool_;
 
   // Logger for logging anomalous things to Scuba
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
-  // will be called when clients connect to the server socket.
-  RpcAcceptCallback::UniquePtr acceptCb_;
+  // Limit of concurrently processed requests for each connection.
+  size_t maxInflightRequestsPerConnection_;
+
+  // will be called when clients connect to the server socket, on the event
+  // base that each of them serves connections on.
+  std::vector<RpcAcceptCallback::UniquePtr> acceptCbs_;
 
   // listening socket for this server.
   folly::AsyncServerSocket::UniquePtr serverSocket_;
@@ -8,6 +8,7 @@
 #ifndef _WIN32
 
 #include <folly/portability/GTest.h>
+#include "eden/fs/nfs/DirList.h"
 #include "eden/fs/nfs/NfsdRpc.h"
 #include "eden/fs/nfs/testharness/XdrTestUtils.h"
 
@@ -28,6 +29,26 @@ TEST(DirListTest, size) {
   EXPECT_EQ(computeInitialOverhead(), 104);
 }
 
+TEST(DirListTest, entriesFitExactly) {
+  for (size_t nameSize = 1; nameSize <= 9; ++nameSize) {
+    std::string name(nameSize, 'a');
+    auto entrySize = XdrTrait<entryplus3>::serializedSize(
+                         entryplus3{InodeNumber{2}, name, 3}) +
+        XdrTrait<bool>::serializedSize(true);
+    auto count = static_cast<uint32_t>(computeInitialOverhead() + entrySize);
+
+    NfsDirList list{count, nfsv3Procs::readdirplus};
+    EXPECT_TRUE(list.add(name, InodeNumber{2}, 3)) << nameSize;
+    EXPECT_FALSE(list.add(name, InodeNumber{4}, 5)) << nameSize;
+    auto& entries = list.getListRef();
+    ASSERT_EQ(1, entries.size());
+    EXPECT_EQ(name, entries[0].name);
+
+    NfsDirList tooSmall{count - 1, nfsv3Procs::readdirplus};
+    EXPECT_FALSE(tooSmall.add(name, InodeNumber{2}, 3)) << nameSize;
+  }
+}
+
 } // namespace facebook::eden
 
 #endif
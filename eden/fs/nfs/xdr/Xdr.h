@@ -204,6 +204,9 @@ void serialize_variable(
 /**
  * Serialize an IOBuf chain. This is serialized like a variable sized array,
  * ie: size first, followed by the content and aligned on a 4-byte boundary.
+ *
+ * The chain is shared with the output rather than copied into it, except for
+ * buffers small enough to be packed into the output's tailroom.
  */
 void serialize_iobuf(
     folly::io::QueueAppender& appender,
@@ -625,6 +628,21 @@ struct XdrTrait<std::optional<T>> {
   }
 };
 
+/**
+ * Serialize a value into a single allocation sized by its serializedSize(),
+ * rather than growing the output one chunk at a time as it is written.
+ *
+ * This costs a pass over the value to compute its size, so only use it for
+ * replies that may be large, like directory listings. Avoid it for values
+ * holding IOBufs: their contents are shared with the output, not copied, and
+ * would be counted in the reservation.
+ */
+template <typename T>
+void serializeReserved(folly::io::QueueAppender& appender, const T& value) {
+  appender.ensure(XdrTrait<T>::serializedSize(value));
+  XdrTrait<T>::serialize(appender, value);
+}
+
 } // namespace facebook::eden
 
 #endif
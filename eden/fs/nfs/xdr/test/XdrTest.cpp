@@ -139,6 +139,42 @@ TEST(XdrSerialize, iobuf) {
   roundtrip(std::move(buf));
 }
 
+TEST(XdrSerialize, large_iobuf_is_not_copied) {
+  constexpr size_t kSize = 64 * 1024;
+  auto data = folly::IOBuf::create(kSize);
+  data->append(kSize);
+  memset(data->writableData(), 'a', kSize);
+
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender(&queue, 1024);
+  XdrTrait<std::unique_ptr<folly::IOBuf>>::serialize(appender, data);
+  auto serialized = queue.move();
+
+  // The serialized chain references the buffer instead of a copy of it, so
+  // that NFS READ replies can be written straight from blob contents.
+  EXPECT_TRUE(data->isShared());
+  bool found = false;
+  for (auto range : *serialized) {
+    found |= range.data() == data->data() && range.size() == kSize;
+  }
+  EXPECT_TRUE(found);
+  EXPECT_EQ(sizeof(uint32_t) + kSize, serialized->computeChainDataLength());
+}
+
+TEST(XdrSerialize, reserved_is_contiguous) {
+  std::vector<uint8_t> value(16 * 1024, 42);
+
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender(&queue, 1024);
+  serializeReserved(appender, value);
+  auto serialized = queue.move();
+
+  EXPECT_FALSE(serialized->isChained());
+  folly::io::Cursor cursor(serialized.get());
+  EXPECT_EQ(value, XdrTrait<std::vector<uint8_t>>::deserialize(cursor));
+  EXPECT_TRUE(cursor.isAtEnd());
+}
+
 struct ListElement {
   uint32_t value;
 };
@@ -11,7 +11,9 @@
 
 #include <ProjectedFSLib.h> // @manual
 #include <folly/executors/GlobalExecutor.h>
+#include <folly/futures/Future.h>
 #include <folly/portability/Windows.h>
+#include <algorithm>
 
 namespace facebook::eden {
 
@@ -26,6 +28,11 @@ PrjfsDirEntry::PrjfsDirEntry(
           std::move(sizeFuture).semi().via(folly::getGlobalCPUExecutor())},
       isDir_{isDir} {}
 
+PrjfsDirEntry::PrjfsDirEntry(const Ready& ready)
+    : name_{ready.name},
+      sizeFuture_{folly::makeFuture(ready.size)},
+      isDir_{ready.isDir} {}
+
 bool PrjfsDirEntry::matchPattern(const std::wstring& pattern) const {
   return PrjFileNameMatch(name_.c_str(), pattern.c_str());
 }
@@ -43,12 +50,11 @@ bool PrjfsDirEntry::operator<(const PrjfsDirEntry& other) const {
 
 Enumerator::Enumerator(std::vector<PrjfsDirEntry>&& entryList)
     : metadataList_(std::move(entryList)), iter_{metadataList_.begin()} {
-  std::sort(
-      metadataList_.begin(),
-      metadataList_.end(),
-      [](const PrjfsDirEntry& first, const PrjfsDirEntry& second) -> bool {
-        return first < second;
-      });
+  // Listings served from the PrjfsDispatcher cache are already sorted,
+  // checking for it is cheaper than sorting them again.
+  if (!std::is_sorted(metadataList_.begin(), metadataList_.end())) {
+    std::sort(metadataList_.begin(), metadataList_.end());
+  }
 }
 
 void Enumerator::advanceEnumeration() {
@@ -27,6 +27,13 @@ class PrjfsDirEntry {
       bool isDir,
       ImmediateFuture<uint64_t> sizeFuture);
 
+  struct Ready;
+
+  /**
+   * Build an entry whose size is already known.
+   */
+  explicit PrjfsDirEntry(const Ready& ready);
+
   /**
    * An entry whose size future has been resolved.
    */
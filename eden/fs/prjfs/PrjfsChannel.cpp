@@ -10,12 +10,15 @@
 #include "eden/fs/prjfs/PrjfsChannel.h"
 #include <fmt/format.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
+#include <set>
 
 #include "eden/common/utils/StringConv.h"
 #include "eden/common/utils/WinError.h"
 #include "eden/fs/notifications/Notifier.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/prjfs/PrjfsRequestContext.h"
+#include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Guid.h"
 #include "eden/fs/utils/ImmediateFuture.h"
@@ -343,7 +346,8 @@ HRESULT PrjfsChannelInner::startEnumeration(
     auto requestWatch =
         std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
     auto stat = &ChannelThreadStats::openDir;
-    context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->startRequest(
+        dispatcher_->getStats(), stat, "PRJFS_OPENDIR", requestWatch);
 
     FB_LOGF(
         getStraceLogger(), DBG7, "opendir({}, guid={})", path, guid.toString());
@@ -420,7 +424,8 @@ HRESULT PrjfsChannelInner::getEnumerationData(
     auto requestWatch =
         std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
     auto stat = &ChannelThreadStats::readDir;
-    context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->startRequest(
+        dispatcher_->getStats(), stat, "PRJFS_READDIR", requestWatch);
 
     // TODO(xavierd): there is a potential quadratic cost to the following code
     // in the case where the buffer can only hold a single entry. The linear
@@ -496,7 +501,8 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
     auto requestWatch =
         std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
     auto stat = &ChannelThreadStats::lookup;
-    context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->startRequest(
+        dispatcher_->getStats(), stat, "PRJFS_LOOKUP", requestWatch);
 
     FB_LOGF(getStraceLogger(), DBG7, "lookup({})", path);
     return dispatcher_->lookup(std::move(path), context)
@@ -540,6 +546,38 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
   return HRESULT_FROM_WIN32(ERROR_IO_PENDING);
 }
 
+ImmediateFuture<bool> PrjfsChannelInner::writePlaceholder(
+    RelativePath path,
+    std::shared_ptr<ObjectFetchContext> context) {
+  return dispatcher_->lookup(std::move(path), std::move(context))
+      .thenValue([this](std::optional<LookupResult>&& optLookupResult) {
+        if (!optLookupResult) {
+          return false;
+        }
+        const auto& lookupResult = optLookupResult.value();
+
+        PRJ_PLACEHOLDER_INFO placeholderInfo{};
+        placeholderInfo.FileBasicInfo.IsDirectory = lookupResult.isDir;
+        placeholderInfo.FileBasicInfo.FileSize = lookupResult.size;
+        auto inodeName = lookupResult.path.wide();
+
+        HRESULT result = PrjWritePlaceholderInfo(
+            mountChannel_,
+            inodeName.c_str(),
+            &placeholderInfo,
+            sizeof(placeholderInfo));
+        if (FAILED(result)) {
+          XLOGF(
+              DBG6,
+              "Couldn't write a placeholder for {}: {:#x}",
+              lookupResult.path,
+              static_cast<uint32_t>(result));
+          return false;
+        }
+        return true;
+      });
+}
+
 HRESULT PrjfsChannelInner::queryFileName(
     std::shared_ptr<PrjfsRequestContext> context,
     const PRJ_CALLBACK_DATA* callbackData,
@@ -552,7 +590,8 @@ HRESULT PrjfsChannelInner::queryFileName(
     auto requestWatch =
         std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
     auto stat = &ChannelThreadStats::access;
-    context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->startRequest(
+        dispatcher_->getStats(), stat, "PRJFS_ACCESS", requestWatch);
     FB_LOGF(getStraceLogger(), DBG7, "access({})", path);
     return dispatcher_->access(std::move(path), context)
         .thenValue([context = std::move(context)](bool present) {
@@ -669,7 +708,8 @@ HRESULT PrjfsChannelInner::getFileData(
             std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(
                 nullptr);
         auto stat = &ChannelThreadStats::read;
-        context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+        context->startRequest(
+            dispatcher_->getStats(), stat, "PRJFS_READ", requestWatch);
 
         FB_LOGF(
             getStraceLogger(),
@@ -794,12 +834,14 @@ struct NotificationHandlerEntry {
   constexpr NotificationHandlerEntry(
       NotificationHandler h,
       NotificationArgRenderer r,
-      ChannelThreadStats::StatPtr s)
-      : handler{h}, renderer{r}, stat{s} {}
+      ChannelThreadStats::StatPtr s,
+      folly::StringPiece n)
+      : handler{h}, renderer{r}, stat{s}, name{n} {}
 
   NotificationHandler handler;
   NotificationArgRenderer renderer;
   ChannelThreadStats::StatPtr stat;
+  folly::StringPiece name;
 };
 
 std::string newFileCreatedRenderer(
@@ -867,49 +909,57 @@ const std::unordered_map<PRJ_NOTIFICATION, NotificationHandlerEntry>
             PRJ_NOTIFICATION_NEW_FILE_CREATED,
             {&PrjfsChannelInner::newFileCreated,
              newFileCreatedRenderer,
-             &ChannelThreadStats::newFileCreated},
+             &ChannelThreadStats::newFileCreated,
+             "PRJFS_NEW_FILE_CREATED"},
         },
         {
             PRJ_NOTIFICATION_PRE_DELETE,
             {&PrjfsChannelInner::preDelete,
              preDeleteRenderer,
-             &ChannelThreadStats::preDelete},
+             &ChannelThreadStats::preDelete,
+             "PRJFS_PRE_DELETE"},
         },
         {
             PRJ_NOTIFICATION_FILE_OVERWRITTEN,
             {&PrjfsChannelInner::fileOverwritten,
              fileOverwrittenRenderer,
-             &ChannelThreadStats::fileOverwritten},
+             &ChannelThreadStats::fileOverwritten,
+             "PRJFS_FILE_OVERWRITTEN"},
         },
         {
             PRJ_NOTIFICATION_FILE_HANDLE_CLOSED_FILE_MODIFIED,
             {&PrjfsChannelInner::fileHandleClosedFileModified,
              fileHandleClosedFileModifiedRenderer,
-             &ChannelThreadStats::fileHandleClosedFileModified},
+             &ChannelThreadStats::fileHandleClosedFileModified,
+             "PRJFS_FILE_HANDLE_CLOSED_FILE_MODIFIED"},
         },
         {
             PRJ_NOTIFICATION_FILE_RENAMED,
             {&PrjfsChannelInner::fileRenamed,
              fileRenamedRenderer,
-             &ChannelThreadStats::fileRenamed},
+             &ChannelThreadStats::fileRenamed,
+             "PRJFS_FILE_RENAMED"},
         },
         {
             PRJ_NOTIFICATION_PRE_RENAME,
             {&PrjfsChannelInner::preRename,
              preRenameRenderer,
-             &ChannelThreadStats::preRenamed},
+             &ChannelThreadStats::preRenamed,
+             "PRJFS_PRE_RENAME"},
         },
         {
             PRJ_NOTIFICATION_FILE_HANDLE_CLOSED_FILE_DELETED,
             {&PrjfsChannelInner::fileHandleClosedFileDeleted,
              fileHandleClosedFileDeletedRenderer,
-             &ChannelThreadStats::fileHandleClosedFileDeleted},
+             &ChannelThreadStats::fileHandleClosedFileDeleted,
+             "PRJFS_FILE_HANDLE_CLOSED_FILE_DELETED"},
         },
         {
             PRJ_NOTIFICATION_PRE_SET_HARDLINK,
             {&PrjfsChannelInner::preSetHardlink,
              preSetHardlinkRenderer,
-             &ChannelThreadStats::preSetHardlink},
+             &ChannelThreadStats::preSetHardlink,
+             "PRJFS_PRE_SET_HARDLINK"},
         },
 };
 } // namespace
@@ -1022,6 +1072,7 @@ HRESULT PrjfsChannelInner::notification(
     return HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER);
   } else {
     auto stat = it->second.stat;
+    auto name = it->second.name;
     auto handler = it->second.handler;
     auto renderer = it->second.renderer;
 
@@ -1039,7 +1090,7 @@ HRESULT PrjfsChannelInner::notification(
 
     auto requestWatch =
         std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
-    context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->startRequest(dispatcher_->getStats(), stat, name, requestWatch);
 
     FB_LOG(getStraceLogger(), DBG7, renderer(relPath, destPath, isDirectory));
     auto fut = (this->*handler)(
@@ -1274,6 +1325,70 @@ folly::Try<folly::Unit> PrjfsChannel::addDirectoryPlaceholder(
   return folly::Try<folly::Unit>{folly::unit};
 }
 
+namespace {
+/**
+ * Write the placeholders of levels[depth] concurrently, and then those of the
+ * following levels. Each level holds the children of the paths of the
+ * previous one, which must be on disk first.
+ */
+ImmediateFuture<size_t> writePlaceholderLevels(
+    folly::ReadMostlySharedPtr<PrjfsChannelInner> inner,
+    std::shared_ptr<std::vector<std::set<RelativePath>>> levels,
+    size_t depth,
+    std::shared_ptr<ObjectFetchContext> context) {
+  if (depth == levels->size()) {
+    return size_t{0};
+  }
+
+  std::vector<ImmediateFuture<bool>> futures;
+  futures.reserve((*levels)[depth].size());
+  for (const auto& path : (*levels)[depth]) {
+    futures.push_back(inner->writePlaceholder(path, context)
+                          .thenTry([](folly::Try<bool>&& written) {
+                            return written.hasValue() && written.value();
+                          }));
+  }
+  return collectAllSafe(std::move(futures))
+      .thenValue([inner, levels, depth, context](
+                     std::vector<bool>&& written) mutable {
+        auto count = static_cast<size_t>(
+            std::count(written.begin(), written.end(), true));
+        return writePlaceholderLevels(
+                   std::move(inner),
+                   std::move(levels),
+                   depth + 1,
+                   std::move(context))
+            .thenValue([count](size_t rest) { return count + rest; });
+      });
+}
+} // namespace
+
+ImmediateFuture<size_t> PrjfsChannel::writePlaceholders(
+    std::vector<RelativePath> paths) {
+  auto inner = getInner();
+  if (!inner) {
+    return size_t{0};
+  }
+
+  auto levels = std::make_shared<std::vector<std::set<RelativePath>>>();
+  for (const auto& path : paths) {
+    size_t depth = 0;
+    for (auto parent : path.paths()) {
+      if (levels->size() <= depth) {
+        levels->emplace_back();
+      }
+      (*levels)[depth].insert(parent.copy());
+      ++depth;
+    }
+  }
+
+  return writePlaceholderLevels(
+      std::move(inner),
+      std::move(levels),
+      0,
+      std::make_shared<StatsFetchContext>());
+}
+
 void PrjfsChannel::flushNegativePathCache() {
   if (useNegativePathCaching_) {
     XLOG(DBG6) << "Flushing negative path cache";
@@ -339,6 +339,19 @@ class PrjfsChannelInner {
       bool isDirectory,
       std::shared_ptr<ObjectFetchContext> context);
 
+  /**
+   * Write the placeholder of path ahead of time, as if ProjectedFS had asked
+   * for it via the getPlaceholderInfo callback. The parent directory of path
+   * must already be on disk.
+   *
+   * Returns false when path isn't part of the working copy or when the
+   * placeholder couldn't be written, typically because the file is already
+   * on disk.
+   */
+  ImmediateFuture<bool> writePlaceholder(
+      RelativePath path,
+      std::shared_ptr<ObjectFetchContext> context);
+
   ProcessAccessLog& getProcessAccessLog() {
     return processAccessLog_;
   }
@@ -514,6 +527,16 @@ class PrjfsChannel {
 
   void flushNegativePathCache();
 
+  /**
+   * Write placeholders for the given paths and all their parent directories
+   * ahead of time, so that the first traversal of these paths by Explorer or
+   * build tools doesn't have to wait on a callback per path.
+   *
+   * Paths that aren't part of the working copy or that are already on disk
+   * are skipped. Returns the number of placeholders written.
+   */
+  ImmediateFuture<size_t> writePlaceholders(std::vector<RelativePath> paths);
+
   ProcessAccessLog& getProcessAccessLog() {
     return processAccessLog_;
   }
@@ -28,12 +28,18 @@ class PrjfsRequestContext : public RequestContext {
       : RequestContext(channel->getProcessAccessLog()),
         channel_(std::move(channel)),
         commandId_(prjfsData.CommandId),
-        clientPid_(prjfsData.TriggeringProcessId) {}
+        clientPid_(prjfsData.TriggeringProcessId),
+        path_(prjfsData.FilePathName) {}
 
   std::optional<pid_t> getClientPid() const override {
     return clientPid_;
   }
 
+  // Override of `RequestContext`
+  std::string getRequestPath() const override {
+    return path_.value();
+  }
+
   ImmediateFuture<folly::Unit> catchErrors(ImmediateFuture<folly::Unit>&& fut) {
     return std::move(fut).thenTry([this](folly::Try<folly::Unit>&& try_) {
       auto result = tryToHResult(try_);
@@ -68,6 +74,7 @@ class PrjfsRequestContext : public RequestContext {
   folly::ReadMostlySharedPtr<PrjfsChannelInner> channel_;
   int32_t commandId_;
   pid_t clientPid_;
+  RelativePath path_;
 };
 
 } // namespace facebook::eden
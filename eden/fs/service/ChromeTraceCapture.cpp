@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ChromeTraceCapture.h"
+
+#include <thrift/lib/cpp/util/EnumUtils.h>
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/store/hg/HgQueuedBackingStore.h"
+
+#ifndef _WIN32
+#include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/nfs/Nfsd3.h"
+#endif
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kFuseTrack = "FUSE requests";
+constexpr folly::StringPiece kNfsTrack = "NFS requests";
+constexpr folly::StringPiece kHgTrack = "hg imports";
+constexpr folly::StringPiece kCheckoutTrack = "checkout";
+} // namespace
+
+ChromeTraceCapture::ChromeTraceCapture(
+    std::shared_ptr<ProcessNameCache> processNameCache)
+    : processNameCache_{std::move(processNameCache)},
+      captureStart_{std::chrono::steady_clock::now()} {}
+
+#ifndef _WIN32
+void ChromeTraceCapture::observe(const FuseTraceEvent& event) {
+  const auto& request = event.getRequest();
+  switch (event.getType()) {
+    case FuseTraceEvent::START: {
+      folly::dynamic args = folly::dynamic::object("pid", request.pid)(
+          "nodeid", request.nodeid);
+      if (auto name = processNameCache_->getProcessName(request.pid)) {
+        args["process"] = std::move(*name);
+      }
+      if (auto& arguments = event.getArguments()) {
+        args["arguments"] = *arguments;
+      }
+      startRequest(
+          kFuseTrack,
+          event.getUnique(),
+          event.monotonicTime,
+          fuseOpcodeName(request.opcode).str(),
+          std::move(args));
+      break;
+    }
+    case FuseTraceEvent::FINISH: {
+      folly::dynamic args = folly::dynamic::object;
+      if (auto& result = event.getResponseCode()) {
+        args["result"] = *result;
+      }
+      finishRequest(
+          kFuseTrack,
+          event.getUnique(),
+          event.monotonicTime,
+          std::move(args));
+      break;
+    }
+  }
+}
+
+void ChromeTraceCapture::observe(const NfsTraceEvent& event) {
+  switch (event.getType()) {
+    case NfsTraceEvent::START: {
+      folly::dynamic args = folly::dynamic::object("xid", event.getXid());
+      if (auto arguments = event.getArguments()) {
+        args["arguments"] = arguments->str();
+      }
+      startRequest(
+          kNfsTrack,
+          event.getRequestId(),
+          event.monotonicTime,
+          nfsProcName(event.getProcNumber()).str(),
+          std::move(args));
+      break;
+    }
+    case NfsTraceEvent::FINISH:
+      finishRequest(
+          kNfsTrack,
+          event.getRequestId(),
+          event.monotonicTime,
+          folly::dynamic::object);
+      break;
+  }
+}
+#endif
+
+void ChromeTraceCapture::startRequest(
+    folly::StringPiece track,
+    uint64_t unique,
+    TimePoint start,
+    std::string name,
+    folly::dynamic args) {
+  state_.wlock()->fsRequests.insert_or_assign(
+      unique, PendingRequest{track, start, std::move(name), std::move(args)});
+}
+
+void ChromeTraceCapture::finishRequest(
+    folly::StringPiece track,
+    uint64_t unique,
+    TimePoint end,
+    folly::dynamic args) {
+  auto state = state_.wlock();
+  auto it = state->fsRequests.find(unique);
+  if (it == state->fsRequests.end()) {
+    // Started before the capture: we don't know its name.
+    state->fsSlices[unique] = state->trace.addSlice(
+        track.str(), "request", captureStart_, end, std::move(args));
+    return;
+  }
+  auto& pending = it->second;
+  pending.args.update(args);
+  state->fsSlices[unique] = state->trace.addSlice(
+      track.str(), std::move(pending.name), pending.start, end, pending.args);
+  state->fsRequests.erase(it);
+}
+
+void ChromeTraceCapture::observe(const HgImportTraceEvent& event) {
+  auto state = state_.wlock();
+  switch (event.eventType) {
+    case HgImportTraceEvent::QUEUE:
+      state->imports[event.unique] =
+          PendingImport{event.monotonicTime, std::nullopt, event.requestId};
+      break;
+    case HgImportTraceEvent::START: {
+      auto it = state->imports.find(event.unique);
+      if (it == state->imports.end()) {
+        it = state->imports
+                 .emplace(event.unique, PendingImport{captureStart_})
+                 .first;
+      }
+      it->second.started = event.monotonicTime;
+      break;
+    }
+    case HgImportTraceEvent::FINISH: {
+      PendingImport pending{captureStart_};
+      auto it = state->imports.find(event.unique);
+      if (it != state->imports.end()) {
+        pending = it->second;
+        state->imports.erase(it);
+      }
+      auto started = pending.started.value_or(pending.queued);
+      folly::dynamic args = folly::dynamic::object("path", event.getPath())(
+          "node", event.manifestNodeId.toString())(
+          "queued_us",
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              started - pending.queued)
+              .count());
+      auto slice = state->trace.addSlice(
+          kHgTrack.str(),
+          event.resourceType == HgImportTraceEvent::BLOB ? "blob" : "tree",
+          pending.queued,
+          event.monotonicTime,
+          std::move(args));
+      if (pending.requestId != 0) {
+        state->importCauses.emplace_back(pending.requestId, slice);
+      }
+      break;
+    }
+  }
+}
+
+void ChromeTraceCapture::observe(const CheckoutTraceEvent& event) {
+  auto start = event.monotonicTime - event.duration;
+  folly::dynamic args = folly::dynamic::object(
+      "from", event.fromRoot.value())("to", event.toRoot.value())(
+      "mode", apache::thrift::util::enumNameSafe(event.mode))(
+      "success", event.success)("fetched_trees", event.fetchedTrees)(
+      "fetched_blobs", event.fetchedBlobs);
+
+  // The CheckoutTimes are cumulative: each is the time at which a stage
+  // ended. Stages that were not reached are zero.
+  struct Stage {
+    const char* name;
+    std::chrono::steady_clock::duration end;
+  };
+  const Stage stages[] = {
+      {"lookup trees", event.times.didLookupTrees},
+      {"diff", event.times.didDiff},
+      {"acquire rename lock", event.times.didAcquireRenameLock},
+      {"checkout", event.times.didCheckout},
+      {"finish", event.times.didFinish},
+  };
+
+  auto state = state_.wlock();
+  auto stageStart = start;
+  for (const auto& stage : stages) {
+    if (stage.end.count() == 0) {
+      break;
+    }
+    auto stageEnd = start + stage.end;
+    state->trace.addSlice(
+        kCheckoutTrack.str(), stage.name, stageStart, stageEnd, args);
+    stageStart = stageEnd;
+  }
+  if (!event.success) {
+    // A failed checkout: show the rest of it as one slice.
+    state->trace.addSlice(
+        kCheckoutTrack.str(),
+        "failed",
+        stageStart,
+        event.monotonicTime,
+        std::move(args));
+  }
+}
+
+std::string ChromeTraceCapture::finish() {
+  auto end = std::chrono::steady_clock::now();
+  auto state = state_.wlock();
+  for (auto& [unique, pending] : state->fsRequests) {
+    pending.args["unfinished"] = true;
+    state->fsSlices[unique] = state->trace.addSlice(
+        pending.track.str(), pending.name, pending.start, end, pending.args);
+  }
+  state->fsRequests.clear();
+
+  for (auto [requestId, importSlice] : state->importCauses) {
+    auto it = state->fsSlices.find(requestId);
+    if (it != state->fsSlices.end()) {
+      state->trace.addFlow(it->second, importSlice);
+    }
+  }
+  state->importCauses.clear();
+  return state->trace.toJson();
+}
+
+} // namespace facebook::eden
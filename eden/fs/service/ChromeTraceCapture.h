@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include "eden/fs/telemetry/ChromeTrace.h"
+
+namespace facebook::eden {
+
+struct CheckoutTraceEvent;
+struct FuseTraceEvent;
+struct HgImportTraceEvent;
+struct NfsTraceEvent;
+class ProcessNameCache;
+
+/**
+ * Turns the events of the filesystem, hg import and checkout TraceBuses of a
+ * mount into a ChromeTrace.
+ *
+ * Every request becomes one slice from its start event to its finish event,
+ * and every import caused by a filesystem request gets a flow from that
+ * request. Requests that were already in flight when the capture started
+ * begin at the capture start, and those still in flight when it ends are
+ * closed at that point.
+ *
+ * The observe methods may be called concurrently from the background threads
+ * of the different TraceBuses.
+ */
+class ChromeTraceCapture {
+ public:
+  explicit ChromeTraceCapture(
+      std::shared_ptr<ProcessNameCache> processNameCache);
+
+#ifndef _WIN32
+  void observe(const FuseTraceEvent& event);
+  void observe(const NfsTraceEvent& event);
+#endif
+  void observe(const HgImportTraceEvent& event);
+  void observe(const CheckoutTraceEvent& event);
+
+  /**
+   * Returns the events observed so far in the Chrome trace-event JSON format.
+   */
+  std::string finish();
+
+ private:
+  using TimePoint = ChromeTrace::TimePoint;
+
+  struct PendingRequest {
+    folly::StringPiece track;
+    TimePoint start;
+    std::string name;
+    folly::dynamic args;
+  };
+
+  struct PendingImport {
+    TimePoint queued;
+    std::optional<TimePoint> started;
+    uint64_t requestId{0};
+  };
+
+  struct State {
+    ChromeTrace trace;
+    folly::F14FastMap<uint64_t, PendingRequest> fsRequests;
+    folly::F14FastMap<uint64_t, PendingImport> imports;
+    // Filesystem requests by their request id, to link the imports to them.
+    folly::F14FastMap<uint64_t, ChromeTrace::SliceId> fsSlices;
+    std::vector<std::pair<uint64_t, ChromeTrace::SliceId>> importCauses;
+  };
+
+  void startRequest(
+      folly::StringPiece track,
+      uint64_t unique,
+      TimePoint start,
+      std::string name,
+      folly::dynamic args);
+  void finishRequest(
+      folly::StringPiece track,
+      uint64_t unique,
+      TimePoint end,
+      folly::dynamic args);
+
+  const std::shared_ptr<ProcessNameCache> processNameCache_;
+  const TimePoint captureStart_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
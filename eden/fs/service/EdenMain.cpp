@@ -149,7 +149,8 @@ void EdenMain::registerStandardBackingStores() {
             params.serverState->getStructuredLogger(),
             std::make_unique<BackingStoreLogger>(
                 params.serverState->getStructuredLogger(),
-                params.serverState->getProcessNameCache())),
+                params.serverState->getProcessNameCache(),
+                reloadableConfig)),
         params.localStore,
         params.sharedStats);
   });
@@ -239,8 +240,10 @@ int runEdenMain(EdenMain&& main, int argc, char** argv) {
   // If the privileged parent edenfs process has already started a privhelper
   // process, then the --privhelper_fd flag is given and this child process will
   // use it to connect to the existing privhelper.
+  folly::stop_watch<> privHelperStart;
   auto identity = UserInfo::lookup();
   auto privHelper = startOrConnectToPrivHelper(identity, argc, argv);
+  auto privHelperStartTime = privHelperStart.elapsed();
   identity.dropPrivileges();
 
   ////////////////////////////////////////////////////////////////////
@@ -278,6 +281,7 @@ int runEdenMain(EdenMain&& main, int argc, char** argv) {
   // Temporary hack until client is migrated to supported channel
   THRIFT_FLAG_SET_MOCK(server_header_reject_framed, false);
 
+  folly::stop_watch<> configLoad;
   std::shared_ptr<EdenConfig> edenConfig;
   try {
     edenConfig = getEdenConfig(identity);
@@ -285,6 +289,7 @@ int runEdenMain(EdenMain&& main, int argc, char** argv) {
     fprintf(stderr, "%s\n", ex.what());
     return kExitCodeError;
   }
+  auto configLoadTime = configLoad.elapsed();
 
   auto logPath = getLogPath(edenConfig->edenDir.getValue());
   auto startupLogger =
@@ -303,6 +308,8 @@ int runEdenMain(EdenMain&& main, int argc, char** argv) {
     privHelper->setDaemonTimeoutBlocking(
         edenConfig->fuseDaemonTimeout.getValue());
     privHelper->setUseEdenFsBlocking(edenConfig->fuseUseEdenFS.getValue());
+    startupLogger->logPhase("privhelper", privHelperStartTime);
+    startupLogger->logPhase("config", configLoadTime);
 
     // Since we are a daemon, and we don't ever want to be in a situation
     // where we hold any open descriptors through a fuse mount that points
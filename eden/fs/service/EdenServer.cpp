@@ -11,10 +11,13 @@
 #include <chrono>
 
 #include <sys/stat.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 
@@ -25,6 +28,7 @@
 #include <folly/SocketAddress.h>
 #include <folly/String.h>
 #include <folly/chrono/Conv.h>
+#include <folly/futures/Future.h>
 #include <folly/io/async/AsyncSignalHandler.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/logging/xlog.h>
@@ -58,7 +62,9 @@
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/SharedPackStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TieredLocalStore.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
@@ -73,6 +79,8 @@
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/MemoryArena.h"
 #include "eden/fs/utils/NfsSocket.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -83,6 +91,7 @@
 #ifndef _WIN32
 #include "eden/fs/fuse/FuseChannel.h"
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/notifications/CommandNotifier.h"
 #include "eden/fs/takeover/TakeoverClient.h"
 #include "eden/fs/takeover/TakeoverData.h"
@@ -91,6 +100,10 @@
 #include "eden/fs/notifications/WindowsNotifier.h" // @manual
 #endif // !_WIN32
 
+#ifdef __linux__
+#include "eden/fs/service/SharedMemoryServer.h"
+#endif // __linux__
+
 DEFINE_bool(
     debug,
     false,
@@ -122,6 +135,20 @@ DEFINE_int32(
     thrift_num_workers,
     std::thread::hardware_concurrency(),
     "The number of thrift worker threads");
+DEFINE_int32(
+    thrift_interactive_workers,
+    2,
+    "The number of thrift CPU threads serving cheap, latency-sensitive "
+    "requests such as getCurrentJournalPosition");
+DEFINE_int32(
+    thrift_bulk_workers,
+    std::thread::hardware_concurrency(),
+    "The number of thrift CPU threads serving requests that are neither "
+    "interactive nor debug, such as getScmStatusV2 and globFiles");
+DEFINE_int32(
+    thrift_debug_workers,
+    1,
+    "The number of thrift CPU threads serving debug* requests");
 DEFINE_int32(
     thrift_max_requests,
     apache::thrift::concurrency::ThreadManager::DEFAULT_MAX_QUEUE_SIZE,
@@ -150,6 +177,15 @@ DEFINE_uint64(
     minimumBlobCacheEntryCount,
     16,
     "The minimum number of recent blobs to keep cached. Trumps maximumBlobCacheSize");
+DEFINE_uint64(
+    blobCacheShardCount,
+    1,
+    "Number of independently locked shards the blob cache is split into");
+DEFINE_string(
+    blobCacheEvictionPolicy,
+    "lru",
+    "Eviction policy for the blob cache: \"lru\" or the scan-resistant "
+    "\"tinylfu\"");
 
 using apache::thrift::ThriftServer;
 using apache::thrift::ThriftServerAsyncProcessorFactory;
@@ -202,6 +238,10 @@ constexpr StringPiece kHgStorePrefix{"store.hg"};
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
 #endif
 constexpr StringPiece kStateConfig{"config.toml"};
+#ifdef __linux__
+// How long a response published in shared memory waits for its client.
+constexpr std::chrono::seconds kSharedMemoryResponseExpiry{30};
+#endif
 
 std::optional<std::string> getUnixDomainSocketPath(
     const folly::SocketAddress& address) {
@@ -282,6 +322,141 @@ size_t getNumberPendingFuseRequests(const EdenMount* mount) {
 }
 #endif // __linux__
 
+#ifndef _WIN32
+constexpr size_t kCacheWarmupBatchSize = 256;
+
+/**
+ * Load the objects ids[begin:] from the local store, one small batch at a
+ * time, and insert the ones found into an in-memory cache in order. Objects
+ * missing from the local store are skipped rather than fetched.
+ */
+template <typename ObjectType>
+folly::Future<folly::Unit> warmCache(
+    std::shared_ptr<LocalStore> localStore,
+    std::shared_ptr<std::vector<ObjectId>> ids,
+    size_t begin,
+    folly::Future<std::unique_ptr<ObjectType>> (LocalStore::*load)(
+        const ObjectId&) const,
+    std::function<void(std::unique_ptr<ObjectType>)> insert) {
+  auto end = std::min(begin + kCacheWarmupBatchSize, ids->size());
+  if (begin >= end) {
+    return folly::unit;
+  }
+  std::vector<folly::Future<std::unique_ptr<ObjectType>>> loads;
+  loads.reserve(end - begin);
+  for (auto i = begin; i < end; ++i) {
+    loads.push_back(((*localStore).*load)((*ids)[i]));
+  }
+  return folly::collectAll(std::move(loads))
+      .toUnsafeFuture()
+      .thenValue([localStore, ids, end, load, insert = std::move(insert)](
+                     std::vector<folly::Try<std::unique_ptr<ObjectType>>>
+                         objects) mutable {
+        for (auto& object : objects) {
+          if (object.hasValue() && object.value()) {
+            insert(std::move(object.value()));
+          }
+        }
+        return warmCache(
+            std::move(localStore),
+            std::move(ids),
+            end,
+            load,
+            std::move(insert));
+      });
+}
+#endif // !_WIN32
+
+/**
+ * Adds up how long each phase of the mounts started together at startup
+ * took, and logs the totals once the last of them is done.
+ */
+class StartupMountSummary {
+ public:
+  StartupMountSummary(
+      std::shared_ptr<StartupLogger> logger,
+      size_t mountCount,
+      std::string action)
+      : logger_{std::move(logger)},
+        action_{std::move(action)},
+        state_{State{mountCount, {}}} {}
+
+  void finished(
+      folly::StringPiece mountPath,
+      const EdenServer::MountStartupTimes& times) {
+    logger_->logVerbose(
+        mountPath,
+        ": initialized in ",
+        times.initialize.count(),
+        " seconds (",
+        times.overlay.count(),
+        " in the overlay, ",
+        times.fsck.count(),
+        " of it in fsck), started channel in ",
+        times.startChannel.count(),
+        " seconds, set up bind mounts in ",
+        times.bindMounts.count(),
+        " seconds");
+
+    EdenServer::MountStartupTimes totals;
+    {
+      auto state = state_.wlock();
+      state->totals.initialize += times.initialize;
+      state->totals.overlay += times.overlay;
+      state->totals.fsck += times.fsck;
+      state->totals.startChannel += times.startChannel;
+      state->totals.bindMounts += times.bindMounts;
+      if (--state->remaining != 0) {
+        return;
+      }
+      totals = state->totals;
+    }
+    logger_->log(
+        action_,
+        " mount points in ",
+        std::chrono::duration<double>{watch_.elapsed()}.count(),
+        " seconds. Summed over mount points: ",
+        totals.initialize.count(),
+        " seconds initializing, ",
+        totals.startChannel.count(),
+        " seconds starting channels, ",
+        totals.bindMounts.count(),
+        " seconds setting up bind mounts.");
+    logger_->logPhase("overlay", totals.overlay);
+    logger_->logPhase("fsck", totals.fsck);
+    logger_->logPhase("mount", watch_.elapsed());
+  }
+
+ private:
+  struct State {
+    size_t remaining;
+    EdenServer::MountStartupTimes totals;
+  };
+
+  std::shared_ptr<StartupLogger> logger_;
+  std::string action_;
+  folly::stop_watch<> watch_;
+  folly::Synchronized<State> state_;
+};
+
+/**
+ * Call `startMount` with each of `items`, starting at most `concurrency`
+ * mounts at a time, or all of them at once if it is 0.
+ */
+template <typename T, typename F>
+std::vector<Future<Unit>> startMountsBounded(
+    folly::Executor* executor,
+    std::vector<T> items,
+    uint32_t concurrency,
+    F&& startMount) {
+  size_t limit = concurrency == 0 ? items.size() : concurrency;
+  return folly::window(
+      folly::getKeepAliveToken(executor),
+      std::move(items),
+      std::forward<F>(startMount),
+      std::max<size_t>(limit, 1));
+}
+
 } // namespace
 
 namespace facebook {
@@ -342,6 +517,45 @@ class EdenServer::ThriftServerEventHandler
 };
 
 static constexpr folly::StringPiece kBlobCacheMemory{"blob_cache.memory"};
+static constexpr folly::StringPiece kBlobCacheHits{"blob_cache.hit_count"};
+static constexpr folly::StringPiece kBlobCacheMisses{"blob_cache.miss_count"};
+static constexpr folly::StringPiece kBlobCacheAdmissionRejects{
+    "blob_cache.admission_reject_count"};
+static constexpr folly::StringPiece kCompressedBlobCacheMemory{
+    "blob_cache.compressed.memory"};
+static constexpr folly::StringPiece kCompressedBlobCacheHits{
+    "blob_cache.compressed.hit_count"};
+static constexpr folly::StringPiece kCompressedBlobCacheMisses{
+    "blob_cache.compressed.miss_count"};
+static constexpr folly::StringPiece kBlobCacheMemoryUsage{
+    "memory.blob_cache"};
+static constexpr folly::StringPiece kTreeCacheMemoryUsage{
+    "memory.tree_cache"};
+static constexpr folly::StringPiece kHgImportQueueMemoryUsage{
+    "memory.hg_import_queue"};
+static constexpr folly::StringPiece kLocalStoreMemoryUsage{
+    "memory.local_store"};
+static constexpr folly::StringPiece kTotalMemoryUsage{"memory.total"};
+static constexpr folly::StringPiece kHgImportBlobBatchSizeTarget{
+    "store.hg.import_batch_size_target.blob"};
+static constexpr folly::StringPiece kHgImportTreeBatchSizeTarget{
+    "store.hg.import_batch_size_target.tree"};
+static constexpr folly::StringPiece kHgImportConcurrencyTarget{
+    "store.hg.import_concurrency_target"};
+
+namespace {
+ObjectCacheEvictionPolicy parseBlobCacheEvictionPolicy(
+    folly::StringPiece policy) {
+  if (policy == "tinylfu") {
+    return ObjectCacheEvictionPolicy::TinyLFU;
+  }
+  if (policy != "lru") {
+    XLOG(WARN) << "unknown blob cache eviction policy \"" << policy
+               << "\", using lru";
+  }
+  return ObjectCacheEvictionPolicy::LRU;
+}
+} // namespace
 
 EdenServer::EdenServer(
     std::vector<std::string> originalCommandLine,
@@ -359,7 +573,10 @@ EdenServer::EdenServer(
       backingStoreFactory_{backingStoreFactory},
       blobCache_{BlobCache::create(
           FLAGS_maximumBlobCacheSize,
-          FLAGS_minimumBlobCacheEntryCount)},
+          FLAGS_minimumBlobCacheEntryCount,
+          FLAGS_blobCacheShardCount,
+          parseBlobCacheEvictionPolicy(FLAGS_blobCacheEvictionPolicy),
+          edenConfig->compressedBlobCacheSize.getValue())},
       config_{std::make_shared<ReloadableConfig>(edenConfig)},
       // Store a pointer to the EventBase that will be used to drive
       // the main thread.  The runServer() code will end up driving this
@@ -386,6 +603,82 @@ EdenServer::EdenServer(
   counters->registerCallback(kBlobCacheMemory, [this] {
     return this->getBlobCache()->getStats().totalSizeInBytes;
   });
+  counters->registerCallback(kBlobCacheHits, [this] {
+    return this->getBlobCache()->getStats().hitCount;
+  });
+  counters->registerCallback(kBlobCacheMisses, [this] {
+    return this->getBlobCache()->getStats().missCount;
+  });
+  counters->registerCallback(kBlobCacheAdmissionRejects, [this] {
+    return this->getBlobCache()->getStats().admissionRejectCount;
+  });
+  counters->registerCallback(kCompressedBlobCacheMemory, [this] {
+    return this->getBlobCache()->getCompressedTierStats().totalSizeInBytes;
+  });
+  counters->registerCallback(kCompressedBlobCacheHits, [this] {
+    return this->getBlobCache()->getCompressedTierStats().hitCount;
+  });
+  counters->registerCallback(kCompressedBlobCacheMisses, [this] {
+    return this->getBlobCache()->getCompressedTierStats().missCount;
+  });
+  counters->registerCallback(kBlobCacheMemoryUsage, [this] {
+    return this->getBlobCache()->getStats().totalSizeInBytes +
+        this->getBlobCache()->getCompressedTierStats().totalSizeInBytes;
+  });
+  counters->registerCallback(kTreeCacheMemoryUsage, [this] {
+    return this->getTreeCache()->getStats().totalSizeInBytes;
+  });
+  counters->registerCallback(kHgImportQueueMemoryUsage, [this] {
+    auto sizes = this->collectHgQueuedBackingStoreCounters(
+        [](const HgQueuedBackingStore& store) {
+          return store.estimateMemoryUsage();
+        });
+    return std::accumulate(sizes.begin(), sizes.end(), size_t{0});
+  });
+  counters->registerCallback(kLocalStoreMemoryUsage, [this] {
+    auto localStore = this->localStore_;
+    return localStore ? localStore->estimateMemoryUsage() : size_t{0};
+  });
+  counters->registerCallback(kTotalMemoryUsage, [this] {
+    auto total = this->estimateMemoryUsage().total();
+    for (const auto& mount : this->getMountPoints()) {
+      total += mount->estimateMemoryUsage().total();
+    }
+    return total;
+  });
+  // With several repositories, report the largest target among them.
+  auto maxHgQueuedBackingStoreCounter =
+      [this](std::function<size_t(const HgQueuedBackingStore&)> getCounter) {
+        auto values = this->collectHgQueuedBackingStoreCounters(
+            std::move(getCounter));
+        if (values.empty()) {
+          return size_t{0};
+        }
+        return *std::max_element(values.begin(), values.end());
+      };
+  counters->registerCallback(
+      kHgImportBlobBatchSizeTarget, [maxHgQueuedBackingStoreCounter] {
+        return maxHgQueuedBackingStoreCounter(
+            [](const HgQueuedBackingStore& store) {
+              return store.getImportBatchSizeTarget(
+                  HgImportBatchController::Kind::Blob);
+            });
+      });
+  counters->registerCallback(
+      kHgImportTreeBatchSizeTarget, [maxHgQueuedBackingStoreCounter] {
+        return maxHgQueuedBackingStoreCounter(
+            [](const HgQueuedBackingStore& store) {
+              return store.getImportBatchSizeTarget(
+                  HgImportBatchController::Kind::Tree);
+            });
+      });
+  counters->registerCallback(
+      kHgImportConcurrencyTarget, [maxHgQueuedBackingStoreCounter] {
+        return maxHgQueuedBackingStoreCounter(
+            [](const HgQueuedBackingStore& store) {
+              return store.getImportConcurrencyTarget();
+            });
+      });
 
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
@@ -423,6 +716,20 @@ EdenServer::EdenServer(
 EdenServer::~EdenServer() {
   auto counters = fb303::ServiceData::get()->getDynamicCounters();
   counters->unregisterCallback(kBlobCacheMemory);
+  counters->unregisterCallback(kBlobCacheHits);
+  counters->unregisterCallback(kBlobCacheMisses);
+  counters->unregisterCallback(kBlobCacheAdmissionRejects);
+  counters->unregisterCallback(kCompressedBlobCacheMemory);
+  counters->unregisterCallback(kCompressedBlobCacheHits);
+  counters->unregisterCallback(kCompressedBlobCacheMisses);
+  counters->unregisterCallback(kBlobCacheMemoryUsage);
+  counters->unregisterCallback(kTreeCacheMemoryUsage);
+  counters->unregisterCallback(kHgImportQueueMemoryUsage);
+  counters->unregisterCallback(kLocalStoreMemoryUsage);
+  counters->unregisterCallback(kTotalMemoryUsage);
+  counters->unregisterCallback(kHgImportBlobBatchSizeTarget);
+  counters->unregisterCallback(kHgImportTreeBatchSizeTarget);
+  counters->unregisterCallback(kHgImportConcurrencyTarget);
 
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
@@ -565,6 +872,44 @@ Future<Unit> EdenServer::unmountAll() {
 }
 
 #ifndef _WIN32
+void EdenServer::warmObjectCaches(
+    std::vector<ObjectId> blobIds,
+    std::vector<ObjectId> treeIds) {
+  if (blobIds.empty() && treeIds.empty()) {
+    return;
+  }
+  XLOG(DBG2) << "reloading " << blobIds.size() << " blobs and "
+             << treeIds.size() << " trees cached by the previous process";
+
+  // The ids are most recently used first. Insert the least recently used
+  // objects first so the caches end up in the same order as before.
+  std::reverse(blobIds.begin(), blobIds.end());
+  std::reverse(treeIds.begin(), treeIds.end());
+
+  auto blobsWarmed = warmCache<Blob>(
+      localStore_,
+      std::make_shared<std::vector<ObjectId>>(std::move(blobIds)),
+      0,
+      &LocalStore::getBlob,
+      [blobCache = blobCache_](std::unique_ptr<Blob> blob) {
+        blobCache->insert(std::move(blob));
+      });
+  auto treesWarmed = warmCache<Tree>(
+      localStore_,
+      std::make_shared<std::vector<ObjectId>>(std::move(treeIds)),
+      0,
+      &LocalStore::getTree,
+      [treeCache = treeCache_](std::unique_ptr<Tree> tree) {
+        treeCache->insert(std::move(tree));
+      });
+  (void)folly::collectAll(std::move(blobsWarmed), std::move(treesWarmed))
+      .toUnsafeFuture()
+      .thenValue([](auto&&) {
+        XLOG(DBG2) << "done reloading the objects cached by the previous "
+                      "process";
+      });
+}
+
 Future<TakeoverData> EdenServer::stopMountsForTakeover(
     folly::Promise<std::optional<TakeoverData>>&& takeoverPromise) {
   std::vector<Future<optional<TakeoverData::MountInfo>>> futures;
@@ -622,11 +967,15 @@ Future<TakeoverData> EdenServer::stopMountsForTakeover(
   // Use collectAll() rather than collect() to wait for all of the unmounts
   // to complete, and only check for errors once everything has finished.
   return folly::collectAll(futures).toUnsafeFuture().thenValue(
-      [takeoverPromise = std::move(takeoverPromise)](
+      [this, takeoverPromise = std::move(takeoverPromise)](
           std::vector<folly::Try<optional<TakeoverData::MountInfo>>>
               results) mutable {
         TakeoverData data;
         data.takeoverComplete = std::move(takeoverPromise);
+        auto warmEntries = serverState_->getEdenConfig()
+                               ->takeoverWarmCacheEntries.getValue();
+        data.recentBlobIds = blobCache_->getMostRecentlyUsedIds(warmEntries);
+        data.recentTreeIds = treeCache_->getMostRecentlyUsedIds(warmEntries);
         data.mountPoints.reserve(results.size());
         for (auto& result : results) {
           // If something went wrong shutting down a mount point,
@@ -658,6 +1007,48 @@ Future<TakeoverData> EdenServer::stopMountsForTakeover(
 void EdenServer::startPeriodicTasks() {
   // Report memory usage stats once every 30 seconds
   memoryStatsTask_.updateInterval(30s);
+
+  maintenanceScheduler_.addJob(
+      "local_store",
+      MaintenanceClass::Light,
+      [this](const folly::CancellationToken&) {
+        manageLocalStore();
+        return folly::makeSemiFuture();
+      });
+  maintenanceScheduler_.addJob(
+      "local_store_gc",
+      MaintenanceClass::Heavy,
+      [this](const folly::CancellationToken& cancel) {
+        auto config = serverState_->getReloadableConfig()->getEdenConfig(
+            ConfigReloadBehavior::NoReload);
+        return localStore_->garbageCollect(*config, cancel);
+      });
+  maintenanceScheduler_.addJob(
+      "backing_store",
+      MaintenanceClass::Light,
+      [this](const folly::CancellationToken&) {
+        refreshBackingStore();
+        return folly::makeSemiFuture();
+      });
+  maintenanceScheduler_.addJob(
+      "dematerialize",
+      MaintenanceClass::Heavy,
+      [this](const folly::CancellationToken& cancel) {
+        std::vector<ImmediateFuture<size_t>> futures;
+        for (const auto& mount : getMountPoints()) {
+          futures.push_back(mount->dematerializeUnchangedDirectories(cancel));
+        }
+        return collectAllSafe(std::move(futures)).unit().semi();
+      });
+  maintenanceScheduler_.addJob(
+      "memory_arena_purge",
+      MaintenanceClass::Light,
+      [](const folly::CancellationToken&) {
+        for (auto* arena : MemoryArena::getAll()) {
+          arena->purge();
+        }
+        return folly::makeSemiFuture();
+      });
   auto config = serverState_->getReloadableConfig()->getEdenConfig();
   updatePeriodicTaskIntervals(*config);
 
@@ -672,7 +1063,7 @@ void EdenServer::startPeriodicTasks() {
   }
 #endif
 
-  backingStoreTask_.updateInterval(1min);
+  maintenanceScheduler_.updateJobInterval("backing_store", 1min);
 }
 
 void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
@@ -691,9 +1082,39 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
           config.checkValidityInterval.getValue()));
 #endif
 
-  localStoreTask_.updateInterval(
+  auto localStoreInterval =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.localStoreManagementInterval.getValue());
+  maintenanceScheduler_.updateJobInterval("local_store", localStoreInterval);
+  maintenanceScheduler_.updateJobInterval(
+      "local_store_gc", localStoreInterval);
+  maintenanceScheduler_.updateJobInterval(
+      "dematerialize",
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.dematerializeInterval.getValue()));
+  maintenanceScheduler_.updateJobInterval(
+      "memory_arena_purge",
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.memoryArenaPurgeInterval.getValue()));
+  maintenanceScheduler_.updateConfig(config);
+
+  inFlightSampleTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.inFlightSampleInterval.getValue()));
+
+#ifndef _WIN32
+  memoryPressureUnloadTask_.updateInterval(
       std::chrono::duration_cast<std::chrono::milliseconds>(
-          config.localStoreManagementInterval.getValue()));
+          config.memoryPressureCheckInterval.getValue()));
+
+  inodeMetadataFlushTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.inodeMetadataFlushInterval.getValue()));
+
+  nfsInodeUnloadTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.nfsInodeUnloadInterval.getValue()));
+#endif
 }
 
 void EdenServer::scheduleCallbackOnMainEventBase(
@@ -743,7 +1164,9 @@ void EdenServer::scheduleCallbackOnMainEventBase(
 }
 
 #ifndef _WIN32
-void EdenServer::unloadInodes() {
+size_t EdenServer::unloadInodesLastAccessedBefore(
+    const timespec& cutoff,
+    bool nfsOnly) {
   struct Root {
     AbsolutePath mountName;
     TreeInodePtr rootInode;
@@ -753,6 +1176,9 @@ void EdenServer::unloadInodes() {
   {
     const auto mountPoints = mountPoints_.wlock();
     for (auto& entry : *mountPoints) {
+      if (nfsOnly && !entry.second.edenMount->isNfsdChannel()) {
+        continue;
+      }
       roots.emplace_back(Root{
           entry.first,
           entry.second.edenMount->getRootInode(),
@@ -760,23 +1186,88 @@ void EdenServer::unloadInodes() {
     }
   }
 
-  if (!roots.empty()) {
-    auto cutoff = std::chrono::system_clock::now() -
-        std::chrono::minutes(FLAGS_unload_age_minutes);
-    auto cutoff_ts = folly::to<timespec>(cutoff);
-    for (auto& [name, rootInode, mount] : roots) {
-      auto unloaded = rootInode->unloadChildrenLastAccessedBefore(cutoff_ts);
-      if (unloaded) {
-        XLOG(INFO) << "Unloaded " << unloaded
-                   << " inodes in background from mount " << name;
-      }
-      mount->getInodeMap()->recordPeriodicInodeUnload(unloaded);
+  size_t total = 0;
+  for (auto& [name, rootInode, mount] : roots) {
+    auto unloaded = rootInode->unloadChildrenLastAccessedBefore(cutoff);
+    if (unloaded) {
+      XLOG(INFO) << "Unloaded " << unloaded
+                 << " inodes in background from mount " << name;
     }
+    mount->getInodeMap()->recordPeriodicInodeUnload(unloaded);
+    total += unloaded;
   }
+  return total;
+}
+
+void EdenServer::unloadInodes() {
+  auto cutoff = std::chrono::system_clock::now() -
+      std::chrono::minutes(FLAGS_unload_age_minutes);
+  unloadInodesLastAccessedBefore(folly::to<timespec>(cutoff));
 
   scheduleInodeUnload(std::chrono::minutes(FLAGS_unload_interval_minutes));
 }
 
+void EdenServer::unloadNfsInodes() {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  auto age = config->nfsInodeUnloadAge.getValue();
+  auto cutoff = std::chrono::system_clock::now() -
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+  unloadInodesLastAccessedBefore(
+      folly::to<timespec>(cutoff), /*nfsOnly=*/true);
+}
+
+void EdenServer::unloadInodesUnderMemoryPressure() {
+  // The age of the first batch unloaded once memory pressure is detected.
+  constexpr auto kInitialUnloadAge = std::chrono::hours(1);
+
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  uint64_t limit = config->memoryPressureLimit.getValue();
+  if (limit == 0) {
+    limit = proc_util::readCgroupMemoryLimit().value_or(0);
+  }
+  auto memoryStats = proc_util::readMemoryStats();
+  if (limit == 0 || !memoryStats) {
+    memoryPressureUnloadAge_.reset();
+    return;
+  }
+
+  auto percentOfLimit = [limit](uint32_t percent) {
+    return limit / 100 * percent;
+  };
+  auto resident = memoryStats->resident;
+  if (!memoryPressureUnloadAge_) {
+    if (resident <=
+        percentOfLimit(config->memoryPressureHighWatermarkPercent.getValue())) {
+      return;
+    }
+    memoryPressureUnloadAge_ = std::max<std::chrono::nanoseconds>(
+        kInitialUnloadAge, config->memoryPressureMinUnloadAge.getValue());
+  } else if (
+      resident <=
+      percentOfLimit(config->memoryPressureTargetPercent.getValue())) {
+    XLOG(INFO) << "Resident memory of " << resident
+               << " bytes is back under target, stopping inode unloading";
+    memoryPressureUnloadAge_.reset();
+    return;
+  }
+
+  auto age = *memoryPressureUnloadAge_;
+  XLOG(INFO) << "Resident memory of " << resident << " bytes exceeds "
+             << "target for a limit of " << limit
+             << " bytes, unloading inodes not accessed in the last "
+             << durationStr(age);
+  auto cutoff = std::chrono::system_clock::now() -
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+  auto unloaded = unloadInodesLastAccessedBefore(folly::to<timespec>(cutoff));
+  XLOG(INFO) << "Unloaded " << unloaded << " inodes due to memory pressure";
+
+  // If that was not enough, move on to more recently used inodes next time.
+  memoryPressureUnloadAge_ =
+      std::max(age / 2, config->memoryPressureMinUnloadAge.getValue());
+}
+
 void EdenServer::scheduleInodeUnload(std::chrono::milliseconds timeout) {
   mainEventBase_->timer().scheduleTimeoutFn(
       [this] {
@@ -873,11 +1364,13 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
     logger->log(
         "Requesting existing edenfs process to gracefully "
         "transfer its mount points...");
+    folly::stop_watch<> takeoverWatch;
     takeoverData = takeoverMounts(takeoverPath);
     logger->log(
         "Received takeover information for ",
         takeoverData.mountPoints.size(),
         " mount points");
+    logger->logPhase("takeover", takeoverWatch.elapsed());
 
     // Take over the eden lock file and the thrift server socket.
     edenDir_.takeoverLock(std::move(takeoverData.lockFile));
@@ -912,7 +1405,9 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
   // another is required, introduce an EdenStateConfig class to manage
   // defaults and save on update.
   auto config = parseConfig();
+  folly::stop_watch<> localStoreWatch;
   bool shouldSaveConfig = openStorageEngine(*config, *logger);
+  logger->logPhase("local_store", localStoreWatch.elapsed());
   if (shouldSaveConfig) {
     saveConfig(*config);
   }
@@ -926,12 +1421,21 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
       &serverState_->getFaultInjector()));
   takeoverServer_->start();
 #endif // !_WIN32
+#ifdef __linux__
+  sharedMemoryServer_ = std::make_unique<SharedMemoryServer>(
+      getMainEventBase(),
+      edenDir_.getSharedMemorySocketPath(),
+      kSharedMemoryResponseExpiry);
+#endif // __linux__
 
   std::vector<Future<Unit>> mountFutures;
   if (doingTakeover) {
 #ifndef _WIN32
     mountFutures =
         prepareMountsTakeover(logger, std::move(takeoverData.mountPoints));
+    warmObjectCaches(
+        std::move(takeoverData.recentBlobIds),
+        std::move(takeoverData.recentTreeIds));
 #else
     NOT_IMPLEMENTED();
 #endif // !_WIN32
@@ -989,7 +1493,8 @@ bool EdenServer::openStorageEngine(
 
   if (storageEngine == "memory") {
     logger.log("Creating new memory store.");
-    localStore_ = make_shared<MemoryLocalStore>();
+    localStore_ = make_shared<MemoryLocalStore>(
+        serverState_->getEdenConfig()->memoryLocalStoreSizeLimit.getValue());
   } else if (storageEngine == "sqlite") {
     const auto path = edenDir_.getPath() + RelativePathPiece{kSqlitePath};
     const auto parentDir = path.dirname();
@@ -1022,6 +1527,22 @@ bool EdenServer::openStorageEngine(
         folly::to<string>("invalid storage engine: ", storageEngine));
   }
 
+  auto sharedPackDirectory = serverState_->getEdenConfig()
+                                 ->localStoreSharedPackDirectory.getValue();
+  if (!sharedPackDirectory.empty()) {
+    auto sharedStore = make_shared<SharedPackStore>(
+        canonicalPath(sharedPackDirectory));
+    logger.log(
+        "Reading through ",
+        sharedStore->getSegmentCount(),
+        " shared pack segments in ",
+        sharedPackDirectory);
+    auto enableBlobCaching = localStore_->enableBlobCaching.load();
+    localStore_ = make_shared<TieredLocalStore>(
+        std::move(localStore_), std::move(sharedStore));
+    localStore_->enableBlobCaching.store(enableBlobCaching);
+  }
+
   return configUpdated;
 }
 
@@ -1030,25 +1551,34 @@ std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
     std::vector<TakeoverData::MountInfo>&& takeoverMounts) {
   // Trigger remounting of existing mount points
   // If doingTakeover is true, use the mounts received in TakeoverData
-  std::vector<Future<Unit>> mountFutures;
-
   if (folly::kIsWindows) {
     NOT_IMPLEMENTED();
   }
 
-  for (auto& info : takeoverMounts) {
-    const auto stateDirectory = info.stateDirectory;
-    auto mountFuture =
-        makeFutureWith([&] {
-          auto initialConfig = CheckoutConfig::loadFromClientDirectory(
-              AbsolutePathPiece{info.mountPath},
-              AbsolutePathPiece{info.stateDirectory});
-
-          return mount(
-              std::move(initialConfig), false, [](auto) {}, std::move(info));
-        })
-            .thenTry([logger, mountPath = info.mountPath](
+  auto summary = std::make_shared<StartupMountSummary>(
+      logger, takeoverMounts.size(), "Took over");
+  return startMountsBounded(
+      serverState_->getThreadPool().get(),
+      std::move(takeoverMounts),
+      serverState_->getEdenConfig()->startupMountConcurrency.getValue(),
+      [this, logger, summary](TakeoverData::MountInfo&& info) {
+        auto mountPath = info.mountPath;
+        auto startupTimes = std::make_shared<MountStartupTimes>();
+        return makeFutureWith([&] {
+                 auto initialConfig = CheckoutConfig::loadFromClientDirectory(
+                     AbsolutePathPiece{info.mountPath},
+                     AbsolutePathPiece{info.stateDirectory});
+
+                 return mount(
+                     std::move(initialConfig),
+                     false,
+                     [](auto) {},
+                     std::move(info),
+                     startupTimes);
+               })
+            .thenTry([logger, summary, startupTimes, mountPath](
                          folly::Try<std::shared_ptr<EdenMount>>&& result) {
+              summary->finished(mountPath.stringPiece(), *startupTimes);
               if (result.hasValue()) {
                 logger->log("Successfully took over mount ", mountPath);
                 return makeFuture();
@@ -1062,10 +1592,7 @@ std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
                 return makeFuture<Unit>(std::move(result).exception());
               }
             });
-    mountFutures.push_back(std::move(mountFuture));
-  }
-
-  return mountFutures;
+      });
 }
 
 std::vector<Future<Unit>> EdenServer::prepareMounts(
@@ -1091,31 +1618,48 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
   }
   logger->log("Remounting ", dirs.size(), " mount points...");
 
+  std::vector<std::pair<std::string, std::string>> clients;
   for (const auto& client : dirs.items()) {
-    auto mountFuture = makeFutureWith([&] {
-      MountInfo mountInfo;
-      *mountInfo.mountPoint_ref() = client.first.c_str();
-      auto edenClientPath =
-          edenDir_.getCheckoutStateDir(client.second.asString());
-      *mountInfo.edenClientPath_ref() = edenClientPath.stringPiece().str();
-      auto initialConfig = CheckoutConfig::loadFromClientDirectory(
-          AbsolutePathPiece{*mountInfo.mountPoint_ref()},
-          AbsolutePathPiece{*mountInfo.edenClientPath_ref()});
-      auto progressIndex = progressManager_->wlock()->registerEntry(
-          client.first.asString(), initialConfig->getOverlayPath().c_str());
-
-      return mount(
-                 std::move(initialConfig),
-                 false,
-                 [this, logger, progressIndex](auto percent) {
-                   progressManager_->wlock()->manageProgress(
-                       logger, progressIndex, percent);
-                 })
-          .thenTry(
-              [this,
-               logger,
-               mountPath = client.first.asString(),
-               progressIndex](folly::Try<std::shared_ptr<EdenMount>>&& result) {
+    clients.emplace_back(client.first.asString(), client.second.asString());
+  }
+
+  auto summary = std::make_shared<StartupMountSummary>(
+      logger, clients.size(), "Remounted");
+  return startMountsBounded(
+      serverState_->getThreadPool().get(),
+      std::move(clients),
+      serverState_->getEdenConfig()->startupMountConcurrency.getValue(),
+      [this, logger, summary](std::pair<std::string, std::string>&& client) {
+        auto startupTimes = std::make_shared<MountStartupTimes>();
+        return makeFutureWith([&] {
+          MountInfo mountInfo;
+          *mountInfo.mountPoint_ref() = client.first;
+          auto edenClientPath = edenDir_.getCheckoutStateDir(client.second);
+          *mountInfo.edenClientPath_ref() = edenClientPath.stringPiece().str();
+          auto initialConfig = CheckoutConfig::loadFromClientDirectory(
+              AbsolutePathPiece{*mountInfo.mountPoint_ref()},
+              AbsolutePathPiece{*mountInfo.edenClientPath_ref()});
+          auto progressIndex = progressManager_->wlock()->registerEntry(
+              std::string{client.first},
+              initialConfig->getOverlayPath().c_str());
+
+          return mount(
+                     std::move(initialConfig),
+                     false,
+                     [this, logger, progressIndex](auto percent) {
+                       progressManager_->wlock()->manageProgress(
+                           logger, progressIndex, percent);
+                     },
+                     std::nullopt,
+                     startupTimes)
+              .thenTry([this,
+                        logger,
+                        summary,
+                        startupTimes,
+                        mountPath = client.first,
+                        progressIndex](
+                           folly::Try<std::shared_ptr<EdenMount>>&& result) {
+                summary->finished(mountPath, *startupTimes);
                 if (result.hasValue()) {
                   auto wl = progressManager_->wlock();
                   wl->finishProgress(progressIndex);
@@ -1131,11 +1675,8 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
                   return makeFuture<Unit>(std::move(result).exception());
                 }
               });
-    });
-
-    mountFutures.push_back(std::move(mountFuture));
-  }
-  return mountFutures;
+        });
+      });
 }
 
 void EdenServer::incrementStartupMountFailures() {
@@ -1229,6 +1770,9 @@ Future<Unit> EdenServer::performNormalShutdown() {
 #ifndef _WIN32
   takeoverServer_.reset();
 #endif // !_WIN32
+#ifdef __linux__
+  sharedMemoryServer_.reset();
+#endif // __linux__
 
   // Clean up all the server mount points
   return unmountAll();
@@ -1278,6 +1822,15 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
       edenMount->getCounterName(CounterName::INODEMAP_UNLOADED), [edenMount] {
         return edenMount->getInodeMap()->getInodeCounts().unloadedInodeCount;
       });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::INODEMAP_UNLOADED_BYTES_PER_INODE),
+      [edenMount] {
+        auto counts = edenMount->getInodeMap()->getInodeCounts();
+        if (counts.unloadedInodeCount == 0) {
+          return size_t{0};
+        }
+        return counts.unloadedInodeMemory / counts.unloadedInodeCount;
+      });
   counters->registerCallback(
       edenMount->getCounterName(CounterName::PERIODIC_INODE_UNLOAD),
       [edenMount] {
@@ -1311,7 +1864,56 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
         auto stats = edenMount->getJournal().getStats();
         return stats ? stats->maxFilesAccumulated : 0;
       });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::MEMORY_INODES),
+      [edenMount] { return edenMount->estimateMemoryUsage().inodes; });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::MEMORY_OVERLAY_FILE_CACHE),
+      [edenMount] {
+        return edenMount->estimateMemoryUsage().overlayFileCache;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::MEMORY_TOTAL),
+      [edenMount] { return edenMount->estimateMemoryUsage().total(); });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::SPECULATIVE_PREFETCH_TREES),
+      [edenMount] {
+        return edenMount->getSpeculativeTreePrefetcher().getPrefetchCount();
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::SPECULATIVE_PREFETCH_HITS),
+      [edenMount] {
+        return edenMount->getSpeculativeTreePrefetcher().getHitCount();
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::SPECULATIVE_PREFETCH_HIT_RATE),
+      [edenMount] {
+        return edenMount->getSpeculativeTreePrefetcher().getHitRatePercent();
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_BACKLOG),
+      [edenMount] { return edenMount->getOverlay()->getGCBacklog(); });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_BACKLOG_AGE),
+      [edenMount] {
+        return edenMount->getOverlay()->getGCBacklogAge().count();
+      });
 #ifndef _WIN32
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_BYTES_CLONED),
+      [edenMount] {
+        return edenMount->getOverlay()->getFileCopyStats().bytesCloned;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_BYTES_COPIED),
+      [edenMount] {
+        return edenMount->getOverlay()->getFileCopyStats().bytesCopied;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_BYTES_DEDUPLICATED),
+      [edenMount] {
+        return edenMount->getOverlay()->getFileCopyStats().bytesDeduplicated;
+      });
   if (auto* channel = edenMount->getFuseChannel()) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
       counters->registerCallback(
@@ -1349,6 +1951,8 @@ void EdenServer::unregisterStats(EdenMount* edenMount) {
       edenMount->getCounterName(CounterName::INODEMAP_LOADED));
   counters->unregisterCallback(
       edenMount->getCounterName(CounterName::INODEMAP_UNLOADED));
+  counters->unregisterCallback(edenMount->getCounterName(
+      CounterName::INODEMAP_UNLOADED_BYTES_PER_INODE));
   counters->unregisterCallback(
       edenMount->getCounterName(CounterName::PERIODIC_INODE_UNLOAD));
   counters->unregisterCallback(
@@ -1361,7 +1965,29 @@ void EdenServer::unregisterStats(EdenMount* edenMount) {
       edenMount->getCounterName(CounterName::JOURNAL_DURATION));
   counters->unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MAX_FILES_ACCUMULATED));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::MEMORY_INODES));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::MEMORY_OVERLAY_FILE_CACHE));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::MEMORY_TOTAL));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::SPECULATIVE_PREFETCH_TREES));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::SPECULATIVE_PREFETCH_HITS));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::SPECULATIVE_PREFETCH_HIT_RATE));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_BACKLOG));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_BACKLOG_AGE));
 #ifndef _WIN32
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_BYTES_CLONED));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_BYTES_COPIED));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_BYTES_DEDUPLICATED));
   if (edenMount->getFuseChannel()) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
       counters->unregisterCallback(getCounterNameForFuseRequests(
@@ -1432,7 +2058,8 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
     std::unique_ptr<CheckoutConfig> initialConfig,
     bool readOnly,
     OverlayChecker::ProgressCallback&& progressCallback,
-    optional<TakeoverData::MountInfo>&& optionalTakeover) {
+    optional<TakeoverData::MountInfo>&& optionalTakeover,
+    std::shared_ptr<MountStartupTimes> startupTimes) {
   folly::stop_watch<> mountStopWatch;
 
   auto backingStore = getBackingStore(
@@ -1462,10 +2089,20 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
 
   const bool doTakeover = optionalTakeover.has_value();
 
-  auto initFuture = edenMount->initialize(
-      std::move(progressCallback),
-      doTakeover ? std::make_optional(optionalTakeover->inodeMap)
-                 : std::nullopt);
+  // Mounts taken over from another process must be initialized from its
+  // inode map before their channel starts serving requests. Others may be
+  // initialized by the first request that reaches them. Nobody watches the
+  // fsck progress once startup is over, so it is not reported then.
+  const bool deferInitialization = !doTakeover &&
+      serverState_->getEdenConfig()->fuseLazyMountInitialization.getValue() &&
+      edenMount->deferInitialization([](auto) {});
+
+  auto initFuture = deferInitialization
+      ? makeFuture()
+      : edenMount->initialize(
+            std::move(progressCallback),
+            doTakeover ? std::make_optional(optionalTakeover->inodeMap)
+                       : std::nullopt);
 
   // Now actually begin starting the mount point
   return std::move(initFuture)
@@ -1474,8 +2111,18 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
                 readOnly,
                 edenMount,
                 mountStopWatch,
+                startupTimes,
+                deferInitialization,
                 optionalTakeover = std::move(optionalTakeover)](
                    folly::Try<Unit>&& result) mutable {
+        if (startupTimes) {
+          startupTimes->initialize = mountStopWatch.elapsed();
+          if (result.hasValue()) {
+            auto* overlay = edenMount->getOverlay();
+            startupTimes->overlay = overlay->getInitDuration();
+            startupTimes->fsck = overlay->getFsckDuration();
+          }
+        }
         if (result.hasException()) {
           XLOG(ERR) << "error initializing " << edenMount->getPath() << ": "
                     << result.exception().what();
@@ -1486,8 +2133,16 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
         return (optionalTakeover ? performTakeoverStart(
                                        edenMount, std::move(*optionalTakeover))
                                  : performFreshStart(edenMount, readOnly))
-            .thenTry([edenMount, doTakeover, this](
-                         folly::Try<Unit>&& result) mutable {
+            .thenTry([edenMount,
+                      doTakeover,
+                      deferInitialization,
+                      mountStopWatch,
+                      startupTimes,
+                      this](folly::Try<Unit>&& result) mutable {
+              if (startupTimes) {
+                startupTimes->startChannel =
+                    mountStopWatch.elapsed() - startupTimes->initialize;
+              }
               // Call mountFinished() if an error occurred during FUSE
               // initialization.
               if (result.hasException()) {
@@ -1516,6 +2171,22 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
                 // The bind mounts are already mounted in the takeover case
                 return makeFuture<std::shared_ptr<EdenMount>>(
                     std::move(edenMount));
+              } else if (deferInitialization) {
+                // Setting up the bind mounts accesses the checkout, which
+                // would initialize it right away. Set them up once something
+                // else has, without holding up the mount.
+                edenMount->getDeferredInitializationFuture()
+                    .deferValue([edenMount](auto&&) {
+                      return edenMount->performBindMounts();
+                    })
+                    .via(getServerState()->getThreadPool().get())
+                    .thenError([edenMount](folly::exception_wrapper&& ew) {
+                      XLOG(ERR) << "Error while performing bind mounts for "
+                                << edenMount->getPath() << ": "
+                                << folly::exceptionStr(ew);
+                    });
+                return makeFuture<std::shared_ptr<EdenMount>>(
+                    std::move(edenMount));
               } else {
                 // Perform all of the bind mounts associated with the
                 // client.  We don't need to do this for the takeover
@@ -1531,7 +2202,15 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
                     .via(getServerState()->getThreadPool().get());
               }
             })
-            .thenTry([this, mountStopWatch, doTakeover, edenMount](auto&& t) {
+            .thenTry([this,
+                      mountStopWatch,
+                      doTakeover,
+                      edenMount,
+                      startupTimes](auto&& t) {
+              if (startupTimes) {
+                startupTimes->bindMounts = mountStopWatch.elapsed() -
+                    startupTimes->initialize - startupTimes->startChannel;
+              }
               FinishedMount event;
               event.repo_type = edenMount->getCheckoutConfig()->getRepoType();
               event.repo_source =
@@ -1665,6 +2344,9 @@ EdenServer::MountList EdenServer::getAllMountPoints() const {
 shared_ptr<EdenMount> EdenServer::getMount(AbsolutePathPiece mountPath) const {
   const auto mount = getMountUnsafe(mountPath);
   if (!mount->isSafeForInodeAccess()) {
+    // Start the initialization of a mount that was deferred until it is
+    // used, so that retrying soon succeeds.
+    mount->ensureInitialized();
     throw newEdenError(
         EBUSY,
         EdenErrorType::POSIX_ERROR,
@@ -1830,6 +2512,23 @@ EdenServer::getHgQueuedBackingStores() {
   return hgBackingStores;
 }
 
+EdenServer::MemoryUsage EdenServer::estimateMemoryUsage() {
+  MemoryUsage usage;
+  usage.blobCache = blobCache_->getStats().totalSizeInBytes +
+      blobCache_->getCompressedTierStats().totalSizeInBytes;
+  usage.treeCache = treeCache_->getStats().totalSizeInBytes;
+  auto hgImportQueueSizes = collectHgQueuedBackingStoreCounters(
+      [](const HgQueuedBackingStore& store) {
+        return store.estimateMemoryUsage();
+      });
+  usage.hgImportQueue = std::accumulate(
+      hgImportQueueSizes.begin(), hgImportQueueSizes.end(), size_t{0});
+  if (auto localStore = localStore_) {
+    usage.localStore = localStore->estimateMemoryUsage();
+  }
+  return usage;
+}
+
 std::vector<size_t> EdenServer::collectHgQueuedBackingStoreCounters(
     std::function<size_t(const HgQueuedBackingStore&)> getCounterFromStore) {
   std::vector<size_t> counters;
@@ -1843,6 +2542,20 @@ Future<Unit> EdenServer::createThriftServer() {
   server_ = make_shared<ThriftServer>();
   server_->setMaxRequests(FLAGS_thrift_max_requests);
   server_->setNumIOWorkerThreads(FLAGS_thrift_num_workers);
+  // Serve each request class from its own thread pool, selected by the
+  // method priorities in eden.thrift, so that long statuses and globs cannot
+  // delay the calls that watchman and the CLI poll.
+  std::array<size_t, apache::thrift::concurrency::N_PRIORITIES> poolSizes{};
+  poolSizes[apache::thrift::concurrency::HIGH_IMPORTANT] = 1;
+  poolSizes[apache::thrift::concurrency::HIGH] =
+      std::max(FLAGS_thrift_interactive_workers, 1);
+  poolSizes[apache::thrift::concurrency::IMPORTANT] = 1;
+  poolSizes[apache::thrift::concurrency::NORMAL] =
+      std::max(FLAGS_thrift_bulk_workers, 1);
+  poolSizes[apache::thrift::concurrency::BEST_EFFORT] =
+      std::max(FLAGS_thrift_debug_workers, 1);
+  server_->setThreadManagerType(ThriftServer::ThreadManagerType::PRIORITY);
+  server_->setThreadManagerPoolSizes(poolSizes);
   server_->setEnableCodel(FLAGS_thrift_enable_codel);
   server_->setQueueTimeout(
       std::chrono::milliseconds{FLAGS_thrift_queue_timeout});
@@ -2083,6 +2796,98 @@ void EdenServer::reportMemoryStats() {
     fb303::ServiceData::get()->addStatValue(
         kRssBytes, memoryStats->resident, fb303::AVG);
   }
+
+  for (const auto* arena : MemoryArena::getAll()) {
+    if (auto stats = arena->getStats()) {
+      auto prefix = folly::to<std::string>("memory.arena.", arena->getName());
+      auto* serviceData = fb303::ServiceData::get();
+      serviceData->setCounter(prefix + ".active_bytes", stats->activeBytes);
+      serviceData->setCounter(prefix + ".dirty_bytes", stats->dirtyBytes);
+      serviceData->setCounter(prefix + ".mapped_bytes", stats->mappedBytes);
+    }
+  }
+}
+
+void EdenServer::flushInodeMetadata() {
+#ifndef _WIN32
+  for (const auto& mount : getMountPoints()) {
+    mount->getOverlay()->flushInodeMetadataAsync();
+  }
+#endif
+}
+
+void EdenServer::sampleInFlightRequests() {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  auto now = std::chrono::steady_clock::now();
+  auto ageOf = [now](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(now - start);
+  };
+
+  InFlightSample sample;
+  sample.time = std::chrono::system_clock::now();
+
+  // Collect the imports first so that a filesystem request waiting on one
+  // can be reported as such, rather than just as running.
+  std::unordered_map<uint64_t, bool> importDispatched;
+  for (const auto& store : getHgQueuedBackingStores()) {
+    auto repoName = store->getRepoName();
+    for (const auto& import : store->getLiveImports()) {
+      InFlightRequest request;
+      request.source = "hg";
+      request.location = repoName ? repoName->str() : "";
+      request.operation = import.isTree ? "tree" : "blob";
+      request.stage = import.dispatched ? "importing" : "queued";
+      request.requestId = import.requestId;
+      request.age = ageOf(import.requestTime);
+      sample.requests.push_back(std::move(request));
+
+      if (import.requestId) {
+        importDispatched[*import.requestId] |= import.dispatched;
+      }
+    }
+  }
+
+#ifndef _WIN32
+  auto fsStage = [&](uint64_t requestId) -> std::string {
+    auto it = importDispatched.find(requestId);
+    if (it == importDispatched.end()) {
+      return "running";
+    }
+    return it->second ? "waiting on import" : "waiting on queued import";
+  };
+
+  for (const auto& mount : getMountPoints()) {
+    auto mountPath = mount->getPath().value();
+    if (auto* fuseChannel = mount->getFuseChannel()) {
+      for (const auto& call : fuseChannel->getOutstandingRequests()) {
+        InFlightRequest request;
+        request.source = "fuse";
+        request.location = mountPath;
+        request.operation = fuseOpcodeName(call.request.opcode).str();
+        request.stage = fsStage(call.unique);
+        request.requestId = call.unique;
+        request.age = ageOf(call.requestStartTime);
+        sample.requests.push_back(std::move(request));
+      }
+    }
+    if (auto* nfsdChannel = mount->getNfsdChannel()) {
+      for (const auto& call : nfsdChannel->getOutstandingRequests()) {
+        InFlightRequest request;
+        request.source = "nfs";
+        request.location = mountPath;
+        request.operation = nfsProcName(call.procNumber).str();
+        request.stage = fsStage(call.requestId);
+        request.requestId = call.requestId;
+        request.age = ageOf(call.requestStartTime);
+        sample.requests.push_back(std::move(request));
+      }
+    }
+  }
+#endif // !_WIN32
+
+  inFlightSamples_.record(
+      std::move(sample), config->inFlightSampleHistory.getValue());
 }
 
 void EdenServer::manageLocalStore() {
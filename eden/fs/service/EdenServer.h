@@ -30,12 +30,14 @@
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/service/EdenStateDir.h"
+#include "eden/fs/service/MaintenanceScheduler.h"
 #include "eden/fs/service/PeriodicTask.h"
 #include "eden/fs/service/StartupLogger.h"
 #include "eden/fs/takeover/TakeoverData.h"
 #include "eden/fs/takeover/TakeoverHandler.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/IActivityRecorder.h"
+#include "eden/fs/telemetry/InFlightSampleLog.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -76,6 +78,9 @@ class UserInfo;
 #ifndef _WIN32
 class TakeoverServer;
 #endif
+#ifdef __linux__
+class SharedMemoryServer;
+#endif
 
 /**
  * To avoid EdenServer having a build dependency on every type of BackingStore
@@ -237,14 +242,34 @@ class EdenServer : private TakeoverHandler {
    */
   folly::Future<TakeoverData> startTakeoverShutdown() override;
 
+  /**
+   * How long each phase of starting a mount took.
+   */
+  struct MountStartupTimes {
+    /// Creating the EdenMount and initializing its overlay, fsck included.
+    std::chrono::duration<double> initialize{0};
+    /// The part of initialize spent initializing the overlay, fsck included.
+    std::chrono::duration<double> overlay{0};
+    /// The part of overlay spent checking an overlay not shut down cleanly.
+    std::chrono::duration<double> fsck{0};
+    /// Starting the FUSE or NFS channel, or taking it over.
+    std::chrono::duration<double> startChannel{0};
+    /// Setting up the bind mounts of the checkout.
+    std::chrono::duration<double> bindMounts{0};
+  };
+
   /**
    * Mount and return an EdenMount.
+   *
+   * If `startupTimes` is not null, it is filled in as the phases of starting
+   * the mount complete.
    */
   FOLLY_NODISCARD folly::Future<std::shared_ptr<EdenMount>> mount(
       std::unique_ptr<CheckoutConfig> initialConfig,
       bool readOnly,
       OverlayChecker::ProgressCallback&& progressCallback = [](auto) {},
-      std::optional<TakeoverData::MountInfo>&& optionalTakeover = std::nullopt);
+      std::optional<TakeoverData::MountInfo>&& optionalTakeover = std::nullopt,
+      std::shared_ptr<MountStartupTimes> startupTimes = nullptr);
 
   /**
    * Takeover a mount from another eden instance
@@ -347,6 +372,15 @@ class EdenServer : private TakeoverHandler {
     return serverState_;
   }
 
+#ifdef __linux__
+  /**
+   * Returns nullptr before the server is prepared and once it shuts down.
+   */
+  SharedMemoryServer* getSharedMemoryServer() const {
+    return sharedMemoryServer_.get();
+  }
+#endif // __linux__
+
   const std::chrono::time_point<std::chrono::steady_clock> getStartTime()
       const {
     return startTime_;
@@ -431,6 +465,31 @@ class EdenServer : private TakeoverHandler {
   std::unordered_set<std::shared_ptr<HgQueuedBackingStore>>
   getHgQueuedBackingStores();
 
+  /**
+   * Estimated bytes of memory used by the structures shared by all mounts,
+   * by subsystem. See EdenMount::estimateMemoryUsage for the rest.
+   */
+  struct MemoryUsage {
+    size_t blobCache = 0;
+    size_t treeCache = 0;
+    size_t hgImportQueue = 0;
+    size_t localStore = 0;
+
+    size_t total() const {
+      return blobCache + treeCache + hgImportQueue + localStore;
+    }
+  };
+
+  MemoryUsage estimateMemoryUsage();
+
+  /**
+   * The recent samples of in-flight filesystem requests and imports. See
+   * core:in-flight-sample-interval.
+   */
+  const InFlightSampleLog& getInFlightSampleLog() const {
+    return inFlightSamples_;
+  }
+
   /**
    * Schedule `fn` to run on the main server event base when the `timeout`
    * expires. This does not block until `fn` is scheduled.
@@ -506,6 +565,25 @@ class EdenServer : private TakeoverHandler {
   // all mounts.
   void unloadInodes();
 
+#ifndef _WIN32
+  // Unload the inodes of every mount, or only of the NFS mounts if nfsOnly
+  // is set, that were last accessed before cutoff. Returns the number of
+  // inodes unloaded.
+  size_t unloadInodesLastAccessedBefore(
+      const timespec& cutoff,
+      bool nfsOnly = false);
+
+  // Unload the inodes of NFS mounts that were not accessed in the last
+  // nfs:inode-unload-age, since NFS never tells us they were forgotten.
+  void unloadNfsInodes();
+
+  // If resident memory is above the configured high watermark, unload one
+  // batch of the least recently accessed inodes. While memory stays above the
+  // target, each call unloads inodes accessed twice as recently as the
+  // previous one, down to the configured minimum age.
+  void unloadInodesUnderMemoryPressure();
+#endif
+
   FOLLY_NODISCARD folly::Future<folly::Unit> createThriftServer();
 
   void prepareThriftAddress() const;
@@ -527,6 +605,14 @@ class EdenServer : private TakeoverHandler {
    * recoverImpl() contains the bulk of the implementation of recover()
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> recoverImpl(TakeoverData&& data);
+
+  /**
+   * Reload the objects the previous process had cached in memory, as listed
+   * in its TakeoverData, from the local store in the background.
+   */
+  void warmObjectCaches(
+      std::vector<ObjectId> blobIds,
+      std::vector<ObjectId> treeIds);
 #endif // !_WIN32
 
   /**
@@ -591,6 +677,13 @@ class EdenServer : private TakeoverHandler {
   // Report memory usage statistics to ServiceData.
   void reportMemoryStats();
 
+  // Record the filesystem requests and source control imports currently in
+  // flight in inFlightSamples_.
+  void sampleInFlightRequests();
+
+  // Start writing back the modified inode metadata of every mount.
+  void flushInodeMetadata();
+
   // Compute stats for the local store and perform garbage collection if
   // necessary
   void manageLocalStore();
@@ -647,6 +740,13 @@ class EdenServer : private TakeoverHandler {
   std::unique_ptr<TakeoverServer> takeoverServer_;
 #endif // !_WIN32
 
+#ifdef __linux__
+  /**
+   * Hands large Thrift responses to local clients in shared memory.
+   */
+  std::unique_ptr<SharedMemoryServer> sharedMemoryServer_;
+#endif // __linux__
+
   /**
    * Information about whether the EdenServer is starting, running, or shutting
    * down, including whether it is performing a graceful restart.
@@ -748,6 +848,8 @@ class EdenServer : private TakeoverHandler {
 
   const std::unique_ptr<folly::Synchronized<ProgressManager>> progressManager_;
 
+  InFlightSampleLog inFlightSamples_;
+
   PeriodicFnTask<&EdenServer::reloadConfig> reloadConfigTask_{
       this,
       "reload_config"};
@@ -757,13 +859,31 @@ class EdenServer : private TakeoverHandler {
   PeriodicFnTask<&EdenServer::reportMemoryStats> memoryStatsTask_{
       this,
       "mem_stats"};
-  PeriodicFnTask<&EdenServer::manageLocalStore> localStoreTask_{
+  PeriodicFnTask<&EdenServer::sampleInFlightRequests> inFlightSampleTask_{
+      this,
+      "in_flight_sample"};
+
+#ifndef _WIN32
+  PeriodicFnTask<&EdenServer::unloadInodesUnderMemoryPressure>
+      memoryPressureUnloadTask_{this, "memory_pressure_unload"};
+
+  PeriodicFnTask<&EdenServer::flushInodeMetadata> inodeMetadataFlushTask_{
       this,
-      "local_store"};
+      "inode_metadata_flush"};
 
-  PeriodicFnTask<&EdenServer::refreshBackingStore> backingStoreTask_{
+  PeriodicFnTask<&EdenServer::unloadNfsInodes> nfsInodeUnloadTask_{
       this,
-      "backing_store"};
+      "nfs_inode_unload"};
+
+  // The age of the inodes the next memory pressure driven unload will
+  // unload, or std::nullopt if memory usage is not above the target. Only
+  // accessed from the main event base thread.
+  std::optional<std::chrono::nanoseconds> memoryPressureUnloadAge_;
+#endif
+
+  // Runs the local and backing store management, holding the local store
+  // garbage collection back until the host is idle.
+  MaintenanceScheduler maintenanceScheduler_{this};
 };
 } // namespace eden
 } // namespace facebook
@@ -9,6 +9,7 @@
 
 #include <sys/types.h>
 #include <algorithm>
+#include <mutex>
 #include <optional>
 #include <typeinfo>
 
@@ -20,12 +21,14 @@
 #include <folly/chrono/Conv.h>
 #include <folly/container/Access.h>
 #include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/logging/Logger.h>
 #include <folly/logging/LoggerDB.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include <folly/system/Shell.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #ifndef _WIN32
 #include "eden/fs/fuse/FuseChannel.h"
@@ -55,7 +58,12 @@
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/model/TreeFilter.h"
+#include "eden/fs/service/ChromeTraceCapture.h"
 #include "eden/fs/service/EdenServer.h"
+#include "eden/fs/service/SharedMemoryServer.h"
+#include "eden/fs/service/ThriftAdmissionController.h"
+#include "eden/fs/service/ThriftClientAccounting.h"
 #include "eden/fs/service/ThriftPermissionChecker.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/service/gen-cpp2/eden_constants.h"
@@ -65,10 +73,10 @@
 #include "eden/fs/store/Diff.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
+#include "eden/fs/store/NameIndex.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/PathLoader.h"
-#include "eden/fs/store/ScmStatusDiffCallback.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/Tracing.h"
@@ -76,6 +84,7 @@
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/ProcUtil.h"
 #include "eden/fs/utils/StatTimes.h"
@@ -158,8 +167,21 @@ class ThriftFetchContext : public ObjectFetchContext {
  public:
   explicit ThriftFetchContext(
       std::optional<pid_t> pid,
-      folly::StringPiece endpoint)
-      : pid_(pid), endpoint_(endpoint) {}
+      folly::StringPiece endpoint,
+      uint64_t requestId,
+      folly::CancellationToken cancellation,
+      ThriftClientAccounting& clientAccounting)
+      : pid_(pid),
+        endpoint_(endpoint),
+        requestId_(requestId),
+        cancellation_(std::move(cancellation)),
+        clientAccounting_(clientAccounting) {}
+
+  void didFetch(ObjectType, const ObjectId&, Origin origin) override {
+    if (pid_ && origin == ObjectFetchContext::FromNetworkFetch) {
+      clientAccounting_.recordBackingStoreFetch(*pid_);
+    }
+  }
 
   std::optional<pid_t> getClientPid() const override {
     return pid_;
@@ -173,6 +195,14 @@ class ThriftFetchContext : public ObjectFetchContext {
     return endpoint_;
   }
 
+  std::optional<uint64_t> getRequestId() const override {
+    return requestId_;
+  }
+
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellation_;
+  }
+
   const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
   getRequestInfo() const override {
     return &requestInfo_;
@@ -191,15 +221,19 @@ class ThriftFetchContext : public ObjectFetchContext {
  private:
   std::optional<pid_t> pid_;
   folly::StringPiece endpoint_;
+  uint64_t requestId_;
+  folly::CancellationToken cancellation_;
   std::unordered_map<std::string, std::string> requestInfo_;
+  ThriftClientAccounting& clientAccounting_;
 };
 
 class PrefetchFetchContext : public ObjectFetchContext {
  public:
   explicit PrefetchFetchContext(
       std::optional<pid_t> pid,
-      folly::StringPiece endpoint)
-      : pid_(pid), endpoint_(endpoint) {}
+      folly::StringPiece endpoint,
+      uint64_t requestId)
+      : pid_(pid), endpoint_(endpoint), requestId_(requestId) {}
 
   std::optional<pid_t> getClientPid() const override {
     return pid_;
@@ -213,14 +247,31 @@ class PrefetchFetchContext : public ObjectFetchContext {
     return endpoint_;
   }
 
+  std::optional<uint64_t> getRequestId() const override {
+    return requestId_;
+  }
+
   const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
   getRequestInfo() const override {
     return nullptr;
   }
 
+  ImportPriority getPriority() const override {
+    return priority_;
+  }
+
+  /**
+   * Must be called before the context is used for any fetch.
+   */
+  void setPriority(ImportPriority priority) {
+    priority_ = priority;
+  }
+
  private:
   std::optional<pid_t> pid_;
   folly::StringPiece endpoint_;
+  uint64_t requestId_;
+  ImportPriority priority_{ImportPriority::kNormal()};
 };
 
 // Helper class to log where the request completes in Future
@@ -236,23 +287,32 @@ class ThriftLogHelper {
       folly::StringPiece itcFunctionName,
       folly::StringPiece itcFileName,
       uint32_t itcLineNumber,
-      std::optional<pid_t> pid)
+      std::optional<pid_t> pid,
+      folly::CancellationToken cancellation,
+      ThriftClientAccounting& clientAccounting)
       : itcFunctionName_(itcFunctionName),
         itcFileName_(itcFileName),
         itcLineNumber_(itcLineNumber),
         level_(level),
         itcLogger_(logger),
-        fetchContext_{pid, itcFunctionName},
-        prefetchFetchContext_{pid, itcFunctionName} {}
+        requestId_(generateUniqueID()),
+        fetchContext_{
+            pid,
+            itcFunctionName,
+            requestId_,
+            std::move(cancellation),
+            clientAccounting},
+        prefetchFetchContext_{pid, itcFunctionName, requestId_} {}
 
   ~ThriftLogHelper() {
     // Logging completion time for the request
     // The line number points to where the object was originally created
     TLOG(itcLogger_, level_, itcFileName_, itcLineNumber_) << fmt::format(
-        "{}() took {} {}",
+        "{}() took {} {} (request {})",
         itcFunctionName_,
         itcTimer_.elapsed().count(),
-        EDEN_MICRO);
+        EDEN_MICRO,
+        requestId_);
   }
 
   PrefetchFetchContext& getPrefetchFetchContext() {
@@ -274,6 +334,8 @@ class ThriftLogHelper {
   folly::LogLevel level_;
   folly::Logger itcLogger_;
   folly::stop_watch<std::chrono::microseconds> itcTimer_ = {};
+  // Shared by both fetch contexts: they serve the same Thrift call.
+  uint64_t requestId_;
   ThriftFetchContext fetchContext_;
   PrefetchFetchContext prefetchFetchContext_;
 };
@@ -302,6 +364,16 @@ RelativePath relpathFromUserPath(StringPiece userPath) {
   }
 }
 
+std::vector<RelativePath> relpathsFromUserPaths(
+    const std::vector<std::string>& userPaths) {
+  std::vector<RelativePath> paths;
+  paths.reserve(userPaths.size());
+  for (const auto& userPath : userPaths) {
+    paths.push_back(relpathFromUserPath(userPath));
+  }
+  return paths;
+}
+
 facebook::eden::InodePtr inodeFromUserPath(
     facebook::eden::EdenMount& mount,
     StringPiece rootRelativePath,
@@ -332,7 +404,9 @@ facebook::eden::InodePtr inodeFromUserPath(
         functionName,                                                 \
         fileName,                                                     \
         lineNumber,                                                   \
-        getAndRegisterClientPid());                                   \
+        getAndRegisterClientPid(),                                    \
+        getClientCancellationToken(),                                 \
+        *clientAccounting_);                                          \
   }(__func__, __FILE__, __LINE__))
 
 // INSTRUMENT_THRIFT_CALL_WITH_FUNCTION_NAME_AND_PID works in the same way
@@ -355,7 +429,9 @@ facebook::eden::InodePtr inodeFromUserPath(
         functionName,                                                 \
         fileName,                                                     \
         lineNumber,                                                   \
-        pid);                                                         \
+        pid,                                                          \
+        folly::CancellationToken{},                                   \
+        *clientAccounting_);                                          \
   }(__FILE__, __LINE__))
 
 namespace facebook::eden {
@@ -367,7 +443,11 @@ EdenServiceHandler::EdenServiceHandler(
     EdenServer* server)
     : BaseService{kServiceName},
       originalCommandLine_{std::move(originalCommandLine)},
-      server_{server} {
+      server_{server},
+      admissionController_{std::make_shared<ThriftAdmissionController>(
+          server_->getServerState())},
+      clientAccounting_{std::make_shared<ThriftClientAccounting>(
+          server_->getServerState())} {
   struct HistConfig {
     int64_t bucketSize{250};
     int64_t min{0};
@@ -423,6 +503,8 @@ EdenServiceHandler::getProcessor() {
     processor->addEventHandler(
         std::make_shared<ThriftPermissionChecker>(server_->getServerState()));
   }
+  processor->addEventHandler(admissionController_);
+  processor->addEventHandler(clientAccounting_);
   return processor;
 }
 
@@ -495,6 +577,51 @@ void EdenServiceHandler::checkOutRevision(
   results = std::move(std::move(checkoutFuture).get().conflicts);
 }
 
+bool EdenServiceHandler::cancelCheckout(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  return server_->getMount(mountPath)->cancelCheckout();
+}
+
+void EdenServiceHandler::setCheckoutFilter(
+    std::vector<CheckoutConflict>& results,
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<std::vector<std::string>> excludedPaths,
+    CheckoutMode checkoutMode) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG1,
+      *mountPoint,
+      toLogArg(*excludedPaths),
+      apache::thrift::util::enumName(checkoutMode, "(unknown)"));
+
+  std::vector<RelativePath> paths;
+  paths.reserve(excludedPaths->size());
+  for (const auto& path : *excludedPaths) {
+    paths.emplace_back(path);
+  }
+  auto filter = std::make_shared<const TreeFilter>(std::move(paths));
+
+  auto edenMount = server_->getMount(AbsolutePathPiece{*mountPoint});
+  auto checkoutFuture = edenMount->checkout(
+      edenMount->getWorkingCopyParent(),
+      helper->getFetchContext().getClientPid(),
+      helper->getFunctionName(),
+      checkoutMode,
+      std::move(filter));
+  results = std::move(std::move(checkoutFuture).get().conflicts);
+}
+
+void EdenServiceHandler::getCheckoutFilter(
+    std::vector<std::string>& results,
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto edenMount = server_->getMount(AbsolutePathPiece{*mountPoint});
+  for (const auto& path : edenMount->getCheckoutFilter()->getExcludedPaths()) {
+    results.push_back(path.value());
+  }
+}
+
 void EdenServiceHandler::resetParentCommits(
     std::unique_ptr<std::string> mountPoint,
     std::unique_ptr<WorkingDirectoryParents> parents,
@@ -626,32 +753,111 @@ ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
       });
 }
 
-ImmediateFuture<BlobMetadata> EdenServiceHandler::getBlobMetadataForPath(
+ImmediateFuture<std::vector<ImmediateFuture<BlobMetadata>>>
+EdenServiceHandler::startBlobMetadataForPaths(
     AbsolutePathPiece mountPoint,
-    StringPiece path,
+    const std::vector<std::string>& paths,
+    bool includeBlake3,
     ObjectFetchContext& fetchContext) {
-  if (path.empty()) {
-    return ImmediateFuture<BlobMetadata>(newEdenError(
-        EINVAL,
-        EdenErrorType::ARGUMENT_ERROR,
-        "path cannot be the empty string"));
-  }
+  auto edenMount = server_->getMount(mountPoint);
+  auto objectStore = edenMount->getObjectStore();
 
-  try {
-    auto edenMount = server_->getMount(mountPoint);
-    auto objectStore = edenMount->getObjectStore();
-    auto relativePath = RelativePathPiece{path};
-
-    return edenMount->getInodeOrTreeOrEntry(relativePath, fetchContext)
-        .thenValue([relativePath, objectStore, &fetchContext](
-                       const InodeOrTreeOrEntry& inodeOrTree) {
-          return inodeOrTree.getBlobMetadata(
-              relativePath, objectStore, fetchContext);
-        });
-  } catch (const std::exception& e) {
-    return ImmediateFuture<BlobMetadata>(
-        newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what()));
-  }
+  ImmediateFuture<std::vector<Try<InodeOrTreeOrEntry>>> entriesFuture =
+      collectAll(applyToInodeOrTreeOrEntry(
+          edenMount->getRootInode(),
+          paths,
+          [](const InodeOrTreeOrEntry& entry) { return entry; },
+          objectStore,
+          fetchContext));
+
+  return std::move(entriesFuture)
+      .thenValue([edenMount, paths, includeBlake3, objectStore, &fetchContext](
+                     std::vector<Try<InodeOrTreeOrEntry>>&& entries) mutable {
+        // Files whose metadata comes from the ObjectStore are looked up
+        // together. The others are materialized, or errors.
+        std::vector<ObjectId> ids;
+        std::vector<bool> sourceBacked(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+          if (entries[i].hasValue() && !paths[i].empty()) {
+            if (auto id = entries[i]->getSourceBlobId()) {
+              ids.push_back(std::move(*id));
+              sourceBacked[i] = true;
+            }
+          }
+        }
+
+        auto getMetadata =
+            [&paths, &entries, includeBlake3, objectStore, &fetchContext](
+                size_t i) {
+              if (entries[i].hasException()) {
+                return makeImmediateFuture<BlobMetadata>(
+                    entries[i].exception());
+              }
+              if (paths[i].empty()) {
+                return makeImmediateFuture<BlobMetadata>(newEdenError(
+                    EINVAL,
+                    EdenErrorType::ARGUMENT_ERROR,
+                    "path cannot be the empty string"));
+              }
+              return entries[i]->getBlobMetadata(
+                  RelativePathPiece{paths[i]},
+                  objectStore,
+                  fetchContext,
+                  includeBlake3);
+            };
+
+        // Warm the metadata cache with a single LocalStore lookup, so that
+        // the getBlobMetadata() calls for the source backed files don't each
+        // read it. Meanwhile, read the materialized files, each in a single
+        // pass over its overlay file.
+        auto prefetched = objectStore->prefetchBlobMetadata(std::move(ids));
+        std::vector<std::optional<ImmediateFuture<BlobMetadata>>> futures(
+            entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+          if (!sourceBacked[i]) {
+            futures[i] = getMetadata(i);
+          }
+        }
+
+        return std::move(prefetched)
+            .thenTry([edenMount,
+                      paths = std::move(paths),
+                      entries = std::move(entries),
+                      sourceBacked = std::move(sourceBacked),
+                      futures = std::move(futures),
+                      includeBlake3,
+                      objectStore,
+                      &fetchContext](auto&&) mutable {
+              std::vector<ImmediateFuture<BlobMetadata>> results;
+              results.reserve(entries.size());
+              for (size_t i = 0; i < entries.size(); ++i) {
+                if (sourceBacked[i]) {
+                  results.push_back(entries[i]->getBlobMetadata(
+                      RelativePathPiece{paths[i]},
+                      objectStore,
+                      fetchContext,
+                      includeBlake3));
+                } else {
+                  results.push_back(std::move(*futures[i]));
+                }
+              }
+              return results;
+            });
+      });
+}
+
+ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+EdenServiceHandler::getBlobMetadataForPaths(
+    AbsolutePathPiece mountPoint,
+    const std::vector<std::string>& paths,
+    bool includeBlake3,
+    ObjectFetchContext& fetchContext) {
+  return startBlobMetadataForPaths(
+             mountPoint, paths, includeBlake3, fetchContext)
+      .thenValue(
+          [](std::vector<ImmediateFuture<BlobMetadata>>&& futures) {
+            return facebook::eden::collectAll(std::move(futures));
+          });
 }
 
 void EdenServiceHandler::getBindMounts(
@@ -776,6 +982,13 @@ EdenServiceHandler::subscribeStreamTemporary(
   auto stream = std::make_shared<Publisher>(
       std::move(streamAndPublisher.second), std::move(disconnected));
 
+  // Clients query the journal after each notification, so coalesce them
+  // during write storms if configured to.
+  auto config = server_->getServerState()->getEdenConfig();
+  Journal::SubscriberOptions options;
+  options.minInterval = config->streamNotificationInterval.getValue();
+  options.maxDeltas = config->streamNotificationMaxDeltas.getValue();
+
   // Register onJournalChange with the journal subsystem, and assign
   // the subscriber id into the handle so that the callbacks can consume it.
   handle->emplace(edenMount->getJournal().registerSubscriber(
@@ -785,7 +998,8 @@ EdenServiceHandler::subscribeStreamTemporary(
         // the subscriber should call getCurrentJournalPosition or
         // getFilesChangedSince.
         stream->publisher.next(pos);
-      }));
+      },
+      options));
 
   return std::move(streamAndPublisher.first);
 }
@@ -879,6 +1093,7 @@ NfsCall populateNfsCall(const NfsTraceEvent& event) {
   nfsCall.xid_ref() = event.getXid();
   nfsCall.procNumber_ref() = event.getProcNumber();
   nfsCall.procName_ref() = nfsProcName(event.getProcNumber());
+  nfsCall.requestId_ref() = event.getRequestId();
   return nfsCall;
 }
 
@@ -1107,27 +1322,39 @@ apache::thrift::ServerStream<FsEvent> EdenServiceHandler::traceFsEvents(
   return std::move(serverStream);
 }
 
-apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
-    std::unique_ptr<std::string> mountPoint) {
-  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
-  auto mountPath = AbsolutePathPiece{*mountPoint};
-  auto edenMount = server_->getMount(mountPath);
-  auto backingStore = edenMount->getObjectStore()->getBackingStore();
-  std::shared_ptr<HgQueuedBackingStore> hgBackingStore{nullptr};
+namespace {
+/**
+ * Chrome traces are kept in memory until the capture ends.
+ */
+constexpr std::chrono::minutes kMaxChromeTraceDuration{10};
 
+/**
+ * Returns the HgQueuedBackingStore of a mount, or null if it uses another kind
+ * of backing store.
+ */
+std::shared_ptr<HgQueuedBackingStore> getHgQueuedBackingStore(
+    const std::shared_ptr<BackingStore>& backingStore) {
   // TODO: remove these dynamic casts in favor of a QueryInterface method
   // BackingStore -> LocalStoreCachedBackingStore
   auto localStoreCachedBackingStore =
       std::dynamic_pointer_cast<LocalStoreCachedBackingStore>(backingStore);
   if (!localStoreCachedBackingStore) {
     // BackingStore -> HgQueuedBackingStore
-    hgBackingStore =
-        std::dynamic_pointer_cast<HgQueuedBackingStore>(backingStore);
-  } else {
-    // LocalStoreCachedBackingStore -> HgQueuedBackingStore
-    hgBackingStore = std::dynamic_pointer_cast<HgQueuedBackingStore>(
-        localStoreCachedBackingStore->getBackingStore());
+    return std::dynamic_pointer_cast<HgQueuedBackingStore>(backingStore);
   }
+  // LocalStoreCachedBackingStore -> HgQueuedBackingStore
+  return std::dynamic_pointer_cast<HgQueuedBackingStore>(
+      localStoreCachedBackingStore->getBackingStore());
+}
+} // namespace
+
+apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+  auto backingStore = edenMount->getObjectStore()->getBackingStore();
+  auto hgBackingStore = getHgQueuedBackingStore(backingStore);
 
   if (!hgBackingStore) {
     // typeid() does not evaluate expressions
@@ -1206,6 +1433,9 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
         }
 
         te.unique_ref() = event.unique;
+        if (event.requestId != 0) {
+          te.requestId_ref() = event.requestId;
+        }
 
         te.manifestNodeId_ref() = event.manifestNodeId.toString();
         te.path_ref() = event.getPath();
@@ -1219,6 +1449,73 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
   return std::move(serverStream);
 }
 
+folly::SemiFuture<std::unique_ptr<ChromeTraceResult>>
+EdenServiceHandler::semifuture_captureChromeTrace(
+    std::unique_ptr<CaptureChromeTraceParams> params) {
+  auto mountPoint = params->get_mountPoint();
+  auto duration = std::chrono::milliseconds{params->get_durationMs()};
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1, mountPoint, duration.count());
+  if (duration.count() <= 0 || duration > kMaxChromeTraceDuration) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "durationMs must be between 1 and ",
+        kMaxChromeTraceDuration.count());
+  }
+  auto edenMount = server_->getMount(AbsolutePathPiece{mountPoint});
+  auto capture = std::make_shared<ChromeTraceCapture>(
+      server_->getServerState()->getProcessNameCache());
+  auto name = folly::to<std::string>(
+      "chrometrace-", edenMount->getPath().basename());
+
+  // The subscriptions are dropped once the capture ends. The subscribers own
+  // the capture, since they may still be called after that.
+  struct Subscriptions {
+#ifndef _WIN32
+    TraceSubscriptionHandle<FuseTraceEvent> fuse;
+    TraceSubscriptionHandle<NfsTraceEvent> nfs;
+#endif
+    TraceSubscriptionHandle<HgImportTraceEvent> hg;
+    TraceSubscriptionHandle<CheckoutTraceEvent> checkout;
+  };
+  auto subscriptions = std::make_unique<Subscriptions>();
+#ifndef _WIN32
+  if (auto* fuseChannel = edenMount->getFuseChannel()) {
+    subscriptions->fuse = fuseChannel->getTraceBus().subscribeFunction(
+        name, [capture](const FuseTraceEvent& event) {
+          capture->observe(event);
+        });
+  } else if (auto* nfsdChannel = edenMount->getNfsdChannel()) {
+    subscriptions->nfs = nfsdChannel->getTraceBus().subscribeFunction(
+        name, [capture](const NfsTraceEvent& event) {
+          capture->observe(event);
+        });
+  }
+#endif
+  if (auto hgBackingStore = getHgQueuedBackingStore(
+          edenMount->getObjectStore()->getBackingStore())) {
+    subscriptions->hg = hgBackingStore->getTraceBus().subscribeFunction(
+        name, [capture](const HgImportTraceEvent& event) {
+          capture->observe(event);
+        });
+  }
+  subscriptions->checkout = edenMount->getCheckoutTraceBus().subscribeFunction(
+      name,
+      [capture](const CheckoutTraceEvent& event) { capture->observe(event); });
+
+  return wrapImmediateFuture(
+             std::move(helper),
+             ImmediateFuture<folly::Unit>{folly::futures::sleep(duration)}
+                 .thenValue([capture, subscriptions = std::move(subscriptions)](
+                                auto&&) mutable {
+                   subscriptions.reset();
+                   auto result = std::make_unique<ChromeTraceResult>();
+                   result->json_ref() = capture->finish();
+                   return result;
+                 }))
+      .semi();
+}
+
 namespace {
 void checkMountGeneration(
     const JournalPosition& position,
@@ -1251,13 +1548,19 @@ void publishFile(
 
 class StreamingDiffCallback : public DiffCallback {
  public:
-  explicit StreamingDiffCallback(
+  StreamingDiffCallback(
       std::shared_ptr<
           folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
-          publisher)
-      : publisher_{std::move(publisher)} {}
-
-  void ignoredPath(RelativePathPiece, dtype_t) override {}
+          publisher,
+      bool listIgnored)
+      : publisher_{std::move(publisher)}, listIgnored_{listIgnored} {}
+
+  void ignoredPath(RelativePathPiece path, dtype_t type) override {
+    if (listIgnored_) {
+      publishFile(
+          *publisher_, path.stringPiece(), ScmFileStatus::IGNORED, type);
+    }
+  }
 
   void addedPath(RelativePathPiece path, dtype_t type) override {
     publishFile(*publisher_, path.stringPiece(), ScmFileStatus::ADDED, type);
@@ -1281,6 +1584,7 @@ class StreamingDiffCallback : public DiffCallback {
   std::shared_ptr<
       folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
       publisher_;
+  bool listIgnored_;
 };
 
 } // namespace
@@ -1375,7 +1679,8 @@ EdenServiceHandler::streamChangesSince(
   }
 
   if (summed->snapshotTransitions.size() > 1) {
-    auto callback = std::make_shared<StreamingDiffCallback>(sharedPublisher);
+    auto callback = std::make_shared<StreamingDiffCallback>(
+        sharedPublisher, /*listIgnored=*/false);
 
     std::vector<ImmediateFuture<folly::Unit>> futures;
     for (auto rootIt = summed->snapshotTransitions.begin();
@@ -1413,6 +1718,66 @@ EdenServiceHandler::streamChangesSince(
   return {std::move(result), std::move(serverStream)};
 }
 
+apache::thrift::ServerStream<ChangedFileResult>
+EdenServiceHandler::streamScmStatus(
+    std::unique_ptr<GetScmStatusParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2,
+      *params->mountPoint_ref(),
+      folly::to<string>("commitHash=", logHash(*params->commit_ref())),
+      folly::to<string>("listIgnored=", *params->listIgnored_ref()));
+
+  auto mountPath = AbsolutePathPiece{*params->mountPoint_ref()};
+  auto mount = server_->getMount(mountPath);
+  auto rootId = mount->getObjectStore()->parseRootId(*params->commit_ref());
+  auto listIgnored = *params->listIgnored_ref();
+  const auto& enforceParents = server_->getServerState()
+                                   ->getReloadableConfig()
+                                   ->getEdenConfig()
+                                   ->enforceParents.getValue();
+
+  // As in streamChangesSince, the publisher doesn't wait for the client to
+  // consume the files before publishing more. The diff can still produce
+  // them faster than the client reads them, but EdenFS no longer builds the
+  // whole ScmStatus before sending the first one.
+  auto cancellationSource = std::make_shared<folly::CancellationSource>();
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<ChangedFileResult>::createPublisher(
+          [cancellationSource] { cancellationSource->requestCancellation(); });
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+  auto callback =
+      std::make_shared<StreamingDiffCallback>(sharedPublisher, listIgnored);
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      mount
+          ->diff(
+              callback.get(),
+              rootId,
+              listIgnored,
+              enforceParents,
+              cancellationSource->getToken(),
+              relpathsFromUserPaths(*params->pathPrefixes_ref()))
+          // Make sure that the mount, callback, helper and cancellationSource
+          // live for the duration of the stream by copying them.
+          .thenTry([mount,
+                    sharedPublisher,
+                    callback = std::move(callback),
+                    helper = std::move(helper),
+                    cancellationSource](folly::Try<folly::Unit>&& result) {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 void EdenServiceHandler::getFilesChangedSince(
     FileDelta& out,
     std::unique_ptr<std::string> mountPoint,
@@ -1661,6 +2026,39 @@ EdenServiceHandler::semifuture_getFileInformation(
 #define ATTR_BITMASK(req, attr) \
   ((req) & static_cast<uint64_t>((FileAttributes::attr)))
 
+namespace {
+/**
+ * Convert the metadata of a file to the attributes requested in
+ * `reqBitmask`, or to the error that prevented computing them.
+ */
+FileAttributeDataOrError makeFileAttributeDataOrError(
+    const folly::Try<BlobMetadata>& tryMetadata,
+    uint64_t reqBitmask) {
+  FileAttributeDataOrError fileResult;
+  if (tryMetadata.hasException()) {
+    fileResult.error_ref() = newEdenError(tryMetadata.exception());
+    return fileResult;
+  }
+
+  FileAttributeData fileData;
+  const auto& metadata = tryMetadata.value();
+  // Only fill in requested fields
+  if (ATTR_BITMASK(reqBitmask, SHA1_HASH)) {
+    fileData.sha1_ref() = thriftHash20(metadata.sha1);
+  }
+  if (ATTR_BITMASK(reqBitmask, FILE_SIZE)) {
+    fileData.fileSize_ref() = metadata.size;
+  }
+  if (ATTR_BITMASK(reqBitmask, BLAKE3_HASH) && metadata.blake3) {
+    fileData.blake3_ref() = std::string{
+        reinterpret_cast<const char*>(metadata.blake3->data()),
+        metadata.blake3->size()};
+  }
+  fileResult.data_ref() = std::move(fileData);
+  return fileResult;
+}
+} // namespace
+
 folly::SemiFuture<std::unique_ptr<GetAttributesFromFilesResult>>
 EdenServiceHandler::semifuture_getAttributesFromFiles(
     std::unique_ptr<GetAttributesFromFilesParams> params) {
@@ -1682,45 +2080,21 @@ EdenServiceHandler::semifuture_getAttributesFromFiles(
                              paths = std::move(paths),
                              &fetchContext,
                              mountPath = mountPath.copy(),
-                             reqBitmask](auto&&) mutable {
-                   vector<ImmediateFuture<BlobMetadata>> futures;
-                   for (const auto& p : paths) {
-                     futures.emplace_back(
-                         getBlobMetadataForPath(mountPath, p, fetchContext));
-                   }
-
-                   // Collect all futures into a single tuple
-                   return facebook::eden::collectAll(std::move(futures))
-                       .thenValue([paths = std::move(paths), reqBitmask](
+                             reqBitmask](auto&&) {
+                   return getBlobMetadataForPaths(
+                              mountPath,
+                              paths,
+                              ATTR_BITMASK(reqBitmask, BLAKE3_HASH),
+                              fetchContext)
+                       .thenValue([reqBitmask](
                                       std::vector<folly::Try<BlobMetadata>>&&
                                           allRes) {
                          auto res =
                              std::make_unique<GetAttributesFromFilesResult>();
-                         auto sizeRequested =
-                             ATTR_BITMASK(reqBitmask, FILE_SIZE);
-                         auto sha1Requested =
-                             ATTR_BITMASK(reqBitmask, SHA1_HASH);
                          for (const auto& tryMetadata : allRes) {
-                           FileAttributeDataOrError file_res;
-                           // check for exceptions. if found, return EdenError
-                           // early
-                           if (tryMetadata.hasException()) {
-                             file_res.error_ref() =
-                                 newEdenError(tryMetadata.exception());
-                           } else { /* No exceptions, fill in data */
-                             FileAttributeData file_data;
-                             const auto& metadata = tryMetadata.value();
-                             // Only fill in requested fields
-                             if (sha1Requested) {
-                               file_data.sha1_ref() =
-                                   thriftHash20(metadata.sha1);
-                             }
-                             if (sizeRequested) {
-                               file_data.fileSize_ref() = metadata.size;
-                             }
-                             file_res.data_ref() = file_data;
-                           }
-                           res->res_ref()->emplace_back(file_res);
+                           res->res_ref()->emplace_back(
+                               makeFileAttributeDataOrError(
+                                   tryMetadata, reqBitmask));
                          }
                          return res;
                        });
@@ -1728,26 +2102,135 @@ EdenServiceHandler::semifuture_getAttributesFromFiles(
       .semi();
 }
 
-folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
-    folly::StringPiece mountPoint,
-    std::vector<std::string> globs,
-    std::vector<std::string> rootHashes,
-    folly::StringPiece searchRootUser,
-    GlobOptions globOptions,
-    folly::StringPiece caller,
-    std::optional<pid_t> pid) {
-  auto helper = INSTRUMENT_THRIFT_CALL_WITH_FUNCTION_NAME_AND_PID(
-      DBG3,
-      caller,
-      pid,
-      mountPoint,
-      toLogArg(globs),
-      globOptions.includeDotfiles);
+apache::thrift::ServerStream<FileAttributesResult>
+EdenServiceHandler::streamGetAttributesFromFiles(
+    std::unique_ptr<GetAttributesFromFilesParams> params) {
+  auto mountPoint = params->get_mountPoint();
   auto mountPath = AbsolutePathPiece{mountPoint};
-  auto edenMount = server_->getMount(mountPath);
+  auto paths = params->get_paths();
+  auto reqBitmask = params->get_requestedAttributes();
+  auto syncTimeout = getSyncTimeout(*params->sync_ref());
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3, mountPoint, syncTimeout.count(), toLogArg(paths));
+  auto& fetchContext = helper->getFetchContext();
+
+  // As in streamGlobFiles, the publisher doesn't wait for the client to
+  // consume the results before publishing more.
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<FileAttributesResult>::createPublisher(
+          [] {});
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<FileAttributesResult>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  auto future =
+      waitForPendingNotifications(*server_->getMount(mountPath), syncTimeout)
+          .thenValue([this,
+                      paths = std::move(paths),
+                      &fetchContext,
+                      mountPath = mountPath.copy(),
+                      reqBitmask](auto&&) {
+            return startBlobMetadataForPaths(
+                mountPath,
+                paths,
+                ATTR_BITMASK(reqBitmask, BLAKE3_HASH),
+                fetchContext);
+          })
+          .thenValue(
+              [sharedPublisher, reqBitmask](
+                  std::vector<ImmediateFuture<BlobMetadata>>&& futures) {
+                std::vector<ImmediateFuture<folly::Unit>> published;
+                published.reserve(futures.size());
+                for (size_t i = 0; i < futures.size(); ++i) {
+                  published.push_back(std::move(futures[i]).thenTry(
+                      [sharedPublisher, reqBitmask, i](
+                          folly::Try<BlobMetadata>&& tryMetadata) {
+                        FileAttributesResult result;
+                        result.index_ref() = static_cast<int64_t>(i);
+                        result.result_ref() =
+                            makeFileAttributeDataOrError(
+                                tryMetadata, reqBitmask);
+                        sharedPublisher->rlock()->next(std::move(result));
+                      }));
+                }
+                return facebook::eden::collectAll(std::move(published));
+              });
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(future)
+          // Make sure that the helper, which owns the fetch context, lives
+          // until the last result has been published.
+          .thenTry([sharedPublisher, helper = std::move(helper)](
+                       auto&& result) {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
 
+  return std::move(serverStream);
+}
+
+namespace {
+/**
+ * How many matching files each Glob in a streamGlobFiles() stream holds, at
+ * most.
+ */
+constexpr size_t kGlobStreamChunkSize = 1024;
+
+/**
+ * How many blobs are passed to a single ObjectStore::prefetchBlobs() call
+ * when prefetching the files matching globs.
+ */
+constexpr size_t kPrefetchBatchSize = 20480;
+
+/**
+ * Add `results` to `out` the way globFiles() reports them.
+ */
+void appendGlobResults(
+    Glob& out,
+    const std::vector<GlobNode::GlobResult>& results,
+    bool wantDtype,
+    bool listOnlyFiles,
+    RootIdCodec& rootIdCodec) {
+  for (auto& entry : results) {
+    if (!listOnlyFiles || entry.dtype != dtype_t::Dir) {
+      out.matchingFiles_ref()->emplace_back(
+          entry.name.stringPiece().toString());
+
+      if (wantDtype) {
+        out.dtypes_ref()->emplace_back(static_cast<OsDtype>(entry.dtype));
+      }
+
+      out.originHashes_ref()->emplace_back(
+          rootIdCodec.renderRootId(*entry.originHash));
+    }
+  }
+}
+
+/**
+ * Compile `globs` and evaluate them against `rootHashes`, or against the
+ * working copy if there are none, adding the matches to `globResults`.
+ *
+ * The RootIds that the results refer to are added to `originRootIds`, which
+ * must outlive the results.
+ */
+folly::Future<std::vector<folly::Try<folly::Unit>>> evaluateGlobs(
+    const std::shared_ptr<ServerState>& serverState,
+    const std::shared_ptr<EdenMount>& edenMount,
+    const std::vector<std::string>& globs,
+    const std::vector<std::string>& rootHashes,
+    RelativePath searchRoot,
+    bool includeDotfiles,
+    ObjectFetchContext& fetchContext,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch,
+    std::shared_ptr<GlobNode::ResultList> globResults,
+    std::vector<RootId>& originRootIds) {
   // Compile the list of globs into a tree
-  auto globRoot = std::make_shared<GlobNode>(globOptions.includeDotfiles);
+  auto globRoot = std::make_shared<GlobNode>(includeDotfiles);
   try {
     for (auto& globString : globs) {
       try {
@@ -1765,35 +2248,31 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     throw newEdenError(exc);
   }
 
-  auto fileBlobsToPrefetch = globOptions.prefetchFiles
-      ? std::make_shared<GlobNode::PrefetchList>()
-      : nullptr;
-
-  auto& fetchContext = helper->getPrefetchFetchContext();
-
-  // These hashes must outlive the GlobResult created by evaluate as the
-  // GlobResults will hold on to references to these hashes
-  auto originRootIds = std::make_unique<std::vector<RootId>>();
+  std::shared_ptr<GlobNode::ParallelEvaluation> parallel;
+  if (auto treeFetches =
+          serverState->getEdenConfig()->globTreeFetchConcurrency.getValue()) {
+    parallel = std::make_shared<GlobNode::ParallelEvaluation>(
+        serverState->getThreadPool().get(), treeFetches);
+  }
 
   // Globs will be evaluated against the specified commits or the current commit
-  // if none are specified. The results will be collected here.
+  // if none are specified.
   std::vector<folly::Future<folly::Unit>> globFutures{};
-  auto globResults = std::make_shared<GlobNode::ResultList>();
-
-  auto searchRoot = relpathFromUserPath(searchRootUser);
+  auto useNameIndex = searchRoot.empty() &&
+      serverState->getEdenConfig()->globUseNameIndex.getValue() &&
+      globRoot->canEvaluateFromNameIndex();
 
   if (!rootHashes.empty()) {
     // Note that we MUST reserve here, otherwise while emplacing we might
     // invalidate the earlier commitHash refrences
     globFutures.reserve(rootHashes.size());
-    originRootIds->reserve(rootHashes.size());
+    originRootIds.reserve(rootHashes.size());
     for (auto& rootHash : rootHashes) {
-      const RootId& originRootId = originRootIds->emplace_back(
+      const RootId& originRootId = originRootIds.emplace_back(
           edenMount->getObjectStore()->parseRootId(rootHash));
 
       globFutures.emplace_back(
-          edenMount->getObjectStore()
-              ->getRootTree(originRootId, fetchContext)
+          edenMount->getFilteredRootTree(originRootId, fetchContext)
               .thenValue([edenMount, globRoot, &fetchContext, searchRoot](
                              std::shared_ptr<const Tree>&& rootTree) {
                 return resolveTree(
@@ -1808,46 +2287,144 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
                    &fetchContext,
                    fileBlobsToPrefetch,
                    globResults,
-                   &originRootId](std::shared_ptr<const Tree>&& tree) mutable {
-                    return globRoot
-                        ->evaluate(
-                            edenMount->getObjectStore(),
-                            fetchContext,
-                            RelativePathPiece(),
-                            std::move(tree),
-                            fileBlobsToPrefetch.get(),
-                            *globResults,
-                            originRootId)
+                   &originRootId,
+                   parallel,
+                   useNameIndex](std::shared_ptr<const Tree>&& tree) mutable {
+                    auto index = useNameIndex
+                        ? edenMount->getNameIndexCache().get(
+                              originRootId, *tree)
+                        : ImmediateFuture<std::shared_ptr<const NameIndex>>{
+                              nullptr};
+                    return std::move(index)
+                        .thenValue(
+                            [edenMount,
+                             globRoot,
+                             &fetchContext,
+                             fileBlobsToPrefetch,
+                             globResults,
+                             &originRootId,
+                             parallel,
+                             tree = std::move(tree)](
+                                std::shared_ptr<const NameIndex> index) mutable
+                            -> ImmediateFuture<folly::Unit> {
+                              if (index &&
+                                  globRoot->evaluateFromNameIndex(
+                                      *index,
+                                      fileBlobsToPrefetch.get(),
+                                      *globResults,
+                                      originRootId)) {
+                                return folly::unit;
+                              }
+                              return globRoot->evaluate(
+                                  edenMount->getObjectStore(),
+                                  fetchContext,
+                                  RelativePathPiece(),
+                                  std::move(tree),
+                                  fileBlobsToPrefetch.get(),
+                                  *globResults,
+                                  originRootId,
+                                  parallel.get());
+                            })
                         .semi();
                   }));
     }
   } else {
     const RootId& originRootId =
-        originRootIds->emplace_back(edenMount->getCheckedOutRootId());
+        originRootIds.emplace_back(edenMount->getCheckedOutRootId());
+    // An unmaterialized search root is globbed from its source control tree,
+    // the way its unmaterialized subdirectories are, so that globbing it
+    // doesn't load inodes.
     globFutures.emplace_back(
-        edenMount->getInodeSlow(searchRoot, fetchContext)
+        edenMount->getInodeOrTreeOrEntry(searchRoot, fetchContext)
             .thenValue([&fetchContext,
                         globRoot,
                         edenMount,
                         fileBlobsToPrefetch,
                         globResults,
-                        &originRootId](InodePtr inode) mutable {
+                        &originRootId,
+                        parallel,
+                        searchRoot](InodeOrTreeOrEntry root) mutable
+                       -> ImmediateFuture<folly::Unit> {
+              if (!root.isDirectory()) {
+                throw PathError(ENOTDIR, searchRoot);
+              }
+              if (auto tree = root.asTreePtrOrNull()) {
+                return globRoot->evaluate(
+                    edenMount->getObjectStore(),
+                    fetchContext,
+                    RelativePathPiece(),
+                    std::move(tree),
+                    fileBlobsToPrefetch.get(),
+                    *globResults,
+                    originRootId,
+                    parallel.get());
+              }
               return globRoot->evaluate(
                   edenMount->getObjectStore(),
                   fetchContext,
                   RelativePathPiece(),
-                  inode.asTreePtr(),
+                  root.asInodePtr().asTreePtr(),
                   fileBlobsToPrefetch.get(),
                   *globResults,
-                  originRootId);
+                  originRootId,
+                  parallel.get());
             })
             .semi()
             .via(&folly::QueuedImmediateExecutor::instance()));
   }
 
+
+  return folly::collectAllUnsafe(std::move(globFutures))
+      .ensure([globRoot, parallel]() {
+        // keep globRoot and parallel alive until the end
+      });
+}
+} // namespace
+
+folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
+    folly::StringPiece mountPoint,
+    std::vector<std::string> globs,
+    std::vector<std::string> rootHashes,
+    folly::StringPiece searchRootUser,
+    GlobOptions globOptions,
+    folly::StringPiece caller,
+    std::optional<pid_t> pid) {
+  auto helper = INSTRUMENT_THRIFT_CALL_WITH_FUNCTION_NAME_AND_PID(
+      DBG3,
+      caller,
+      pid,
+      mountPoint,
+      toLogArg(globs),
+      globOptions.includeDotfiles);
+  auto mountPath = AbsolutePathPiece{mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+
+  auto fileBlobsToPrefetch = globOptions.prefetchFiles
+      ? std::make_shared<GlobNode::PrefetchList>()
+      : nullptr;
+
+  auto& fetchContext = helper->getPrefetchFetchContext();
+
+  // These hashes must outlive the GlobResult created by evaluate as the
+  // GlobResults will hold on to references to these hashes
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+  auto globResults = std::make_shared<GlobNode::ResultList>();
+
+  auto globFuture = evaluateGlobs(
+      server_->getServerState(),
+      edenMount,
+      globs,
+      rootHashes,
+      relpathFromUserPath(searchRootUser),
+      globOptions.includeDotfiles,
+      fetchContext,
+      fileBlobsToPrefetch,
+      globResults,
+      *originRootIds);
+
   auto prefetchFuture = wrapFuture(
       std::move(helper),
-      folly::collectAllUnsafe(std::move(globFutures))
+      std::move(globFuture)
           .thenValue([fileBlobsToPrefetch,
                       globResults = std::move(globResults),
                       suppressFileList = globOptions.suppressFileList](
@@ -1893,21 +2470,12 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
 
             if (!suppressFileList) {
               // already deduplicated at this point, no need to de-dup
-              for (auto& entry : results) {
-                if (!listOnlyFiles || entry.dtype != dtype_t::Dir) {
-                  out->matchingFiles_ref()->emplace_back(
-                      entry.name.stringPiece().toString());
-
-                  if (wantDtype) {
-                    out->dtypes_ref()->emplace_back(
-                        static_cast<OsDtype>(entry.dtype));
-                  }
-
-                  out->originHashes_ref()->emplace_back(
-                      edenMount->getObjectStore()->renderRootId(
-                          *entry.originHash));
-                }
-              }
+              appendGlobResults(
+                  *out,
+                  results,
+                  wantDtype,
+                  listOnlyFiles,
+                  *edenMount->getObjectStore());
             }
             if (fileBlobsToPrefetch) {
               std::vector<folly::Future<folly::Unit>> futures;
@@ -1916,9 +2484,9 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
               auto blobs = fileBlobsToPrefetch->rlock();
               auto range = folly::Range{blobs->data(), blobs->size()};
 
-              while (range.size() > 20480) {
-                auto curRange = range.subpiece(0, 20480);
-                range.advance(20480);
+              while (range.size() > kPrefetchBatchSize) {
+                auto curRange = range.subpiece(0, kPrefetchBatchSize);
+                range.advance(kPrefetchBatchSize);
                 futures.emplace_back(
                     store->prefetchBlobs(curRange, fetchContext));
               }
@@ -1933,8 +2501,8 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
             }
             return makeFuture(std::move(out));
           })
-          .ensure([globRoot, originRootIds = std::move(originRootIds)]() {
-            // keep globRoot and originRootIds alive until the end
+          .ensure([originRootIds = std::move(originRootIds)]() {
+            // keep originRootIds alive until the end
           }));
 
   if (!globOptions.background) {
@@ -1984,6 +2552,44 @@ EdenServiceHandler::future_setPathObjectId(
 #endif
 }
 
+folly::Future<std::unique_ptr<SetPathObjectIdResult>>
+EdenServiceHandler::future_setPathObjectIds(
+    std::unique_ptr<SetPathObjectIdsParams> params) {
+#ifndef _WIN32
+  auto mountPoint = params->get_mountPoint();
+  auto mountPath = AbsolutePathPiece{mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+  auto helper =
+      INSTRUMENT_THRIFT_CALL(DBG1, mountPoint, params->get_objects().size());
+
+  std::vector<SetPathObjectIdObject> objects;
+  objects.reserve(params->get_objects().size());
+  for (auto& object : *params->objects_ref()) {
+    objects.push_back(SetPathObjectIdObject{
+        RelativePath{object.get_path()},
+        edenMount->getObjectStore()->parseRootId(object.get_objectId()),
+        object.get_type()});
+  }
+
+  auto& fetchContext = helper->getFetchContext();
+  if (auto requestInfo = params->requestInfo_ref()) {
+    fetchContext.updateRequestInfo(std::move(*requestInfo));
+  }
+  return wrapFuture(
+      std::move(helper),
+      edenMount
+          ->setPathObjectIds(
+              std::move(objects), params->get_mode(), fetchContext)
+          .thenValue([](auto&& resultAndTimes) {
+            return std::make_unique<SetPathObjectIdResult>(
+                std::move(resultAndTimes.result));
+          }));
+#else
+  (void)params;
+  NOT_IMPLEMENTED();
+#endif
+}
+
 folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_removeRecursively(
     std::unique_ptr<RemoveRecursivelyParams> params) {
   auto mountPoint = params->get_mountPoint();
@@ -2124,6 +2730,274 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
       getAndRegisterClientPid());
 }
 
+folly::Future<std::unique_ptr<SharedMemoryResponse>>
+EdenServiceHandler::future_globFilesShared(std::unique_ptr<GlobParams> params) {
+  GlobOptions globOptions{*params};
+  return globFilesImpl(
+             *params->mountPoint_ref(),
+             *params->globs_ref(),
+             *params->revisions_ref(),
+             *params->searchRoot_ref(),
+             globOptions,
+             __func__,
+             getAndRegisterClientPid())
+      .thenValue([this](std::unique_ptr<Glob> glob) {
+        folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+        apache::thrift::CompactSerializer::serialize(*glob, &queue);
+        return std::make_unique<SharedMemoryResponse>(
+            publishSharedMemoryResponse(*queue.move()));
+      });
+}
+
+apache::thrift::ServerStream<Glob> EdenServiceHandler::streamGlobFiles(
+    std::unique_ptr<GlobParams> params) {
+  GlobOptions globOptions{*params};
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3,
+      *params->mountPoint_ref(),
+      toLogArg(*params->globs_ref()),
+      globOptions.includeDotfiles);
+  auto mountPath = AbsolutePathPiece{*params->mountPoint_ref()};
+  auto edenMount = server_->getMount(mountPath);
+
+  // As in streamChangesSince, the publisher doesn't wait for the client to
+  // consume the chunks before publishing more, but at most one chunk of
+  // results is held in memory at a time.
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<Glob>::createPublisher([] {});
+  auto sharedPublisher =
+      std::make_shared<folly::Synchronized<ThriftStreamPublisherOwner<Glob>>>(
+          ThriftStreamPublisherOwner{std::move(publisher)});
+  auto globResults = std::make_shared<GlobNode::ResultList>(
+      kGlobStreamChunkSize,
+      [edenMount,
+       sharedPublisher,
+       wantDtype = globOptions.wantDtype,
+       listOnlyFiles = globOptions.listOnlyFiles](
+          std::vector<GlobNode::GlobResult>&& results) {
+        Glob chunk;
+        appendGlobResults(
+            chunk,
+            results,
+            wantDtype,
+            listOnlyFiles,
+            *edenMount->getObjectStore());
+        if (!chunk.matchingFiles_ref()->empty()) {
+          sharedPublisher->rlock()->next(std::move(chunk));
+        }
+      });
+
+  auto& fetchContext = helper->getFetchContext();
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+  auto globFuture = evaluateGlobs(
+      server_->getServerState(),
+      edenMount,
+      *params->globs_ref(),
+      *params->revisions_ref(),
+      relpathFromUserPath(*params->searchRoot_ref()),
+      globOptions.includeDotfiles,
+      fetchContext,
+      /*fileBlobsToPrefetch=*/nullptr,
+      globResults,
+      *originRootIds);
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(globFuture)
+          // Make sure that the helper and the RootIds the results refer to
+          // live until the last chunk has been published.
+          .thenValue([sharedPublisher,
+                      globResults = std::move(globResults),
+                      helper = std::move(helper),
+                      originRootIds = std::move(originRootIds)](
+                         std::vector<folly::Try<folly::Unit>>&& tries) {
+            for (auto& try_ : tries) {
+              if (try_.hasException()) {
+                auto publisher = std::move(*sharedPublisher->wlock());
+                std::move(publisher).next(
+                    newEdenError(std::move(try_).exception()));
+                return;
+              }
+            }
+            globResults->flush();
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
+namespace {
+ImportPriorityKind toImportPriorityKind(HgImportPriority priority) {
+  switch (priority) {
+    case HgImportPriority::LOW:
+      return ImportPriorityKind::Low;
+    case HgImportPriority::NORMAL:
+      return ImportPriorityKind::Normal;
+    case HgImportPriority::HIGH:
+      return ImportPriorityKind::High;
+  }
+  throw newEdenError(
+      EdenErrorType::ARGUMENT_ERROR,
+      "unknown import priority ",
+      static_cast<int>(priority));
+}
+
+using SharedPrefetchPublisher = std::shared_ptr<
+    folly::Synchronized<ThriftStreamPublisherOwner<PrefetchProgress>>>;
+
+/**
+ * Fetch the blobs from `start` on, one batch at a time, publishing the
+ * progress after each batch. Stops early once `cancelled` is set.
+ */
+folly::Future<Unit> prefetchBatches(
+    std::shared_ptr<EdenMount> edenMount,
+    std::shared_ptr<const std::vector<ObjectId>> blobs,
+    size_t start,
+    size_t batchSize,
+    PrefetchProgress progress,
+    ObjectFetchContext& fetchContext,
+    SharedPrefetchPublisher publisher,
+    std::shared_ptr<std::atomic<bool>> cancelled) {
+  if (start >= blobs->size() || cancelled->load()) {
+    return folly::unit;
+  }
+  auto end = std::min(start + batchSize, blobs->size());
+  auto batch = ObjectIdRange{blobs->data() + start, blobs->data() + end};
+  folly::stop_watch<std::chrono::microseconds> batchTimer;
+  return edenMount->getObjectStore()
+      ->prefetchBlobs(batch, fetchContext)
+      .thenValue([edenMount,
+                  blobs,
+                  start,
+                  end,
+                  batchSize,
+                  progress = std::move(progress),
+                  &fetchContext,
+                  publisher = std::move(publisher),
+                  cancelled = std::move(cancelled),
+                  batchTimer](auto&&) mutable {
+        auto fetched = static_cast<int64_t>(end - start);
+        progress.fetchedBlobs_ref() = *progress.fetchedBlobs_ref() + fetched;
+        progress.batchBlobs_ref() = fetched;
+        progress.batchDurationMicros_ref() = batchTimer.elapsed().count();
+        publisher->rlock()->next(progress);
+        return prefetchBatches(
+            std::move(edenMount),
+            std::move(blobs),
+            end,
+            batchSize,
+            std::move(progress),
+            fetchContext,
+            std::move(publisher),
+            std::move(cancelled));
+      });
+}
+} // namespace
+
+apache::thrift::ServerStream<PrefetchProgress>
+EdenServiceHandler::streamPrefetchFiles(
+    std::unique_ptr<StreamPrefetchFilesParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3,
+      *params->mountPoint_ref(),
+      toLogArg(*params->globs_ref()),
+      *params->includeDotfiles_ref(),
+      apache::thrift::util::enumName(*params->priority_ref(), "(unknown)"),
+      *params->batchSize_ref());
+  auto mountPath = AbsolutePathPiece{*params->mountPoint_ref()};
+  auto edenMount = server_->getMount(mountPath);
+  auto batchSize = *params->batchSize_ref() > 0
+      ? static_cast<size_t>(*params->batchSize_ref())
+      : kPrefetchBatchSize;
+
+  auto& fetchContext = helper->getPrefetchFetchContext();
+  fetchContext.setPriority(
+      ImportPriority{toImportPriorityKind(*params->priority_ref())});
+
+  // There is no point fetching more once the client is gone.
+  auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<PrefetchProgress>::createPublisher(
+          [cancelled] { cancelled->store(true); });
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<PrefetchProgress>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Only the blobs of the matching files are needed, not the files.
+  auto blobs = std::make_shared<GlobNode::PrefetchList>();
+  auto globResults = std::make_shared<GlobNode::ResultList>(
+      kGlobStreamChunkSize, [](std::vector<GlobNode::GlobResult>&&) {});
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+  auto globFuture = evaluateGlobs(
+      server_->getServerState(),
+      edenMount,
+      *params->globs_ref(),
+      *params->revisions_ref(),
+      relpathFromUserPath(*params->searchRoot_ref()),
+      *params->includeDotfiles_ref(),
+      fetchContext,
+      blobs,
+      globResults,
+      *originRootIds);
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(globFuture)
+          .thenValue([blobs, globResults = std::move(globResults)](
+                         std::vector<folly::Try<folly::Unit>>&& tries) {
+            for (auto& try_ : tries) {
+              try_.throwUnlessValue();
+            }
+            auto ids = std::move(*blobs->wlock());
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            return ids;
+          })
+          .thenValue([edenMount, sharedPublisher](std::vector<ObjectId>&& ids) {
+            auto totalBlobs = ids.size();
+            return edenMount->getObjectStore()
+                ->getUncachedBlobs(std::move(ids))
+                .thenValue([totalBlobs, sharedPublisher](
+                               std::vector<ObjectId>&& uncached) {
+                  PrefetchProgress progress;
+                  progress.totalBlobs_ref() = totalBlobs;
+                  progress.cachedBlobs_ref() = totalBlobs - uncached.size();
+                  sharedPublisher->rlock()->next(progress);
+                  return std::make_pair(std::move(uncached), progress);
+                });
+          })
+          .thenValue(
+              [edenMount, batchSize, &fetchContext, sharedPublisher, cancelled](
+                  std::pair<std::vector<ObjectId>, PrefetchProgress>&&
+                      planned) {
+                return prefetchBatches(
+                    edenMount,
+                    std::make_shared<const std::vector<ObjectId>>(
+                        std::move(planned.first)),
+                    0,
+                    batchSize,
+                    std::move(planned.second),
+                    fetchContext,
+                    sharedPublisher,
+                    cancelled);
+              })
+          // Make sure that the helper, whose fetch context the fetches use,
+          // lives until they are done.
+          .thenTry([sharedPublisher,
+                    helper = std::move(helper),
+                    originRootIds = std::move(originRootIds)](
+                       folly::Try<Unit>&& result) {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 folly::Future<Unit> EdenServiceHandler::future_chown(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
     FOLLY_MAYBE_UNUSED int32_t uid,
@@ -2162,7 +3036,8 @@ EdenServiceHandler::future_getScmStatusV2(
               rootId,
               context->getConnectionContext()->getCancellationToken(),
               *params->listIgnored_ref(),
-              enforceParents)
+              enforceParents,
+              relpathsFromUserPaths(*params->pathPrefixes_ref()))
           .thenValue([this, mount](std::unique_ptr<ScmStatus>&& status) {
             auto result = std::make_unique<GetScmStatusResult>();
             result->status_ref() = std::move(*status);
@@ -2175,7 +3050,8 @@ folly::Future<std::unique_ptr<ScmStatus>>
 EdenServiceHandler::future_getScmStatus(
     unique_ptr<string> mountPoint,
     bool listIgnored,
-    unique_ptr<string> commitHash) {
+    unique_ptr<string> commitHash,
+    unique_ptr<vector<string>> pathPrefixes) {
   auto* context = getRequestContext();
   auto helper = INSTRUMENT_THRIFT_CALL(
       DBG2,
@@ -2196,14 +3072,16 @@ EdenServiceHandler::future_getScmStatus(
           hash,
           context->getConnectionContext()->getCancellationToken(),
           listIgnored,
-          /*enforceCurrentParent=*/false));
+          /*enforceCurrentParent=*/false,
+          relpathsFromUserPaths(*pathPrefixes)));
 }
 
 folly::SemiFuture<unique_ptr<ScmStatus>>
 EdenServiceHandler::semifuture_getScmStatusBetweenRevisions(
     unique_ptr<string> mountPoint,
     unique_ptr<string> oldHash,
-    unique_ptr<string> newHash) {
+    unique_ptr<string> newHash,
+    unique_ptr<vector<string>> pathPrefixes) {
   auto* context = getRequestContext();
   auto helper = INSTRUMENT_THRIFT_CALL(
       DBG2,
@@ -2213,19 +3091,12 @@ EdenServiceHandler::semifuture_getScmStatusBetweenRevisions(
   auto mountPath = AbsolutePathPiece{*mountPoint};
   auto mount = server_->getMount(mountPath);
 
-  auto callback = std::make_unique<ScmStatusDiffCallback>();
-  auto diffFuture = mount->diffBetweenRoots(
+  auto statusFuture = mount->getScmStatusBetweenRoots(
       mount->getObjectStore()->parseRootId(*oldHash),
       mount->getObjectStore()->parseRootId(*newHash),
       context->getConnectionContext()->getCancellationToken(),
-      callback.get());
-  return wrapImmediateFuture(
-             std::move(helper),
-             std::move(diffFuture)
-                 .thenValue([callback = std::move(callback)](auto&&) {
-                   return std::make_unique<ScmStatus>(
-                       callback->extractStatus());
-                 }))
+      relpathsFromUserPaths(*pathPrefixes));
+  return wrapImmediateFuture(std::move(helper), std::move(statusFuture))
       .semi();
 }
 
@@ -2262,15 +3133,14 @@ void EdenServiceHandler::debugGetScmTree(
   }
 }
 
-void EdenServiceHandler::debugGetScmBlob(
-    string& data,
-    unique_ptr<string> mountPoint,
-    unique_ptr<string> idStr,
-    bool localStoreOnly) {
-  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint, logHash(*idStr));
-  auto mountPath = AbsolutePathPiece{*mountPoint};
+std::shared_ptr<const Blob> EdenServiceHandler::getScmBlob(
+    folly::StringPiece mountPoint,
+    folly::StringPiece idStr,
+    bool localStoreOnly,
+    ObjectFetchContext& fetchContext) {
+  auto mountPath = AbsolutePathPiece{mountPoint};
   auto edenMount = server_->getMount(mountPath);
-  auto id = edenMount->getObjectStore()->parseObjectId(*idStr);
+  auto id = edenMount->getObjectStore()->parseObjectId(idStr);
 
   std::shared_ptr<const Blob> blob;
   auto store = edenMount->getObjectStore();
@@ -2278,17 +3148,62 @@ void EdenServiceHandler::debugGetScmBlob(
     auto localStore = store->getLocalStore();
     blob = localStore->getBlob(id).get();
   } else {
-    blob = store->getBlob(id, helper->getFetchContext()).get();
+    blob = store->getBlob(id, fetchContext).get();
   }
 
   if (!blob) {
     throw newEdenError(
         ENOENT, EdenErrorType::POSIX_ERROR, "no blob found for id ", id);
   }
+  return blob;
+}
+
+void EdenServiceHandler::debugGetScmBlob(
+    string& data,
+    unique_ptr<string> mountPoint,
+    unique_ptr<string> idStr,
+    bool localStoreOnly) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint, logHash(*idStr));
+  auto blob = getScmBlob(
+      *mountPoint, *idStr, localStoreOnly, helper->getFetchContext());
   auto dataBuf = blob->getContents().cloneCoalescedAsValue();
   data.assign(reinterpret_cast<const char*>(dataBuf.data()), dataBuf.length());
 }
 
+void EdenServiceHandler::debugGetScmBlobShared(
+    SharedMemoryResponse& response,
+    unique_ptr<string> mountPoint,
+    unique_ptr<string> idStr,
+    bool localStoreOnly) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint, logHash(*idStr));
+  auto blob = getScmBlob(
+      *mountPoint, *idStr, localStoreOnly, helper->getFetchContext());
+  response = publishSharedMemoryResponse(blob->getContents());
+}
+
+SharedMemoryResponse EdenServiceHandler::publishSharedMemoryResponse(
+    const folly::IOBuf& data) {
+#ifdef __linux__
+  auto* sharedMemoryServer = server_->getSharedMemoryServer();
+  if (!sharedMemoryServer) {
+    throw newEdenError(
+        EAGAIN,
+        EdenErrorType::POSIX_ERROR,
+        "the shared memory server is not running");
+  }
+  auto segment = sharedMemoryServer->publish(data);
+  SharedMemoryResponse response;
+  response.token_ref() = static_cast<int64_t>(segment.token);
+  response.size_ref() = static_cast<int64_t>(segment.size);
+  response.socketPath_ref() =
+      sharedMemoryServer->getSocketPath().stringPiece().str();
+  return response;
+#else
+  (void)data;
+  NOT_IMPLEMENTED();
+#endif
+}
+
 void EdenServiceHandler::debugGetScmBlobMetadata(
     ScmBlobMetadata& result,
     unique_ptr<string> mountPoint,
@@ -2353,6 +3268,8 @@ class InodeStatusCallbacks : public TraversalCallbacks {
 
     info.entries_ref()->reserve(entries.size());
 
+    // Indices of the entries whose size must be fetched, and their hashes.
+    std::vector<std::pair<size_t, ObjectId>> sizesToFetch;
     for (auto& entry : entries) {
       TreeInodeEntryDebugInfo entryInfo;
       entryInfo.name_ref() = entry.name.stringPiece().str();
@@ -2382,8 +3299,8 @@ class InodeStatusCallbacks : public TraversalCallbacks {
           dtype_t::Dir != entry.dtype) {
         if (entry.hash.has_value()) {
           // schedule fetching size from ObjectStore::getBlobSize
-          requestedSizes_.push_back(RequestedSize{
-              results_.size(), info.entries_ref()->size(), entry.hash.value()});
+          sizesToFetch.emplace_back(
+              info.entries_ref()->size(), entry.hash.value());
         } else {
 #ifndef _WIN32
           entryInfo.fileSize_ref() =
@@ -2414,6 +3331,13 @@ class InodeStatusCallbacks : public TraversalCallbacks {
       info.entries_ref()->push_back(entryInfo);
     }
 
+    // Directories are visited concurrently, so only hold the lock while
+    // recording the result.
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [entryIndex, hash] : sizesToFetch) {
+      requestedSizes_.push_back(
+          RequestedSize{results_.size(), entryIndex, std::move(hash)});
+    }
     results_.push_back(std::move(info));
   }
 
@@ -2428,6 +3352,10 @@ class InodeStatusCallbacks : public TraversalCallbacks {
     return true;
   }
 
+  bool canRunConcurrently() const override {
+    return true;
+  }
+
   void fillBlobSizes(ObjectFetchContext& fetchContext) {
     std::vector<ImmediateFuture<folly::Unit>> futures;
     futures.reserve(requestedSizes_.size());
@@ -2444,6 +3372,19 @@ class InodeStatusCallbacks : public TraversalCallbacks {
     collectAll(std::move(futures)).get();
   }
 
+  /**
+   * Sort the results by path, since the traversal visits directories in no
+   * particular order. This keeps the root first.
+   */
+  void sortResults() {
+    std::sort(
+        results_.begin(),
+        results_.end(),
+        [](const TreeInodeDebugInfo& a, const TreeInodeDebugInfo& b) {
+          return *a.path_ref() < *b.path_ref();
+        });
+  }
+
  private:
   struct RequestedSize {
     size_t resultIndex;
@@ -2453,6 +3394,7 @@ class InodeStatusCallbacks : public TraversalCallbacks {
 
   EdenMount* mount_;
   int64_t flags_;
+  std::mutex mutex_;
   std::vector<TreeInodeDebugInfo>& results_;
   std::vector<RequestedSize> requestedSizes_;
 };
@@ -2484,8 +3426,15 @@ void EdenServiceHandler::debugInodeStatus(
         auto inodePath = inode->getPath().value();
 
         InodeStatusCallbacks callbacks{edenMount.get(), flags, inodeInfo};
-        traverseObservedInodes(*inode, inodePath, callbacks);
+        traverseObservedInodesInParallel(
+            std::move(inode),
+            std::move(inodePath),
+            callbacks,
+            folly::getKeepAliveToken(
+                server_->getServerState()->getThreadPool().get()))
+            .get();
         callbacks.fillBlobSizes(helper->getFetchContext());
+        callbacks.sortResults();
       })
       .get();
 }
@@ -2525,6 +3474,9 @@ void EdenServiceHandler::debugOutstandingNfsCalls(
     for (const auto& call : nfsdChannel->getOutstandingRequests()) {
       NfsCall nfsCall;
       nfsCall.xid_ref() = call.xid;
+      nfsCall.procNumber_ref() = call.procNumber;
+      nfsCall.procName_ref() = nfsProcName(call.procNumber);
+      nfsCall.requestId_ref() = call.requestId;
       outstandingCalls.push_back(nfsCall);
     }
   }
@@ -2693,6 +3645,25 @@ void EdenServiceHandler::stopRecordingBackingStoreFetch(
   }
 } // namespace eden
 
+void EdenServiceHandler::startRecordingPrefetchProfile(
+    std::unique_ptr<StartRecordingPrefetchProfileParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->mountPoint_ref(), *params->profileName_ref());
+  auto mount = server_->getMount(AbsolutePathPiece{*params->mountPoint_ref()});
+  auto pid = *params->pid_ref();
+  mount->getRecordedPrefetchProfiles().startRecording(
+      *params->profileName_ref(),
+      pid == 0 ? std::nullopt : std::optional<pid_t>{pid});
+}
+
+int64_t EdenServiceHandler::stopRecordingPrefetchProfile(
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<std::string> profileName) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG2, *mountPoint, *profileName);
+  auto mount = server_->getMount(AbsolutePathPiece{*mountPoint});
+  return mount->getRecordedPrefetchProfiles().stopRecording(*profileName);
+}
+
 void EdenServiceHandler::getAccessCounts(
     GetAccessCountsResult& result,
     int64_t duration) {
@@ -2718,6 +3689,16 @@ void EdenServiceHandler::getAccessCounts(
       ma.fetchCountsByPid_ref()[pid] = fetchCount;
     }
   }
+
+  for (auto& [pid, cost] : clientAccounting_->getCosts()) {
+    ThriftAccessCounts counts;
+    counts.calls_ref() = cost.calls;
+    counts.throttled_ref() = cost.throttled;
+    counts.durationNs_ref() = cost.duration.count();
+    counts.backingStoreFetches_ref() = cost.backingStoreFetches;
+    counts.bytesReturned_ref() = cost.bytesReturned;
+    result.thriftAccessesByPid_ref()[pid] = std::move(counts);
+  }
 }
 
 void EdenServiceHandler::clearAndCompactLocalStore() {
@@ -2747,6 +3728,75 @@ int64_t EdenServiceHandler::debugDropAllPendingRequests() {
   return numDropped;
 }
 
+void EdenServiceHandler::debugGetFsRequestLatency(
+    DebugFsRequestLatencyResponse& response) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
+  auto* stats = server_->getStats();
+
+  for (const auto& [operation, histogram] :
+       stats->getChannelLatencyHistograms()) {
+    FsRequestLatency latency;
+    latency.operation_ref() = operation;
+    latency.count_ref() = histogram.count();
+    latency.p50Micros_ref() = histogram.percentile(50).count();
+    latency.p90Micros_ref() = histogram.percentile(90).count();
+    latency.p99Micros_ref() = histogram.percentile(99).count();
+    latency.p999Micros_ref() = histogram.percentile(99.9).count();
+    latency.maxMicros_ref() = histogram.max().count();
+    response.latencies_ref()->push_back(std::move(latency));
+  }
+
+  for (auto& request : stats->getSlowRequestLog().getSlowRequests()) {
+    SlowFsRequest slow;
+    slow.operation_ref() = std::move(request.operation);
+    slow.durationMicros_ref() = request.duration.count();
+    slow.finishedAt_ref() = std::chrono::duration_cast<std::chrono::seconds>(
+                                request.finishTime.time_since_epoch())
+                                .count();
+    if (request.pid.has_value()) {
+      slow.pid_ref() = *request.pid;
+    }
+    if (request.inode.has_value()) {
+      slow.inodeNumber_ref() = *request.inode;
+    }
+    if (!request.path.empty()) {
+      slow.path_ref() = std::move(request.path);
+    }
+    slow.fetchOrigin_ref() = std::move(request.fetchOrigin);
+    slow.backingStoreMicros_ref() = request.backingStoreDuration.count();
+    if (request.requestId.has_value()) {
+      slow.requestId_ref() = *request.requestId;
+    }
+    response.slowRequests_ref()->push_back(std::move(slow));
+  }
+}
+
+void EdenServiceHandler::debugGetInFlightSamples(
+    DebugInFlightSamplesResponse& response) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
+
+  for (auto& sample : server_->getInFlightSampleLog().getSamples()) {
+    InFlightCallSample thriftSample;
+    thriftSample.takenAtMillis_ref() =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            sample.time.time_since_epoch())
+            .count();
+    for (auto& request : sample.requests) {
+      InFlightCall thriftRequest;
+      thriftRequest.source_ref() = std::move(request.source);
+      thriftRequest.location_ref() = std::move(request.location);
+      thriftRequest.operation_ref() = std::move(request.operation);
+      thriftRequest.stage_ref() = std::move(request.stage);
+      if (request.requestId.has_value()) {
+        thriftRequest.requestId_ref() = *request.requestId;
+      }
+      thriftRequest.ageMicros_ref() = request.age.count();
+      thriftSample.calls_ref()->push_back(std::move(thriftRequest));
+    }
+    response.samples_ref()->push_back(std::move(thriftSample));
+  }
+}
+
 int64_t EdenServiceHandler::unloadInodeForPath(
     FOLLY_MAYBE_UNUSED unique_ptr<string> mountPoint,
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> path,
@@ -2862,6 +3912,8 @@ void EdenServiceHandler::getStatInfo(
     result.blobCacheStats_ref()->evictionCount_ref() =
         blobCacheStats.evictionCount;
     result.blobCacheStats_ref()->dropCount_ref() = blobCacheStats.dropCount;
+    result.blobCacheStats_ref()->admissionRejectCount_ref() =
+        blobCacheStats.admissionRejectCount;
 
     const auto treeCacheStats = server_->getTreeCache()->getStats();
     result.treeCacheStats_ref() = CacheStats{};
@@ -3182,4 +4234,12 @@ std::optional<pid_t> EdenServiceHandler::getAndRegisterClientPid() {
 #endif
 }
 
+folly::CancellationToken EdenServiceHandler::getClientCancellationToken() {
+  auto connectionContext = getRequestContext();
+  if (connectionContext) {
+    return connectionContext->getConnectionContext()->getCancellationToken();
+  }
+  return {};
+}
+
 } // namespace facebook::eden
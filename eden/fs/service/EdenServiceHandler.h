@@ -8,6 +8,7 @@
 #pragma once
 
 #include <fb303/BaseService.h>
+#include <folly/CancellationToken.h>
 #include <optional>
 #include "eden/fs/eden-config.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
@@ -16,17 +17,21 @@
 namespace folly {
 template <typename T>
 class Future;
-}
+class IOBuf;
+} // namespace folly
 
 namespace facebook {
 namespace eden {
 
 class Hash20;
+class Blob;
 class BlobMetadata;
 class EdenMount;
 class EdenServer;
 class TreeInode;
 class ObjectFetchContext;
+class ThriftAdmissionController;
+class ThriftClientAccounting;
 #ifdef EDEN_HAVE_USAGE_SERVICE
 class EdenFSSmartPlatformServiceEndpoint;
 #endif
@@ -64,6 +69,18 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       CheckoutMode checkoutMode,
       std::unique_ptr<CheckOutRevisionParams> params) override;
 
+  bool cancelCheckout(std::unique_ptr<std::string> mountPoint) override;
+
+  void setCheckoutFilter(
+      std::vector<CheckoutConflict>& results,
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::vector<std::string>> excludedPaths,
+      CheckoutMode checkoutMode) override;
+
+  void getCheckoutFilter(
+      std::vector<std::string>& results,
+      std::unique_ptr<std::string> mountPoint) override;
+
   void resetParentCommits(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<WorkingDirectoryParents> parents,
@@ -90,9 +107,33 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::vector<std::string>> paths,
       std::unique_ptr<SyncBehavior> sync) override;
 
-  ImmediateFuture<BlobMetadata> getBlobMetadataForPath(
+  /**
+   * Returns the metadata of the files at `paths`, in the same order.
+   *
+   * The paths are looked up together, and the metadata of the files that
+   * aren't materialized is read with a single batched LocalStore lookup.
+   * Materialized files are read once each, while that lookup runs.
+   *
+   * BLAKE3 hashes are only filled in if `includeBlake3` is set, since they may
+   * need the files' contents to be fetched.
+   */
+  ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+  getBlobMetadataForPaths(
       AbsolutePathPiece mountPoint,
-      folly::StringPiece path,
+      const std::vector<std::string>& paths,
+      bool includeBlake3,
+      ObjectFetchContext& fetchContext);
+
+  /**
+   * Like getBlobMetadataForPaths, but completes once the lookups have been
+   * started, with one future per path, so that callers can use each result
+   * as soon as it is ready.
+   */
+  ImmediateFuture<std::vector<ImmediateFuture<BlobMetadata>>>
+  startBlobMetadataForPaths(
+      AbsolutePathPiece mountPoint,
+      const std::vector<std::string>& paths,
+      bool includeBlake3,
       ObjectFetchContext& fetchContext);
 
   void getCurrentJournalPosition(
@@ -139,6 +180,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   folly::Future<std::unique_ptr<Glob>> future_predictiveGlobFiles(
       std::unique_ptr<GlobParams> params) override;
 
+  folly::Future<std::unique_ptr<SharedMemoryResponse>>
+  future_globFilesShared(std::unique_ptr<GlobParams> params) override;
+
   folly::Future<folly::Unit> future_chown(
       std::unique_ptr<std::string> mountPoint,
       int32_t uid,
@@ -160,16 +204,31 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ResponseAndServerStream<ChangesSinceResult, ChangedFileResult>
   streamChangesSince(std::unique_ptr<StreamChangesSinceParams> params) override;
 
+  apache::thrift::ServerStream<Glob> streamGlobFiles(
+      std::unique_ptr<GlobParams> params) override;
+
+  apache::thrift::ServerStream<ChangedFileResult> streamScmStatus(
+      std::unique_ptr<GetScmStatusParams> params) override;
+
+  apache::thrift::ServerStream<FileAttributesResult>
+  streamGetAttributesFromFiles(
+      std::unique_ptr<GetAttributesFromFilesParams> params) override;
+
+  apache::thrift::ServerStream<PrefetchProgress> streamPrefetchFiles(
+      std::unique_ptr<StreamPrefetchFilesParams> params) override;
+
   folly::Future<std::unique_ptr<ScmStatus>> future_getScmStatus(
       std::unique_ptr<std::string> mountPoint,
       bool listIgnored,
-      std::unique_ptr<std::string> commitHash) override;
+      std::unique_ptr<std::string> commitHash,
+      std::unique_ptr<std::vector<std::string>> pathPrefixes) override;
 
   folly::SemiFuture<std::unique_ptr<ScmStatus>>
   semifuture_getScmStatusBetweenRevisions(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::string> oldHash,
-      std::unique_ptr<std::string> newHash) override;
+      std::unique_ptr<std::string> newHash,
+      std::unique_ptr<std::vector<std::string>> pathPrefixes) override;
 
   void debugGetScmTree(
       std::vector<ScmTreeEntry>& entries,
@@ -183,6 +242,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> id,
       bool localStoreOnly) override;
 
+  void debugGetScmBlobShared(
+      SharedMemoryResponse& response,
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::string> id,
+      bool localStoreOnly) override;
+
   void debugGetScmBlobMetadata(
       ScmBlobMetadata& metadata,
       std::unique_ptr<std::string> mountPoint,
@@ -242,6 +307,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
 
   int64_t debugDropAllPendingRequests() override;
 
+  void debugGetFsRequestLatency(
+      DebugFsRequestLatencyResponse& response) override;
+
+  void debugGetInFlightSamples(
+      DebugInFlightSamplesResponse& response) override;
+
   int64_t unloadInodeForPath(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::string> path,
@@ -268,9 +339,17 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   folly::Future<std::unique_ptr<SetPathObjectIdResult>> future_setPathObjectId(
       std::unique_ptr<SetPathObjectIdParams> params) override;
 
+  folly::Future<std::unique_ptr<SetPathObjectIdResult>>
+  future_setPathObjectIds(
+      std::unique_ptr<SetPathObjectIdsParams> params) override;
+
   folly::SemiFuture<folly::Unit> semifuture_removeRecursively(
       std::unique_ptr<RemoveRecursivelyParams> params) override;
 
+  folly::SemiFuture<std::unique_ptr<ChromeTraceResult>>
+  semifuture_captureChromeTrace(
+      std::unique_ptr<CaptureChromeTraceParams> params) override;
+
   void reloadConfig() override;
 
   void getDaemonInfo(DaemonInfo& result) override;
@@ -304,6 +383,13 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
    */
   void stopRecordingBackingStoreFetch(GetFetchedFilesResult& results) override;
 
+  void startRecordingPrefetchProfile(
+      std::unique_ptr<StartRecordingPrefetchProfileParams> params) override;
+
+  int64_t stopRecordingPrefetchProfile(
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::string> profileName) override;
+
   /**
    * Returns the pid that caused the Thrift request running on the calling
    * Thrift worker thread and registers it with the ProcessNameCache.
@@ -313,6 +399,16 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
    */
   std::optional<pid_t> getAndRegisterClientPid();
 
+  /**
+   * Returns a token that is cancelled when the client of the Thrift request
+   * running on the calling Thrift worker thread disconnects, so that the
+   * fetches it started can be dropped.
+   *
+   * Like getAndRegisterClientPid, this must be run from a Thrift worker
+   * thread.
+   */
+  folly::CancellationToken getClientCancellationToken();
+
  private:
   ImmediateFuture<Hash20> getSHA1ForPath(
       AbsolutePathPiece mountPoint,
@@ -344,6 +440,18 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       folly::StringPiece caller,
       std::optional<pid_t> pid);
 
+  std::shared_ptr<const Blob> getScmBlob(
+      folly::StringPiece mountPoint,
+      folly::StringPiece id,
+      bool localStoreOnly,
+      ObjectFetchContext& fetchContext);
+
+  /**
+   * Copy a response into shared memory, for the *Shared variants of the
+   * methods returning large results.
+   */
+  SharedMemoryResponse publishSharedMemoryResponse(const folly::IOBuf& data);
+
 #ifdef EDEN_HAVE_USAGE_SERVICE
   // an endpoint for the edenfs/edenfs_service smartservice used for predictive
   // prefetch profiles
@@ -351,6 +459,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
 #endif
   const std::vector<std::string> originalCommandLine_;
   EdenServer* const server_;
+  // Shared by every processor, as it counts the requests in flight.
+  const std::shared_ptr<ThriftAdmissionController> admissionController_;
+  const std::shared_ptr<ThriftClientAccounting> clientAccounting_;
 };
 } // namespace eden
 } // namespace facebook
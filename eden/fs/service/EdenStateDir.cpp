@@ -21,6 +21,7 @@ constexpr StringPiece kPidFileName{"pid"};
 constexpr StringPiece kTakeoverSocketName{"takeover"};
 constexpr StringPiece kThriftSocketName{"socket"};
 constexpr PathComponentPiece kMountdSocketName{"mountd.socket"_pc};
+constexpr PathComponentPiece kSharedMemorySocketName{"shm.socket"_pc};
 } // namespace
 
 EdenStateDir::EdenStateDir(AbsolutePathPiece path)
@@ -117,6 +118,10 @@ AbsolutePath EdenStateDir::getMountdSocketPath() const {
   return path_ + kMountdSocketName;
 }
 
+AbsolutePath EdenStateDir::getSharedMemorySocketPath() const {
+  return path_ + kSharedMemorySocketName;
+}
+
 AbsolutePath EdenStateDir::getCheckoutStateDir(StringPiece checkoutID) const {
   return path_ + PathComponent("clients") + PathComponent(checkoutID);
 }
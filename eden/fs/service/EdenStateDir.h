@@ -95,6 +95,12 @@ class EdenStateDir {
    */
   AbsolutePath getMountdSocketPath() const;
 
+  /**
+   * Get the path to the socket that hands out large Thrift responses in
+   * shared memory.
+   */
+  AbsolutePath getSharedMemorySocketPath() const;
+
   /**
    * Get the path to the directory where state for a specific checkout is
    * stored.
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MaintenanceScheduler.h"
+
+#include <algorithm>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/service/EdenServer.h"
+#include "eden/fs/utils/ProcessAccessLog.h"
+
+using namespace std::chrono_literals;
+
+namespace facebook {
+namespace eden {
+
+namespace {
+// ProcessAccessLog only keeps the last ten seconds of accesses.
+constexpr auto kMaxRequestRateWindow = 10s;
+} // namespace
+
+void IdleDetector::record(
+    const HostLoad& load,
+    const IdleThresholds& thresholds,
+    Clock::time_point now) {
+  bool busy = load.channelRequestRate > thresholds.maxChannelRequestRate ||
+      load.cpuUtilization.value_or(0) > thresholds.maxCpuUtilization ||
+      load.ioRate.value_or(0) > thresholds.maxIoRate;
+  if (busy) {
+    idleSince_.reset();
+  } else if (!idleSince_) {
+    idleSince_ = lastSample_.value_or(now);
+  }
+  lastSample_ = now;
+}
+
+struct MaintenanceScheduler::JobState {
+  JobState(
+      folly::StringPiece jobName,
+      MaintenanceClass jobClass,
+      Job&& jobFn,
+      IdleDetector::Clock::time_point now)
+      : name{jobName.str()},
+        maintenanceClass{jobClass},
+        run{std::move(jobFn)},
+        lastCompleted{now} {}
+
+  const std::string name;
+  const MaintenanceClass maintenanceClass;
+  const Job run;
+  Duration interval{0};
+
+  /**
+   * When the job last completed, or was added. It is due once its interval
+   * has passed since then.
+   */
+  IdleDetector::Clock::time_point lastCompleted;
+
+  /**
+   * Set while the job runs.
+   */
+  std::optional<folly::CancellationSource> running;
+  IdleDetector::Clock::time_point startTime;
+  bool preemptible{false};
+  /**
+   * Whether cancellation was requested because the host got busy, rather than
+   * because the job ran out of budget.
+   */
+  bool preempted{false};
+};
+
+MaintenanceScheduler::MaintenanceScheduler(EdenServer* server)
+    : PeriodicTask{server, "maintenance"} {}
+
+MaintenanceScheduler::~MaintenanceScheduler() {
+  for (const auto& job : jobs_) {
+    if (job->running) {
+      job->running->requestCancellation();
+    }
+  }
+}
+
+void MaintenanceScheduler::addJob(
+    folly::StringPiece name,
+    MaintenanceClass maintenanceClass,
+    Job job) {
+  jobs_.push_back(std::make_shared<JobState>(
+      name, maintenanceClass, std::move(job), IdleDetector::Clock::now()));
+}
+
+void MaintenanceScheduler::updateJobInterval(
+    folly::StringPiece name,
+    Duration interval) {
+  for (const auto& job : jobs_) {
+    if (job->name == name) {
+      job->interval = interval;
+      return;
+    }
+  }
+  XLOG(DFATAL) << "unknown maintenance job " << name;
+}
+
+void MaintenanceScheduler::updateConfig(const EdenConfig& config) {
+  thresholds_.maxChannelRequestRate =
+      config.maintenanceMaxRequestRate.getValue();
+  thresholds_.maxCpuUtilization =
+      config.maintenanceMaxCpuPercent.getValue() / 100.0;
+  thresholds_.maxIoRate = config.maintenanceMaxIoRate.getValue();
+  idleOnly_ = config.maintenanceIdleOnly.getValue();
+  idleDelay_ = config.maintenanceIdleDelay.getValue();
+  heavyJobBudget_ = config.maintenanceHeavyJobBudget.getValue();
+  maxDeferral_ = config.maintenanceMaxDeferral.getValue();
+
+  updateInterval(
+      std::chrono::duration_cast<Duration>(
+          config.maintenanceCheckInterval.getValue()),
+      /*splay=*/false);
+}
+
+HostLoad MaintenanceScheduler::sampleLoad() {
+  auto now = IdleDetector::Clock::now();
+  auto elapsed = lastSampleTime_
+      ? std::chrono::duration<double>{now - *lastSampleTime_}.count()
+      : 0.0;
+  lastSampleTime_ = now;
+
+  HostLoad load;
+
+  auto window = std::clamp(
+      std::chrono::duration_cast<std::chrono::seconds>(getInterval()),
+      std::chrono::seconds{1},
+      std::chrono::seconds{kMaxRequestRateWindow});
+  uint64_t requests = 0;
+  for (const auto& mount : getServer()->getMountPoints()) {
+    for (const auto& [pid, counts] :
+         mount->getProcessAccessLog().getAccessCounts(window)) {
+      requests += *counts.fsChannelTotal_ref();
+    }
+  }
+  load.channelRequestRate = static_cast<double>(requests) / window.count();
+
+  auto cpuTimes = proc_util::readHostCpuTimes();
+  if (cpuTimes && lastCpuTimes_ && cpuTimes->total > lastCpuTimes_->total) {
+    load.cpuUtilization =
+        static_cast<double>(cpuTimes->busy - lastCpuTimes_->busy) /
+        (cpuTimes->total - lastCpuTimes_->total);
+  }
+  lastCpuTimes_ = cpuTimes;
+
+  auto pagedBytes = proc_util::readHostPagedBytes();
+  if (pagedBytes && lastPagedBytes_ && elapsed > 0) {
+    load.ioRate = (*pagedBytes - *lastPagedBytes_) / elapsed;
+  }
+  lastPagedBytes_ = pagedBytes;
+
+  return load;
+}
+
+void MaintenanceScheduler::runTask() {
+  auto load = sampleLoad();
+  auto now = IdleDetector::Clock::now();
+  idleDetector_.record(load, thresholds_, now);
+  bool idle = !idleOnly_ || idleDetector_.isIdle(idleDelay_, now);
+  bool busy = idleOnly_ && idleDetector_.isBusy();
+
+  bool heavyRunning = false;
+  for (const auto& job : jobs_) {
+    if (!job->running) {
+      continue;
+    }
+    if (job->maintenanceClass == MaintenanceClass::Heavy) {
+      heavyRunning = true;
+      if (job->running->isCancellationRequested()) {
+        continue;
+      }
+      if (busy && job->preemptible) {
+        XLOG(INFO) << "stopping maintenance job " << job->name
+                   << ": the host is busy (" << load.channelRequestRate
+                   << " requests/s, cpu " << load.cpuUtilization.value_or(0)
+                   << ", " << load.ioRate.value_or(0) << " bytes/s paged)";
+        job->preempted = true;
+        job->running->requestCancellation();
+      } else if (now - job->startTime >= heavyJobBudget_) {
+        XLOG(INFO) << "stopping maintenance job " << job->name
+                   << ": it ran out of budget";
+        job->running->requestCancellation();
+      }
+    }
+  }
+
+  for (const auto& job : jobs_) {
+    if (job->running || job->interval <= Duration(0)) {
+      continue;
+    }
+    auto dueTime = job->lastCompleted + job->interval;
+    if (now < dueTime) {
+      continue;
+    }
+    if (job->maintenanceClass == MaintenanceClass::Light) {
+      startJob(job, now, /*preemptible=*/false);
+      continue;
+    }
+    if (heavyRunning) {
+      continue;
+    }
+    bool overdue = now - dueTime >= maxDeferral_;
+    if (!idle && !overdue) {
+      XLOG(DBG4) << "deferring maintenance job " << job->name
+                 << " until the host is idle";
+      continue;
+    }
+    if (!idle) {
+      XLOG(INFO) << "running maintenance job " << job->name
+                 << " although the host is busy: it was deferred for too long";
+    }
+    startJob(job, now, /*preemptible=*/idleOnly_ && !overdue);
+    heavyRunning = true;
+  }
+}
+
+void MaintenanceScheduler::startJob(
+    const std::shared_ptr<JobState>& job,
+    IdleDetector::Clock::time_point now,
+    bool preemptible) {
+  XLOG(DBG3) << "starting maintenance job " << job->name;
+  job->running.emplace();
+  job->startTime = now;
+  job->preemptible = preemptible;
+  job->preempted = false;
+
+  auto token = job->running->getToken();
+  folly::makeSemiFutureWith([&] { return job->run(token); })
+      .via(getServer()->getMainEventBase())
+      .thenTry([job](folly::Try<folly::Unit>&& result) {
+        if (result.hasException()) {
+          XLOG(ERR) << "error running maintenance job " << job->name << ": "
+                    << result.exception().what();
+        }
+        // A job the load stopped is still due, and runs again in the next
+        // idle window. Light jobs keep to their interval however long they
+        // took.
+        if (!job->preempted) {
+          job->lastCompleted = job->maintenanceClass == MaintenanceClass::Light
+              ? job->startTime
+              : IdleDetector::Clock::now();
+        }
+        job->running.reset();
+      });
+}
+
+} // namespace eden
+} // namespace facebook
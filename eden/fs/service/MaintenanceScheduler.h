@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <folly/CancellationToken.h>
+#include <folly/Range.h>
+#include <folly/futures/Future.h>
+
+#include "eden/fs/service/PeriodicTask.h"
+#include "eden/fs/utils/ProcUtil.h"
+
+namespace facebook {
+namespace eden {
+
+class EdenConfig;
+
+/**
+ * How much a maintenance job competes with the user's work.
+ */
+enum class MaintenanceClass {
+  /**
+   * Cheap jobs, such as publishing stats, which run on their schedule
+   * whatever the load.
+   */
+  Light,
+  /**
+   * Jobs that use a lot of I/O or CPU, such as local store garbage
+   * collection. They wait for the host to be idle, run one at a time, and are
+   * stopped when the load comes back.
+   */
+  Heavy,
+};
+
+/**
+ * The load on the host since the previous sample.
+ */
+struct HostLoad {
+  /// Filesystem requests per second, across all mounts.
+  double channelRequestRate = 0;
+  /// The fraction of the host's CPU time spent busy, if known.
+  std::optional<double> cpuUtilization;
+  /// Bytes per second the host paged in from and out to disk, if known.
+  std::optional<double> ioRate;
+};
+
+/**
+ * The load above which the host is busy.
+ */
+struct IdleThresholds {
+  double maxChannelRequestRate = 0;
+  double maxCpuUtilization = 0;
+  double maxIoRate = 0;
+};
+
+/**
+ * Tells from consecutive HostLoad samples for how long the host has been
+ * idle.
+ */
+class IdleDetector {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Record the load since the previous sample. Loads that are not known do
+   * not make the host busy.
+   */
+  void record(
+      const HostLoad& load,
+      const IdleThresholds& thresholds,
+      Clock::time_point now);
+
+  /**
+   * Whether the last recorded load was above a threshold.
+   */
+  bool isBusy() const {
+    return !idleSince_.has_value();
+  }
+
+  /**
+   * Whether all the loads recorded over the last `delay` were below the
+   * thresholds.
+   */
+  bool isIdle(Clock::duration delay, Clock::time_point now) const {
+    return idleSince_.has_value() && now - *idleSince_ >= delay;
+  }
+
+ private:
+  /**
+   * The start of the sampling period of the first of the consecutive samples
+   * below the thresholds, if the last one was.
+   */
+  std::optional<Clock::time_point> idleSince_;
+  std::optional<Clock::time_point> lastSample_;
+};
+
+/**
+ * Runs EdenServer's maintenance jobs, so that the expensive ones run when
+ * the user is not, and don't collide with each other.
+ *
+ * Every maintenance:check-interval it samples the load on the host, and
+ * starts the jobs whose interval has passed since they last completed. Heavy
+ * jobs only start once the host has been idle for maintenance:idle-delay,
+ * and their cancellation is requested when it gets busy again or they ran
+ * for longer than maintenance:heavy-job-budget. A heavy job stopped by load
+ * starts again in the next idle window.
+ *
+ * Like other PeriodicTasks, this must only be used from the EdenServer's
+ * main EventBase thread.
+ */
+class MaintenanceScheduler : private PeriodicTask {
+ public:
+  using PeriodicTask::Duration;
+
+  /**
+   * A maintenance job. Its work may be done asynchronously, in which case
+   * the job should return early once cancellation of the token is requested.
+   */
+  using Job = std::function<folly::SemiFuture<folly::Unit>(
+      const folly::CancellationToken&)>;
+
+  explicit MaintenanceScheduler(EdenServer* server);
+
+  /**
+   * Requests the cancellation of the jobs still running.
+   */
+  ~MaintenanceScheduler();
+
+  MaintenanceScheduler(const MaintenanceScheduler&) = delete;
+  MaintenanceScheduler& operator=(const MaintenanceScheduler&) = delete;
+
+  /**
+   * Add a job. It does not run until its interval is set to a positive
+   * value.
+   */
+  void addJob(
+      folly::StringPiece name,
+      MaintenanceClass maintenanceClass,
+      Job job);
+
+  /**
+   * Set how often the job named `name` runs. 0 or negative stops running
+   * it.
+   */
+  void updateJobInterval(folly::StringPiece name, Duration interval);
+
+  /**
+   * Apply the maintenance:* settings, and start sampling the load.
+   */
+  void updateConfig(const EdenConfig& config);
+
+ private:
+  struct JobState;
+
+  void runTask() override;
+
+  HostLoad sampleLoad();
+  void startJob(
+      const std::shared_ptr<JobState>& job,
+      IdleDetector::Clock::time_point now,
+      bool preemptible);
+
+  std::vector<std::shared_ptr<JobState>> jobs_;
+  IdleDetector idleDetector_;
+
+  IdleThresholds thresholds_;
+  bool idleOnly_{true};
+  IdleDetector::Clock::duration idleDelay_{};
+  IdleDetector::Clock::duration heavyJobBudget_{};
+  IdleDetector::Clock::duration maxDeferral_{};
+
+  // The cumulative host counters of the previous sample.
+  std::optional<proc_util::CpuTimes> lastCpuTimes_;
+  std::optional<uint64_t> lastPagedBytes_;
+  std::optional<IdleDetector::Clock::time_point> lastSampleTime_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifdef __linux__
+
+#include "eden/fs/service/SharedMemoryServer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/SocketAddress.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/utils/FutureUnixSocket.h"
+
+using folly::AsyncServerSocket;
+using folly::exceptionStr;
+using std::chrono::steady_clock;
+
+namespace facebook {
+namespace eden {
+
+namespace {
+constexpr std::chrono::seconds kTokenReceiveTimeout{5};
+
+UnixSocket::Message errorMessage(folly::StringPiece message) {
+  return UnixSocket::Message{
+      folly::IOBuf{folly::IOBuf::COPY_BUFFER, message}, {}};
+}
+} // namespace
+
+SharedMemoryServer::SharedMemoryServer(
+    folly::EventBase* eventBase,
+    AbsolutePathPiece socketPath,
+    std::chrono::nanoseconds expiry)
+    : eventBase_{eventBase}, socketPath_{socketPath}, expiry_{expiry} {
+  folly::SocketAddress address;
+  address.setFromPath(socketPath_.stringPiece());
+
+  // Remove any old file at this path, so we can bind to it.
+  auto rc = unlink(socketPath_.value().c_str());
+  if (rc != 0 && errno != ENOENT) {
+    folly::throwSystemError("error removing old shared memory socket");
+  }
+
+  socket_.reset(new AsyncServerSocket{eventBase_});
+  socket_->bind(address);
+  socket_->listen(/* backlog */ 1024);
+  socket_->addAcceptCallback(this, nullptr);
+  socket_->startAccepting();
+}
+
+SharedMemoryServer::~SharedMemoryServer() {}
+
+SharedMemoryServer::Segment SharedMemoryServer::publish(
+    const folly::IOBuf& data) {
+  int fd = memfd_create("edenfs-response", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  folly::checkUnixError(fd, "memfd_create failed");
+  folly::File file{fd, /* ownsFd */ true};
+
+  uint64_t size = 0;
+  for (auto range : data) {
+    folly::checkUnixError(
+        folly::writeFull(file.fd(), range.data(), range.size()),
+        "error writing response to shared memory");
+    size += range.size();
+  }
+
+  // Once sealed, neither this process nor the client can change the
+  // contents, so the client can map them without validating them again.
+  folly::checkUnixError(
+      fcntl(
+          file.fd(),
+          F_ADD_SEALS,
+          F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL),
+      "error sealing shared memory response");
+
+  auto now = steady_clock::now();
+  auto entries = entries_.wlock();
+  dropExpired(*entries, now);
+  uint64_t token;
+  do {
+    token = folly::Random::secureRand64();
+  } while (token == 0 || entries->count(token));
+  entries->emplace(token, Entry{std::move(file), now + expiry_});
+  return Segment{token, size};
+}
+
+folly::File SharedMemoryServer::take(uint64_t token) {
+  auto entries = entries_.wlock();
+  dropExpired(*entries, steady_clock::now());
+  auto it = entries->find(token);
+  if (it == entries->end()) {
+    return folly::File{};
+  }
+  auto file = std::move(it->second.file);
+  entries->erase(it);
+  return file;
+}
+
+void SharedMemoryServer::dropExpired(
+    folly::F14FastMap<uint64_t, Entry>& entries,
+    steady_clock::time_point now) {
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->second.expiry <= now) {
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void SharedMemoryServer::connectionAccepted(
+    folly::NetworkSocket fdNetworkSocket,
+    const folly::SocketAddress& /* clientAddr */,
+    AcceptInfo /* info */) noexcept {
+  auto socket = std::make_shared<FutureUnixSocket>(
+      eventBase_, folly::File{fdNetworkSocket.toFd(), /* ownsFd */ true});
+
+  // Only hand responses to processes of the user the daemon runs as, the
+  // same as the other local sockets.
+  uid_t uid;
+  try {
+    uid = socket->getRemoteUID();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "unable to get the credentials of a shared memory client: "
+              << exceptionStr(ex);
+    return;
+  }
+  if (uid != getuid()) {
+    XLOG(ERR) << "rejecting shared memory request from UID " << uid;
+    return;
+  }
+
+  socket->receive(kTokenReceiveTimeout)
+      .thenValue([this, socket](UnixSocket::Message&& msg) {
+        folly::io::Cursor cursor{&msg.data};
+        uint64_t token;
+        if (!cursor.tryReadLE(token)) {
+          return socket->send(errorMessage("malformed shared memory token"));
+        }
+        auto file = take(token);
+        if (!file) {
+          return socket->send(errorMessage("unknown shared memory token"));
+        }
+        std::vector<folly::File> files;
+        files.push_back(std::move(file));
+        return socket->send(
+            UnixSocket::Message{folly::IOBuf{}, std::move(files)});
+      })
+      .thenError([](const folly::exception_wrapper& ew) {
+        XLOG(DBG3) << "error processing shared memory request: "
+                   << exceptionStr(ew);
+      })
+      .ensure([socket] {});
+}
+
+void SharedMemoryServer::acceptError(folly::exception_wrapper ex) noexcept {
+  XLOG(ERR) << "accept() error on shared memory socket: " << exceptionStr(ex);
+}
+
+} // namespace eden
+} // namespace facebook
+
+#endif // __linux__
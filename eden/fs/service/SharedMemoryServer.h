@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifdef __linux__
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncServerSocket.h>
+#include <chrono>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Hands large Thrift responses to local clients through shared memory, so
+ * that they are not serialized into Thrift buffers and copied through the
+ * Thrift socket.
+ *
+ * publish() copies a response into a sealed memfd and returns a token for
+ * it. The client connects to the socket this server listens on, sends the
+ * token as 8 little-endian bytes, and receives the memfd, which it can map
+ * read-only. Each response is handed out once, and only to a process of
+ * the same user. Those that are not collected within the expiry are
+ * dropped.
+ */
+class SharedMemoryServer : private folly::AsyncServerSocket::AcceptCallback {
+ public:
+  SharedMemoryServer(
+      folly::EventBase* eventBase,
+      AbsolutePathPiece socketPath,
+      std::chrono::nanoseconds expiry);
+  ~SharedMemoryServer() override;
+
+  struct Segment {
+    uint64_t token;
+    uint64_t size;
+  };
+
+  /**
+   * Store `data` in shared memory until a client collects it.
+   */
+  Segment publish(const folly::IOBuf& data);
+
+  /**
+   * Take the memfd published under `token`, or return an empty File if there
+   * is none.
+   */
+  folly::File take(uint64_t token);
+
+  const AbsolutePath& getSocketPath() const {
+    return socketPath_;
+  }
+
+ private:
+  struct Entry {
+    folly::File file;
+    std::chrono::steady_clock::time_point expiry;
+  };
+
+  void connectionAccepted(
+      folly::NetworkSocket fdNetworkSocket,
+      const folly::SocketAddress& clientAddr,
+      AcceptInfo info) noexcept override;
+  void acceptError(folly::exception_wrapper ex) noexcept override;
+
+  void dropExpired(
+      folly::F14FastMap<uint64_t, Entry>& entries,
+      std::chrono::steady_clock::time_point now);
+
+  folly::EventBase* const eventBase_;
+  const AbsolutePath socketPath_;
+  const std::chrono::nanoseconds expiry_;
+  folly::AsyncServerSocket::UniquePtr socket_;
+  folly::Synchronized<folly::F14FastMap<uint64_t, Entry>> entries_;
+};
+
+} // namespace eden
+} // namespace facebook
+
+#endif // __linux__
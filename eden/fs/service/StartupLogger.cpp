@@ -82,6 +82,12 @@ std::shared_ptr<StartupLogger> daemonizeIfRequested(
 
 StartupLogger::~StartupLogger() = default;
 
+void StartupLogger::logPhase(
+    StringPiece phase,
+    std::chrono::duration<double> duration) {
+  logVerbose("Startup phase ", phase, " took ", duration.count(), " seconds");
+}
+
 void StartupLogger::success(uint64_t startTimeInSeconds) {
   writeMessage(
       folly::LogLevel::INFO,
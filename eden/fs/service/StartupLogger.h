@@ -13,6 +13,7 @@
 #include <folly/lang/Assume.h>
 #include <folly/logging/LogLevel.h>
 #include <gflags/gflags_declare.h>
+#include <chrono>
 #include <memory>
 #include <optional>
 #include "eden/fs/config/EdenConfig.h"
@@ -104,6 +105,18 @@ class StartupLogger {
         folly::to<std::string>(std::forward<Args>(args)...));
   }
 
+  /**
+   * Log how long one phase of startup took, such as opening the local store
+   * or mounting the checkouts.
+   *
+   * These messages have a fixed format, "Startup phase <phase> took <N>
+   * seconds", so that tools such as the daemon_startup benchmark can parse
+   * them out of the --startupLogPath file.
+   */
+  void logPhase(
+      folly::StringPiece phase,
+      std::chrono::duration<double> duration);
+
   /**
    * Indicate that startup has failed.
    *
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftAdmissionController.h"
+
+#include <fmt/format.h>
+#include <folly/Utility.h>
+#include <thrift/lib/cpp2/server/Cpp2ConnContext.h>
+#include <algorithm>
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace {
+/**
+ * The methods annotated with priority = 'HIGH' in eden.thrift.
+ */
+constexpr folly::StringPiece INTERACTIVE_METHODS[] = {
+    "getCurrentJournalPosition",
+    "getDaemonInfo",
+    "getPid",
+    "listMounts",
+};
+
+constexpr folly::StringPiece kEdenServicePrefixes[] = {
+    "EdenService.",
+    "StreamingEdenService.",
+};
+
+constexpr folly::StringPiece kDebugPrefix = "debug";
+
+} // namespace
+
+namespace facebook {
+namespace eden {
+
+ThriftRequestClass classifyThriftMethod(folly::StringPiece methodName) {
+  auto name = methodName;
+  for (auto& prefix : kEdenServicePrefixes) {
+    name.removePrefix(prefix);
+  }
+  if (name.size() == methodName.size()) {
+    // The fb303 methods only read counters and status.
+    return ThriftRequestClass::Interactive;
+  }
+  for (auto& interactive : INTERACTIVE_METHODS) {
+    if (name == interactive) {
+      return ThriftRequestClass::Interactive;
+    }
+  }
+  if (name.startsWith(kDebugPrefix)) {
+    return ThriftRequestClass::Debug;
+  }
+  return ThriftRequestClass::Bulk;
+}
+
+ThriftAdmissionController::ThriftAdmissionController(
+    std::shared_ptr<ServerState> serverState)
+    : serverState_{std::move(serverState)} {}
+
+void* ThriftAdmissionController::getContext(
+    const char* fn_name,
+    apache::thrift::TConnectionContext* connectionContext) {
+  auto requestClass = classifyThriftMethod(fn_name);
+  inflight_[folly::to_underlying(requestClass)].fetch_add(
+      1, std::memory_order_relaxed);
+
+  // getContext is called once a worker thread picked the request up, so the
+  // time since it was read off the socket is the time it was queued.
+  auto* requestContext =
+      dynamic_cast<apache::thrift::Cpp2RequestContext*>(connectionContext);
+  if (requestContext) {
+    auto readEnd = requestContext->getTimestamps().readEnd;
+    if (readEnd.time_since_epoch().count() != 0) {
+      auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - readEnd)
+                        .count();
+      auto& stats = serverState_->getStats().getThriftStatsForCurrentThread();
+      switch (requestClass) {
+        case ThriftRequestClass::Interactive:
+          stats.queueWaitInteractive.addValue(waited);
+          break;
+        case ThriftRequestClass::Bulk:
+          stats.queueWaitBulk.addValue(waited);
+          break;
+        case ThriftRequestClass::Debug:
+          stats.queueWaitDebug.addValue(waited);
+          break;
+      }
+    }
+  }
+  return connectionContext;
+}
+
+void ThriftAdmissionController::freeContext(
+    void* /*ctx*/,
+    const char* fn_name) {
+  // We don't own the connectionContext.
+  auto requestClass = classifyThriftMethod(fn_name);
+  inflight_[folly::to_underlying(requestClass)].fetch_sub(
+      1, std::memory_order_relaxed);
+}
+
+void ThriftAdmissionController::preRead(void* /*ctx*/, const char* fn_name) {
+  auto requestClass = classifyThriftMethod(fn_name);
+  if (requestClass == ThriftRequestClass::Interactive) {
+    return;
+  }
+
+  auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  auto limit = requestClass == ThriftRequestClass::Bulk
+      ? config->thriftMaxBulkRequests.getValue()
+      : config->thriftMaxDebugRequests.getValue();
+  if (requestClass == ThriftRequestClass::Bulk &&
+      config->thriftAdaptiveBulkRequests.getValue()) {
+    uint64_t adaptiveLimit =
+        serverState_->getStats().getBackgroundRequestLimit().getLimit();
+    limit = limit == 0 ? adaptiveLimit : std::min(limit, adaptiveLimit);
+  }
+  auto inflight = inflight_[folly::to_underlying(requestClass)].load(
+      std::memory_order_relaxed);
+  if (limit == 0 || inflight <= limit) {
+    return;
+  }
+
+  auto& stats = serverState_->getStats().getThriftStatsForCurrentThread();
+  if (requestClass == ThriftRequestClass::Bulk) {
+    stats.rejectedBulk.addValue(1);
+  } else {
+    stats.rejectedDebug.addValue(1);
+  }
+  throw ThriftOverloaded{fmt::format(
+      "{} refused: {} requests of its class are already in flight",
+      fn_name,
+      inflight - 1)};
+}
+
+} // namespace eden
+} // namespace facebook
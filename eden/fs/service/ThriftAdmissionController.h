@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <thrift/lib/cpp/TProcessorEventHandler.h>
+#include <array>
+#include <atomic>
+#include <stdexcept>
+
+namespace facebook {
+namespace eden {
+
+class ServerState;
+
+/**
+ * Thrift methods are sorted into classes, each served by its own thread pool
+ * according to the method priorities declared in eden.thrift.
+ */
+enum class ThriftRequestClass : uint8_t {
+  /// Cheap, latency-sensitive methods such as getCurrentJournalPosition.
+  Interactive,
+  /// Everything that is neither interactive nor debug: status, glob, ...
+  Bulk,
+  /// The debug* methods.
+  Debug,
+};
+
+constexpr size_t kThriftRequestClassCount = 3;
+
+/**
+ * Returns the class of a method, named as in TProcessorEventHandler
+ * callbacks, e.g. "EdenService.getDaemonInfo". Methods of other services,
+ * such as fb303 counters, are interactive.
+ */
+ThriftRequestClass classifyThriftMethod(folly::StringPiece methodName);
+
+class ThriftOverloaded : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * Records how long each request waited for a Thrift worker thread, and
+ * throws ThriftOverloaded in preRead when more bulk or debug requests are in
+ * flight than allowed by thrift:max-bulk-requests and
+ * thrift:max-debug-requests. With thrift:adaptive-bulk-requests, bulk
+ * requests are also limited by EdenStats::getBackgroundRequestLimit().
+ *
+ * Interactive requests are never refused.
+ */
+class ThriftAdmissionController
+    : public apache::thrift::TProcessorEventHandler {
+ public:
+  explicit ThriftAdmissionController(std::shared_ptr<ServerState> serverState);
+
+  void* getContext(
+      const char* fn_name,
+      apache::thrift::TConnectionContext* connectionContext) override;
+  void freeContext(void* ctx, const char* fn_name) override;
+
+  void preRead(void* ctx, const char* fn_name) override;
+
+ private:
+  std::shared_ptr<ServerState> serverState_;
+
+  /**
+   * Number of requests of each class between getContext and freeContext,
+   * which the generated code only calls once the reply has been sent.
+   */
+  std::array<std::atomic<uint64_t>, kThriftRequestClassCount> inflight_{};
+};
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftClientAccounting.h"
+
+#include <fmt/format.h>
+#include <thrift/lib/cpp2/server/Cpp2ConnContext.h>
+#include <algorithm>
+#include <optional>
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/service/ThriftAdmissionController.h"
+
+namespace facebook {
+namespace eden {
+
+struct ThriftClientAccounting::Request {
+  std::chrono::steady_clock::time_point start{
+      std::chrono::steady_clock::now()};
+  std::optional<pid_t> pid;
+  uint64_t bytes{0};
+};
+
+ThriftClientAccounting::ThriftClientAccounting(
+    std::shared_ptr<ServerState> serverState)
+    : serverState_{std::move(serverState)} {}
+
+void* ThriftClientAccounting::getContext(
+    const char* /*fn_name*/,
+    apache::thrift::TConnectionContext* connectionContext) {
+  auto request = std::make_unique<Request>();
+#ifndef _WIN32
+  auto* requestContext =
+      dynamic_cast<apache::thrift::Cpp2RequestContext*>(connectionContext);
+  if (requestContext) {
+    if (auto creds =
+            requestContext->getConnectionContext()->getPeerEffectiveCreds()) {
+      request->pid = creds->pid;
+      serverState_->getProcessNameCache()->add(creds->pid);
+    }
+  }
+#else
+  // There is no way to retrieve peer credentials on Windows.
+  (void)connectionContext;
+#endif
+  return request.release();
+}
+
+void ThriftClientAccounting::freeContext(
+    void* ctx,
+    const char* /*fn_name*/) {
+  std::unique_ptr<Request> request{static_cast<Request*>(ctx)};
+  if (!request->pid) {
+    return;
+  }
+  auto duration = std::chrono::steady_clock::now() - request->start;
+  auto clients = clients_.wlock();
+  auto& cost = (*clients)[*request->pid].cost;
+  ++cost.calls;
+  cost.duration += duration;
+  cost.bytesReturned += request->bytes;
+}
+
+void ThriftClientAccounting::preRead(void* ctx, const char* fn_name) {
+  auto* request = static_cast<Request*>(ctx);
+  if (!request->pid ||
+      classifyThriftMethod(fn_name) == ThriftRequestClass::Interactive) {
+    return;
+  }
+
+  auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  auto rate = config->thriftClientRequestsPerSecond.getValue();
+  if (rate == 0) {
+    return;
+  }
+  auto burst = std::max(config->thriftClientRequestBurst.getValue(), rate);
+
+  auto clients = clients_.wlock();
+  auto& client = (*clients)[*request->pid];
+  if (client.bucket.consume(1, rate, burst)) {
+    return;
+  }
+  ++client.cost.throttled;
+  throw ThriftOverloaded{fmt::format(
+      "{} refused: pid {} exceeded {} requests per second",
+      fn_name,
+      *request->pid,
+      rate)};
+}
+
+void ThriftClientAccounting::postWrite(
+    void* ctx,
+    const char* /*fn_name*/,
+    uint32_t bytes) {
+  static_cast<Request*>(ctx)->bytes += bytes;
+}
+
+void ThriftClientAccounting::recordBackingStoreFetch(pid_t pid) {
+  ++(*clients_.wlock())[pid].cost.backingStoreFetches;
+}
+
+std::map<pid_t, ThriftClientCost> ThriftClientAccounting::getCosts() const {
+  std::map<pid_t, ThriftClientCost> costs;
+  auto clients = clients_.rlock();
+  for (const auto& [pid, client] : *clients) {
+    costs.emplace(pid, client.cost);
+  }
+  return costs;
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/TokenBucket.h>
+#include <folly/container/F14Map.h>
+#include <sys/types.h>
+#include <thrift/lib/cpp/TProcessorEventHandler.h>
+#include <chrono>
+#include <map>
+
+namespace facebook {
+namespace eden {
+
+class ServerState;
+
+/**
+ * What a client cost EdenFS through its Thrift requests.
+ */
+struct ThriftClientCost {
+  /// Number of requests, including the throttled ones.
+  uint64_t calls{0};
+  /// Number of requests refused by the rate limit.
+  uint64_t throttled{0};
+  /// Time between the start of each request and its reply being sent.
+  std::chrono::nanoseconds duration{0};
+  /// Objects fetched from the backing store on behalf of the requests.
+  uint64_t backingStoreFetches{0};
+  /// Serialized size of the replies.
+  uint64_t bytesReturned{0};
+};
+
+/**
+ * Attributes the cost of every Thrift request to the pid of the calling
+ * process, and throttles the clients that exceed
+ * thrift:client-requests-per-second with a token bucket.
+ *
+ * The requests that are cheap to serve, as classified by
+ * classifyThriftMethod(), are accounted for but never throttled, so that a
+ * throttled client can still query the daemon status.
+ */
+class ThriftClientAccounting : public apache::thrift::TProcessorEventHandler {
+ public:
+  explicit ThriftClientAccounting(std::shared_ptr<ServerState> serverState);
+
+  void* getContext(
+      const char* fn_name,
+      apache::thrift::TConnectionContext* connectionContext) override;
+  void freeContext(void* ctx, const char* fn_name) override;
+
+  void preRead(void* ctx, const char* fn_name) override;
+  void postWrite(void* ctx, const char* fn_name, uint32_t bytes) override;
+
+  /**
+   * Called by the fetch context of a Thrift request each time it caused an
+   * object to be fetched from the backing store.
+   */
+  void recordBackingStoreFetch(pid_t pid);
+
+  /**
+   * Returns the cost of every client seen since the daemon started.
+   */
+  std::map<pid_t, ThriftClientCost> getCosts() const;
+
+ private:
+  struct Client {
+    ThriftClientCost cost;
+    folly::DynamicTokenBucket bucket;
+  };
+
+  struct Request;
+
+  std::shared_ptr<ServerState> serverState_;
+  folly::Synchronized<folly::F14NodeMap<pid_t, Client>> clients_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -37,7 +37,7 @@ inline Hash20 hash20FromThrift(folly::StringPiece commitID) {
     return Hash20(folly::ByteRange(folly::StringPiece(commitID)));
   } else if (commitID.size() == 2 * Hash20::RAW_SIZE) {
     // This looks like 40 bytes of hexadecimal data.
-    return Hash20(commitID);
+    return Hash20::fromHex(commitID);
   } else {
     throw newEdenError(
         EINVAL,
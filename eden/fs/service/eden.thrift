@@ -262,6 +262,9 @@ enum FileAttributes {
   NONE = 0,
   SHA1_HASH = 1,
   FILE_SIZE = 2,
+  // Fast to compute for materialized files, but may require fetching the
+  // contents of files that are not.
+  BLAKE3_HASH = 4,
 /* NEXT_ATTR = 2^x */
 } (cpp2.enum_type = 'uint64_t')
 
@@ -271,6 +274,7 @@ enum FileAttributes {
 struct FileAttributeData {
   1: optional BinaryHash sha1;
   2: optional i64 fileSize;
+  3: optional binary blake3;
 }
 
 /**
@@ -543,6 +547,24 @@ struct ScmBlobMetadata {
   2: BinaryHash contentsSha1;
 }
 
+/**
+ * A response that was left in shared memory rather than returned through
+ * Thrift.
+ *
+ * To collect it, connect to socketPath and send the token as 8 little-endian
+ * bytes. The reply carries a sealed memfd holding the size bytes of the
+ * response, or no file descriptor and an error message if the token is
+ * unknown. A response can be collected once, and is dropped if it is not
+ * collected within 30 seconds.
+ *
+ * Only supported on Linux.
+ */
+struct SharedMemoryResponse {
+  1: i64 token;
+  2: i64 size;
+  3: PathString socketPath;
+}
+
 struct ScmTreeEntry {
   1: binary name;
   2: i32 mode;
@@ -618,6 +640,13 @@ struct GetFetchedFilesResult {
   1: map<string, set<PathString>> fetchedFilePaths;
 }
 
+struct StartRecordingPrefetchProfileParams {
+  1: PathString mountPoint;
+  2: string profileName;
+  // Only record the files loaded by this process. 0 records every process.
+  3: pid_t pid;
+}
+
 struct WorkingDirectoryParents {
   1: ThriftRootId parent1;
   // This field is never used by EdenFS.
@@ -641,6 +670,79 @@ struct InodePathDebugInfo {
   3: bool linked;
 }
 
+/**
+ * Latency distribution of one FUSE opcode, NFS procedure or ProjectedFS
+ * callback, since EdenFS started. Percentiles are accurate to within 12.5%.
+ */
+struct FsRequestLatency {
+  1: string operation;
+  2: i64 count;
+  3: i64 p50Micros;
+  4: i64 p90Micros;
+  5: i64 p99Micros;
+  6: i64 p999Micros;
+  7: i64 maxMicros;
+}
+
+/**
+ * A filesystem request that was among the slowest of its minute.
+ */
+struct SlowFsRequest {
+  1: string operation;
+  2: i64 durationMicros;
+  // When the request finished, in seconds since the epoch.
+  3: i64 finishedAt;
+  4: optional pid_t pid;
+  5: optional i64 inodeNumber;
+  6: optional PathString path;
+  // Where the last source control object the request needed came from:
+  // not_fetched, memory_cache, disk_cache or network.
+  7: string fetchOrigin;
+  // Time spent waiting on source control objects that were not cached in
+  // memory. Concurrent fetches are summed.
+  8: i64 backingStoreMicros;
+  // The id the request has in trace events: FuseCall.unique or
+  // NfsCall.requestId.
+  9: optional i64 requestId;
+}
+
+struct DebugFsRequestLatencyResponse {
+  1: list<FsRequestLatency> latencies;
+  // The slowest requests of each of the last 10 minutes, oldest first.
+  2: list<SlowFsRequest> slowRequests;
+}
+
+/**
+ * A filesystem request or source control import that was in flight when an
+ * InFlightCallSample was taken.
+ */
+struct InFlightCall {
+  // fuse, nfs or hg.
+  1: string source;
+  // The mount of a filesystem request, or the repository of an import.
+  2: string location;
+  // The FUSE opcode or NFS procedure, or blob or tree for an import.
+  3: string operation;
+  // For an import, queued or importing. For a filesystem request, running,
+  // waiting on queued import or waiting on import.
+  4: string stage;
+  // See SlowFsRequest.requestId. Imports caused by a filesystem request
+  // carry the id of that request.
+  5: optional i64 requestId;
+  6: i64 ageMicros;
+}
+
+struct InFlightCallSample {
+  // When the sample was taken, in milliseconds since the epoch.
+  1: i64 takenAtMillis;
+  2: list<InFlightCall> calls;
+}
+
+struct DebugInFlightSamplesResponse {
+  // Oldest first. See core:in-flight-sample-interval.
+  1: list<InFlightCallSample> samples;
+}
+
 struct ActivityRecorderResult {
   // 0 if the operation has failed. For example,
   // fail to start recording due to file permission issue
@@ -681,6 +783,7 @@ struct CacheStats {
   4: i64 missCount;
   5: i64 evictionCount;
   6: i64 dropCount;
+  7: i64 admissionRejectCount;
 }
 
 /*
@@ -774,6 +877,8 @@ struct NfsCall {
   1: i32 xid;
   2: i32 procNumber;
   3: string procName;
+  // Process-unique, unlike the xid which is chosen by the client.
+  4: i64 requestId;
 }
 
 enum PrjfsTraceCallType {
@@ -930,11 +1035,22 @@ struct MountAccesses {
   2: map<pid_t, i64> fetchCountsByPid;
 }
 
+/**
+ * The cost of the Thrift requests of one client process since EdenFS started.
+ */
+struct ThriftAccessCounts {
+  1: i64 calls;
+  // Requests refused by thrift:client-requests-per-second.
+  2: i64 throttled;
+  3: i64 durationNs;
+  4: i64 backingStoreFetches;
+  5: i64 bytesReturned;
+}
+
 struct GetAccessCountsResult {
   1: map<pid_t, binary> cmdsByPid;
   2: map<PathString, MountAccesses> accessesByMount;
-// TODO: Count the number of thrift requests
-// 3: map<pid_t, AccessCount> thriftAccesses
+  3: map<pid_t, ThriftAccessCounts> thriftAccessesByPid;
 }
 
 enum TracePointEvent {
@@ -1022,6 +1138,16 @@ struct GetScmStatusParams {
    * directory) will never be reported even when listIgnored is true.
    */
   3: bool listIgnored = false;
+
+  /**
+   * Paths relative to the root of the checkout to limit the status to.
+   *
+   * When not empty, only files under one of these paths are reported, and
+   * the directories that aren't under nor leading to one of them are not
+   * compared at all.  The result is the same as the status of the whole
+   * checkout filtered to these paths.
+   */
+  4: list<PathString> pathPrefixes;
 }
 
 /**
@@ -1049,6 +1175,32 @@ struct SetPathObjectIdResult {
   1: list<CheckoutConflict> conflicts;
 }
 
+struct PathObjectId {
+  1: PathString path;
+  2: ThriftObjectId objectId;
+  3: ObjectType type;
+}
+
+struct SetPathObjectIdsParams {
+  1: PathString mountPoint;
+  2: list<PathObjectId> objects;
+  3: CheckoutMode mode;
+  // Extra request infomation. i.e. build uuid, cache session id.
+  4: optional map<string, string> requestInfo;
+}
+
+struct CaptureChromeTraceParams {
+  1: PathString mountPoint;
+  // How long to record events for, at most 10 minutes.
+  2: i64 durationMs;
+}
+
+struct ChromeTraceResult {
+  // The events in the Chrome trace-event JSON format, which Perfetto and
+  // chrome://tracing load directly.
+  1: binary json;
+}
+
 struct CheckOutRevisionParams {
   /**
    * The hg root manifest that corresponds to the commit (if known).
@@ -1087,8 +1239,14 @@ struct SynchronizeWorkingCopyParams {
   1: SyncBehavior sync;
 }
 
+/**
+ * Methods are served by separate thread pools according to their priority:
+ * cheap, latency-sensitive methods are HIGH, debug methods are BEST_EFFORT and
+ * everything else runs in the NORMAL pool, so that a slow status or glob
+ * cannot delay a journal position query.
+ */
 service EdenService extends fb303_core.BaseService {
-  list<MountInfo> listMounts() throws (1: EdenError ex);
+  list<MountInfo> listMounts() throws (1: EdenError ex) (priority = 'HIGH');
   void mount(1: MountArgument info) throws (1: EdenError ex);
   void unmount(1: PathString mountPoint) throws (1: EdenError ex);
 
@@ -1114,6 +1272,11 @@ service EdenService extends fb303_core.BaseService {
    * errors. The caller is responsible for taking appropriate action to update
    * these paths as desired after checkOutRevision() returns.
    *
+   * If a previous checkout was interrupted, by cancelCheckout() or by EdenFS
+   * stopping, only a FORCE checkout or a checkout to the same snapshot is
+   * allowed. The latter resumes the interrupted checkout, skipping the work it
+   * already did.
+   *
    * Note: this internally synchronize the working copy.
    */
   list<CheckoutConflict> checkOutRevision(
@@ -1123,6 +1286,40 @@ service EdenService extends fb303_core.BaseService {
     4: CheckOutRevisionParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Stop the checkOutRevision() call in progress on this mount once the
+   * directories it is updating are done. That call then fails with ECANCELED,
+   * and leaves the working copy partially checked out until a checkout to the
+   * same snapshot resumes it.
+   *
+   * Returns false if no checkout is in progress.
+   */
+  bool cancelCheckout(1: PathString mountPoint) throws (
+    1: EdenError ex,
+  ) (priority = 'HIGH');
+
+  /**
+   * Exclude the given paths, and everything under them, from the working
+   * copy, replacing the paths excluded before. The working copy stays on the
+   * same snapshot: the newly excluded paths are removed and the ones no longer
+   * excluded are checked out again, with conflicts reported and handled as in
+   * checkOutRevision(). An empty list makes the whole snapshot visible again.
+   *
+   * The filter persists across restarts, and applies to later checkouts.
+   */
+  list<CheckoutConflict> setCheckoutFilter(
+    1: PathString mountPoint,
+    2: list<PathString> excludedPaths,
+    3: CheckoutMode checkoutMode,
+  ) throws (1: EdenError ex);
+
+  /**
+   * Get the paths excluded from the working copy by setCheckoutFilter().
+   */
+  list<PathString> getCheckoutFilter(1: PathString mountPoint) throws (
+    1: EdenError ex,
+  );
+
   /**
    * Reset the working directory's parent commits, without changing the working
    * directory contents.
@@ -1223,7 +1420,7 @@ service EdenService extends fb303_core.BaseService {
    */
   JournalPosition getCurrentJournalPosition(1: PathString mountPoint) throws (
     1: EdenError ex,
-  );
+  ) (priority = 'HIGH');
 
   /** Returns the set of files (and dirs) that changed since a prior point.
    * If fromPosition.mountGeneration is mismatched with the current
@@ -1262,7 +1459,7 @@ service EdenService extends fb303_core.BaseService {
    */
   DebugGetRawJournalResponse debugGetRawJournal(
     1: DebugGetRawJournalParams params,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Returns the subset of information about a list of paths that can
@@ -1332,6 +1529,17 @@ service EdenService extends fb303_core.BaseService {
    */
   Glob globFiles(1: GlobParams params) throws (1: EdenError ex);
 
+  /**
+   * Same as globFiles(), but the Glob, serialized with the Thrift compact
+   * protocol, is handed over in shared memory.
+   *
+   * This avoids copying the results of globs matching millions of files
+   * through the Thrift socket.
+   */
+  SharedMemoryResponse globFilesShared(1: GlobParams params) throws (
+    1: EdenError ex,
+  );
+
   /**
    * Gets a list of a user's most accessed directories, performs
    * prefetching as specified by PredictiveGlobParams, and returns
@@ -1376,6 +1584,8 @@ service EdenService extends fb303_core.BaseService {
     1: PathString mountPoint,
     2: bool listIgnored,
     3: ThriftRootId commit,
+    // Limits the status as GetScmStatusParams.pathPrefixes does.
+    4: list<PathString> pathPrefixes,
   ) throws (1: EdenError ex);
 
   /**
@@ -1384,11 +1594,15 @@ service EdenService extends fb303_core.BaseService {
    *
    * This is used by Watchman and which will be deprecated once EdenFS provides
    * an API to get the set of files changed between 2 journal clocks.
+   *
+   * When pathPrefixes is not empty, only the files under them are compared,
+   * as for GetScmStatusParams.pathPrefixes.
    */
   ScmStatus getScmStatusBetweenRevisions(
     1: PathString mountPoint,
     2: ThriftRootId oldHash,
     3: ThriftRootId newHash,
+    4: list<PathString> pathPrefixes,
   ) throws (1: EdenError ex);
 
   //////// Administrative APIs ////////
@@ -1397,7 +1611,7 @@ service EdenService extends fb303_core.BaseService {
    * Returns information about the running process, including pid and command
    * line.
    */
-  DaemonInfo getDaemonInfo() throws (1: EdenError ex);
+  DaemonInfo getDaemonInfo() throws (1: EdenError ex) (priority = 'HIGH');
 
   /**
   * Returns information about the privhelper process, including accesibility.
@@ -1447,7 +1661,7 @@ service EdenService extends fb303_core.BaseService {
     1: PathString mountPoint,
     2: ThriftObjectId id,
     3: bool localStoreOnly,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Get the contents of a source control Blob.
@@ -1459,7 +1673,17 @@ service EdenService extends fb303_core.BaseService {
     1: PathString mountPoint,
     2: ThriftObjectId id,
     3: bool localStoreOnly,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
+
+  /**
+   * Same as debugGetScmBlob(), but the contents of the blob are handed over
+   * in shared memory, which suits large blobs.
+   */
+  SharedMemoryResponse debugGetScmBlobShared(
+    1: PathString mountPoint,
+    2: ThriftObjectId id,
+    3: bool localStoreOnly,
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Get the metadata about a source control Blob.
@@ -1473,7 +1697,7 @@ service EdenService extends fb303_core.BaseService {
     1: PathString mountPoint,
     2: ThriftObjectId id,
     3: bool localStoreOnly,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Get status about inodes with allocated inode numbers.
@@ -1505,7 +1729,7 @@ service EdenService extends fb303_core.BaseService {
     2: PathString path,
     3: i64 flags,
     4: SyncBehavior sync,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Get the list of outstanding fuse requests
@@ -1513,14 +1737,18 @@ service EdenService extends fb303_core.BaseService {
    * This will return the list of FuseCall structure containing the data from
    * fuse_in_header.
    */
-  list<FuseCall> debugOutstandingFuseCalls(1: PathString mountPoint);
+  list<FuseCall> debugOutstandingFuseCalls(
+    1: PathString mountPoint,
+  ) (priority = 'BEST_EFFORT');
 
   /**
    * Get the list of outstanding NFS requests
    *
    * This will return the list of NfsCall structure containing the data from the RPC request.
    */
-  list<NfsCall> debugOutstandingNfsCalls(1: PathString mountPoint);
+  list<NfsCall> debugOutstandingNfsCalls(
+    1: PathString mountPoint,
+  ) (priority = 'BEST_EFFORT');
 
   /**
    * Get the list of outstanding ProjectedFS requests
@@ -1528,7 +1756,9 @@ service EdenService extends fb303_core.BaseService {
    * This will return the list of PrjfsCall structure containing the data from
    * the PRJ_CALLBACK_DATA.
    */
-  list<PrjfsCall> debugOutstandingPrjfsCalls(1: PathString mountPoint);
+  list<PrjfsCall> debugOutstandingPrjfsCalls(
+    1: PathString mountPoint,
+  ) (priority = 'BEST_EFFORT');
 
   /**
    * Start recording performance metrics such as files read
@@ -1538,7 +1768,7 @@ service EdenService extends fb303_core.BaseService {
   ActivityRecorderResult debugStartRecordingActivity(
     1: PathString mountPoint,
     2: PathString outputDir,
-  );
+  ) (priority = 'BEST_EFFORT');
 
   /**
    * Stop the recording identified by unique
@@ -1549,7 +1779,7 @@ service EdenService extends fb303_core.BaseService {
   ActivityRecorderResult debugStopRecordingActivity(
     1: PathString mountPoint,
     2: i64 unique,
-  );
+  ) (priority = 'BEST_EFFORT');
 
   /**
    * Get the list of ongoing activity recordings
@@ -1559,7 +1789,7 @@ service EdenService extends fb303_core.BaseService {
    */
   ListActivityRecordingsResult debugListActivityRecordings(
     1: PathString mountPoint,
-  );
+  ) (priority = 'BEST_EFFORT');
 
   /**
    * Get the InodePathDebugInfo for the inode that corresponds to the given
@@ -1570,7 +1800,7 @@ service EdenService extends fb303_core.BaseService {
   InodePathDebugInfo debugGetInodePath(
     1: PathString mountPoint,
     2: i64 inodeNumber,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Clear pidFetchCounts_ in ObjectStore to start a new recording of process
@@ -1609,6 +1839,26 @@ service EdenService extends fb303_core.BaseService {
     1: EdenError ex,
   );
 
+  /**
+   * Start recording the paths of the files whose contents are loaded in a
+   * mount into the named prefetch profile.
+   *
+   * Once saved, a profile is replayed after every checkout of the mount: the
+   * blobs of its files in the new commit are prefetched in one batch.
+   */
+  void startRecordingPrefetchProfile(
+    1: StartRecordingPrefetchProfileParams params,
+  ) throws (1: EdenError ex);
+
+  /**
+   * Stop recording the named prefetch profile and save it, replacing any
+   * earlier recording of the same name. Returns the number of paths saved.
+   */
+  i64 stopRecordingPrefetchProfile(
+    1: PathString mountPoint,
+    2: string profileName,
+  ) throws (1: EdenError ex);
+
   /**
    * Column by column, clears and compacts the LocalStore. All columns are
    * compacted, but only columns that contain ephemeral data are cleared.
@@ -1625,12 +1875,16 @@ service EdenService extends fb303_core.BaseService {
    * Clears all data from the LocalStore that can be populated from the upstream
    * backing store.
    */
-  void debugClearLocalStoreCaches() throws (1: EdenError ex);
+  void debugClearLocalStoreCaches() throws (1: EdenError ex) (
+    priority = 'BEST_EFFORT',
+  );
 
   /**
    * Asks RocksDB to perform a compaction.
    */
-  void debugCompactLocalStorage() throws (1: EdenError ex);
+  void debugCompactLocalStorage() throws (1: EdenError ex) (
+    priority = 'BEST_EFFORT',
+  );
 
   /**
    * Requests EdenFS to drop all pending backing store fetches.
@@ -1638,6 +1892,23 @@ service EdenService extends fb303_core.BaseService {
    */
   i64 debugDropAllPendingRequests() throws (1: EdenError ex);
 
+  /**
+   * Get the latency distribution of every kind of filesystem request, and
+   * the details of the slowest recent ones.
+   */
+  DebugFsRequestLatencyResponse debugGetFsRequestLatency() throws (
+    1: EdenError ex,
+  ) (priority = 'BEST_EFFORT');
+
+  /**
+   * Get the recent periodic samples of the filesystem requests and source
+   * control imports that were in flight, to inspect what a stall was stuck
+   * on.
+   */
+  DebugInFlightSamplesResponse debugGetInFlightSamples() throws (
+    1: EdenError ex,
+  ) (priority = 'BEST_EFFORT');
+
   /**
   * Unloads unused Inodes from a directory inside a mountPoint whose last
   * access time is older than the specified age.
@@ -1716,6 +1987,18 @@ service EdenService extends fb303_core.BaseService {
     1: SetPathObjectIdParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Batched version of setPathObjectId.
+   *
+   * The objects are applied in path order under a single rename lock, and the
+   * files of a same directory are checked out together, which is much cheaper
+   * than one setPathObjectId call per object. When a path appears more than
+   * once, the last object wins. The conflicts of all the objects are returned.
+   */
+  SetPathObjectIdResult setPathObjectIds(
+    1: SetPathObjectIdsParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * Functionally same as rm -r command but more efficient since rm command would
    * load every subtree before unlinking it.
@@ -1723,4 +2006,13 @@ service EdenService extends fb303_core.BaseService {
   void removeRecursively(1: RemoveRecursivelyParams params) throws (
     1: EdenError ex,
   );
+
+  /**
+   * Records the FUSE or NFS requests, the hg imports and the checkouts of a
+   * mount for durationMs, and returns them as a Chrome trace. Each import
+   * caused by a filesystem request is linked to it by a flow event.
+   */
+  ChromeTraceResult captureChromeTrace(
+    1: CaptureChromeTraceParams params,
+  ) throws (1: EdenError ex);
 }
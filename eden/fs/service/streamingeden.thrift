@@ -122,6 +122,9 @@ struct HgEvent {
   7: optional RequestInfo requestInfo;
   8: HgImportPriority importPriority;
   9: HgImportCause importCause;
+  // The FuseCall.unique or NfsCall.requestId of the filesystem request, or the
+  // id of the Thrift call, that caused the import.
+  10: optional i64 requestId;
 }
 
 /**
@@ -152,6 +155,51 @@ struct StreamChangesSinceParams {
   2: eden.JournalPosition fromPosition;
 }
 
+/**
+ * An item of the streamGetAttributesFromFiles stream: the attributes of
+ * params.paths[index].
+ */
+struct FileAttributesResult {
+  1: i64 index;
+  2: eden.FileAttributeDataOrError result;
+}
+
+/**
+ * Argument to streamPrefetchFiles API.
+ *
+ * globs, includeDotfiles, revisions and searchRoot select files as in
+ * eden.GlobParams.
+ */
+struct StreamPrefetchFilesParams {
+  1: eden.PathString mountPoint;
+  2: list<string> globs;
+  3: bool includeDotfiles;
+  4: list<eden.ThriftRootId> revisions;
+  5: eden.PathString searchRoot;
+  // Priority of the fetches, relative to the other imports.
+  6: HgImportPriority priority = HgImportPriority.LOW;
+  // How many blobs to fetch per backing store batch. 0 uses the default.
+  7: i64 batchSize = 0;
+}
+
+/**
+ * An item of the streamPrefetchFiles stream. The first one is sent once the
+ * blobs to fetch are known, before any is fetched, and has batchBlobs set to
+ * 0. Each of the others is sent once a batch has been fetched.
+ */
+struct PrefetchProgress {
+  // Distinct blobs of the matching files.
+  1: i64 totalBlobs;
+  // Blobs that were already cached locally, and are not fetched.
+  2: i64 cachedBlobs;
+  // Blobs fetched so far.
+  3: i64 fetchedBlobs;
+  // Blobs in the batch that was just fetched.
+  4: i64 batchBlobs;
+  // How long fetching that batch took.
+  5: i64 batchDurationMicros;
+}
+
 /**
  * This Thrift service defines streaming functions. It is separate from
  * EdenService because older Thrift runtimes do not support Thrift streaming,
@@ -224,4 +272,61 @@ service StreamingEdenService extends eden.EdenService {
   > streamChangesSince(1: StreamChangesSinceParams params) throws (
     1: eden.EdenError ex,
   );
+
+  /**
+   * Like globFiles, but returns the matching files in chunks as they are
+   * found, so that clients can start processing them before the whole glob
+   * has been evaluated, and EdenFS doesn't have to hold all of them in
+   * memory.
+   *
+   * Each Glob in the stream holds some of the matching files, with dtypes and
+   * originHashes as globFiles would return them. The files are returned in no
+   * particular order. prefetchFiles, suppressFileList and background are
+   * ignored.
+   */
+  stream<eden.Glob throws (1: eden.EdenError ex)> streamGlobFiles(
+    1: eden.GlobParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Like getScmStatusV2, but returns the status of each file as it is found,
+   * so that clients can start processing them before the whole working copy
+   * has been compared, and EdenFS doesn't have to hold all of them in memory.
+   *
+   * Files are returned in no particular order. Unlike getScmStatusV2, the
+   * stream ends with an error as soon as the status of a file can't be
+   * computed.
+   */
+  stream<ChangedFileResult throws (1: eden.EdenError ex)> streamScmStatus(
+    1: eden.GetScmStatusParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Like getAttributesFromFiles, but returns the attributes of each file as
+   * soon as they are known, so that files whose metadata is cached don't wait
+   * for the ones that have to be read or fetched.
+   *
+   * Results are returned in completion order; the index of each one says
+   * which of params.paths it belongs to.
+   */
+  stream<
+    FileAttributesResult throws (1: eden.EdenError ex)
+  > streamGetAttributesFromFiles(
+    1: eden.GetAttributesFromFilesParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Fetch the blobs of the files matching params.globs, reporting progress as
+   * it goes.
+   *
+   * The blobs are deduplicated and the ones already cached locally are
+   * skipped before anything is fetched. The rest are fetched one batch of
+   * params.batchSize blobs at a time, at params.priority. The stream ends
+   * once all of them have been fetched, or with an error if one could not be.
+   */
+  stream<
+    PrefetchProgress throws (1: eden.EdenError ex)
+  > streamPrefetchFiles(1: StreamPrefetchFilesParams params) throws (
+    1: eden.EdenError ex,
+  );
 }
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MaintenanceScheduler.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+const IdleThresholds kThresholds{
+    /*maxChannelRequestRate=*/10,
+    /*maxCpuUtilization=*/0.5,
+    /*maxIoRate=*/1000};
+
+HostLoad quiet() {
+  return HostLoad{1, 0.1, 10};
+}
+
+} // namespace
+
+TEST(IdleDetector, idleOnceLoadStaysLowForDelay) {
+  IdleDetector detector;
+  auto start = IdleDetector::Clock::now();
+  EXPECT_TRUE(detector.isBusy());
+  EXPECT_FALSE(detector.isIdle(0s, start));
+
+  // The first sample covers the period since the previous one, so the host
+  // has been quiet since then.
+  detector.record(quiet(), kThresholds, start);
+  detector.record(quiet(), kThresholds, start + 10s);
+  EXPECT_FALSE(detector.isBusy());
+  EXPECT_FALSE(detector.isIdle(30s, start + 10s));
+
+  detector.record(quiet(), kThresholds, start + 20s);
+  detector.record(quiet(), kThresholds, start + 30s);
+  EXPECT_TRUE(detector.isIdle(30s, start + 30s));
+}
+
+TEST(IdleDetector, anyLoadAboveItsThresholdIsBusy) {
+  auto start = IdleDetector::Clock::now();
+  for (auto load :
+       {HostLoad{11, 0.1, 10},
+        HostLoad{1, 0.6, 10},
+        HostLoad{1, 0.1, 2000}}) {
+    IdleDetector detector;
+    detector.record(quiet(), kThresholds, start);
+    detector.record(quiet(), kThresholds, start + 60s);
+    EXPECT_TRUE(detector.isIdle(30s, start + 60s));
+
+    detector.record(load, kThresholds, start + 70s);
+    EXPECT_TRUE(detector.isBusy());
+    EXPECT_FALSE(detector.isIdle(0s, start + 70s));
+
+    // Quiet again: the idle delay starts over from the end of the busy
+    // period.
+    detector.record(quiet(), kThresholds, start + 80s);
+    EXPECT_FALSE(detector.isBusy());
+    EXPECT_TRUE(detector.isIdle(10s, start + 80s));
+    EXPECT_FALSE(detector.isIdle(30s, start + 80s));
+  }
+}
+
+TEST(IdleDetector, unknownLoadDoesNotMakeBusy) {
+  IdleDetector detector;
+  auto now = IdleDetector::Clock::now();
+  detector.record(HostLoad{}, kThresholds, now);
+  EXPECT_FALSE(detector.isBusy());
+}
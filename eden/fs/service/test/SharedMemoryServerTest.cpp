@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifdef __linux__
+
+#include "eden/fs/service/SharedMemoryServer.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "eden/fs/utils/FutureUnixSocket.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using folly::test::TemporaryDirectory;
+
+namespace {
+
+UnixSocket::Message collect(
+    folly::EventBase& evb,
+    const SharedMemoryServer& server,
+    uint64_t token) {
+  FutureUnixSocket socket;
+  folly::IOBuf request{folly::IOBuf::CREATE, sizeof(token)};
+  folly::io::Appender{&request, 0}.writeLE(token);
+  auto reply = socket.connect(&evb, server.getSocketPath().stringPiece(), 5s)
+                   .thenValue([&](auto&&) {
+                     return socket.send(std::move(request));
+                   })
+                   .thenValue([&](auto&&) { return socket.receive(5s); });
+  return std::move(reply).getVia(&evb);
+}
+
+} // namespace
+
+TEST(SharedMemoryServer, publishedResponseIsCollectedOnce) {
+  TemporaryDirectory tmpDir("eden_shared_memory_test");
+  folly::EventBase evb;
+  SharedMemoryServer server{
+      &evb,
+      AbsolutePath{tmpDir.path().string()} + "shm.socket"_pc,
+      std::chrono::seconds{30}};
+
+  auto data = folly::IOBuf::copyBuffer("hello ");
+  data->prependChain(folly::IOBuf::copyBuffer("world"));
+  auto segment = server.publish(*data);
+  EXPECT_EQ(11, segment.size);
+
+  auto reply = collect(evb, server, segment.token);
+  ASSERT_EQ(1, reply.files.size());
+  struct stat st;
+  ASSERT_EQ(0, fstat(reply.files[0].fd(), &st));
+  ASSERT_EQ(11, st.st_size);
+  auto* mapped = static_cast<const char*>(
+      mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, reply.files[0].fd(), 0));
+  ASSERT_NE(MAP_FAILED, mapped);
+  EXPECT_EQ("hello world", std::string(mapped, st.st_size));
+  munmap(const_cast<char*>(mapped), st.st_size);
+
+  // The segment is sealed, so the client cannot change it.
+  EXPECT_EQ(
+      MAP_FAILED,
+      mmap(
+          nullptr,
+          st.st_size,
+          PROT_WRITE,
+          MAP_SHARED,
+          reply.files[0].fd(),
+          0));
+
+  auto second = collect(evb, server, segment.token);
+  EXPECT_EQ(0, second.files.size());
+  EXPECT_EQ(
+      "unknown shared memory token",
+      second.data.moveToFbString().toStdString());
+}
+
+TEST(SharedMemoryServer, uncollectedResponsesExpire) {
+  TemporaryDirectory tmpDir("eden_shared_memory_test");
+  folly::EventBase evb;
+  SharedMemoryServer server{
+      &evb,
+      AbsolutePath{tmpDir.path().string()} + "shm.socket"_pc,
+      std::chrono::nanoseconds{0}};
+
+  auto segment = server.publish(*folly::IOBuf::copyBuffer("expired"));
+  EXPECT_FALSE(server.take(segment.token));
+}
+
+#endif // __linux__
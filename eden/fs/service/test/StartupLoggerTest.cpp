@@ -455,6 +455,12 @@ TEST_F(FileStartupLoggerTest, loggingAppendsToFileIfItAlreadyExists) {
   EXPECT_EQ("existing line\nnew line\n", readLogContents());
 }
 
+TEST_F(FileStartupLoggerTest, logPhaseWritesParseableMessageToFile) {
+  auto logger = FileStartupLogger{logPath().stringPiece()};
+  logger.logPhase("local_store", std::chrono::milliseconds{1500});
+  EXPECT_EQ("Startup phase local_store took 1.5 seconds\n", readLogContents());
+}
+
 TEST_F(FileStartupLoggerTest, successWritesMessageToFile) {
   auto logger = FileStartupLogger{logPath().stringPiece()};
   logger.success(41);
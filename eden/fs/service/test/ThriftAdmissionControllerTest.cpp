@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftAdmissionController.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(ThriftAdmissionControllerTest, classifies_eden_methods) {
+  EXPECT_EQ(
+      ThriftRequestClass::Interactive,
+      classifyThriftMethod("EdenService.getCurrentJournalPosition"));
+  EXPECT_EQ(
+      ThriftRequestClass::Interactive,
+      classifyThriftMethod("EdenService.getDaemonInfo"));
+  EXPECT_EQ(
+      ThriftRequestClass::Bulk,
+      classifyThriftMethod("EdenService.getScmStatusV2"));
+  EXPECT_EQ(
+      ThriftRequestClass::Bulk, classifyThriftMethod("EdenService.globFiles"));
+  EXPECT_EQ(
+      ThriftRequestClass::Debug,
+      classifyThriftMethod("EdenService.debugInodeStatus"));
+  EXPECT_EQ(
+      ThriftRequestClass::Bulk,
+      classifyThriftMethod("StreamingEdenService.traceFsEvents"));
+}
+
+TEST(ThriftAdmissionControllerTest, other_services_are_interactive) {
+  EXPECT_EQ(
+      ThriftRequestClass::Interactive,
+      classifyThriftMethod("BaseService.getCounters"));
+  EXPECT_EQ(
+      ThriftRequestClass::Interactive, classifyThriftMethod("debugInodeStatus"));
+}
@@ -7,6 +7,7 @@
 
 #include "eden/fs/sqlite/SqliteDatabase.h"
 
+#include <folly/ScopeGuard.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
 
@@ -15,11 +16,36 @@ struct SqliteDatabase::StatementCache {
   explicit StatementCache(SqliteDatabase::Connection& db)
       : beginTransaction{db, "BEGIN"},
         commitTransaction{db, "COMMIT"},
-        rollbackTransaction{db, "ROLLBACK"} {}
+        rollbackTransaction{db, "ROLLBACK"},
+        savepoint{db, "SAVEPOINT batched"},
+        releaseSavepoint{db, "RELEASE batched"},
+        rollbackToSavepoint{db, "ROLLBACK TO batched"} {}
 
   PersistentSqliteStatement beginTransaction;
   PersistentSqliteStatement commitTransaction;
   PersistentSqliteStatement rollbackTransaction;
+  PersistentSqliteStatement savepoint;
+  PersistentSqliteStatement releaseSavepoint;
+  PersistentSqliteStatement rollbackToSavepoint;
+};
+
+struct SqliteDatabase::ReadPool {
+  ReadPool() = default;
+  ReadPool(const ReadPool&) = delete;
+  ReadPool& operator=(const ReadPool&) = delete;
+
+  ~ReadPool() {
+    for (auto& connection : connections) {
+      sqlite3_close(*connection->wlock());
+    }
+  }
+
+  std::vector<std::unique_ptr<folly::Synchronized<sqlite3*>>> connections;
+  /// Where the next reader starts looking for an idle connection.
+  std::atomic<size_t> next{0};
+  /// Mirrors `batch_.depth > 0` so readers can check it without the writer
+  /// lock.
+  std::atomic<bool> batchActive{false};
 };
 
 void checkSqliteResult(sqlite3* db, int result) {
@@ -44,7 +70,7 @@ void checkSqliteResult(sqlite3* db, int result) {
   }
 }
 
-SqliteDatabase::SqliteDatabase(const char* addr) {
+SqliteDatabase::SqliteDatabase(const char* addr) : address_{addr} {
   sqlite3* db = nullptr;
   auto result = sqlite3_open(addr, &db);
   if (result != SQLITE_OK) {
@@ -63,7 +89,17 @@ void SqliteDatabase::close() {
   // We must clear the cached statement before closing the database. Otherwise
   // `sqlite3_close` will fail with `SQLITE_BUSY`. This rule applies to any
   // statement cache elsewhere too.
+  if (batch_.depth > 0 && cache_ && *db) {
+    XLOG(WARN) << "closing SQLite database with a batch in progress";
+    try {
+      cache_->commitTransaction.get(db).step();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "failed to commit SQLite batch: " << ex.what();
+    }
+  }
+  batch_ = BatchState{};
   cache_.reset();
+  readPool_.reset();
   if (*db) {
     sqlite3_close(*db);
     *db = nullptr;
@@ -78,8 +114,53 @@ SqliteDatabase::Connection SqliteDatabase::lock() {
   return db_.wlock();
 }
 
+void SqliteDatabase::openReadConnections(size_t count) {
+  if (address_ == ":memory:" || count == 0) {
+    return;
+  }
+  auto pool = std::make_unique<ReadPool>();
+  for (size_t i = 0; i < count; ++i) {
+    sqlite3* db = nullptr;
+    auto result =
+        sqlite3_open_v2(address_.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    if (result != SQLITE_OK) {
+      // @lint-ignore CLANGTIDY
+      sqlite3_close(db);
+      checkSqliteResult(nullptr, result);
+    }
+    pool->connections.push_back(
+        std::make_unique<folly::Synchronized<sqlite3*>>(db));
+  }
+  readPool_ = std::move(pool);
+}
+
+size_t SqliteDatabase::getReadConnectionCount() const {
+  return readPool_ ? readPool_->connections.size() : 0;
+}
+
+std::optional<SqliteDatabase::ReadConnection> SqliteDatabase::lockForRead() {
+  if (!readPool_ || readPool_->batchActive.load(std::memory_order_acquire)) {
+    return std::nullopt;
+  }
+  auto& connections = readPool_->connections;
+  auto start = readPool_->next.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < connections.size(); ++i) {
+    auto index = (start + i) % connections.size();
+    if (auto conn = connections[index]->tryWLock()) {
+      return ReadConnection{std::move(conn), index};
+    }
+  }
+  // Every connection is busy; wait for the one this reader started with.
+  auto index = start % connections.size();
+  return ReadConnection{connections[index]->wlock(), index};
+}
+
 void SqliteDatabase::transaction(const std::function<void(Connection&)>& func) {
   auto conn = lock();
+  if (batch_.depth > 0) {
+    batchedTransaction(conn, func);
+    return;
+  }
   try {
     cache_->beginTransaction.get(conn).step();
     func(conn);
@@ -90,4 +171,71 @@ void SqliteDatabase::transaction(const std::function<void(Connection&)>& func) {
     throw;
   }
 }
+
+void SqliteDatabase::batchedTransaction(
+    Connection& conn,
+    const std::function<void(Connection&)>& func) {
+  try {
+    cache_->savepoint.get(conn).step();
+    func(conn);
+    cache_->releaseSavepoint.get(conn).step();
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "SQLite transaction failed: " << ex.what();
+    if (sqlite3_get_autocommit(*conn)) {
+      // Some errors, such as SQLITE_FULL or SQLITE_IOERR, make SQLite roll
+      // back the whole outer transaction. Open a new one for the rest of the
+      // batch.
+      XLOG(ERR) << "SQLite batch rolled back after "
+                << batch_.pendingTransactions << " transactions";
+      batch_.pendingTransactions = 0;
+      cache_->beginTransaction.get(conn).step();
+    } else {
+      cache_->rollbackToSavepoint.get(conn).step();
+      cache_->releaseSavepoint.get(conn).step();
+    }
+    throw;
+  }
+
+  if (batch_.commitInterval != 0 &&
+      ++batch_.pendingTransactions >= batch_.commitInterval) {
+    cache_->commitTransaction.get(conn).step();
+    batch_.pendingTransactions = 0;
+    cache_->beginTransaction.get(conn).step();
+  }
+}
+
+void SqliteDatabase::beginBatch(size_t commitInterval) {
+  auto conn = lock();
+  if (batch_.depth == 0) {
+    cache_->beginTransaction.get(conn).step();
+    batch_.commitInterval = commitInterval;
+    batch_.pendingTransactions = 0;
+    if (readPool_) {
+      readPool_->batchActive.store(true, std::memory_order_release);
+    }
+  }
+  ++batch_.depth;
+}
+
+void SqliteDatabase::endBatch() {
+  auto conn = lock();
+  XCHECK_GT(batch_.depth, 0u) << "endBatch() called without a batch";
+  if (--batch_.depth > 0) {
+    return;
+  }
+  SCOPE_EXIT {
+    if (readPool_) {
+      readPool_->batchActive.store(false, std::memory_order_release);
+    }
+  };
+  try {
+    cache_->commitTransaction.get(conn).step();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "failed to commit SQLite batch: " << ex.what();
+    if (!sqlite3_get_autocommit(*conn)) {
+      cache_->rollbackTransaction.get(conn).step();
+    }
+    throw;
+  }
+}
 } // namespace facebook::eden
@@ -9,6 +9,7 @@
 
 #include <folly/Synchronized.h>
 #include <sqlite3.h>
+#include <optional>
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -24,6 +25,16 @@ class SqliteDatabase {
   constexpr static struct InMemory {
   } inMemory{};
 
+  /**
+   * A locked read-only connection. `index` identifies the connection among
+   * the read connections, so callers can keep prepared statements per
+   * connection.
+   */
+  struct ReadConnection {
+    Connection conn;
+    size_t index;
+  };
+
   /** Open a handle to the database at the specified path.
    * Will throw an exception if the database fails to open.
    * The database will be created if it didn't already exist.
@@ -56,6 +67,31 @@ class SqliteDatabase {
    * to the SqliteStatement class. */
   Connection lock();
 
+  /**
+   * Open `count` read-only connections to the database, so that reads can
+   * run in parallel with each other and with the writer connection returned
+   * by lock(). The database must be in WAL mode, otherwise readers and the
+   * writer block each other at the file level.
+   *
+   * Does nothing for in-memory databases, which can't be shared between
+   * connections. Must be called before any other thread uses the database.
+   */
+  void openReadConnections(size_t count);
+
+  /**
+   * The number of connections opened by openReadConnections().
+   */
+  size_t getReadConnectionCount() const;
+
+  /**
+   * Lock one of the read-only connections, preferring one that isn't in use.
+   *
+   * Returns std::nullopt if there are no read connections, or while a batch
+   * is in progress: its uncommitted writes are only visible through lock().
+   * Read connections see the last committed state of the database.
+   */
+  std::optional<ReadConnection> lockForRead();
+
   /**
    * Executes a SQLite transaction. If the lambda body throws any error, the
    * transaction will be rolled back. This function returns a boolean to
@@ -72,13 +108,53 @@ class SqliteDatabase {
    */
   void transaction(const std::function<void(Connection&)>& func);
 
+  /**
+   * Start a batch: until the matching endBatch(), transactions are run as
+   * savepoints of a single outer transaction, which is committed every
+   * `commitInterval` transactions and when the batch ends. This trades the
+   * durability of the batched transactions for fewer commits, and thus
+   * fewer fsyncs. A transaction that fails is still rolled back on its own.
+   *
+   * Batches may nest; only the outermost one commits, and its
+   * `commitInterval` is used. 0 means the batch is only committed at the
+   * end.
+   */
+  void beginBatch(size_t commitInterval);
+
+  /**
+   * End the batch started by the matching beginBatch(). Throws if the
+   * outermost batch can't be committed.
+   */
+  void endBatch();
+
  private:
   struct StatementCache;
+  struct ReadPool;
+
+  struct BatchState {
+    /// Number of beginBatch() calls without a matching endBatch().
+    size_t depth{0};
+    size_t commitInterval{0};
+    /// Transactions run since the outer transaction was last committed.
+    size_t pendingTransactions{0};
+  };
 
   explicit SqliteDatabase(const char* address);
 
+  void batchedTransaction(
+      Connection& conn,
+      const std::function<void(Connection&)>& func);
+
   folly::Synchronized<sqlite3*> db_{nullptr};
 
+  // Protected by the lock of db_.
+  BatchState batch_;
+
   std::unique_ptr<StatementCache> cache_;
+
+  // The path the database was opened with, used to open read connections.
+  std::string address_;
+
+  std::unique_ptr<ReadPool> readPool_;
 };
 } // namespace facebook::eden
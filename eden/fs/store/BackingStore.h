@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <folly/futures/Future.h>
+#include <folly/io/IOBuf.h>
 #include <memory>
 
 #include "eden/fs/model/BlobMetadata.h"
@@ -106,6 +107,29 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
       const ObjectId& id,
       ObjectFetchContext& context) = 0;
 
+  /**
+   * Returns true if getBlobRange() can fetch part of a blob without fetching
+   * the whole blob.
+   */
+  virtual bool supportsBlobRanges() {
+    return false;
+  }
+
+  /**
+   * Fetch up to `length` bytes of the contents of a blob, starting at
+   * `offset`. Only called if supportsBlobRanges() returns true.
+   *
+   * The result is not cached in the LocalStore.
+   */
+  virtual folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& /*id*/,
+      uint64_t /*offset*/,
+      uint64_t /*length*/,
+      ObjectFetchContext& /*context*/) {
+    return folly::makeSemiFuture<std::unique_ptr<folly::IOBuf>>(
+        std::logic_error("this backing store does not support blob ranges"));
+  }
+
   /**
    * Fetch blob metadata if available locally.
    */
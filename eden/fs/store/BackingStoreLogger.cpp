@@ -8,8 +8,11 @@
 #include "eden/fs/store/BackingStoreLogger.h"
 
 #include <folly/Conv.h>
+#include <folly/Random.h>
 
 #include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/telemetry/LogEvent.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
@@ -17,29 +20,10 @@
 
 namespace facebook::eden {
 
-BackingStoreLogger::BackingStoreLogger(
-    std::shared_ptr<StructuredLogger> logger,
-    std::shared_ptr<ProcessNameCache> processNameCache)
-    : logger_{std::move(logger)},
-      processNameCache_{std::move(processNameCache)},
-      loggingAvailable_{true} {}
-
-void BackingStoreLogger::logImport(
-    ObjectFetchContext& context,
-    RelativePathPiece importPath,
-    ObjectFetchContext::ObjectType fetchedType) {
-  if (!loggingAvailable_) {
-    return;
-  }
-  auto pid = context.getClientPid();
-  auto cause = context.getCause();
-  auto importPathString = importPath.stringPiece().str();
-
-  std::optional<std::string> cmdline;
-  if (pid) {
-    cmdline = processNameCache_->getSpacedProcessName(pid.value());
-  }
-
+namespace {
+std::string causeToString(
+    ObjectFetchContext::Cause cause,
+    const std::optional<std::string>& causeDetail) {
   std::string cause_string = "<invalid>";
   switch (cause) {
     case ObjectFetchContext::Cause::Fs:
@@ -54,11 +38,14 @@ void BackingStoreLogger::logImport(
     case ObjectFetchContext::Unknown:
       cause_string = "Unknown";
   }
-  if (auto causeDetail = context.getCauseDetail()) {
+  if (causeDetail) {
     cause_string =
         folly::to<std::string>(cause_string, " - ", causeDetail.value());
   }
+  return cause_string;
+}
 
+std::string typeToString(ObjectFetchContext::ObjectType fetchedType) {
   std::string typeString = "<invalid>";
   switch (fetchedType) {
     case ObjectFetchContext::ObjectType::Blob:
@@ -74,13 +61,124 @@ void BackingStoreLogger::logImport(
       // invalid string prolly good here
       break;
   }
+  return typeString;
+}
+} // namespace
 
-  logger_->logEvent(ServerDataFetch{
-      std::move(cause_string),
+BackingStoreLogger::BackingStoreLogger(
+    std::shared_ptr<StructuredLogger> logger,
+    std::shared_ptr<ProcessNameCache> processNameCache,
+    std::shared_ptr<ReloadableConfig> config)
+    : logger_{std::move(logger)},
+      processNameCache_{std::move(processNameCache)},
+      config_{std::move(config)},
+      loggingAvailable_{true},
+      thread_{[this] { run(); }} {}
+
+BackingStoreLogger::~BackingStoreLogger() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  state_.lock()->stopping = true;
+  queuedCv_.notify_all();
+  thread_.join();
+}
+
+bool BackingStoreLogger::isSampled(ObjectFetchContext::Cause cause) const {
+  auto config = config_->getEdenConfig(ConfigReloadBehavior::NoReload);
+  const auto& denominators =
+      config->logObjectFetchSampleDenominators.getValue();
+  if (cause >= denominators.size()) {
+    return false;
+  }
+  auto denominator = denominators[cause];
+  return denominator != 0 &&
+      (denominator == 1 || folly::Random::oneIn(denominator));
+}
+
+void BackingStoreLogger::logImport(
+    ObjectFetchContext& context,
+    RelativePathPiece importPath,
+    ObjectFetchContext::ObjectType fetchedType) {
+  if (!loggingAvailable_) {
+    return;
+  }
+  auto cause = context.getCause();
+  if (!isSampled(cause)) {
+    return;
+  }
+
+  auto pid = context.getClientPid();
+  if (pid) {
+    // Only start resolving the name here: the logger thread waits for it.
+    processNameCache_->add(pid.value());
+  }
+  std::optional<std::string> causeDetail;
+  if (auto detail = context.getCauseDetail()) {
+    causeDetail = detail->str();
+  }
+  PendingEvent event{
+      cause,
+      std::move(causeDetail),
       pid,
+      importPath.stringPiece().str(),
+      fetchedType};
+
+  {
+    auto state = state_.lock();
+    if (state->pending.size() >= kMaxPendingEvents) {
+      return;
+    }
+    state->pending.push_back(std::move(event));
+    ++state->queued;
+  }
+  queuedCv_.notify_one();
+}
+
+void BackingStoreLogger::flush() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  auto state = state_.lock();
+  auto target = state->queued;
+  doneCv_.wait(state.as_lock(), [&] { return state->done >= target; });
+}
+
+void BackingStoreLogger::run() {
+  auto state = state_.lock();
+  while (true) {
+    queuedCv_.wait(state.as_lock(), [&] {
+      return state->stopping || !state->pending.empty();
+    });
+    if (state->pending.empty()) {
+      // Stopping, with everything logged.
+      return;
+    }
+
+    // Events queued while this batch is logged form the next one.
+    auto batch = std::exchange(state->pending, {});
+    state.unlock();
+    for (auto& event : batch) {
+      logEvent(event);
+    }
+    state = state_.lock();
+    state->done += batch.size();
+    doneCv_.notify_all();
+  }
+}
+
+void BackingStoreLogger::logEvent(PendingEvent& event) {
+  std::optional<std::string> cmdline;
+  if (event.pid) {
+    cmdline = processNameCache_->getSpacedProcessName(event.pid.value());
+  }
+
+  logger_->logEvent(ServerDataFetch{
+      causeToString(event.cause, event.causeDetail),
+      event.pid,
       std::move(cmdline),
-      std::move(importPathString),
-      std::move(typeString)});
+      std::move(event.path),
+      typeToString(event.type)});
 }
 
 } // namespace facebook::eden
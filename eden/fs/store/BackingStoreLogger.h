@@ -8,7 +8,13 @@
 #pragma once
 
 #include <folly/Executor.h>
+#include <folly/Synchronized.h>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -18,27 +24,78 @@ namespace facebook::eden {
 class UnboundedQueueExecutor;
 class StructuredLogger;
 class ProcessNameCache;
+class ReloadableConfig;
 
+/**
+ * Logs the fetches that `telemetry:log-object-fetch-path-regex` selects.
+ *
+ * Fetches are sampled according to their cause, and only the sampled ones
+ * are queued. A background thread resolves the process names of a whole
+ * batch of queued fetches and logs them, so that logging adds almost nothing
+ * to the fetch path. If the thread falls behind, fetches beyond
+ * kMaxPendingEvents are dropped.
+ */
 class BackingStoreLogger {
  public:
   BackingStoreLogger(
       std::shared_ptr<StructuredLogger> logger,
-      std::shared_ptr<ProcessNameCache> processNameCache);
+      std::shared_ptr<ProcessNameCache> processNameCache,
+      std::shared_ptr<ReloadableConfig> config);
 
   // for unit tests so that a no-op logger can be passed into the backing store
   BackingStoreLogger() = default;
 
+  ~BackingStoreLogger();
+
+  BackingStoreLogger(const BackingStoreLogger&) = delete;
+  BackingStoreLogger& operator=(const BackingStoreLogger&) = delete;
+
   void logImport(
       ObjectFetchContext& context,
       RelativePathPiece importPath,
       ObjectFetchContext::ObjectType fetchedType);
 
+  /**
+   * Return once every fetch queued so far has been logged.
+   */
+  void flush();
+
+  static constexpr size_t kMaxPendingEvents = 10000;
+
  private:
+  struct PendingEvent {
+    ObjectFetchContext::Cause cause;
+    std::optional<std::string> causeDetail;
+    std::optional<pid_t> pid;
+    std::string path;
+    ObjectFetchContext::ObjectType type;
+  };
+
+  struct State {
+    std::vector<PendingEvent> pending;
+    /// Events queued, and events logged, since construction.
+    uint64_t queued{0};
+    uint64_t done{0};
+    bool stopping{false};
+  };
+
+  bool isSampled(ObjectFetchContext::Cause cause) const;
+  void run();
+  void logEvent(PendingEvent& event);
+
   std::shared_ptr<StructuredLogger> logger_;
   std::shared_ptr<ProcessNameCache> processNameCache_;
+  std::shared_ptr<ReloadableConfig> config_;
 
   // for unit tests so that a no-op logger can be passed into the backing store
   bool loggingAvailable_ = false;
+
+  folly::Synchronized<State, std::mutex> state_;
+  /// Signaled when events are queued or the thread should stop.
+  std::condition_variable queuedCv_;
+  /// Signaled when a batch has been logged.
+  std::condition_variable doneCv_;
+  std::thread thread_;
 };
 
 } // namespace facebook::eden
@@ -7,16 +7,38 @@
 
 #include "eden/fs/store/BlobAccess.h"
 #include <folly/MapUtil.h>
+#include <folly/io/IOBuf.h>
+#include <folly/logging/xlog.h>
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/BlobCache.h"
 #include "eden/fs/store/IObjectStore.h"
 
 namespace facebook::eden {
 
+namespace {
+
+/**
+ * The BlobCache key for chunk `index` of the blob `hash`. The suffix keeps
+ * chunks apart from whole blobs, and includes the chunk size so that chunks
+ * cached before the chunk size changed are not mixed with newer ones.
+ */
+ObjectId chunkId(const ObjectId& hash, uint64_t index, uint64_t chunkSize) {
+  auto bytes = hash.asString();
+  bytes.append(":chunk:");
+  bytes.append(reinterpret_cast<const char*>(&chunkSize), sizeof(chunkSize));
+  bytes.append(reinterpret_cast<const char*>(&index), sizeof(index));
+  return ObjectId{bytes};
+}
+
+} // namespace
+
 BlobAccess::BlobAccess(
     std::shared_ptr<IObjectStore> objectStore,
     std::shared_ptr<BlobCache> blobCache)
-    : objectStore_{std::move(objectStore)}, blobCache_{std::move(blobCache)} {}
+    : objectStore_{std::move(objectStore)},
+      blobCache_{std::move(blobCache)},
+      pendingChunks_{std::make_shared<folly::Synchronized<
+          std::unordered_map<ObjectId, std::shared_ptr<ChunkPromise>>>>()} {}
 
 BlobAccess::~BlobAccess() {}
 
@@ -37,4 +59,87 @@ folly::Future<BlobCache::GetResult> BlobAccess::getBlob(
       });
 }
 
-} // namespace facebook::eden
+folly::Future<std::unique_ptr<folly::IOBuf>> BlobAccess::getBlobRange(
+    const ObjectId& hash,
+    uint64_t blobSize,
+    uint64_t offset,
+    uint64_t length,
+    uint64_t chunkSize,
+    ObjectFetchContext& context) {
+  XCHECK_GT(chunkSize, 0u);
+  if (offset >= blobSize || length == 0) {
+    return folly::makeFuture(folly::IOBuf::create(0));
+  }
+  length = std::min(length, blobSize - offset);
+
+  auto firstChunk = offset / chunkSize;
+  auto lastChunk = (offset + length - 1) / chunkSize;
+  std::vector<folly::Future<std::shared_ptr<const Blob>>> chunks;
+  chunks.reserve(lastChunk - firstChunk + 1);
+  for (auto index = firstChunk; index <= lastChunk; ++index) {
+    chunks.push_back(getBlobChunk(hash, blobSize, index, chunkSize, context));
+  }
+
+  return folly::collect(std::move(chunks))
+      .thenValue([offsetInChunk = offset - firstChunk * chunkSize,
+                  length](std::vector<std::shared_ptr<const Blob>> chunks) {
+        auto result = folly::IOBuf::create(0);
+        auto remaining = length;
+        auto chunkOffset = offsetInChunk;
+        for (const auto& chunk : chunks) {
+          auto piece = chunk->cloneRange(chunkOffset, remaining);
+          remaining -= std::min(remaining, piece->computeChainDataLength());
+          result->prependChain(std::move(piece));
+          chunkOffset = 0;
+        }
+        return result;
+      });
+}
+
+folly::Future<std::shared_ptr<const Blob>> BlobAccess::getBlobChunk(
+    const ObjectId& hash,
+    uint64_t blobSize,
+    uint64_t index,
+    uint64_t chunkSize,
+    ObjectFetchContext& context) {
+  auto id = chunkId(hash, index, chunkSize);
+  auto cached =
+      blobCache_->get(id, BlobCache::Interest::LikelyNeededAgain).object;
+  if (cached) {
+    return folly::makeFuture(std::move(cached));
+  }
+
+  auto promise = std::make_shared<ChunkPromise>();
+  {
+    auto pending = pendingChunks_->wlock();
+    auto [it, inserted] = pending->emplace(id, promise);
+    if (!inserted) {
+      return it->second->getFuture();
+    }
+  }
+
+  auto chunkOffset = index * chunkSize;
+  objectStore_
+      ->getBlobRange(
+          hash,
+          chunkOffset,
+          std::min(chunkSize, blobSize - chunkOffset),
+          context)
+      .thenTry([blobCache = blobCache_,
+                pendingChunks = pendingChunks_,
+                id = std::move(id),
+                promise](folly::Try<std::unique_ptr<folly::IOBuf>> buf) {
+        if (buf.hasException()) {
+          pendingChunks->wlock()->erase(id);
+          promise->setException(std::move(buf.exception()));
+          return;
+        }
+        // Cache the chunk before forgetting the fetch, so that a concurrent
+        // request finds one or the other.
+        auto chunk = std::make_shared<const Blob>(id, std::move(**buf));
+        blobCache->insert(chunk, BlobCache::Interest::LikelyNeededAgain);
+        pendingChunks->wlock()->erase(id);
+        promise->setValue(std::move(chunk));
+      });
+  return promise->getFuture();
+}
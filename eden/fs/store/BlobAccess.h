@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
 #include <memory>
+#include <unordered_map>
 #include "eden/fs/store/BlobCache.h"
 
 namespace facebook::eden {
@@ -23,10 +26,9 @@ class ObjectFetchContext;
  * cache for every read() request that makes into the edenfs process. Thus,
  * centralize blob access through this interface.
  *
- * TODO: To support large files, they should be split into a series of blobs,
- * and those blobs should get their own blob IDs, which could then be used
- * in this API. Splitting large blobs into a series of smaller blobs has the
- * benefit of helping bound Eden's memory usage here.
+ * Large files can instead be read in fixed-size chunks with getBlobRange(),
+ * which only fetches and caches the chunks covering the requested bytes and
+ * so bounds memory usage by what is read rather than by the file size.
  */
 class BlobAccess {
  public:
@@ -58,12 +60,45 @@ class BlobAccess {
       ObjectFetchContext& context,
       BlobCache::Interest interest = BlobCache::Interest::LikelyNeededAgain);
 
+  /**
+   * Loads and returns `length` bytes of the blob starting at `offset`,
+   * fetching only the `chunkSize` chunks of the blob that the range covers.
+   * Chunks are kept in the BlobCache so that subsequent reads nearby do not
+   * refetch them, and concurrent requests for a chunk share one fetch, so
+   * that a read can wait on a readahead of the same chunk.
+   *
+   * `blobSize` must be the size of the blob. The result is shorter than
+   * `length` if the range extends past the end of the blob.
+   */
+  folly::Future<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& hash,
+      uint64_t blobSize,
+      uint64_t offset,
+      uint64_t length,
+      uint64_t chunkSize,
+      ObjectFetchContext& context);
+
  private:
   BlobAccess(const BlobAccess&) = delete;
   BlobAccess& operator=(const BlobAccess&) = delete;
 
+  folly::Future<std::shared_ptr<const Blob>> getBlobChunk(
+      const ObjectId& hash,
+      uint64_t blobSize,
+      uint64_t index,
+      uint64_t chunkSize,
+      ObjectFetchContext& context);
+
+  using ChunkPromise = folly::SharedPromise<std::shared_ptr<const Blob>>;
+
   const std::shared_ptr<IObjectStore> objectStore_;
   const std::shared_ptr<BlobCache> blobCache_;
+
+  /// Chunks being fetched, keyed by their BlobCache ID. Shared with the
+  /// fetches' callbacks, which may outlive this BlobAccess.
+  const std::shared_ptr<folly::Synchronized<
+      std::unordered_map<ObjectId, std::shared_ptr<ChunkPromise>>>>
+      pendingChunks_;
 };
 
 } // namespace facebook::eden
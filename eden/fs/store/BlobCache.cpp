@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobCache.h"
+
+#include <folly/MapUtil.h>
+#include <folly/compression/Compression.h>
+#include <folly/logging/xlog.h>
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * Blobs smaller than this are not worth the per-entry overhead of the
+ * compressed tier.
+ */
+constexpr size_t kMinimumCompressibleSize = 256;
+
+/**
+ * folly::io::Codec instances are not thread-safe, so keep one per thread.
+ */
+folly::io::Codec& getThreadCodec() {
+  thread_local auto codec = folly::io::getCodec(
+      folly::io::CodecType::ZSTD, folly::io::COMPRESSION_LEVEL_FASTEST);
+  return *codec;
+}
+} // namespace
+
+BlobCache::BlobCache(
+    size_t maximumCacheSizeBytes,
+    size_t minimumEntryCount,
+    size_t numShards,
+    ObjectCacheEvictionPolicy policy,
+    size_t compressedCacheSizeBytes)
+    : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
+          maximumCacheSizeBytes,
+          minimumEntryCount,
+          numShards,
+          policy},
+      compressedCacheSizeBytes_{compressedCacheSizeBytes} {
+  if (compressedCacheSizeBytes_ > 0) {
+    enableEvictionNotifications();
+  }
+}
+
+BlobCache::GetResult BlobCache::get(const ObjectId& hash, Interest interest) {
+  auto result = getInterestHandle(hash, interest);
+  if (result.object || compressedCacheSizeBytes_ == 0) {
+    return result;
+  }
+
+  auto blob = getCompressed(hash);
+  if (!blob) {
+    return result;
+  }
+  auto interestHandle = insert(blob, interest);
+  return GetResult{std::move(blob), std::move(interestHandle)};
+}
+
+void BlobCache::clear() {
+  ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>::clear();
+  auto compressed = compressed_.wlock();
+  compressed->entries.clear();
+  compressed->evictionQueue.clear();
+  compressed->totalSize = 0;
+  compressed->uncompressedSize = 0;
+}
+
+BlobCache::CompressedTierStats BlobCache::getCompressedTierStats() const {
+  auto compressed = compressed_.rlock();
+  CompressedTierStats stats;
+  stats.objectCount = compressed->entries.size();
+  stats.totalSizeInBytes = compressed->totalSize;
+  stats.uncompressedSizeInBytes = compressed->uncompressedSize;
+  stats.hitCount = compressed->hitCount;
+  stats.missCount = compressed->missCount;
+  stats.evictionCount = compressed->evictionCount;
+  stats.incompressibleCount = compressed->incompressibleCount;
+  return stats;
+}
+
+void BlobCache::onObjectsEvicted(std::vector<ObjectPtr> objects) noexcept {
+  for (auto& blob : objects) {
+    try {
+      insertCompressed(*blob);
+    } catch (const std::exception& ex) {
+      XLOG(DBG3) << "unable to compress evicted blob " << blob->getHash()
+                 << ": " << ex.what();
+    }
+  }
+}
+
+BlobCache::ObjectPtr BlobCache::getCompressed(const ObjectId& hash) {
+  std::unique_ptr<folly::IOBuf> contents;
+  size_t uncompressedSize;
+  {
+    auto compressed = compressed_.wlock();
+    auto* entry = folly::get_ptr(compressed->entries, hash);
+    if (!entry) {
+      ++compressed->missCount;
+      return nullptr;
+    }
+    ++compressed->hitCount;
+    compressed->evictionQueue.splice(
+        compressed->evictionQueue.end(),
+        compressed->evictionQueue,
+        entry->index);
+    // Inflate outside the lock. The compressed copy stays in this tier so
+    // that, if the blob is evicted from the first tier again, it does not
+    // need to be recompressed.
+    contents = entry->contents->clone();
+    uncompressedSize = entry->uncompressedSize;
+  }
+
+  auto uncompressed =
+      getThreadCodec().uncompress(contents.get(), uncompressedSize);
+  return std::make_shared<const Blob>(hash, std::move(*uncompressed));
+}
+
+void BlobCache::insertCompressed(const Blob& blob) {
+  auto size = blob.getSizeBytes();
+  if (size < kMinimumCompressibleSize || size > compressedCacheSizeBytes_) {
+    return;
+  }
+
+  {
+    // The blob may have been inflated from this tier in the first place.
+    auto compressed = compressed_.wlock();
+    if (auto* entry = folly::get_ptr(compressed->entries, blob.getHash())) {
+      compressed->evictionQueue.splice(
+          compressed->evictionQueue.end(),
+          compressed->evictionQueue,
+          entry->index);
+      return;
+    }
+  }
+
+  auto contents = getThreadCodec().compress(&blob.getContents());
+  auto compressedSize = contents->computeChainDataLength();
+
+  auto compressed = compressed_.wlock();
+  if (compressedSize >= size) {
+    ++compressed->incompressibleCount;
+    return;
+  }
+
+  auto [iter, inserted] = compressed->entries.try_emplace(
+      blob.getHash(),
+      CompressedEntry{std::move(contents), compressedSize, size, {}});
+  if (!inserted) {
+    // Another thread compressed the same blob concurrently.
+    return;
+  }
+  try {
+    compressed->evictionQueue.push_back(blob.getHash());
+  } catch (const std::exception&) {
+    compressed->entries.erase(iter);
+    throw;
+  }
+  iter->second.index = std::prev(compressed->evictionQueue.end());
+  compressed->totalSize += compressedSize;
+  compressed->uncompressedSize += size;
+
+  while (compressed->totalSize > compressedCacheSizeBytes_) {
+    auto oldest = compressed->entries.find(compressed->evictionQueue.front());
+    compressed->evictionQueue.pop_front();
+    compressed->totalSize -= oldest->second.compressedSize;
+    compressed->uncompressedSize -= oldest->second.uncompressedSize;
+    compressed->entries.erase(oldest);
+    ++compressed->evictionCount;
+  }
+}
+
+} // namespace facebook::eden
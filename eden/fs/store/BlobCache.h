@@ -6,6 +6,13 @@
  */
 
 #pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+#include <folly/io/IOBuf.h>
+
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ObjectCache.h"
 
@@ -23,19 +30,51 @@ using BlobInterestHandle = ObjectInterestHandle<Blob>;
  * frequently-accessed large blobs when they are larger than the maximum cache
  * size.
  *
+ * When numShards is greater than one, the cache is split into independently
+ * locked shards to reduce contention. A scan-resistant TinyLFU eviction
+ * policy can be selected in place of plain LRU. See ObjectCache for details.
+ *
+ * If compressedCacheSizeBytes is non-zero, blobs evicted from the in-memory
+ * cache are zstd-compressed into a second, separately budgeted LRU tier. A
+ * miss in the first tier that hits the compressed tier is inflated and
+ * reinserted into the first tier instead of being refetched from the
+ * LocalStore or BackingStore.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
  public:
+  struct CompressedTierStats {
+    size_t objectCount{0};
+    /// Sum of the compressed sizes of all entries.
+    size_t totalSizeInBytes{0};
+    /// Sum of the uncompressed sizes of all entries.
+    size_t uncompressedSizeInBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+    /// Evicted blobs not kept because compression did not shrink them.
+    uint64_t incompressibleCount{0};
+  };
+
   static std::shared_ptr<BlobCache> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount) {
+      size_t minimumEntryCount,
+      size_t numShards = 1,
+      ObjectCacheEvictionPolicy policy = ObjectCacheEvictionPolicy::LRU,
+      size_t compressedCacheSizeBytes = 0) {
     struct BC : BlobCache {
-      BC(size_t x, size_t y) : BlobCache{x, y} {}
+      BC(size_t x, size_t y, size_t z, ObjectCacheEvictionPolicy p, size_t c)
+          : BlobCache{x, y, z, p, c} {}
     };
-    return std::make_shared<BC>(maximumCacheSizeBytes, minimumEntryCount);
+    return std::make_shared<BC>(
+        maximumCacheSizeBytes,
+        minimumEntryCount,
+        numShards,
+        policy,
+        compressedCacheSizeBytes);
   }
-  ~BlobCache() = default;
+  ~BlobCache() override = default;
 
   /**
    * If a blob for the given hash is in cache, return it. If the blob is not in
@@ -51,9 +90,7 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
    */
   GetResult get(
       const ObjectId& hash,
-      Interest interest = Interest::LikelyNeededAgain) {
-    return getInterestHandle(hash, interest);
-  }
+      Interest interest = Interest::LikelyNeededAgain);
 
   /**
    * Inserts a blob into the cache for future lookup. If the new total size
@@ -69,11 +106,60 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
     return insertInterestHandle(blob, interest);
   }
 
+  /**
+   * Evicts everything from both tiers.
+   */
+  void clear();
+
+  /**
+   * Return the size and hit counts of the compressed tier. The first tier is
+   * reported by getStats().
+   */
+  CompressedTierStats getCompressedTierStats() const;
+
  private:
-  explicit BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount)
-      : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
-            maximumCacheSizeBytes,
-            minimumEntryCount} {}
+  explicit BlobCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t numShards,
+      ObjectCacheEvictionPolicy policy,
+      size_t compressedCacheSizeBytes);
+
+  void onObjectsEvicted(std::vector<ObjectPtr> objects) noexcept override;
+
+  /**
+   * Look up and inflate a blob from the compressed tier. Returns nullptr if
+   * the blob is not there.
+   */
+  ObjectPtr getCompressed(const ObjectId& hash);
+
+  /**
+   * Compress a blob evicted from the first tier and store it in the
+   * compressed tier, evicting older compressed entries as necessary.
+   */
+  void insertCompressed(const Blob& blob);
+
+  struct CompressedEntry {
+    std::unique_ptr<folly::IOBuf> contents;
+    size_t compressedSize;
+    size_t uncompressedSize;
+    std::list<ObjectId>::iterator index;
+  };
+
+  struct CompressedState {
+    std::unordered_map<ObjectId, CompressedEntry> entries;
+    /// Entries are evicted from the front of the queue.
+    std::list<ObjectId> evictionQueue;
+    size_t totalSize{0};
+    size_t uncompressedSize{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+    uint64_t incompressibleCount{0};
+  };
+
+  const size_t compressedCacheSizeBytes_;
+  folly::Synchronized<CompressedState> compressed_;
 };
 
 } // namespace facebook::eden
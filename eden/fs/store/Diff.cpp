@@ -401,12 +401,14 @@ void processRemovedSide(
     ChildFutures& childFutures,
     RelativePathPiece currentPath,
     const TreeEntry& scmEntry) {
-  context->callback->removedPath(
-      currentPath + scmEntry.getName(), scmEntry.getDType());
+  auto entryPath = currentPath + scmEntry.getName();
+  if (!context->shouldDiffPath(entryPath)) {
+    return;
+  }
+  context->callback->removedPath(entryPath, scmEntry.getDType());
   if (!scmEntry.isTree()) {
     return;
   }
-  auto entryPath = currentPath + scmEntry.getName();
   auto childFuture = diffRemovedTree(context, entryPath, scmEntry.getHash());
   childFutures.add(std::move(entryPath), std::move(childFuture));
 }
@@ -427,6 +429,9 @@ void processAddedSide(
     bool isIgnored) {
   bool entryIgnored = isIgnored;
   auto entryPath = currentPath + wdEntry.getName();
+  if (!context->shouldDiffPath(entryPath)) {
+    return;
+  }
   if (!isIgnored && ignore) {
     auto fileType =
         wdEntry.isTree() ? GitIgnore::TYPE_DIR : GitIgnore::TYPE_FILE;
@@ -470,6 +475,9 @@ void processBothPresent(
     bool isIgnored) {
   bool entryIgnored = isIgnored;
   auto entryPath = currentPath + scmEntry.getName();
+  if (!context->shouldDiffPath(entryPath)) {
+    return;
+  }
   // If wdEntry and scmEntry are both files (or symlinks) then we don't need
   // to bother computing the ignore status: the file is explicitly tracked in
   // source control, so we should report it's status even if it would normally
@@ -634,10 +642,8 @@ FOLLY_NODISCARD Future<Unit> diffTrees(
     ObjectId wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
-  auto scmTreeFuture =
-      context->store->getTree(scmHash, context->getFetchContext());
-  auto wdTreeFuture =
-      context->store->getTree(wdHash, context->getFetchContext());
+  auto scmTreeFuture = context->getTree(scmHash);
+  auto wdTreeFuture = context->getTree(wdHash);
   // Optimization for the case when both tree objects are immediately ready.
   // We can avoid copying the input path in this case.
   if (scmTreeFuture.isReady() && wdTreeFuture.isReady()) {
@@ -670,9 +676,8 @@ FOLLY_NODISCARD Future<Unit> diffAddedTree(
     ObjectId wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
-  auto wdFuture = context->store->getTree(wdHash, context->getFetchContext())
-                      .semi()
-                      .via(&folly::QueuedImmediateExecutor::instance());
+  auto wdFuture = context->getTree(wdHash).semi().via(
+      &folly::QueuedImmediateExecutor::instance());
   // Optimization for the case when the tree object is immediately ready.
   // We can avoid copying the input path in this case.
   if (wdFuture.isReady()) {
@@ -691,9 +696,8 @@ FOLLY_NODISCARD Future<Unit> diffRemovedTree(
     DiffContext* context,
     RelativePathPiece currentPath,
     ObjectId scmHash) {
-  auto scmFuture = context->store->getTree(scmHash, context->getFetchContext())
-                       .semi()
-                       .via(&folly::QueuedImmediateExecutor::instance());
+  auto scmFuture = context->getTree(scmHash).semi().via(
+      &folly::QueuedImmediateExecutor::instance());
   // Optimization for the case when the tree object is immediately ready.
   // We can avoid copying the input path in this case.
   if (scmFuture.isReady()) {
@@ -7,12 +7,92 @@
 
 #include "eden/fs/store/DiffContext.h"
 
+#include <folly/String.h>
+
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/store/DiffCallback.h"
 #include "eden/fs/store/IObjectStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/ConcurrencyLimiter.h"
 
 namespace facebook::eden {
 
+namespace {
+
+/**
+ * Forwards the results of a diff that are under its path prefixes.
+ */
+class PathPrefixDiffCallback : public DiffCallback {
+ public:
+  PathPrefixDiffCallback(const DiffContext& context, DiffCallback* target)
+      : context_{context}, target_{target} {}
+
+  void ignoredPath(RelativePathPiece path, dtype_t type) override {
+    if (context_.isPathIncluded(path)) {
+      target_->ignoredPath(path, type);
+    }
+  }
+
+  void addedPath(RelativePathPiece path, dtype_t type) override {
+    if (context_.isPathIncluded(path)) {
+      target_->addedPath(path, type);
+    }
+  }
+
+  void removedPath(RelativePathPiece path, dtype_t type) override {
+    if (context_.isPathIncluded(path)) {
+      target_->removedPath(path, type);
+    }
+  }
+
+  void modifiedPath(RelativePathPiece path, dtype_t type) override {
+    if (context_.isPathIncluded(path)) {
+      target_->modifiedPath(path, type);
+    }
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    // An error in a directory leading to a path prefix means the results
+    // under it may be missing.
+    if (context_.shouldDiffPath(path)) {
+      target_->diffError(path, ew);
+    }
+  }
+
+ private:
+  const DiffContext& context_;
+  DiffCallback* const target_;
+};
+
+/**
+ * Whether `path` is `dir` or under it.
+ */
+bool isPathUnder(
+    RelativePathPiece path,
+    RelativePathPiece dir,
+    CaseSensitivity caseSensitive) {
+  auto pathStr = path.stringPiece();
+  auto dirStr = dir.stringPiece();
+  if (dirStr.empty()) {
+    return true;
+  }
+  if (pathStr.size() < dirStr.size()) {
+    return false;
+  }
+  auto head = pathStr.subpiece(0, dirStr.size());
+  bool matches = caseSensitive == CaseSensitivity::Sensitive
+      ? head == dirStr
+      : head.equals(dirStr, folly::AsciiCaseInsensitive());
+  return matches &&
+      (pathStr.size() == dirStr.size() ||
+       detail::isDirSeparator(pathStr[dirStr.size()]));
+}
+
+} // namespace
+
 DiffContext::DiffContext(
     DiffCallback* cb,
     folly::CancellationToken cancellation,
@@ -20,14 +100,28 @@ DiffContext::DiffContext(
     CaseSensitivity caseSensitive,
     const ObjectStore* os,
     std::unique_ptr<TopLevelIgnores> topLevelIgnores,
-    LoadFileFunction loadFileContentsFromPath)
-    : callback{cb},
+    LoadFileFunction loadFileContentsFromPath,
+    size_t maxConcurrentTreeFetches,
+    folly::Executor* hashExecutor,
+    std::vector<RelativePath> pathPrefixes)
+    : pathPrefixCallback_{
+          pathPrefixes.empty()
+              ? nullptr
+              : std::make_unique<PathPrefixDiffCallback>(*this, cb)},
+      callback{pathPrefixCallback_ ? pathPrefixCallback_.get() : cb},
       store{os},
       listIgnored{listIgnored},
       topLevelIgnores_(std::move(topLevelIgnores)),
       loadFileContentsFromPath_{loadFileContentsFromPath},
       cancellation_{std::move(cancellation)},
-      caseSensitive_{caseSensitive} {}
+      caseSensitive_{caseSensitive},
+      hashExecutor_{hashExecutor},
+      pathPrefixes_{std::move(pathPrefixes)} {
+  if (maxConcurrentTreeFetches > 0) {
+    treeFetchLimiter_ =
+        std::make_unique<ConcurrencyLimiter>(maxConcurrentTreeFetches);
+  }
+}
 
 DiffContext::~DiffContext() = default;
 
@@ -39,6 +133,39 @@ DiffContext::LoadFileFunction DiffContext::getLoadFileContentsFromPath() const {
   return loadFileContentsFromPath_;
 }
 
+ImmediateFuture<std::shared_ptr<const Tree>> DiffContext::getTree(
+    const ObjectId& id) {
+  if (!treeFetchLimiter_) {
+    return store->getTree(id, fetchContext_);
+  }
+  return treeFetchLimiter_->run(
+      [this, id] { return store->getTree(id, fetchContext_); });
+}
+
+bool DiffContext::isPathIncluded(RelativePathPiece path) const {
+  if (pathPrefixes_.empty()) {
+    return true;
+  }
+  for (const auto& prefix : pathPrefixes_) {
+    if (isPathUnder(path, prefix, caseSensitive_)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DiffContext::shouldDiffPath(RelativePathPiece path) const {
+  if (isPathIncluded(path)) {
+    return true;
+  }
+  for (const auto& prefix : pathPrefixes_) {
+    if (isPathUnder(prefix, path, caseSensitive_)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool DiffContext::isCancelled() const {
   return cancellation_.isCancellationRequested();
 }
@@ -10,8 +10,10 @@
 #include <folly/CancellationToken.h>
 #include <folly/Range.h>
 #include <folly/futures/Future.h>
+#include <vector>
 
 #include "eden/fs/store/StatsFetchContext.h"
+#include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
@@ -21,10 +23,13 @@ class Future;
 
 namespace facebook::eden {
 
+class ConcurrencyLimiter;
 class DiffCallback;
 class GitIgnoreStack;
 class ObjectFetchContext;
+class ObjectId;
 class ObjectStore;
+class Tree;
 class UserInfo;
 class TopLevelIgnores;
 class EdenMount;
@@ -50,7 +55,10 @@ class DiffContext {
       CaseSensitivity caseSensitive,
       const ObjectStore* os,
       std::unique_ptr<TopLevelIgnores> topLevelIgnores,
-      LoadFileFunction loadFileContentsFromPath);
+      LoadFileFunction loadFileContentsFromPath,
+      size_t maxConcurrentTreeFetches = 0,
+      folly::Executor* hashExecutor = nullptr,
+      std::vector<RelativePath> pathPrefixes = {});
 
   DiffContext(const DiffContext&) = delete;
   DiffContext& operator=(const DiffContext&) = delete;
@@ -58,6 +66,17 @@ class DiffContext {
   DiffContext& operator=(DiffContext&&) = delete;
   ~DiffContext();
 
+ private:
+  /**
+   * Wraps the callback when the diff is limited to path prefixes. Declared
+   * ahead of callback, which points to it in that case.
+   */
+  std::unique_ptr<DiffCallback> pathPrefixCallback_;
+
+ public:
+  /**
+   * Only receives the results under the path prefixes, if any were given.
+   */
   DiffCallback* const callback;
   const ObjectStore* const store;
   /**
@@ -75,6 +94,39 @@ class DiffContext {
     return fetchContext_;
   }
 
+  /**
+   * Fetch a tree from the ObjectStore on behalf of this diff.
+   *
+   * When maxConcurrentTreeFetches is non-zero, at most that many of these
+   * fetches are outstanding at once and the rest are started, in the order
+   * they were requested, as earlier ones complete. The diff requests all the
+   * differing subdirectories of a tree before it waits on any of them, so each
+   * level reaches the BackingStore as one batch.
+   */
+  ImmediateFuture<std::shared_ptr<const Tree>> getTree(const ObjectId& id);
+
+  /**
+   * Executor on which the diff hashes the contents of materialized files, so
+   * that the files of a directory are hashed in parallel. Null to hash them
+   * on the thread running the diff.
+   */
+  folly::Executor* getHashExecutor() const {
+    return hashExecutor_;
+  }
+
+  /**
+   * Whether `path` is one of the path prefixes or under one of them. All paths
+   * are included when there are no path prefixes.
+   */
+  bool isPathIncluded(RelativePathPiece path) const;
+
+  /**
+   * Whether the diff needs to look at `path`: it is included, or it is a
+   * directory leading to a path prefix. The diff skips everything else
+   * without loading it.
+   */
+  bool shouldDiffPath(RelativePathPiece path) const;
+
   /** Whether this repository is mounted in case-sensitive mode */
   CaseSensitivity getCaseSensitive() const {
     return caseSensitive_;
@@ -89,6 +141,12 @@ class DiffContext {
    * Controls the case sensitivity of the diff operation.
    */
   CaseSensitivity caseSensitive_;
+  /**
+   * Null when tree fetches are not limited.
+   */
+  std::unique_ptr<ConcurrencyLimiter> treeFetchLimiter_;
+  folly::Executor* const hashExecutor_;
+  const std::vector<RelativePath> pathPrefixes_;
 };
 
 } // namespace facebook::eden
@@ -19,6 +19,7 @@
 namespace folly {
 template <typename T>
 class Future;
+class IOBuf;
 struct Unit;
 } // namespace folly
 
@@ -54,6 +55,18 @@ class IObjectStore {
       const ObjectId& id,
       ObjectFetchContext& context) const = 0;
 
+  /**
+   * Fetch up to `length` bytes of a blob's contents, starting at `offset`.
+   *
+   * This only avoids fetching the whole blob if supportsBlobRanges() is true.
+   */
+  virtual folly::Future<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) const = 0;
+  virtual bool supportsBlobRanges() const = 0;
+
   /**
    * Prefetch all the blobs represented by the HashRange.
    *
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/KeyAccessTracker.h"
+
+#include <folly/hash/SpookyHashV2.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+uint64_t hashKey(folly::ByteRange key) {
+  return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+}
+} // namespace
+
+KeyAccessTracker::KeyAccessTracker(
+    size_t numBuckets,
+    std::chrono::nanoseconds bucketDuration,
+    size_t maxKeysPerBucket)
+    : numBuckets_{std::max<size_t>(numBuckets, 1)},
+      bucketDuration_{std::max<std::chrono::nanoseconds>(
+          bucketDuration, std::chrono::nanoseconds{1})},
+      maxKeysPerShardBucket_{
+          (maxKeysPerBucket + kNumShards - 1) / kNumShards} {}
+
+int64_t KeyAccessTracker::epochOf(Clock::time_point now) const {
+  return now.time_since_epoch() / bucketDuration_;
+}
+
+void KeyAccessTracker::recordAccess(
+    folly::ByteRange key,
+    Clock::time_point now) {
+  auto hash = hashKey(key);
+  auto epoch = epochOf(now);
+  // The F14 set also hashes the value, so pick the shard with the high bits.
+  auto buckets = shards_[(hash >> 32) % kNumShards].buckets.lock();
+
+  if (buckets->empty() || buckets->back().epoch < epoch) {
+    buckets->push_back(Bucket{epoch, {}});
+    auto oldest = epoch - static_cast<int64_t>(numBuckets_);
+    while (buckets->front().epoch <= oldest) {
+      buckets->pop_front();
+    }
+  }
+
+  auto& current = buckets->back();
+  if (current.keys.size() < maxKeysPerShardBucket_) {
+    current.keys.insert(hash);
+  }
+}
+
+size_t KeyAccessTracker::getAge(folly::ByteRange key, Clock::time_point now)
+    const {
+  auto hash = hashKey(key);
+  auto epoch = epochOf(now);
+  auto buckets = shards_[(hash >> 32) % kNumShards].buckets.lock();
+
+  for (auto it = buckets->rbegin(); it != buckets->rend(); ++it) {
+    auto age = epoch - it->epoch;
+    if (age >= static_cast<int64_t>(numBuckets_)) {
+      break;
+    }
+    if (it->keys.count(hash)) {
+      return static_cast<size_t>(std::max<int64_t>(age, 0));
+    }
+  }
+  return numBuckets_;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Set.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace facebook::eden {
+
+/**
+ * Remembers, coarsely, when keys were last accessed.
+ *
+ * Time is divided into buckets of a fixed duration, and the tracker keeps
+ * the set of keys (as 64-bit hashes) accessed during each of the last
+ * `numBuckets` buckets. This is enough to order keys for least recently used
+ * eviction without storing a timestamp per key; keys whose hashes collide
+ * merely look as recent as each other.
+ *
+ * Memory use is bounded by `maxKeysPerBucket`: once a bucket is full, further
+ * keys accessed during it are not recorded and will look older than they
+ * are.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class KeyAccessTracker {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  KeyAccessTracker(
+      size_t numBuckets,
+      std::chrono::nanoseconds bucketDuration,
+      size_t maxKeysPerBucket);
+
+  void recordAccess(folly::ByteRange key, Clock::time_point now = Clock::now());
+
+  /**
+   * How many buckets ago `key` was last accessed: 0 if during the current
+   * bucket, and getNumBuckets() if not within the tracked window.
+   */
+  size_t getAge(folly::ByteRange key, Clock::time_point now = Clock::now())
+      const;
+
+  size_t getNumBuckets() const {
+    return numBuckets_;
+  }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Bucket {
+    int64_t epoch;
+    folly::F14FastSet<uint64_t> keys;
+  };
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    /// Buckets in increasing epoch order. Epochs may be missing.
+    folly::Synchronized<std::deque<Bucket>, std::mutex> buckets;
+  };
+
+  int64_t epochOf(Clock::time_point now) const;
+
+  const size_t numBuckets_;
+  const std::chrono::nanoseconds bucketDuration_;
+  const size_t maxKeysPerShardBucket_;
+  std::array<Shard, kNumShards> shards_;
+};
+
+} // namespace facebook::eden
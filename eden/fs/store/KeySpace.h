@@ -33,6 +33,64 @@ struct Deprecated {};
 
 using Persistence = std::variant<Ephemeral, Persistent, Deprecated>;
 
+/**
+ * How the RocksDbLocalStore should tune the column family backing a key
+ * space. Other LocalStore implementations ignore this.
+ */
+struct KeySpaceTuning {
+  enum class BlockCache : uint8_t {
+    /// Share one block cache with every other key space that asks for it.
+    Shared,
+    /// Use a block cache of dedicatedBlockCacheSizeMB owned by this key space
+    /// alone, so that its reads cannot evict other key spaces' blocks.
+    Dedicated,
+  };
+
+  uint32_t blockSizeBytes;
+  /// Zero disables the bloom filter.
+  uint8_t bloomFilterBitsPerKey;
+  bool compression;
+  BlockCache blockCache;
+  uint32_t dedicatedBlockCacheSizeMB;
+  /// Values at least this large are stored in BlobDB blob files instead of
+  /// the SST files, so compactions do not rewrite them. Zero disables BlobDB.
+  uint32_t largeValueThresholdBytes;
+};
+
+/**
+ * Small values that are looked up on every miss. Small blocks keep each
+ * lookup's read cheap, and a generous bloom filter avoids going to disk for
+ * keys that are absent.
+ */
+constexpr KeySpaceTuning kSmallValueTuning{
+    4 * 1024,
+    16,
+    false,
+    KeySpaceTuning::BlockCache::Shared,
+    0,
+    0};
+
+/**
+ * Large values that are written once and rarely read again. They get a small
+ * cache of their own so that reading them does not evict metadata from the
+ * shared cache, and the largest ones are kept out of compactions.
+ */
+constexpr KeySpaceTuning kLargeValueTuning{
+    64 * 1024,
+    10,
+    true,
+    KeySpaceTuning::BlockCache::Dedicated,
+    8,
+    512 * 1024};
+
+constexpr KeySpaceTuning kDefaultTuning{
+    16 * 1024,
+    10,
+    true,
+    KeySpaceTuning::BlockCache::Shared,
+    0,
+    0};
+
 /**
  * Which key space (and thus column family for the RocksDbLocalStore) should be
  * used to store a specific key.  The `name` value must be stable across builds
@@ -43,6 +101,7 @@ struct KeySpaceRecord {
   uint8_t index;
   folly::StringPiece name;
   Persistence persistence;
+  KeySpaceTuning tuning = kDefaultTuning;
 
   constexpr bool isEphemeral() const noexcept {
     return std::holds_alternative<Ephemeral>(persistence);
@@ -69,11 +128,13 @@ class KeySpace {
   static constexpr KeySpaceRecord BlobFamily{
       0,
       "blob",
-      Ephemeral{&EdenConfig::localStoreBlobSizeLimit}};
+      Ephemeral{&EdenConfig::localStoreBlobSizeLimit},
+      kLargeValueTuning};
   static constexpr KeySpaceRecord BlobMetaDataFamily{
       1,
       "blobmeta",
-      Ephemeral{&EdenConfig::localStoreBlobMetaSizeLimit}};
+      Ephemeral{&EdenConfig::localStoreBlobMetaSizeLimit},
+      kSmallValueTuning};
   static constexpr KeySpaceRecord TreeFamily{
       2,
       "tree",
@@ -83,11 +144,13 @@ class KeySpace {
   static constexpr KeySpaceRecord HgProxyHashFamily{
       3,
       "hgproxyhash",
-      Persistent{}};
+      Persistent{},
+      kSmallValueTuning};
   static constexpr KeySpaceRecord HgCommitToTreeFamily{
       4,
       "hgcommit2tree",
-      Ephemeral{&EdenConfig::localStoreHgCommit2TreeSizeLimit}};
+      Ephemeral{&EdenConfig::localStoreHgCommit2TreeSizeLimit},
+      kSmallValueTuning};
   static constexpr KeySpaceRecord BlobSizeFamily{5, "blobsize", Deprecated{}};
 
   static constexpr KeySpaceRecord ScsProxyHashFamily{
@@ -102,6 +165,25 @@ class KeySpace {
       8,
       "recasdigestproxyhash",
       Deprecated{}};
+  // Memoized statuses between pairs of roots, keyed by the pair of RootIds.
+  static constexpr KeySpaceRecord ScmStatusFamily{
+      9,
+      "scmstatus",
+      Ephemeral{&EdenConfig::localStoreScmStatusSizeLimit}};
+  // The paths of the entries of a root, indexed by name, keyed by RootId.
+  static constexpr KeySpaceRecord NameIndexFamily{
+      10,
+      "nameindex",
+      Ephemeral{&EdenConfig::localStoreNameIndexSizeLimit},
+      kLargeValueTuning};
+  // Blobs and trees moved out of their own key spaces by
+  // RocksDbLocalStore::repackForLocality(), stored in the order of a walk of
+  // the trees, together with the index to find them by ID.
+  static constexpr KeySpaceRecord LocalityFamily{
+      11,
+      "locality",
+      Ephemeral{&EdenConfig::localStoreLocalitySizeLimit},
+      kLargeValueTuning};
 
   static constexpr const KeySpaceRecord* kAll[] = {
       &BlobFamily,
@@ -112,7 +194,10 @@ class KeySpace {
       &BlobSizeFamily,
       &ScsProxyHashFamily,
       &TreeMetaDataFamily,
-      &ReCasDigestProxyHashFamily};
+      &ReCasDigestProxyHashFamily,
+      &ScmStatusFamily,
+      &NameIndexFamily,
+      &LocalityFamily};
   static constexpr size_t kTotalCount = std::size(kAll);
 
  private:
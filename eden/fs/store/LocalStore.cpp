@@ -16,6 +16,7 @@
 #include <array>
 
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/SerializedTreeView.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GitBlob.h"
 #include "eden/fs/model/git/GitTree.h"
@@ -90,6 +91,19 @@ folly::Future<std::vector<StoreResult>> LocalStore::getBatch(
   });
 }
 
+folly::Future<std::vector<bool>> LocalStore::hasKeyBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  return folly::makeFutureWith([keySpace, keys, this] {
+    std::vector<bool> results;
+    results.reserve(keys.size());
+    for (auto& key : keys) {
+      results.push_back(hasKey(keySpace, key));
+    }
+    return results;
+  });
+}
+
 folly::Future<std::unique_ptr<Tree>> LocalStore::getTree(
     const ObjectId& id) const {
   return getFuture(KeySpace::TreeFamily, id.getBytes())
@@ -105,6 +119,17 @@ folly::Future<std::unique_ptr<Tree>> LocalStore::getTree(
       });
 }
 
+folly::Future<std::unique_ptr<SerializedTreeView>> LocalStore::getTreeView(
+    const ObjectId& id) const {
+  return getFuture(KeySpace::TreeFamily, id.getBytes())
+      .thenValue([id](StoreResult&& data) {
+        if (!data.isValid()) {
+          return std::unique_ptr<SerializedTreeView>(nullptr);
+        }
+        return SerializedTreeView::tryCreate(id, data.extractIOBuf());
+      });
+}
+
 folly::Future<std::unique_ptr<Blob>> LocalStore::getBlob(
     const ObjectId& id) const {
   if (!enableBlobCaching) {
@@ -133,6 +158,31 @@ folly::Future<optional<BlobMetadata>> LocalStore::getBlobMetadata(
       });
 }
 
+folly::Future<std::vector<optional<BlobMetadata>>>
+LocalStore::getBlobMetadataBatch(const std::vector<ObjectId>& ids) const {
+  // The keys must remain valid until getBatch() completes.
+  auto ownedIds = std::make_shared<const std::vector<ObjectId>>(ids);
+  std::vector<ByteRange> keys;
+  keys.reserve(ownedIds->size());
+  for (const auto& id : *ownedIds) {
+    keys.push_back(id.getBytes());
+  }
+  return getBatch(KeySpace::BlobMetaDataFamily, keys)
+      .thenValue([ownedIds](std::vector<StoreResult>&& results) {
+        std::vector<optional<BlobMetadata>> metadata;
+        metadata.reserve(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+          if (results[i].isValid()) {
+            metadata.push_back(
+                SerializedBlobMetadata::parse((*ownedIds)[i], results[i]));
+          } else {
+            metadata.push_back(std::nullopt);
+          }
+        }
+        return metadata;
+      });
+}
+
 folly::IOBuf LocalStore::serializeTree(const Tree& tree) {
   return tree.serialize();
 }
@@ -181,6 +231,34 @@ BlobMetadata LocalStore::putBlobMetadata(const ObjectId& id, const Blob* blob) {
   return metadata;
 }
 
+void LocalStore::putBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata) {
+  SerializedBlobMetadata metadataBytes(metadata);
+  put(KeySpace::BlobMetaDataFamily, id.getBytes(), metadataBytes.slice());
+}
+
+void LocalStore::putTreeMetadata(const TreeMetadata& metadata) {
+  const auto* entries =
+      std::get_if<TreeMetadata::HashIndexedEntryMetadata>(&metadata.entries());
+  if (!entries) {
+    throw std::domain_error(
+        "Identifiers for entries are not hashes, can not store metadata.");
+  }
+  if (entries->empty()) {
+    return;
+  }
+
+  auto batch = beginWrite(
+      entries->size() * (Hash20::RAW_SIZE + SerializedBlobMetadata::SIZE));
+  for (const auto& [id, blobMetadata] : *entries) {
+    SerializedBlobMetadata metadataBytes(blobMetadata);
+    batch->put(
+        KeySpace::BlobMetaDataFamily, id.getBytes(), metadataBytes.slice());
+  }
+  batch->flush();
+}
+
 void LocalStore::put(
     KeySpace keySpace,
     const ObjectId& id,
@@ -230,4 +308,10 @@ void LocalStore::periodicManagementTask(const EdenConfig& /* config */) {
   // periodic management.
 }
 
+folly::SemiFuture<folly::Unit> LocalStore::garbageCollect(
+    const EdenConfig& /* config */,
+    const folly::CancellationToken& /* cancel */) {
+  return folly::unit;
+}
+
 } // namespace facebook::eden
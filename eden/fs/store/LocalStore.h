@@ -17,14 +17,19 @@
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
+class CancellationToken;
 template <typename T>
 class Future;
+template <typename T>
+class SemiFuture;
+struct Unit;
 } // namespace folly
 
 namespace facebook::eden {
 
 class Blob;
 class EdenConfig;
+class SerializedTreeView;
 class StoreResult;
 class Tree;
 class TreeMetadata;
@@ -116,6 +121,17 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   folly::Future<std::unique_ptr<Tree>> getTree(const ObjectId& id) const;
 
+  /**
+   * Get a read-only view of a Tree that decodes its entries directly from the
+   * stored bytes, without building a Tree.
+   *
+   * Returns nullptr if this key is not present in the store, or if the tree
+   * was stored in a format SerializedTreeView does not understand, in which
+   * case getTree() should be used instead.
+   */
+  folly::Future<std::unique_ptr<SerializedTreeView>> getTreeView(
+      const ObjectId& id) const;
+
   /**
    * Get a Blob from the store.
    *
@@ -136,12 +152,25 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
   folly::Future<std::optional<BlobMetadata>> getBlobMetadata(
       const ObjectId& id) const;
 
+  /**
+   * Like getBlobMetadata(), for many blobs with a single getBatch() lookup.
+   */
+  folly::Future<std::vector<std::optional<BlobMetadata>>>
+  getBlobMetadataBatch(const std::vector<ObjectId>& ids) const;
+
   /**
    * Test whether the key is stored.
    */
   virtual bool hasKey(KeySpace keySpace, folly::ByteRange key) const = 0;
   bool hasKey(KeySpace keySpace, const ObjectId& id) const;
 
+  /**
+   * Test whether each of the keys is stored, in the order of the keys.
+   */
+  FOLLY_NODISCARD virtual folly::Future<std::vector<bool>> hasKeyBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const;
+
   /**
    * Store a Tree into the TreeFamily KeySpace.
    */
@@ -156,6 +185,13 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    * Store a blob metadata.
    */
   BlobMetadata putBlobMetadata(const ObjectId& id, const Blob* blob);
+  void putBlobMetadata(const ObjectId& id, const BlobMetadata& metadata);
+
+  /**
+   * Store the metadata of all the blob entries of a tree with a single write
+   * batch. `metadata` must be indexed by hash.
+   */
+  void putTreeMetadata(const TreeMetadata& metadata);
 
   /**
    * Put arbitrary data in the store.
@@ -237,6 +273,25 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
 
   virtual void periodicManagementTask(const EdenConfig& config);
 
+  /**
+   * Free the ephemeral data that exceeds its configured limits. This is
+   * expensive, so EdenServer runs it when the host is idle.
+   *
+   * The returned future completes once collection is done, or once it stopped
+   * early because cancellation of `cancel` was requested.
+   */
+  virtual folly::SemiFuture<folly::Unit> garbageCollect(
+      const EdenConfig& config,
+      const folly::CancellationToken& cancel);
+
+  /**
+   * Estimated bytes of memory held by the store, such as caches and data not
+   * yet written to disk. Stores that keep nothing in memory return 0.
+   */
+  virtual size_t estimateMemoryUsage() const {
+    return 0;
+  }
+
   /*
    * We keep this field to avoid making `LocalStore` holding a reference to
    * `EdenConfig`, which will require us to change all the subclasses. We update
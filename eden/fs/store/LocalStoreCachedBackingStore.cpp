@@ -83,6 +83,21 @@ LocalStoreCachedBackingStore::getLocalBlobMetadata(
   return backingStore_->getLocalBlobMetadata(id, context);
 }
 
+bool LocalStoreCachedBackingStore::supportsBlobRanges() {
+  return backingStore_->supportsBlobRanges();
+}
+
+folly::SemiFuture<std::unique_ptr<folly::IOBuf>>
+LocalStoreCachedBackingStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    ObjectFetchContext& context) {
+  // Whole blobs may already be in the LocalStore, but checking would mean
+  // reading the whole blob, which is what ranged fetches try to avoid.
+  return backingStore_->getBlobRange(id, offset, length, context);
+}
+
 folly::SemiFuture<BackingStore::GetBlobRes>
 LocalStoreCachedBackingStore::getBlob(
     const ObjectId& id,
@@ -52,6 +52,13 @@ class LocalStoreCachedBackingStore : public BackingStore {
       const ObjectId& id,
       ObjectFetchContext& context) override;
 
+  bool supportsBlobRanges() override;
+  folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) override;
+
   std::unique_ptr<BlobMetadata> getLocalBlobMetadata(
       const ObjectId& id,
       ObjectFetchContext& context) override;
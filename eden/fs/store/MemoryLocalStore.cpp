@@ -7,6 +7,9 @@
 
 #include "eden/fs/store/MemoryLocalStore.h"
 #include <folly/String.h>
+#include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
 #include "eden/fs/store/StoreResult.h"
 
 namespace facebook::eden {
@@ -51,40 +54,112 @@ class MemoryWriteBatch : public LocalStore::WriteBatch {
 };
 } // namespace
 
-MemoryLocalStore::MemoryLocalStore() {
-  storage_.wlock()->resize(KeySpace::kTotalCount);
-}
+MemoryLocalStore::MemoryLocalStore(size_t maxBytes)
+    : maxBytesPerShard_{
+          maxBytes == 0 ? 0 : std::max<size_t>(maxBytes / kNumShards, 1)} {}
 
 void MemoryLocalStore::close() {}
 
+folly::Synchronized<MemoryLocalStore::Shard, std::mutex>&
+MemoryLocalStore::getShard(KeySpace keySpace, folly::ByteRange key) const {
+  auto hash = folly::hash::hash_combine(keySpace->index, StringPiece(key));
+  return shards_[hash % kNumShards].shard;
+}
+
+bool MemoryLocalStore::isEvictable(KeySpace keySpace) const {
+  return maxBytesPerShard_ != 0 && keySpace->isEphemeral();
+}
+
+void MemoryLocalStore::evictLocked(Shard& shard) {
+  while (shard.evictableBytes > maxBytesPerShard_ && !shard.lru.empty()) {
+    auto node = shard.lru.front();
+    auto& keySpace = shard.keySpaces[node.keySpaceIndex];
+    auto it = keySpace.find(*node.key);
+    auto size = it->first.size() + it->second.value->size();
+    shard.bytes -= size;
+    shard.evictableBytes -= size;
+    shard.lru.pop_front();
+    keySpace.erase(it);
+  }
+}
+
+size_t MemoryLocalStore::estimateMemoryUsage() const {
+  size_t total = 0;
+  for (const auto& padded : shards_) {
+    auto shard = padded.shard.lock();
+    total += shard->bytes;
+    for (const auto& keySpace : shard->keySpaces) {
+      total += keySpace.size() * sizeof(*keySpace.begin());
+    }
+    total += shard->lru.size() * sizeof(LruNode);
+  }
+  return total;
+}
+
 void MemoryLocalStore::clearKeySpace(KeySpace keySpace) {
-  (*storage_.wlock())[keySpace->index].clear();
+  bool evictable = isEvictable(keySpace);
+  for (auto& padded : shards_) {
+    auto shard = padded.shard.lock();
+    auto& entries = shard->keySpaces[keySpace->index];
+    for (const auto& [key, entry] : entries) {
+      auto size = key.size() + entry.value->size();
+      shard->bytes -= size;
+      if (evictable) {
+        shard->evictableBytes -= size;
+        shard->lru.erase(entry.lruPosition);
+      }
+    }
+    entries.clear();
+  }
 }
 
 void MemoryLocalStore::compactKeySpace(KeySpace) {}
 
 StoreResult MemoryLocalStore::get(KeySpace keySpace, folly::ByteRange key)
     const {
-  auto store = storage_.rlock();
-  auto it = (*store)[keySpace->index].find(StringPiece(key));
-  if (it == (*store)[keySpace->index].end()) {
+  auto shard = getShard(keySpace, key).lock();
+  auto& entries = shard->keySpaces[keySpace->index];
+  auto it = entries.find(StringPiece(key));
+  if (it == entries.end()) {
     return StoreResult::missing(keySpace, key);
   }
-  return StoreResult(std::string(it->second));
+  if (isEvictable(keySpace)) {
+    shard->lru.splice(shard->lru.end(), shard->lru, it->second.lruPosition);
+  }
+  return StoreResult(it->second.value);
 }
 
 bool MemoryLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
-  auto store = storage_.rlock();
-  auto it = (*store)[keySpace->index].find(StringPiece(key));
-  return it != (*store)[keySpace->index].end();
+  auto shard = getShard(keySpace, key).lock();
+  return shard->keySpaces[keySpace->index].count(StringPiece(key)) != 0;
 }
 
 void MemoryLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
-  (*storage_.wlock())[keySpace->index][StringPiece(key)] =
-      StringPiece(value).str();
+  // Allocate the value before taking the lock.
+  auto shared = std::make_shared<const std::string>(StringPiece(value).str());
+
+  auto shard = getShard(keySpace, key).lock();
+  auto [it, inserted] =
+      shard->keySpaces[keySpace->index].try_emplace(StringPiece(key).str());
+  auto& entry = it->second;
+  size_t oldSize = inserted ? 0 : it->first.size() + entry.value->size();
+  entry.value = std::move(shared);
+  size_t newSize = it->first.size() + entry.value->size();
+  shard->bytes = shard->bytes - oldSize + newSize;
+
+  if (isEvictable(keySpace)) {
+    shard->evictableBytes = shard->evictableBytes - oldSize + newSize;
+    if (inserted) {
+      entry.lruPosition = shard->lru.insert(
+          shard->lru.end(), LruNode{keySpace->index, &it->first});
+    } else {
+      shard->lru.splice(shard->lru.end(), shard->lru, entry.lruPosition);
+    }
+    evictLocked(*shard);
+  }
 }
 
 std::unique_ptr<LocalStore::WriteBatch> MemoryLocalStore::beginWrite(size_t) {
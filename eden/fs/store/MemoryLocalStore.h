@@ -7,20 +7,34 @@
 
 #pragma once
 #include <folly/Synchronized.h>
-#include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
 #include "eden/fs/store/LocalStore.h"
 
 namespace facebook::eden {
 
 /** An implementation of LocalStore that stores values in memory.
- * Stored values remain in memory for the lifetime of the
+ *
+ * Keys are spread across shards by hash, each with its own lock, so that
+ * concurrent accesses rarely contend. Values are reference counted and
+ * returned without being copied.
+ *
+ * If `maxBytes` is non-zero, the least recently used values of ephemeral key
+ * spaces are evicted to keep their keys and values below roughly that many
+ * bytes. Values of persistent key spaces are never evicted and don't count
+ * against the budget; they remain in memory for the lifetime of the
  * MemoryLocalStore instance.
+ *
  * MemoryLocalStore is thread safe, allowing concurrent reads and
  * writes from any thread.
  * */
 class MemoryLocalStore : public LocalStore {
  public:
-  explicit MemoryLocalStore();
+  explicit MemoryLocalStore(size_t maxBytes = 0);
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
@@ -30,10 +44,47 @@ class MemoryLocalStore : public LocalStore {
       override;
   std::unique_ptr<LocalStore::WriteBatch> beginWrite(
       size_t bufSize = 0) override;
+  size_t estimateMemoryUsage() const override;
 
  private:
-  folly::Synchronized<std::vector<folly::StringKeyedUnorderedMap<std::string>>>
-      storage_;
+  static constexpr size_t kNumShards = 64;
+
+  struct LruNode {
+    size_t keySpaceIndex;
+    /// Points into the key space map, whose keys never move.
+    const std::string* key;
+  };
+
+  struct Entry {
+    std::shared_ptr<const std::string> value;
+    /// Only set for evictable entries.
+    std::list<LruNode>::iterator lruPosition;
+  };
+
+  struct Shard {
+    std::array<folly::F14NodeMap<std::string, Entry>, KeySpace::kTotalCount>
+        keySpaces;
+    /// Evictable entries, least recently used first.
+    std::list<LruNode> lru;
+    /// Size of the keys and values stored in this shard.
+    size_t bytes{0};
+    /// The part of `bytes` that is evictable and counts against the budget.
+    size_t evictableBytes{0};
+  };
+
+  struct alignas(folly::hardware_destructive_interference_size) PaddedShard {
+    folly::Synchronized<Shard, std::mutex> shard;
+  };
+
+  folly::Synchronized<Shard, std::mutex>& getShard(
+      KeySpace keySpace,
+      folly::ByteRange key) const;
+  bool isEvictable(KeySpace keySpace) const;
+  void evictLocked(Shard& shard);
+
+  /// 0 if unbounded.
+  const size_t maxBytesPerShard_;
+  mutable std::array<PaddedShard, kNumShards> shards_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/NameIndex.h"
+
+#include <folly/Varint.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <atomic>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * The first byte of a serialized index. Bump it when changing the format, so
+ * that indexes in the old format are rebuilt.
+ */
+constexpr char kVersion = '1';
+
+bool entryLess(const NameIndex::Entry& a, const NameIndex::Entry& b) {
+  auto aName = a.path.basename();
+  auto bName = b.path.basename();
+  return aName < bName || (aName == bName && a.path < b.path);
+}
+
+void appendBytes(std::string& out, folly::ByteRange bytes) {
+  uint8_t length[folly::kMaxVarintLength64];
+  out.append(
+      reinterpret_cast<const char*>(length),
+      folly::encodeVarint(bytes.size(), length));
+  out.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+std::optional<folly::ByteRange> readBytes(folly::ByteRange& data) {
+  auto length = folly::tryDecodeVarint(data);
+  if (length.hasError() || *length > data.size()) {
+    return std::nullopt;
+  }
+  auto bytes = data.subpiece(0, *length);
+  data.advance(*length);
+  return bytes;
+}
+
+struct IndexBuilder {
+  explicit IndexBuilder(std::shared_ptr<LocalStore> store)
+      : localStore{std::move(store)} {}
+
+  std::shared_ptr<LocalStore> localStore;
+  folly::Synchronized<std::vector<NameIndex::Entry>> entries;
+  std::atomic<bool> complete{true};
+};
+
+ImmediateFuture<folly::Unit> addTree(
+    std::shared_ptr<IndexBuilder> builder,
+    RelativePathPiece path,
+    const Tree& tree);
+
+ImmediateFuture<folly::Unit> addSubtree(
+    std::shared_ptr<IndexBuilder> builder,
+    RelativePath path,
+    const ObjectId& id) {
+  if (!builder->complete.load(std::memory_order_relaxed)) {
+    return folly::unit;
+  }
+  return ImmediateFuture<std::unique_ptr<Tree>>{
+      builder->localStore->getTree(id).semi()}
+      .thenValue([builder, path = std::move(path)](std::unique_ptr<Tree> tree)
+                     -> ImmediateFuture<folly::Unit> {
+        if (!tree) {
+          builder->complete.store(false, std::memory_order_relaxed);
+          return folly::unit;
+        }
+        return addTree(builder, path, *tree);
+      });
+}
+
+ImmediateFuture<folly::Unit> addTree(
+    std::shared_ptr<IndexBuilder> builder,
+    RelativePathPiece path,
+    const Tree& tree) {
+  std::vector<NameIndex::Entry> entries;
+  std::vector<ImmediateFuture<folly::Unit>> subtrees;
+  entries.reserve(tree.getTreeEntries().size());
+  for (const auto& entry : tree.getTreeEntries()) {
+    auto entryPath = path + entry.getName();
+    if (entry.isTree()) {
+      subtrees.push_back(addSubtree(builder, entryPath, entry.getHash()));
+    }
+    entries.emplace_back(std::move(entryPath), entry);
+  }
+  {
+    auto all = builder->entries.wlock();
+    all->insert(
+        all->end(),
+        std::make_move_iterator(entries.begin()),
+        std::make_move_iterator(entries.end()));
+  }
+  return collectAllSafe(std::move(subtrees))
+      .thenValue([](std::vector<folly::Unit>&&) { return folly::unit; });
+}
+
+} // namespace
+
+NameIndex::NameIndex(std::vector<Entry> entries)
+    : entries_{std::move(entries)} {
+  std::sort(entries_.begin(), entries_.end(), entryLess);
+}
+
+folly::Range<const NameIndex::Entry*> NameIndex::lookup(
+    PathComponentPiece name) const {
+  auto isBefore = [name](const Entry& entry) {
+    return entry.path.basename() < name;
+  };
+  auto isNamed = [name](const Entry& entry) {
+    return entry.path.basename() == name;
+  };
+  auto begin = std::partition_point(entries_.begin(), entries_.end(), isBefore);
+  auto end = std::partition_point(begin, entries_.end(), isNamed);
+  return {
+      entries_.data() + (begin - entries_.begin()),
+      static_cast<size_t>(end - begin)};
+}
+
+std::string NameIndex::serialize() const {
+  std::string out;
+  out.push_back(kVersion);
+  for (const auto& [path, entry] : entries_) {
+    appendBytes(out, folly::ByteRange{path.stringPiece()});
+    out.push_back(static_cast<char>(entry.getType()));
+    appendBytes(out, entry.getHash().getBytes());
+  }
+  return out;
+}
+
+std::optional<NameIndex> NameIndex::deserialize(folly::StringPiece data) {
+  if (data.empty() || data.front() != kVersion) {
+    return std::nullopt;
+  }
+  auto bytes = folly::ByteRange{data};
+  bytes.advance(1);
+
+  std::vector<Entry> entries;
+  try {
+    while (!bytes.empty()) {
+      auto path = readBytes(bytes);
+      if (!path || bytes.empty()) {
+        return std::nullopt;
+      }
+      auto type = static_cast<TreeEntryType>(bytes.front());
+      bytes.advance(1);
+      auto hash = readBytes(bytes);
+      if (!hash) {
+        return std::nullopt;
+      }
+      RelativePath entryPath{folly::StringPiece{*path}};
+      auto name = entryPath.basename().copy();
+      entries.emplace_back(
+          std::move(entryPath),
+          TreeEntry{ObjectId{*hash}, std::move(name), type});
+    }
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "corrupt name index: " << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+  return NameIndex{std::move(entries)};
+}
+
+ImmediateFuture<std::optional<NameIndex>> NameIndex::buildFromLocalStore(
+    std::shared_ptr<LocalStore> localStore,
+    const Tree& root) {
+  auto builder = std::make_shared<IndexBuilder>(std::move(localStore));
+  return addTree(builder, RelativePathPiece{}, root)
+      .thenValue([builder](folly::Unit) -> std::optional<NameIndex> {
+        if (!builder->complete.load(std::memory_order_relaxed)) {
+          return std::nullopt;
+        }
+        return NameIndex{std::move(*builder->entries.wlock())};
+      });
+}
+
+ImmediateFuture<std::shared_ptr<const NameIndex>> NameIndexCache::get(
+    const RootId& rootId,
+    const Tree& rootTree) {
+  {
+    auto cache = cache_.lock();
+    auto it = cache->find(rootId);
+    if (it != cache->end()) {
+      return it->second;
+    }
+  }
+
+  auto key = folly::StringPiece{rootId.value()};
+  auto stored =
+      localStore_->get(KeySpace::NameIndexFamily, folly::ByteRange{key});
+  if (stored.isValid()) {
+    if (auto index = NameIndex::deserialize(stored.asString())) {
+      auto result = std::make_shared<const NameIndex>(std::move(*index));
+      insert(rootId, result);
+      return result;
+    }
+    XLOG(WARN) << "rebuilding unreadable name index of " << rootId;
+  }
+
+  return NameIndex::buildFromLocalStore(localStore_, rootTree)
+      .thenValue([this, rootId](std::optional<NameIndex> index)
+                     -> std::shared_ptr<const NameIndex> {
+        if (!index) {
+          XLOG(DBG3) << "not all trees of " << rootId
+                     << " are available to index";
+          return nullptr;
+        }
+        XLOG(DBG2) << "indexed " << index->size() << " entries of " << rootId;
+        auto value = index->serialize();
+        auto key = folly::StringPiece{rootId.value()};
+        localStore_->put(
+            KeySpace::NameIndexFamily,
+            folly::ByteRange{key},
+            folly::ByteRange{folly::StringPiece{value}});
+        auto result = std::make_shared<const NameIndex>(std::move(*index));
+        insert(rootId, result);
+        return result;
+      });
+}
+
+void NameIndexCache::insert(
+    const RootId& rootId,
+    std::shared_ptr<const NameIndex> index) {
+  cache_.lock()->set(rootId, std::move(index));
+}
+
+} // namespace facebook::eden
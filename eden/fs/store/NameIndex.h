@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class LocalStore;
+class Tree;
+
+/**
+ * Every entry of a source control root, files and directories alike, indexed
+ * by name.
+ *
+ * This answers questions like "where are all the files named BUCK?" without
+ * walking the root's trees. The contents of a root never change, so neither
+ * does its index.
+ */
+class NameIndex {
+ public:
+  struct Entry {
+    Entry(RelativePath path, TreeEntry entry)
+        : path{std::move(path)}, entry{std::move(entry)} {}
+
+    RelativePath path;
+    TreeEntry entry;
+  };
+
+  explicit NameIndex(std::vector<Entry> entries);
+
+  /**
+   * Returns the entries named `name`, sorted by path.
+   */
+  folly::Range<const Entry*> lookup(PathComponentPiece name) const;
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  std::string serialize() const;
+
+  /**
+   * Returns std::nullopt if `data` was not produced by serialize().
+   */
+  static std::optional<NameIndex> deserialize(folly::StringPiece data);
+
+  /**
+   * Index the trees under `root` that are already in `localStore`, without
+   * fetching anything from the BackingStore. Returns std::nullopt if any of
+   * them is missing.
+   */
+  static ImmediateFuture<std::optional<NameIndex>> buildFromLocalStore(
+      std::shared_ptr<LocalStore> localStore,
+      const Tree& root);
+
+ private:
+  // Sorted by name, then by path.
+  std::vector<Entry> entries_;
+};
+
+/**
+ * The NameIndex of recently used roots, kept in memory and in the
+ * LocalStore's nameindex key space.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class NameIndexCache {
+ public:
+  NameIndexCache(std::shared_ptr<LocalStore> localStore, size_t maximumEntries)
+      : localStore_{std::move(localStore)},
+        cache_{folly::in_place, maximumEntries} {}
+
+  /**
+   * Returns the index of `rootId`, whose root tree is `rootTree`.
+   *
+   * An index that is not stored yet is built from the trees in the
+   * LocalStore. Until they have all been fetched, for example by a glob that
+   * walked the whole root, this returns nullptr and the next call tries again.
+   */
+  ImmediateFuture<std::shared_ptr<const NameIndex>> get(
+      const RootId& rootId,
+      const Tree& rootTree);
+
+ private:
+  void insert(const RootId& rootId, std::shared_ptr<const NameIndex> index);
+
+  std::shared_ptr<LocalStore> localStore_;
+  // A lookup updates the LRU order, so there is no point in a shared lock.
+  folly::Synchronized<
+      folly::EvictingCacheMap<RootId, std::shared_ptr<const NameIndex>>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
@@ -6,14 +6,24 @@
  */
 
 #include <folly/MapUtil.h>
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
 #include <utility>
 
 #include "eden/fs/store/ObjectCache.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/MemoryArena.h"
 
 namespace facebook::eden {
 
+namespace detail {
+/// Percentage of each shard's byte budget used for the TinyLFU window.
+constexpr size_t kObjectCacheWindowPercent = 1;
+/// Assumed average object size when sizing the TinyLFU frequency sketch.
+constexpr size_t kObjectCacheSketchBytesPerEntry = 4096;
+constexpr size_t kObjectCacheMaxSketchEntries = 1 << 20;
+} // namespace detail
+
 template <typename ObjectType>
 ObjectInterestHandle<ObjectType>::ObjectInterestHandle(
     std::weak_ptr<ObjectCache<ObjectType, ObjectCacheFlavor::InterestHandle>>
@@ -61,20 +71,48 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::shared_ptr<ObjectCache<ObjectType, Flavor>>
 ObjectCache<ObjectType, Flavor>::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    size_t numShards,
+    ObjectCacheEvictionPolicy policy) {
   // Allow make_shared with private constructor.
   struct OC : ObjectCache<ObjectType, Flavor> {
-    OC(size_t x, size_t y) : ObjectCache<ObjectType, Flavor>{x, y} {}
+    OC(size_t x, size_t y, size_t z, ObjectCacheEvictionPolicy p)
+        : ObjectCache<ObjectType, Flavor>{x, y, z, p} {}
   };
-  return std::make_shared<OC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<OC>(
+      maximumCacheSizeBytes, minimumEntryCount, numShards, policy);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 ObjectCache<ObjectType, Flavor>::ObjectCache(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount)
-    : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+    size_t minimumEntryCount,
+    size_t numShards,
+    ObjectCacheEvictionPolicy policy)
+    : shards_(std::max<size_t>(numShards, 1)),
+      maximumCacheSizeBytes_{maximumCacheSizeBytes / shards_.size()},
+      minimumEntryCount_{
+          (minimumEntryCount + shards_.size() - 1) / shards_.size()},
+      policy_{policy},
+      windowSizeBytes_{
+          maximumCacheSizeBytes_ * detail::kObjectCacheWindowPercent / 100} {
+  if (policy_ == ObjectCacheEvictionPolicy::TinyLFU) {
+    auto expectedEntries = std::clamp(
+        maximumCacheSizeBytes_ / detail::kObjectCacheSketchBytesPerEntry,
+        std::max<size_t>(minimumEntryCount_, 1),
+        detail::kObjectCacheMaxSketchEntries);
+    for (auto& shard : shards_) {
+      shard.state.frequency.ensureCapacity(expectedEntries);
+    }
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+size_t ObjectCache<ObjectType, Flavor>::shardIndex(const ObjectId& hash) const {
+  // The per-shard unordered_map also hashes the ObjectId, so mix the bits to
+  // avoid correlating shard selection with the bucket selection.
+  return folly::hash::twang_mix64(hash.getHashCode()) % shards_.size();
+}
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
@@ -90,7 +128,7 @@ ObjectCache<ObjectType, Flavor>::getInterestHandle(
   // runs after the lock is released.
   ObjectInterestHandle<ObjectType> interestHandle;
 
-  auto state = lockState();
+  auto state = lockState(hash);
 
   auto item = getImpl(hash, state);
   if (!item) {
@@ -129,7 +167,7 @@ typename std::enable_if_t<
     typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
 ObjectCache<ObjectType, Flavor>::getSimple(const ObjectId& hash) {
   XLOG(DBG6) << "BlobCache::getSimple " << hash;
-  auto state = lockState();
+  auto state = lockState(hash);
 
   if (auto item = getImpl(hash, state)) {
     return item->object;
@@ -143,6 +181,7 @@ ObjectCache<ObjectType, Flavor>::getImpl(
     const ObjectId& hash,
     LockedState& state) {
   XLOG(DBG6) << "ObjectCache::getImpl " << hash;
+  recordAccess(hash, state);
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
     XLOG(DBG6) << "ObjectCache::getImpl missed";
@@ -153,8 +192,8 @@ ObjectCache<ObjectType, Flavor>::getImpl(
 
     // TODO: Should we avoid promoting if interest is UnlikelyNeededAgain?
     // For now, we'll try not to be too clever.
-    state->evictionQueue.splice(
-        state->evictionQueue.end(), state->evictionQueue, item->index);
+    auto& queue = queueFor(state, item);
+    queue.splice(queue.end(), queue, item->index);
     ++state->hitCount;
   }
 
@@ -190,25 +229,32 @@ ObjectCache<ObjectType, Flavor>::insertInterestHandle(
 
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
-  auto state = lockState();
-  auto [item, inserted] = insertImpl(object, state);
-  switch (interest) {
-    case Interest::UnlikelyNeededAgain:
-      break;
-    case Interest::WantHandle:
-    case Interest::LikelyNeededAgain:
-      ++item->referenceCount;
-      break;
+  std::vector<ObjectPtr> evicted;
+  {
+    auto state = lockState(object->getHash());
+    auto [item, inserted] = insertImpl(object, state);
+    switch (interest) {
+      case Interest::UnlikelyNeededAgain:
+        break;
+      case Interest::WantHandle:
+      case Interest::LikelyNeededAgain:
+        ++item->referenceCount;
+        break;
+    }
+    if (inserted) { // new entry we need to set the generation number
+      item->generation = cacheItemGeneration;
+      evicted.swap(state->evicted);
+    } else {
+      XLOG(DBG6) << "duplicate entry, using generation " << item->generation;
+      // Inserting duplicate entry - use its generation.
+      interestHandle.cacheItemGeneration_ = item->generation;
+      // note we can skip eviction here because we didn't insert anything new,
+      // so the cache size has not changed as a result of this operation.
+      return interestHandle;
+    }
   }
-  if (inserted) { // new entry we need to set the generation number
-    item->generation = cacheItemGeneration;
-  } else {
-    XLOG(DBG6) << "duplicate entry, using generation " << item->generation;
-    // Inserting duplicate entry - use its generation.
-    interestHandle.cacheItemGeneration_ = item->generation;
-    // note we can skip eviction here because we didn't insert anything new,
-    // so the cache size has not changed as a result of this operation.
-    return interestHandle;
+  if (!evicted.empty()) {
+    onObjectsEvicted(std::move(evicted));
   }
   return interestHandle;
 }
@@ -219,8 +265,15 @@ typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void>
 ObjectCache<ObjectType, Flavor>::insertSimple(
     ObjectCache<ObjectType, Flavor>::ObjectPtr object) {
   XLOG(DBG6) << "ObjectCache::insertSimple " << object->getHash();
-  auto state = lockState();
-  insertImpl(object, state);
+  std::vector<ObjectPtr> evicted;
+  {
+    auto state = lockState(object->getHash());
+    insertImpl(object, state);
+    evicted.swap(state->evicted);
+  }
+  if (!evicted.empty()) {
+    onObjectsEvicted(std::move(evicted));
+  }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -229,6 +282,7 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
     ObjectPtr object,
     LockedState& state) {
   XLOG(DBG6) << "ObjectCache::insertImpl " << object->getHash();
+  MemoryArena::Scope arenaScope{MemoryArena::objectCache()};
 
   auto hash = object->getHash();
   auto size = object->getSizeBytes();
@@ -240,57 +294,110 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
 
   auto* itemPtr = &iter->second;
   if (inserted) {
+    itemPtr->inWindow = policy_ == ObjectCacheEvictionPolicy::TinyLFU;
+    auto& queue = queueFor(state, itemPtr);
     try {
-      state->evictionQueue.push_back(itemPtr);
+      queue.push_back(itemPtr);
     } catch (const std::exception&) {
       state->items.erase(iter);
       throw;
     }
-    iter->second.index = std::prev(state->evictionQueue.end());
+    iter->second.index = std::prev(queue.end());
     state->totalSize += size;
+    if (itemPtr->inWindow) {
+      state->windowSize += size;
+    }
+    recordAccess(iter->first, state);
     evictUntilFits(state);
   } else {
-    state->evictionQueue.splice(
-        state->evictionQueue.end(), state->evictionQueue, itemPtr->index);
+    auto& queue = queueFor(state, itemPtr);
+    queue.splice(queue.end(), queue, itemPtr->index);
   }
   return std::make_pair(itemPtr, inserted);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 bool ObjectCache<ObjectType, Flavor>::contains(const ObjectId& hash) const {
-  auto state = lockState();
+  auto state = lockState(hash);
   return 1 == state->items.count(hash);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::clear() {
   XLOG(DBG6) << "ObjectCache::clear";
-  auto state = lockState();
-  state->totalSize = 0;
-  state->items.clear();
-  state->evictionQueue.clear();
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    state->totalSize = 0;
+    state->items.clear();
+    state->evictionQueue.clear();
+    state->windowQueue.clear();
+    state->windowSize = 0;
+  }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::Stats
 ObjectCache<ObjectType, Flavor>::getStats() const {
-  auto state = lockState();
   Stats stats;
-  stats.objectCount = state->items.size();
-  stats.totalSizeInBytes = state->totalSize;
-  stats.hitCount = state->hitCount;
-  stats.missCount = state->missCount;
-  stats.evictionCount = state->evictionCount;
-  stats.dropCount = state->dropCount;
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    stats.objectCount += state->items.size();
+    stats.totalSizeInBytes += state->totalSize;
+    stats.hitCount += state->hitCount;
+    stats.missCount += state->missCount;
+    stats.evictionCount += state->evictionCount;
+    stats.dropCount += state->dropCount;
+    stats.admissionRejectCount += state->admissionRejectCount;
+  }
   return stats;
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+std::vector<ObjectId> ObjectCache<ObjectType, Flavor>::getMostRecentlyUsedIds(
+    size_t limit) const {
+  auto perShardLimit = (limit + shards_.size() - 1) / shards_.size();
+  std::vector<std::vector<ObjectId>> shardIds;
+  shardIds.reserve(shards_.size());
+  size_t total = 0;
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    auto& ids = shardIds.emplace_back();
+    ids.reserve(std::min(perShardLimit, state->items.size()));
+    // The TinyLFU window holds the newest entries. Both queues evict from the
+    // front.
+    for (auto* queue : {&state->windowQueue, &state->evictionQueue}) {
+      for (auto it = queue->rbegin();
+           it != queue->rend() && ids.size() < perShardLimit;
+           ++it) {
+        ids.push_back((*it)->object->getHash());
+      }
+    }
+    total += ids.size();
+  }
+
+  std::vector<ObjectId> result;
+  result.reserve(std::min(limit, total));
+  for (size_t i = 0; result.size() < limit; ++i) {
+    bool found = false;
+    for (auto& ids : shardIds) {
+      if (i < ids.size() && result.size() < limit) {
+        result.push_back(std::move(ids[i]));
+        found = true;
+      }
+    }
+    if (!found) {
+      break;
+    }
+  }
+  return result;
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
     const ObjectId& hash,
     uint64_t generation) noexcept {
   XLOG(DBG6) << "dropInterestHandle " << hash << " generation=" << generation;
-  auto state = lockState();
+  auto state = lockState(hash);
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -312,12 +419,58 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
   }
 
   if (--item->referenceCount == 0) {
-    state->evictionQueue.erase(item->index);
+    queueFor(state, item).erase(item->index);
     ++state->dropCount;
     evictItem(state, item);
   }
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::recordAccess(
+    const ObjectId& hash,
+    LockedState& state) noexcept {
+  if (policy_ == ObjectCacheEvictionPolicy::TinyLFU) {
+    state->frequency.increment(hash.getHashCode());
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::drainWindow(LockedState& state) noexcept {
+  // Always leave the most recently inserted entry in the window so that
+  // insertImpl's caller can still reference it.
+  while (state->windowSize > windowSizeBytes_ &&
+         state->windowQueue.size() > 1) {
+    CacheItem* candidate = state->windowQueue.front();
+    state->evictionQueue.splice(
+        state->evictionQueue.end(), state->windowQueue, candidate->index);
+    candidate->inWindow = false;
+    state->windowSize -= candidate->object->getSizeBytes();
+
+    if (state->totalSize <= maximumCacheSizeBytes_ ||
+        itemCount(state) <= minimumEntryCount_ ||
+        state->evictionQueue.size() == 1) {
+      // There is room for the candidate, or nothing to compare it against.
+      continue;
+    }
+
+    CacheItem* victim = state->evictionQueue.front();
+    auto candidateFrequency =
+        state->frequency.frequency(candidate->object->getHash().getHashCode());
+    auto victimFrequency =
+        state->frequency.frequency(victim->object->getHash().getHashCode());
+    if (candidateFrequency > victimFrequency) {
+      evictOne(state);
+    } else {
+      XLOG(DBG6) << "ObjectCache::drainWindow rejecting "
+                 << candidate->object->getHash();
+      state->evictionQueue.pop_back();
+      ++state->admissionRejectCount;
+      recordEviction(state, candidate);
+      evictItem(state, candidate);
+    }
+  }
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictUntilFits(
     LockedState& state) noexcept {
@@ -325,21 +478,44 @@ void ObjectCache<ObjectType, Flavor>::evictUntilFits(
              << "state.totalSize=" << state->totalSize
              << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes_
              << ", evictionQueue.size()=" << state->evictionQueue.size()
+             << ", windowQueue.size()=" << state->windowQueue.size()
              << ", minimumEntryCount_=" << minimumEntryCount_;
+  if (policy_ == ObjectCacheEvictionPolicy::TinyLFU) {
+    drainWindow(state);
+  }
   while (state->totalSize > maximumCacheSizeBytes_ &&
-         state->evictionQueue.size() > minimumEntryCount_) {
+         itemCount(state) > minimumEntryCount_) {
     evictOne(state);
   }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictOne(LockedState& state) noexcept {
-  CacheItem* front = state->evictionQueue.front();
-  state->evictionQueue.pop_front();
+  // The main queue is always evicted first; the window is only touched when
+  // everything else is gone.
+  auto& queue = state->evictionQueue.empty() ? state->windowQueue
+                                             : state->evictionQueue;
+  CacheItem* front = queue.front();
+  queue.pop_front();
   ++state->evictionCount;
+  recordEviction(state, front);
   evictItem(state, front);
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::recordEviction(
+    LockedState& state,
+    CacheItem* item) noexcept {
+  if (!notifyEvictions_) {
+    return;
+  }
+  try {
+    state->evicted.push_back(item->object);
+  } catch (const std::bad_alloc&) {
+    // Eviction notifications are best-effort.
+  }
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictItem(
     LockedState& state,
@@ -348,6 +524,9 @@ void ObjectCache<ObjectType, Flavor>::evictItem(
              << "evicting " << item->object->getHash()
              << " generation=" << item->generation;
   auto size = item->object->getSizeBytes();
+  if (item->inWindow) {
+    state->windowSize -= size;
+  }
   // TODO: Releasing this ObjectPtr here can run arbitrary deleters which
   // could, in theory, try to reacquire the ObjectCache's lock. The object
   // could be scheduled for deletion in a deletion queue but then it's hard to
@@ -7,18 +7,43 @@
 
 #pragma once
 
+#include <algorithm>
 #include <list>
+#include <new>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
+#include <folly/lang/Align.h>
 #include <folly/synchronization/DistributedMutex.h>
 
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/FrequencySketch.h"
 
 namespace facebook::eden {
 
 enum class ObjectCacheFlavor { Simple, InterestHandle };
 
+/**
+ * How an ObjectCache decides what to keep when it is over budget.
+ */
+enum class ObjectCacheEvictionPolicy {
+  /**
+   * Plain LRU: new objects are always admitted and the least recently used
+   * objects are evicted.
+   */
+  LRU,
+
+  /**
+   * W-TinyLFU: new objects land in a small LRU admission window. When an
+   * object leaves the window and the cache is full, it is only admitted into
+   * the main LRU if it has been accessed more often recently than the main
+   * LRU's eviction candidate. This keeps one-off scans from flushing the
+   * frequently used working set.
+   */
+  TinyLFU,
+};
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 class ObjectCache;
 
@@ -100,6 +125,16 @@ class ObjectInterestHandle {
  * be used that only allow clients to use one flavor of get and insert. See
  * BlobCache and TreeCache for examples of each flavor.
  *
+ * The cache can optionally be split into a number of independent shards,
+ * selected by the hash of the ObjectId. Each shard has its own lock, LRU
+ * queue, and an equal share of the maximum cache size and minimum entry count.
+ * Sharding reduces lock contention when many threads hit the cache
+ * concurrently, at the cost of the LRU order only being maintained per shard.
+ * With a single shard (the default), the cache behaves as a global LRU.
+ *
+ * The eviction policy is selected at creation time; see
+ * ObjectCacheEvictionPolicy.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -144,12 +179,21 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    /// Objects not admitted into the cache by the TinyLFU policy.
+    uint64_t admissionRejectCount{0};
   };
 
+  /**
+   * Create an ObjectCache split into numShards shards (0 is treated as 1).
+   * The maximum cache size and minimum entry count are split evenly between
+   * the shards, rounding the minimum entry count up.
+   */
   static std::shared_ptr<ObjectCache<ObjectType, Flavor>> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
-  ~ObjectCache() {}
+      size_t minimumEntryCount,
+      size_t numShards = 1,
+      ObjectCacheEvictionPolicy policy = ObjectCacheEvictionPolicy::LRU);
+  virtual ~ObjectCache() {}
 
   /**
    * If a object for the given hash is in cache, return it. If the object is not
@@ -222,8 +266,43 @@ class ObjectCache
    */
   Stats getStats() const;
 
+  /**
+   * Return the ids of up to limit cached objects, most recently used first.
+   * With several shards, whose relative order is unknown, the shards are
+   * interleaved.
+   */
+  std::vector<ObjectId> getMostRecentlyUsedIds(size_t limit) const;
+
+  /**
+   * Return the number of independently locked shards in this cache.
+   */
+  size_t getShardCount() const {
+    return shards_.size();
+  }
+
  protected:
-  explicit ObjectCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  explicit ObjectCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t numShards = 1,
+      ObjectCacheEvictionPolicy policy = ObjectCacheEvictionPolicy::LRU);
+
+  /**
+   * Subclasses that override onObjectsEvicted must call this from their
+   * constructor, before the cache is shared with other threads.
+   */
+  void enableEvictionNotifications() {
+    notifyEvictions_ = true;
+  }
+
+  /**
+   * Called after an insert, with no cache lock held, with the objects that
+   * were evicted to make room or rejected by the admission policy. Objects
+   * dropped because their last interest handle went away or removed by
+   * clear() are not reported.
+   */
+  virtual void onObjectsEvicted(std::vector<ObjectPtr> /* objects */) noexcept {
+  }
 
  private:
   /*
@@ -254,6 +333,10 @@ class ObjectCache
     /// Given a unique value upon allocation. Used to verify InterestHandle
     /// matches this specific item.
     uint64_t generation{std::numeric_limits<uint64_t>::max()};
+
+    /// True if index points into State::windowQueue rather than
+    /// State::evictionQueue. Only ever set with the TinyLFU policy.
+    bool inWindow{false};
   };
 
   struct State {
@@ -263,10 +346,32 @@ class ObjectCache
     /// Entries are evicted from the front of the queue.
     std::list<CacheItem*> evictionQueue;
 
+    /// TinyLFU admission window. Newly inserted entries start here and move
+    /// to evictionQueue, if admitted, once the window exceeds its budget.
+    std::list<CacheItem*> windowQueue;
+    size_t windowSize{0};
+
+    /// Recent access frequencies, only populated with the TinyLFU policy.
+    FrequencySketch frequency;
+
     uint64_t hitCount{0};
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t admissionRejectCount{0};
+
+    /// Objects evicted during the current insert, handed to
+    /// onObjectsEvicted once the lock is released.
+    std::vector<ObjectPtr> evicted;
+  };
+
+  /**
+   * Each shard is padded to its own cache line(s) so that threads hammering
+   * different shards do not false-share the locks.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    State state;
+    folly::DistributedMutex lock;
   };
 
   /**
@@ -300,8 +405,25 @@ class ObjectCache
     std::unique_lock<folly::DistributedMutex> stateLock_;
   };
 
-  LockedState lockState() const {
-    return LockedState{state_, stateLock_};
+  Shard& getShard(const ObjectId& hash) const {
+    if (shards_.size() == 1) {
+      return shards_[0];
+    }
+    return shards_[shardIndex(hash)];
+  }
+
+  size_t shardIndex(const ObjectId& hash) const;
+
+  /**
+   * Lock the shard responsible for the given hash.
+   */
+  LockedState lockState(const ObjectId& hash) const {
+    auto& shard = getShard(hash);
+    return LockedState{shard.state, shard.lock};
+  }
+
+  LockedState lockShard(Shard& shard) const {
+    return LockedState{shard.state, shard.lock};
   }
 
   /**
@@ -325,14 +447,40 @@ class ObjectCache
 
   void dropInterestHandle(const ObjectId& hash, uint64_t generation) noexcept;
 
+  std::list<CacheItem*>& queueFor(LockedState& state, CacheItem* item) {
+    return item->inWindow ? state->windowQueue : state->evictionQueue;
+  }
+
+  size_t itemCount(LockedState& state) const {
+    return state->evictionQueue.size() + state->windowQueue.size();
+  }
+
+  void recordAccess(const ObjectId& hash, LockedState& state) noexcept;
+
+  /**
+   * Move entries that overflow the TinyLFU window into the main queue,
+   * evicting either the entry itself or the main queue's LRU entry, whichever
+   * has been accessed less frequently.
+   */
+  void drainWindow(LockedState& state) noexcept;
+
   void evictUntilFits(LockedState& state) noexcept;
   void evictOne(LockedState& state) noexcept;
   void evictItem(LockedState&, CacheItem* item) noexcept;
+  void recordEviction(LockedState& state, CacheItem* item) noexcept;
 
+  // Must be initialized before the per-shard limits below.
+  mutable std::vector<Shard> shards_;
+
+  /// Per-shard limits, derived from the limits passed to create().
   const size_t maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
-  mutable State state_;
-  mutable folly::DistributedMutex stateLock_;
+
+  const ObjectCacheEvictionPolicy policy_;
+  /// Per-shard size of the TinyLFU admission window.
+  const size_t windowSizeBytes_;
+
+  bool notifyEvictions_{false};
 
   friend class ObjectInterestHandle<ObjectType>;
 };
@@ -6,9 +6,11 @@
  */
 
 #pragma once
+#include <chrono>
 #include <optional>
 #include <unordered_map>
 
+#include <folly/CancellationToken.h>
 #include <folly/Range.h>
 
 #include "eden/fs/store/ImportPriority.h"
@@ -64,6 +66,14 @@ class ObjectFetchContext {
 
   virtual void didFetch(ObjectType, const ObjectId&, Origin) {}
 
+  /**
+   * Called with the time spent waiting on the BackingStore for an object that
+   * was not in the in-memory caches.
+   *
+   * May be called concurrently by arbitrary threads.
+   */
+  virtual void didWaitForBackingStore(std::chrono::microseconds) {}
+
   virtual std::optional<pid_t> getClientPid() const {
     return std::nullopt;
   }
@@ -76,6 +86,26 @@ class ObjectFetchContext {
     return std::nullopt;
   }
 
+  /**
+   * The process-unique id allocated once for the FUSE, NFS or Thrift request
+   * that caused the fetch. It is carried into the import requests, the trace
+   * events and the slow request log, so that they can all be tied back to the
+   * request.
+   */
+  virtual std::optional<uint64_t> getRequestId() const {
+    return std::nullopt;
+  }
+
+  /**
+   * Cancelled once the caller no longer needs the objects, for instance
+   * because the process behind a FUSE request was interrupted or a Thrift
+   * client disconnected. Imports that only cancelled callers wait on may be
+   * dropped before they are started, failing with folly::OperationCancelled.
+   */
+  virtual folly::CancellationToken getCancellationToken() const {
+    return {};
+  }
+
   virtual ImportPriority getPriority() const {
     return ImportPriority::kNormal();
   }
@@ -7,18 +7,25 @@
 
 #include "ObjectStore.h"
 
+#include <folly/CancellationToken.h>
 #include <folly/Conv.h>
+#include <folly/ExceptionString.h>
 #include <folly/Executor.h>
+#include <folly/String.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBuf.h>
 
+#include <algorithm>
+#include <chrono>
 #include <stdexcept>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeFilter.h"
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/TreeMetadata.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 
@@ -32,7 +39,13 @@ namespace facebook::eden {
 
 namespace {
 constexpr uint64_t kImportPriorityDeprioritizeAmount = 1;
-}
+
+/**
+ * Rendered filtered object IDs are this prefix followed by the hex-encoded
+ * ID, since the BackingStore can't render them.
+ */
+constexpr folly::StringPiece kFilteredObjectIdPrefix{"filtered:"};
+} // namespace
 
 std::shared_ptr<ObjectStore> ObjectStore::create(
     shared_ptr<LocalStore> localStore,
@@ -65,6 +78,11 @@ ObjectStore::ObjectStore(
     std::shared_ptr<const EdenConfig> edenConfig)
     : metadataCache_{folly::in_place, kCacheSize},
       treeCache_{std::move(treeCache)},
+      negativeCacheEnabled_{edenConfig->negativeCacheSize.getValue() != 0},
+      // EvictingCacheMap treats a maximum size of 0 as unbounded.
+      negativeCache_{
+          folly::in_place,
+          std::max<size_t>(edenConfig->negativeCacheSize.getValue(), 1)},
       localStore_{std::move(localStore)},
       backingStore_{std::move(backingStore)},
       stats_{std::move(stats)},
@@ -76,10 +94,57 @@ ObjectStore::ObjectStore(
 
 ObjectStore::~ObjectStore() {}
 
+void ObjectStore::invalidateNegativeCache() const {
+  negativeCache_.wlock()->clear();
+}
+
+std::optional<folly::exception_wrapper> ObjectStore::getCachedFailure(
+    const ObjectId& id) const {
+  if (!negativeCacheEnabled_) {
+    return std::nullopt;
+  }
+  auto negativeCache = negativeCache_.wlock();
+  auto iter = negativeCache->find(id);
+  if (iter == negativeCache->end()) {
+    return std::nullopt;
+  }
+  if (iter->second.expiry <= std::chrono::steady_clock::now()) {
+    negativeCache->erase(iter);
+    return std::nullopt;
+  }
+  stats_->getObjectStoreStatsForCurrentThread().negativeCacheHit.addValue(1);
+  return iter->second.error;
+}
+
+void ObjectStore::cacheFailure(
+    const ObjectId& id,
+    const folly::exception_wrapper& error) const {
+  // A fetch that was cancelled because its callers went away says nothing
+  // about the object.
+  if (!negativeCacheEnabled_ ||
+      error.is_compatible_with<folly::OperationCancelled>()) {
+    return;
+  }
+  auto ttl = error.is_compatible_with<std::domain_error>()
+      ? edenConfig_->negativeCacheMissingTTL.getValue()
+      : edenConfig_->negativeCacheErrorTTL.getValue();
+  if (ttl.count() <= 0) {
+    return;
+  }
+  auto expiry = std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(ttl);
+  negativeCache_.wlock()->set(id, NegativeCacheEntry{expiry, error});
+}
+
 void ObjectStore::updateProcessFetch(
     const ObjectFetchContext& fetchContext) const {
   if (auto pid = fetchContext.getClientPid()) {
     auto fetch_count = pidFetchCounts_->recordProcessFetch(pid.value());
+    if (fetch_count == 0 && processNameCache_) {
+      // Many fetching processes are short-lived: capture the name while the
+      // process still exists. The cache resolves it on its own thread.
+      processNameCache_->add(pid.value());
+    }
     auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
     if (fetch_count && threshold && !(fetch_count % threshold)) {
       sendFetchHeavyEvent(pid.value(), fetch_count);
@@ -88,11 +153,22 @@ void ObjectStore::updateProcessFetch(
 }
 
 void ObjectStore::sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const {
-  auto processName = processNameCache_->getSpacedProcessName(pid);
-  if (processName.has_value()) {
-    structuredLogger_->logEvent(
-        FetchHeavy{processName.value(), pid, fetch_count});
+  if (!processNameCache_ || !structuredLogger_) {
+    return;
   }
+  // Looking the name up may wait for the cache to read it from the system,
+  // which the fetch that crossed the threshold shouldn't.
+  folly::futures::detachOnGlobalCPUExecutor(folly::makeSemiFuture().deferValue(
+      [processNameCache = processNameCache_,
+       structuredLogger = structuredLogger_,
+       pid,
+       fetch_count](folly::Unit) {
+        auto processName = processNameCache->getSpacedProcessName(pid);
+        if (processName.has_value()) {
+          structuredLogger->logEvent(
+              FetchHeavy{processName.value(), pid, fetch_count});
+        }
+      }));
 }
 
 void ObjectStore::deprioritizeWhenFetchHeavy(
@@ -116,10 +192,23 @@ std::string ObjectStore::renderRootId(const RootId& rootId) {
 }
 
 ObjectId ObjectStore::parseObjectId(folly::StringPiece objectId) {
+  if (objectId.removePrefix(kFilteredObjectIdPrefix)) {
+    std::string bytes;
+    if (!folly::unhexlify(objectId, bytes)) {
+      throw std::invalid_argument(
+          fmt::format("invalid filtered object ID: {}", objectId));
+    }
+    return ObjectId{folly::StringPiece{bytes}};
+  }
   return backingStore_->parseObjectId(objectId);
 }
 
 std::string ObjectStore::renderObjectId(const ObjectId& objectId) {
+  // Filtered IDs mean nothing to the BackingStore.
+  if (TreeFilter::parseFilteredId(objectId)) {
+    return fmt::format(
+        "{}{}", kFilteredObjectIdPrefix, folly::hexlify(objectId.getBytes()));
+  }
   return backingStore_->renderObjectId(objectId);
 }
 
@@ -158,18 +247,12 @@ folly::Future<std::shared_ptr<TreeEntry>> ObjectStore::getTreeEntryForRootId(
 ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
     const ObjectId& id,
     ObjectFetchContext& fetchContext) const {
-  // Check in the LocalStore first
-
-  // TODO: We should consider checking if we have in flight BackingStore
-  // requests on this layer instead of only in the BackingStore. Consider the
-  // case in which thread A and thread B both request a Tree at the same time.
-  // Let's say thread A checks the LocalStore, then thread B checks the
-  // LocalStore, gets the file from the BackingStore (making a request to the
-  // server), then writes the Tree to the LocalStore. Now when thread A checks
-  // for in flight requests in the BackingStore, it will not see any since
-  // thread B has completely finished, so thread A will make a duplicate
-  // request. If we we're to mark here that we got a request on this layer, then
-  // we could avoid that case.
+  // Check the in-memory cache first.
+  //
+  // Concurrent misses for the same tree are joined onto one BackingStore
+  // request by pendingTreeFetches_. Otherwise thread A could miss here, thread
+  // B could miss, fetch, and finish, and thread A would then issue a duplicate
+  // request because the BackingStore no longer sees B's request in flight.
 
   if (auto maybeTree = treeCache_->get(id)) {
     fetchContext.didFetch(
@@ -180,27 +263,101 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
     return maybeTree;
   }
 
-  deprioritizeWhenFetchHeavy(fetchContext);
+  if (auto error = getCachedFailure(id)) {
+    return folly::makeSemiFuture<shared_ptr<const Tree>>(std::move(*error));
+  }
 
-  return backingStore_->getTree(id, fetchContext)
-      .via(executor_)
-      .thenValue([self = shared_from_this(), id, &fetchContext](
-                     BackingStore::GetTreeRes result) {
-        if (!result.tree) {
-          // TODO: Perhaps we should do some short-term negative
-          // caching?
-          XLOG(DBG2) << "unable to find tree " << id;
-          throw std::domain_error(fmt::format("tree {} not found", id));
-        }
+  // Filtered trees are derived from the unfiltered ones, which are fetched
+  // and cached as usual.
+  if (auto filtered = TreeFilter::parseFilteredId(id)) {
+    return getTree(filtered->first, fetchContext)
+        .thenValue([treeCache = treeCache_,
+                    filter = std::move(filtered->second)](
+                       shared_ptr<const Tree> tree) {
+          auto filteredTree = filter.apply(std::move(tree));
+          treeCache->insert(filteredTree);
+          return filteredTree;
+        });
+  }
+
+  auto self = shared_from_this();
+  auto fetchStart = std::chrono::steady_clock::now();
+  auto [future, coalesced] =
+      pendingTreeFetches_.fetch(id, executor_, [&self, &id, &fetchContext] {
+        self->deprioritizeWhenFetchHeavy(fetchContext);
+
+        return self->backingStore_->getTree(id, fetchContext)
+            .via(self->executor_)
+            .thenValue([self, id](BackingStore::GetTreeRes result) {
+              if (!result.tree) {
+                // TODO: Perhaps we should do some short-term negative
+                // caching?
+                XLOG(DBG2) << "unable to find tree " << id;
+                throw std::domain_error(fmt::format("tree {} not found", id));
+              }
 
-        // promote to shared_ptr so we can store in the cache and return
-        auto sharedTree = std::shared_ptr<const Tree>(std::move(result.tree));
-        self->treeCache_->insert(sharedTree);
-        fetchContext.didFetch(ObjectFetchContext::Tree, id, result.origin);
+              // promote to shared_ptr so we can store in the cache and return
+              auto sharedTree =
+                  std::shared_ptr<const Tree>(std::move(result.tree));
+              self->treeCache_->insert(sharedTree);
+              self->cacheTreeMetadata(*sharedTree);
+              return FetchedTree{std::move(sharedTree), result.origin};
+            })
+            .thenError([self, id](folly::exception_wrapper&& error) {
+              self->cacheFailure(id, error);
+              return folly::makeFuture<FetchedTree>(std::move(error));
+            });
+      });
+  auto result =
+      std::move(future).thenValue([self, id, &fetchContext, fetchStart](
+                                      FetchedTree fetched) {
+        fetchContext.didWaitForBackingStore(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - fetchStart));
+        fetchContext.didFetch(ObjectFetchContext::Tree, id, fetched.origin);
         self->updateProcessFetch(fetchContext);
-        return sharedTree;
-      })
-      .semi();
+        return std::move(fetched.tree);
+      });
+  if (coalesced) {
+    stats_->getObjectStoreStatsForCurrentThread().getTreeCoalesced.addValue(1);
+    // The joined fetch is dropped if the caller that started it went away,
+    // which doesn't concern this caller.
+    result = std::move(result).thenError(
+        folly::tag_t<folly::OperationCancelled>{},
+        [self, id, &fetchContext](folly::OperationCancelled&& error)
+            -> folly::Future<shared_ptr<const Tree>> {
+          if (fetchContext.getCancellationToken().isCancellationRequested()) {
+            return folly::makeFuture<shared_ptr<const Tree>>(
+                std::move(error));
+          }
+          return self->getTree(id, fetchContext).semi().via(self->executor_);
+        });
+  }
+  return std::move(result).semi();
+}
+
+void ObjectStore::cacheTreeMetadata(const Tree& tree) const {
+  auto metadata = TreeMetadata::fromTree(tree);
+  if (metadata.empty()) {
+    return;
+  }
+
+  try {
+    localStore_->putTreeMetadata(metadata);
+  } catch (const std::exception& ex) {
+    // The metadata can be fetched again later, so don't fail the tree fetch.
+    XLOG(WARN) << "failed to store the metadata of tree " << tree.getHash()
+               << ": " << folly::exceptionStr(ex);
+  }
+
+  auto metadataCache = metadataCache_.wlock();
+  for (const auto& [id, blobMetadata] :
+       std::get<TreeMetadata::HashIndexedEntryMetadata>(metadata.entries())) {
+    // Don't drop a BLAKE3 hash that was computed earlier.
+    if (!metadataCache->exists(id)) {
+      metadataCache->set(id, blobMetadata);
+    }
+  }
 }
 
 folly::Future<folly::Unit> ObjectStore::prefetchBlobs(
@@ -220,36 +377,127 @@ folly::Future<folly::Unit> ObjectStore::prefetchBlobs(
   return backingStore_->prefetchBlobs(ids, fetchContext).via(executor_);
 }
 
+folly::Future<std::vector<ObjectId>> ObjectStore::getUncachedBlobs(
+    std::vector<ObjectId> ids) const {
+  if (ids.empty() ||
+      !localStore_->enableBlobCaching.load(std::memory_order_relaxed)) {
+    return std::move(ids);
+  }
+  // The keys point into the IDs, which must not move until the lookup is
+  // done.
+  auto sharedIds = std::make_shared<std::vector<ObjectId>>(std::move(ids));
+  std::vector<folly::ByteRange> keys;
+  keys.reserve(sharedIds->size());
+  for (const auto& id : *sharedIds) {
+    keys.push_back(id.getBytes());
+  }
+  return localStore_->hasKeyBatch(KeySpace::BlobFamily, keys)
+      .thenValue([sharedIds](std::vector<bool> cached) {
+        std::vector<ObjectId> uncached;
+        for (size_t i = 0; i < cached.size(); ++i) {
+          if (!cached[i]) {
+            uncached.push_back((*sharedIds)[i]);
+          }
+        }
+        return uncached;
+      });
+}
+
 Future<shared_ptr<const Blob>> ObjectStore::getBlob(
     const ObjectId& id,
     ObjectFetchContext& fetchContext) const {
+  if (auto error = getCachedFailure(id)) {
+    return makeFuture<shared_ptr<const Blob>>(std::move(*error));
+  }
+
+  auto self = shared_from_this();
+  auto fetchStart = std::chrono::steady_clock::now();
+  auto [future, coalesced] =
+      pendingBlobFetches_.fetch(id, executor_, [&self, &id, &fetchContext] {
+        self->deprioritizeWhenFetchHeavy(fetchContext);
+        return self->backingStore_->getBlob(id, fetchContext)
+            .via(self->executor_)
+            .thenValue([self, id](BackingStore::GetBlobRes result) {
+              if (!result.blob) {
+                // TODO: Perhaps we should do some short-term negative
+                // caching?
+                XLOG(DBG2) << "unable to find blob " << id;
+                throw std::domain_error(fmt::format("blob {} not found", id));
+              }
+              // Quick check in-memory cache first, before doing expensive
+              // calculations. If metadata is present in cache, it most
+              // certainly exists in local store too.
+              // Additionally check if we use aux metadata from mercurial, and
+              // do not compute it in this case.
+              if (!self->edenConfig_->useAuxMetadata.getValue() &&
+                  !self->metadataCache_.rlock()->exists(id)) {
+                auto metadata =
+                    self->localStore_->putBlobMetadata(id, result.blob.get());
+                self->metadataCache_.wlock()->set(id, metadata);
+              }
+              return FetchedBlob{
+                  std::shared_ptr<const Blob>{std::move(result.blob)},
+                  result.origin};
+            })
+            .thenError([self, id](folly::exception_wrapper&& error) {
+              self->cacheFailure(id, error);
+              return makeFuture<FetchedBlob>(std::move(error));
+            });
+      });
+  auto result = std::move(future).thenValue(
+      [self, id, &fetchContext, fetchStart](FetchedBlob fetched) {
+        fetchContext.didWaitForBackingStore(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - fetchStart));
+        self->updateProcessFetch(fetchContext);
+        fetchContext.didFetch(ObjectFetchContext::Blob, id, fetched.origin);
+        return std::move(fetched.blob);
+      });
+  if (coalesced) {
+    stats_->getObjectStoreStatsForCurrentThread().getBlobCoalesced.addValue(1);
+    // See getTree.
+    result = std::move(result).thenError(
+        folly::tag_t<folly::OperationCancelled>{},
+        [self, id, &fetchContext](folly::OperationCancelled&& error) {
+          if (fetchContext.getCancellationToken().isCancellationRequested()) {
+            return folly::makeFuture<shared_ptr<const Blob>>(std::move(error));
+          }
+          return self->getBlob(id, fetchContext);
+        });
+  }
+  return result;
+}
+
+Future<std::unique_ptr<folly::IOBuf>> ObjectStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    ObjectFetchContext& fetchContext) const {
+  if (!supportsBlobRanges()) {
+    return getBlob(id, fetchContext)
+        .thenValue([offset, length](std::shared_ptr<const Blob> blob) {
+          return blob->cloneRange(offset, length);
+        });
+  }
+
   deprioritizeWhenFetchHeavy(fetchContext);
-  return backingStore_->getBlob(id, fetchContext)
+  auto self = shared_from_this();
+  return backingStore_->getBlobRange(id, offset, length, fetchContext)
       .via(executor_)
-      .thenValue([self = shared_from_this(), id, &fetchContext](
-                     BackingStore::GetBlobRes result) {
-        if (!result.blob) {
-          // TODO: Perhaps we should do some short-term negative caching?
-          XLOG(DBG2) << "unable to find blob " << id;
-          throw std::domain_error(fmt::format("blob {} not found", id));
-        }
-        // Quick check in-memory cache first, before doing expensive
-        // calculations. If metadata is present in cache, it most certainly
-        // exists in local store too.
-        // Additionally check if we use aux metadata from mercurial, and do not
-        // compute it in this case.
-        if (!self->edenConfig_->useAuxMetadata.getValue() &&
-            !self->metadataCache_.rlock()->exists(id)) {
-          auto metadata =
-              self->localStore_->putBlobMetadata(id, result.blob.get());
-          self->metadataCache_.wlock()->set(id, metadata);
-        }
+      .thenValue([self, id, &fetchContext](std::unique_ptr<folly::IOBuf> buf) {
         self->updateProcessFetch(fetchContext);
-        fetchContext.didFetch(ObjectFetchContext::Blob, id, result.origin);
-        return std::move(result.blob);
+        fetchContext.didFetch(
+            ObjectFetchContext::Blob,
+            id,
+            ObjectFetchContext::Origin::FromNetworkFetch);
+        return buf;
       });
 }
 
+bool ObjectStore::supportsBlobRanges() const {
+  return backingStore_->supportsBlobRanges();
+}
+
 ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
     const ObjectId& id,
     ObjectFetchContext& context) const {
@@ -347,6 +595,57 @@ ImmediateFuture<Hash20> ObjectStore::getBlobSha1(
       .thenValue([](const BlobMetadata& metadata) { return metadata.sha1; });
 }
 
+ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadataWithBlake3(
+    const ObjectId& id,
+    ObjectFetchContext& context) const {
+  auto self = shared_from_this();
+  return getBlobMetadata(id, context)
+      .thenValue([self, id, &context](
+                     BlobMetadata metadata) -> ImmediateFuture<BlobMetadata> {
+        if (metadata.blake3) {
+          return metadata;
+        }
+        return ImmediateFuture<std::shared_ptr<const Blob>>{
+            self->getBlob(id, context).semi()}
+            .thenValue([self, id, metadata = std::move(metadata)](
+                           std::shared_ptr<const Blob> blob) mutable {
+              metadata.blake3 = Blake3::hash(blob->getContents());
+              self->localStore_->putBlobMetadata(id, metadata);
+              self->metadataCache_.wlock()->set(id, metadata);
+              return metadata;
+            });
+      });
+}
+
+ImmediateFuture<folly::Unit> ObjectStore::prefetchBlobMetadata(
+    std::vector<ObjectId> ids) const {
+  {
+    auto metadataCache = metadataCache_.wlock();
+    ids.erase(
+        std::remove_if(
+            ids.begin(),
+            ids.end(),
+            [&](const ObjectId& id) { return metadataCache->exists(id); }),
+        ids.end());
+  }
+  if (ids.empty()) {
+    return folly::unit;
+  }
+
+  auto self = shared_from_this();
+  return ImmediateFuture<std::vector<std::optional<BlobMetadata>>>{
+      localStore_->getBlobMetadataBatch(ids).semi()}
+      .thenValue([self, ids = std::move(ids)](
+                     std::vector<std::optional<BlobMetadata>>&& metadata) {
+        auto metadataCache = self->metadataCache_.wlock();
+        for (size_t i = 0; i < ids.size(); ++i) {
+          if (metadata[i]) {
+            metadataCache->set(ids[i], *metadata[i]);
+          }
+        }
+      });
+}
+
 ImmediateFuture<uint64_t> ObjectStore::getBlobSize(
     const ObjectId& id,
     ObjectFetchContext& context) const {
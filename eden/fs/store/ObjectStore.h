@@ -10,7 +10,9 @@
 #include <folly/Executor.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 #include <folly/logging/xlog.h>
@@ -22,6 +24,7 @@
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/SingleFlight.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
@@ -91,8 +94,9 @@ class ObjectStore : public IObjectStore,
   void updateProcessFetch(const ObjectFetchContext& fetchContext) const;
 
   /**
-   * send a FetchHeavy log event to Scuba. If either processNameCache_
-   * or structuredLogger_ is nullptr, this function does nothing.
+   * send a FetchHeavy log event to Scuba, from a background thread. If either
+   * processNameCache_ or structuredLogger_ is nullptr, this function does
+   * nothing.
    */
   void sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const;
 
@@ -179,6 +183,15 @@ class ObjectStore : public IObjectStore,
       ObjectIdRange ids,
       ObjectFetchContext& context) const override;
 
+  /**
+   * Returns the blobs that are not cached in the LocalStore, in the order of
+   * ids, so that prefetches can skip the others. The existence checks are
+   * done with a single batched lookup. All the blobs are returned if blobs are
+   * not cached in the LocalStore.
+   */
+  folly::Future<std::vector<ObjectId>> getUncachedBlobs(
+      std::vector<ObjectId> ids) const;
+
   /**
    * Get a Blob by ID.
    *
@@ -190,6 +203,13 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       ObjectFetchContext& context) const override;
 
+  folly::Future<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) const override;
+  bool supportsBlobRanges() const override;
+
   /**
    * Get metadata about a Blob.
    *
@@ -215,6 +235,29 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       ObjectFetchContext& context) const;
 
+  /**
+   * Like getBlobMetadata(), but also fills in the BLAKE3 hash of the blob's
+   * contents.
+   *
+   * Unlike the SHA-1, backing stores don't provide it, so the first request
+   * for a blob fetches and hashes its contents. The result is then saved
+   * with the rest of the blob's metadata.
+   */
+  ImmediateFuture<BlobMetadata> getBlobMetadataWithBlake3(
+      const ObjectId& id,
+      ObjectFetchContext& context) const;
+
+  /**
+   * Load the metadata of the given blobs from the LocalStore into the
+   * in-memory metadata cache with a single batched lookup, so that
+   * getBlobMetadata() then finds them without a LocalStore read per blob.
+   *
+   * Blobs whose metadata isn't in the LocalStore are left for
+   * getBlobMetadata() to fetch.
+   */
+  ImmediateFuture<folly::Unit> prefetchBlobMetadata(
+      std::vector<ObjectId> ids) const;
+
   /**
    * Get the LocalStore used by this ObjectStore
    */
@@ -237,6 +280,13 @@ class ObjectStore : public IObjectStore,
     pidFetchCounts_->clear();
   }
 
+  /**
+   * Forget every object the negative cache has recorded as missing or failed.
+   * Call this when new data may have become available, for example after
+   * pulling new commits.
+   */
+  void invalidateNegativeCache() const;
+
  private:
   // Forbidden constructor. Use create().
   ObjectStore(
@@ -284,6 +334,65 @@ class ObjectStore : public IObjectStore,
    */
   const std::shared_ptr<TreeCache> treeCache_;
 
+  struct FetchedBlob {
+    std::shared_ptr<const Blob> blob;
+    ObjectFetchContext::Origin origin;
+  };
+
+  struct FetchedTree {
+    std::shared_ptr<const Tree> tree;
+    ObjectFetchContext::Origin origin;
+  };
+
+  /**
+   * When a build starts, many processes tend to fault in the same objects at
+   * the same moment. Concurrent getBlob() and getTree() calls for the same ID
+   * are joined onto the first caller's BackingStore fetch rather than each
+   * issuing their own. The BackingStore only sees the first caller's
+   * ObjectFetchContext, but every caller records the fetch in its own.
+   */
+  mutable SingleFlight<FetchedBlob> pendingBlobFetches_;
+  mutable SingleFlight<FetchedTree> pendingTreeFetches_;
+
+  /**
+   * Store the blob metadata that the backing store returned along with a
+   * freshly fetched tree in the LocalStore and in metadataCache_, so that
+   * stat() of its files doesn't need another lookup.
+   */
+  void cacheTreeMetadata(const Tree& tree) const;
+
+  struct NegativeCacheEntry {
+    std::chrono::steady_clock::time_point expiry;
+    folly::exception_wrapper error;
+  };
+
+  /**
+   * Return the error a recent fetch of `id` failed with, if it is still in
+   * the negative cache.
+   */
+  std::optional<folly::exception_wrapper> getCachedFailure(
+      const ObjectId& id) const;
+
+  /**
+   * Record that fetching `id` failed with `error`. Not-found errors and other
+   * errors are remembered for different amounts of time.
+   */
+  void cacheFailure(const ObjectId& id, const folly::exception_wrapper& error)
+      const;
+
+  /**
+   * Tooling regularly probes object IDs that do not exist, and retries failed
+   * fetches. Remember recent failures for a short time so that repeating
+   * them does not go through the LocalStore and BackingStore again. The
+   * entries expire after negativeCacheMissingTTL or negativeCacheErrorTTL, and
+   * least recently used entries are evicted once negativeCacheSize is
+   * reached.
+   */
+  const bool negativeCacheEnabled_;
+  mutable folly::Synchronized<
+      folly::EvictingCacheMap<ObjectId, NegativeCacheEntry>>
+      negativeCache_;
+
   /*
    * The LocalStore.
    *
@@ -7,23 +7,32 @@
 
 #include "eden/fs/store/RocksDbLocalStore.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <thread>
 
 #include <fb303/ServiceData.h>
 #include <folly/Format.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
+#include <folly/container/F14Set.h>
 #include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <rocksdb/cache.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/table.h>
 
 #include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/rocksdb/RocksException.h"
 #include "eden/fs/rocksdb/RocksHandles.h"
 #include "eden/fs/store/KeySpace.h"
@@ -43,15 +52,123 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
-rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
+/**
+ * Maximum number of keys looked up by a single MultiGet call in getBatch().
+ */
+constexpr size_t kMultiGetBatchSize = 2048;
+
+/**
+ * Write combining limits used until configureWriteCombining() is called.
+ * They match the defaults of the corresponding config settings.
+ */
+constexpr size_t kWriteCombiningBatchBytes = 16 * 1024 * 1024;
+constexpr std::chrono::nanoseconds kWriteCombiningInterval =
+    std::chrono::seconds{1};
+
+/**
+ * Access-time tracking for least recently used garbage collection: keys
+ * accessed within the last kLruGcNumBuckets * kLruGcBucketDuration are
+ * ordered by bucket, and everything older looks equally old.
+ */
+constexpr size_t kLruGcNumBuckets = 8;
+constexpr auto kLruGcBucketDuration = std::chrono::hours{3};
+constexpr size_t kLruGcMaxKeysPerBucket = 100'000;
+
+/**
+ * Least recently used garbage collection shrinks a column to this fraction
+ * of its limit so that it does not run again as soon as it finishes.
+ */
+constexpr double kLruGcTargetRatio = 0.8;
+
+/**
+ * Longest pause between garbage collection steps while backing off for
+ * foreground reads.
+ */
+constexpr auto kLruGcMaxPause = std::chrono::seconds{1};
+
+/**
+ * Size of the block cache shared by every key space whose tuning profile asks
+ * for KeySpaceTuning::BlockCache::Shared.
+ */
+constexpr size_t kSharedBlockCacheSizeMB = 64;
+
+/**
+ * Keys of the locality key space. Repacked objects are stored under
+ * kLocalityDataPrefix followed by their big-endian position in the walk of
+ * the trees, and found through kLocalityIndexPrefix followed by the index of
+ * their key space and their key.
+ */
+constexpr char kLocalityDataPrefix = 'd';
+constexpr char kLocalityIndexPrefix = 'i';
+
+/**
+ * repackForLocality() commits its writes in batches of about this size.
+ */
+constexpr size_t kRepackWriteBatchBytes = 16 * 1024 * 1024;
+
+std::string makeLocalityDataKey(uint64_t position) {
+  std::string key(1 + sizeof(position), kLocalityDataPrefix);
+  auto bigEndian = folly::Endian::big(position);
+  std::memcpy(&key[1], &bigEndian, sizeof(bigEndian));
+  return key;
+}
+
+std::string makeLocalityIndexKey(KeySpace keySpace, ByteRange key) {
+  std::string indexKey;
+  indexKey.reserve(2 + key.size());
+  indexKey.push_back(kLocalityIndexPrefix);
+  indexKey.push_back(static_cast<char>(keySpace->index));
+  indexKey.append(reinterpret_cast<const char*>(key.data()), key.size());
+  return indexKey;
+}
+
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    const KeySpaceTuning& tuning,
+    const std::shared_ptr<rocksdb::Cache>& sharedBlockCache) {
   rocksdb::ColumnFamilyOptions options;
 
-  // We'll never perform range scans on any of the keys that we store.
-  // This enables bloom filters and a hash policy that improves our
-  // get/put performance.
-  options.OptimizeForPointLookup(LRUblockCacheSizeMB);
+  // We'll never perform range scans on any of the keys that we store, so
+  // this mirrors ColumnFamilyOptions::OptimizeForPointLookup() with the
+  // block size, bloom filter and cache taken from the tuning profile.
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.data_block_index_type =
+      rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  tableOptions.data_block_hash_table_util_ratio = 0.75;
+  tableOptions.block_size = tuning.blockSizeBytes;
+  if (tuning.bloomFilterBitsPerKey != 0) {
+    tableOptions.filter_policy.reset(
+        rocksdb::NewBloomFilterPolicy(tuning.bloomFilterBitsPerKey));
+    options.memtable_prefix_bloom_size_ratio = 0.02;
+    options.memtable_whole_key_filtering = true;
+  }
+  switch (tuning.blockCache) {
+    case KeySpaceTuning::BlockCache::Shared:
+      tableOptions.block_cache = sharedBlockCache;
+      break;
+    case KeySpaceTuning::BlockCache::Dedicated:
+      tableOptions.block_cache = rocksdb::NewLRUCache(
+          static_cast<size_t>(tuning.dedicatedBlockCacheSizeMB) * 1024 * 1024);
+      break;
+  }
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
 
   options.OptimizeLevelStyleCompaction();
+  if (!tuning.compression) {
+    // OptimizeLevelStyleCompaction() picks a per-level compression type,
+    // which takes precedence over options.compression.
+    options.compression_per_level.clear();
+    options.compression = rocksdb::kNoCompression;
+  }
+
+  if (tuning.largeValueThresholdBytes != 0) {
+    options.enable_blob_files = true;
+    options.min_blob_size = tuning.largeValueThresholdBytes;
+    options.blob_compression_type =
+        tuning.compression ? rocksdb::kLZ4Compression : rocksdb::kNoCompression;
+    // Blob files are only reclaimed once no SST file refers to them, so
+    // relocate live values out of old blob files during compaction.
+    options.enable_blob_garbage_collection = true;
+  }
   return options;
 }
 
@@ -62,12 +179,14 @@ rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
     const std::string& name) {
-  // Most of the column families will share the same cache.  We
-  // want the blob data to live in its own smaller cache; the assumption
-  // is that the vfs cache will compensate for that, together with the
-  // idea that we shouldn't need to materialize a great many files.
-  auto options = makeColumnOptions(64);
-  auto blobOptions = makeColumnOptions(8);
+  // Each key space is tuned according to its KeySpaceTuning profile. Most of
+  // them share one block cache; the blob data lives in its own smaller cache,
+  // the assumption being that the vfs cache will compensate for that,
+  // together with the idea that we shouldn't need to materialize a great many
+  // files.
+  auto sharedBlockCache =
+      rocksdb::NewLRUCache(kSharedBlockCacheSizeMB * 1024 * 1024);
+  auto options = makeColumnOptions(kDefaultTuning, sharedBlockCache);
 
   // We have to open all column families that currenly exists in our RocksDb.
   // Else we will get "Invalid argument: You have to open all column
@@ -81,8 +200,7 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
   std::vector<rocksdb::ColumnFamilyDescriptor> families;
   for (auto& ks : KeySpace::kAll) {
     families.emplace_back(
-        ks->name.str(),
-        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options);
+        ks->name.str(), makeColumnOptions(ks->tuning, sharedBlockCache));
     auto oldFamily = find(
         oldUnopenedColumnFamilies.begin(),
         oldUnopenedColumnFamilies.end(),
@@ -146,11 +264,13 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
   ~RocksDbWriteBatch() override;
   // Use LocalStore::beginWrite() to create a write batch
   RocksDbWriteBatch(
+      const RocksDbLocalStore& store,
       Synchronized<RocksHandles>::ConstRLockedPtr&& dbHandles,
       size_t bufferSize);
 
   void flushIfNeeded();
 
+  const RocksDbLocalStore& store_;
   folly::Synchronized<RocksHandles>::ConstRLockedPtr lockedDB_;
   rocksdb::WriteBatch writeBatch_;
   size_t bufSize_;
@@ -185,9 +305,11 @@ void RocksDbWriteBatch::flushIfNeeded() {
 }
 
 RocksDbWriteBatch::RocksDbWriteBatch(
+    const RocksDbLocalStore& store,
     Synchronized<RocksHandles>::ConstRLockedPtr&& dbHandles,
     size_t bufSize)
     : LocalStore::WriteBatch(),
+      store_(store),
       lockedDB_(std::move(dbHandles)),
       writeBatch_(bufSize),
       bufSize_(bufSize) {}
@@ -207,6 +329,7 @@ void RocksDbWriteBatch::put(
       lockedDB_->columns[keySpace->index].get(),
       _createSlice(key),
       _createSlice(value));
+  store_.recordAccess(keySpace, key);
 
   flushIfNeeded();
 }
@@ -227,10 +350,47 @@ void RocksDbWriteBatch::put(
       lockedDB_->columns[keySpace->index].get(),
       keyParts,
       SliceParts(slices.data(), slices.size()));
+  store_.recordAccess(keySpace, key);
 
   flushIfNeeded();
 }
 
+/**
+ * A write batch that hands its writes to the store's WriteCombiner, which
+ * commits them to RocksDB in larger batches.
+ */
+class CombiningWriteBatch : public LocalStore::WriteBatch {
+ public:
+  CombiningWriteBatch(const RocksDbLocalStore& store, WriteCombiner& combiner)
+      : store_{store}, combiner_{combiner} {}
+
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    combiner_.put(keySpace, key, folly::StringPiece{value}.str());
+    store_.recordAccess(keySpace, key);
+  }
+
+  void put(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::vector<folly::ByteRange> valueSlices) override {
+    std::string value;
+    for (auto& valueSlice : valueSlices) {
+      value.append(folly::StringPiece{valueSlice});
+    }
+    combiner_.put(keySpace, key, std::move(value));
+    store_.recordAccess(keySpace, key);
+  }
+
+  void flush() override {
+    // The WriteCombiner commits the writes.
+  }
+
+ private:
+  const RocksDbLocalStore& store_;
+  WriteCombiner& combiner_;
+};
+
 rocksdb::Options getRocksdbOptions() {
   rocksdb::Options options;
   // Optimize RocksDB. This is the easiest way to get RocksDB to perform well.
@@ -282,10 +442,29 @@ RocksDbLocalStore::RocksDbLocalStore(
       faultInjector_(*faultInjector),
       ioPool_(12, "RocksLocalStore"),
       dbHandles_(folly::in_place, openDB(pathToRocksDb, mode)) {
+  for (const auto& ks : KeySpace::kAll) {
+    if (std::holds_alternative<Ephemeral>(ks->persistence)) {
+      accessTrackers_[ks->index] = std::make_unique<KeyAccessTracker>(
+          kLruGcNumBuckets, kLruGcBucketDuration, kLruGcMaxKeysPerBucket);
+    }
+  }
+  writeCombiner_ = std::make_unique<WriteCombiner>(
+      [this](const WriteCombiner::Batch& batch) {
+        commitCombinedWrites(batch);
+      },
+      kWriteCombiningBatchBytes,
+      kWriteCombiningInterval);
   // Publish fb303 stats once when we first open the DB.
   // These will be kept up-to-date later by the periodicManagementTask() call.
   computeStats(/*publish=*/true, /*config=*/nullptr);
   clearDeprecatedKeySpaces();
+
+  auto handles = getHandles();
+  std::unique_ptr<rocksdb::Iterator> it{handles->db->NewIterator(
+      ReadOptions(),
+      handles->columns[KeySpace::LocalityFamily.index].get())};
+  it->SeekToFirst();
+  hasRepackedObjects_.store(it->Valid(), std::memory_order_relaxed);
 }
 
 RocksDbLocalStore::~RocksDbLocalStore() {
@@ -293,6 +472,14 @@ RocksDbLocalStore::~RocksDbLocalStore() {
 }
 
 void RocksDbLocalStore::close() {
+  // Commit the buffered writes while the DB is still open.
+  try {
+    writeCombiner_->stop();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "lost buffered writes when closing the local store: "
+              << ex.what();
+  }
+
   // Acquire dbHandles_ in write-lock mode.
   // Since any other access to the DB acquires a read lock this will block until
   // all current DB operations are complete.
@@ -320,6 +507,8 @@ void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
 }
 
 void RocksDbLocalStore::clearKeySpace(KeySpace keySpace) {
+  // Buffered writes must not reappear once the key space is cleared.
+  writeCombiner_->flush();
   auto handles = getHandles();
   auto columnFamily = handles->columns[keySpace->index].get();
   std::unique_ptr<rocksdb::Iterator> it{
@@ -374,8 +563,27 @@ void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
   }
 }
 
+void RocksDbLocalStore::recordAccess(KeySpace keySpace, folly::ByteRange key)
+    const {
+  if (!lruGcEnabled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (auto& tracker = accessTrackers_[keySpace->index]) {
+    tracker->recordAccess(key);
+  }
+}
+
 StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
   auto handles = getHandles();
+  if (lruGcEnabled_.load(std::memory_order_relaxed)) {
+    readCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Check the buffered writes before RocksDB, so that a write committed in
+  // between is found in RocksDB.
+  if (auto buffered = writeCombiner_->get(keySpace, key)) {
+    recordAccess(keySpace, key);
+    return StoreResult(std::move(*buffered));
+  }
   string value;
   auto status = handles->db->Get(
       ReadOptions(),
@@ -384,6 +592,9 @@ StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
       &value);
   if (!status.ok()) {
     if (status.IsNotFound()) {
+      if (auto repacked = getRepacked(*handles, keySpace, key)) {
+        return StoreResult(std::move(*repacked));
+      }
       // Return an empty StoreResult
       return StoreResult::missing(keySpace, key);
     }
@@ -396,6 +607,7 @@ StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
     throw RocksException::build(
         status, "failed to get ", folly::hexlify(key), " from local store");
   }
+  recordAccess(keySpace, key);
   return StoreResult(std::move(value));
 }
 
@@ -425,47 +637,108 @@ FOLLY_NODISCARD folly::Future<std::vector<StoreResult>>
 RocksDbLocalStore::getBatch(
     KeySpace keySpace,
     const std::vector<folly::ByteRange>& keys) const {
-  std::vector<folly::Future<std::vector<StoreResult>>> futures;
-
-  std::vector<std::shared_ptr<std::vector<std::string>>> batches;
-  batches.emplace_back(std::make_shared<std::vector<std::string>>());
+  if (keys.empty()) {
+    return folly::makeFuture(std::vector<StoreResult>{});
+  }
 
-  for (auto& key : keys) {
-    if (batches.back()->size() >= 2048) {
-      batches.emplace_back(std::make_shared<std::vector<std::string>>());
+  // RocksDB's batched MultiGet is fastest when the keys are sorted, since it
+  // can then walk each SST block once for all the keys it contains. Sort the
+  // keys, remembering where each one came from, and split them into
+  // contiguous ranges that are looked up in parallel on the I/O pool.
+  using IndexedKey = std::pair<std::string, size_t>;
+  using IndexedResults = std::vector<std::pair<size_t, StoreResult>>;
+  auto sortedKeys = std::make_shared<std::vector<IndexedKey>>();
+  sortedKeys->reserve(keys.size());
+  // Buffered writes are looked up before RocksDB is read, so that a write
+  // committed in between is found in RocksDB.
+  IndexedResults buffered;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (auto value = writeCombiner_->get(keySpace, keys[i])) {
+      recordAccess(keySpace, keys[i]);
+      buffered.emplace_back(i, StoreResult{std::move(*value)});
+      continue;
     }
-    batches.back()->emplace_back(
-        reinterpret_cast<const char*>(key.data()), key.size());
+    sortedKeys->emplace_back(
+        std::string{
+            reinterpret_cast<const char*>(keys[i].data()), keys[i].size()},
+        i);
+  }
+  std::sort(sortedKeys->begin(), sortedKeys->end());
+
+  // All ranges read from the same snapshot so that the batch as a whole is
+  // consistent, even though it is spread across several MultiGet calls.
+  std::shared_ptr<const rocksdb::Snapshot> snapshot;
+  if (sortedKeys->size() > kMultiGetBatchSize) {
+    auto handles = getHandles();
+    snapshot = std::shared_ptr<const rocksdb::Snapshot>(
+        handles->db->GetSnapshot(),
+        [store = getSharedFromThis()](const rocksdb::Snapshot* snap) {
+          auto handles = store->dbHandles_.rlock();
+          if (handles->db) {
+            handles->db->ReleaseSnapshot(snap);
+          }
+        });
   }
 
-  for (auto& batch : batches) {
+  std::vector<folly::Future<IndexedResults>> futures;
+  for (size_t begin = 0; begin < sortedKeys->size();
+       begin += kMultiGetBatchSize) {
+    auto end = std::min(begin + kMultiGetBatchSize, sortedKeys->size());
     futures.emplace_back(
         faultInjector_.checkAsync("local store get batch", "")
             .via(&ioPool_)
             .thenValue([store = getSharedFromThis(),
                         keySpace,
-                        keys = std::move(batch)](folly::Unit&&) {
+                        sortedKeys,
+                        snapshot,
+                        begin,
+                        end](folly::Unit&&) {
               XLOG(DBG3) << __func__ << " starting to actually do work";
               auto handles = store->getHandles();
+              auto count = end - begin;
+              if (store->lruGcEnabled_.load(std::memory_order_relaxed)) {
+                store->readCount_.fetch_add(1, std::memory_order_relaxed);
+              }
               std::vector<Slice> keySlices;
-              std::vector<std::string> values;
-              std::vector<rocksdb::ColumnFamilyHandle*> columns;
-              for (auto& key : *keys) {
-                keySlices.emplace_back(key);
-                columns.emplace_back(handles->columns[keySpace->index].get());
+              keySlices.reserve(count);
+              for (size_t i = begin; i < end; ++i) {
+                keySlices.emplace_back((*sortedKeys)[i].first);
               }
-              auto statuses = handles->db->MultiGet(
-                  ReadOptions(), columns, keySlices, &values);
-
-              std::vector<StoreResult> results;
-              for (size_t i = 0; i < keys->size(); ++i) {
+              std::vector<rocksdb::PinnableSlice> values(count);
+              std::vector<rocksdb::Status> statuses(count);
+
+              ReadOptions readOptions;
+              readOptions.snapshot = snapshot.get();
+              handles->db->MultiGet(
+                  readOptions,
+                  handles->columns[keySpace->index].get(),
+                  count,
+                  keySlices.data(),
+                  values.data(),
+                  statuses.data(),
+                  /*sorted_input=*/true);
+
+              IndexedResults results;
+              results.reserve(count);
+              for (size_t i = 0; i < count; ++i) {
+                auto& [key, index] = (*sortedKeys)[begin + i];
                 auto& status = statuses[i];
                 if (!status.ok()) {
                   if (status.IsNotFound()) {
+                    if (auto repacked = store->getRepacked(
+                            *handles,
+                            keySpace,
+                            folly::ByteRange{folly::StringPiece{key}})) {
+                      results.emplace_back(
+                          index, StoreResult{std::move(*repacked)});
+                      continue;
+                    }
                     // Return an empty StoreResult
-                    results.push_back(StoreResult::missing(
-                        keySpace,
-                        folly::ByteRange{folly::StringPiece{keys->at(i)}}));
+                    results.emplace_back(
+                        index,
+                        StoreResult::missing(
+                            keySpace,
+                            folly::ByteRange{folly::StringPiece{key}}));
                     continue;
                   }
 
@@ -479,23 +752,32 @@ RocksDbLocalStore::getBatch(
                   throw RocksException::build(
                       status,
                       "failed to get ",
-                      folly::hexlify(keys->at(i)),
+                      folly::hexlify(key),
                       " from local store");
                 }
-                results.emplace_back(std::move(values[i]));
+                store->recordAccess(
+                    keySpace, folly::ByteRange{folly::StringPiece{key}});
+                results.emplace_back(index, StoreResult{values[i].ToString()});
               }
               return results;
             }));
   }
 
   return folly::collectUnsafe(futures).thenValue(
-      [](std::vector<std::vector<StoreResult>>&& tries) {
+      [count = keys.size(), buffered = std::move(buffered)](
+          std::vector<IndexedResults>&& batches) mutable {
+        // Put the results back in the order the keys were requested in.
+        std::vector<std::optional<StoreResult>> ordered(count);
+        batches.push_back(std::move(buffered));
+        for (auto& batch : batches) {
+          for (auto& [index, result] : batch) {
+            ordered[index].emplace(std::move(result));
+          }
+        }
         std::vector<StoreResult> results;
-        for (auto& batch : tries) {
-          results.insert(
-              results.end(),
-              make_move_iterator(batch.begin()),
-              make_move_iterator(batch.end()));
+        results.reserve(count);
+        for (auto& result : ordered) {
+          results.push_back(std::move(*result));
         }
         return results;
       });
@@ -504,6 +786,9 @@ RocksDbLocalStore::getBatch(
 bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
   string value;
   auto handles = getHandles();
+  if (writeCombiner_->contains(keySpace, key)) {
+    return true;
+  }
   auto status = handles->db->Get(
       ReadOptions(),
       handles->columns[keySpace->index].get(),
@@ -511,7 +796,7 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
       &value);
   if (!status.ok()) {
     if (status.IsNotFound()) {
-      return false;
+      return getRepacked(*handles, keySpace, key).has_value();
     }
 
     // TODO: RocksDB can return a "TryAgain" error.
@@ -527,19 +812,61 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
 
 std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginWrite(
     size_t bufSize) {
-  return std::make_unique<RocksDbWriteBatch>(getHandles(), bufSize);
+  if (writeCombining_.load(std::memory_order_relaxed)) {
+    // Fail like RocksDbWriteBatch if the store is closed.
+    getHandles();
+    return std::make_unique<CombiningWriteBatch>(*this, *writeCombiner_);
+  }
+  return std::make_unique<RocksDbWriteBatch>(*this, getHandles(), bufSize);
 }
 
 void RocksDbLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  if (writeCombining_.load(std::memory_order_relaxed)) {
+    // Fail like a direct write if the store is closed, but don't hold the
+    // handles while waiting for the WriteCombiner to make room.
+    getHandles();
+    writeCombiner_->put(keySpace, key, folly::StringPiece{value}.str());
+    recordAccess(keySpace, key);
+    return;
+  }
   auto handles = getHandles();
   handles->db->Put(
       WriteOptions(),
       handles->columns[keySpace->index].get(),
       _createSlice(key),
       _createSlice(value));
+  recordAccess(keySpace, key);
+}
+
+std::vector<std::string> RocksDbLocalStore::listKeys(
+    KeySpace keySpace,
+    size_t limit,
+    folly::StringPiece startAfter) const {
+  auto handles = getHandles();
+  // Listing keys touches every block of the column once; don't let it evict
+  // the blocks foreground reads are using.
+  ReadOptions readOptions;
+  readOptions.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> it{handles->db->NewIterator(
+      readOptions, handles->columns[keySpace->index].get())};
+  if (startAfter.empty()) {
+    it->SeekToFirst();
+  } else {
+    auto start = _createSlice(folly::ByteRange{startAfter});
+    it->Seek(start);
+    if (it->Valid() && it->key() == start) {
+      it->Next();
+    }
+  }
+  std::vector<std::string> keys;
+  for (; it->Valid() && keys.size() < limit; it->Next()) {
+    keys.push_back(it->key().ToString());
+  }
+  RocksException::check(it->status(), "error listing keys in local store");
+  return keys;
 }
 
 uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
@@ -587,31 +914,128 @@ uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
   return size;
 }
 
+size_t RocksDbLocalStore::estimateMemoryUsage() const {
+  auto handles = dbHandles_.rlock();
+  if (!handles->db) {
+    // The store was closed.
+    return 0;
+  }
+  uint64_t total = writeCombiner_->getBufferedBytes();
+  uint64_t value;
+  for (const auto& property :
+       {rocksdb::DB::Properties::kSizeAllMemTables,
+        rocksdb::DB::Properties::kEstimateTableReadersMem}) {
+    if (handles->db->GetAggregatedIntProperty(property, &value)) {
+      total += value;
+    }
+  }
+
+  // Every key space with a shared block cache reports the usage of the same
+  // cache, so only count it once.
+  bool countedSharedCache = false;
+  for (auto& ks : KeySpace::kAll) {
+    if (ks->tuning.blockCache == KeySpaceTuning::BlockCache::Shared) {
+      if (countedSharedCache) {
+        continue;
+      }
+      countedSharedCache = true;
+    }
+    if (handles->db->GetIntProperty(
+            handles->columns[ks->index].get(),
+            rocksdb::DB::Properties::kBlockCacheUsage,
+            &value)) {
+      total += value;
+    }
+  }
+  return total;
+}
+
+void RocksDbLocalStore::configureWriteCombining(
+    bool enabled,
+    size_t maxBatchBytes,
+    std::chrono::nanoseconds flushInterval) {
+  writeCombiner_->setLimits(maxBatchBytes, flushInterval);
+  if (!writeCombining_.exchange(enabled, std::memory_order_relaxed) ||
+      enabled) {
+    return;
+  }
+  // Writes made from now on go straight to RocksDB; commit the older ones
+  // now rather than after the flush interval.
+  writeCombiner_->flush();
+}
+
+void RocksDbLocalStore::commitCombinedWrites(
+    const WriteCombiner::Batch& batch) {
+  auto handles = getHandles();
+  rocksdb::WriteBatch writeBatch;
+  for (const auto& ks : KeySpace::kAll) {
+    auto* column = handles->columns[ks->index].get();
+    for (const auto& [key, value] : batch[ks->index]) {
+      writeBatch.Put(column, key, value);
+    }
+  }
+  XLOG(DBG5) << "Committing " << writeBatch.Count()
+             << " buffered writes with data size of "
+             << writeBatch.GetDataSize();
+  // Like every other write, this appends to the WAL without syncing it.
+  auto status = handles->db->Write(WriteOptions(), &writeBatch);
+  if (!status.ok()) {
+    throw RocksException::build(
+        status, "error committing buffered writes to local store");
+  }
+}
+
 void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
   enableBlobCaching.store(
       config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  configureWriteCombining(
+      config.localStoreWriteCombining.getValue(),
+      config.localStoreWriteCombiningBatchSize.getValue(),
+      config.localStoreWriteCombiningInterval.getValue());
+  lruGcEnabled_.store(
+      config.localStoreLruGc.getValue(), std::memory_order_relaxed);
 
   // Compute and publish the stats
-  auto before = computeStats(/*publish=*/true, &config);
+  computeStats(/*publish=*/true, &config);
+}
 
-  // If any ephemeral column's size is more than its configured limit,
-  // trigger garbage collection.
-  if (before.excessiveKeySpaces.any()) {
-    std::string keySpaceNames;
+folly::SemiFuture<folly::Unit> RocksDbLocalStore::garbageCollect(
+    const EdenConfig& config,
+    const folly::CancellationToken& cancel) {
+  // Only collect when an ephemeral column's size is more than its configured
+  // limit.
+  auto before = computeStats(/*publish=*/false, &config);
+  if (!before.excessiveKeySpaces.any()) {
+    return folly::unit;
+  }
+
+  std::string keySpaceNames;
+  for (auto& ks : KeySpace::kAll) {
+    if (before.excessiveKeySpaces.test(ks->index)) {
+      if (!keySpaceNames.empty()) {
+        keySpaceNames.push_back(',');
+      }
+      keySpaceNames.append(ks->name.str());
+    }
+  }
+  XLOG(INFO) << "scheduling automatic local store garbage collection: "
+             << "ephemeral data sizes of columns " << keySpaceNames
+             << " exceed their limits; total ephemeral size = "
+             << before.ephemeral;
+
+  std::optional<LruGcOptions> lruOptions;
+  std::array<uint64_t, KeySpace::kTotalCount> sizeLimits{};
+  if (config.localStoreLruGc.getValue()) {
+    lruOptions = LruGcOptions{
+        config.localStoreLruGcBatchSize.getValue(),
+        config.localStoreLruGcBatchInterval.getValue()};
     for (auto& ks : KeySpace::kAll) {
-      if (before.excessiveKeySpaces.test(ks->index)) {
-        if (!keySpaceNames.empty()) {
-          keySpaceNames.push_back(',');
-        }
-        keySpaceNames.append(ks->name.str());
+      if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
+        sizeLimits[ks->index] = (config.*(ephemeral->cacheLimit)).getValue();
       }
     }
-    XLOG(INFO) << "scheduling automatic local store garbage collection: "
-               << "ephemeral data sizes of columns " << keySpaceNames
-               << " exceed their limits; total ephemeral size = "
-               << before.ephemeral;
-    triggerAutoGC(before);
   }
+  return triggerAutoGC(before, lruOptions, sizeLimits, cancel);
 }
 
 RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
@@ -655,7 +1079,11 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
 // code, but the gc operation can take a significant amount of time, and it
 // seems unfortunate to tie up one of the main pool threads for potentially
 // multiple minutes.
-void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
+folly::SemiFuture<folly::Unit> RocksDbLocalStore::triggerAutoGC(
+    SizeSummary before,
+    std::optional<LruGcOptions> lruOptions,
+    std::array<uint64_t, KeySpace::kTotalCount> sizeLimits,
+    folly::CancellationToken cancel) {
   {
     auto state = autoGCState_.wlock();
     if (state->inProgress_) {
@@ -663,7 +1091,7 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
                     "another GC job is still running";
       fb303::fbData->incrementCounter(
           folly::to<string>(statsPrefix_, "auto_gc.schedule_failure"));
-      return;
+      return folly::unit;
     }
     fb303::fbData->setCounter(
         folly::to<string>(statsPrefix_, "auto_gc.running"), 1);
@@ -674,11 +1102,31 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
     state->inProgress_ = true;
   }
 
-  ioPool_.add([store = getSharedFromThis(), before] {
+  auto [promise, future] = folly::makePromiseContract<folly::Unit>();
+  ioPool_.add([store = getSharedFromThis(),
+               before,
+               lruOptions,
+               sizeLimits,
+               cancel = std::move(cancel),
+               promise = std::move(promise)]() mutable {
+    SCOPE_EXIT {
+      promise.setValue();
+    };
     try {
       for (auto& ks : KeySpace::kAll) {
+        if (cancel.isCancellationRequested()) {
+          XLOG(INFO) << "local store garbage collection stopped early";
+          break;
+        }
         if (before.excessiveKeySpaces.test(ks->index)) {
-          store->clearKeySpace(ks);
+          if (lruOptions) {
+            auto evicted = store->evictLeastRecentlyUsed(
+                ks, sizeLimits[ks->index], *lruOptions, cancel);
+            XLOG(INFO) << "evicted " << evicted
+                       << " least recently used keys from " << ks->name;
+          } else {
+            store->clearKeySpace(ks);
+          }
           store->compactKeySpace(ks);
         }
       }
@@ -690,6 +1138,131 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
     }
     store->autoGCFinished(/*successful=*/true, before.ephemeral);
   });
+  return std::move(future);
+}
+
+template <typename Fn>
+void RocksDbLocalStore::forEachKeyChunkThrottled(
+    KeySpace keySpace,
+    const LruGcOptions& options,
+    const folly::CancellationToken& cancel,
+    Fn&& fn) {
+  auto batchSize = std::max<size_t>(options.batchSize, 1);
+  auto pause = options.batchInterval;
+  auto lastReadCount = readCount_.load(std::memory_order_relaxed);
+  std::string lastKey;
+  while (!cancel.isCancellationRequested()) {
+    auto keys = listKeys(keySpace, batchSize, lastKey);
+    if (keys.empty()) {
+      return;
+    }
+    lastKey = keys.back();
+    fn(keys);
+    if (keys.size() < batchSize) {
+      return;
+    }
+
+    // Back off while foreground reads are happening, and return to the
+    // configured pace once they stop.
+    auto readCount = readCount_.load(std::memory_order_relaxed);
+    if (readCount != lastReadCount) {
+      pause = std::min<std::chrono::nanoseconds>(
+          std::max<std::chrono::nanoseconds>(
+              pause * 2, std::chrono::milliseconds{1}),
+          kLruGcMaxPause);
+    } else {
+      pause = options.batchInterval;
+    }
+    lastReadCount = readCount;
+    std::this_thread::sleep_for(pause);
+  }
+}
+
+uint64_t RocksDbLocalStore::evictLeastRecentlyUsed(
+    KeySpace keySpace,
+    uint64_t sizeLimit,
+    const LruGcOptions& options,
+    const folly::CancellationToken& cancel) {
+  auto& tracker = accessTrackers_[keySpace->index];
+  if (!tracker) {
+    XLOG(WARN) << "not evicting keys from non-ephemeral column "
+               << keySpace->name;
+    return 0;
+  }
+
+  auto size = getApproximateSize(keySpace);
+  auto target = static_cast<uint64_t>(sizeLimit * kLruGcTargetRatio);
+  if (size == 0 || size <= target) {
+    return 0;
+  }
+
+  // Ages are computed against a fixed time so that both passes agree. Keys
+  // accessed in between look younger than the cutoff and are kept.
+  auto now = KeyAccessTracker::Clock::now();
+
+  // First pass: how many keys are there of each age?
+  std::vector<uint64_t> keysPerAge(tracker->getNumBuckets() + 1);
+  uint64_t numKeys = 0;
+  forEachKeyChunkThrottled(
+      keySpace, options, cancel, [&](const std::vector<std::string>& keys) {
+        for (const auto& key : keys) {
+          ++keysPerAge[tracker->getAge(
+              folly::ByteRange{folly::StringPiece{key}}, now)];
+        }
+        numKeys += keys.size();
+      });
+
+  // Assume keys are of similar size, and pick the oldest ones until enough
+  // are selected. Keys accessed during the current bucket are always kept.
+  auto toDelete = static_cast<uint64_t>(
+      numKeys * (static_cast<double>(size - target) / size));
+  size_t cutoffAge = keysPerAge.size();
+  uint64_t toDeleteAtCutoff = 0;
+  uint64_t selected = 0;
+  for (size_t age = keysPerAge.size() - 1; age > 0 && selected < toDelete;
+       --age) {
+    auto take = std::min(keysPerAge[age], toDelete - selected);
+    if (take > 0) {
+      selected += take;
+      cutoffAge = age;
+      toDeleteAtCutoff = take;
+    }
+  }
+  // Deleting based on an incomplete count could delete too much.
+  if (selected == 0 || cancel.isCancellationRequested()) {
+    return 0;
+  }
+
+  // Second pass: delete the selected keys.
+  uint64_t deleted = 0;
+  uint64_t deletedAtCutoff = 0;
+  forEachKeyChunkThrottled(
+      keySpace, options, cancel, [&](const std::vector<std::string>& keys) {
+        auto handles = getHandles();
+        rocksdb::WriteBatch batch;
+        for (const auto& key : keys) {
+          auto age =
+              tracker->getAge(folly::ByteRange{folly::StringPiece{key}}, now);
+          if (age < cutoffAge ||
+              (age == cutoffAge && deletedAtCutoff++ >= toDeleteAtCutoff)) {
+            continue;
+          }
+          batch.Delete(handles->columns[keySpace->index].get(), key);
+        }
+        if (batch.Count() == 0) {
+          return;
+        }
+        WriteOptions writeOptions;
+        writeOptions.low_pri = true;
+        RocksException::check(
+            handles->db->Write(writeOptions, &batch),
+            "error deleting least recently used keys from local store");
+        deleted += batch.Count();
+      });
+
+  fb303::fbData->incrementCounter(
+      folly::to<string>(statsPrefix_, "auto_gc.evicted_keys"), deleted);
+  return deleted;
 }
 
 void RocksDbLocalStore::autoGCFinished(
@@ -732,6 +1305,176 @@ void RocksDbLocalStore::autoGCFinished(
   }
 }
 
+std::optional<std::string> RocksDbLocalStore::getRepacked(
+    const RocksHandles& handles,
+    KeySpace keySpace,
+    ByteRange key) const {
+  if (!hasRepackedObjects_.load(std::memory_order_relaxed) ||
+      (keySpace->index != KeySpace::BlobFamily.index &&
+       keySpace->index != KeySpace::TreeFamily.index)) {
+    return std::nullopt;
+  }
+  auto* column = handles.columns[KeySpace::LocalityFamily.index].get();
+  auto indexKey = makeLocalityIndexKey(keySpace, key);
+  string dataKey;
+  auto status = handles.db->Get(ReadOptions(), column, indexKey, &dataKey);
+  string value;
+  if (status.ok()) {
+    status = handles.db->Get(ReadOptions(), column, dataKey, &value);
+  }
+  if (!status.ok()) {
+    if (status.IsNotFound()) {
+      return std::nullopt;
+    }
+    throw RocksException::build(
+        status,
+        "failed to get repacked ",
+        folly::hexlify(key),
+        " from local store");
+  }
+  recordAccess(
+      KeySpace::LocalityFamily, folly::ByteRange{folly::StringPiece{indexKey}});
+  recordAccess(
+      KeySpace::LocalityFamily, folly::ByteRange{folly::StringPiece{dataKey}});
+  return value;
+}
+
+RocksDbLocalStore::RepackStats RocksDbLocalStore::repackForLocality(
+    size_t batchSize) {
+  writeCombiner_->flush();
+  batchSize = std::max<size_t>(batchSize, 1);
+
+  // The walk starts from the trees that no other cached tree refers to.
+  std::vector<ObjectId> trees;
+  folly::F14FastSet<ObjectId> subtrees;
+  std::string lastKey;
+  for (;;) {
+    auto keys = listKeys(KeySpace::TreeFamily, batchSize, lastKey);
+    if (keys.empty()) {
+      break;
+    }
+    lastKey = keys.back();
+    for (const auto& key : keys) {
+      auto id = ObjectId{ByteRange{folly::StringPiece{key}}};
+      if (auto tree = getTree(id).get()) {
+        for (const auto& entry : tree->getTreeEntries()) {
+          if (entry.isTree()) {
+            subtrees.insert(entry.getHash());
+          }
+        }
+      }
+      trees.push_back(std::move(id));
+    }
+  }
+
+  // Objects repacked by a previous run keep their place, and the new ones
+  // are stored after them.
+  uint64_t position = 0;
+  {
+    auto handles = getHandles();
+    std::unique_ptr<rocksdb::Iterator> it{handles->db->NewIterator(
+        ReadOptions(),
+        handles->columns[KeySpace::LocalityFamily.index].get())};
+    auto lastDataKey =
+        makeLocalityDataKey(std::numeric_limits<uint64_t>::max());
+    it->SeekForPrev(lastDataKey);
+    if (it->Valid() && it->key().size() == lastDataKey.size() &&
+        it->key()[0] == kLocalityDataPrefix) {
+      uint64_t bigEndian;
+      std::memcpy(&bigEndian, it->key().data() + 1, sizeof(bigEndian));
+      position = folly::Endian::big(bigEndian) + 1;
+    }
+    RocksException::check(it->status(), "error reading locality key space");
+  }
+  hasRepackedObjects_.store(true, std::memory_order_relaxed);
+
+  RepackStats stats;
+  rocksdb::WriteBatch batch;
+  auto commit = [&] {
+    if (batch.Count() == 0) {
+      return;
+    }
+    auto handles = getHandles();
+    RocksException::check(
+        handles->db->Write(WriteOptions(), &batch),
+        "error writing repacked objects to local store");
+    batch.Clear();
+  };
+  // Returns whether the object was found in `keySpace` and moved.
+  auto move = [&](KeySpace keySpace, const ObjectId& id) {
+    auto handles = getHandles();
+    auto* column = handles->columns[keySpace->index].get();
+    auto key = _createSlice(id.getBytes());
+    string value;
+    auto status = handles->db->Get(ReadOptions(), column, key, &value);
+    if (!status.ok()) {
+      if (status.IsNotFound()) {
+        return false;
+      }
+      throw RocksException::build(
+          status,
+          "failed to get ",
+          folly::hexlify(id.getBytes()),
+          " from local store");
+    }
+    auto* locality = handles->columns[KeySpace::LocalityFamily.index].get();
+    auto dataKey = makeLocalityDataKey(position++);
+    batch.Put(locality, dataKey, value);
+    batch.Put(locality, makeLocalityIndexKey(keySpace, id.getBytes()), dataKey);
+    batch.Delete(column, key);
+    stats.bytes += value.size();
+    return true;
+  };
+
+  folly::F14FastSet<ObjectId> visited;
+  std::vector<ObjectId> stack;
+  for (const auto& root : trees) {
+    if (subtrees.count(root)) {
+      continue;
+    }
+    stack.push_back(root);
+    while (!stack.empty()) {
+      auto id = std::move(stack.back());
+      stack.pop_back();
+      if (!visited.insert(id).second) {
+        continue;
+      }
+      auto tree = getTree(id).get();
+      if (!tree) {
+        continue;
+      }
+      if (move(KeySpace::TreeFamily, id)) {
+        ++stats.trees;
+      }
+      const auto& entries = tree->getTreeEntries();
+      for (const auto& entry : entries) {
+        if (!entry.isTree() && visited.insert(entry.getHash()).second &&
+            move(KeySpace::BlobFamily, entry.getHash())) {
+          ++stats.blobs;
+        }
+      }
+      // Subdirectories are pushed in reverse so that they are walked in name
+      // order.
+      for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (it->isTree()) {
+          stack.push_back(it->getHash());
+        }
+      }
+      if (batch.GetDataSize() >= kRepackWriteBatchBytes) {
+        commit();
+      }
+    }
+  }
+  commit();
+
+  // Drop the moved keys from the SST files of their key spaces, and write
+  // the locality key space out in order.
+  compactKeySpace(KeySpace::TreeFamily);
+  compactKeySpace(KeySpace::BlobFamily);
+  compactKeySpace(KeySpace::LocalityFamily);
+  return stats;
+}
+
 void RocksDbLocalStore::throwStoreClosedError() const {
   // It might be nicer to throw an EdenError exception here.
   // At the moment we don't simply due to library dependency ordering in the
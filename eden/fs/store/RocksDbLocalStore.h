@@ -7,12 +7,19 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/CppAttributes.h>
 #include <folly/Synchronized.h>
+#include <array>
+#include <atomic>
 #include <bitset>
+#include <chrono>
+#include <optional>
 
 #include "eden/fs/rocksdb/RocksHandles.h"
+#include "eden/fs/store/KeyAccessTracker.h"
 #include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/WriteCombiner.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace facebook::eden {
@@ -57,7 +64,89 @@ class RocksDbLocalStore : public LocalStore {
   // specified key space.
   uint64_t getApproximateSize(KeySpace keySpace) const;
 
+  // Return up to limit keys from the specified key space, in key order,
+  // starting after `startAfter` if it is not empty. Intended for diagnostic
+  // and benchmarking tools.
+  std::vector<std::string> listKeys(
+      KeySpace keySpace,
+      size_t limit,
+      folly::StringPiece startAfter = {}) const;
+
+  struct RepackStats {
+    size_t trees = 0;
+    size_t blobs = 0;
+    uint64_t bytes = 0;
+  };
+
+  /**
+   * Move the cached trees and blobs into the locality key space, in the
+   * order of a depth-first walk of the trees: each tree is followed by its
+   * files, then by its subdirectories. As RocksDB stores keys in order, the
+   * objects of a directory then end up next to each other on disk instead of
+   * scattered by hash, and a cold scan of a directory reads mostly
+   * sequentially.
+   *
+   * The walk starts from the trees no other cached tree refers to. Objects
+   * it does not reach stay where they are. get() finds moved objects through
+   * the index kept in the locality key space.
+   *
+   * This reads every cached tree and is only meant to be run offline, by
+   * eden_store_util.
+   */
+  RepackStats repackForLocality(size_t batchSize);
+
   void periodicManagementTask(const EdenConfig& config) override;
+  folly::SemiFuture<folly::Unit> garbageCollect(
+      const EdenConfig& config,
+      const folly::CancellationToken& cancel) override;
+
+  /**
+   * Buffer put() and beginWrite() writes in a WriteCombiner and commit them
+   * in batches of up to `maxBatchBytes` at least every `flushInterval`,
+   * instead of writing them to RocksDB as they come. Disabling commits
+   * everything buffered so far. This is normally configured from
+   * `store:write-combining` by periodicManagementTask().
+   */
+  void configureWriteCombining(
+      bool enabled,
+      size_t maxBatchBytes,
+      std::chrono::nanoseconds flushInterval);
+
+  /**
+   * The memory RocksDB reports for its memtables, the indexes and filters of
+   * open SST files, and the block caches.
+   */
+  size_t estimateMemoryUsage() const override;
+
+  /**
+   * Note that `key` in `keySpace` was just read or written, for least
+   * recently used garbage collection. Does nothing unless
+   * `store:lru-gc` is enabled.
+   */
+  void recordAccess(KeySpace keySpace, folly::ByteRange key) const;
+
+  struct LruGcOptions {
+    /// Number of keys scanned, and at most deleted, per step.
+    size_t batchSize;
+    /// Pause between steps, doubled while foreground reads are happening.
+    std::chrono::nanoseconds batchInterval;
+  };
+
+  /**
+   * Delete the least recently accessed keys of `keySpace` until its size is
+   * estimated to be comfortably below `sizeLimit`. Keys accessed within the
+   * current access-time bucket are never deleted. Returns the number of
+   * keys deleted.
+   *
+   * This runs in small throttled steps so that it does not compete with
+   * foreground reads, and can take a long time. It stops between steps once
+   * cancellation of `cancel` is requested.
+   */
+  uint64_t evictLeastRecentlyUsed(
+      KeySpace keySpace,
+      uint64_t sizeLimit,
+      const LruGcOptions& options,
+      const folly::CancellationToken& cancel = {});
 
  private:
   /**
@@ -76,6 +165,15 @@ class RocksDbLocalStore : public LocalStore {
     return handles;
   }
   [[noreturn]] void throwStoreClosedError() const;
+
+  /**
+   * Look up `key` of `keySpace` in the locality key space, where
+   * repackForLocality() may have moved it.
+   */
+  std::optional<std::string> getRepacked(
+      const RocksHandles& handles,
+      KeySpace keySpace,
+      folly::ByteRange key) const;
   std::shared_ptr<RocksDbLocalStore> getSharedFromThis() {
     return std::static_pointer_cast<RocksDbLocalStore>(shared_from_this());
   }
@@ -111,15 +209,56 @@ class RocksDbLocalStore : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
-  void triggerAutoGC(SizeSummary before);
+  folly::SemiFuture<folly::Unit> triggerAutoGC(
+      SizeSummary before,
+      std::optional<LruGcOptions> lruOptions,
+      std::array<uint64_t, KeySpace::kTotalCount> sizeLimits,
+      folly::CancellationToken cancel);
+
+  /**
+   * Call `fn` with consecutive chunks of the keys of `keySpace`, pausing
+   * between chunks as described by LruGcOptions, until cancellation of
+   * `cancel` is requested.
+   */
+  template <typename Fn>
+  void forEachKeyChunkThrottled(
+      KeySpace keySpace,
+      const LruGcOptions& options,
+      const folly::CancellationToken& cancel,
+      Fn&& fn);
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
+  /**
+   * Commit a batch of buffered writes in a single RocksDB write.
+   */
+  void commitCombinedWrites(const WriteCombiner::Batch& batch);
+
   std::shared_ptr<StructuredLogger> structuredLogger_;
   const std::string statsPrefix_{"local_store."};
   FaultInjector& faultInjector_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
+
+  /**
+   * Access times of the keys of each ephemeral key space, null for the
+   * others.
+   */
+  std::array<std::unique_ptr<KeyAccessTracker>, KeySpace::kTotalCount>
+      accessTrackers_;
+  std::atomic<bool> lruGcEnabled_{false};
+  /// Counts reads, so that garbage collection can back off while they
+  /// happen.
+  mutable std::atomic<uint64_t> readCount_{0};
+
   folly::Synchronized<RocksHandles> dbHandles_;
+
+  std::atomic<bool> writeCombining_{false};
+  /// Whether the locality key space has anything in it, so that misses
+  /// only look there once repackForLocality() has been run.
+  std::atomic<bool> hasRepackedObjects_{false};
+  /// Buffered writes are committed with dbHandles_, so this is declared
+  /// after it.
+  std::unique_ptr<WriteCombiner> writeCombiner_;
 };
 
 } // namespace facebook::eden
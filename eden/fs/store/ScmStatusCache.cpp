@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ScmStatusCache.h"
+
+#include <folly/Conv.h>
+#include <folly/logging/xlog.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <algorithm>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+using apache::thrift::CompactSerializer;
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Returns the tree at `dir` under `root`, or nullptr if there is no
+ * directory at that path.
+ */
+ImmediateFuture<std::shared_ptr<const Tree>> getDirectory(
+    std::shared_ptr<ObjectStore> store,
+    std::shared_ptr<const Tree> root,
+    RelativePath dir,
+    ObjectFetchContext& context) {
+  if (dir.empty()) {
+    return root;
+  }
+  auto parent = dir.dirname().copy();
+  return getDirectory(store, std::move(root), std::move(parent), context)
+      .thenValue(
+          [store, dir = std::move(dir), &context](
+              std::shared_ptr<const Tree> tree)
+              -> ImmediateFuture<std::shared_ptr<const Tree>> {
+            if (!tree) {
+              return std::shared_ptr<const Tree>{};
+            }
+            auto* entry = tree->getEntryPtr(dir.basename());
+            if (!entry || !entry->isTree()) {
+              return std::shared_ptr<const Tree>{};
+            }
+            return store->getTree(entry->getHash(), context);
+          });
+}
+
+/**
+ * Returns the entry for the file (or symlink) at `path` under `root`, or
+ * std::nullopt if there is no file at that path.
+ */
+ImmediateFuture<std::optional<TreeEntry>> getFile(
+    std::shared_ptr<ObjectStore> store,
+    std::shared_ptr<const Tree> root,
+    RelativePath path,
+    ObjectFetchContext& context) {
+  auto dir = path.dirname().copy();
+  return getDirectory(
+             std::move(store), std::move(root), std::move(dir), context)
+      .thenValue([path = std::move(path)](std::shared_ptr<const Tree> tree)
+                     -> std::optional<TreeEntry> {
+        if (!tree) {
+          return std::nullopt;
+        }
+        auto* entry = tree->getEntryPtr(path.basename());
+        if (!entry || entry->isTree()) {
+          return std::nullopt;
+        }
+        return *entry;
+      });
+}
+
+/**
+ * Compare the file at `path` in two roots the same way diffTrees() would,
+ * returning std::nullopt if it did not change.
+ */
+ImmediateFuture<std::optional<ScmFileStatus>> compareFile(
+    std::shared_ptr<ObjectStore> store,
+    std::shared_ptr<const Tree> fromRoot,
+    std::shared_ptr<const Tree> toRoot,
+    RelativePath path,
+    ObjectFetchContext& context) {
+  auto fromFile = getFile(store, std::move(fromRoot), path, context);
+  auto toFile = getFile(store, std::move(toRoot), std::move(path), context);
+  return collectAllSafe(std::move(fromFile), std::move(toFile))
+      .thenValue(
+          [store, &context](std::tuple<
+                            std::optional<TreeEntry>,
+                            std::optional<TreeEntry>>&& files)
+              -> ImmediateFuture<std::optional<ScmFileStatus>> {
+            auto& [fromFile, toFile] = files;
+            if (!fromFile && !toFile) {
+              return std::optional<ScmFileStatus>{};
+            }
+            if (!toFile) {
+              return std::optional<ScmFileStatus>{ScmFileStatus::REMOVED};
+            }
+            if (!fromFile) {
+              return std::optional<ScmFileStatus>{ScmFileStatus::ADDED};
+            }
+            if (fromFile->getType() != toFile->getType()) {
+              return std::optional<ScmFileStatus>{ScmFileStatus::MODIFIED};
+            }
+            if (fromFile->getHash() == toFile->getHash()) {
+              return std::optional<ScmFileStatus>{};
+            }
+            // Different blob IDs may still have the same contents.
+            return collectAllSafe(
+                       store->getBlobSha1(fromFile->getHash(), context),
+                       store->getBlobSha1(toFile->getHash(), context))
+                .thenValue([](std::tuple<Hash20, Hash20>&& sha1s)
+                               -> std::optional<ScmFileStatus> {
+                  if (std::get<0>(sha1s) == std::get<1>(sha1s)) {
+                    return std::nullopt;
+                  }
+                  return ScmFileStatus::MODIFIED;
+                });
+          });
+}
+
+} // namespace
+
+ScmStatusCache::ScmStatusCache(
+    std::shared_ptr<ObjectStore> objectStore,
+    CaseSensitivity caseSensitive)
+    : objectStore_{std::move(objectStore)}, caseSensitive_{caseSensitive} {}
+
+std::string ScmStatusCache::makeKey(const RootId& from, const RootId& to)
+    const {
+  // The case sensitivity affects how entries are paired up during the diff.
+  // Prefixing the length of `from` keeps distinct pairs from colliding.
+  return folly::to<std::string>(
+      caseSensitive_ == CaseSensitivity::Sensitive ? "s" : "i",
+      from.value().size(),
+      ":",
+      from.value(),
+      to.value());
+}
+
+std::optional<ScmStatus> ScmStatusCache::get(
+    const RootId& from,
+    const RootId& to) const {
+  auto key = makeKey(from, to);
+  auto result = objectStore_->getLocalStore()->get(
+      KeySpace::ScmStatusFamily, folly::ByteRange{folly::StringPiece{key}});
+  if (!result.isValid()) {
+    return std::nullopt;
+  }
+  try {
+    return CompactSerializer::deserialize<ScmStatus>(result.asString());
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "ignoring corrupt cached status between " << from << " and "
+               << to << ": " << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+}
+
+void ScmStatusCache::insert(
+    const RootId& from,
+    const RootId& to,
+    const ScmStatus& status) const {
+  if (!status.errors_ref()->empty()) {
+    return;
+  }
+  auto key = makeKey(from, to);
+  auto value = CompactSerializer::serialize<std::string>(status);
+  objectStore_->getLocalStore()->put(
+      KeySpace::ScmStatusFamily,
+      folly::ByteRange{folly::StringPiece{key}},
+      folly::ByteRange{folly::StringPiece{value}});
+}
+
+std::optional<ImmediateFuture<ScmStatus>> ScmStatusCache::compose(
+    const RootId& from,
+    const RootId& via,
+    const RootId& to,
+    ObjectFetchContext& context) const {
+  auto first = get(from, via);
+  if (!first) {
+    return std::nullopt;
+  }
+  auto second = get(via, to);
+  if (!second) {
+    return std::nullopt;
+  }
+
+  std::vector<RelativePath> candidates;
+  for (const auto* status : {&*first, &*second}) {
+    for (const auto& entry : *status->entries_ref()) {
+      candidates.emplace_back(entry.first);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(
+      std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  auto fromTree = ImmediateFuture<std::shared_ptr<const Tree>>{
+      objectStore_->getRootTree(from, context).semi()};
+  auto toTree = ImmediateFuture<std::shared_ptr<const Tree>>{
+      objectStore_->getRootTree(to, context).semi()};
+  return collectAllSafe(std::move(fromTree), std::move(toTree))
+      .thenValue([store = objectStore_,
+                  candidates = std::move(candidates),
+                  &context](std::tuple<
+                            std::shared_ptr<const Tree>,
+                            std::shared_ptr<const Tree>>&& roots) mutable {
+        const auto& [fromRoot, toRoot] = roots;
+        std::vector<ImmediateFuture<std::optional<ScmFileStatus>>> comparisons;
+        comparisons.reserve(candidates.size());
+        for (const auto& path : candidates) {
+          comparisons.push_back(
+              compareFile(store, fromRoot, toRoot, path, context));
+        }
+        return collectAll(std::move(comparisons))
+            .thenValue([candidates = std::move(candidates)](
+                           std::vector<folly::Try<std::optional<ScmFileStatus>>>
+                               results) {
+              ScmStatus status;
+              for (size_t i = 0; i < results.size(); ++i) {
+                auto path = candidates[i].stringPiece().str();
+                if (results[i].hasException()) {
+                  status.errors_ref()->emplace(
+                      std::move(path),
+                      folly::exceptionStr(results[i].exception())
+                          .toStdString());
+                } else if (auto fileStatus = results[i].value()) {
+                  status.entries_ref()->emplace(std::move(path), *fileStatus);
+                }
+              }
+              return status;
+            });
+      });
+}
+
+} // namespace facebook::eden
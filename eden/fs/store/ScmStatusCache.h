@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+
+/**
+ * Remembers the ScmStatus between pairs of source control roots in the
+ * LocalStore's scmstatus key space.
+ *
+ * The status between two roots never changes, so entries are never
+ * invalidated. Like the other ephemeral key spaces, the total size is bounded
+ * by periodic garbage collection (see store:scmstatus-size-limit).
+ */
+class ScmStatusCache {
+ public:
+  ScmStatusCache(
+      std::shared_ptr<ObjectStore> objectStore,
+      CaseSensitivity caseSensitive);
+
+  /**
+   * Returns the cached status between `from` and `to`, or std::nullopt if
+   * there is none.
+   */
+  std::optional<ScmStatus> get(const RootId& from, const RootId& to) const;
+
+  /**
+   * Remember the status between `from` and `to`. Statuses that contain errors
+   * are not cached, since they may be incomplete.
+   */
+  void insert(const RootId& from, const RootId& to, const ScmStatus& status)
+      const;
+
+  /**
+   * Compute the status between `from` and `to` out of the cached statuses
+   * between `from` and `via` and between `via` and `to`.
+   *
+   * A path can only differ between `from` and `to` if it differs in one of
+   * those two statuses, so only the paths they name are looked up and
+   * compared, rather than diffing the two roots in full. Returns std::nullopt
+   * if either status is not cached.
+   */
+  std::optional<ImmediateFuture<ScmStatus>> compose(
+      const RootId& from,
+      const RootId& via,
+      const RootId& to,
+      ObjectFetchContext& context) const;
+
+ private:
+  std::string makeKey(const RootId& from, const RootId& to) const;
+
+  std::shared_ptr<ObjectStore> objectStore_;
+  CaseSensitivity caseSensitive_;
+};
+
+} // namespace facebook::eden
@@ -17,7 +17,7 @@
 namespace facebook::eden {
 
 SerializedBlobMetadata::SerializedBlobMetadata(const BlobMetadata& metadata) {
-  serialize(metadata.sha1, metadata.size);
+  serialize(metadata.sha1, metadata.size, metadata.blake3);
 }
 
 SerializedBlobMetadata::SerializedBlobMetadata(
@@ -27,14 +27,14 @@ SerializedBlobMetadata::SerializedBlobMetadata(
 }
 
 folly::ByteRange SerializedBlobMetadata::slice() const {
-  return folly::ByteRange{data_};
+  return folly::ByteRange{data_.data(), size_};
 }
 
 BlobMetadata SerializedBlobMetadata::parse(
     ObjectId blobID,
     const StoreResult& result) {
   auto bytes = result.bytes();
-  if (bytes.size() != SIZE) {
+  if (bytes.size() != SIZE && bytes.size() != SIZE_WITH_BLAKE3) {
     throw std::invalid_argument(fmt::format(
         "Blob metadata for {} had unexpected size {}. Could not deserialize.",
         blobID,
@@ -48,19 +48,31 @@ BlobMetadata SerializedBlobMetadata::unslice(folly::ByteRange bytes) {
   uint64_t blobSizeBE;
   memcpy(&blobSizeBE, bytes.data(), sizeof(uint64_t));
   bytes.advance(sizeof(uint64_t));
-  auto contentsHash = Hash20{bytes};
-  return BlobMetadata{contentsHash, folly::Endian::big(blobSizeBE)};
+  auto contentsHash = Hash20{bytes.subpiece(0, Hash20::RAW_SIZE)};
+  bytes.advance(Hash20::RAW_SIZE);
+  std::optional<Blake3::Digest> blake3;
+  if (bytes.size() >= Blake3::kDigestSize) {
+    blake3.emplace();
+    memcpy(blake3->data(), bytes.data(), Blake3::kDigestSize);
+  }
+  return BlobMetadata{contentsHash, folly::Endian::big(blobSizeBE), blake3};
 }
 
 void SerializedBlobMetadata::serialize(
     const Hash20& contentsHash,
-    uint64_t blobSize) {
+    uint64_t blobSize,
+    const std::optional<Blake3::Digest>& blake3) {
   uint64_t blobSizeBE = folly::Endian::big(blobSize);
   memcpy(data_.data(), &blobSizeBE, sizeof(uint64_t));
   memcpy(
       data_.data() + sizeof(uint64_t),
       contentsHash.getBytes().data(),
       Hash20::RAW_SIZE);
+  size_ = SIZE;
+  if (blake3) {
+    memcpy(data_.data() + SIZE, blake3->data(), Blake3::kDigestSize);
+    size_ = SIZE_WITH_BLAKE3;
+  }
 }
 
 } // namespace facebook::eden
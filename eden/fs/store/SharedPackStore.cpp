@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SharedPackStore.h"
+
+#include <folly/ExceptionString.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/MemoryMapping.h>
+#include <fmt/format.h>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+
+// A segment is laid out as:
+//   Header
+//   IndexEntry[entryCount], sorted by key space and then key
+//   the keys and values, at the offsets recorded in the index
+// All integers are little endian.
+
+constexpr folly::StringPiece kMagic{"EDENPACK"};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t entryCount;
+};
+static_assert(sizeof(Header) == 16);
+
+struct IndexEntry {
+  uint8_t keySpace;
+  uint8_t reserved[3];
+  uint32_t keyLength;
+  uint64_t keyOffset;
+  uint64_t valueOffset;
+  uint64_t valueLength;
+};
+static_assert(sizeof(IndexEntry) == 32);
+
+int compareKeys(
+    uint8_t keySpace1,
+    folly::ByteRange key1,
+    uint8_t keySpace2,
+    folly::ByteRange key2) {
+  if (keySpace1 != keySpace2) {
+    return keySpace1 < keySpace2 ? -1 : 1;
+  }
+  return key1.compare(key2);
+}
+
+} // namespace
+
+class SharedPackStore::Segment {
+ public:
+  /**
+   * Map and validate the segment at `path`. Throws if it is malformed, so
+   * that lookups don't need to check any offsets.
+   */
+  explicit Segment(AbsolutePathPiece path)
+      : mapping_{path.copy().c_str()}, data_{mapping_.range()} {
+    if (data_.size() < sizeof(Header)) {
+      throw std::runtime_error("truncated header");
+    }
+    Header header;
+    memcpy(&header, data_.data(), sizeof(header));
+    if (folly::StringPiece{header.magic, sizeof(header.magic)} != kMagic) {
+      throw std::runtime_error("bad magic");
+    }
+    if (folly::Endian::little(header.version) != kVersion) {
+      throw std::runtime_error(fmt::format(
+          "unsupported version {}", folly::Endian::little(header.version)));
+    }
+    count_ = folly::Endian::little(header.entryCount);
+    if ((data_.size() - sizeof(Header)) / sizeof(IndexEntry) < count_) {
+      throw std::runtime_error("truncated index");
+    }
+
+    for (uint32_t i = 0; i < count_; ++i) {
+      auto entry = getEntry(i);
+      if (!inBounds(entry.keyOffset, entry.keyLength) ||
+          !inBounds(entry.valueOffset, entry.valueLength)) {
+        throw std::runtime_error(fmt::format("entry {} is out of bounds", i));
+      }
+      if (i > 0) {
+        auto previous = getEntry(i - 1);
+        if (compareKeys(
+                previous.keySpace,
+                getKey(previous),
+                entry.keySpace,
+                getKey(entry)) >= 0) {
+          throw std::runtime_error(fmt::format("entry {} is not sorted", i));
+        }
+      }
+    }
+  }
+
+  std::optional<folly::ByteRange> find(
+      KeySpace keySpace,
+      folly::ByteRange key) const {
+    uint32_t low = 0;
+    uint32_t high = count_;
+    while (low < high) {
+      auto middle = low + (high - low) / 2;
+      auto entry = getEntry(middle);
+      auto comparison =
+          compareKeys(entry.keySpace, getKey(entry), keySpace->index, key);
+      if (comparison == 0) {
+        return data_.subpiece(entry.valueOffset, entry.valueLength);
+      } else if (comparison < 0) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  IndexEntry getEntry(uint32_t i) const {
+    IndexEntry entry;
+    memcpy(
+        &entry,
+        data_.data() + sizeof(Header) + i * sizeof(IndexEntry),
+        sizeof(entry));
+    entry.keyLength = folly::Endian::little(entry.keyLength);
+    entry.keyOffset = folly::Endian::little(entry.keyOffset);
+    entry.valueOffset = folly::Endian::little(entry.valueOffset);
+    entry.valueLength = folly::Endian::little(entry.valueLength);
+    return entry;
+  }
+
+  folly::ByteRange getKey(const IndexEntry& entry) const {
+    return data_.subpiece(entry.keyOffset, entry.keyLength);
+  }
+
+  bool inBounds(uint64_t offset, uint64_t length) const {
+    return offset <= data_.size() && length <= data_.size() - offset;
+  }
+
+  folly::MemoryMapping mapping_;
+  folly::ByteRange data_;
+  uint32_t count_{0};
+};
+
+SharedPackStore::SharedPackStore(AbsolutePath directory)
+    : directory_{std::move(directory)} {
+  refresh();
+}
+
+SharedPackStore::~SharedPackStore() = default;
+
+StoreResult SharedPackStore::get(KeySpace keySpace, folly::ByteRange key)
+    const {
+  auto segments = segments_.rlock();
+  for (const auto& [name, segment] : *segments) {
+    if (auto value = segment->find(keySpace, key)) {
+      // The StoreResult keeps the segment mapped.
+      return StoreResult{*value, segment};
+    }
+  }
+  return StoreResult::missing(keySpace, key);
+}
+
+bool SharedPackStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  auto segments = segments_.rlock();
+  for (const auto& [name, segment] : *segments) {
+    if (segment->find(keySpace, key)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SharedPackStore::refresh() {
+  auto names = getAllDirectoryEntryNames(directory_);
+  if (names.hasException()) {
+    XLOG(DBG3) << "unable to list shared pack directory " << directory_
+               << ": " << names.exception().what();
+    return;
+  }
+
+  std::vector<std::pair<std::string, std::shared_ptr<const Segment>>> added;
+  {
+    auto segments = segments_.rlock();
+    for (const auto& name : names.value()) {
+      auto nameString = name.stringPiece().str();
+      if (!name.stringPiece().endsWith(kSegmentExtension) ||
+          segments->count(nameString)) {
+        continue;
+      }
+      auto path = directory_ + name;
+      try {
+        added.emplace_back(
+            std::move(nameString), std::make_shared<const Segment>(path));
+      } catch (const std::exception& ex) {
+        XLOG(WARN) << "ignoring invalid shared pack segment " << path << ": "
+                   << folly::exceptionStr(ex);
+      }
+    }
+  }
+
+  if (!added.empty()) {
+    auto segments = segments_.wlock();
+    for (auto& [name, segment] : added) {
+      segments->emplace(std::move(name), std::move(segment));
+    }
+  }
+}
+
+size_t SharedPackStore::getSegmentCount() const {
+  return segments_.rlock()->size();
+}
+
+void SharedPackWriter::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  entries_[{keySpace->index, folly::StringPiece{key}.str()}] =
+      folly::StringPiece{value}.str();
+}
+
+void SharedPackWriter::write(AbsolutePathPiece path) const {
+  size_t dataOffset = sizeof(Header) + entries_.size() * sizeof(IndexEntry);
+  size_t totalSize = dataOffset;
+  for (const auto& [key, value] : entries_) {
+    totalSize += key.second.size() + value.size();
+  }
+
+  std::string buffer(totalSize, '\0');
+  Header header;
+  memcpy(header.magic, kMagic.data(), sizeof(header.magic));
+  header.version = folly::Endian::little(kVersion);
+  header.entryCount =
+      folly::Endian::little(static_cast<uint32_t>(entries_.size()));
+  memcpy(buffer.data(), &header, sizeof(header));
+
+  size_t indexOffset = sizeof(Header);
+  for (const auto& [key, value] : entries_) {
+    const auto& [keySpace, keyBytes] = key;
+    IndexEntry entry{};
+    entry.keySpace = keySpace;
+    entry.keyLength =
+        folly::Endian::little(static_cast<uint32_t>(keyBytes.size()));
+    entry.keyOffset =
+        folly::Endian::little(static_cast<uint64_t>(dataOffset));
+    memcpy(buffer.data() + dataOffset, keyBytes.data(), keyBytes.size());
+    dataOffset += keyBytes.size();
+    entry.valueOffset =
+        folly::Endian::little(static_cast<uint64_t>(dataOffset));
+    entry.valueLength =
+        folly::Endian::little(static_cast<uint64_t>(value.size()));
+    memcpy(buffer.data() + dataOffset, value.data(), value.size());
+    dataOffset += value.size();
+    memcpy(buffer.data() + indexOffset, &entry, sizeof(entry));
+    indexOffset += sizeof(entry);
+  }
+
+  writeFileAtomic(path, folly::StringPiece{buffer}).value();
+}
+
+} // namespace facebook::eden
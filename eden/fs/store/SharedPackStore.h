@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class StoreResult;
+
+/**
+ * A read-only, content-addressed store shared by all the EdenFS instances of
+ * a host, so that objects fetched on behalf of one user are not fetched and
+ * stored again for every other user.
+ *
+ * The store is a directory of immutable pack segments, written by a separate
+ * process with SharedPackWriter. Each segment is a memory mapped file holding
+ * a sorted index followed by the keys and values, so lookups are a binary
+ * search and values are returned without being copied.
+ *
+ * Only content-addressed data, whose value for a key never changes, belongs
+ * in a shared pack.
+ *
+ * SharedPackStore is thread safe.
+ */
+class SharedPackStore {
+ public:
+  /**
+   * The file name extension of pack segments. Other files in the directory,
+   * such as segments that are still being written, are ignored.
+   */
+  static constexpr folly::StringPiece kSegmentExtension{".pack"};
+
+  /**
+   * Map the segments that are in `directory`. A missing directory is treated
+   * as an empty store.
+   */
+  explicit SharedPackStore(AbsolutePath directory);
+  ~SharedPackStore();
+
+  SharedPackStore(const SharedPackStore&) = delete;
+  SharedPackStore& operator=(const SharedPackStore&) = delete;
+
+  /**
+   * Look up a key. The returned StoreResult points into the mapped segment
+   * and keeps it mapped.
+   */
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const;
+
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const;
+
+  /**
+   * Map the segments that were added to the directory since the last call.
+   * Segments that fail validation are skipped with a warning.
+   */
+  void refresh();
+
+  size_t getSegmentCount() const;
+
+ private:
+  class Segment;
+
+  const AbsolutePath directory_;
+  /// Segments by file name, so that refresh() only maps new ones.
+  folly::Synchronized<std::map<std::string, std::shared_ptr<const Segment>>>
+      segments_;
+};
+
+/**
+ * Builds a pack segment for a SharedPackStore.
+ */
+class SharedPackWriter {
+ public:
+  /**
+   * Add a key and its value. Adding the same key again replaces its value.
+   */
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value);
+
+  bool empty() const {
+    return entries_.empty();
+  }
+
+  /**
+   * Atomically write the segment to `path`, which should be in the store's
+   * directory and end in SharedPackStore::kSegmentExtension. Throws on
+   * error.
+   */
+  void write(AbsolutePathPiece path) const;
+
+ private:
+  std::map<std::pair<uint8_t, std::string>, std::string> entries_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Synchronized.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * Joins concurrent fetches of the same ObjectId onto a single fetch.
+ *
+ * The first caller for an ID runs the fetch. Callers that arrive while it is
+ * in flight receive a copy of its result (or exception) instead of issuing a
+ * fetch of their own. Once the fetch completes the ID is forgotten, so later
+ * callers are expected to find the object in whatever cache the fetch filled.
+ *
+ * T must be copyable, since every joined caller receives its own copy.
+ * It is safe to use this object from arbitrary threads.
+ */
+template <typename T>
+class SingleFlight {
+ public:
+  /**
+   * Return the result of fetching `id`, calling `fetch()` to produce a
+   * folly::Future<T> only if no fetch of `id` is already in flight.
+   *
+   * The second member of the returned pair is true if the caller was joined
+   * onto an existing fetch. Joined callers' futures complete on `executor`.
+   */
+  template <typename Fetch>
+  std::pair<folly::Future<T>, bool> fetch(
+      const ObjectId& id,
+      folly::Executor::KeepAlive<folly::Executor> executor,
+      Fetch&& fetch) {
+    {
+      auto pending = pending_->wlock();
+      auto [iter, inserted] = pending->try_emplace(id);
+      if (!inserted) {
+        return {iter->second.getSemiFuture().via(std::move(executor)), true};
+      }
+    }
+
+    auto future = folly::makeFutureWith(std::forward<Fetch>(fetch));
+    return {
+        std::move(future).thenTry([pending = pending_,
+                                   id](folly::Try<T>&& result) {
+          folly::SharedPromise<T> promise;
+          {
+            auto locked = pending->wlock();
+            auto iter = locked->find(id);
+            promise = std::move(iter->second);
+            locked->erase(iter);
+          }
+          promise.setTry(folly::Try<T>{result});
+          return std::move(result).value();
+        }),
+        false};
+  }
+
+  /**
+   * The number of IDs currently being fetched.
+   */
+  size_t inFlightCount() const {
+    return pending_->rlock()->size();
+  }
+
+ private:
+  using PendingMap = folly::Synchronized<
+      std::unordered_map<ObjectId, folly::SharedPromise<T>>>;
+
+  /**
+   * Shared with the continuations of in-flight fetches, which may outlive
+   * this object.
+   */
+  std::shared_ptr<PendingMap> pending_ = std::make_shared<PendingMap>();
+};
+
+} // namespace facebook::eden
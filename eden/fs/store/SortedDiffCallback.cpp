@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SortedDiffCallback.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+void SortedDiffCallback::ignoredPath(RelativePathPiece path, dtype_t type) {
+  record(path, Kind::Ignored, type);
+}
+
+void SortedDiffCallback::addedPath(RelativePathPiece path, dtype_t type) {
+  record(path, Kind::Added, type);
+}
+
+void SortedDiffCallback::removedPath(RelativePathPiece path, dtype_t type) {
+  record(path, Kind::Removed, type);
+}
+
+void SortedDiffCallback::modifiedPath(RelativePathPiece path, dtype_t type) {
+  record(path, Kind::Modified, type);
+}
+
+void SortedDiffCallback::diffError(
+    RelativePathPiece path,
+    const folly::exception_wrapper& ew) {
+  record(path, Kind::Error, dtype_t::Unknown, ew);
+}
+
+void SortedDiffCallback::record(
+    RelativePathPiece path,
+    Kind kind,
+    dtype_t type,
+    folly::exception_wrapper error) {
+  results_.wlock()->push_back(
+      Result{path.copy(), kind, type, std::move(error)});
+}
+
+void SortedDiffCallback::flush() {
+  auto results = std::move(*results_.wlock());
+  // A path may be reported more than once, e.g. a file replaced by a
+  // directory is both removed and added, so break ties on the kind.
+  std::sort(
+      results.begin(), results.end(), [](const Result& a, const Result& b) {
+        if (a.path != b.path) {
+          return a.path < b.path;
+        }
+        return a.kind < b.kind;
+      });
+
+  for (auto& result : results) {
+    switch (result.kind) {
+      case Kind::Ignored:
+        target_->ignoredPath(result.path, result.type);
+        break;
+      case Kind::Added:
+        target_->addedPath(result.path, result.type);
+        break;
+      case Kind::Removed:
+        target_->removedPath(result.path, result.type);
+        break;
+      case Kind::Modified:
+        target_->modifiedPath(result.path, result.type);
+        break;
+      case Kind::Error:
+        target_->diffError(result.path, result.error);
+        break;
+    }
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/Synchronized.h>
+#include <vector>
+
+#include "eden/fs/store/DiffCallback.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A DiffCallback that buffers every result and forwards them to another
+ * DiffCallback, sorted by path, when flush() is called.
+ *
+ * The diff functions fetch and compare subtrees concurrently, so the order in
+ * which they report results depends on which fetches finish first. Wrapping a
+ * callback in this makes the order it observes independent of that timing.
+ */
+class SortedDiffCallback : public DiffCallback {
+ public:
+  explicit SortedDiffCallback(DiffCallback* target) : target_{target} {}
+
+  void ignoredPath(RelativePathPiece path, dtype_t type) override;
+  void addedPath(RelativePathPiece path, dtype_t type) override;
+  void removedPath(RelativePathPiece path, dtype_t type) override;
+  void modifiedPath(RelativePathPiece path, dtype_t type) override;
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override;
+
+  /**
+   * Forward all buffered results to the target callback and forget them.
+   *
+   * This should only be invoked after the diff operation has completed.
+   */
+  void flush();
+
+ private:
+  enum class Kind { Removed, Added, Modified, Ignored, Error };
+
+  struct Result {
+    RelativePath path;
+    Kind kind;
+    dtype_t type;
+    folly::exception_wrapper error;
+  };
+
+  void record(
+      RelativePathPiece path,
+      Kind kind,
+      dtype_t type,
+      folly::exception_wrapper error = {});
+
+  DiffCallback* const target_;
+  folly::Synchronized<std::vector<Result>> results_;
+};
+
+} // namespace facebook::eden
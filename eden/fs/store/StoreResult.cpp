@@ -18,6 +18,16 @@ void freeString(void* /* buffer */, void* userData) {
   auto str = static_cast<std::string*>(userData);
   delete str;
 }
+
+void releaseSharedString(void* /* buffer */, void* userData) {
+  auto str = static_cast<std::shared_ptr<const std::string>*>(userData);
+  delete str;
+}
+
+void releaseOwner(void* /* buffer */, void* userData) {
+  auto owner = static_cast<std::shared_ptr<const void>*>(userData);
+  delete owner;
+}
 } // namespace
 
 namespace facebook::eden {
@@ -39,6 +49,33 @@ IOBuf StoreResult::iobufWrapper() const {
 folly::IOBuf StoreResult::extractIOBuf() {
   ensureValid();
 
+  if (shared_) {
+    auto sharedPtr = std::make_unique<std::shared_ptr<const std::string>>(
+        std::exchange(shared_, nullptr));
+    auto data = const_cast<char*>((*sharedPtr)->data());
+    auto size = (*sharedPtr)->size();
+    IOBuf buf(
+        IOBuf::TAKE_OWNERSHIP,
+        data,
+        size,
+        releaseSharedString,
+        sharedPtr.release());
+    // The store still references the data, so it must not be written to.
+    buf.markExternallySharedOne();
+    return buf;
+  }
+
+  if (owner_) {
+    auto owner = std::make_unique<std::shared_ptr<const void>>(
+        std::exchange(owner_, nullptr));
+    auto data = const_cast<uint8_t*>(external_.data());
+    auto size = std::exchange(external_, {}).size();
+    IOBuf buf(IOBuf::TAKE_OWNERSHIP, data, size, releaseOwner, owner.release());
+    // The data may be read-only memory, and is shared with other readers.
+    buf.markExternallySharedOne();
+    return buf;
+  }
+
   // Unfortunately RocksDB returns data to us in a std::string.  This makes it
   // difficult for us to control the lifetime.  We end up having to allocate a
   // new std::string on the heap, just to control when it will free the
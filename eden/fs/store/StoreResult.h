@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -44,10 +45,27 @@ class StoreResult {
    */
   explicit StoreResult(std::string data) : StoreResult{true, std::move(data)} {}
 
+  /**
+   * Construct a StoreResult sharing payload data that the store keeps in
+   * memory, without copying it.
+   */
+  explicit StoreResult(std::shared_ptr<const std::string> data)
+      : valid_{true}, shared_{std::move(data)} {}
+
+  /**
+   * Construct a StoreResult pointing at payload data that `owner` keeps
+   * alive, such as a memory mapped file, without copying it.
+   */
+  StoreResult(folly::ByteRange data, std::shared_ptr<const void> owner)
+      : valid_{true}, owner_{std::move(owner)}, external_{data} {}
+
   StoreResult(StoreResult&& that) noexcept
       : valid_{false}, data_{"moved-from"} {
     std::swap(valid_, that.valid_);
     std::swap(data_, that.data_);
+    std::swap(shared_, that.shared_);
+    std::swap(owner_, that.owner_);
+    std::swap(external_, that.external_);
   }
 
   StoreResult& operator=(StoreResult&& that) noexcept {
@@ -55,6 +73,9 @@ class StoreResult {
     // Allocate the new std::string before performing the no-except swaps.
     valid_ = std::exchange(that.valid_, false);
     data_ = std::exchange(that.data_, std::move(data));
+    shared_ = std::move(that.shared_);
+    owner_ = std::move(that.owner_);
+    external_ = std::exchange(that.external_, folly::ByteRange{});
     return *this;
   }
 
@@ -67,13 +88,17 @@ class StoreResult {
   }
 
   /**
-   * Get a reference to the std::string result.
+   * Get a reference to the std::string result. Data owned by something other
+   * than a std::string is copied the first time.
    *
    * Throws std::domain_error if the key was not present in the store.
    */
   const std::string& asString() const {
     ensureValid();
-    return data_;
+    if (owner_ && data_.empty() && !external_.empty()) {
+      data_ = folly::StringPiece{external_}.str();
+    }
+    return owner_ ? data_ : value();
   }
 
   /**
@@ -83,7 +108,7 @@ class StoreResult {
    */
   folly::ByteRange bytes() const {
     ensureValid();
-    return folly::StringPiece{data_};
+    return owner_ ? external_ : folly::StringPiece{value()};
   }
 
   /**
@@ -93,7 +118,7 @@ class StoreResult {
    */
   folly::StringPiece piece() const {
     ensureValid();
-    return folly::StringPiece{data_};
+    return owner_ ? folly::StringPiece{external_} : folly::StringPiece{value()};
   }
 
   /**
@@ -106,11 +131,19 @@ class StoreResult {
   folly::IOBuf iobufWrapper() const;
 
   /**
-   * Extract the std::string contained in this StoreResult.
+   * Extract the std::string contained in this StoreResult. This copies the
+   * data if it is shared with the store.
    */
   std::string extractValue() {
     ensureValid();
     valid_ = false;
+    if (shared_) {
+      return *std::exchange(shared_, nullptr);
+    }
+    if (owner_) {
+      owner_.reset();
+      return folly::StringPiece{std::exchange(external_, {})}.str();
+    }
     return std::move(data_);
   }
 
@@ -122,7 +155,9 @@ class StoreResult {
    *
    * This does require a memory allocation to move the stored std::string onto
    * the heap (but it just does a small allocation for the string object
-   * itself, and not the string data).
+   * itself, and not the string data). Data shared with the store, or kept
+   * alive by an owner, is not copied either; the IOBuf keeps a reference to
+   * it.
    */
   folly::IOBuf extractIOBuf();
 
@@ -146,13 +181,28 @@ class StoreResult {
 
   [[noreturn]] void throwInvalidError() const;
 
+  const std::string& value() const {
+    return shared_ ? *shared_ : data_;
+  }
+
   /**
    * If true, data_ contains the payload from the store.
    * If false, it contains an error message that includes context about what was
-   * looked up.
+   * looked up. If owner_ is set, it is only filled in by asString().
    */
   bool valid_{false};
-  std::string data_;
+  mutable std::string data_;
+  /**
+   * If set, the payload, shared with the store that returned it. data_ is
+   * unused then.
+   */
+  std::shared_ptr<const std::string> shared_;
+  /**
+   * If set, keeps the payload at external_ alive. data_ and shared_ are
+   * unused then.
+   */
+  std::shared_ptr<const void> owner_;
+  folly::ByteRange external_;
 };
 
 } // namespace facebook::eden
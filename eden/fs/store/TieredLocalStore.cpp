@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+
+#include <folly/futures/Future.h>
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/SharedPackStore.h"
+#include "eden/fs/store/StoreResult.h"
+
+namespace facebook::eden {
+
+TieredLocalStore::TieredLocalStore(
+    std::shared_ptr<LocalStore> primary,
+    std::shared_ptr<SharedPackStore> shared)
+    : primary_{std::move(primary)}, shared_{std::move(shared)} {}
+
+void TieredLocalStore::close() {
+  primary_->close();
+}
+
+void TieredLocalStore::clearKeySpace(KeySpace keySpace) {
+  primary_->clearKeySpace(keySpace);
+}
+
+void TieredLocalStore::compactKeySpace(KeySpace keySpace) {
+  primary_->compactKeySpace(keySpace);
+}
+
+StoreResult TieredLocalStore::get(KeySpace keySpace, folly::ByteRange key)
+    const {
+  auto result = shared_->get(keySpace, key);
+  if (result.isValid()) {
+    return result;
+  }
+  return primary_->get(keySpace, key);
+}
+
+folly::Future<StoreResult> TieredLocalStore::getFuture(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  auto result = shared_->get(keySpace, key);
+  if (result.isValid()) {
+    return std::move(result);
+  }
+  return primary_->getFuture(keySpace, key);
+}
+
+folly::Future<std::vector<StoreResult>> TieredLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  // Only the keys that aren't in the shared store are looked up in the
+  // primary store, with a single batch.
+  std::vector<StoreResult> results;
+  results.reserve(keys.size());
+  std::vector<size_t> missingIndexes;
+  std::vector<folly::ByteRange> missingKeys;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto result = shared_->get(keySpace, keys[i]);
+    if (!result.isValid()) {
+      missingIndexes.push_back(i);
+      missingKeys.push_back(keys[i]);
+    }
+    results.push_back(std::move(result));
+  }
+  if (missingKeys.empty()) {
+    return std::move(results);
+  }
+
+  return primary_->getBatch(keySpace, missingKeys)
+      .thenValue([results = std::move(results),
+                  missingIndexes = std::move(missingIndexes)](
+                     std::vector<StoreResult>&& primaryResults) mutable {
+        for (size_t i = 0; i < missingIndexes.size(); ++i) {
+          results[missingIndexes[i]] = std::move(primaryResults[i]);
+        }
+        return std::move(results);
+      });
+}
+
+bool TieredLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  return shared_->hasKey(keySpace, key) || primary_->hasKey(keySpace, key);
+}
+
+void TieredLocalStore::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  primary_->put(keySpace, key, value);
+}
+
+std::unique_ptr<LocalStore::WriteBatch> TieredLocalStore::beginWrite(
+    size_t bufSize) {
+  return primary_->beginWrite(bufSize);
+}
+
+void TieredLocalStore::periodicManagementTask(const EdenConfig& config) {
+  enableBlobCaching.store(
+      config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  primary_->periodicManagementTask(config);
+  shared_->refresh();
+}
+
+folly::SemiFuture<folly::Unit> TieredLocalStore::garbageCollect(
+    const EdenConfig& config,
+    const folly::CancellationToken& cancel) {
+  return primary_->garbageCollect(config, cancel);
+}
+
+size_t TieredLocalStore::estimateMemoryUsage() const {
+  return primary_->estimateMemoryUsage();
+}
+
+} // namespace facebook::eden
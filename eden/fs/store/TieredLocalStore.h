@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+class SharedPackStore;
+
+/**
+ * A LocalStore that reads through a host-wide SharedPackStore before falling
+ * back to a per-user store.
+ *
+ * Every write goes to the per-user store, since the shared store is read-only
+ * and populated by a separate process. Values found in the shared store are
+ * returned without being copied.
+ */
+class TieredLocalStore : public LocalStore {
+ public:
+  TieredLocalStore(
+      std::shared_ptr<LocalStore> primary,
+      std::shared_ptr<SharedPackStore> shared);
+
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<StoreResult> getFuture(
+      KeySpace keySpace,
+      folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
+
+  /**
+   * Runs the per-user store's management, and maps the segments that were
+   * added to the shared store since the last run.
+   */
+  void periodicManagementTask(const EdenConfig& config) override;
+  folly::SemiFuture<folly::Unit> garbageCollect(
+      const EdenConfig& config,
+      const folly::CancellationToken& cancel) override;
+
+  size_t estimateMemoryUsage() const override;
+
+ private:
+  const std::shared_ptr<LocalStore> primary_;
+  const std::shared_ptr<SharedPackStore> shared_;
+};
+
+} // namespace facebook::eden
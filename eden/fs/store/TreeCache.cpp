@@ -8,10 +8,17 @@
 #include "eden/fs/store/TreeCache.h"
 
 #include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/utils/MemoryArena.h"
 
 namespace facebook::eden {
 std::shared_ptr<const Tree> TreeCache::get(const ObjectId& hash) {
   if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
+    if (compactCache_) {
+      if (auto compact = compactCache_->getSimple(hash)) {
+        return compact->toTree();
+      }
+      return std::shared_ptr<const Tree>{nullptr};
+    }
     return getSimple(hash);
   }
   return std::shared_ptr<const Tree>{nullptr};
@@ -19,14 +26,58 @@ std::shared_ptr<const Tree> TreeCache::get(const ObjectId& hash) {
 
 void TreeCache::insert(std::shared_ptr<const Tree> tree) {
   if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
+    if (compactCache_) {
+      // The compact copy is only referenced by the cache.
+      MemoryArena::Scope arenaScope{MemoryArena::objectCache()};
+      return compactCache_->insertSimple(std::make_shared<CompactTree>(*tree));
+    }
     return insertSimple(tree);
   }
 }
 
+bool TreeCache::contains(const ObjectId& hash) const {
+  if (compactCache_) {
+    return compactCache_->contains(hash);
+  }
+  return ObjectCache<Tree, ObjectCacheFlavor::Simple>::contains(hash);
+}
+
+void TreeCache::clear() {
+  if (compactCache_) {
+    compactCache_->clear();
+  }
+  ObjectCache<Tree, ObjectCacheFlavor::Simple>::clear();
+}
+
+TreeCache::Stats TreeCache::getStats() const {
+  if (!compactCache_) {
+    return ObjectCache<Tree, ObjectCacheFlavor::Simple>::getStats();
+  }
+  auto compactStats = compactCache_->getStats();
+  Stats stats;
+  stats.objectCount = compactStats.objectCount;
+  stats.totalSizeInBytes = compactStats.totalSizeInBytes;
+  stats.hitCount = compactStats.hitCount;
+  stats.missCount = compactStats.missCount;
+  stats.evictionCount = compactStats.evictionCount;
+  stats.dropCount = compactStats.dropCount;
+  stats.admissionRejectCount = compactStats.admissionRejectCount;
+  return stats;
+}
+
 TreeCache::TreeCache(std::shared_ptr<ReloadableConfig> config)
       : ObjectCache<Tree, ObjectCacheFlavor::Simple>{
             config->getEdenConfig()->inMemoryTreeCacheSize.getValue(),
-            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue()},
-        config_{config} {}
+            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue(),
+            config->getEdenConfig()->inMemoryTreeCacheShards.getValue()},
+        config_{config} {
+  auto edenConfig = config->getEdenConfig();
+  if (edenConfig->inMemoryTreeCacheCompact.getValue()) {
+    compactCache_ = CompactTreeCache::create(
+        edenConfig->inMemoryTreeCacheSize.getValue(),
+        edenConfig->inMemoryTreeCacheMinElements.getValue(),
+        edenConfig->inMemoryTreeCacheShards.getValue());
+  }
+}
 
 } // namespace facebook::eden
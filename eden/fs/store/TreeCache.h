@@ -8,6 +8,7 @@
 #pragma once
 
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/CompactTree.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ObjectCache.h"
 
@@ -29,6 +30,10 @@ namespace facebook::eden {
  * be cachable your minimum entry count must be atleast 1, otherwise insert may
  * not actually insert the tree into the cache.
  *
+ * When treecache:compact-representation is set, trees are cached as
+ * CompactTree instead. More of them fit in the same budget, but each hit
+ * returns a freshly built Tree rather than the one that was inserted.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
@@ -55,12 +60,28 @@ class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
    */
   void insert(std::shared_ptr<const Tree> tree);
 
+  /**
+   * These hide the ObjectCache methods of the same name so that they also
+   * cover the compact representation.
+   */
+  bool contains(const ObjectId& hash) const;
+  void clear();
+  Stats getStats() const;
+
  private:
+  using CompactTreeCache = ObjectCache<CompactTree, ObjectCacheFlavor::Simple>;
+
   /**
    * Reference to the eden config, may be a null pointer in unit tests.
    */
   std::shared_ptr<ReloadableConfig> config_;
 
+  /**
+   * Holds the cached trees in place of the base class when the compact
+   * representation is enabled, and is null otherwise.
+   */
+  std::shared_ptr<CompactTreeCache> compactCache_;
+
   explicit TreeCache(std::shared_ptr<ReloadableConfig> config);
 };
 
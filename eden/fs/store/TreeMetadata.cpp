@@ -13,6 +13,7 @@
 #include <folly/logging/xlog.h>
 
 #include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/store/StoreResult.h"
 
 namespace facebook::eden {
@@ -94,7 +95,8 @@ IOBuf TreeMetadata::serializeV1() const {
   }
   for (auto& [hash, metadata] : *hashIndexedEntries) {
     appender.push(hash.getBytes());
-    SerializedBlobMetadata serializedMetadata(metadata);
+    // Tree metadata entries have a fixed size, without BLAKE3 hashes.
+    SerializedBlobMetadata serializedMetadata(metadata.sha1, metadata.size);
     appender.push(serializedMetadata.slice());
   }
   return buf;
@@ -128,12 +130,28 @@ IOBuf TreeMetadata::serializeV2(size_t serialized_size) const {
     XCHECK_LE(bytes.size(), std::numeric_limits<uint16_t>::max());
     appender.write<uint16_t>(folly::to_narrow(bytes.size()));
     appender.push(bytes);
-    SerializedBlobMetadata serializedMetadata(metadata);
+    // Tree metadata entries have a fixed size, without BLAKE3 hashes.
+    SerializedBlobMetadata serializedMetadata(metadata.sha1, metadata.size);
     appender.push(serializedMetadata.slice());
   }
   return buf;
 }
 
+TreeMetadata TreeMetadata::fromTree(const Tree& tree) {
+  HashIndexedEntryMetadata entries;
+  for (const auto& entry : tree.getTreeEntries()) {
+    if (entry.isTree()) {
+      continue;
+    }
+    const auto& size = entry.getSize();
+    const auto& contentSha1 = entry.getContentSha1();
+    if (size && contentSha1) {
+      entries.emplace_back(entry.getHash(), BlobMetadata{*contentSha1, *size});
+    }
+  }
+  return TreeMetadata{std::move(entries)};
+}
+
 TreeMetadata TreeMetadata::deserialize(const StoreResult& result) {
   auto data = result.piece();
   if (data.size() < sizeof(uint32_t)) {
@@ -20,6 +20,7 @@ namespace facebook::eden {
 
 class BlobMetadata;
 class StoreResult;
+class Tree;
 
 /**
  * This is to help manipulate and store the metadata for the blob entries
@@ -62,6 +63,16 @@ class TreeMetadata {
 
   static TreeMetadata deserialize(const StoreResult& result);
 
+  /**
+   * Collects the metadata that the backing store returned along with `tree`,
+   * for the blob entries that have both a size and a SHA-1.
+   */
+  static TreeMetadata fromTree(const Tree& tree);
+
+  bool empty() const {
+    return getNumberOfEntries() == 0;
+  }
+
   const EntryMetadata& entries() const {
     return entryMetadata_;
   }
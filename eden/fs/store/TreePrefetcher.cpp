@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreePrefetcher.h"
+
+#include <folly/Synchronized.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/logging/xlog.h>
+#include <deque>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+namespace {
+
+using TreePair =
+    std::tuple<std::shared_ptr<const Tree>, std::shared_ptr<const Tree>>;
+
+class ChangedTreeWalk : public std::enable_shared_from_this<ChangedTreeWalk> {
+ public:
+  ChangedTreeWalk(
+      std::shared_ptr<ObjectStore> objectStore,
+      ObjectFetchContext& context,
+      size_t maxConcurrency)
+      : objectStore_{std::move(objectStore)},
+        context_{context},
+        maxConcurrency_{std::max<size_t>(maxConcurrency, 1)} {}
+
+  folly::SemiFuture<size_t> start(const Tree& fromTree, const Tree& toTree) {
+    state_.lock()->enqueueChangedChildren(fromTree, toTree);
+    auto future = promise_.getSemiFuture();
+    pump();
+    return future;
+  }
+
+ private:
+  struct State {
+    /// Add the subtrees of `from` and `to` that have the same name but
+    /// different IDs.
+    void enqueueChangedChildren(const Tree& from, const Tree& to) {
+      // Tree entries are sorted by name.
+      const auto& fromEntries = from.getTreeEntries();
+      const auto& toEntries = to.getTreeEntries();
+      auto fromIt = fromEntries.begin();
+      auto toIt = toEntries.begin();
+      while (fromIt != fromEntries.end() && toIt != toEntries.end()) {
+        if (fromIt->getName() < toIt->getName()) {
+          ++fromIt;
+        } else if (toIt->getName() < fromIt->getName()) {
+          ++toIt;
+        } else {
+          if (fromIt->isTree() && toIt->isTree() &&
+              fromIt->getHash() != toIt->getHash()) {
+            queue.emplace_back(fromIt->getHash(), toIt->getHash());
+          }
+          ++fromIt;
+          ++toIt;
+        }
+      }
+    }
+
+    std::deque<std::pair<ObjectId, ObjectId>> queue;
+    size_t inFlight{0};
+    size_t fetched{0};
+    bool done{false};
+  };
+
+  /**
+   * Start fetches until `maxConcurrency_` are in flight, and complete the
+   * promise once there is nothing left to fetch.
+   *
+   * Fetches that complete immediately, such as those that hit the in-memory
+   * tree cache, are handled in this loop rather than recursively, so that
+   * walking a cached tree doesn't need a stack frame per tree.
+   */
+  void pump() {
+    for (;;) {
+      std::pair<ObjectId, ObjectId> ids;
+      {
+        auto state = state_.lock();
+        if (state->queue.empty() || state->inFlight >= maxConcurrency_) {
+          if (state->queue.empty() && state->inFlight == 0 && !state->done) {
+            state->done = true;
+            auto fetched = state->fetched;
+            state.unlock();
+            promise_.setValue(fetched);
+          }
+          return;
+        }
+        ids = std::move(state->queue.front());
+        state->queue.pop_front();
+        ++state->inFlight;
+      }
+
+      auto future = collectAllSafe(
+          objectStore_->getTree(ids.first, context_),
+          objectStore_->getTree(ids.second, context_));
+      if (future.isReady()) {
+        handleResult(std::move(future).getTry());
+        continue;
+      }
+      std::move(future)
+          .semi()
+          .via(&folly::QueuedImmediateExecutor::instance())
+          .thenTry([self = shared_from_this()](folly::Try<TreePair>&& result) {
+            self->handleResult(std::move(result));
+            self->pump();
+          });
+    }
+  }
+
+  void handleResult(folly::Try<TreePair>&& result) {
+    auto state = state_.lock();
+    --state->inFlight;
+    if (result.hasException()) {
+      XLOG(DBG3) << "failed to prefetch tree: " << result.exception().what();
+      return;
+    }
+    state->fetched += 2;
+    const auto& [from, to] = result.value();
+    state->enqueueChangedChildren(*from, *to);
+  }
+
+  const std::shared_ptr<ObjectStore> objectStore_;
+  ObjectFetchContext& context_;
+  const size_t maxConcurrency_;
+  folly::Promise<size_t> promise_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace
+
+folly::SemiFuture<size_t> prefetchChangedTrees(
+    std::shared_ptr<ObjectStore> objectStore,
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree,
+    ObjectFetchContext& context,
+    size_t maxConcurrency) {
+  if (!fromTree || !toTree) {
+    return size_t{0};
+  }
+  auto walk = std::make_shared<ChangedTreeWalk>(
+      std::move(objectStore), context, maxConcurrency);
+  return walk->start(*fromTree, *toTree);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/futures/Future.h>
+#include <memory>
+
+namespace facebook::eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class Tree;
+
+/**
+ * Fetch, through `objectStore`, every tree present in both `fromTree` and
+ * `toTree` at the same path but with a different ID, recursively, with at
+ * most `maxConcurrency` fetches in flight.
+ *
+ * These are the trees a checkout from `fromTree` to `toTree` may have to
+ * load when it reaches a loaded or materialized directory. Fetching them
+ * ahead of time, breadth first, takes their latency out of the checkout's
+ * depth-first walk. Trees only present on one side are skipped: checkout
+ * replaces those entries without reading them.
+ *
+ * Fetch errors are ignored, the checkout reports them if it needs the tree.
+ * The returned future completes with the number of trees fetched. The caller
+ * must keep `context` alive until then.
+ */
+folly::SemiFuture<size_t> prefetchChangedTrees(
+    std::shared_ptr<ObjectStore> objectStore,
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree,
+    ObjectFetchContext& context,
+    size_t maxConcurrency);
+
+} // namespace facebook::eden
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/WriteCombiner.h"
+
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <utility>
+
+namespace facebook::eden {
+
+namespace {
+/// Writers block once this many batches worth of bytes are buffered.
+constexpr size_t kMaxBufferedBatches = 4;
+} // namespace
+
+WriteCombiner::WriteCombiner(
+    CommitFn commit,
+    size_t maxBatchBytes,
+    std::chrono::nanoseconds flushInterval)
+    : commit_{std::move(commit)},
+      maxBatchBytes_{maxBatchBytes},
+      flushInterval_{flushInterval.count()},
+      thread_{[this] { run(); }} {}
+
+WriteCombiner::~WriteCombiner() {
+  try {
+    stop();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "lost buffered local store writes: " << ex.what();
+  }
+}
+
+void WriteCombiner::setLimits(
+    size_t maxBatchBytes,
+    std::chrono::nanoseconds flushInterval) {
+  maxBatchBytes_.store(maxBatchBytes, std::memory_order_relaxed);
+  flushInterval_.store(flushInterval.count(), std::memory_order_relaxed);
+  cv_.notify_all();
+}
+
+void WriteCombiner::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    std::string value) {
+  auto state = state_.lock();
+  auto maxBatchBytes = maxBatchBytes_.load(std::memory_order_relaxed);
+  cv_.wait(state.as_lock(), [&] {
+    return state->stopping ||
+        state->pendingBytes < kMaxBufferedBatches * maxBatchBytes;
+  });
+
+  auto valueSize = value.size();
+  auto [it, inserted] = state->pending[keySpace->index].try_emplace(
+      std::string{folly::StringPiece{key}}, std::move(value));
+  if (inserted) {
+    ++state->pendingEntries;
+    state->pendingBytes += key.size() + valueSize;
+    bufferedEntries_.fetch_add(1, std::memory_order_release);
+  } else {
+    state->pendingBytes = state->pendingBytes - it->second.size() + valueSize;
+    it->second = std::move(value);
+  }
+  bool full = state->pendingBytes >= maxBatchBytes;
+  state.unlock();
+
+  if (full) {
+    cv_.notify_all();
+  }
+}
+
+std::optional<std::string> WriteCombiner::get(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  if (empty()) {
+    return std::nullopt;
+  }
+  folly::StringPiece keyPiece{key};
+  auto state = state_.lock();
+  const auto& pending = state->pending[keySpace->index];
+  if (auto it = pending.find(keyPiece); it != pending.end()) {
+    return it->second;
+  }
+  if (state->committing) {
+    const auto& committing = (*state->committing)[keySpace->index];
+    if (auto it = committing.find(keyPiece); it != committing.end()) {
+      return it->second;
+    }
+  }
+  return std::nullopt;
+}
+
+bool WriteCombiner::contains(KeySpace keySpace, folly::ByteRange key) const {
+  if (empty()) {
+    return false;
+  }
+  folly::StringPiece keyPiece{key};
+  auto state = state_.lock();
+  if (state->pending[keySpace->index].count(keyPiece)) {
+    return true;
+  }
+  return state->committing &&
+      (*state->committing)[keySpace->index].count(keyPiece);
+}
+
+size_t WriteCombiner::getBufferedBytes() const {
+  auto state = state_.lock();
+  return state->pendingBytes + state->committingBytes;
+}
+
+void WriteCombiner::flush() {
+  std::lock_guard<std::mutex> commitGuard{commitMutex_};
+
+  std::shared_ptr<const Batch> batch;
+  {
+    auto state = state_.lock();
+    if (state->pendingEntries == 0) {
+      return;
+    }
+    batch = std::make_shared<const Batch>(std::exchange(state->pending, {}));
+    state->committing = batch;
+    state->pendingEntries = 0;
+    state->committingBytes = std::exchange(state->pendingBytes, 0);
+  }
+  // Writers waiting for the buffer to drain can proceed.
+  cv_.notify_all();
+
+  try {
+    commit_(*batch);
+  } catch (...) {
+    auto state = state_.lock();
+    // Keep the writes buffered so that they are committed later. Writes made
+    // since the batch was taken are newer and take precedence.
+    for (size_t index = 0; index < batch->size(); ++index) {
+      for (const auto& [key, value] : (*batch)[index]) {
+        if (state->pending[index].try_emplace(key, value).second) {
+          ++state->pendingEntries;
+          state->pendingBytes += key.size() + value.size();
+        }
+      }
+    }
+    state->committing.reset();
+    state->committingBytes = 0;
+    bufferedEntries_.store(state->pendingEntries, std::memory_order_release);
+    throw;
+  }
+
+  auto state = state_.lock();
+  state->committing.reset();
+  state->committingBytes = 0;
+  bufferedEntries_.store(state->pendingEntries, std::memory_order_release);
+}
+
+void WriteCombiner::stop() {
+  {
+    auto state = state_.lock();
+    if (state->stopping) {
+      return;
+    }
+    state->stopping = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+  flush();
+}
+
+void WriteCombiner::run() {
+  folly::setThreadName("WriteCombiner");
+  auto state = state_.lock();
+  while (!state->stopping) {
+    std::chrono::nanoseconds interval{
+        flushInterval_.load(std::memory_order_relaxed)};
+    cv_.wait_for(state.as_lock(), interval, [&] {
+      return state->stopping ||
+          state->pendingBytes >= maxBatchBytes_.load(std::memory_order_relaxed);
+    });
+    if (state->stopping || state->pendingEntries == 0) {
+      continue;
+    }
+
+    state.unlock();
+    bool failed = false;
+    try {
+      flush();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "failed to commit buffered local store writes: "
+                << ex.what();
+      failed = true;
+    }
+    state = state_.lock();
+
+    if (failed) {
+      // Don't retry a full buffer in a tight loop.
+      cv_.wait_for(
+          state.as_lock(), interval, [&] { return state->stopping; });
+    }
+  }
+}
+
+} // namespace facebook::eden
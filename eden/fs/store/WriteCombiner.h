@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "eden/fs/store/KeySpace.h"
+
+namespace facebook::eden {
+
+/**
+ * Buffers writes to a LocalStore in memory so that they can be committed in
+ * a few large batches rather than one small write each.
+ *
+ * A background thread commits the buffered writes, through the function
+ * given to the constructor, once they reach the maximum batch size or have
+ * waited for the flush interval. Writers block while four times the maximum
+ * batch size is buffered, to bound memory usage.
+ *
+ * Buffered writes, including those of a batch that is being committed, are
+ * returned by get(). Callers must check get() before reading the underlying
+ * store, so that a write is never invisible while it moves from the buffer to
+ * the store.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class WriteCombiner {
+ public:
+  using Batch = std::array<
+      folly::F14FastMap<std::string, std::string>,
+      KeySpace::kTotalCount>;
+  using CommitFn = folly::Function<void(const Batch&)>;
+
+  WriteCombiner(
+      CommitFn commit,
+      size_t maxBatchBytes,
+      std::chrono::nanoseconds flushInterval);
+  ~WriteCombiner();
+
+  WriteCombiner(const WriteCombiner&) = delete;
+  WriteCombiner& operator=(const WriteCombiner&) = delete;
+
+  void setLimits(size_t maxBatchBytes, std::chrono::nanoseconds flushInterval);
+
+  void put(KeySpace keySpace, folly::ByteRange key, std::string value);
+
+  /**
+   * Return the latest buffered value of `key`, or std::nullopt if it has no
+   * buffered write.
+   */
+  std::optional<std::string> get(KeySpace keySpace, folly::ByteRange key)
+      const;
+
+  bool contains(KeySpace keySpace, folly::ByteRange key) const;
+
+  /**
+   * Whether nothing is buffered. Cheap enough to be checked before every
+   * read.
+   */
+  bool empty() const {
+    return bufferedEntries_.load(std::memory_order_acquire) == 0;
+  }
+
+  size_t getBufferedBytes() const;
+
+  /**
+   * Commit everything buffered so far before returning. If committing fails,
+   * the writes stay buffered and the error is rethrown.
+   */
+  void flush();
+
+  /**
+   * Stop the background thread and commit everything buffered. Writes must
+   * not be added afterwards.
+   */
+  void stop();
+
+ private:
+  struct State {
+    Batch pending;
+    size_t pendingEntries{0};
+    size_t pendingBytes{0};
+    /// The batch being committed, still visible to readers until it is.
+    std::shared_ptr<const Batch> committing;
+    size_t committingBytes{0};
+    bool stopping{false};
+  };
+
+  void run();
+
+  CommitFn commit_;
+  std::atomic<size_t> maxBatchBytes_;
+  std::atomic<std::chrono::nanoseconds::rep> flushInterval_;
+
+  /// Entries in `pending` and `committing`.
+  std::atomic<size_t> bufferedEntries_{0};
+
+  /// Held while committing, so that batches are committed in order.
+  std::mutex commitMutex_;
+  folly::Synchronized<State, std::mutex> state_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+
+} // namespace facebook::eden
@@ -6,8 +6,10 @@
  */
 
 #include <sysexits.h>
+#include <algorithm>
 #include <memory>
 #include <optional>
+#include <random>
 
 #include <folly/Range.h>
 #include <folly/String.h>
@@ -22,8 +24,10 @@
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/service/EdenInit.h"
 #include "eden/fs/service/EdenStateDir.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/utils/FaultInjector.h"
 #include "eden/fs/utils/UserInfo.h"
@@ -37,6 +41,12 @@ using std::optional;
 FOLLY_INIT_LOGGING_CONFIG("eden=DBG2; default:async=true");
 
 DEFINE_string(keySpace, "", "operate on just a single key space");
+DEFINE_uint64(batchSize, 1024, "number of keys per batch for batch_get");
+DEFINE_uint64(batchCount, 1000, "number of batches to fetch for batch_get");
+DEFINE_uint64(
+    batchKeyPool,
+    100000,
+    "number of distinct existing keys batch_get samples from");
 
 namespace {
 
@@ -205,13 +215,180 @@ class ShowSizesCommand : public Command {
   }
 };
 
+class MigrateProxyHashesCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("migrate_proxy_hashes");
+  static constexpr auto help = StringPiece(
+      "Rewrite cached trees so their entries embed the Mercurial hash and "
+      "path in their object IDs instead of using legacy proxy hashes "
+      "(processes --batchSize trees at a time)");
+
+  void run() override {
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadWrite);
+
+    // Objects already loaded into a checkout keep their legacy ID, so the
+    // hgproxyhash key space is left alone: it is still needed to resolve
+    // them. Only trees read from the LocalStore from now on will hand out
+    // embedded IDs, which never need a LocalStore lookup.
+    size_t scannedTrees = 0;
+    size_t rewrittenTrees = 0;
+    size_t rewrittenEntries = 0;
+    std::string lastKey;
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    for (;;) {
+      auto keys = localStore->listKeys(
+          KeySpace::TreeFamily,
+          std::max<uint64_t>(FLAGS_batchSize, 1),
+          lastKey);
+      if (keys.empty()) {
+        break;
+      }
+      lastKey = keys.back();
+
+      auto writeBatch = localStore->beginWrite();
+      for (const auto& key : keys) {
+        ++scannedTrees;
+        auto treeId = ObjectId{folly::ByteRange{StringPiece{key}}};
+        auto tree = localStore->getTree(treeId).get();
+        if (!tree) {
+          continue;
+        }
+        size_t rewritten = 0;
+        if (auto migrated = migrateEntries(*localStore, *tree, rewritten)) {
+          writeBatch->putTree(*migrated);
+          rewrittenEntries += rewritten;
+          ++rewrittenTrees;
+        }
+      }
+      writeBatch->flush();
+      XLOG(INFO) << "Scanned " << scannedTrees << " trees, rewrote "
+                 << rewrittenEntries << " entries in " << rewrittenTrees
+                 << " trees";
+    }
+    LOG(INFO) << "Migrated " << rewrittenEntries << " entries in "
+              << rewrittenTrees << " of " << scannedTrees << " trees in "
+              << (watch.elapsed().count() / 1000.0) << " seconds";
+  }
+
+ private:
+  /**
+   * Return a copy of `tree` whose entries that had a legacy proxy hash embed
+   * it instead, or null if there were none. `rewritten` is set to the number
+   * of entries replaced.
+   *
+   * Entries with no proxy hash in the LocalStore (e.g. Git objects) are left
+   * as they are.
+   */
+  static std::unique_ptr<Tree>
+  migrateEntries(LocalStore& localStore, const Tree& tree, size_t& rewritten) {
+    rewritten = 0;
+    std::vector<TreeEntry> entries;
+    entries.reserve(tree.getTreeEntries().size());
+    for (const auto& entry : tree.getTreeEntries()) {
+      const auto& id = entry.getHash();
+      if (HgProxyHash::tryParseEmbeddedProxyHash(id)) {
+        entries.push_back(entry);
+        continue;
+      }
+      auto stored = localStore.get(KeySpace::HgProxyHashFamily, id);
+      if (!stored.isValid()) {
+        entries.push_back(entry);
+        continue;
+      }
+      HgProxyHash proxyHash{id, stored.extractValue()};
+      entries.emplace_back(
+          HgProxyHash::makeEmbeddedProxyHash1(
+              proxyHash.revHash(), proxyHash.path()),
+          PathComponent{entry.getName()},
+          entry.getType(),
+          entry.getSize(),
+          entry.getContentSha1());
+      ++rewritten;
+    }
+    if (!rewritten) {
+      return nullptr;
+    }
+    return std::make_unique<Tree>(std::move(entries), tree.getHash());
+  }
+};
+
+class RepackCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("repack");
+  static constexpr auto help = StringPiece(
+      "Rewrite the cached trees and blobs in the order of a walk of the trees, "
+      "so that the objects of a directory are stored next to each other "
+      "(reads --batchSize trees at a time while looking for the roots)");
+
+  void run() override {
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadWrite);
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    auto stats = localStore->repackForLocality(FLAGS_batchSize);
+    LOG(INFO) << "Repacked " << stats.trees << " trees and " << stats.blobs
+              << " blobs ("
+              << folly::prettyPrint(stats.bytes, folly::PRETTY_BYTES_METRIC)
+              << ") in " << (watch.elapsed().count() / 1000.0) << " seconds";
+  }
+};
+
+class BatchGetCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("batch_get");
+  static constexpr auto help = StringPiece(
+      "Measure LocalStore::getBatch() throughput on existing keys "
+      "(defaults to the hgproxyhash key space)");
+
+  void run() override {
+    auto keySpace = getKeySpace().value_or(KeySpace::HgProxyHashFamily);
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadOnly);
+
+    auto keys = localStore->listKeys(keySpace, FLAGS_batchKeyPool);
+    if (keys.empty()) {
+      throw ArgumentError(fmt::format(
+          FMT_STRING("key space \"{}\" is empty"), keySpace->name));
+    }
+    // Batches are built from random samples so they are not already sorted.
+    std::mt19937 rng{std::random_device{}()};
+    std::shuffle(keys.begin(), keys.end(), rng);
+    XLOG(INFO) << "Sampling batches of " << FLAGS_batchSize << " from "
+               << keys.size() << " keys in " << keySpace->name;
+
+    size_t nextKey = 0;
+    size_t found = 0;
+    folly::stop_watch<std::chrono::microseconds> watch;
+    for (uint64_t batch = 0; batch < FLAGS_batchCount; ++batch) {
+      std::vector<folly::ByteRange> batchKeys;
+      batchKeys.reserve(FLAGS_batchSize);
+      for (uint64_t i = 0; i < FLAGS_batchSize; ++i) {
+        batchKeys.emplace_back(StringPiece{keys[nextKey++ % keys.size()]});
+      }
+      auto results = localStore->getBatch(keySpace, batchKeys).get();
+      found += std::count_if(results.begin(), results.end(), [](auto& result) {
+        return result.isValid();
+      });
+    }
+    auto elapsed = watch.elapsed();
+
+    auto totalKeys = FLAGS_batchCount * FLAGS_batchSize;
+    auto seconds = elapsed.count() / 1000000.0;
+    LOG(INFO) << "Fetched " << totalKeys << " keys (" << found << " found) in "
+              << FLAGS_batchCount << " batches in " << seconds << " seconds";
+    LOG(INFO) << "  " << (totalKeys / seconds) << " keys/second, "
+              << (elapsed.count() / std::max<uint64_t>(FLAGS_batchCount, 1))
+              << " us/batch";
+  }
+};
+
 std::unique_ptr<Command> createCommand(StringPiece name) {
   auto commands = make_array<std::unique_ptr<CommandFactory>>(
       make_unique<CommandFactoryT<GcCommand>>(),
       make_unique<CommandFactoryT<ClearCommand>>(),
       make_unique<CommandFactoryT<CompactCommand>>(),
       make_unique<CommandFactoryT<RepairCommand>>(),
-      make_unique<CommandFactoryT<ShowSizesCommand>>());
+      make_unique<CommandFactoryT<ShowSizesCommand>>(),
+      make_unique<CommandFactoryT<MigrateProxyHashesCommand>>(),
+      make_unique<CommandFactoryT<RepackCommand>>(),
+      make_unique<CommandFactoryT<BatchGetCommand>>());
 
   std::unique_ptr<Command> command;
   for (const auto& factory : commands) {
@@ -10,6 +10,7 @@
 #include <folly/Conv.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 #include <git2.h>
 
 #include "eden/fs/model/Blob.h"
@@ -24,13 +25,17 @@
 
 using folly::ByteRange;
 using folly::IOBuf;
-using folly::makeSemiFuture;
 using folly::SemiFuture;
 using folly::StringPiece;
 using std::make_unique;
 using std::string;
 using std::unique_ptr;
 
+DEFINE_int32(
+    num_git_import_threads,
+    8,
+    "the number of threads reading objects from each git repository");
+
 namespace {
 
 template <typename... Args>
@@ -51,24 +56,43 @@ void freeBlobIOBufData(void* /*blobData*/, void* blobObject) {
 
 namespace facebook::eden {
 
-GitBackingStore::GitBackingStore(AbsolutePathPiece repository) {
-  // Make sure libgit2 is initialized.
-  // (git_libgit2_init() is safe to call multiple times if multiple
+GitBackingStore::LibGit2Initializer::LibGit2Initializer() {
+  // git_libgit2_init() is safe to call multiple times if multiple
   // GitBackingStore objects are created.  git_libgit2_shutdown() should be
-  // called once for each call to git_libgit2_init().)
+  // called once for each call to git_libgit2_init().
   git_libgit2_init();
-
-  auto error = git_repository_open(&repo_, repository.value().str().c_str());
-  gitCheckError(error, "error opening git repository", repository);
 }
 
-GitBackingStore::~GitBackingStore() {
-  git_repository_free(repo_);
+GitBackingStore::LibGit2Initializer::~LibGit2Initializer() {
   git_libgit2_shutdown();
 }
 
+GitBackingStore::RepositoryHandle::RepositoryHandle(const std::string& path) {
+  auto error = git_repository_open(&repo, path.c_str());
+  gitCheckError(error, "error opening git repository", path);
+}
+
+GitBackingStore::RepositoryHandle::~RepositoryHandle() {
+  git_repository_free(repo);
+}
+
+GitBackingStore::GitBackingStore(AbsolutePathPiece repository)
+    : threadRepositories_{[this] { return new RepositoryHandle{path_}; }},
+      pool_{static_cast<size_t>(FLAGS_num_git_import_threads), "GitImporter"} {
+  // Open the repository once here so that errors are reported to whoever
+  // creates the store, and to find the .git directory the threads open.
+  RepositoryHandle handle{repository.value().str()};
+  path_ = git_repository_path(handle.repo);
+}
+
+GitBackingStore::~GitBackingStore() = default;
+
 const char* GitBackingStore::getPath() const {
-  return git_repository_path(repo_);
+  return path_.c_str();
+}
+
+git_repository* GitBackingStore::getRepository() {
+  return threadRepositories_->repo;
 }
 
 RootId GitBackingStore::parseRootId(folly::StringPiece rootId) {
@@ -92,13 +116,17 @@ std::string GitBackingStore::renderObjectId(const ObjectId& objectId) {
 SemiFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
     const RootId& rootId,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
+  return folly::via(&pool_, [this, rootId] { return getRootTreeImpl(rootId); })
+      .semi();
+}
+
+unique_ptr<Tree> GitBackingStore::getRootTreeImpl(const RootId& rootId) {
   XLOG(DBG4) << "resolving tree for commit " << rootId;
 
   // Look up the commit info
   git_oid commitOID = root2Oid(rootId);
   git_commit* commit = nullptr;
-  auto error = git_commit_lookup(&commit, repo_, &commitOID);
+  auto error = git_commit_lookup(&commit, getRepository(), &commitOID);
   gitCheckError(
       error,
       "unable to find git commit ",
@@ -119,9 +147,13 @@ SemiFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
 SemiFuture<BackingStore::GetTreeRes> GitBackingStore::getTree(
     const ObjectId& id,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetTreeRes{
-      getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             &pool_,
+             [this, id] {
+               return BackingStore::GetTreeRes{
+                   getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
 }
 
 unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
@@ -129,7 +161,7 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 
   git_oid treeOID = hash2Oid(id);
   git_tree* gitTree = nullptr;
-  auto error = git_tree_lookup(&gitTree, repo_, &treeOID);
+  auto error = git_tree_lookup(&gitTree, getRepository(), &treeOID);
   gitCheckError(
       error, "unable to find git tree ", id, " in repository ", getPath());
   SCOPE_EXIT {
@@ -170,9 +202,13 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 SemiFuture<BackingStore::GetBlobRes> GitBackingStore::getBlob(
     const ObjectId& id,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetBlobRes{
-      getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             &pool_,
+             [this, id] {
+               return BackingStore::GetBlobRes{
+                   getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
 }
 
 unique_ptr<Blob> GitBackingStore::getBlobImpl(const ObjectId& id) {
@@ -180,7 +216,7 @@ unique_ptr<Blob> GitBackingStore::getBlobImpl(const ObjectId& id) {
 
   auto blobOID = hash2Oid(id);
   git_blob* blob = nullptr;
-  int error = git_blob_lookup(&blob, repo_, &blobOID);
+  int error = git_blob_lookup(&blob, getRepository(), &blobOID);
   gitCheckError(
       error, "unable to find git blob ", id, " in repository ", getPath());
 
@@ -8,10 +8,12 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/ThreadLocal.h>
 
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 struct git_oid;
 struct git_repository;
@@ -20,6 +22,10 @@ namespace facebook::eden {
 
 /**
  * A BackingStore implementation that loads data out of a git repository.
+ *
+ * Objects are read on a pool of threads so that many can be read from the
+ * object database at once. libgit2 repository handles can't be shared between
+ * threads, so each pool thread opens its own.
  */
 class GitBackingStore final : public BackingStore {
  public:
@@ -81,12 +87,45 @@ class GitBackingStore final : public BackingStore {
   std::unique_ptr<Tree> getTreeImpl(const ObjectId& id);
   std::unique_ptr<Blob> getBlobImpl(const ObjectId& id);
 
+  /**
+   * A repository handle owned by a single thread.
+   */
+  struct RepositoryHandle {
+    explicit RepositoryHandle(const std::string& path);
+    ~RepositoryHandle();
+
+    RepositoryHandle(const RepositoryHandle&) = delete;
+    RepositoryHandle& operator=(const RepositoryHandle&) = delete;
+
+    git_repository* repo{nullptr};
+  };
+
+  /**
+   * Calls git_libgit2_init() and git_libgit2_shutdown(), so that libgit2 is
+   * initialized for as long as any repository handle exists.
+   */
+  struct LibGit2Initializer {
+    LibGit2Initializer();
+    ~LibGit2Initializer();
+  };
+
+  /**
+   * Return the repository handle of the calling thread.
+   */
+  git_repository* getRepository();
+
+  std::unique_ptr<Tree> getRootTreeImpl(const RootId& rootId);
+
   static git_oid root2Oid(const RootId& rootId);
 
   static git_oid hash2Oid(const ObjectId& hash);
   static ObjectId oid2Hash(const git_oid* oid);
 
-  git_repository* repo_{nullptr};
+  LibGit2Initializer libgit2_;
+  std::string path_;
+  folly::ThreadLocal<RepositoryHandle> threadRepositories_;
+  /// Declared last so that the threads stop before their handles are freed.
+  UnboundedQueueExecutor pool_;
 };
 
 } // namespace facebook::eden
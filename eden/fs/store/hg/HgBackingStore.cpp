@@ -177,7 +177,8 @@ HgBackingStore::HgBackingStore(
           useEdenApi_,
           config->getEdenConfig()->useAuxMetadata.getValue(),
           false, // allowRetries
-          config),
+          config,
+          serverThreadPool),
       logger_(logger) {
   HgImporter importer(repository, stats);
   const auto& options = importer.getOptions();
@@ -209,6 +210,13 @@ HgBackingStore::HgBackingStore(
 
 HgBackingStore::~HgBackingStore() = default;
 
+bool HgBackingStore::useImporterFallback() const {
+  // Without EdenAPI the native backing store only reads the local caches, so
+  // HgImporter is the only way to reach the server.
+  return !useEdenApi_ ||
+      config_->getEdenConfig()->hgImporterFallback.getValue();
+}
+
 SemiFuture<unique_ptr<Tree>> HgBackingStore::getRootTree(const RootId& rootId) {
   ObjectId commitId = hashFromRootId(rootId);
 
@@ -298,6 +306,14 @@ HgBackingStore::fetchTreeFromHgCacheOrImporter(
       auto ew = folly::exception_wrapper(std::current_exception());
       return folly::makeFuture<unique_ptr<Tree>>(ew);
     }
+    stats_->getHgBackingStoreStatsForCurrentThread()
+        .importerFallbackTree.addValue(1);
+    if (!useImporterFallback()) {
+      return folly::makeFuture<unique_ptr<Tree>>(std::domain_error(fmt::format(
+          "tree {} for path \"{}\" was not found by the native backing store",
+          manifestNode.toString(),
+          path)));
+    }
     return fetchTreeFromImporter(
         manifestNode, edenTreeID, std::move(path), std::move(writeBatch));
   }
@@ -517,6 +533,10 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
 
 folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifest(
     const ObjectId& commitId) {
+  // The native backing store can't resolve commits, but this only happens
+  // once per root tree.
+  stats_->getHgBackingStoreStatsForCurrentThread()
+      .importerManifestNode.addValue(1);
   return folly::via(
              importThreadPool_.get(),
              [commitId] {
@@ -573,6 +593,15 @@ folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
 
 SemiFuture<std::unique_ptr<Blob>> HgBackingStore::fetchBlobFromHgImporter(
     HgProxyHash hgInfo) {
+  stats_->getHgBackingStoreStatsForCurrentThread()
+      .importerFallbackBlob.addValue(1);
+  if (!useImporterFallback()) {
+    return folly::makeSemiFuture<std::unique_ptr<Blob>>(
+        std::domain_error(fmt::format(
+            "blob {} for path \"{}\" was not found by the native backing store",
+            hgInfo.revHash().toString(),
+            hgInfo.path())));
+  }
   return folly::via(
       importThreadPool_.get(),
       [this,
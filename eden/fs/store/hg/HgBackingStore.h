@@ -112,6 +112,11 @@ class HgBackingStore {
 
   // Get blob step functions
 
+  /**
+   * Import a blob the native backing store could not find through the
+   * HgImporter subprocess. Fails without trying when the fallback is
+   * disabled, see the hg:importer-fallback config.
+   */
   folly::SemiFuture<std::unique_ptr<Blob>> fetchBlobFromHgImporter(
       HgProxyHash hgInfo);
 
@@ -132,6 +137,13 @@ class HgBackingStore {
       Hash20 manifestNode);
 
   void initializeDatapackImport(AbsolutePathPiece repository);
+
+  /**
+   * Whether objects the native backing store misses should be fetched
+   * through HgImporter.
+   */
+  bool useImporterFallback() const;
+
   folly::Future<std::unique_ptr<Tree>> importTreeImpl(
       const Hash20& manifestNode,
       const ObjectId& edenTreeID,
@@ -10,6 +10,7 @@
 #include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <memory>
 #include <optional>
 
@@ -78,12 +79,12 @@ std::unique_ptr<Tree> fromRawTree(
     HgObjectIdFormat hgObjectIdFormat,
     LocalStore::WriteBatch* FOLLY_NULLABLE writeBatch) {
   std::vector<TreeEntry> entries;
+  entries.reserve(tree->length);
 
   for (uintptr_t i = 0; i < tree->length; i++) {
     try {
-      auto entry = fromRawTreeEntry(
-          tree->entries[i], path, hgObjectIdFormat, writeBatch);
-      entries.push_back(entry);
+      entries.push_back(fromRawTreeEntry(
+          tree->entries[i], path, hgObjectIdFormat, writeBatch));
     } catch (const PathComponentContainsDirectorySeparator& ex) {
       XLOG(WARN) << "Ignoring directory entry: " << ex.what();
     }
@@ -93,8 +94,74 @@ std::unique_ptr<Tree> fromRawTree(
   }
   return std::make_unique<Tree>(std::move(entries), edenTreeId);
 }
+
+using BatchRequests =
+    std::vector<std::pair<folly::ByteRange, folly::ByteRange>>;
+
+/**
+ * Call `fetch(requests, local, resolve)` once to look up all of `requests`
+ * locally, then again for the ones that were not found, fetching at most
+ * `subBatchSize` of them remotely per call. `resolve` is called with indices
+ * into `requests` and must set `imported` for every index it is given.
+ */
+template <typename Content, typename Fetch, typename Resolve>
+void fetchInSubBatches(
+    const BatchRequests& requests,
+    const std::vector<bool>& imported,
+    size_t subBatchSize,
+    Fetch&& fetch,
+    Resolve& resolve) {
+  fetch(
+      requests,
+      /*local=*/true,
+      [&resolve](size_t index, Content content) {
+        resolve(index, std::move(content));
+      });
+
+  std::vector<size_t> missing;
+  for (size_t index = 0; index < requests.size(); ++index) {
+    if (!imported[index]) {
+      missing.push_back(index);
+    }
+  }
+  if (subBatchSize == 0) {
+    subBatchSize = missing.size();
+  }
+
+  for (size_t start = 0; start < missing.size(); start += subBatchSize) {
+    auto end = std::min(start + subBatchSize, missing.size());
+    BatchRequests subBatch;
+    subBatch.reserve(end - start);
+    for (auto i = start; i < end; ++i) {
+      subBatch.push_back(requests[missing[i]]);
+    }
+    fetch(
+        subBatch,
+        /*local=*/false,
+        [&resolve, &missing, start](size_t index, Content content) {
+          resolve(missing[start + index], std::move(content));
+        });
+  }
+}
 } // namespace
 
+template <typename T>
+void HgDatapackStore::complete(
+    bool streamed,
+    std::shared_ptr<HgImportRequest> request,
+    std::unique_ptr<T> object,
+    RequestMetricsScope watch) {
+  if (streamed && completionExecutor_) {
+    completionExecutor_->add([request = std::move(request),
+                              object = std::move(object),
+                              watch = std::move(watch)]() mutable {
+      request->getPromise<std::unique_ptr<T>>()->setValue(std::move(object));
+    });
+  } else {
+    request->getPromise<std::unique_ptr<T>>()->setValue(std::move(object));
+  }
+}
+
 std::unique_ptr<Blob> HgDatapackStore::getBlobLocal(
     const ObjectId& id,
     const HgProxyHash& hgInfo) {
@@ -127,11 +194,11 @@ std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
   return nullptr;
 }
 
-void HgDatapackStore::getBlobBatch(
+std::vector<bool> HgDatapackStore::getBlobBatch(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
   size_t count = importRequests.size();
 
-  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
+  BatchRequests requests;
   requests.reserve(count);
 
   for (const auto& importRequest : importRequests) {
@@ -148,35 +215,55 @@ void HgDatapackStore::getBlobBatch(
     requestsWatches.emplace_back(&liveBatchedBlobWatches_);
   }
 
-  store_.getBlobBatch(
-      requests,
-      false,
-      // store_.getBlobBatch is blocking, hence we can take these by reference.
-      [&importRequests, &requests, &requestsWatches](
-          size_t index, std::unique_ptr<folly::IOBuf> content) {
-        XLOGF(
-            DBG9,
-            "Imported name={} node={}",
-            folly::StringPiece{requests[index].first},
-            folly::hexlify(requests[index].second));
-        auto& importRequest = importRequests[index];
-        auto* blobRequest =
-            importRequest->getRequest<HgImportRequest::BlobImport>();
-        auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
-        importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
-            std::move(blob));
-
-        // Make sure that we're stopping this watch.
-        auto watch = std::move(requestsWatches[index]);
-      });
+  auto config = config_->getEdenConfig();
+  bool streamed = config->streamImportBatches.getValue();
+  std::vector<bool> imported(count, false);
+
+  // store_.getBlobBatch is blocking, hence we can take these by reference.
+  auto resolve = [this,
+                  streamed,
+                  &importRequests,
+                  &requests,
+                  &requestsWatches,
+                  &imported](
+                     size_t index, std::unique_ptr<folly::IOBuf> content) {
+    XLOGF(
+        DBG9,
+        "Imported name={} node={}",
+        folly::StringPiece{requests[index].first},
+        folly::hexlify(requests[index].second));
+    auto& importRequest = importRequests[index];
+    auto* blobRequest =
+        importRequest->getRequest<HgImportRequest::BlobImport>();
+    imported[index] = true;
+    complete(
+        streamed,
+        importRequest,
+        std::make_unique<Blob>(blobRequest->hash, std::move(*content)),
+        std::move(requestsWatches[index]));
+  };
+
+  if (streamed) {
+    fetchInSubBatches<std::unique_ptr<folly::IOBuf>>(
+        requests,
+        imported,
+        config->importRemoteSubBatchSize.getValue(),
+        [this](const BatchRequests& batch, bool local, auto&& callback) {
+          store_.getBlobBatch(batch, local, std::move(callback));
+        },
+        resolve);
+  } else {
+    store_.getBlobBatch(requests, false, std::move(resolve));
+  }
+  return imported;
 }
 
-void HgDatapackStore::getTreeBatch(
+std::vector<bool> HgDatapackStore::getTreeBatch(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests,
     LocalStore::WriteBatch* writeBatch) {
   auto count = importRequests.size();
 
-  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
+  BatchRequests requests;
   requests.reserve(count);
 
   for (const auto& importRequest : importRequests) {
@@ -192,40 +279,60 @@ void HgDatapackStore::getTreeBatch(
     requestsWatches.emplace_back(&liveBatchedTreeWatches_);
   }
 
-  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+  auto config = config_->getEdenConfig();
+  auto hgObjectIdFormat = config->hgObjectIdFormat.getValue();
+  bool streamed = config->streamImportBatches.getValue();
+  std::vector<bool> imported(count, false);
+
+  // store_.getTreeBatch is blocking, hence we can take these by reference.
+  // The tree is converted here since writeBatch may only be used on this
+  // thread.
+  auto resolve = [this,
+                  streamed,
+                  hgObjectIdFormat,
+                  &requests,
+                  &importRequests,
+                  &requestsWatches,
+                  &imported,
+                  writeBatch](size_t index, std::shared_ptr<RustTree> content) {
+    XLOGF(
+        DBG4,
+        "Imported tree name={} node={}",
+        folly::StringPiece{requests[index].first},
+        folly::hexlify(requests[index].second));
+    auto& importRequest = importRequests[index];
+    auto* treeRequest =
+        importRequest->getRequest<HgImportRequest::TreeImport>();
+
+    auto tree = fromRawTree(
+        content.get(),
+        treeRequest->hash,
+        treeRequest->proxyHash.path(),
+        hgObjectIdFormat,
+        (hgObjectIdFormat != HgObjectIdFormat::ProxyHash) ? nullptr
+                                                          : writeBatch);
 
-  store_.getTreeBatch(
-      requests,
-      false,
-      // store_.getTreeBatch is blocking, hence we can take these by reference.
-      [hgObjectIdFormat,
-       &requests,
-       &importRequests,
-       &requestsWatches,
-       writeBatch](size_t index, std::shared_ptr<RustTree> content) mutable {
-        XLOGF(
-            DBG4,
-            "Imported tree name={} node={}",
-            folly::StringPiece{requests[index].first},
-            folly::hexlify(requests[index].second));
-        auto& importRequest = importRequests[index];
-        auto* treeRequest =
-            importRequest->getRequest<HgImportRequest::TreeImport>();
-
-        auto tree = fromRawTree(
-            content.get(),
-            treeRequest->hash,
-            treeRequest->proxyHash.path(),
-            hgObjectIdFormat,
-            (hgObjectIdFormat != HgObjectIdFormat::ProxyHash) ? nullptr
-                                                              : writeBatch);
-
-        importRequest->getPromise<std::unique_ptr<Tree>>()->setValue(
-            std::move(tree));
-
-        // Make sure that we're stopping this watch.
-        auto watch = std::move(requestsWatches[index]);
-      });
+    imported[index] = true;
+    complete(
+        streamed,
+        importRequest,
+        std::move(tree),
+        std::move(requestsWatches[index]));
+  };
+
+  if (streamed) {
+    fetchInSubBatches<std::shared_ptr<RustTree>>(
+        requests,
+        imported,
+        config->importRemoteSubBatchSize.getValue(),
+        [this](const BatchRequests& batch, bool local, auto&& callback) {
+          store_.getTreeBatch(batch, local, std::move(callback));
+        },
+        resolve);
+  } else {
+    store_.getTreeBatch(requests, false, std::move(resolve));
+  }
+  return imported;
 }
 
 std::unique_ptr<Tree> HgDatapackStore::getTree(
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/Executor.h>
 #include <folly/Range.h>
 #include <folly/futures/Promise.h>
 
@@ -30,9 +31,11 @@ class HgDatapackStore {
       bool useEdenApi,
       bool useAuxData,
       bool allowRetries,
-      std::shared_ptr<ReloadableConfig> config)
+      std::shared_ptr<ReloadableConfig> config,
+      folly::Executor* completionExecutor = nullptr)
       : store_{repository.stringPiece(), useEdenApi, useAuxData, allowRetries},
-        config_{std::move(config)} {}
+        config_{std::move(config)},
+        completionExecutor_{completionExecutor} {}
 
   /**
    * Imports the blob identified by the given hash from the local store.
@@ -52,14 +55,20 @@ class HgDatapackStore {
       LocalStore& localStore);
 
   /**
-   * Import multiple blobs at once. The vector parameters have to be the same
-   * length. Promises passed in will be resolved if a blob is successfully
-   * imported. Otherwise the promise will be left untouched.
+   * Import multiple blobs at once. The promise of every request whose blob
+   * is successfully imported will be resolved, the others are left untouched.
+   *
+   * Returns whether each request was imported. With
+   * `hg:stream-import-batches` enabled, promises are resolved on the
+   * completion executor and may not be fulfilled yet when this returns.
    */
-  void getBlobBatch(
+  std::vector<bool> getBlobBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests);
 
-  void getTreeBatch(
+  /**
+   * Import multiple trees at once, like getBlobBatch.
+   */
+  std::vector<bool> getTreeBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests,
       LocalStore::WriteBatch* writeBatch);
 
@@ -99,8 +108,22 @@ class HgDatapackStore {
   }
 
  private:
+  /**
+   * Fulfil the promise of `request` with `object`, on the completion
+   * executor if batches are streamed. `watch` is released once the promise
+   * has been fulfilled.
+   */
+  template <typename T>
+  void complete(
+      bool streamed,
+      std::shared_ptr<HgImportRequest> request,
+      std::unique_ptr<T> object,
+      RequestMetricsScope watch);
+
   HgNativeBackingStore store_;
   std::shared_ptr<ReloadableConfig> config_;
+  /// Where streamed batches fulfil their promises. May be null.
+  folly::Executor* completionExecutor_;
 
   mutable RequestMetricsScope::LockedRequestWatchList liveBatchedBlobWatches_;
   mutable RequestMetricsScope::LockedRequestWatchList liveBatchedTreeWatches_;
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportBatchController.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+
+/// Weight of the latest batch in the throughput moving average.
+constexpr double kThroughputWeight = 0.2;
+
+/**
+ * Throughput may dip this far below its moving average before the batch size
+ * stops growing. Some noise between batches is expected.
+ */
+constexpr double kThroughputTolerance = 0.9;
+
+size_t clamp(size_t value, size_t max) {
+  return std::clamp<size_t>(value, 1, std::max<size_t>(max, 1));
+}
+
+} // namespace
+
+size_t HgImportBatchController::getBatchSize(Kind kind, size_t maxBatchSize)
+    const {
+  auto state = state_.lock();
+  auto& kindState = state->kinds[static_cast<size_t>(kind)];
+  return clamp(kindState.batchSize, maxBatchSize);
+}
+
+size_t HgImportBatchController::getConcurrency(size_t maxConcurrency) const {
+  return clamp(state_.lock()->concurrency, maxConcurrency);
+}
+
+void HgImportBatchController::recordBatch(
+    Kind kind,
+    size_t batchSize,
+    std::chrono::nanoseconds latency,
+    const Limits& limits) {
+  auto seconds = std::chrono::duration<double>(latency).count();
+  auto throughput = seconds > 0 ? batchSize / seconds : 0;
+
+  auto state = state_.lock();
+  auto& kindState = state->kinds[static_cast<size_t>(kind)];
+  kindState.batchSize = clamp(kindState.batchSize, limits.maxBatchSize);
+  state->concurrency = clamp(state->concurrency, limits.maxConcurrency);
+
+  auto previousThroughput = kindState.throughput;
+  kindState.throughput = previousThroughput == 0
+      ? throughput
+      : (1 - kThroughputWeight) * previousThroughput +
+          kThroughputWeight * throughput;
+
+  if (latency > limits.targetLatency) {
+    if (kindState.batchSize > 1) {
+      kindState.batchSize = std::max<size_t>(kindState.batchSize / 2, 1);
+    } else {
+      state->concurrency = std::max<size_t>(state->concurrency / 2, 1);
+    }
+    return;
+  }
+
+  // A batch smaller than the target says nothing about whether a larger one
+  // would do better: the queue simply did not have more requests.
+  if (batchSize < kindState.batchSize ||
+      throughput < kThroughputTolerance * previousThroughput) {
+    return;
+  }
+
+  if (kindState.batchSize < limits.maxBatchSize) {
+    ++kindState.batchSize;
+  } else if (state->concurrency < limits.maxConcurrency) {
+    ++state->concurrency;
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <array>
+#include <chrono>
+#include <mutex>
+
+namespace facebook::eden {
+
+/**
+ * Tunes the size of import batches and the number of batches imported
+ * concurrently from the latency and throughput of recent batches.
+ *
+ * This is an additive-increase/multiplicative-decrease controller. While
+ * batches complete within the target latency and throughput is not falling,
+ * the batch size grows by one after every full batch, and once it reaches
+ * its maximum the concurrency grows by one instead. A batch that takes
+ * longer than the target latency halves the batch size, or the concurrency
+ * once the batch size is down to one.
+ *
+ * The limits are passed in on every call so that config changes take effect
+ * immediately. It is safe to use this object from arbitrary threads.
+ */
+class HgImportBatchController {
+ public:
+  enum class Kind { Blob, Tree };
+
+  struct Limits {
+    size_t maxBatchSize;
+    size_t maxConcurrency;
+    std::chrono::nanoseconds targetLatency;
+  };
+
+  /**
+   * The number of requests of the given kind to import per batch, between 1
+   * and maxBatchSize.
+   */
+  size_t getBatchSize(Kind kind, size_t maxBatchSize) const;
+
+  /**
+   * The number of batches to import at the same time, between 1 and
+   * maxConcurrency.
+   */
+  size_t getConcurrency(size_t maxConcurrency) const;
+
+  /**
+   * Update the targets after a batch of `batchSize` requests took `latency`
+   * to import.
+   */
+  void recordBatch(
+      Kind kind,
+      size_t batchSize,
+      std::chrono::nanoseconds latency,
+      const Limits& limits);
+
+ private:
+  struct KindState {
+    size_t batchSize = 1;
+    /// Exponentially weighted moving average, in requests per second.
+    double throughput = 0;
+  };
+
+  struct State {
+    std::array<KindState, 2> kinds;
+    size_t concurrency = 1;
+  };
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -10,6 +10,7 @@
 #include <folly/Try.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <algorithm>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 
@@ -20,22 +21,39 @@ HgImportRequest::HgImportRequest(
     RequestType request,
     ImportPriority priority,
     ObjectFetchContext::Cause cause,
+    std::optional<pid_t> pid,
+    std::optional<uint64_t> requestId,
+    folly::CancellationToken cancellation,
     folly::Promise<typename RequestType::Response>&& promise)
     : request_(std::move(request)),
       priority_(priority),
       cause_(cause),
-      promise_(std::move(promise)) {}
+      pid_(pid),
+      requestId_(requestId),
+      promise_(std::move(promise)) {
+  if (cancellation.canBeCancelled()) {
+    cancellableWaiters_.push_back(std::move(cancellation));
+  } else {
+    hasUncancellableWaiter_ = true;
+  }
+}
 
 template <typename RequestType, typename... Input>
 std::shared_ptr<HgImportRequest> HgImportRequest::makeRequest(
     ImportPriority priority,
     ObjectFetchContext::Cause cause,
+    std::optional<pid_t> pid,
+    std::optional<uint64_t> requestId,
+    folly::CancellationToken cancellation,
     Input&&... input) {
   auto promise = folly::Promise<typename RequestType::Response>{};
   return std::make_shared<HgImportRequest>(
       RequestType{std::forward<Input>(input)...},
       priority,
       cause,
+      pid,
+      requestId,
+      std::move(cancellation),
       std::move(promise));
 }
 
@@ -43,16 +61,54 @@ std::shared_ptr<HgImportRequest> HgImportRequest::makeBlobImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
     ImportPriority priority,
-    ObjectFetchContext::Cause cause) {
-  return makeRequest<BlobImport>(priority, cause, hash, std::move(proxyHash));
+    ObjectFetchContext::Cause cause,
+    std::optional<pid_t> pid,
+    std::optional<uint64_t> requestId,
+    folly::CancellationToken cancellation) {
+  return makeRequest<BlobImport>(
+      priority,
+      cause,
+      pid,
+      requestId,
+      std::move(cancellation),
+      hash,
+      std::move(proxyHash));
 }
 
 std::shared_ptr<HgImportRequest> HgImportRequest::makeTreeImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
     ImportPriority priority,
-    ObjectFetchContext::Cause cause) {
-  return makeRequest<TreeImport>(priority, cause, hash, std::move(proxyHash));
+    ObjectFetchContext::Cause cause,
+    std::optional<pid_t> pid,
+    std::optional<uint64_t> requestId,
+    folly::CancellationToken cancellation) {
+  return makeRequest<TreeImport>(
+      priority,
+      cause,
+      pid,
+      requestId,
+      std::move(cancellation),
+      hash,
+      std::move(proxyHash));
+}
+
+void HgImportRequest::addWaitersOf(const HgImportRequest& other) {
+  cancellableWaiters_.insert(
+      cancellableWaiters_.end(),
+      other.cancellableWaiters_.begin(),
+      other.cancellableWaiters_.end());
+  hasUncancellableWaiter_ |= other.hasUncancellableWaiter_;
+}
+
+bool HgImportRequest::isAbandoned() const {
+  return !hasUncancellableWaiter_ &&
+      std::all_of(
+             cancellableWaiters_.begin(),
+             cancellableWaiters_.end(),
+             [](const folly::CancellationToken& cancellation) {
+               return cancellation.isCancellationRequested();
+             });
 }
 
 } // namespace facebook::eden
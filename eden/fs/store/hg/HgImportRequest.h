@@ -7,9 +7,13 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/futures/Promise.h>
+#include <folly/small_vector.h>
+#include <optional>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
@@ -31,29 +35,36 @@ namespace facebook::eden {
  */
 class HgImportRequest {
  public:
+  /**
+   * Promises of the requests that were de-duplicated to an import. Most
+   * imports have at most one, so it is stored inline.
+   */
+  template <typename Response>
+  using DuplicatePromises = folly::small_vector<folly::Promise<Response>, 1>;
+
   struct BlobImport {
     using Response = std::unique_ptr<Blob>;
     BlobImport(ObjectId hash, HgProxyHash proxyHash)
-        : hash(hash), proxyHash(proxyHash) {}
+        : hash(std::move(hash)), proxyHash(std::move(proxyHash)) {}
 
     ObjectId hash;
     HgProxyHash proxyHash;
 
     // In the case where requests de-duplicate to this one, the requests
     // promise will be enqueued to the following vector.
-    std::vector<folly::Promise<Response>> promises;
+    DuplicatePromises<Response> promises;
   };
 
   struct TreeImport {
     using Response = std::unique_ptr<Tree>;
     TreeImport(ObjectId hash, HgProxyHash proxyHash)
-        : hash(hash), proxyHash(proxyHash) {}
+        : hash(std::move(hash)), proxyHash(std::move(proxyHash)) {}
 
     ObjectId hash;
     HgProxyHash proxyHash;
 
     // See the comment above for BlobImport::promises
-    std::vector<folly::Promise<Response>> promises;
+    DuplicatePromises<Response> promises;
   };
 
   /**
@@ -63,7 +74,10 @@ class HgImportRequest {
       ObjectId hash,
       HgProxyHash proxyHash,
       ImportPriority priority,
-      ObjectFetchContext::Cause cause);
+      ObjectFetchContext::Cause cause,
+      std::optional<pid_t> pid = std::nullopt,
+      std::optional<uint64_t> requestId = std::nullopt,
+      folly::CancellationToken cancellation = {});
 
   /**
    * Allocate a tree request.
@@ -72,7 +86,10 @@ class HgImportRequest {
       ObjectId hash,
       HgProxyHash proxyHash,
       ImportPriority priority,
-      ObjectFetchContext::Cause cause);
+      ObjectFetchContext::Cause cause,
+      std::optional<pid_t> pid = std::nullopt,
+      std::optional<uint64_t> requestId = std::nullopt,
+      folly::CancellationToken cancellation = {});
 
   /**
    * Implementation detail of the make*Request functions from above. Do not use
@@ -83,6 +100,9 @@ class HgImportRequest {
       RequestType request,
       ImportPriority priority,
       ObjectFetchContext::Cause cause,
+      std::optional<pid_t> pid,
+      std::optional<uint64_t> requestId,
+      folly::CancellationToken cancellation,
       folly::Promise<typename RequestType::Response>&& promise);
 
   ~HgImportRequest() = default;
@@ -112,10 +132,63 @@ class HgImportRequest {
     return cause_;
   }
 
+  /**
+   * The pid of the process that caused this import, if known.
+   */
+  std::optional<pid_t> getPid() const noexcept {
+    return pid_;
+  }
+
+  /**
+   * The id of the FUSE, NFS or Thrift request that caused this import, if
+   * known. See ObjectFetchContext::getRequestId.
+   */
+  std::optional<uint64_t> getRequestId() const noexcept {
+    return requestId_;
+  }
+
   void setPriority(ImportPriority priority) noexcept {
     priority_ = priority;
   }
 
+  /**
+   * Whether the request was dequeued and handed to an importer. Like the
+   * priority, this is only accessed under the HgImportRequestQueue lock.
+   */
+  bool isDispatched() const noexcept {
+    return dispatched_;
+  }
+
+  void markDispatched() noexcept {
+    dispatched_ = true;
+  }
+
+  /**
+   * Take over the waiters of a request that was de-duplicated to this one.
+   * Once enqueued, the waiters are only accessed under the lock of the
+   * request's HgImportRequestQueue tracker shard.
+   */
+  void addWaitersOf(const HgImportRequest& other);
+
+  /**
+   * Whether the cancellation token of every caller waiting on this import
+   * was cancelled, so that it needn't run.
+   */
+  bool isAbandoned() const;
+
+  /**
+   * The position of the request in its HgImportRequestQueue heap while it is
+   * queued, so that raising its priority doesn't need to search for it. Only
+   * accessed under the HgImportRequestQueue lock.
+   */
+  size_t getQueueIndex() const noexcept {
+    return queueIndex_;
+  }
+
+  void setQueueIndex(size_t index) noexcept {
+    queueIndex_ = index;
+  }
+
   template <typename T>
   folly::Promise<T>* getPromise() {
     auto promise = std::get_if<folly::Promise<T>>(&promise_); // Promise<T>
@@ -142,6 +215,9 @@ class HgImportRequest {
   static std::shared_ptr<HgImportRequest> makeRequest(
       ImportPriority priority,
       ObjectFetchContext::Cause cause,
+      std::optional<pid_t> pid,
+      std::optional<uint64_t> requestId,
+      folly::CancellationToken cancellation,
       Input&&... input);
 
   HgImportRequest(const HgImportRequest&) = delete;
@@ -155,6 +231,15 @@ class HgImportRequest {
   Request request_;
   ImportPriority priority_;
   ObjectFetchContext::Cause cause_;
+  std::optional<pid_t> pid_;
+  std::optional<uint64_t> requestId_;
+  bool dispatched_ = false;
+  /// The tokens of the waiters that may go away.
+  std::vector<folly::CancellationToken> cancellableWaiters_;
+  /// Whether a waiter stays interested regardless, like a background
+  /// prefetch.
+  bool hasUncancellableWaiter_ = false;
+  size_t queueIndex_ = 0;
   Response promise_;
   uint64_t unique_ = generateUniqueID();
   std::chrono::steady_clock::time_point requestTime_ =
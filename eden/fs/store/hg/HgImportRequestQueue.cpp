@@ -6,12 +6,200 @@
  */
 
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include <folly/CancellationToken.h>
+#include <folly/MapUtil.h>
 #include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
 #include <algorithm>
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/telemetry/EdenStats.h"
 
 namespace facebook::eden {
 
+namespace {
+
+using RequestHeap = std::vector<std::shared_ptr<HgImportRequest>>;
+
+/**
+ * The client heaps are maintained by hand rather than with std::push_heap
+ * and friends so that every request knows its index, which lets a raised
+ * priority be fixed up in O(log n).
+ */
+void placeRequest(
+    RequestHeap& heap,
+    size_t index,
+    std::shared_ptr<HgImportRequest> request) {
+  request->setQueueIndex(index);
+  heap[index] = std::move(request);
+}
+
+void siftUp(RequestHeap& heap, size_t index) {
+  auto request = std::move(heap[index]);
+  while (index > 0) {
+    auto parent = (index - 1) / 2;
+    if (!(*heap[parent] < *request)) {
+      break;
+    }
+    placeRequest(heap, index, std::move(heap[parent]));
+    index = parent;
+  }
+  placeRequest(heap, index, std::move(request));
+}
+
+void siftDown(RequestHeap& heap, size_t index) {
+  auto request = std::move(heap[index]);
+  while (true) {
+    auto child = 2 * index + 1;
+    if (child >= heap.size()) {
+      break;
+    }
+    if (child + 1 < heap.size() && *heap[child] < *heap[child + 1]) {
+      ++child;
+    }
+    if (!(*request < *heap[child])) {
+      break;
+    }
+    placeRequest(heap, index, std::move(heap[child]));
+    index = child;
+  }
+  placeRequest(heap, index, std::move(request));
+}
+
+std::shared_ptr<HgImportRequest> popHeap(RequestHeap& heap) {
+  auto top = std::move(heap.front());
+  auto last = std::move(heap.back());
+  heap.pop_back();
+  if (!heap.empty()) {
+    heap.front() = std::move(last);
+    siftDown(heap, 0);
+  }
+  return top;
+}
+
+uint64_t clientKey(const HgImportRequest& request) {
+  if (auto pid = request.getPid()) {
+    return static_cast<uint32_t>(*pid);
+  }
+  // Keep requests with no known pid apart from every real pid.
+  return (uint64_t{1} << 63) | static_cast<uint64_t>(request.getCause());
+}
+
+/**
+ * The priority of a request, raised by one class for every agingInterval it
+ * has been waiting.
+ */
+ImportPriority agedPriority(
+    const HgImportRequest& request,
+    std::chrono::steady_clock::time_point now,
+    std::chrono::nanoseconds agingInterval) {
+  auto priority = request.getPriority();
+  if (agingInterval.count() <= 0) {
+    return priority;
+  }
+  auto steps = (now - request.getRequestTime()) / agingInterval;
+  auto kind = std::min<int64_t>(
+      static_cast<int64_t>(priority.kind) + steps,
+      static_cast<int64_t>(ImportPriorityKind::High));
+  return ImportPriority{static_cast<ImportPriorityKind>(kind), priority.offset};
+}
+
+} // namespace
+
+void HgImportRequestQueue::FairQueue::push(
+    std::shared_ptr<HgImportRequest> request) {
+  auto key = clientKey(*request);
+  auto [it, inserted] = clients_.try_emplace(key);
+  if (inserted) {
+    rotation_.push_back(key);
+  }
+  auto& heap = it->second.heap;
+  heap.emplace_back(std::move(request));
+  siftUp(heap, heap.size() - 1);
+  ++size_;
+}
+
+bool HgImportRequestQueue::FairQueue::priorityRaised(
+    const HgImportRequest& request) {
+  auto* client = folly::get_ptr(clients_, clientKey(request));
+  auto index = request.getQueueIndex();
+  if (!client || index >= client->heap.size() ||
+      client->heap[index].get() != &request) {
+    // Already dequeued.
+    return false;
+  }
+  siftUp(client->heap, index);
+  return true;
+}
+
+ImportPriority HgImportRequestQueue::FairQueue::highestPriority(
+    std::chrono::steady_clock::time_point now,
+    std::chrono::nanoseconds agingInterval) const {
+  XCHECK(!empty());
+  std::optional<ImportPriority> highest;
+  for (const auto& [key, client] : clients_) {
+    auto priority = agedPriority(*client.heap.front(), now, agingInterval);
+    if (!highest || priority > *highest) {
+      highest = priority;
+    }
+  }
+  return *highest;
+}
+
+void HgImportRequestQueue::FairQueue::pop(
+    size_t count,
+    size_t quantum,
+    std::chrono::steady_clock::time_point now,
+    std::chrono::nanoseconds agingInterval,
+    std::vector<std::shared_ptr<HgImportRequest>>& out) {
+  auto kindOf = [&](const Client& client) {
+    return agedPriority(*client.heap.front(), now, agingInterval).kind;
+  };
+
+  while (out.size() < count && !empty()) {
+    // One round over the clients whose head is in the highest class.
+    auto kind = highestPriority(now, agingInterval).kind;
+    auto turns = rotation_.size();
+    for (size_t i = 0; i < turns && out.size() < count; ++i) {
+      auto key = rotation_.front();
+      rotation_.pop_front();
+      auto& client = clients_.at(key);
+
+      if (kindOf(client) == kind) {
+        client.deficit += quantum;
+        while (client.deficit > 0 && out.size() < count &&
+               !client.heap.empty() && kindOf(client) == kind) {
+          out.emplace_back(popHeap(client.heap));
+          --client.deficit;
+          --size_;
+        }
+      }
+
+      if (client.heap.empty()) {
+        clients_.erase(key);
+      } else {
+        rotation_.push_back(key);
+      }
+    }
+  }
+}
+
+std::vector<std::shared_ptr<HgImportRequest>>
+HgImportRequestQueue::FairQueue::takeAll() {
+  std::vector<std::shared_ptr<HgImportRequest>> result;
+  result.reserve(size_);
+  for (auto& [key, client] : clients_) {
+    result.insert(
+        result.end(),
+        std::make_move_iterator(client.heap.begin()),
+        std::make_move_iterator(client.heap.end()));
+  }
+  clients_.clear();
+  rotation_.clear();
+  size_ = 0;
+  return result;
+}
+
 void HgImportRequestQueue::stop() {
   auto state = state_.lock();
   if (state->running) {
@@ -32,59 +220,65 @@ folly::Future<std::unique_ptr<Tree>> HgImportRequestQueue::enqueueTree(
       std::move(request));
 }
 
+HgImportRequestQueue::RequestTracker& HgImportRequestQueue::trackerShard(
+    const ObjectId& id) {
+  // The F14 map in each shard also hashes the ObjectId, so mix the bits to
+  // avoid correlating shard selection with the bucket selection.
+  auto index = folly::hash::twang_mix64(id.getHashCode()) % kNumTrackerShards;
+  return trackerShards_[index].tracker;
+}
+
 template <typename Ret, typename ImportType>
 folly::Future<Ret> HgImportRequestQueue::enqueue(
     std::shared_ptr<HgImportRequest> request) {
-  auto state = state_.lock();
-
-  std::vector<std::shared_ptr<HgImportRequest>>* queue;
-  if constexpr (std::is_same_v<ImportType, HgImportRequest::BlobImport>) {
-    queue = &state->blobQueue;
-  } else {
-    static_assert(std::is_same_v<ImportType, HgImportRequest::TreeImport>);
-    queue = &state->treeQueue;
-  }
+  auto getQueue = [](State& state) -> FairQueue& {
+    if constexpr (std::is_same_v<ImportType, HgImportRequest::BlobImport>) {
+      return state.blobQueue;
+    } else {
+      static_assert(std::is_same_v<ImportType, HgImportRequest::TreeImport>);
+      return state.treeQueue;
+    }
+  };
 
   const auto& hash = request->getRequest<ImportType>()->hash;
-  if (auto* existingRequestPtr = folly::get_ptr(state->requestTracker, hash)) {
+  auto tracker = trackerShard(hash).lock();
+  if (auto* existingRequestPtr = folly::get_ptr(*tracker, hash)) {
     auto& existingRequest = *existingRequestPtr;
     auto* trackedImport = existingRequest->template getRequest<ImportType>();
+    existingRequest->addWaitersOf(*request);
 
-    auto [promise, future] = folly::makePromiseContract<Ret>();
-    trackedImport->promises.emplace_back(std::move(promise));
+    // Hand the new request's promise over to the tracked import, rather
+    // than allocating another one.
+    auto* promise = request->getPromise<Ret>();
+    auto future = promise->getFuture();
+    trackedImport->promises.emplace_back(std::move(*promise));
 
+    // The queued request's priority is read by dequeue, so it may only be
+    // changed while holding the state_ lock. The import inherits the
+    // priority of its most urgent waiter, so that an interactive request
+    // doesn't wait behind the prefetch that happened to queue it first.
     if (existingRequest->getPriority() < request->getPriority()) {
+      auto state = state_.lock();
       existingRequest->setPriority(request->getPriority());
+      bool promoted = getQueue(*state).priorityRaised(*existingRequest);
+      state.unlock();
 
-      // Since the new request has a higher priority than the already present
-      // one, we need to re-order the heap.
-      //
-      // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
-      // duplicated requests will thus lead to a quadratic complexity.
-      std::make_heap(
-          queue->begin(),
-          queue->end(),
-          [](const std::shared_ptr<HgImportRequest>& lhs,
-             const std::shared_ptr<HgImportRequest>& rhs) {
-            return (*lhs) < (*rhs);
-          });
+      if (promoted && stats_) {
+        stats_->getHgBackingStoreStatsForCurrentThread()
+            .importPromoted.addValue(1);
+      }
     }
 
-    return std::move(future).toUnsafeFuture();
+    return future;
   }
 
-  queue->emplace_back(request);
   auto promise = request->getPromise<Ret>();
-
-  state->requestTracker.emplace(hash, std::move(request));
-
-  std::push_heap(
-      queue->begin(),
-      queue->end(),
-      [](const std::shared_ptr<HgImportRequest>& lhs,
-         const std::shared_ptr<HgImportRequest>& rhs) {
-        return (*lhs) < (*rhs);
-      });
+  {
+    auto state = state_.lock();
+    getQueue(*state).push(request);
+  }
+  tracker->emplace(hash, std::move(request));
+  tracker.unlock();
 
   queueCV_.notify_one();
 
@@ -101,29 +295,130 @@ HgImportRequestQueue::combineAndClearRequestQueues() {
       "combineAndClearRequestQueues: tree queue size = {}, blob queue size = {}",
       treeQSz,
       blobQSz);
-  auto res = std::move(state->treeQueue);
+  auto res = state->treeQueue.takeAll();
+  auto blobs = state->blobQueue.takeAll();
   res.insert(
       res.end(),
-      std::make_move_iterator(state->blobQueue.begin()),
-      std::make_move_iterator(state->blobQueue.end()));
-  state->treeQueue.clear();
-  state->blobQueue.clear();
+      std::make_move_iterator(blobs.begin()),
+      std::make_move_iterator(blobs.end()));
   XCHECK_EQ(res.size(), treeQSz + blobQSz);
   return res;
 }
 
-std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
+std::vector<HgImportRequestQueue::LiveImport>
+HgImportRequestQueue::getLiveImports() const {
+  std::vector<std::shared_ptr<HgImportRequest>> requests;
+  for (const auto& shard : trackerShards_) {
+    auto tracker = shard.tracker.lock();
+    for (const auto& [id, request] : *tracker) {
+      requests.push_back(request);
+    }
+  }
+
+  std::vector<LiveImport> result;
+  result.reserve(requests.size());
+  // Take the state_ lock once, after the tracker shard locks were released,
+  // to read whether each request was dequeued.
+  auto state = state_.lock();
+  for (const auto& request : requests) {
+    result.push_back(LiveImport{
+        request->isType<HgImportRequest::TreeImport>(),
+        request->isDispatched(),
+        request->getRequestId(),
+        request->getRequestTime()});
+  }
+  return result;
+}
+
+size_t HgImportRequestQueue::estimateMemoryUsage() const {
+  // Every live request is in a tracker shard. A queued one is also pointed to
+  // by a client heap, which is counted as a second shared_ptr.
+  constexpr size_t kRequestSize = sizeof(HgImportRequest) +
+      2 * sizeof(void*) + sizeof(ObjectId) +
+      2 * sizeof(std::shared_ptr<HgImportRequest>);
+  size_t requests = 0;
+  for (const auto& shard : trackerShards_) {
+    requests += shard.tracker.lock()->size();
+  }
+  return requests * kRequestSize;
+}
+
+std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue(
+    size_t maxBlobBatchSize,
+    size_t maxTreeBatchSize) {
+  while (true) {
+    auto requests = popBatch(maxBlobBatchSize, maxTreeBatchSize);
+    if (requests.empty()) {
+      // The queue was stopped.
+      return requests;
+    }
+    dropAbandoned(requests);
+    if (!requests.empty()) {
+      return requests;
+    }
+  }
+}
+
+void HgImportRequestQueue::dropAbandoned(
+    std::vector<std::shared_ptr<HgImportRequest>>& requests) {
+  auto kept = requests.begin();
+  for (auto& request : requests) {
+    bool dropped = request->isType<HgImportRequest::BlobImport>()
+        ? dropIfAbandoned<HgImportRequest::BlobImport>(*request)
+        : dropIfAbandoned<HgImportRequest::TreeImport>(*request);
+    if (!dropped) {
+      *kept++ = std::move(request);
+    }
+  }
+  auto droppedCount = static_cast<size_t>(requests.end() - kept);
+  requests.erase(kept, requests.end());
+
+  if (droppedCount != 0 && stats_) {
+    stats_->getHgBackingStoreStatsForCurrentThread().importDropped.addValue(
+        droppedCount);
+  }
+}
+
+template <typename ImportType>
+bool HgImportRequestQueue::dropIfAbandoned(HgImportRequest& request) {
+  auto* import = request.getRequest<ImportType>();
+  {
+    // The waiters are added under the tracker lock, and once the request is
+    // no longer tracked none can be added.
+    auto tracker = trackerShard(import->hash).lock();
+    if (!request.isAbandoned()) {
+      return false;
+    }
+    tracker->erase(import->hash);
+  }
+
+  XLOGF(DBG4, "Dropping abandoned import of {}", import->hash);
+  request.getPromise<typename ImportType::Response>()->setException(
+      folly::OperationCancelled{});
+  for (auto& promise : import->promises) {
+    promise.setException(folly::OperationCancelled{});
+  }
+  return true;
+}
+
+std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::popBatch(
+    size_t maxBlobBatchSize,
+    size_t maxTreeBatchSize) {
   size_t count;
-  std::vector<std::shared_ptr<HgImportRequest>>* queue = nullptr;
+  FairQueue* queue = nullptr;
+  std::chrono::steady_clock::time_point now;
+  auto config = config_->getEdenConfig();
+  auto agingInterval = config->importPriorityAgingInterval.getValue();
 
   auto state = state_.lock();
   while (true) {
     if (!state->running) {
-      state->treeQueue.clear();
-      state->blobQueue.clear();
+      state->treeQueue.takeAll();
+      state->blobQueue.takeAll();
       return std::vector<std::shared_ptr<HgImportRequest>>();
     }
 
+    now = std::chrono::steady_clock::now();
     ImportPriority highestPriority{ImportPriorityKind::Low, 0};
 
     // Trees have a higher priority than blobs, thus check the queues in that
@@ -131,16 +426,18 @@ std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
     // allowing a higher fan-out and thus increasing concurrency of fetches
     // which translate onto a higher overall throughput.
     if (!state->treeQueue.empty()) {
-      count = config_->getEdenConfig()->importBatchSizeTree.getValue();
-      highestPriority = state->treeQueue.front()->getPriority();
+      count = std::min<size_t>(
+          config->importBatchSizeTree.getValue(), maxTreeBatchSize);
+      highestPriority = state->treeQueue.highestPriority(now, agingInterval);
       queue = &state->treeQueue;
     }
 
     if (!state->blobQueue.empty()) {
-      auto priority = state->blobQueue.front()->getPriority();
+      auto priority = state->blobQueue.highestPriority(now, agingInterval);
       if (!queue || priority > highestPriority) {
         queue = &state->blobQueue;
-        count = config_->getEdenConfig()->importBatchSize.getValue();
+        count = std::min<size_t>(
+            config->importBatchSize.getValue(), maxBlobBatchSize);
         highestPriority = priority;
       }
     }
@@ -152,20 +449,37 @@ std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
     }
   }
 
-  count = std::min(count, queue->size());
   std::vector<std::shared_ptr<HgImportRequest>> result;
-  result.reserve(count);
-  for (size_t i = 0; i < count; i++) {
-    std::pop_heap(
-        queue->begin(),
-        queue->end(),
-        [](const std::shared_ptr<HgImportRequest>& lhs,
-           const std::shared_ptr<HgImportRequest>& rhs) {
-          return (*lhs) < (*rhs);
-        });
-
-    result.emplace_back(std::move(queue->back()));
-    queue->pop_back();
+  result.reserve(std::min(count, queue->size()));
+  queue->pop(
+      count,
+      std::max<size_t>(config->importFairQueueQuantum.getValue(), 1),
+      now,
+      agingInterval,
+      result);
+  for (auto& request : result) {
+    request->markDispatched();
+  }
+  state.unlock();
+
+  if (stats_) {
+    auto& stats = stats_->getHgBackingStoreStatsForCurrentThread();
+    for (const auto& request : result) {
+      auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - request->getRequestTime())
+                        .count();
+      switch (request->getPriority().kind) {
+        case ImportPriorityKind::Low:
+          stats.queueWaitLow.addValue(waited);
+          break;
+        case ImportPriorityKind::Normal:
+          stats.queueWaitNormal.addValue(waited);
+          break;
+        case ImportPriorityKind::High:
+          stats.queueWaitHigh.addValue(waited);
+          break;
+      }
+    }
   }
 
   return result;
@@ -10,8 +10,14 @@
 #include <folly/Synchronized.h>
 #include <folly/Try.h>
 #include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <limits>
 #include <mutex>
+#include <optional>
 #include <vector>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
@@ -19,12 +25,15 @@
 
 namespace facebook::eden {
 
+class EdenStats;
 class ReloadableConfig;
 
 class HgImportRequestQueue {
  public:
-  explicit HgImportRequestQueue(std::shared_ptr<ReloadableConfig> config)
-      : config_(std::move(config)) {}
+  explicit HgImportRequestQueue(
+      std::shared_ptr<ReloadableConfig> config,
+      std::shared_ptr<EdenStats> stats = nullptr)
+      : config_(std::move(config)), stats_(std::move(stats)) {}
 
   /**
    * Enqueue a blob request to the queue.
@@ -50,8 +59,22 @@ class HgImportRequestQueue {
    * All requests in the vector are guaranteed to be the same type.
    * The number of the returned requests is controlled by `import-batch-size*`
    * options in the config. It may have fewer requests than configured.
+   *
+   * Requests are taken from the highest priority class first, after aging
+   * (see `hg:import-priority-aging-interval`). Within a class, clients take
+   * turns by deficit round robin, so one fetch-heavy process cannot crowd
+   * out the others.
+   *
+   * `maxBlobBatchSize` and `maxTreeBatchSize` further limit the size of the
+   * returned batch, below what the config allows.
+   *
+   * Requests whose waiters all cancelled (see
+   * ObjectFetchContext::getCancellationToken) are not returned, and fail
+   * with folly::OperationCancelled instead.
    */
-  std::vector<std::shared_ptr<HgImportRequest>> dequeue();
+  std::vector<std::shared_ptr<HgImportRequest>> dequeue(
+      size_t maxBlobBatchSize = std::numeric_limits<size_t>::max(),
+      size_t maxTreeBatchSize = std::numeric_limits<size_t>::max());
 
   /**
    * Destroy the queue.
@@ -69,12 +92,12 @@ class HgImportRequestQueue {
       folly::Try<std::unique_ptr<T>>& importTry) {
     std::shared_ptr<HgImportRequest> import;
     {
-      auto state = state_.lock();
+      auto tracker = trackerShard(id).lock();
 
-      auto importReq = state->requestTracker.find(id);
-      if (importReq != state->requestTracker.end()) {
+      auto importReq = tracker->find(id);
+      if (importReq != tracker->end()) {
         import = std::move(importReq->second);
-        state->requestTracker.erase(importReq);
+        tracker->erase(importReq);
       }
     }
 
@@ -82,7 +105,7 @@ class HgImportRequestQueue {
       return;
     }
 
-    std::vector<folly::Promise<std::unique_ptr<T>>>* promises;
+    HgImportRequest::DuplicatePromises<std::unique_ptr<T>>* promises;
 
     if constexpr (std::is_same_v<T, Tree>) {
       auto* treeImport = import->getRequest<HgImportRequest::TreeImport>();
@@ -116,6 +139,28 @@ class HgImportRequestQueue {
    */
   std::vector<std::shared_ptr<HgImportRequest>> combineAndClearRequestQueues();
 
+  /**
+   * A request that was enqueued and whose import has not finished yet.
+   */
+  struct LiveImport {
+    bool isTree;
+    /// Whether an importer took the request, rather than it still being
+    /// queued.
+    bool dispatched;
+    std::optional<uint64_t> requestId;
+    std::chrono::steady_clock::time_point requestTime;
+  };
+
+  /**
+   * Returns the requests that are queued or being imported.
+   */
+  std::vector<LiveImport> getLiveImports() const;
+
+  /**
+   * Estimated bytes used by the queued and in-progress requests.
+   */
+  size_t estimateMemoryUsage() const;
+
  private:
   /**
    * Puts an item into the queue.
@@ -123,25 +168,129 @@ class HgImportRequestQueue {
   template <typename Ret, typename ImportType>
   folly::Future<Ret> enqueue(std::shared_ptr<HgImportRequest> request);
 
+  /**
+   * Take the next batch of requests off the queues, blocking until there is
+   * one. Returns an empty list once the queue is stopped.
+   */
+  std::vector<std::shared_ptr<HgImportRequest>> popBatch(
+      size_t maxBlobBatchSize,
+      size_t maxTreeBatchSize);
+
+  /**
+   * Fail and remove the requests of `requests` that were abandoned by all
+   * their waiters.
+   */
+  void dropAbandoned(std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
+  /**
+   * Returns true and fails `request` with folly::OperationCancelled if it
+   * was abandoned by all its waiters.
+   */
+  template <typename ImportType>
+  bool dropIfAbandoned(HgImportRequest& request);
+
   HgImportRequestQueue(HgImportRequestQueue&&) = delete;
   HgImportRequestQueue& operator=(HgImportRequestQueue&&) = delete;
 
-  struct State {
-    bool running = true;
-    std::vector<std::shared_ptr<HgImportRequest>> treeQueue;
-    std::vector<std::shared_ptr<HgImportRequest>> blobQueue;
+  /**
+   * The queued requests of one type, with one priority heap per client.
+   *
+   * A client is the process that caused the request or, when that is not
+   * known, the fetch cause.
+   */
+  class FairQueue {
+   public:
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    size_t size() const {
+      return size_;
+    }
+
+    void push(std::shared_ptr<HgImportRequest> request);
+
+    /**
+     * Move a request up its client's heap after its priority was raised.
+     * Returns false if the request is no longer queued.
+     */
+    bool priorityRaised(const HgImportRequest& request);
+
+    /**
+     * The highest aged priority among the heads of the client heaps. The
+     * queue must not be empty.
+     */
+    ImportPriority highestPriority(
+        std::chrono::steady_clock::time_point now,
+        std::chrono::nanoseconds agingInterval) const;
 
     /**
-     * Map of a ObjectId to an element in the queue. Any changes to this type
-     * can have a significant effect on EdenFS performance and thus changes to
-     * it needs to be carefully studied and measured. The
-     * benchmarks/hg_import_request_queue.cpp is a good way to measure the
-     * potential performance impact.
+     * Move up to `count` requests to `out`, serving each client with a head
+     * in the highest priority class `quantum` requests at a time before
+     * moving on to the next class.
      */
-    folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>
-        requestTracker;
+    void pop(
+        size_t count,
+        size_t quantum,
+        std::chrono::steady_clock::time_point now,
+        std::chrono::nanoseconds agingInterval,
+        std::vector<std::shared_ptr<HgImportRequest>>& out);
+
+    /**
+     * Remove and return all queued requests.
+     */
+    std::vector<std::shared_ptr<HgImportRequest>> takeAll();
+
+   private:
+    struct Client {
+      std::vector<std::shared_ptr<HgImportRequest>> heap;
+      size_t deficit = 0;
+    };
+
+    folly::F14FastMap<uint64_t, Client> clients_;
+    /// Clients with queued requests, in the order they take turns.
+    std::deque<uint64_t> rotation_;
+    size_t size_ = 0;
   };
+
+  struct State {
+    bool running = true;
+    FairQueue treeQueue;
+    FairQueue blobQueue;
+  };
+
+  /**
+   * Map of a ObjectId to an element in the queue. Any changes to this type
+   * can have a significant effect on EdenFS performance and thus changes to
+   * it needs to be carefully studied and measured. The
+   * benchmarks/hg_import_request_queue.cpp is a good way to measure the
+   * potential performance impact.
+   */
+  using RequestTracker = folly::Synchronized<
+      folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>,
+      std::mutex>;
+
+  /**
+   * The request tracker is split into shards by ObjectId so that enqueueing
+   * and finishing imports of different objects rarely contend with each
+   * other or with dequeue, which only needs the state_ lock. Each shard is
+   * padded to its own cache line(s) to avoid false sharing of the locks.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) TrackerShard {
+    RequestTracker tracker;
+  };
+
+  static constexpr size_t kNumTrackerShards = 16;
+
+  RequestTracker& trackerShard(const ObjectId& id);
+
   std::shared_ptr<ReloadableConfig> config_;
+  std::shared_ptr<EdenStats> stats_;
+  /**
+   * Lock ordering: a tracker shard lock may be held while acquiring state_,
+   * never the reverse.
+   */
+  std::array<TrackerShard, kNumTrackerShards> trackerShards_;
   folly::Synchronized<State, std::mutex> state_;
   std::condition_variable queueCV_;
 };
@@ -14,6 +14,7 @@
 
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/StoreResult.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/utils/Bug.h"
 
 using folly::ByteRange;
@@ -25,7 +26,7 @@ namespace facebook::eden {
 
 HgProxyHash::HgProxyHash(RelativePathPiece path, const Hash20& hgRevHash) {
   auto [hash, buf] = prepareToStoreLegacy(path, hgRevHash);
-  value_ = std::move(buf);
+  value_ = std::make_shared<const std::string>(std::move(buf));
 }
 
 std::optional<HgProxyHash> HgProxyHash::tryParseEmbeddedProxyHash(
@@ -68,40 +69,56 @@ std::optional<HgProxyHash> HgProxyHash::tryParseEmbeddedProxyHash(
 
 folly::Future<std::vector<HgProxyHash>> HgProxyHash::getBatch(
     LocalStore* store,
-    ObjectIdRange blobHashes) {
-  std::vector<HgProxyHash> embedded_results;
+    ObjectIdRange blobHashes,
+    HgProxyHashCache* FOLLY_NULLABLE cache) {
+  std::vector<HgProxyHash> results(blobHashes.size());
+  std::vector<size_t> storedIndices;
   std::vector<ByteRange> byteRanges;
-  for (const auto& hash : blobHashes) {
+  for (size_t i = 0; i < blobHashes.size(); ++i) {
+    const auto& hash = blobHashes[i];
     if (auto embedded = tryParseEmbeddedProxyHash(hash)) {
-      embedded_results.push_back(*embedded);
+      results[i] = std::move(*embedded);
+    } else if (auto cached = cache ? cache->get(hash) : std::nullopt) {
+      results[i] = std::move(*cached);
     } else {
+      storedIndices.push_back(i);
       byteRanges.push_back(hash.getBytes());
     }
   }
   if (byteRanges.empty()) {
-    return std::move(embedded_results);
+    return std::move(results);
   }
   return store->getBatch(KeySpace::HgProxyHashFamily, byteRanges)
-      .thenValue([embedded_results,
-                  byteRanges](std::vector<StoreResult>&& data) {
-        std::vector<HgProxyHash> results{embedded_results};
-
+      .thenValue([results = std::move(results),
+                  storedIndices = std::move(storedIndices),
+                  byteRanges,
+                  cache](std::vector<StoreResult>&& data) mutable {
         for (size_t i = 0; i < byteRanges.size(); ++i) {
-          results.emplace_back(HgProxyHash{
-              ObjectId{byteRanges.at(i)}, data[i], "prefetchFiles getBatch"});
+          auto id = ObjectId{byteRanges.at(i)};
+          auto& result = results[storedIndices[i]];
+          result = HgProxyHash{id, data[i], "prefetchFiles getBatch"};
+          if (cache) {
+            cache->insert(id, result);
+          }
         }
 
-        return results;
+        return std::move(results);
       });
 }
 
 HgProxyHash HgProxyHash::load(
     LocalStore* store,
     const ObjectId& edenObjectId,
-    StringPiece context) {
+    StringPiece context,
+    HgProxyHashCache* FOLLY_NULLABLE cache) {
   if (auto embedded = tryParseEmbeddedProxyHash(edenObjectId)) {
     return *embedded;
   }
+  if (cache) {
+    if (auto cached = cache->get(edenObjectId)) {
+      return std::move(*cached);
+    }
+  }
   // Read the path name and file rev hash
   auto infoResult = store->get(KeySpace::HgProxyHashFamily, edenObjectId);
   if (!infoResult.isValid()) {
@@ -110,7 +127,11 @@ HgProxyHash HgProxyHash::load(
     // Fall through and let infoResult.extractValue() throw
   }
 
-  return HgProxyHash{edenObjectId, infoResult.extractValue()};
+  HgProxyHash proxyHash{edenObjectId, infoResult.extractValue()};
+  if (cache) {
+    cache->insert(edenObjectId, proxyHash);
+  }
+  return proxyHash;
 }
 
 ObjectId HgProxyHash::store(
@@ -141,21 +162,21 @@ ObjectId HgProxyHash::makeEmbeddedProxyHash1(
   folly::StringPiece hashPiece{hgRevHash.getBytes()};
   folly::StringPiece pathPiece{path};
 
-  folly::fbstring str;
+  std::string str;
   str.reserve(21 + pathPiece.size());
   str.push_back(TYPE_HG_ID_WITH_PATH);
   str.append(hashPiece.data(), hashPiece.size());
   str.append(pathPiece.data(), pathPiece.size());
-  return ObjectId{std::move(str)};
+  return ObjectId{str};
 }
 
 ObjectId HgProxyHash::makeEmbeddedProxyHash2(const Hash20& hgRevHash) {
-  folly::fbstring str;
-  str.reserve(21);
-  str.push_back(TYPE_HG_ID_NO_PATH);
-  auto bytes = folly::StringPiece{hgRevHash.getBytes()};
-  str.append(bytes.data(), bytes.size());
-  return ObjectId{std::move(str)};
+  // 21 bytes, which ObjectId stores inline.
+  std::array<uint8_t, 21> bytes;
+  bytes[0] = TYPE_HG_ID_NO_PATH;
+  auto hashBytes = hgRevHash.getBytes();
+  std::copy(hashBytes.begin(), hashBytes.end(), bytes.begin() + 1);
+  return ObjectId{folly::ByteRange{bytes}};
 }
 
 std::pair<ObjectId, std::string> HgProxyHash::prepareToStoreLegacy(
@@ -189,7 +210,7 @@ HgProxyHash::HgProxyHash(
     // Fall through and let infoResult.extractValue() throw
   }
 
-  value_ = infoResult.extractValue();
+  value_ = std::make_shared<const std::string>(infoResult.extractValue());
   validate(edenBlobHash);
 }
 
@@ -213,12 +234,17 @@ std::string HgProxyHash::serialize(
   return buf;
 }
 
+const std::string& HgProxyHash::getValue() const {
+  static const std::string kEmpty;
+  return value_ ? *value_ : kEmpty;
+}
+
 RelativePathPiece HgProxyHash::path() const noexcept {
-  if (value_.empty()) {
+  if (!value_) {
     return RelativePathPiece{};
   } else {
-    XDCHECK_GE(value_.size(), Hash20::RAW_SIZE + sizeof(uint32_t));
-    StringPiece data{value_.data(), value_.size()};
+    XDCHECK_GE(value_->size(), Hash20::RAW_SIZE + sizeof(uint32_t));
+    StringPiece data{*value_};
     data.advance(Hash20::RAW_SIZE + sizeof(uint32_t));
     // value_ was built with a known good RelativePath, thus we don't need to
     // recheck it when deserializing.
@@ -227,11 +253,11 @@ RelativePathPiece HgProxyHash::path() const noexcept {
 }
 
 ByteRange HgProxyHash::byteHash() const noexcept {
-  if (value_.empty()) {
+  if (!value_) {
     return kZeroHash.getBytes();
   } else {
-    XDCHECK_GE(value_.size(), Hash20::RAW_SIZE);
-    return ByteRange{StringPiece{value_.data(), Hash20::RAW_SIZE}};
+    XDCHECK_GE(value_->size(), Hash20::RAW_SIZE);
+    return ByteRange{StringPiece{value_->data(), Hash20::RAW_SIZE}};
   }
 }
 
@@ -240,27 +266,27 @@ Hash20 HgProxyHash::revHash() const noexcept {
 }
 
 ObjectId HgProxyHash::sha1() const noexcept {
-  if (value_.empty()) {
+  if (!value_) {
     // The SHA-1 of an empty HgProxyHash, (kZeroHash, "").
     // The correctness of this value is asserted in tests.
     const ObjectId emptyProxyHash = ObjectId::fromHex(
         folly::StringPiece{"d3399b7262fb56cb9ed053d68db9291c410839c4"});
     return emptyProxyHash;
   } else {
-    return ObjectId::sha1(value_);
+    return ObjectId::sha1(*value_);
   }
 }
 
 bool HgProxyHash::operator==(const HgProxyHash& otherHash) const {
-  return value_ == otherHash.value_;
+  return value_ == otherHash.value_ || getValue() == otherHash.getValue();
 }
 
 bool HgProxyHash::operator<(const HgProxyHash& otherHash) const {
-  return value_ < otherHash.value_;
+  return getValue() < otherHash.getValue();
 }
 
 void HgProxyHash::validate(ObjectId edenBlobHash) {
-  ByteRange infoBytes = StringPiece(value_);
+  ByteRange infoBytes = StringPiece(*value_);
   // Make sure the data is long enough to contain the rev hash and path length
   if (infoBytes.size() < Hash20::RAW_SIZE + sizeof(uint32_t)) {
     auto msg = folly::to<string>(
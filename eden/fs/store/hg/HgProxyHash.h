@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "eden/fs/config/HgObjectIdFormat.h"
@@ -21,6 +22,8 @@ class Future;
 
 namespace facebook::eden {
 
+class HgProxyHashCache;
+
 /**
  * HgProxyHash is a derived index allowing us to map EdenFS's fixed-size hashes
  * onto Mercurial's (revHash, path) pairs.
@@ -53,7 +56,7 @@ class HgProxyHash {
    * with Eden's object ID.
    */
   HgProxyHash(const ObjectId& edenObjectId, std::string value)
-      : value_{std::move(value)} {
+      : value_{std::make_shared<const std::string>(std::move(value))} {
     validate(edenObjectId);
   }
 
@@ -64,16 +67,15 @@ class HgProxyHash {
 
   ~HgProxyHash() = default;
 
+  /**
+   * Copies share the serialized data, so that the many import requests,
+   * cache entries and batches that refer to a proxy hash don't each hold a
+   * copy of its path. A moved-from HgProxyHash is uninitialized.
+   */
   HgProxyHash(const HgProxyHash& other) = default;
   HgProxyHash& operator=(const HgProxyHash& other) = default;
-
-  HgProxyHash(HgProxyHash&& other) noexcept
-      : value_{std::exchange(other.value_, std::string{})} {}
-
-  HgProxyHash& operator=(HgProxyHash&& other) noexcept {
-    value_ = std::exchange(other.value_, std::string{});
-    return *this;
-  }
+  HgProxyHash(HgProxyHash&& other) noexcept = default;
+  HgProxyHash& operator=(HgProxyHash&& other) noexcept = default;
 
   RelativePathPiece path() const noexcept;
 
@@ -98,27 +100,31 @@ class HgProxyHash {
   bool operator==(const HgProxyHash&) const;
   bool operator<(const HgProxyHash&) const;
 
-  const std::string& getValue() const {
-    return value_;
-  }
+  const std::string& getValue() const;
 
   /**
-   * Load all the proxy hashes given.
+   * Load all the proxy hashes given, in the same order.
    *
-   * The caller is responsible for keeping the ObjectIdRange alive for the
-   * duration of the future.
+   * The caller is responsible for keeping the ObjectIdRange and the cache
+   * alive for the duration of the future.
+   *
+   * Proxy hashes that are not embedded in their ID are looked up in `cache`
+   * first, when given, and those read from the LocalStore are added to it.
    */
   static folly::Future<std::vector<HgProxyHash>> getBatch(
       LocalStore* store,
-      ObjectIdRange blobHashes);
+      ObjectIdRange blobHashes,
+      HgProxyHashCache* FOLLY_NULLABLE cache = nullptr);
 
   /**
-   * Load HgProxyHash data for the given eden blob hash from the LocalStore.
+   * Load HgProxyHash data for the given eden blob hash from the LocalStore,
+   * or from `cache` if given, like getBatch.
    */
   static HgProxyHash load(
       LocalStore* store,
       const ObjectId& edenObjectId,
-      folly::StringPiece context);
+      folly::StringPiece context,
+      HgProxyHashCache* FOLLY_NULLABLE cache = nullptr);
 
   /**
    * Store HgProxyHash data in the LocalStore.
@@ -200,9 +206,10 @@ class HgProxyHash {
   };
 
   /**
-   * The serialized data as written in the LocalStore.
+   * The serialized data as written in the LocalStore, or null for an
+   * uninitialized hash. It is never modified once set.
    */
-  std::string value_;
+  std::shared_ptr<const std::string> value_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgProxyHashCache.h"
+
+namespace facebook::eden {
+
+std::optional<HgProxyHash> HgProxyHashCache::get(const ObjectId& id) {
+  auto cache = cache_.lock();
+  auto it = cache->find(id);
+  if (it == cache->end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void HgProxyHashCache::insert(
+    const ObjectId& id,
+    const HgProxyHash& proxyHash) {
+  cache_.lock()->set(id, proxyHash);
+}
+
+} // namespace facebook::eden
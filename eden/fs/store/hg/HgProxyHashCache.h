@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <mutex>
+#include <optional>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded, in-memory LRU cache of the HgProxyHash of legacy (non-embedded)
+ * object IDs, sitting in front of the HgProxyHashFamily key space.
+ *
+ * Every blob and tree import resolves its ObjectId to an HgProxyHash, which
+ * costs a LocalStore read unless the ID embeds the Mercurial hash. Recently
+ * used objects tend to be used again, so most of these reads can be served
+ * from memory. Each entry costs roughly 150 bytes plus the length of its
+ * path.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class HgProxyHashCache {
+ public:
+  explicit HgProxyHashCache(size_t maximumEntries)
+      : cache_{folly::in_place, maximumEntries} {}
+
+  std::optional<HgProxyHash> get(const ObjectId& id);
+
+  void insert(const ObjectId& id, const HgProxyHash& proxyHash);
+
+  size_t size() const {
+    return cache_.lock()->size();
+  }
+
+ private:
+  // A lookup updates the LRU order, so there is no point in a shared lock.
+  folly::Synchronized<
+      folly::EvictingCacheMap<ObjectId, HgProxyHash>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
@@ -8,6 +8,7 @@
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 
 #include <chrono>
+#include <limits>
 #include <thread>
 #include <utility>
 #include <variant>
@@ -29,6 +30,7 @@
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
@@ -45,11 +47,11 @@ namespace facebook::eden {
 namespace {
 // 100,000 hg object fetches in a short term is plausible.
 constexpr size_t kTraceBusCapacity = 100000;
-static_assert(CheckSize<HgImportTraceEvent, 56>());
+static_assert(CheckSize<HgImportTraceEvent, 64>());
 // TraceBus is double-buffered, so the following capacity should be doubled.
-// 10 MB overhead per backing repo is tolerable.
+// 13 MB overhead per backing repo is tolerable.
 static_assert(
-    CheckEqual<5600000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+    CheckEqual<6400000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
 } // namespace
 
 HgImportTraceEvent::HgImportTraceEvent(
@@ -58,13 +60,15 @@ HgImportTraceEvent::HgImportTraceEvent(
     ResourceType resourceType,
     const HgProxyHash& proxyHash,
     ImportPriorityKind priority,
-    ObjectFetchContext::Cause cause)
+    ObjectFetchContext::Cause cause,
+    uint64_t requestId)
     : unique{unique},
       manifestNodeId{proxyHash.revHash()},
       eventType{eventType},
       resourceType{resourceType},
       importPriority{priority},
-      importCause{cause} {
+      importCause{cause},
+      requestId{requestId} {
   auto hgPath = proxyHash.path().stringPiece();
   path.reset(new char[hgPath.size() + 1]);
   memcpy(path.get(), hgPath.data(), hgPath.size());
@@ -82,7 +86,14 @@ HgQueuedBackingStore::HgQueuedBackingStore(
       stats_(std::move(stats)),
       config_(config),
       backingStore_(std::move(backingStore)),
-      queue_(std::move(config)),
+      proxyHashCache_{[&]() -> std::unique_ptr<HgProxyHashCache> {
+        auto size = config_->getEdenConfig()->hgProxyHashCacheSize.getValue();
+        if (size == 0) {
+          return nullptr;
+        }
+        return std::make_unique<HgProxyHashCache>(size);
+      }()},
+      queue_(std::move(config), stats_),
       structuredLogger_{std::move(structuredLogger)},
       logger_(std::move(logger)),
       traceBus_{TraceBus<HgImportTraceEvent>::create("hg", kTraceBusCapacity)} {
@@ -93,13 +104,19 @@ HgQueuedBackingStore::HgQueuedBackingStore(
         << "HgQueuedBackingStore configured to use 0 threads. Invalid, using one thread instead";
     numberThreads = 1;
   }
+  numWorkers_ = numberThreads;
   threads_.reserve(numberThreads);
   for (uint16_t i = 0; i < numberThreads; i++) {
-    threads_.emplace_back(&HgQueuedBackingStore::processRequest, this);
+    threads_.emplace_back(&HgQueuedBackingStore::processRequest, this, i);
   }
 }
 
 HgQueuedBackingStore::~HgQueuedBackingStore() {
+  {
+    auto running = workersRunning_.lock();
+    *running = false;
+  }
+  workersCV_.notify_all();
   queue_.stop();
   for (auto& thread : threads_) {
     thread.join();
@@ -120,20 +137,21 @@ void HgQueuedBackingStore::processBlobImportRequests(
         HgImportTraceEvent::BLOB,
         blobImport->proxyHash,
         request->getPriority().kind,
-        request->getCause()));
+        request->getCause(),
+        request->getRequestId()));
 
     XLOGF(DBG4, "Processing blob request for {}", blobImport->hash);
   }
 
-  backingStore_->getDatapackStore().getBlobBatch(requests);
+  auto imported = backingStore_->getDatapackStore().getBlobBatch(requests);
 
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
     futures.reserve(requests.size());
 
-    for (auto& request : requests) {
-      auto* promise = request->getPromise<std::unique_ptr<Blob>>();
-      if (promise->isFulfilled()) {
+    for (size_t index = 0; index < requests.size(); ++index) {
+      auto& request = requests[index];
+      if (imported[index]) {
         stats_->getHgBackingStoreStatsForCurrentThread()
             .hgBackingStoreGetBlob.addValue(watch.elapsed().count());
         continue;
@@ -174,23 +192,26 @@ void HgQueuedBackingStore::processTreeImportRequests(
         HgImportTraceEvent::TREE,
         treeImport->proxyHash,
         request->getPriority().kind,
-        request->getCause()));
+        request->getCause(),
+        request->getRequestId()));
 
     XLOGF(DBG4, "Processing tree request for {}", treeImport->hash);
   }
 
+  std::vector<bool> imported;
   {
     auto writeBatch = localStore_->beginWrite();
-    backingStore_->getDatapackStore().getTreeBatch(requests, writeBatch.get());
+    imported = backingStore_->getDatapackStore().getTreeBatch(
+        requests, writeBatch.get());
   }
 
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
     futures.reserve(requests.size());
 
-    for (auto& request : requests) {
-      auto* promise = request->getPromise<std::unique_ptr<Tree>>();
-      if (promise->isFulfilled()) {
+    for (size_t index = 0; index < requests.size(); ++index) {
+      auto& request = requests[index];
+      if (imported[index]) {
         stats_->getHgBackingStoreStatsForCurrentThread()
             .hgBackingStoreGetTree.addValue(watch.elapsed().count());
         continue;
@@ -219,21 +240,73 @@ void HgQueuedBackingStore::processTreeImportRequests(
   }
 }
 
-void HgQueuedBackingStore::processRequest() {
+bool HgQueuedBackingStore::waitForWorkerTurn(size_t index) {
+  auto running = workersRunning_.lock();
+  while (*running && index >= batchController_.getConcurrency(numWorkers_)) {
+    // Also wake up periodically to notice adaptive batching being disabled.
+    workersCV_.wait_for(running.as_lock(), std::chrono::seconds{1});
+    if (!config_->getEdenConfig()->adaptiveImportBatching.getValue()) {
+      break;
+    }
+  }
+  return *running;
+}
+
+void HgQueuedBackingStore::processRequest(size_t index) {
   folly::setThreadName("hgqueue");
   for (;;) {
-    auto requests = queue_.dequeue();
+    auto config = config_->getEdenConfig();
+    bool adaptive = config->adaptiveImportBatching.getValue();
+    auto maxBlobBatchSize = std::numeric_limits<size_t>::max();
+    auto maxTreeBatchSize = std::numeric_limits<size_t>::max();
+    if (adaptive) {
+      if (!waitForWorkerTurn(index)) {
+        break;
+      }
+      maxBlobBatchSize = batchController_.getBatchSize(
+          HgImportBatchController::Kind::Blob,
+          config->importBatchSize.getValue());
+      maxTreeBatchSize = batchController_.getBatchSize(
+          HgImportBatchController::Kind::Tree,
+          config->importBatchSizeTree.getValue());
+    }
+
+    auto requests = queue_.dequeue(maxBlobBatchSize, maxTreeBatchSize);
 
     if (requests.empty()) {
       break;
     }
 
+    folly::stop_watch<std::chrono::nanoseconds> watch;
+    auto batchSize = requests.size();
     const auto& first = requests.at(0);
 
+    HgImportBatchController::Kind kind;
     if (first->isType<HgImportRequest::BlobImport>()) {
+      kind = HgImportBatchController::Kind::Blob;
       processBlobImportRequests(std::move(requests));
     } else if (first->isType<HgImportRequest::TreeImport>()) {
+      kind = HgImportBatchController::Kind::Tree;
       processTreeImportRequests(std::move(requests));
+    } else {
+      continue;
+    }
+
+    if (adaptive) {
+      auto concurrency = batchController_.getConcurrency(numWorkers_);
+      batchController_.recordBatch(
+          kind,
+          batchSize,
+          watch.elapsed(),
+          HgImportBatchController::Limits{
+              kind == HgImportBatchController::Kind::Blob
+                  ? config->importBatchSize.getValue()
+                  : config->importBatchSizeTree.getValue(),
+              numWorkers_,
+              config->importBatchTargetLatency.getValue()});
+      if (batchController_.getConcurrency(numWorkers_) > concurrency) {
+        workersCV_.notify_all();
+      }
     }
   }
 }
@@ -269,7 +342,7 @@ ObjectId HgQueuedBackingStore::staticParseObjectId(
           fmt::format("invalid proxy hash length: {}", objectId.size()));
     }
 
-    return ObjectId{folly::unhexlify<folly::fbstring>(objectId.subpiece(6))};
+    return ObjectId{folly::unhexlify(objectId.subpiece(6))};
   }
 
   if (objectId.size() == 40) {
@@ -308,7 +381,8 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTree(
     ObjectFetchContext& context) {
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(localStore_.get(), id, "getTree");
+    proxyHash = HgProxyHash::load(
+        localStore_.get(), id, "getTree", proxyHashCache_.get());
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -335,8 +409,8 @@ std::unique_ptr<BlobMetadata> HgQueuedBackingStore::getLocalBlobMetadata(
     ObjectFetchContext& /*context*/) {
   HgProxyHash proxyHash;
   try {
-    proxyHash =
-        HgProxyHash::load(localStore_.get(), id, "getLocalBlobMetadata");
+    proxyHash = HgProxyHash::load(
+        localStore_.get(), id, "getLocalBlobMetadata", proxyHashCache_.get());
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -351,7 +425,13 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
     ObjectFetchContext& context) {
   auto getTreeFuture = folly::makeFutureWith([&] {
     auto request = HgImportRequest::makeTreeImportRequest(
-        id, proxyHash, context.getPriority(), context.getCause());
+        id,
+        proxyHash,
+        context.getPriority(),
+        context.getCause(),
+        context.getClientPid(),
+        context.getRequestId(),
+        context.getCancellationToken());
     uint64_t unique = request->getUnique();
 
     auto importTracker =
@@ -361,7 +441,8 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
         HgImportTraceEvent::TREE,
         proxyHash,
         context.getPriority().kind,
-        context.getCause()));
+        context.getCause(),
+        context.getRequestId()));
 
     return queue_.enqueueTree(std::move(request))
         .ensure([this,
@@ -374,7 +455,8 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
               HgImportTraceEvent::TREE,
               proxyHash,
               context.getPriority().kind,
-              context.getCause()));
+              context.getCause(),
+              context.getRequestId()));
         });
   });
 
@@ -392,7 +474,8 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlob(
     ObjectFetchContext& context) {
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(localStore_.get(), id, "getBlob");
+    proxyHash = HgProxyHash::load(
+        localStore_.get(), id, "getBlob", proxyHashCache_.get());
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -421,7 +504,13 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
                << ", hash is:" << id;
 
     auto request = HgImportRequest::makeBlobImportRequest(
-        id, proxyHash, context.getPriority(), context.getCause());
+        id,
+        proxyHash,
+        context.getPriority(),
+        context.getCause(),
+        context.getClientPid(),
+        context.getRequestId(),
+        context.getCancellationToken());
     auto unique = request->getUnique();
 
     auto importTracker =
@@ -431,7 +520,8 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
         HgImportTraceEvent::BLOB,
         proxyHash,
         context.getPriority().kind,
-        context.getCause()));
+        context.getCause(),
+        context.getRequestId()));
 
     return queue_.enqueueBlob(std::move(request))
         .ensure([this,
@@ -444,7 +534,8 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
               HgImportTraceEvent::BLOB,
               proxyHash,
               context.getPriority().kind,
-              context.getCause()));
+              context.getCause(),
+              context.getRequestId()));
         });
   });
 
@@ -466,7 +557,7 @@ folly::SemiFuture<std::unique_ptr<Tree>> HgQueuedBackingStore::getRootTree(
 folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
     ObjectIdRange ids,
     ObjectFetchContext& context) {
-  return HgProxyHash::getBatch(localStore_.get(), ids)
+  return HgProxyHash::getBatch(localStore_.get(), ids, proxyHashCache_.get())
       // The caller guarantees that ids will live at least longer than this
       // future, thus we don't need to deep-copy it.
       .thenTry([&context, this, ids](
@@ -553,6 +644,20 @@ void HgQueuedBackingStore::logBackingStoreFetch(
   }
 }
 
+size_t HgQueuedBackingStore::getImportBatchSizeTarget(
+    HgImportBatchController::Kind kind) const {
+  auto config = config_->getEdenConfig();
+  return batchController_.getBatchSize(
+      kind,
+      kind == HgImportBatchController::Kind::Blob
+          ? config->importBatchSize.getValue()
+          : config->importBatchSizeTree.getValue());
+}
+
+size_t HgQueuedBackingStore::getImportConcurrencyTarget() const {
+  return batchController_.getConcurrency(numWorkers_);
+}
+
 size_t HgQueuedBackingStore::getImportMetric(
     RequestMetricsScope::RequestStage stage,
     HgBackingStore::HgImportObject object,
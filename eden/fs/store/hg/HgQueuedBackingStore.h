@@ -11,7 +11,9 @@
 #include <folly/Synchronized.h>
 #include <sys/types.h>
 #include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "eden/fs/model/Hash.h"
@@ -19,6 +21,7 @@
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
+#include "eden/fs/store/hg/HgImportBatchController.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
@@ -28,6 +31,7 @@ namespace facebook::eden {
 class BackingStoreLogger;
 class ReloadableConfig;
 class HgBackingStore;
+class HgProxyHashCache;
 class LocalStore;
 class EdenStats;
 class HgImportRequest;
@@ -50,9 +54,16 @@ struct HgImportTraceEvent : TraceEventBase {
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriorityKind priority,
-      ObjectFetchContext::Cause cause) {
+      ObjectFetchContext::Cause cause,
+      std::optional<uint64_t> requestId) {
     return HgImportTraceEvent{
-        unique, QUEUE, resourceType, proxyHash, priority, cause};
+        unique,
+        QUEUE,
+        resourceType,
+        proxyHash,
+        priority,
+        cause,
+        requestId.value_or(0)};
   }
 
   static HgImportTraceEvent start(
@@ -60,9 +71,16 @@ struct HgImportTraceEvent : TraceEventBase {
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriorityKind priority,
-      ObjectFetchContext::Cause cause) {
+      ObjectFetchContext::Cause cause,
+      std::optional<uint64_t> requestId) {
     return HgImportTraceEvent{
-        unique, START, resourceType, proxyHash, priority, cause};
+        unique,
+        START,
+        resourceType,
+        proxyHash,
+        priority,
+        cause,
+        requestId.value_or(0)};
   }
 
   static HgImportTraceEvent finish(
@@ -70,9 +88,16 @@ struct HgImportTraceEvent : TraceEventBase {
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriorityKind priority,
-      ObjectFetchContext::Cause cause) {
+      ObjectFetchContext::Cause cause,
+      std::optional<uint64_t> requestId) {
     return HgImportTraceEvent{
-        unique, FINISH, resourceType, proxyHash, priority, cause};
+        unique,
+        FINISH,
+        resourceType,
+        proxyHash,
+        priority,
+        cause,
+        requestId.value_or(0)};
   }
 
   HgImportTraceEvent(
@@ -81,7 +106,8 @@ struct HgImportTraceEvent : TraceEventBase {
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriorityKind priority,
-      ObjectFetchContext::Cause cause);
+      ObjectFetchContext::Cause cause,
+      uint64_t requestId);
 
   /// Simple accessor that hides the internal memory representation of paths.
   std::string getPath() const {
@@ -99,6 +125,9 @@ struct HgImportTraceEvent : TraceEventBase {
   ResourceType resourceType;
   ImportPriorityKind importPriority;
   ObjectFetchContext::Cause importCause;
+  // The id of the FUSE, NFS or Thrift request that caused the import, or zero.
+  // See ObjectFetchContext::getRequestId.
+  uint64_t requestId;
 };
 
 /**
@@ -172,6 +201,18 @@ class HgQueuedBackingStore final : public BackingStore {
       HgBackingStore::HgImportObject object,
       RequestMetricsScope::RequestMetric metric) const;
 
+  /**
+   * The batch size currently targeted for imports of the given kind when
+   * `hg:adaptive-import-batching` is enabled.
+   */
+  size_t getImportBatchSizeTarget(HgImportBatchController::Kind kind) const;
+
+  /**
+   * The number of batches currently targeted to be imported at once when
+   * `hg:adaptive-import-batching` is enabled.
+   */
+  size_t getImportConcurrencyTarget() const;
+
   void startRecordingFetch() override;
   std::unordered_set<std::string> stopRecordingFetch() override;
 
@@ -191,6 +232,20 @@ class HgQueuedBackingStore final : public BackingStore {
 
   int64_t dropAllPendingRequestsFromQueue() override;
 
+  /**
+   * Returns the imports that are queued or in progress.
+   */
+  std::vector<HgImportRequestQueue::LiveImport> getLiveImports() const {
+    return queue_.getLiveImports();
+  }
+
+  /**
+   * Estimated bytes used by the import queue.
+   */
+  size_t estimateMemoryUsage() const {
+    return queue_.estimateMemoryUsage();
+  }
+
  private:
   // Forbidden copy constructor and assignment operator
   HgQueuedBackingStore(const HgQueuedBackingStore&) = delete;
@@ -204,9 +259,16 @@ class HgQueuedBackingStore final : public BackingStore {
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
 
   /**
-   * The worker runloop function.
+   * The worker runloop function. `index` identifies the worker among
+   * threads_.
+   */
+  void processRequest(size_t index);
+
+  /**
+   * With adaptive batching, block until worker `index` is within the
+   * current concurrency target. Returns false once the workers should exit.
    */
-  void processRequest();
+  bool waitForWorkerTurn(size_t index);
 
   void logMissingProxyHash();
 
@@ -290,6 +352,12 @@ class HgQueuedBackingStore final : public BackingStore {
 
   std::unique_ptr<HgBackingStore> backingStore_;
 
+  /**
+   * Recently loaded legacy proxy hashes, or null if disabled by
+   * `hg:proxy-hash-cache-size`.
+   */
+  std::unique_ptr<HgProxyHashCache> proxyHashCache_;
+
   /**
    * The import request queue. This queue is unbounded. This queue
    * implementation will ensure enqueue operation never blocks.
@@ -301,6 +369,16 @@ class HgQueuedBackingStore final : public BackingStore {
    * forever to process incoming import requests
    */
   std::vector<std::thread> threads_;
+  size_t numWorkers_{0};
+
+  /**
+   * Tunes batch sizes and the number of active workers when
+   * `hg:adaptive-import-batching` is enabled. Workers beyond the concurrency
+   * target wait on workersCV_.
+   */
+  HgImportBatchController batchController_;
+  folly::Synchronized<bool, std::mutex> workersRunning_{true};
+  std::condition_variable workersCV_;
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
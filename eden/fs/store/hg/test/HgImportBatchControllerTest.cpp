@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/hg/HgImportBatchController.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+constexpr auto kBlob = HgImportBatchController::Kind::Blob;
+constexpr auto kTree = HgImportBatchController::Kind::Tree;
+const HgImportBatchController::Limits kLimits{4, 3, 100ms};
+
+void recordFastBatches(
+    HgImportBatchController& controller,
+    HgImportBatchController::Kind kind,
+    size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    auto batchSize = controller.getBatchSize(kind, kLimits.maxBatchSize);
+    controller.recordBatch(kind, batchSize, 10ms * batchSize, kLimits);
+  }
+}
+} // namespace
+
+TEST(HgImportBatchControllerTest, growsBatchSizeThenConcurrency) {
+  HgImportBatchController controller;
+  EXPECT_EQ(1, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+  EXPECT_EQ(1, controller.getConcurrency(kLimits.maxConcurrency));
+
+  recordFastBatches(controller, kBlob, 3);
+  EXPECT_EQ(4, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+  EXPECT_EQ(1, controller.getConcurrency(kLimits.maxConcurrency));
+
+  recordFastBatches(controller, kBlob, 10);
+  EXPECT_EQ(4, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+  EXPECT_EQ(3, controller.getConcurrency(kLimits.maxConcurrency));
+
+  // Each kind tracks its own batch size.
+  EXPECT_EQ(1, controller.getBatchSize(kTree, kLimits.maxBatchSize));
+}
+
+TEST(HgImportBatchControllerTest, slowBatchesShrinkBatchSizeThenConcurrency) {
+  HgImportBatchController controller;
+  recordFastBatches(controller, kBlob, 10);
+  ASSERT_EQ(3, controller.getConcurrency(kLimits.maxConcurrency));
+
+  controller.recordBatch(kBlob, 4, 200ms, kLimits);
+  EXPECT_EQ(2, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+  EXPECT_EQ(3, controller.getConcurrency(kLimits.maxConcurrency));
+
+  controller.recordBatch(kBlob, 2, 200ms, kLimits);
+  controller.recordBatch(kBlob, 1, 200ms, kLimits);
+  EXPECT_EQ(1, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+  EXPECT_EQ(1, controller.getConcurrency(kLimits.maxConcurrency));
+}
+
+TEST(HgImportBatchControllerTest, partialBatchesDoNotGrow) {
+  HgImportBatchController controller;
+  recordFastBatches(controller, kBlob, 2);
+  ASSERT_EQ(3, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+
+  controller.recordBatch(kBlob, 1, 1ms, kLimits);
+  EXPECT_EQ(3, controller.getBatchSize(kBlob, kLimits.maxBatchSize));
+}
+
+TEST(HgImportBatchControllerTest, targetsStayWithinLimits) {
+  HgImportBatchController controller;
+  recordFastBatches(controller, kBlob, 10);
+  EXPECT_EQ(2, controller.getBatchSize(kBlob, 2));
+  EXPECT_EQ(1, controller.getConcurrency(1));
+  EXPECT_EQ(1, controller.getBatchSize(kBlob, 0));
+}
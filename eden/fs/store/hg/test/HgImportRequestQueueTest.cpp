@@ -5,11 +5,13 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/CancellationToken.h>
 #include <folly/Try.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <array>
 #include <memory>
+#include <thread>
 
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Hash.h"
@@ -104,6 +106,31 @@ ObjectId insertTreeImportRequest(
   return hash;
 }
 
+ObjectId insertBlobImportRequestForPid(
+    HgImportRequestQueue& queue,
+    ImportPriority priority,
+    pid_t pid) {
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash,
+      std::move(proxyHash),
+      priority,
+      ObjectFetchContext::Cause::Fs,
+      pid));
+  return hash;
+}
+
+ObjectId dequeueBlob(HgImportRequestQueue& queue) {
+  auto requests = queue.dequeue();
+  EXPECT_EQ(1, requests.size());
+  auto hash = requests.at(0)->getRequest<HgImportRequest::BlobImport>()->hash;
+  folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+      [&] { return std::make_unique<Blob>(hash, folly::IOBuf{}); });
+  queue.markImportAsFinished<Blob>(hash, blob);
+  return hash;
+}
+
 TEST_F(HgImportRequestQueueTest, getRequestByPriority) {
   auto queue = HgImportRequestQueue{edenConfig};
   std::vector<ObjectId> enqueued;
@@ -565,3 +592,186 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
         request->getRequest<HgImportRequest::BlobImport>()->hash, expBlob);
   }
 }
+
+TEST_F(HgImportRequestQueueTest, clientsTakeTurns) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  // A fetch-heavy client queues many requests, some at a higher offset than
+  // the single request of an interactive client.
+  std::vector<ObjectId> heavy;
+  for (int i = 0; i < 5; i++) {
+    heavy.push_back(insertBlobImportRequestForPid(
+        queue, ImportPriority(ImportPriorityKind::Normal, 10 - i), 100));
+  }
+  auto interactive = insertBlobImportRequestForPid(
+      queue, ImportPriority(ImportPriorityKind::Normal, 0), 200);
+
+  EXPECT_EQ(heavy[0], dequeueBlob(queue));
+  EXPECT_EQ(interactive, dequeueBlob(queue));
+  for (int i = 1; i < 5; i++) {
+    EXPECT_EQ(heavy[i], dequeueBlob(queue));
+  }
+}
+
+TEST_F(HgImportRequestQueueTest, priorityClassBeatsTurns) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto low = insertBlobImportRequestForPid(queue, ImportPriority::kLow(), 100);
+  auto high1 =
+      insertBlobImportRequestForPid(queue, ImportPriority::kHigh(), 200);
+  auto high2 =
+      insertBlobImportRequestForPid(queue, ImportPriority::kHigh(), 200);
+
+  EXPECT_EQ(high1, dequeueBlob(queue));
+  EXPECT_EQ(high2, dequeueBlob(queue));
+  EXPECT_EQ(low, dequeueBlob(queue));
+}
+
+TEST_F(HgImportRequestQueueTest, waitingRequestsAge) {
+  rawEdenConfig->importPriorityAgingInterval.setValue(
+      std::chrono::milliseconds{10}, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto low = insertBlobImportRequestForPid(queue, ImportPriority::kLow(), 100);
+  // Long enough for the low priority request to age two classes, to High.
+  std::this_thread::sleep_for(std::chrono::milliseconds{25});
+  auto normal =
+      insertBlobImportRequestForPid(queue, ImportPriority::kNormal(), 200);
+
+  EXPECT_EQ(low, dequeueBlob(queue));
+  EXPECT_EQ(normal, dequeueBlob(queue));
+}
+
+TEST_F(HgImportRequestQueueTest, requestIdIsCarriedToTheImporter) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash,
+      std::move(proxyHash),
+      ImportPriority::kNormal(),
+      ObjectFetchContext::Cause::Fs,
+      100,
+      1234));
+
+  auto requests = queue.dequeue();
+  ASSERT_EQ(1, requests.size());
+  EXPECT_EQ(std::optional<uint64_t>{1234}, requests[0]->getRequestId());
+  folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+      [&] { return std::make_unique<Blob>(hash, folly::IOBuf{}); });
+  queue.markImportAsFinished<Blob>(hash, blob);
+}
+
+TEST_F(HgImportRequestQueueTest, liveImportsReportWhetherDispatched) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash,
+      std::move(proxyHash),
+      ImportPriority::kNormal(),
+      ObjectFetchContext::Cause::Fs,
+      100,
+      1234));
+
+  auto live = queue.getLiveImports();
+  ASSERT_EQ(1, live.size());
+  EXPECT_FALSE(live[0].isTree);
+  EXPECT_FALSE(live[0].dispatched);
+  EXPECT_EQ(std::optional<uint64_t>{1234}, live[0].requestId);
+
+  auto requests = queue.dequeue();
+  ASSERT_EQ(1, requests.size());
+  live = queue.getLiveImports();
+  ASSERT_EQ(1, live.size());
+  EXPECT_TRUE(live[0].dispatched);
+
+  folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+      [&] { return std::make_unique<Blob>(hash, folly::IOBuf{}); });
+  queue.markImportAsFinished<Blob>(hash, blob);
+  EXPECT_TRUE(queue.getLiveImports().empty());
+}
+
+TEST_F(HgImportRequestQueueTest, duplicateRaisesQueuedImportInPlace) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  // A prefetch queues a backlog of low priority imports, and an interactive
+  // process then needs one from the middle of it.
+  std::vector<ObjectId> prefetched;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  for (int i = 0; i < 20; i++) {
+    if (i == 10) {
+      queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+          hash,
+          proxyHash,
+          ImportPriority::kLow(),
+          ObjectFetchContext::Cause::Prefetch,
+          100));
+    } else {
+      prefetched.push_back(insertBlobImportRequestForPid(
+          queue, ImportPriority(ImportPriorityKind::Low, 20 - i), 100));
+    }
+  }
+  auto interactive = queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash,
+      proxyHash,
+      ImportPriority::kHigh(),
+      ObjectFetchContext::Cause::Fs,
+      200));
+
+  EXPECT_EQ(hash, dequeueBlob(queue));
+  EXPECT_NE(nullptr, std::move(interactive).get());
+  for (const auto& expected : prefetched) {
+    EXPECT_EQ(expected, dequeueBlob(queue));
+  }
+}
+
+TEST_F(HgImportRequestQueueTest, abandonedImportIsDropped) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource cancellation;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto abandoned = proxyHash.sha1();
+  auto future = queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      abandoned,
+      std::move(proxyHash),
+      ImportPriority::kHigh(),
+      ObjectFetchContext::Cause::Fs,
+      100,
+      std::nullopt,
+      cancellation.getToken()));
+  auto live = insertBlobImportRequest(queue, ImportPriority::kLow());
+
+  cancellation.requestCancellation();
+  EXPECT_EQ(live, dequeueBlob(queue));
+  EXPECT_THROW(std::move(future).get(), folly::OperationCancelled);
+  EXPECT_TRUE(queue.getLiveImports().empty());
+}
+
+TEST_F(HgImportRequestQueueTest, importIsKeptWhileAWaiterRemains) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource cancellation;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  auto cancelled = queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash,
+      proxyHash,
+      ImportPriority::kNormal(),
+      ObjectFetchContext::Cause::Fs,
+      100,
+      std::nullopt,
+      cancellation.getToken()));
+  // A duplicate that can't be cancelled, like a background prefetch.
+  auto remaining = queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash,
+      proxyHash,
+      ImportPriority::kLow(),
+      ObjectFetchContext::Cause::Prefetch,
+      200));
+
+  cancellation.requestCancellation();
+  EXPECT_EQ(hash, dequeueBlob(queue));
+  EXPECT_NE(nullptr, std::move(remaining).get());
+}
@@ -13,6 +13,7 @@
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -43,6 +44,9 @@ TEST(HgProxyHashTest, testCopyMove) {
 
   EXPECT_EQ(orig1.path(), second.path());
   EXPECT_EQ(orig1.revHash(), second.revHash());
+  // Copies share the path rather than duplicating it.
+  EXPECT_EQ(
+      orig1.path().stringPiece().data(), second.path().stringPiece().data());
 
   second = orig2;
   EXPECT_EQ(orig2.path(), second.path());
@@ -112,3 +116,79 @@ TEST(HgProxyHashTest, round_trip_version_2) {
   EXPECT_EQ(hash, proxy.revHash());
   EXPECT_EQ(RelativePathPiece{}, proxy.path());
 }
+
+TEST(HgProxyHashTest, getBatch_preserves_order) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  Hash20 hash1{folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  Hash20 hash2{folly::StringPiece{"2222222222222222222222222222222222222222"}};
+  ObjectId legacy;
+  {
+    auto write = store->beginWrite();
+    legacy = HgProxyHash::store(
+        RelativePathPiece{"foo"},
+        hash1,
+        HgObjectIdFormat::ProxyHash,
+        write.get());
+    write->flush();
+  }
+
+  std::vector<ObjectId> ids{HgProxyHash::makeEmbeddedProxyHash2(hash2), legacy};
+  auto proxyHashes =
+      HgProxyHash::getBatch(store.get(), folly::range(ids)).get();
+  ASSERT_EQ(2, proxyHashes.size());
+  EXPECT_EQ(hash2, proxyHashes[0].revHash());
+  EXPECT_EQ(hash1, proxyHashes[1].revHash());
+  EXPECT_EQ(RelativePathPiece{"foo"}, proxyHashes[1].path());
+}
+
+TEST(HgProxyHashTest, cache_avoids_local_store) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  Hash20 hash{folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  ObjectId first, second;
+  {
+    auto write = store->beginWrite();
+    first = HgProxyHash::store(
+        RelativePathPiece{"foo"},
+        hash,
+        HgObjectIdFormat::ProxyHash,
+        write.get());
+    second = HgProxyHash::store(
+        RelativePathPiece{"bar"},
+        hash,
+        HgObjectIdFormat::ProxyHash,
+        write.get());
+    write->flush();
+  }
+
+  HgProxyHashCache cache{10};
+  HgProxyHash::load(store.get(), first, "test", &cache);
+  std::vector<ObjectId> ids{second};
+  HgProxyHash::getBatch(store.get(), folly::range(ids), &cache).get();
+  EXPECT_EQ(2, cache.size());
+
+  store->clearKeySpace(KeySpace::HgProxyHashFamily);
+  EXPECT_EQ(
+      RelativePathPiece{"foo"},
+      HgProxyHash::load(store.get(), first, "test", &cache).path());
+  auto proxyHashes =
+      HgProxyHash::getBatch(store.get(), folly::range(ids), &cache).get();
+  EXPECT_EQ(RelativePathPiece{"bar"}, proxyHashes.at(0).path());
+}
+
+TEST(HgProxyHashTest, cache_is_bounded) {
+  HgProxyHashCache cache{2};
+  Hash20 hash{folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  HgProxyHash foo{RelativePathPiece{"foo"}, hash};
+  HgProxyHash bar{RelativePathPiece{"bar"}, hash};
+  HgProxyHash baz{RelativePathPiece{"baz"}, hash};
+  cache.insert(foo.sha1(), foo);
+  cache.insert(bar.sha1(), bar);
+  // Looking foo up makes bar the least recently used entry.
+  EXPECT_TRUE(cache.get(foo.sha1()));
+  cache.insert(baz.sha1(), baz);
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(foo, cache.get(foo.sha1()));
+  EXPECT_FALSE(cache.get(bar.sha1()));
+  EXPECT_EQ(baz, cache.get(baz.sha1()));
+}
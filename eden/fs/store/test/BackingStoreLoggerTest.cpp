@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BackingStoreLogger.h"
+
+#include <folly/json.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/telemetry/ScribeLogger.h"
+#include "eden/fs/telemetry/ScubaStructuredLogger.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+struct TestScribeLogger : public ScribeLogger {
+  std::vector<std::string> lines;
+
+  void log(std::string line) override {
+    lines.emplace_back(std::move(line));
+  }
+};
+
+class CauseFetchContext : public ObjectFetchContext {
+ public:
+  explicit CauseFetchContext(Cause cause) : cause_{cause} {}
+
+  Cause getCause() const override {
+    return cause_;
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+
+ private:
+  Cause cause_;
+};
+
+struct BackingStoreLoggerTest : ::testing::Test {
+  BackingStoreLoggerTest() {
+    std::shared_ptr<EdenConfig> rawEdenConfig{
+        EdenConfig::createTestEdenConfig()};
+    // Log every thrift fetch and no filesystem fetch.
+    rawEdenConfig->logObjectFetchSampleDenominators.setValue(
+        {1, 0, 1, 1}, ConfigSource::Default, true);
+    logger = std::make_unique<BackingStoreLogger>(
+        std::make_shared<ScubaStructuredLogger>(scribe, SessionInfo{}),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<ReloadableConfig>(
+            rawEdenConfig, ConfigReloadBehavior::NoReload));
+  }
+
+  std::vector<std::string> loggedPaths() const {
+    std::vector<std::string> paths;
+    for (const auto& line : scribe->lines) {
+      paths.push_back(
+          folly::parseJson(line)["normal"]["fetched_path"].asString());
+    }
+    return paths;
+  }
+
+  std::shared_ptr<TestScribeLogger> scribe{
+      std::make_shared<TestScribeLogger>()};
+  std::unique_ptr<BackingStoreLogger> logger;
+};
+
+} // namespace
+
+TEST_F(BackingStoreLoggerTest, logs_sampled_causes_in_the_background) {
+  CauseFetchContext fsContext{ObjectFetchContext::Cause::Fs};
+  CauseFetchContext thriftContext{ObjectFetchContext::Cause::Thrift};
+  logger->logImport(
+      fsContext, "dir/fs"_relpath, ObjectFetchContext::ObjectType::Blob);
+  logger->logImport(
+      thriftContext,
+      "dir/thrift"_relpath,
+      ObjectFetchContext::ObjectType::Tree);
+
+  logger->flush();
+  EXPECT_EQ(std::vector<std::string>{"dir/thrift"}, loggedPaths());
+}
+
+TEST_F(BackingStoreLoggerTest, destruction_logs_queued_fetches) {
+  CauseFetchContext context{ObjectFetchContext::Cause::Thrift};
+  for (int i = 0; i < 100; ++i) {
+    logger->logImport(
+        context, "dir/file"_relpath, ObjectFetchContext::ObjectType::Blob);
+  }
+
+  logger.reset();
+  EXPECT_EQ(100, scribe->lines.size());
+}
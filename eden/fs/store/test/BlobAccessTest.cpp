@@ -169,3 +169,74 @@ TEST_F(BlobAccessTest, drops_oldest_blobs) {
   EXPECT_EQ(2, backingStore->getAccessCount(hash4));
   EXPECT_EQ(1, backingStore->getAccessCount(hash5));
 }
+
+TEST_F(BlobAccessTest, ranges_are_fetched_and_cached_in_chunks) {
+  auto hash7 = ObjectId::fromHex("0000000000000000000000000000000000000004");
+  backingStore->putBlob(hash7, "abcdef"_sp)->setReady();
+  backingStore->setSupportsBlobRanges(true);
+
+  auto getRange = [&](uint64_t offset, uint64_t length) {
+    return blobAccess
+        ->getBlobRange(
+            hash7,
+            /*blobSize=*/6,
+            offset,
+            length,
+            /*chunkSize=*/2,
+            ObjectFetchContext::getNullContext())
+        .get(0ms)
+        ->moveToFbString();
+  };
+
+  EXPECT_EQ("bcd", getRange(1, 3));
+  EXPECT_EQ(0, backingStore->getAccessCount(hash7));
+  EXPECT_EQ(2, backingStore->getRangeAccessCount(hash7));
+
+  // The second chunk is still cached, only the third one is fetched.
+  EXPECT_EQ("cdef", getRange(2, 10));
+  EXPECT_EQ(3, backingStore->getRangeAccessCount(hash7));
+
+  EXPECT_EQ("", getRange(6, 1));
+  EXPECT_EQ(3, backingStore->getRangeAccessCount(hash7));
+}
+
+TEST_F(BlobAccessTest, ranges_fall_back_to_whole_blobs) {
+  auto range = blobAccess
+                   ->getBlobRange(
+                       hash6,
+                       /*blobSize=*/6,
+                       /*offset=*/1,
+                       /*length=*/3,
+                       /*chunkSize=*/4,
+                       ObjectFetchContext::getNullContext())
+                   .get(0ms);
+
+  EXPECT_EQ("666", range->moveToFbString());
+  EXPECT_EQ(0, backingStore->getRangeAccessCount(hash6));
+}
+
+TEST_F(BlobAccessTest, concurrent_range_reads_share_chunk_fetches) {
+  auto hash7 = ObjectId::fromHex("0000000000000000000000000000000000000004");
+  auto* storedBlob = backingStore->putBlob(hash7, "abcdef"_sp);
+  backingStore->setSupportsBlobRanges(true);
+
+  auto getRange = [&](uint64_t offset, uint64_t length) {
+    return blobAccess->getBlobRange(
+        hash7,
+        /*blobSize=*/6,
+        offset,
+        length,
+        /*chunkSize=*/2,
+        ObjectFetchContext::getNullContext());
+  };
+
+  auto readahead = getRange(2, 4);
+  auto read = getRange(3, 2);
+  EXPECT_EQ(2, backingStore->getRangeAccessCount(hash7));
+  EXPECT_FALSE(read.isReady());
+
+  storedBlob->setReady();
+  EXPECT_EQ("cd", std::move(read).get(0ms)->moveToFbString());
+  EXPECT_EQ("cdef", std::move(readahead).get(0ms)->moveToFbString());
+  EXPECT_EQ(2, backingStore->getRangeAccessCount(hash7));
+}
@@ -118,3 +118,83 @@ TEST(BlobCache, does_not_forget_blob_until_last_handle_is_forgotten) {
   result2.interestHandle.reset();
   EXPECT_FALSE(weak.lock());
 }
+
+namespace {
+std::shared_ptr<const Blob> makeTextBlob(uint8_t id, size_t size) {
+  std::array<uint8_t, 20> bytes{};
+  bytes[19] = id;
+  std::string contents;
+  while (contents.size() < size) {
+    contents += "int main() { return 0; }\n";
+  }
+  contents.resize(size);
+  return std::make_shared<Blob>(
+      ObjectId{folly::ByteRange{bytes.data(), bytes.size()}},
+      folly::StringPiece{contents});
+}
+} // namespace
+
+TEST(BlobCache, compressed_tier_serves_evicted_blobs) {
+  auto cache =
+      BlobCache::create(4096, 0, 1, ObjectCacheEvictionPolicy::LRU, 4096);
+  auto first = makeTextBlob(1, 4096);
+  auto second = makeTextBlob(2, 4096);
+  cache->insert(first);
+  cache->insert(second); // evicts first into the compressed tier
+
+  EXPECT_EQ(1, cache->getStats().objectCount);
+  auto compressedStats = cache->getCompressedTierStats();
+  EXPECT_EQ(1, compressedStats.objectCount);
+  EXPECT_LT(compressedStats.totalSizeInBytes, 4096);
+  EXPECT_EQ(4096, compressedStats.uncompressedSizeInBytes);
+
+  auto result = cache->get(first->getHash());
+  ASSERT_TRUE(result.object);
+  EXPECT_NE(first, result.object) << "blob was inflated from compressed tier";
+  EXPECT_TRUE(folly::IOBufEqualTo{}(
+      result.object->getContents(), first->getContents()));
+  EXPECT_EQ(1, cache->getCompressedTierStats().hitCount);
+  EXPECT_EQ(1, cache->getStats().missCount);
+
+  // The inflated blob is back in the first tier.
+  EXPECT_TRUE(cache->contains(first->getHash()));
+}
+
+TEST(BlobCache, compressed_tier_misses_unknown_blobs) {
+  auto cache =
+      BlobCache::create(100, 0, 1, ObjectCacheEvictionPolicy::LRU, 100);
+  EXPECT_FALSE(cache->get(hash3).object);
+  EXPECT_EQ(1, cache->getCompressedTierStats().missCount);
+}
+
+TEST(BlobCache, compressed_tier_is_disabled_by_default) {
+  auto cache = BlobCache::create(4096, 0);
+  auto first = makeTextBlob(1, 4096);
+  cache->insert(first);
+  cache->insert(makeTextBlob(2, 4096));
+  EXPECT_EQ(0, cache->getCompressedTierStats().objectCount);
+  EXPECT_FALSE(cache->get(first->getHash()).object);
+}
+
+TEST(BlobCache, compressed_tier_evicts_oldest_when_full) {
+  auto cache =
+      BlobCache::create(4096, 0, 1, ObjectCacheEvictionPolicy::LRU, 400);
+  for (uint8_t i = 0; i < 20; ++i) {
+    cache->insert(makeTextBlob(i, 4096));
+  }
+  auto stats = cache->getCompressedTierStats();
+  EXPECT_LE(stats.totalSizeInBytes, 400);
+  EXPECT_GT(stats.evictionCount, 0);
+}
+
+TEST(BlobCache, clear_empties_both_tiers) {
+  auto cache =
+      BlobCache::create(4096, 0, 1, ObjectCacheEvictionPolicy::LRU, 4096);
+  auto first = makeTextBlob(1, 4096);
+  cache->insert(first);
+  cache->insert(makeTextBlob(2, 4096));
+  cache->clear();
+  EXPECT_EQ(0, cache->getStats().objectCount);
+  EXPECT_EQ(0, cache->getCompressedTierStats().objectCount);
+  EXPECT_FALSE(cache->get(first->getHash()).object);
+}
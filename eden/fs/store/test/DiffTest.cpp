@@ -19,6 +19,7 @@
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/SortedDiffCallback.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
@@ -32,6 +33,7 @@ using namespace std::chrono_literals;
 using folly::Future;
 using folly::StringPiece;
 using std::make_shared;
+using ::testing::ElementsAre;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 
@@ -90,7 +92,9 @@ class DiffTest : public ::testing::Test {
       std::unique_ptr<TopLevelIgnores> topLevelIgnores,
       DiffContext::LoadFileFunction loadFileContentsFromPath,
       bool listIgnored = true,
-      CaseSensitivity caseSensitive = kPathMapDefaultCaseSensitive) {
+      CaseSensitivity caseSensitive = kPathMapDefaultCaseSensitive,
+      size_t maxConcurrentTreeFetches = 0,
+      std::vector<RelativePath> pathPrefixes = {}) {
     return std::make_unique<DiffContext>(
         callback,
         folly::CancellationToken{},
@@ -98,7 +102,10 @@ class DiffTest : public ::testing::Test {
         caseSensitive,
         store_.get(),
         std::move(topLevelIgnores),
-        loadFileContentsFromPath);
+        loadFileContentsFromPath,
+        maxConcurrentTreeFetches,
+        nullptr,
+        std::move(pathPrefixes));
   }
 
   Future<ScmStatus> diffCommitsFuture(
@@ -1424,3 +1431,201 @@ TEST_F(DiffTest, directoryDiff) {
   // TODO(xavierd): Are we missing a change to the root whenever a file to the
   // root is created/removed?
 }
+
+namespace {
+
+/**
+ * Builds two commits whose top-level directories a, b and c each gain a file,
+ * with none of their trees ready in the backing store.
+ */
+std::pair<FakeTreeBuilder, FakeTreeBuilder> makeUnreadySubtrees(
+    const std::shared_ptr<FakeBackingStore>& backingStore) {
+  FakeTreeBuilder builder1;
+  builder1.setFile("a/1", "1\n");
+  builder1.setFile("b/1", "1\n");
+  builder1.setFile("c/1", "1\n");
+  builder1.finalize(backingStore, /* setReady */ false);
+  builder1.setReady("");
+
+  auto builder2 = builder1.clone();
+  builder2.setFile("a/2", "2\n");
+  builder2.setFile("b/2", "2\n");
+  builder2.setFile("c/2", "2\n");
+  builder2.finalize(backingStore, /* setReady */ false);
+  builder2.setReady("");
+
+  return {std::move(builder1), std::move(builder2)};
+}
+
+struct RecordingDiffCallback : public DiffCallback {
+  void ignoredPath(RelativePathPiece, dtype_t) override {}
+
+  void addedPath(RelativePathPiece path, dtype_t type) override {
+    if (type != dtype_t::Dir) {
+      paths.wlock()->push_back(path.copy());
+    }
+  }
+
+  void removedPath(RelativePathPiece, dtype_t) override {}
+  void modifiedPath(RelativePathPiece, dtype_t) override {}
+
+  void diffError(RelativePathPiece /*path*/, const folly::exception_wrapper& ew)
+      override {
+    ew.throw_exception();
+  }
+
+  folly::Synchronized<std::vector<RelativePath>> paths;
+};
+
+} // namespace
+
+TEST_F(DiffTest, limitsConcurrentTreeFetches) {
+  auto builders = makeUnreadySubtrees(backingStore_);
+  auto& builder1 = builders.first;
+  auto& builder2 = builders.second;
+
+  auto callback = std::make_unique<ScmStatusDiffCallback>();
+  auto topLevelIgnores = std::make_unique<TopLevelIgnores>("", "");
+  auto gitIgnoreStack = topLevelIgnores->getStack();
+  auto diffContext = makeDiffContext(
+      callback.get(),
+      std::move(topLevelIgnores),
+      nullptr,
+      true,
+      kPathMapDefaultCaseSensitive,
+      /* maxConcurrentTreeFetches */ 2);
+
+  auto fut = diffTrees(
+      diffContext.get(),
+      RelativePathPiece{},
+      builder1.getRoot()->get().getHash(),
+      builder2.getRoot()->get().getHash(),
+      gitIgnoreStack,
+      false);
+
+  auto fetchCount = [&] {
+    size_t count = 0;
+    for (auto* builder : {&builder1, &builder2}) {
+      for (auto dir : {"a", "b", "c"}) {
+        auto hash = builder->getStoredTree(RelativePathPiece{dir})
+                        ->get()
+                        .getHash();
+        count += backingStore_->getAccessCount(hash);
+      }
+    }
+    return count;
+  };
+
+  // Only the two fetches for "a" may be outstanding.
+  EXPECT_EQ(2, fetchCount());
+  builder1.setReady("a");
+  EXPECT_EQ(3, fetchCount());
+  builder2.setReady("a");
+  EXPECT_EQ(4, fetchCount());
+  EXPECT_FALSE(fut.isReady());
+
+  builder1.setReady("b");
+  builder2.setReady("b");
+  builder1.setReady("c");
+  builder2.setReady("c");
+  EXPECT_EQ(6, fetchCount());
+  ASSERT_TRUE(fut.isReady());
+  std::move(fut).get();
+
+  EXPECT_THAT(
+      *callback->extractStatus().entries_ref(),
+      UnorderedElementsAre(
+          Pair("a/2", ScmFileStatus::ADDED),
+          Pair("b/2", ScmFileStatus::ADDED),
+          Pair("c/2", ScmFileStatus::ADDED)));
+}
+
+TEST_F(DiffTest, sortedCallbackIgnoresFetchOrder) {
+  auto builders = makeUnreadySubtrees(backingStore_);
+  auto& builder1 = builders.first;
+  auto& builder2 = builders.second;
+
+  RecordingDiffCallback recorded;
+  SortedDiffCallback sorted{&recorded};
+  auto topLevelIgnores = std::make_unique<TopLevelIgnores>("", "");
+  auto gitIgnoreStack = topLevelIgnores->getStack();
+  auto diffContext =
+      makeDiffContext(&sorted, std::move(topLevelIgnores), nullptr);
+
+  auto fut = diffTrees(
+      diffContext.get(),
+      RelativePathPiece{},
+      builder1.getRoot()->get().getHash(),
+      builder2.getRoot()->get().getHash(),
+      gitIgnoreStack,
+      false);
+
+  // Complete the subtrees in reverse order.
+  for (auto dir : {"c", "b", "a"}) {
+    builder1.setReady(dir);
+    builder2.setReady(dir);
+  }
+  ASSERT_TRUE(fut.isReady());
+  std::move(fut).get();
+
+  EXPECT_TRUE(recorded.paths.rlock()->empty());
+  sorted.flush();
+  EXPECT_THAT(
+      *recorded.paths.rlock(),
+      ElementsAre(
+          RelativePath{"a/2"}, RelativePath{"b/2"}, RelativePath{"c/2"}));
+}
+
+TEST_F(DiffTest, pathPrefixesLimitDiff) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/b/c/d.txt", "d");
+  builder.setFile("a/b/1.txt", "1");
+  builder.setFile("a/b/2.txt", "2");
+  builder.setFile("src/main.c", "hello world");
+  builder.setFile("src/test/test.c", "testing");
+  builder.setFile("srcs/other.c", "other");
+  builder.finalize(backingStore_, /* setReady */ true);
+
+  auto builder2 = builder.clone();
+  builder2.replaceFile("a/b/c/d.txt", "d v2");
+  builder2.replaceFile("a/b/1.txt", "1 v2");
+  builder2.removeFile("a/b/2.txt");
+  builder2.replaceFile("src/main.c", "hello world v2");
+  builder2.setFile("src/test/test2.c", "another test");
+  builder2.replaceFile("srcs/other.c", "other v2");
+  builder2.finalize(backingStore_, /* setReady */ true);
+
+  auto callback = std::make_unique<ScmStatusDiffCallback>();
+  auto topLevelIgnores = std::make_unique<TopLevelIgnores>("", "");
+  auto gitIgnoreStack = topLevelIgnores->getStack();
+  auto diffContext = makeDiffContext(
+      callback.get(),
+      std::move(topLevelIgnores),
+      nullptr,
+      true,
+      kPathMapDefaultCaseSensitive,
+      0,
+      {RelativePath{"src/test"}, RelativePath{"a/b/2.txt"}});
+
+  diffTrees(
+      diffContext.get(),
+      RelativePathPiece{},
+      builder.getRoot()->get().getHash(),
+      builder2.getRoot()->get().getHash(),
+      gitIgnoreStack,
+      false)
+      .get(100ms);
+
+  EXPECT_THAT(
+      *callback->extractStatus().entries_ref(),
+      UnorderedElementsAre(
+          Pair("src/test/test2.c", ScmFileStatus::ADDED),
+          Pair("a/b/2.txt", ScmFileStatus::REMOVED)));
+
+  // Directories outside of the prefixes were not even fetched.
+  for (auto dir : {"a/b/c", "srcs"}) {
+    auto hash =
+        builder2.getStoredTree(RelativePathPiece{dir})->get().getHash();
+    EXPECT_EQ(0, backingStore_->getAccessCount(hash)) << dir;
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/KeyAccessTracker.h"
+
+#include <folly/portability/GTest.h>
+#include <string>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+folly::ByteRange key(folly::StringPiece name) {
+  return folly::ByteRange{name};
+}
+
+} // namespace
+
+TEST(KeyAccessTracker, ageIsBucketsSinceLastAccess) {
+  KeyAccessTracker tracker{4, 1h, 1000};
+  KeyAccessTracker::Clock::time_point start{};
+
+  tracker.recordAccess(key("old"), start);
+  tracker.recordAccess(key("new"), start + 2h);
+
+  EXPECT_EQ(2, tracker.getAge(key("old"), start + 2h));
+  EXPECT_EQ(0, tracker.getAge(key("new"), start + 2h));
+  EXPECT_EQ(4, tracker.getAge(key("never"), start + 2h));
+
+  // A new access makes the key young again.
+  tracker.recordAccess(key("old"), start + 3h);
+  EXPECT_EQ(0, tracker.getAge(key("old"), start + 3h));
+}
+
+TEST(KeyAccessTracker, forgetsKeysOutsideTheWindow) {
+  KeyAccessTracker tracker{4, 1h, 1000};
+  KeyAccessTracker::Clock::time_point start{};
+
+  tracker.recordAccess(key("a"), start);
+  EXPECT_EQ(3, tracker.getAge(key("a"), start + 3h));
+  EXPECT_EQ(4, tracker.getAge(key("a"), start + 4h));
+
+  // Recording a later access drops the expired bucket entirely.
+  tracker.recordAccess(key("b"), start + 10h);
+  EXPECT_EQ(4, tracker.getAge(key("a"), start + 10h));
+}
+
+TEST(KeyAccessTracker, fullBucketsStopRecording) {
+  KeyAccessTracker tracker{4, 1h, 160};
+  KeyAccessTracker::Clock::time_point start{};
+
+  for (int i = 0; i < 10'000; ++i) {
+    tracker.recordAccess(key(std::to_string(i)), start);
+  }
+
+  size_t tracked = 0;
+  for (int i = 0; i < 10'000; ++i) {
+    if (tracker.getAge(key(std::to_string(i)), start) == 0) {
+      ++tracked;
+    }
+  }
+  EXPECT_LE(tracked, 160);
+  EXPECT_GT(tracked, 0);
+}
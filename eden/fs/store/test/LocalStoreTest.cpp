@@ -8,8 +8,11 @@
 #ifndef _WIN32
 
 #include "eden/fs/store/test/LocalStoreTest.h"
+#include <fmt/format.h>
 #include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/SharedPackStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TieredLocalStore.h"
 
 namespace {
 
@@ -28,6 +31,15 @@ LocalStoreImplResult makeSqliteLocalStore(FaultInjector*) {
   return {std::move(tempDir), std::move(store)};
 }
 
+LocalStoreImplResult makeTieredLocalStore(FaultInjector*) {
+  auto tempDir = makeTempDir();
+  auto store = std::make_unique<TieredLocalStore>(
+      std::make_shared<MemoryLocalStore>(),
+      std::make_shared<SharedPackStore>(
+          AbsolutePathPiece{tempDir.path().string()} + "shared"_pc));
+  return {std::move(tempDir), std::move(store)};
+}
+
 TEST_P(LocalStoreTest, testReadAndWriteBlob) {
   ObjectId hash = ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0");
 
@@ -215,6 +227,90 @@ TEST_P(LocalStoreTest, testClearKeySpace) {
   EXPECT_TRUE(store_->hasKey(KeySpace::TreeFamily, "tree"_sp));
 }
 
+TEST_P(LocalStoreTest, getBatch_returns_results_in_request_order) {
+  // Enough keys to span several MultiGet calls in RocksDbLocalStore.
+  constexpr size_t kKeyCount = 5000;
+  auto batch = store_->beginWrite();
+  for (size_t i = 0; i < kKeyCount; i += 2) {
+    batch->put(
+        KeySpace::BlobFamily,
+        StringPiece{fmt::format("key{}", i)},
+        StringPiece{fmt::format("value{}", i)});
+  }
+  batch->flush();
+
+  // Request the keys in descending order, so they are not sorted, and include
+  // the odd keys which were never written.
+  std::vector<std::string> keyStorage;
+  for (size_t i = kKeyCount; i > 0; --i) {
+    keyStorage.push_back(fmt::format("key{}", i - 1));
+  }
+  std::vector<folly::ByteRange> keys;
+  for (auto& key : keyStorage) {
+    keys.emplace_back(StringPiece{key});
+  }
+
+  auto results = store_->getBatch(KeySpace::BlobFamily, keys).get();
+  ASSERT_EQ(kKeyCount, results.size());
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    auto index = kKeyCount - 1 - i;
+    if (index % 2 == 0) {
+      ASSERT_TRUE(results[i].isValid()) << keyStorage[i];
+      EXPECT_EQ(fmt::format("value{}", index), results[i].piece());
+    } else {
+      EXPECT_FALSE(results[i].isValid()) << keyStorage[i];
+    }
+  }
+}
+
+TEST_P(LocalStoreTest, hasKeyBatch_returns_results_in_request_order) {
+  store_->put(KeySpace::BlobFamily, "key1"_sp, "value1"_sp);
+  store_->put(KeySpace::TreeFamily, "key2"_sp, "value2"_sp);
+  std::vector<folly::ByteRange> keys{
+      "key2"_sp, "key1"_sp, "key3"_sp, "key1"_sp};
+  auto results = store_->hasKeyBatch(KeySpace::BlobFamily, keys).get();
+  EXPECT_EQ((std::vector<bool>{false, true, false, true}), results);
+}
+
+TEST_P(LocalStoreTest, getBatch_with_no_keys) {
+  auto results = store_->getBatch(KeySpace::BlobFamily, {}).get();
+  EXPECT_TRUE(results.empty());
+}
+
+TEST(MemoryLocalStoreTest, get_does_not_copy_values) {
+  MemoryLocalStore store;
+  store.put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+  auto first = store.get(KeySpace::BlobFamily, "key"_sp);
+  auto second = store.get(KeySpace::BlobFamily, "key"_sp);
+  EXPECT_EQ(first.bytes().data(), second.bytes().data());
+  auto buf = first.extractIOBuf();
+  EXPECT_TRUE(buf.isShared());
+  EXPECT_EQ("value", buf.moveToFbString());
+}
+
+TEST(MemoryLocalStoreTest, evicts_ephemeral_values_over_the_budget) {
+  constexpr size_t kMaxBytes = 64 * 1024;
+  MemoryLocalStore store{kMaxBytes};
+  std::string value(100, 'x');
+  for (int i = 0; i < 10000; ++i) {
+    auto key = fmt::format("key{}", i);
+    store.put(KeySpace::BlobFamily, StringPiece{key}, StringPiece{value});
+    store.put(KeySpace::HgProxyHashFamily, StringPiece{key}, "proxy"_sp);
+  }
+
+  size_t blobs = 0;
+  for (int i = 0; i < 10000; ++i) {
+    auto key = fmt::format("key{}", i);
+    blobs += store.hasKey(KeySpace::BlobFamily, StringPiece{key});
+    // Persistent key spaces are never evicted.
+    EXPECT_TRUE(store.hasKey(KeySpace::HgProxyHashFamily, StringPiece{key}));
+  }
+  EXPECT_GT(blobs, 0);
+  EXPECT_LT(blobs * value.size(), kMaxBytes);
+  // The most recent write is never evicted to make room for older ones.
+  EXPECT_TRUE(store.hasKey(KeySpace::BlobFamily, "key9999"_sp));
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
@@ -226,6 +322,11 @@ INSTANTIATE_TEST_CASE_P(
     Sqlite,
     LocalStoreTest,
     ::testing::Values(makeSqliteLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Tiered,
+    LocalStoreTest,
+    ::testing::Values(makeTieredLocalStore));
 #pragma clang diagnostic pop
 
 } // namespace
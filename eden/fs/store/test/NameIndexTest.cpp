@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/NameIndex.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/testharness/TestUtil.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using ::testing::ElementsAre;
+
+namespace {
+
+class NameIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // root/
+    //   BUCK
+    //   lib/
+    //     BUCK
+    //     lib.c
+    localStore_ = std::make_shared<MemoryLocalStore>();
+    lib_ = std::make_shared<Tree>(
+        std::vector<TreeEntry>{
+            TreeEntry{
+                makeTestHash("2"), "BUCK"_pc, TreeEntryType::REGULAR_FILE},
+            TreeEntry{
+                makeTestHash("3"), "lib.c"_pc, TreeEntryType::REGULAR_FILE}},
+        makeTestHash("10"));
+    root_ = std::make_shared<Tree>(
+        std::vector<TreeEntry>{
+            TreeEntry{
+                makeTestHash("1"), "BUCK"_pc, TreeEntryType::EXECUTABLE_FILE},
+            TreeEntry{makeTestHash("10"), "lib"_pc, TreeEntryType::TREE}},
+        makeTestHash("11"));
+  }
+
+  static std::vector<std::string> getPaths(
+      const NameIndex& index,
+      PathComponentPiece name) {
+    std::vector<std::string> paths;
+    for (const auto& entry : index.lookup(name)) {
+      paths.push_back(entry.path.stringPiece().str());
+    }
+    return paths;
+  }
+
+  std::shared_ptr<LocalStore> localStore_;
+  std::shared_ptr<Tree> lib_;
+  std::shared_ptr<Tree> root_;
+};
+
+} // namespace
+
+TEST_F(NameIndexTest, buildNeedsAllTreesInTheLocalStore) {
+  auto missing = NameIndex::buildFromLocalStore(localStore_, *root_).get(0ms);
+  EXPECT_FALSE(missing.has_value());
+
+  localStore_->putTree(*lib_);
+  auto index = NameIndex::buildFromLocalStore(localStore_, *root_).get(0ms);
+  ASSERT_TRUE(index.has_value());
+  EXPECT_EQ(4, index->size());
+  EXPECT_THAT(getPaths(*index, "BUCK"_pc), ElementsAre("BUCK", "lib/BUCK"));
+  EXPECT_THAT(getPaths(*index, "lib"_pc), ElementsAre("lib"));
+  EXPECT_THAT(getPaths(*index, "lib.c"_pc), ElementsAre("lib/lib.c"));
+  EXPECT_TRUE(getPaths(*index, "TARGETS"_pc).empty());
+}
+
+TEST_F(NameIndexTest, serializeRoundTrips) {
+  localStore_->putTree(*lib_);
+  auto index = NameIndex::buildFromLocalStore(localStore_, *root_).get(0ms);
+  ASSERT_TRUE(index.has_value());
+
+  auto copy = NameIndex::deserialize(index->serialize());
+  ASSERT_TRUE(copy.has_value());
+  EXPECT_EQ(index->size(), copy->size());
+  auto bucks = copy->lookup("BUCK"_pc);
+  ASSERT_EQ(2, bucks.size());
+  EXPECT_EQ(makeTestHash("1"), bucks[0].entry.getHash());
+  EXPECT_EQ(TreeEntryType::EXECUTABLE_FILE, bucks[0].entry.getType());
+  EXPECT_EQ(makeTestHash("2"), bucks[1].entry.getHash());
+  EXPECT_TRUE(copy->lookup("lib"_pc)[0].entry.isTree());
+
+  EXPECT_FALSE(NameIndex::deserialize("").has_value());
+  EXPECT_FALSE(NameIndex::deserialize("x").has_value());
+  auto truncated = index->serialize();
+  truncated.resize(truncated.size() - 1);
+  EXPECT_FALSE(NameIndex::deserialize(truncated).has_value());
+}
+
+TEST_F(NameIndexTest, cacheStoresIndexesInTheLocalStore) {
+  RootId rootId{"commit"};
+  NameIndexCache cache{localStore_, 1};
+  EXPECT_EQ(nullptr, cache.get(rootId, *root_).get(0ms));
+
+  localStore_->putTree(*lib_);
+  auto index = cache.get(rootId, *root_).get(0ms);
+  ASSERT_NE(nullptr, index);
+  EXPECT_EQ(index, cache.get(rootId, *root_).get(0ms));
+  EXPECT_TRUE(localStore_
+                  ->get(
+                      KeySpace::NameIndexFamily,
+                      folly::ByteRange{folly::StringPiece{"commit"}})
+                  .isValid());
+
+  // Another cache finds it without the trees.
+  localStore_->clearKeySpace(KeySpace::TreeFamily);
+  NameIndexCache other{localStore_, 1};
+  auto stored = other.get(rootId, *root_).get(0ms);
+  ASSERT_NE(nullptr, stored);
+  EXPECT_THAT(getPaths(*stored, "BUCK"_pc), ElementsAre("BUCK", "lib/BUCK"));
+}
@@ -534,3 +534,208 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+/**
+ * sharded cache test cases
+ */
+
+TEST(ObjectCache, sharded_cache_splits_limits_between_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(40, 3, 4);
+  EXPECT_EQ(4, cache->getShardCount());
+
+  // Every shard can hold 10 bytes and keeps at least one entry, so inserting
+  // many objects never exceeds the total budget by more than one entry per
+  // shard.
+  std::vector<std::shared_ptr<CacheObject>> objects;
+  for (uint8_t i = 0; i < 64; ++i) {
+    std::array<uint8_t, 20> bytes{};
+    bytes[19] = i;
+    objects.push_back(std::make_shared<CacheObject>(
+        ObjectId{folly::ByteRange{bytes.data(), bytes.size()}}, 3));
+    cache->insertSimple(objects.back());
+  }
+
+  auto stats = cache->getStats();
+  EXPECT_LE(stats.totalSizeInBytes, 40);
+  EXPECT_GE(stats.objectCount, 4);
+  EXPECT_EQ(64 - stats.objectCount, stats.evictionCount);
+
+  // The most recently inserted object is always still cached in its shard.
+  EXPECT_EQ(objects.back(), cache->getSimple(objects.back()->getHash()));
+}
+
+TEST(ObjectCache, zero_shards_is_treated_as_one) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1, 0);
+  EXPECT_EQ(1, cache->getShardCount());
+  cache->insertSimple(object3);
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+}
+
+TEST(ObjectCache, sharded_cache_aggregates_stats_and_clears_all_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          1000, 0, 8);
+  cache->insertInterestHandle(object3);
+  cache->insertInterestHandle(object4);
+  cache->insertInterestHandle(object5);
+  cache->insertInterestHandle(object6);
+
+  EXPECT_TRUE(cache->getInterestHandle(hash3).object);
+  EXPECT_TRUE(cache->getInterestHandle(hash6).object);
+  EXPECT_FALSE(cache->getInterestHandle(hash9).object);
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(4, stats.objectCount);
+  EXPECT_EQ(18, stats.totalSizeInBytes);
+  EXPECT_EQ(2, stats.hitCount);
+  EXPECT_EQ(1, stats.missCount);
+
+  cache->clear();
+  stats = cache->getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(0, stats.totalSizeInBytes);
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_FALSE(cache->contains(hash6));
+}
+
+TEST(ObjectCache, sharded_cache_interest_handle_evicts_from_its_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          1000, 0, 8);
+  auto handle3 = cache->insertInterestHandle(
+      object3,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  cache->insertInterestHandle(object4);
+  EXPECT_TRUE(cache->contains(hash3));
+  handle3.reset();
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_EQ(1, cache->getStats().dropCount);
+}
+
+/**
+ * TinyLFU eviction policy test cases
+ */
+
+namespace {
+std::vector<std::shared_ptr<CacheObject>> makeObjects(
+    uint8_t prefix,
+    size_t count,
+    size_t size) {
+  std::vector<std::shared_ptr<CacheObject>> objects;
+  for (size_t i = 0; i < count; ++i) {
+    std::array<uint8_t, 20> bytes{};
+    bytes[0] = prefix;
+    bytes[19] = static_cast<uint8_t>(i);
+    objects.push_back(std::make_shared<CacheObject>(
+        ObjectId{folly::ByteRange{bytes.data(), bytes.size()}}, size));
+  }
+  return objects;
+}
+
+template <typename Cache>
+void warmAndScan(
+    Cache& cache,
+    const std::vector<std::shared_ptr<CacheObject>>& hot,
+    const std::vector<std::shared_ptr<CacheObject>>& scan) {
+  for (auto& object : hot) {
+    cache->insertSimple(object);
+  }
+  for (int round = 0; round < 5; ++round) {
+    for (auto& object : hot) {
+      cache->getSimple(object->getHash());
+    }
+  }
+  for (auto& object : scan) {
+    cache->insertSimple(object);
+  }
+}
+} // namespace
+
+TEST(ObjectCache, lru_scan_evicts_hot_objects) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      100, 0, 1, ObjectCacheEvictionPolicy::LRU);
+  auto hot = makeObjects(1, 9, 10);
+  warmAndScan(cache, hot, makeObjects(2, 50, 10));
+
+  for (auto& object : hot) {
+    EXPECT_FALSE(cache->contains(object->getHash()));
+  }
+  EXPECT_EQ(0, cache->getStats().admissionRejectCount);
+}
+
+TEST(ObjectCache, tinylfu_scan_does_not_evict_hot_objects) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      100, 0, 1, ObjectCacheEvictionPolicy::TinyLFU);
+  auto hot = makeObjects(1, 9, 10);
+  auto scan = makeObjects(2, 50, 10);
+  warmAndScan(cache, hot, scan);
+
+  for (auto& object : hot) {
+    EXPECT_TRUE(cache->contains(object->getHash()));
+  }
+  // The most recent scanned object is still in the admission window.
+  EXPECT_TRUE(cache->contains(scan.back()->getHash()));
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(49, stats.admissionRejectCount);
+  EXPECT_LE(stats.totalSizeInBytes, 100);
+}
+
+TEST(ObjectCache, tinylfu_admits_frequently_accessed_new_objects) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      100, 0, 1, ObjectCacheEvictionPolicy::TinyLFU);
+  auto hot = makeObjects(1, 9, 10);
+  warmAndScan(cache, hot, makeObjects(2, 5, 10));
+
+  auto popular = makeObjects(3, 2, 10);
+  cache->insertSimple(popular[0]);
+  for (int i = 0; i < 10; ++i) {
+    cache->getSimple(popular[0]->getHash());
+  }
+  // Pushes popular[0] out of the window, where it beats the LRU main entry.
+  cache->insertSimple(popular[1]);
+
+  EXPECT_TRUE(cache->contains(popular[0]->getHash()));
+  EXPECT_FALSE(cache->contains(hot[0]->getHash()));
+  EXPECT_LE(cache->getStats().totalSizeInBytes, 100);
+}
+
+TEST(ObjectCache, tinylfu_interest_handle_drop_evicts_from_window) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          100, 0, 1, ObjectCacheEvictionPolicy::TinyLFU);
+  auto handle3 = cache->insertInterestHandle(
+      object3,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  EXPECT_TRUE(cache->contains(hash3));
+  handle3.reset();
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_EQ(0, cache->getStats().totalSizeInBytes);
+
+  // The window accounting must be back to zero, so later inserts still work.
+  cache->insertInterestHandle(object4);
+  cache->insertInterestHandle(object5);
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_TRUE(cache->contains(hash5));
+  EXPECT_EQ(9, cache->getStats().totalSizeInBytes);
+}
+
+TEST(ObjectCache, most_recently_used_ids) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 1);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->getSimple(hash3);
+
+  EXPECT_EQ(
+      (std::vector<ObjectId>{hash3, hash5, hash4}),
+      cache->getMostRecentlyUsedIds(10));
+  EXPECT_EQ(
+      (std::vector<ObjectId>{hash3, hash5}), cache->getMostRecentlyUsedIds(2));
+}
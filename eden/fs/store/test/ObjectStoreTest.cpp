@@ -105,6 +105,20 @@ TEST_F(ObjectStoreTest, getBlob_tracks_second_read_from_cache) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, getUncachedBlobs_skips_blobs_in_local_store) {
+  auto otherBlobId = putReadyBlob("otherblob");
+  objectStore->getBlob(readyBlobId, context).get(0ms);
+
+  auto uncached =
+      objectStore->getUncachedBlobs({otherBlobId, readyBlobId}).get(0ms);
+  EXPECT_EQ(std::vector<ObjectId>{otherBlobId}, uncached);
+
+  // Without blob caching, nothing can be skipped.
+  localStore->enableBlobCaching.store(false);
+  uncached = objectStore->getUncachedBlobs({otherBlobId, readyBlobId}).get(0ms);
+  EXPECT_EQ((std::vector<ObjectId>{otherBlobId, readyBlobId}), uncached);
+}
+
 TEST_F(ObjectStoreTest, getTree_tracks_backing_store_read) {
   objectStore->getTree(readyTreeId, context).get(0ms);
   ASSERT_EQ(1, context.requests.size());
@@ -222,6 +236,81 @@ TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
   EXPECT_EQ(1, fakeBackingStore->getAccessCount(readyBlobId));
 }
 
+TEST_F(ObjectStoreTest, blake3_is_saved_with_the_metadata) {
+  auto data = "A"_sp;
+  ObjectId id = putReadyBlob(data);
+
+  EXPECT_EQ(
+      std::nullopt, objectStore->getBlobMetadata(id, context).get().blake3);
+  auto blake3 =
+      objectStore->getBlobMetadataWithBlake3(id, context).get(0ms).blake3;
+  EXPECT_EQ(Blake3::hash(folly::ByteRange{data}), blake3);
+  auto accesses = fakeBackingStore->getAccessCount(id);
+
+  objectStore = ObjectStore::create(
+      localStore,
+      backingStore,
+      treeCache,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig());
+  EXPECT_EQ(
+      blake3,
+      objectStore->getBlobMetadataWithBlake3(id, context).get(0ms).blake3);
+  EXPECT_EQ(blake3, objectStore->getBlobMetadata(id, context).get(0ms).blake3);
+  EXPECT_EQ(accesses, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, prefetchBlobMetadata_loads_local_store_into_cache) {
+  ObjectId missingId;
+  // Caches the metadata in the local store.
+  objectStore->getBlobSize(readyBlobId, context).get(0ms);
+  objectStore = ObjectStore::create(
+      localStore,
+      backingStore,
+      treeCache,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig());
+
+  objectStore->prefetchBlobMetadata({readyBlobId, missingId}).get(0ms);
+  objectStore->getBlobSize(readyBlobId, context).get(0ms);
+  ASSERT_EQ(2, context.requests.size());
+  EXPECT_EQ(ObjectFetchContext::FromMemoryCache, context.requests[1].origin);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(readyBlobId));
+}
+
+TEST_F(ObjectStoreTest, tree_metadata_is_cached_for_its_entries) {
+  auto data = "content"_sp;
+  StoredBlob* storedBlob = fakeBackingStore->putBlob(data);
+  ObjectId blobId = storedBlob->get().getHash();
+  Hash20 sha1 = Hash20::sha1(folly::ByteRange{data});
+  StoredTree* storedTree = fakeBackingStore->putTree(std::vector<TreeEntry>{
+      TreeEntry{
+          blobId,
+          PathComponent{"a"},
+          TreeEntryType::REGULAR_FILE,
+          data.size(),
+          sha1}});
+  storedTree->setReady();
+
+  objectStore->getTree(storedTree->get().getHash(), context).get(0ms);
+
+  // The blob was never made ready, so this would hang if it were fetched.
+  EXPECT_EQ(data.size(), objectStore->getBlobSize(blobId, context).get(0ms));
+  EXPECT_EQ(sha1, objectStore->getBlobSha1(blobId, context).get(0ms));
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(blobId));
+
+  auto stored = localStore->getBlobMetadata(blobId).get(0ms);
+  ASSERT_TRUE(stored.has_value());
+  EXPECT_EQ(sha1, stored->sha1);
+  EXPECT_EQ(data.size(), stored->size);
+}
+
 class PidFetchContext : public ObjectFetchContext {
  public:
   PidFetchContext(pid_t pid) : ObjectFetchContext{}, pid_{pid} {}
@@ -258,3 +347,79 @@ TEST_F(ObjectStoreTest, test_process_access_counts) {
   EXPECT_EQ(2, objectStore->getPidFetches().rlock()->at(pid0));
   EXPECT_EQ(1, objectStore->getPidFetches().rlock()->at(pid1));
 }
+
+TEST_F(ObjectStoreTest, concurrent_getBlob_calls_share_one_fetch) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("pending blob");
+  auto id = storedBlob->get().getHash();
+
+  LoggingFetchContext context2;
+  auto future1 = objectStore->getBlob(id, context);
+  auto future2 = objectStore->getBlob(id, context2);
+  EXPECT_FALSE(future1.isReady());
+  EXPECT_FALSE(future2.isReady());
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  storedBlob->setReady();
+  auto blob1 = std::move(future1).get(0ms);
+  auto blob2 = std::move(future2).get(0ms);
+  EXPECT_EQ(blob1, blob2);
+
+  // Both callers record the fetch, with the origin of the shared fetch.
+  ASSERT_EQ(1, context.requests.size());
+  ASSERT_EQ(1, context2.requests.size());
+  EXPECT_EQ(ObjectFetchContext::FromNetworkFetch, context2.requests[0].origin);
+
+  // Once the fetch has finished, new requests are not joined onto it.
+  objectStore->getBlob(id, context).get(0ms);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, concurrent_getTree_calls_share_one_fetch) {
+  StoredTree* storedTree =
+      fakeBackingStore->putTree({{"a", fakeBackingStore->putBlob("a")}});
+  auto id = storedTree->get().getHash();
+
+  LoggingFetchContext context2;
+  auto future1 = objectStore->getTree(id, context);
+  auto future2 = objectStore->getTree(id, context2);
+  EXPECT_FALSE(future1.isReady());
+  EXPECT_FALSE(future2.isReady());
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  storedTree->setReady();
+  auto tree1 = std::move(future1).get(0ms);
+  auto tree2 = std::move(future2).get(0ms);
+  EXPECT_EQ(tree1, tree2);
+  EXPECT_EQ(1, context2.requests.size());
+}
+
+TEST_F(ObjectStoreTest, concurrent_getBlob_calls_share_errors) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("failing blob");
+  auto id = storedBlob->get().getHash();
+
+  auto future1 = objectStore->getBlob(id, context);
+  auto future2 = objectStore->getBlob(id, context);
+  storedBlob->triggerError(std::runtime_error("fetch failed"));
+  EXPECT_THROW_RE(std::move(future1).get(0ms), std::runtime_error, "failed");
+  EXPECT_THROW_RE(std::move(future2).get(0ms), std::runtime_error, "failed");
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, missing_blob_is_negatively_cached) {
+  auto id = ObjectId::sha1("not in the backing store");
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  // After invalidation the backing store is asked again.
+  objectStore->invalidateNegativeCache();
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, missing_tree_is_negatively_cached) {
+  auto id = ObjectId::sha1("not in the backing store");
+  EXPECT_THROW(objectStore->getTree(id, context).get(0ms), std::domain_error);
+  EXPECT_THROW(objectStore->getTree(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
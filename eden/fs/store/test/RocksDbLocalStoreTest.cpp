@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/store/test/LocalStoreTest.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 
@@ -22,6 +23,120 @@ LocalStoreImplResult makeRocksDbLocalStore(FaultInjector* faultInjector) {
   return {std::move(tempDir), std::move(store)};
 }
 
+TEST(RocksDbLocalStoreTest, memory_usage_includes_unflushed_writes) {
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto [tempDir, store] = makeRocksDbLocalStore(&faultInjector);
+  auto before = store->estimateMemoryUsage();
+
+  std::string value(64 * 1024, 'x');
+  store->put(
+      KeySpace::BlobFamily,
+      folly::StringPiece{"key"},
+      folly::StringPiece{value});
+  EXPECT_GT(store->estimateMemoryUsage(), before);
+}
+
+TEST(RocksDbLocalStoreTest, combined_writes_are_readable_before_and_after) {
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto result = makeRocksDbLocalStore(&faultInjector);
+  auto& store = result.second;
+  auto* rocksStore = static_cast<RocksDbLocalStore*>(store.get());
+  rocksStore->configureWriteCombining(true, 1024 * 1024, std::chrono::hours{1});
+
+  store->put(
+      KeySpace::BlobFamily,
+      folly::StringPiece{"put"},
+      folly::StringPiece{"one"});
+  auto batch = store->beginWrite();
+  batch->put(
+      KeySpace::BlobFamily,
+      folly::StringPiece{"batch"},
+      folly::StringPiece{"two"});
+  batch->flush();
+
+  auto check = [&] {
+    EXPECT_EQ(
+        "one",
+        store->get(KeySpace::BlobFamily, folly::StringPiece{"put"}).piece());
+    EXPECT_TRUE(
+        store->hasKey(KeySpace::BlobFamily, folly::StringPiece{"batch"}));
+    auto results = store
+                       ->getBatch(
+                           KeySpace::BlobFamily,
+                           {folly::StringPiece{"batch"},
+                            folly::StringPiece{"missing"},
+                            folly::StringPiece{"put"}})
+                       .get();
+    ASSERT_EQ(3, results.size());
+    EXPECT_EQ("two", results[0].piece());
+    EXPECT_FALSE(results[1].isValid());
+    EXPECT_EQ("one", results[2].piece());
+  };
+  check();
+
+  // Disabling write combining commits the buffered writes to RocksDB.
+  rocksStore->configureWriteCombining(
+      false, 1024 * 1024, std::chrono::hours{1});
+  check();
+}
+
+TEST(RocksDbLocalStoreTest, repack_stores_objects_in_tree_order) {
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto result = makeRocksDbLocalStore(&faultInjector);
+  auto& store = result.second;
+  auto* rocksStore = static_cast<RocksDbLocalStore*>(store.get());
+
+  auto putBlob = [&](const std::string& contents) {
+    auto id = ObjectId::sha1(contents);
+    store->put(KeySpace::BlobFamily, id, folly::StringPiece{contents});
+    return id;
+  };
+  auto fileB = putBlob("b contents");
+  Tree dir{
+      {TreeEntry{fileB, PathComponent{"b"}, TreeEntryType::REGULAR_FILE}},
+      ObjectId::sha1(std::string{"dir"})};
+  store->putTree(dir);
+  auto fileA = putBlob("a contents");
+  Tree root{
+      {TreeEntry{fileA, PathComponent{"a"}, TreeEntryType::REGULAR_FILE},
+       TreeEntry{dir.getHash(), PathComponent{"dir"}, TreeEntryType::TREE}},
+      ObjectId::sha1(std::string{"root"})};
+  store->putTree(root);
+
+  auto stats = rocksStore->repackForLocality(/*batchSize=*/1);
+  EXPECT_EQ(2, stats.trees);
+  EXPECT_EQ(2, stats.blobs);
+  EXPECT_TRUE(rocksStore->listKeys(KeySpace::BlobFamily, 10).empty());
+  EXPECT_TRUE(rocksStore->listKeys(KeySpace::TreeFamily, 10).empty());
+
+  // The data keys come first, in the order of the walk: root, a, dir, b.
+  auto keys = rocksStore->listKeys(KeySpace::LocalityFamily, 10);
+  ASSERT_EQ(8, keys.size());
+  EXPECT_EQ(
+      "a contents",
+      store->get(KeySpace::LocalityFamily, folly::StringPiece{keys[1]})
+          .piece());
+  EXPECT_EQ(
+      "b contents",
+      store->get(KeySpace::LocalityFamily, folly::StringPiece{keys[3]})
+          .piece());
+
+  // Moved objects are still found by their ID.
+  EXPECT_EQ(
+      "a contents", store->get(KeySpace::BlobFamily, fileA.getBytes()).piece());
+  EXPECT_TRUE(store->hasKey(KeySpace::BlobFamily, fileB));
+  auto results =
+      store->getBatch(KeySpace::BlobFamily, {fileB.getBytes()}).get();
+  ASSERT_EQ(1, results.size());
+  EXPECT_EQ("b contents", results[0].piece());
+  auto loaded = store->getTree(root.getHash()).get();
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(2, loaded->getTreeEntries().size());
+
+  stats = rocksStore->repackForLocality(/*batchSize=*/1);
+  EXPECT_EQ(0, stats.trees + stats.blobs);
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ScmStatusCache.h"
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+
+using namespace facebook::eden;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+namespace {
+
+ScmStatus makeStatus(
+    std::initializer_list<std::pair<std::string, ScmFileStatus>> entries) {
+  ScmStatus status;
+  for (const auto& [path, fileStatus] : entries) {
+    status.entries_ref()->emplace(path, fileStatus);
+  }
+  return status;
+}
+
+class ScmStatusCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::shared_ptr<EdenConfig> rawEdenConfig{
+        EdenConfig::createTestEdenConfig()};
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        rawEdenConfig, ConfigReloadBehavior::NoReload);
+    backingStore_ = std::make_shared<FakeBackingStore>();
+    objectStore_ = ObjectStore::create(
+        std::make_shared<MemoryLocalStore>(),
+        backingStore_,
+        TreeCache::create(edenConfig),
+        std::make_shared<EdenStats>(),
+        &folly::QueuedImmediateExecutor::instance(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        rawEdenConfig);
+  }
+
+  std::shared_ptr<FakeBackingStore> backingStore_;
+  std::shared_ptr<ObjectStore> objectStore_;
+};
+
+} // namespace
+
+TEST_F(ScmStatusCacheTest, insertAndGet) {
+  ScmStatusCache cache{objectStore_, CaseSensitivity::Sensitive};
+  EXPECT_FALSE(cache.get(RootId{"1"}, RootId{"2"}));
+
+  cache.insert(
+      RootId{"1"}, RootId{"2"}, makeStatus({{"a", ScmFileStatus::ADDED}}));
+  auto status = cache.get(RootId{"1"}, RootId{"2"});
+  ASSERT_TRUE(status);
+  EXPECT_THAT(
+      *status->entries_ref(),
+      UnorderedElementsAre(Pair("a", ScmFileStatus::ADDED)));
+
+  // The order of the roots and the case sensitivity are part of the key.
+  EXPECT_FALSE(cache.get(RootId{"2"}, RootId{"1"}));
+  ScmStatusCache insensitive{objectStore_, CaseSensitivity::Insensitive};
+  EXPECT_FALSE(insensitive.get(RootId{"1"}, RootId{"2"}));
+}
+
+TEST_F(ScmStatusCacheTest, statusesWithErrorsAreNotCached) {
+  ScmStatusCache cache{objectStore_, CaseSensitivity::Sensitive};
+  auto status = makeStatus({{"a", ScmFileStatus::ADDED}});
+  status.errors_ref()->emplace("b", "fetch failed");
+  cache.insert(RootId{"1"}, RootId{"2"}, status);
+  EXPECT_FALSE(cache.get(RootId{"1"}, RootId{"2"}));
+}
+
+TEST_F(ScmStatusCacheTest, composeThroughIntermediateRoot) {
+  FakeTreeBuilder builder1;
+  builder1.setFile("reverted", "original\n");
+  builder1.setFile("removed", "removed\n");
+  builder1.setFile("dir/modified", "1\n");
+  builder1.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("1", builder1)->setReady();
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("reverted", "changed\n");
+  builder2.replaceFile("dir/modified", "2\n");
+  builder2.setFile("dir/added", "added\n");
+  builder2.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  auto builder3 = builder2.clone();
+  builder3.replaceFile("reverted", "original\n");
+  builder3.removeFile("removed");
+  builder3.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("3", builder3)->setReady();
+
+  ScmStatusCache cache{objectStore_, CaseSensitivity::Sensitive};
+  auto& context = ObjectFetchContext::getNullContext();
+  EXPECT_FALSE(cache.compose(RootId{"1"}, RootId{"2"}, RootId{"3"}, context));
+
+  cache.insert(
+      RootId{"1"},
+      RootId{"2"},
+      makeStatus(
+          {{"reverted", ScmFileStatus::MODIFIED},
+           {"dir/modified", ScmFileStatus::MODIFIED},
+           {"dir/added", ScmFileStatus::ADDED}}));
+  EXPECT_FALSE(cache.compose(RootId{"1"}, RootId{"2"}, RootId{"3"}, context));
+
+  cache.insert(
+      RootId{"2"},
+      RootId{"3"},
+      makeStatus(
+          {{"reverted", ScmFileStatus::MODIFIED},
+           {"removed", ScmFileStatus::REMOVED}}));
+  auto composed =
+      cache.compose(RootId{"1"}, RootId{"2"}, RootId{"3"}, context);
+  ASSERT_TRUE(composed);
+  auto status = std::move(*composed).get();
+
+  EXPECT_TRUE(status.errors_ref()->empty());
+  EXPECT_THAT(
+      *status.entries_ref(),
+      UnorderedElementsAre(
+          Pair("removed", ScmFileStatus::REMOVED),
+          Pair("dir/modified", ScmFileStatus::MODIFIED),
+          Pair("dir/added", ScmFileStatus::ADDED)));
+}
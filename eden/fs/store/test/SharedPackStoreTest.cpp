@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SharedPackStore.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/store/TieredLocalStore.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FileUtils.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct SharedPackStoreTest : ::testing::Test {
+  AbsolutePath segmentPath(folly::StringPiece name) const {
+    return directory + PathComponentPiece{name};
+  }
+
+  folly::test::TemporaryDirectory tempDir = makeTempDir();
+  AbsolutePath directory{tempDir.path().string()};
+};
+
+} // namespace
+
+TEST_F(SharedPackStoreTest, returns_the_values_of_written_segments) {
+  SharedPackWriter writer;
+  writer.put(KeySpace::BlobFamily, "b"_sp, "blob b"_sp);
+  writer.put(KeySpace::BlobFamily, "a"_sp, "blob a"_sp);
+  writer.put(KeySpace::TreeFamily, "a"_sp, "tree a"_sp);
+  writer.put(KeySpace::BlobFamily, "b"_sp, "blob b again"_sp);
+  writer.write(segmentPath("1.pack"));
+
+  SharedPackStore store{directory};
+  EXPECT_EQ(1, store.getSegmentCount());
+  EXPECT_EQ("blob a", store.get(KeySpace::BlobFamily, "a"_sp).piece());
+  EXPECT_EQ("blob b again", store.get(KeySpace::BlobFamily, "b"_sp).piece());
+  EXPECT_EQ("tree a", store.get(KeySpace::TreeFamily, "a"_sp).piece());
+  EXPECT_FALSE(store.get(KeySpace::TreeFamily, "b"_sp).isValid());
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "c"_sp));
+  EXPECT_TRUE(store.hasKey(KeySpace::BlobFamily, "a"_sp));
+}
+
+TEST_F(SharedPackStoreTest, values_outlive_the_store) {
+  SharedPackWriter writer;
+  writer.put(KeySpace::BlobFamily, "a"_sp, "blob a"_sp);
+  writer.write(segmentPath("1.pack"));
+
+  auto store = std::make_unique<SharedPackStore>(directory);
+  auto result = store->get(KeySpace::BlobFamily, "a"_sp);
+  store.reset();
+  auto buf = result.extractIOBuf();
+  EXPECT_TRUE(buf.isShared());
+  EXPECT_EQ("blob a", buf.moveToFbString());
+}
+
+TEST_F(SharedPackStoreTest, refresh_maps_new_segments_and_skips_bad_ones) {
+  SharedPackStore store{directory};
+  EXPECT_EQ(0, store.getSegmentCount());
+
+  SharedPackWriter writer;
+  writer.put(KeySpace::BlobFamily, "a"_sp, "blob a"_sp);
+  writer.write(segmentPath("1.pack"));
+  writeFile(segmentPath("2.pack"), "not a pack"_sp).value();
+  writeFile(segmentPath("3.pack.tmp"), "still being written"_sp).value();
+
+  store.refresh();
+  EXPECT_EQ(1, store.getSegmentCount());
+  EXPECT_EQ("blob a", store.get(KeySpace::BlobFamily, "a"_sp).piece());
+}
+
+TEST_F(SharedPackStoreTest, missing_directory_is_empty) {
+  SharedPackStore store{directory + "missing"_pc};
+  EXPECT_EQ(0, store.getSegmentCount());
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "a"_sp));
+}
+
+TEST_F(SharedPackStoreTest, tiered_store_reads_shared_values_first) {
+  SharedPackWriter writer;
+  writer.put(KeySpace::BlobFamily, "shared"_sp, "from the pack"_sp);
+  writer.write(segmentPath("1.pack"));
+
+  auto primary = std::make_shared<MemoryLocalStore>();
+  TieredLocalStore store{primary, std::make_shared<SharedPackStore>(directory)};
+  store.put(KeySpace::BlobFamily, "local"_sp, "from the primary"_sp);
+
+  EXPECT_EQ(
+      "from the pack", store.get(KeySpace::BlobFamily, "shared"_sp).piece());
+  EXPECT_EQ(
+      "from the primary", store.get(KeySpace::BlobFamily, "local"_sp).piece());
+  EXPECT_FALSE(primary->hasKey(KeySpace::BlobFamily, "shared"_sp));
+  EXPECT_TRUE(store.hasKey(KeySpace::BlobFamily, "shared"_sp));
+
+  auto results = store
+                     .getBatch(
+                         KeySpace::BlobFamily,
+                         {"local"_sp, "missing"_sp, "shared"_sp})
+                     .get(10s);
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ("from the primary", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+  EXPECT_EQ("from the pack", results[2].piece());
+}
@@ -180,3 +180,24 @@ TEST_F(TreeCacheTest, testSizeOverflowLargeInsert) {
   EXPECT_TRUE(cache->contains(tree4->getHash()));
   EXPECT_EQ(tree4, cache->get(tree4->getHash()));
 }
+
+TEST_F(TreeCacheTest, testCompactRepresentation) {
+  auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+  rawEdenConfig->inMemoryTreeCacheCompact.setValue(
+      true, ConfigSource::Default, true);
+  auto compactCache = TreeCache::create(std::make_shared<ReloadableConfig>(
+      rawEdenConfig, ConfigReloadBehavior::NoReload));
+
+  compactCache->insert(tree4);
+  EXPECT_TRUE(compactCache->contains(tree4->getHash()));
+  auto cached = compactCache->get(tree4->getHash());
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(*tree4, *cached);
+
+  auto stats = compactCache->getStats();
+  EXPECT_EQ(1, stats.objectCount);
+  EXPECT_LT(stats.totalSizeInBytes, tree4->getSizeBytes());
+
+  compactCache->clear();
+  EXPECT_FALSE(compactCache->contains(tree4->getHash()));
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreePrefetcher.h"
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/LocalStoreCachedBackingStore.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/LoggingFetchContext.h"
+#include "eden/fs/testharness/StoredObject.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct TreePrefetcherTest : ::testing::Test {
+  void SetUp() override {
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+    localStore = std::make_shared<MemoryLocalStore>();
+    auto stats = std::make_shared<EdenStats>();
+    fakeBackingStore = std::make_shared<FakeBackingStore>();
+    objectStore = ObjectStore::create(
+        localStore,
+        std::make_shared<LocalStoreCachedBackingStore>(
+            fakeBackingStore, localStore, stats),
+        TreeCache::create(edenConfig),
+        stats,
+        &folly::QueuedImmediateExecutor::instance(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        EdenConfig::createTestEdenConfig());
+  }
+
+  StoredTree* putTree(
+      const std::initializer_list<FakeBackingStore::TreeEntryData>& entries) {
+    auto* tree = fakeBackingStore->putTree(entries);
+    tree->setReady();
+    return tree;
+  }
+
+  StoredTree* putFileTree(folly::StringPiece contents) {
+    return putTree({{"file", fakeBackingStore->putBlob(contents)}});
+  }
+
+  std::shared_ptr<const Tree> load(StoredTree* tree) {
+    return objectStore->getTree(tree->get().getHash(), context).get(0ms);
+  }
+
+  size_t getAccessCount(StoredTree* tree) {
+    return fakeBackingStore->getAccessCount(tree->get().getHash());
+  }
+
+  LoggingFetchContext context;
+  std::shared_ptr<LocalStore> localStore;
+  std::shared_ptr<FakeBackingStore> fakeBackingStore;
+  std::shared_ptr<ObjectStore> objectStore;
+};
+
+} // namespace
+
+TEST_F(TreePrefetcherTest, fetches_trees_changed_on_both_sides) {
+  auto* same = putFileTree("same");
+  auto* fromSub = putFileTree("from sub");
+  auto* toSub = putFileTree("to sub");
+  auto* fromOnly = putFileTree("from only");
+  auto* toOnly = putFileTree("to only");
+  auto* fromDir = putTree({{"same", same}, {"sub", fromSub}});
+  auto* toDir = putTree({{"same", same}, {"sub", toSub}});
+  auto* fromRoot =
+      putTree({{"dir", fromDir}, {"old", fromOnly}, {"same", same}});
+  auto* toRoot = putTree({{"dir", toDir}, {"new", toOnly}, {"same", same}});
+
+  auto fetched = prefetchChangedTrees(
+                     objectStore, load(fromRoot), load(toRoot), context, 4)
+                     .get(0ms);
+  EXPECT_EQ(4, fetched);
+  EXPECT_EQ(1, getAccessCount(fromDir));
+  EXPECT_EQ(1, getAccessCount(toDir));
+  EXPECT_EQ(1, getAccessCount(fromSub));
+  EXPECT_EQ(1, getAccessCount(toSub));
+  EXPECT_EQ(0, getAccessCount(same));
+  EXPECT_EQ(0, getAccessCount(fromOnly));
+  EXPECT_EQ(0, getAccessCount(toOnly));
+}
+
+TEST_F(TreePrefetcherTest, limits_fetches_in_flight) {
+  auto* fromA = fakeBackingStore->putTree({});
+  auto* toA = putFileTree("a");
+  auto* fromB = putFileTree("from b");
+  auto* toB = fakeBackingStore->putTree(
+      {{"file", fakeBackingStore->putBlob("to b")}});
+  auto* fromRoot = putTree({{"a", fromA}, {"b", fromB}});
+  auto* toRoot = putTree({{"a", toA}, {"b", toB}});
+
+  auto future = prefetchChangedTrees(
+      objectStore, load(fromRoot), load(toRoot), context, 1);
+  EXPECT_FALSE(future.isReady());
+  EXPECT_EQ(1, getAccessCount(fromA));
+  EXPECT_EQ(0, getAccessCount(fromB));
+
+  fromA->setReady();
+  EXPECT_FALSE(future.isReady());
+  EXPECT_EQ(1, getAccessCount(toB));
+  toB->setReady();
+  EXPECT_EQ(4, std::move(future).get(0ms));
+}
+
+TEST_F(TreePrefetcherTest, ignores_fetch_errors) {
+  auto* fromA = fakeBackingStore->putTree({});
+  auto* toA = putFileTree("a");
+  auto* fromB = putFileTree("from b");
+  auto* toB = putFileTree("to b");
+  auto* fromRoot = putTree({{"a", fromA}, {"b", fromB}});
+  auto* toRoot = putTree({{"a", toA}, {"b", toB}});
+
+  auto future = prefetchChangedTrees(
+      objectStore, load(fromRoot), load(toRoot), context, 2);
+  fromA->triggerError(std::runtime_error("fetch failed"));
+  EXPECT_EQ(2, std::move(future).get(0ms));
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/WriteCombiner.h"
+
+#include <folly/Synchronized.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+folly::ByteRange key(folly::StringPiece name) {
+  return folly::ByteRange{name};
+}
+
+using Committed = folly::Synchronized<std::map<std::string, std::string>>;
+
+WriteCombiner::CommitFn recordInto(Committed& committed) {
+  return [&committed](const WriteCombiner::Batch& batch) {
+    auto locked = committed.wlock();
+    for (const auto& [k, v] : batch[KeySpace::BlobFamily.index]) {
+      (*locked)[k] = v;
+    }
+  };
+}
+
+} // namespace
+
+TEST(WriteCombiner, writesAreVisibleUntilCommitted) {
+  Committed committed;
+  WriteCombiner combiner{recordInto(committed), 1024 * 1024, 1h};
+  EXPECT_TRUE(combiner.empty());
+
+  combiner.put(KeySpace::BlobFamily, key("a"), "first");
+  combiner.put(KeySpace::BlobFamily, key("a"), "second");
+  EXPECT_FALSE(combiner.empty());
+  EXPECT_EQ("second", combiner.get(KeySpace::BlobFamily, key("a")).value());
+  EXPECT_TRUE(combiner.contains(KeySpace::BlobFamily, key("a")));
+  EXPECT_FALSE(combiner.contains(KeySpace::TreeFamily, key("a")));
+  EXPECT_TRUE(committed.rlock()->empty());
+
+  combiner.flush();
+  EXPECT_TRUE(combiner.empty());
+  EXPECT_EQ(std::nullopt, combiner.get(KeySpace::BlobFamily, key("a")));
+  EXPECT_EQ("second", committed.rlock()->at("a"));
+}
+
+TEST(WriteCombiner, failedCommitKeepsWritesBuffered) {
+  Committed committed;
+  bool fail = true;
+  WriteCombiner combiner{
+      [&](const WriteCombiner::Batch& batch) {
+        if (fail) {
+          throw std::runtime_error("injected");
+        }
+        recordInto(committed)(batch);
+      },
+      1024 * 1024,
+      1h};
+
+  combiner.put(KeySpace::BlobFamily, key("a"), "value");
+  EXPECT_THROW(combiner.flush(), std::runtime_error);
+  EXPECT_EQ("value", combiner.get(KeySpace::BlobFamily, key("a")).value());
+
+  fail = false;
+  combiner.flush();
+  EXPECT_TRUE(combiner.empty());
+  EXPECT_EQ("value", committed.rlock()->at("a"));
+}
+
+TEST(WriteCombiner, fullBatchIsCommittedInTheBackground) {
+  folly::Baton<> baton;
+  WriteCombiner combiner{
+      [&](const WriteCombiner::Batch&) { baton.post(); }, 16, 1h};
+
+  combiner.put(KeySpace::BlobFamily, key("a"), std::string(32, 'x'));
+  EXPECT_TRUE(baton.try_wait_for(10s));
+}
+
+TEST(WriteCombiner, stopCommitsEverything) {
+  Committed committed;
+  {
+    WriteCombiner combiner{recordInto(committed), 1024 * 1024, 1h};
+    combiner.put(KeySpace::BlobFamily, key("a"), "value");
+  }
+  EXPECT_EQ("value", committed.rlock()->at("a"));
+}
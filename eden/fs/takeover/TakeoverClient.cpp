@@ -32,6 +32,29 @@ DEFINE_int32(
 namespace facebook {
 namespace eden {
 
+namespace {
+/**
+ * Deserializes the inode map chunks streamed by the server as they arrive,
+ * until it receives the final takeover message, which is returned.
+ */
+folly::Future<UnixSocket::Message> receiveTakeoverMessage(
+    FutureUnixSocket& socket,
+    UnixSocket::Message&& msg,
+    std::vector<SerializedInodeMapChunk>& inodeMapChunks) {
+  if (!TakeoverData::isInodeMapChunk(&msg.data)) {
+    return folly::makeFuture<UnixSocket::Message>(std::move(msg));
+  }
+  inodeMapChunks.push_back(TakeoverData::deserializeInodeMapChunk(&msg.data));
+
+  auto timeout = std::chrono::seconds(FLAGS_takeoverReceiveTimeout);
+  return socket.receive(timeout).thenValue(
+      [&socket, &inodeMapChunks](UnixSocket::Message&& next) {
+        return receiveTakeoverMessage(
+            socket, std::move(next), inodeMapChunks);
+      });
+}
+} // namespace
+
 TakeoverData takeoverMounts(
     AbsolutePathPiece socketPath,
     bool shouldPing,
@@ -39,6 +62,7 @@ TakeoverData takeoverMounts(
   folly::EventBase evb;
   folly::Expected<UnixSocket::Message, folly::exception_wrapper>
       expectedMessage;
+  std::vector<SerializedInodeMapChunk> inodeMapChunks;
 
   auto connectTimeout = std::chrono::seconds(1);
   FutureUnixSocket socket;
@@ -82,6 +106,9 @@ TakeoverData takeoverMounts(
           return folly::makeFuture<UnixSocket::Message>(std::move(msg));
         }
       })
+      .thenValue([&socket, &inodeMapChunks](UnixSocket::Message&& msg) {
+        return receiveTakeoverMessage(socket, std::move(msg), inodeMapChunks);
+      })
       .thenValue([&expectedMessage](UnixSocket::Message&& msg) {
         expectedMessage = std::move(msg);
       })
@@ -101,7 +128,7 @@ TakeoverData takeoverMounts(
     XLOG(DBG7) << "received fd for takeover: " << file.fd();
   }
 
-  return TakeoverData::deserialize(message);
+  return TakeoverData::deserialize(message, std::move(inodeMapChunks));
 }
 } // namespace eden
 } // namespace facebook
@@ -9,11 +9,13 @@
 
 #include "eden/fs/takeover/TakeoverData.h"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <variant>
 
 #include <folly/Format.h>
+#include <folly/Utility.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
@@ -48,13 +50,33 @@ TakeoverMountProtocol getMountProtocol(
       mountInfo.mountPath));
 }
 
+std::vector<std::string> serializeObjectIds(const std::vector<ObjectId>& ids) {
+  std::vector<std::string> serialized;
+  serialized.reserve(ids.size());
+  for (const auto& id : ids) {
+    serialized.emplace_back(folly::StringPiece{id.getBytes()});
+  }
+  return serialized;
+}
+
+std::vector<ObjectId> deserializeObjectIds(
+    const std::vector<std::string>& serialized) {
+  std::vector<ObjectId> ids;
+  ids.reserve(serialized.size());
+  for (const auto& bytes : serialized) {
+    ids.emplace_back(folly::ByteRange{folly::StringPiece{bytes}});
+  }
+  return ids;
+}
+
 } // namespace
 
 const std::set<int32_t> kSupportedTakeoverVersions{
     TakeoverData::kTakeoverProtocolVersionThree,
     TakeoverData::kTakeoverProtocolVersionFour,
     TakeoverData::kTakeoverProtocolVersionFive,
-    TakeoverData::kTakeoverProtocolVersionSix};
+    TakeoverData::kTakeoverProtocolVersionSix,
+    TakeoverData::kTakeoverProtocolVersionSeven};
 
 std::optional<int32_t> TakeoverData::computeCompatibleVersion(
     const std::set<int32_t>& versions,
@@ -103,6 +125,15 @@ uint64_t TakeoverData::versionToCapabilites(int32_t version) {
           TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
           TakeoverCapabilities::ORDERED_FDS |
           TakeoverCapabilities::OPTIONAL_MOUNTD;
+    case kTakeoverProtocolVersionSeven:
+      return TakeoverCapabilities::FUSE | TakeoverCapabilities::MOUNT_TYPES |
+          TakeoverCapabilities::PING |
+          TakeoverCapabilities::THRIFT_SERIALIZATION |
+          TakeoverCapabilities::NFS |
+          TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
+          TakeoverCapabilities::ORDERED_FDS |
+          TakeoverCapabilities::OPTIONAL_MOUNTD |
+          TakeoverCapabilities::CHUNKED_INODE_MAPS;
   }
   throw std::runtime_error(fmt::format("Unsupported version: {}", version));
 }
@@ -144,6 +175,17 @@ int32_t TakeoverData::capabilitesToVersion(uint64_t capabilities) {
     return kTakeoverProtocolVersionSix;
   }
 
+  if (capabilities ==
+      (TakeoverCapabilities::FUSE | TakeoverCapabilities::MOUNT_TYPES |
+       TakeoverCapabilities::PING | TakeoverCapabilities::THRIFT_SERIALIZATION |
+       TakeoverCapabilities::NFS |
+       TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
+       TakeoverCapabilities::ORDERED_FDS |
+       TakeoverCapabilities::OPTIONAL_MOUNTD |
+       TakeoverCapabilities::CHUNKED_INODE_MAPS)) {
+    return kTakeoverProtocolVersionSeven;
+  }
+
   throw std::runtime_error(
       fmt::format("Unsupported combination of capabilities: {}", capabilities));
 }
@@ -254,6 +296,59 @@ IOBuf TakeoverData::serialize(uint64_t protocolCapabilities) {
   return serializeThrift(protocolCapabilities);
 }
 
+size_t TakeoverData::countInodeMapChunks() const {
+  size_t count = 0;
+  for (const auto& mount : mountPoints) {
+    auto entries = mount.inodeMap.unloadedInodes_ref()->size();
+    count += (entries + kInodeMapChunkSize - 1) / kInodeMapChunkSize;
+  }
+  return count;
+}
+
+std::vector<folly::SemiFuture<IOBuf>> TakeoverData::serializeInodeMapChunks(
+    folly::Executor::KeepAlive<> executor) const {
+  std::vector<folly::SemiFuture<IOBuf>> chunks;
+  chunks.reserve(countInodeMapChunks());
+  for (size_t mountIndex = 0; mountIndex < mountPoints.size(); ++mountIndex) {
+    const auto& entries =
+        *mountPoints[mountIndex].inodeMap.unloadedInodes_ref();
+    for (size_t begin = 0; begin < entries.size();
+         begin += kInodeMapChunkSize) {
+      auto end = std::min(begin + kInodeMapChunkSize, entries.size());
+      chunks.push_back(
+          folly::via(executor, [&entries, mountIndex, begin, end] {
+            // The entries are copied rather than moved out, as this
+            // TakeoverData is used to recover if the takeover fails.
+            SerializedInodeMapChunk chunk;
+            chunk.mountIndex_ref() = folly::to_narrow(mountIndex);
+            chunk.inodeMap_ref()->unloadedInodes_ref() =
+                std::vector<SerializedInodeMapEntry>{
+                    entries.begin() + begin, entries.begin() + end};
+
+            folly::IOBufQueue bufQ;
+            folly::io::QueueAppender app(&bufQ, 0);
+            app.writeBE<uint32_t>(MessageType::INODE_MAP_CHUNK);
+            CompactSerializer::serialize(chunk, &bufQ);
+            return std::move(*bufQ.move());
+          }).semi());
+    }
+  }
+  return chunks;
+}
+
+bool TakeoverData::isInodeMapChunk(const IOBuf* buf) {
+  if (buf->length() < kHeaderLength) {
+    return false;
+  }
+  folly::io::Cursor cursor(buf);
+  return cursor.readBE<uint32_t>() == MessageType::INODE_MAP_CHUNK;
+}
+
+SerializedInodeMapChunk TakeoverData::deserializeInodeMapChunk(IOBuf* buf) {
+  buf->trimStart(kHeaderLength);
+  return CompactSerializer::deserialize<SerializedInodeMapChunk>(buf);
+}
+
 folly::IOBuf TakeoverData::serializeError(
     uint64_t protocolCapabilities,
     const folly::exception_wrapper& ew) {
@@ -287,11 +382,14 @@ folly::IOBuf TakeoverData::serializePing() {
   return buf;
 }
 
-TakeoverData TakeoverData::deserialize(UnixSocket::Message& msg) {
+TakeoverData TakeoverData::deserialize(
+    UnixSocket::Message& msg,
+    std::vector<SerializedInodeMapChunk> inodeMapChunks) {
   auto protocolVersion = TakeoverData::getProtocolVersion(&msg.data);
   auto capabilities = TakeoverData::versionToCapabilites(protocolVersion);
 
-  auto data = TakeoverData::deserialize(capabilities, &msg.data);
+  auto data =
+      TakeoverData::deserialize(capabilities, &msg.data, inodeMapChunks);
   // when we serialize the mountd socket we have three general files instead
   // of two
   const auto mountPointFilesOffset =
@@ -348,6 +446,7 @@ int32_t TakeoverData::getProtocolVersion(IOBuf* buf) {
     case kTakeoverProtocolVersionFour:
     case kTakeoverProtocolVersionFive:
     case kTakeoverProtocolVersionSix:
+    case kTakeoverProtocolVersionSeven:
       // Version 3 (there was no 2 because of how Version 1 used word values
       // 1 and 2) doesn't care about this version byte, so we skip past it
       // and let the underlying code decode the data
@@ -362,7 +461,8 @@ int32_t TakeoverData::getProtocolVersion(IOBuf* buf) {
 
 TakeoverData TakeoverData::deserialize(
     uint64_t protocolCapabilities,
-    IOBuf* buf) {
+    IOBuf* buf,
+    std::vector<SerializedInodeMapChunk>& inodeMapChunks) {
   XCHECK(
       protocolCapabilities & TakeoverCapabilities::THRIFT_SERIALIZATION ||
       protocolCapabilities == 0)
@@ -371,7 +471,7 @@ TakeoverData TakeoverData::deserialize(
              "Cababilities: {}",
              protocolCapabilities);
 
-  return deserializeThrift(protocolCapabilities, buf);
+  return deserializeThrift(protocolCapabilities, buf, inodeMapChunks);
 }
 
 bool canSerDeMountType(
@@ -451,7 +551,9 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
           sizeof(fuseChannelInfo->connInfo)};
     }
 
-    *serializedMount.inodeMap_ref() = mount.inodeMap;
+    if (!(protocolCapabilities & TakeoverCapabilities::CHUNKED_INODE_MAPS)) {
+      *serializedMount.inodeMap_ref() = mount.inodeMap;
+    }
 
     serializedMount.mountProtocol_ref() = mountProtocol;
 
@@ -467,6 +569,11 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
     if (protocolCapabilities & TakeoverCapabilities::ORDERED_FDS) {
       serialized.fileDescriptors_ref() = generalFDOrder;
     }
+    if (protocolCapabilities & TakeoverCapabilities::CHUNKED_INODE_MAPS) {
+      serialized.inodeMapChunkCount_ref() = countInodeMapChunks();
+    }
+    serialized.recentBlobIds_ref() = serializeObjectIds(recentBlobIds);
+    serialized.recentTreeIds_ref() = serializeObjectIds(recentTreeIds);
     SerializedTakeoverResult result;
     result.takeoverData_ref() = serialized;
 
@@ -515,7 +622,8 @@ folly::IOBuf TakeoverData::serializeErrorThrift(
 
 TakeoverData TakeoverData::deserializeThrift(
     uint32_t protocolCapabilities,
-    IOBuf* buf) {
+    IOBuf* buf,
+    std::vector<SerializedInodeMapChunk>& inodeMapChunks) {
   if (protocolCapabilities & TakeoverCapabilities::RESULT_TYPE_SERIALIZATION) {
     auto serialized =
         CompactSerializer::deserialize<SerializedTakeoverResult>(buf);
@@ -531,6 +639,36 @@ TakeoverData TakeoverData::deserializeThrift(
           takeoverData.generalFDOrder =
               *(serialized.takeoverData_ref()->fileDescriptors_ref());
         }
+        takeoverData.recentBlobIds = deserializeObjectIds(
+            *serialized.takeoverData_ref()->recentBlobIds_ref());
+        takeoverData.recentTreeIds = deserializeObjectIds(
+            *serialized.takeoverData_ref()->recentTreeIds_ref());
+        if (protocolCapabilities & TakeoverCapabilities::CHUNKED_INODE_MAPS) {
+          auto expectedChunks =
+              *serialized.takeoverData_ref()->inodeMapChunkCount_ref();
+          if (folly::to_unsigned(expectedChunks) != inodeMapChunks.size()) {
+            throw std::runtime_error(fmt::format(
+                "received {} inode map chunks, but expected {}",
+                inodeMapChunks.size(),
+                expectedChunks));
+          }
+          for (auto& chunk : inodeMapChunks) {
+            auto mountIndex = folly::to_unsigned(*chunk.mountIndex_ref());
+            if (mountIndex >= takeoverData.mountPoints.size()) {
+              throw std::runtime_error(fmt::format(
+                  "received an inode map chunk for mount {} out of {}",
+                  mountIndex,
+                  takeoverData.mountPoints.size()));
+            }
+            auto& entries = *takeoverData.mountPoints[mountIndex]
+                                 .inodeMap.unloadedInodes_ref();
+            auto& chunkEntries = *chunk.inodeMap_ref()->unloadedInodes_ref();
+            entries.insert(
+                entries.end(),
+                std::make_move_iterator(chunkEntries.begin()),
+                std::make_move_iterator(chunkEntries.end()));
+          }
+        }
         return takeoverData;
       }
       case SerializedTakeoverResult::Type::__EMPTY__:
@@ -11,9 +11,12 @@
 #include <optional>
 #include <vector>
 
+#include <folly/Executor.h>
 #include <folly/File.h>
+#include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/takeover/gen-cpp2/takeover_types.h"
 #include "eden/fs/utils/FsChannelTypes.h"
 #include "eden/fs/utils/FutureUnixSocket.h"
@@ -97,6 +100,12 @@ class TakeoverCapabilities {
     // does the mountd socket need to be sent.
     // Note this capability can not be used with out ORDERED_FDS.
     OPTIONAL_MOUNTD = 1 << 8,
+
+    // Indicates that the inode maps are serialized in parallel and streamed
+    // in separate SerializedInodeMapChunk messages ahead of the takeover
+    // message, rather than being part of it.
+    // Note this capability can not be used with out RESULT_TYPE_SERIALIZATION.
+    CHUNKED_INODE_MAPS = 1 << 9,
   };
 };
 
@@ -153,9 +162,12 @@ class TakeoverData {
 
     // This version introduced a more generic thrift struct for serialization
     // and allows us to only pass some of the file descriptors.
-    kTakeoverProtocolVersionSix = 6
-    // version 6 should be the last real version, we should bump to version 7
-    // and from then on only match capabilities
+    kTakeoverProtocolVersionSix = 6,
+
+    // This version streams the inode maps in chunks ahead of the takeover
+    // message. Until capability matching is implemented, new capabilities
+    // still need a new version.
+    kTakeoverProtocolVersionSeven = 7,
   };
 
   /**
@@ -245,6 +257,18 @@ class TakeoverData {
    */
   void serialize(uint64_t protocolCapabilities, UnixSocket::Message& msg);
 
+  /**
+   * With the CHUNKED_INODE_MAPS capability, serialize() leaves the inode maps
+   * out of the message, and they are sent ahead of it in chunks of at most
+   * kInodeMapChunkSize entries.
+   *
+   * This starts serializing all the chunks on the executor, so that the mounts
+   * are serialized in parallel, and returns them in the order they must be
+   * sent. This TakeoverData must outlive the returned futures.
+   */
+  std::vector<folly::SemiFuture<folly::IOBuf>> serializeInodeMapChunks(
+      folly::Executor::KeepAlive<> executor) const;
+
   /**
    * Serialize an exception.
    */
@@ -267,15 +291,29 @@ class TakeoverData {
   static int32_t getProtocolVersion(folly::IOBuf* buf);
 
   /**
-   * Deserialize the TakeoverData from a UnixSocket msg.
+   * Deserialize the TakeoverData from a UnixSocket msg, and the inode map
+   * chunks received ahead of it.
    */
-  static TakeoverData deserialize(UnixSocket::Message& msg);
+  static TakeoverData deserialize(
+      UnixSocket::Message& msg,
+      std::vector<SerializedInodeMapChunk> inodeMapChunks = {});
 
   /**
    * Checks to see if a message is of type PING
    */
   static bool isPing(const folly::IOBuf* buf);
 
+  /**
+   * Checks to see if a message is one of the chunks produced by
+   * serializeInodeMapChunks().
+   */
+  static bool isInodeMapChunk(const folly::IOBuf* buf);
+
+  /**
+   * Deserialize a message for which isInodeMapChunk() is true.
+   */
+  static SerializedInodeMapChunk deserializeInodeMapChunk(folly::IOBuf* buf);
+
   /**
    * Determines if we should serialized NFS data given the protocol version
    * we are serializing with. i.e. should we send takeover data for NFS mount
@@ -310,6 +348,14 @@ class TakeoverData {
    */
   std::vector<MountInfo> mountPoints;
 
+  /**
+   * Ids of the blobs and trees in the in-memory caches, most recently used
+   * first. Only sent with the RESULT_TYPE_SERIALIZATION capability; older
+   * clients ignore them.
+   */
+  std::vector<ObjectId> recentBlobIds;
+  std::vector<ObjectId> recentTreeIds;
+
   /**
    * The takeoverComplete promise will be fulfilled by the TakeoverServer code
    * once the TakeoverData has been sent to the remote process.
@@ -352,7 +398,8 @@ class TakeoverData {
    */
   static TakeoverData deserialize(
       uint64_t protocolCapabilities,
-      folly::IOBuf* buf);
+      folly::IOBuf* buf,
+      std::vector<SerializedInodeMapChunk>& inodeMapChunks);
 
   /**
    * Deserialize the TakeoverData from a buffer for any version of the protocol
@@ -360,7 +407,8 @@ class TakeoverData {
    */
   static TakeoverData deserializeThrift(
       uint32_t protocolCapabilities,
-      folly::IOBuf* buf);
+      folly::IOBuf* buf,
+      std::vector<SerializedInodeMapChunk>& inodeMapChunks);
 
   /**
    * Deserialize the file descriptor for file `type` from the
@@ -389,6 +437,11 @@ class TakeoverData {
   std::vector<FileDescriptorType> generateGeneralFdOrder(
       uint32_t protocolCapabilities);
 
+  /**
+   * Number of chunks serializeInodeMapChunks() splits the inode maps into.
+   */
+  size_t countInodeMapChunks() const;
+
   /**
    * Message type values.
    * If we ever need to include more information in the takeover data in the
@@ -399,8 +452,16 @@ class TakeoverData {
     ERROR = 1,
     MOUNTS = 2,
     PING = 3,
+    // Chosen out of the range of the protocol versions, which also start
+    // messages.
+    INODE_MAP_CHUNK = 0x696d6170, // "imap"
   };
 
+  /**
+   * Maximum number of inode map entries per SerializedInodeMapChunk.
+   */
+  static constexpr size_t kInodeMapChunkSize = 1 << 16;
+
   /**
    * The length of the serialized header.
    * This is just a 4-byte message type field.
@@ -14,6 +14,7 @@
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/SocketAddress.h>
+#include <folly/executors/GlobalExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
@@ -74,6 +75,9 @@ class TakeoverServer::ConnHandler {
   FOLLY_NODISCARD folly::Future<folly::Unit> sendTakeoverData(
       TakeoverData&& data);
 
+  FOLLY_NODISCARD folly::Future<folly::Unit> sendTakeoverMessage(
+      TakeoverData&& data);
+
   template <typename... Args>
   [[noreturn]] void fail(Args&&... args) {
     auto msg = folly::to<std::string>(std::forward<Args>(args)...);
@@ -239,11 +243,52 @@ Future<Unit> TakeoverServer::ConnHandler::pingThenSendTakeoverData(
 
 Future<Unit> TakeoverServer::ConnHandler::sendTakeoverData(
     TakeoverData&& data) {
-  // Before sending the takeover data, we must close the server's
-  // local and backing store. This is important for ensuring the RocksDB
-  // lock is released so the client can take over.
+  if (!(protocolCapabilities_ & TakeoverCapabilities::CHUNKED_INODE_MAPS)) {
+    // Before sending the takeover data, we must close the server's
+    // local and backing store. This is important for ensuring the RocksDB
+    // lock is released so the client can take over.
+    server_->getTakeoverHandler()->closeStorage();
+    return sendTakeoverMessage(std::move(data));
+  }
+
+  // Serialize the inode maps of all the mounts in parallel while the storage
+  // is being closed, and stream the chunks in order as they become ready, so
+  // the client deserializes them while the next ones are being sent.
+  auto sharedData = std::make_shared<TakeoverData>(std::move(data));
+  auto chunks =
+      sharedData->serializeInodeMapChunks(folly::getGlobalCPUExecutor());
   server_->getTakeoverHandler()->closeStorage();
 
+  XLOG(INFO) << "Sending " << chunks.size()
+             << " inode map chunks to new process";
+  auto sent = makeFuture();
+  for (auto& chunk : chunks) {
+    sent = std::move(sent).thenValue(
+        [this, chunk = std::move(chunk)](auto&&) mutable {
+          return std::move(chunk)
+              .via(server_->eventBase_)
+              .thenValue([this](folly::IOBuf&& buf) {
+                return socket_.send(std::move(buf));
+              });
+        });
+  }
+
+  // The file descriptors are only sent with the final message, so if the
+  // chunks could not be sent this process can still recover its mounts.
+  return std::move(sent)
+      .via(server_->eventBase_)
+      .thenTry([this, sharedData](folly::Try<Unit>&& result) {
+        if (result.hasException()) {
+          auto takeoverPromise = std::move(sharedData->takeoverComplete);
+          takeoverPromise.setValue(std::move(*sharedData));
+          return makeFuture<Unit>(result.exception());
+        }
+        return sendTakeoverMessage(std::move(*sharedData));
+      });
+}
+
+Future<Unit> TakeoverServer::ConnHandler::sendTakeoverMessage(
+    TakeoverData&& data) {
   UnixSocket::Message msg;
   try {
     data.serialize(protocolCapabilities_, msg);
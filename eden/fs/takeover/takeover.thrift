@@ -83,6 +83,22 @@ enum FileDescriptorType {
 struct SerializedTakeoverInfo {
   1: list<SerializedMountInfo> mounts;
   2: list<FileDescriptorType> fileDescriptors;
+  // Number of SerializedInodeMapChunk messages sent ahead of this one, when
+  // the inode maps are chunked. The inodeMap of each mount is then empty.
+  3: i64 inodeMapChunkCount;
+  // Ids of the objects in the in-memory caches of the old process, most
+  // recently used first, so the new process can reload them.
+  4: list<binary> recentBlobIds;
+  5: list<binary> recentTreeIds;
+}
+
+// Part of the inode map of a mount. Large inode maps are split into chunks
+// that are serialized in parallel and streamed to the client ahead of the
+// SerializedTakeoverResult, so it can deserialize them as they arrive.
+struct SerializedInodeMapChunk {
+  // Index of the mount in SerializedTakeoverInfo.mounts.
+  1: i32 mountIndex;
+  2: SerializedInodeMap inodeMap;
 }
 
 // This is the highlevel structure we use to send takeover data between the
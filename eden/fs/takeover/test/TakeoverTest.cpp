@@ -232,6 +232,14 @@ TEST(Takeover, simple) {
           fuse_init_out{}},
       SerializedInodeMap{});
 
+  const std::vector<ObjectId> recentBlobIds{
+      ObjectId::fromHex("0000000000000000000000000000000000000001"),
+      ObjectId::fromHex("0000000000000000000000000000000000000002")};
+  const std::vector<ObjectId> recentTreeIds{
+      ObjectId::fromHex("0000000000000000000000000000000000000003")};
+  serverData.recentBlobIds = recentBlobIds;
+  serverData.recentTreeIds = recentTreeIds;
+
   // Perform the takeover
   auto serverSendFuture = serverData.takeoverComplete.getFuture();
   TestHandler handler{std::move(serverData)};
@@ -246,6 +254,10 @@ TEST(Takeover, simple) {
   checkExpectedFile(clientData.thriftSocket.fd(), thriftSocketPath);
   checkExpectedFile(clientData.mountdServerSocket->fd(), mountdSocketPath);
 
+  // The ids of the cached objects are handed over in order.
+  EXPECT_EQ(recentBlobIds, clientData.recentBlobIds);
+  EXPECT_EQ(recentTreeIds, clientData.recentTreeIds);
+
   // Make sure the received mount information is correct
   ASSERT_EQ(2, clientData.mountPoints.size());
   EXPECT_EQ(mount1Path, clientData.mountPoints.at(0).mountPath);
@@ -386,6 +398,76 @@ TEST(Takeover, manyMounts) {
   }
 }
 
+namespace {
+SerializedInodeMap makeInodeMap(size_t numEntries, int64_t firstInode) {
+  SerializedInodeMap inodeMap;
+  for (size_t n = 0; n < numEntries; ++n) {
+    SerializedInodeMapEntry entry;
+    entry.inodeNumber_ref() = firstInode + n;
+    entry.parentInode_ref() = 1;
+    entry.name_ref() = folly::to<string>("file", n);
+    entry.mode_ref() = 0644;
+    inodeMap.unloadedInodes_ref()->push_back(std::move(entry));
+  }
+  return inodeMap;
+}
+
+void runInodeMapTakeover(int32_t version) {
+  TemporaryDirectory tmpDir("eden_takeover_test");
+  AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+  TakeoverData serverData;
+  auto lockFilePath = tmpDirPath + "lock"_pc;
+  serverData.lockFile =
+      folly::File{lockFilePath.stringPiece(), O_RDWR | O_CREAT};
+  auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+  serverData.thriftSocket =
+      folly::File{thriftSocketPath.stringPiece(), O_RDWR | O_CREAT};
+  auto mountdSocketPath = tmpDirPath + "mountd"_pc;
+  serverData.mountdServerSocket =
+      folly::File{mountdSocketPath.stringPiece(), O_RDWR | O_CREAT};
+
+  // The first inode map spans several chunks, the second one is empty and the
+  // third one fits in a single chunk.
+  const std::vector<size_t> numEntries = {150000, 0, 10};
+  for (size_t n = 0; n < numEntries.size(); ++n) {
+    auto fusePath =
+        tmpDirPath + PathComponentPiece{folly::to<string>("fuse", n)};
+    serverData.mountPoints.emplace_back(
+        tmpDirPath + PathComponentPiece{folly::to<string>("mount", n)},
+        tmpDirPath + PathComponentPiece{folly::to<string>("client", n)},
+        std::vector<AbsolutePath>{},
+        FuseChannelData{
+            folly::File{fusePath.stringPiece(), O_RDWR | O_CREAT},
+            fuse_init_out{}},
+        makeInodeMap(numEntries[n], 1000 * n + 2));
+  }
+
+  auto serverSendFuture = serverData.takeoverComplete.getFuture();
+  TestHandler handler{std::move(serverData)};
+  auto result = runTakeover(
+      tmpDir, &handler, std::set<int32_t>{version}, std::set<int32_t>{version});
+  ASSERT_TRUE(serverSendFuture.hasValue());
+  ASSERT_TRUE(result.hasValue());
+  const auto& clientData = result.value();
+
+  ASSERT_EQ(numEntries.size(), clientData.mountPoints.size());
+  for (size_t n = 0; n < numEntries.size(); ++n) {
+    EXPECT_EQ(
+        makeInodeMap(numEntries[n], 1000 * n + 2),
+        clientData.mountPoints[n].inodeMap);
+  }
+}
+} // namespace
+
+TEST(Takeover, inodeMaps) {
+  runInodeMapTakeover(TakeoverData::kTakeoverProtocolVersionSix);
+}
+
+TEST(Takeover, chunkedInodeMaps) {
+  runInodeMapTakeover(TakeoverData::kTakeoverProtocolVersionSeven);
+}
+
 TEST(Takeover, error) {
   TemporaryDirectory tmpDir("eden_takeover_test");
   ErrorHandler handler;
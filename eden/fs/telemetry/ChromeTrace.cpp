@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/ChromeTrace.h"
+
+#include <folly/json.h>
+#include <algorithm>
+#include <numeric>
+
+namespace facebook::eden {
+
+ChromeTrace::SliceId ChromeTrace::addSlice(
+    const std::string& track,
+    std::string name,
+    TimePoint start,
+    TimePoint end,
+    folly::dynamic args) {
+  auto it = std::find(tracks_.begin(), tracks_.end(), track);
+  auto trackIndex = static_cast<size_t>(it - tracks_.begin());
+  if (it == tracks_.end()) {
+    tracks_.push_back(track);
+  }
+  slices_.push_back(Slice{
+      trackIndex,
+      std::move(name),
+      start,
+      std::max(start, end),
+      std::move(args)});
+  return slices_.size() - 1;
+}
+
+void ChromeTrace::addFlow(SliceId from, SliceId to) {
+  flows_.emplace_back(from, to);
+}
+
+std::string ChromeTrace::toJson() const {
+  TimePoint origin = TimePoint::max();
+  for (const auto& slice : slices_) {
+    origin = std::min(origin, slice.start);
+  }
+  auto timestamp = [&](TimePoint time) {
+    return std::chrono::duration<double, std::micro>{time - origin}.count();
+  };
+
+  // Lay out the slices of every track on threads, in start order, reusing the
+  // first thread whose last slice already ended.
+  std::vector<SliceId> order(slices_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](SliceId a, SliceId b) {
+    return slices_[a].start < slices_[b].start;
+  });
+  std::vector<std::vector<TimePoint>> threadEnds(tracks_.size());
+  std::vector<size_t> threads(slices_.size());
+  for (auto id : order) {
+    const auto& slice = slices_[id];
+    auto& ends = threadEnds[slice.track];
+    auto free = std::find_if(ends.begin(), ends.end(), [&](TimePoint end) {
+      return end <= slice.start;
+    });
+    if (free == ends.end()) {
+      free = ends.insert(ends.end(), slice.end);
+    } else {
+      *free = slice.end;
+    }
+    threads[id] = static_cast<size_t>(free - ends.begin());
+  }
+
+  auto makeEvent = [](const char* phase, size_t track, size_t thread) {
+    return folly::dynamic::object("ph", phase)("pid", track + 1)(
+        "tid", thread + 1);
+  };
+
+  auto events = folly::dynamic::array();
+  for (size_t track = 0; track < tracks_.size(); ++track) {
+    auto process = makeEvent("M", track, 0);
+    process["name"] = "process_name";
+    process["args"] = folly::dynamic::object("name", tracks_[track]);
+    events.push_back(std::move(process));
+    for (size_t thread = 0; thread < threadEnds[track].size(); ++thread) {
+      auto event = makeEvent("M", track, thread);
+      event["name"] = "thread_name";
+      event["args"] = folly::dynamic::object(
+          "name", tracks_[track] + " " + std::to_string(thread + 1));
+      events.push_back(std::move(event));
+    }
+  }
+
+  for (SliceId id = 0; id < slices_.size(); ++id) {
+    const auto& slice = slices_[id];
+    auto event = makeEvent("X", slice.track, threads[id]);
+    event["name"] = slice.name;
+    event["cat"] = tracks_[slice.track];
+    event["ts"] = timestamp(slice.start);
+    event["dur"] = timestamp(slice.end) - timestamp(slice.start);
+    event["args"] = slice.args;
+    events.push_back(std::move(event));
+  }
+
+  // A flow starts inside the slice it comes from, at the latest when that
+  // slice ends, and binds to the slice enclosing its end point.
+  for (size_t flow = 0; flow < flows_.size(); ++flow) {
+    auto [fromId, toId] = flows_[flow];
+    const auto& from = slices_[fromId];
+    const auto& to = slices_[toId];
+
+    auto start = makeEvent("s", from.track, threads[fromId]);
+    start["ts"] = timestamp(std::clamp(to.start, from.start, from.end));
+
+    auto finish = makeEvent("f", to.track, threads[toId]);
+    finish["ts"] = timestamp(to.start);
+    finish["bp"] = "e";
+
+    for (auto* event : {&start, &finish}) {
+      (*event)["name"] = "cause";
+      (*event)["cat"] = "flow";
+      (*event)["id"] = flow + 1;
+      events.push_back(std::move(*event));
+    }
+  }
+
+  auto trace = folly::dynamic::object("traceEvents", std::move(events))(
+      "displayTimeUnit", "ms");
+  return folly::toJson(trace);
+}
+
+} // namespace facebook::eden
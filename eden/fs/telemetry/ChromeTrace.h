@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/dynamic.h>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Builds a trace in the Chrome trace-event JSON format, which Perfetto and
+ * chrome://tracing load directly.
+ *
+ * Each track is rendered as a process. Slices of a track may overlap, so they
+ * are spread over as many threads of that process as needed for the slices of
+ * every thread to never overlap. Flows draw an arrow from one slice to
+ * another, e.g. from a FUSE request to the import it caused.
+ *
+ * ChromeTrace is not synchronized.
+ */
+class ChromeTrace {
+ public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+  using SliceId = size_t;
+
+  SliceId addSlice(
+      const std::string& track,
+      std::string name,
+      TimePoint start,
+      TimePoint end,
+      folly::dynamic args = folly::dynamic::object());
+
+  void addFlow(SliceId from, SliceId to);
+
+  size_t sliceCount() const {
+    return slices_.size();
+  }
+
+  /**
+   * Timestamps are in microseconds from the start of the earliest slice.
+   */
+  std::string toJson() const;
+
+ private:
+  struct Slice {
+    size_t track;
+    std::string name;
+    TimePoint start;
+    TimePoint end;
+    folly::dynamic args;
+  };
+
+  std::vector<std::string> tracks_;
+  std::vector<Slice> slices_;
+  std::vector<std::pair<SliceId, SliceId>> flows_;
+};
+
+} // namespace facebook::eden
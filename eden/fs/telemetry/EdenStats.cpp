@@ -33,6 +33,73 @@ JournalThreadStats& EdenStats::getJournalStatsForCurrentThread() {
   return *threadLocalJournalStats_.get();
 }
 
+ThriftThreadStats& EdenStats::getThriftStatsForCurrentThread() {
+  return *threadLocalThriftStats_.get();
+}
+
+void EdenStats::recordChannelLatency(
+    folly::StringPiece operation,
+    std::chrono::microseconds elapsed) {
+  auto& local = *threadLocalChannelLatencies_;
+  auto it = local.deltas.find(operation);
+  if (it == local.deltas.end()) {
+    it = local.deltas
+             .emplace(
+                 operation.str(),
+                 ChannelLatencyDeltas::Delta{
+                     LatencyHistogram{}, &getSharedChannelLatency(operation)})
+             .first;
+  }
+  it->second.histogram.record(elapsed);
+
+  auto now = std::chrono::steady_clock::now();
+  if (now >= local.nextPublish) {
+    local.publish();
+    local.nextPublish = now + kChannelLatencyPublishInterval;
+  }
+  backgroundRequestLimit_.recordLatency(elapsed, now);
+}
+
+SharedLatencyHistogram& EdenStats::getSharedChannelLatency(
+    folly::StringPiece operation) {
+  {
+    auto shared = sharedChannelLatencies_.rlock();
+    auto it = shared->find(operation);
+    if (it != shared->end()) {
+      return *it->second;
+    }
+  }
+  auto shared = sharedChannelLatencies_.wlock();
+  auto& histogram = (*shared)[operation.str()];
+  if (!histogram) {
+    histogram = std::make_unique<SharedLatencyHistogram>();
+  }
+  return *histogram;
+}
+
+EdenStats::ChannelLatencyDeltas::~ChannelLatencyDeltas() {
+  publish();
+}
+
+void EdenStats::ChannelLatencyDeltas::publish() {
+  for (auto& [operation, delta] : deltas) {
+    if (delta.histogram.count() != 0) {
+      delta.shared->add(delta.histogram);
+      delta.histogram = LatencyHistogram{};
+    }
+  }
+}
+
+std::map<std::string, LatencyHistogram>
+EdenStats::getChannelLatencyHistograms() {
+  std::map<std::string, LatencyHistogram> result;
+  auto shared = sharedChannelLatencies_.rlock();
+  for (const auto& [operation, histogram] : *shared) {
+    result.emplace(operation, histogram->snapshot());
+  }
+  return result;
+}
+
 void EdenStats::flush() {
   // This method is only really useful while testing to ensure that the service
   // data singleton instance has the latest stats. Since all our stats are now
@@ -7,12 +7,22 @@
 
 #pragma once
 
+#include <chrono>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 
 #include <fb303/detail/QuantileStatWrappers.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
+#include <folly/container/F14Map.h>
 
 #include "eden/fs/eden-config.h"
+#include "eden/fs/telemetry/LatencyHistogram.h"
+#include "eden/fs/telemetry/SlowRequestLog.h"
+#include "eden/fs/utils/AdaptiveConcurrencyLimit.h"
 
 namespace facebook {
 namespace eden {
@@ -22,9 +32,16 @@ class ObjectStoreThreadStats;
 class HgBackingStoreThreadStats;
 class HgImporterThreadStats;
 class JournalThreadStats;
+class ThriftThreadStats;
 
 class EdenStats {
  public:
+  /**
+   * How often each thread adds the channel latencies it recorded to the
+   * histograms returned by getChannelLatencyHistograms().
+   */
+  static constexpr std::chrono::seconds kChannelLatencyPublishInterval{1};
+
   /**
    * This function can be called on any thread.
    *
@@ -60,6 +77,54 @@ class EdenStats {
    */
   JournalThreadStats& getJournalStatsForCurrentThread();
 
+  /**
+   * This function can be called on any thread.
+   *
+   * The returned object can be used only on the current thread.
+   */
+  ThriftThreadStats& getThriftStatsForCurrentThread();
+
+  /**
+   * Record the latency of a FUSE, NFS or ProjectedFS request in the
+   * histogram of its operation, and in the background request limit.
+   *
+   * This function can be called on any thread.
+   */
+  void recordChannelLatency(
+      folly::StringPiece operation,
+      std::chrono::microseconds elapsed);
+
+  /**
+   * Returns the latency histogram of every operation recorded with
+   * recordChannelLatency(), merged across all threads.
+   *
+   * Threads publish their latencies about once per
+   * kChannelLatencyPublishInterval, so the latest ones may be missing. The
+   * cost of this function depends on the number of operations, not threads.
+   *
+   * This function can be called on any thread.
+   */
+  std::map<std::string, LatencyHistogram> getChannelLatencyHistograms();
+
+  /**
+   * The slowest recent filesystem requests.
+   *
+   * This function can be called on any thread.
+   */
+  SlowRequestLog& getSlowRequestLog() {
+    return slowRequestLog_;
+  }
+
+  /**
+   * How many background requests may be in flight for filesystem requests
+   * to stay about as fast as they usually are.
+   *
+   * This function can be called on any thread.
+   */
+  const AdaptiveConcurrencyLimit& getBackgroundRequestLimit() const {
+    return backgroundRequestLimit_;
+  }
+
   /**
    * This function can be called on any thread.
    */
@@ -68,6 +133,25 @@ class EdenStats {
  private:
   class ThreadLocalTag {};
 
+  SharedLatencyHistogram& getSharedChannelLatency(folly::StringPiece operation);
+
+  /**
+   * The latencies a thread recorded since it last added them to the shared
+   * histograms, keyed by operation. Only accessed by its thread, except that
+   * the latencies left are published when the thread exits.
+   */
+  struct ChannelLatencyDeltas {
+    ~ChannelLatencyDeltas();
+    void publish();
+
+    struct Delta {
+      LatencyHistogram histogram;
+      SharedLatencyHistogram* shared;
+    };
+    folly::F14NodeMap<std::string, Delta> deltas;
+    std::chrono::steady_clock::time_point nextPublish;
+  };
+
   folly::ThreadLocal<ChannelThreadStats, ThreadLocalTag, void>
       threadLocalChannelStats_;
   folly::ThreadLocal<ObjectStoreThreadStats, ThreadLocalTag, void>
@@ -78,6 +162,22 @@ class EdenStats {
       threadLocalHgImporterStats_;
   folly::ThreadLocal<JournalThreadStats, ThreadLocalTag, void>
       threadLocalJournalStats_;
+  folly::ThreadLocal<ThriftThreadStats, ThreadLocalTag, void>
+      threadLocalThriftStats_;
+  /**
+   * The histograms of every thread's channel latencies, keyed by operation.
+   * This must outlive threadLocalChannelLatencies_, which publishes to it
+   * when destroyed.
+   */
+  folly::Synchronized<
+      folly::F14NodeMap<std::string, std::unique_ptr<SharedLatencyHistogram>>>
+      sharedChannelLatencies_;
+  folly::ThreadLocal<ChannelLatencyDeltas, ThreadLocalTag, void>
+      threadLocalChannelLatencies_;
+
+  SlowRequestLog slowRequestLog_;
+  AdaptiveConcurrencyLimit backgroundRequestLimit_{
+      AdaptiveConcurrencyLimit::Options{}};
 };
 
 std::shared_ptr<HgImporterThreadStats> getSharedHgImporterStatsForCurrentThread(
@@ -127,6 +227,7 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat fsync{createStat("fuse.fsync_us")};
   Stat opendir{createStat("fuse.opendir_us")};
   Stat readdir{createStat("fuse.readdir_us")};
+  Stat readdirplus{createStat("fuse.readdirplus_us")};
   Stat releasedir{createStat("fuse.releasedir_us")};
   Stat fsyncdir{createStat("fuse.fsyncdir_us")};
   Stat statfs{createStat("fuse.statfs_us")};
@@ -207,6 +308,12 @@ class ObjectStoreThreadStats : public EdenThreadStatsBase {
   Stat getBlobFromLocalStore{createStat("object_store.get_blob.local_store")};
   Stat getBlobFromBackingStore{
       createStat("object_store.get_blob.backing_store")};
+  /// getBlob() calls joined onto an identical in-flight fetch.
+  Stat getBlobCoalesced{createStat("object_store.get_blob.coalesced")};
+  /// getTree() calls joined onto an identical in-flight fetch.
+  Stat getTreeCoalesced{createStat("object_store.get_tree.coalesced")};
+  /// getBlob() and getTree() calls failed from the negative cache.
+  Stat negativeCacheHit{createStat("object_store.negative_cache.hit")};
 
   Stat getBlobMetadataFromMemory{
       createStat("object_store.get_blob_metadata.memory")};
@@ -230,6 +337,20 @@ class HgBackingStoreThreadStats : public EdenThreadStatsBase {
   Stat hgBackingStoreImportBlob{createStat("store.hg.import_blob")};
   Stat hgBackingStoreGetTree{createStat("store.hg.get_tree")};
   Stat hgBackingStoreImportTree{createStat("store.hg.import_tree")};
+  /// Objects the native backing store missed, which fell back to HgImporter
+  /// or failed when that fallback is disabled.
+  Stat importerFallbackBlob{createStat("store.hg.importer_fallback.blob")};
+  Stat importerFallbackTree{createStat("store.hg.importer_fallback.tree")};
+  /// Commits resolved to their root manifest by HgImporter.
+  Stat importerManifestNode{createStat("store.hg.importer_manifest_node")};
+  /// Time import requests spent in the queue, by their priority class.
+  Stat queueWaitLow{createStat("store.hg.queue_wait_us.low")};
+  Stat queueWaitNormal{createStat("store.hg.queue_wait_us.normal")};
+  Stat queueWaitHigh{createStat("store.hg.queue_wait_us.high")};
+  /// Queued imports raised to the priority of a more urgent duplicate.
+  Stat importPromoted{createStat("store.hg.import_promoted")};
+  /// Queued imports dropped because all their waiters cancelled.
+  Stat importDropped{createStat("store.hg.import_dropped")};
 };
 
 /**
@@ -250,6 +371,22 @@ class JournalThreadStats : public EdenThreadStatsBase {
  public:
   Stat truncatedReads{createStat("journal.truncated_reads")};
   Stat filesAccumulated{createStat("journal.files_accumulated")};
+  Stat notificationsDropped{createStat("journal.notifications_dropped")};
+  Stat trailingNotifications{createStat("journal.trailing_notifications")};
+};
+
+/**
+ * @see ThriftAdmissionController
+ */
+class ThriftThreadStats : public EdenThreadStatsBase {
+ public:
+  /// Time requests waited for a Thrift worker thread, by request class.
+  Stat queueWaitInteractive{createStat("thrift.queue_wait_us.interactive")};
+  Stat queueWaitBulk{createStat("thrift.queue_wait_us.bulk")};
+  Stat queueWaitDebug{createStat("thrift.queue_wait_us.debug")};
+  /// Requests refused because too many of their class were in flight.
+  Stat rejectedBulk{createStat("thrift.rejected.bulk")};
+  Stat rejectedDebug{createStat("thrift.rejected.debug")};
 };
 
 } // namespace eden
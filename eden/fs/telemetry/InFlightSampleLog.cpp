@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/InFlightSampleLog.h"
+
+namespace facebook::eden {
+
+void InFlightSampleLog::record(
+    InFlightSample sample,
+    std::chrono::nanoseconds history) {
+  auto oldest = sample.time -
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(history);
+  auto samples = samples_.lock();
+  samples->push_back(std::move(sample));
+  while (!samples->empty() && samples->front().time < oldest) {
+    samples->pop_front();
+  }
+}
+
+std::vector<InFlightSample> InFlightSampleLog::getSamples() const {
+  auto samples = samples_.lock();
+  return {samples->begin(), samples->end()};
+}
+
+} // namespace facebook::eden
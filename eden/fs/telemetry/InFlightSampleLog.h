@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A filesystem request or source control import that was in flight when a
+ * sample was taken.
+ */
+struct InFlightRequest {
+  /// "fuse", "nfs", "prjfs" or "hg".
+  std::string source;
+  /// The mount of a filesystem request, or the repository of an import.
+  std::string location;
+  /// Name of the FUSE opcode or NFS procedure, or "blob" or "tree".
+  std::string operation;
+  /// What the request was doing when sampled, e.g. "queued" or "importing".
+  std::string stage;
+  /// See ObjectFetchContext::getRequestId.
+  std::optional<uint64_t> requestId;
+  /// How long the request had been in flight when sampled.
+  std::chrono::microseconds age{0};
+};
+
+struct InFlightSample {
+  std::chrono::system_clock::time_point time;
+  std::vector<InFlightRequest> requests;
+};
+
+/**
+ * A rolling history of periodic snapshots of the in-flight requests, so that
+ * the state of a stall can be inspected after the fact.
+ */
+class InFlightSampleLog {
+ public:
+  /**
+   * Add a sample and drop the samples taken more than `history` before it.
+   */
+  void record(InFlightSample sample, std::chrono::nanoseconds history);
+
+  /**
+   * Returns the kept samples, oldest first.
+   */
+  std::vector<InFlightSample> getSamples() const;
+
+ private:
+  folly::Synchronized<std::deque<InFlightSample>, std::mutex> samples_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LatencyHistogram.h"
+
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+  if (value < kSubBuckets) {
+    return value;
+  }
+  // folly::findLastSet returns the 1-based index of the most significant bit.
+  size_t shift = folly::findLastSet(value) - 1 - kSubBucketBits;
+  return (shift + 1) * kSubBuckets + ((value >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  size_t shift = index / kSubBuckets - 1;
+  uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+  return lower + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(std::chrono::microseconds latency) {
+  auto value = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  ++buckets_[bucketIndex(value)];
+  ++count_;
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  max_ = std::max(max_, other.max_);
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double pct) const {
+  if (count_ == 0) {
+    return std::chrono::microseconds{0};
+  }
+  auto rank = static_cast<uint64_t>(
+      std::ceil(std::clamp(pct, 0.0, 100.0) / 100.0 * count_));
+  rank = std::max<uint64_t>(rank, 1);
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::chrono::microseconds{std::min(bucketUpperBound(i), max_)};
+    }
+  }
+  return max();
+}
+
+void SharedLatencyHistogram::add(const LatencyHistogram& delta) {
+  if (delta.count_ == 0) {
+    return;
+  }
+  for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    if (delta.buckets_[i] != 0) {
+      buckets_[i].fetch_add(delta.buckets_[i], std::memory_order_relaxed);
+    }
+  }
+  auto max = max_.load(std::memory_order_relaxed);
+  while (max < delta.max_ &&
+         !max_.compare_exchange_weak(
+             max, delta.max_, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram SharedLatencyHistogram::snapshot() const {
+  // The count is summed from the buckets, so that it stays consistent with
+  // them even if adds are in progress.
+  LatencyHistogram result;
+  for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    result.buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+    result.count_ += result.buckets_[i];
+  }
+  result.max_ = max_.load(std::memory_order_relaxed);
+  return result;
+}
+
+} // namespace facebook::eden
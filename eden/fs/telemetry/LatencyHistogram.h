@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace facebook::eden {
+
+/**
+ * A log-linear latency histogram in the style of HdrHistogram.
+ *
+ * Every power of two is split into kSubBuckets equally sized buckets, so any
+ * recorded value is known to within 1/kSubBuckets (12.5%) of its magnitude,
+ * from microseconds to hours, with a fixed amount of memory and without any
+ * allocation when recording.
+ *
+ * LatencyHistogram is not synchronized.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 3;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  static constexpr size_t kBucketCount =
+      (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(std::chrono::microseconds latency);
+
+  /**
+   * Add all of the values recorded in other to this histogram.
+   */
+  void merge(const LatencyHistogram& other);
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  std::chrono::microseconds max() const {
+    return std::chrono::microseconds{max_};
+  }
+
+  /**
+   * Returns the latency below which the given percentage (0 to 100) of the
+   * recorded values fall, or 0 if nothing was recorded.
+   */
+  std::chrono::microseconds percentile(double pct) const;
+
+  static size_t bucketIndex(uint64_t value);
+
+  /**
+   * The largest value that is recorded in the bucket at index.
+   */
+  static uint64_t bucketUpperBound(size_t index);
+
+ private:
+  friend class SharedLatencyHistogram;
+
+  std::array<uint64_t, kBucketCount> buckets_{};
+  uint64_t count_{0};
+  uint64_t max_{0};
+};
+
+/**
+ * A LatencyHistogram that threads add to concurrently without locks, meant
+ * to aggregate thread-local histograms: each thread records into its own
+ * LatencyHistogram and periodically adds it here, so that reading the
+ * aggregate does not need to visit every thread.
+ */
+class SharedLatencyHistogram {
+ public:
+  /**
+   * Add the values recorded in delta. Readers may see some of its buckets
+   * added before others.
+   */
+  void add(const LatencyHistogram& delta);
+
+  LatencyHistogram snapshot() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, LatencyHistogram::kBucketCount>
+      buckets_{};
+  std::atomic<uint64_t> max_{0};
+};
+
+} // namespace facebook::eden
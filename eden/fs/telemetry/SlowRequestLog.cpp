@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/SlowRequestLog.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+bool fasterThan(const SlowRequest& lhs, const SlowRequest& rhs) {
+  // std::push_heap builds a max-heap, so invert the comparison to keep the
+  // fastest request at the front.
+  return lhs.duration > rhs.duration;
+}
+} // namespace
+
+SlowRequestLog::SlowRequestLog(
+    size_t requestsPerWindow,
+    size_t windowCount,
+    std::chrono::seconds windowLength)
+    : requestsPerWindow_{std::max<size_t>(requestsPerWindow, 1)},
+      windowCount_{std::max<size_t>(windowCount, 1)},
+      windowLength_{std::max(windowLength, std::chrono::seconds{1})} {}
+
+int64_t SlowRequestLog::windowIndex(
+    std::chrono::system_clock::time_point time) const {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             time.time_since_epoch())
+             .count() /
+      windowLength_.count();
+}
+
+bool SlowRequestLog::isSlowEnough(
+    std::chrono::microseconds duration,
+    std::chrono::system_clock::time_point now) const {
+  if (windowIndex(now) != currentWindow_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  return duration.count() > thresholdUs_.load(std::memory_order_relaxed);
+}
+
+void SlowRequestLog::record(SlowRequest request) {
+  auto index = windowIndex(request.finishTime);
+
+  auto windows = windows_.lock();
+  if (windows->empty() || windows->back().index < index) {
+    windows->push_back(Window{index, {}});
+    windows->back().slowest.reserve(requestsPerWindow_);
+    while (windows->size() > windowCount_) {
+      windows->pop_front();
+    }
+  } else if (windows->back().index > index) {
+    // The request finished before a window that was already started.
+    return;
+  }
+
+  auto& slowest = windows->back().slowest;
+  if (slowest.size() < requestsPerWindow_) {
+    slowest.push_back(std::move(request));
+    std::push_heap(slowest.begin(), slowest.end(), fasterThan);
+  } else if (request.duration > slowest.front().duration) {
+    std::pop_heap(slowest.begin(), slowest.end(), fasterThan);
+    slowest.back() = std::move(request);
+    std::push_heap(slowest.begin(), slowest.end(), fasterThan);
+  } else {
+    return;
+  }
+
+  currentWindow_.store(index, std::memory_order_relaxed);
+  thresholdUs_.store(
+      slowest.size() < requestsPerWindow_ ? 0
+                                          : slowest.front().duration.count(),
+      std::memory_order_relaxed);
+}
+
+std::vector<SlowRequest> SlowRequestLog::getSlowRequests() const {
+  std::vector<SlowRequest> result;
+  {
+    auto windows = windows_.lock();
+    for (const auto& window : *windows) {
+      result.insert(
+          result.end(), window.slowest.begin(), window.slowest.end());
+    }
+  }
+  std::sort(
+      result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.finishTime < rhs.finishTime;
+      });
+  return result;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/portability/SysTypes.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Details of a filesystem request that was among the slowest of its time
+ * window.
+ */
+struct SlowRequest {
+  /// Name of the FUSE opcode, NFS procedure or ProjectedFS callback.
+  std::string operation;
+  std::chrono::microseconds duration{0};
+  std::chrono::system_clock::time_point finishTime;
+  std::optional<pid_t> pid;
+  /// See ObjectFetchContext::getRequestId.
+  std::optional<uint64_t> requestId;
+  /// The inode the request was made on, if the channel reports one.
+  std::optional<uint64_t> inode;
+  /// The path the request was made on, if the channel reports one.
+  std::string path;
+  /// Where the last source control object the request needed came from.
+  std::string fetchOrigin;
+  /// Total time spent waiting on source control object fetches that missed
+  /// the in-memory caches. Concurrent fetches are summed.
+  std::chrono::microseconds backingStoreDuration{0};
+};
+
+/**
+ * Keeps the slowest requestsPerWindow requests of each of the last
+ * windowCount windows of windowLength.
+ *
+ * record() is cheap to skip: callers should check isSlowEnough() first, which
+ * does not take a lock, and only build a SlowRequest when it returns true.
+ */
+class SlowRequestLog {
+ public:
+  explicit SlowRequestLog(
+      size_t requestsPerWindow = 10,
+      size_t windowCount = 10,
+      std::chrono::seconds windowLength = std::chrono::minutes{1});
+
+  /**
+   * Whether a request of this duration that finished now would currently be
+   * kept. May return true for a request that record() then drops.
+   */
+  bool isSlowEnough(
+      std::chrono::microseconds duration,
+      std::chrono::system_clock::time_point now =
+          std::chrono::system_clock::now()) const;
+
+  void record(SlowRequest request);
+
+  /**
+   * Returns the requests that were kept, oldest first.
+   */
+  std::vector<SlowRequest> getSlowRequests() const;
+
+ private:
+  struct Window {
+    int64_t index;
+    // A min-heap on duration, so that the fastest kept request is evicted
+    // first.
+    std::vector<SlowRequest> slowest;
+  };
+
+  int64_t windowIndex(std::chrono::system_clock::time_point time) const;
+
+  const size_t requestsPerWindow_;
+  const size_t windowCount_;
+  const std::chrono::seconds windowLength_;
+
+  folly::Synchronized<std::deque<Window>, std::mutex> windows_;
+
+  // Lock-free summary of the latest window for isSlowEnough(): its index and
+  // the shortest duration kept in it once it is full, or 0 before that.
+  std::atomic<int64_t> currentWindow_{-1};
+  std::atomic<int64_t> thresholdUs_{0};
+};
+
+} // namespace facebook::eden
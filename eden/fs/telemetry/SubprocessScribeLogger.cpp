@@ -9,6 +9,8 @@
 
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <algorithm>
+#include <vector>
 
 namespace {
 /**
@@ -17,6 +19,12 @@ namespace {
  */
 constexpr size_t kQueueLimitBytes = 128 * 1024;
 
+/**
+ * The most iovecs passed to one writev call, which is at least IOV_MAX on
+ * the platforms we support.
+ */
+constexpr size_t kMaxIovecs = 1024;
+
 constexpr std::chrono::seconds kFlushTimeout{1};
 constexpr std::chrono::seconds kProcessExitTimeout{1};
 constexpr std::chrono::seconds kProcessTerminateTimeout{1};
@@ -90,6 +98,7 @@ void SubprocessScribeLogger::closeProcess() {
 
 void SubprocessScribeLogger::log(std::string message) {
   size_t messageSize = message.size();
+  uint64_t dropped = 0;
 
   {
     auto state = state_.lock();
@@ -97,24 +106,38 @@ void SubprocessScribeLogger::log(std::string message) {
     if (state->didStop) {
       return;
     }
-    if (state->totalBytes + messageSize > kQueueLimitBytes) {
-      XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
-      // queue full, dropping!
-      return;
-    }
+    if (messageSize > kQueueLimitBytes) {
+      dropped = 1;
+    } else {
+      // Recent messages are the more useful ones, so make room for this one
+      // by dropping the oldest.
+      while (state->totalBytes + messageSize > kQueueLimitBytes) {
+        state->totalBytes -= state->messages.front().size();
+        state->messages.pop_front();
+        ++dropped;
+      }
 
-    // This order is important in order to be atomic under std::bad_alloc.
-    state->messages.emplace_back(std::move(message));
-    state->totalBytes += messageSize;
+      // This order is important in order to be atomic under std::bad_alloc.
+      state->messages.emplace_back(std::move(message));
+      state->totalBytes += messageSize;
+    }
+  }
+  if (dropped) {
+    auto total =
+        droppedMessages_.fetch_add(dropped, std::memory_order_relaxed) +
+        dropped;
+    XLOG_EVERY_MS(DBG7, 10000)
+        << "ScribeLogger queue full, " << total << " messages dropped so far";
   }
   newMessageOrStop_.notify_one();
 }
 
 void SubprocessScribeLogger::writerThread() {
   auto fd = process_.stdinFd();
+  static constexpr char kNewline = '\n';
 
   for (;;) {
-    std::string message;
+    std::list<std::string> batch;
 
     {
       auto state = state_.lock();
@@ -122,13 +145,10 @@ void SubprocessScribeLogger::writerThread() {
         return state->shouldStop || !state->messages.empty();
       });
       if (!state->messages.empty()) {
-        XCHECK_LE(state->messages.front().size(), state->totalBytes)
-            << "totalSize accounting fell out of sync!";
-
-        // The below statements are all noexcept.
-        std::swap(message, state->messages.front());
-        state->messages.pop_front();
-        state->totalBytes -= message.size();
+        // Take every queued message at once, so they are written with as
+        // few syscalls as possible and log() does not wait for the writes.
+        batch.swap(state->messages);
+        state->totalBytes = 0;
       } else {
         // If the predicate succeeded but we have no messages, then we're
         // shutting down cleanly.
@@ -142,25 +162,29 @@ void SubprocessScribeLogger::writerThread() {
       }
     }
 
-    char newline = '\n';
-    std::array<iovec, 2> iov;
-    iov[0].iov_base = message.data();
-    iov[0].iov_len = message.size();
-    iov[1].iov_base = &newline;
-    iov[1].iov_len = sizeof(newline);
-    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
-      // TODO: We could attempt to restart the process here.
-      XLOG(ERR) << "Failed to writev to logger process stdin: "
-                << folly::errnoStr(errno) << ". Giving up!";
-      // Give up. Allow the ScribeLogger class to be destroyed.
-      {
-        auto state = state_.lock();
-        state->didStop = true;
-        state->messages.clear();
-        state->totalBytes = 0;
+    std::vector<iovec> iov;
+    iov.reserve(std::min(batch.size() * 2, kMaxIovecs));
+    auto it = batch.begin();
+    while (it != batch.end()) {
+      iov.clear();
+      for (; it != batch.end() && iov.size() + 2 <= kMaxIovecs; ++it) {
+        iov.push_back({it->data(), it->size()});
+        iov.push_back({const_cast<char*>(&kNewline), sizeof(kNewline)});
+      }
+      if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+        // TODO: We could attempt to restart the process here.
+        XLOG(ERR) << "Failed to writev to logger process stdin: "
+                  << folly::errnoStr(errno) << ". Giving up!";
+        // Give up. Allow the ScribeLogger class to be destroyed.
+        {
+          auto state = state_.lock();
+          state->didStop = true;
+          state->messages.clear();
+          state->totalBytes = 0;
+        }
+        allMessagesWritten_.notify_one();
+        return;
       }
-      allMessagesWritten_.notify_one();
-      return;
     }
   }
 }
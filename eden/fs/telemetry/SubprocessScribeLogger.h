@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <atomic>
 #include <list>
 #include "eden/fs/telemetry/ScribeLogger.h"
 #include "eden/fs/utils/SpawnedProcess.h"
@@ -46,11 +47,19 @@ class SubprocessScribeLogger : public ScribeLogger {
    * Forwards a log message to the external process. Must not contain newlines,
    * since that is how the process distinguishes between messages.
    *
-   * If the writer process is not keeping up, messages are dropped.
+   * This never waits for the process. If it is not keeping up, the oldest
+   * queued messages are dropped to make room.
    */
   void log(std::string message) override;
   using ScribeLogger::log;
 
+  /**
+   * The number of messages dropped because the process was not keeping up.
+   */
+  uint64_t getDroppedMessageCount() const {
+    return droppedMessages_.load(std::memory_order_relaxed);
+  }
+
  private:
   void closeProcess();
   void writerThread();
@@ -69,6 +78,7 @@ class SubprocessScribeLogger : public ScribeLogger {
   std::thread writerThread_;
 
   folly::Synchronized<State, std::mutex> state_;
+  std::atomic<uint64_t> droppedMessages_{0};
   std::condition_variable newMessageOrStop_;
   std::condition_variable allMessagesWritten_;
 };
@@ -23,10 +23,14 @@ TraceBus<TraceEvent>::TraceBus(
     PrivateConstructorTag,
     std::string name,
     size_t bufferCapacity)
-    : name_{std::move(name)}, bufferCapacity_{bufferCapacity} {
+    : name_{std::move(name)},
+      bufferCapacity_{bufferCapacity},
+      slots_{std::make_unique<Slot[]>(bufferCapacity)} {
   XCHECK_GT(bufferCapacity_, 0u) << "Buffer capacity must not be zero";
 
-  state_.unsafeGetUnlocked().writeBuffer.reserve(bufferCapacity_);
+  for (size_t i = 0; i < bufferCapacity_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
 
   // Allocate the backbuffer here rather than in the thread so std::bad_alloc
   // can be caught.
@@ -45,8 +49,8 @@ TraceBus<TraceEvent>::TraceBus(
 
 template <typename TraceEvent>
 TraceBus<TraceEvent>::~TraceBus() {
-  state_.lock()->done = true;
-  emptyCV_.notify_one();
+  done_.store(true, std::memory_order_seq_cst);
+  emptyEvent_.notify();
   thread_.join();
 
   auto& state = state_.unsafeGetUnlocked();
@@ -67,27 +71,56 @@ void TraceBus<TraceEvent>::publish(const TraceEvent& event) noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::publish(TraceEvent&& event) noexcept {
   static_assert(std::is_nothrow_move_constructible_v<TraceEvent>);
+  XCHECK(!done_.load(std::memory_order_relaxed))
+      << "Illegal to publish concurrently with destruction";
+
+  auto sequence = writeSequence_.fetch_add(1, std::memory_order_relaxed);
+  auto& slot = slots_[sequence % bufferCapacity_];
+  if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+    // If the buffer is full then the capacity is potentially set too low. Log
+    // an appropriate warning and then block until our slot has been emptied.
+    logFullOnce();
+    waitForSlot(slot, sequence);
+  }
+  new (slot.storage) TraceEvent{std::move(event)};
+  slot.sequence.store(sequence + 1, std::memory_order_release);
 
-  bool wake;
-  {
-    auto state = state_.lock();
-    XCHECK(!state->done) << "Illegal to publish concurrently with destruction";
-    if (state->writeBuffer.size() == bufferCapacity_) {
-      // If the buffer is full then the capacity is potentially set too low. Log
-      // an appropriate warning and then block until we have room to append the
-      // current event.
-      logFullOnce();
-      fullCV_.wait(state.as_lock(), [&] {
-        return state->writeBuffer.size() < bufferCapacity_;
-      });
+  // Pairs with the fence in waitForEvent: either the background thread sees
+  // the event before going to sleep, or we see that it is asleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumerSleeping_.load(std::memory_order_relaxed)) {
+    emptyEvent_.notify();
+  }
+}
+
+template <typename TraceEvent>
+void TraceBus<TraceEvent>::waitForSlot(Slot& slot, uint64_t sequence) noexcept {
+  while (true) {
+    auto key = fullEvent_.prepareWait();
+    waitingPublishers_.fetch_add(1, std::memory_order_seq_cst);
+    if (slot.sequence.load(std::memory_order_seq_cst) == sequence) {
+      waitingPublishers_.fetch_sub(1, std::memory_order_relaxed);
+      fullEvent_.cancelWait();
+      return;
     }
-    wake = state->writeBuffer.empty();
-    state->writeBuffer.push_back(std::move(event));
-    state->sequenceNumber++;
+    fullEvent_.wait(key);
+    waitingPublishers_.fetch_sub(1, std::memory_order_relaxed);
   }
-  if (wake) {
-    emptyCV_.notify_one();
+}
+
+template <typename TraceEvent>
+void TraceBus<TraceEvent>::waitForEvent(uint64_t sequence) noexcept {
+  auto& slot = slots_[sequence % bufferCapacity_];
+  auto key = emptyEvent_.prepareWait();
+  consumerSleeping_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (slot.sequence.load(std::memory_order_relaxed) == sequence + 1 ||
+      done_.load(std::memory_order_relaxed)) {
+    emptyEvent_.cancelWait();
+  } else {
+    emptyEvent_.wait(key);
   }
+  consumerSleeping_.store(false, std::memory_order_relaxed);
 }
 
 template <typename TraceEvent>
@@ -107,8 +140,9 @@ void TraceBus<TraceEvent>::unsubscribe(void* subscription) noexcept {
   auto* sub = static_cast<Subscription*>(subscription);
 
   auto state = state_.lock();
-  // Signal to threadLoop that `sub` should be deleted.
-  sub->unsubscribe = state->sequenceNumber;
+  // Signal to threadLoop that `sub` should be deleted once every event claimed
+  // so far has been observed. Offset by one so zero means subscribed.
+  sub->unsubscribe = writeSequence_.load(std::memory_order_acquire) + 1;
 
   // At this point, the memory referenced by `sub` must not be accessed as it
   // may be deleted at any moment.
@@ -139,12 +173,15 @@ void TraceBus<TraceEvent>::threadLoop(
     std::vector<TraceEvent>& readBuffer) noexcept {
   // This function does no allocation and throws no exceptions.
 
-  bool done = false;
-  uint64_t lastObservedSequenceNumber = 0;
-  while (!done) {
+  uint64_t readSequence = 0;
+  while (true) {
     XCHECK(readBuffer.empty())
         << "Avoid waiting while holding references to things";
 
+    // Read before draining: the destructor only sets it once every publish()
+    // has returned, so an empty drain afterwards means nothing is left.
+    bool done = done_.load(std::memory_order_acquire);
+
     Subscription* head;
     {
       auto state = state_.lock();
@@ -159,7 +196,7 @@ void TraceBus<TraceEvent>::threadLoop(
       while (p) {
         Subscription** nlink = &p->next;
         Subscription* next = *nlink;
-        if (p->unsubscribe && p->unsubscribe <= lastObservedSequenceNumber) {
+        if (p->unsubscribe && p->unsubscribe <= readSequence + 1) {
           // Here, we know this subscription has seen events up to (and possibly
           // beyond) its unsubscription request, so unlink it.
           *plink = *nlink;
@@ -179,23 +216,38 @@ void TraceBus<TraceEvent>::threadLoop(
       // of events published after unsubscription.
       //
       // This probably isn't important.
-      lastObservedSequenceNumber = state->sequenceNumber;
+      head = state->subscriptions;
+    }
 
-      // If no events are buffered, sleep until events are delivered or we are
-      // signaled to terminate.
-      emptyCV_.wait(state.as_lock(), [&] {
-        return state->done || !state->writeBuffer.empty();
-      });
-      std::swap(state->writeBuffer, readBuffer);
-      done = state->done;
+    // Move the contiguous run of published events into the batch, emptying
+    // their slots for the next lap of publishers.
+    while (readBuffer.size() < bufferCapacity_) {
+      auto& slot = slots_[readSequence % bufferCapacity_];
+      if (slot.sequence.load(std::memory_order_acquire) != readSequence + 1) {
+        break;
+      }
+      readBuffer.push_back(std::move(*slot.event()));
+      slot.event()->~TraceEvent();
+      slot.sequence.store(
+          readSequence + bufferCapacity_, std::memory_order_release);
+      ++readSequence;
+    }
 
-      head = state->subscriptions;
+    if (readBuffer.empty()) {
+      if (done) {
+        break;
+      }
+      // If no events are buffered, sleep until events are delivered or we
+      // are signaled to terminate.
+      waitForEvent(readSequence);
+      continue;
     }
 
-    // If the publish buffer filled, it's possible a publisher is waiting for
-    // space, so wake them.
-    if (readBuffer.size() == bufferCapacity_) {
-      fullCV_.notify_all();
+    // If the ring filled, it's possible a publisher is waiting for space, so
+    // wake them. Pairs with the check in waitForSlot.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waitingPublishers_.load(std::memory_order_relaxed) > 0) {
+      fullEvent_.notifyAll();
     }
 
     for (auto* sub = head; sub; sub = sub->next) {
@@ -8,10 +8,14 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/experimental/EventCount.h>
+#include <folly/lang/Align.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <new>
 #include <thread>
 #include <utility>
 
@@ -142,6 +146,13 @@ class TraceSubscriptionHandle {
  * computation: if the subscriptions perform heavy computation and events are
  * submitted more frequently than they're processed, publish() will block.
  *
+ * Events are queued in a bounded multi-producer, single-consumer ring. Each
+ * publisher claims a sequence number with one atomic increment and owns the
+ * matching slot until it marks it filled, so publishers never take a lock and
+ * only wake the background thread when it is asleep. The background thread
+ * moves the contiguous run of filled slots into a batch and hands it to every
+ * subscriber's observeBatch.
+ *
  * The capacity should be selected based on the expected usage in context.
  * Memory usage will be capacity * sizeof(TraceEvent) * 2, but a capacity too
  * small will block publishers. The buffer is not intended to prevent all
@@ -239,17 +250,42 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
 
   void logFullOnce() noexcept;
 
+  struct Slot;
+
+  /**
+   * Blocks the publisher that claimed `sequence` until the background thread
+   * has emptied the slot that was used one lap earlier.
+   */
+  void waitForSlot(Slot& slot, uint64_t sequence) noexcept;
+
+  /**
+   * Blocks the background thread until the event at `sequence` is published
+   * or the TraceBus is being destroyed.
+   */
+  void waitForEvent(uint64_t sequence) noexcept;
+
   void threadLoop(std::vector<TraceEvent>& readbuffer) noexcept;
 
+  struct Slot {
+    // Equal to the sequence number that may next fill this slot while it is
+    // empty, and to that sequence number plus one once it holds the event.
+    std::atomic<uint64_t> sequence;
+    alignas(TraceEvent) unsigned char storage[sizeof(TraceEvent)];
+
+    TraceEvent* event() noexcept {
+      return std::launder(reinterpret_cast<TraceEvent*>(storage));
+    }
+  };
+
   struct Subscription {
     const std::shared_ptr<Subscriber> subscriber;
 
     // Accessed only on background thread. Set if the subscriber throws.
     bool hasThrownException = false;
 
-    // If nonzero, unsubscription has been requested after the corresponding
-    // sequenceNumber events have been observed. Only written or read while the
-    // lock is held.
+    // If nonzero, unsubscription has been requested after the events with
+    // sequence numbers below it have been claimed. Only written or read while
+    // the lock is held.
     uint64_t unsubscribe = 0;
 
     // Subscriptions form a linked list. Subscriptions insert to the head of the
@@ -261,21 +297,31 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   };
 
   struct State {
-    bool done = false;
     Subscription* subscriptions = nullptr;
-    std::vector<TraceEvent> writeBuffer;
-    // Incremented every publish()
-    uint64_t sequenceNumber = 1;
   };
 
   const std::string name_;
   const size_t bufferCapacity_;
+  const std::unique_ptr<Slot[]> slots_;
+
+  // Next sequence number to be claimed by a publisher. Kept on its own cache
+  // line since every publisher increments it.
+  alignas(folly::hardware_destructive_interference_size)
+      std::atomic<uint64_t> writeSequence_{0};
+
+  // Set while the background thread waits on emptyEvent_, so publishers only
+  // pay for a wakeup when the thread is asleep.
+  alignas(folly::hardware_destructive_interference_size)
+      std::atomic<bool> consumerSleeping_{false};
+  std::atomic<bool> done_{false};
+  folly::EventCount emptyEvent_;
+
+  // Number of publishers waiting on fullEvent_ for a slot to be emptied.
+  std::atomic<uint64_t> waitingPublishers_{0};
+  folly::EventCount fullEvent_;
 
+  // Only protects the subscription list; publish() never takes it.
   folly::Synchronized<State, std::mutex> state_;
-  // Encodes the condition done || !writeBuffer.empty()
-  std::condition_variable emptyCV_;
-  // Encodes the condition writeBuffer.size() < bufferCapacity_
-  std::condition_variable fullCV_;
   folly::once_flag logIfFullFlag_;
   std::thread thread_;
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/ChromeTrace.h"
+
+#include <folly/json.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<folly::dynamic> eventsWithPhase(
+    const std::string& json,
+    folly::StringPiece phase) {
+  std::vector<folly::dynamic> result;
+  for (auto& event : folly::parseJson(json)["traceEvents"]) {
+    if (event["ph"].asString() == phase) {
+      result.push_back(event);
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(ChromeTraceTest, overlapping_slices_use_separate_threads) {
+  ChromeTrace trace;
+  auto t0 = ChromeTrace::TimePoint{} + 1s;
+  trace.addSlice("fuse", "lookup", t0, t0 + 10ms);
+  trace.addSlice("fuse", "read", t0 + 5ms, t0 + 20ms);
+  trace.addSlice("fuse", "getattr", t0 + 10ms, t0 + 15ms);
+
+  auto slices = eventsWithPhase(trace.toJson(), "X");
+  ASSERT_EQ(3u, slices.size());
+  EXPECT_EQ("lookup", slices[0]["name"].asString());
+  EXPECT_EQ(0, slices[0]["ts"].asDouble());
+  EXPECT_EQ(10000, slices[0]["dur"].asDouble());
+  EXPECT_EQ(1, slices[0]["tid"].asInt());
+  EXPECT_EQ(2, slices[1]["tid"].asInt());
+  // getattr starts when lookup ends, so it reuses its thread.
+  EXPECT_EQ(1, slices[2]["tid"].asInt());
+}
+
+TEST(ChromeTraceTest, tracks_are_processes) {
+  ChromeTrace trace;
+  auto t0 = ChromeTrace::TimePoint{} + 1s;
+  trace.addSlice("fuse", "read", t0, t0 + 10ms);
+  trace.addSlice("hg", "blob", t0, t0 + 10ms);
+
+  auto json = trace.toJson();
+  auto slices = eventsWithPhase(json, "X");
+  ASSERT_EQ(2u, slices.size());
+  EXPECT_EQ(1, slices[0]["pid"].asInt());
+  EXPECT_EQ(2, slices[1]["pid"].asInt());
+
+  std::vector<std::string> names;
+  for (auto& event : eventsWithPhase(json, "M")) {
+    if (event["name"].asString() == "process_name") {
+      names.push_back(event["args"]["name"].asString());
+    }
+  }
+  EXPECT_EQ((std::vector<std::string>{"fuse", "hg"}), names);
+}
+
+TEST(ChromeTraceTest, flow_links_slices) {
+  ChromeTrace trace;
+  auto t0 = ChromeTrace::TimePoint{} + 1s;
+  auto read = trace.addSlice("fuse", "read", t0, t0 + 10ms);
+  auto blob = trace.addSlice("hg", "blob", t0 + 2ms, t0 + 8ms);
+  trace.addFlow(read, blob);
+
+  auto json = trace.toJson();
+  auto starts = eventsWithPhase(json, "s");
+  auto finishes = eventsWithPhase(json, "f");
+  ASSERT_EQ(1u, starts.size());
+  ASSERT_EQ(1u, finishes.size());
+  EXPECT_EQ(starts[0]["id"], finishes[0]["id"]);
+  EXPECT_EQ(1, starts[0]["pid"].asInt());
+  EXPECT_EQ(2000, starts[0]["ts"].asDouble());
+  EXPECT_EQ(2, finishes[0]["pid"].asInt());
+  EXPECT_EQ(2000, finishes[0]["ts"].asDouble());
+  EXPECT_EQ("e", finishes[0]["bp"].asString());
+}
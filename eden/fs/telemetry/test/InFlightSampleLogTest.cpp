@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/InFlightSampleLog.h"
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono_literals;
+using namespace facebook::eden;
+
+namespace {
+const auto kStart = std::chrono::system_clock::time_point{600s};
+
+InFlightSample makeSample(
+    std::chrono::system_clock::time_point time,
+    std::string stage) {
+  InFlightSample sample;
+  sample.time = time;
+  InFlightRequest request;
+  request.source = "hg";
+  request.operation = "blob";
+  request.stage = std::move(stage);
+  sample.requests.push_back(std::move(request));
+  return sample;
+}
+} // namespace
+
+TEST(InFlightSampleLogTest, keeps_samples_within_history) {
+  InFlightSampleLog log;
+  log.record(makeSample(kStart, "queued"), 10s);
+  log.record(makeSample(kStart + 5s, "importing"), 10s);
+  log.record(makeSample(kStart + 11s, "importing"), 10s);
+
+  auto samples = log.getSamples();
+  ASSERT_EQ(2u, samples.size());
+  EXPECT_EQ(kStart + 5s, samples[0].time);
+  EXPECT_EQ(kStart + 11s, samples[1].time);
+  ASSERT_EQ(1u, samples[1].requests.size());
+  EXPECT_EQ("importing", samples[1].requests[0].stage);
+}
+
+TEST(InFlightSampleLogTest, shorter_history_drops_older_samples) {
+  InFlightSampleLog log;
+  log.record(makeSample(kStart, "queued"), 60s);
+  log.record(makeSample(kStart + 1s, "queued"), 60s);
+  log.record(makeSample(kStart + 2s, "queued"), 0s);
+
+  auto samples = log.getSamples();
+  ASSERT_EQ(1u, samples.size());
+  EXPECT_EQ(kStart + 2s, samples[0].time);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LatencyHistogram.h"
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono_literals;
+using namespace facebook::eden;
+
+TEST(LatencyHistogramTest, empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.count());
+  EXPECT_EQ(0us, histogram.percentile(50));
+  EXPECT_EQ(0us, histogram.max());
+}
+
+TEST(LatencyHistogramTest, small_values_are_exact) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 8; ++i) {
+    histogram.record(std::chrono::microseconds{i});
+  }
+  EXPECT_EQ(8, histogram.count());
+  EXPECT_EQ(0us, histogram.percentile(0));
+  EXPECT_EQ(3us, histogram.percentile(50));
+  EXPECT_EQ(7us, histogram.percentile(100));
+}
+
+TEST(LatencyHistogramTest, buckets_cover_every_value_once) {
+  uint64_t previousUpper = 0;
+  for (size_t i = 1; i < LatencyHistogram::kBucketCount; ++i) {
+    auto upper = LatencyHistogram::bucketUpperBound(i);
+    EXPECT_EQ(i, LatencyHistogram::bucketIndex(previousUpper + 1));
+    EXPECT_EQ(i, LatencyHistogram::bucketIndex(upper));
+    previousUpper = upper;
+  }
+  EXPECT_EQ(UINT64_MAX, previousUpper);
+}
+
+TEST(LatencyHistogramTest, percentiles_are_within_precision) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(std::chrono::microseconds{i * 1000});
+  }
+  auto p50 = histogram.percentile(50).count();
+  EXPECT_GE(p50, 500'000);
+  EXPECT_LE(p50, 500'000 * 9 / 8);
+  auto p99 = histogram.percentile(99).count();
+  EXPECT_GE(p99, 990'000);
+  EXPECT_LE(p99, 990'000 * 9 / 8);
+  EXPECT_EQ(1'000'000us, histogram.percentile(100));
+  EXPECT_EQ(1'000'000us, histogram.max());
+}
+
+TEST(LatencyHistogramTest, merge) {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  a.record(10us);
+  b.record(20us);
+  b.record(5000us);
+  a.merge(b);
+  EXPECT_EQ(3, a.count());
+  EXPECT_EQ(5000us, a.max());
+  EXPECT_EQ(10us, a.percentile(33));
+}
+
+TEST(LatencyHistogramTest, shared_histogram_sums_deltas) {
+  SharedLatencyHistogram shared;
+  EXPECT_EQ(0, shared.snapshot().count());
+
+  LatencyHistogram a;
+  a.record(5us);
+  a.record(100us);
+  LatencyHistogram b;
+  b.record(5us);
+  b.record(20ms);
+  shared.add(a);
+  shared.add(b);
+  shared.add(LatencyHistogram{});
+
+  auto snapshot = shared.snapshot();
+  EXPECT_EQ(4, snapshot.count());
+  EXPECT_EQ(20ms, snapshot.max());
+  EXPECT_EQ(5us, snapshot.percentile(50));
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/SlowRequestLog.h"
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono_literals;
+using namespace facebook::eden;
+
+namespace {
+const auto kStart = std::chrono::system_clock::time_point{600s};
+
+SlowRequest makeRequest(
+    std::chrono::microseconds duration,
+    std::chrono::system_clock::time_point finishTime) {
+  SlowRequest request;
+  request.operation = "FUSE_LOOKUP";
+  request.duration = duration;
+  request.finishTime = finishTime;
+  return request;
+}
+} // namespace
+
+TEST(SlowRequestLogTest, keeps_slowest_requests_of_window) {
+  SlowRequestLog log{/*requestsPerWindow=*/2, /*windowCount=*/1, 60s};
+  log.record(makeRequest(10us, kStart));
+  log.record(makeRequest(30us, kStart + 1s));
+  log.record(makeRequest(20us, kStart + 2s));
+  log.record(makeRequest(5us, kStart + 3s));
+
+  auto requests = log.getSlowRequests();
+  ASSERT_EQ(2, requests.size());
+  EXPECT_EQ(30us, requests[0].duration);
+  EXPECT_EQ(20us, requests[1].duration);
+
+  EXPECT_FALSE(log.isSlowEnough(20us, kStart + 4s));
+  EXPECT_TRUE(log.isSlowEnough(21us, kStart + 4s));
+  // Any request is slow enough for a new window.
+  EXPECT_TRUE(log.isSlowEnough(1us, kStart + 60s));
+}
+
+TEST(SlowRequestLogTest, old_windows_are_dropped) {
+  SlowRequestLog log{/*requestsPerWindow=*/1, /*windowCount=*/2, 60s};
+  log.record(makeRequest(10us, kStart));
+  log.record(makeRequest(20us, kStart + 60s));
+  log.record(makeRequest(30us, kStart + 120s));
+
+  auto requests = log.getSlowRequests();
+  ASSERT_EQ(2, requests.size());
+  EXPECT_EQ(20us, requests[0].duration);
+  EXPECT_EQ(30us, requests[1].duration);
+}
@@ -7,7 +7,9 @@
 
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
+#include <folly/Conv.h>
 #include <folly/FileUtil.h>
+#include <folly/String.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 
@@ -31,3 +33,31 @@ TEST(ScribeLogger, log_messages_are_written_with_newlines) {
   folly::readFile(output.fd(), contents);
   EXPECT_EQ("foo\nbar\n", contents);
 }
+
+TEST(ScribeLogger, oldest_messages_are_dropped_when_process_falls_behind) {
+  folly::test::TemporaryFile output;
+  uint64_t dropped;
+
+  {
+    // The process does not read until the queue has overflowed.
+    SubprocessScribeLogger logger{
+        std::vector<std::string>{"/bin/sh", "-c", "sleep 0.2; exec cat"},
+        FileDescriptor(
+            ::dup(output.fd()), "dup", FileDescriptor::FDType::Generic)};
+    std::string padding(1024, 'x');
+    for (int i = 0; i < 1000; ++i) {
+      logger.log(folly::to<std::string>(i, " ", padding));
+    }
+    dropped = logger.getDroppedMessageCount();
+  }
+
+  EXPECT_GT(dropped, 0);
+  folly::checkUnixError(lseek(output.fd(), 0, SEEK_SET));
+  std::string contents;
+  folly::readFile(output.fd(), contents);
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', folly::StringPiece{contents}, lines, true);
+  EXPECT_EQ(1000 - dropped, lines.size());
+  ASSERT_FALSE(lines.empty());
+  EXPECT_TRUE(lines.back().startsWith("999 "));
+}
@@ -8,6 +8,7 @@
 #include "eden/fs/telemetry/TraceBus.h"
 #include <folly/futures/Promise.h>
 #include <folly/portability/GTest.h>
+#include <thread>
 
 using namespace std::literals;
 using namespace facebook::eden;
@@ -46,6 +47,35 @@ TEST(TraceBusTest, publishes_exceed_capacity) {
   }
 }
 
+TEST(TraceBusTest, concurrent_publishers_keep_their_order) {
+  constexpr int kThreads = 8;
+  constexpr int kEventsPerThread = 10000;
+  std::vector<std::pair<int, int>> events;
+  {
+    auto bus = TraceBus<std::pair<int, int>>::create("bus", 16);
+    auto handle = bus->subscribeFunction(
+        "sub", [&](std::pair<int, int> v) { events.push_back(v); });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < kEventsPerThread; ++i) {
+          bus->publish(std::make_pair(t, i));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  ASSERT_EQ(size_t{kThreads * kEventsPerThread}, events.size());
+  std::vector<int> next(kThreads, 0);
+  for (auto [thread, i] : events) {
+    EXPECT_EQ(next[thread]++, i);
+  }
+}
+
 TEST(TraceBusTest, unsubscribes_upon_exception) {
   int i = 0;
 
@@ -133,6 +133,24 @@ SemiFuture<BackingStore::GetBlobRes> FakeBackingStore::getBlob(
   });
 }
 
+SemiFuture<std::unique_ptr<IOBuf>> FakeBackingStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    ObjectFetchContext& /*context*/) {
+  auto data = data_.wlock();
+  ++data->rangeAccessCounts[id];
+  auto it = data->blobs.find(id);
+  if (it == data->blobs.end()) {
+    throw std::domain_error(fmt::format("blob {} not found", id));
+  }
+
+  return it->second->getFuture().thenValue(
+      [offset, length](std::unique_ptr<Blob> blob) {
+        return blob->cloneRange(offset, length);
+      });
+}
+
 Blob FakeBackingStore::makeBlob(folly::StringPiece contents) {
   return makeBlob(ObjectId::sha1(contents), contents);
 }
@@ -400,5 +418,9 @@ void FakeBackingStore::discardOutstandingRequests() {
 size_t FakeBackingStore::getAccessCount(const ObjectId& hash) const {
   return folly::get_default(data_.rlock()->accessCounts, hash, 0);
 }
+
+size_t FakeBackingStore::getRangeAccessCount(const ObjectId& hash) const {
+  return folly::get_default(data_.rlock()->rangeAccessCounts, hash, 0);
+}
 } // namespace eden
 } // namespace facebook
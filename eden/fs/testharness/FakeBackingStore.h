@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <initializer_list>
 #include <memory>
 #include <unordered_map>
@@ -63,6 +64,22 @@ class FakeBackingStore final : public BackingStore {
       const ObjectId& id,
       ObjectFetchContext& context) override;
 
+  bool supportsBlobRanges() override {
+    return supportsBlobRanges_.load(std::memory_order_relaxed);
+  }
+  folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) override;
+
+  /**
+   * Control whether getBlobRange() is used. It is not by default.
+   */
+  void setSupportsBlobRanges(bool supported) {
+    supportsBlobRanges_.store(supported, std::memory_order_relaxed);
+  }
+
   /**
    * Add a Blob to the backing store
    *
@@ -156,6 +173,12 @@ class FakeBackingStore final : public BackingStore {
    */
   size_t getAccessCount(const ObjectId& hash) const;
 
+  /**
+   * Returns the number of times a range of this blob has been fetched with
+   * getBlobRange().
+   */
+  size_t getRangeAccessCount(const ObjectId& hash) const;
+
   // TODO(T119221752): Implement for all BackingStore subclasses
   int64_t dropAllPendingRequestsFromQueue() override {
     XLOG(
@@ -172,6 +195,7 @@ class FakeBackingStore final : public BackingStore {
 
     std::unordered_map<RootId, size_t> commitAccessCounts;
     std::unordered_map<ObjectId, size_t> accessCounts;
+    std::unordered_map<ObjectId, size_t> rangeAccessCounts;
   };
 
   static std::vector<TreeEntry> buildTreeEntries(
@@ -186,6 +210,7 @@ class FakeBackingStore final : public BackingStore {
       std::vector<TreeEntry>&& sortedEntries);
 
   folly::Synchronized<Data> data_;
+  std::atomic<bool> supportsBlobRanges_{false};
 };
 
 enum class FakeBlobType {
@@ -80,6 +80,17 @@ Future<std::shared_ptr<const Blob>> FakeObjectStore::getBlob(
   return makeFuture(make_shared<Blob>(iter->second));
 }
 
+Future<std::unique_ptr<folly::IOBuf>> FakeObjectStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    ObjectFetchContext& context) const {
+  return getBlob(id, context)
+      .thenValue([offset, length](std::shared_ptr<const Blob> blob) {
+        return blob->cloneRange(offset, length);
+      });
+}
+
 folly::Future<folly::Unit> FakeObjectStore::prefetchBlobs(
     ObjectIdRange,
     ObjectFetchContext&) const {
@@ -46,6 +46,15 @@ class FakeObjectStore final : public IObjectStore {
       const ObjectId& id,
       ObjectFetchContext& context =
           ObjectFetchContext::getNullContext()) const override;
+  folly::Future<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context =
+          ObjectFetchContext::getNullContext()) const override;
+  bool supportsBlobRanges() const override {
+    return false;
+  }
   folly::Future<folly::Unit> prefetchBlobs(
       ObjectIdRange ids,
       ObjectFetchContext& context =
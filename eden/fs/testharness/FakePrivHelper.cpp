@@ -98,7 +98,9 @@ Future<Unit> FakePrivHelper::nfsMount(
     folly::SocketAddress /*nfsdPort*/,
     bool /*readOnly*/,
     uint32_t /*iosize*/,
-    bool /*useReaddirplus*/) {
+    bool /*useReaddirplus*/,
+    std::chrono::seconds /*fileAttrCacheTimeout*/,
+    std::chrono::seconds /*dirAttrCacheTimeout*/) {
   return makeFuture<Unit>(
       runtime_error("FakePrivHelper::nfsMount() not implemented"));
 }
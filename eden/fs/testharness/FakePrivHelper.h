@@ -60,7 +60,9 @@ class FakePrivHelper : public PrivHelper {
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus) override;
+      bool useReaddirplus,
+      std::chrono::seconds fileAttrCacheTimeout,
+      std::chrono::seconds dirAttrCacheTimeout) override;
   folly::Future<folly::Unit> fuseUnmount(folly::StringPiece mountPath) override;
   folly::Future<folly::Unit> nfsUnmount(folly::StringPiece mountPath) override;
   folly::Future<folly::Unit> bindMount(
@@ -21,7 +21,7 @@ ImmediateFuture<fuse_entry_out> TestDispatcher::lookup(
     uint64_t requestID,
     InodeNumber parent,
     PathComponentPiece name,
-    ObjectFetchContext& /*context*/) {
+    ObjectFetchContext& context) {
   XLOG(DBG5) << "received lookup " << requestID << ": parent=" << parent
              << ", name=" << name;
   ImmediateFuture<fuse_entry_out> result{};
@@ -29,8 +29,9 @@ ImmediateFuture<fuse_entry_out> TestDispatcher::lookup(
     // Whenever we receive a lookup request just add it to the pendingLookups_
     // The test harness can then respond to it later however it wants.
     auto state = state_.lock();
-    auto emplaceResult =
-        state->pendingLookups.emplace(requestID, PendingLookup(parent, name));
+    auto emplaceResult = state->pendingLookups.emplace(
+        requestID,
+        PendingLookup(parent, name, context.getCancellationToken()));
 
     // We expect the test code to generate unique request IDs,
     // just like the kernel should.
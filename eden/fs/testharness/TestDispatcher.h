@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/Synchronized.h>
 #include <folly/futures/Promise.h>
 #include <chrono>
@@ -31,11 +32,18 @@ class TestDispatcher : public FuseDispatcher {
    * Data for a pending FUSE_LOOKUP request.
    */
   struct PendingLookup {
-    PendingLookup(InodeNumber parent, PathComponentPiece name)
-        : parent(parent), name(name.copy()) {}
+    PendingLookup(
+        InodeNumber parent,
+        PathComponentPiece name,
+        folly::CancellationToken cancellation)
+        : parent(parent),
+          name(name.copy()),
+          cancellation(std::move(cancellation)) {}
 
     InodeNumber parent;
     PathComponent name;
+    /// The cancellation token of the request's fetch context.
+    folly::CancellationToken cancellation;
     folly::Promise<fuse_entry_out> promise;
   };
 
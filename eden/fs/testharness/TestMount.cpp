@@ -463,7 +463,7 @@ void TestMount::addFile(folly::StringPiece path, folly::StringPiece contents) {
 #else
   createResult->write(contents, /*off*/ 0, ObjectFetchContext::getNullContext())
       .get(0ms);
-  createResult->fsync(/*datasync*/ true);
+  createResult->fsync(/*datasync*/ true).get();
 #endif
 }
 
@@ -506,7 +506,7 @@ void TestMount::overwriteFile(
 
   off_t offset = 0;
   file->write(contents, offset, ObjectFetchContext::getNullContext()).get(0ms);
-  file->fsync(/*datasync*/ true);
+  file->fsync(/*datasync*/ true).get();
 #endif
 }
 
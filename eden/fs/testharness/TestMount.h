@@ -305,6 +305,10 @@ class TestMount {
     return serverState_;
   }
 
+  const std::shared_ptr<EdenConfig>& getEdenConfig() const {
+    return edenConfig_;
+  }
+
   /**
    * Get a hash to use for the next commit.
    *
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/AdaptiveConcurrencyLimit.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+AdaptiveConcurrencyLimit::AdaptiveConcurrencyLimit(Options options)
+    : options_{options},
+      nextUpdate_{(std::chrono::steady_clock::now() + options.window)
+                      .time_since_epoch()
+                      .count()},
+      smoothedLimit_{static_cast<double>(options.initialLimit)},
+      limit_{options.initialLimit} {}
+
+void AdaptiveConcurrencyLimit::recordLatency(
+    std::chrono::microseconds latency,
+    std::chrono::steady_clock::time_point now) {
+  sampleSumUs_.fetch_add(latency.count(), std::memory_order_relaxed);
+  sampleCount_.fetch_add(1, std::memory_order_relaxed);
+
+  auto nowTicks = now.time_since_epoch().count();
+  if (nowTicks < nextUpdate_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock{updateMutex_, std::try_to_lock};
+  if (!lock.owns_lock() ||
+      nowTicks < nextUpdate_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (sampleCount_.load(std::memory_order_relaxed) <
+      options_.minSamplesPerWindow) {
+    return;
+  }
+  nextUpdate_.store(
+      (now + options_.window).time_since_epoch().count(),
+      std::memory_order_relaxed);
+  auto count = sampleCount_.exchange(0, std::memory_order_relaxed);
+  auto sum = sampleSumUs_.exchange(0, std::memory_order_relaxed);
+  update(static_cast<double>(sum) / count);
+}
+
+void AdaptiveConcurrencyLimit::update(double averageUs) {
+  if (baselineUs_ == 0) {
+    baselineUs_ = averageUs;
+    return;
+  }
+  baselineUs_ = (1 - options_.baselineWeight) * baselineUs_ +
+      options_.baselineWeight * averageUs;
+
+  double gradient = 1.0;
+  if (averageUs > 0) {
+    gradient = std::clamp(
+        options_.tolerance * baselineUs_ / averageUs, 0.5, 1.0);
+  }
+  // Allow a queue of about the square root of the limit, which leaves room
+  // to grow while the foreground requests are as fast as the baseline.
+  double newLimit = smoothedLimit_ * gradient + std::sqrt(smoothedLimit_);
+  smoothedLimit_ = (1 - options_.smoothing) * smoothedLimit_ +
+      options_.smoothing * newLimit;
+  smoothedLimit_ = std::clamp(
+      smoothedLimit_,
+      static_cast<double>(options_.minLimit),
+      static_cast<double>(options_.maxLimit));
+  limit_.store(
+      static_cast<size_t>(smoothedLimit_), std::memory_order_relaxed);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace facebook::eden {
+
+/**
+ * A concurrency limit for background work that adapts to the latency of
+ * foreground requests, after the gradient algorithm of Netflix's
+ * concurrency-limits.
+ *
+ * Foreground latencies are averaged over short windows and compared with a
+ * slowly moving baseline. While they stay within `tolerance` times the
+ * baseline the limit grows by about its square root per window, and once
+ * they exceed it the limit shrinks in proportion, so that background work
+ * is shed before the foreground requests slow down further.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class AdaptiveConcurrencyLimit {
+ public:
+  struct Options {
+    size_t minLimit = 4;
+    size_t maxLimit = 1000;
+    size_t initialLimit = 64;
+    /// How often the limit is updated.
+    std::chrono::milliseconds window{250};
+    /// Windows with fewer samples are too noisy to act on.
+    uint64_t minSamplesPerWindow = 10;
+    /// How much slower than the baseline requests may get.
+    double tolerance = 1.5;
+    /// The weight of the latest window in the baseline latency.
+    double baselineWeight = 0.01;
+    /// The weight of the latest window's limit in the limit.
+    double smoothing = 0.2;
+  };
+
+  explicit AdaptiveConcurrencyLimit(Options options);
+
+  /**
+   * Record the latency of a foreground request, updating the limit when a
+   * window has elapsed.
+   */
+  void recordLatency(
+      std::chrono::microseconds latency,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+  size_t getLimit() const {
+    return limit_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void update(double averageUs);
+
+  const Options options_;
+
+  std::atomic<uint64_t> sampleSumUs_{0};
+  std::atomic<uint64_t> sampleCount_{0};
+  std::atomic<std::chrono::steady_clock::rep> nextUpdate_;
+
+  /// Held by the thread updating the limit; others skip the update.
+  std::mutex updateMutex_;
+  double baselineUs_{0};
+  double smoothedLimit_;
+
+  std::atomic<size_t> limit_;
+};
+
+} // namespace facebook::eden
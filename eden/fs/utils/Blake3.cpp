@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Blake3.h"
+
+#include <folly/io/IOBuf.h>
+#include <algorithm>
+#include <cstring>
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr uint32_t kChunkStart = 1 << 0;
+constexpr uint32_t kChunkEnd = 1 << 1;
+constexpr uint32_t kParent = 1 << 2;
+constexpr uint32_t kRoot = 1 << 3;
+
+constexpr std::array<uint32_t, 8> kIV = {
+    0x6A09E667,
+    0xBB67AE85,
+    0x3C6EF372,
+    0xA54FF53A,
+    0x510E527F,
+    0x9B05688C,
+    0x1F83D9AB,
+    0x5BE0CD19,
+};
+
+constexpr std::array<uint8_t, 16> kMessagePermutation = {
+    2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+using Words = std::array<uint32_t, 16>;
+
+inline uint32_t rotateRight(uint32_t value, int bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+inline void
+g(Words& state, int a, int b, int c, int d, uint32_t mx, uint32_t my) {
+  state[a] = state[a] + state[b] + mx;
+  state[d] = rotateRight(state[d] ^ state[a], 16);
+  state[c] = state[c] + state[d];
+  state[b] = rotateRight(state[b] ^ state[c], 12);
+  state[a] = state[a] + state[b] + my;
+  state[d] = rotateRight(state[d] ^ state[a], 8);
+  state[c] = state[c] + state[d];
+  state[b] = rotateRight(state[b] ^ state[c], 7);
+}
+
+inline void round(Words& state, const Words& m) {
+  // Mix the columns.
+  g(state, 0, 4, 8, 12, m[0], m[1]);
+  g(state, 1, 5, 9, 13, m[2], m[3]);
+  g(state, 2, 6, 10, 14, m[4], m[5]);
+  g(state, 3, 7, 11, 15, m[6], m[7]);
+  // Mix the diagonals.
+  g(state, 0, 5, 10, 15, m[8], m[9]);
+  g(state, 1, 6, 11, 12, m[10], m[11]);
+  g(state, 2, 7, 8, 13, m[12], m[13]);
+  g(state, 3, 4, 9, 14, m[14], m[15]);
+}
+
+Words loadBlock(const uint8_t* block) {
+  Words words;
+  for (size_t i = 0; i < words.size(); ++i) {
+    const uint8_t* p = block + 4 * i;
+    words[i] = uint32_t(p[0]) | (uint32_t(p[1]) << 8) |
+        (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+  }
+  return words;
+}
+
+/**
+ * The BLAKE3 compression function. The first 8 words of the result are the
+ * new chaining value; all 16 are output when finalizing the root.
+ */
+Words compress(
+    const std::array<uint32_t, 8>& cv,
+    Words m,
+    uint64_t counter,
+    uint32_t blockLength,
+    uint32_t flags) {
+  Words state = {
+      cv[0],
+      cv[1],
+      cv[2],
+      cv[3],
+      cv[4],
+      cv[5],
+      cv[6],
+      cv[7],
+      kIV[0],
+      kIV[1],
+      kIV[2],
+      kIV[3],
+      static_cast<uint32_t>(counter),
+      static_cast<uint32_t>(counter >> 32),
+      blockLength,
+      flags,
+  };
+  for (int r = 0; r < 7; ++r) {
+    round(state, m);
+    if (r != 6) {
+      Words permuted;
+      for (size_t i = 0; i < permuted.size(); ++i) {
+        permuted[i] = m[kMessagePermutation[i]];
+      }
+      m = permuted;
+    }
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    state[i] ^= state[i + 8];
+    state[i + 8] ^= cv[i];
+  }
+  return state;
+}
+
+std::array<uint32_t, 8> firstEight(const Words& words) {
+  std::array<uint32_t, 8> cv;
+  std::copy_n(words.begin(), cv.size(), cv.begin());
+  return cv;
+}
+
+/**
+ * The inputs to a compression that is either the root, whose output is the
+ * digest, or whose chaining value feeds into its parent.
+ */
+struct Output {
+  std::array<uint32_t, 8> cv;
+  Words block;
+  uint64_t counter;
+  uint32_t blockLength;
+  uint32_t flags;
+
+  std::array<uint32_t, 8> chainingValue() const {
+    return firstEight(compress(cv, block, counter, blockLength, flags));
+  }
+
+  Blake3::Digest rootBytes() const {
+    auto words = compress(cv, block, 0, blockLength, flags | kRoot);
+    Blake3::Digest digest;
+    for (size_t i = 0; i < 8; ++i) {
+      digest[4 * i] = static_cast<uint8_t>(words[i]);
+      digest[4 * i + 1] = static_cast<uint8_t>(words[i] >> 8);
+      digest[4 * i + 2] = static_cast<uint8_t>(words[i] >> 16);
+      digest[4 * i + 3] = static_cast<uint8_t>(words[i] >> 24);
+    }
+    return digest;
+  }
+};
+
+Output parentOutput(
+    const std::array<uint32_t, 8>& left,
+    const std::array<uint32_t, 8>& right) {
+  Output output{kIV, {}, 0, Blake3::kBlockSize, kParent};
+  std::copy(left.begin(), left.end(), output.block.begin());
+  std::copy(right.begin(), right.end(), output.block.begin() + 8);
+  return output;
+}
+
+} // namespace
+
+Blake3::ChunkState::ChunkState(uint64_t chunkCounter)
+    : cv{kIV}, counter{chunkCounter} {}
+
+Blake3::Blake3() : chunk_{0} {}
+
+void Blake3::addChunkChainingValue(ChainingValue cv, uint64_t totalChunks) {
+  // Each completed subtree of the chunks seen so far is merged into its
+  // parent. The number of trailing zeros of totalChunks is the number of
+  // subtrees that this chunk completes.
+  while ((totalChunks & 1) == 0) {
+    cv = parentOutput(stack_[--stackSize_], cv).chainingValue();
+    totalChunks >>= 1;
+  }
+  stack_[stackSize_++] = cv;
+}
+
+void Blake3::update(folly::ByteRange data) {
+  while (!data.empty()) {
+    if (chunk_.length() == kChunkSize) {
+      // More input follows, so this chunk is not the root.
+      auto output = Output{
+          chunk_.cv,
+          loadBlock(chunk_.block.data()),
+          chunk_.counter,
+          chunk_.blockLength,
+          (chunk_.blocksCompressed == 0 ? kChunkStart : 0) | kChunkEnd};
+      auto totalChunks = chunk_.counter + 1;
+      addChunkChainingValue(output.chainingValue(), totalChunks);
+      chunk_ = ChunkState{totalChunks};
+    }
+
+    if (chunk_.length() == 0 && data.size() > kChunkSize) {
+      // Compress a whole chunk straight from the input. It is not the last
+      // chunk, so it cannot be the root.
+      auto cv = chunk_.cv;
+      for (size_t i = 0; i < kChunkSize / kBlockSize; ++i) {
+        uint32_t flags = 0;
+        if (i == 0) {
+          flags |= kChunkStart;
+        }
+        if (i == kChunkSize / kBlockSize - 1) {
+          flags |= kChunkEnd;
+        }
+        cv = firstEight(compress(
+            cv,
+            loadBlock(data.data() + i * kBlockSize),
+            chunk_.counter,
+            kBlockSize,
+            flags));
+      }
+      auto totalChunks = chunk_.counter + 1;
+      addChunkChainingValue(cv, totalChunks);
+      chunk_ = ChunkState{totalChunks};
+      data.advance(kChunkSize);
+      continue;
+    }
+
+    // Fill the current block. A full block is only compressed once more
+    // input arrives, since the last block of a chunk is flagged differently.
+    if (chunk_.blockLength == kBlockSize) {
+      chunk_.cv = firstEight(compress(
+          chunk_.cv,
+          loadBlock(chunk_.block.data()),
+          chunk_.counter,
+          kBlockSize,
+          chunk_.blocksCompressed == 0 ? kChunkStart : 0));
+      ++chunk_.blocksCompressed;
+      chunk_.block.fill(0);
+      chunk_.blockLength = 0;
+    }
+    auto take = std::min(
+        kChunkSize - chunk_.length(),
+        std::min(kBlockSize - chunk_.blockLength, data.size()));
+    memcpy(chunk_.block.data() + chunk_.blockLength, data.data(), take);
+    chunk_.blockLength += static_cast<uint8_t>(take);
+    data.advance(take);
+  }
+}
+
+Blake3::Digest Blake3::finalize() const {
+  auto output = Output{
+      chunk_.cv,
+      loadBlock(chunk_.block.data()),
+      chunk_.counter,
+      chunk_.blockLength,
+      (chunk_.blocksCompressed == 0 ? kChunkStart : 0) | kChunkEnd};
+  for (size_t i = stackSize_; i > 0; --i) {
+    output = parentOutput(stack_[i - 1], output.chainingValue());
+  }
+  return output.rootBytes();
+}
+
+Blake3::Digest Blake3::hash(folly::ByteRange data) {
+  Blake3 hasher;
+  hasher.update(data);
+  return hasher.finalize();
+}
+
+Blake3::Digest Blake3::hash(const folly::IOBuf& buf) {
+  Blake3 hasher;
+  for (auto range : buf) {
+    hasher.update(range);
+  }
+  return hasher.finalize();
+}
+
+} // namespace facebook::eden
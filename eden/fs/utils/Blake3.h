@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <array>
+#include <cstdint>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace facebook::eden {
+
+/**
+ * Incrementally computes the 32-byte BLAKE3 digest of some data, in the
+ * default (unkeyed) mode.
+ *
+ * BLAKE3 is several times faster than SHA-1 even without SIMD, so it is
+ * offered next to SHA-1 to clients that only need a fast content hash.
+ * Whole 1 KiB chunks are compressed straight from the input without being
+ * copied.
+ */
+class Blake3 {
+ public:
+  static constexpr size_t kDigestSize = 32;
+  using Digest = std::array<uint8_t, kDigestSize>;
+
+  Blake3();
+
+  void update(folly::ByteRange data);
+
+  /**
+   * Return the digest of all the data passed to update() so far. The hasher
+   * can be updated further afterwards.
+   */
+  Digest finalize() const;
+
+  static Digest hash(folly::ByteRange data);
+  static Digest hash(const folly::IOBuf& buf);
+
+  static constexpr size_t kBlockSize = 64;
+  static constexpr size_t kChunkSize = 1024;
+
+ private:
+  using ChainingValue = std::array<uint32_t, 8>;
+
+  struct ChunkState {
+    explicit ChunkState(uint64_t counter);
+
+    size_t length() const {
+      return kBlockSize * blocksCompressed + blockLength;
+    }
+
+    ChainingValue cv;
+    uint64_t counter;
+    std::array<uint8_t, kBlockSize> block{};
+    uint8_t blockLength{0};
+    uint8_t blocksCompressed{0};
+  };
+
+  void addChunkChainingValue(ChainingValue cv, uint64_t totalChunks);
+
+  ChunkState chunk_;
+  /// Enough for 2^54 chunks, which is more than a 64-bit length can hold.
+  std::array<ChainingValue, 54> stack_;
+  uint8_t stackSize_{0};
+};
+
+} // namespace facebook::eden
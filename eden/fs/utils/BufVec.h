@@ -7,21 +7,33 @@
 
 #pragma once
 #include <folly/io/IOBuf.h>
+#include <sys/types.h>
+#include <memory>
 
 namespace facebook {
 namespace eden {
 
 /**
- * Represents data that may come from a buffer or a file descriptor.
+ * Represents data held in memory.
  *
- * EdenFS does not currently support splicing between the FUSE device
- * pipe and the backing files in the overlay, but there's an opportunity
- * to improve performance on large files by enabling FUSE_CAP_SPLICE_READ or
- * FUSE_CAP_SPLICE_WRITE.
+ * Data that comes from a file descriptor is represented by FileRange instead,
+ * so that large reads from the overlay can be spliced to the FUSE device.
  *
  * So pretend we have a type that corresponds roughly to libfuse's fuse_bufvec.
  */
 using BufVec = std::unique_ptr<folly::IOBuf>;
 
+/**
+ * A range of an open file, corresponding roughly to a libfuse fuse_buf with
+ * FUSE_BUF_IS_FD set. The range may extend past the end of the file.
+ */
+struct FileRange {
+  int fd{-1};
+  off_t offset{0};
+  size_t size{0};
+  /// Keeps fd open for as long as the FileRange exists.
+  std::shared_ptr<const void> keepAlive;
+};
+
 } // namespace eden
 } // namespace facebook
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/ConcurrencyLimiter.h"
+
+namespace facebook::eden {
+
+ImmediateFuture<folly::Unit> ConcurrencyLimiter::acquire() {
+  auto state = state_.lock();
+  if (state->inFlight < limit_) {
+    ++state->inFlight;
+    return folly::unit;
+  }
+  state->waiters.emplace_back();
+  return state->waiters.back().getSemiFuture();
+}
+
+void ConcurrencyLimiter::release() {
+  folly::Promise<folly::Unit> next;
+  {
+    auto state = state_.lock();
+    if (state->waiters.empty()) {
+      --state->inFlight;
+      return;
+    }
+    // Hand the permit straight to the next waiter.
+    next = std::move(state->waiters.front());
+    state->waiters.pop_front();
+  }
+  next.setValue();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/futures/Promise.h>
+#include <deque>
+#include <mutex>
+
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+/**
+ * Bounds the number of asynchronous operations in flight.
+ *
+ * Callers wait on acquire() before starting an operation, and call release()
+ * once it completes. Waiters are handed permits in the order they asked for
+ * them.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class ConcurrencyLimiter {
+ public:
+  explicit ConcurrencyLimiter(size_t limit) : limit_{limit} {}
+
+  /**
+   * Completes once the caller may start an operation. This is immediately
+   * ready while fewer than `limit` operations are in flight.
+   */
+  ImmediateFuture<folly::Unit> acquire();
+
+  /**
+   * Mark an operation started after acquire() as complete.
+   */
+  void release();
+
+  /**
+   * Run `func`, an operation returning an ImmediateFuture, once fewer than
+   * `limit` operations are in flight.
+   */
+  template <typename Func>
+  auto run(Func&& func) -> decltype(func()) {
+    return acquire().thenValue(
+        [this, func = std::forward<Func>(func)](folly::Unit) mutable {
+          return makeImmediateFutureWith(std::move(func)).ensure([this] {
+            release();
+          });
+        });
+  }
+
+ private:
+  struct State {
+    size_t inFlight{0};
+    std::deque<folly::Promise<folly::Unit>> waiters;
+  };
+
+  const size_t limit_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -7,13 +7,21 @@
 
 #include "eden/fs/utils/FileHash.h"
 #include <openssl/sha.h>
+#include <vector>
 #include "eden/common/utils/WinError.h"
 
 namespace facebook::eden {
 
 #ifdef _WIN32
 
-Hash20 getFileSha1(AbsolutePathPiece filePath) {
+namespace {
+
+/**
+ * Call `update` with successive pieces of the contents of the file at
+ * `filePath`.
+ */
+template <typename Fn>
+void readFileChunks(AbsolutePathPiece filePath, size_t bufSize, Fn&& update) {
   auto widePath = filePath.wide();
 
   HANDLE fileHandle = CreateFileW(
@@ -33,25 +41,36 @@ Hash20 getFileSha1(AbsolutePathPiece filePath) {
     CloseHandle(fileHandle);
   };
 
-  SHA_CTX ctx;
-  SHA1_Init(&ctx);
+  std::vector<uint8_t> buf(bufSize);
   while (true) {
-    uint8_t buf[8192];
-
     DWORD bytesRead;
-    if (!ReadFile(fileHandle, buf, sizeof(buf), &bytesRead, nullptr)) {
+    if (!ReadFile(
+            fileHandle,
+            buf.data(),
+            static_cast<DWORD>(buf.size()),
+            &bytesRead,
+            nullptr)) {
       throw makeWin32ErrorExplicit(
           GetLastError(),
-          fmt::format(
-              FMT_STRING("Error while computing SHA1 of {}"), filePath));
+          fmt::format(FMT_STRING("Error while hashing {}"), filePath));
     }
 
     if (bytesRead == 0) {
       break;
     }
 
-    SHA1_Update(&ctx, buf, bytesRead);
+    update(buf.data(), bytesRead);
   }
+}
+
+} // namespace
+
+Hash20 getFileSha1(AbsolutePathPiece filePath) {
+  SHA_CTX ctx;
+  SHA1_Init(&ctx);
+  readFileChunks(filePath, 8192, [&](const uint8_t* data, size_t size) {
+    SHA1_Update(&ctx, data, size);
+  });
 
   static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
   Hash20 sha1;
@@ -60,6 +79,14 @@ Hash20 getFileSha1(AbsolutePathPiece filePath) {
   return sha1;
 }
 
+Blake3::Digest getFileBlake3(AbsolutePathPiece filePath) {
+  Blake3 hasher;
+  readFileChunks(filePath, 256 * 1024, [&](const uint8_t* data, size_t size) {
+    hasher.update(folly::ByteRange{data, size});
+  });
+  return hasher.finalize();
+}
+
 #endif
 
 } // namespace facebook::eden
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/Blake3.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -15,6 +16,9 @@ namespace facebook::eden {
 #ifdef _WIN32
 /** Compute the sha1 of the file */
 Hash20 getFileSha1(AbsolutePathPiece filePath);
+
+/** Compute the BLAKE3 hash of the file */
+Blake3::Digest getFileBlake3(AbsolutePathPiece filePath);
 #endif
 
 } // namespace facebook::eden
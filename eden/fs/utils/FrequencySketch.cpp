@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FrequencySketch.h"
+
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+// Each table word holds sixteen 4-bit counters.
+constexpr size_t kDepth = 4;
+constexpr uint64_t kResetMask = 0x7777777777777777ull;
+constexpr uint64_t kSeeds[kDepth] = {
+    0xc3a5c85c97cb3127ull,
+    0xb492b66fbe98f273ull,
+    0x9ae16a3b2f90404full,
+    0xcbf29ce484222325ull,
+};
+
+size_t nextPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+} // namespace
+
+void FrequencySketch::ensureCapacity(size_t expectedEntries) {
+  auto words = nextPowerOfTwo(std::max<size_t>(expectedEntries, 16));
+  table_.assign(words, 0);
+  tableMask_ = words - 1;
+  additions_ = 0;
+  sampleSize_ = 10 * std::max<size_t>(expectedEntries, 16);
+}
+
+uint64_t FrequencySketch::mix(uint64_t hash, size_t depth) noexcept {
+  // splitmix64 finalizer with a per-row seed, so that the rows are
+  // independent even when the caller's hash is weak.
+  uint64_t x = hash + kSeeds[depth];
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+void FrequencySketch::increment(uint64_t hash) noexcept {
+  if (table_.empty()) {
+    return;
+  }
+  bool added = false;
+  for (size_t depth = 0; depth < kDepth; ++depth) {
+    auto h = mix(hash, depth);
+    auto& word = table_[h & tableMask_];
+    auto shift = ((h >> 60) & 0xf) * 4;
+    if (((word >> shift) & 0xf) < kMaxFrequency) {
+      word += uint64_t{1} << shift;
+      added = true;
+    }
+  }
+  if (added && ++additions_ >= sampleSize_) {
+    age();
+  }
+}
+
+uint8_t FrequencySketch::frequency(uint64_t hash) const noexcept {
+  if (table_.empty()) {
+    return 0;
+  }
+  uint8_t result = kMaxFrequency;
+  for (size_t depth = 0; depth < kDepth; ++depth) {
+    auto h = mix(hash, depth);
+    auto word = table_[h & tableMask_];
+    auto shift = ((h >> 60) & 0xf) * 4;
+    result = std::min(result, static_cast<uint8_t>((word >> shift) & 0xf));
+  }
+  return result;
+}
+
+void FrequencySketch::age() noexcept {
+  for (auto& word : table_) {
+    word = (word >> 1) & kResetMask;
+  }
+  additions_ /= 2;
+}
+
+void FrequencySketch::clear() noexcept {
+  std::fill(table_.begin(), table_.end(), 0);
+  additions_ = 0;
+}
+
+} // namespace eden
+} // namespace facebook
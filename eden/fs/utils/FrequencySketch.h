@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace facebook {
+namespace eden {
+
+/**
+ * A compact, approximate frequency counter in the style of the count-min
+ * sketch used by TinyLFU.
+ *
+ * Each key maps to four 4-bit counters; the estimated frequency of a key is
+ * the minimum of its counters, so it can overestimate but never
+ * underestimate (until aging). Counters saturate at 15. Once the number of
+ * recorded accesses reaches ten times the configured capacity, every counter
+ * is halved so that the sketch tracks recent popularity rather than all-time
+ * popularity.
+ *
+ * Callers pass in an already-computed 64-bit hash of the key.
+ *
+ * This class is not thread-safe; callers must provide their own locking.
+ */
+class FrequencySketch {
+ public:
+  static constexpr uint8_t kMaxFrequency = 15;
+
+  /**
+   * Construct an empty sketch that does not track anything. Call
+   * ensureCapacity() before use.
+   */
+  FrequencySketch() = default;
+
+  explicit FrequencySketch(size_t expectedEntries) {
+    ensureCapacity(expectedEntries);
+  }
+
+  /**
+   * Size the sketch to accurately track roughly expectedEntries distinct keys.
+   * Resizing discards all existing counts.
+   */
+  void ensureCapacity(size_t expectedEntries);
+
+  /**
+   * Record one access to the key with the given hash.
+   */
+  void increment(uint64_t hash) noexcept;
+
+  /**
+   * Return the estimated number of recent accesses to the key with the given
+   * hash, between 0 and kMaxFrequency.
+   */
+  uint8_t frequency(uint64_t hash) const noexcept;
+
+  /**
+   * Halve every counter. Called automatically; exposed for tests.
+   */
+  void age() noexcept;
+
+  /**
+   * Forget all recorded accesses.
+   */
+  void clear() noexcept;
+
+  bool empty() const noexcept {
+    return table_.empty();
+  }
+
+ private:
+  static uint64_t mix(uint64_t hash, size_t depth) noexcept;
+
+  std::vector<uint64_t> table_;
+  uint64_t tableMask_{0};
+  size_t additions_{0};
+  size_t sampleSize_{0};
+};
+
+} // namespace eden
+} // namespace facebook
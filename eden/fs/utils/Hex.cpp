@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Hex.h"
+
+#include <folly/Portability.h>
+#include <array>
+
+#if FOLLY_SSE >= 2
+#include <emmintrin.h>
+#elif FOLLY_NEON && FOLLY_AARCH64
+#include <arm_neon.h>
+#endif
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+constexpr uint8_t kInvalidNibble = 0xff;
+
+constexpr std::array<uint8_t, 256> makeNibbleTable() {
+  std::array<uint8_t, 256> table{};
+  for (int c = 0; c < static_cast<int>(table.size()); ++c) {
+    if ('0' <= c && c <= '9') {
+      table[c] = c - '0';
+    } else if ('a' <= c && c <= 'f') {
+      table[c] = 10 + c - 'a';
+    } else if ('A' <= c && c <= 'F') {
+      table[c] = 10 + c - 'A';
+    } else {
+      table[c] = kInvalidNibble;
+    }
+  }
+  return table;
+}
+
+constexpr std::array<uint8_t, 256> kNibbleTable = makeNibbleTable();
+
+#if FOLLY_SSE >= 2
+
+/**
+ * Map each byte of `nibbles`, all in [0, 15], to its lowercase hex digit.
+ */
+__m128i nibblesToHex(__m128i nibbles) {
+  auto letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  auto digits = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+  return _mm_add_epi8(
+      digits, _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+/**
+ * Encode 16 bytes from `in` as 32 hex digits in `out`.
+ */
+void encode16(const uint8_t* in, char* out) {
+  auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  auto mask = _mm_set1_epi8(0x0f);
+  auto high = nibblesToHex(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+  auto low = nibblesToHex(_mm_and_si128(bytes, mask));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(high, low));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(high, low));
+}
+
+/**
+ * Map each hex digit in `chars` to its value, clearing bytes of `valid` for
+ * characters that are not hex digits.
+ *
+ * The range checks use signed comparisons, which is fine since every digit
+ * is below 0x80 and every byte at or above 0x80 compares as negative.
+ */
+__m128i hexToNibbles(__m128i chars, __m128i& valid) {
+  auto isDigit = _mm_and_si128(
+      _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+      _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+  auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  auto isLetter = _mm_and_si128(
+      _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+      _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+  valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isLetter));
+  return _mm_or_si128(
+      _mm_and_si128(isDigit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+      _mm_and_si128(
+          isLetter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+/**
+ * Combine each pair of nibbles in `nibbles`, high nibble first, into a byte
+ * stored in the low half of the corresponding 16-bit lane.
+ */
+__m128i combineNibbles(__m128i nibbles) {
+  auto high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0xff)), 4);
+  auto low = _mm_srli_epi16(nibbles, 8);
+  return _mm_or_si128(high, low);
+}
+
+/**
+ * Decode 32 hex digits from `in` into 16 bytes in `out`. Returns false if any
+ * of them is not a hex digit.
+ */
+bool decode32(const char* in, uint8_t* out) {
+  auto valid = _mm_set1_epi8(-1);
+  auto first = hexToNibbles(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), valid);
+  auto second = hexToNibbles(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16)), valid);
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out),
+      _mm_packus_epi16(combineNibbles(first), combineNibbles(second)));
+  return _mm_movemask_epi8(valid) == 0xffff;
+}
+
+#define EDEN_HAVE_SIMD_HEX 1
+
+#elif FOLLY_NEON && FOLLY_AARCH64
+
+void encode16(const uint8_t* in, char* out) {
+  auto table = vld1q_u8(reinterpret_cast<const uint8_t*>(kHexDigits));
+  auto bytes = vld1q_u8(in);
+  uint8x16x2_t chars;
+  chars.val[0] = vqtbl1q_u8(table, vshrq_n_u8(bytes, 4));
+  chars.val[1] = vqtbl1q_u8(table, vandq_u8(bytes, vdupq_n_u8(0x0f)));
+  // vst2q interleaves the high and low digits of each byte.
+  vst2q_u8(reinterpret_cast<uint8_t*>(out), chars);
+}
+
+/**
+ * Map each hex digit in `chars` to its value, clearing bytes of `valid` for
+ * characters that are not hex digits.
+ */
+uint8x16_t hexToNibbles(uint8x16_t chars, uint8x16_t& valid) {
+  auto digit = vsubq_u8(chars, vdupq_n_u8('0'));
+  auto isDigit = vcltq_u8(digit, vdupq_n_u8(10));
+  auto letter = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  auto isLetter = vcltq_u8(letter, vdupq_n_u8(6));
+  valid = vandq_u8(valid, vorrq_u8(isDigit, isLetter));
+  return vorrq_u8(
+      vandq_u8(isDigit, digit),
+      vandq_u8(isLetter, vaddq_u8(letter, vdupq_n_u8(10))));
+}
+
+bool decode32(const char* in, uint8_t* out) {
+  // vld2q splits the input into high digits and low digits.
+  auto chars = vld2q_u8(reinterpret_cast<const uint8_t*>(in));
+  auto valid = vdupq_n_u8(0xff);
+  auto high = hexToNibbles(chars.val[0], valid);
+  auto low = hexToNibbles(chars.val[1], valid);
+  vst1q_u8(out, vorrq_u8(vshlq_n_u8(high, 4), low));
+  return vminvq_u8(valid) == 0xff;
+}
+
+#define EDEN_HAVE_SIMD_HEX 1
+
+#endif
+
+} // namespace
+
+void hexEncode(folly::ByteRange bytes, char* out) {
+  auto in = bytes.data();
+  auto end = bytes.end();
+#ifdef EDEN_HAVE_SIMD_HEX
+  for (; end - in >= 16; in += 16, out += 32) {
+    encode16(in, out);
+  }
+#endif
+  for (; in != end; ++in, out += 2) {
+    out[0] = kHexDigits[*in >> 4];
+    out[1] = kHexDigits[*in & 0x0f];
+  }
+}
+
+std::string hexEncode(folly::ByteRange bytes) {
+  std::string result(bytes.size() * 2, '\0');
+  hexEncode(bytes, result.data());
+  return result;
+}
+
+bool hexDecode(folly::StringPiece hex, uint8_t* out) {
+  auto in = hex.data();
+  auto end = hex.end();
+  bool valid = true;
+#ifdef EDEN_HAVE_SIMD_HEX
+  for (; end - in >= 32; in += 32, out += 16) {
+    valid &= decode32(in, out);
+  }
+#endif
+  // Checking validity once at the end avoids a branch per byte. Valid nibbles
+  // are below 0x10, so OR-ing them together exposes any invalid one.
+  uint8_t invalid = 0;
+  for (; end - in >= 2; in += 2, ++out) {
+    auto high = kNibbleTable[static_cast<uint8_t>(in[0])];
+    auto low = kNibbleTable[static_cast<uint8_t>(in[1])];
+    invalid |= high | low;
+    *out = static_cast<uint8_t>((high << 4) | low);
+  }
+  return valid && (invalid & 0xf0) == 0;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstdint>
+#include <string>
+
+namespace facebook::eden {
+
+/**
+ * Write the lowercase hexadecimal representation of `bytes` to `out`, which
+ * must have room for 2 * bytes.size() characters. No terminator is written.
+ *
+ * This is equivalent to folly::hexlify, but encodes 16 bytes at a time with
+ * SSE2 or NEON where available. Object IDs are rendered on hot paths (debug
+ * logging, thrift responses, backing store requests), where hexlify's
+ * per-byte appends stand out.
+ */
+void hexEncode(folly::ByteRange bytes, char* out);
+
+/**
+ * Return the lowercase hexadecimal representation of `bytes`.
+ */
+std::string hexEncode(folly::ByteRange bytes);
+
+/**
+ * Decode the hexadecimal string `hex` into `out`, which must have room for
+ * hex.size() / 2 bytes. Both lowercase and uppercase digits are accepted.
+ *
+ * hex.size() must be even. Returns false if `hex` contains a character that
+ * is not a hexadecimal digit, in which case the contents of `out` are
+ * unspecified.
+ */
+bool hexDecode(folly::StringPiece hex, uint8_t* out);
+
+} // namespace facebook::eden
@@ -88,11 +88,26 @@ ImmediateFuture<T>& ImmediateFuture<T>::operator=(
   return *this;
 }
 
+template <typename T>
+void ImmediateFuture<T>::unwrapReadySemiFuture() {
+  if (kind_ != Kind::SemiFuture || !semi_.isReady()) {
+    return;
+  }
+  // The SemiFuture holds a result with no deferred work pending, extracting it
+  // is non-blocking and lets the continuation run inline instead of being
+  // deferred on the SemiFuture core, which would heap allocate.
+  auto try_ = std::move(semi_).getTry();
+  destroy();
+  new (&immediate_) folly::Try<T>{std::move(try_)};
+  kind_ = Kind::Immediate;
+}
+
 template <typename T>
 template <typename Func>
 ImmediateFuture<detail::continuation_result_t<Func, T>>
 ImmediateFuture<T>::thenValue(Func&& func) && {
   using RetType = detail::continuation_result_t<Func, T>;
+  unwrapReadySemiFuture();
   if (kind_ == Kind::Immediate && immediate_.hasException()) {
     return ImmediateFuture<RetType>{
         folly::Try<RetType>{std::move(immediate_).exception()}};
@@ -144,6 +159,7 @@ ImmediateFuture<T>::thenTry(Func&& func) && {
   using NewType = detail::continuation_result_t<Func, folly::Try<T>>;
   using FuncRetType = std::invoke_result_t<Func, folly::Try<T>>;
 
+  unwrapReadySemiFuture();
   switch (kind_) {
     case Kind::Immediate:
       try {
@@ -376,4 +392,27 @@ collectAllSafe(Fs&&... fs) {
                  res) { return unwrapTryTuple(std::move(res)); });
 }
 
+#if FOLLY_HAS_COROUTINES
+template <typename T>
+void ImmediateFutureAwaiter<T>::await_suspend(
+    folly::coro::coroutine_handle<> continuation) {
+  suspended_ = true;
+  folly::futures::detachOn(
+      std::move(executor_),
+      std::move(future_).semi().defer(
+          [this, continuation](folly::Try<T>&& result) mutable {
+            result_ = std::move(result);
+            continuation.resume();
+          }));
+}
+
+template <typename T>
+T ImmediateFutureAwaiter<T>::await_resume() {
+  if (suspended_) {
+    return std::move(result_).value();
+  }
+  return std::move(future_).get();
+}
+#endif
+
 } // namespace facebook::eden
@@ -7,7 +7,11 @@
 
 #pragma once
 
+#include <folly/Portability.h>
 #include <folly/futures/Future.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Coroutine.h>
+#endif
 #include "eden/fs/utils/ImmediateFuture-pre.h"
 
 namespace facebook::eden {
@@ -208,6 +212,12 @@ class ImmediateFuture {
    */
   void destroy();
 
+  /**
+   * If this holds a SemiFuture that already completed, move its result into
+   * immediate_ so that continuations attached to it run inline.
+   */
+  void unwrapReadySemiFuture();
+
   union {
     folly::Try<T> immediate_;
     folly::SemiFuture<T> semi_;
@@ -321,6 +331,56 @@ template <typename... Fs>
 ImmediateFuture<std::tuple<typename folly::remove_cvref_t<Fs>::value_type...>>
 collectAllSafe(Fs&&... fs);
 
+#if FOLLY_HAS_COROUTINES
+/**
+ * Awaiter used when an ImmediateFuture is co_await'ed from a
+ * folly::coro::Task.
+ *
+ * A ready ImmediateFuture does not suspend the awaiting coroutine: its value
+ * is returned synchronously, without allocating. Otherwise, the underlying
+ * SemiFuture is scheduled on the Task's executor and the coroutine is resumed
+ * there once it completes.
+ */
+template <typename T>
+class ImmediateFutureAwaiter {
+ public:
+  ImmediateFutureAwaiter(
+      folly::Executor::KeepAlive<> executor,
+      ImmediateFuture<T>&& future)
+      : executor_{std::move(executor)}, future_{std::move(future)} {}
+
+  bool await_ready() const {
+    return future_.isReady();
+  }
+
+  void await_suspend(folly::coro::coroutine_handle<> continuation);
+
+  T await_resume();
+
+ private:
+  folly::Executor::KeepAlive<> executor_;
+  ImmediateFuture<T> future_;
+  folly::Try<T> result_;
+  bool suspended_{false};
+};
+
+/**
+ * Allows an ImmediateFuture to be co_await'ed from a folly::coro::Task. Found
+ * by argument dependent lookup from the Task's await_transform:
+ *
+ *   folly::coro::Task<int> foo() {
+ *     auto value = co_await immediateFutureReturningFunction();
+ *     co_return value + 1;
+ *   }
+ */
+template <typename T>
+ImmediateFutureAwaiter<T> co_viaIfAsync(
+    folly::Executor::KeepAlive<> executor,
+    ImmediateFuture<T>&& future) {
+  return ImmediateFutureAwaiter<T>{std::move(executor), std::move(future)};
+}
+#endif
+
 } // namespace facebook::eden
 
 #include "eden/fs/utils/ImmediateFuture-inl.h"
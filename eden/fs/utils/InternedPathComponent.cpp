@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/InternedPathComponent.h"
+
+#include <folly/Indestructible.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <atomic>
+
+namespace facebook::eden {
+
+struct InternedPathComponent::Node {
+  Node(PathComponentPiece name, size_t hash) : hash{hash}, name{name.copy()} {}
+
+  // Once this reaches zero, the node is never resurrected: the constructor
+  // replaces a dying node with a new one.
+  std::atomic<size_t> refCount{1};
+  const size_t hash;
+  const PathComponent name;
+};
+
+struct alignas(folly::hardware_destructive_interference_size)
+    InternedPathComponent::Shard {
+  // The keys point into the nodes.
+  folly::Synchronized<folly::F14FastMap<folly::StringPiece, Node*>> nodes;
+};
+
+InternedPathComponent::Shard* InternedPathComponent::getShards() {
+  // Interned names may be released by static destructors, so the table is
+  // never destroyed.
+  static folly::Indestructible<std::array<Shard, kShardCount>> shards;
+  return shards->data();
+}
+
+InternedPathComponent::InternedPathComponent(PathComponentPiece name) {
+  auto hash = std::hash<PathComponentPiece>{}(name);
+  auto nodes = getShards()[hash % kShardCount].nodes.wlock();
+  auto it = nodes->find(name.stringPiece());
+  if (it != nodes->end()) {
+    auto* node = it->second;
+    auto refCount = node->refCount.load(std::memory_order_relaxed);
+    while (refCount != 0) {
+      if (node->refCount.compare_exchange_weak(
+              refCount, refCount + 1, std::memory_order_relaxed)) {
+        node_ = node;
+        return;
+      }
+    }
+    // The node is being released; its key points into it.
+    nodes->erase(it);
+  }
+
+  node_ = new Node{name, hash};
+  nodes->emplace(node_->name.stringPiece(), node_);
+}
+
+InternedPathComponent::InternedPathComponent(
+    const InternedPathComponent& other) noexcept
+    : node_{other.node_} {
+  if (node_) {
+    node_->refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+InternedPathComponent& InternedPathComponent::operator=(
+    const InternedPathComponent& other) noexcept {
+  InternedPathComponent copy{other};
+  std::swap(node_, copy.node_);
+  return *this;
+}
+
+InternedPathComponent& InternedPathComponent::operator=(
+    InternedPathComponent&& other) noexcept {
+  InternedPathComponent moved{std::move(other)};
+  std::swap(node_, moved.node_);
+  return *this;
+}
+
+InternedPathComponent::~InternedPathComponent() {
+  if (node_) {
+    release(node_);
+  }
+}
+
+PathComponentPiece InternedPathComponent::piece() const {
+  return node_->name.piece();
+}
+
+size_t InternedPathComponent::hash() const noexcept {
+  return node_->hash;
+}
+
+size_t InternedPathComponent::getInternedCount() {
+  size_t count = 0;
+  auto* shards = getShards();
+  for (size_t i = 0; i < kShardCount; ++i) {
+    count += shards[i].nodes.rlock()->size();
+  }
+  return count;
+}
+
+void InternedPathComponent::release(Node* node) {
+  if (node->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  {
+    auto nodes = getShards()[node->hash % kShardCount].nodes.wlock();
+    auto it = nodes->find(node->name.stringPiece());
+    if (it != nodes->end() && it->second == node) {
+      nodes->erase(it);
+    }
+  }
+  delete node;
+}
+
+} // namespace facebook::eden
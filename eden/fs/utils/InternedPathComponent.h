@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <functional>
+#include <utility>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A PathComponent interned in a process-wide table.
+ *
+ * All the InternedPathComponents built from the same name share a single
+ * refcounted copy of it, so copying one never allocates. Equality is a
+ * pointer comparison, and the hash is computed once, when the name is first
+ * interned. The hash is the same as that of the equivalent PathComponent, so
+ * the two can be used for heterogeneous lookups.
+ *
+ * An InternedPathComponent converts to a PathComponentPiece and can be used as
+ * the key of a PathMap.
+ *
+ * It is safe to use from arbitrary threads. A name is removed from the table
+ * once the last InternedPathComponent referring to it is destroyed.
+ */
+class InternedPathComponent {
+ public:
+  using piece_type = PathComponentPiece;
+  using stored_type = PathComponent;
+
+  explicit InternedPathComponent(PathComponentPiece name);
+
+  InternedPathComponent(const InternedPathComponent& other) noexcept;
+  InternedPathComponent(InternedPathComponent&& other) noexcept
+      : node_{std::exchange(other.node_, nullptr)} {}
+  InternedPathComponent& operator=(const InternedPathComponent& other) noexcept;
+  InternedPathComponent& operator=(InternedPathComponent&& other) noexcept;
+  ~InternedPathComponent();
+
+  PathComponentPiece piece() const;
+
+  /* implicit */ operator PathComponentPiece() const {
+    return piece();
+  }
+
+  folly::StringPiece stringPiece() const {
+    return piece().stringPiece();
+  }
+
+  bool operator==(const InternedPathComponent& other) const {
+    return node_ == other.node_;
+  }
+  bool operator!=(const InternedPathComponent& other) const {
+    return node_ != other.node_;
+  }
+
+  size_t hash() const noexcept;
+
+  /** The number of distinct names currently interned. */
+  static size_t getInternedCount();
+
+ private:
+  struct Node;
+  struct Shard;
+
+  static constexpr size_t kShardCount = 16;
+
+  /** Returns the kShardCount shards of the table. */
+  static Shard* getShards();
+  static void release(Node* node);
+
+  Node* node_{nullptr};
+};
+
+} // namespace facebook::eden
+
+namespace std {
+template <>
+struct hash<facebook::eden::InternedPathComponent> {
+  size_t operator()(
+      const facebook::eden::InternedPathComponent& name) const noexcept {
+    return name.hash();
+  }
+};
+} // namespace std
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/IoUring.h"
+
+#include <folly/Exception.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+#include "eden/fs/eden-config.h"
+
+#ifdef EDEN_HAVE_LIBURING
+#include <liburing.h> // @manual
+#endif
+
+namespace facebook {
+namespace eden {
+
+#ifdef EDEN_HAVE_LIBURING
+
+struct IoUring::Ring {
+  io_uring ring;
+};
+
+IoUring::IoUring(unsigned queueDepth) : ring_{std::make_unique<Ring>()} {
+  auto ret = io_uring_queue_init(queueDepth, &ring_->ring, 0);
+  if (ret < 0) {
+    folly::throwSystemErrorExplicit(-ret, "io_uring_queue_init failed");
+  }
+  reaper_ = std::thread{[this] {
+    folly::setThreadName("IoUringReaper");
+    reapCompletions();
+  }};
+}
+
+IoUring::~IoUring() {
+  // A completion without a promise tells the reaper to exit once all other
+  // operations completed.
+  {
+    std::lock_guard<std::mutex> lock{submitMutex_};
+    auto* sqe = io_uring_get_sqe(&ring_->ring);
+    XCHECK(sqe) << "io_uring submission queue is full when stopping";
+    io_uring_prep_nop(sqe);
+    io_uring_sqe_set_data(sqe, nullptr);
+    submitLocked();
+  }
+  reaper_.join();
+  io_uring_queue_exit(&ring_->ring);
+}
+
+bool IoUring::isSupported() {
+  io_uring ring;
+  if (io_uring_queue_init(1, &ring, 0) < 0) {
+    return false;
+  }
+  io_uring_queue_exit(&ring);
+  return true;
+}
+
+template <typename Prepare>
+folly::SemiFuture<int> IoUring::submit(Prepare&& prepare) {
+  auto promise = std::make_unique<folly::Promise<int>>();
+  auto future = promise->getSemiFuture();
+
+  std::lock_guard<std::mutex> lock{submitMutex_};
+  // Every submission is flushed right away, so the queue only fills up if
+  // the kernel refused earlier submissions.
+  auto* sqe = io_uring_get_sqe(&ring_->ring);
+  if (!sqe) {
+    submitLocked();
+    sqe = io_uring_get_sqe(&ring_->ring);
+    if (!sqe) {
+      return folly::makeSemiFuture<int>(-EAGAIN);
+    }
+  }
+  prepare(sqe);
+  io_uring_sqe_set_data(sqe, promise.release());
+  ++pending_;
+  submitLocked();
+  return future;
+}
+
+void IoUring::submitLocked() {
+  while (true) {
+    auto ret = io_uring_submit(&ring_->ring);
+    if (ret >= 0) {
+      return;
+    }
+    if (ret == -EINTR || ret == -EAGAIN || ret == -EBUSY) {
+      // The kernel is short on resources to track more operations; let the
+      // reaper retire some.
+      std::this_thread::yield();
+      continue;
+    }
+    // The entries stay queued, and go with the next successful submission.
+    XLOG(ERR) << "io_uring_submit failed: " << folly::errnoStr(-ret);
+    return;
+  }
+}
+
+void IoUring::reapCompletions() noexcept {
+  bool stopping = false;
+  while (!stopping || pending_.load(std::memory_order_acquire) != 0) {
+    io_uring_cqe* cqe;
+    auto ret = io_uring_wait_cqe(&ring_->ring, &cqe);
+    if (ret < 0) {
+      if (ret == -EINTR) {
+        continue;
+      }
+      XLOG(FATAL) << "io_uring_wait_cqe failed: " << folly::errnoStr(-ret);
+    }
+
+    auto* promise =
+        static_cast<folly::Promise<int>*>(io_uring_cqe_get_data(cqe));
+    auto result = cqe->res;
+    io_uring_cqe_seen(&ring_->ring, cqe);
+
+    if (!promise) {
+      stopping = true;
+      continue;
+    }
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+    std::unique_ptr<folly::Promise<int>>{promise}->setValue(result);
+  }
+}
+
+folly::SemiFuture<int>
+IoUring::pread(int fd, void* buf, size_t n, off_t offset) {
+  return submit([&](io_uring_sqe* sqe) {
+    io_uring_prep_read(sqe, fd, buf, n, offset);
+  });
+}
+
+folly::SemiFuture<int>
+IoUring::pwritev(int fd, const iovec* iov, int iovcnt, off_t offset) {
+  return submit([&](io_uring_sqe* sqe) {
+    io_uring_prep_writev(sqe, fd, iov, iovcnt, offset);
+  });
+}
+
+folly::SemiFuture<int> IoUring::fsync(int fd, bool datasync) {
+  return submit([&](io_uring_sqe* sqe) {
+    io_uring_prep_fsync(sqe, fd, datasync ? IORING_FSYNC_DATASYNC : 0);
+  });
+}
+
+#else // !EDEN_HAVE_LIBURING
+
+struct IoUring::Ring {};
+
+IoUring::IoUring(unsigned /* queueDepth */) {
+  folly::throwSystemErrorExplicit(
+      ENOSYS, "EdenFS was built without io_uring support");
+}
+
+IoUring::~IoUring() = default;
+
+bool IoUring::isSupported() {
+  return false;
+}
+
+folly::SemiFuture<int> IoUring::pread(int, void*, size_t, off_t) {
+  return folly::makeSemiFuture<int>(-ENOSYS);
+}
+
+folly::SemiFuture<int> IoUring::pwritev(int, const iovec*, int, off_t) {
+  return folly::makeSemiFuture<int>(-ENOSYS);
+}
+
+folly::SemiFuture<int> IoUring::fsync(int, bool) {
+  return folly::makeSemiFuture<int>(-ENOSYS);
+}
+
+#endif // EDEN_HAVE_LIBURING
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/futures/Future.h>
+#include <folly/portability/SysUio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Performs file I/O through an io_uring, so that the threads issuing it do not
+ * wait on the disk.
+ *
+ * Each operation's future completes with the result of the equivalent system
+ * call: a non-negative value on success, or a negated errno value on failure.
+ * Buffers passed to an operation must stay valid until its future completes.
+ *
+ * Futures are completed by a single thread dedicated to reaping completions,
+ * so continuations that run inline on it must not block.
+ *
+ * io_uring is only available on Linux, when EdenFS is built with liburing.
+ */
+class IoUring {
+ public:
+  /**
+   * Set up an io_uring with room for `queueDepth` submissions.
+   *
+   * Throws std::system_error if io_uring is not supported by this build or by
+   * the running kernel.
+   */
+  explicit IoUring(unsigned queueDepth);
+
+  /**
+   * Waits for all submitted operations to complete.
+   */
+  ~IoUring();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  static bool isSupported();
+
+  FOLLY_NODISCARD folly::SemiFuture<int>
+  pread(int fd, void* buf, size_t n, off_t offset);
+
+  /**
+   * The iovec array, like the buffers it points to, must stay valid until the
+   * returned future completes.
+   */
+  FOLLY_NODISCARD folly::SemiFuture<int>
+  pwritev(int fd, const iovec* iov, int iovcnt, off_t offset);
+
+  /**
+   * Like fdatasync(2) if `datasync` is set, and fsync(2) otherwise.
+   */
+  FOLLY_NODISCARD folly::SemiFuture<int> fsync(int fd, bool datasync);
+
+ private:
+  struct Ring;
+
+  template <typename Prepare>
+  folly::SemiFuture<int> submit(Prepare&& prepare);
+  void submitLocked();
+
+  void reapCompletions() noexcept;
+
+  std::unique_ptr<Ring> ring_;
+
+  /// Serializes access to the submission queue.
+  std::mutex submitMutex_;
+
+  /// Number of submitted operations that have not completed.
+  std::atomic<size_t> pending_{0};
+
+  std::thread reaper_;
+};
+
+} // namespace eden
+} // namespace facebook
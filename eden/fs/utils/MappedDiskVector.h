@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <algorithm>
 #include <type_traits>
 
 #include <eden/fs/utils/Bug.h>
@@ -16,6 +18,7 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/logging/xlog.h>
 
 namespace facebook {
@@ -73,6 +76,16 @@ template <typename T, typename... OldVersions>
 struct Migrator;
 } // namespace detail
 
+/**
+ * How the records of a MappedDiskVector are expected to be accessed, passed to
+ * madvise() for its mapping.
+ */
+enum class MappedDiskVectorAccess {
+  Normal,
+  Random,
+  Sequential,
+};
+
 /**
  * MappedDiskVector is roughly analogous to std::vector, except it's backed by
  * a persistent memory-mapped file.
@@ -244,6 +257,8 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    access_ = other.access_;
+    useHugePages_ = other.useHugePages_;
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
@@ -261,6 +276,8 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    access_ = other.access_;
+    useHugePages_ = other.useHugePages_;
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
@@ -283,6 +300,44 @@ class MappedDiskVector {
     return (mapSizeInBytes_ - sizeof(Header)) / sizeof(T);
   }
 
+  /**
+   * Tells the kernel how the records will be accessed and whether to back the
+   * mapping with transparent huge pages where the kernel and filesystem
+   * support it. The advice is reapplied whenever growing remaps the file.
+   *
+   * This is only a hint: failures are ignored.
+   */
+  void advise(MappedDiskVectorAccess access, bool useHugePages = false) {
+    access_ = access;
+    useHugePages_ = useHugePages;
+    applyAdvice();
+  }
+
+  /**
+   * Starts writing the modified records back to disk without waiting for the
+   * writes to complete, so the kernel doesn't have to write them back later
+   * at an unpredictable time.
+   *
+   * Safe to call concurrently with readers and with modifications of existing
+   * records, but not with emplace_back, which may remap the file.
+   */
+  void flushAsync() const {
+#ifdef __linux__
+    // msync(MS_ASYNC) is a no-op on Linux, sync_file_range starts the
+    // writeback.
+    if (sync_file_range(
+            file_.fd(), 0, mapSizeInBytes_, SYNC_FILE_RANGE_WRITE) == -1) {
+      XLOG(WARN) << "sync_file_range failed on MappedDiskVector: "
+                 << folly::errnoStr(errno);
+    }
+#else
+    if (msync(map_, mapSizeInBytes_, MS_ASYNC) == -1) {
+      XLOG(WARN) << "msync failed on MappedDiskVector: "
+                 << folly::errnoStr(errno);
+    }
+#endif
+  }
+
   T& operator[](size_t index) {
     return begin_[index];
   }
@@ -299,8 +354,11 @@ class MappedDiskVector {
           "Growth must expand the file more than a single record");
 
       size_t oldSize = size();
-      size_t newFileSize =
-          mapSizeInBytes_ + GROWTH_IN_PAGES * detail::kPageSize;
+      // Grow geometrically so that a table growing to n records is only
+      // remapped O(log n) times.
+      size_t newFileSize = detail::roundUpToNonzeroPageSize(
+          mapSizeInBytes_ +
+          std::max(GROWTH_IN_PAGES * detail::kPageSize, mapSizeInBytes_ / 2));
 
       // Always keep the file size a whole number of pages.
       XCHECK_EQ(0ul, newFileSize % detail::kPageSize);
@@ -336,6 +394,7 @@ class MappedDiskVector {
 
       begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
       end_ = begin_ + oldSize;
+      applyAdvice();
     }
 
     T* out = end_;
@@ -475,6 +534,31 @@ class MappedDiskVector {
         static_cast<char*>(map_) + mapSizeInBytes_);
   }
 
+  void applyAdvice() {
+    int advice = MADV_NORMAL;
+    switch (access_) {
+      case MappedDiskVectorAccess::Normal:
+        advice = MADV_NORMAL;
+        break;
+      case MappedDiskVectorAccess::Random:
+        advice = MADV_RANDOM;
+        break;
+      case MappedDiskVectorAccess::Sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    }
+    if (madvise(map_, mapSizeInBytes_, advice) == -1) {
+      XLOG(DBG2) << "madvise failed on MappedDiskVector: "
+                 << folly::errnoStr(errno);
+    }
+#ifdef MADV_HUGEPAGE
+    if (useHugePages_ && madvise(map_, mapSizeInBytes_, MADV_HUGEPAGE) == -1) {
+      XLOG(DBG2) << "huge pages are not supported for MappedDiskVector: "
+                 << folly::errnoStr(errno);
+    }
+#endif
+  }
+
   bool hasRoom(size_t amount) const {
     // Technically, the expression (end_ + amount) is constructing a pointer
     // past the end of the "object" (mmap) and is thus UB.  But hopefully no
@@ -518,6 +602,9 @@ class MappedDiskVector {
   void* map_{nullptr};
   size_t mapSizeInBytes_{0}; // must be nonzero, multiple of page size
 
+  MappedDiskVectorAccess access_{MappedDiskVectorAccess::Normal};
+  bool useHugePages_{false};
+
   folly::File file_;
 
   template <typename T_, typename... OldVersions>
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/MemoryArena.h"
+
+#include <folly/Conv.h>
+#include <folly/Portability.h>
+#include <folly/logging/xlog.h>
+#include <folly/memory/Malloc.h>
+#include <cstdlib>
+#include <new>
+
+#if defined(FOLLY_USE_JEMALLOC) && !FOLLY_SANITIZE
+#include <jemalloc/jemalloc.h> // @manual
+#define EDEN_HAVE_JEMALLOC_ARENAS 1
+#endif
+
+namespace facebook::eden {
+
+namespace {
+
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+template <typename T>
+std::optional<T> mallctlRead(const std::string& name) {
+  T value;
+  size_t size = sizeof(value);
+  if (mallctl(name.c_str(), &value, &size, nullptr, 0) != 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/**
+ * The MIB of "thread.arena", looked up once since Scopes are created on hot
+ * paths.
+ */
+struct ThreadArenaMib {
+  ThreadArenaMib() {
+    if (mallctlnametomib("thread.arena", mib, &length) != 0) {
+      length = 0;
+    }
+  }
+
+  std::optional<unsigned> exchange(unsigned arena) {
+    if (length == 0) {
+      return std::nullopt;
+    }
+    unsigned previous;
+    size_t size = sizeof(previous);
+    if (mallctlbymib(mib, length, &previous, &size, &arena, sizeof(arena)) !=
+        0) {
+      return std::nullopt;
+    }
+    return previous;
+  }
+
+  size_t mib[2];
+  size_t length{2};
+};
+
+ThreadArenaMib& getThreadArenaMib() {
+  static ThreadArenaMib mib;
+  return mib;
+}
+#endif
+
+} // namespace
+
+MemoryArena::MemoryArena(folly::StringPiece name) : name_{name.str()} {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (!folly::usingJEMalloc()) {
+    return;
+  }
+  auto index = mallctlRead<unsigned>("arenas.create");
+  if (!index) {
+    XLOG(WARN) << "unable to create a jemalloc arena for " << name_;
+    return;
+  }
+  arenaIndex_ = *index;
+  flags_ = MALLOCX_ARENA(*index) | MALLOCX_TCACHE_NONE;
+#endif
+}
+
+// The arenas are never destroyed, so that memory allocated from them can be
+// freed at any point of the process's shutdown.
+
+MemoryArena& MemoryArena::inodes() {
+  static auto* arena = new MemoryArena{"inodes"};
+  return *arena;
+}
+
+MemoryArena& MemoryArena::objectCache() {
+  static auto* arena = new MemoryArena{"object_cache"};
+  return *arena;
+}
+
+MemoryArena& MemoryArena::journal() {
+  static auto* arena = new MemoryArena{"journal"};
+  return *arena;
+}
+
+const std::vector<MemoryArena*>& MemoryArena::getAll() {
+  static auto* all =
+      new std::vector<MemoryArena*>{&inodes(), &objectCache(), &journal()};
+  return *all;
+}
+
+void* MemoryArena::allocate(size_t size) {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (arenaIndex_) {
+    if (auto* ptr = mallocx(size, flags_)) {
+      return ptr;
+    }
+    throw std::bad_alloc();
+  }
+#endif
+  if (auto* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void MemoryArena::deallocate(void* ptr, size_t size) noexcept {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (arenaIndex_) {
+    sdallocx(ptr, size, flags_);
+    return;
+  }
+#endif
+  (void)size;
+  std::free(ptr);
+}
+
+void MemoryArena::purge() {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (arenaIndex_) {
+    auto name = folly::to<std::string>("arena.", *arenaIndex_, ".purge");
+    if (mallctl(name.c_str(), nullptr, nullptr, nullptr, 0) != 0) {
+      XLOG(DBG2) << "unable to purge the " << name_ << " memory arena";
+    }
+  }
+#endif
+}
+
+std::optional<MemoryArena::Stats> MemoryArena::getStats() const {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (!arenaIndex_) {
+    return std::nullopt;
+  }
+  // jemalloc only refreshes its statistics when the epoch is advanced.
+  uint64_t epoch = 1;
+  size_t epochSize = sizeof(epoch);
+  mallctl("epoch", &epoch, &epochSize, &epoch, epochSize);
+
+  auto prefix = folly::to<std::string>("stats.arenas.", *arenaIndex_, ".");
+  auto pageSize = mallctlRead<size_t>("arenas.page");
+  auto active = mallctlRead<size_t>(prefix + "pactive");
+  auto dirty = mallctlRead<size_t>(prefix + "pdirty");
+  auto mapped = mallctlRead<size_t>(prefix + "mapped");
+  if (!pageSize || !active || !dirty || !mapped) {
+    return std::nullopt;
+  }
+  return Stats{*active * *pageSize, *dirty * *pageSize, *mapped};
+#else
+  return std::nullopt;
+#endif
+}
+
+MemoryArena::Scope::Scope(MemoryArena& arena) {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (arena.arenaIndex_) {
+    previousArena_ = getThreadArenaMib().exchange(*arena.arenaIndex_);
+  }
+#else
+  (void)arena;
+#endif
+}
+
+MemoryArena::Scope::~Scope() {
+#ifdef EDEN_HAVE_JEMALLOC_ARENAS
+  if (previousArena_) {
+    getThreadArenaMib().exchange(*previousArena_);
+  }
+#endif
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A jemalloc arena dedicated to the long-lived allocations of one subsystem,
+ * such as loaded inodes, cached trees or journal deltas.
+ *
+ * Keeping them apart from the short-lived garbage of requests means that
+ * once a large checkout's working set is freed, its pages are empty and can
+ * be returned to the system, instead of being pinned by a few survivors
+ * from other subsystems.
+ *
+ * When the process does not use jemalloc, allocations go to malloc and the
+ * other operations do nothing.
+ */
+class MemoryArena {
+ public:
+  /**
+   * Loaded inodes.
+   */
+  static MemoryArena& inodes();
+
+  /**
+   * Trees built to be kept in the in-memory object caches.
+   */
+  static MemoryArena& objectCache();
+
+  /**
+   * Journal deltas and the paths they refer to.
+   */
+  static MemoryArena& journal();
+
+  /**
+   * All of the arenas above.
+   */
+  static const std::vector<MemoryArena*>& getAll();
+
+  MemoryArena(const MemoryArena&) = delete;
+  MemoryArena& operator=(const MemoryArena&) = delete;
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+  /**
+   * Allocate from this arena, bypassing the thread caches so that no memory
+   * of other arenas is handed out.
+   */
+  void* allocate(size_t size);
+  void deallocate(void* ptr, size_t size) noexcept;
+
+  /**
+   * Return the unused dirty pages of this arena to the system now, rather
+   * than as jemalloc's decay lets them age out.
+   */
+  void purge();
+
+  struct Stats {
+    /// Bytes of the pages in use.
+    size_t activeBytes = 0;
+    /// Bytes of the unused pages not yet returned to the system.
+    size_t dirtyBytes = 0;
+    /// Bytes of the address space mapped by this arena.
+    size_t mappedBytes = 0;
+  };
+
+  /**
+   * Returns std::nullopt if this is not a jemalloc arena, or jemalloc was
+   * built without statistics.
+   */
+  std::optional<Stats> getStats() const;
+
+  /**
+   * While a Scope exists, the allocations of the thread that created it come
+   * from the given arena. This suits building object graphs, such as a tree
+   * and its entries, whose allocations are spread over many functions.
+   *
+   * Unlike allocate(), this keeps the thread cache, so a few of the
+   * allocations can still be served with memory cached from the thread's
+   * previous arena.
+   */
+  class Scope {
+   public:
+    explicit Scope(MemoryArena& arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    std::optional<unsigned> previousArena_;
+  };
+
+ private:
+  explicit MemoryArena(folly::StringPiece name);
+
+  const std::string name_;
+  /**
+   * The index of the jemalloc arena, if one could be created.
+   */
+  std::optional<unsigned> arenaIndex_;
+  int flags_{0};
+};
+
+} // namespace facebook::eden
@@ -11,6 +11,7 @@
 #include <boost/filesystem/path.hpp>
 
 #include <folly/Exception.h>
+#include <folly/Portability.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/Stdlib.h>
 #include <optional>
@@ -24,12 +25,147 @@
 #include <mach-o/dyld.h> // @manual
 #endif
 
+#if FOLLY_SSE >= 2
+#include <emmintrin.h>
+#elif FOLLY_NEON && FOLLY_AARCH64
+#include <arm_neon.h>
+#endif
+
 using folly::Expected;
 using folly::StringPiece;
 
 namespace facebook {
 namespace eden {
 
+namespace {
+
+constexpr bool isPlainPathChar(char c) {
+  return c != '\0' && !detail::isBitSet(c, 7) && !detail::isDirSeparator(c);
+}
+
+constexpr char foldAsciiCase(char c) {
+  return 'A' <= c && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+#if FOLLY_SSE >= 2
+
+/**
+ * Returns whether all 16 bytes at `p` are plain path characters.
+ *
+ * Comparisons set matching bytes to 0xff, so OR-ing them with the characters
+ * themselves leaves the top bit of every byte that isn't plain set.
+ */
+bool arePlainPathChars16(const char* p) {
+  auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  auto bad = _mm_or_si128(
+      chars,
+      _mm_or_si128(
+          _mm_cmpeq_epi8(chars, _mm_setzero_si128()),
+          _mm_cmpeq_epi8(chars, _mm_set1_epi8(kDirSeparator))));
+  if constexpr (folly::kIsWindows) {
+    bad = _mm_or_si128(
+        bad, _mm_cmpeq_epi8(chars, _mm_set1_epi8(kWinDirSeparator)));
+  }
+  return _mm_movemask_epi8(bad) == 0;
+}
+
+/**
+ * Returns `chars` with the upper case ASCII letters made lower case. Bytes at
+ * or above 0x80 compare as negative, so they are never taken for letters.
+ */
+__m128i foldAsciiCase16(__m128i chars) {
+  auto isUpper = _mm_and_si128(
+      _mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)),
+      _mm_cmplt_epi8(chars, _mm_set1_epi8('Z' + 1)));
+  return _mm_or_si128(chars, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+}
+
+bool equalsIgnoringAsciiCase16(const char* a, const char* b) {
+  auto foldedA =
+      foldAsciiCase16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+  auto foldedB =
+      foldAsciiCase16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(foldedA, foldedB)) == 0xffff;
+}
+
+#define EDEN_HAVE_SIMD_PATH_CHARS 1
+
+#elif FOLLY_NEON && FOLLY_AARCH64
+
+bool arePlainPathChars16(const char* p) {
+  auto chars = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+  auto bad = vorrq_u8(
+      chars,
+      vorrq_u8(
+          vceqq_u8(chars, vdupq_n_u8(0)),
+          vceqq_u8(chars, vdupq_n_u8(kDirSeparator))));
+  if constexpr (folly::kIsWindows) {
+    bad = vorrq_u8(bad, vceqq_u8(chars, vdupq_n_u8(kWinDirSeparator)));
+  }
+  return vmaxvq_u8(bad) < 0x80;
+}
+
+uint8x16_t foldAsciiCase16(uint8x16_t chars) {
+  auto isUpper = vcltq_u8(vsubq_u8(chars, vdupq_n_u8('A')), vdupq_n_u8(26));
+  return vorrq_u8(chars, vandq_u8(isUpper, vdupq_n_u8(0x20)));
+}
+
+bool equalsIgnoringAsciiCase16(const char* a, const char* b) {
+  auto foldedA = foldAsciiCase16(vld1q_u8(reinterpret_cast<const uint8_t*>(a)));
+  auto foldedB = foldAsciiCase16(vld1q_u8(reinterpret_cast<const uint8_t*>(b)));
+  return vminvq_u8(vceqq_u8(foldedA, foldedB)) == 0xff;
+}
+
+#define EDEN_HAVE_SIMD_PATH_CHARS 1
+
+#endif
+
+} // namespace
+
+namespace detail {
+
+bool hasOnlyPlainPathChars(StringPiece val) noexcept {
+  auto it = val.begin();
+  auto end = val.end();
+#ifdef EDEN_HAVE_SIMD_PATH_CHARS
+  for (; end - it >= 16; it += 16) {
+    if (!arePlainPathChars16(it)) {
+      return false;
+    }
+  }
+#endif
+  for (; it != end; ++it) {
+    if (!isPlainPathChar(*it)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+bool equalsIgnoringAsciiCase(StringPiece a, StringPiece b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  auto itA = a.begin();
+  auto itB = b.begin();
+  auto end = a.end();
+#ifdef EDEN_HAVE_SIMD_PATH_CHARS
+  for (; end - itA >= 16; itA += 16, itB += 16) {
+    if (!equalsIgnoringAsciiCase16(itA, itB)) {
+      return false;
+    }
+  }
+#endif
+  for (; itA != end; ++itA, ++itB) {
+    if (foldAsciiCase(*itA) != foldAsciiCase(*itB)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 StringPiece dirname(StringPiece path) {
   auto dirSeparator = detail::rfindPathSeparator(path);
 
@@ -390,8 +526,7 @@ CompareResult comparePathComponent(
     PathComponentPiece right,
     CaseSensitivity caseSensitivity) {
   if (caseSensitivity == CaseSensitivity::Insensitive) {
-    if (left.stringPiece().equals(
-            right.stringPiece(), folly::AsciiCaseInsensitive())) {
+    if (equalsIgnoringAsciiCase(left.stringPiece(), right.stringPiece())) {
       return CompareResult::EQUAL;
     }
   } else {
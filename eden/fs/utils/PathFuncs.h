@@ -17,6 +17,7 @@
 #include <folly/FBVector.h>
 #include <folly/Format.h>
 #include <folly/String.h>
+#include <folly/Traits.h>
 #include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
 #include <iterator>
@@ -460,9 +461,34 @@ class PathBase :
 #endif
 };
 
+namespace detail {
+/**
+ * Returns whether `val` consists of ASCII characters other than nul and
+ * directory separators only, checking many bytes at a time where the CPU
+ * allows it. Such names are valid path components unless they are empty, .
+ * or ..
+ */
+bool hasOnlyPlainPathChars(folly::StringPiece val) noexcept;
+} // namespace detail
+
+/**
+ * Returns whether `a` and `b` are equal when ASCII letters are folded to the
+ * same case, like folly::AsciiCaseInsensitive, but many bytes at a time where
+ * the CPU allows it.
+ */
+bool equalsIgnoringAsciiCase(folly::StringPiece a, folly::StringPiece b);
+
 /// Asserts that val is a well formed path component
 struct PathComponentSanityCheck {
   constexpr void operator()(folly::StringPiece val) const {
+    // Almost every name is plain ASCII, which can be checked much faster than
+    // one byte at a time, but only outside of constant evaluation.
+    if (!folly::is_constant_evaluated_or(true) &&
+        detail::hasOnlyPlainPathChars(val)) {
+      checkSpecialNames(val);
+      return;
+    }
+
     for (auto c : val) {
       if (isDirSeparator(c)) {
         throw PathComponentContainsDirectorySeparator(folly::to<std::string>(
@@ -479,6 +505,17 @@ struct PathComponentSanityCheck {
       }
     }
 
+    checkSpecialNames(val);
+
+    if (!isValidUtf8(val)) {
+      throw PathComponentNotUtf8(folly::to<std::string>(
+          "attempt to construct a PathComponent from non valid UTF8 data: ",
+          val));
+    }
+  }
+
+ private:
+  static constexpr void checkSpecialNames(folly::StringPiece val) {
     switch (val.size()) {
       case 0:
         throw PathComponentValidationError(
@@ -494,12 +531,6 @@ struct PathComponentSanityCheck {
         }
         break;
     }
-
-    if (!isValidUtf8(val)) {
-      throw PathComponentNotUtf8(folly::to<std::string>(
-          "attempt to construct a PathComponent from non valid UTF8 data: ",
-          val));
-    }
   }
 };
 
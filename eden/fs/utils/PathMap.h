@@ -8,9 +8,13 @@
 #pragma once
 #include <folly/FBVector.h>
 #include <folly/Portability.h>
+#include <folly/small_vector.h>
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -24,20 +28,27 @@ namespace eden {
  * This is similar to std::map but has a couple of different properties:
  * - lookups can be made using the Piece (non-stored) variant of the key
  *   type and won't require allocation just for the lookup.
- * - The storage is a vector maintained in sorted order using a binary
- *   search (std::lower_bound). Out-of-order inserts require moving
- *   the guts of the vector around to make space and are therefore slower
- *   than the equivalent std::map.  If bulk insert performance is critical,
- *   it is better to pre-sort the data to be inserted.
- * - Since insert and erase operations move the vector contents around,
+ * - The storage is a sequence of vectors, or chunks, each maintained in
+ *   sorted order, the last key of a chunk sorting before the first key of the
+ *   next one. Lookups binary search the chunks and then the chunk that may
+ *   hold the key. Maps of up to kMaxChunkSize entries, which covers nearly all
+ *   directories, are a single sorted vector stored inline. Larger maps split
+ *   full chunks in two, so an out-of-order insert only moves the entries of
+ *   one chunk around instead of the whole map, which keeps populating a
+ *   directory with hundreds of thousands of entries from being quadratic.
+ * - Since insert and erase operations move the chunk contents around,
  *   those operations invalidate iterators.
+ * - Iterators are random access, but moving one by more than one entry or
+ *   computing the distance between two of them is linear in the number of
+ *   chunks.
  */
 template <typename Value, typename Key = PathComponent>
-class PathMap : private folly::fbvector<std::pair<Key, Value>> {
+class PathMap {
   using Pair = std::pair<Key, Value>;
-  using Vector = folly::fbvector<Pair>;
+  using Chunk = folly::fbvector<Pair>;
+  using Chunks = folly::small_vector<Chunk, 1>;
   using Piece = typename Key::piece_type;
-  using Allocator = typename Vector::allocator_type;
+  using Allocator = typename Chunk::allocator_type;
 
   // Comparator that knows how compare Stored and Piece in the vector.
   struct Compare {
@@ -72,28 +83,277 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
   };
 
+  /** Position of an entry: the index of its chunk and its offset in it.
+   * The end position is {chunks.size(), 0}.
+   */
+  template <bool IsConst>
+  class Iterator {
+    using ChunksPtr = std::conditional_t<IsConst, const Chunks*, Chunks*>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Pair;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const Pair*, Pair*>;
+    using reference = std::conditional_t<IsConst, const Pair&, Pair&>;
+
+    Iterator() = default;
+
+    /* implicit */ Iterator(const Iterator<false>& other)
+        : chunks_{other.chunks_},
+          chunk_{other.chunk_},
+          offset_{other.offset_} {}
+
+    reference operator*() const {
+      return (*chunks_)[chunk_][offset_];
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    Iterator& operator++() {
+      if (++offset_ == (*chunks_)[chunk_].size()) {
+        ++chunk_;
+        offset_ = 0;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    Iterator& operator--() {
+      if (offset_ == 0) {
+        --chunk_;
+        offset_ = (*chunks_)[chunk_].size();
+      }
+      --offset_;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      auto copy = *this;
+      --*this;
+      return copy;
+    }
+
+    Iterator& operator+=(difference_type n) {
+      if (n < 0) {
+        return *this -= -n;
+      }
+      auto remaining = static_cast<size_t>(n);
+      while (remaining > 0) {
+        auto available = (*chunks_)[chunk_].size() - offset_;
+        if (remaining < available) {
+          offset_ += remaining;
+          break;
+        }
+        remaining -= available;
+        ++chunk_;
+        offset_ = 0;
+      }
+      return *this;
+    }
+
+    Iterator& operator-=(difference_type n) {
+      if (n < 0) {
+        return *this += -n;
+      }
+      auto remaining = static_cast<size_t>(n);
+      while (remaining > offset_) {
+        remaining -= offset_;
+        --chunk_;
+        offset_ = (*chunks_)[chunk_].size();
+      }
+      offset_ -= remaining;
+      return *this;
+    }
+
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+
+    template <bool OtherConst>
+    difference_type operator-(const Iterator<OtherConst>& other) const {
+      return static_cast<difference_type>(index()) -
+          static_cast<difference_type>(other.index());
+    }
+
+    template <bool OtherConst>
+    bool operator==(const Iterator<OtherConst>& other) const {
+      return chunk_ == other.chunk_ && offset_ == other.offset_;
+    }
+
+    template <bool OtherConst>
+    bool operator!=(const Iterator<OtherConst>& other) const {
+      return !(*this == other);
+    }
+
+    template <bool OtherConst>
+    bool operator<(const Iterator<OtherConst>& other) const {
+      return std::tie(chunk_, offset_) < std::tie(other.chunk_, other.offset_);
+    }
+
+    template <bool OtherConst>
+    bool operator>(const Iterator<OtherConst>& other) const {
+      return other < *this;
+    }
+
+    template <bool OtherConst>
+    bool operator<=(const Iterator<OtherConst>& other) const {
+      return !(other < *this);
+    }
+
+    template <bool OtherConst>
+    bool operator>=(const Iterator<OtherConst>& other) const {
+      return !(*this < other);
+    }
+
+   private:
+    friend class PathMap;
+    friend class Iterator<!IsConst>;
+
+    Iterator(ChunksPtr chunks, size_t chunk, size_t offset)
+        : chunks_{chunks}, chunk_{chunk}, offset_{offset} {}
+
+    /** The position of the entry in the whole map. */
+    size_t index() const {
+      size_t index = offset_;
+      for (size_t i = 0; i < chunk_; ++i) {
+        index += (*chunks_)[i].size();
+      }
+      return index;
+    }
+
+    ChunksPtr chunks_{nullptr};
+    size_t chunk_{0};
+    size_t offset_{0};
+  };
+
   // Hold an instance of the comparator.  It doesn't actually
   // occupy any space.
   Compare compare_;
   CaseSensitivity caseSensitive_{kPathMapDefaultCaseSensitive};
 
+  /** Find an entry whose key matches `key` ignoring ASCII case.
+   * Returns self.end() if there is none. If several keys match, this returns
+   * the first one in sorted order.
+   */
+  template <typename Self>
+  static auto findInsensitive(Self& self, Piece key) -> decltype(self.end()) {
+    if constexpr (std::is_same_v<Piece, PathComponentPiece>) {
+      return findInsensitiveSorted(
+          self.begin(), self.end(), self.end(), key.stringPiece(), 0);
+    } else {
+      // Composed paths may not sort bytewise, so just scan them.
+      for (auto iter = self.begin(); iter != self.end(); ++iter) {
+        if (equalsIgnoringAsciiCase(
+                key.stringPiece(), iter->first.stringPiece())) {
+          return iter;
+        }
+      }
+      return self.end();
+    }
+  }
+
+  /** Case insensitive search of the bytewise sorted range [first, last).
+   *
+   * Every key in the range starts with the same `pos` bytes, which match the
+   * beginning of `key` ignoring case. Since keys with a common prefix are
+   * contiguous, the range is narrowed one byte of `key` at a time with binary
+   * searches, first to the keys with the upper case form of a letter and then
+   * to those with the lower case one. This keeps lookups in large case
+   * insensitive directories logarithmic instead of scanning every entry.
+   */
+  template <typename Iterator>
+  static Iterator findInsensitiveSorted(
+      Iterator first,
+      Iterator last,
+      Iterator notFound,
+      folly::StringPiece key,
+      size_t pos) {
+    while (first != last) {
+      if (pos == key.size()) {
+        // A key ending here sorts before the longer keys in the range.
+        return first->first.stringPiece().size() == pos ? first : notFound;
+      }
+      auto c = static_cast<unsigned char>(key[pos]);
+      if (c >= 'a' && c <= 'z') {
+        c = static_cast<unsigned char>(c - 'a' + 'A');
+      }
+      if (c >= 'A' && c <= 'Z') {
+        auto [upperFirst, upperLast] = equalRangeAt(first, last, pos, c);
+        auto found = findInsensitiveSorted(
+            upperFirst, upperLast, notFound, key, pos + 1);
+        if (found != notFound) {
+          return found;
+        }
+        // Lower case letters sort after upper case ones.
+        first = upperLast;
+        c = static_cast<unsigned char>(c - 'A' + 'a');
+      }
+      std::tie(first, last) = equalRangeAt(first, last, pos, c);
+      ++pos;
+    }
+    return notFound;
+  }
+
+  /** Return the subrange of [first, last) whose keys have byte `c` at `pos`.
+   * All keys in the range must share their first `pos` bytes.
+   */
+  template <typename Iterator>
+  static std::pair<Iterator, Iterator>
+  equalRangeAt(Iterator first, Iterator last, size_t pos, unsigned char c) {
+    // Keys that end before `pos` sort first.
+    auto byteAt = [pos](const Pair& entry) -> int {
+      auto name = entry.first.stringPiece();
+      return name.size() > pos ? static_cast<unsigned char>(name[pos]) : -1;
+    };
+    auto rangeFirst = std::partition_point(
+        first, last, [&](const Pair& entry) { return byteAt(entry) < c; });
+    auto rangeLast = std::partition_point(rangeFirst, last, [&](const Pair& e) {
+      return byteAt(e) == c;
+    });
+    return {rangeFirst, rangeLast};
+  }
+
  public:
   // Various type aliases to satisfy container concepts.
   using key_type = Key;
   using mapped_type = Value;
-  using value_type = typename Vector::value_type;
+  using value_type = Pair;
   using key_compare = Compare;
   using allocator_type = Allocator;
   using reference = Pair&;
   using const_reference = const Pair&;
-  using iterator = typename Vector::iterator;
-  using const_iterator = typename Vector::const_iterator;
-  using size_type = typename Vector::size_type;
-  using difference_type = typename Vector::difference_type;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
   using pointer = Pair*;
   using const_pointer = const Pair*;
-  using reverse_iterator = typename Vector::reverse_iterator;
-  using const_reverse_iterator = typename Vector::const_reverse_iterator;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /** Maximum number of entries of a chunk, above which it is split in two.
+   */
+  static constexpr size_t kMaxChunkSize = 512;
 
   // Construct empty.
   PathMap(CaseSensitivity caseSensitive) : caseSensitive_(caseSensitive) {}
@@ -109,60 +369,104 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       InputIterator last,
       CaseSensitivity caseSensitive)
       : caseSensitive_(caseSensitive) {
-    // The std::distance call is O(1) if the iterators are random-access, but
-    // O(n) otherwise.  We're fine with the O(n) on the basis that if n is large
-    // enough to matter, the cost of iterating will be dwarfed by the cost
-    // of growing the storage several times during population.
-    this->reserve(std::distance(first, last));
     for (; first != last; ++first) {
       insert(*first);
     }
   }
 
-  // Inherit the underlying vector copy/assignment.
   PathMap(const PathMap& other)
-      : Vector(other), caseSensitive_(other.caseSensitive_) {}
+      : chunks_(other.chunks_),
+        size_(other.size_),
+        caseSensitive_(other.caseSensitive_) {}
   PathMap& operator=(const PathMap& other) {
     PathMap(other).swap(*this);
     return *this;
   }
 
-  // inherit Move construction.
   PathMap(PathMap&& other) noexcept
-      : Vector(std::move(other)), caseSensitive_(other.caseSensitive_) {}
+      : chunks_(std::move(other.chunks_)),
+        size_(std::exchange(other.size_, 0)),
+        caseSensitive_(other.caseSensitive_) {
+    other.chunks_.clear();
+  }
   PathMap& operator=(PathMap&& other) {
     other.swap(*this);
     return *this;
   }
 
-  // inherit these methods from the underlying vector.
-  using Vector::begin;
-  using Vector::cbegin;
-  using Vector::cend;
-  using Vector::clear;
-  using Vector::crbegin;
-  using Vector::crend;
-  using Vector::empty;
-  using Vector::end;
-  using Vector::erase;
-  using Vector::max_size;
-  using Vector::rbegin;
-  using Vector::rend;
-  using Vector::size;
+  iterator begin() {
+    return normalized(iterator{&chunks_, 0, 0});
+  }
+  const_iterator begin() const {
+    return normalized(const_iterator{&chunks_, 0, 0});
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  iterator end() {
+    return iterator{&chunks_, chunks_.size(), 0};
+  }
+  const_iterator end() const {
+    return const_iterator{&chunks_, chunks_.size(), 0};
+  }
+  const_iterator cend() const {
+    return end();
+  }
+
+  reverse_iterator rbegin() {
+    return reverse_iterator{end()};
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator{end()};
+  }
+  const_reverse_iterator crbegin() const {
+    return rbegin();
+  }
+
+  reverse_iterator rend() {
+    return reverse_iterator{begin()};
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator{begin()};
+  }
+  const_reverse_iterator crend() const {
+    return rend();
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+  size_type max_size() const {
+    return std::numeric_limits<difference_type>::max();
+  }
+
+  void clear() {
+    chunks_.clear();
+    size_ = 0;
+  }
 
   // Swap contents with another map.
   void swap(PathMap& other) noexcept {
-    Vector::swap(other);
+    chunks_.swap(other.chunks_);
+    std::swap(size_, other.size_);
     std::swap(caseSensitive_, other.caseSensitive_);
   }
 
   // lower_bound performs the binary search for locating keys.
   iterator lower_bound(Piece key) {
-    return std::lower_bound(begin(), end(), key, compare_);
+    auto [chunk, offset] = lowerBoundPosition(key);
+    return iterator{&chunks_, chunk, offset};
   }
 
   const_iterator lower_bound(Piece key) const {
-    return std::lower_bound(begin(), end(), key, compare_);
+    auto [chunk, offset] = lowerBoundPosition(key);
+    return const_iterator{&chunks_, chunk, offset};
   }
 
   /** Find using the Piece representation of a key.
@@ -178,12 +482,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       // When !caseSensitive_, for performance, we will do a case sensitive
       // search first which should cover most of the cases and if not found then
       // do a case insensitive search.
-      for (iter = begin(); iter != end(); ++iter) {
-        if (key.stringPiece().equals(
-                iter->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          return iter;
-        }
-      }
+      return findInsensitive(*this, key);
     }
     return end();
   }
@@ -198,12 +497,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       return iter;
     }
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (iter = begin(); iter != end(); ++iter) {
-        if (key.stringPiece().equals(
-                iter->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          return iter;
-        }
-      }
+      return findInsensitive(*this, key);
     }
     return end();
   }
@@ -221,17 +515,15 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
 
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (val.first.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it; leave it alone
-          return std::make_pair(insens, false);
-        }
+      auto insens = findInsensitive(*this, val.first);
+      if (insens != end()) {
+        // Found it; leave it alone
+        return std::make_pair(insens, false);
       }
     }
 
     // Otherwise, iter is the insertion point
-    return std::make_pair(Vector::insert(iter, val), true);
+    return std::make_pair(insertAt(iter, Pair(val)), true);
   }
 
   /** Emplace a new key-value pair by constructing it in-place.
@@ -250,17 +542,15 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
 
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (key.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it; leave it alone
-          return std::make_pair(insens, false);
-        }
+      auto insens = findInsensitive(*this, key);
+      if (insens != end()) {
+        // Found it; leave it alone
+        return std::make_pair(insens, false);
       }
     }
 
     // Otherwise, iter is the insertion point
-    iter = Vector::emplace(
+    iter = insertAt(
         iter, std::make_pair(Key(key), Value(std::forward<Args>(args)...)));
     return std::make_pair(iter, true);
   }
@@ -277,17 +567,15 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
       // Case insensitive lookup
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (key.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it
-          return insens->second;
-        }
+      auto insens = findInsensitive(*this, key);
+      if (insens != end()) {
+        // Found it
+        return insens->second;
       }
     }
 
     // Not yet present, make a new one at the insertion point
-    iter = Vector::insert(iter, std::make_pair(Key(key), mapped_type()));
+    iter = insertAt(iter, std::make_pair(Key(key), mapped_type()));
     return iter->second;
   }
 
@@ -318,6 +606,20 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     return iter->second;
   }
 
+  /** Erase the entry at pos.
+   * Returns an iterator to the entry that followed it. */
+  iterator erase(const_iterator pos) {
+    auto chunkIndex = pos.chunk_;
+    auto& chunk = chunks_[chunkIndex];
+    chunk.erase(chunk.begin() + pos.offset_);
+    --size_;
+    if (chunk.empty()) {
+      chunks_.erase(chunks_.begin() + chunkIndex);
+      return iterator{&chunks_, chunkIndex, 0};
+    }
+    return normalized(iterator{&chunks_, chunkIndex, pos.offset_});
+  }
+
   /** Erase the value associated with key.
    * Does not allocate any additional memory to look up the key.
    * Returns the number of matching elements that were erased; this is
@@ -344,6 +646,74 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   /// Inequality operator.
   template <typename V, typename K>
   friend bool operator!=(const PathMap<V, K>& lhs, const PathMap<V, K>& rhs);
+
+ private:
+  /** Moves an iterator that points past the end of its chunk to the start of
+   * the next chunk. */
+  template <typename It>
+  static It normalized(It iter) {
+    if (iter.chunk_ < iter.chunks_->size() &&
+        iter.offset_ == (*iter.chunks_)[iter.chunk_].size()) {
+      ++iter.chunk_;
+      iter.offset_ = 0;
+    }
+    return iter;
+  }
+
+  std::pair<size_t, size_t> lowerBoundPosition(Piece key) const {
+    // The first chunk whose last key is not less than key holds the lower
+    // bound.
+    auto chunk = std::partition_point(
+        chunks_.begin(), chunks_.end(), [&](const Chunk& c) {
+          return compare_(c.back(), key);
+        });
+    if (chunk == chunks_.end()) {
+      return {chunks_.size(), 0};
+    }
+    auto offset = std::lower_bound(chunk->begin(), chunk->end(), key, compare_);
+    return {
+        static_cast<size_t>(chunk - chunks_.begin()),
+        static_cast<size_t>(offset - chunk->begin())};
+  }
+
+  /** Insert pair at pos, which must be its sorted position, splitting its
+   * chunk if it becomes too large. */
+  iterator insertAt(iterator pos, Pair&& pair) {
+    auto chunkIndex = pos.chunk_;
+    auto offset = pos.offset_;
+    if (chunkIndex == chunks_.size()) {
+      // Past the last key: append to the last chunk.
+      if (chunks_.empty()) {
+        chunks_.emplace_back();
+      }
+      chunkIndex = chunks_.size() - 1;
+      offset = chunks_[chunkIndex].size();
+    }
+
+    auto& chunk = chunks_[chunkIndex];
+    chunk.insert(chunk.begin() + offset, std::move(pair));
+    ++size_;
+
+    if (chunk.size() > kMaxChunkSize) {
+      auto half = chunk.size() / 2;
+      Chunk upper;
+      upper.reserve(kMaxChunkSize);
+      upper.insert(
+          upper.end(),
+          std::make_move_iterator(chunk.begin() + half),
+          std::make_move_iterator(chunk.end()));
+      chunk.erase(chunk.begin() + half, chunk.end());
+      chunks_.insert(chunks_.begin() + chunkIndex + 1, std::move(upper));
+      if (offset >= half) {
+        ++chunkIndex;
+        offset -= half;
+      }
+    }
+    return iterator{&chunks_, chunkIndex, offset};
+  }
+
+  Chunks chunks_;
+  size_t size_{0};
 };
 
 // Implementations of the equality operators; gcc hates us if we
@@ -352,17 +722,14 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 /// Equality operator.
 template <typename V, typename K>
 bool operator==(const PathMap<V, K>& lhs, const PathMap<V, K>& rhs) {
-  // reinterpret lhs as the underlying vector type.
-  const folly::fbvector<std::pair<K, V>>& vector = lhs;
-  return vector == rhs;
+  return lhs.size() == rhs.size() &&
+      std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
 /// Inequality operator.
 template <typename V, typename K>
 bool operator!=(const PathMap<V, K>& lhs, const PathMap<V, K>& rhs) {
-  // reinterpret lhs as the underlying vector type.
-  const folly::fbvector<std::pair<K, V>>& vector = lhs;
-  return vector != rhs;
+  return !(lhs == rhs);
 }
 } // namespace eden
 } // namespace facebook
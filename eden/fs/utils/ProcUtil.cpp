@@ -7,6 +7,7 @@
 
 #include "eden/fs/utils/ProcUtil.h"
 
+#include <algorithm>
 #include <array>
 #include <fstream>
 #include <vector>
@@ -88,6 +89,90 @@ optional<MemoryStats> readMemoryStats() {
 #endif
 }
 
+optional<CpuTimes> readHostCpuTimes() {
+#ifdef __linux__
+  std::string contents;
+  if (!folly::readFile("/proc/stat", contents)) {
+    return std::nullopt;
+  }
+  return parseProcStat(contents);
+#else
+  return std::nullopt;
+#endif
+}
+
+optional<CpuTimes> parseProcStat(StringPiece data) {
+  // The first line has the form "cpu user nice system idle iowait irq
+  // softirq steal guest guest_nice". Guest time is included in user and nice
+  // already.
+  auto eol = data.find('\n');
+  auto line = data.subpiece(0, eol);
+  if (!line.removePrefix("cpu ")) {
+    return std::nullopt;
+  }
+  std::array<uint64_t, 8> values{};
+  size_t count = 0;
+  for (; count < values.size(); ++count) {
+    line = folly::ltrimWhitespace(line);
+    if (line.empty()) {
+      break;
+    }
+    auto parseResult = folly::parseTo(line, values[count]);
+    if (parseResult.hasError()) {
+      return std::nullopt;
+    }
+    line = parseResult.value();
+  }
+  // Linux reports at least the first four fields.
+  if (count < 4) {
+    return std::nullopt;
+  }
+
+  CpuTimes times;
+  for (size_t i = 0; i < count; ++i) {
+    times.total += values[i];
+  }
+  auto idle = values[3] + values[4];
+  times.busy = times.total - idle;
+  return times;
+}
+
+optional<uint64_t> readHostPagedBytes() {
+#ifdef __linux__
+  std::string contents;
+  if (!folly::readFile("/proc/vmstat", contents)) {
+    return std::nullopt;
+  }
+  return parseProcVmstatPagedBytes(contents);
+#else
+  return std::nullopt;
+#endif
+}
+
+optional<uint64_t> parseProcVmstatPagedBytes(StringPiece data) {
+  optional<uint64_t> pagedIn;
+  optional<uint64_t> pagedOut;
+  std::vector<StringPiece> lines;
+  folly::split('\n', data, lines);
+  for (auto line : lines) {
+    StringPiece key;
+    StringPiece value;
+    if (!folly::split<false>(' ', line, key, value)) {
+      continue;
+    }
+    if (key == "pgpgin") {
+      pagedIn = folly::tryTo<uint64_t>(value).value_or(0);
+    } else if (key == "pgpgout") {
+      pagedOut = folly::tryTo<uint64_t>(value).value_or(0);
+    }
+  }
+  if (!pagedIn || !pagedOut) {
+    return std::nullopt;
+  }
+  // Both counters are in KiB, regardless of the page size.
+  return (*pagedIn + *pagedOut) * 1024;
+}
+
 #ifndef _WIN32
 optional<MemoryStats> readStatmFile(AbsolutePathPiece filename) {
   auto contents = readFile(filename);
@@ -123,6 +208,76 @@ optional<MemoryStats> parseStatmFile(StringPiece data, size_t pageSize) {
   return stats;
 }
 
+optional<size_t> readCgroupMemoryLimit() {
+#ifdef __linux__
+  std::string procCgroup;
+  if (!folly::readFile("/proc/self/cgroup", procCgroup)) {
+    return std::nullopt;
+  }
+  auto cgroup = parseProcCgroupFile(procCgroup);
+  if (!cgroup) {
+    return std::nullopt;
+  }
+
+  auto relativePath = cgroup->path == "/" ? std::string{} : cgroup->path;
+  auto limitPath = cgroup->unified
+      ? folly::to<std::string>("/sys/fs/cgroup", relativePath, "/memory.max")
+      : folly::to<std::string>(
+            "/sys/fs/cgroup/memory", relativePath, "/memory.limit_in_bytes");
+  std::string limit;
+  if (!folly::readFile(limitPath.c_str(), limit)) {
+    XLOG(DBG3) << "unable to read cgroup memory limit from " << limitPath;
+    return std::nullopt;
+  }
+  return parseCgroupMemoryLimit(limit);
+#else
+  return std::nullopt;
+#endif
+}
+
+optional<MemoryCgroup> parseProcCgroupFile(StringPiece data) {
+  // Each line has the form "hierarchy-ID:controller-list:cgroup-path".
+  optional<MemoryCgroup> result;
+  std::vector<StringPiece> lines;
+  folly::split('\n', data, lines);
+  for (auto line : lines) {
+    StringPiece hierarchy;
+    StringPiece controllers;
+    StringPiece path;
+    if (!folly::split<false>(':', line, hierarchy, controllers, path) ||
+        path.empty()) {
+      continue;
+    }
+    if (hierarchy == "0" && controllers.empty()) {
+      if (!result) {
+        result = MemoryCgroup{path.str(), true};
+      }
+      continue;
+    }
+    std::vector<StringPiece> controllerList;
+    folly::split(',', controllers, controllerList);
+    if (std::find(controllerList.begin(), controllerList.end(), "memory") !=
+        controllerList.end()) {
+      return MemoryCgroup{path.str(), false};
+    }
+  }
+  return result;
+}
+
+optional<size_t> parseCgroupMemoryLimit(StringPiece data) {
+  data = folly::trimWhitespace(data);
+  if (data == "max") {
+    return std::nullopt;
+  }
+  auto limit = folly::tryTo<uint64_t>(data);
+  // cgroup v1 reports a lack of limit as a number close to INT64_MAX.
+  constexpr uint64_t kUnlimited = uint64_t{1} << 62;
+  if (limit.hasError() || limit.value() >= kUnlimited) {
+    return std::nullopt;
+  }
+  return static_cast<size_t>(limit.value());
+}
+
 std::string& trim(std::string& str, const std::string& delim) {
   str.erase(0, str.find_first_not_of(delim));
   str.erase(str.find_last_not_of(delim) + 1);
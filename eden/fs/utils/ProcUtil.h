@@ -54,6 +54,44 @@ std::optional<MemoryStats> readMemoryStats();
  */
 std::optional<size_t> calculatePrivateBytes();
 
+/**
+ * The time the host's CPUs spent busy and in total since boot, summed over
+ * all CPUs, in clock ticks.
+ */
+struct CpuTimes {
+  uint64_t busy = 0;
+  uint64_t total = 0;
+};
+
+/**
+ * Read the host's CPU times from /proc/stat.
+ *
+ * Returns std::nullopt on non-Linux platforms or if an error occurs reading
+ * or parsing the data.
+ */
+std::optional<CpuTimes> readHostCpuTimes();
+
+/**
+ * Parse the aggregate "cpu" line of a /proc/stat file. Time spent idle or
+ * waiting for I/O does not count as busy.
+ */
+std::optional<CpuTimes> parseProcStat(folly::StringPiece data);
+
+/**
+ * Read the number of bytes the host paged in from and out to disk since
+ * boot, from /proc/vmstat.
+ *
+ * Returns std::nullopt on non-Linux platforms or if an error occurs reading
+ * or parsing the data.
+ */
+std::optional<uint64_t> readHostPagedBytes();
+
+/**
+ * Parse the pgpgin and pgpgout counters of a /proc/vmstat file, and return
+ * their sum in bytes.
+ */
+std::optional<uint64_t> parseProcVmstatPagedBytes(folly::StringPiece data);
+
 #ifndef _WIN32
 /**
  * Read a /proc/<pid>/statm file and return the results as a MemoryStats object.
@@ -69,6 +107,38 @@ std::optional<MemoryStats> parseStatmFile(
     folly::StringPiece data,
     size_t pageSize);
 
+/**
+ * Read the memory limit, in bytes, of the cgroup the current process belongs
+ * to. Both cgroup v1 and the unified v2 hierarchy are supported.
+ *
+ * Returns std::nullopt if the cgroup has no memory limit, on non-Linux
+ * platforms, or if an error occurs reading or parsing the data.
+ */
+std::optional<size_t> readCgroupMemoryLimit();
+
+/**
+ * The location of the process's memory cgroup, as found in
+ * /proc/<pid>/cgroup.
+ */
+struct MemoryCgroup {
+  /// The cgroup path, relative to the root of its hierarchy.
+  std::string path;
+  /// Whether the cgroup is in the unified (v2) hierarchy.
+  bool unified = false;
+};
+
+/**
+ * Parse the contents of a /proc/<pid>/cgroup file. The memory controller's
+ * v1 hierarchy is preferred over the unified hierarchy if both are listed.
+ */
+std::optional<MemoryCgroup> parseProcCgroupFile(folly::StringPiece data);
+
+/**
+ * Parse the contents of a cgroup v2 memory.max or cgroup v1
+ * memory.limit_in_bytes file. Returns std::nullopt if there is no limit.
+ */
+std::optional<size_t> parseCgroupMemoryLimit(folly::StringPiece data);
+
 /**
  * Trim leading and trailing delimiter characters from passed string.
  * @return the modified string.
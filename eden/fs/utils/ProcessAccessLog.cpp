@@ -8,6 +8,7 @@
 #include "ProcessAccessLog.h"
 
 #include <folly/Exception.h>
+#include <folly/Likely.h>
 #include <folly/MapUtil.h>
 #include <folly/MicroLock.h>
 #include <folly/ThreadLocal.h>
@@ -93,11 +94,6 @@ struct ThreadLocalBucket {
   folly::Synchronized<State, folly::MicroLock> state_;
 };
 
-namespace {
-struct BucketTag;
-folly::ThreadLocalPtr<ThreadLocalBucket, BucketTag> threadLocalBucketPtr;
-} // namespace
-
 void ProcessAccessLog::Bucket::clear() {
   accessCountsByPid.clear();
 }
@@ -106,28 +102,30 @@ void ProcessAccessLog::Bucket::add(
     pid_t pid,
     bool& isNewPid,
     ProcessAccessLog::AccessType type) {
-  auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
+  // try_emplace, unlike emplace, does not allocate when the pid is present.
+  auto [it, inserted] = accessCountsByPid.try_emplace(pid);
   it->second[type]++;
-  isNewPid = contains;
+  isNewPid = inserted;
 }
 
 void ProcessAccessLog::Bucket::add(
     pid_t pid,
     bool& isNewPid,
     std::chrono::nanoseconds duration) {
-  auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
+  auto [it, inserted] = accessCountsByPid.try_emplace(pid);
   it->second.duration += duration;
-  isNewPid = contains;
+  isNewPid = inserted;
 }
 
 void ProcessAccessLog::Bucket::merge(const Bucket& other) {
-  for (auto [pid, otherAccessCounts] : other.accessCountsByPid) {
+  for (const auto& [pid, otherAccessCounts] : other.accessCountsByPid) {
+    auto& accessCounts = accessCountsByPid[pid];
     for (std::underlying_type_t<AccessType> type = 0;
          type != folly::to_underlying(AccessType::Last);
          type++) {
-      accessCountsByPid[pid].counts[type] += otherAccessCounts.counts[type];
+      accessCounts.counts[type] += otherAccessCounts.counts[type];
     }
-    accessCountsByPid[pid].duration += otherAccessCounts.duration;
+    accessCounts.duration += otherAccessCounts.duration;
   }
 }
 
@@ -138,16 +136,17 @@ ProcessAccessLog::ProcessAccessLog(
 }
 
 ProcessAccessLog::~ProcessAccessLog() {
-  for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
+  // Stop exiting threads from merging into this log while it is destroyed.
+  for (auto& tlb : threadLocalBuckets_.accessAllThreads()) {
     tlb.clearOwnerIfMe(this);
   }
 }
 
 ThreadLocalBucket* ProcessAccessLog::getTlb() {
-  auto tlb = threadLocalBucketPtr.get();
-  if (!tlb) {
-    threadLocalBucketPtr.reset(std::make_unique<ThreadLocalBucket>(this));
-    tlb = threadLocalBucketPtr.get();
+  auto tlb = threadLocalBuckets_.get();
+  if (FOLLY_UNLIKELY(!tlb)) {
+    threadLocalBuckets_.reset(std::make_unique<ThreadLocalBucket>(this));
+    tlb = threadLocalBuckets_.get();
   }
   return tlb;
 }
@@ -197,8 +196,8 @@ void ProcessAccessLog::recordDuration(
 std::unordered_map<pid_t, AccessCounts> ProcessAccessLog::getAccessCounts(
     std::chrono::seconds lastNSeconds) {
   auto secondCount = lastNSeconds.count();
-  // First, merge all the thread-local buckets into their owners, including us.
-  for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
+  // First, merge all the thread-local buckets into this log.
+  for (auto& tlb : threadLocalBuckets_.accessAllThreads()) {
     // This must be done outside of acquiring our own state_ lock.
     tlb.mergeUpstream();
   }
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <folly/container/F14Map.h>
 #include <type_traits>
 
 #include "eden/fs/service/gen-cpp2/eden_types.h"
@@ -24,10 +26,9 @@ struct ThreadLocalBucket;
  * An inexpensive mechanism for counting accesses by pids. Intended for counting
  * channel and Thrift calls from external processes.
  *
- * The first time a thread calls recordAccess, that thread is then coupled to
- * this particular ProcessAccessLog, even if it calls recordAccess on another
- * ProcessAccessLog instance. Thus, use one ProcessAccessLog per pool of
- * threads.
+ * Each thread records into its own buckets, which are only merged into the
+ * log when they are read or when the thread exits, so concurrent recording
+ * threads do not contend with each other.
  */
 class ProcessAccessLog {
  public:
@@ -45,9 +46,7 @@ class ProcessAccessLog {
   ~ProcessAccessLog();
 
   /**
-   * Records an access by a process ID. The first call to recordAccess by a
-   * particular thread binds that thread to this access log. Future recordAccess
-   * calls on that thread will accumulate within this access log.
+   * Records an access by a process ID.
    *
    * Process IDs passed to recordAccess are also inserted into the
    * ProcessNameCache.
@@ -85,7 +84,7 @@ class ProcessAccessLog {
     void add(pid_t pid, bool& isNew, std::chrono::nanoseconds duration);
     void merge(const Bucket& other);
 
-    std::unordered_map<pid_t, PerBucketAccessCounts> accessCountsByPid;
+    folly::F14FastMap<pid_t, PerBucketAccessCounts> accessCountsByPid;
   };
 
   // Keep up to ten seconds of data, but use a power of two so BucketedLog
@@ -97,8 +96,14 @@ class ProcessAccessLog {
     Buckets buckets;
   };
 
+  struct ThreadLocalBucketTag;
+
   const std::shared_ptr<ProcessNameCache> processNameCache_;
   folly::Synchronized<State> state_;
+  // Declared after state_ so that the buckets of the threads still alive are
+  // destroyed first.
+  folly::ThreadLocalPtr<ThreadLocalBucket, ThreadLocalBucketTag>
+      threadLocalBuckets_;
 
   uint64_t getSecondsSinceEpoch();
   ThreadLocalBucket* getTlb();
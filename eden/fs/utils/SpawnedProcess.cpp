@@ -38,6 +38,14 @@ using namespace std::chrono_literals;
 extern "C" {
 extern char** environ;
 }
+
+#define EDEN_HAVE_SPAWN_ADDCHDIR 0
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 29)
+#undef EDEN_HAVE_SPAWN_ADDCHDIR
+#define EDEN_HAVE_SPAWN_ADDCHDIR 1
+#endif
+#endif
 #endif
 
 namespace facebook {
@@ -452,24 +460,40 @@ SpawnedProcess::SpawnedProcess(
   };
 
   // Reset signals to default for the child process
-  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+  short flags = POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_USEVFORK
+  // Ask for vfork semantics so that spawning doesn't have to duplicate the
+  // page tables of a large edenfs process. glibc 2.24 and later always do
+  // this, older versions need to be told.
+  flags |= POSIX_SPAWN_USEVFORK;
+#endif
+  posix_spawnattr_setflags(&attr, flags);
 
   // We make a copy because posix_spawnp requires that the argv be non-const.
   // In addition, if combining chdir and executablePath we need to modify the
   // argv array.
   std::vector<std::string> argStrings = args;
 
+#if EDEN_HAVE_SPAWN_ADDCHDIR
+  if (options.cwd_.has_value()) {
+    // Let posix_spawn change the directory in the child rather than paying
+    // for an extra shell exec.
+    checkPosixError(
+        posix_spawn_file_actions_addchdir_np(&actions, options.cwd_->c_str()),
+        "posix_spawn_file_actions_addchdir_np");
+  }
+#else
   if (options.cwd_.has_value()) {
     // There isn't a portably defined way to inform posix_spawn to use an
     // alternate cwd.
     //
-    // Solaris 11.3 lead the way with posix_spawn_file_actions_addchdir_np(3C).
-    // glibc added support for this same function in 2.29, but that isn't yet
-    // in wide circulation.  macOS doesn't have any functions for this.
+    // Solaris 11.3 lead the way with posix_spawn_file_actions_addchdir_np(3C),
+    // and glibc added support for this same function in 2.29, which we use
+    // when it is available.
     //
-    // Instead, the recommendation for a multi-threaded program is to spawn a
-    // helper child process that will perform the chdir and then exec the final
-    // process.
+    // Otherwise, the recommendation for a multi-threaded program is to spawn
+    // a helper child process that will perform the chdir and then exec the
+    // final process.
     //
     // We use the shell for this.
     std::string shellCommand =
@@ -507,6 +531,7 @@ SpawnedProcess::SpawnedProcess(
     argStrings.emplace_back("-c");
     argStrings.emplace_back(std::move(shellCommand));
   }
+#endif
 
   std::vector<char*> argv;
   argv.reserve(argStrings.size() + 1);
@@ -8,8 +8,9 @@
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 #include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ExecutorWithPriority.h>
 #include <folly/executors/ManualExecutor.h>
-#include <folly/executors/task_queue/UnboundedBlockingQueue.h>
+#include <folly/executors/task_queue/PriorityUnboundedBlockingQueue.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 
 namespace facebook {
@@ -20,13 +21,29 @@ UnboundedQueueExecutor::UnboundedQueueExecutor(
     folly::StringPiece threadNamePrefix)
     : executor_{std::make_unique<folly::CPUThreadPoolExecutor>(
           threadCount,
-          std::make_unique<folly::UnboundedBlockingQueue<
-              folly::CPUThreadPoolExecutor::CPUTask>>(),
+          std::make_unique<folly::PriorityUnboundedBlockingQueue<
+              folly::CPUThreadPoolExecutor::CPUTask>>(kNumPriorities),
           std::make_unique<folly::NamedThreadFactory>(threadNamePrefix))} {}
 
 UnboundedQueueExecutor::UnboundedQueueExecutor(
     std::shared_ptr<folly::ManualExecutor> executor)
     : executor_{std::move(executor)} {}
 
+void UnboundedQueueExecutor::addWithPriority(
+    folly::Func func,
+    int8_t priority) {
+  // The ManualExecutor used by tests has a single queue.
+  if (executor_->getNumPriorities() == 1) {
+    executor_->add(std::move(func));
+  } else {
+    executor_->addWithPriority(std::move(func), priority);
+  }
+}
+
+folly::Executor::KeepAlive<> UnboundedQueueExecutor::getLowPriorityExecutor() {
+  return folly::ExecutorWithPriority::create(
+      getKeepAliveToken(this), folly::Executor::LO_PRI);
+}
+
 } // namespace eden
 } // namespace facebook
@@ -23,6 +23,14 @@ namespace eden {
  *
  * Parts of Eden rely on queuing a function to be non-blocking for deadlock
  * safety.
+ *
+ * Work is queued in two priority lanes. Functions added with `add()` or with a
+ * non-negative priority go to the high priority lane, which workers always
+ * drain first. Bulk background work (prefetching, checkout) should be queued
+ * with a negative priority, see `getLowPriorityExecutor()`, so it does not
+ * delay interactive requests. As the lanes are strictly ordered, low priority
+ * work may be starved for as long as the pool is saturated with high priority
+ * work.
  */
 class UnboundedQueueExecutor : public folly::Executor {
  public:
@@ -51,6 +59,23 @@ class UnboundedQueueExecutor : public folly::Executor {
     executor_->add(std::move(func));
   }
 
+  void addWithPriority(folly::Func func, int8_t priority) override;
+
+  uint8_t getNumPriorities() const override {
+    return executor_->getNumPriorities();
+  }
+
+  /**
+   * Returns an Executor that queues functions to this executor's low priority
+   * lane.
+   */
+  folly::Executor::KeepAlive<> getLowPriorityExecutor();
+
+  /**
+   * Number of priority lanes of the thread pool.
+   */
+  static constexpr uint8_t kNumPriorities = 2;
+
  private:
   std::shared_ptr<folly::Executor> executor_;
 };
@@ -6,11 +6,49 @@
  */
 
 #include "eden/fs/utils/Utf8.h"
+#include <folly/Portability.h>
 #include <folly/Unicode.h>
+#include <folly/lang/Bits.h>
+
+#if FOLLY_SSE >= 2
+#include <emmintrin.h>
+#elif FOLLY_NEON && FOLLY_AARCH64
+#include <arm_neon.h>
+#endif
 
 namespace facebook {
 namespace eden {
 
+namespace detail {
+
+size_t asciiPrefixLength(folly::StringPiece str) noexcept {
+  auto begin = str.begin();
+  auto it = begin;
+  auto end = str.end();
+#if FOLLY_SSE >= 2
+  for (; end - it >= 16; it += 16) {
+    auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+    // One bit per byte, set for those that aren't ASCII.
+    if (auto mask = _mm_movemask_epi8(chars)) {
+      return (it - begin) + folly::findFirstSet(mask) - 1;
+    }
+  }
+#elif FOLLY_NEON && FOLLY_AARCH64
+  for (; end - it >= 16; it += 16) {
+    auto chars = vld1q_u8(reinterpret_cast<const uint8_t*>(it));
+    if (vmaxvq_u8(chars) >= 0x80) {
+      break;
+    }
+  }
+#endif
+  while (it != end && !isBitSet(*it, 7)) {
+    ++it;
+  }
+  return it - begin;
+}
+
+} // namespace detail
+
 std::string ensureValidUtf8(folly::ByteRange str) {
   std::string output;
   output.reserve(str.size());
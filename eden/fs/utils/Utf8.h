@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Traits.h>
 #include <folly/Utility.h>
 
 namespace facebook {
@@ -58,6 +59,63 @@ constexpr bool isValidContinuation(
 
   return true;
 }
+
+/**
+ * Returns the number of ASCII characters `str` starts with, checking many
+ * bytes at a time where the CPU allows it.
+ */
+size_t asciiPrefixLength(folly::StringPiece str) noexcept;
+
+/**
+ * Consume the character at `begin`. Returns false if it is not correctly
+ * encoded.
+ */
+constexpr bool consumeUtf8Char(const char*& begin, const char* const end) {
+  char first = *begin++;
+  if (!isBitSet(first, 7)) {
+    // ASCII character, nothing to do.
+  } else if (!isBitSet(first, 6)) {
+    // 10xxxxxx isn't a valid for the first byte.
+    return false;
+  } else if (!isBitSet(first, 5)) {
+    // 110xxxxx: 2 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0x1F;
+    if (!isValidContinuation(begin, end, 1, codepoint)) {
+      return false;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x80) {
+      return false;
+    }
+  } else if (!isBitSet(first, 4)) {
+    // 1110xxxx: 3 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0xF;
+    if (!isValidContinuation(begin, end, 2, codepoint)) {
+      return false;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x800) {
+      return false;
+    }
+  } else if (!isBitSet(first, 3)) {
+    // 11110xxx: 4 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0x7;
+    if (!isValidContinuation(begin, end, 3, codepoint)) {
+      return false;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x10000) {
+      return false;
+    }
+  } else {
+    // 11111xxx isn't ever valid.
+    return false;
+  }
+  return true;
+}
 } // namespace detail
 
 /**
@@ -71,47 +129,15 @@ constexpr bool isValidUtf8(folly::StringPiece str) {
   const char* const end = str.end();
 
   while (begin != end) {
-    char first = *begin++;
-    if (!detail::isBitSet(first, 7)) {
-      // ASCII character, nothing to do.
-    } else if (!detail::isBitSet(first, 6)) {
-      // 10xxxxxx isn't a valid for the first byte.
-      return false;
-    } else if (!detail::isBitSet(first, 5)) {
-      // 110xxxxx: 2 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0x1F;
-      if (!detail::isValidContinuation(begin, end, 1, codepoint)) {
-        return false;
+    if (!folly::is_constant_evaluated_or(true)) {
+      // Outside of constant evaluation, skip over runs of ASCII characters,
+      // which is what most strings consist of, many bytes at a time.
+      begin += detail::asciiPrefixLength(folly::StringPiece{begin, end});
+      if (begin == end) {
+        break;
       }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x80) {
-        return false;
-      }
-    } else if (!detail::isBitSet(first, 4)) {
-      // 1110xxxx: 3 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0xF;
-      if (!detail::isValidContinuation(begin, end, 2, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x800) {
-        return false;
-      }
-    } else if (!detail::isBitSet(first, 3)) {
-      // 11110xxx: 4 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0x7;
-      if (!detail::isValidContinuation(begin, end, 3, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x10000) {
-        return false;
-      }
-    } else {
-      // 11111xxx isn't ever valid.
+    }
+    if (!detail::consumeUtf8Char(begin, end)) {
       return false;
     }
   }
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/AdaptiveConcurrencyLimit.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+AdaptiveConcurrencyLimit::Options testOptions() {
+  AdaptiveConcurrencyLimit::Options options;
+  options.minLimit = 4;
+  options.maxLimit = 200;
+  options.initialLimit = 50;
+  options.window = 1s;
+  options.minSamplesPerWindow = 10;
+  return options;
+}
+
+/**
+ * Record a window of identical samples, ending one window after `start`.
+ */
+std::chrono::steady_clock::time_point recordWindow(
+    AdaptiveConcurrencyLimit& limit,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::microseconds latency) {
+  auto end = start + 1s;
+  for (int i = 0; i < 10; ++i) {
+    limit.recordLatency(latency, i == 9 ? end : start);
+  }
+  return end;
+}
+
+} // namespace
+
+TEST(AdaptiveConcurrencyLimit, grows_while_latency_is_steady) {
+  AdaptiveConcurrencyLimit limit{testOptions()};
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 100; ++i) {
+    now = recordWindow(limit, now, 100us);
+  }
+  EXPECT_EQ(200, limit.getLimit());
+}
+
+TEST(AdaptiveConcurrencyLimit, shrinks_when_latency_rises) {
+  AdaptiveConcurrencyLimit limit{testOptions()};
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 5; ++i) {
+    now = recordWindow(limit, now, 100us);
+  }
+  auto steadyLimit = limit.getLimit();
+  EXPECT_GT(steadyLimit, 50);
+
+  for (int i = 0; i < 5; ++i) {
+    now = recordWindow(limit, now, 1000us);
+  }
+  EXPECT_LT(limit.getLimit(), steadyLimit);
+
+  for (int i = 0; i < 15; ++i) {
+    now = recordWindow(limit, now, 1000us);
+  }
+  EXPECT_LT(limit.getLimit(), 50);
+  EXPECT_GE(limit.getLimit(), 4);
+}
+
+TEST(AdaptiveConcurrencyLimit, ignores_sparse_windows) {
+  AdaptiveConcurrencyLimit limit{testOptions()};
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 5; ++i) {
+    now += 1s;
+    limit.recordLatency(100us, now);
+  }
+  EXPECT_EQ(50, limit.getLimit());
+}
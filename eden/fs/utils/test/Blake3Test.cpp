@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Blake3.h"
+#include <folly/String.h>
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+/// The input of the official BLAKE3 test vectors.
+std::string testInput(size_t size) {
+  std::string input;
+  for (size_t i = 0; i < size; ++i) {
+    input.push_back(static_cast<char>(i % 251));
+  }
+  return input;
+}
+
+std::string hexDigest(folly::StringPiece data) {
+  return folly::hexlify(Blake3::hash(folly::ByteRange{data}));
+}
+
+} // namespace
+
+TEST(Blake3Test, matches_test_vectors) {
+  EXPECT_EQ(
+      "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
+      hexDigest(""));
+  EXPECT_EQ(
+      "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85",
+      hexDigest("abc"));
+  EXPECT_EQ(
+      "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213",
+      hexDigest(testInput(1)));
+  EXPECT_EQ(
+      "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7",
+      hexDigest(testInput(1024)));
+  EXPECT_EQ(
+      "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444",
+      hexDigest(testInput(1025)));
+}
+
+TEST(Blake3Test, incremental_updates_match_one_shot) {
+  // Cover single chunks, chunk boundaries and several tree levels.
+  for (size_t size : {63, 64, 65, 1023, 1024, 1025, 2048, 3073, 8193, 31744}) {
+    auto input = testInput(size);
+    folly::ByteRange bytes{folly::StringPiece{input}};
+    Blake3 hasher;
+    for (size_t i = 0; i < size; i += 7) {
+      hasher.update(bytes.subpiece(i, 7));
+    }
+    EXPECT_EQ(Blake3::hash(bytes), hasher.finalize()) << size;
+  }
+}
+
+TEST(Blake3Test, hashes_chained_iobufs) {
+  auto input = testInput(5000);
+  auto buf = folly::IOBuf::copyBuffer(input.data(), 1500);
+  buf->prependChain(folly::IOBuf::copyBuffer(input.data() + 1500, 3500));
+  EXPECT_EQ(
+      Blake3::hash(folly::ByteRange{folly::StringPiece{input}}),
+      Blake3::hash(*buf));
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/ConcurrencyLimiter.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(ConcurrencyLimiter, waitersAreServedInOrder) {
+  ConcurrencyLimiter limiter{2};
+  auto first = limiter.acquire();
+  auto second = limiter.acquire();
+  auto third = limiter.acquire();
+  auto fourth = limiter.acquire();
+  EXPECT_TRUE(first.isReady());
+  EXPECT_TRUE(second.isReady());
+  EXPECT_FALSE(third.isReady());
+  EXPECT_FALSE(fourth.isReady());
+
+  limiter.release();
+  EXPECT_TRUE(third.isReady());
+  EXPECT_FALSE(fourth.isReady());
+  limiter.release();
+  EXPECT_TRUE(fourth.isReady());
+}
+
+TEST(ConcurrencyLimiter, runReleasesWhenTheOperationCompletes) {
+  ConcurrencyLimiter limiter{1};
+  folly::Promise<int> promise;
+  auto running = limiter.run(
+      [&] { return ImmediateFuture<int>{promise.getSemiFuture()}; });
+  auto waiting = limiter.run([] { return ImmediateFuture<int>{2}; });
+  EXPECT_FALSE(waiting.isReady());
+
+  promise.setValue(1);
+  EXPECT_EQ(1, std::move(running).get());
+  EXPECT_EQ(2, std::move(waiting).get());
+
+  // Failures release the permit too.
+  auto failing = limiter.run([]() -> ImmediateFuture<int> {
+    throw std::runtime_error("failed");
+  });
+  EXPECT_THROW(std::move(failing).get(), std::runtime_error);
+  EXPECT_TRUE(limiter.acquire().isReady());
+}
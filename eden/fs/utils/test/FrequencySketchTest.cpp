@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FrequencySketch.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(FrequencySketchTest, empty_sketch_counts_nothing) {
+  FrequencySketch sketch;
+  EXPECT_TRUE(sketch.empty());
+  sketch.increment(1);
+  EXPECT_EQ(0, sketch.frequency(1));
+}
+
+TEST(FrequencySketchTest, counts_accesses) {
+  FrequencySketch sketch{128};
+  EXPECT_EQ(0, sketch.frequency(42));
+  sketch.increment(42);
+  sketch.increment(42);
+  sketch.increment(42);
+  EXPECT_EQ(3, sketch.frequency(42));
+  EXPECT_EQ(0, sketch.frequency(43));
+}
+
+TEST(FrequencySketchTest, counters_saturate) {
+  FrequencySketch sketch{128};
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(7);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.frequency(7));
+}
+
+TEST(FrequencySketchTest, aging_halves_counts) {
+  FrequencySketch sketch{128};
+  for (int i = 0; i < 8; ++i) {
+    sketch.increment(7);
+  }
+  sketch.age();
+  EXPECT_EQ(4, sketch.frequency(7));
+}
+
+TEST(FrequencySketchTest, ages_automatically_after_many_accesses) {
+  FrequencySketch sketch{16};
+  for (int i = 0; i < 10; ++i) {
+    sketch.increment(7);
+  }
+  // 160 accesses trigger at least one reset, after which the old hot key is
+  // no longer saturated.
+  for (uint64_t i = 0; i < 160; ++i) {
+    sketch.increment(1000 + i);
+  }
+  EXPECT_LT(sketch.frequency(7), 10);
+}
+
+TEST(FrequencySketchTest, hot_keys_outrank_scanned_keys) {
+  FrequencySketch sketch{1024};
+  for (int round = 0; round < 5; ++round) {
+    for (uint64_t hot = 0; hot < 10; ++hot) {
+      sketch.increment(hot);
+    }
+  }
+  for (uint64_t scanned = 100; scanned < 1100; ++scanned) {
+    sketch.increment(scanned);
+  }
+  size_t hotWins = 0;
+  for (uint64_t hot = 0; hot < 10; ++hot) {
+    if (sketch.frequency(hot) > sketch.frequency(100 + hot)) {
+      ++hotWins;
+    }
+  }
+  EXPECT_EQ(10, hotWins);
+}
+
+TEST(FrequencySketchTest, clear_forgets_counts) {
+  FrequencySketch sketch{128};
+  sketch.increment(42);
+  sketch.clear();
+  EXPECT_EQ(0, sketch.frequency(42));
+}
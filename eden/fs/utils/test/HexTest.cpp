@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Hex.h"
+#include <folly/String.h>
+#include <folly/portability/GTest.h>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+
+std::string allBytes(size_t size) {
+  std::string bytes;
+  for (size_t i = 0; i < size; ++i) {
+    bytes.push_back(static_cast<char>((i * 37 + 11) & 0xff));
+  }
+  return bytes;
+}
+
+} // namespace
+
+TEST(HexTest, encode_matches_hexlify) {
+  // Cover lengths on both sides of the 16-byte vector width.
+  for (size_t size = 0; size <= 70; ++size) {
+    auto bytes = allBytes(size);
+    EXPECT_EQ(
+        folly::hexlify(bytes),
+        hexEncode(folly::ByteRange{folly::StringPiece{bytes}}))
+        << "size " << size;
+  }
+}
+
+TEST(HexTest, encode_every_byte_value) {
+  std::string bytes;
+  for (int i = 0; i < 256; ++i) {
+    bytes.push_back(static_cast<char>(i));
+  }
+  EXPECT_EQ(
+      folly::hexlify(bytes),
+      hexEncode(folly::ByteRange{folly::StringPiece{bytes}}));
+}
+
+TEST(HexTest, decode_round_trips) {
+  for (size_t size = 0; size <= 70; ++size) {
+    auto bytes = allBytes(size);
+    auto hex = folly::hexlify(bytes);
+    std::vector<uint8_t> out(size);
+    ASSERT_TRUE(hexDecode(hex, out.data())) << "size " << size;
+    EXPECT_EQ(bytes, std::string(out.begin(), out.end())) << "size " << size;
+  }
+}
+
+TEST(HexTest, decode_accepts_uppercase) {
+  std::vector<uint8_t> out(20);
+  ASSERT_TRUE(
+      hexDecode("FACEB00CDEADBEEFC00010FF1BADB0028BADF00D", out.data()));
+  EXPECT_EQ(0xfa, out[0]);
+  EXPECT_EQ(0x0d, out[19]);
+}
+
+TEST(HexTest, decode_rejects_invalid_digits) {
+  auto hex = folly::hexlify(allBytes(40));
+  std::vector<uint8_t> out(40);
+  for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\x80', '\xff'}) {
+    // Put the bad digit in the vectorized part and in the scalar tail.
+    for (size_t pos : {size_t{0}, size_t{31}, size_t{45}, size_t{79}}) {
+      auto copy = hex;
+      copy[pos] = bad;
+      EXPECT_FALSE(hexDecode(copy, out.data()))
+          << "character " << int(bad) << " at " << pos;
+    }
+  }
+}
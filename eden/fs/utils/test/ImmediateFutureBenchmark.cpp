@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/ImmediateFuture.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <new>
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * Number of heap allocations made by the current thread. Counted by the
+ * global operator new below so each benchmark can report allocations per
+ * continuation chain.
+ */
+thread_local size_t allocationCount = 0;
+
+constexpr int kChainLength = 8;
+
+ImmediateFuture<int> chain(ImmediateFuture<int> fut) {
+  for (int i = 0; i < kChainLength; ++i) {
+    fut = std::move(fut).thenValue([](int value) { return value + 1; });
+  }
+  return fut;
+}
+
+void reportAllocations(benchmark::State& state, size_t allocations) {
+  state.counters["allocs_per_chain"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  ++allocationCount;
+  if (auto* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+static void ImmediateFuture_ready_chain(benchmark::State& state) {
+  auto before = allocationCount;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(chain(ImmediateFuture<int>{0}).get());
+  }
+  reportAllocations(state, allocationCount - before);
+}
+BENCHMARK(ImmediateFuture_ready_chain);
+
+static void ImmediateFuture_ready_chain_returning_ImmediateFuture(
+    benchmark::State& state) {
+  auto before = allocationCount;
+  for (auto _ : state) {
+    ImmediateFuture<int> fut{0};
+    for (int i = 0; i < kChainLength; ++i) {
+      fut = std::move(fut).thenValue(
+          [](int value) -> ImmediateFuture<int> { return value + 1; });
+    }
+    benchmark::DoNotOptimize(std::move(fut).get());
+  }
+  reportAllocations(state, allocationCount - before);
+}
+BENCHMARK(ImmediateFuture_ready_chain_returning_ImmediateFuture);
+
+/**
+ * The chain starts from a SemiFuture that was fulfilled before the first
+ * continuation is attached. Only the promise/future core itself should
+ * allocate.
+ */
+static void ImmediateFuture_fulfilled_SemiFuture_chain(
+    benchmark::State& state) {
+  auto before = allocationCount;
+  for (auto _ : state) {
+    auto [promise, semi] = folly::makePromiseContract<int>();
+    promise.setValue(0);
+    benchmark::DoNotOptimize(
+        chain(ImmediateFuture<int>{std::move(semi)}).get());
+  }
+  reportAllocations(state, allocationCount - before);
+}
+BENCHMARK(ImmediateFuture_fulfilled_SemiFuture_chain);
+
+static void SemiFuture_fulfilled_chain(benchmark::State& state) {
+  auto before = allocationCount;
+  for (auto _ : state) {
+    auto [promise, semi] = folly::makePromiseContract<int>();
+    promise.setValue(0);
+    for (int i = 0; i < kChainLength; ++i) {
+      semi = std::move(semi).deferValue([](int value) { return value + 1; });
+    }
+    benchmark::DoNotOptimize(std::move(semi).get());
+  }
+  reportAllocations(state, allocationCount - before);
+}
+BENCHMARK(SemiFuture_fulfilled_chain);
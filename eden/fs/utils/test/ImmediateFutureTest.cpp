@@ -9,6 +9,11 @@
 
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/executors/ManualExecutor.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Task.h>
+#endif
 
 using namespace facebook::eden;
 using namespace std::literals::chrono_literals;
@@ -274,6 +279,36 @@ TEST(
   EXPECT_TRUE(run);
 }
 
+TEST(ImmediateFuture, thenValue_on_fulfilled_SemiFuture_runs_inline) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto imm = ImmediateFuture<int>{std::move(semi)};
+  promise.setValue(10);
+
+  bool run = false;
+  auto then = std::move(imm).thenValue([&](int x) {
+    run = true;
+    return x + 1;
+  });
+  EXPECT_TRUE(run);
+  EXPECT_TRUE(then.isReady());
+  EXPECT_EQ(11, std::move(then).get());
+}
+
+TEST(ImmediateFuture, thenValue_on_failed_SemiFuture_skips_continuation) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto imm = ImmediateFuture<int>{std::move(semi)};
+  promise.setException(std::logic_error("Test exception"));
+
+  bool run = false;
+  auto then = std::move(imm).thenValue([&](int x) {
+    run = true;
+    return x + 1;
+  });
+  EXPECT_FALSE(run);
+  EXPECT_TRUE(then.isReady());
+  EXPECT_THROW_RE(std::move(then).get(), std::logic_error, "Test exception");
+}
+
 TEST(ImmediateFuture, collectAllImmediate) {
   std::vector<ImmediateFuture<int>> vec;
   vec.push_back(ImmediateFuture<int>{42});
@@ -534,3 +569,41 @@ TEST(ImmediateFuture, unit_method_error) {
   auto res = std::move(future).getTry();
   EXPECT_THROW_RE(res.value(), std::logic_error, "Test");
 }
+
+#if FOLLY_HAS_COROUTINES
+TEST(ImmediateFuture, co_await_ready) {
+  auto task = []() -> folly::coro::Task<int> {
+    auto value = co_await ImmediateFuture<int>{41};
+    co_return value + 1;
+  };
+  EXPECT_EQ(42, folly::coro::blockingWait(task()));
+}
+
+TEST(ImmediateFuture, co_await_not_ready) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto task = [](ImmediateFuture<int> fut) -> folly::coro::Task<int> {
+    auto value = co_await std::move(fut);
+    co_return value + 1;
+  };
+
+  folly::ManualExecutor executor;
+  auto fut = task(ImmediateFuture<int>{std::move(semi)})
+                 .scheduleOn(&executor)
+                 .start();
+  executor.drain();
+  EXPECT_FALSE(fut.isReady());
+
+  promise.setValue(41);
+  executor.drain();
+  EXPECT_EQ(42, std::move(fut).get());
+}
+
+TEST(ImmediateFuture, co_await_exception) {
+  auto task = []() -> folly::coro::Task<int> {
+    co_return co_await makeImmediateFuture<int>(
+        std::logic_error("Test exception"));
+  };
+  EXPECT_THROW_RE(
+      folly::coro::blockingWait(task()), std::logic_error, "Test exception");
+}
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/InternedPathComponent.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/utils/PathMap.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+TEST(InternedPathComponent, sameNamesShareStorage) {
+  InternedPathComponent a{"foo"_pc};
+  InternedPathComponent b{"foo"_pc};
+  InternedPathComponent c{"bar"_pc};
+
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.stringPiece().data(), b.stringPiece().data());
+  EXPECT_NE(a, c);
+  EXPECT_EQ("foo"_pc, a.piece());
+  EXPECT_EQ("bar"_pc, c.piece());
+}
+
+TEST(InternedPathComponent, hashMatchesPathComponent) {
+  InternedPathComponent name{"some_file.txt"_pc};
+  EXPECT_EQ(
+      std::hash<PathComponent>{}(PathComponent{"some_file.txt"}),
+      std::hash<InternedPathComponent>{}(name));
+}
+
+TEST(InternedPathComponent, namesAreReleasedWithTheirLastReference) {
+  auto before = InternedPathComponent::getInternedCount();
+  {
+    InternedPathComponent a{"released_name"_pc};
+    auto b = a;
+    EXPECT_EQ(before + 1, InternedPathComponent::getInternedCount());
+    InternedPathComponent moved{std::move(a)};
+    EXPECT_EQ(before + 1, InternedPathComponent::getInternedCount());
+    EXPECT_EQ(b, moved);
+  }
+  EXPECT_EQ(before, InternedPathComponent::getInternedCount());
+
+  InternedPathComponent again{"released_name"_pc};
+  EXPECT_EQ("released_name"_pc, again.piece());
+  EXPECT_EQ(before + 1, InternedPathComponent::getInternedCount());
+}
+
+TEST(InternedPathComponent, concurrentInterning) {
+  constexpr size_t kThreads = 8;
+  constexpr size_t kIterations = 1000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([] {
+      for (size_t j = 0; j < kIterations; ++j) {
+        InternedPathComponent a{"contended"_pc};
+        InternedPathComponent b{"contended"_pc};
+        EXPECT_EQ(a, b);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  InternedPathComponent name{"contended"_pc};
+  EXPECT_EQ("contended"_pc, name.piece());
+}
+
+TEST(InternedPathComponent, pathMapKey) {
+  PathMap<int, InternedPathComponent> map{CaseSensitivity::Insensitive};
+  map.emplace("foo"_pc, 1);
+  map.emplace("Bar"_pc, 2);
+
+  EXPECT_EQ(1, map.at("foo"_pc));
+  EXPECT_EQ(1, map.at("FOO"_pc));
+  EXPECT_EQ(2, map.at("bar"_pc));
+  EXPECT_EQ(InternedPathComponent{"Bar"_pc}, map.find("bar"_pc)->first);
+}
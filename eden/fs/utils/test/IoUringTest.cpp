@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/utils/IoUring.h"
+
+#include <fcntl.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <chrono>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+class IoUringTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!IoUring::isSupported()) {
+      // Older kernels and sandboxes may not allow io_uring.
+      return;
+    }
+    ring_ = std::make_unique<IoUring>(4);
+  }
+
+  folly::test::TemporaryFile file_;
+  std::unique_ptr<IoUring> ring_;
+};
+
+} // namespace
+
+TEST_F(IoUringTest, writesReadsAndSyncs) {
+  if (!ring_) {
+    return;
+  }
+  int fd = file_.fd();
+
+  std::string hello{"hello"};
+  std::string world{" world"};
+  iovec iov[2] = {
+      {hello.data(), hello.size()},
+      {world.data(), world.size()},
+  };
+  EXPECT_EQ(11, ring_->pwritev(fd, iov, 2, 3).get(10s));
+  EXPECT_EQ(0, ring_->fsync(fd, /*datasync=*/true).get(10s));
+  EXPECT_EQ(0, ring_->fsync(fd, /*datasync=*/false).get(10s));
+
+  char buf[32];
+  EXPECT_EQ(8, ring_->pread(fd, buf, sizeof(buf), 6).get(10s));
+  EXPECT_EQ("lo world", std::string(buf, 8));
+
+  // Reads at EOF return 0.
+  EXPECT_EQ(0, ring_->pread(fd, buf, sizeof(buf), 14).get(10s));
+}
+
+TEST_F(IoUringTest, failuresReturnNegatedErrno) {
+  if (!ring_) {
+    return;
+  }
+  folly::File readOnly{file_.path().string(), O_RDONLY};
+  char buf[4] = {};
+  iovec iov{buf, sizeof(buf)};
+  EXPECT_EQ(-EBADF, ring_->pwritev(readOnly.fd(), &iov, 1, 0).get(10s));
+}
+
+TEST_F(IoUringTest, destructionWaitsForPendingOperations) {
+  if (!ring_) {
+    return;
+  }
+  std::vector<folly::SemiFuture<int>> futures;
+  std::string data(4096, 'x');
+  iovec iov{data.data(), data.size()};
+  for (int i = 0; i < 4; ++i) {
+    futures.push_back(ring_->pwritev(file_.fd(), &iov, 1, i * data.size()));
+  }
+  ring_.reset();
+
+  for (auto& future : futures) {
+    EXPECT_TRUE(future.isReady());
+    EXPECT_EQ(4096, std::move(future).get());
+  }
+}
+
+#endif
@@ -81,6 +81,39 @@ TEST_F(MappedDiskVectorTest, remembers_contents_on_reopen) {
   EXPECT_EQ(35, mdv[2]);
 }
 
+TEST_F(MappedDiskVectorTest, grows_geometrically) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  size_t remaps = 0;
+  auto capacity = mdv.capacity();
+  constexpr uint64_t N = 1000000;
+  for (uint64_t i = 0; i < N; ++i) {
+    mdv.emplace_back(i);
+    if (mdv.capacity() != capacity) {
+      // Each growth adds at least half of the previous size.
+      EXPECT_GE(mdv.capacity(), capacity + capacity / 2);
+      capacity = mdv.capacity();
+      ++remaps;
+    }
+  }
+  // Growing by a constant 1 MB would have taken 7 remaps.
+  EXPECT_LE(remaps, 5);
+}
+
+TEST_F(MappedDiskVectorTest, advice_and_flush_keep_contents) {
+  {
+    auto mdv = MappedDiskVector<U64>::open(mdvPath);
+    mdv.advise(MappedDiskVectorAccess::Random, /*useHugePages=*/true);
+    mdv.emplace_back(15ull);
+    mdv[0] = 16ull;
+    mdv.flushAsync();
+  }
+
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  mdv.advise(MappedDiskVectorAccess::Sequential);
+  EXPECT_EQ(1, mdv.size());
+  EXPECT_EQ(16, mdv[0]);
+}
+
 TEST_F(MappedDiskVectorTest, pop_back) {
   auto mdv = MappedDiskVector<U64>::open(mdvPath);
   mdv.emplace_back(1ull);
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/MemoryArena.h"
+
+#include <folly/portability/GTest.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace facebook::eden;
+
+TEST(MemoryArena, allocateAndDeallocate) {
+  auto& arena = MemoryArena::inodes();
+  std::vector<void*> allocations;
+  for (size_t size = 1; size <= 1 << 20; size *= 4) {
+    auto* ptr = arena.allocate(size);
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 0xab, size);
+    allocations.push_back(ptr);
+  }
+  size_t size = 1;
+  for (auto* ptr : allocations) {
+    arena.deallocate(ptr, size);
+    size *= 4;
+  }
+  arena.purge();
+}
+
+TEST(MemoryArena, statsCountActivePages) {
+  auto& arena = MemoryArena::objectCache();
+  if (!arena.getStats()) {
+    GTEST_SKIP() << "not using jemalloc";
+  }
+  constexpr size_t kSize = 4 << 20;
+  auto before = arena.getStats()->activeBytes;
+  auto* ptr = arena.allocate(kSize);
+  EXPECT_GE(arena.getStats()->activeBytes, before + kSize);
+  arena.deallocate(ptr, kSize);
+  arena.purge();
+  EXPECT_EQ(0, arena.getStats()->dirtyBytes);
+}
+
+TEST(MemoryArena, scopesNest) {
+  std::unique_ptr<std::vector<int>> outer;
+  std::unique_ptr<std::vector<int>> inner;
+  {
+    MemoryArena::Scope journalScope{MemoryArena::journal()};
+    outer = std::make_unique<std::vector<int>>(100);
+    {
+      MemoryArena::Scope cacheScope{MemoryArena::objectCache()};
+      inner = std::make_unique<std::vector<int>>(100);
+    }
+  }
+  // Memory from any arena can be freed outside of a Scope.
+  outer.reset();
+  inner.reset();
+  for (auto* arena : MemoryArena::getAll()) {
+    EXPECT_FALSE(arena->getName().empty());
+  }
+}
@@ -549,6 +549,46 @@ TEST(PathFuncs, PathComponent) {
   EXPECT_THROW_RE(PathComponent(".."), std::domain_error, "must not be \\.\\.");
 }
 
+TEST(PathFuncs, PathComponentLongNames) {
+  // Long enough to be checked in blocks, with a bad byte in every position.
+  const std::string name(40, 'x');
+  EXPECT_NO_THROW(PathComponent{name});
+  for (size_t i = 0; i < name.size(); ++i) {
+    auto withSlash = name;
+    withSlash[i] = '/';
+    EXPECT_THROW(PathComponent{withSlash}, std::domain_error) << i;
+    auto withNul = name;
+    withNul[i] = '\0';
+    EXPECT_THROW(PathComponent{withNul}, std::domain_error) << i;
+    auto withBadUtf8 = name;
+    withBadUtf8[i] = '\xff';
+    EXPECT_THROW(PathComponent{withBadUtf8}, std::domain_error) << i;
+  }
+  EXPECT_NO_THROW(PathComponent{
+      name + reinterpret_cast<const char*>(u8"\u00e9t\u00e9") + name});
+}
+
+TEST(PathFuncs, equalsIgnoringAsciiCase) {
+  EXPECT_TRUE(equalsIgnoringAsciiCase("", ""));
+  EXPECT_TRUE(equalsIgnoringAsciiCase("Foo", "fOO"));
+  EXPECT_FALSE(equalsIgnoringAsciiCase("foo", "foo2"));
+  EXPECT_FALSE(equalsIgnoringAsciiCase("[", "{"));
+  EXPECT_FALSE(equalsIgnoringAsciiCase("@", "`"));
+
+  const std::string lower = "abcdefghijklmnopqrstuvwxyz0123456789_@[`{";
+  const std::string upper = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_@[`{";
+  EXPECT_TRUE(equalsIgnoringAsciiCase(lower, upper));
+  for (size_t i = 0; i < lower.size(); ++i) {
+    auto changed = lower;
+    changed[i] = '-';
+    EXPECT_FALSE(equalsIgnoringAsciiCase(changed, upper)) << i;
+  }
+  // Only ASCII letters are folded.
+  EXPECT_FALSE(equalsIgnoringAsciiCase(
+      lower + "\xc3\xa9", upper + "\xc3\x89"));
+  EXPECT_FALSE(equalsIgnoringAsciiCase(lower + "\xe1", upper + "\xc1"));
+}
+
 TEST(PathFuncs, RelativePath) {
   RelativePath emptyRel;
   EXPECT_EQ("", emptyRel.stringPiece());
@@ -6,8 +6,11 @@
  */
 
 #include "eden/fs/utils/PathMap.h"
+#include <folly/Conv.h>
 #include <folly/portability/GTest.h>
 #include <folly/portability/Unistd.h>
+#include <algorithm>
+#include <random>
 
 using namespace facebook::eden;
 using namespace facebook::eden::path_literals;
@@ -83,6 +86,31 @@ TEST(PathMap, caseInSensitive) {
   EXPECT_EQ(map.begin()->first, "FOO"_pc);
 }
 
+TEST(PathMap, caseInSensitiveLookupInLargeMap) {
+  PathMap<int> map(CaseSensitivity::Insensitive);
+  for (int i = 0; i < 1000; ++i) {
+    map.emplace(PathComponent{folly::to<std::string>("File_", i, ".txt")}, i);
+  }
+  map.emplace(PathComponent{"Makefile"}, -1);
+  map.emplace(PathComponent{"makefile.inc"}, -2);
+  map.emplace(PathComponent{"a"}, -3);
+
+  EXPECT_EQ(map.at("file_0.TXT"_pc), 0);
+  EXPECT_EQ(map.at("FILE_999.txt"_pc), 999);
+  EXPECT_EQ(map.at("FiLe_500.TxT"_pc), 500);
+  EXPECT_EQ(map.at("MAKEFILE"_pc), -1);
+  EXPECT_EQ(map.at("MakeFile.INC"_pc), -2);
+  EXPECT_EQ(map.at("A"_pc), -3);
+  EXPECT_EQ(map.find("file_1000.txt"_pc), map.end());
+  EXPECT_EQ(map.find("file_1.tx"_pc), map.end());
+  EXPECT_EQ(map.find("file-1.txt"_pc), map.end());
+
+  EXPECT_FALSE(map.emplace(PathComponent{"MAKEFILE.inc"}, 0).second);
+  EXPECT_EQ(map.erase("file_42.txt"_pc), 1);
+  EXPECT_EQ(map.find("File_42.txt"_pc), map.end());
+  EXPECT_EQ(map.size(), 1002);
+}
+
 TEST(PathMap, caseInSensitiveCopyMove) {
   PathMap<bool> map(CaseSensitivity::Insensitive);
   map.insert(std::make_pair(PathComponent("foo"), true));
@@ -240,3 +268,98 @@ TEST(PathMap, swap) {
   EXPECT_EQ(0, b.size()) << "b now has 0 elements";
   EXPECT_EQ("foo", a.at("foo"_pc));
 }
+
+namespace {
+// Enough entries to be split across several chunks.
+constexpr size_t kLargeMapSize = PathMap<size_t>::kMaxChunkSize * 5;
+
+PathComponent largeMapName(size_t i) {
+  return PathComponent{folly::to<std::string>("File_", i)};
+}
+
+PathMap<size_t> makeLargeMap(CaseSensitivity caseSensitive) {
+  std::vector<size_t> order(kLargeMapSize);
+  for (size_t i = 0; i < kLargeMapSize; ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937{42});
+
+  PathMap<size_t> map{caseSensitive};
+  for (auto i : order) {
+    EXPECT_TRUE(map.emplace(largeMapName(i), i).second);
+  }
+  return map;
+}
+} // namespace
+
+TEST(PathMap, largeMapIsSorted) {
+  auto map = makeLargeMap(CaseSensitivity::Sensitive);
+  EXPECT_EQ(kLargeMapSize, map.size());
+  EXPECT_EQ(kLargeMapSize, static_cast<size_t>(map.end() - map.begin()));
+  EXPECT_TRUE(std::is_sorted(
+      map.begin(), map.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      }));
+
+  size_t count = 0;
+  for (auto it = map.rbegin(); it != map.rend(); ++it) {
+    ++count;
+  }
+  EXPECT_EQ(kLargeMapSize, count);
+
+  auto begin = map.cbegin();
+  for (size_t i = 0; i < kLargeMapSize; i += 97) {
+    EXPECT_EQ(largeMapName(begin[i].second), begin[i].first);
+  }
+}
+
+TEST(PathMap, largeMapLookup) {
+  auto map = makeLargeMap(CaseSensitivity::Sensitive);
+  for (size_t i = 0; i < kLargeMapSize; ++i) {
+    EXPECT_EQ(i, map.at(largeMapName(i)));
+  }
+  EXPECT_EQ(map.end(), map.find("File_"_pc));
+  EXPECT_EQ(map.end(), map.find("file_1"_pc));
+  EXPECT_EQ(map.end(), map.find("zzz"_pc));
+  EXPECT_FALSE(map.emplace(largeMapName(7), 0).second);
+  EXPECT_EQ(7, map.at(largeMapName(7)));
+}
+
+TEST(PathMap, largeMapCaseInsensitiveLookup) {
+  auto map = makeLargeMap(CaseSensitivity::Insensitive);
+  for (size_t i = 0; i < kLargeMapSize; i += 13) {
+    auto name = folly::to<std::string>("FILE_", i);
+    EXPECT_EQ(i, map.at(PathComponentPiece{name}));
+  }
+  EXPECT_FALSE(map.emplace("file_3"_pc, 0).second);
+}
+
+TEST(PathMap, largeMapErase) {
+  auto map = makeLargeMap(CaseSensitivity::Sensitive);
+  for (size_t i = 0; i < kLargeMapSize; i += 2) {
+    EXPECT_EQ(1, map.erase(largeMapName(i)));
+  }
+  EXPECT_EQ(kLargeMapSize / 2, map.size());
+
+  // Erase the rest while iterating.
+  size_t erased = 0;
+  for (auto it = map.begin(); it != map.end();) {
+    EXPECT_EQ(1, it->second % 2);
+    it = map.erase(it);
+    ++erased;
+  }
+  EXPECT_EQ(kLargeMapSize / 2, erased);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+
+  map.emplace("foo"_pc, 1);
+  EXPECT_EQ(1, map.at("foo"_pc));
+}
+
+TEST(PathMap, largeMapEquality) {
+  auto a = makeLargeMap(CaseSensitivity::Sensitive);
+  auto b = a;
+  EXPECT_EQ(a, b);
+  b.erase(largeMapName(3));
+  EXPECT_NE(a, b);
+}
@@ -147,6 +147,52 @@ TEST(proc_util, readMemoryStatsNoThrow) {
   EXPECT_FALSE(stats.has_value());
 }
 
+TEST(proc_util, parseProcCgroupFile) {
+  auto unified = parseProcCgroupFile("0::/user.slice/edenfs.service\n");
+  ASSERT_TRUE(unified.has_value());
+  EXPECT_EQ("/user.slice/edenfs.service", unified->path);
+  EXPECT_TRUE(unified->unified);
+
+  auto v1 = parseProcCgroupFile(
+      "12:cpu,cpuacct:/system.slice\n"
+      "4:memory:/system.slice/edenfs.service\n"
+      "0::/system.slice/edenfs.service\n");
+  ASSERT_TRUE(v1.has_value());
+  EXPECT_EQ("/system.slice/edenfs.service", v1->path);
+  EXPECT_FALSE(v1->unified);
+
+  EXPECT_FALSE(parseProcCgroupFile("12:cpu,cpuacct:/system.slice\n"));
+  EXPECT_FALSE(parseProcCgroupFile(""));
+}
+
+TEST(proc_util, parseCgroupMemoryLimit) {
+  EXPECT_EQ(8589934592, parseCgroupMemoryLimit("8589934592\n"));
+  EXPECT_FALSE(parseCgroupMemoryLimit("max\n"));
+  EXPECT_FALSE(parseCgroupMemoryLimit("9223372036854771712\n"));
+  EXPECT_FALSE(parseCgroupMemoryLimit("garbage"));
+}
+
+TEST(proc_util, parseProcStat) {
+  auto times = parseProcStat(
+      "cpu  100 20 30 800 50 0 0 0 0 0\n"
+      "cpu0 50 10 15 400 25 0 0 0 0 0\n");
+  ASSERT_TRUE(times);
+  EXPECT_EQ(1000, times->total);
+  EXPECT_EQ(150, times->busy);
+
+  EXPECT_FALSE(parseProcStat("cpu0 50 10 15 400 25 0 0 0 0 0\n"));
+  EXPECT_FALSE(parseProcStat("cpu  100 20\n"));
+  EXPECT_FALSE(parseProcStat(""));
+}
+
+TEST(proc_util, parseProcVmstatPagedBytes) {
+  EXPECT_EQ(
+      (3 + 4) * 1024,
+      parseProcVmstatPagedBytes("nr_free_pages 12\npgpgin 3\npgpgout 4\n"));
+  EXPECT_FALSE(parseProcVmstatPagedBytes("pgpgin 3\n"));
+  EXPECT_FALSE(parseProcVmstatPagedBytes(""));
+}
+
 TEST(proc_util, procSmapsPrivateBytes) {
   auto procPath = dataPath("ProcSmapsSimple.txt"_pc);
   std::ifstream input(procPath.c_str());
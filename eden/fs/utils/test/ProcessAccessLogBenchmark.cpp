@@ -19,17 +19,56 @@ struct ProcessAccessLogFixture : benchmark::Fixture {
   ProcessAccessLog processAccessLog{processNameCache};
 };
 
+BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_self)(benchmark::State& state) {
+  auto myPid = getpid();
+  for (auto _ : state) {
+    processAccessLog.recordAccess(
+        myPid, ProcessAccessLog::AccessType::FsChannelOther);
+  }
+}
+
+BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_self)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
 /**
- * A high but realistic amount of contention.
+ * What a FUSE request records: an access and its duration, from one of a
+ * handful of processes.
  */
-constexpr size_t kThreadCount = 4;
+BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_request_from_many_pids)
+(benchmark::State& state) {
+  constexpr pid_t kPidCount = 16;
+  pid_t pid = static_cast<pid_t>(state.thread_index() * 7);
+  for (auto _ : state) {
+    pid = (pid + 1) % kPidCount;
+    processAccessLog.recordAccess(
+        pid + 1, ProcessAccessLog::AccessType::FsChannelRead);
+    processAccessLog.recordDuration(pid + 1, std::chrono::microseconds{10});
+  }
+}
 
-BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_self)(benchmark::State& state) {
+BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_request_from_many_pids)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+/**
+ * Recording while the first thread reads the log every 1000 iterations, as
+ * `eden top` and the Thrift counters do.
+ */
+BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_self_while_reading)
+(benchmark::State& state) {
   auto myPid = getpid();
+  size_t iteration = 0;
   for (auto _ : state) {
     processAccessLog.recordAccess(
         myPid, ProcessAccessLog::AccessType::FsChannelOther);
+    if (state.thread_index() == 0 && ++iteration % 1000 == 0) {
+      benchmark::DoNotOptimize(
+          processAccessLog.getAccessCounts(std::chrono::seconds{10}));
+    }
   }
 }
 
-BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_self)->Threads(kThreadCount);
+BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_self_while_reading)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
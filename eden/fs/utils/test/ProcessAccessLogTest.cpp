@@ -8,7 +8,9 @@
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <sys/types.h>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
@@ -51,3 +53,34 @@ TEST(ProcessAccessLog, accessAddsProcessToProcessNameCache) {
   log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelOther);
   EXPECT_THAT(processNameCache->getAllProcessNames(), Contains(Key(Eq(pid))));
 }
+
+TEST(ProcessAccessLog, logsUsedByOneThreadAreKeptApart) {
+  auto pid = pid_t{42};
+  auto processNameCache = std::make_shared<ProcessNameCache>();
+  auto log1 = ProcessAccessLog{processNameCache};
+  auto log2 = ProcessAccessLog{processNameCache};
+
+  log1.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelRead);
+  log2.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelRead);
+  log2.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelRead);
+
+  EXPECT_EQ(1, *log1.getAccessCounts(10s)[pid].fsChannelReads_ref());
+  EXPECT_EQ(2, *log2.getAccessCounts(10s)[pid].fsChannelReads_ref());
+}
+
+TEST(ProcessAccessLog, accessesOfExitedThreadsAreKept) {
+  auto pid = pid_t{42};
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelWrite);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(4, *log.getAccessCounts(10s)[pid].fsChannelWrites_ref());
+}
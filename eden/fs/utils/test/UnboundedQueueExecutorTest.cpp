@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+#include <folly/executors/ManualExecutor.h>
+#include <folly/futures/Future.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <vector>
+
+using namespace facebook::eden;
+
+TEST(UnboundedQueueExecutor, highPriorityWorkRunsBeforeLowPriorityWork) {
+  UnboundedQueueExecutor executor{1, "Test"};
+  EXPECT_EQ(
+      UnboundedQueueExecutor::kNumPriorities, executor.getNumPriorities());
+
+  // Keep the only worker busy while work is queued.
+  folly::Baton<> started;
+  folly::Baton<> unblock;
+  executor.add([&] {
+    started.post();
+    unblock.wait();
+  });
+  started.wait();
+
+  std::vector<int> order;
+  folly::Baton<> done;
+  auto lowPriority = executor.getLowPriorityExecutor();
+  lowPriority->add([&] { order.push_back(1); });
+  executor.add([&] { order.push_back(2); });
+  lowPriority->add([&] {
+    order.push_back(3);
+    done.post();
+  });
+  unblock.post();
+  done.wait();
+
+  EXPECT_EQ((std::vector<int>{2, 1, 3}), order);
+}
+
+TEST(UnboundedQueueExecutor, manualExecutorIgnoresPriorities) {
+  auto manual = std::make_shared<folly::ManualExecutor>();
+  UnboundedQueueExecutor executor{manual};
+
+  std::vector<int> order;
+  executor.getLowPriorityExecutor()->add([&] { order.push_back(1); });
+  executor.add([&] { order.push_back(2); });
+  manual->drain();
+
+  EXPECT_EQ((std::vector<int>{1, 2}), order);
+}
@@ -35,6 +35,23 @@ TEST(Utf8Test, isValidUtf8) {
   EXPECT_FALSE(isValidUtf8("\xA0prefix\xB0"));
 }
 
+TEST(Utf8Test, isValidUtf8LongStrings) {
+  // Long ASCII runs are skipped in blocks, so put characters at every offset.
+  const std::string ascii(40, 'a');
+  EXPECT_TRUE(isValidUtf8(ascii));
+  for (size_t i = 0; i <= ascii.size(); ++i) {
+    auto prefix = ascii.substr(0, i);
+    auto suffix = ascii.substr(i);
+    EXPECT_TRUE(isValidUtf8(
+        prefix + reinterpret_cast<const char*>(u8"\U00010348") + suffix))
+        << i;
+    EXPECT_FALSE(isValidUtf8(prefix + "\xff" + suffix)) << i;
+    EXPECT_FALSE(isValidUtf8(prefix + "\xF0\x82\x82\xAC" + suffix)) << i;
+  }
+  // A multi-byte character cut short by the end of the string.
+  EXPECT_FALSE(isValidUtf8(ascii + "\xE0\xA4"));
+}
+
 TEST(Utf8String, ensureValidUtf8) {
   for (auto str : kValidStrings) {
     EXPECT_EQ(str, ensureValidUtf8(str));
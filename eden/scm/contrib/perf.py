@@ -50,6 +50,7 @@ from edenscm.mercurial import (
     mdiff,
     merge,
     revlog,
+    store,
     util,
 )
 
@@ -1033,6 +1034,25 @@ def perffncacheencode(ui, repo, **opts):
     fm.end()
 
 
+@command(
+    "perfpathencode",
+    [("r", "rev", ".", "revision whose file paths to encode")] + formatteropts,
+)
+def perfpathencode(ui, repo, rev, **opts):
+    """benchmark the store encoding of every file path of a revision"""
+    timer, fm = gettimer(ui, opts)
+    ctx = scmutil.revsingle(repo, rev, rev)
+    paths = ["data/%s.i" % f for f in ctx.manifest()]
+    encode = store._pathencode
+
+    def d():
+        for p in paths:
+            encode(p)
+
+    timer(d)
+    fm.end()
+
+
 @command("perfdiffwd", formatteropts)
 def perfdiffwd(ui, repo, **opts):
     """Profile diff of working directory changes"""
@@ -783,6 +783,72 @@ nomem:
   return NULL;
 }
 
+/* the most bytes of unmodified lines that diff compares in one memcmp */
+#define DIFF_BLOCK_SIZE 4096
+
+static bool lineeq(const line* left, const line* right) {
+  return left->len == right->len && left->hash_suffix == right->hash_suffix &&
+      (left->start == right->start ||
+       memcmp(left->start, right->start, left->len) == 0);
+}
+
+/*
+ * Count the lines that are identical in both manifests, starting at
+ * self->lines[sneedle] and other->lines[oneedle].
+ *
+ * Lines that weren't modified lie back to back in the manifest text, and
+ * manifests copied from one another share that text, so runs of them are
+ * compared a block at a time instead of line by line.
+ */
+static int countidentical(
+    lazymanifest* self,
+    int sneedle,
+    lazymanifest* other,
+    int oneedle) {
+  int n = 0;
+  while (sneedle + n < self->numlines && oneedle + n < other->numlines) {
+    line* left = self->lines + sneedle + n;
+    line* right = other->lines + oneedle + n;
+    int count = 0;
+    Py_ssize_t size = 0;
+    if (left->deleted || right->deleted) {
+      break;
+    }
+    while (sneedle + n + count < self->numlines &&
+           oneedle + n + count < other->numlines) {
+      line* l = left + count;
+      line* r = right + count;
+      if (l->deleted || r->deleted || l->from_malloc || r->from_malloc ||
+          l->len != r->len || l->hash_suffix != r->hash_suffix ||
+          l->start != left->start + size || r->start != right->start + size ||
+          size + l->len > DIFF_BLOCK_SIZE) {
+        break;
+      }
+      size += l->len;
+      count++;
+    }
+    if (count > 1) {
+      if (left->start == right->start ||
+          memcmp(left->start, right->start, size) == 0) {
+        n += count;
+        continue;
+      }
+      /* one of the lines in the block differs, find it */
+      while (lineeq(left, right)) {
+        left++;
+        right++;
+        n++;
+      }
+      break;
+    }
+    if (!lineeq(left, right)) {
+      break;
+    }
+    n++;
+  }
+  return n;
+}
+
 static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
   lazymanifest* other;
   PyObject* pyclean = NULL;
@@ -817,6 +883,16 @@ static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
     int result;
     PyObject* key;
     PyObject* outer;
+    /* Unless clean files are listed, skip over the identical lines
+     * without creating any Python objects for them. */
+    if (!listclean) {
+      int identical = countidentical(self, sneedle, other, oneedle);
+      if (identical > 0) {
+        sneedle += identical;
+        oneedle += identical;
+        continue;
+      }
+    }
     /* If we're looking at a deleted entry and it's not
      * the end of the manifest, just skip it. */
     if (sneedle < self->numlines && left->deleted) {
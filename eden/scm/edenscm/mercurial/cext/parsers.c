@@ -17,7 +17,9 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <ctype.h>
+#include <limits.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "eden/scm/edenscm/mercurial/bitmanipulation.h"
@@ -250,26 +252,21 @@ PyTypeObject dirstateTupleType = {
     dirstate_tuple_new, /* tp_new */
 };
 
-static PyObject* parse_dirstate(PyObject* self, PyObject* args) {
-  PyObject *dmap, *cmap, *parents = NULL, *ret = NULL;
+/*
+ * Fill the dmap and cmap dicts from the dirstate in str, and return its
+ * parents.
+ */
+static PyObject* parse_dirstate_data(
+    PyObject* dmap,
+    PyObject* cmap,
+    const char* str,
+    Py_ssize_t len) {
+  PyObject *parents = NULL, *ret = NULL;
   PyObject *fname = NULL, *cname = NULL, *entry = NULL;
-  char state, *cur, *str, *cpos;
+  const char *cur, *cpos;
+  char state;
   int mode, size, mtime;
   unsigned int flen, pos = 40;
-  Py_ssize_t readlen, len;
-
-  if (!PyArg_ParseTuple(
-          args,
-          "O!O!s#:parse_dirstate",
-          &PyDict_Type,
-          &dmap,
-          &PyDict_Type,
-          &cmap,
-          &str,
-          &readlen))
-    goto quit;
-
-  len = readlen;
 
   /* read parents */
   if (len < 40) {
@@ -347,6 +344,368 @@ quit:
   return ret;
 }
 
+static PyObject* parse_dirstate(PyObject* self, PyObject* args) {
+  PyObject *dmap, *cmap;
+  char* str;
+  Py_ssize_t len;
+
+  if (!PyArg_ParseTuple(
+          args,
+          "O!O!s#:parse_dirstate",
+          &PyDict_Type,
+          &dmap,
+          &PyDict_Type,
+          &cmap,
+          &str,
+          &len))
+    return NULL;
+
+  return parse_dirstate_data(dmap, cmap, str, len);
+}
+
+/*
+ * lazydirstate - a dirstate that is parsed on demand.
+ *
+ * Constructing one validates the dirstate in a single pass and builds an
+ * index of pointers to its entries, sorted by file name. Nothing else is
+ * copied: lookups binary search the index and only create Python objects
+ * for the entries they return. The data may be any buffer, such as an mmap
+ * of the dirstate file, which is kept alive for the lifetime of the object.
+ */
+
+typedef struct {
+  const char* name; /* file name, which follows the 17 byte entry header */
+  unsigned int namelen; /* length of the file name, without a copy source */
+} lazydirstateentry;
+
+typedef struct {
+  PyObject_HEAD Py_buffer data;
+  lazydirstateentry* entries;
+  Py_ssize_t numentries;
+} lazydirstate;
+
+#define DIRSTATE_OOM -1
+#define DIRSTATE_NO_PARENTS -2
+#define DIRSTATE_OVERFLOW -3
+
+static int lazydirstate_namecmp(const void* left, const void* right) {
+  const lazydirstateentry* l = left;
+  const lazydirstateentry* r = right;
+  unsigned int n = l->namelen < r->namelen ? l->namelen : r->namelen;
+  int cmp = memcmp(l->name, r->name, n);
+  if (cmp != 0) {
+    return cmp;
+  }
+  if (l->namelen != r->namelen) {
+    return l->namelen < r->namelen ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Sort duplicate names by their position, so the last one can be kept. */
+static int lazydirstate_entrycmp(const void* left, const void* right) {
+  const lazydirstateentry* l = left;
+  const lazydirstateentry* r = right;
+  int cmp = lazydirstate_namecmp(left, right);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return l->name < r->name ? -1 : (l->name > r->name ? 1 : 0);
+}
+
+/*
+ * Validate the dirstate in the same way as parse_dirstate, and build the
+ * sorted index of its entries. This does not use the Python API, so it can
+ * run without the GIL.
+ */
+static int lazydirstate_index(lazydirstate* self) {
+  const char* str = self->data.buf;
+  Py_ssize_t len = self->data.len;
+  Py_ssize_t maxentries = 0, i, kept;
+  unsigned int flen, pos = 40;
+  lazydirstateentry* entry;
+  const char* cpos;
+  int sorted = 1;
+
+  if (len < 40) {
+    return DIRSTATE_NO_PARENTS;
+  }
+
+  while (pos >= 40 && pos < len) {
+    if (pos + 17 > len) {
+      return DIRSTATE_OVERFLOW;
+    }
+    flen = getbe32(str + pos + 13);
+    pos += 17;
+    if (flen > len - pos) {
+      return DIRSTATE_OVERFLOW;
+    }
+    if (self->numentries == maxentries) {
+      /* Start from a guess based on the size of a typical entry. */
+      lazydirstateentry* entries;
+      maxentries = maxentries ? maxentries * 2 : (len - pos) / 64 + 16;
+      entries =
+          realloc(self->entries, maxentries * sizeof(lazydirstateentry));
+      if (!entries) {
+        return DIRSTATE_OOM;
+      }
+      self->entries = entries;
+    }
+    entry = &self->entries[self->numentries++];
+    entry->name = str + pos;
+    cpos = memchr(entry->name, 0, flen);
+    entry->namelen = cpos ? (unsigned int)(cpos - entry->name) : flen;
+    pos += flen;
+    /* Dirstates written after a full checkout are usually in order. */
+    if (sorted && self->numentries > 1 &&
+        lazydirstate_namecmp(entry - 1, entry) >= 0) {
+      sorted = 0;
+    }
+  }
+
+  if (!sorted) {
+    qsort(
+        self->entries,
+        self->numentries,
+        sizeof(lazydirstateentry),
+        lazydirstate_entrycmp);
+    /* Like the dicts parse_dirstate fills, the last duplicate wins. */
+    kept = 0;
+    for (i = 0; i < self->numentries; i++) {
+      if (i + 1 < self->numentries &&
+          lazydirstate_namecmp(&self->entries[i], &self->entries[i + 1]) ==
+              0) {
+        continue;
+      }
+      self->entries[kept++] = self->entries[i];
+    }
+    self->numentries = kept;
+  }
+  return 0;
+}
+
+static void lazydirstate_clear(lazydirstate* self) {
+  free(self->entries);
+  self->entries = NULL;
+  self->numentries = 0;
+  if (self->data.obj) {
+    PyBuffer_Release(&self->data);
+  }
+}
+
+static int lazydirstate_init(lazydirstate* self, PyObject* args) {
+  PyObject* pydata;
+  int ret;
+
+  if (!PyArg_ParseTuple(args, "O:lazydirstate", &pydata)) {
+    return -1;
+  }
+  lazydirstate_clear(self);
+  if (PyObject_GetBuffer(pydata, &self->data, PyBUF_SIMPLE) == -1) {
+    return -1;
+  }
+
+  Py_BEGIN_ALLOW_THREADS ret = lazydirstate_index(self);
+  Py_END_ALLOW_THREADS switch (ret) {
+    case 0:
+      return 0;
+    case DIRSTATE_OOM:
+      PyErr_NoMemory();
+      break;
+    case DIRSTATE_NO_PARENTS:
+      PyErr_SetString(PyExc_ValueError, "too little data for parents");
+      break;
+    default:
+      PyErr_SetString(PyExc_ValueError, "overflow in dirstate");
+  }
+  lazydirstate_clear(self);
+  return -1;
+}
+
+static void lazydirstate_dealloc(lazydirstate* self) {
+  lazydirstate_clear(self);
+  PyObject_Del(self);
+}
+
+/*
+ * Find the entry for a file name. Returns NULL without an exception set if
+ * there is none, including for keys that cannot be file names.
+ */
+static lazydirstateentry* lazydirstate_find(
+    lazydirstate* self,
+    PyObject* key) {
+  lazydirstateentry needle;
+  Py_ssize_t len;
+
+#ifdef IS_PY3K
+  if (!PyUnicode_Check(key)) {
+    return NULL;
+  }
+  needle.name = PyUnicode_AsUTF8AndSize(key, &len);
+  if (!needle.name) {
+    /* Names that aren't valid UTF-8 could never have been parsed. */
+    PyErr_Clear();
+    return NULL;
+  }
+#else
+  if (!PyBytes_Check(key)) {
+    return NULL;
+  }
+  needle.name = PyBytes_AS_STRING(key);
+  len = PyBytes_GET_SIZE(key);
+#endif
+  if ((size_t)len > UINT_MAX) {
+    return NULL;
+  }
+  needle.namelen = (unsigned int)len;
+  return bsearch(
+      &needle,
+      self->entries,
+      self->numentries,
+      sizeof(lazydirstateentry),
+      lazydirstate_namecmp);
+}
+
+static PyObject* lazydirstate_entrytuple(lazydirstateentry* entry) {
+  const char* cur = entry->name - 17;
+  return (PyObject*)make_dirstate_tuple(
+      *cur, getbe32(cur + 1), getbe32(cur + 5), getbe32(cur + 9));
+}
+
+static Py_ssize_t lazydirstate_size(lazydirstate* self) {
+  return self->numentries;
+}
+
+static PyObject* lazydirstate_getitem(lazydirstate* self, PyObject* key) {
+  lazydirstateentry* entry = lazydirstate_find(self, key);
+  if (!entry) {
+    PyErr_SetObject(PyExc_KeyError, key);
+    return NULL;
+  }
+  return lazydirstate_entrytuple(entry);
+}
+
+static int lazydirstate_contains(lazydirstate* self, PyObject* key) {
+  return lazydirstate_find(self, key) != NULL;
+}
+
+static PyObject* lazydirstate_get(lazydirstate* self, PyObject* args) {
+  PyObject *key, *def = Py_None;
+  lazydirstateentry* entry;
+
+  if (!PyArg_ParseTuple(args, "O|O:get", &key, &def)) {
+    return NULL;
+  }
+  entry = lazydirstate_find(self, key);
+  if (!entry) {
+    Py_INCREF(def);
+    return def;
+  }
+  return lazydirstate_entrytuple(entry);
+}
+
+static PyObject* lazydirstate_parents(lazydirstate* self) {
+  const char* str = self->data.buf;
+#ifdef IS_PY3K
+  return Py_BuildValue("y#y#", str, (Py_ssize_t)20, str + 20, (Py_ssize_t)20);
+#else
+  return Py_BuildValue("s#s#", str, (Py_ssize_t)20, str + 20, (Py_ssize_t)20);
+#endif
+}
+
+static PyObject* lazydirstate_todict(lazydirstate* self, PyObject* args) {
+  PyObject *dmap, *cmap;
+
+  if (!PyArg_ParseTuple(
+          args, "O!O!:todict", &PyDict_Type, &dmap, &PyDict_Type, &cmap)) {
+    return NULL;
+  }
+  /* Reparse the data, so the dicts keep the order of the file. */
+  return parse_dirstate_data(dmap, cmap, self->data.buf, self->data.len);
+}
+
+static PyMappingMethods lazydirstate_mapping_methods = {
+    (lenfunc)lazydirstate_size, /* mp_length */
+    (binaryfunc)lazydirstate_getitem, /* mp_subscript */
+    0, /* mp_ass_subscript */
+};
+
+/* sequence methods (important or __contains__ builds an iterator) */
+static PySequenceMethods lazydirstate_seq_meths = {
+    (lenfunc)lazydirstate_size, /* sq_length */
+    0, /* sq_concat */
+    0, /* sq_repeat */
+    0, /* sq_item */
+    0, /* sq_slice */
+    0, /* sq_ass_item */
+    0, /* sq_ass_slice */
+    (objobjproc)lazydirstate_contains, /* sq_contains */
+    0, /* sq_inplace_concat */
+    0, /* sq_inplace_repeat */
+};
+
+static PyMethodDef lazydirstate_methods[] = {
+    {"get",
+     (PyCFunction)lazydirstate_get,
+     METH_VARARGS,
+     "Return the dirstate tuple of a file, or a default."},
+    {"parents",
+     (PyCFunction)lazydirstate_parents,
+     METH_NOARGS,
+     "Return the parents of the working copy."},
+    {"todict",
+     (PyCFunction)lazydirstate_todict,
+     METH_VARARGS,
+     "Fill dicts of the dirstate and copies, like parse_dirstate."},
+    {NULL},
+};
+
+#ifdef IS_PY3K
+#define LAZYDIRSTATE_TPFLAGS Py_TPFLAGS_DEFAULT
+#else
+#define LAZYDIRSTATE_TPFLAGS Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_SEQUENCE_IN
+#endif
+
+static PyTypeObject lazydirstateType = {
+    PyVarObject_HEAD_INIT(NULL, 0) /* header */
+    "parsers.lazydirstate", /* tp_name */
+    sizeof(lazydirstate), /* tp_basicsize */
+    0, /* tp_itemsize */
+    (destructor)lazydirstate_dealloc, /* tp_dealloc */
+    0, /* tp_print */
+    0, /* tp_getattr */
+    0, /* tp_setattr */
+    0, /* tp_compare */
+    0, /* tp_repr */
+    0, /* tp_as_number */
+    &lazydirstate_seq_meths, /* tp_as_sequence */
+    &lazydirstate_mapping_methods, /* tp_as_mapping */
+    0, /* tp_hash */
+    0, /* tp_call */
+    0, /* tp_str */
+    0, /* tp_getattro */
+    0, /* tp_setattro */
+    0, /* tp_as_buffer */
+    LAZYDIRSTATE_TPFLAGS, /* tp_flags */
+    "dirstate that is parsed on demand", /* tp_doc */
+    0, /* tp_traverse */
+    0, /* tp_clear */
+    0, /* tp_richcompare */
+    0, /* tp_weaklistoffset */
+    0, /* tp_iter */
+    0, /* tp_iternext */
+    lazydirstate_methods, /* tp_methods */
+    0, /* tp_members */
+    0, /* tp_getset */
+    0, /* tp_base */
+    0, /* tp_dict */
+    0, /* tp_descr_get */
+    0, /* tp_descr_set */
+    0, /* tp_dictoffset */
+    (initproc)lazydirstate_init, /* tp_init */
+    0, /* tp_alloc */
+};
+
 /*
  * Build a set of non-normal and other parent entries from the dirstate dmap
  */
@@ -841,6 +1200,12 @@ static void module_init(PyObject* mod) {
     return;
   Py_INCREF(&dirstateTupleType);
   PyModule_AddObject(mod, "dirstatetuple", (PyObject*)&dirstateTupleType);
+
+  lazydirstateType.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&lazydirstateType) < 0)
+    return;
+  Py_INCREF(&lazydirstateType);
+  PyModule_AddObject(mod, "lazydirstate", (PyObject*)&lazydirstateType);
 }
 
 static int check_python_version(void) {
@@ -29,6 +29,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PATHENCODE_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PATHENCODE_NEON
+#endif
+
 #include "eden/scm/edenscm/mercurial/cext/util.h"
 
 /* state machine for the fast path */
@@ -62,6 +70,63 @@ static inline int inset(const uint32_t bitset[], char c) {
   return bitset[((uint8_t)c) >> 5] & (1u << (((uint8_t)c) & 31));
 }
 
+/*
+ * Return the length of the run of lowercase letters, digits and '-'
+ * at the start of src. Every encoding below copies those bytes
+ * unchanged, and long runs of them are common, so where SIMD is
+ * available they are classified 16 at a time and the run can be copied
+ * in bulk. The last len % 16 bytes are not looked at, and neither is
+ * anything without SIMD: the byte-by-byte loops handle those.
+ */
+static inline Py_ssize_t safeprefix(const char* src, Py_ssize_t len) {
+  Py_ssize_t n = 0;
+
+#if defined(PATHENCODE_SSE2)
+  /* Bytes above 0x7f are negative, so they fail the signed compares. */
+  const __m128i beforelower = _mm_set1_epi8('a' - 1);
+  const __m128i afterlower = _mm_set1_epi8('z' + 1);
+  const __m128i beforedigit = _mm_set1_epi8('0' - 1);
+  const __m128i afterdigit = _mm_set1_epi8('9' + 1);
+  const __m128i dash = _mm_set1_epi8('-');
+
+  for (; n + 16 <= len; n += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + n));
+    __m128i lower = _mm_and_si128(
+        _mm_cmpgt_epi8(v, beforelower), _mm_cmplt_epi8(v, afterlower));
+    __m128i digit = _mm_and_si128(
+        _mm_cmpgt_epi8(v, beforedigit), _mm_cmplt_epi8(v, afterdigit));
+    __m128i safe =
+        _mm_or_si128(_mm_or_si128(lower, digit), _mm_cmpeq_epi8(v, dash));
+    unsigned mask = (unsigned)_mm_movemask_epi8(safe);
+    if (mask != 0xffff)
+      return n + __builtin_ctz(~mask);
+  }
+#elif defined(PATHENCODE_NEON)
+  const uint8x16_t lowerbase = vdupq_n_u8('a');
+  const uint8x16_t lowerspan = vdupq_n_u8('z' - 'a');
+  const uint8x16_t digitbase = vdupq_n_u8('0');
+  const uint8x16_t digitspan = vdupq_n_u8('9' - '0');
+  const uint8x16_t dash = vdupq_n_u8('-');
+
+  for (; n + 16 <= len; n += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*)src + n);
+    uint8x16_t lower = vcleq_u8(vsubq_u8(v, lowerbase), lowerspan);
+    uint8x16_t digit = vcleq_u8(vsubq_u8(v, digitbase), digitspan);
+    uint8x16_t safe = vorrq_u8(vorrq_u8(lower, digit), vceqq_u8(v, dash));
+    /* Narrow each byte of the comparison to 4 bits of a 64-bit mask. */
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(safe), 4)), 0);
+    if (mask != ~(uint64_t)0)
+      return n + (__builtin_ctzll(~mask) >> 2);
+  }
+#else
+  (void)src;
+  (void)len;
+#endif
+
+  return n;
+}
+
 static inline void
 charcopy(char* dest, Py_ssize_t* destlen, size_t destsize, char c) {
   if (dest) {
@@ -78,7 +143,7 @@ static inline void memcopy(
     const void* src,
     Py_ssize_t len) {
   if (dest) {
-    assert(*destlen + len < destsize);
+    assert(*destlen + len <= destsize);
     memcpy((void*)&dest[*destlen], src, len);
   }
   *destlen += len;
@@ -136,11 +201,19 @@ _encodedir(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
         }
         state = DDEFAULT;
         break;
-      case DDEFAULT:
+      case DDEFAULT: {
+        Py_ssize_t n = safeprefix(&src[i], len - i);
+        if (n > 0) {
+          memcopy(dest, &destlen, destsize, &src[i], n);
+          i += n;
+          if (i == len)
+            break;
+        }
         if (src[i] == '.')
           state = DDOT;
         charcopy(dest, &destlen, destsize, src[i++]);
         break;
+      }
     }
   }
 
@@ -443,7 +516,15 @@ static Py_ssize_t _encode(
             break;
         }
         break;
-      case DEFAULT:
+      case DEFAULT: {
+        /* Every caller's onebyte set includes the safe bytes. */
+        Py_ssize_t n = safeprefix(&src[i], len - i);
+        if (n > 0) {
+          memcopy(dest, &destlen, destsize, &src[i], n);
+          i += n;
+          if (i == len)
+            goto done;
+        }
         while (inset(onebyte, src[i])) {
           charcopy(dest, &destlen, destsize, src[i++]);
           if (i == len)
@@ -477,6 +558,7 @@ static Py_ssize_t _encode(
             break;
         }
         break;
+      }
     }
   }
 done:
@@ -510,6 +592,13 @@ _lowerencode(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
   Py_ssize_t i, destlen = 0;
 
   for (i = 0; i < len; i++) {
+    Py_ssize_t n = safeprefix(&src[i], len - i);
+    if (n > 0) {
+      memcopy(dest, &destlen, destsize, &src[i], n);
+      i += n;
+      if (i == len)
+        break;
+    }
     if (inset(onebyte, src[i]))
       charcopy(dest, &destlen, destsize, src[i]);
     else if (inset(lower, src[i]))
@@ -41,6 +41,10 @@ Config
 
   # whether to skip config or env change checks
   skiphash = False
+
+  # how many idle workers to fork ahead of connections, so that commands do
+  # not wait for the server to fork (0 forks a worker per connection)
+  preforkworkers = 2
 """
 
 from __future__ import absolute_import
@@ -315,6 +319,7 @@ class chgunixservicehandler(object):
     def __init__(self, ui):
         self.ui = ui
         self._idletimeout = ui.configint("chgserver", "idletimeout")
+        self.preforkworkers = ui.configint("chgserver", "preforkworkers")
         self._lastactive = time.time()
 
     def bindsocket(self, sock, address):
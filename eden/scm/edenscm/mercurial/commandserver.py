@@ -435,6 +435,10 @@ class unixservicehandler(object):
 
     pollinterval = None
 
+    # number of idle workers to fork ahead of connections; 0 forks a worker
+    # once a connection is accepted
+    preforkworkers = 0
+
     def __init__(self, ui):
         self.ui = ui
 
@@ -462,7 +466,9 @@ class unixservicehandler(object):
 
 class unixforkingservice(object):
     """
-    Listens on unix domain socket and forks server per connection
+    Listens on unix domain socket and forks server per connection, either
+    once the connection is accepted or ahead of it if the handler sets
+    preforkworkers
     """
 
     def __init__(self, ui, repo, opts, handler=None):
@@ -477,6 +483,7 @@ class unixforkingservice(object):
         self._sock = None
         self._oldsigchldhandler = None
         self._workerpids = set()  # updated by signal handler; do not iterate
+        self._idlepids = set()  # preforked workers yet to accept
         self._socketunlinked = None
 
     def init(self):
@@ -517,6 +524,9 @@ class unixforkingservice(object):
             self._cleanup()
 
     def _mainloop(self):
+        if self._servicehandler.preforkworkers > 0:
+            self._preforkmainloop()
+            return
         exiting = False
         h = self._servicehandler
         selector = selectors2.DefaultSelector()
@@ -565,6 +575,99 @@ class unixforkingservice(object):
                         os._exit(255)
         selector.close()
 
+    def _preforkmainloop(self):
+        """Keep a pool of idle workers which accept connections themselves
+
+        The workers are forked before clients connect, so a client does not
+        wait for the main process to fork. Each worker tells the main process
+        its pid through a pipe once it accepts a connection, and the main
+        process forks another to take its place.
+        """
+        h = self._servicehandler
+        # accept() is raced by the idle workers; the losers get EAGAIN
+        self._sock.setblocking(False)
+        notifyr, notifyw = os.pipe()
+        # closed to tell the idle workers to exit
+        stopr, stopw = os.pipe()
+        selector = selectors2.DefaultSelector()
+        selector.register(notifyr, selectors2.EVENT_READ)
+        try:
+            while True:
+                if h.shouldexit():
+                    # idle workers accept the connections that are queued
+                    # already, then exit once they see the pipe closed.
+                    self._unlinksocket()
+                    break
+                while len(self._idlepids & self._workerpids) < h.preforkworkers:
+                    self._preforkworker(selector, (notifyr, notifyw), (stopr, stopw))
+                if selector.select(timeout=h.pollinterval):
+                    self._readnotifications(notifyr)
+        finally:
+            selector.close()
+            for fd in (notifyr, notifyw, stopr, stopw):
+                os.close(fd)
+            self._idlepids.clear()
+
+    def _preforkworker(self, selector, notifypipe, stoppipe):
+        pid = os.fork()
+        if pid:
+            self.ui.debug("preforked worker process (pid=%d)\n" % pid)
+            self._workerpids.add(pid)
+            self._idlepids.add(pid)
+            return
+        notifyr, notifyw = notifypipe
+        stopr, stopw = stoppipe
+        try:
+            selector.close()
+            # the write end must only be open in the main process, for the
+            # worker to see it closed
+            os.close(stopw)
+            os.close(notifyr)
+            conn = self._acceptpreforked(stopr)
+            if conn:
+                os.write(notifyw, struct.pack(">i", os.getpid()))
+                os.close(notifyw)
+                self._runworker(conn)
+                conn.close()
+            os._exit(0)
+        except:  # never return, hence no re-raises
+            try:
+                self.ui.traceback(force=True)
+            finally:
+                os._exit(255)
+
+    def _acceptpreforked(self, stopr):
+        """Wait for a connection in a preforked worker
+
+        Return None if the main process stopped before one was accepted.
+        """
+        selector = selectors2.DefaultSelector()
+        selector.register(self._sock, selectors2.EVENT_READ)
+        selector.register(stopr, selectors2.EVENT_READ)
+        try:
+            while True:
+                ready = selector.select()
+                try:
+                    conn, _addr = self._sock.accept()
+                except socket.error as inst:
+                    if inst.args[0] not in (errno.EAGAIN, errno.EINTR):
+                        raise
+                    if any(key.fileobj == stopr for key, _events in ready):
+                        return None
+                    continue
+                conn.setblocking(True)
+                return conn
+        finally:
+            selector.close()
+            self._sock.close()
+
+    def _readnotifications(self, notifyr):
+        # pids are written whole, as they are shorter than PIPE_BUF
+        data = os.read(notifyr, 4096)
+        for (pid,) in struct.iter_unpack(">i", data):
+            self._idlepids.discard(pid)
+            self._servicehandler.newconnection()
+
     def _sigchldhandler(self, signal, frame):
         self._reapworkers(os.WNOHANG)
 
@@ -584,6 +687,7 @@ class unixforkingservice(object):
                 # no waitable child processes
                 return
             self._workerpids.discard(pid)
+            self._idlepids.discard(pid)
 
     def _runworker(self, conn):
         util.signal(signal.SIGCHLD, self._oldsigchldhandler)
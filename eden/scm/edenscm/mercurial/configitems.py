@@ -149,6 +149,7 @@ coreconfigitem("bundle", "reorder", default="auto")
 coreconfigitem("censor", "policy", default="abort")
 coreconfigitem("checkout", "resumable", default=True)
 coreconfigitem("chgserver", "idletimeout", default=3600)
+coreconfigitem("chgserver", "preforkworkers", default=2)
 coreconfigitem("chgserver", "skiphash", default=False)
 coreconfigitem("clone", "prefer-edenapi-clonedata", default=True)
 coreconfigitem("clone", "nativepull", default=False)
@@ -17,6 +17,7 @@ from __future__ import absolute_import
 import collections
 import contextlib
 import errno
+import mmap
 import os
 import stat
 import tempfile
@@ -1496,12 +1497,21 @@ class dirstatemap(object):
     def get(
         self, key: str, default: "Optional[dirstatetuple]" = None
     ) -> "Optional[dirstatetuple]":
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return lazymap.get(key, default)
         return self._map.get(key, default)
 
     def __contains__(self, key: str) -> bool:
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return key in lazymap
         return key in self._map
 
     def __getitem__(self, key: str) -> "dirstatetuple":
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return lazymap[key]
         return self._map[key]
 
     def keys(self) -> "Iterable[str]":
@@ -1681,20 +1691,59 @@ class dirstatemap(object):
         self._parents = (p1, p2)
         self._dirtyparents = True
 
-    def read(self) -> None:
+    def _readfile(self, usemmap: bool = False) -> "Union[bytes, mmap.mmap]":
+        """Read the dirstate file, returning an empty string if it's missing."""
         # ignore HG_PENDING because identity is used only for writing
         self.identity = util.filestat.frompath(self._opener.join(self._filename))
 
         try:
             fp = self._opendirstatefile()
             try:
-                st = fp.read()
+                if usemmap:
+                    return util.mmapread(fp)
+                return fp.read()
             finally:
                 fp.close()
         except IOError as err:
             if err.errno != errno.ENOENT:
                 raise
+            return b""
+
+    @util.propertycache
+    def _lazymap(self) -> "Optional[parsers.lazydirstate]":
+        """The dirstate file parsed on demand, which answers lookups of a
+        few files without building the whole map.
+
+        None once the whole map has been read, or if the file is empty.
+        """
+        if "_map" in self.__dict__ or not util.safehasattr(parsers, "lazydirstate"):
+            return None
+        # The dirstate is replaced when it's written, which Windows doesn't
+        # allow while the file is mapped.
+        st = self._readfile(usemmap=not pycompat.iswindows)
+        if not st:
+            return None
+        lazymap = parsers.lazydirstate(st)
+
+        self.__contains__: "Callable[[str], bool]" = lazymap.__contains__
+        self.__getitem__: "Callable[[str], dirstatetuple]" = lazymap.__getitem__
+        self.get = lazymap.get
+        return lazymap
+
+    def read(self) -> None:
+        lazymap = self._lazymap
+        if lazymap is not None:
+            # Fill the map from the data that lookups have been answered from,
+            # which the identity belongs to.
+            self._lazymap = None
+            self._map = parsers.dict_new_presized(len(lazymap))
+            p = util.nogc(lazymap.todict)(self._map, self.copymap)
+            if not self._dirtyparents:
+                self.setparents(*p)
+            self._setfastpaths()
             return
+
+        st = self._readfile()
         if not st:
             return
 
@@ -1727,7 +1776,9 @@ class dirstatemap(object):
         p = parse_dirstate(self._map, self.copymap, st)
         if not self._dirtyparents:
             self.setparents(*p)
+        self._setfastpaths()
 
+    def _setfastpaths(self) -> None:
         # Avoid excess attribute lookups by fast pathing certain checks
         self.__contains__: "Callable[[str], bool]" = self._map.__contains__
         self.__getitem__: "Callable[[str], dirstatetuple]" = self._map.__getitem__
@@ -29,6 +29,9 @@ modefromflag = {
 
 
 class eden_dirstate_map(dirstate.dirstatemap):
+    # The eden dirstate has its own format, which is always read in full.
+    _lazymap = None
+
     def __init__(
         self,
         ui: "ui_mod.ui",
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+//! A multiset of the directories that contain paths.
+//!
+//! Directory names are stored back to back in a single arena instead of one
+//! allocation each, and found through an open addressing table of slices of
+//! that arena, so lookups don't allocate.
+
+use std::slice;
+
+/// Values of `Slot::count` for slots that hold no directory.
+const EMPTY: u32 = 0;
+const REMOVED: u32 = u32::MAX;
+
+const MIN_SLOTS: usize = 8;
+
+/// Slots are kept small so that the table of a large repository stays in
+/// cache. Offsets into the arena are 32 bits, which allows for 4 GB of
+/// directory names.
+#[derive(Clone, Copy, Default)]
+struct Slot {
+    hash: u32,
+    start: u32,
+    len: u32,
+    /// The number of paths and subdirectories directly in this directory,
+    /// or EMPTY or REMOVED.
+    count: u32,
+}
+
+pub struct DirSet {
+    arena: String,
+    /// Bytes of the arena used by names that were removed. They are
+    /// reclaimed when the table is rehashed.
+    garbage: usize,
+    /// Power of two sized, and at most three quarters full of used or
+    /// removed slots.
+    slots: Vec<Slot>,
+    len: usize,
+    filled: usize,
+}
+
+pub struct Iter<'a> {
+    arena: &'a str,
+    slots: slice::Iter<'a, Slot>,
+}
+
+/// Hashes 8 bytes at a time, in the manner of FxHash. This is much cheaper
+/// than SipHash for directory names, which aren't chosen by an adversary.
+fn hash(dir: &str) -> u32 {
+    const K: u64 = 0x517cc1b727220a95;
+    let mut hash = dir.len() as u64;
+    let mut chunks = dir.as_bytes().chunks_exact(8);
+    for chunk in &mut chunks {
+        let word = u64::from_le_bytes(chunk.try_into().unwrap());
+        hash = (hash.rotate_left(5) ^ word).wrapping_mul(K);
+    }
+    let mut tail = [0u8; 8];
+    tail[..chunks.remainder().len()].copy_from_slice(chunks.remainder());
+    hash = (hash.rotate_left(5) ^ u64::from_le_bytes(tail)).wrapping_mul(K);
+    // The multiplications only carry upwards, so keep the high bits.
+    (hash >> 32) as u32
+}
+
+/// The lengths of the ancestor directories of `path`, deepest first. The
+/// root is the empty directory.
+fn ancestor_lens(path: &str) -> impl Iterator<Item = usize> + '_ {
+    path.rmatch_indices('/').map(|(i, _)| i).chain(Some(0))
+}
+
+impl DirSet {
+    pub fn new() -> Self {
+        DirSet {
+            arena: String::new(),
+            garbage: 0,
+            slots: vec![Slot::default(); MIN_SLOTS],
+            len: 0,
+            filled: 0,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn contains(&self, dir: &str) -> bool {
+        self.find(dir, hash(dir)).is_ok()
+    }
+
+    /// Add the ancestor directories of `path`.
+    pub fn add_path(&mut self, path: &str) {
+        for i in ancestor_lens(path) {
+            let dir = &path[..i];
+            let hash = hash(dir);
+            match self.find(dir, hash) {
+                Ok(index) => {
+                    // The ancestors of dir are already counted.
+                    self.slots[index].count += 1;
+                    return;
+                }
+                Err(_) => self.insert(dir, hash),
+            }
+        }
+    }
+
+    /// Remove the ancestor directories of `path`. Returns false if one of
+    /// them was not in the set.
+    pub fn del_path(&mut self, path: &str) -> bool {
+        for i in ancestor_lens(path) {
+            let dir = &path[..i];
+            let slot = match self.find(dir, hash(dir)) {
+                Ok(index) => &mut self.slots[index],
+                Err(_) => return false,
+            };
+            if slot.count > 1 {
+                slot.count -= 1;
+                return true;
+            }
+            slot.count = REMOVED;
+            self.garbage += slot.len as usize;
+            self.len -= 1;
+        }
+        true
+    }
+
+    pub fn iter(&self) -> Iter<'_> {
+        Iter {
+            arena: &self.arena,
+            slots: self.slots.iter(),
+        }
+    }
+
+    fn name(&self, slot: &Slot) -> &str {
+        let start = slot.start as usize;
+        &self.arena[start..start + slot.len as usize]
+    }
+
+    /// Returns the index of the slot holding `dir`, or of the slot it should
+    /// be inserted at.
+    fn find(&self, dir: &str, hash: u32) -> Result<usize, usize> {
+        let mask = self.slots.len() - 1;
+        let mut index = hash as usize & mask;
+        let mut removed = None;
+        loop {
+            let slot = &self.slots[index];
+            match slot.count {
+                EMPTY => return Err(removed.unwrap_or(index)),
+                REMOVED => {
+                    removed.get_or_insert(index);
+                }
+                _ => {
+                    if slot.hash == hash && self.name(slot) == dir {
+                        return Ok(index);
+                    }
+                }
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    fn insert(&mut self, dir: &str, hash: u32) {
+        if (self.filled + 1) * 4 > self.slots.len() * 3 {
+            self.rehash();
+        }
+        let index = match self.find(dir, hash) {
+            Ok(index) | Err(index) => index,
+        };
+        if self.slots[index].count == EMPTY {
+            self.filled += 1;
+        }
+        self.slots[index] = Slot {
+            hash,
+            start: to_u32(self.arena.len()),
+            len: to_u32(dir.len()),
+            count: 1,
+        };
+        self.arena.push_str(dir);
+        self.len += 1;
+    }
+
+    /// Rebuild the table with room for as many names again as are in use,
+    /// dropping removed slots, and compact the arena if at least half of it
+    /// is garbage.
+    fn rehash(&mut self) {
+        let size = ((self.len + 1) * 2).next_power_of_two().max(MIN_SLOTS);
+        let old_slots = std::mem::replace(&mut self.slots, vec![Slot::default(); size]);
+        let compact = self.garbage * 2 >= self.arena.len();
+        let mut arena = String::new();
+        if compact {
+            arena.reserve(self.arena.len() - self.garbage);
+        }
+        let mask = size - 1;
+        for mut slot in old_slots {
+            if slot.count == EMPTY || slot.count == REMOVED {
+                continue;
+            }
+            if compact {
+                let start = to_u32(arena.len());
+                arena.push_str(self.name(&slot));
+                slot.start = start;
+            }
+            let mut index = slot.hash as usize & mask;
+            while self.slots[index].count != EMPTY {
+                index = (index + 1) & mask;
+            }
+            self.slots[index] = slot;
+        }
+        if compact {
+            self.arena = arena;
+            self.garbage = 0;
+        }
+        self.filled = self.len;
+    }
+}
+
+fn to_u32(n: usize) -> u32 {
+    u32::try_from(n).expect("directory names should fit in 4 GB")
+}
+
+impl<'a> Iterator for Iter<'a> {
+    type Item = &'a str;
+
+    fn next(&mut self) -> Option<&'a str> {
+        for slot in &mut self.slots {
+            if slot.count != EMPTY && slot.count != REMOVED {
+                let start = slot.start as usize;
+                return Some(&self.arena[start..start + slot.len as usize]);
+            }
+        }
+        None
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::collections::HashMap;
+
+    use super::*;
+
+    fn sorted(set: &DirSet) -> Vec<&str> {
+        let mut dirs: Vec<&str> = set.iter().collect();
+        dirs.sort_unstable();
+        dirs
+    }
+
+    #[test]
+    fn test_add_del() {
+        let mut set = DirSet::new();
+        set.add_path("a/b/c");
+        set.add_path("a/d");
+        set.add_path("e");
+        assert_eq!(sorted(&set), ["", "a", "a/b"]);
+        assert!(set.contains("a/b"));
+        assert!(!set.contains("a/b/c"));
+
+        assert!(set.del_path("a/b/c"));
+        assert_eq!(sorted(&set), ["", "a"]);
+        assert!(set.del_path("a/d"));
+        assert!(set.del_path("e"));
+        assert_eq!(set.len(), 0);
+        assert!(!set.del_path("e"));
+    }
+
+    #[test]
+    fn test_matches_hashmap() {
+        // Compare against a straightforward HashMap multiset, through enough
+        // churn to rehash and compact the arena several times.
+        let mut set = DirSet::new();
+        let mut expected: HashMap<String, u64> = HashMap::new();
+        let mut paths = Vec::new();
+        for i in 0..20000usize {
+            if i % 3 == 2 {
+                let path: String = paths.swap_remove((i * 7919) % paths.len());
+                assert!(set.del_path(&path));
+                for len in ancestor_lens(&path) {
+                    let count = expected.get_mut(&path[..len]).unwrap();
+                    *count -= 1;
+                    if *count == 0 {
+                        expected.remove(&path[..len]);
+                    }
+                }
+            } else {
+                let path = format!("d{}/e{}/f{}", i % 17, i % 101, i);
+                set.add_path(&path);
+                for len in ancestor_lens(&path) {
+                    *expected.entry(path[..len].to_string()).or_default() += 1;
+                }
+                paths.push(path);
+            }
+            assert_eq!(set.len(), expected.len());
+        }
+        let mut expected_dirs: Vec<&str> = expected.keys().map(|s| s.as_str()).collect();
+        expected_dirs.sort_unstable();
+        assert_eq!(sorted(&set), expected_dirs);
+    }
+}
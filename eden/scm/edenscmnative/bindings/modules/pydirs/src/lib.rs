@@ -8,15 +8,17 @@
 #![allow(non_camel_case_types)]
 
 use std::cell::RefCell;
-use std::collections::hash_map::Keys;
-use std::collections::HashMap;
-use std::str;
 
 use cpython::*;
 use cpython_ext::PyNone;
 use cpython_ext::PyPath;
 use cpython_ext::PyPathBuf;
 
+mod dirset;
+
+use dirset::DirSet;
+use dirset::Iter;
+
 pub fn init_module(py: Python, package: &str) -> PyResult<PyModule> {
     let name = [package, "dirs"].join(".");
     let m = PyModule::new(py, &name)?;
@@ -24,48 +26,16 @@ pub fn init_module(py: Python, package: &str) -> PyResult<PyModule> {
     Ok(m)
 }
 
-fn add_path(map: &mut HashMap<PyPathBuf, u64>, path: &PyPath) {
-    let path = path.as_str();
-    for (i, _) in path.rmatch_indices("/").chain(Some((0, ""))) {
-        let prefix = PyPath::from_str(&path[..i]);
-        if let Some(e) = map.get_mut(prefix) {
-            *e += 1;
-            return;
-        }
-        map.insert(prefix.to_owned(), 1);
-    }
-}
-
-fn del_path(py: Python, map: &mut HashMap<PyPathBuf, u64>, path: &PyPath) -> PyResult<()> {
-    let path = path.as_str();
-    for (i, _) in path.rmatch_indices("/").chain(Some((0, ""))) {
-        let prefix = PyPath::from_str(&path[..i]);
-        if let Some(e) = map.get_mut(prefix) {
-            if *e > 1 {
-                *e -= 1;
-                return Ok(());
-            }
-        } else {
-            return Err(PyErr::new::<exc::ValueError, _>(
-                py,
-                "path not in collection",
-            ));
-        }
-        map.remove(prefix);
-    }
-    Ok(())
-}
-
 // A multi-set of the directories that contain paths.
 py_class!(pub class dirs |py| {
-    @shared data inner: HashMap<PyPathBuf, u64>;
+    @shared data inner: DirSet;
 
     def __new__(_cls, init: Option<&PyObject>) -> PyResult<dirs> {
-        let mut inner = HashMap::new();
+        let mut inner = DirSet::new();
         if let Some(init) = init {
             for path in init.iter(py)? {
                 RefFromPyObject::with_extracted(py, &path?, |path: &PyPath| {
-                    add_path(&mut inner, path);
+                    inner.add_path(path.as_str());
                 })?;
             }
         }
@@ -74,19 +44,26 @@ py_class!(pub class dirs |py| {
 
     def addpath(&self, path: &PyPath) -> PyResult<PyNone> {
         let mut inner = self.inner(py).borrow_mut();
-        add_path(&mut *inner, path);
+        inner.add_path(path.as_str());
         Ok(PyNone)
     }
 
     def delpath(&self, path: &PyPath) -> PyResult<PyNone> {
         let mut inner = self.inner(py).borrow_mut();
-        del_path(py, &mut *inner, path)?;
+        if !inner.del_path(path.as_str()) {
+            return Err(PyErr::new::<exc::ValueError, _>(
+                py,
+                "path not in collection",
+            ));
+        }
         Ok(PyNone)
     }
 
-    def __contains__(&self, path: PyPathBuf) -> PyResult<bool> {
+    def __contains__(&self, path: &PyObject) -> PyResult<bool> {
         let inner = self.inner(py).borrow();
-        Ok(inner.contains_key(&path))
+        RefFromPyObject::with_extracted(py, path, |path: &PyPath| {
+            inner.contains(path.as_str())
+        })
     }
 
     def __len__(&self) -> PyResult<usize> {
@@ -95,17 +72,17 @@ py_class!(pub class dirs |py| {
 
     def __iter__(&self) -> PyResult<dirsiter> {
         let iter = self.inner(py).leak_immutable();
-        dirsiter::create_instance(py, RefCell::new(unsafe { iter.map(py, |o| o.keys()) }))
+        dirsiter::create_instance(py, RefCell::new(unsafe { iter.map(py, |o| o.iter()) }))
     }
 });
 
 py_class!(pub class dirsiter |py| {
-    data iter: RefCell<UnsafePyLeaked<Keys<'static, PyPathBuf, u64>>>;
+    data iter: RefCell<UnsafePyLeaked<Iter<'static>>>;
 
     def __next__(&self) -> PyResult<Option<PyPathBuf>> {
         let mut iter = self.iter(py).borrow_mut();
         let mut iter = unsafe { iter.try_borrow_mut(py)? };
-        Ok(iter.next().cloned())
+        Ok(iter.next().map(|dir| PyPathBuf::from(dir.to_string())))
     }
 
     def __iter__(&self) -> PyResult<dirsiter> {
@@ -12,6 +12,11 @@ from libc.string cimport memcpy, memset, strdup
 IF UNAME_SYSNAME != "Windows":
     from posix cimport fcntl, mman, stat, unistd
     from posix.types cimport off_t
+IF UNAME_SYSNAME == "Linux":
+    cdef extern from "<sys/mman.h>" nogil:
+        void *mremap(void *old_address, size_t old_size, size_t new_size,
+                     int flags, ...)
+        enum: MREMAP_MAYMOVE
 
 import os
 
@@ -67,6 +72,14 @@ ELSE:
     cdef size_t pagesize = <size_t>unistd.sysconf(unistd._SC_PAGESIZE)
     cdef size_t unitsize = pagesize # used when resizing a buffer
 
+cdef size_t _growsize(size_t size, size_t neededsize):
+    # grow geometrically so a series of appends resizes (and remaps) the
+    # buffer O(log n) times instead of once per unitsize
+    cdef size_t newsize = size + size // 2
+    if newsize < neededsize:
+        newsize = neededsize
+    return (newsize // unitsize + 1) * unitsize
+
 class LinelogError(Exception):
     _messages = {
         LINELOG_RESULT_EILLDATA: b'Illegal data',
@@ -143,7 +156,7 @@ cdef class _buffer: # thin wrapper around linelog_buf
             if result == LINELOG_RESULT_OK:
                 return
             elif result == LINELOG_RESULT_ENEEDRESIZE:
-                self.resize((self.buf.neededsize // unitsize + 1) * unitsize)
+                self.resize(_growsize(self.buf.size, self.buf.neededsize))
             else:
                 raise LinelogError(result)
 
@@ -191,6 +204,21 @@ IF UNAME_SYSNAME != "Windows":
         cdef resize(self, size_t newsize):
             if self.fd == -1:
                 self._open()
+            IF UNAME_SYSNAME == "Linux":
+                # grow or shrink the existing mapping in place, so pages
+                # that were already touched stay mapped. if that fails, the
+                # old mapping is still valid and we fall back to remapping.
+                if self.buf.data != NULL and newsize != 0:
+                    r = unistd.ftruncate(self.fd, <off_t>newsize)
+                    if r != 0:
+                        raise _excwitherrno(IOError, b'ftruncate')
+                    p = mremap(self.buf.data, self.maplen, newsize,
+                               MREMAP_MAYMOVE)
+                    if p != mman.MAP_FAILED:
+                        self.buf.data = <uint8_t *>p
+                        self.buf.size = newsize
+                        self.maplen = newsize
+                        return
             self._unmap()
             r = unistd.ftruncate(self.fd, <off_t>newsize)
             if r != 0:
@@ -233,7 +261,7 @@ IF UNAME_SYSNAME != "Windows":
             self.maplen = (1 if filelen == 0 else filelen) # cannot be 0
             p = mman.mmap(NULL, self.maplen, mman.PROT_READ | mman.PROT_WRITE,
                           mman.MAP_SHARED, self.fd, 0)
-            if p == NULL:
+            if p == mman.MAP_FAILED:
                 raise _excwitherrno(OSError, b'mmap')
 
             self.buf.data = <uint8_t *>p
@@ -128,15 +128,44 @@ int xdl_recmatch_vendored(const char *l1, int64_t s1, const char *l2, int64_t s2
 	return 0;
 }
 
+/*
+ * The hash of a record only has to be equal for equal records: records are
+ * classified with it in xdl_classify_record(), which confirms matches with
+ * memcmp and then replaces the hash with the index of the class. So it can
+ * consume a word at a time instead of a byte at a time.
+ */
+#define XDL_HASH_MUL 0x9e3779b97f4a7c15ULL
+
+static uint64_t xdl_hash_word(uint64_t ha, uint64_t word) {
+	ha ^= word;
+	ha *= XDL_HASH_MUL;
+	return ha ^ (ha >> 29);
+}
+
 uint64_t xdl_hash_record_vendored(char const **data, char const *top) {
 	uint64_t ha = 5381;
+	uint64_t word;
 	char const *ptr = *data;
+	char const *eol;
 
-	for (; ptr < top && *ptr != '\n'; ptr++) {
-		ha += (ha << 5);
-		ha ^= (unsigned long) *ptr;
+	/*
+	 * Find the end of the line with memchr, which libc vectorizes, rather
+	 * than testing each byte.
+	 */
+	if (!(eol = memchr(ptr, '\n', top - ptr)))
+		eol = top;
+
+	for (; (size_t) (eol - ptr) >= sizeof(word); ptr += sizeof(word)) {
+		memcpy(&word, ptr, sizeof(word));
+		ha = xdl_hash_word(ha, word);
+	}
+	if (ptr < eol) {
+		word = 0;
+		memcpy(&word, ptr, eol - ptr);
+		/* Tell apart tails that only differ by trailing zero bytes. */
+		ha = xdl_hash_word(ha, word ^ (uint64_t) (eol - ptr));
 	}
-	*data = ptr < top ? ptr + 1: ptr;
+	*data = eol < top ? eol + 1: eol;
 
 	return ha;
 }
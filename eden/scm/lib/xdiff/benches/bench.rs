@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+use minibench::bench;
+use minibench::elapsed;
+use xdiff::diff_hunks;
+
+/// A generated file of `lines` lines that look like source code.
+fn generated_file(lines: usize, line_len: usize) -> Vec<u8> {
+    let mut text = Vec::with_capacity(lines * (line_len + 1));
+    for i in 0..lines {
+        let line = format!("    let value_{} = compute({}, {});", i, i * 7, i % 13);
+        let mut line = line.into_bytes();
+        line.resize(line_len, b' ');
+        text.extend_from_slice(&line);
+        text.push(b'\n');
+    }
+    text
+}
+
+/// Change every `every`-th line of `text`.
+fn change_lines(text: &[u8], every: usize) -> Vec<u8> {
+    let mut changed = Vec::with_capacity(text.len());
+    for (i, line) in text.split_inclusive(|&b| b == b'\n').enumerate() {
+        if i % every == 0 {
+            changed.extend_from_slice(b"    // changed\n");
+        } else {
+            changed.extend_from_slice(line);
+        }
+    }
+    changed
+}
+
+fn main() {
+    for &(lines, line_len) in &[(100_000, 40), (100_000, 200), (500_000, 80)] {
+        let old = generated_file(lines, line_len);
+        let new = change_lines(&old, 100);
+        let mb = old.len() / 1_000_000;
+        bench(
+            format!("diff {} MB, {} byte lines, 1% changed", mb, line_len),
+            || {
+                elapsed(|| {
+                    diff_hunks(&old, &new);
+                })
+            },
+        );
+    }
+}
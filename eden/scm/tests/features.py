@@ -249,6 +249,7 @@ segmentedchangelogcompatiblelist = """
     test-issue2137-t.py
     test-issue4074.t
     test-known.t
+    test-lazydirstate.py
     test-lfs-journal-t.py
     test-lfs-localstore.t
     test-lfs-pointer.py
@@ -0,0 +1,97 @@
+from __future__ import absolute_import
+
+import mmap
+import struct
+import tempfile
+import unittest
+
+import silenttestrunner
+from edenscmnative import parsers
+
+
+P1 = b"1" * 20
+P2 = b"2" * 20
+
+
+def entry(state, name, size=0, copysource=None):
+    if copysource is not None:
+        name += b"\0" + copysource
+    return struct.pack(">cllll", state, 0o644, size, 0, len(name)) + name
+
+
+def parsefull(data):
+    dmap, copymap = {}, {}
+    parents = parsers.parse_dirstate(dmap, copymap, data)
+    return parents, dmap, copymap
+
+
+class testlazydirstate(unittest.TestCase):
+    def testlookups(self):
+        dmap = {}
+        copymap = {}
+        for i in range(1000):
+            # Not in sorted order, as the dirstate keeps the order of the map.
+            f = "dir%d/file%d" % (i % 7, i)
+            dmap[f] = parsers.dirstatetuple("nmar"[i % 4], 0o644, i, i * 3)
+            if i % 10 == 0:
+                copymap[f] = "source%d" % i
+        data = parsers.pack_dirstate(dmap, copymap, (P1, P2), 1 << 30)
+
+        lazy = parsers.lazydirstate(data)
+        self.assertEqual(len(dmap), len(lazy))
+        self.assertEqual((P1, P2), lazy.parents())
+        for f, e in dmap.items():
+            self.assertIn(f, lazy)
+            self.assertEqual(tuple(e), tuple(lazy[f]))
+            self.assertEqual(tuple(e), tuple(lazy.get(f)))
+        self.assertNotIn("dir0", lazy)
+        self.assertNotIn(b"dir0/file0", lazy)
+        self.assertIsNone(lazy.get("missing"))
+        self.assertEqual(1, lazy.get("missing", 1))
+        self.assertRaises(KeyError, lambda: lazy["missing"])
+
+        fulldmap, fullcopymap = {}, {}
+        self.assertEqual((P1, P2), lazy.todict(fulldmap, fullcopymap))
+        self.assertEqual(list(dmap), list(fulldmap))
+        self.assertEqual(copymap, fullcopymap)
+
+    def testduplicates(self):
+        data = (
+            P1
+            + P2
+            + entry(b"n", b"a", size=1)
+            + entry(b"r", b"b", size=2)
+            + entry(b"a", b"a", size=3, copysource=b"c")
+        )
+        parents, dmap, copymap = parsefull(data)
+        lazy = parsers.lazydirstate(data)
+        self.assertEqual(len(dmap), len(lazy))
+        for f, e in dmap.items():
+            self.assertEqual(tuple(e), tuple(lazy[f]))
+
+    def testinvalid(self):
+        self.assertEqual(0, len(parsers.lazydirstate(P1 + P2)))
+        for data in [
+            b"x" * 39,
+            P1 + P2 + b"n" * 16,
+            P1 + P2 + entry(b"n", b"abc")[:-1],
+        ]:
+            self.assertRaises(ValueError, parsefull, data)
+            self.assertRaises(ValueError, parsers.lazydirstate, data)
+
+    def testmmap(self):
+        data = P1 + P2 + entry(b"n", b"b") + entry(b"a", b"a", size=5)
+        with tempfile.TemporaryFile() as fp:
+            fp.write(data)
+            fp.flush()
+            m = mmap.mmap(fp.fileno(), 0, access=mmap.ACCESS_READ)
+            lazy = parsers.lazydirstate(m)
+            # The lazydirstate keeps the buffer exported.
+            self.assertRaises(BufferError, m.close)
+            self.assertEqual(5, lazy["a"][2])
+            del lazy
+            m.close()
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)
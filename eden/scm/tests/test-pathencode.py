@@ -232,9 +232,19 @@ def genpath(rng, count):
         yield makepath(rng, x, y)
 
 
+def fixedpaths():
+    """Pathnames with long runs of bytes that are copied unchanged, ended by
+    one that is not at each offset around the 16-byte blocks in which the C
+    implementation classifies bytes."""
+
+    for n in xrange(40):
+        for c in ". _A~/\x80":
+            yield "data/" + "a0-z9" * 8 + "/" + "x" * n + c + "y" * 20 + ".i"
+
+
 def runtests(rng, seed, count):
     nerrs = 0
-    for p in genpath(rng, count):
+    for p in itertools.chain(fixedpaths(), genpath(rng, count)):
         h = store._pathencode(p)  # uses C implementation, if available
         r = store._hybridencode(p, True)  # reference implementation in Python
         if h != r: